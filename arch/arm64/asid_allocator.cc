@@ -11,6 +11,7 @@
 #include <trace.h>
 #include <zircon/types.h>
 
+#include <arch/ops.h>
 #include <ktl/unique_ptr.h>
 
 #include <ktl/enforce.h>
@@ -18,42 +19,84 @@
 #define LOCAL_TRACE 0
 
 AsidAllocator::AsidAllocator(enum arm64_asid_width width_override) {
-  bitmap_.Reset(MMU_ARM64_MAX_USER_ASID_16 + 1);
-
   // save whether or not the cpu only supports 8 bits which is fairly exceptional.
   // most support the full 16 bit ASID space.
   asid_width_ = (width_override != arm64_asid_width::UNKNOWN) ? width_override : arm64_asid_width();
   DEBUG_ASSERT(asid_width_ == arm64_asid_width::ASID_8 || asid_width_ == arm64_asid_width::ASID_16);
+
+  // Permanently claim the ids outside of [MMU_ARM64_FIRST_USER_ASID, max_user_asid()] so that the
+  // search never returns them.
+  for (size_t asid = 0; asid < MMU_ARM64_FIRST_USER_ASID; asid++) {
+    allocated_[asid / kBitsPerWord].fetch_or(1ul << (asid % kBitsPerWord));
+  }
+  for (size_t asid = max_user_asid() + 1ul; asid < kWords * kBitsPerWord; asid++) {
+    allocated_[asid / kBitsPerWord].fetch_or(1ul << (asid % kBitsPerWord));
+  }
 }
 
 AsidAllocator::~AsidAllocator() {}
 
-zx::result<uint16_t> AsidAllocator::Alloc() {
-  uint16_t new_asid;
+uint16_t AsidAllocator::TryAlloc() {
+  const size_t words = (max_user_asid() + 1ul + kBitsPerWord - 1) / kBitsPerWord;
+  const size_t hint = hint_.load(ktl::memory_order_relaxed);
+  for (size_t i = 0; i < words; i++) {
+    const size_t word = (hint + i) % words;
+    uint64_t bits = allocated_[word].load(ktl::memory_order_relaxed);
+    while (bits != ~0ul) {
+      const uint64_t bit = __builtin_ctzl(~bits);
+      // Acquire pairs with the release in RolloverLocked, so that a caller given an ASID that was
+      // released by a rollover also observes the new generation.
+      if (allocated_[word].compare_exchange_weak(bits, bits | (1ul << bit),
+                                                 ktl::memory_order_acquire,
+                                                 ktl::memory_order_relaxed)) {
+        hint_.store(word, ktl::memory_order_relaxed);
+        return static_cast<uint16_t>(word * kBitsPerWord + bit);
+      }
+    }
+  }
+  return 0;
+}
 
+bool AsidAllocator::RolloverLocked() {
+  bool any_freed = false;
+  for (size_t word = 0; word < kWords && !any_freed; word++) {
+    any_freed = freed_[word].load(ktl::memory_order_relaxed) != 0;
+  }
+  if (!any_freed) {
+    return false;
+  }
+
+  // Advance the generation before releasing any ASIDs, so that no CPU can run with a released ASID
+  // without first seeing that it needs to invalidate its TLB.
+  generation_.fetch_add(1, ktl::memory_order_relaxed);
+  for (size_t word = 0; word < kWords; word++) {
+    const uint64_t freed = freed_[word].exchange(0, ktl::memory_order_relaxed);
+    if (freed != 0) {
+      allocated_[word].fetch_and(~freed, ktl::memory_order_release);
+    }
+  }
+  hint_.store(0, ktl::memory_order_relaxed);
+  return true;
+}
+
+zx::result<uint16_t> AsidAllocator::Alloc() {
   // use the bitmap allocator to allocate ids in the range of
   // [MMU_ARM64_FIRST_USER_ASID, MMU_ARM64_MAX_USER_ASID]
-  // start the search from the last found id + 1 and wrap when hitting the end of the range
-  {
+  // start the search from the last word an id was found in, and wrap when hitting the end of the
+  // range
+  uint16_t new_asid = TryAlloc();
+  while (unlikely(new_asid == 0)) {
     Guard<Mutex> al{&lock_};
-
-    size_t val;
-    bool notfound = bitmap_.Get(last_ + 1, max_user_asid() + 1, &val);
-    if (unlikely(notfound)) {
-      // search again from the start
-      notfound = bitmap_.Get(MMU_ARM64_FIRST_USER_ASID, max_user_asid() + 1, &val);
-      if (unlikely(notfound)) {
-        return zx::error(ZX_ERR_NO_MEMORY);
-      }
+    // Another thread may have rolled over, or freed an id, while we waited for the lock.
+    new_asid = TryAlloc();
+    if (new_asid == 0 && !RolloverLocked()) {
+      return zx::error(ZX_ERR_NO_MEMORY);
     }
-    bitmap_.SetOne(val);
-
-    DEBUG_ASSERT(val <= max_user_asid());
-
-    new_asid = (uint16_t)val;
-    last_ = new_asid;
   }
 
+  DEBUG_ASSERT(new_asid >= MMU_ARM64_FIRST_USER_ASID);
+  DEBUG_ASSERT(new_asid <= max_user_asid());
+
   LTRACEF("new asid %#x\n", new_asid);
 
   return zx::ok(new_asid);
@@ -62,13 +105,31 @@ zx::result<uint16_t> AsidAllocator::Alloc() {
 zx::result<> AsidAllocator::Free(uint16_t asid) {
   LTRACEF("free asid %#x\n", asid);
 
-  Guard<Mutex> al{&lock_};
+  DEBUG_ASSERT(asid >= MMU_ARM64_FIRST_USER_ASID);
+  DEBUG_ASSERT(asid <= max_user_asid());
+  DEBUG_ASSERT(allocated_[asid / kBitsPerWord].load() & (1ul << (asid % kBitsPerWord)));
 
-  bitmap_.ClearOne(asid);
+  // Leave the id allocated until the next rollover, which is when TLB entries tagged with it are
+  // invalidated.
+  [[maybe_unused]] const uint64_t prev =
+      freed_[asid / kBitsPerWord].fetch_or(1ul << (asid % kBitsPerWord), ktl::memory_order_relaxed);
+  DEBUG_ASSERT(!(prev & (1ul << (asid % kBitsPerWord))));
 
   return zx::ok();
 }
 
+void AsidAllocator::PrepareCurrentCpu() {
+  DEBUG_ASSERT(arch_ints_disabled());
+  uint64_t& cpu_generation = cpu_generation_[arch_curr_cpu_num()].value;
+  const uint64_t generation = generation_.load(ktl::memory_order_acquire);
+  if (unlikely(cpu_generation != generation)) {
+    // Invalidate all non-global entries on this CPU only.
+    ARM64_TLBI_NOADDR(vmalle1);
+    __dsb(ARM_MB_NSH);
+    cpu_generation = generation;
+  }
+}
+
 // unit tests for the asid allocator
 namespace {
 
@@ -107,6 +168,23 @@ bool asid_allocator_test_inner(enum arm64_asid_width asid_width) {
       auto status = aa->Free(static_cast<uint16_t>(i));
       ASSERT_TRUE(status.is_ok());
     }
+
+    // freed ids only become available again once the allocator rolls over to a new generation
+    EXPECT_EQ(static_cast<uint64_t>(j), aa->generation());
+  }
+  EXPECT_EQ(1u, aa->generation());
+
+  // ids that are still allocated survive a rollover
+  {
+    auto kept = aa->Alloc();
+    ASSERT_TRUE(kept.is_ok());
+    EXPECT_EQ(2u, aa->generation());
+    for (uint32_t i = MMU_ARM64_FIRST_USER_ASID; i < max_asid; i++) {
+      auto status = aa->Alloc();
+      ASSERT_TRUE(status.is_ok());
+      EXPECT_NE(kept.value(), status.value());
+    }
+    EXPECT_TRUE(aa->Alloc().is_error());
   }
 
   END_TEST;
@@ -11,13 +11,22 @@
 
 #include <arch/arm64/feature.h>
 #include <arch/arm64/mmu.h>
-#include <bitmap/raw-bitmap.h>
-#include <bitmap/storage.h>
 #include <fbl/macros.h>
+#include <kernel/cpu.h>
 #include <kernel/mutex.h>
+#include <ktl/atomic.h>
 
 // Class to automate allocating an ASID for a new address space for arm64.
 //
+// ASIDs are recycled in generations. A freed ASID is not handed out again, and so does not need its
+// TLB entries invalidated, until every ASID has been allocated. At that point the allocator rolls
+// over to a new generation, making every ASID freed during the previous one available again. Rather
+// than broadcasting a TLB invalidation at rollover, each CPU invalidates its own TLB the next time
+// it switches to a user address space, see |PrepareCurrentCpu|. ASIDs of live address spaces are
+// kept across rollovers.
+//
+// Allocation and freeing only touch an atomic bitmap, the lock is only taken to roll over.
+//
 // NOTE: stores as much space for 16bit ASIDs, but will fall back to limiting to 8 bit ASIDs
 // given hardware support.
 class AsidAllocator {
@@ -28,6 +37,13 @@ class AsidAllocator {
   zx::result<uint16_t> Alloc();
   zx::result<> Free(uint16_t asid);
 
+  // Must be called, with interrupts disabled, before the current CPU runs with an ASID from Alloc.
+  // Invalidates the local TLB if a rollover has happened since the CPU last did so, as it may still
+  // hold entries for ASIDs that have since been reallocated.
+  void PrepareCurrentCpu();
+
+  uint64_t generation() const { return generation_.load(ktl::memory_order_acquire); }
+
   uint16_t max_user_asid() const {
     return (asid_width_ == arm64_asid_width::ASID_8) ? MMU_ARM64_MAX_USER_ASID_8
                                                      : MMU_ARM64_MAX_USER_ASID_16;
@@ -36,12 +52,30 @@ class AsidAllocator {
  private:
   DISALLOW_COPY_ASSIGN_AND_MOVE(AsidAllocator);
 
+  static constexpr size_t kBitsPerWord = 64;
+  static constexpr size_t kWords = (MMU_ARM64_MAX_USER_ASID_16 + 1) / kBitsPerWord;
+
+  // Claims a clear bit in |allocated_|, scanning from the hint. Returns 0 if every bit is set.
+  uint16_t TryAlloc();
+  // Starts a new generation, returning false if no ASIDs were freed during the current one.
+  bool RolloverLocked() TA_REQ(lock_);
+
   DECLARE_MUTEX(AsidAllocator) lock_;
-  uint16_t last_ TA_GUARDED(lock_) = MMU_ARM64_FIRST_USER_ASID - 1;
   enum arm64_asid_width asid_width_ = arm64_asid_width::UNKNOWN;
 
-  bitmap::RawBitmapGeneric<bitmap::FixedStorage<MMU_ARM64_MAX_USER_ASID_16 + 1>> bitmap_
-      TA_GUARDED(lock_);
+  ktl::atomic<uint64_t> generation_ = 0;
+  // The word of |allocated_| to start searching from.
+  ktl::atomic<size_t> hint_ = 0;
+  // ASIDs that are in use, or were freed during the current generation.
+  ktl::atomic<uint64_t> allocated_[kWords] = {};
+  // ASIDs that were freed during the current generation.
+  ktl::atomic<uint64_t> freed_[kWords] = {};
+
+  // The generation each CPU last invalidated its TLB for. Only accessed by the CPU itself.
+  struct alignas(MAX_CACHE_LINE) CpuGeneration {
+    uint64_t value = 0;
+  };
+  CpuGeneration cpu_generation_[SMP_MAX_CPUS];
 };
 
 #endif  // ZIRCON_KERNEL_ARCH_ARM64_ASID_ALLOCATOR_H_
@@ -4,11 +4,13 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <lib/arch/arm64/feature.h>
 #include <lib/code-patching/code-patches.h>
 #include <zircon/assert.h>
 
 #include <cstdint>
 
+#include <arch/arm64/cstring/selection.h>
 #include <arch/code-patches/case-id.h>
 #include <phys/arch/arch-handoff.h>
 #include <phys/arch/arch-phys-info.h>
@@ -20,6 +22,13 @@
 bool ArchPatchCode(code_patching::Patcher& patcher, const ArchPatchInfo& info,
                    ktl::span<ktl::byte> insns, CodePatchId case_id,
                    fit::inline_function<void(ktl::initializer_list<ktl::string_view>)> print) {
+  auto do_alternative = [&patcher, insns, &print](ktl::string_view name,
+                                                  ktl::string_view alternative) {
+    patcher.MandatoryPatchWithAlternative(insns, alternative);
+    print({"using ", name, " alternative \"", alternative, "\""});
+    return true;
+  };
+
   switch (case_id) {
     case CodePatchId::kSelfTest:
       patcher.NopFill(insns);
@@ -79,6 +88,13 @@ bool ArchPatchCode(code_patching::Patcher& patcher, const ArchPatchInfo& info,
       print({"CPU workaround SMCCC function is "sv, choice});
       return true;
     }
+
+    case CodePatchId::k__UnsanitizedMemcpy:
+      return do_alternative("memcpy",
+                            SelectArm64MemcpyAlternative(arch::ArmIdAa64IsaR2El1::Read()));
+    case CodePatchId::k__UnsanitizedMemset:
+      return do_alternative("memset",
+                            SelectArm64MemsetAlternative(arch::ArmIdAa64IsaR2El1::Read()));
   }
   return false;
 }
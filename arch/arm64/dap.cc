@@ -148,7 +148,8 @@ void arm_dap_init(uint level) {
 
   // map the dap base into the kernel
   for (auto &da : dap_apertures) {
-    LTRACEF("mapping aperture: base %#lx size %#zx mask %#x\n", da.base, da.size, da.mask);
+    LTRACEF("mapping aperture: base %#lx size %#zx mask %#lx\n", da.base, da.size,
+            da.mask.word(0));
 
     zx_status_t err = VmAspace::kernel_aspace()->AllocPhysical(
         "arm dap",
@@ -194,7 +195,7 @@ void arm_dap_init_percpu(uint level) {
     }
 
     // Is the aperture associated with this CPU?
-    if ((cpu_num_to_mask(curr_cpu_num) & da.mask) == 0) {
+    if (!da.mask.test(curr_cpu_num)) {
       // Nope, skip it.
       LTRACEF("cpu-%u not in mask, skipping aperture paddr %#lx\n", curr_cpu_num, da.base);
       continue;
@@ -186,14 +186,56 @@ void arm64_unknown_handler(iframe_t* iframe, uint exception_flags, uint32_t esr)
   try_dispatch_user_exception(ZX_EXCP_UNDEFINED_INSTRUCTION, iframe, esr);
 }
 
+// Rewinds an interrupted FEAT_MOPS CPY* or SET* sequence back to its prologue instruction, with
+// the registers put back in the form the prologue expects, following the generic restart rules in
+// the Arm ARM. The sequence then restarts using whichever algorithm option this CPU implements.
+static void arm64_mops_restart(iframe_t* iframe, uint32_t esr) {
+  const bool set = BIT(esr, 24);
+  const bool from_epilogue = BIT(esr, 18);
+  const bool option_a = BIT_SET(esr, 16) ^ BIT_SET(esr, 17);  // OptionA ^ WrongOption
+  const uint32_t dst_reg = BITS_SHIFT(esr, 14, 10);
+  const uint32_t src_reg = BITS_SHIFT(esr, 9, 5);
+  const uint32_t size_reg = BITS_SHIFT(esr, 4, 0);
+  // Register 30 is saved as lr rather than in r[], and the instructions can't use 31.
+  auto reg = [iframe](uint32_t n) -> uint64_t& { return n == 30 ? iframe->lr : iframe->r[n]; };
+
+  const uint64_t dst = reg(dst_reg);
+  const uint64_t size = reg(size_reg);
+  if (set) {
+    if (option_a) {
+      // Option A counts the size up from its negation towards zero.
+      reg(dst_reg) = dst + size;
+      reg(size_reg) = -size;
+    }
+  } else {
+    const uint64_t src = reg(src_reg);
+    if (!option_a) {
+      // Option B leaves the registers as the prologue wants them, except for backwards copies,
+      // which are marked with the N flag.
+      if (iframe->spsr & (1ul << 31)) {
+        reg(dst_reg) = dst - size;
+        reg(src_reg) = src - size;
+      }
+    } else if (size & (1ul << 63)) {
+      // Option A forward copies count the size up from its negation towards zero.
+      reg(dst_reg) = dst + size;
+      reg(src_reg) = src + size;
+      reg(size_reg) = -size;
+    }
+  }
+  iframe->elr -= from_epilogue ? 8 : 4;
+}
+
 void arm64_mops_handler(iframe_t* iframe, uint exception_flags, uint32_t esr) {
-  // This means the PC and the PSTATE don't agree.  It's not an undefined
-  // instruction but it's an illegal instruction.
+  // The kernel's memcpy and memset use FEAT_MOPS when it is available. A sequence that is
+  // interrupted and then resumed on a CPU implementing the other algorithm option raises this
+  // exception, and is simply restarted.
   if (unlikely((exception_flags & ARM64_EXCEPTION_FLAG_LOWER_EL) == 0)) {
-    /* trapped inside the kernel, this is bad */
-    exception_die(iframe, esr, __arm_rsr64("far_el1"),
-                  "FEAT_MOPS exception in kernel: PC at %#" PRIx64 "\n", iframe->elr);
+    arm64_mops_restart(iframe, esr);
+    return;
   }
+  // This means the PC and the PSTATE don't agree.  It's not an undefined
+  // instruction but it's an illegal instruction.
   try_dispatch_user_exception(ZX_EXCP_UNDEFINED_INSTRUCTION, iframe, esr);
 }
 
@@ -590,6 +590,11 @@ void arm64_feature_init() {
       arm64_mmu_features.ccsidx = true;
     }
 
+    // Check for the TLBI range instructions.
+    if (isar0.tlb() == arch::ArmIdAa64IsaR0El1::Tlb::kkTlbirange) {
+      arm64_mmu_features.tlbi_range = true;
+    }
+
     // Check if FEAT_PMUv3 is enabled.
     uint64_t pmu_version = (__arm_rsr64("id_aa64dfr0_el1") >> 8) & 0xf;
     feat_pmuv3_enabled = pmu_version > 0b0000 && pmu_version < 0b1111;
@@ -648,6 +653,7 @@ void arm64_feature_debug(bool full) {
     dprintf(INFO, "ARM accessed bit %d, dirty bit %d\n", arm64_mmu_features.accessed_bit,
             arm64_mmu_features.dirty_bit);
     dprintf(INFO, "ARM PAN %d, UAO %d\n", arm64_mmu_features.pan, arm64_mmu_features.uao);
+    dprintf(INFO, "ARM TLBI range %d\n", arm64_mmu_features.tlbi_range);
     dprintf(INFO, "ARM cache line sizes: icache %u dcache %u zva %u\n", arm64_icache_size,
             arm64_dcache_size, arm64_zva_size);
     if (DPRINTF_ENABLED_FOR_LEVEL(INFO)) {
@@ -58,7 +58,7 @@ class El2CpuState {
   arch::ArmTcrEl2 tcr_;
   arch::ArmVtcrEl2 vtcr_;
 
-  cpu_mask_t cpu_mask_ = 0;
+  cpu_mask_t cpu_mask_{};
   id_allocator::IdAllocator<uint16_t, UINT16_MAX> vmid_allocator_;
 
   El2CpuState() = default;
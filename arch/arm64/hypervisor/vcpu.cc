@@ -208,8 +208,22 @@ zx::result<ktl::unique_ptr<Vcpu>> Vcpu::Create(Guest& guest, zx_vaddr_t entry) {
   return zx::ok(ktl::move(vcpu));
 }
 
+// Exception classes are 6 bits, so physical interrupts are counted after them.
+static constexpr uint32_t kPhysicalInterruptReason = 64;
+
+static const char* exit_reason_name(uint32_t reason) {
+  if (reason == kPhysicalInterruptReason) {
+    return "PHYSICAL_INTERRUPT";
+  }
+  return exception_class_name(static_cast<ExceptionClass>(reason));
+}
+
 Vcpu::Vcpu(Guest& guest, uint16_t vpid, Thread* thread)
-    : guest_(guest), vpid_(vpid), last_cpu_(thread->LastCpu()), thread_(thread) {
+    : guest_(guest),
+      vpid_(vpid),
+      last_cpu_(thread->LastCpu()),
+      thread_(thread),
+      exit_stats_(thread->pid(), thread->tid(), exit_reason_name) {
   thread->set_vcpu(true);
   thread->SetMigrateFn([this](Thread* thread, auto stage) {
     ChainLockTransaction::AssertActive();
@@ -329,6 +343,7 @@ zx::result<> Vcpu::Enter(zx_port_packet_t& packet) {
       status = arm64_el2_enter(vttbr, el2_state_.PhysicalAddress(), hcr_);
       GUEST_STATS_INC(vm_exits);
     }
+    const zx_instant_mono_t exit_time = current_mono_time();
     gich_state_.TrackAllListRegisters(ich_state);
     if (status == ZX_ERR_NEXT) {
       // We received a physical interrupt. Continue execution of the guest.
@@ -336,10 +351,14 @@ zx::result<> Vcpu::Enter(zx_port_packet_t& packet) {
                        guest_state->system_state.elr_el2);
       GUEST_STATS_INC(interrupts);
       status = ZX_OK;
+      exit_stats_.Record(kPhysicalInterruptReason,
+                         zx_time_sub_time(current_mono_time(), exit_time));
     } else if (status == ZX_OK) {
+      const uint32_t exception_class = BITS_SHIFT(guest_state->esr_el2, 31, 26);
       status = vmexit_handler(&hcr_, guest_state, &gich_state_, &guest_.AddressSpace(),
                               &guest_.Traps(), &packet)
                    .status_value();
+      exit_stats_.Record(exception_class, zx_time_sub_time(current_mono_time(), exit_time));
     } else {
       ktrace_vcpu_exit(VCPU_FAILURE, guest_state->system_state.elr_el2);
       dprintf(INFO, "hypervisor: VCPU enter failed: %d\n", status);
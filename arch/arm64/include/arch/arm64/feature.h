@@ -96,6 +96,9 @@ struct arm64_mmu_features {
 
   // extended CCSIDR register format
   bool ccsidx;
+
+  // TLB range invalidation instructions (FEAT_TLBIRANGE)
+  bool tlbi_range;
 };
 
 // the global feature structure for mmu features
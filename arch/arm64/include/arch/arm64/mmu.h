@@ -405,6 +405,11 @@
 /* TLBI VADDR mask, VA[55:12], bits [43:0] */
 #define TLBI_VADDR_MASK                BM(0, 44, 0xfffffffffff)
 
+/* TLBI range operand fields, for a 4K translation granule */
+#define TLBI_RANGE_BADDR_MASK          BM(0, 37, 0x1fffffffff)
+#define TLBI_RANGE_NUM_SHIFT           39
+#define TLBI_RANGE_TG_4K               (1UL << 46)
+
 // clang-format on
 
 #ifndef __ASSEMBLER__
@@ -437,6 +442,14 @@ using pte_t = uint64_t;
     __isb(ARM_MB_SY);                                    \
   })
 
+// FEAT_TLBIRANGE inner shareable operations, written as sys instructions so that they do not need
+// an ARMv8.4 assembler. |op2| is 1 for rvae1is, 3 for rvaae1is, 5 for rvale1is and 7 for rvaale1is.
+#define ARM64_TLBI_RANGE_IS(op2, val)                                         \
+  ({                                                                          \
+    __asm__ volatile("sys #0, c8, c2, #" #op2 ", %0" ::"r"((uint64_t)(val))); \
+    __isb(ARM_MB_SY);                                                         \
+  })
+
 // dedicated address space ids
 const uint16_t MMU_ARM64_UNUSED_ASID = 0;
 const uint16_t MMU_ARM64_GLOBAL_ASID = 1;  // NOTE: keep in sync with start.S
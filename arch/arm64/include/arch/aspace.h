@@ -77,6 +77,11 @@ class ArmArchVmAspace final : public ArchVmAspaceInterface {
 
   bool AccessedSinceLastCheck(bool clear) override;
 
+  // Writes are not recorded in the page tables.
+  zx_status_t HarvestDirty(vaddr_t vaddr, size_t count, const DirtyRangeFunction& dirty) override {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+
   paddr_t arch_table_phys() const override { return tt_phys_; }
   uint16_t arch_asid() const { return asid_; }
   void arch_set_asid(uint16_t asid) { asid_ = asid; }
@@ -90,6 +95,9 @@ class ArmArchVmAspace final : public ArchVmAspaceInterface {
   // HarvestAccessed.
   static constexpr bool HasNonTerminalAccessedFlag() { return false; }
 
+  // Access flag faults are reported as such, with VMM_PF_FLAG_ACCESS.
+  static constexpr bool HasUnreportedAccessFaults() { return false; }
+
   static constexpr vaddr_t NextUserPageTableOffset(vaddr_t va) {
     // Work out the virtual address the next page table would start at by first masking the va down
     // to determine its index, then adding 1 and turning it back into a virtual address.
@@ -173,6 +181,11 @@ class ArmArchVmAspace final : public ArchVmAspaceInterface {
   void FlushTLBEntry(vaddr_t vaddr, bool terminal) const TA_REQ(lock_);
   void FlushTLBEntryForAllAsids(vaddr_t vaddr, bool terminal) const TA_REQ(lock_);
 
+  // Largest run of pages that FlushTLBRange can invalidate.
+  static constexpr size_t kMaxTlbRangePages = 64;
+  bool CanFlushTLBRange() const;
+  void FlushTLBRange(vaddr_t vaddr, size_t pages, bool terminal) const TA_REQ(lock_);
+
   void FlushAsid() const TA_REQ(lock_);
   void FlushAllAsids() const TA_REQ(lock_);
 
@@ -14,6 +14,7 @@
 #include <arch/arm64/hypervisor/el2_state.h>
 #include <fbl/ref_ptr.h>
 #include <hypervisor/aspace.h>
+#include <hypervisor/exit_stats.h>
 #include <hypervisor/interrupt_tracker.h>
 #include <hypervisor/page.h>
 #include <hypervisor/trap_map.h>
@@ -153,6 +154,7 @@ class Vcpu {
   hypervisor::PagePtr<El2State> el2_state_;
   GichState gich_state_;
   uint64_t hcr_;
+  hypervisor::ExitStats exit_stats_;
 };
 
 using NormalVcpu = Vcpu;
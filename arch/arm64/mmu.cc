@@ -29,6 +29,7 @@
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
+#include <arch/arm64/feature.h>
 #include <arch/arm64/hypervisor/el2_state.h>
 #include <arch/aspace.h>
 #include <kernel/auto_preempt_disabler.h>
@@ -115,6 +116,8 @@ bool allow_bbm = false;
 KCOUNTER(cm_flush_all, "mmu.consistency_manager.flush_all")
 KCOUNTER(cm_flush_all_replacing, "mmu.consistency_manager.flush_all_replacing")
 KCOUNTER(cm_single_tlb_invalidates, "mmu.consistency_manager.single_tlb_invalidate")
+KCOUNTER(cm_range_tlb_invalidates, "mmu.consistency_manager.range_tlb_invalidate")
+KCOUNTER(cm_range_tlb_pages, "mmu.consistency_manager.range_tlb_pages")
 KCOUNTER(cm_flush, "mmu.consistency_manager.flush")
 
 lazy_init::LazyInit<AsidAllocator> asid;
@@ -510,6 +513,12 @@ class ArmArchVmAspace::ConsistencyManager {
     DEBUG_ASSERT(IS_PAGE_ROUNDED(va));
     DEBUG_ASSERT(aspace_.IsValidVaddr(va));
 
+    // If a single range invalidate can cover it, fold this page into the previous entry.
+    if (num_pending_tlbs_ > 0 && aspace_.CanFlushTLBRange() &&
+        pending_tlbs_[num_pending_tlbs_ - 1].TryAppend(va, terminal)) {
+      return;
+    }
+
     pending_tlbs_[num_pending_tlbs_++] = {va, terminal};
   }
 
@@ -546,10 +555,17 @@ class ArmArchVmAspace::ConsistencyManager {
     } else {
       for (size_t i = 0; i < num_pending_tlbs_; i++) {
         const vaddr_t va = pending_tlbs_[i].va();
+        const size_t pages = pending_tlbs_[i].pages();
         DEBUG_ASSERT(aspace_.IsValidVaddr(va));
-        aspace_.FlushTLBEntry(va, pending_tlbs_[i].terminal());
+        if (pages > 1) {
+          aspace_.FlushTLBRange(va, pages, pending_tlbs_[i].terminal());
+          cm_range_tlb_invalidates.Add(1);
+          cm_range_tlb_pages.Add(pages);
+        } else {
+          aspace_.FlushTLBEntry(va, pending_tlbs_[i].terminal());
+          cm_single_tlb_invalidates.Add(1);
+        }
       }
-      cm_single_tlb_invalidates.Add(num_pending_tlbs_);
     }
 
     // DSB to ensure TLB flushes happen prior to returning to user.
@@ -577,20 +593,34 @@ class ArmArchVmAspace::ConsistencyManager {
   static constexpr size_t kMaxPendingTlbs = 16;
 
   // Pending TLBs to flush are stored as 63 bits, with the bottom bit stolen to store the terminal
-  // flag. 63 bits is more than enough as these entries are page aligned at the minimum.
+  // flag. 63 bits is more than enough as these entries are page aligned at the minimum. When range
+  // invalidates are available an entry may cover a run of consecutive pages starting at va.
   struct PendingTlbs {
     PendingTlbs() = default;
     PendingTlbs(uint64_t va, bool terminal) : va_terminal_(va | terminal) {}
 
     bool terminal() const { return va_terminal_ & 1; }
     uint64_t va() const { return va_terminal_ & ~1UL; }
+    uint32_t pages() const { return pages_; }
+
+    // Extends this entry by the page at |va| if it immediately follows the entry and has the same
+    // terminal flag. Returns false if the page must be queued separately.
+    bool TryAppend(uint64_t va, bool terminal) {
+      if (terminal != this->terminal() || pages_ >= ArmArchVmAspace::kMaxTlbRangePages ||
+          va != this->va() + pages_ * PAGE_SIZE) {
+        return false;
+      }
+      pages_++;
+      return true;
+    }
 
    private:
     // address[63:1], terminal[0]
     uint64_t va_terminal_;
+    uint32_t pages_ = 1;
   };
 
-  static_assert(sizeof(PendingTlbs) == 8);
+  static_assert(sizeof(PendingTlbs) == 16);
 
   // The aspace we are invalidating TLBs for.
   const ArmArchVmAspace& aspace_;
@@ -834,6 +864,43 @@ void ArmArchVmAspace::FlushTLBEntry(vaddr_t vaddr, bool terminal) const {
   __UNREACHABLE;
 }
 
+bool ArmArchVmAspace::CanFlushTLBRange() const {
+  // Range operands are only built for user aspaces, whose addresses all sit in the TTBR0 half and
+  // are mapped with a 4K granule.
+  static_assert(USER_PAGE_SIZE_SHIFT == 12);
+  return arm64_mmu_features.tlbi_range && type_ == ArmAspaceType::kUser;
+}
+
+// Flush |pages| consecutive pages starting at |vaddr| with as few range invalidates as possible.
+// Only a SCALE of 0 is used, which describes runs of 2 to 64 pages in steps of 2, so an odd final
+// page is flushed on its own.
+void ArmArchVmAspace::FlushTLBRange(vaddr_t vaddr, size_t pages, bool terminal) const {
+  DEBUG_ASSERT(CanFlushTLBRange());
+  DEBUG_ASSERT(pages > 1 && pages <= kMaxTlbRangePages);
+
+  const uint64_t num = pages / 2 - 1;
+  uint64_t operand = TLBI_RANGE_TG_4K | (num << TLBI_RANGE_NUM_SHIFT) |
+                     ((vaddr >> 12) & TLBI_RANGE_BADDR_MASK);
+  if (IsShared()) {
+    if (terminal) {
+      ARM64_TLBI_RANGE_IS(7, operand);  // rvaale1is
+    } else {
+      ARM64_TLBI_RANGE_IS(3, operand);  // rvaae1is
+    }
+  } else {
+    operand |= (vaddr_t)asid_ << 48;
+    if (terminal) {
+      ARM64_TLBI_RANGE_IS(5, operand);  // rvale1is
+    } else {
+      ARM64_TLBI_RANGE_IS(1, operand);  // rvae1is
+    }
+  }
+
+  if (pages % 2) {
+    FlushTLBEntry(vaddr + (pages - 1) * PAGE_SIZE, terminal);
+  }
+}
+
 void ArmArchVmAspace::FlushAllAsids() const {
   DEBUG_ASSERT(type_ == ArmAspaceType::kUser);
   DEBUG_ASSERT(IsShared());
@@ -1310,6 +1377,12 @@ size_t ArmArchVmAspace::HarvestAccessedPageTable(
       // to update on an access.
       if (likely(page)) {
         Pmm::Node().GetPageQueues()->MarkAccessed(page);
+        // A block maps a run of pages that all share the one access flag.
+        for (size_t offset = PAGE_SIZE; offset < chunk_size; offset += PAGE_SIZE) {
+          if (vm_page_t* block_page = paddr_to_vm_page(paddr + offset); likely(block_page)) {
+            Pmm::Node().GetPageQueues()->MarkAccessed(block_page);
+          }
+        }
 
         if (terminal_action == TerminalAction::UpdateAgeAndHarvest) {
           // Modifying the access flag does not require break-before-make for correctness and as we
@@ -2134,11 +2207,18 @@ zx_status_t ArmArchVmAspace::DestroyIndividual() {
   // Need a DSB to synchronize any page table updates prior to flushing the TLBs.
   __dsb(ARM_MB_ISH);
 
-  // Flush the ASID or VMID associated with this aspace
-  FlushAsid();
+  // Flush the ASID or VMID associated with this aspace. A user ASID is not reallocated until the
+  // allocator rolls over, and every CPU invalidates its TLB before running with an ASID from the
+  // new generation, so its entries can be left to be cleaned up then. This aspace is no longer
+  // active on any CPU, so nothing can use those entries in the meantime.
+  if (type_ != ArmAspaceType::kUser || !feat_asid_enabled) {
+    FlushAsid();
 
-  // Need a DSB to ensure all other cpus have fully processed the TLB flush.
-  __dsb(ARM_MB_ISH);
+    // Need a DSB to ensure all other cpus have fully processed the TLB flush.
+    __dsb(ARM_MB_ISH);
+  } else {
+    DEBUG_ASSERT(num_active_cpus_.load(ktl::memory_order_relaxed) == 0);
+  }
 
   // Free any ASID.
   if (type_ == ArmAspaceType::kUser) {
@@ -2228,6 +2308,11 @@ void ArmArchVmAspace::ContextSwitch(ArmArchVmAspace* old_aspace, ArmArchVmAspace
     DEBUG_ASSERT(aspace->type_ == ArmAspaceType::kUser);
     DEBUG_ASSERT(aspace->asid_ >= MMU_ARM64_FIRST_USER_ASID);
 
+    // Drop any TLB entries this CPU holds for ASIDs that were recycled by an allocator rollover.
+    if (feat_asid_enabled) {
+      asid->PrepareCurrentCpu();
+    }
+
     // Compute the user space TTBR with the translation table and user space ASID.
     ttbr = ((uint64_t)aspace->asid_ << 48) | aspace->tt_phys_;
     tcr = aspace->Tcr();
@@ -73,12 +73,13 @@ void arch_mp_reschedule(cpu_mask_t mask) {
 }
 
 void arch_mp_send_ipi(mp_ipi_target target, cpu_mask_t mask, mp_ipi ipi) {
-  LTRACEF("target %d mask %#x, ipi %d\n", static_cast<int>(target), mask, static_cast<int>(ipi));
+  LTRACEF("target %d mask %#lx, ipi %d\n", static_cast<int>(target), mask.word(0),
+          static_cast<int>(ipi));
 
   // translate the high level target + mask mechanism into just a mask
   switch (target) {
     case mp_ipi_target::ALL:
-      mask = (1ul << SMP_MAX_CPUS) - 1;
+      mask = CpuMask::FirstN(SMP_MAX_CPUS);
       break;
     case mp_ipi_target::ALL_BUT_LOCAL:
       mask = mask_all_but_one(arch_curr_cpu_num());
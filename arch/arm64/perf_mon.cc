@@ -631,7 +631,7 @@ zx_status_t arch_perfmon_start() {
 
   // Make sure all relevant sysregs have been wiped clean.
   if (!perfmon_hw_initialized) {
-    mp_sync_exec(mp_ipi_target::ALL, 0, arm64_perfmon_reset_task, nullptr);
+    mp_sync_exec(mp_ipi_target::ALL, {}, arm64_perfmon_reset_task, nullptr);
     perfmon_hw_initialized = true;
   }
 
@@ -662,7 +662,7 @@ zx_status_t arch_perfmon_start() {
     }
   }
 
-  mp_sync_exec(mp_ipi_target::ALL, 0, arm64_perfmon_start_task, state);
+  mp_sync_exec(mp_ipi_target::ALL, {}, arm64_perfmon_start_task, state);
   perfmon_active.store(true);
 
   return ZX_OK;
@@ -787,7 +787,7 @@ static void arch_perfmon_stop_locked() TA_REQ(PerfmonLock::Get()) {
   // multiple stops and still read register values.
 
   auto state = perfmon_state.get();
-  mp_sync_exec(mp_ipi_target::ALL, 0, arm64_perfmon_stop_task, state);
+  mp_sync_exec(mp_ipi_target::ALL, {}, arm64_perfmon_stop_task, state);
 
   // arm64_perfmon_start currently maps the buffers in, so we unmap them here.
   // Make sure to do this after we've turned everything off so that we
@@ -840,7 +840,7 @@ void arch_perfmon_fini() {
     DEBUG_ASSERT(!perfmon_active.load());
   }
 
-  mp_sync_exec(mp_ipi_target::ALL, 0, arm64_perfmon_reset_task, nullptr);
+  mp_sync_exec(mp_ipi_target::ALL, {}, arm64_perfmon_reset_task, nullptr);
 
   perfmon_state.reset();
 }
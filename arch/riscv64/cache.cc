@@ -85,7 +85,7 @@ void arch_sync_cache_range(vaddr_t start, size_t len) {
   // Shootdown on all cores.  Using mp_sync_exec instead of an SBI remote fence to handle race
   // conditions with cores going offline.
   auto fencei = [](void*) { __asm__ volatile("fence.i"); };
-  mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ 0, fencei, nullptr);
+  mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ {}, fencei, nullptr);
 }
 
 }  // extern C
@@ -75,6 +75,11 @@ class Riscv64ArchVmAspace final : public ArchVmAspaceInterface {
 
   bool AccessedSinceLastCheck(bool clear) override;
 
+  // Writes are not recorded in the page tables.
+  zx_status_t HarvestDirty(vaddr_t vaddr, size_t count, const DirtyRangeFunction& dirty) override {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+
   paddr_t arch_table_phys() const override { return 0; }
   uint16_t arch_asid() const { return 0; }
   uint16_t asid() const { return asid_; }
@@ -86,6 +91,10 @@ class Riscv64ArchVmAspace final : public ArchVmAspaceInterface {
 
   static constexpr bool HasNonTerminalAccessedFlag() { return false; }
 
+  // Accessed flags are managed in software, so touching a page whose accessed flag was harvested
+  // raises an ordinary page fault against a translation that otherwise permits the access.
+  static constexpr bool HasUnreportedAccessFaults() { return true; }
+
   static constexpr vaddr_t NextUserPageTableOffset(vaddr_t va) {
     // Work out the virtual address the next page table would start at by first masking the va down
     // to determine its index, then adding 1 and turning it back into a virtual address.
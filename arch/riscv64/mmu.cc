@@ -621,7 +621,7 @@ void Riscv64ArchVmAspace::FlushTLBEntryRun(vaddr_t vaddr, size_t count) const {
   const size_t size = count * PAGE_SIZE;
   if (IsKernel() || IsShared()) {
     SfenceVmaArgs args{.range = SfenceVmaArgs::Range{.base = vaddr, .size = size}};
-    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ 0, &SfenceVma, &args);
+    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ {}, &SfenceVma, &args);
   } else if (IsUser()) {
     // Flush just the aspace's asid.
     SfenceVmaArgs args{.range = SfenceVmaArgs::Range{.base = vaddr, .size = size}, .asid = asid_};
@@ -629,7 +629,7 @@ void Riscv64ArchVmAspace::FlushTLBEntryRun(vaddr_t vaddr, size_t count) const {
     if (IsRestricted()) {
       args.unified_asid = get_unified_aspace()->asid();
     }
-    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ 0, &SfenceVma, &args);
+    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ {}, &SfenceVma, &args);
   } else {
     PANIC_UNIMPLEMENTED;
   }
@@ -642,7 +642,7 @@ void Riscv64ArchVmAspace::FlushAsid() const {
   if (IsKernel() || IsShared()) {
     // Perform a full flush of all cpus across all ASIDs
     SfenceVmaArgs args{};
-    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ 0, &SfenceVma, &args);
+    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ {}, &SfenceVma, &args);
     kcounter_add(cm_global_invalidate, 1);
   } else {
     // Perform a full flush of all cpus of a single ASID
@@ -651,7 +651,7 @@ void Riscv64ArchVmAspace::FlushAsid() const {
     if (IsRestricted()) {
       args.unified_asid = get_unified_aspace()->asid();
     }
-    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ 0, &SfenceVma, &args);
+    mp_sync_exec(mp_ipi_target::ALL, /* cpu_mask */ {}, &SfenceVma, &args);
     kcounter_add(cm_asid_invalidate, 1);
   }
 }
@@ -976,8 +976,8 @@ void Riscv64ArchVmAspace::HarvestAccessedPageTable(vaddr_t vaddr, vaddr_t vaddr_
       volatile pte_t* next_page_table =
           static_cast<volatile pte_t*>(paddr_to_physmap(page_table_paddr));
 
-      // NOTE: We currently cannot honor NonTerminalAction::FreeUnaccessed since accessed
-      // information is not being tracked on inner nodes.
+      // NOTE: We currently cannot honor NonTerminalAction::FreeUnaccessed or
+      // NonTerminalAction::Harvest since accessed information is not being tracked on inner nodes.
 
       // Recurse into the next level
       HarvestAccessedPageTable(vaddr, vaddr_rel, chunk_size, level - 1, non_terminal_action,
@@ -991,6 +991,12 @@ void Riscv64ArchVmAspace::HarvestAccessedPageTable(vaddr_t vaddr, vaddr_t vaddr_
       // to update on an access.
       if (likely(page)) {
         Pmm::Node().GetPageQueues()->MarkAccessed(page);
+        // A large page maps a run of pages that all share the one accessed bit.
+        for (size_t offset = PAGE_SIZE; offset < chunk_size; offset += PAGE_SIZE) {
+          if (vm_page_t* large_page = paddr_to_vm_page(paddr + offset); likely(large_page)) {
+            Pmm::Node().GetPageQueues()->MarkAccessed(large_page);
+          }
+        }
 
         if (terminal_action == TerminalAction::UpdateAgeAndHarvest) {
           // Modifying the access flag does not require break-before-make for correctness and as we
@@ -42,11 +42,10 @@ riscv64_percpu riscv64_percpu_array[SMP_MAX_CPUS];
 // local helper routine to help convert cpu masks to hart masks
 template <typename Callback>
 void for_every_hart_in_cpu_mask(cpu_mask_t cmask, Callback callback) {
-  for (cpu_num_t cpu = 0; cpu < riscv64_num_cpus && cmask; cpu++, cmask >>= 1) {
-    if (cmask & 1) {
-      auto hart = cpu_to_hart_map[cpu];
-      callback(hart, cpu);
-    }
+  cpu_num_t cpu;
+  while ((cpu = remove_cpu_from_mask(cmask)) != INVALID_CPU && cpu < riscv64_num_cpus) {
+    auto hart = cpu_to_hart_map[cpu];
+    callback(hart, cpu);
   }
 }
 
@@ -112,7 +111,7 @@ arch::HartMask riscv64_cpu_mask_to_hart_mask(cpu_mask_t cmask) {
 }
 
 void arch_mp_send_ipi(const mp_ipi_target target, cpu_mask_t cpu_mask, const mp_ipi ipi) {
-  LTRACEF("target %d mask %#x, ipi %d\n", static_cast<int>(target), cpu_mask,
+  LTRACEF("target %d mask %#lx, ipi %d\n", static_cast<int>(target), cpu_mask.word(0),
           static_cast<int>(ipi));
 
   // translate the high level target + mask mechanism into just a mask
@@ -128,7 +127,7 @@ void arch_mp_send_ipi(const mp_ipi_target target, cpu_mask_t cpu_mask, const mp_
   }
 
   // no need to continue if the computed mask is 0
-  if (cpu_mask == 0) {
+  if (cpu_mask.none()) {
     return;
   }
 
@@ -196,7 +196,7 @@ arch::RiscvSbiRet sbi_remote_fencei(cpu_mask_t cpu_mask) {
   arch::HartMask hart_mask = riscv64_cpu_mask_to_hart_mask(cpu_mask);
   arch::HartMaskBase hart_mask_base = 0;
 
-  LTRACEF("cpu_mask %#x, hart_mask %#lx\n", cpu_mask, hart_mask);
+  LTRACEF("cpu_mask %#lx, hart_mask %#lx\n", cpu_mask.word(0), hart_mask);
 
   return arch::RiscvSbi::RemoteFenceI(hart_mask, hart_mask_base);
 }
@@ -205,8 +205,8 @@ arch::RiscvSbiRet sbi_remote_sfence_vma(cpu_mask_t cpu_mask, uintptr_t start, ui
   arch::HartMask hart_mask = riscv64_cpu_mask_to_hart_mask(cpu_mask);
   arch::HartMaskBase hart_mask_base = 0;
 
-  LTRACEF("start %#lx, size %#lx, cpu_mask %#x, hart_mask %#lx\n", start, size, cpu_mask,
-          hart_mask);
+  LTRACEF("start %#lx, size %#lx, cpu_mask %#lx, hart_mask %#lx\n", start, size,
+          cpu_mask.word(0), hart_mask);
 
   return arch::RiscvSbi::RemoteSfenceVma(hart_mask, hart_mask_base, start, size);
 }
@@ -216,8 +216,8 @@ arch::RiscvSbiRet sbi_remote_sfence_vma_asid(cpu_mask_t cpu_mask, uintptr_t star
   arch::HartMask hart_mask = riscv64_cpu_mask_to_hart_mask(cpu_mask);
   arch::HartMaskBase hart_mask_base = 0;
 
-  LTRACEF("start %#lx, size %#lx, asid %lu, cpu_mask %#x, hart_mask %#lx\n", start, size, asid,
-          cpu_mask, hart_mask);
+  LTRACEF("start %#lx, size %#lx, asid %lu, cpu_mask %#lx, hart_mask %#lx\n", start, size, asid,
+          cpu_mask.word(0), hart_mask);
 
   return arch::RiscvSbi::RemoteSfenceVmaAsid(hart_mask, hart_mask_base, start, size, asid);
 }
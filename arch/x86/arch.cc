@@ -171,7 +171,7 @@ void arch_enter_uspace(iframe_t* iframe) {
 }
 
 [[noreturn, gnu::noinline]] static void finish_secondary_entry(
-    ktl::atomic<unsigned int>* aps_still_booting, Thread* thread, uint cpu_num) {
+    AtomicCpuMask* aps_still_booting, Thread* thread, uint cpu_num) {
   // Mark this cpu as online so MP code can try to deliver IPIs.
   // Mark here so any code waiting for the cpu to be started will see the cpu
   // online after the atomic below.
@@ -181,9 +181,9 @@ void arch_enter_uspace(iframe_t* iframe) {
   // operation, we do not touch any resources associated with bootstrap
   // besides our Thread and stack, since this is the checkpoint the
   // bootstrap process uses to identify completion.
-  unsigned int old_val = aps_still_booting->fetch_and(~(1U << cpu_num));
-  if (old_val == 0) {
-    // If the value is already zero, then booting this CPU timed out.
+  const cpu_mask_t old_val = aps_still_booting->fetch_and(~cpu_num_to_mask(cpu_num));
+  if (!old_val.test(cpu_num)) {
+    // If our bit was already cleared, then booting this CPU timed out.
     goto fail;
   }
 
@@ -195,7 +195,7 @@ void arch_enter_uspace(iframe_t* iframe) {
 
   // Load the appropriate PAT/MTRRs.  This must happen after init_percpu, so
   // that this CPU is considered online.
-  x86_pat_sync(1U << cpu_num);
+  x86_pat_sync(cpu_num_to_mask(cpu_num));
 
   /* run early secondary cpu init routines up to the threading level */
   lk_init_level(LK_INIT_FLAG_SECONDARY_CPUS, LK_INIT_LEVEL_EARLIEST, LK_INIT_LEVEL_THREADING - 1);
@@ -221,7 +221,7 @@ fail:
 // this function is simple enough that the compiler won't
 // want to generate stack-protector prologue/epilogue code,
 // which would use %gs.
-__NO_SAFESTACK __NO_RETURN void x86_secondary_entry(ktl::atomic<unsigned int>* aps_still_booting,
+__NO_SAFESTACK __NO_RETURN void x86_secondary_entry(AtomicCpuMask* aps_still_booting,
                                                     Thread* thread) {
   // Would prefer this to be in init_percpu, but there is a dependency on a
   // page mapping existing, and the BP calls that before the VM subsystem is
@@ -130,6 +130,9 @@ zx_status_t x86_get_set_vector_regs(Thread* thread, zx_thread_state_vector_regs_
 
   SingleChainLockGuard guard{IrqSaveOption, thread->get_lock(), CLT_TAG("x86_get_set_vector_regs")};
   DEBUG_ASSERT(thread->IsUserStateSavedLocked());
+  if (access == RegAccess::kSet) {
+    x86_extended_register_invalidate(thread);
+  }
 
   constexpr int kNumSSERegs = 16;
 
@@ -335,6 +338,7 @@ zx_status_t arch_set_fp_regs(Thread* thread, const zx_thread_state_fp_regs_t* in
   SingleChainLockGuard guard{IrqSaveOption, thread->get_lock(), CLT_TAG("arch_set_fp_regs")};
 
   DEBUG_ASSERT(thread->IsUserStateSavedLocked());
+  x86_extended_register_invalidate(thread);
 
   uint32_t comp_size = 0;
   x86_xsave_legacy_area* save =
@@ -136,7 +136,7 @@ void set_global_desc_64(seg_sel_t sel, uint64_t base, uint32_t limit, uint8_t pr
 
 void gdt_setup() {
   DEBUG_ASSERT(arch_curr_cpu_num() == 0);
-  DEBUG_ASSERT(mp_get_online_mask() == 1);
+  DEBUG_ASSERT(mp_get_online_mask() == cpu_num_to_mask(0));
   // Max GDT size is limited to 64K and we reserve the whole 64K area, but we map
   // just enough read/write to store GDT and leave the rest mapped read-only
   // so all write accesses beyond GDT last page are going to cause page fault.
@@ -718,12 +718,36 @@ static const x86_microarch_config_t skylake_config{
         {
             .states =
                 {
-                    {.name = "C10", .mwait_hint = 0x60, .exit_latency = 890, .flushes_tlb = true},
-                    {.name = "C9", .mwait_hint = 0x50, .exit_latency = 480, .flushes_tlb = true},
-                    {.name = "C8", .mwait_hint = 0x40, .exit_latency = 200, .flushes_tlb = true},
-                    {.name = "C7s", .mwait_hint = 0x33, .exit_latency = 124, .flushes_tlb = true},
-                    {.name = "C6", .mwait_hint = 0x20, .exit_latency = 85, .flushes_tlb = true},
-                    {.name = "C3", .mwait_hint = 0x10, .exit_latency = 70, .flushes_tlb = true},
+                    {.name = "C10",
+                     .mwait_hint = 0x60,
+                     .exit_latency = 890,
+                     .target_residency = 5000,
+                     .flushes_tlb = true},
+                    {.name = "C9",
+                     .mwait_hint = 0x50,
+                     .exit_latency = 480,
+                     .target_residency = 5000,
+                     .flushes_tlb = true},
+                    {.name = "C8",
+                     .mwait_hint = 0x40,
+                     .exit_latency = 200,
+                     .target_residency = 800,
+                     .flushes_tlb = true},
+                    {.name = "C7s",
+                     .mwait_hint = 0x33,
+                     .exit_latency = 124,
+                     .target_residency = 800,
+                     .flushes_tlb = true},
+                    {.name = "C6",
+                     .mwait_hint = 0x20,
+                     .exit_latency = 85,
+                     .target_residency = 200,
+                     .flushes_tlb = true},
+                    {.name = "C3",
+                     .mwait_hint = 0x10,
+                     .exit_latency = 70,
+                     .target_residency = 100,
+                     .flushes_tlb = true},
                     X86_CSTATE_C1(0),
                 },
             .default_state_mask = kX86IdleStateMaskC1Only,
@@ -78,6 +78,11 @@ zx::result<ktl::unique_ptr<G>> Guest::Create() {
   IgnoreMsr(guest->msr_bitmaps_page_, X86_MSR_IA32_KERNEL_GS_BASE);
   IgnoreMsr(guest->msr_bitmaps_page_, X86_MSR_IA32_TSC_AUX);
 
+  // This is virtualized by the TPR shadow and virtualize x2APIC mode. Only the
+  // TPR may be passed through: without APIC-register virtualization, other
+  // x2APIC MSRs would access the physical local APIC.
+  IgnoreMsr(guest->msr_bitmaps_page_, X86_MSR_IA32_X2APIC_TPR);
+
   return zx::ok(ktl::move(guest));
 }
 
@@ -5,6 +5,7 @@
 // https://opensource.org/licenses/MIT
 
 #include <arch/x86/hypervisor/invalidate.h>
+#include <arch/x86/hypervisor/vmx_state.h>
 
 #include "vmx_cpu_state_priv.h"
 
@@ -39,5 +40,7 @@ uint64_t ept_pointer_from_pml4(zx_paddr_t ept_pml4) {
       // Use write-back memory type for paging structures.
       VMX_MEMORY_TYPE_WRITE_BACK << 0 |
       // Page walk length of 4 (defined as N minus 1).
-      3u << 3;
+      3u << 3 |
+      // Enable accessed and dirty flags, for the dirty page log.
+      (vmx_ept_supports_accessed_dirty() ? 1u << 6 : 0u);
 }
@@ -25,6 +25,7 @@
 #include <hypervisor/ktrace.h>
 #include <kernel/percpu.h>
 #include <kernel/stats.h>
+#include <platform/timer.h>
 #include <vm/fault.h>
 #include <vm/pmm.h>
 #include <vm/vm_object.h>
@@ -135,8 +136,8 @@ void register_copy(Out& out, const In& in) {
 }
 
 zx::result<> vmcs_init(AutoVmcs& vmcs, const VcpuConfig& config, uint16_t vpid, uintptr_t entry,
-                       paddr_t msr_bitmaps_address, paddr_t ept_pml4, VmxState* vmx_state,
-                       uint8_t* extended_register_state) {
+                       paddr_t msr_bitmaps_address, paddr_t virtual_apic_address,
+                       paddr_t ept_pml4, VmxState* vmx_state, uint8_t* extended_register_state) {
   // Setup secondary processor-based VMCS controls.
   auto result =
       vmcs.SetControl(VmcsField32::PROCBASED_CTLS2, read_msr(X86_MSR_IA32_VMX_PROCBASED_CTLS2), 0,
@@ -306,6 +307,14 @@ zx::result<> vmcs_init(AutoVmcs& vmcs, const VcpuConfig& config, uint16_t vpid,
   // Setup MSR handling.
   vmcs.Write(VmcsField64::MSR_BITMAPS_ADDRESS, msr_bitmaps_address);
 
+  // From Volume 3, Section 29.1: With the TPR shadow enabled, the processor
+  // virtualizes the guest's TPR using the virtual-APIC page. Together with
+  // virtualize x2APIC mode, this lets the guest read and write its TPR, via
+  // both CR8 and the x2APIC TPR MSR, without VM exits. A TPR threshold of 0
+  // means that lowering the TPR never causes a VM exit.
+  vmcs.Write(VmcsField64::VIRTUAL_APIC_ADDRESS, virtual_apic_address);
+  vmcs.Write(VmcsField32::TPR_THRESHOLD, 0);
+
   // Setup VMCS host state.
   //
   // NOTE: We are pinned to a thread when executing this function, therefore
@@ -683,14 +692,20 @@ zx::result<ktl::unique_ptr<V>> Vcpu::Create(G& guest, uint16_t vpid, zx_vaddr_t
   VmxRegion* region = vcpu->vmcs_page_.template VirtualAddress<VmxRegion>();
   region->revision_id = vmx_info.revision_id;
 
+  result = vcpu->virtual_apic_page_.Alloc(vmx_info, 0);
+  if (result.is_error()) {
+    return result.take_error();
+  }
+
   zx_paddr_t ept_pml4 = guest.PhysicalAspace().arch_aspace().arch_table_phys();
   zx_paddr_t vmcs_address = vcpu->vmcs_page_.PhysicalAddress();
   // We create the `AutoVmcs` object here, so that we ensure that interrupts are
   // disabled from `vmcs_init` until `SetMigrateFn`. This is important to ensure
   // that we do not migrate CPUs while setting up the VCPU.
   AutoVmcs vmcs(vmcs_address, /*clear=*/true);
-  result = vmcs_init(vmcs, V::kConfig, vpid, entry, guest.MsrBitmapsAddress(), ept_pml4,
-                     &vcpu->vmx_state_, vcpu->extended_register_state_);
+  result = vmcs_init(vmcs, V::kConfig, vpid, entry, guest.MsrBitmapsAddress(),
+                     vcpu->virtual_apic_page_.PhysicalAddress(), ept_pml4, &vcpu->vmx_state_,
+                     vcpu->extended_register_state_);
   if (result.is_error()) {
     return result.take_error();
   }
@@ -723,7 +738,10 @@ Vcpu::Vcpu(Guest& guest, uint16_t vpid, Thread* thread)
       last_cpu_(thread->LastCpu()),
       thread_(thread),
       vmx_state_(/* zero-init */),
-      msr_state_(/* zero-init */) {
+      msr_state_(/* zero-init */),
+      exit_stats_(thread->pid(), thread->tid(), [](uint32_t reason) {
+        return exit_reason_name(static_cast<ExitReason>(reason));
+      }) {
   thread->set_vcpu(true);
 }
 
@@ -982,7 +1000,11 @@ zx::result<> Vcpu::EnterInternal(PreEnterFn pre_enter, PostExitFn post_exit,
 
     if (result.is_ok()) {
       vmx_state_.resume = true;
+      // From Volume 3, Section 26.7: Bits 15:0 are the basic exit reason.
+      const uint32_t exit_reason = BITS(vmcs.Read(VmcsField32::EXIT_REASON), 15, 0);
+      const zx_instant_mono_t exit_time = current_mono_time();
       result = post_exit(vmcs, packet);
+      exit_stats_.Record(exit_reason, zx_time_sub_time(current_mono_time(), exit_time));
     } else {
       ktrace_vcpu_exit(VCPU_FAILURE, vmcs.Read(VmcsFieldXX::GUEST_RIP));
       uint64_t error = vmcs.Read(VmcsField32::INSTRUCTION_ERROR);
@@ -108,6 +108,7 @@ enum class VmcsField64 : uint64_t {
     EXIT_MSR_STORE_ADDRESS                              = 0x2006,
     EXIT_MSR_LOAD_ADDRESS                               = 0x2008,
     ENTRY_MSR_LOAD_ADDRESS                              = 0x200a,
+    VIRTUAL_APIC_ADDRESS                                = 0x2012,
     EPT_POINTER                                         = 0x201a,
     GUEST_PHYSICAL_ADDRESS                              = 0x2400,
     LINK_POINTER                                        = 0x2800,
@@ -130,6 +131,7 @@ enum class VmcsField32 : uint64_t {
     ENTRY_MSR_LOAD_COUNT                                = 0x4014,
     ENTRY_INTERRUPTION_INFORMATION                      = 0x4016,
     ENTRY_EXCEPTION_ERROR_CODE                          = 0x4018,
+    TPR_THRESHOLD                                       = 0x401c,
     PROCBASED_CTLS2                                     = 0x401e,
     PLE_GAP                                             = 0x4020,
     PLE_WINDOW                                          = 0x4022,
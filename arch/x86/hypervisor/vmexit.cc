@@ -25,6 +25,7 @@
 #include <hypervisor/ktrace.h>
 #include <kernel/percpu.h>
 #include <kernel/stats.h>
+#include <kernel/thread.h>
 #include <ktl/algorithm.h>
 #include <platform/pc/timer.h>
 #include <vm/fault.h>
@@ -65,6 +66,7 @@ alignas(uint32_t) constexpr char kHypVendorId[] = "KVMKVMKVM\0\0\0";
 static_assert(sizeof(kHypVendorId) - 1 == 12, "Vendor ID must be 12 characters long");
 
 constexpr uint64_t kKvmFeatureNoIoDelay = 1u << 1;
+constexpr uint64_t kKvmFeaturePvSchedYield = 1u << 13;
 
 void dump_guest_state(const GuestState& guest_state, const ExitInfo& exit_info) {
   dprintf(INFO, " RAX: %#18lx  RCX: %#18lx  RDX: %#18lx  RBX: %#18lx\n", guest_state.rax,
@@ -309,8 +311,9 @@ zx::result<> handle_cpuid(const ExitInfo& exit_info, AutoVmcs& vmcs, GuestState&
       return zx::ok();
     }
     case X86_CPUID_KVM_FEATURES:
-      // We support KVM clock.
-      guest_state.rax = kKvmFeatureClockSourceOld | kKvmFeatureClockSource | kKvmFeatureNoIoDelay;
+      // We support KVM clock, and the yield hypercall.
+      guest_state.rax = kKvmFeatureClockSourceOld | kKvmFeatureClockSource | kKvmFeatureNoIoDelay |
+                        kKvmFeaturePvSchedYield;
       guest_state.rbx = 0;
       guest_state.rcx = 0;
       guest_state.rdx = 0;
@@ -999,7 +1002,15 @@ zx::result<> handle_xsetbv(const ExitInfo& exit_info, AutoVmcs& vmcs, GuestState
   return zx::ok();
 }
 
-void handle_pause(const ExitInfo& exit_info, AutoVmcs& vmcs) { next_rip(exit_info, vmcs); }
+void handle_pause(const ExitInfo& exit_info, AutoVmcs& vmcs) {
+  next_rip(exit_info, vmcs);
+  // With PAUSE-loop exiting, we only get here once the guest has been spinning
+  // for a while, most likely on a lock held by a vCPU that is not running. Give
+  // up the CPU so that the lock holder has a chance to run, instead of burning
+  // the rest of our time slice.
+  vmcs.Invalidate();
+  Thread::Current::Yield();
+}
 
 bool is_cpl0(AutoVmcs& vmcs) {
   const uint32_t access_rights = vmcs.Read(VmcsField32::GUEST_SS_ACCESS_RIGHTS);
@@ -1035,6 +1046,14 @@ void handle_vmcall_regular(const ExitInfo& exit_info, AutoVmcs& vmcs, GuestState
       guest_state.rax = VmCallStatus::OK;
       break;
     }
+    case VmCallType::SCHED_YIELD:
+      // The guest is waiting on a vCPU that it believes has been preempted,
+      // identified by the APIC ID in arg[0]. VCPUs are not tracked per guest
+      // here, so this is an undirected yield, which still gives the preempted
+      // vCPU a chance to run if it shares this CPU.
+      Thread::Current::Yield();
+      guest_state.rax = VmCallStatus::OK;
+      break;
     default:
       dprintf(INFO,
               "hypervisor: Unknown hypercall %lu (arg0=%#lx, arg1=%#lx, arg2=%#lx, arg3=%#lx)\n",
@@ -249,6 +249,7 @@ enum VmCallStatus : int64_t {
 
 enum class VmCallType : uint64_t {
     CLOCK_PAIRING       = 9u,
+    SCHED_YIELD         = 11u,
 };
 
 // clang-format on
@@ -23,6 +23,10 @@ fbl::Array<VmxPage> vmxon_pages TA_GUARDED(GuestMutex::Get());
 // This starts at an assumption of false and is only made true if every CPU supports ept large
 // pages.
 ktl::atomic<bool> ept_supports_large_pages = false;
+// Likewise for 1gb pages.
+ktl::atomic<bool> ept_supports_huge_pages = false;
+// Likewise, only made true if every CPU supports EPT accessed and dirty flags.
+ktl::atomic<bool> ept_supports_accessed_dirty = false;
 
 void vmxon(zx_paddr_t pa) {
   uint8_t err;
@@ -49,6 +53,8 @@ void vmxoff() {
 struct vmxon_task_state {
   fbl::Array<VmxPage>* pages;
   ktl::atomic<bool>* large_page_support;
+  ktl::atomic<bool>* huge_page_support;
+  ktl::atomic<bool>* accessed_dirty_support;
 };
 
 zx::result<> vmxon_task(void* context, cpu_num_t cpu_num) {
@@ -89,6 +95,17 @@ zx::result<> vmxon_task(void* context, cpu_num_t cpu_num) {
     // disabled.
     state->large_page_support->store(false);
   }
+  if (!ept_info.huge_pages) {
+    dprintf(INFO, "hypervisor: EPT 1gb pages not supported\n");
+    state->huge_page_support->store(false);
+  }
+
+  // Check that accessed and dirty flags are supported.
+  if (!ept_info.accessed_dirty) {
+    // Informational only, the dirty page log will not be available.
+    dprintf(INFO, "hypervisor: EPT accessed and dirty flags not supported\n");
+    state->accessed_dirty_support->store(false);
+  }
 
   // Check that the INVEPT instruction is supported.
   if (!ept_info.invept) {
@@ -162,7 +179,7 @@ void broadcast_invept(uint64_t eptp) {
   Guard<Mutex> guard(GuestMutex::Get());
   if (num_guests != 0) {
     mp_sync_exec(
-        mp_ipi_target::ALL, 0,
+        mp_ipi_target::ALL, {},
         [](void* eptp) { invept(InvEpt::SINGLE_CONTEXT, *static_cast<uint64_t*>(eptp)); }, &eptp);
   }
 }
@@ -182,11 +199,12 @@ EptInfo::EptInfo() {
   uint64_t ept_info = read_msr(X86_MSR_IA32_VMX_EPT_VPID_CAP);
   page_walk_4 = BIT_SHIFT(ept_info, 6);
   write_back = BIT_SHIFT(ept_info, 14);
-  large_pages =
-      // 2mb pages are supported.
-      BIT_SHIFT(ept_info, 16) &&
-      // 1gb pages are supported.
-      BIT_SHIFT(ept_info, 17);
+  // 2mb pages are supported.
+  large_pages = BIT_SHIFT(ept_info, 16);
+  // 1gb pages are supported.
+  huge_pages = BIT_SHIFT(ept_info, 17);
+  // Accessed and dirty flags for EPT are supported.
+  accessed_dirty = BIT_SHIFT(ept_info, 21);
   invept =
       // INVEPT instruction is supported.
       BIT_SHIFT(ept_info, 20) &&
@@ -244,7 +262,14 @@ zx::result<> alloc_vmx_state() {
     }
 
     ktl::atomic<bool> large_page_support = true;
-    vmxon_task_state state = {.pages = &pages, .large_page_support = &large_page_support};
+    ktl::atomic<bool> huge_page_support = true;
+    ktl::atomic<bool> accessed_dirty_support = true;
+    vmxon_task_state state = {
+        .pages = &pages,
+        .large_page_support = &large_page_support,
+        .huge_page_support = &huge_page_support,
+        .accessed_dirty_support = &accessed_dirty_support,
+    };
 
     // Enable VMX for all online CPUs.
     cpu_mask_t cpu_mask = hypervisor::percpu_exec(vmxon_task, &state);
@@ -253,6 +278,9 @@ zx::result<> alloc_vmx_state() {
       return zx::error(ZX_ERR_NOT_SUPPORTED);
     }
     ept_supports_large_pages.store(large_page_support.load());
+    // 1gb pages are only used alongside 2mb pages.
+    ept_supports_huge_pages.store(large_page_support.load() && huge_page_support.load());
+    ept_supports_accessed_dirty.store(accessed_dirty_support.load());
 
     vmxon_pages = ktl::move(pages);
   }
@@ -264,7 +292,7 @@ void free_vmx_state() {
   Guard<Mutex> guard(GuestMutex::Get());
   num_guests--;
   if (num_guests == 0) {
-    mp_sync_exec(mp_ipi_target::ALL, 0, vmxoff_task, nullptr);
+    mp_sync_exec(mp_ipi_target::ALL, {}, vmxoff_task, nullptr);
     vmxon_pages.reset();
   }
 }
@@ -276,3 +304,7 @@ bool cr_is_invalid(uint64_t cr_value, uint32_t fixed0_msr, uint32_t fixed1_msr)
 }
 
 bool vmx_ept_supports_large_pages() { return ept_supports_large_pages; }
+
+bool vmx_ept_supports_huge_pages() { return ept_supports_huge_pages; }
+
+bool vmx_ept_supports_accessed_dirty() { return ept_supports_accessed_dirty; }
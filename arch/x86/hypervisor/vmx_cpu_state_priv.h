@@ -45,6 +45,8 @@ struct EptInfo {
   bool page_walk_4;
   bool write_back;
   bool large_pages;
+  bool huge_pages;
+  bool accessed_dirty;
   bool invept;
   bool invvpid;
 
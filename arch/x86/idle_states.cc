@@ -10,13 +10,21 @@
 
 #include <arch/x86/feature.h>
 #include <arch/x86/idle_states.h>
+#include <ktl/algorithm.h>
 #include <ktl/atomic.h>
 
 #include <ktl/enforce.h>
 
 namespace {
 
-constexpr int kIdleDurationFactor = 3;
+// Idle durations are tracked in microseconds and clamped to a second, which is deeper than any
+// state's target residency, so that the statistics below cannot overflow.
+constexpr uint64_t kMaxTrackedIdleUs = 1'000'000;
+
+// Recent idle durations whose variance is below this (in us^2), or whose standard deviation is
+// below a sixth of their average, are considered to have a typical duration.
+constexpr uint64_t kTypicalVarianceUs2 = 400;
+constexpr uint64_t kTypicalStddevDivisor = 6;
 
 constexpr uint32_t StateNumberFromMwaitHint(uint32_t hint) { return BITS_SHIFT(hint, 8, 4) + 1; }
 
@@ -35,7 +43,7 @@ int x86_num_idle_states(const x86_idle_states_t* states) {
   return -1;
 }
 
-X86IdleStates::X86IdleStates(const x86_idle_states_t* states) : last_idle_duration_(0U) {
+X86IdleStates::X86IdleStates(const x86_idle_states_t* states) {
   auto num_states = x86_num_idle_states(states);
   ASSERT_MSG(num_states > 0, "Invalid C-state configuration: Expected at least C1 to be defined.");
   num_states_ = static_cast<size_t>(num_states);
@@ -45,21 +53,77 @@ X86IdleStates::X86IdleStates(const x86_idle_states_t* states) : last_idle_durati
   state_mask_ = states->default_state_mask | 0x1;  // Always allow C1
 }
 
-X86IdleState* X86IdleStates::PickIdleState() {
-  if (last_idle_duration_ == 0) {
+void X86IdleStates::RecordDuration(zx_duration_t duration) {
+  idle_history_[idle_history_next_] = duration;
+  idle_history_next_ = (idle_history_next_ + 1) % kIdleHistorySize;
+  idle_history_count_ = ktl::min(idle_history_count_ + 1, kIdleHistorySize);
+}
+
+zx_duration_t X86IdleStates::TypicalIdleDuration() const {
+  // Samples above |threshold| have been discarded as outliers.
+  uint64_t threshold = kMaxTrackedIdleUs;
+  for (;;) {
+    uint64_t samples[kIdleHistorySize];
+    size_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+    for (size_t i = 0; i < idle_history_count_; ++i) {
+      const uint64_t us =
+          ktl::min(static_cast<uint64_t>(ktl::max<zx_duration_t>(idle_history_[i], 0)) / 1000,
+                   kMaxTrackedIdleUs);
+      if (us <= threshold) {
+        samples[count++] = us;
+        sum += us;
+        max = ktl::max(max, us);
+      }
+    }
+    if (count == 0) {
+      return ZX_TIME_INFINITE;
+    }
+
+    const uint64_t avg = sum / count;
+    uint64_t variance = 0;
+    for (size_t i = 0; i < count; ++i) {
+      const uint64_t diff = samples[i] > avg ? samples[i] - avg : avg - samples[i];
+      variance += diff * diff;
+    }
+    variance /= count;
+
+    if (variance <= kTypicalVarianceUs2 ||
+        avg * avg > kTypicalStddevDivisor * kTypicalStddevDivisor * variance) {
+      return zx_duration_from_usec(avg);
+    }
+
+    // Too spread out. Discard the longest samples, which are the likeliest to be one-off long
+    // sleeps, but give up once fewer than three quarters of the history would remain.
+    if (count * 4 <= idle_history_count_ * 3) {
+      return ZX_TIME_INFINITE;
+    }
+    threshold = max - 1;
+  }
+}
+
+X86IdleState* X86IdleStates::PickIdleState(zx_duration_t time_to_next_timer,
+                                           zx_duration_t latency_limit) {
+  if (idle_history_count_ == 0) {
     // Return the shallowest state (C1).
     return &states_[num_states_ - 1];
   }
+
+  // The CPU will stay idle no longer than until its next timer, and likely no longer than its
+  // recent idle periods if they have been consistent.
+  const zx_duration_t predicted_idle = ktl::min(time_to_next_timer, TypicalIdleDuration());
+
   const uint32_t valid_state_mask = state_mask_.load(ktl::memory_order_relaxed);
-  // Pick the deepest valid state which has ExitLatency less than
-  // kIdleDurationFactor * <expected idle duration>
+  // Pick the deepest valid state which pays for itself within the predicted idle duration and
+  // can be exited within the latency limit.
   for (unsigned i = 0; i < num_states_; ++i) {
     auto& state = states_[i];
     auto state_num = StateNumberFromMwaitHint(state.MwaitHint());
     if (!(BIT_SET(valid_state_mask, state_num - 1))) {
       continue;
     }
-    if (state.ExitLatency() < kIdleDurationFactor * last_idle_duration_) {
+    if (state.TargetResidency() <= predicted_idle && state.ExitLatency() <= latency_limit) {
       return &state;
     }
   }
@@ -43,6 +43,13 @@ bool test_c1_only() {
   END_TEST;
 }
 
+// Fills the idle history of |states| with |duration|.
+void RecordSteadyIdle(X86IdleStates& states, zx_duration_t duration) {
+  for (int i = 0; i < 8; ++i) {
+    states.RecordDuration(duration);
+  }
+}
+
 bool test_kbl() {
   BEGIN_TEST;
 
@@ -53,22 +60,22 @@ bool test_kbl() {
   EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
   EXPECT_EQ(state->MwaitHint(), 0x00u);
 
-  states.RecordDuration(zx_duration_from_usec(3U));
+  RecordSteadyIdle(states, zx_duration_from_usec(5U));
   state = states.PickIdleState();
   EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
   EXPECT_EQ(state->MwaitHint(), 0x00u);
 
-  states.RecordDuration(zx_duration_from_usec(4U));
+  RecordSteadyIdle(states, zx_duration_from_usec(50U));
   state = states.PickIdleState();
   EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
   EXPECT_EQ(state->MwaitHint(), 0x01u);
 
-  states.RecordDuration(zx_duration_from_usec(34U));
+  RecordSteadyIdle(states, zx_duration_from_usec(500U));
   state = states.PickIdleState();
   EXPECT_EQ(strcmp(state->Name(), "C3"), 0);
   EXPECT_EQ(state->MwaitHint(), 0x20u);
 
-  states.RecordDuration(zx_duration_from_usec(334U));
+  RecordSteadyIdle(states, zx_duration_from_usec(5000U));
   state = states.PickIdleState();
   EXPECT_EQ(strcmp(state->Name(), "C6"), 0);
   EXPECT_EQ(state->MwaitHint(), 0x50u);
@@ -76,6 +83,47 @@ bool test_kbl() {
   END_TEST;
 }
 
+bool test_kbl_prediction() {
+  BEGIN_TEST;
+
+  X86IdleStates states(&kKabyLakeIdleStates);
+  RecordSteadyIdle(states, zx_duration_from_usec(5000U));
+
+  // A nearer timer bounds the predicted idle duration.
+  X86IdleState* state = states.PickIdleState(zx_duration_from_usec(500U));
+  EXPECT_EQ(strcmp(state->Name(), "C3"), 0);
+  state = states.PickIdleState(zx_duration_from_usec(50U));
+  EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
+  state = states.PickIdleState(0);
+  EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
+
+  // So does the latency a deadline thread can tolerate.
+  state = states.PickIdleState(ZX_TIME_INFINITE, zx_duration_from_usec(500U));
+  EXPECT_EQ(strcmp(state->Name(), "C3"), 0);
+  state = states.PickIdleState(ZX_TIME_INFINITE, zx_duration_from_usec(99U));
+  EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
+
+  // A single long idle period is discarded as an outlier.
+  states.RecordDuration(zx_duration_from_usec(900000U));
+  state = states.PickIdleState();
+  EXPECT_EQ(strcmp(state->Name(), "C6"), 0);
+
+  // Short idle periods pull the prediction down, even with no timer pending.
+  RecordSteadyIdle(states, zx_duration_from_usec(50U));
+  state = states.PickIdleState();
+  EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
+
+  // With no typical idle duration, the next timer is the only guide.
+  constexpr uint32_t kScatteredUs[] = {100, 300, 900, 2700};
+  for (uint32_t i = 0; i < 8; ++i) {
+    states.RecordDuration(zx_duration_from_usec(kScatteredUs[i % 4]));
+  }
+  state = states.PickIdleState(zx_duration_from_usec(500U));
+  EXPECT_EQ(strcmp(state->Name(), "C3"), 0);
+
+  END_TEST;
+}
+
 bool test_kbl_statemask() {
   BEGIN_TEST;
 
@@ -86,42 +134,38 @@ bool test_kbl_statemask() {
   X86IdleState* state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x00u);
   EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
-  states.RecordDuration(zx_duration_from_usec(3U));
+  RecordSteadyIdle(states, zx_duration_from_usec(5U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x00u);
   EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
-  states.RecordDuration(zx_duration_from_usec(4U));
+  RecordSteadyIdle(states, zx_duration_from_usec(50U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x01u);
   EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
-  states.RecordDuration(zx_duration_from_usec(34U));
+  RecordSteadyIdle(states, zx_duration_from_usec(500U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x01u);
   EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
-  states.RecordDuration(zx_duration_from_usec(334U));
+  RecordSteadyIdle(states, zx_duration_from_usec(5000U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x01u);
   EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
 
   // Mask to only allow C6, C1/C1E
   states.SetStateMask(0b0000'0000'0010'0001);
-  states.RecordDuration(zx_duration_from_usec(0u));
-  state = states.PickIdleState();
-  EXPECT_EQ(state->MwaitHint(), 0x00u);
-  EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
-  states.RecordDuration(zx_duration_from_usec(3U));
+  RecordSteadyIdle(states, zx_duration_from_usec(5U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x00u);
   EXPECT_EQ(strcmp(state->Name(), "C1"), 0);
-  states.RecordDuration(zx_duration_from_usec(4U));
+  RecordSteadyIdle(states, zx_duration_from_usec(50U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x01u);
   EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
-  states.RecordDuration(zx_duration_from_usec(34U));
+  RecordSteadyIdle(states, zx_duration_from_usec(500U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x01u);
   EXPECT_EQ(strcmp(state->Name(), "C1E"), 0);
-  states.RecordDuration(zx_duration_from_usec(334U));
+  RecordSteadyIdle(states, zx_duration_from_usec(5000U));
   state = states.PickIdleState();
   EXPECT_EQ(state->MwaitHint(), 0x50u);
   EXPECT_EQ(strcmp(state->Name(), "C6"), 0);
@@ -182,6 +226,8 @@ bool test_enter_idle_states() {
 UNITTEST_START_TESTCASE(x86_idle_states_tests)
 UNITTEST("Select an idle state using data from a CPU with only C1.", test_c1_only)
 UNITTEST("Select an idle state using data from a Kabylake CPU.", test_kbl)
+UNITTEST("Select an idle state bounded by the next timer and a latency limit.",
+         test_kbl_prediction)
 UNITTEST("Select an idle state using data from a Kabylake CPU, respecting a mask of valid states.",
          test_kbl_statemask)
 UNITTEST("Enter each supported idle state using MWAIT/MONITOR.", test_enter_idle_states)
@@ -114,7 +114,7 @@ void idt_setup(struct idt* idt) {
 // TODO(thgarnie): Move to C++ and non-compact VMAR for KASLR support.
 void idt_setup_readonly(void) {
   DEBUG_ASSERT(arch_curr_cpu_num() == 0);
-  DEBUG_ASSERT(mp_get_online_mask() == 1);
+  DEBUG_ASSERT(mp_get_online_mask() == cpu_num_to_mask(0));
   zx_status_t status = VmAspace::kernel_aspace()->AllocPhysical(
       "idt_readonly", sizeof(_idt), (void**)&_idt_ro, PAGE_SIZE_SHIFT, vaddr_to_paddr(&_idt),
       0 /* vmm flags */, ARCH_MMU_FLAG_PERM_READ);
@@ -16,6 +16,7 @@
 
 #include <arch/kernel_aspace.h>
 #include <arch/x86/registers.h>
+#include <kernel/cpu.h>
 
 struct syscall_regs_t;
 
@@ -55,6 +56,10 @@ struct arch_thread {
   // xsaves instruction requires the target buffer be 64 byte aligned.
   alignas(64) uint8_t extended_register_buffer[X86_MAX_EXTENDED_REGISTER_SIZE];
 
+  // The CPU whose registers this thread's extended state was last loaded into, or INVALID_CPU if
+  // |extended_register_buffer| has been modified since. See x86_extended_register_switch_to.
+  cpu_num_t extended_register_cpu;
+
   // If non-NULL, address to return to on page fault. Additionally the
   // X86_PFR_RUN_FAULT_HANDLER_BIT controls whether the fault handler is invoked or not. If not
   // invoked resume is called with rdx = fault address and rcx = page fault flags.
@@ -52,6 +52,8 @@ class X86PageTableMmu final : public X86PageTableImpl<X86PageTableMmu> {
   void TlbInvalidate(const PendingTlbInvalidation* pending);
   uint pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level);
   bool needs_cache_flushes() { return false; }
+  PtFlags dirty_flag() { return X86_MMU_PG_D; }
+  PtFlags accessed_dirty_flags() { return X86_MMU_PG_A | X86_MMU_PG_D; }
 
   // If true, all mappings will have the global bit set.
   bool use_global_mappings_ = false;
@@ -74,6 +76,10 @@ class X86PageTableEpt final : public X86PageTableImpl<X86PageTableEpt> {
   void TlbInvalidate(const PendingTlbInvalidation* pending);
   uint pt_flags_to_mmu_flags(PtFlags flags, PageTableLevel level);
   bool needs_cache_flushes() { return false; }
+  // The accessed and dirty flags are only set by the hardware if they were enabled in the EPT
+  // pointer. See vmx_ept_supports_accessed_dirty.
+  PtFlags dirty_flag() { return X86_EPT_D; }
+  PtFlags accessed_dirty_flags() { return X86_EPT_A | X86_EPT_D; }
 };
 
 class X86ArchVmAspace final : public ArchVmAspaceInterface {
@@ -121,6 +127,9 @@ class X86ArchVmAspace final : public ArchVmAspaceInterface {
 
   bool AccessedSinceLastCheck(bool clear) override;
 
+  // Reports and resets dirty flags. See X86PageTableBase::HarvestDirty.
+  zx_status_t HarvestDirty(vaddr_t vaddr, size_t count, const DirtyRangeFunction& dirty) override;
+
   paddr_t arch_table_phys() const override { return pt_->phys(); }
   paddr_t pt_phys() const { return pt_->phys(); }
   size_t pt_pages() const { return pt_->pages(); }
@@ -139,6 +148,9 @@ class X86ArchVmAspace final : public ArchVmAspaceInterface {
 
   static void HandoffPageTablesFromPhysboot(list_node_t* mmu_pages);
 
+  // The hardware sets accessed and dirty flags itself and never faults on them.
+  static constexpr bool HasUnreportedAccessFaults() { return false; }
+
   static constexpr vaddr_t NextUserPageTableOffset(vaddr_t va) {
     // This logic only works for 'regular' page sizes that match the hardware page sizes.
     static_assert(PAGE_SIZE_SHIFT == 12 || PAGE_SIZE_SHIFT == 21);
@@ -183,14 +195,14 @@ class X86ArchVmAspace final : public ArchVmAspaceInterface {
   const size_t size_ = 0;
 
   // CPUs that are currently executing in this aspace.
-  ktl::atomic<cpu_mask_t> active_cpus_{0};
+  AtomicCpuMask active_cpus_;
 
   // Whether not this has been accessed since |AccessedSinceLastCheck| was called.
   ktl::atomic<bool> accessed_since_last_check_ = false;
 
   // A bitmap of cpus where the current PCID that was assigned is now dirty and should
   // be flushed on the next context switch.
-  ktl::atomic<cpu_mask_t> pcid_dirty_cpus_{0};
+  AtomicCpuMask pcid_dirty_cpus_;
 };
 
 class X86VmICacheConsistencyManager final : public ArchVmICacheConsistencyManagerInterface {
@@ -17,6 +17,7 @@
 #include <arch/x86/interrupts.h>
 #include <fbl/ref_ptr.h>
 #include <hypervisor/aspace.h>
+#include <hypervisor/exit_stats.h>
 #include <hypervisor/interrupt_tracker.h>
 #include <hypervisor/page.h>
 #include <hypervisor/trap_map.h>
@@ -176,8 +177,11 @@ class Vcpu {
   ktl::atomic<bool> kicked_ = false;
   ktl::atomic<bool> entered_ = false;
   VmxPage vmcs_page_;
+  // Backs the TPR shadow, so that the guest's TPR accesses do not cause VM exits.
+  VmxPage virtual_apic_page_;
   VmxState vmx_state_;
   MsrState msr_state_;
+  hypervisor::ExitStats exit_stats_;
   // The guest may enable any state, so the XSAVE area is the maximum size.
   alignas(64) uint8_t extended_register_state_[X86_MAX_EXTENDED_REGISTER_SIZE];
 };
@@ -15,6 +15,11 @@
 struct ArchSavedNormalState {
   uint64_t normal_fs_base_ = 0;
   uint64_t normal_gs_base_ = 0;
+
+  // The FS and GS base known to be loaded in the hardware while the thread switches modes with
+  // interrupts disabled, so that the switch only rewrites the bases that differ between modes.
+  uint64_t live_fs_base_ = 0;
+  uint64_t live_gs_base_ = 0;
 };
 
 #endif  // ZIRCON_KERNEL_ARCH_X86_INCLUDE_ARCH_RESTRICTED_H_
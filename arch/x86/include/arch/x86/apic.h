@@ -124,6 +124,8 @@ void apic_io_configure_irq(uint32_t global_irq, enum interrupt_trigger_mode trig
 zx_status_t apic_io_fetch_irq_config(uint32_t global_irq, enum interrupt_trigger_mode* trig_mode,
                                      enum interrupt_polarity* polarity);
 void apic_io_configure_irq_vector(uint32_t global_irq, uint8_t vector);
+// Retargets |global_irq| at the local APIC with the physical ID |dst|.
+void apic_io_configure_irq_destination(uint32_t global_irq, uint8_t dst);
 uint8_t apic_io_fetch_irq_vector(uint32_t global_irq);
 
 void apic_io_mask_isa_irq(uint8_t isa_irq, bool mask);
@@ -25,6 +25,7 @@
 #include <zircon/compiler.h>
 #include <zircon/types.h>
 
+#include <kernel/cpu.h>
 #include <vm/vm_aspace.h>
 
 struct x86_bootstrap16_data {
@@ -68,7 +69,7 @@ struct __PACKED x86_ap_bootstrap_data {
   // Counter for APs to use to determine which stack to take
   uint32_t cpu_id_counter;
   // Pointer to value to use to determine when APs are done with boot
-  ktl::atomic<unsigned int>* cpu_waiting_mask;
+  AtomicCpuMask* cpu_waiting_mask;
 
   // Per-cpu data
   struct __PACKED {
@@ -124,6 +124,11 @@ static_assert(__offsetof(VmxState, guest_state.cr2) == GS_CR2);
 zx::result<> vmx_enter(VmxState* vmx_state);
 
 bool vmx_ept_supports_large_pages();
+bool vmx_ept_supports_huge_pages();
+
+// Whether the processor sets the accessed and dirty flags in EPT entries. If so, every EPT pointer
+// enables them.
+bool vmx_ept_supports_accessed_dirty();
 
 // Implemented in assembly.
 extern "C" {
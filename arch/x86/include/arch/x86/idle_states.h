@@ -20,6 +20,9 @@ typedef struct {
   uint32_t mwait_hint;
   // The expected latency (in us) of exiting the C-state.
   uint32_t exit_latency;
+  // The minimum time (in us) the CPU must stay in the C-state for entering it to save power over
+  // a shallower one. Zero means the same as |exit_latency|.
+  uint32_t target_residency;
   // Whether entering the state can result in a TLB flush.
   bool flushes_tlb;
 } x86_idle_state_t;
@@ -49,10 +52,10 @@ typedef struct {
 #define X86_CSTATE_C1_NAME "C1"
 #define X86_CSTATE_C1_MWAIT_HINT 0x00
 
-#define X86_CSTATE_C1(exit_latency_us)                                  \
-  {                                                                     \
-    .name = X86_CSTATE_C1_NAME, .mwait_hint = X86_CSTATE_C1_MWAIT_HINT, \
-    .exit_latency = (exit_latency_us), .flushes_tlb = false,            \
+#define X86_CSTATE_C1(exit_latency_us)                                                  \
+  {                                                                                     \
+    .name = X86_CSTATE_C1_NAME, .mwait_hint = X86_CSTATE_C1_MWAIT_HINT,                 \
+    .exit_latency = (exit_latency_us), .target_residency = 0, .flushes_tlb = false,     \
   }
 
 static inline bool x86_is_base_idle_state(const x86_idle_state_t* state) {
@@ -87,6 +90,12 @@ class X86IdleState {
     return zx_duration_from_usec(state_->exit_latency);
   }
 
+  // Returns the minimum idle duration for which entering this state is worthwhile.
+  constexpr zx_duration_t TargetResidency() const {
+    return state_->target_residency != 0 ? zx_duration_from_usec(state_->target_residency)
+                                         : ExitLatency();
+  }
+
   bool IsBaseState() const { return x86_is_base_idle_state(state_); }
 
   constexpr bool FlushesTlb() const { return state_->flushes_tlb; }
@@ -131,18 +140,33 @@ class X86IdleStates {
   constexpr size_t NumStates() const { return num_states_; }
 
   // Picks an idle state to enter.
-  X86IdleState* PickIdleState();
+  //
+  // The idle duration is predicted as the lesser of |time_to_next_timer| and the typical duration
+  // of recent idle periods, if they have one, and the deepest allowed state whose target residency
+  // fits the prediction and whose exit latency does not exceed |latency_limit| is chosen. With no
+  // idle history yet, the shallowest state is chosen.
+  X86IdleState* PickIdleState(zx_duration_t time_to_next_timer = ZX_TIME_INFINITE,
+                              zx_duration_t latency_limit = ZX_TIME_INFINITE);
 
   // Callback to call when the system becomes idle.
-  void RecordDuration(zx_duration_t duration) { last_idle_duration_ = duration; }
+  void RecordDuration(zx_duration_t duration);
 
   // Updates the mask of valid C-states.
   void SetStateMask(uint32_t mask) { state_mask_ = mask | 0x1;  /* Always allow C1 */ }
 
  private:
+  static constexpr size_t kIdleHistorySize = 8;
+
+  // Returns the typical duration of the recorded idle periods, discarding the longest few as
+  // outliers if needed, or ZX_TIME_INFINITE if they are too spread out to have one.
+  zx_duration_t TypicalIdleDuration() const;
+
   X86IdleState states_[X86_MAX_CSTATES];
   size_t num_states_;
-  zx_duration_t last_idle_duration_;
+  // The most recent idle durations, as a ring buffer.
+  zx_duration_t idle_history_[kIdleHistorySize] = {};
+  size_t idle_history_count_ = 0;
+  size_t idle_history_next_ = 0;
   ktl::atomic<uint32_t> state_mask_;
 };
 
@@ -84,6 +84,8 @@
 #define X86_KERNEL_KASAN_INITIAL_PD_FLAGS (X86_MMU_PG_P)
 #define X86_KERNEL_KASAN_RW_PT_FLAGS (X86_MMU_PG_G | X86_MMU_PG_RW | X86_MMU_PG_P)
 #define X86_KERNEL_KASAN_PD_FLAGS (X86_MMU_PG_RW | X86_MMU_PG_P)
+// Where the shadow of a whole page directory entry is needed, a read-write 2MB page backs it.
+#define X86_KERNEL_KASAN_RW_LP_FLAGS (X86_MMU_PG_G | X86_MMU_PG_PS | X86_MMU_PG_RW | X86_MMU_PG_P)
 
 #define MMU_GUEST_SIZE_SHIFT 48
 
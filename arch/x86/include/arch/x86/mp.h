@@ -109,6 +109,10 @@ struct x86_percpu {
     uint8_t machine_check[INTERRUPT_STACK_SIZE] __ALIGNED(16);
     uint8_t double_fault[INTERRUPT_STACK_SIZE] __ALIGNED(16);
   } interrupt_stacks;
+
+  /* The thread whose extended register state is live in this core's registers, if any. Kernel
+   * threads do not touch the extended registers, so this is the last user thread to run here. */
+  const Thread *extended_register_owner;
 } __CPU_ALIGN;
 
 static_assert(__offsetof(struct x86_percpu, direct) == PERCPU_DIRECT_OFFSET);
@@ -138,6 +142,7 @@ extern "C" void x86_init_percpu(cpu_num_t cpu_num);
 void x86_set_local_apic_id(uint32_t apic_id);
 
 int x86_apic_id_to_cpu_num(uint32_t apic_id);
+uint32_t x86_cpu_num_to_apic_id(cpu_num_t cpu_num);
 
 // Allocate all of the necessary structures for all of the APs to run.
 zx_status_t x86_allocate_ap_structures(uint32_t *apic_ids, uint8_t cpu_count);
@@ -183,7 +188,7 @@ inline uint arch_max_num_cpus() { return x86_num_cpus; }
 void x86_ipi_halt_handler() __NO_RETURN;
 
 // Called from assembly.
-extern "C" void x86_secondary_entry(ktl::atomic<unsigned int> *aps_still_booting, Thread *thread);
+extern "C" void x86_secondary_entry(AtomicCpuMask *aps_still_booting, Thread *thread);
 
 void x86_force_halt_all_but_local_and_bsp();
 
@@ -339,7 +339,17 @@ void x86_extended_register_save_state(void* register_state);
 void x86_extended_register_restore_state(const void* register_state);
 
 struct Thread;
-void x86_extended_register_context_switch(Thread* old_thread, const Thread* new_thread);
+/* Save |old_thread|'s state and load |new_thread|'s. Kernel threads have no extended register
+ * state of their own and are skipped. */
+void x86_extended_register_context_switch(Thread* old_thread, Thread* new_thread);
+
+/* Load the state of |thread|, which is about to run on the current CPU, unless it is still live
+ * in the registers because no other user thread has run here since it last did. */
+void x86_extended_register_switch_to(Thread* thread);
+
+/* Note that the saved state of |thread|, which is not running, has been modified, so it must be
+ * loaded again before the thread next runs. */
+void x86_extended_register_invalidate(Thread* thread);
 
 void x86_set_extended_register_pt_state(bool threads);
 
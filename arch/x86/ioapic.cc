@@ -362,6 +362,18 @@ void apic_io_configure_irq_vector(uint32_t global_irq, uint8_t vector) {
   apic_io_write_redirection_entry(io_apic, global_irq, reg);
 }
 
+void apic_io_configure_irq_destination(uint32_t global_irq, uint8_t dst) {
+  struct io_apic* io_apic = apic_io_resolve_global_irq(global_irq);
+
+  Guard<SpinLock, IrqSave> guard{io_apic_lock::Get()};
+
+  uint64_t reg = apic_io_read_redirection_entry(io_apic, global_irq);
+  reg &= ~(IO_APIC_RTE_DST(0xff) | IO_APIC_RTE_DST_MODE(1));
+  reg |= IO_APIC_RTE_DST_MODE(DST_MODE_PHYSICAL);
+  reg |= IO_APIC_RTE_DST(dst);
+  apic_io_write_redirection_entry(io_apic, global_irq, reg);
+}
+
 uint8_t apic_io_fetch_irq_vector(uint32_t global_irq) {
   struct io_apic* io_apic = apic_io_resolve_global_irq(global_irq);
 
@@ -51,6 +51,8 @@ KCOUNTER(ept_tlb_invalidations, "mmu.ept_tlb_invalidations")
 KCOUNTER(context_switches, "mmu.context_switches")
 // Count the total number of fast context switches on the cpu (using PCID feature)
 KCOUNTER(context_switches_pcid, "mmu.context_switches_pcid")
+// Count of user aspaces that ran untagged because every PCID was in use
+KCOUNTER(pcid_exhausted, "mmu.pcid_exhausted")
 
 /* Default address width including virtual/physical address.
  * newer versions fetched below */
@@ -362,9 +364,9 @@ void X86PageTableMmu::TlbInvalidate(const PendingTlbInvalidation* pending) {
   };
   TlbInvalidatePage_context task_context = {
       .target_root_ptable = root_ptable_phys,
-      .target_mask = 0,
+      .target_mask = {},
       .target_unified_ptable = unified_ptable_phys,
-      .target_unified_mask = 0,
+      .target_unified_mask = {},
       .pending = pending,
       .pcid = pcid,
       .unified_pcid = unified_pcid,
@@ -372,7 +374,7 @@ void X86PageTableMmu::TlbInvalidate(const PendingTlbInvalidation* pending) {
   };
 
   mp_ipi_target target;
-  cpu_mask_t target_mask = 0;
+  cpu_mask_t target_mask{};
   // We need to send the TLB invalidate to all CPUs if this aspace is shared because active_cpus
   // is inaccurate in that case (another CPU may be running a unified aspace with these shared
   // mappings).
@@ -398,15 +400,14 @@ void X86PageTableMmu::TlbInvalidate(const PendingTlbInvalidation* pending) {
     }
 
     if (g_x86_feature_pcid_enabled) {
-      // Only the kernel aspace uses the 0 pcid, and all its mappings are global and so would have
-      // forced an IPI_TARGET_ALL above.
-      DEBUG_ASSERT(pcid != MMU_X86_UNUSED_PCID);
       // Mark all cpus as being dirty that aren't in this mask. This will force a TLB flush on the
       // next context switch on that cpu. If this is a restricted aspace, then we need to mark the
-      // PCID of the associated unified aspace as dirty as well.
-      aspace->MarkPcidDirtyCpus(~task_context.target_mask);
-      if (unified_aspace) {
-        DEBUG_ASSERT(unified_pcid != MMU_X86_UNUSED_PCID);
+      // PCID of the associated unified aspace as dirty as well. A user aspace that could not get a
+      // PCID runs under the 0 pcid, which is flushed on every load, so there is nothing to mark.
+      if (pcid != MMU_X86_UNUSED_PCID) {
+        aspace->MarkPcidDirtyCpus(~task_context.target_mask);
+      }
+      if (unified_aspace && unified_pcid != MMU_X86_UNUSED_PCID) {
         unified_aspace->MarkPcidDirtyCpus(~task_context.target_unified_mask);
       }
 
@@ -477,7 +478,6 @@ void X86PageTableMmu::TlbInvalidate(const PendingTlbInvalidation* pending) {
             x86_tlb_nonglobal_invalidate(context->pcid);
           }
           if (curr_cpu_bit & context->target_unified_mask) {
-            DEBUG_ASSERT(context->unified_pcid != MMU_X86_UNUSED_PCID);
             // If there's an associated unified PCID, invalidate that PCID too.
             x86_tlb_nonglobal_invalidate(context->unified_pcid);
           }
@@ -491,49 +491,52 @@ void X86PageTableMmu::TlbInvalidate(const PendingTlbInvalidation* pending) {
      */
     for (uint i = 0; i < context->pending->count; ++i) {
       const auto& item = context->pending->item[i];
-      switch (static_cast<PageTableLevel>(item.page_level())) {
-        case PageTableLevel::PML4_L:
-          panic("PML4_L invld found; should not be here\n");
-        case PageTableLevel::PDP_L:
-        case PageTableLevel::PD_L:
-        case PageTableLevel::PT_L:
-          // Terminal entry is being asked to be flushed.
-          if (item.is_global() || context->pcid == MMU_X86_UNUSED_PCID) {
-            // If this is a global page or does not belong to a special PCID, then use an invlpg
-            // instruction to invalidate the address of the page.
-            invlpg(item.addr());
-          } else {
-            // This item does not contain a global page and has a valid PCID.
-            // Start by invalidating the target PCID if it is running (or has run) on this CPU.
-            if (curr_cpu_bit & context->target_mask) {
-              if (context->target_root_ptable == current_root_ptable) {
-                // If the CPU we're running on is running the target aspace, then run an invlpg to
-                // flush the address from our TLB.
-                invlpg(item.addr());
-              } else {
-                // In this case, the target aspace is not actively running on this CPU, but we know
-                // that the CPU ran this aspace in the past. Therefore, we have to flush this PCID
-                // using an invpcid.
-                invpcid_va_pcid(item.addr(), context->pcid);
+      for (uint j = 0; j < item.pages(); ++j) {
+        const vaddr_t addr = item.addr() + j * item.page_size();
+        switch (static_cast<PageTableLevel>(item.page_level())) {
+          case PageTableLevel::PML4_L:
+            panic("PML4_L invld found; should not be here\n");
+          case PageTableLevel::PDP_L:
+          case PageTableLevel::PD_L:
+          case PageTableLevel::PT_L:
+            // Terminal entry is being asked to be flushed.
+            if (item.is_global() || (context->pcid == MMU_X86_UNUSED_PCID &&
+                                     context->unified_pcid == MMU_X86_UNUSED_PCID)) {
+              // If this is a global page or does not belong to a special PCID, then use an invlpg
+              // instruction to invalidate the address of the page.
+              invlpg(addr);
+            } else {
+              // This item does not contain a global page and has a valid PCID.
+              // Start by invalidating the target PCID if it is running (or has run) on this CPU.
+              if (curr_cpu_bit & context->target_mask) {
+                if (context->target_root_ptable == current_root_ptable) {
+                  // If the CPU we're running on is running the target aspace, then run an invlpg
+                  // to flush the address from our TLB.
+                  invlpg(addr);
+                } else {
+                  // In this case, the target aspace is not actively running on this CPU, but we
+                  // know that the CPU ran this aspace in the past. Therefore, we have to flush this
+                  // PCID using an invpcid.
+                  invpcid_va_pcid(addr, context->pcid);
+                }
               }
-            }
 
-            // Now, check if there is an associated unified aspace and if it has run on this CPU.
-            if (curr_cpu_bit & context->target_unified_mask) {
-              if (context->target_unified_ptable == current_root_ptable) {
-                // If the unified aspace is currently active on this CPU, then just run an invlpg to
-                // flush the entry.
-                invlpg(item.addr());
-              } else {
-                DEBUG_ASSERT(context->unified_pcid != MMU_X86_UNUSED_PCID);
-                // In this case, a unified aspace exists but is not currently active on this CPU.
-                // However, we know that this CPU has ran the unified aspace in the past, so flush
-                // its PCID using an invpcid.
-                invpcid_va_pcid(item.addr(), context->unified_pcid);
+              // Now, check if there is an associated unified aspace and if it has run on this CPU.
+              if (curr_cpu_bit & context->target_unified_mask) {
+                if (context->target_unified_ptable == current_root_ptable) {
+                  // If the unified aspace is currently active on this CPU, then just run an invlpg
+                  // to flush the entry.
+                  invlpg(addr);
+                } else {
+                  // In this case, a unified aspace exists but is not currently active on this
+                  // CPU. However, we know that this CPU has ran the unified aspace in the past, so
+                  // flush its PCID using an invpcid.
+                  invpcid_va_pcid(addr, context->unified_pcid);
+                }
               }
             }
-          }
-          break;
+            break;
+        }
       }
     }
   };
@@ -605,7 +608,7 @@ bool X86PageTableEpt::supports_page_size(PageTableLevel level) {
     case PageTableLevel::PD_L:
       return vmx_ept_supports_large_pages();
     case PageTableLevel::PDP_L:
-      return false;
+      return vmx_ept_supports_huge_pages();
     case PageTableLevel::PML4_L:
       return false;
     default:
@@ -887,9 +890,12 @@ zx_status_t X86ArchVmAspace::AllocatePCID() {
   DEBUG_ASSERT(g_x86_feature_pcid_enabled);
   zx::result<uint16_t> result = pcid_allocator->TryAlloc();
   if (result.is_error()) {
-    // TODO(https://fxbug.dev/42075323): Implement some kind of PCID recycling.
+    // Rather than failing to create the aspace, run it untagged under the 0 pcid. Loading it always
+    // flushes the 0 pcid, so it behaves as it would without PCIDs and only loses the cheaper
+    // context switches. Untagged aspaces do not need their PCID recycled when they are destroyed.
     LTRACEF("X86: ran out of PCIDs when assigning new aspace\n");
-    return ZX_ERR_NO_RESOURCES;
+    pcid_exhausted.Add(1);
+    return ZX_OK;
   }
   pcid_ = result.value();
   DEBUG_ASSERT(pcid_ != MMU_X86_UNUSED_PCID && pcid_ < 4096);
@@ -909,7 +915,7 @@ X86ArchVmAspace::~X86ArchVmAspace() {
 
 zx_status_t X86ArchVmAspace::Destroy() {
   canary_.Assert();
-  DEBUG_ASSERT(active_cpus_.load() == 0);
+  DEBUG_ASSERT(active_cpus_.load().none());
 
   if (flags_ & ARCH_ASPACE_FLAG_GUEST) {
     static_cast<X86PageTableEpt*>(pt_)->Destroy(base_, size_);
@@ -979,14 +985,14 @@ void X86ArchVmAspace::ContextSwitch(X86ArchVmAspace* old_aspace, X86ArchVmAspace
     LTRACEF_LEVEL(3, "switching to aspace %p, pt %#" PRIXPTR "\n", aspace, phys);
 
     if (old_aspace != nullptr) {
-      [[maybe_unused]] uint32_t prev = old_aspace->active_cpus_.fetch_and(~cpu_bit);
+      [[maybe_unused]] cpu_mask_t prev = old_aspace->active_cpus_.fetch_and(~cpu_bit);
       // Make sure we were actually previously running on this CPU.
       DEBUG_ASSERT(prev & cpu_bit);
     }
     // Set ourselves as active on this CPU prior to clearing the dirty bit. This ensures that TLB
     // invalidation code will either see us as active, and know to IPI us, or we will see the dirty
     // bit and clear the tlb here. See comment in X86PageTableMmu::TlbInvalidate for more details.
-    [[maybe_unused]] uint32_t prev = aspace->active_cpus_.fetch_or(cpu_bit);
+    [[maybe_unused]] cpu_mask_t prev = aspace->active_cpus_.fetch_or(cpu_bit);
     // Should not already be running on this CPU.
     DEBUG_ASSERT(!(prev & cpu_bit));
 
@@ -1012,6 +1018,8 @@ void X86ArchVmAspace::ContextSwitch(X86ArchVmAspace* old_aspace, X86ArchVmAspace
       cr3.set_pcid(aspace->pcid_ & 0xfff);
       cr3.Write();
     } else {
+      // Without a PCID of our own this loads the 0 pcid and flushes it, discarding anything left
+      // behind by whichever untagged aspace last ran on this cpu.
       arch::X86Cr3::Write(phys);
     }
 
@@ -1038,7 +1046,7 @@ void X86ArchVmAspace::ContextSwitch(X86ArchVmAspace* old_aspace, X86ArchVmAspace
     // the noflush bit clear which is fine since the kernel uses global pages.
     arch::X86Cr3::Write(root_page_table_phys);
     if (old_aspace != nullptr) {
-      [[maybe_unused]] uint32_t prev = old_aspace->active_cpus_.fetch_and(~cpu_bit);
+      [[maybe_unused]] cpu_mask_t prev = old_aspace->active_cpus_.fetch_and(~cpu_bit);
       // Make sure we were actually previously running on this CPU
       DEBUG_ASSERT(prev & cpu_bit);
     }
@@ -1071,9 +1079,18 @@ zx_status_t X86ArchVmAspace::HarvestAccessed(vaddr_t vaddr, size_t count,
   return pt_->HarvestAccessed(vaddr, count, non_terminal_action, terminal_action);
 }
 
+zx_status_t X86ArchVmAspace::HarvestDirty(vaddr_t vaddr, size_t count,
+                                          const DirtyRangeFunction& dirty) {
+  DEBUG_ASSERT(!pt_->IsUnified());
+  if (!IsValidVaddr(vaddr)) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  return pt_->HarvestDirty(vaddr, count, dirty);
+}
+
 bool X86ArchVmAspace::AccessedSinceLastCheck(bool clear) {
   // Read whether any CPUs are presently executing.
-  bool currently_active = active_cpus_.load(ktl::memory_order_relaxed) != 0;
+  bool currently_active = active_cpus_.load(ktl::memory_order_relaxed).any();
   // When clearing |accessed_since_last_check_| we cannot just exchange with 'false' since the
   // hardware page table walker can directly update accessed information asynchronously and so new
   // accessed information could become available without any further aspace calls. Therefore if
@@ -87,8 +87,8 @@ static struct mtrrs* target_mtrrs = &THE_MTRRS;
 static void x86_pat_sync_task(void* context);
 struct pat_sync_task_context {
   /* Barrier counters for the two barriers described in Intel's algorithm */
-  ktl::atomic<int> barrier1;
-  ktl::atomic<int> barrier2;
+  AtomicCpuMask barrier1;
+  AtomicCpuMask barrier2;
 };
 
 void x86_mmu_mem_type_init(void) {
@@ -112,7 +112,7 @@ void x86_mmu_mem_type_init(void) {
 
   /* Update the PAT on the bootstrap processor (and sync any changes to the
    * MTRR that may have been made above). */
-  x86_pat_sync(1 << 0);
+  x86_pat_sync(cpu_num_to_mask(0));
 }
 
 /* @brief Give the specified CPUs our Page Attribute Tables and
@@ -129,8 +129,8 @@ void x86_pat_sync(cpu_mask_t targets) {
   targets &= mp_get_online_mask();
 
   struct pat_sync_task_context context = {
-      .barrier1 = (int)targets,
-      .barrier2 = (int)targets,
+      .barrier1{targets},
+      .barrier2{targets},
   };
   /* Step 1: Broadcast to all processors to execute the sequence */
   if (targets == cpu_num_to_mask(arch_curr_cpu_num())) {
@@ -153,8 +153,8 @@ static void x86_pat_sync_task(void* raw_context) {
   cpu_num_t cpu = arch_curr_cpu_num();
 
   /* Step 3: Wait for all processors to reach this point. */
-  context->barrier1.fetch_and(~(1 << cpu));
-  while (context->barrier1.load() != 0) {
+  context->barrier1.fetch_and(~cpu_num_to_mask(cpu));
+  while (context->barrier1.load().any()) {
     arch::Yield();
   }
 
@@ -236,8 +236,8 @@ static void x86_pat_sync_task(void* raw_context) {
   }
 
   /* Step 14: Wait for all processors to reach this point. */
-  context->barrier2.fetch_and(~(1 << cpu));
-  while (context->barrier2.load() != 0) {
+  context->barrier2.fetch_and(~cpu_num_to_mask(cpu));
+  while (context->barrier2.load().any()) {
     arch::Yield();
   }
 }
@@ -211,9 +211,70 @@ static bool x86_test_destroy_unified() {
   END_TEST;
 }
 
+// Returns the terminal 4k page table entry that maps |va|.
+static volatile uint64_t* find_pte(uint64_t* pml4, vaddr_t va) {
+  uint64_t offsets[] = {BITS_SHIFT(va, 47, 39), BITS_SHIFT(va, 38, 30), BITS_SHIFT(va, 29, 21)};
+  uint64_t* current_level = pml4;
+  for (uint64_t index : offsets) {
+    uint64_t next_level_va = X86_PHYS_TO_VIRT(current_level[index] & X86_PG_FRAME);
+    current_level = reinterpret_cast<uint64_t*>(next_level_va);
+  }
+  return &current_level[BITS_SHIFT(va, 20, 12)];
+}
+
+static bool x86_test_harvest_dirty() {
+  BEGIN_TEST;
+
+  constexpr uint64_t kTestAspaceSize = 4ull * 1024 * 1024 * 1024;
+  constexpr uintptr_t kTestVirtualAddress = kTestAspaceSize - 2 * PAGE_SIZE;
+  X86ArchVmAspace aspace(0, kTestAspaceSize, /*mmu_flags=*/0);
+  ASSERT_OK(aspace.Init());
+  uint64_t* const pml4 = reinterpret_cast<uint64_t*>(X86_PHYS_TO_VIRT(aspace.pt_phys()));
+
+  paddr_t pa[2];
+  vm_page_t* vm_page[2];
+  for (size_t i = 0; i < 2; i++) {
+    ASSERT_OK(pmm_alloc_page(/*alloc_flags=*/0, &vm_page[i], &pa[i]));
+  }
+  EXPECT_OK(aspace.Map(kTestVirtualAddress, pa, 2,
+                       ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE | ARCH_MMU_FLAG_PERM_USER,
+                       X86ArchVmAspace::ExistingEntryAction::Error));
+
+  // The aspace is not active, so stand in for the hardware recording a write to the first page.
+  volatile uint64_t* pte = find_pte(pml4, kTestVirtualAddress);
+  *pte = *pte | X86_MMU_PG_A | X86_MMU_PG_D;
+
+  vaddr_t dirty_vaddr = 0;
+  size_t dirty_len = 0;
+  auto record = [&](vaddr_t vaddr, size_t len) {
+    dirty_vaddr = vaddr;
+    dirty_len += len;
+  };
+  EXPECT_OK(aspace.HarvestDirty(kTestVirtualAddress, 2, record));
+  EXPECT_EQ(kTestVirtualAddress, dirty_vaddr);
+  EXPECT_EQ(PAGE_SIZE, dirty_len);
+
+  // The dirty flag is reset, but the accessed flag is kept for the accessed harvester.
+  EXPECT_EQ(0u, *pte & X86_MMU_PG_D);
+  EXPECT_NE(0u, *pte & X86_MMU_PG_A);
+
+  dirty_len = 0;
+  EXPECT_OK(aspace.HarvestDirty(kTestVirtualAddress, 2, record));
+  EXPECT_EQ(0u, dirty_len);
+
+  EXPECT_OK(aspace.Unmap(kTestVirtualAddress, 2, ArchUnmapOptions::Enlarge));
+  for (vm_page_t* page : vm_page) {
+    pmm_free_page(page);
+  }
+  EXPECT_OK(aspace.Destroy());
+
+  END_TEST;
+}
+
 UNITTEST_START_TESTCASE(x86_mmu_tests)
 UNITTEST("user-aspace page table tests", x86_arch_vmaspace_usermmu_tests)
 UNITTEST("l1tf test", x86_test_l1tf_invariant)
 UNITTEST("physmap nx", x86_test_physmap_nx)
 UNITTEST("destroy unified", x86_test_destroy_unified)
+UNITTEST("harvest dirty", x86_test_harvest_dirty)
 UNITTEST_END_TESTCASE(x86_mmu_tests, "x86_mmu", "x86 mmu tests")
@@ -39,6 +39,8 @@
 #include <hwreg/x86msr.h>
 #include <kernel/auto_preempt_disabler.h>
 #include <kernel/cpu.h>
+#include <kernel/percpu.h>
+#include <kernel/scheduler.h>
 #include <kernel/timer.h>
 #include <ktl/algorithm.h>
 #include <ktl/align.h>
@@ -314,8 +316,22 @@ int x86_apic_id_to_cpu_num(uint32_t apic_id) {
   return -1;
 }
 
+uint32_t x86_cpu_num_to_apic_id(cpu_num_t cpu_num) {
+  DEBUG_ASSERT(cpu_num < (cpu_num_t)x86_num_cpus);
+  if (cpu_num == bp_percpu.cpu_num) {
+    return bp_percpu.apic_id;
+  }
+
+  for (uint i = 0; i < (uint)x86_num_cpus - 1; ++i) {
+    if (ap_percpus[i].cpu_num == cpu_num) {
+      return ap_percpus[i].apic_id;
+    }
+  }
+  return bp_percpu.apic_id;
+}
+
 void arch_mp_reschedule(cpu_mask_t mask) {
-  cpu_mask_t needs_ipi = 0;
+  cpu_mask_t needs_ipi{};
   if (use_monitor) {
     while (mask) {
       cpu_num_t cpu_id = lowest_cpu_set(mask);
@@ -384,7 +400,9 @@ void ArchIdlePowerThread::EnterIdleState() {
   // be able to rely on this pointer and mask being valid for the duration of
   // the method.
   struct x86_percpu* percpu = x86_get_percpu();
-  const cpu_mask_t local_reschedule_mask = cpu_num_to_mask(arch_curr_cpu_num());
+  const cpu_num_t current_cpu = arch_curr_cpu_num();
+  const cpu_mask_t local_reschedule_mask = cpu_num_to_mask(current_cpu);
+  const TimerQueue& timer_queue = percpu::Get(current_cpu).timer_queue;
 
   if (use_monitor) {
     bool rsb_maybe_empty = false;
@@ -393,7 +411,9 @@ void ArchIdlePowerThread::EnterIdleState() {
     percpu->monitor->Write(kTargetStateIdle);
 
     while (percpu->monitor->Read() == kTargetStateIdle && !preemption_state.preempts_pending()) {
-      X86IdleState* next_state = percpu->idle_states->PickIdleState();
+      X86IdleState* next_state = percpu->idle_states->PickIdleState(
+          timer_queue.TimeUntilNextWakeup(),
+          Scheduler::PeekIdleLatencyLimit(current_cpu, current_mono_time()));
       rsb_maybe_empty |= x86_intel_idle_state_may_empty_rsb(next_state);
       ktrace::Scope trace = KTRACE_CPU_BEGIN_SCOPE_ENABLE(
           LOCAL_KTRACE_ENABLE, "kernel:sched", "idle", ("mwait hint", next_state->MwaitHint()));
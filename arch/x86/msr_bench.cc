@@ -320,13 +320,13 @@ class BenchmarkState {
 int BenchmarkState::Run() {
   // Figure out how many CPUs we have currently online.
   cpu_mask_t online_cpus = mp_get_online_mask();
-  size_t online_count = ktl::popcount(online_cpus);
+  size_t online_count = online_cpus.count();
 
   // Allocate enough context storage for the online CPUs.
   fbl::AllocChecker ac;
   cpu_contexts_.reset(new (&ac) CpuContext[online_count], online_count);
   if (!ac.check()) {
-    printf("Failed to allocate %zu CpuContexts (mask 0x%08x)\n", online_count, online_cpus);
+    printf("Failed to allocate %zu CpuContexts (mask %#lx)\n", online_count, online_cpus.word(0));
     return -1;
   }
 
@@ -335,7 +335,8 @@ int BenchmarkState::Run() {
   bool is_primary = true;
   size_t ndx = 0;
   while (online_cpus) {
-    if (online_cpus & 0x1) {
+    if (online_cpus.test(cpu_id)) {
+      online_cpus.reset(cpu_id);
       zx_status_t status = cpu_contexts_[ndx].Init(
           this, cpu_id, is_primary,
           [](void* _ctx) -> int {
@@ -353,7 +354,6 @@ int BenchmarkState::Run() {
 
     ++cpu_id;
     is_primary = false;
-    online_cpus >>= 1;
   }
 
   // Cycle all of test threads through all of the stages.
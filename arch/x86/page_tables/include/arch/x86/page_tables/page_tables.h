@@ -10,6 +10,7 @@
 #include <align.h>
 #include <lib/arch/x86/boot-cpuid.h>
 #include <lib/fit/defer.h>
+#include <lib/fit/function.h>
 #include <lib/zx/result.h>
 
 #include <arch/x86/page_tables/constants.h>
@@ -95,18 +96,31 @@ struct PendingTlbInvalidation {
     DEF_SUBFIELD(raw, 2, 0, page_level);
     DEF_SUBBIT(raw, 3, is_global);
     DEF_SUBBIT(raw, 4, is_terminal);
+    // Number of pages, after the first, of size |page_level| that directly follow |addr| and share
+    // its attributes.
+    DEF_SUBFIELD(raw, 11, 5, extra_pages);
     DEF_SUBFIELD(raw, 63, 12, encoded_addr);
 
     vaddr_t addr() const { return encoded_addr() << PAGE_SIZE_SHIFT; }
+    uint pages() const { return static_cast<uint>(extra_pages()) + 1; }
+    size_t page_size() const { return 1ul << (PAGE_SIZE_SHIFT + 9 * page_level()); }
   };
   static_assert(sizeof(Item) == 8, "");
 
+  // Maximum number of pages, across all items, that will be invalidated individually before
+  // falling back to a full shootdown.
+  static constexpr uint kMaxPages = 64;
+  // Largest run of pages a single item can describe.
+  static constexpr uint kMaxItemPages = 128;
+
   // If true, ignore |vaddr| and perform a full invalidation for this context.
   bool full_shootdown = false;
   // If true, at least one enqueued entry was for a global page.
   bool contains_global = false;
   // Number of valid elements in |item|
   uint count = 0;
+  // Total number of pages described by the valid elements in |item|
+  uint pages = 0;
   // List of addresses queued for invalidation.
   // Explicitly uninitialized since the size is fairly large.
   Item item[32];
@@ -122,20 +136,41 @@ struct PendingTlbInvalidation {
 
     // We mark PML4_L entries as full shootdowns, since it's going to be
     // expensive one way or another.
-    if (count >= ktl::size(item) || level == PageTableLevel::PML4_L) {
+    if (full_shootdown || pages >= kMaxPages || level == PageTableLevel::PML4_L) {
       full_shootdown = true;
       return;
     }
+
+    // Unmap and protect walk the range in order, so runs of neighbouring pages are common. Fold
+    // them into the previous item so that they do not use up the queue.
+    if (count > 0) {
+      Item& last = item[count - 1];
+      if (last.page_level() == static_cast<uint64_t>(level) && last.is_global() == is_global_page &&
+          last.is_terminal() == is_terminal && last.pages() < kMaxItemPages &&
+          last.addr() + last.pages() * last.page_size() == v) {
+        last.set_extra_pages(last.extra_pages() + 1);
+        pages++;
+        return;
+      }
+    }
+
+    if (count >= ktl::size(item)) {
+      full_shootdown = true;
+      return;
+    }
+    item[count].raw = 0;
     item[count].set_page_level(static_cast<uint64_t>(level));
     item[count].set_is_global(is_global_page);
     item[count].set_is_terminal(is_terminal);
     item[count].set_encoded_addr(v >> PAGE_SIZE_SHIFT);
     count++;
+    pages++;
   }
 
   // Clear the list of pending invalidations
   void clear() {
     count = 0;
+    pages = 0;
     full_shootdown = false;
     contains_global = false;
   }
@@ -193,6 +228,15 @@ class X86PageTableBase {
                                       NonTerminalAction non_terminal_action,
                                       TerminalAction terminal_action) = 0;
 
+  // Calls |dirty| for each range of terminal mappings in the given range that has its dirty flag
+  // set, and removes the flag. A large page is reported and reset as a whole if the range covers
+  // it, and otherwise the covered part is reported without resetting the flag, so a range is never
+  // missed but may be reported again. The TLB is invalidated before returning, so any write after
+  // this returns will set the dirty flag again.
+  using DirtyRangeFunction = fit::inline_function<void(vaddr_t vaddr, size_t len)>;
+  virtual zx_status_t HarvestDirty(vaddr_t vaddr, size_t count,
+                                   const DirtyRangeFunction& dirty) = 0;
+
   // Returns 1 for unified page tables and 0 for all other page tables. This establishes an
   // ordering that is used when the lock_ is acquired. The restricted page table lock is acquired
   // first, and the unified page table lock is acquired afterwards.
@@ -546,6 +590,28 @@ class X86PageTableImpl : public X86PageTableBase {
     return ZX_OK;
   }
 
+  zx_status_t HarvestDirty(vaddr_t vaddr, size_t count,
+                           const DirtyRangeFunction& dirty) override final {
+    canary_.Assert();
+
+    if (!static_cast<T*>(this)->check_vaddr(vaddr)) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+    if (count == 0) {
+      return ZX_OK;
+    }
+
+    VirtualAddressCursor cursor(/*vaddr=*/vaddr, /*size=*/count * PAGE_SIZE);
+    __UNINITIALIZED ConsistencyManager cm(this);
+    {
+      Guard<Mutex> a{AssertOrderedLock, &lock_, LockOrder()};
+      HarvestDirtyMapping(virt_, static_cast<T*>(this)->top_level(), cursor, dirty, &cm);
+      cm.Finish();
+    }
+    DEBUG_ASSERT(cursor.size() == 0);
+    return ZX_OK;
+  }
+
   static uint CountPresentEntries(const volatile pt_entry_t* page_table) {
     uint count = 0;
     for (uint i = 0; i < NO_OF_PT_ENTRIES; i++) {
@@ -1350,10 +1416,20 @@ class X86PageTableImpl : public X86PageTableBase {
         // If the request covers the entire large page then harvest the accessed bit, otherwise we
         // just skip it.
         if (vaddr_level_aligned && cursor.size() >= ps) {
+          const paddr_t paddr = paddr_from_pte(level, pt_val);
+          // Large pages of paged VMOs are backed by a run of pages that all share the one accessed
+          // bit, and so all need their age updated.
+          if (pt_val & X86_MMU_PG_A) {
+            for (size_t offset = 0; offset < ps; offset += PAGE_SIZE) {
+              if (vm_page_t* page = paddr_to_vm_page(paddr + offset); page) {
+                Pmm::Node().GetPageQueues()->MarkAccessed(page);
+              }
+            }
+          }
           const uint mmu_flags = static_cast<T*>(this)->pt_flags_to_mmu_flags(pt_val, level);
           const PtFlags term_flags = static_cast<T*>(this)->terminal_flags(level, mmu_flags);
-          UpdateEntry(cm, level, cursor.vaddr(), e, paddr_from_pte(level, pt_val),
-                      term_flags | X86_MMU_PG_PS, /*was_terminal=*/true, /*exact_flags=*/true);
+          UpdateEntry(cm, level, cursor.vaddr(), e, paddr, term_flags | X86_MMU_PG_PS,
+                      /*was_terminal=*/true, /*exact_flags=*/true);
         }
         cursor.Consume(ps);
         continue;
@@ -1481,6 +1557,55 @@ class X86PageTableImpl : public X86PageTableBase {
     DEBUG_ASSERT(cursor.size() == 0 || page_aligned(PageTableLevel::PT_L, cursor.vaddr()));
   }
 
+  // Recursive helper for HarvestDirty. Level must be top_level() when invoked.
+  void HarvestDirtyMapping(volatile pt_entry_t* table, PageTableLevel level,
+                           VirtualAddressCursor& cursor, const DirtyRangeFunction& dirty,
+                           ConsistencyManager* cm) TA_REQ(lock_) {
+    DEBUG_ASSERT(table);
+    const size_t ps = page_size(level);
+    const PtFlags dirty_flag = static_cast<T*>(this)->dirty_flag();
+    uint index = vaddr_to_index(level, cursor.vaddr());
+    for (; index != NO_OF_PT_ENTRIES && cursor.size() != 0; ++index) {
+      volatile pt_entry_t* e = table + index;
+      const pt_entry_t pt_val = *e;
+      if (!IS_PAGE_PRESENT(pt_val)) {
+        cursor.SkipEntry(ps);
+        continue;
+      }
+      if (level != PageTableLevel::PT_L && !IS_LARGE_PAGE(pt_val)) {
+        HarvestDirtyMapping(get_next_table_from_entry(pt_val), lower_level(level), cursor, dirty,
+                            cm);
+        DEBUG_ASSERT(cursor.size() == 0 || page_aligned(level, cursor.vaddr()));
+        continue;
+      }
+      if (!(pt_val & dirty_flag)) {
+        cursor.SkipEntry(ps);
+        continue;
+      }
+      const vaddr_t vaddr = cursor.vaddr();
+      if (!page_aligned(level, vaddr) || cursor.size() < ps) {
+        // Only part of a large page is covered, so leave its flag for a later harvest of the rest.
+        cursor.SkipEntry(ps);
+        dirty(vaddr, cursor.vaddr() - vaddr);
+        continue;
+      }
+      // The hardware sets the accessed and dirty flags only when they are clear, and sets both on a
+      // write, so neither can change underneath this update. Writes through a stale TLB entry
+      // before the invalidation land in a range that is being reported now.
+      const uint mmu_flags = static_cast<T*>(this)->pt_flags_to_mmu_flags(pt_val, level);
+      PtFlags term_flags = static_cast<T*>(this)->terminal_flags(level, mmu_flags);
+      if (level != PageTableLevel::PT_L) {
+        term_flags |= X86_MMU_PG_PS;
+      }
+      // Keep the accessed flag for HarvestAccessed.
+      term_flags |= pt_val & (static_cast<T*>(this)->accessed_dirty_flags() & ~dirty_flag);
+      UpdateEntry(cm, level, vaddr, e, paddr_from_pte(level, pt_val), term_flags,
+                  /*was_terminal=*/true, /*exact_flags=*/true);
+      dirty(vaddr, ps);
+      cursor.Consume(ps);
+    }
+  }
+
   /**
    * @brief  Walk the page table structures returning the entry and level that maps the address.
    *
@@ -1581,7 +1706,7 @@ class X86PageTableImpl : public X86PageTableBase {
 
     // Check if we are actually changing anything, ignoring the accessed and dirty bits unless
     // exact_flags has been requested to allow for those bits to be explicitly unset.
-    if ((olde & ~(exact_flags ? 0 : (X86_MMU_PG_A | X86_MMU_PG_D))) == newe) {
+    if ((olde & ~(exact_flags ? 0 : static_cast<T*>(this)->accessed_dirty_flags())) == newe) {
       return;
     }
 
@@ -45,6 +45,7 @@
 #include <arch/regs.h>
 #include <arch/x86.h>
 #include <arch/x86/apic.h>
+#include <arch/x86/descriptor.h>
 #include <arch/x86/feature.h>
 #include <arch/x86/mmu.h>
 #include <fbl/algorithm.h>
@@ -1482,7 +1483,7 @@ zx_status_t arch_perfmon_start() {
 
   // Make sure all relevant sysregs have been wiped clean.
   if (!perfmon_hw_initialized) {
-    mp_sync_exec(mp_ipi_target::ALL, 0, x86_perfmon_reset_task, nullptr);
+    mp_sync_exec(mp_ipi_target::ALL, {}, x86_perfmon_reset_task, nullptr);
     perfmon_hw_initialized = true;
   }
 
@@ -1512,7 +1513,7 @@ zx_status_t arch_perfmon_start() {
     }
   }
 
-  mp_sync_exec(mp_ipi_target::ALL, 0, x86_perfmon_start_cpu_task, state);
+  mp_sync_exec(mp_ipi_target::ALL, {}, x86_perfmon_start_cpu_task, state);
   perfmon_active.store(true);
 
   return ZX_OK;
@@ -1655,7 +1656,7 @@ static void arch_perfmon_stop_locked() TA_REQ(PerfmonLock::Get()) {
   // multiple stops and still read register values.
 
   auto state = perfmon_state.get();
-  mp_sync_exec(mp_ipi_target::ALL, 0, x86_perfmon_stop_cpu_task, state);
+  mp_sync_exec(mp_ipi_target::ALL, {}, x86_perfmon_stop_cpu_task, state);
 
   // x86_perfmon_start currently maps the buffers in, so we unmap them here.
   // Make sure to do this after we've turned everything off so that we
@@ -1708,7 +1709,7 @@ void arch_perfmon_fini() {
     DEBUG_ASSERT(!perfmon_active.load());
   }
 
-  mp_sync_exec(mp_ipi_target::ALL, 0, x86_perfmon_reset_task, nullptr);
+  mp_sync_exec(mp_ipi_target::ALL, {}, x86_perfmon_reset_task, nullptr);
 
   perfmon_state.reset();
 }
@@ -1749,6 +1750,19 @@ static perfmon::RecordHeader* x86_perfmon_write_last_branches(PerfmonState* stat
   return next;
 }
 
+// Write a PC record for |id|, and when "kernel:arch" tracing is enabled also
+// emit the sample as a ktrace event. The perfmon record only carries the
+// address space (cr3), whereas the ktrace event is attributed to the thread
+// that was interrupted, so samples can be lined up with a scheduler trace
+// recorded alongside. Samples are kept out of "kernel:sched" so that
+// scheduler traces do not pay for them unless asked.
+static perfmon::RecordHeader* write_pc_sample(perfmon::RecordHeader* next, PmuEventId id,
+                                              uint64_t cr3, const iframe_t* frame) {
+  KTRACE_INSTANT("kernel:arch", "pmu_sample", ("event", static_cast<uint32_t>(id)),
+                 ("pc", frame->ip), ("cpl", SELECTOR_PL(frame->cs)));
+  return arch_perfmon_write_pc_record(next, id, cr3, frame->ip);
+}
+
 // Helper function so that there is only one place where we enable/disable
 // interrupts (our caller).
 // Returns true if success, false if buffer is full.
@@ -1812,7 +1826,7 @@ static bool pmi_interrupt_handler(iframe_t* frame, PerfmonState* state) {
         continue;
       }
       if (state->programmable_flags[i] & perfmon::kPmuConfigFlagPc) {
-        next = arch_perfmon_write_pc_record(next, id, cr3, frame->ip);
+        next = write_pc_sample(next, id, cr3, frame);
       } else {
         next = arch_perfmon_write_tick_record(next, id);
       }
@@ -1839,7 +1853,7 @@ static bool pmi_interrupt_handler(iframe_t* frame, PerfmonState* state) {
         continue;
       }
       if (state->fixed_flags[i] & perfmon::kPmuConfigFlagPc) {
-        next = arch_perfmon_write_pc_record(next, id, cr3, frame->ip);
+        next = write_pc_sample(next, id, cr3, frame);
       } else {
         next = arch_perfmon_write_tick_record(next, id);
       }
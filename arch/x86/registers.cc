@@ -17,10 +17,17 @@
  * 4) FXSAVE (can only save FPU/SSE registers)
  * 5) none (will not save any extended registers, will not allow enabling
  *          features that use extended registers.)
+ *
+ * On a context switch, only user threads have their state saved and loaded;
+ * the kernel is built without floating point or vector instructions, so kernel
+ * threads leave the live state alone. A user thread's state is not loaded
+ * again if it is still live, i.e. no other user thread has run on the CPU
+ * since it last did and its saved state has not been modified.
  ****************************************************************************/
 #include "arch/x86/registers.h"
 
 #include <inttypes.h>
+#include <lib/counters.h>
 #include <lib/fit/defer.h>
 #include <string.h>
 #include <trace.h>
@@ -53,6 +60,9 @@
 // Bit in XCOMP_BV field of xsave indicating compacted format.
 #define XSAVE_XCOMP_BV_COMPACT (1ULL << 63)
 
+// Number of context switches to a user thread whose extended register state was still live.
+KCOUNTER(xstate_restore_skipped, "thread.xstate_restore_skipped")
+
 static void fxsave(void* register_state);
 static void fxrstor(const void* register_state);
 static void xrstor(const void* register_state, uint64_t feature_mask);
@@ -225,6 +235,9 @@ void x86_extended_register_init(void) {
   if (!initialized_cpu_already) {
     x86_extended_register_cpu_init();
   }
+
+  // Whatever was in this CPU's registers belongs to no one.
+  x86_get_percpu()->extended_register_owner = nullptr;
 }
 
 bool x86_extended_register_enable_feature(enum x86_extended_register_feature feature) {
@@ -377,11 +390,37 @@ void x86_extended_register_restore_state(const void* register_state) {
   }
 }
 
-void x86_extended_register_context_switch(Thread* old_thread, const Thread* new_thread) {
-  if (likely(old_thread)) {
+// Only user threads have extended register state of their own.
+static bool x86_thread_has_extended_register_state(const Thread* thread) {
+  return thread->user_thread() != nullptr;
+}
+
+void x86_extended_register_context_switch(Thread* old_thread, Thread* new_thread) {
+  if (likely(old_thread) && x86_thread_has_extended_register_state(old_thread)) {
     x86_extended_register_save_state(old_thread->arch().extended_register_buffer);
   }
-  x86_extended_register_restore_state(new_thread->arch().extended_register_buffer);
+  x86_extended_register_switch_to(new_thread);
+}
+
+void x86_extended_register_switch_to(Thread* thread) {
+  DEBUG_ASSERT(arch_ints_disabled());
+  if (!x86_thread_has_extended_register_state(thread)) {
+    return;
+  }
+
+  x86_percpu* const percpu = x86_get_percpu();
+  arch_thread& arch = thread->arch();
+  if (percpu->extended_register_owner == thread && arch.extended_register_cpu == percpu->cpu_num) {
+    kcounter_add(xstate_restore_skipped, 1);
+    return;
+  }
+  x86_extended_register_restore_state(arch.extended_register_buffer);
+  percpu->extended_register_owner = thread;
+  arch.extended_register_cpu = percpu->cpu_num;
+}
+
+void x86_extended_register_invalidate(Thread* thread) {
+  thread->arch().extended_register_cpu = INVALID_CPU;
 }
 
 static void read_xsave_state_info(void) {
@@ -86,22 +86,40 @@ void get_fsgsbase(uint64_t* fsbase, uint64_t* gsbase) {
   }
 }
 
-void set_fsgsbase(uint64_t fsbase, uint64_t gsbase) {
+// load the user fs/gs base, skipping whichever of them already holds the value it
+// is being set to according to |arch_state|. normal and restricted mode rarely
+// both use the gs base, and skipping it saves a swapgs pair or a wrmsr.
+void update_fsgsbase(const ArchSavedNormalState& arch_state, uint64_t fsbase, uint64_t gsbase) {
   DEBUG_ASSERT(arch_ints_disabled());
 
   DEBUG_ASSERT(x86_is_vaddr_canonical(fsbase));
   DEBUG_ASSERT(x86_is_vaddr_canonical(gsbase));
-  if (likely(x86_feature_test(X86_FEATURE_FSGSBASE))) {
-    _writefsbase_u64(fsbase);
-    // the user and kernel base have been swapped, use swapgs to temporarily
-    // gain access to the gs register.
-    __asm__ __volatile__("swapgs\n");
-    _writegsbase_u64(gsbase);
-    __asm__ __volatile__("swapgs\n");
-  } else {
-    write_msr(X86_MSR_IA32_FS_BASE, fsbase);
-    write_msr(X86_MSR_IA32_KERNEL_GS_BASE, gsbase);
+  const bool fsgsbase = x86_feature_test(X86_FEATURE_FSGSBASE);
+  if (fsbase != arch_state.live_fs_base_) {
+    if (likely(fsgsbase)) {
+      _writefsbase_u64(fsbase);
+    } else {
+      write_msr(X86_MSR_IA32_FS_BASE, fsbase);
+    }
   }
+  if (gsbase != arch_state.live_gs_base_) {
+    if (likely(fsgsbase)) {
+      // the user and kernel base have been swapped, use swapgs to temporarily
+      // gain access to the gs register.
+      __asm__ __volatile__("swapgs\n");
+      _writegsbase_u64(gsbase);
+      __asm__ __volatile__("swapgs\n");
+    } else {
+      write_msr(X86_MSR_IA32_KERNEL_GS_BASE, gsbase);
+    }
+  }
+}
+
+// the saved state of the current thread, which is switching modes.
+ArchSavedNormalState& current_arch_state() {
+  RestrictedState* rs = Thread::Current::restricted_state();
+  DEBUG_ASSERT(rs != nullptr);
+  return rs->arch_normal_state();
 }
 
 }  // namespace
@@ -109,13 +127,16 @@ void set_fsgsbase(uint64_t fsbase, uint64_t gsbase) {
 void RestrictedState::ArchSaveStatePreRestrictedEntry(ArchSavedNormalState& arch_state) {
   // save the normal mode fs/gs base which we'll reload on the way back
   get_fsgsbase(&arch_state.normal_fs_base_, &arch_state.normal_gs_base_);
+  arch_state.live_fs_base_ = arch_state.normal_fs_base_;
+  arch_state.live_gs_base_ = arch_state.normal_gs_base_;
 }
 
 [[noreturn]] void RestrictedState::ArchEnterRestricted(const zx_restricted_state_t& state) {
   DEBUG_ASSERT(arch_ints_disabled());
 
-  // load the user fs/gs base from restricted mode
-  set_fsgsbase(state.fs_base, state.gs_base);
+  // load the user fs/gs base from restricted mode. the normal mode bases were
+  // just saved, so only the ones restricted mode uses differently are written.
+  update_fsgsbase(current_arch_state(), state.fs_base, state.gs_base);
 
   // copy to a kernel iframe_t
   // struct iframe_t {
@@ -230,7 +251,10 @@ void RestrictedState::ArchSaveRestrictedSyscallState(zx_restricted_state_t& stat
   state.flags = regs.rflags & X86_FLAGS_USER;
 
   // read the fs/gs base out of the MSRs
-  get_fsgsbase(&state.fs_base, &state.gs_base);
+  ArchSavedNormalState& arch_state = current_arch_state();
+  get_fsgsbase(&arch_state.live_fs_base_, &arch_state.live_gs_base_);
+  state.fs_base = arch_state.live_fs_base_;
+  state.gs_base = arch_state.live_gs_base_;
 }
 
 void RestrictedState::ArchSaveRestrictedIframeState(zx_restricted_state_t& state,
@@ -261,7 +285,10 @@ void RestrictedState::ArchSaveRestrictedIframeState(zx_restricted_state_t& state
   // vector, err_code, cs, and user_ss are unused.
 
   // read the fs/gs base out of the MSRs
-  get_fsgsbase(&state.fs_base, &state.gs_base);
+  ArchSavedNormalState& arch_state = current_arch_state();
+  get_fsgsbase(&arch_state.live_fs_base_, &arch_state.live_gs_base_);
+  state.fs_base = arch_state.live_fs_base_;
+  state.gs_base = arch_state.live_gs_base_;
 }
 
 [[noreturn]] void RestrictedState::ArchEnterFull(const ArchSavedNormalState& arch_state,
@@ -269,8 +296,10 @@ void RestrictedState::ArchSaveRestrictedIframeState(zx_restricted_state_t& state
                                                  uint64_t code) {
   DEBUG_ASSERT(arch_ints_disabled());
 
-  // load the user fs/gs base from normal mode
-  set_fsgsbase(arch_state.normal_fs_base_, arch_state.normal_gs_base_);
+  // load the user fs/gs base from normal mode. the live bases were recorded on
+  // the way here, either when saving the restricted state or, for a kick before
+  // entering restricted mode, when saving the normal state.
+  update_fsgsbase(arch_state, arch_state.normal_fs_base_, arch_state.normal_gs_base_);
 
   // set up a mostly blank iframe and return back to normal mode
   iframe_t iframe{};
@@ -52,7 +52,7 @@ static void free_thread(Thread* t) {
 }
 
 zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
-  ktl::atomic<unsigned int> aps_still_booting = {0};
+  AtomicCpuMask aps_still_booting;
   zx_status_t status = ZX_ERR_INTERNAL;
 
   // if being asked to bring up 0 cpus, move on
@@ -70,7 +70,7 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
     if (mp_is_cpu_online(cpu)) {
       return ZX_ERR_BAD_STATE;
     }
-    aps_still_booting.fetch_or(1U << cpu);
+    aps_still_booting.fetch_or(cpu_num_to_mask(cpu));
   }
 
   struct x86_ap_bootstrap_data* bootstrap_data = nullptr;
@@ -123,6 +123,9 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
 
   // Actually send the startups
   DEBUG_ASSERT(bootstrap_instr_ptr < 1 * MB && IS_PAGE_ROUNDED(bootstrap_instr_ptr));
+  for (unsigned int i = 0; i < count; ++i) {
+    mp_record_boot_stage(x86_apic_id_to_cpu_num(apic_ids[i]), mp_boot_stage::START);
+  }
   uint8_t vec;
   vec = static_cast<uint8_t>(bootstrap_instr_ptr >> PAGE_SIZE_SHIFT);
   // Try up to two times per CPU, as Intel 3A recommends.
@@ -135,7 +138,7 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
       apic_send_ipi(vec, apic_id, DELIVERY_MODE_STARTUP);
     }
 
-    if (aps_still_booting.load() == 0) {
+    if (aps_still_booting.load().none()) {
       break;
     }
     // Wait 1ms for cores to boot.  The docs recommend 200us between STARTUP
@@ -145,18 +148,16 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
 
   // The docs recommend waiting 200us for cores to boot.  We do a bit more
   // work before the cores report in, so wait longer (up to 1 second).
-  for (int tries_left = 200; aps_still_booting.load() != 0 && tries_left > 0; --tries_left) {
+  for (int tries_left = 200; aps_still_booting.load().any() && tries_left > 0; --tries_left) {
     Thread::Current::SleepRelative(ZX_MSEC(5));
   }
 
-  uint failed_aps;
-  failed_aps = aps_still_booting.exchange(0);
-  if (failed_aps != 0) {
-    printf("Failed to boot CPUs: mask %x\n", failed_aps);
+  cpu_mask_t failed_aps = aps_still_booting.exchange({});
+  if (failed_aps.any()) {
+    printf("Failed to boot CPUs: mask %#lx\n", failed_aps.word(0));
     for (uint i = 0; i < count; ++i) {
       int cpu = x86_apic_id_to_cpu_num(apic_ids[i]);
-      uint mask = 1U << cpu;
-      if ((failed_aps & mask) == 0) {
+      if (!failed_aps.test(cpu)) {
         continue;
       }
 
@@ -174,9 +175,9 @@ zx_status_t x86_bringup_aps(uint32_t* apic_ids, uint32_t count) {
       free_thread(bootstrap_data->per_cpu[i].thread);
       bootstrap_data->per_cpu[i].thread = nullptr;
 
-      failed_aps &= ~mask;
+      failed_aps.reset(cpu);
     }
-    DEBUG_ASSERT(failed_aps == 0);
+    DEBUG_ASSERT(failed_aps.none());
 
     status = ZX_ERR_TIMED_OUT;
 
@@ -17,6 +17,7 @@
 #include <string.h>
 #include <sys/types.h>
 
+#include <arch/interrupt.h>
 #include <arch/thread.h>
 #include <arch/x86.h>
 #include <arch/x86/descriptor.h>
@@ -55,6 +56,7 @@ void arch_thread_initialize(Thread* t, vaddr_t entry_point) {
   // initialize the saved extended register state
   arch_thread& arch = t->arch();
   x86_extended_register_init_state(arch.extended_register_buffer);
+  arch.extended_register_cpu = INVALID_CPU;
   DEBUG_ASSERT(
       IS_ROUNDED(&arch.extended_register_buffer, alignof(decltype(arch.extended_register_buffer))));
 
@@ -270,7 +272,7 @@ void arch_context_switch(Thread* oldthread, Thread* newthread)
     // Nothing left to save for |oldthread|, so just restore |newthread|.  Technically, we could
     // skip restoring here since we know a higher layer will restore before leaving the kernel.  We
     // restore anyway to so we don't leave |oldthread|'s state lingering in the hardware registers.
-    x86_extended_register_restore_state(newthread->arch().extended_register_buffer);
+    x86_extended_register_switch_to(newthread);
     x86_debug_restore_state(newthread);
     x86_segment_selector_restore_state(newthread);
   }
@@ -303,7 +305,10 @@ void arch_save_user_state(Thread* thread) {
 void arch_restore_user_state(Thread* thread) {
   x86_segment_selector_restore_state(thread);
   x86_debug_restore_state(thread);
-  x86_extended_register_restore_state(thread->arch().extended_register_buffer);
+  // The saved state may have been modified while it was saved, e.g. by a debugger, in which case
+  // it has been invalidated and is loaded again here.
+  InterruptDisableGuard irqd;
+  x86_extended_register_switch_to(thread);
 }
 
 void arch_set_suspended_general_regs(struct Thread* thread, GeneralRegsSource source, void* gregs) {
@@ -26,7 +26,8 @@ extern "C" X64CopyToFromUserRet FUNCTION_NAME(void* dst, const void* src, size_t
 namespace {
 
 TEST(X86UserCopyTests, FUNCTION_NAME) {
-  for (size_t i = 1; i < 40; ++i) {
+  // Go past the lengths at which any of the variants switch copy strategy.
+  for (size_t i = 1; i < 300; ++i) {
     auto dst = std::make_unique<uint8_t[]>(i);
     std::unique_ptr<uint8_t[]> src(new uint8_t[i]);
     for (size_t j = 0; j < i; ++j) {
@@ -19,14 +19,21 @@ inline std::string_view SelectX86UserCopyAlternative(CpuidIoProvider&& cpuid) {
   const auto edx = cpuid.template Read<arch::CpuidExtendedFeatureFlagsD>();
   const bool is_zen = arch::GetMicroarchitecture(cpuid) == arch::Microarchitecture::kAmdFamilyZen;
 
-  // Whether the "Enhanced" or "Fast Short" `rep mov` optimizations are present
-  // - or whether this is an AMD Zen (for which previous measurements indicated
-  // that moving byte by byte was on the whole faster.)
-  if (ebx.erms() || edx.fsrm() || is_zen) {
+  // Whether the "Fast Short" `rep mov` optimization is present - or whether
+  // this is an AMD Zen (for which previous measurements indicated that moving
+  // byte by byte was on the whole faster.)
+  if (edx.fsrm() || is_zen) {
     if (ebx.smap()) {
       return "_x86_copy_to_or_from_user_movsb_smap";
     }
     return "_x86_copy_to_or_from_user_movsb";
+  } else if (ebx.erms()) {
+    // "Enhanced" `rep movsb` alone only pays off once the copy is long enough
+    // to amortize its startup cost.
+    if (ebx.smap()) {
+      return "_x86_copy_to_or_from_user_erms_smap";
+    }
+    return "_x86_copy_to_or_from_user_erms";
   } else {
     if (ebx.smap()) {
       return "_x86_copy_to_or_from_user_movsq_smap";
@@ -25,13 +25,13 @@ TEST(X86UserCopyTests, Selection) {
   // Intel Core i3-3240: ERMS, no SMAP.
   {
     arch::testing::FakeCpuidIo cpuid(X86Microprocessor::kIntelCoreI3_3240);
-    EXPECT_EQ("_x86_copy_to_or_from_user_movsb"sv, SelectX86UserCopyAlternative(cpuid));
+    EXPECT_EQ("_x86_copy_to_or_from_user_erms"sv, SelectX86UserCopyAlternative(cpuid));
   }
 
   // Intel Core i3-6100: ERMS, SMAP.
   {
     arch::testing::FakeCpuidIo cpuid(X86Microprocessor::kIntelCoreI3_6100);
-    EXPECT_EQ("_x86_copy_to_or_from_user_movsb_smap"sv, SelectX86UserCopyAlternative(cpuid));
+    EXPECT_EQ("_x86_copy_to_or_from_user_erms_smap"sv, SelectX86UserCopyAlternative(cpuid));
   }
 
   // AMD A10-7870K: Pre-Zen, no SMAP.
@@ -262,7 +262,7 @@ zx_status_t gic_get_interrupt_config(interrupt_vector_t vector, interrupt_trigge
 }
 
 zx_status_t gic_set_affinity(interrupt_vector_t vector, cpu_mask_t mask) {
-  LTRACEF("vector %u, mask %#x\n", vector, mask);
+  LTRACEF("vector %u, mask %#lx\n", vector, mask.word(0));
 
   if (vector >= max_irqs) {
     return ZX_ERR_INVALID_ARGS;
@@ -280,7 +280,7 @@ zx_status_t gic_set_affinity(interrupt_vector_t vector, cpu_mask_t mask) {
   uint32_t targetsr = arm_gicv2_read32(GICD_ITARGETSR(vector / 4));
   uint32_t old_targetsr = targetsr;
   targetsr &= ~(0xff << ((vector % 4) * 8));
-  targetsr |= mask << ((vector % 4) * 8);
+  targetsr |= static_cast<uint32_t>(mask.word(0)) << ((vector % 4) * 8);
   arm_gicv2_write32(GICD_ITARGETSR(vector / 4), targetsr);
 
   guard.Release();
@@ -323,9 +323,9 @@ zx_status_t gic_send_ipi(cpu_mask_t logical_target, mp_ipi ipi) {
 
   uint gic_ipi_num = static_cast<uint32_t>(ipi) + ipi_base;
 
-  if (target != 0) {
-    LTRACEF("target 0x%x, gic_ipi %u\n", target, gic_ipi_num);
-    arm_gic_sgi(gic_ipi_num, ARM_GIC_SGI_FLAG_NS, target);
+  if (target) {
+    LTRACEF("target %#lx, gic_ipi %u\n", target.word(0), gic_ipi_num);
+    arm_gic_sgi(gic_ipi_num, ARM_GIC_SGI_FLAG_NS, static_cast<unsigned int>(target.word(0)));
   }
 
   return ZX_OK;
@@ -366,16 +366,17 @@ void gic_init_percpu() {
 
   // Lookup the gic_mask for this processor via GIC registers and compare it
   // to what we were told by the bootloader, warn if there is a mismatch.
-  const cpu_mask_t gic_mask = gic_determine_local_mask(read_gicd_targetsr);
+  const cpu_mask_t gic_mask = CpuMask::FromWord(gic_determine_local_mask(read_gicd_targetsr));
   const cpu_mask_t assigned_gic_mask = mask_translator.GetGicMask(logical_num);
   if (gic_mask != assigned_gic_mask) {
     printf(
         "arm_gicv2: WARNING assigned gic_id of %u does not match processor's gic_id of %u."
         "Successful operation is unlikely!",
-        assigned_gic_mask, gic_mask);
+        lowest_cpu_set(assigned_gic_mask), lowest_cpu_set(gic_mask));
   }
-  TRACEF("logical_cpu_mask: %u programmatic_gic_mask: %u assigned_gic_mask: %u\n",
-         cpu_num_to_mask(arch_curr_cpu_num()), gic_mask, assigned_gic_mask);
+  TRACEF("logical_cpu_mask: %#lx programmatic_gic_mask: %#lx assigned_gic_mask: %#lx\n",
+         cpu_num_to_mask(arch_curr_cpu_num()).word(0), gic_mask.word(0),
+         assigned_gic_mask.word(0));
 }
 
 void gic_shutdown() {
@@ -24,9 +24,9 @@ class CpuMaskTranslator {
       return GetGicMask(lowest_cpu_set(logical));
     }
 
-    cpu_mask_t out = 0;
-    for (int i = 0; i < 8; i++) {
-      if ((logical >> i) & 1) {
+    cpu_mask_t out{};
+    for (cpu_num_t i = 0; i < kMapSize; i++) {
+      if (logical.test(i)) {
         out |= GetGicMask(i);
       }
     }
@@ -44,11 +44,7 @@ class CpuMaskTranslator {
   }
 
  private:
-  bool OnlyOneCpu(const cpu_mask_t mask) {
-    // In the general case mask & mask-1 would tell you if there is more than
-    // one bit set, but we also account for the value being 0.
-    return mask && !(mask & (mask - 1));
-  }
+  bool OnlyOneCpu(const cpu_mask_t mask) { return mask.count() == 1; }
 
   // GIC v2 only allows 8 cpus.
   static constexpr size_t kMapSize = 8;
@@ -16,13 +16,13 @@ bool test_gic_translator_translate() {
   arm_gicv2::CpuMaskTranslator translator;
 
   translator.SetGicIdForLogicalId(0, 7);
-  ASSERT_EQ(0b10000000u, translator.GetGicMask(0));
+  ASSERT_TRUE(CpuMask::FromWord(0b10000000u) == translator.GetGicMask(0));
 
   translator.SetGicIdForLogicalId(1, 2);
-  ASSERT_EQ(0b00000100u, translator.GetGicMask(1));
+  ASSERT_TRUE(CpuMask::FromWord(0b00000100u) == translator.GetGicMask(1));
 
   translator.SetGicIdForLogicalId(2, 0);
-  ASSERT_EQ(0b00000001u, translator.GetGicMask(2));
+  ASSERT_TRUE(CpuMask::FromWord(0b00000001u) == translator.GetGicMask(2));
 
   END_TEST;
 }
@@ -36,8 +36,10 @@ bool test_gic_translator_translate_mask() {
   translator.SetGicIdForLogicalId(1, 2);
   translator.SetGicIdForLogicalId(2, 0);
 
-  ASSERT_EQ(0b10000101u, translator.LogicalMaskToGic(0b00000111));
-  ASSERT_EQ(0b10000000u, translator.LogicalMaskToGic(0b00000001));
+  ASSERT_TRUE(CpuMask::FromWord(0b10000101u) ==
+              translator.LogicalMaskToGic(CpuMask::FromWord(0b00000111)));
+  ASSERT_TRUE(CpuMask::FromWord(0b10000000u) ==
+              translator.LogicalMaskToGic(CpuMask::FromWord(0b00000001)));
 
   END_TEST;
 }
@@ -242,8 +242,8 @@ void send_sgi_for_cluster(unsigned int irq, uint64_t aff321, uint64_t aff0_mask)
   }
 }
 
-zx_status_t arm_gic_sgi(const unsigned int irq, const unsigned int flags, unsigned int cpu_mask) {
-  LTRACEF("irq %u, flags %u, cpu_mask %#x\n", irq, flags, cpu_mask);
+zx_status_t arm_gic_sgi(const unsigned int irq, const unsigned int flags, cpu_mask_t cpu_mask) {
+  LTRACEF("irq %u, flags %u, cpu_mask %#lx\n", irq, flags, cpu_mask.word(0));
 
   if (flags != ARM_GIC_SGI_FLAG_NS) {
     return ZX_ERR_INVALID_ARGS;
@@ -275,8 +275,8 @@ zx_status_t arm_gic_sgi(const unsigned int irq, const unsigned int flags, unsign
     }
 
     // This cpu is within the current aff mask we're looking at, accumulate.
-    if (cpu_mask & (1u << cpu)) {
-      cpu_mask &= ~(1u << cpu);
+    if (cpu_mask.test(cpu)) {
+      cpu_mask.reset(cpu);
       aff0_mask |= 1u << aff0;
     }
   }
@@ -372,8 +372,22 @@ zx_status_t gic_get_interrupt_config(interrupt_vector_t vector, interrupt_trigge
 }
 
 zx_status_t gic_set_affinity(interrupt_vector_t vector, cpu_mask_t mask) {
-  LTRACEF("vector %u, mask %#x\n", vector, mask);
-  return ZX_ERR_NOT_SUPPORTED;
+  LTRACEF("vector %u, mask %#lx\n", vector, mask.word(0));
+
+  // Only SPIs can be routed, SGIs and PPIs are private to each CPU.
+  if (vector < 32 || vector >= gic_max_int) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+
+  // Targeted routing (IRM == 0) names a single PE by affinity, so route to the lowest online CPU
+  // in the mask. The affinity fields of GICD_IROUTER line up with those of the MPIDR.
+  const cpu_mask_t online = mask & mp_get_online_mask();
+  if (!online) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  const uint64_t mpidr = arch_cpu_num_to_mpidr(online.lowest());
+  arm_gicv3_write64(GICD_IROUTER(vector), mpidr & ARM64_MPIDR_MASK);
+  return ZX_OK;
 }
 
 interrupt_vector_t gic_remap_interrupt(interrupt_vector_t vector) {
@@ -416,9 +430,9 @@ zx_status_t gic_send_ipi(cpu_mask_t target, mp_ipi ipi) {
   uint gic_ipi_num = static_cast<uint32_t>(ipi) + ipi_base;
 
   // filter out targets outside of the range of cpus we care about
-  target &= static_cast<cpu_mask_t>(((1UL << arch_max_num_cpus()) - 1));
-  if (target != 0) {
-    LTRACEF("target 0x%x, gic_ipi %u\n", target, gic_ipi_num);
+  target &= CpuMask::FirstN(arch_max_num_cpus());
+  if (target) {
+    LTRACEF("target %#lx, gic_ipi %u\n", target.word(0), gic_ipi_num);
     arm_gic_sgi(gic_ipi_num, ARM_GIC_SGI_FLAG_NS, target);
   }
 
@@ -173,4 +173,13 @@ void msi_free_block(msi_block_t* block);
 // block.
 void msi_register_handler(const msi_block_t* block, uint msi_id, interrupt_handler_t handler);
 
+// Steer a given msi_id within an msi_block at |cpu|.
+//
+// On platforms where the CPU is encoded in the MSI target address, the address the device must
+// now write to is returned in |out_tgt_addr| and it is up to the caller to program it into the
+// device. Otherwise the platform retargets the interrupt itself and |out_tgt_addr| is the block's
+// unchanged target address.
+zx_status_t msi_route_to_cpu(const msi_block_t* block, uint msi_id, cpu_num_t cpu,
+                             uint64_t* out_tgt_addr);
+
 #endif  // ZIRCON_KERNEL_DEV_INTERRUPT_INCLUDE_DEV_INTERRUPT_H_
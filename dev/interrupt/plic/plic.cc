@@ -148,7 +148,7 @@ zx_status_t plic_get_interrupt_config(interrupt_vector_t vector, interrupt_trigg
 }
 
 static zx_status_t plic_set_affinity(interrupt_vector_t vector, cpu_mask_t mask) {
-  LTRACEF("vector %u, mask %#x\n", vector, mask);
+  LTRACEF("vector %u, mask %#lx\n", vector, mask.word(0));
   return ZX_ERR_NOT_SUPPORTED;
 }
 
@@ -213,10 +213,14 @@ zx::result<uint64_t> DeviceContext::SecondLevelMap(const fbl::RefPtr<VmObject>&
 
   uint flags = perms_to_arch_mmu_flags(perms);
 
-  if (vmo->LookupContiguous(vmo_offset, size, nullptr) != ZX_OK) {
+  // The range is pinned, so the physical address found here stays valid and there is no need to
+  // look it up again when mapping.
+  paddr_t paddr = UINT64_MAX;
+  if (vmo->LookupContiguous(vmo_offset, size, &paddr) != ZX_OK) {
     return SecondLevelMapDiscontiguous(vmo, vmo_offset, size, flags);
   }
-  return SecondLevelMapContiguous(vmo, vmo_offset, size, flags);
+  DEBUG_ASSERT(paddr != UINT64_MAX);
+  return SecondLevelMapContiguous(paddr, size, flags);
 }
 
 zx::result<uint64_t> DeviceContext::SecondLevelMapDiscontiguous(const fbl::RefPtr<VmObject>& vmo,
@@ -288,19 +292,13 @@ zx::result<uint64_t> DeviceContext::SecondLevelMapDiscontiguous(const fbl::RefPt
   return zx::ok(region->base);
 }
 
-zx::result<uint64_t> DeviceContext::SecondLevelMapContiguous(const fbl::RefPtr<VmObject>& vmo,
-                                                             uint64_t vmo_offset, size_t size,
+zx::result<uint64_t> DeviceContext::SecondLevelMapContiguous(paddr_t paddr, size_t size,
                                                              uint flags) {
-  paddr_t paddr = UINT64_MAX;
-  zx_status_t status = vmo->LookupContiguous(vmo_offset, size, &paddr);
-  if (status != ZX_OK) {
-    return zx::error(status);
-  }
-  DEBUG_ASSERT(paddr != UINT64_MAX);
+  DEBUG_ASSERT(IS_PAGE_ROUNDED(paddr));
 
   RegionAllocator::Region::UPtr region;
   uint64_t min_contig = minimum_contiguity();
-  status = region_alloc_.GetRegion(size, min_contig, region);
+  zx_status_t status = region_alloc_.GetRegion(size, min_contig, region);
   if (status != ZX_OK) {
     return zx::error(status);
   }
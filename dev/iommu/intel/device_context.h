@@ -73,10 +73,10 @@ class DeviceContext : public fbl::DoublyLinkedListable<ktl::unique_ptr<DeviceCon
   zx::result<uint64_t> SecondLevelMapDiscontiguous(const fbl::RefPtr<VmObject>& vmo,
                                                    uint64_t offset, size_t size, uint flags);
 
-  // Map a VMO which consists of contiguous physical pages. Either maps
-  // the whole requested range, returning the base dev_addr_t, or fails.
-  zx::result<uint64_t> SecondLevelMapContiguous(const fbl::RefPtr<VmObject>& vmo, uint64_t offset,
-                                                size_t size, uint flags);
+  // Map a range of a VMO which consists of contiguous physical pages starting
+  // at |paddr|. Either maps the whole requested range, returning the base
+  // dev_addr_t, or fails.
+  zx::result<uint64_t> SecondLevelMapContiguous(paddr_t paddr, size_t size, uint flags);
 
   IommuImpl* const parent_;
   union {
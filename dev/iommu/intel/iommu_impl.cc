@@ -7,6 +7,7 @@
 #include "iommu_impl.h"
 
 #include <align.h>
+#include <lib/counters.h>
 #include <lib/root_resource_filter.h>
 #include <platform.h>
 #include <trace.h>
@@ -35,6 +36,10 @@
 
 #define LOCAL_TRACE 0
 
+KCOUNTER(iotlb_invalidate_global_count, "iommu.intel.iotlb_invalidate.global")
+KCOUNTER(iotlb_invalidate_domain_count, "iommu.intel.iotlb_invalidate.domain")
+KCOUNTER(iotlb_invalidate_page_count, "iommu.intel.iotlb_invalidate.page")
+
 namespace intel_iommu {
 
 IommuImpl::IommuImpl(volatile void* register_base, ktl::unique_ptr<const uint8_t[]> desc,
@@ -555,6 +560,7 @@ void IommuImpl::InvalidateIotlbGlobalLocked() {
   iotlb_invld.WriteTo(&mmio_);
 
   WaitForValueLocked(&iotlb_invld, &decltype(iotlb_invld)::invld_iotlb, 0, ZX_TIME_INFINITE);
+  iotlb_invalidate_global_count.Add(1);
 }
 
 void IommuImpl::InvalidateIotlbDomainAllLocked(uint32_t domain_id) {
@@ -569,6 +575,7 @@ void IommuImpl::InvalidateIotlbDomainAllLocked(uint32_t domain_id) {
   iotlb_invld.WriteTo(&mmio_);
 
   WaitForValueLocked(&iotlb_invld, &decltype(iotlb_invld)::invld_iotlb, 0, ZX_TIME_INFINITE);
+  iotlb_invalidate_domain_count.Add(1);
 }
 
 void IommuImpl::InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr, uint pages_pow2) {
@@ -592,6 +599,7 @@ void IommuImpl::InvalidateIotlbPageLocked(uint32_t domain_id, dev_vaddr_t vaddr,
   iotlb_invld.WriteTo(&mmio_);
 
   WaitForValueLocked(&iotlb_invld, &decltype(iotlb_invld)::invld_iotlb, 0, ZX_TIME_INFINITE);
+  iotlb_invalidate_page_count.Add(1);
 }
 
 void IommuImpl::InvalidateIotlbGlobal() {
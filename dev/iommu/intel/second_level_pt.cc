@@ -7,6 +7,7 @@
 #include "second_level_pt.h"
 
 #include <arch/x86/mmu.h>
+#include <ktl/algorithm.h>
 
 #include "device_context.h"
 #include "iommu_impl.h"
@@ -137,15 +138,15 @@ void SecondLevelPageTable::TlbInvalidate(const PendingTlbInvalidation* pending)
     TA_NO_THREAD_SAFETY_ANALYSIS {
   DEBUG_ASSERT(!pending->contains_global);
 
-  if (pending->full_shootdown) {
+  if (pending->full_shootdown || !iommu_->caps()->supports_page_selective_invld()) {
     iommu_->InvalidateIotlbDomainAllLocked(parent_->domain_id());
     return;
   }
 
   constexpr uint kBitsPerLevel = 9;
+  const uint max_address_mask = static_cast<uint>(iommu_->caps()->max_addr_mask_value());
   for (uint i = 0; i < pending->count; ++i) {
     const auto& item = pending->item[i];
-    uint address_mask = kBitsPerLevel * static_cast<uint>(item.page_level());
 
     if (!item.is_terminal()) {
       // If this is non-terminal, force the paging-structure cache to be
@@ -153,9 +154,27 @@ void SecondLevelPageTable::TlbInvalidate(const PendingTlbInvalidation* pending)
       // been changed.
       // TODO(teisenbe): Not completely sure this is necessary.  Including for
       // now out of caution.
-      address_mask = 0;
+      for (uint j = 0; j < item.pages(); ++j) {
+        iommu_->InvalidateIotlbPageLocked(parent_->domain_id(), item.addr() + j * item.page_size(),
+                                          0);
+      }
+      continue;
+    }
+
+    // Each page-selective invalidation waits for the hardware to complete it, so rather than
+    // invalidating page by page cover the run with as few naturally aligned power of two blocks as
+    // the address mask allows.
+    uint64_t frame = item.addr() >> PAGE_SIZE_SHIFT;
+    uint64_t frames = static_cast<uint64_t>(item.pages())
+                      << (kBitsPerLevel * static_cast<uint>(item.page_level()));
+    while (frames > 0) {
+      uint order = frame == 0 ? max_address_mask : static_cast<uint>(__builtin_ctzll(frame));
+      order = ktl::min(order, static_cast<uint>(63 - __builtin_clzll(frames)));
+      order = ktl::min(order, max_address_mask);
+      iommu_->InvalidateIotlbPageLocked(parent_->domain_id(), frame << PAGE_SIZE_SHIFT, order);
+      frame += 1ul << order;
+      frames -= 1ul << order;
     }
-    iommu_->InvalidateIotlbPageLocked(parent_->domain_id(), item.addr(), address_mask);
   }
 }
 
@@ -19,6 +19,8 @@
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
 #include <kernel/mutex.h>
+#include <kernel/semaphore.h>
+#include <ktl/atomic.h>
 #include <region-alloc/region-alloc.h>
 
 class SharedLegacyIrqHandler;
@@ -121,6 +123,11 @@ class PcieBusDriver : public fbl::RefCounted<PcieBusDriver> {
   // devices.
   fbl::RefPtr<PcieDevice> GetNthDevice(uint32_t index);
 
+  // Scan the bus below |upstream| for devices.  While StartBusDriver is
+  // scanning in parallel, the scan is queued for the scan workers instead of
+  // being done by the caller.
+  void ScanDownstreamOf(PcieUpstreamNode& upstream);
+
   // Topology related stuff
   void LinkDeviceToUpstream(PcieDevice& dev, PcieUpstreamNode& upstream);
   void UnlinkDeviceFromUpstream(PcieDevice& dev);
@@ -154,8 +161,11 @@ class PcieBusDriver : public fbl::RefCounted<PcieBusDriver> {
   static void ShutdownDriver();
 
   // Debug/ASSERT routine, used by devices and bridges to assert that the
-  // rescan lock is currently being held.
-  bool RescanLockIsHeld() const { return bus_rescan_lock_.lock().IsHeld(); }
+  // rescan lock is currently being held, either by the caller or by the thread
+  // which started the scan workers the caller is one of.
+  bool RescanLockIsHeld() const {
+    return bus_rescan_lock_.lock().IsHeld() || parallel_scan_.load(ktl::memory_order_relaxed);
+  }
 
  private:
   friend class PcieDebugConsole;
@@ -195,13 +205,30 @@ class PcieBusDriver : public fbl::RefCounted<PcieBusDriver> {
 
   static void RunQuirks(const fbl::RefPtr<PcieDevice>& device);
 
+  // Parallel scanning support.  The roots, and the bridges found below them,
+  // are scanned by a worker thread on each online CPU.
+  void ScanRootsParallel();
+  static int ScanWorker(void* ctx);
+
   State state_ = State::NOT_STARTED;
   DECLARE_MUTEX(PcieBusDriver) bus_topology_lock_;
   DECLARE_MUTEX(PcieBusDriver) bus_rescan_lock_;
   mutable DECLARE_MUTEX(PcieBusDriver) start_lock_;
   RootCollection roots_;
+  DECLARE_MUTEX(PcieBusDriver) config_lock_;
   fbl::SinglyLinkedList<fbl::RefPtr<PciConfig>> configs_;
 
+  // Parallel scanning state.  Every upstream node whose scan is queued or in
+  // progress is counted as pending, and the semaphore is posted once for every
+  // queued node and, when nothing is left pending, once for every worker.
+  DECLARE_MUTEX(PcieBusDriver) scan_lock_;
+  fbl::RefPtr<PcieUpstreamNode> scan_queue_[PCIE_MAX_BUSSES];
+  size_t scan_queued_ = 0;
+  size_t scan_pending_ = 0;
+  uint scan_workers_ = 0;
+  Semaphore scan_work_;
+  ktl::atomic<bool> parallel_scan_{false};
+
   RegionAllocator::RegionPool::RefPtr region_bookkeeping_;
   RegionAllocator pf_mmio_regions_;
   RegionAllocator mmio_lo_regions_;
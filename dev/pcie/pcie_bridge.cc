@@ -116,7 +116,7 @@ zx_status_t PcieBridge::Init(PcieUpstreamNode& upstream) {
   plugged_in_ = true;
   driver().LinkDeviceToUpstream(*this, upstream);
   // Release the device lock, then recurse and scan for downstream devices.
-  ScanDownstream();
+  driver().ScanDownstreamOf(*this);
   return ZX_OK;
 }
 
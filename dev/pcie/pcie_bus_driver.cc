@@ -5,8 +5,10 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <debug.h>
 #include <inttypes.h>
 #include <lib/pci/pio.h>
+#include <platform.h>
 #include <trace.h>
 
 #include <dev/pcie_bridge.h>
@@ -15,7 +17,9 @@
 #include <dev/pcie_root.h>
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
+#include <kernel/mp.h>
 #include <kernel/mutex.h>
+#include <kernel/thread.h>
 #include <ktl/iterator.h>
 #include <ktl/limits.h>
 #include <ktl/utility.h>
@@ -171,13 +175,10 @@ zx_status_t PcieBusDriver::StartBusDriver() {
   {
     Guard<Mutex> guard{&bus_rescan_lock_};
 
-    // Scan each root looking for for devices and other bridges.
-    ForeachRoot(
-        [](const fbl::RefPtr<PcieRoot>& root, void* ctx) -> bool {
-          root->ScanDownstream();
-          return true;
-        },
-        nullptr);
+    // Scan each root looking for for devices and other bridges.  Nothing has
+    // been allocated yet, so the roots and bridges can be scanned in parallel,
+    // leaving BAR allocation to the single pass below.
+    ScanRootsParallel();
 
     if (!AdvanceState(State::STARTING_SCANNING, State::STARTING_RUNNING_QUIRKS))
       return ZX_ERR_BAD_STATE;
@@ -212,6 +213,123 @@ zx_status_t PcieBusDriver::StartBusDriver() {
   return ZX_OK;
 }
 
+void PcieBusDriver::ScanDownstreamOf(PcieUpstreamNode& upstream) {
+  if (parallel_scan_.load(ktl::memory_order_relaxed)) {
+    bool queued = false;
+    {
+      Guard<Mutex> guard{&scan_lock_};
+      if (scan_queued_ < ktl::size(scan_queue_)) {
+        scan_queue_[scan_queued_++] = fbl::RefPtr(&upstream);
+        scan_pending_++;
+        queued = true;
+      }
+    }
+    if (queued) {
+      scan_work_.Post();
+      return;
+    }
+  }
+
+  upstream.ScanDownstream();
+}
+
+void PcieBusDriver::ScanRootsParallel() {
+  DEBUG_ASSERT(RescanLockIsHeld());
+  const zx_instant_mono_t start = current_mono_time();
+
+  parallel_scan_.store(true, ktl::memory_order_relaxed);
+  ForeachRoot(
+      [](const fbl::RefPtr<PcieRoot>& root, void* ctx) -> bool {
+        static_cast<PcieBusDriver*>(ctx)->ScanDownstreamOf(*root);
+        return true;
+      },
+      this);
+
+  // Create all of the workers before starting any of them, so that the last
+  // one to finish knows how many to wake.
+  Thread* threads[SMP_MAX_CPUS] = {};
+  uint workers = 1;
+  const cpu_mask_t online_mask = mp_get_online_mask();
+  const cpu_num_t curr_cpu = arch_curr_cpu_num();
+  for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+    if (cpu == curr_cpu || (online_mask & cpu_num_to_mask(cpu)) == 0) {
+      continue;
+    }
+    threads[cpu] = Thread::Create("pcie-scan", &PcieBusDriver::ScanWorker, this, DEFAULT_PRIORITY);
+    if (!threads[cpu]) {
+      break;
+    }
+    threads[cpu]->SetCpuAffinity(cpu_num_to_mask(cpu));
+    workers++;
+  }
+
+  bool done;
+  {
+    Guard<Mutex> guard{&scan_lock_};
+    scan_workers_ = workers;
+    done = (scan_pending_ == 0);
+  }
+  if (done) {
+    // There was nothing to scan; wake every worker so that it exits right away.
+    for (uint i = 0; i < workers; i++) {
+      scan_work_.Post();
+    }
+  }
+
+  for (Thread* thread : threads) {
+    if (thread) {
+      thread->Resume();
+    }
+  }
+
+  // The current thread takes part as well, and does all of the scanning if no
+  // workers could be created.
+  ScanWorker(this);
+  for (Thread* thread : threads) {
+    if (thread) {
+      thread->Join(nullptr, ZX_TIME_INFINITE);
+    }
+  }
+  parallel_scan_.store(false, ktl::memory_order_relaxed);
+
+  dprintf(INFO, "PCIe: scanned roots in %" PRIi64 " us with %u workers\n",
+          (current_mono_time() - start) / ZX_USEC(1), workers);
+}
+
+int PcieBusDriver::ScanWorker(void* ctx) {
+  auto driver = static_cast<PcieBusDriver*>(ctx);
+
+  while (true) {
+    driver->scan_work_.Wait(Deadline::infinite());
+
+    fbl::RefPtr<PcieUpstreamNode> upstream;
+    {
+      Guard<Mutex> guard{&driver->scan_lock_};
+      // Nothing was queued for this wakeup, so everything has been scanned.
+      if (driver->scan_queued_ == 0) {
+        DEBUG_ASSERT(driver->scan_pending_ == 0);
+        return 0;
+      }
+      upstream = ktl::move(driver->scan_queue_[--driver->scan_queued_]);
+    }
+
+    // Any bridges found below are queued, and counted as pending, before this
+    // node stops being pending.
+    upstream->ScanDownstream();
+
+    uint wake = 0;
+    {
+      Guard<Mutex> guard{&driver->scan_lock_};
+      if (--driver->scan_pending_ == 0) {
+        wake = driver->scan_workers_;
+      }
+    }
+    for (uint i = 0; i < wake; i++) {
+      driver->scan_work_.Post();
+    }
+  }
+}
+
 fbl::RefPtr<PcieDevice> PcieBusDriver::GetNthDevice(uint32_t index) {
   struct GetNthDeviceState {
     uint32_t index;
@@ -532,6 +650,9 @@ const PciConfig* PcieBusDriver::GetConfig(uint bus_id, uint dev_id, uint func_id
     return nullptr;
   }
 
+  // Devices may be scanned in parallel, see ScanRootsParallel.
+  Guard<Mutex> guard{&config_lock_};
+
   // Check if we already have this config space cached somewhere.
   auto cfg_iter = configs_.find_if([addr](const PciConfig& cfg) { return (cfg.base() == addr); });
 
@@ -106,8 +106,8 @@ void PcieUpstreamNode::ScanDownstream() {
         } else if (downstream_device->is_bridge()) {
           // TODO(johngro) : Instead of going up and down the class graph with static
           // casts, would it be better to do this with vtable tricks?
-          static_cast<PcieUpstreamNode*>(static_cast<PcieBridge*>(downstream_device.get()))
-              ->ScanDownstream();
+          driver().ScanDownstreamOf(
+              *static_cast<PcieUpstreamNode*>(static_cast<PcieBridge*>(downstream_device.get())));
         }
       }
 
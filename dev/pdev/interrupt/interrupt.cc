@@ -5,12 +5,14 @@
 // https://opensource.org/licenses/MIT
 
 #include <lib/arch/intrin.h>
+#include <lib/counters.h>
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
 #include <kernel/spinlock.h>
 #include <lk/init.h>
 #include <pdev/interrupt.h>
+#include <platform/timer.h>
 
 #include <ktl/enforce.h>
 
@@ -25,6 +27,14 @@ struct int_handler_struct {
 
 struct int_handler_struct int_handler_table[MAX_INTERRUPTS];
 
+// Time spent in registered device interrupt handlers, from 128ns up to 2ms.
+KCOUNTER_HISTOGRAM(interrupt_handler_duration_ns, "interrupt.handler_duration_ns", 7)
+
+void RecordHandlerDuration(zx_instant_mono_ticks_t start_ticks) {
+  interrupt_handler_duration_ns.Add(static_cast<uint64_t>(
+      timer_get_ticks_to_time_ratio().Scale(current_mono_ticks() - start_ticks)));
+}
+
 struct int_handler_struct* pdev_get_int_handler(interrupt_vector_t vector) {
   DEBUG_ASSERT(vector < MAX_INTERRUPTS);
   return &int_handler_table[vector];
@@ -92,6 +102,7 @@ zx_status_t register_permanent_int_handler(interrupt_vector_t vector, interrupt_
 
 bool pdev_invoke_int_if_present(interrupt_vector_t vector) {
   auto h = pdev_get_int_handler(vector);
+  const zx_instant_mono_ticks_t start_ticks = current_mono_ticks();
   // Use a relaxed load as permanent handlers are never modified once set, and they are only set in
   // startup code, and so there is nothing to race with.
   if (h->permanent.load(ktl::memory_order_relaxed)) {
@@ -101,12 +112,14 @@ bool pdev_invoke_int_if_present(interrupt_vector_t vector) {
       DEBUG_ASSERT(h->handler);
       h->handler();
     }();
+    RecordHandlerDuration(start_ticks);
     return true;
   }
   Guard<SpinLock, IrqSave> guard{pdev_lock::Get()};
 
   if (h->handler) {
     h->handler();
+    RecordHandlerDuration(start_ticks);
     return true;
   }
   return false;
@@ -209,6 +222,20 @@ void msi_register_handler(const msi_block_t* block, uint msi_id, interrupt_handl
   intr_ops->msi_register_handler(block, msi_id, ktl::move(handler));
 }
 
+zx_status_t msi_route_to_cpu(const msi_block_t* block, uint msi_id, cpu_num_t cpu,
+                             uint64_t* out_tgt_addr) {
+  DEBUG_ASSERT(block && block->allocated);
+  DEBUG_ASSERT(msi_id < block->num_irq);
+  // MSIs arrive through a frame shared by all CPUs and are routed onwards by the interrupt
+  // controller like any other interrupt, so only the routing of the vector needs to change.
+  zx_status_t status = set_interrupt_affinity(block->base_irq_id + msi_id, cpu_num_to_mask(cpu));
+  if (status != ZX_OK) {
+    return status;
+  }
+  *out_tgt_addr = block->tgt_addr;
+  return ZX_OK;
+}
+
 namespace {
 
 void interrupt_init_percpu_early_hook(uint level) { interrupt_init_percpu_early(); }
@@ -810,7 +810,8 @@ bool test_event_stream() {
   Thread* threads[SMP_MAX_CPUS]{};
 
   // How many online+active CPUs do we have?
-  uint32_t num_cpus = ktl::popcount(mp_get_online_mask() & Scheduler::PeekActiveMask());
+  uint32_t num_cpus =
+      static_cast<uint32_t>((mp_get_online_mask() & Scheduler::PeekActiveMask()).count());
   args.waiting.store(num_cpus);
 
   // Create a thread bound to each online+active CPU, but don't start them just yet.
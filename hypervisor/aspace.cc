@@ -15,6 +15,10 @@
 #include <vm/physmap.h>
 #include <vm/vm_object_physical.h>
 
+#if defined(__x86_64__)
+#include <arch/x86/hypervisor/vmx_state.h>
+#endif
+
 #include <ktl/enforce.h>
 
 namespace {
@@ -191,6 +195,38 @@ zx::result<GuestPtr> GuestPhysicalAspace::CreateGuestPtr(zx_gpaddr_t guest_paddr
                          guest_paddr - begin));
 }
 
+zx::result<> GuestPhysicalAspace::HarvestDirty(zx_gpaddr_t guest_paddr, size_t len,
+                                               ktl::span<uint64_t> bitmap) {
+  if (!IS_PAGE_ROUNDED(guest_paddr) || !IS_PAGE_ROUNDED(len) ||
+      !InRange(guest_paddr, len, size())) {
+    return zx::error(ZX_ERR_INVALID_ARGS);
+  }
+  const size_t num_pages = len / PAGE_SIZE;
+  if (bitmap.size() < (num_pages + 63) / 64) {
+    return zx::error(ZX_ERR_BUFFER_TOO_SMALL);
+  }
+#if defined(__x86_64__)
+  if (!vmx_ept_supports_accessed_dirty()) {
+    return zx::error(ZX_ERR_NOT_SUPPORTED);
+  }
+  for (uint64_t& word : bitmap) {
+    word = 0;
+  }
+  zx_status_t status = arch_aspace().HarvestDirty(
+      guest_paddr, num_pages, [guest_paddr, &bitmap](vaddr_t vaddr, size_t dirty_len) {
+        // Reported ranges are always clipped to the harvested range.
+        const size_t first = (vaddr - guest_paddr) / PAGE_SIZE;
+        const size_t last = first + dirty_len / PAGE_SIZE;
+        for (size_t i = first; i < last; i++) {
+          bitmap[i / 64] |= uint64_t{1} << (i % 64);
+        }
+      });
+  return zx::make_result(status);
+#else
+  return zx::error(ZX_ERR_NOT_SUPPORTED);
+#endif
+}
+
 fbl::RefPtr<VmMapping> GuestPhysicalAspace::FindMapping(zx_gpaddr_t guest_paddr) const {
   fbl::RefPtr<VmAddressRegion> region = physical_aspace_->RootVmarLocked();
   AssertHeld(region->lock_ref());
@@ -14,11 +14,11 @@
 namespace {
 
 struct percpu_state {
-  ktl::atomic<cpu_mask_t> cpu_mask;
+  AtomicCpuMask cpu_mask;
   hypervisor::percpu_task_t task;
   void* context;
 
-  percpu_state(hypervisor::percpu_task_t pt, void* cx) : cpu_mask(0), task(pt), context(cx) {}
+  percpu_state(hypervisor::percpu_task_t pt, void* cx) : task(pt), context(cx) {}
 };
 
 }  // namespace
@@ -35,7 +35,7 @@ static void percpu_task(void* arg) {
 
 cpu_mask_t percpu_exec(percpu_task_t task, void* context) {
   percpu_state state(task, context);
-  mp_sync_exec(mp_ipi_target::ALL, 0, percpu_task, &state);
+  mp_sync_exec(mp_ipi_target::ALL, {}, percpu_task, &state);
   return state.cpu_mask.load();
 }
 
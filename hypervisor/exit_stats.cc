@@ -0,0 +1,73 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <inttypes.h>
+#include <lib/console.h>
+#include <stdio.h>
+
+#include <hypervisor/exit_stats.h>
+#include <kernel/mutex.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+DECLARE_SINGLETON_MUTEX(ExitStatsLock);
+fbl::DoublyLinkedList<hypervisor::ExitStats*> exit_stats_list TA_GUARDED(ExitStatsLock::Get());
+
+int cmd_vcpustat(int argc, const cmd_args* argv, uint32_t flags) {
+  if (argc != 1) {
+    printf("usage:\n");
+    printf("%s : print VM exit counts, handling time and a latency histogram (in ns) per vCPU\n",
+           argv[0].str);
+    return -1;
+  }
+  hypervisor::ExitStats::DumpAll();
+  return 0;
+}
+
+}  // namespace
+
+namespace hypervisor {
+
+ExitStats::ExitStats(zx_koid_t pid, zx_koid_t tid, ReasonNameFn reason_name)
+    : pid_(pid), tid_(tid), reason_name_(reason_name) {
+  Guard<Mutex> guard{ExitStatsLock::Get()};
+  exit_stats_list.push_back(this);
+}
+
+ExitStats::~ExitStats() {
+  Guard<Mutex> guard{ExitStatsLock::Get()};
+  exit_stats_list.erase(*this);
+}
+
+void ExitStats::DumpAll() {
+  Guard<Mutex> guard{ExitStatsLock::Get()};
+  for (const ExitStats& stats : exit_stats_list) {
+    stats.Dump();
+  }
+}
+
+void ExitStats::Dump() const {
+  printf("vcpu pid %" PRIu64 " tid %" PRIu64 ":\n", pid_, tid_);
+  for (uint32_t reason = 0; reason <= kMaxReasons; reason++) {
+    const uint64_t count = counts_[reason];
+    if (count == 0) {
+      continue;
+    }
+    const zx_duration_mono_t duration = durations_[reason];
+    printf("\t%-28s %10" PRIu64 " exits %14" PRIi64 " ns total %10" PRIi64 " ns avg\n",
+           reason == kMaxReasons ? "OTHER" : reason_name_(reason), count, duration,
+           duration / static_cast<zx_duration_mono_t>(count));
+  }
+  DumpSchedHistogram("exit latency", latency_);
+}
+
+}  // namespace hypervisor
+
+STATIC_COMMAND_START
+STATIC_COMMAND("vcpustat", "per-vCPU VM exit statistics", &cmd_vcpustat)
+STATIC_COMMAND_END(vcpustat)
@@ -456,6 +456,42 @@ static bool guest_physical_aspace_query() {
   END_TEST;
 }
 
+static bool guest_physical_aspace_harvest_dirty() {
+  BEGIN_TEST;
+
+  if (!hypervisor_supported()) {
+    return true;
+  }
+
+  // Setup.
+  auto gpa = create_gpas();
+  ASSERT_OK(gpa.status_value());
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status = create_vmo(PAGE_SIZE * 2, &vmo);
+  ASSERT_OK(status);
+  status = create_mapping(gpa->RootVmar(), vmo, 0);
+  ASSERT_OK(status);
+  for (zx_gpaddr_t addr = 0; addr < PAGE_SIZE * 2; addr += PAGE_SIZE) {
+    auto result = gpa->PageFault(addr);
+    ASSERT_OK(result.status_value());
+  }
+
+  uint64_t bitmap[1] = {~0ul};
+  auto result = gpa->HarvestDirty(1, PAGE_SIZE, bitmap);
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS, result.status_value());
+  result = gpa->HarvestDirty(0, PAGE_SIZE * 2, ktl::span<uint64_t>());
+  EXPECT_EQ(ZX_ERR_BUFFER_TOO_SMALL, result.status_value());
+
+  // Mapping a page does not dirty it, so only a guest write can set a bit.
+  result = gpa->HarvestDirty(0, PAGE_SIZE * 2, bitmap);
+  if (result.status_value() != ZX_ERR_NOT_SUPPORTED) {
+    EXPECT_OK(result.status_value());
+    EXPECT_EQ(0u, bitmap[0]);
+  }
+
+  END_TEST;
+}
+
 static bool direct_physical_aspace_create() {
   BEGIN_TEST;
 
@@ -599,6 +635,7 @@ HYPERVISOR_UNITTEST(guest_physical_aspace_uncached_device)
 HYPERVISOR_UNITTEST(guest_physical_aspace_write_combining)
 HYPERVISOR_UNITTEST(guest_physical_aspace_protect)
 HYPERVISOR_UNITTEST(guest_physical_aspace_query)
+HYPERVISOR_UNITTEST(guest_physical_aspace_harvest_dirty)
 HYPERVISOR_UNITTEST(direct_physical_aspace_create)
 HYPERVISOR_UNITTEST(interrupt_bitmap)
 HYPERVISOR_UNITTEST(trap_map_insert_trap_intersecting)
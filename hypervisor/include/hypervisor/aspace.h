@@ -9,6 +9,7 @@
 
 #include <lib/zx/result.h>
 
+#include <ktl/span.h>
 #include <ktl/unique_ptr.h>
 #include <ktl/utility.h>
 #include <vm/pinned_vm_object.h>
@@ -77,6 +78,16 @@ class GuestPhysicalAspace {
   zx::result<> PageFault(zx_gpaddr_t guest_paddr);
   zx::result<GuestPtr> CreateGuestPtr(zx_gpaddr_t guest_paddr, size_t len, const char* name);
 
+  // Fills |bitmap| with the pages in [guest_paddr, guest_paddr + len) that the guest has written
+  // to since the last harvest of them, and resets the log for those pages. Bit i of the bitmap,
+  // counting from the low bit of the first word, covers the i-th page of the range. Pages may be
+  // reported dirty more than once, but a write is never missed, so a VMM can copy the reported
+  // pages after this returns for pre-copy migration or incremental snapshots.
+  //
+  // Unmapping or changing the permissions of a page discards its log. Returns
+  // ZX_ERR_NOT_SUPPORTED if the hardware cannot track dirty pages.
+  zx::result<> HarvestDirty(zx_gpaddr_t guest_paddr, size_t len, ktl::span<uint64_t> bitmap);
+
  private:
   fbl::RefPtr<VmMapping> FindMapping(zx_gpaddr_t guest_paddr) const
       TA_REQ(physical_aspace_->lock());
@@ -0,0 +1,64 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_HYPERVISOR_INCLUDE_HYPERVISOR_EXIT_STATS_H_
+#define ZIRCON_KERNEL_HYPERVISOR_INCLUDE_HYPERVISOR_EXIT_STATS_H_
+
+#include <lib/relaxed_atomic.h>
+#include <zircon/types.h>
+
+#include <fbl/intrusive_double_list.h>
+#include <kernel/sched_histogram.h>
+#include <ktl/array.h>
+
+namespace hypervisor {
+
+// Counts the VM exits of a vCPU by reason, along with the time spent handling
+// them in the kernel, for the `vcpustat` console command.
+//
+// Only the vCPU thread records, so recording is a few uncontended relaxed adds,
+// cheap enough to always be on. The time of an exit that waits for an
+// interrupt, such as HLT or WFI, includes the time the vCPU was idle.
+class ExitStats : public fbl::DoublyLinkedListable<ExitStats*> {
+ public:
+  // Exit reasons are x86 basic exit reasons or arm64 exception classes, both of
+  // which are below this. Any other reason is counted in the last slot.
+  static constexpr uint32_t kMaxReasons = 80;
+
+  using ReasonNameFn = const char* (*)(uint32_t reason);
+
+  ExitStats(zx_koid_t pid, zx_koid_t tid, ReasonNameFn reason_name);
+  ~ExitStats();
+
+  ExitStats(const ExitStats&) = delete;
+  ExitStats& operator=(const ExitStats&) = delete;
+
+  void Record(uint32_t reason, zx_duration_mono_t duration) {
+    if (reason >= kMaxReasons) {
+      reason = kMaxReasons;
+    }
+    counts_[reason] += 1;
+    durations_[reason] += duration;
+    latency_[SchedHistogramBucket(duration)] += 1;
+  }
+
+  // Prints the stats of every live vCPU.
+  static void DumpAll();
+
+ private:
+  void Dump() const;
+
+  const zx_koid_t pid_;
+  const zx_koid_t tid_;
+  const ReasonNameFn reason_name_;
+  ktl::array<RelaxedAtomic<uint64_t>, kMaxReasons + 1> counts_{};
+  ktl::array<RelaxedAtomic<zx_duration_mono_t>, kMaxReasons + 1> durations_{};
+  ktl::array<RelaxedAtomic<uint64_t>, kSchedHistogramBuckets> latency_{};
+};
+
+}  // namespace hypervisor
+
+#endif  // ZIRCON_KERNEL_HYPERVISOR_INCLUDE_HYPERVISOR_EXIT_STATS_H_
@@ -7,6 +7,7 @@
 #ifndef ZIRCON_KERNEL_HYPERVISOR_INCLUDE_HYPERVISOR_INTERRUPT_TRACKER_H_
 #define ZIRCON_KERNEL_HYPERVISOR_INCLUDE_HYPERVISOR_INTERRUPT_TRACKER_H_
 
+#include <lib/arch/intrin.h>
 #include <lib/fit/defer.h>
 #include <lib/ktrace.h>
 #include <lib/zx/result.h>
@@ -16,6 +17,8 @@
 #include <hypervisor/ktrace.h>
 #include <hypervisor/state_invalidator.h>
 #include <kernel/event.h>
+#include <ktl/algorithm.h>
+#include <platform/timer.h>
 
 namespace hypervisor {
 
@@ -72,6 +75,50 @@ class InterruptBitmap {
   bitmap::RawBitmapGeneric<bitmap::FixedStorage<N>> bitmap_;
 };
 
+// Adaptively polls for an interrupt before a vCPU blocks.
+//
+// Guests that idle for short periods pay for a full block and wake, and
+// possibly a migration, on every HLT or WFI. The poll window grows while the
+// vCPU keeps being woken shortly after blocking, and shrinks when it blocks for
+// longer than the maximum window, so guests that idle for long periods do not
+// burn CPU spinning.
+class HaltPoller {
+ public:
+  // Spins until |pending| returns true, the poll window elapses, or |deadline|
+  // passes. Returns true if the vCPU should resume without blocking.
+  template <typename Pending>
+  bool Poll(zx_instant_mono_t deadline, Pending&& pending) {
+    if (window_ == 0) {
+      return false;
+    }
+    const zx_instant_mono_t start = current_mono_time();
+    const zx_instant_mono_t end = ktl::min(zx_time_add_duration(start, window_), deadline);
+    zx_instant_mono_t now = start;
+    for (; now < end; now = current_mono_time()) {
+      if (pending()) {
+        PollHit();
+        return true;
+      }
+      arch::Yield();
+    }
+    if (now >= deadline) {
+      PollHit();
+      return true;
+    }
+    PollMiss();
+    return false;
+  }
+
+  // Adjusts the poll window after the vCPU was blocked for |blocked|.
+  void Blocked(zx_duration_mono_t blocked);
+
+ private:
+  static void PollHit();
+  static void PollMiss();
+
+  zx_duration_mono_t window_ = 0;
+};
+
 // |N| is the maximum number of interrupts to be tracked.
 template <uint32_t N>
 class InterruptTracker {
@@ -132,8 +179,15 @@ class InterruptTracker {
     if (invalidator != nullptr) {
       invalidator->Invalidate();
     }
+    if (halt_poller_.Poll(deadline, [this] { return Pending(); })) {
+      return zx::ok();
+    }
     ktrace_vcpu(VCPU_BLOCK, VCPU_INTERRUPT);
-    auto defer = fit::defer([] { ktrace_vcpu(VCPU_UNBLOCK, VCPU_INTERRUPT); });
+    const zx_instant_mono_t block_start = current_mono_time();
+    auto defer = fit::defer([this, block_start] {
+      halt_poller_.Blocked(zx_time_sub_time(current_mono_time(), block_start));
+      ktrace_vcpu(VCPU_UNBLOCK, VCPU_INTERRUPT);
+    });
     do {
       zx_status_t status = event_.Wait(Deadline::no_slack(deadline));
       switch (status) {
@@ -151,6 +205,8 @@ class InterruptTracker {
   }
 
  private:
+  // Only used by the vCPU thread, from Wait.
+  HaltPoller halt_poller_;
   AutounsignalEvent event_;
   DECLARE_SPINLOCK(InterruptTracker) lock_;
   InterruptBitmap<N> bitmap_ TA_GUARDED(lock_);
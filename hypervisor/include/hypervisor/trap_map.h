@@ -12,11 +12,17 @@
 #include <fbl/ref_ptr.h>
 #include <hypervisor/state_invalidator.h>
 #include <kernel/semaphore.h>
+#include <kernel/spinlock.h>
+#include <ktl/array.h>
+#include <ktl/atomic.h>
 #include <object/port_dispatcher.h>
 
 namespace hypervisor {
 
 // Blocks on allocation if the arena is empty.
+//
+// Also tracks the bell packet that is queued but not yet dequeued, if any, so
+// that repeated writes to the same doorbell can be coalesced into it.
 class BlockingPortAllocator final : public PortAllocator {
  public:
   BlockingPortAllocator();
@@ -25,10 +31,20 @@ class BlockingPortAllocator final : public PortAllocator {
   PortPacket* AllocBlocking();
   virtual void Free(PortPacket* port_packet) override;
 
+  // Returns true if a bell packet for |addr| is still waiting in the port.
+  bool HasPendingBell(zx_gpaddr_t addr) TA_EXCL(lock_);
+  // Records |port_packet| as the pending bell packet, if there is none. This
+  // must be called before the packet is queued, as it may be freed as soon as
+  // it has been queued.
+  void SetPendingBell(PortPacket* port_packet) TA_EXCL(lock_);
+
  private:
   Semaphore semaphore_;
   fbl::TypedArena<PortPacket, Mutex> arena_;
 
+  DECLARE_SPINLOCK(BlockingPortAllocator) lock_;
+  PortPacket* pending_bell_ TA_GUARDED(lock_) = nullptr;
+
   PortPacket* Alloc() override;
 };
 
@@ -60,6 +76,11 @@ class Trap : public fbl::WAVLTreeContainable<ktl::unique_ptr<Trap>> {
 };
 
 // Contains all the traps within a guest.
+//
+// Traps are only ever inserted, and live as long as the TrapMap. This allows
+// FindTrap to first check the trap that was last found on the current CPU
+// without taking the lock, which is the common case for a vCPU repeatedly
+// hitting the same doorbell or IO port.
 class TrapMap {
  public:
   zx::result<> InsertTrap(uint32_t kind, zx_gpaddr_t addr, size_t len,
@@ -68,14 +89,19 @@ class TrapMap {
 
  private:
   using TrapTree = fbl::WAVLTree<zx_gpaddr_t, ktl::unique_ptr<Trap>>;
+  // The trap last found by FindTrap on each CPU.
+  using TrapCache = ktl::array<ktl::atomic<Trap*>, SMP_MAX_CPUS>;
 
   DECLARE_SPINLOCK(TrapMap) lock_;
   TrapTree mem_traps_ TA_GUARDED(lock_);
+  TrapCache mem_cache_{};
 #ifdef ARCH_X86
   TrapTree io_traps_ TA_GUARDED(lock_);
+  TrapCache io_cache_{};
 #endif  // ARCH_X86
 
   TrapTree* TreeOf(uint32_t kind);
+  TrapCache* CacheOf(uint32_t kind);
 };
 
 }  // namespace hypervisor
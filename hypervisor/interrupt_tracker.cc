@@ -0,0 +1,50 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/counters.h>
+
+#include <hypervisor/interrupt_tracker.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+// On x86 the vCPU polls with interrupts still disabled by AutoVmcs, so the
+// window is capped well below KVM's 200us default to bound the added host
+// interrupt latency. Wakes from other CPUs, such as the VMM kicking a queue,
+// are still caught.
+constexpr zx_duration_mono_t kHaltPollMax = ZX_USEC(50);
+constexpr zx_duration_mono_t kHaltPollStart = ZX_USEC(5);
+constexpr uint32_t kHaltPollGrow = 2;
+
+KCOUNTER(halt_poll_hit, "hypervisor.halt_poll.hit")
+KCOUNTER(halt_poll_miss, "hypervisor.halt_poll.miss")
+KCOUNTER(halt_poll_grow, "hypervisor.halt_poll.grow")
+KCOUNTER(halt_poll_shrink, "hypervisor.halt_poll.shrink")
+
+}  // namespace
+
+namespace hypervisor {
+
+void HaltPoller::Blocked(zx_duration_mono_t blocked) {
+  if (blocked > kHaltPollMax) {
+    // Polling would not have helped, so stop paying for it.
+    if (window_ != 0) {
+      window_ = window_ / kHaltPollGrow < kHaltPollStart ? 0 : window_ / kHaltPollGrow;
+      halt_poll_shrink.Add(1);
+    }
+  } else if (window_ < kHaltPollMax) {
+    // A slightly longer poll would have caught this wake.
+    window_ = window_ == 0 ? kHaltPollStart : ktl::min(window_ * kHaltPollGrow, kHaltPollMax);
+    halt_poll_grow.Add(1);
+  }
+}
+
+void HaltPoller::PollHit() { halt_poll_hit.Add(1); }
+
+void HaltPoller::PollMiss() { halt_poll_miss.Add(1); }
+
+}  // namespace hypervisor
@@ -4,6 +4,7 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <zircon/errors.h>
 #include <zircon/syscalls/hypervisor.h>
@@ -12,12 +13,15 @@
 #include <fbl/alloc_checker.h>
 #include <hypervisor/ktrace.h>
 #include <hypervisor/trap_map.h>
+#include <kernel/cpu.h>
 #include <kernel/range_check.h>
 
 namespace {
 
 constexpr size_t kMaxPacketsPerRange = 256;
 
+KCOUNTER(bells_coalesced, "hypervisor.trap.bells_coalesced")
+
 bool ValidRange(uint32_t kind, zx_gpaddr_t addr, size_t len) {
   if (len == 0) {
     return false;
@@ -60,10 +64,28 @@ PortPacket* BlockingPortAllocator::Alloc() {
 }
 
 void BlockingPortAllocator::Free(PortPacket* port_packet) {
+  {
+    Guard<SpinLock, IrqSave> guard{&lock_};
+    if (pending_bell_ == port_packet) {
+      pending_bell_ = nullptr;
+    }
+  }
   arena_.Delete(port_packet);
   semaphore_.Post();
 }
 
+bool BlockingPortAllocator::HasPendingBell(zx_gpaddr_t addr) {
+  Guard<SpinLock, IrqSave> guard{&lock_};
+  return pending_bell_ != nullptr && pending_bell_->packet.guest_bell.addr == addr;
+}
+
+void BlockingPortAllocator::SetPendingBell(PortPacket* port_packet) {
+  Guard<SpinLock, IrqSave> guard{&lock_};
+  if (pending_bell_ == nullptr) {
+    pending_bell_ = port_packet;
+  }
+}
+
 Trap::Trap(uint32_t kind, zx_gpaddr_t addr, size_t len, fbl::RefPtr<PortDispatcher> port,
            uint64_t key)
     : kind_(kind), addr_(addr), len_(len), port_(ktl::move(port)), key_(key) {}
@@ -84,11 +106,22 @@ zx::result<> Trap::Queue(const zx_port_packet_t& packet, StateInvalidator* inval
   if (port_ == nullptr) {
     return zx::error(ZX_ERR_NOT_FOUND);
   }
+  // A doorbell only tells the VMM to look at its queues. If a packet for the
+  // same doorbell has not been dequeued yet, the VMM has yet to look, so this
+  // write needs no packet of its own.
+  const bool is_bell = packet.type == ZX_PKT_TYPE_GUEST_BELL;
+  if (is_bell && port_allocator_.HasPendingBell(packet.guest_bell.addr)) {
+    bells_coalesced.Add(1);
+    return zx::ok();
+  }
   PortPacket* port_packet = port_allocator_.AllocBlocking();
   if (port_packet == nullptr) {
     return zx::error(ZX_ERR_NO_MEMORY);
   }
   port_packet->packet = packet;
+  if (is_bell) {
+    port_allocator_.SetPendingBell(port_packet);
+  }
   zx_status_t status = port_->Queue(port_packet);
   if (status != ZX_OK) {
     port_allocator_.Free(port_packet);
@@ -139,6 +172,14 @@ zx::result<Trap*> TrapMap::FindTrap(uint32_t kind, zx_gpaddr_t addr) {
     return zx::error(ZX_ERR_INVALID_ARGS);
   }
 
+  // We may migrate after reading the CPU number, but any slot holds either
+  // nullptr or a valid trap, so that only costs a cache miss.
+  ktl::atomic<Trap*>& cached = (*CacheOf(kind))[arch_curr_cpu_num()];
+  Trap* trap = cached.load(ktl::memory_order_acquire);
+  if (trap != nullptr && trap->Contains(addr)) {
+    return zx::ok(trap);
+  }
+
   Trap* found;
   {
     Guard<SpinLock, IrqSave> guard{&lock_};
@@ -151,6 +192,7 @@ zx::result<Trap*> TrapMap::FindTrap(uint32_t kind, zx_gpaddr_t addr) {
   if (!found->Contains(addr)) {
     return zx::error(ZX_ERR_NOT_FOUND);
   }
+  cached.store(found, ktl::memory_order_release);
   return zx::ok(found);
 }
 
@@ -168,4 +210,18 @@ TrapMap::TrapTree* TrapMap::TreeOf(uint32_t kind) {
   }
 }
 
+TrapMap::TrapCache* TrapMap::CacheOf(uint32_t kind) {
+  switch (kind) {
+    case ZX_GUEST_TRAP_BELL:
+    case ZX_GUEST_TRAP_MEM:
+      return &mem_cache_;
+#ifdef ARCH_X86
+    case ZX_GUEST_TRAP_IO:
+      return &io_cache_;
+#endif  // ARCH_X86
+    default:
+      return nullptr;
+  }
+}
+
 }  // namespace hypervisor
@@ -17,10 +17,14 @@
 #include <kernel/spin_tracing_config.h>
 #include <ktl/atomic.h>
 
+// The low 16 bits of |value| hold the number plus one of the CPU that owns the lock, or zero if it
+// is free. The remaining bits are for use by the implementation, see kernel/queued_spinlock.h.
 struct TA_CAP("mutex") arch_spin_lock_t {
   ktl::atomic<cpu_num_t> value;
 };
 
+inline constexpr cpu_num_t kArchSpinLockOwnerMask = 0xffff;
+
 void arch_spin_lock_non_instrumented(arch_spin_lock_t* lock) TA_ACQ(lock);
 void arch_spin_lock_trace_instrumented(arch_spin_lock_t* lock,
                                        spin_tracing::EncodedLockId encoded_lock_id) TA_ACQ(lock);
@@ -49,7 +53,7 @@ bool arch_spin_trylock(arch_spin_lock_t* lock) TA_TRY_ACQ(false, lock);
 void arch_spin_unlock(arch_spin_lock_t* lock) TA_REL(lock);
 
 inline cpu_num_t arch_spin_lock_holder_cpu(const arch_spin_lock_t* lock) {
-  return lock->value.load(ktl::memory_order_relaxed) - 1;
+  return (lock->value.load(ktl::memory_order_relaxed) & kArchSpinLockOwnerMask) - 1;
 }
 
 inline bool arch_spin_lock_held(const arch_spin_lock_t* lock) {
@@ -14,9 +14,12 @@
 #include <lib/zircon-internal/thread_annotations.h>
 #include <stdint.h>
 
+#include <arch/defines.h>
 #include <fbl/canary.h>
+#include <kernel/event.h>
 #include <kernel/lock_trace.h>
 #include <kernel/lock_validation_guard.h>
+#include <kernel/mutex.h>
 #include <kernel/owned_wait_queue.h>
 #include <kernel/scheduler.h>
 #include <kernel/spin_tracing_storage.h>
@@ -309,6 +312,120 @@ LOCK_DEP_POLICY_OPTION(BrwLockNoPi, BrwLockNoPi::Writer, BrwLockNoPi::WriterPoli
 // Configure fbl::Guard<BrwLockNoPi, BrwLockNoPi::Reader> read locks through the given policy.
 LOCK_DEP_POLICY_OPTION(BrwLockNoPi, BrwLockNoPi::Reader, BrwLockNoPi::ReaderPolicy);
 
+// Reader-biased ("big reader") variant of BrwLock for read-mostly state.
+//
+// Readers only increment and decrement a counter in a cache line picked by the
+// current CPU, so parallel readers on different CPUs never bounce a shared line.
+// Writers pay for this: they serialize on a mutex, announce themselves and then
+// block until the sum of every reader counter drains to zero. Readers that
+// observe a pending writer back out of their counter and queue up behind the
+// writer on the same mutex.
+//
+// The lock does not support priority inheritance or ReadUpgrade, and readers
+// are allowed to block whilst holding it. Because the number of readers is only
+// known as a sum, a reader may release the lock from a different CPU than the
+// one it acquired it on.
+class TA_CAP("mutex") BrwLockPercpu {
+ public:
+  constexpr BrwLockPercpu() = default;
+  ~BrwLockPercpu();
+
+  void ReadAcquire() TA_ACQ_SHARED() {
+    DEBUG_ASSERT(!arch_blocking_disallowed());
+    canary_.Assert();
+    // Preemption stays disabled between the increment and the writer check so
+    // that backing out touches the same counter as the increment did.
+    Thread::Current::preemption_state().PreemptDisable();
+    ktl::atomic<int64_t>& count = LocalCount();
+    count.fetch_add(1, ktl::memory_order_seq_cst);
+    if (unlikely(writer_.load(ktl::memory_order_seq_cst))) {
+      ContendedReadAcquire(count);
+      return;
+    }
+    Thread::Current::preemption_state().PreemptReenable();
+  }
+
+  void ReadRelease() TA_REL_SHARED() {
+    canary_.Assert();
+    LocalCount().fetch_sub(1, ktl::memory_order_seq_cst);
+    // Pairs with the store to |writer_| in WriteAcquire. Either the writer sees
+    // this decrement when it sums the counters, or we see the writer here.
+    if (unlikely(writer_.load(ktl::memory_order_seq_cst))) {
+      drained_.Signal();
+    }
+  }
+
+  void WriteAcquire() TA_ACQ();
+  void WriteRelease() TA_REL();
+
+  // suppress default constructors
+  DISALLOW_COPY_ASSIGN_AND_MOVE(BrwLockPercpu);
+
+  // Tag structs needed for linking BrwLockPercpu acquisition options to the
+  // different policy structures. See LOCK_DEP_POLICY_OPTION usage below.
+  struct Reader {};
+  struct Writer {};
+
+  struct ReaderPolicy {
+    struct State {};
+    // This will be seen by Guard to know to generate shared acquisitions for thread analysis.
+    struct Shared {};
+
+    using ValidationGuard = LockValidationGuard;
+
+    static void PreValidate(BrwLockPercpu*, State*) {}
+    static bool Acquire(BrwLockPercpu* lock, State*) TA_ACQ_SHARED(lock) {
+      lock->ReadAcquire();
+      return true;
+    }
+    static void Release(BrwLockPercpu* lock, State*) TA_REL_SHARED(lock) { lock->ReadRelease(); }
+  };
+
+  struct WriterPolicy {
+    struct State {};
+
+    using ValidationGuard = LockValidationGuard;
+
+    static void PreValidate(BrwLockPercpu*, State*) {}
+    static bool Acquire(BrwLockPercpu* lock, State*) TA_ACQ(lock) {
+      lock->WriteAcquire();
+      return true;
+    }
+    static void Release(BrwLockPercpu* lock, State*) TA_REL(lock) { lock->WriteRelease(); }
+  };
+
+ private:
+  // CPUs share reader counters once there are more of them than slots, which
+  // bounds the size of the lock independently of SMP_MAX_CPUS.
+  static constexpr size_t kReaderSlots = 8;
+
+  struct alignas(MAX_CACHE_LINE) ReaderSlot {
+    ktl::atomic<int64_t> count{0};
+  };
+
+  ktl::atomic<int64_t>& LocalCount() {
+    return reader_slots_[arch_curr_cpu_num() % kReaderSlots].count;
+  }
+
+  int64_t ReaderCount() const;
+
+  // Entered with preemption disabled and |count| already incremented.
+  void ContendedReadAcquire(ktl::atomic<int64_t>& count);
+
+  fbl::Canary<fbl::magic("RWLP")> canary_;
+  ktl::atomic<bool> writer_{false};
+  // Serializes writers, and readers that found a writer pending.
+  Mutex writer_lock_;
+  // Signaled by readers that release the lock while a writer is pending.
+  AutounsignalEvent drained_;
+  ReaderSlot reader_slots_[kReaderSlots];
+};
+
+// Configure fbl::Guard<BrwLockPercpu, BrwLockPercpu::Writer> write locks through the given policy.
+LOCK_DEP_POLICY_OPTION(BrwLockPercpu, BrwLockPercpu::Writer, BrwLockPercpu::WriterPolicy);
+// Configure fbl::Guard<BrwLockPercpu, BrwLockPercpu::Reader> read locks through the given policy.
+LOCK_DEP_POLICY_OPTION(BrwLockPercpu, BrwLockPercpu::Reader, BrwLockPercpu::ReaderPolicy);
+
 }  // namespace internal
 
 #ifdef __riscv
@@ -332,4 +449,11 @@ using BrwLockNoPi = internal::BrwLockNoPi;
 #define DECLARE_SINGLETON_BRWLOCK_NO_PI(name, ...) \
   LOCK_DEP_SINGLETON_LOCK(name, BrwLockNoPi, ##__VA_ARGS__)
 
+using BrwLockPercpu = internal::BrwLockPercpu;
+
+#define DECLARE_BRWLOCK_PERCPU(container_type, ...) \
+  LOCK_DEP_INSTRUMENT(container_type, BrwLockPercpu, ##__VA_ARGS__)
+#define DECLARE_SINGLETON_BRWLOCK_PERCPU(name, ...) \
+  LOCK_DEP_SINGLETON_LOCK(name, BrwLockPercpu, ##__VA_ARGS__)
+
 #endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_BRWLOCK_H_
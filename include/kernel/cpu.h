@@ -7,57 +7,275 @@
 #ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_CPU_H_
 #define ZIRCON_KERNEL_INCLUDE_KERNEL_CPU_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
+#include <ktl/atomic.h>
+#include <ktl/bit.h>
 #include <ktl/limits.h>
 
 // types and routines for dealing with lists of cpus and cpu masks
 
-using cpu_mask_t = uint32_t;
 using cpu_num_t = uint32_t;
 
-static_assert(SMP_MAX_CPUS <= sizeof(cpu_mask_t) * CHAR_BIT);
+// CpuMask is a fixed size bitset with one bit per possible CPU, sized by SMP_MAX_CPUS.
+//
+// It is a value type with the usual bitwise operators. Contextual conversion to bool tests whether
+// any CPU is set, so that expressions such as |if (mask & cpu_num_to_mask(cpu))| read the same as
+// they would for an integer mask. When SMP_MAX_CPUS is at most 64 the mask is a single word and all
+// operations compile to the equivalent scalar instructions.
+class CpuMask {
+ public:
+  using Word = uint64_t;
+  static constexpr size_t kBitsPerWord = ktl::numeric_limits<Word>::digits;
+  static constexpr size_t kWords = (SMP_MAX_CPUS + kBitsPerWord - 1) / kBitsPerWord;
+  static constexpr size_t kBits = kWords * kBitsPerWord;
+
+  constexpr CpuMask() = default;
+
+  // Returns a mask with every bit set, including any bits beyond SMP_MAX_CPUS.
+  static constexpr CpuMask All() {
+    CpuMask mask;
+    for (Word& word : mask.words_) {
+      word = ~Word{0};
+    }
+    return mask;
+  }
+
+  // Returns a mask with the CPUs [0, count) set.
+  static constexpr CpuMask FirstN(size_t count) {
+    CpuMask mask;
+    for (size_t i = 0; i < kWords && count > 0; i++) {
+      const size_t bits = count < kBitsPerWord ? count : kBitsPerWord;
+      mask.words_[i] = bits == kBitsPerWord ? ~Word{0} : (Word{1} << bits) - 1;
+      count -= bits;
+    }
+    return mask;
+  }
+
+  // Returns a mask with the low word set to |word|.
+  static constexpr CpuMask FromWord(Word word) { return FromWords(&word, 1); }
+
+  // Returns a mask built from the given words, starting at CPU 0. Words past kWords are ignored and
+  // missing words are treated as zero. Used for converting to and from ABI CPU sets.
+  static constexpr CpuMask FromWords(const Word* words, size_t count) {
+    CpuMask mask;
+    for (size_t i = 0; i < kWords && i < count; i++) {
+      mask.words_[i] = words[i];
+    }
+    return mask;
+  }
+
+  constexpr Word word(size_t index) const { return index < kWords ? words_[index] : 0; }
+
+  constexpr bool test(cpu_num_t cpu) const {
+    return cpu < kBits && (words_[cpu / kBitsPerWord] & BitFor(cpu)) != 0;
+  }
+  constexpr CpuMask& set(cpu_num_t cpu) {
+    if (cpu < kBits) {
+      words_[cpu / kBitsPerWord] |= BitFor(cpu);
+    }
+    return *this;
+  }
+  constexpr CpuMask& reset(cpu_num_t cpu) {
+    if (cpu < kBits) {
+      words_[cpu / kBitsPerWord] &= ~BitFor(cpu);
+    }
+    return *this;
+  }
+
+  constexpr bool any() const {
+    for (Word word : words_) {
+      if (word != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+  constexpr bool none() const { return !any(); }
+  constexpr explicit operator bool() const { return any(); }
+
+  // Returns the number of CPUs in the mask.
+  constexpr size_t count() const {
+    size_t total = 0;
+    for (Word word : words_) {
+      total += ktl::popcount(word);
+    }
+    return total;
+  }
+
+  // Returns the lowest/highest CPU in the mask, or kBits if the mask is empty.
+  constexpr cpu_num_t lowest() const {
+    for (size_t i = 0; i < kWords; i++) {
+      if (words_[i] != 0) {
+        return static_cast<cpu_num_t>(i * kBitsPerWord + ktl::countr_zero(words_[i]));
+      }
+    }
+    return kBits;
+  }
+  constexpr cpu_num_t highest() const {
+    for (size_t i = kWords; i > 0; i--) {
+      if (words_[i - 1] != 0) {
+        return static_cast<cpu_num_t>(i * kBitsPerWord - 1 - ktl::countl_zero(words_[i - 1]));
+      }
+    }
+    return kBits;
+  }
+
+  constexpr CpuMask operator~() const {
+    CpuMask result;
+    for (size_t i = 0; i < kWords; i++) {
+      result.words_[i] = ~words_[i];
+    }
+    return result;
+  }
+  constexpr CpuMask& operator|=(const CpuMask& other) {
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i] |= other.words_[i];
+    }
+    return *this;
+  }
+  constexpr CpuMask& operator&=(const CpuMask& other) {
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i] &= other.words_[i];
+    }
+    return *this;
+  }
+  constexpr CpuMask& operator^=(const CpuMask& other) {
+    for (size_t i = 0; i < kWords; i++) {
+      words_[i] ^= other.words_[i];
+    }
+    return *this;
+  }
+  friend constexpr CpuMask operator|(CpuMask lhs, const CpuMask& rhs) { return lhs |= rhs; }
+  friend constexpr CpuMask operator&(CpuMask lhs, const CpuMask& rhs) { return lhs &= rhs; }
+  friend constexpr CpuMask operator^(CpuMask lhs, const CpuMask& rhs) { return lhs ^= rhs; }
+  friend constexpr bool operator==(const CpuMask& lhs, const CpuMask& rhs) {
+    for (size_t i = 0; i < kWords; i++) {
+      if (lhs.words_[i] != rhs.words_[i]) {
+        return false;
+      }
+    }
+    return true;
+  }
+  friend constexpr bool operator!=(const CpuMask& lhs, const CpuMask& rhs) { return !(lhs == rhs); }
+
+ private:
+  friend class AtomicCpuMask;
+
+  static constexpr Word BitFor(cpu_num_t cpu) { return Word{1} << (cpu % kBitsPerWord); }
+
+  Word words_[kWords] = {};
+};
+
+// An atomic CpuMask with the subset of the ktl::atomic interface used for CPU masks.
+//
+// Each word of the mask is updated with its own atomic operation, which is exactly equivalent to a
+// scalar atomic when the mask is a single word. For multi-word masks the value returned from a
+// read-modify-write is assembled from the previous value of the modified words and a load of the
+// others, and is not a snapshot of the entire mask. With the default seq_cst ordering this still
+// guarantees that, of several CPUs concurrently setting (or clearing) their own bits, at least the
+// last to do so observes the fully set (or cleared) result.
+class AtomicCpuMask {
+ public:
+  constexpr AtomicCpuMask() = default;
+  explicit AtomicCpuMask(const CpuMask& initial) { store(initial, ktl::memory_order_relaxed); }
+  AtomicCpuMask(const AtomicCpuMask&) = delete;
+  AtomicCpuMask& operator=(const AtomicCpuMask&) = delete;
+
+  CpuMask load(ktl::memory_order order = ktl::memory_order_seq_cst) const {
+    CpuMask result;
+    for (size_t i = 0; i < CpuMask::kWords; i++) {
+      result.words_[i] = words_[i].load(order);
+    }
+    return result;
+  }
+  void store(const CpuMask& value, ktl::memory_order order = ktl::memory_order_seq_cst) {
+    for (size_t i = 0; i < CpuMask::kWords; i++) {
+      words_[i].store(value.words_[i], order);
+    }
+  }
+  CpuMask exchange(const CpuMask& value, ktl::memory_order order = ktl::memory_order_seq_cst) {
+    CpuMask result;
+    for (size_t i = 0; i < CpuMask::kWords; i++) {
+      result.words_[i] = words_[i].exchange(value.words_[i], order);
+    }
+    return result;
+  }
+  CpuMask fetch_or(const CpuMask& value, ktl::memory_order order = ktl::memory_order_seq_cst) {
+    CpuMask result;
+    for (size_t i = 0; i < CpuMask::kWords; i++) {
+      result.words_[i] = value.words_[i] != 0 ? words_[i].fetch_or(value.words_[i], order)
+                                              : words_[i].load(order);
+    }
+    return result;
+  }
+  CpuMask fetch_and(const CpuMask& value, ktl::memory_order order = ktl::memory_order_seq_cst) {
+    CpuMask result;
+    for (size_t i = 0; i < CpuMask::kWords; i++) {
+      result.words_[i] = value.words_[i] != ~CpuMask::Word{0}
+                             ? words_[i].fetch_and(value.words_[i], order)
+                             : words_[i].load(order);
+    }
+    return result;
+  }
+
+  // Single CPU accessors; these touch only the word containing |cpu|.
+  bool test(cpu_num_t cpu, ktl::memory_order order = ktl::memory_order_seq_cst) const {
+    return cpu < CpuMask::kBits &&
+           (words_[cpu / CpuMask::kBitsPerWord].load(order) & CpuMask::BitFor(cpu)) != 0;
+  }
+
+ private:
+  ktl::atomic<CpuMask::Word> words_[CpuMask::kWords] = {};
+};
+
+using cpu_mask_t = CpuMask;
+
+static_assert(SMP_MAX_CPUS <= CpuMask::kBits);
 
 constexpr cpu_num_t INVALID_CPU = -1;
-constexpr cpu_mask_t CPU_MASK_ALL = -1;
+// Every CPU the kernel can run on. This deliberately excludes the bits beyond SMP_MAX_CPUS that
+// |CpuMask::All| sets, as this is the default thread affinity and is reported to userspace.
+constexpr cpu_mask_t CPU_MASK_ALL = CpuMask::FirstN(SMP_MAX_CPUS);
 
 constexpr bool is_valid_cpu_num(cpu_num_t num) { return (num < SMP_MAX_CPUS); }
 
 constexpr cpu_mask_t cpu_num_to_mask(cpu_num_t num) {
   if (!is_valid_cpu_num(num)) {
-    return 0;
+    return {};
   }
 
-  return (static_cast<cpu_mask_t>(1u) << num);
+  return CpuMask{}.set(num);
 }
 
 constexpr cpu_mask_t mask_all_but_one(cpu_num_t num) { return CPU_MASK_ALL ^ cpu_num_to_mask(num); }
 
 constexpr cpu_num_t highest_cpu_set(cpu_mask_t mask) {
-  if (mask == 0) {
+  if (!mask) {
     return 0;
   }
 
-  return static_cast<cpu_num_t>((sizeof(cpu_mask_t) * CHAR_BIT) - 1) - __builtin_clz(mask);
+  return mask.highest();
 }
 
 constexpr cpu_num_t lowest_cpu_set(cpu_mask_t mask) {
-  if (mask == 0) {
+  if (!mask) {
     return 0;
   }
 
-  return static_cast<cpu_num_t>(__builtin_ctz(mask));
+  return mask.lowest();
 }
 
 // Removes one CPU from the mask and returns its ID.
 //
 // Returns INVALID_CPU if the mask is empty.
 constexpr cpu_num_t remove_cpu_from_mask(cpu_mask_t& mask) {
-  if (mask == 0) {
+  if (!mask) {
     return INVALID_CPU;
   }
-  cpu_num_t index_of_lowest_set_bit = __builtin_ffsl(mask) - 1;
-  mask &= ~cpu_num_to_mask(index_of_lowest_set_bit);
+  cpu_num_t index_of_lowest_set_bit = mask.lowest();
+  mask.reset(index_of_lowest_set_bit);
   return index_of_lowest_set_bit;
 }
 
@@ -52,6 +52,23 @@ class CpuSearchSet {
     return cluster_set_.cpu_to_cluster_map[this_cpu_].cluster->id;
   }
 
+  // Returns the number of logical clusters, which is zero until auto-clustering
+  // has run.
+  static size_t cluster_count() { return cluster_set_.clusters.size(); }
+
+  // Returns the logical CPU ids of the members of the given logical cluster.
+  static ktl::span<const cpu_num_t> cluster_members(size_t cluster) {
+    DEBUG_ASSERT(cluster < cluster_count());
+    const fbl::Vector<cpu_num_t>& members = cluster_set_.clusters[cluster].members;
+    return ktl::span{members.begin(), members.size()};
+  }
+
+  // Returns the mask of the members of the given logical cluster.
+  static cpu_mask_t cluster_mask(size_t cluster) {
+    DEBUG_ASSERT(cluster < cluster_count());
+    return cluster_set_.clusters[cluster].mask;
+  }
+
   // Sets the relative performance scale for the given CPU.
   static void SetPerfScale(cpu_num_t cpu, int64_t perf_scale) {
     DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
@@ -102,6 +119,7 @@ class CpuSearchSet {
   struct Cluster {
     size_t id{0};
     fbl::Vector<cpu_num_t> members{};
+    cpu_mask_t mask{};
   };
 
   // Entry type for the logical CPU id to cluster map.
@@ -0,0 +1,60 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_DEADLINE_ADMISSION_H_
+#define ZIRCON_KERNEL_INCLUDE_KERNEL_DEADLINE_ADMISSION_H_
+
+#include <lib/zx/result.h>
+
+#include <kernel/cpu.h>
+#include <kernel/scheduler_state.h>
+
+// Admission control for deadline profiles applied by userspace.
+//
+// Each admitted deadline thread reserves its utilization on a single CPU in its
+// affinity set. A CPU accepts reservations up to its current processing rate
+// scaled by kernel.scheduler.deadline-admission-limit, so the deadline threads
+// admitted to it cannot overcommit it. Threads are reserved on the CPU with the
+// most remaining capacity, spreading the load over the affinity set.
+//
+// Reservations are bookkeeping only: the scheduler still places and migrates
+// deadline threads as usual. Kernel threads given deadline profiles directly are
+// not subject to admission.
+class DeadlineAdmission {
+ public:
+  // The utilization reserved for one thread, or an empty reservation.
+  struct Reservation {
+    bool is_valid() const { return cpu != INVALID_CPU; }
+
+    cpu_num_t cpu{INVALID_CPU};
+    SchedUtilization utilization{0};
+  };
+
+  // Returns true if admission control is enabled.
+  static bool IsEnabled();
+
+  // Reserves |utilization| on a CPU in |affinity| in place of |current|, whose
+  // capacity is available to the new reservation. On success, |current| is
+  // released; on failure, it is kept.
+  //
+  // Returns ZX_ERR_NO_RESOURCES if no CPU in |affinity| has enough capacity
+  // left, or ZX_ERR_INVALID_ARGS if |affinity| contains no active CPU.
+  static zx::result<Reservation> Admit(SchedUtilization utilization, cpu_mask_t affinity,
+                                       const Reservation& current);
+
+  // Releases |reservation|, if it is valid.
+  static void Release(const Reservation& reservation);
+
+  // Returns the utilization that may still be admitted to |cpu|, which may be
+  // negative if the CPU's processing rate dropped after reservations were made.
+  static SchedUtilization RemainingCapacity(cpu_num_t cpu);
+
+  // Returns the largest utilization that a single thread with |affinity| could
+  // be admitted with right now.
+  static SchedUtilization RemainingCapacity(cpu_mask_t affinity);
+};
+
+#endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_DEADLINE_ADMISSION_H_
@@ -10,16 +10,17 @@
 #include <zircon/compiler.h>
 #include <zircon/types.h>
 
-#include <fbl/intrusive_double_list.h>
 #include <kernel/event.h>
+#include <kernel/spinlock.h>
 #include <kernel/thread.h>
+#include <ktl/atomic.h>
 
 // Deferred Procedure Calls - queue callback to invoke on the current cpu in thread context.
 // Dpcs are executed with interrupts enabled, and do not ever migrate cpus while executing.
 // A Dpc may not execute on the original current cpu if it is hotunplugged/offlined.
 // Dpcs may block, though this may starve other queued work.
 
-class Dpc : public fbl::DoublyLinkedListable<Dpc*, fbl::NodeOptions::AllowCopyMove> {
+class Dpc {
  public:
   using Func = void(Dpc*);
 
@@ -27,24 +28,29 @@ class Dpc : public fbl::DoublyLinkedListable<Dpc*, fbl::NodeOptions::AllowCopyMo
     DEBUG_ASSERT(func_ != nullptr);
   }
 
+  // A copy is never queued, even if |other| is.  The worker runs a copy of each Dpc so that the
+  // original may be requeued, or destroyed, by its own callback.
+  Dpc(const Dpc& other) : func_(other.func_), arg_(other.arg_) {}
+  Dpc& operator=(const Dpc&) = delete;
+
   template <class ArgType>
   ArgType* arg() {
     return static_cast<ArgType*>(arg_);
   }
 
-  // A single spinlock protects the data members of all DpcRunners.
-  //
-  // Take care to drop this lock before calling any code that might acquire a chainlock.
-  DECLARE_SINGLETON_SPINLOCK(Lock);
-
  private:
   friend class DpcRunner;
 
   // Called by DpcRunner.
-  void Invoke() TA_EXCL(Dpc::Lock::Get());
+  void Invoke() { func_(this); }
 
   Func* const func_;
   void* const arg_;
+
+  // Set by the Enqueue that claims this Dpc and cleared by the worker once it has copied it.
+  // While set, |next_| belongs to the queue the Dpc is on.
+  ktl::atomic<bool> queued_{false};
+  Dpc* next_ = nullptr;
 };
 
 // A DpcRunner is responsible for running queued Dpcs.  Under the hood, a given runner may manage
@@ -105,7 +111,9 @@ class DpcRunner {
 
   // Enqueue |dpc| in the specified queue |type| and signal its worker thread to execute it.
   //
-  // |Enqueue| will not block, but it may wait briefly for a spinlock.
+  // |Enqueue| will not block or take any locks.  It publishes |dpc| on the current cpu's queue
+  // with a single compare-and-swap, so cpus queueing Dpcs concurrently do not contend with each
+  // other.
   //
   // |Enqueue| may return before or after the Dpc has executed.  It is the
   // caller's responsibility to ensure that a queued Dpc object is not destroyed
@@ -124,6 +132,10 @@ class DpcRunner {
   // Queue encapsulates a list of Dpc tasks and a thread that pops tasks off the list and executes
   // them in order.
   //
+  // The list is a multi-producer, single-consumer stack.  Producers push onto |head_| without
+  // locking.  The worker takes the whole stack at once and reverses it into |pending_| so that
+  // Dpcs still run in the order they were queued.
+  //
   // A Queue must be initialized (|Init|) prior to use.  A Queue that's been initialized must be
   // |Shutdown| before it may be reinitialized.
   class Queue {
@@ -134,7 +146,7 @@ class DpcRunner {
     void Init(cpu_num_t cpu, const char* name_prefix, const SchedulerState::BaseProfile& profile);
 
     // Begins the shutdown process for this Queue.  After a successful |Shutdown|, this Queue's
-    // remaining contents should be moved into elsewhere by calling |TakeFromLocked| on another
+    // remaining contents should be moved into elsewhere by calling |TakeFrom| on another
     // Queue.
     //
     // Signals the worker thread to terminate and waits until it has terminated or |deadline| is
@@ -142,24 +154,35 @@ class DpcRunner {
     zx_status_t Shutdown(zx_instant_mono_t deadline);
 
     // Moves any queued Dpcs from |source| to |this|.  May only be called after a successful
-    // |Shutdown| of |source|.
-    void TakeFromLocked(Queue& source) TA_REQ(Dpc::Lock::Get());
+    // |Shutdown| of |source|.  Returns true if the caller must |Signal| this Queue.
+    bool TakeFrom(Queue& source);
 
-    void EnqueueLocked(Dpc& dpc) TA_REQ(Dpc::Lock::Get());
-    void Signal() TA_EXCL(Dpc::Lock::Get());
+    // Pushes |dpc|, which must already be claimed, onto the stack.  Returns true if the stack was
+    // empty, in which case the caller must |Signal| the worker.
+    bool Push(Dpc& dpc) { return PushChain(&dpc, &dpc); }
+    void Signal() { event_.Signal(); }
 
    private:
     int DoWork();
 
+    // Pushes the chain |first| -> ... -> |last|, linked through |next_|, onto the stack so that
+    // |last| is the first of them to run.  Returns true if the stack was empty.
+    bool PushChain(Dpc* first, Dpc* last);
+
     // Request the thread_ to stop by setting to true.
-    //
-    // This guarded by the static global dpc_lock.
-    bool stop_ TA_GUARDED(Dpc::Lock::Get()) = false;
+    ktl::atomic<bool> stop_{false};
+
+    // The most recently queued Dpc.  Each Dpc's |next_| points at the one queued before it.
+    ktl::atomic<Dpc*> head_{nullptr};
+
+    // Dpcs the worker has taken from |head_| but not yet run, oldest first.  Only the worker
+    // touches this, except after a successful |Shutdown|.
+    Dpc* pending_ = nullptr;
 
-    fbl::DoublyLinkedList<Dpc*> list_ TA_GUARDED(Dpc::Lock::Get());
+    DECLARE_SPINLOCK(DpcRunner::Queue) lock_;
 
-    // The thread that executes DPCs queued in list_.
-    Thread* thread_ TA_GUARDED(Dpc::Lock::Get()) = nullptr;
+    // The thread that executes DPCs queued in this Queue.
+    Thread* thread_ TA_GUARDED(lock_) = nullptr;
 
     Event event_;
   };
@@ -167,11 +190,16 @@ class DpcRunner {
   static int WorkerThread(void* unused);
   int Work();
 
+  // Protects this DpcRunner's ownership.  The Dpc queues themselves are lock-free.
+  //
+  // Take care to drop this lock before calling any code that might acquire a chainlock.
+  DECLARE_SPINLOCK(DpcRunner, lockdep::LockFlagsNestable) lock_;
+
   // The cpu that owns this DpcRunner.
-  cpu_num_t cpu_ TA_GUARDED(Dpc::Lock::Get()) = INVALID_CPU;
+  cpu_num_t cpu_ TA_GUARDED(lock_) = INVALID_CPU;
 
   // Whether the DpcRunner has been initialized for the owning cpu.
-  bool initialized_ TA_GUARDED(Dpc::Lock::Get()) = false;
+  bool initialized_ TA_GUARDED(lock_) = false;
 
   Queue queue_general_;
   Queue queue_low_latency_;
@@ -0,0 +1,80 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_LOAD_AVERAGE_H_
+#define ZIRCON_KERNEL_INCLUDE_KERNEL_LOAD_AVERAGE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+
+#include <ktl/array.h>
+
+// Scheduler load averages are exponentially weighted moving averages of a per-CPU quantity, such
+// as the number of runnable threads, over windows of 1, 10, and 60 seconds. They are fixed point
+// values with kLoadAverageShift fractional bits, updated once per kLoadAveragePeriod with the
+// mean of the quantity over the period.
+inline constexpr size_t kLoadAverageWindows = 3;
+inline constexpr zx_duration_mono_t kLoadAveragePeriod = ZX_MSEC(100);
+inline constexpr int kLoadAverageShift = 16;
+inline constexpr int64_t kLoadAverageOne = int64_t{1} << kLoadAverageShift;
+
+// A tickless idle CPU may take no interrupts for a long time, during which its published averages
+// would go stale. While any of its averages is nonzero, the CPU keeps a timer armed to refresh
+// them, starting kLoadAverageMinRefresh after it last ran a thread and backing off to
+// kLoadAverageMaxRefresh. This bounds the staleness of an idle CPU's averages to
+// kLoadAverageMaxRefresh, and the extra wakeups to the hundred or so it takes the 60 second
+// average to decay to zero.
+inline constexpr zx_duration_mono_t kLoadAverageMinRefresh = ZX_SEC(1);
+inline constexpr zx_duration_mono_t kLoadAverageMaxRefresh = ZX_SEC(8);
+
+// exp(-kLoadAveragePeriod / window) for each of the windows.
+inline constexpr ktl::array<int64_t, kLoadAverageWindows> kLoadAverageDecay{59299, 64884, 65427};
+
+// Returns |factor|^|n| for a fixed point |factor| between zero and one.
+constexpr int64_t LoadAverageDecayPow(int64_t factor, uint64_t n) {
+  int64_t result = kLoadAverageOne;
+  while (n != 0 && result != 0) {
+    if (n & 1) {
+      result = (result * factor) >> kLoadAverageShift;
+    }
+    factor = (factor * factor) >> kLoadAverageShift;
+    n >>= 1;
+  }
+  return result;
+}
+
+// Returns |average| updated for |periods| periods during which the quantity averaged |sample|.
+constexpr int64_t LoadAverageUpdate(int64_t average, int64_t sample, int64_t decay,
+                                    uint64_t periods) {
+  return sample + (average - sample) * LoadAverageDecayPow(decay, periods) / kLoadAverageOne;
+}
+
+// Returns the fixed point mean of a quantity whose integral over |period_ns| is |sum_ns|.
+constexpr int64_t LoadAverageSample(int64_t sum_ns, zx_duration_mono_t period_ns) {
+  // Scale down very long periods, such as a long idle period, to avoid overflow.
+  while (period_ns > ZX_TIME_INFINITE / kLoadAverageOne) {
+    sum_ns >>= 1;
+    period_ns >>= 1;
+  }
+  return (sum_ns / period_ns) * kLoadAverageOne +
+         (sum_ns % period_ns) * kLoadAverageOne / period_ns;
+}
+
+static_assert(LoadAverageDecayPow(kLoadAverageDecay[0], 0) == kLoadAverageOne);
+static_assert(LoadAverageUpdate(kLoadAverageOne, kLoadAverageOne, kLoadAverageDecay[2], 7) ==
+              kLoadAverageOne);
+static_assert(LoadAverageUpdate(0, kLoadAverageOne, kLoadAverageDecay[2], 1'000'000) ==
+              kLoadAverageOne);
+static_assert(LoadAverageUpdate(4 * kLoadAverageOne, 0, kLoadAverageDecay[0], 1'000) == 0);
+// One window's worth of periods covers about 1 - 1/e of the distance to the sample.
+static_assert(LoadAverageUpdate(0, kLoadAverageOne, kLoadAverageDecay[0], 10) > 41000);
+static_assert(LoadAverageUpdate(0, kLoadAverageOne, kLoadAverageDecay[0], 10) < 42000);
+static_assert(LoadAverageSample(ZX_MSEC(150), ZX_MSEC(100)) == kLoadAverageOne * 3 / 2);
+static_assert(LoadAverageSample(ZX_HOUR(100), ZX_HOUR(200)) == kLoadAverageOne / 2);
+
+#endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_LOAD_AVERAGE_H_
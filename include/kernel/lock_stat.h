@@ -0,0 +1,79 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_LOCK_STAT_H_
+#define ZIRCON_KERNEL_INCLUDE_KERNEL_LOCK_STAT_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <zircon/time.h>
+#include <zircon/types.h>
+
+#include <kernel/lockdep.h>
+#include <ktl/atomic.h>
+
+// Lock contention statistics, enabled by kernel.lock-stats.
+//
+// Statistics are aggregated per lockdep lock class into per-CPU buckets, so
+// recording them never bounces a shared cache line between CPUs. For each class
+// they count acquires and contended acquires, and track the total time spent
+// waiting for contended acquires and the longest time the lock was held.
+//
+// Locks learn their class from lockdep through SetLockClassId, which happens in
+// every build, instrumented or not. Locks that are not declared through lockdep
+// are recorded under kUnknownClass.
+namespace lock_stat {
+
+// Index of a lock class in the statistics table.
+using ClassIndex = uint16_t;
+
+// Used for locks with no lockdep class, and for classes that did not fit in the
+// table.
+inline constexpr ClassIndex kUnknownClass = 0;
+
+// The number of lock classes that can be tracked, including kUnknownClass.
+inline constexpr size_t kMaxClasses = 256;
+
+namespace internal {
+// Set during init when kernel.lock-stats is enabled.
+extern ktl::atomic<bool> gEnabled;
+}  // namespace internal
+
+// Returns whether statistics are being recorded.
+inline bool Enabled() { return internal::gEnabled.load(ktl::memory_order_acquire); }
+
+// Returns the table index of the lockdep class |lcid|, adding it to the table on
+// first use. This never blocks and is safe to call from global constructors.
+ClassIndex Register(lockdep::LockClassId lcid);
+
+// Records an acquire of a lock of class |index| which waited |wait_ticks| for
+// the lock if it was |contended|.
+void RecordAcquire(ClassIndex index, bool contended, zx_duration_mono_ticks_t wait_ticks);
+
+// Records that a lock of class |index| was held for |hold_ticks|.
+void RecordHold(ClassIndex index, zx_duration_mono_ticks_t hold_ticks);
+
+// Totals of the per-CPU statistics of one lock class.
+struct ClassStats {
+  uint64_t acquires;
+  uint64_t contended;
+  zx_duration_mono_t total_wait;
+  zx_duration_mono_t max_hold;
+};
+
+// Sums the statistics of class |index| across all CPUs. Returns false if the
+// class is not in use.
+bool GetClassStats(ClassIndex index, ClassStats* stats);
+
+// Returns the name of class |index|, or "<unknown>".
+const char* ClassName(ClassIndex index);
+
+// Zeroes every statistic while leaving the classes registered.
+void Reset();
+
+}  // namespace lock_stat
+
+#endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_LOCK_STAT_H_
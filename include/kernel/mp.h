@@ -93,4 +93,17 @@ void mp_signal_curr_cpu_ready();
 // timeout.
 zx_status_t mp_wait_for_all_cpus_ready(Deadline deadline);
 
+// The stages of secondary CPU start-up that are timestamped for the boot timeline. START is
+// recorded by the CPU starting the secondary, just before it is told to start, and the others by
+// the secondary itself. Once all CPUs are ready the slowest CPU of each stage is reported, and the
+// per-CPU times are available with the `mp boot` console command.
+enum class mp_boot_stage : uint8_t {
+  START,       // The secondary was told to start.
+  EARLY_INIT,  // The arch code finished its early init and per-CPU init up to threading.
+  LATE_INIT,   // The per-CPU init hooks from threading on finished.
+  READY,       // The secondary declared itself ready, see mp_signal_curr_cpu_ready().
+  COUNT_,
+};
+void mp_record_boot_stage(cpu_num_t cpu, mp_boot_stage stage);
+
 #endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_MP_H_
@@ -19,6 +19,7 @@
 
 #include <fbl/canary.h>
 #include <fbl/macros.h>
+#include <kernel/lock_stat.h>
 #include <kernel/lock_validation_guard.h>
 #include <kernel/lockdep.h>
 #include <kernel/owned_wait_queue.h>
@@ -86,6 +87,13 @@ class TA_CAP("mutex") Mutex
   // Mutex and have yet to enter a blocking phase.
   bool IsContested() const { return val() & STATE_FLAG_CONTESTED; }
 
+  // Called by lockdep with the class of the lock. Besides naming the lock in
+  // traces, this selects where lock_stat records its statistics.
+  void SetLockClassId(lockdep::LockClassId lcid) {
+    LockNameStorage::SetLockClassId(lcid);
+    lock_stat_class_ = lock_stat::Register(lcid);
+  }
+
  protected:
   // TimesliceExtension is used to control whether a timeslice extension will be
   // set and if so, what value will be used.
@@ -145,6 +153,14 @@ class TA_CAP("mutex") Mutex
     maybe_acquired_on_cpu_.store(INVALID_CPU, ktl::memory_order_relaxed);
   }
 
+  // Returns how long a contended acquire should spin before blocking, given the
+  // caller's |spin_max_duration|. See |spin_budget_ns_|.
+  zx_duration_t SpinBudget(zx_duration_t spin_max_duration) const;
+
+  // Moves the learned spin budget towards |sample|, keeping it within
+  // [spin_max_duration / 8, spin_max_duration].
+  void UpdateSpinBudget(zx_duration_t spin_max_duration, zx_duration_t sample);
+
   static constexpr uint32_t MAGIC = 0x6D757478;  // 'mutx'
   static constexpr uintptr_t STATE_FREE = 0u;
   static constexpr uintptr_t STATE_FLAG_CONTESTED = 1u;
@@ -164,8 +180,18 @@ class TA_CAP("mutex") Mutex
   // this variable, and how it affects the spin phase behavior of
   // Mutex::AcquireContendedMutex
   ktl::atomic<cpu_num_t> maybe_acquired_on_cpu_{INVALID_CPU};
+
+  // When kernel.mutex.adaptive-spin is enabled, the spin budget learned from
+  // previous contended acquires of this mutex, in nanoseconds, or zero before
+  // the first one. Updates are racy, which is fine for a heuristic.
+  ktl::atomic<uint32_t> spin_budget_ns_{0};
+  // The lock_stat class of this mutex. Fits in what would otherwise be padding.
+  lock_stat::ClassIndex lock_stat_class_{lock_stat::kUnknownClass};
   ktl::atomic<uintptr_t> val_{STATE_FREE};
   OwnedWaitQueue wait_;
+  // When lock statistics are enabled, when the current holder acquired the
+  // mutex, or zero if it was acquired before they were enabled.
+  zx_instant_mono_ticks_t lock_stat_acquired_ticks_{0};
 };
 
 // TimeslicExtension specializations for Mutex::Acquire and
@@ -19,6 +19,7 @@
 #include <kernel/cpu_search_set.h>
 #include <kernel/dpc.h>
 #include <kernel/idle_power_thread.h>
+#include <kernel/koid.h>
 #include <kernel/scheduler.h>
 #include <kernel/stats.h>
 #include <kernel/thread.h>
@@ -113,6 +114,10 @@ struct percpu {
   // See |PlatformResumeState| type declaration.
   PlatformCpuResumeState resume_state;
 
+  // The KOIDs reserved by this CPU, see KernelObjectId::Generate. Only accessed by this CPU with
+  // interrupts disabled.
+  KernelObjectId::Block koid_block;
+
   // Returns a reference to the percpu instance for given CPU number.
   static percpu& Get(cpu_num_t cpu_num) {
     DEBUG_ASSERT(cpu_num < processor_count());
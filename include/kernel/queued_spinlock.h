@@ -0,0 +1,72 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_QUEUED_SPINLOCK_H_
+#define ZIRCON_KERNEL_INCLUDE_KERNEL_QUEUED_SPINLOCK_H_
+
+#include <lib/zircon-internal/thread_annotations.h>
+
+#include <arch/spinlock.h>
+#include <kernel/cpu.h>
+#include <ktl/atomic.h>
+
+// An MCS style queued implementation of arch_spin_lock_t, shared by the architectures that use it.
+//
+// The lock word keeps the owner CPU in its low 16 bits, see arch_spin_lock_holder_cpu, and the
+// high 16 bits hold the number plus one of the CPU at the tail of the queue of waiters. Each
+// waiter spins on a node of its own, and is handed the head of the queue by its predecessor, so
+// contended acquisitions are granted in FIFO order and only the head of the queue polls the lock
+// word. As spinlocks are only ever acquired with interrupts disabled, a CPU waits on at most one
+// lock at a time and a single node per CPU suffices.
+//
+// These take care of the lock word only, the callers are responsible for the per-CPU spinlock
+// count.
+//
+// A CPU that stops while queued, say because another CPU panicked and halted it, would block every
+// later acquisition of the lock. Once EnterPanicMode has been called, waiters therefore stop
+// honoring the queue and take locks whenever they have no owner, as a test-and-set lock would.
+namespace queued_spinlock {
+
+inline constexpr uint32_t kTailShift = 16;
+static_assert(SMP_MAX_CPUS < kArchSpinLockOwnerMask, "cpu numbers must fit in 16 bits");
+
+// Attempts to take |lock| for |cpu| if it is free with no waiters. This is the uncontended path.
+inline bool TryAcquireUncontended(arch_spin_lock_t* lock, cpu_num_t cpu) {
+  cpu_num_t expected = 0;
+  return lock->value.compare_exchange_strong(expected, cpu + 1, ktl::memory_order_acquire,
+                                             ktl::memory_order_relaxed);
+}
+
+// Queues |cpu| on |lock| and spins until it is acquired.
+void AcquireContended(arch_spin_lock_t* lock, cpu_num_t cpu) TA_ACQ(lock);
+
+inline void Acquire(arch_spin_lock_t* lock, cpu_num_t cpu) TA_ACQ(lock)
+    TA_NO_THREAD_SAFETY_ANALYSIS {
+  if (!TryAcquireUncontended(lock, cpu)) {
+    AcquireContended(lock, cpu);
+  }
+}
+
+// Takes |lock| for |cpu| if it is not owned, even if there are waiters, and returns true on
+// success. This only fails if the lock was observed to be owned.
+bool TryAcquire(arch_spin_lock_t* lock, cpu_num_t cpu);
+
+// Spins until |lock| has no owner and takes it for |cpu|, without queuing or waiting on any other
+// CPU's node. This is what contended acquisitions fall back to in panic mode.
+void AcquireBypassingQueue(arch_spin_lock_t* lock, cpu_num_t cpu) TA_ACQ(lock);
+
+// Makes all contended acquisitions, including those already waiting in a queue, bypass the queue
+// from now on. This is called on the panic path, before other CPUs are halted, and is never undone.
+void EnterPanicMode();
+
+inline void Release(arch_spin_lock_t* lock) TA_REL(lock) TA_NO_THREAD_SAFETY_ANALYSIS {
+  // Only clear the owner, any waiters that queued up meanwhile must be preserved.
+  lock->value.fetch_and(~kArchSpinLockOwnerMask, ktl::memory_order_release);
+}
+
+}  // namespace queued_spinlock
+
+#endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_QUEUED_SPINLOCK_H_
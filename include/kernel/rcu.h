@@ -0,0 +1,85 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_RCU_H_
+#define ZIRCON_KERNEL_INCLUDE_KERNEL_RCU_H_
+
+#include <zircon/compiler.h>
+
+#include <kernel/thread.h>
+
+// Read-copy-update style deferred reclamation.
+//
+// Readers enter a read-side critical section with an RcuReadGuard. Inside the
+// section they may follow pointers to RCU protected objects without taking the
+// lock which protects updates to those objects, and the objects will not be
+// freed until the section ends.
+//
+// Writers unpublish an object (with release semantics, so readers never see a
+// partially initialized replacement) under their usual lock, and then either
+// block in rcu::Synchronize until every pre-existing read-side section has
+// finished, or hand the object to rcu::Call to be reclaimed asynchronously.
+//
+// A read-side section is a region with preemption disabled. A CPU which has
+// context switched with preemption enabled cannot be inside a section that
+// began before the switch, so a grace period has passed once every online CPU
+// has done so. Sections must therefore be short and must not block, just like
+// any other preempt-disabled region.
+//
+// Readers must load RCU protected pointers with at least acquire semantics
+// (ktl::atomic or fbl::RefPtr loads under the guard), since there is no lock to
+// order them.
+namespace rcu {
+
+// Marks a read-side critical section for the lifetime of the guard. Guards
+// nest.
+class RcuReadGuard {
+ public:
+  RcuReadGuard() { Thread::Current::preemption_state().PreemptDisable(); }
+  ~RcuReadGuard() { Thread::Current::preemption_state().PreemptReenable(); }
+
+  RcuReadGuard(const RcuReadGuard&) = delete;
+  RcuReadGuard& operator=(const RcuReadGuard&) = delete;
+  RcuReadGuard(RcuReadGuard&&) = delete;
+  RcuReadGuard& operator=(RcuReadGuard&&) = delete;
+};
+
+// Returns true if the current thread is inside a read-side critical section, or
+// some other region in which a grace period cannot end on this CPU.
+inline bool InReadSection() { return !Thread::Current::preemption_state().PreemptIsEnabled(); }
+
+// Blocks until every read-side critical section which was in progress when
+// Synchronize was called has finished.
+//
+// Must be called from thread context with preemption enabled and without any
+// spinlocks held. Synchronize migrates the calling thread across every online
+// CPU, so prefer Call on hot paths.
+void Synchronize();
+
+// Embed an RcuHead in an object to reclaim it with Call.
+struct RcuHead {
+  using Func = void(RcuHead*);
+
+  RcuHead* next = nullptr;
+  Func* func = nullptr;
+};
+
+// Arranges for |func| to be called with |head| after a grace period has passed.
+//
+// Call never blocks and never takes a lock, so it may be called while holding
+// spinlocks or from within a read-side critical section. Callbacks run on the
+// RCU reclaimer thread in thread context, so they may free memory and drop
+// references. A single grace period is shared by every callback queued before
+// it starts.
+void Call(RcuHead* head, RcuHead::Func* func);
+
+// Blocks until every callback queued by Call before Barrier was called has run.
+// Has the same calling requirements as Synchronize.
+void Barrier();
+
+}  // namespace rcu
+
+#endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_RCU_H_
@@ -0,0 +1,60 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_KERNEL_SCHED_HISTOGRAM_H_
+#define ZIRCON_KERNEL_INCLUDE_KERNEL_SCHED_HISTOGRAM_H_
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <zircon/types.h>
+
+#include <ktl/algorithm.h>
+#include <ktl/bit.h>
+
+// Scheduler latency histograms, enabled by kernel.scheduler.latency-histograms, count durations
+// in log2 buckets of roughly microsecond granularity. Bucket 0 counts durations shorter than
+// 1024ns, bucket N counts durations in [2^(N-1) * 1024ns, 2^N * 1024ns), and the last bucket also
+// counts every longer duration.
+inline constexpr size_t kSchedHistogramBuckets = 16;
+inline constexpr int kSchedHistogramShift = 10;
+
+// Returns the bucket that counts |duration|.
+constexpr size_t SchedHistogramBucket(zx_duration_mono_t duration) {
+  if (duration <= 0) {
+    return 0;
+  }
+  const uint64_t scaled = static_cast<uint64_t>(duration) >> kSchedHistogramShift;
+  return ktl::min(static_cast<size_t>(ktl::bit_width(scaled)), kSchedHistogramBuckets - 1);
+}
+
+// Returns the shortest duration counted by |bucket|.
+constexpr zx_duration_mono_t SchedHistogramBucketStart(size_t bucket) {
+  return bucket == 0 ? 0 : zx_duration_mono_t{1} << (bucket - 1 + kSchedHistogramShift);
+}
+
+static_assert(SchedHistogramBucket(1023) == 0);
+static_assert(SchedHistogramBucket(1024) == 1);
+static_assert(SchedHistogramBucket(SchedHistogramBucketStart(5)) == 5);
+static_assert(SchedHistogramBucket(SchedHistogramBucketStart(6) - 1) == 5);
+static_assert(SchedHistogramBucket(10'000'000'000) == kSchedHistogramBuckets - 1);
+
+// Prints the non-empty buckets of |counts| on one line, each labeled with the shortest duration
+// it counts in nanoseconds.
+template <typename Counts>
+void DumpSchedHistogram(const char* name, const Counts& counts) {
+  printf("\t%s:", name);
+  for (size_t i = 0; i < kSchedHistogramBuckets; i++) {
+    if (counts[i] != 0) {
+      printf(" %" PRIi64 "%s=%" PRIu64, SchedHistogramBucketStart(i),
+             i == kSchedHistogramBuckets - 1 ? "+" : "", static_cast<uint64_t>(counts[i]));
+    }
+  }
+  printf("\n");
+}
+
+#endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_SCHED_HISTOGRAM_H_
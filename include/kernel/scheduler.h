@@ -25,6 +25,7 @@
 #include <fbl/wavl_tree_augmented_invariant_observer.h>
 #include <ffl/fixed.h>
 #include <kernel/dpc.h>
+#include <kernel/load_average.h>
 #include <kernel/mp.h>
 #include <kernel/owned_wait_queue.h>
 #include <kernel/scheduler_state.h>
@@ -32,6 +33,7 @@
 #include <kernel/thread.h>
 #include <kernel/wait.h>
 #include <ktl/algorithm.h>
+#include <ktl/array.h>
 #include <ktl/optional.h>
 #include <ktl/utility.h>
 
@@ -113,9 +115,50 @@ class Scheduler {
   // unloaded. In a performance-balanced system, this tunable value approximates
   // the cost of intra-cluster migration due to cache misses, assuming a task
   // has high cache affinity with the last CPU it ran on. This tunable may be
-  // increased to limit intra-cluster spill over.
+  // increased to limit intra-cluster spill over. Idle CPUs likewise do not
+  // steal from CPUs in their own cluster that are below this value.
   static constexpr SchedDuration kIntraClusterThreshold = SchedUs(25);
 
+  // How long after a thread last ran in a logical cluster it is assumed to still
+  // have part of its working set in that cluster's caches.
+  static constexpr SchedDuration kCacheWarmDuration = SchedMs(4);
+
+  // When placing a fair thread that is cache warm on the CPU it last ran on,
+  // that CPU is preferred over other CPUs in its cluster unless their queue
+  // times are lower by more than this value.
+  static constexpr SchedDuration kWarmCpuThreshold = SchedUs(100);
+
+  // A fair thread that has been woken this many times in a row by the same
+  // thread is placed starting from the waker's CPU instead of the CPU it last
+  // ran on, since the data it consumes was most likely just produced there.
+  static constexpr uint32_t kWakeAffineMinWakes = 4;
+
+  // Systems with at least this many CPUs, in more than one logical cluster,
+  // place threads by searching the starting cluster and then the least loaded
+  // other cluster, according to the per-cluster load summaries, instead of
+  // searching every CPU. This keeps the cost of placement proportional to the
+  // number of clusters plus the size of a cluster.
+  static constexpr size_t kClusterSearchMinCpus = 16;
+
+  // The interval over which the busy time of each CPU is sampled to estimate
+  // its demand for energy aware scheduling.
+  static constexpr SchedDuration kDemandWindow = SchedMs(4);
+
+  // With energy aware scheduling, fair threads are packed onto the CPU with the
+  // lowest processing rate whose demand is below this fraction of its
+  // processing rate, and are spread by the usual placement otherwise.
+  static constexpr SchedUtilization kEnergyPackUtilization = ffl::FromRatio(1, 2);
+
+  // With energy aware scheduling, the power level is chosen to provide this
+  // multiple of the estimated demand, leaving headroom for the demand to grow
+  // before the next sample.
+  static constexpr ffl::Fixed<int32_t, 2> kPowerLevelHeadroom = ffl::FromRatio(5, 4);
+
+  // The maximum number of CPUs an idle CPU will try to steal work from before
+  // giving up. Each attempt acquires the target CPU's queue lock, so this
+  // bounds the contention that idle CPUs add to busy ones.
+  static constexpr size_t kStealVictimLimit = 4;
+
   // The per-CPU deadline utilization limit to attempt to honor when selecting a
   // CPU to place a task. It is up to userspace to ensure that the total set of
   // deadline tasks can honor this limit. Even if userspace ensures the total
@@ -161,6 +204,10 @@ class Scheduler {
   // is associated with.
   size_t cluster() const { return cluster_; }
 
+  // Moves this CPU's contribution to the per-cluster load summaries to the
+  // given logical cluster. Called once the clusters are known.
+  void SetCluster(size_t cluster) TA_EXCL(queue_lock_);
+
   // Returns the lock-free value of the estimated queue time for the CPU this
   // scheduler is associated with.
   SchedDuration exported_queue_time_ns() const { return exported_queue_time_ns_.load(); }
@@ -175,6 +222,25 @@ class Scheduler {
   // scheduler is associated with.
   SchedProcessingRate exported_processing_rate() const { return exported_processing_rate_.load(); }
 
+  // Returns the lock-free value of the estimated demand for the CPU this
+  // scheduler is associated with, in units of normalized processing rate.
+  SchedUtilization exported_demand() const { return exported_demand_.load(); }
+
+  // Returns the longest exit latency the idle state of |cpu| may have at time |now| without
+  // risking the deadline of a deadline thread that recently blocked on it, and so is likely to
+  // wake there, or ZX_TIME_INFINITE if there is no such thread. A lock-free hint for idle
+  // governors.
+  static zx_duration_mono_t PeekIdleLatencyLimit(cpu_num_t cpu, zx_instant_mono_t now);
+
+  // Returns true if |thread| appears to be the thread running on |cpu|. This is
+  // a lock-free hint for spinning lock waiters: it may be stale by the time it
+  // is returned and |thread| is only compared, never dereferenced.
+  static bool IsActiveThreadHint(const Thread* thread, cpu_num_t cpu);
+
+  // Returns the CPUs set aside by kernel.scheduler.isolated-cpus for threads pinned to them.
+  static cpu_mask_t IsolatedMask();
+  static bool IsIsolatedCpu(cpu_num_t cpu) { return IsolatedMask().test(cpu); }
+
   // Returns the processing rate of the CPU this scheduler instance is
   // associated with.
   SchedProcessingRate processing_rate() const TA_REQ(queue_lock_) {
@@ -226,6 +292,14 @@ class Scheduler {
   static void Yield(Thread* current_thread)
       TA_REQ(chainlock_transaction_token, current_thread->get_lock());
 
+  // Prepares for the current thread to yield to |target|, a thread it is waiting on. If |target|
+  // is a fair thread waiting in a run queue, it is moved ahead of the threads there that are not
+  // yet due, so that it runs as soon as the CPU it is queued on reschedules. Returns
+  // ZX_ERR_SHOULD_WAIT if |target| is already running and ZX_ERR_BAD_STATE if it is not runnable,
+  // in which case yielding would not help it.
+  static zx_status_t PrepareYieldTo(Thread* target)
+      TA_REQ(chainlock_transaction_token, target->get_lock());
+
   // Note; no locks should be held when calling preempt.  The thread's lock will be obtained
   // unconditionally in the process.
   static void Preempt() TA_EXCL(chainlock_transaction_token);
@@ -266,6 +340,13 @@ class Scheduler {
   // This function is logically private and should only be called by timer.cc.
   static void TimerTick(SchedTime now);
 
+  // SampleLoad is called on every timer interrupt to keep the load averages of
+  // an idle CPU, which does not reschedule, up to date. A tickless idle CPU is
+  // woken for this by its load refresh timer, see UpdateLoadAverages().
+  //
+  // This function is logically private and should only be called by timer.cc.
+  static void SampleLoad(SchedTime now);
+
   // Releases the lock held by the previous and current threads after a context
   // switch. This must be called by trampoline routines at some point before
   // jumping to the current thread's entry point.
@@ -404,8 +485,7 @@ class Scheduler {
   // Note that this is just a lockless atomic load.  Baring special
   // circumstances, the set of active schedulers can change at any time.
   static bool PeekIsActive(cpu_num_t cpu) {
-    const cpu_mask_t mask = cpu_num_to_mask(cpu);
-    return (PeekActiveMask() & mask) != 0;
+    return active_schedulers_.test(cpu, ktl::memory_order_relaxed);
   }
 
   // Accessors for the "idle" state mask; similar to the active state mask.
@@ -418,7 +498,9 @@ class Scheduler {
     }
   }
   static cpu_mask_t PeekIdleMask() { return idle_schedulers_.load(ktl::memory_order_relaxed); }
-  static bool PeekIsIdle(cpu_num_t cpu) { return (PeekIdleMask() & cpu_num_to_mask(cpu)) != 0; }
+  static bool PeekIsIdle(cpu_num_t cpu) {
+    return idle_schedulers_.test(cpu, ktl::memory_order_relaxed);
+  }
 
   using PowerDomain = power_management::PowerDomain;
 
@@ -616,7 +698,23 @@ class Scheduler {
   // Typically, users will want to use FindActiveSchedulerForThread instead,
   // which will supply a locked scheduler which is guaranteed to be active.
   //
-  static cpu_num_t FindTargetCpu(Thread* thread) TA_REQ_SHARED(thread->get_lock());
+  // When placing a batch of threads woken together, |batch_mask| holds the
+  // CPUs that earlier threads of the batch were placed on. Those CPUs never end
+  // the search early, so that the batch is spread across unloaded CPUs rather
+  // than piling onto the first one.
+  //
+  static cpu_num_t FindTargetCpu(Thread* thread, cpu_mask_t batch_mask = cpu_mask_t{})
+      TA_REQ_SHARED(thread->get_lock());
+
+  // Records the current thread as the waker of the given thread, for the
+  // wake-affine placement in FindTargetCpu. Wakeups from interrupt context
+  // have no waker and reset the record.
+  static void RecordWaker(Thread* thread) TA_REQ(thread->get_lock());
+
+  // Returns the CPU in |available_mask| with the lowest processing rate whose
+  // demand is below kEnergyPackUtilization of its processing rate, or
+  // INVALID_CPU if there is no such CPU.
+  static cpu_num_t FindEnergyEfficientCpu(cpu_mask_t available_mask);
 
   // Increment the kcounter which tracks the number of times that an extra
   // attempt to find an active scheduler was needed during
@@ -838,9 +936,10 @@ class Scheduler {
   Thread* FindEarlierDeadlineThread(SchedTime eligible_time, SchedTime finish_time)
       TA_REQ(queue_lock_);
 
-  // Attempts to steal work from other busy CPUs. Returns nullptr if no work was
-  // stolen, otherwise returns a pointer to the stolen thread that is partially
-  // associated with the local Scheduler instance.
+  // Attempts to steal work from other busy CPUs, trying the most loaded CPUs in
+  // this CPU's cluster before CPUs in other clusters. Returns nullptr if no
+  // work was stolen, otherwise returns a pointer to the stolen thread that is
+  // partially associated with the local Scheduler instance.
   DequeueResult StealWork(SchedTime now, SchedProcessingRate processing_rate)
       TA_REQ(chainlock_transaction_token) TA_EXCL(queue_lock_);
 
@@ -863,6 +962,40 @@ class Scheduler {
   SchedTime ClampToEarlierDeadline(SchedTime completion_time, SchedTime finish_time)
       TA_REQ(queue_lock_);
 
+#if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+  // Returns the completion time clamped to the start of the earliest fair
+  // thread that will become eligible in that time frame and also has an earlier
+  // finish time than the given finish time.
+  SchedTime ClampToEarlierFair(SchedTime completion_time, SchedTime finish_time)
+      TA_REQ(queue_lock_);
+#endif
+
+  // Returns the time at which the preemption timer should fire for a thread of
+  // the given kind whose time slice completes at |completion_time| and whose
+  // activation period ends at |finish_time|. This is the completion time
+  // clamped to the start of any thread that would preempt it in the meantime.
+  SchedTime ClampPreemptionTime(bool is_fair, SchedTime completion_time, SchedTime finish_time)
+      TA_REQ(queue_lock_);
+
+  // Returns true if |next_thread| may run on this isolated CPU without a
+  // preemption timer: it is a fair thread and nothing else is runnable here.
+  // Anything made runnable later reschedules this CPU, which re-arms the timer.
+  bool CanStopTick(const Thread* next_thread) const
+      TA_REQ(queue_lock_) TA_REQ_SHARED(next_thread->get_lock()) {
+    return IsIsolatedCpu(this_cpu_) && !next_thread->IsIdle() && IsFairThread(next_thread) &&
+           fair_run_queue_.is_empty() && deadline_run_queue_.is_empty();
+  }
+
+  // Returns true if every SMT sibling of this CPU is idle, according to
+  // |idle_mask|, or is running a thread of the process |pid|.
+  bool IsSmtIsolatedFor(zx_koid_t pid, cpu_mask_t idle_mask) const;
+
+  // Records the run burst of |current_thread|, which is being switched away
+  // from, and the wakeup latency of |next_thread|, which is being switched to,
+  // in the per-CPU and per-thread latency histograms.
+  static void RecordLatencyHistograms(SchedTime now, Thread* current_thread, Thread* next_thread)
+      TA_REQ(current_thread->get_lock(), next_thread->get_lock());
+
   // Updates the timeslice of the thread based on the current run queue state.
   // Returns the absolute deadline for the next time slice, which may be earlier
   // than the completion of the time slice if other threads could preempt the
@@ -968,6 +1101,26 @@ class Scheduler {
   // cross-CPU readers.
   inline bool UpdateProcessingRate() TA_REQ(queue_lock_);
 
+  // Accumulates |busy_ns| of non-idle runtime into the current demand window.
+  // At the end of each window, updates the demand estimate, exports it, and,
+  // with energy aware scheduling enabled, requests a power level to match it.
+  void UpdateDemand(SchedTime now, SchedDuration busy_ns) TA_REQ(queue_lock_);
+
+  // Accumulates the number of runnable threads and the busy time since the
+  // last update. At the end of each kLoadAveragePeriod, updates the load
+  // averages and exports them through the scheduler.load.* kcounters. Must be
+  // called on this scheduler's CPU.
+  void UpdateLoadAverages(SchedTime now) TA_REQ(queue_lock_);
+
+  // Keeps the load refresh timer armed while any load average is nonzero, so
+  // that the averages of a tickless idle CPU keep decaying. See
+  // kLoadAverageMinRefresh.
+  void ArmLoadRefreshTimer(SchedTime now) TA_REQ(queue_lock_);
+
+  // The load refresh timer only needs to interrupt the CPU: the interrupt runs
+  // SampleLoad() before any timer callbacks.
+  static void LoadRefreshTimerHandler(Timer* timer, zx_instant_mono_t now, void* arg) {}
+
   // Computes the estimated energy consumed since the last reschedule and
   // updates the current thread and CPU energy accumulators.
   void UpdateEstimatedEnergyConsumption(Thread* current_thread, SchedMonoTimeAndBootTicks now,
@@ -1186,7 +1339,16 @@ class Scheduler {
   // queue_lock_ must be held.  Therefore, observations of the schedulers'
   // active mask must typically be assumed to be volatile.  As soon as the mask
   // is observed, it can immediately change.
-  static inline ktl::atomic<cpu_mask_t> active_schedulers_{0};
+  static inline AtomicCpuMask active_schedulers_;
+
+  // The sums of the exported queue times and deadline utilizations of the CPUs
+  // in each logical cluster, as raw values. Used to choose a cluster before
+  // choosing a CPU within it when placing threads on large systems.
+  struct ClusterLoad {
+    RelaxedAtomic<int64_t> queue_time_ns{0};
+    RelaxedAtomic<int64_t> deadline_utilization{0};
+  };
+  static inline ktl::array<ClusterLoad, SMP_MAX_CPUS> cluster_loads_;
 
   // A mask of all of the currently idle scheduler's in the system.  An
   // "idle" scheduler is one which last selected the idle/power thread to run,
@@ -1194,7 +1356,7 @@ class Scheduler {
   //
   // Like the active mask, the idle mask is volatile and subject to change at
   // any time barring special circumstances.
-  static inline ktl::atomic<cpu_mask_t> idle_schedulers_{0};
+  static inline AtomicCpuMask idle_schedulers_;
 
   // Flow id counter for sched_latency flow events.
   inline static RelaxedAtomic<uint64_t> next_flow_id_{1};
@@ -1225,6 +1387,45 @@ class Scheduler {
   TA_GUARDED(queue_lock_)
   Thread* active_thread_{nullptr};
 
+  // The estimated demand on this CPU: the fraction of recent time spent running
+  // threads, scaled by the processing rate they ran at. The estimate rises as
+  // quickly as the busy time and decays slowly. See UpdateDemand().
+  TA_GUARDED(queue_lock_)
+  SchedUtilization demand_{0};
+
+  // The start of the current demand window and the busy time accumulated in it.
+  TA_GUARDED(queue_lock_)
+  SchedTime demand_window_start_{0};
+  TA_GUARDED(queue_lock_)
+  SchedDuration demand_window_busy_ns_{0};
+
+  // The load averages of the number of runnable threads and of the fraction of
+  // time this CPU is busy, see kernel/load_average.h, along with the start of
+  // the current period, the time of the last update, and the integrals of both
+  // quantities accumulated since the start of the period. See
+  // UpdateLoadAverages().
+  TA_GUARDED(queue_lock_)
+  ktl::array<int64_t, kLoadAverageWindows> runnable_load_{};
+  TA_GUARDED(queue_lock_)
+  ktl::array<int64_t, kLoadAverageWindows> busy_load_{};
+  TA_GUARDED(queue_lock_)
+  SchedTime load_period_start_{0};
+  TA_GUARDED(queue_lock_)
+  SchedTime load_last_update_{0};
+  TA_GUARDED(queue_lock_)
+  int64_t load_runnable_ns_{0};
+  TA_GUARDED(queue_lock_)
+  int64_t load_busy_ns_{0};
+
+  // The timer that refreshes the load averages of an idle CPU, its deadline,
+  // and the interval to the next deadline. See ArmLoadRefreshTimer().
+  TA_GUARDED(queue_lock_)
+  Timer load_refresh_timer_;
+  TA_GUARDED(queue_lock_)
+  SchedTime load_refresh_deadline_{0};
+  TA_GUARDED(queue_lock_)
+  zx_duration_mono_t load_refresh_interval_{kLoadAverageMinRefresh};
+
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
   TA_GUARDED(queue_lock_)
   SchedWeight active_thread_weight_{SchedWeight::Max()};
@@ -1341,6 +1542,9 @@ class Scheduler {
   // respect to load distribution decisions.
   size_t cluster_{0};
 
+  // The other logical CPUs that share a physical core with this CPU.
+  cpu_mask_t smt_siblings_{};
+
   // Flag indicating that this Scheduler's CPU is in the process of becoming
   // inactive.  When true, threads who have a migration function which must be
   // run on this CPU are permitted to join this CPU's ready queue, even if the
@@ -1359,6 +1563,22 @@ class Scheduler {
   RelaxedAtomic<SchedDuration> exported_queue_time_ns_{SchedNs(0)};
   RelaxedAtomic<SchedUtilization> exported_deadline_utilization_{SchedUtilization{0}};
   RelaxedAtomic<SchedProcessingRate> exported_processing_rate_{SchedProcessingRate{1}};
+  RelaxedAtomic<SchedUtilization> exported_demand_{SchedUtilization{0}};
+
+  // The koid of the process of the thread running on this CPU, or
+  // ZX_KOID_INVALID for the idle thread and kernel threads. Used to decide
+  // whether a sibling hyperthread is running unrelated work.
+  RelaxedAtomic<zx_koid_t> exported_active_pid_{ZX_KOID_INVALID};
+
+  // The address of the thread running on this CPU. Only ever compared against,
+  // see IsActiveThreadHint.
+  RelaxedAtomic<uintptr_t> exported_active_thread_{0};
+
+  // The idle exit latency tolerated by the deadline threads that recently
+  // blocked on this CPU, and the time after which it no longer applies. See
+  // PeekIdleLatencyLimit.
+  RelaxedAtomic<SchedDuration> exported_idle_latency_limit_{SchedDuration{0}};
+  RelaxedAtomic<SchedTime> exported_idle_latency_expiry_{SchedTime{0}};
 
   // The thread which ran just before this thread was scheduled.  Used by
   // Scheduler::LockHandoff to release the previous thread's lock after a
@@ -1448,6 +1668,12 @@ class Scheduler {
     // scheduler.
     [[nodiscard("A reschedule is required when true")]] bool RequestPowerLevel(uint8_t power_level);
 
+    // Called by the scheduler, with energy aware scheduling enabled, to request the slowest active
+    // power level that provides |processing_rate|. Does nothing if the domain does not accept
+    // scheduler control or the level is already current or requested.
+    [[nodiscard("A reschedule is required when true")]] bool RequestPowerLevelForRate(
+        SchedProcessingRate processing_rate);
+
     // Called by RescheduleCommon to send any pending request to the registered power level
     // controller.
     void SendPendingPowerLevelRequest() {
@@ -1526,6 +1752,11 @@ class Scheduler {
       return ffl::FromRatio<uint64_t>(processing_rate, 1000);
     }
 
+    // The inverse of ToProcessingRate.
+    static uint64_t FromProcessingRate(SchedProcessingRate processing_rate) {
+      return ffl::Round<uint64_t>(processing_rate * 1000);
+    }
+
     SchedProcessingRate processing_rate_{1};
     SchedProcessingRate processing_rate_reciprocal_{1};
     SchedProcessingRate updated_processing_rate_{1};
@@ -85,6 +85,8 @@ inline void Scheduler::UpdateTotalExpectedRuntime(SchedDuration delta_ns) {
   total_expected_runtime_ns_ += delta_ns;
   DEBUG_ASSERT(total_expected_runtime_ns_ >= 0);
   const SchedDuration scaled_ns = ScaleUp(total_expected_runtime_ns_);
+  cluster_loads_[cluster_].queue_time_ns +=
+      (scaled_ns - exported_queue_time_ns_.load()).raw_value();
   exported_queue_time_ns_ = scaled_ns;
   LOCAL_KTRACE_COUNTER(COUNTER, "Estimated Runtime", this_cpu(), ("CPU", scaled_ns.raw_value()));
 }
@@ -95,6 +97,8 @@ inline void Scheduler::UpdateTotalExpectedRuntime(SchedDuration delta_ns) {
 inline void Scheduler::UpdateTotalDeadlineUtilization(SchedUtilization delta) {
   const SchedUtilization utilization = power_level_control_.UpdateNormalizedUtilization(delta);
   DEBUG_ASSERT(utilization >= 0);
+  cluster_loads_[cluster_].deadline_utilization +=
+      (utilization - exported_deadline_utilization_.load()).raw_value();
   exported_deadline_utilization_ = utilization;
   LOCAL_KTRACE_COUNTER(COUNTER, "Utilization", this_cpu(),
                        ("CPU", ffl::Round<uint64_t>(utilization * 1000)));
@@ -136,13 +140,13 @@ inline void Scheduler::RescheduleMask(cpu_mask_t cpus_to_reschedule_mask) {
     // EagerReschedDisabled implies that local preemption is also disabled.
     DEBUG_ASSERT(!preemption_state.PreemptIsEnabled());
     preemption_state.preempts_pending_add(cpus_to_reschedule_mask);
-    if (local_cpu != 0) {
+    if (local_cpu) {
       preemption_state.EvaluateTimesliceExtension();
     }
     return;
   }
 
-  if (local_cpu != 0) {
+  if (local_cpu) {
     const bool preempt_enabled = preemption_state.EvaluateTimesliceExtension();
 
     // Can we do it here and now?
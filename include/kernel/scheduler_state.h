@@ -21,7 +21,9 @@
 #include <ffl/fixed.h>
 #include <ffl/string.h>
 #include <kernel/cpu.h>
+#include <kernel/sched_histogram.h>
 #include <kernel/spinlock.h>
+#include <ktl/array.h>
 #include <ktl/limits.h>
 #include <ktl/type_traits.h>
 #include <ktl/utility.h>
@@ -572,7 +574,7 @@ class SchedulerState {
 
     // Return the mask honoring soft affinity if it is viable, otherwise ignore
     // soft affinity and honor only hard affinity.
-    if (likely(available_mask != 0)) {
+    if (likely(available_mask.any())) {
       return available_mask;
     }
 
@@ -614,6 +616,27 @@ class SchedulerState {
   cpu_num_t curr_cpu() const { return curr_cpu_; }
   cpu_num_t last_cpu() const { return last_cpu_; }
 
+  // The number of times the thread started running on a CPU other than the one
+  // it last ran on.
+  uint64_t migration_count() const { return migration_count_; }
+
+  // The number of logical clusters for which the time the thread last ran is
+  // tracked. The thread is never considered cache warm on other clusters.
+  static constexpr size_t kMaxWarmClusters = 4;
+
+  // Returns the last time the thread ran on a CPU in the given logical cluster,
+  // or zero if it has not run there.
+  SchedTime last_ran_on_cluster(size_t cluster) const {
+    return cluster < kMaxWarmClusters ? cluster_last_ran_[cluster] : SchedTime{0};
+  }
+
+  // Histograms of the time from unblocking to running and of the time run
+  // before switching away, recorded when kernel.scheduler.latency-histograms
+  // is enabled. See kernel/sched_histogram.h.
+  using LatencyHistogram = ktl::array<uint32_t, kSchedHistogramBuckets>;
+  const LatencyHistogram& wakeup_latency_histogram() const { return wakeup_latency_histogram_; }
+  const LatencyHistogram& run_burst_histogram() const { return run_burst_histogram_; }
+
   thread_state state() const { return state_; }
   void set_state(thread_state state) { state_ = state; }
 
@@ -714,6 +737,24 @@ class SchedulerState {
   // The last CPU the thread ran on. INVALID_CPU before it first runs.
   cpu_num_t last_cpu_{INVALID_CPU};
 
+  // See migration_count().
+  uint64_t migration_count_{0};
+
+  // The time the thread was last descheduled from a CPU in each of the first
+  // kMaxWarmClusters logical clusters. See last_ran_on_cluster().
+  ktl::array<SchedTime, kMaxWarmClusters> cluster_last_ran_{};
+
+  // The time the thread was last unblocked, or zero once it has started
+  // running since then.
+  SchedTime wakeup_time_{0};
+
+  // The time the thread was last switched in while THREAD_RUNNING.
+  SchedTime switched_in_time_{0};
+
+  // See wakeup_latency_histogram() and run_burst_histogram().
+  LatencyHistogram wakeup_latency_histogram_{};
+  LatencyHistogram run_burst_histogram_{};
+
   // The set of CPUs the thread is permitted to run on. The thread is never
   // assigned to CPUs outside of this set.
   cpu_mask_t hard_affinity_{CPU_MASK_ALL};
@@ -721,6 +762,11 @@ class SchedulerState {
   // The set of CPUs the thread should run on if possible. The thread may be
   // assigned to CPUs outside of this set if necessary.
   cpu_mask_t soft_affinity_{CPU_MASK_ALL};
+
+  // The thread that last woke this thread, and the number of consecutive
+  // wakeups by that thread. See Scheduler::RecordWaker().
+  zx_koid_t last_waker_tid_{ZX_KOID_INVALID};
+  uint32_t consecutive_wakes_{0};
 };
 
 // SchedulerQueueState tracks the association with a scheduler and run queue. To
@@ -56,6 +56,22 @@ class Semaphore {
   // |Wait| has acquire memory order semantics and synchronizes with |Post|.
   zx_status_t Wait(const Deadline& deadline) TA_EXCL(chainlock_transaction_token);
 
+  // If the count is positive, decrement the count and return true.  Otherwise,
+  // return false without blocking or changing the count.
+  //
+  // A successful |TryWait| has acquire memory order semantics and synchronizes
+  // with |Post|.
+  bool TryWait() {
+    int64_t old_count = count_.load(ktl::memory_order_relaxed);
+    while (old_count > 0) {
+      if (count_.compare_exchange_weak(old_count, old_count - 1, ktl::memory_order_acquire,
+                                       ktl::memory_order_relaxed)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   // Observe the current internal count of the semaphore.
   //
   // This should only be used for testing/diagnostic purposes.
@@ -10,6 +10,8 @@
 #include <zircon/compiler.h>
 #include <zircon/types.h>
 
+#include <kernel/sched_histogram.h>
+
 // per cpu guest statistics
 struct guest_stats {
   ulong vm_entries;
@@ -61,6 +63,10 @@ struct cpu_stats {
   // energy consumption
   ulong active_energy_consumption_nj;
   ulong idle_energy_consumption_nj;
+
+  // scheduler latency histograms, see kernel/sched_histogram.h
+  ulong wakeup_latency[kSchedHistogramBuckets];  // time from unblocking to running
+  ulong run_burst[kSchedHistogramBuckets];       // time running before switching away
 };
 
 // include after the cpu_stats definition above, since it is part of the percpu structure
@@ -76,4 +82,10 @@ struct cpu_stats {
     __atomic_fetch_add(&percpu::GetCurrent().stats.name, 1u, __ATOMIC_RELAXED); \
   } while (0)
 
+#define CPU_STATS_HISTOGRAM_RECORD(name, duration)                                           \
+  do {                                                                                       \
+    __atomic_fetch_add(&percpu::GetCurrent().stats.name[SchedHistogramBucket(duration)], 1u, \
+                       __ATOMIC_RELAXED);                                                    \
+  } while (0)
+
 #endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_STATS_H_
@@ -51,16 +51,27 @@ struct TaskRuntimeStats {
   // The total duration (in ticks) spent contented on kernel locks.
   zx_duration_mono_ticks_t lock_contention_ticks = 0;
 
+  // The number of times a thread started running on a different CPU than the
+  // one it last ran on.
+  uint64_t migrations = 0;
+
+  // The total duration (in ticks) spent stalled on memory, i.e. inside a
+  // ScopedMemoryStall. This covers waits on page requests and on reclamation.
+  zx_duration_mono_ticks_t memory_stall_ticks = 0;
+
   // Adds another TaskRuntimeStats to this one.
   constexpr TaskRuntimeStats& operator+=(const TaskRuntimeStats& other) {
     cpu_ticks = zx_ticks_add_ticks(cpu_ticks, other.cpu_ticks);
     queue_ticks = zx_ticks_add_ticks(queue_ticks, other.queue_ticks);
     page_fault_ticks = zx_ticks_add_ticks(page_fault_ticks, other.page_fault_ticks);
     lock_contention_ticks = zx_ticks_add_ticks(lock_contention_ticks, other.lock_contention_ticks);
+    migrations += other.migrations;
+    memory_stall_ticks = zx_ticks_add_ticks(memory_stall_ticks, other.memory_stall_ticks);
     return *this;
   }
 
-  // Conversion to zx_info_task_runtime_t.
+  // Conversion to zx_info_task_runtime_t. The migration count and the memory
+  // stall time have no field in the ABI struct and are not reported.
   operator zx_info_task_runtime_t() const;
 };
 
@@ -148,6 +159,14 @@ class ThreadRuntimeStats {
     lock_contention_ticks_.fetch_add(delta);
   }
 
+  // Counts a migration of the thread to a different CPU.
+  void AddMigration() { migrations_.fetch_add(1); }
+
+  // Updates the memory stall ticks with the given delta.
+  void AddMemoryStallTicks(zx_duration_mono_ticks_t delta) {
+    memory_stall_ticks_.fetch_add(delta);
+  }
+
   // Returns the instantaneous runtime stats for the thread, including the time
   // the thread has spent in its current state (if that state is either READY or
   // RUNNING).
@@ -168,7 +187,9 @@ class ThreadRuntimeStats {
     return TaskRuntimeStats{.cpu_ticks = res.stats.total_running_ticks,
                             .queue_ticks = res.stats.total_ready_ticks,
                             .page_fault_ticks = page_fault_ticks_,
-                            .lock_contention_ticks = lock_contention_ticks_};
+                            .lock_contention_ticks = lock_contention_ticks_,
+                            .migrations = migrations_,
+                            .memory_stall_ticks = memory_stall_ticks_};
   }
 
  private:
@@ -229,6 +250,8 @@ class ThreadRuntimeStats {
   SeqLockPayload<ThreadStats, decltype(seq_lock_)> published_stats_ TA_GUARDED(seq_lock_){};
   RelaxedAtomic<zx_duration_mono_ticks_t> page_fault_ticks_{0};
   RelaxedAtomic<zx_duration_mono_ticks_t> lock_contention_ticks_{0};
+  RelaxedAtomic<uint64_t> migrations_{0};
+  RelaxedAtomic<zx_duration_mono_ticks_t> memory_stall_ticks_{0};
 };
 
 }  // namespace task_runtime_stats::internal
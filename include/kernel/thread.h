@@ -15,6 +15,7 @@
 #include <lib/fit/function.h>
 #include <lib/fxt/thread_ref.h>
 #include <lib/kconcurrent/chainlock.h>
+#include <lib/lockup_detector.h>
 #include <lib/relaxed_atomic.h>
 #include <lib/zircon-internal/thread_annotations.h>
 #include <lib/zx/result.h>
@@ -49,6 +50,7 @@
 #include <ktl/atomic.h>
 #include <ktl/optional.h>
 #include <ktl/string_view.h>
+#include <ktl/utility.h>
 #include <lockdep/thread_lock_state.h>
 #include <vm/kstack.h>
 
@@ -501,7 +503,12 @@ class WaitQueue : public ChainLockable {
   // queue and set our blocked state.  All we need to do now is set up our
   // timer, and finally descend into the scheduler in order to block and select
   // a new thread.
-  inline zx_status_t BlockEtcPostamble(Thread* current_thread, const Deadline& deadline)
+  //
+  // |caller| is the return address of the blocking operation, and |owner_tid|
+  // the tid of the thread which owns the queue, if any.  Both are only used to
+  // annotate the off-CPU time of the block in "kernel:sched" traces.
+  inline zx_status_t BlockEtcPostamble(Thread* current_thread, const Deadline& deadline,
+                                       uintptr_t caller, zx_koid_t owner_tid)
       TA_EXCL(get_lock())
           TA_REQ(chainlock_transaction_token, ChainLockable::GetLock(*current_thread));
 
@@ -605,9 +612,11 @@ class PreemptionState {
     Active = 0b10 << kTimesliceExtensionFlagsShift,
   };
 
-  cpu_mask_t preempts_pending() const { return preempts_pending_.load(); }
-  void preempts_pending_clear() { preempts_pending_.store(0); }
-  void preempts_pending_add(cpu_mask_t mask) { preempts_pending_.fetch_or(mask); }
+  cpu_mask_t preempts_pending() const { return preempts_pending_.load(ktl::memory_order_relaxed); }
+  void preempts_pending_clear() { preempts_pending_.store({}, ktl::memory_order_relaxed); }
+  void preempts_pending_add(cpu_mask_t mask) {
+    preempts_pending_.fetch_or(mask, ktl::memory_order_relaxed);
+  }
 
   bool PreemptIsEnabled() const {
     // Preemption is enabled iff both counts are zero and there's no runtime
@@ -633,6 +642,9 @@ class PreemptionState {
   void PreemptDisable() {
     const uint32_t old_state = state_.fetch_add(1);
     ASSERT(PreemptDisableCount(old_state) < kMaxCountValue);
+    if (unlikely(lockup_section_histograms_enabled()) && PreemptDisableCount(old_state) == 0) {
+      preempt_disabled_begin_ticks_ = lockup_preempt_disabled_begin();
+    }
   }
 
   // PreemptReenable() decrements the preempt disable counter and flushes any
@@ -640,6 +652,7 @@ class PreemptionState {
   // calling from a context where blocking is allowed, as the call may result in
   // the immediate preemption of the calling thread.
   void PreemptReenable() {
+    RecordPreemptDisabledEnd();
     const uint32_t old_state = state_.fetch_sub(1);
     ASSERT(PreemptDisableCount(old_state) > 0);
 
@@ -715,6 +728,7 @@ class PreemptionState {
     DEBUG_ASSERT(arch_ints_disabled());
     DEBUG_ASSERT(arch_blocking_disallowed());
 
+    RecordPreemptDisabledEnd();
     const uint32_t old_state = state_.fetch_sub(1);
     ASSERT(PreemptDisableCount(old_state) > 0);
 
@@ -722,8 +736,9 @@ class PreemptionState {
     // with a zero eager resched disable count and no timeslice extension.
     if (old_state == 1) {
       const cpu_mask_t local_mask = cpu_num_to_mask(arch_curr_cpu_num());
-      const cpu_mask_t prev_mask = preempts_pending_.fetch_and(~local_mask);
-      return (local_mask & prev_mask) != 0;
+      const cpu_mask_t prev_mask =
+          preempts_pending_.fetch_and(~local_mask, ktl::memory_order_relaxed);
+      return (local_mask & prev_mask).any();
     }
 
     if (EagerReschedDisableCount(old_state) > 0 || PreemptDisableCount(old_state) > 1) {
@@ -742,8 +757,9 @@ class PreemptionState {
         // It has.
         DEBUG_ASSERT(PreemptIsEnabled());
         const cpu_mask_t local_mask = cpu_num_to_mask(arch_curr_cpu_num());
-        const cpu_mask_t prev_mask = preempts_pending_.fetch_and(~local_mask);
-        return (local_mask & prev_mask) != 0;
+        const cpu_mask_t prev_mask =
+            preempts_pending_.fetch_and(~local_mask, ktl::memory_order_relaxed);
+        return (local_mask & prev_mask).any();
       }
     }
 
@@ -877,7 +893,7 @@ class PreemptionState {
     DEBUG_ASSERT(arch_blocking_disallowed());
     DEBUG_ASSERT(!PreemptIsEnabled());
 
-    preempts_pending_.fetch_or(reschedule_mask);
+    preempts_pending_.fetch_or(reschedule_mask, ktl::memory_order_relaxed);
 
     // Are we pending for the local CPU?
     if (reschedule_mask & cpu_num_to_mask(arch_curr_cpu_num() == 0)) {
@@ -938,9 +954,10 @@ class PreemptionState {
   // idle/power thread that halted while taking a CPU offline.
   void Reset() {
     state_ = 0;
-    preempts_pending_ = 0;
+    preempts_pending_.store({}, ktl::memory_order_relaxed);
     timeslice_extension_ = 0;
     timeslice_extension_deadline_ = 0;
+    preempt_disabled_begin_ticks_ = 0;
   }
 
  private:
@@ -985,6 +1002,16 @@ class PreemptionState {
     return false;
   }
 
+  // Reports the end of the outermost preempt disabled section to the lockup
+  // detector when kernel.lockup-detector.section-histograms is enabled. Called
+  // while preemption is still disabled, before the count is decremented.
+  void RecordPreemptDisabledEnd() {
+    if (unlikely(lockup_section_histograms_enabled()) && PreemptDisableCount() == 1) {
+      lockup_preempt_disabled_end(preempt_disabled_begin_ticks_);
+      preempt_disabled_begin_ticks_ = 0;
+    }
+  }
+
   enum Flush { FlushLocal = 0x1, FlushRemote = 0x2, FlushAll = FlushLocal | FlushRemote };
 
   // Flushes local, remote, or all pending preemptions.
@@ -996,7 +1023,7 @@ class PreemptionState {
     // any potential flush due to context switch, however, the context switch can
     // only clear bits that would have been flushed below, no new pending
     // preemptions are possible in the mask bits indicated by |flush|.
-    if (likely(preempts_pending_.load() == 0)) {
+    if (likely(preempts_pending_.load(ktl::memory_order_relaxed).none())) {
       return;
     }
     FlushPendingContinued(flush);
@@ -1026,7 +1053,9 @@ class PreemptionState {
   //  * if PreemptDisableCount() or EagerReschedDisable() are non-zero, or
   //  * after PreemptDisableCount() or EagerReschedDisable() have been
   //    decremented, while preempts_pending_ is being checked.
-  RelaxedAtomic<cpu_mask_t> preempts_pending_{};
+  //
+  // All accesses are relaxed.
+  AtomicCpuMask preempts_pending_;
 
   // The maximum duration of the thread's timeslice extension.
   //
@@ -1055,6 +1084,14 @@ class PreemptionState {
   // flag.  By using these fences, we ensure the flag and field value remain in
   // sync.
   RelaxedAtomic<zx_instant_mono_t> timeslice_extension_deadline_{};
+
+  // The time (tick count) at which the outermost preempt disabled section
+  // began, recorded when kernel.lockup-detector.section-histograms is enabled.
+  // Zero if the section began before the histograms were enabled.
+  //
+  // Like |state_|, this field is modified by interrupt handlers, which only
+  // begin a section of their own when no section is active.
+  RelaxedAtomic<zx_instant_boot_ticks_t> preempt_disabled_begin_ticks_{};
 };
 
 // TaskState is responsible for running the task defined by
@@ -1193,6 +1230,9 @@ struct Thread : public ChainLockable {
                            const SchedulerState::BaseProfile& profile,
                            thread_trampoline_routine alt_trampoline);
 
+  // Frees the Thread structures each CPU keeps for reuse by Create(). Returns the number freed.
+  static size_t TrimStructCache();
+
   // Public routines used by debugging code to dump thread state.
 
   // Dump the information of a single thread. If |full| is true then a multi-line verbose dump of
@@ -1392,6 +1432,10 @@ struct Thread : public ChainLockable {
 
     // Scheduler routines to be used by regular kernel code.
     static void Yield();
+    // Yields the CPU in favor of |target|, a thread the current thread is waiting on, such as the
+    // owner of a lock. See Scheduler::PrepareYieldTo for the meaning of the returned status. The
+    // current thread only yields when ZX_OK is returned.
+    static zx_status_t YieldTo(Thread* target);
     static void Preempt();
     static void Reschedule() TA_EXCL(chainlock_transaction_token);
     static void Exit(int retcode) __NO_RETURN;
@@ -1445,6 +1489,15 @@ struct Thread : public ChainLockable {
       return Thread::Current::Get()->memory_allocation_state_;
     }
 
+    // Marks whether threads woken by the current thread are being woken synchronously, i.e. the
+    // current thread is about to block waiting on the work it is handing to them. The scheduler
+    // may then place a woken thread on the current CPU instead of searching for another one.
+    // Returns the previous value so that callers can restore it.
+    static bool set_sync_wakeup(bool sync_wakeup) {
+      return ktl::exchange(Thread::Current::Get()->sync_wakeup_, sync_wakeup);
+    }
+    static bool sync_wakeup() { return Thread::Current::Get()->sync_wakeup_; }
+
     // If a restricted kick is pending on this thread, clear it and return true.
     // Otherwise return false.
     // Must be called with interrupts disabled.
@@ -1526,6 +1579,10 @@ struct Thread : public ChainLockable {
   // Called by the scheduler to update runtime stats.
   void UpdateRuntimeStats(thread_state new_state);
 
+  // Called by the scheduler when the thread starts running on a different CPU
+  // than the one it last ran on.
+  void CountMigration();
+
   // Accessors into Thread state. When the conversion to all-private
   // members is complete (bug 54383), we can revisit the overall
   // Thread API.
@@ -1851,6 +1908,9 @@ struct Thread : public ChainLockable {
   // Must only be accessed by "this" thread. May be null.
   ktl::unique_ptr<RestrictedState> restricted_state_;
 
+  // Must only be accessed by "this" thread. See Thread::Current::set_sync_wakeup.
+  bool sync_wakeup_ = false;
+
 #if WITH_LOCK_DEP
   // state for runtime lock validation when in thread context
   lockdep::ThreadLockState lock_state_;
@@ -2240,6 +2300,10 @@ struct WaitQueueLockOps {
 
 // RAII class to mark sections of code as memory stalls.
 //
+// Besides feeding the per-CPU stall accumulator, the duration of the stall is
+// added to the user thread's runtime stats, so that it rolls up to its process
+// and job.
+//
 // Nesting is not allowed. It is a programming error to instantiate this class
 // if there exists another instance on the call stack.
 class ScopedMemoryStall {
@@ -2252,6 +2316,9 @@ class ScopedMemoryStall {
   ScopedMemoryStall(ScopedMemoryStall&&) = delete;
   ScopedMemoryStall& operator=(const ScopedMemoryStall&) = delete;
   ScopedMemoryStall& operator=(ScopedMemoryStall&&) = delete;
+
+ private:
+  zx_instant_mono_ticks_t start_ticks_ = 0;
 };
 
 #endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_THREAD_H_
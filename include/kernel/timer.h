@@ -14,10 +14,13 @@
 #include <zircon/types.h>
 
 #include <fbl/canary.h>
-#include <fbl/intrusive_double_list.h>
+#include <fbl/intrusive_wavl_tree.h>
 #include <kernel/deadline.h>
 #include <kernel/spinlock.h>
 #include <ktl/atomic.h>
+#include <ktl/utility.h>
+
+class TimerQueue;
 
 // Rules for Timers:
 // - Timer callbacks occur from interrupt context.
@@ -27,20 +30,27 @@
 // - Timer::cancel() may spin waiting for a pending timer to complete on another cpu.
 // - Timers aren't permanently bound to a particular CPU and may fire on a CPU other
 //   than the one on which they were set.
+// - Each TimerQueue has its own lock. A timer is only ever on one queue at a time, and the
+//   queue it is on is published in |queue_| so that it can be canceled from any cpu.
+// - A monotonic timer with slack that would otherwise need a wakeup of its own may be placed on
+//   another cpu's queue that already has a timer within that slack.
 
-// Timers may be removed from an arbitrary TimerQueue, so their list
-// node requires the AllowRemoveFromContainer option.
-class Timer : public fbl::DoublyLinkedListable<Timer*, fbl::NodeOptions::AllowRemoveFromContainer> {
+// Timers are kept in a TimerQueue's tree ordered by scheduled time.
+class Timer : public fbl::WAVLTreeContainable<Timer*> {
  public:
   using Callback = void (*)(Timer*, zx_time_t now, void* arg);
 
+  // Timers with the same scheduled time are common, as coalescing is the point of slack, so the
+  // timer's address breaks ties to keep every key in a TimerQueue unique.
+  using Key = ktl::pair<zx_time_t, uintptr_t>;
+
   // Timers need a constexpr constructor, as it is valid to construct them in static storage.
   // TODO(https://fxbug.dev/328306129): The default value for the clock_id parameter should be
   // removed, thus forcing users of the Timer class to explicitly declare the clock they wish
   // to use.
   constexpr explicit Timer(zx_clock_t clock_id = ZX_CLOCK_MONOTONIC) : clock_id_(clock_id) {}
 
-  // We ensure that timers are not on a list or an active cpu when destroyed.
+  // We ensure that timers are not on a queue or an active cpu when destroyed.
   ~Timer();
 
   // Timers are not moved or copied.
@@ -85,6 +95,9 @@ class Timer : public fbl::DoublyLinkedListable<Timer*, fbl::NodeOptions::AllowRe
   zx_status_t TrylockOrCancel(ChainLock& lock) TA_REQ(chainlock_transaction_token)
       TA_TRY_ACQ(false, lock);
 
+  // The key under which this timer is ordered in its TimerQueue.
+  Key GetKey() const { return {scheduled_time_, reinterpret_cast<uintptr_t>(this)}; }
+
   // Private accessors for timer tests.
   zx_duration_t slack_for_test() const { return slack_; }
 
@@ -121,32 +134,12 @@ class Timer : public fbl::DoublyLinkedListable<Timer*, fbl::NodeOptions::AllowRe
   // true if cancel is pending
   ktl::atomic<bool> cancel_{false};
 
-  // Note that we need to manually name the timer_lock because it is one of and
-  // extremely small number of "wrapped" locks in the system, and cannot easily
-  // use lockdep in order to generate its name.
-  //
-  // The vast majority of locks in the system are directly instrumented using
-  // lockdep. This causes the instance of the actual lock to become a member of a
-  // generated lock dep class, which is used to access the underlying lock.  In
-  // these cases, lockdep itself controls the construction sequencing of the lock,
-  // allowing it to configure the internal lock's metadata immediately after
-  // construction has completed.
-  //
-  // Wrapped locks, OTOH, are a bit different.  The lock instance is declared
-  // outside of the lockdep generated class, which holds a reference to the lock
-  // instead of encapsulating the lock itself.  This leads to a global ctor race:
-  // Who is constructed first, the lock itself, or the lock wrapper who holds a
-  // pointer/reference to the lock?
-  //
-  // In situations like this, it is not safe for lock wrapper to be interacting
-  // with the lock whose reference it holds, since that lock may not have been
-  // constructed yet.
-  //
-  // So instead, we simply manually name the lock, and the lockdep wrapper never
-  // makes any attempt to name the lock because of the ordering issues.
-  //
-  static MonitoredSpinLock timer_lock __CPU_ALIGN_EXCLUSIVE;
-  DECLARE_SINGLETON_LOCK_WRAPPER(TimerLock, timer_lock);
+  // The TimerQueue this timer is on, or nullptr if it is not on any queue. Only written while
+  // holding that TimerQueue's lock, but may be read without it to find which lock to take.
+  ktl::atomic<TimerQueue*> queue_{nullptr};
+
+  // Removes this timer from whichever TimerQueue it is on. Returns false if it was not on one.
+  bool RemoveFromTimerQueue();
 };
 
 // Preemption Timers
@@ -162,6 +155,10 @@ class Timer : public fbl::DoublyLinkedListable<Timer*, fbl::NodeOptions::AllowRe
 // Note: A preemption timer may fire even after it has been canceled.
 class TimerQueue {
  public:
+  // Pending timers, ordered by scheduled time. Insertion and removal are O(log n), and the
+  // earliest timer is always at the front.
+  using TimerTree = fbl::WAVLTree<Timer::Key, Timer*>;
+
   // Set/reset/cancel the preemption timer.
   //
   // When the preemption timer fires, Scheduler::TimerTick is called. Set the
@@ -174,9 +171,17 @@ class TimerQueue {
   // not fire, as a spurious expiration is allowed.
   bool PreemptArmed() const { return preempt_timer_deadline_ != ZX_TIME_INFINITE; }
 
+  // Returns how long until the platform timer of this TimerQueue fires, or ZX_TIME_INFINITE if it
+  // is not set. Idle governors use this to bound how long the cpu can stay idle.
+  //
+  // This can only be called with interrupts disabled, on the cpu this TimerQueue belongs to.
+  zx_duration_mono_t TimeUntilNextWakeup() const;
+
   // Internal routines used when bringing cpus online/offline
 
   // Moves |source|'s timers (except its preemption timer) to this TimerQueue.
+  //
+  // |source| must belong to a cpu that is no longer running.
   void TransitionOffCpu(TimerQueue& source);
 
   // Prints the contents of all timer queues into |buf| of length |len| and null
@@ -193,32 +198,53 @@ class TimerQueue {
   // 3. The preemption timer deadline.
   //
   // This can only be called when interrupts are disabled.
-  void UpdatePlatformTimer() TA_EXCL(Timer::TimerLock::Get());
-  void UpdatePlatformTimerLocked() TA_REQ(Timer::TimerLock::Get());
+  void UpdatePlatformTimer() TA_EXCL(lock_);
+  void UpdatePlatformTimerLocked() TA_REQ(lock_);
 
  private:
   // Timers can directly call Insert and Cancel.
   friend class Timer;
 
   // Add |timer| to this TimerQueue, possibly coalescing deadlines as well.
-  void Insert(Timer* timer, zx_time_t earliest_deadline, zx_time_t latest_deadline);
+  void Insert(Timer* timer, zx_time_t earliest_deadline, zx_time_t latest_deadline)
+      TA_REQ(lock_);
+
+  // Remove |timer| from this TimerQueue, updating the platform timer if it was at the head of
+  // the current cpu's queue.
+  void RemoveLocked(Timer* timer) TA_REQ(lock_);
+
+  // Returns the tree of this TimerQueue that |timer| belongs on.
+  TimerTree& TreeForLocked(const Timer& timer) TA_REQ(lock_);
 
-  // A helper function for Insert that inserts the given timer into the given timer list.
-  static void InsertIntoTimerList(fbl::DoublyLinkedList<Timer*>& timer_list, Timer* timer,
-                                  zx_time_t earliest_deadline, zx_time_t latest_deadline);
+  // Publishes the scheduled time of the head of |monotonic_timers_| to |monotonic_head_hint_|.
+  void PublishHeadHintLocked() TA_REQ(lock_);
 
-  // A helper function for TransitionOffCpu that moves all timers from the src_list to the
-  // dst_list. Returns the Timer at the head of the dst_list if it changed, otherwise returns
-  // nullopt.
-  static ktl::optional<Timer*> TransitionTimerList(fbl::DoublyLinkedList<Timer*>& src_list,
-                                                   fbl::DoublyLinkedList<Timer*>& dst_list);
+  // Returns true if |timers| has a timer scheduled within [earliest_deadline, latest_deadline].
+  static bool HasTimerInWindow(TimerTree& timers, zx_time_t earliest_deadline,
+                               zx_time_t latest_deadline);
 
-  // A helper function for PrintTimerQueues that prints all of the timers in the given timer_list
+  // Inserts the monotonic |timer| into the queue of a cpu other than |local_cpu| that already has
+  // a timer scheduled within [earliest_deadline, latest_deadline], coalescing with it. Returns
+  // false, leaving |timer| untouched, if there is no such queue.
+  static bool InsertOnRemoteQueue(Timer* timer, cpu_num_t local_cpu, zx_time_t earliest_deadline,
+                                  zx_time_t latest_deadline);
+
+  // A helper function for Insert that inserts the given timer into the given timer tree,
+  // coalescing it with the closest existing timer within its slack.
+  static void InsertIntoTimerTree(TimerTree& timers, Timer* timer, zx_time_t earliest_deadline,
+                                  zx_time_t latest_deadline);
+
+  // A helper function for TransitionOffCpu that moves all timers from src_timers to dst_timers,
+  // which must belong to this TimerQueue. Returns the Timer at the head of dst_timers if it
+  // changed, otherwise returns nullopt.
+  ktl::optional<Timer*> TransitionTimerTree(TimerTree& src_timers, TimerTree& dst_timers)
+      TA_REQ(lock_);
+
+  // A helper function for PrintTimerQueues that prints all of the timers in the given timer tree
   // into the given buffer. Also takes in the current time, which is either a zx_instant_mono_t or a
-  // zx_instant_boot_t depending on the timeline the timer_list is operating on.
+  // zx_instant_boot_t depending on the timeline the timer tree is operating on.
   template <typename TimestampType>
-  static void PrintTimerList(TimestampType now, fbl::DoublyLinkedList<Timer*>& timer_list,
-                             StringFile& buffer);
+  static void PrintTimerTree(TimestampType now, TimerTree& timers, StringFile& buffer);
 
   // The UpdatePlatformTimer* methods are used to update the platform's oneshot timer to the
   // minimum of the existing deadline (stored in next_timer_deadline_) and the given new_deadline.
@@ -242,14 +268,26 @@ class TimerQueue {
   // This is called by Tick(), and processes all timers with scheduled times less than now.
   // Once it's done, the scheduled time of the timer at the front of the queue is returned.
   template <typename TimestampType>
-  static void TickInternal(TimestampType now, cpu_num_t cpu,
-                           fbl::DoublyLinkedList<Timer*>* timer_list);
+  void TickInternal(TimestampType now, cpu_num_t cpu, TimerTree* timers) TA_EXCL(lock_);
 
-  // Timers on the monotonic timeline are placed in this list.
-  fbl::DoublyLinkedList<Timer*> monotonic_timer_list_ TA_GUARDED(Timer::TimerLock::Get());
-
-  // Timers on the boot timeline are placed in this list.
-  fbl::DoublyLinkedList<Timer*> boot_timer_list_ TA_GUARDED(Timer::TimerLock::Get());
+  // Guards this TimerQueue's timer trees and the |queue_| field of the timers on them.
+  //
+  // Timers are set on, and fire from, the local cpu's queue, so this lock is normally only
+  // contended by cross-cpu cancellation. It is nestable because TransitionOffCpu holds the locks
+  // of both queues involved.
+  mutable DECLARE_SPINLOCK_WITH_TYPE(TimerQueue, MonitoredSpinLock, lockdep::LockFlagsNestable)
+      lock_;
+
+  // Timers on the monotonic timeline are placed in this tree.
+  TimerTree monotonic_timers_ TA_GUARDED(lock_);
+
+  // Timers on the boot timeline are placed in this tree.
+  TimerTree boot_timers_ TA_GUARDED(lock_);
+
+  // The scheduled time of the head of |monotonic_timers_|, or ZX_TIME_INFINITE if it is empty.
+  // Written under |lock_| but read without it by other cpus looking for a wakeup to coalesce with,
+  // so it is only a hint.
+  ktl::atomic<zx_instant_mono_t> monotonic_head_hint_{ZX_TIME_INFINITE};
 
   // This TimerQueue's preemption deadline. ZX_TIME_INFINITE means not set.
   zx_instant_mono_t preempt_timer_deadline_ = ZX_TIME_INFINITE;
@@ -82,7 +82,8 @@ inline zx_status_t WaitQueue::BlockEtcPreamble(Thread* const current_thread,
 }
 
 inline zx_status_t WaitQueue::BlockEtcPostamble(Thread* const current_thread,
-                                                const Deadline& deadline)
+                                                const Deadline& deadline, uintptr_t caller,
+                                                zx_koid_t owner_tid)
     TA_REQ(current_thread->get_lock()) TA_EXCL(get_lock()) {
   DEBUG_ASSERT(current_thread == Thread::Current::Get());
   Timer timer;
@@ -92,6 +93,11 @@ inline zx_status_t WaitQueue::BlockEtcPostamble(Thread* const current_thread,
     timer.Set(deadline, &WaitQueue::TimeoutHandler, (void*)current_thread);
   }
 
+  // Only read the clock when the block is going to be traced.  A block which
+  // starts before tracing is enabled goes unrecorded.
+  const zx_instant_boot_ticks_t block_start =
+      KTrace::CategoryEnabled("kernel:sched"_category) ? KTrace::Timestamp() : 0;
+
   Scheduler::Block(current_thread);
 
   // we don't really know if the timer fired or not, so it's better safe to try to cancel it
@@ -100,7 +106,15 @@ inline zx_status_t WaitQueue::BlockEtcPostamble(Thread* const current_thread,
   }
 
   current_thread->wait_queue_state().interruptible_ = Interruptible::No;
-  return current_thread->wait_queue_state().blocked_status_;
+  const zx_status_t blocked_status = current_thread->wait_queue_state().blocked_status_;
+
+  // Record how long the thread spent off CPU, where it blocked, and who it was
+  // waiting on, so that lock waits and other stalls are visible in traces.
+  if (block_start != 0) {
+    KTRACE_COMPLETE("kernel:sched", "blocked", block_start, ("caller", caller),
+                    ("owner_tid", owner_tid), ("status", blocked_status));
+  }
+  return blocked_status;
 }
 
 #endif  // ZIRCON_KERNEL_INCLUDE_KERNEL_WAIT_QUEUE_INTERNAL_H_
@@ -8,6 +8,7 @@
 #define ZIRCON_KERNEL_INCLUDE_LIB_KTRACE_H_
 
 #include <align.h>
+#include <lib/fxt/fields.h>
 #include <lib/fxt/interned_category.h>
 #include <lib/fxt/interned_string.h>
 #include <lib/fxt/record_types.h>
@@ -671,6 +672,21 @@ class KTrace {
       return buffer_.Read(copy_fn, len);
     }
 
+    // Returns the number of bytes currently available to read from the underlying SpscBuffer.
+    uint32_t AvailableData() const { return buffer_.AvailableData(); }
+
+    // Sets whether a full buffer overwrites its oldest records instead of dropping new ones.
+    // Overwriting moves the read pointer from the writer, so reads must not run while writes are
+    // enabled in this mode. This must be set before writes are enabled.
+    void set_overwrite(bool overwrite) { overwrite_ = overwrite; }
+
+    // Returns a mark identifying the current end of the data in the buffer, and moves everything
+    // written after a given mark to the front of the buffer. Used to place metadata written at
+    // the end of a circular trace ahead of the records that it describes. These must only be
+    // called by the writer, and with no concurrent reader.
+    uint32_t WriteMark() const { return buffer_.WriteMark(); }
+    void RotateToFront(uint32_t mark) { buffer_.RotateToFront(mark); }
+
     // We interpose ourselves in the Reserve path to ensure that we can emit a record containing
     // the dropped records statistics if we need to.
     zx::result<Reservation> Reserve(uint32_t size) {
@@ -687,8 +703,12 @@ class KTrace {
         total_size += sizeof(DroppedRecordDurationEvent);
       }
 
-      // Pass the Reserve call on to the SpscBuffer.
+      // Pass the Reserve call on to the SpscBuffer. In overwrite mode, make room by discarding
+      // the oldest records and try again.
       zx::result<Reservation> res = buffer_.Reserve(total_size);
+      if (res.is_error() && overwrite_ && buffer_.DiscardOldest(total_size, RecordSizeBytes)) {
+        res = buffer_.Reserve(total_size);
+      }
       if (res.is_error()) {
         // If the reservation failed, then we did not have enough space in this buffer, and the
         // record we were attempting to write will be dropped. Add the "size" to the dropped record
@@ -802,6 +822,11 @@ class KTrace {
       };
     }
 
+    // Returns the size in bytes of the FXT record starting with the given header.
+    static uint32_t RecordSizeBytes(uint64_t header) {
+      return fxt::RecordFields::RecordSize::Get<uint32_t>(header) * sizeof(uint64_t);
+    }
+
     // Adds a dropped record of the given size to the tracked statistics.
     void TrackDroppedRecord(uint32_t size) {
       if (!first_dropped_.has_value()) {
@@ -826,6 +851,9 @@ class KTrace {
     // be stored in a single 64-bit word in the FXT record we emit when space is available.
     uint32_t num_dropped_{0};
     uint32_t bytes_dropped_{0};
+
+    // True if the oldest records are overwritten when the buffer is full.
+    bool overwrite_{false};
   };
 
  public:
@@ -917,9 +945,23 @@ class KTrace {
   // * If ptr is nullptr, the number of bytes needed to read all of the available data is returned.
   // * Otherwise:
   //    * On success, this function returns the number of bytes that were read into the buffer.
-  //    * On failure, a zx_status_t error code is returned.
+  //    * On failure, a zx_status_t error code is returned. A circular trace must be stopped before
+  //      it can be read, and reading one that is still running fails with ZX_ERR_BAD_STATE.
   zx::result<size_t> ReadUser(user_out_ptr<void> ptr, uint32_t off, size_t len);
 
+  // Stops new records from being added to a circular trace, so that the records leading up to
+  // this point are preserved until the trace is stopped and read. Does nothing if the current
+  // trace is not circular.
+  //
+  // This is meant to be called when the kernel notices a problem worth investigating, such as an
+  // out of memory condition or a lockup. It only performs an atomic store, and so can be called
+  // from any context, including with interrupts disabled.
+  void FreezeFlightRecorder() {
+    if (circular_.load(ktl::memory_order_acquire)) {
+      set_categories_bitmask(0u);
+    }
+  }
+
   // Reserve reserves a slot of memory to write a record into.
   //
   // This is likely not the method you want to use. In fact, it is exposed as a public method only
@@ -1199,16 +1241,15 @@ class KTrace {
 
   // Initializes the KTrace instance. Calling any other function on KTrace before calling Init
   // should be a no-op. This should only be called from the InitHook.
-  void Init(uint32_t bufsize, uint32_t initial_grpmask) TA_EXCL(lock_);
+  void Init(uint32_t bufsize, uint32_t initial_grpmask, bool circular = false) TA_EXCL(lock_);
 
   // Allocate our per-CPU buffers.
   zx_status_t Allocate() TA_REQ(lock_);
 
   // Start collecting trace data.
-  // `action` must be one of KTRACE_ACTION_START or KTRACE_ACTION_START_CIRCULAR.
+  // `action` must be one of KTRACE_ACTION_START or KTRACE_ACTION_START_CIRCULAR. It only takes
+  // effect when starting a new trace; changing the categories of a running trace keeps its mode.
   // `categories` is the set of categories to trace. Cannot be zero.
-  // TODO(https://fxbug.dev/404539312): The `action` argument is unnecessary once we switch to
-  // the per-CPU streaming implementation by default.
   zx_status_t Start(uint32_t action, uint32_t categories) TA_REQ(lock_);
   // Stop collecting trace data.
   zx_status_t Stop() TA_REQ(lock_);
@@ -1217,16 +1258,26 @@ class KTrace {
   zx_status_t Rewind() TA_REQ(lock_);
 
   // Returns true if the given category is enabled for tracing.
+  //
+  // This is evaluated at every tracepoint, so the common case of tracing being disabled entirely
+  // is checked first. A disabled tracepoint then costs a single load of the bitmask and a branch,
+  // and does not touch the category, which is likely to be cold.
   bool IsCategoryEnabled(const fxt::InternedCategory& category) const {
+    const uint32_t enabled_mask = categories_bitmask();
+    if (likely(enabled_mask == 0)) {
+      return false;
+    }
     const uint32_t bit_number = category.index();
     if (bit_number == fxt::InternedCategory::kInvalidIndex) {
       return false;
     }
     const uint32_t bitmask = 1u << bit_number;
-    return (bitmask & categories_bitmask()) != 0;
+    return (bitmask & enabled_mask) != 0;
   }
 
-  // Emits metadata records into the trace buffer.
+  // Emits metadata records into the trace buffer. For a circular trace, this happens when the trace
+  // is stopped, and the records are moved to the front of the boot CPU's buffer so that they are
+  // read before the records that they describe.
   // This method is declared virtual to facilitate testing.
   virtual void ReportMetadata();
 
@@ -1273,6 +1324,12 @@ class KTrace {
   // Stores whether writes are currently enabled.
   ktl::atomic<bool> writes_enabled_{false};
 
+  // True if the current, or most recent, trace was started with KTRACE_ACTION_START_CIRCULAR, in
+  // which case the per-CPU buffers overwrite their oldest records when full. Only modified while
+  // holding the lock_ and with writes disabled, but read without the lock_ by
+  // FreezeFlightRecorder and ReportMetadata.
+  ktl::atomic<bool> circular_{false};
+
   // The buffers used to store data when using per-CPU mode.
   ktl::unique_ptr<PerCpuBuffer[]> percpu_buffers_{nullptr};
   // The number of buffers in percpu_buffers_. This is logically equivalent to the number of cores.
@@ -0,0 +1,50 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_INCLUDE_LK_BOOT_TIMELINE_H_
+#define ZIRCON_KERNEL_INCLUDE_LK_BOOT_TIMELINE_H_
+
+#include <stdint.h>
+
+// The points of the kernel's part of boot that are sampled for the boot timeline, continuing the
+// physboot samples carried in PhysBootTimes. Each point is exported as a boot.timeline.* kcounter
+// and, along with the physboot samples, as a "kernel:boot" ktrace instant event, so that the time
+// from the ZBI entry to the launch of userboot can be broken down by phase.
+//
+// Unless noted otherwise, a point is sampled once the init hooks of the corresponding level, and
+// the call into the arch or platform layer that precedes them, have completed.
+enum class BootTimelinePoint : uint8_t {
+  kEarliest,
+  kArchEarly,
+  kPmmInitStart,  // PmmNode::Init begins, from within the platform's early init.
+  kPmmInitEnd,    // The PMM arenas are added and the boot reservations applied.
+  kPlatformEarly,
+  kArchPrevm,
+  kPlatformPrevm,
+  kVmPreheap,
+  kHeap,
+  kVm,
+  kTopology,
+  kKernel,
+  kThreading,  // The bootstrap thread is running.
+  kArch,
+  kPlatform,
+  kArchLate,
+  kUserboot,  // userboot has been launched.
+  kInit,      // The last init level has completed.
+  kCount,
+};
+
+// Samples the current time for |point|. Must only be called on the boot CPU, once per point. Safe
+// to call before the platform timer is set up.
+void boot_timeline_sample(BootTimelinePoint point);
+
+// Exports the physboot samples and the points sampled so far. Points sampled after this are
+// exported as they are sampled. Called once on the boot CPU, after ktrace is initialized and
+// before the physboot hand-off ends.
+void boot_timeline_publish();
+
+#endif  // ZIRCON_KERNEL_INCLUDE_LK_BOOT_TIMELINE_H_
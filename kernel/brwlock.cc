@@ -686,4 +686,55 @@ void BrwLock<PI>::ContendedReadUpgrade() {
 template class BrwLock<BrwLockEnablePi::Yes>;
 template class BrwLock<BrwLockEnablePi::No>;
 
+BrwLockPercpu::~BrwLockPercpu() {
+  DEBUG_ASSERT(ReaderCount() == 0);
+  DEBUG_ASSERT(!writer_.load(ktl::memory_order_relaxed));
+}
+
+int64_t BrwLockPercpu::ReaderCount() const {
+  int64_t count = 0;
+  for (const ReaderSlot& slot : reader_slots_) {
+    count += slot.count.load(ktl::memory_order_seq_cst);
+  }
+  return count;
+}
+
+void BrwLockPercpu::ContendedReadAcquire(ktl::atomic<int64_t>& count)
+    TA_NO_THREAD_SAFETY_ANALYSIS {
+  LOCK_TRACE_DURATION("BrwLockPercpu::ContendedReadAcquire");
+
+  // Back out so that the writer can drain, then wait for it by queueing on the
+  // writer mutex. No writer can be active while we hold that mutex, so the
+  // counter can be taken again without checking |writer_|.
+  count.fetch_sub(1, ktl::memory_order_seq_cst);
+  Thread::Current::preemption_state().PreemptReenable();
+  drained_.Signal();
+
+  writer_lock_.Acquire();
+  LocalCount().fetch_add(1, ktl::memory_order_relaxed);
+  writer_lock_.Release();
+}
+
+void BrwLockPercpu::WriteAcquire() TA_NO_THREAD_SAFETY_ANALYSIS {
+  DEBUG_ASSERT(!arch_blocking_disallowed());
+  canary_.Assert();
+
+  writer_lock_.Acquire();
+  // Pairs with the loads of |writer_| in ReadAcquire and ReadRelease. Readers
+  // arriving from here on back out, and readers leaving signal |drained_|.
+  writer_.store(true, ktl::memory_order_seq_cst);
+  while (ReaderCount() != 0) {
+    LOCK_TRACE_DURATION("BrwLockPercpu::ContendedWriteAcquire");
+    drained_.Wait(Deadline::infinite());
+  }
+}
+
+void BrwLockPercpu::WriteRelease() TA_NO_THREAD_SAFETY_ANALYSIS {
+  canary_.Assert();
+  DEBUG_ASSERT(writer_.load(ktl::memory_order_relaxed));
+
+  writer_.store(false, ktl::memory_order_release);
+  writer_lock_.Release();
+}
+
 }  // namespace internal
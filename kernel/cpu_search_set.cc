@@ -152,6 +152,7 @@ CpuSearchSet::ClusterSet CpuSearchSet::DoAutoCluster(size_t cpu_count, const Cpu
       for (cpu_num_t j = 0; j < cpu_count; j++) {
         if (cluster_map[j] == i) {
           cluster.members[member_index] = j;
+          cluster.mask.set(j);
           cpu_to_cluster_map[j] = {&cluster, member_index};
           member_index++;
         }
@@ -0,0 +1,142 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "kernel/deadline_admission.h"
+
+#include <inttypes.h>
+#include <lib/boot-options/boot-options.h>
+#include <lib/console.h>
+#include <lib/counters.h>
+#include <stdio.h>
+#include <zircon/errors.h>
+
+#include <kernel/mutex.h>
+#include <kernel/percpu.h>
+#include <kernel/scheduler.h>
+#include <ktl/array.h>
+
+#include <ktl/enforce.h>
+
+KCOUNTER(counter_admitted, "scheduler.deadline_admission.admitted")
+KCOUNTER(counter_rejected, "scheduler.deadline_admission.rejected")
+
+namespace {
+
+DECLARE_SINGLETON_MUTEX(AdmissionLock);
+
+// The utilization reserved on each CPU by admitted deadline threads.
+ktl::array<SchedUtilization, SMP_MAX_CPUS> reserved_utilization TA_GUARDED(AdmissionLock::Get());
+
+// Returns the utilization that the deadline threads admitted to |cpu| may add
+// up to, given its current processing rate.
+SchedUtilization Capacity(cpu_num_t cpu) {
+  const SchedProcessingRate processing_rate = Scheduler::Get(cpu)->exported_processing_rate();
+  const SchedUtilization limit{
+      ffl::FromRatio<uint64_t>(gBootOptions->scheduler_deadline_admission_limit, 100)};
+  return SchedUtilization{limit * processing_rate};
+}
+
+SchedUtilization RemainingCapacityLocked(cpu_num_t cpu) TA_REQ(AdmissionLock::Get()) {
+  return Capacity(cpu) - reserved_utilization[cpu];
+}
+
+// Returns the active CPU in |affinity| with the most remaining capacity, or
+// INVALID_CPU if there is none.
+cpu_num_t FindLeastReservedCpu(cpu_mask_t affinity) TA_REQ(AdmissionLock::Get()) {
+  const cpu_mask_t candidates = affinity & Scheduler::PeekActiveMask();
+  cpu_num_t best_cpu = INVALID_CPU;
+  SchedUtilization best_remaining{0};
+  for (cpu_num_t cpu = 0; cpu < percpu::processor_count(); cpu++) {
+    if (!candidates.test(cpu)) {
+      continue;
+    }
+    const SchedUtilization remaining = RemainingCapacityLocked(cpu);
+    if (best_cpu == INVALID_CPU || remaining > best_remaining) {
+      best_cpu = cpu;
+      best_remaining = remaining;
+    }
+  }
+  return best_cpu;
+}
+
+}  // namespace
+
+bool DeadlineAdmission::IsEnabled() { return gBootOptions->scheduler_deadline_admission_limit > 0; }
+
+zx::result<DeadlineAdmission::Reservation> DeadlineAdmission::Admit(SchedUtilization utilization,
+                                                                     cpu_mask_t affinity,
+                                                                     const Reservation& current) {
+  DEBUG_ASSERT(IsEnabled());
+  DEBUG_ASSERT(utilization > 0);
+
+  Guard<Mutex> guard{AdmissionLock::Get()};
+
+  // Make the current reservation's capacity available while looking for a CPU,
+  // restoring it if none is found.
+  if (current.is_valid()) {
+    reserved_utilization[current.cpu] -= current.utilization;
+  }
+
+  const cpu_num_t cpu = FindLeastReservedCpu(affinity);
+  if (cpu == INVALID_CPU || utilization > RemainingCapacityLocked(cpu)) {
+    if (current.is_valid()) {
+      reserved_utilization[current.cpu] += current.utilization;
+    }
+    counter_rejected.Add(1);
+    return zx::error(cpu == INVALID_CPU ? ZX_ERR_INVALID_ARGS : ZX_ERR_NO_RESOURCES);
+  }
+
+  reserved_utilization[cpu] += utilization;
+  counter_admitted.Add(1);
+  return zx::ok(Reservation{.cpu = cpu, .utilization = utilization});
+}
+
+void DeadlineAdmission::Release(const Reservation& reservation) {
+  if (!reservation.is_valid()) {
+    return;
+  }
+  Guard<Mutex> guard{AdmissionLock::Get()};
+  reserved_utilization[reservation.cpu] -= reservation.utilization;
+  DEBUG_ASSERT(reserved_utilization[reservation.cpu] >= 0);
+}
+
+SchedUtilization DeadlineAdmission::RemainingCapacity(cpu_num_t cpu) {
+  DEBUG_ASSERT(cpu < percpu::processor_count());
+  Guard<Mutex> guard{AdmissionLock::Get()};
+  return RemainingCapacityLocked(cpu);
+}
+
+SchedUtilization DeadlineAdmission::RemainingCapacity(cpu_mask_t affinity) {
+  Guard<Mutex> guard{AdmissionLock::Get()};
+  const cpu_num_t cpu = FindLeastReservedCpu(affinity);
+  if (cpu == INVALID_CPU) {
+    return SchedUtilization{0};
+  }
+  return ktl::max(RemainingCapacityLocked(cpu), SchedUtilization{0});
+}
+
+static int cmd_deadline_admission(int argc, const cmd_args* argv, uint32_t flags) {
+  if (!DeadlineAdmission::IsEnabled()) {
+    printf("deadline admission control is disabled\n");
+    return 0;
+  }
+
+  Guard<Mutex> guard{AdmissionLock::Get()};
+  printf("%4s %12s %12s %12s\n", "cpu", "capacity", "reserved", "remaining");
+  for (cpu_num_t cpu = 0; cpu < percpu::processor_count(); cpu++) {
+    // Utilizations are printed in thousandths of the CPU's maximum rate.
+    const SchedUtilization capacity = Capacity(cpu);
+    const SchedUtilization reserved = reserved_utilization[cpu];
+    printf("%4u %12" PRId64 " %12" PRId64 " %12" PRId64 "\n", cpu,
+           ffl::Round<int64_t>(capacity * 1000), ffl::Round<int64_t>(reserved * 1000),
+           ffl::Round<int64_t>((capacity - reserved) * 1000));
+  }
+  return 0;
+}
+
+STATIC_COMMAND_START
+STATIC_COMMAND("dladmit", "dump deadline admission control reservations", &cmd_deadline_admission)
+STATIC_COMMAND_END(dladmit)
@@ -17,6 +17,7 @@
 
 #include <debug.h>
 #include <inttypes.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/concurrent/copy.h>
 #include <lib/console.h>
 #include <lib/kconcurrent/chainlock_transaction.h>
@@ -32,6 +33,7 @@
 #include <kernel/cpu.h>
 #include <kernel/mp.h>
 #include <kernel/percpu.h>
+#include <kernel/sched_histogram.h>
 #include <kernel/scheduler.h>
 #include <kernel/thread.h>
 #include <vm/vm.h>
@@ -136,6 +138,10 @@ static int cmd_threadstats(int argc, const cmd_args* argv, uint32_t flags) {
     printf("\tyields: %lu\n", percpu.stats.yields);
     printf("\ttimer interrupts: %lu\n", percpu.stats.timer_ints);
     printf("\ttimers: %lu\n", percpu.stats.timers);
+    if (gBootOptions->scheduler_latency_histograms) {
+      DumpSchedHistogram("wakeup latency (ns)", percpu.stats.wakeup_latency);
+      DumpSchedHistogram("run burst (ns)", percpu.stats.run_burst);
+    }
   }
 
   return 0;
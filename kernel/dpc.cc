@@ -7,12 +7,14 @@
 #include "kernel/dpc.h"
 
 #include <assert.h>
+#include <inttypes.h>
 #include <lib/kconcurrent/chainlock_transaction.h>
 #include <trace.h>
 #include <zircon/errors.h>
 #include <zircon/listnode.h>
 #include <zircon/types.h>
 
+#include <arch/interrupt.h>
 #include <arch/ops.h>
 #include <kernel/auto_preempt_disabler.h>
 #include <kernel/event.h>
@@ -38,21 +40,19 @@ constexpr SchedulerState::BaseProfile kProfileLowLatency{
 
 }  // namespace
 
-void Dpc::Invoke() { func_(this); }
-
 void DpcRunner::InitForCurrentCpu() {
   if constexpr (DEBUG_ASSERT_IMPLEMENTED) {
     Thread* const current_thread = Thread::Current::Get();
     SingleChainLockGuard guard{IrqSaveOption, current_thread->get_lock(),
                                CLT_TAG("DpcRunner::InitForCurrentCpu")};
     const cpu_mask_t mask = current_thread->scheduler_state().hard_affinity();
-    DEBUG_ASSERT_MSG(ktl::popcount(mask) == 1, "mask %#x", mask);
+    DEBUG_ASSERT_MSG(mask.count() == 1, "mask %#" PRIx64, mask.word(0));
   }
 
   const cpu_num_t cpu = arch_curr_cpu_num();
 
   {
-    Guard<SpinLock, IrqSave> guard{Dpc::Lock::Get()};
+    Guard<SpinLock, IrqSave> guard{&lock_};
 
     // This cpu's DpcRunner was initialized on a previous hotplug event.
     if (initialized_) {
@@ -77,27 +77,55 @@ zx_status_t DpcRunner::Shutdown(zx_instant_mono_t deadline) {
 }
 
 void DpcRunner::TransitionOffCpu(DpcRunner& source) {
-  Guard<SpinLock, IrqSave> guard{Dpc::Lock::Get()};
-
-  // |source|'s cpu is shutting down. Assert that we are migrating to the current cpu.
-  DEBUG_ASSERT(cpu_ == arch_curr_cpu_num());
-  DEBUG_ASSERT(cpu_ != source.cpu_);
+  DEBUG_ASSERT(this != &source);
 
-  source.queue_general_.TakeFromLocked(source.queue_general_);
-  source.queue_low_latency_.TakeFromLocked(source.queue_low_latency_);
+  bool signal_general;
+  bool signal_low_latency;
+  {
+    // Both runners' locks are always taken in address order.
+    InterruptDisableGuard irqd;
+    const bool source_first =
+        reinterpret_cast<uintptr_t>(&source) < reinterpret_cast<uintptr_t>(this);
+    DpcRunner& first = source_first ? source : *this;
+    DpcRunner& second = source_first ? *this : source;
+    Guard<SpinLock, NoIrqSave> first_guard{AssertOrderedLock, &first.lock_, 0};
+    Guard<SpinLock, NoIrqSave> second_guard{AssertOrderedLock, &second.lock_, 1};
+    AssertHeld(lock_);
+    AssertHeld(source.lock_);
+
+    // |source|'s cpu is shutting down. Assert that we are migrating to the current cpu.
+    DEBUG_ASSERT(cpu_ == arch_curr_cpu_num());
+    DEBUG_ASSERT(cpu_ != source.cpu_);
+
+    signal_general = queue_general_.TakeFrom(source.queue_general_);
+    signal_low_latency = queue_low_latency_.TakeFrom(source.queue_low_latency_);
+
+    source.initialized_ = false;
+    source.cpu_ = INVALID_CPU;
+  }
 
-  source.initialized_ = false;
-  source.cpu_ = INVALID_CPU;
+  // Wake our workers for the Dpcs they inherited outside of the locks, as signaling may acquire
+  // chainlocks.
+  if (signal_general) {
+    queue_general_.Signal();
+  }
+  if (signal_low_latency) {
+    queue_low_latency_.Signal();
+  }
 }
 
 zx_status_t DpcRunner::Enqueue(Dpc& dpc, QueueType type) {
+  // Claim the Dpc.  Whoever wins owns |dpc.next_| until the worker copies it.
+  if (dpc.queued_.exchange(true, ktl::memory_order_acquire)) {
+    return ZX_ERR_ALREADY_EXISTS;
+  }
+
   DpcRunner::Queue* queue = nullptr;
+  bool was_empty;
   {
-    Guard<SpinLock, IrqSave> guard{Dpc::Lock::Get()};
-
-    if (dpc.InContainer()) {
-      return ZX_ERR_ALREADY_EXISTS;
-    }
+    // Stay on this cpu until the Dpc is published so that it cannot land on the queue of a cpu
+    // that has already been transitioned off.
+    InterruptDisableGuard irqd;
 
     // Select the queue.
     DpcRunner& runner = percpu::GetCurrent().dpc_runner;
@@ -112,13 +140,16 @@ zx_status_t DpcRunner::Enqueue(Dpc& dpc, QueueType type) {
         panic("unknown QueueType %u", static_cast<uint32_t>(type));
     };
 
-    // Put this Dpc at the tail of the list. Signal the worker outside the lock.
-    queue->EnqueueLocked(dpc);
+    // Publish this Dpc.  Once it is on the stack the worker may run it at any time, so |dpc|
+    // must not be touched again.
+    was_empty = queue->Push(dpc);
   }
 
-  // Signal outside of the lock to avoid lock order inversion with the thread
-  // lock.
-  queue->Signal();
+  // The worker drains its whole stack before it waits again, so it only needs waking when the
+  // stack goes from empty to non-empty.
+  if (was_empty) {
+    queue->Signal();
+  }
   return ZX_OK;
 }
 
@@ -137,7 +168,7 @@ void DpcRunner::Queue::Init(cpu_num_t cpu, const char* name_prefix,
   thread->SetCpuAffinity(cpu_num_to_mask(cpu));
 
   {
-    Guard<SpinLock, IrqSave> guard{Dpc::Lock::Get()};
+    Guard<SpinLock, IrqSave> guard{&lock_};
     thread_ = thread;
   }
 
@@ -148,13 +179,13 @@ zx_status_t DpcRunner::Queue::Shutdown(zx_instant_mono_t deadline) {
   Thread* t;
   Event* event;
   {
-    Guard<SpinLock, IrqSave> guard{Dpc::Lock::Get()};
+    Guard<SpinLock, IrqSave> guard{&lock_};
 
     DEBUG_ASSERT(thread_ != nullptr);
 
     // Ask the thread to terminate.
-    DEBUG_ASSERT(!stop_);
-    stop_ = true;
+    [[maybe_unused]] const bool was_stopped = stop_.exchange(true, ktl::memory_order_release);
+    DEBUG_ASSERT(!was_stopped);
 
     // Remember this Event so we can signal it outside the spinlock.
     event = &event_;
@@ -170,53 +201,95 @@ zx_status_t DpcRunner::Queue::Shutdown(zx_instant_mono_t deadline) {
   return t->Join(nullptr, deadline);
 }
 
-void DpcRunner::Queue::TakeFromLocked(Queue& source) {
-  // The thread must have already been stopped by a call to |Shutdown|.
-  DEBUG_ASSERT(source.stop_);
-  DEBUG_ASSERT(source.thread_ == nullptr);
+bool DpcRunner::Queue::TakeFrom(Queue& source) {
+  // The thread must have already been stopped by a call to |Shutdown|.  It has been joined, so
+  // its |pending_| list is ours to take.
+  DEBUG_ASSERT(source.stop_.load(ktl::memory_order_relaxed));
+
+  // Collect |source|'s Dpcs newest first: its stack as it stands, followed by its |pending_|
+  // list reversed.  The oldest pending Dpc ends up last.
+  Dpc* older = nullptr;
+  Dpc* last = source.pending_;
+  while (source.pending_ != nullptr) {
+    Dpc* dpc = source.pending_;
+    source.pending_ = dpc->next_;
+    dpc->next_ = older;
+    older = dpc;
+  }
+  Dpc* first = source.head_.exchange(nullptr, ktl::memory_order_acquire);
+  if (first == nullptr) {
+    first = older;
+  } else {
+    Dpc* newer = first;
+    while (newer->next_ != nullptr) {
+      newer = newer->next_;
+    }
+    newer->next_ = older;
+    if (last == nullptr) {
+      last = newer;
+    }
+  }
 
-  // Move the contents of |source.list_| to the back of our |list_|.
-  auto back = list_.end();
-  list_.splice(back, source.list_);
+  // Queue them behind our own Dpcs.
+  const bool was_empty = first != nullptr && PushChain(first, last);
 
   // Reset |source|'s state so we can restart Dpc processing if its cpu comes back online.
   source.event_.Unsignal();
-  DEBUG_ASSERT(source.list_.is_empty());
-  source.stop_ = false;
+  source.stop_.store(false, ktl::memory_order_relaxed);
+  return was_empty;
 }
 
-void DpcRunner::Queue::EnqueueLocked(Dpc& dpc) { list_.push_back(&dpc); }
-void DpcRunner::Queue::Signal() { event_.Signal(); }
+bool DpcRunner::Queue::PushChain(Dpc* first, Dpc* last) {
+  Dpc* head = head_.load(ktl::memory_order_relaxed);
+  do {
+    last->next_ = head;
+  } while (!head_.compare_exchange_weak(head, first, ktl::memory_order_release,
+                                        ktl::memory_order_relaxed));
+  return head == nullptr;
+}
 
 int DpcRunner::Queue::DoWork() {
   for (;;) {
-    // Wait for a Dpc to fire.
-    [[maybe_unused]] zx_status_t err = event_.Wait();
-    DEBUG_ASSERT(err == ZX_OK);
-
-    ktl::optional<Dpc> dpc_local;
-    {
-      Guard<SpinLock, IrqSave> guard{Dpc::Lock::Get()};
-
-      if (stop_) {
-        return 0;
-      }
-
-      // Pop a Dpc off our list, and make a local copy.
-      Dpc* dpc = list_.pop_front();
+    if (stop_.load(ktl::memory_order_acquire)) {
+      return 0;
+    }
 
-      // If our list is now empty, unsignal the event so we block until it is.
-      if (!dpc) {
-        event_.Unsignal();
+    if (pending_ == nullptr) {
+      // Unsignal before looking at the stack.  A producer that pushes onto it after we have taken
+      // it sees it empty and signals again, so the wakeup cannot be lost.
+      event_.Unsignal();
+      Dpc* dpc = head_.exchange(nullptr, ktl::memory_order_acquire);
+      if (dpc == nullptr) {
+        // |Shutdown| sets |stop_| before signaling, so check it again now that its signal may
+        // have been cleared.
+        if (stop_.load(ktl::memory_order_acquire)) {
+          return 0;
+        }
+
+        // Wait for a Dpc to fire.
+        [[maybe_unused]] zx_status_t err = event_.Wait();
+        DEBUG_ASSERT(err == ZX_OK);
         continue;
       }
 
-      // Copy the Dpc to the stack.
-      dpc_local.emplace(*dpc);
+      // The stack is newest first.  Reverse it so that Dpcs run in the order they were queued.
+      while (dpc != nullptr) {
+        Dpc* next = dpc->next_;
+        dpc->next_ = pending_;
+        pending_ = dpc;
+        dpc = next;
+      }
     }
 
+    // Pop a Dpc off our list and make a local copy.  Read its link before releasing it, as it
+    // may be requeued as soon as |queued_| is cleared.
+    Dpc* dpc = pending_;
+    pending_ = dpc->next_;
+    Dpc dpc_local(*dpc);
+    dpc->queued_.store(false, ktl::memory_order_release);
+
     // Call the Dpc.
-    dpc_local->Invoke();
+    dpc_local.Invoke();
   }
 
   return 0;
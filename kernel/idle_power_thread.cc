@@ -346,7 +346,7 @@ zx_status_t IdlePowerThread::TransitionAllActiveToSuspend(zx_instant_boot_t resu
 
   const Deadline suspend_timeout_at = Deadline::after_mono(ZX_MIN(1));
   cpu_mask_t cpus_to_suspend = cpus_active_before_suspend;
-  while (cpus_to_suspend != 0) {
+  while (cpus_to_suspend.any()) {
     const cpu_num_t cpu_id = highest_cpu_set(cpus_to_suspend);
     const TransitionResult active_to_suspend_result =
         percpu::Get(cpu_id).idle_power_thread.TransitionFromTo(State::Active, State::Suspend,
@@ -360,7 +360,7 @@ zx_status_t IdlePowerThread::TransitionAllActiveToSuspend(zx_instant_boot_t resu
     cpus_to_suspend &= ~cpu_num_to_mask(cpu_id);
   }
 
-  if (cpus_to_suspend != 0) {
+  if (cpus_to_suspend.any()) {
     dprintf(INFO, "Aborting suspend and resuming non-boot CPUs...\n");
   } else {
     dprintf(INFO, "Done suspending non-boot CPUs.\n");
@@ -443,7 +443,7 @@ zx_status_t IdlePowerThread::TransitionAllActiveToSuspend(zx_instant_boot_t resu
 
   const Deadline resume_timeout_at = Deadline::after_mono(ZX_MIN(1));
   cpu_mask_t cpus_to_resume = cpus_active_before_suspend ^ cpus_to_suspend;
-  while (cpus_to_resume != 0) {
+  while (cpus_to_resume.any()) {
     const cpu_num_t cpu_id = highest_cpu_set(cpus_to_resume);
     const TransitionResult suspend_to_active_result =
         percpu::Get(cpu_id).idle_power_thread.TransitionFromTo(State::Suspend, State::Active,
@@ -456,7 +456,7 @@ zx_status_t IdlePowerThread::TransitionAllActiveToSuspend(zx_instant_boot_t resu
 
     cpus_to_resume &= ~cpu_num_to_mask(cpu_id);
   }
-  DEBUG_ASSERT(cpus_to_resume == 0);
+  DEBUG_ASSERT(cpus_to_resume.none());
 
   dprintf(INFO, "Done resuming non-boot CPUs.\n");
   return ZX_OK;
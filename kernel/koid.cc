@@ -0,0 +1,34 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "kernel/koid.h"
+
+#include <zircon/compiler.h>
+
+#include <arch/interrupt.h>
+#include <arch/ops.h>
+#include <kernel/percpu.h>
+
+#include <ktl/enforce.h>
+
+zx_koid_t KernelObjectId::Generate() {
+  // Disabling interrupts keeps us on this CPU and keeps an interrupt handler from racing with us
+  // on its block, and is much cheaper than contending on the global generator.
+  InterruptDisableGuard irqd;
+
+  // Threads are created before the boot CPU's percpu struct is installed.
+  percpu* const cpu = arch_get_curr_percpu();
+  if (unlikely(cpu == nullptr)) {
+    return GenerateRange(1);
+  }
+
+  KernelObjectId::Block& block = cpu->koid_block;
+  if (unlikely(block.next == block.end)) {
+    block.next = GenerateRange(kBlockSize);
+    block.end = block.next + kBlockSize;
+  }
+  return block.next++;
+}
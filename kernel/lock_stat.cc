@@ -0,0 +1,227 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "kernel/lock_stat.h"
+
+#include <inttypes.h>
+#include <lib/affine/ratio.h>
+#include <lib/boot-options/boot-options.h>
+#include <lib/console.h>
+#include <lib/fxt/interned_string.h>
+#include <platform.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <fbl/alloc_checker.h>
+#include <kernel/percpu.h>
+#include <ktl/algorithm.h>
+#include <ktl/unique_ptr.h>
+#include <lk/init.h>
+
+#include <ktl/enforce.h>
+
+namespace lock_stat {
+
+namespace internal {
+ktl::atomic<bool> gEnabled{false};
+}  // namespace internal
+
+namespace {
+
+// The statistics of one lock class on one CPU. Only threads running on that CPU
+// update them, but a thread may migrate mid update, so they are still atomic.
+struct Bucket {
+  ktl::atomic<uint64_t> acquires{0};
+  ktl::atomic<uint64_t> contended{0};
+  ktl::atomic<uint64_t> wait_ticks{0};
+  ktl::atomic<uint64_t> max_hold_ticks{0};
+};
+
+// Registered lock classes, hashed by class id. Slot kUnknownClass is never
+// assigned.
+ktl::atomic<lockdep::LockClassId> gClassIds[kMaxClasses];
+
+// kMaxClasses buckets for each CPU, allocated when statistics are enabled.
+Bucket* gBuckets = nullptr;
+size_t gBucketCpus = 0;
+
+Bucket& LocalBucket(ClassIndex index) {
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  DEBUG_ASSERT(cpu < gBucketCpus);
+  return gBuckets[cpu * kMaxClasses + index];
+}
+
+void LockStatInit(uint /*level*/) {
+  if (!gBootOptions->lock_stats) {
+    return;
+  }
+
+  gBucketCpus = percpu::processor_count();
+  fbl::AllocChecker ac;
+  gBuckets = new (&ac) Bucket[gBucketCpus * kMaxClasses];
+  if (!ac.check()) {
+    printf("lock_stat: failed to allocate statistics for %zu CPUs\n", gBucketCpus);
+    gBuckets = nullptr;
+    return;
+  }
+  internal::gEnabled.store(true, ktl::memory_order_release);
+}
+
+// Prints the statistics of every class that was acquired, most waited for first.
+void Dump() {
+  struct Entry {
+    ClassIndex index;
+    ClassStats stats;
+  };
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<Entry[]> entries{new (&ac) Entry[kMaxClasses]};
+  if (!ac.check()) {
+    printf("failed to allocate lock statistics\n");
+    return;
+  }
+
+  size_t count = 0;
+  for (size_t i = 0; i < kMaxClasses; i++) {
+    const ClassIndex index = static_cast<ClassIndex>(i);
+    if (GetClassStats(index, &entries[count].stats) && entries[count].stats.acquires != 0) {
+      entries[count++].index = index;
+    }
+  }
+  ktl::stable_sort(entries.get(), entries.get() + count, [](const Entry& a, const Entry& b) {
+    return a.stats.total_wait > b.stats.total_wait;
+  });
+
+  printf("%12s %12s %16s %14s  %s\n", "acquires", "contended", "total wait ns", "max hold ns",
+         "class");
+  for (size_t i = 0; i < count; i++) {
+    const ClassStats& stats = entries[i].stats;
+    printf("%12" PRIu64 " %12" PRIu64 " %16" PRIi64 " %14" PRIi64 "  %s\n", stats.acquires,
+           stats.contended, stats.total_wait, stats.max_hold, ClassName(entries[i].index));
+  }
+}
+
+int CommandLockStat(int argc, const cmd_args* argv, uint32_t flags) {
+  if (!Enabled()) {
+    printf("lock statistics are disabled, boot with kernel.lock-stats=true\n");
+    return -1;
+  }
+  if (argc < 2 || strcmp(argv[1].str, "dump") == 0) {
+    Dump();
+  } else if (strcmp(argv[1].str, "reset") == 0) {
+    Reset();
+  } else {
+    printf("usage:\n");
+    printf("%s [dump]          : dump lock class statistics\n", argv[0].str);
+    printf("%s reset           : zero lock class statistics\n", argv[0].str);
+    return -1;
+  }
+  return 0;
+}
+
+}  // namespace
+
+ClassIndex Register(lockdep::LockClassId lcid) {
+  if (lcid == lockdep::kInvalidLockClassId) {
+    return kUnknownClass;
+  }
+
+  // Open addressing over every slot but kUnknownClass. Slots are only ever
+  // claimed, never released, so a probe can stop at the first empty slot.
+  constexpr size_t kSlots = kMaxClasses - 1;
+  const size_t start = static_cast<size_t>((static_cast<uint64_t>(lcid) >> 4) % kSlots);
+  for (size_t probe = 0; probe < kSlots; probe++) {
+    const size_t slot = 1 + (start + probe) % kSlots;
+    lockdep::LockClassId expected = lockdep::kInvalidLockClassId;
+    if (gClassIds[slot].compare_exchange_strong(expected, lcid, ktl::memory_order_relaxed) ||
+        expected == lcid) {
+      return static_cast<ClassIndex>(slot);
+    }
+  }
+  return kUnknownClass;
+}
+
+void RecordAcquire(ClassIndex index, bool contended, zx_duration_mono_ticks_t wait_ticks) {
+  DEBUG_ASSERT(index < kMaxClasses);
+  Bucket& bucket = LocalBucket(index);
+  bucket.acquires.fetch_add(1, ktl::memory_order_relaxed);
+  if (contended) {
+    bucket.contended.fetch_add(1, ktl::memory_order_relaxed);
+    bucket.wait_ticks.fetch_add(static_cast<uint64_t>(wait_ticks), ktl::memory_order_relaxed);
+  }
+}
+
+void RecordHold(ClassIndex index, zx_duration_mono_ticks_t hold_ticks) {
+  DEBUG_ASSERT(index < kMaxClasses);
+  Bucket& bucket = LocalBucket(index);
+  const uint64_t hold = static_cast<uint64_t>(hold_ticks);
+  uint64_t max = bucket.max_hold_ticks.load(ktl::memory_order_relaxed);
+  while (hold > max &&
+         !bucket.max_hold_ticks.compare_exchange_weak(max, hold, ktl::memory_order_relaxed)) {
+  }
+}
+
+bool GetClassStats(ClassIndex index, ClassStats* stats) {
+  if (!Enabled() || index >= kMaxClasses ||
+      (index != kUnknownClass &&
+       gClassIds[index].load(ktl::memory_order_relaxed) == lockdep::kInvalidLockClassId)) {
+    return false;
+  }
+
+  uint64_t acquires = 0;
+  uint64_t contended = 0;
+  uint64_t wait_ticks = 0;
+  uint64_t max_hold_ticks = 0;
+  for (size_t cpu = 0; cpu < gBucketCpus; cpu++) {
+    const Bucket& bucket = gBuckets[cpu * kMaxClasses + index];
+    acquires += bucket.acquires.load(ktl::memory_order_relaxed);
+    contended += bucket.contended.load(ktl::memory_order_relaxed);
+    wait_ticks += bucket.wait_ticks.load(ktl::memory_order_relaxed);
+    max_hold_ticks =
+        ktl::max(max_hold_ticks, bucket.max_hold_ticks.load(ktl::memory_order_relaxed));
+  }
+
+  const affine::Ratio ticks_to_time = timer_get_ticks_to_time_ratio();
+  *stats = {
+      .acquires = acquires,
+      .contended = contended,
+      .total_wait = ticks_to_time.Scale(static_cast<zx_duration_mono_ticks_t>(wait_ticks)),
+      .max_hold = ticks_to_time.Scale(static_cast<zx_duration_mono_ticks_t>(max_hold_ticks)),
+  };
+  return true;
+}
+
+const char* ClassName(ClassIndex index) {
+  const lockdep::LockClassId lcid =
+      index < kMaxClasses ? gClassIds[index].load(ktl::memory_order_relaxed)
+                          : lockdep::kInvalidLockClassId;
+  if (lcid == lockdep::kInvalidLockClassId) {
+    return "<unknown>";
+  }
+  // See LockNameStorage::SetLockClassId for why the name may be missing.
+  const fxt::InternedString* name = &lockdep::MetadataLockClassState::Get(lcid)->interned_name();
+  return name != nullptr ? name->string() : "<unknown>";
+}
+
+void Reset() {
+  if (!Enabled()) {
+    return;
+  }
+  for (size_t i = 0; i < gBucketCpus * kMaxClasses; i++) {
+    Bucket& bucket = gBuckets[i];
+    bucket.acquires.store(0, ktl::memory_order_relaxed);
+    bucket.contended.store(0, ktl::memory_order_relaxed);
+    bucket.wait_ticks.store(0, ktl::memory_order_relaxed);
+    bucket.max_hold_ticks.store(0, ktl::memory_order_relaxed);
+  }
+}
+
+}  // namespace lock_stat
+
+LK_INIT_HOOK(lock_stat, lock_stat::LockStatInit, LK_INIT_LEVEL_THREADING)
+
+STATIC_COMMAND_START
+STATIC_COMMAND("lockstat", "lock contention statistics", &lock_stat::CommandLockStat)
+STATIC_COMMAND_END(lockstat)
@@ -9,9 +9,11 @@
 
 #include <align.h>
 #include <assert.h>
+#include <inttypes.h>
 #include <debug.h>
 #include <lib/arch/intrin.h>
 #include <lib/console.h>
+#include <lib/counters.h>
 #include <lib/fit/defer.h>
 #include <lib/kconcurrent/chainlock_transaction.h>
 #include <lib/lazy_init/lazy_init.h>
@@ -39,6 +41,7 @@
 #include <kernel/spinlock.h>
 #include <kernel/stats.h>
 #include <kernel/timer.h>
+#include <ktl/algorithm.h>
 #include <ktl/bit.h>
 #include <lk/init.h>
 #include <platform/timer.h>
@@ -61,7 +64,7 @@ struct mp_ipi_task
 // Global mp state to track what the cpus are up to.
 struct mp_state {
   // Cpus that are currently online.
-  ktl::atomic<cpu_mask_t> online_cpus;
+  AtomicCpuMask online_cpus;
 
   SpinLock ipi_task_lock{"mp_state:ipi_task_lock"_intern};
   // The list of outstanding tasks for each CPU to execute. Should only be
@@ -73,7 +76,7 @@ struct mp_state {
 
   // Tracks the CPUs that are "ready".
   // Used below in mp_signal_curr_cpu_ready and mp_wait_for_all_cpus_ready.
-  ktl::atomic<cpu_mask_t> ready_cpu_mask{0};
+  AtomicCpuMask ready_cpu_mask;
 
   // Signals when all CPUs are ready.
   Event ready_cpu_event;
@@ -82,6 +85,17 @@ struct mp_state {
 // The global state structure for the mp subsystem, aligned on cpu cache line to minimize aliasing.
 mp_state mp __CPU_ALIGN_EXCLUSIVE;
 
+constexpr size_t kBootStageCount = static_cast<size_t>(mp_boot_stage::COUNT_);
+constexpr const char* kBootStageNames[kBootStageCount] = {"start", "early-init", "late-init",
+                                                          "ready"};
+
+// The tick at which each CPU reached each mp_boot_stage, or 0 if it has not. Each entry is written
+// once during start-up, by the CPU that started the secondary or by the secondary itself.
+ktl::atomic<zx_instant_mono_ticks_t> boot_stage_ticks[SMP_MAX_CPUS][kBootStageCount];
+
+KCOUNTER(timeline_secondary_start, "boot.timeline.secondary-start")
+KCOUNTER(timeline_secondary_ready, "boot.timeline.secondary-ready")
+
 }  // namespace
 
 // tracks if a cpu is online and initialized
@@ -94,7 +108,7 @@ void mp_set_cpu_online(cpu_num_t cpu, bool online) {
 }
 
 cpu_mask_t mp_get_online_mask() { return mp.online_cpus.load(); }
-bool mp_is_cpu_online(cpu_num_t cpu) { return mp_get_online_mask() & cpu_num_to_mask(cpu); }
+bool mp_is_cpu_online(cpu_num_t cpu) { return mp.online_cpus.test(cpu); }
 
 void mp_init() {}
 
@@ -103,16 +117,16 @@ void mp_reschedule(cpu_mask_t mask, uint flags) {
 
   const cpu_num_t local_cpu = arch_curr_cpu_num();
 
-  LTRACEF("local %u, mask %#x\n", local_cpu, mask);
+  LTRACEF("local %u, mask %#" PRIx64 "\n", local_cpu, mask.word(0));
 
   // mask out cpus that do not have an active scheduler, and the local cpu
   mask &= Scheduler::PeekActiveMask();
   mask &= ~cpu_num_to_mask(local_cpu);
 
-  LTRACEF("local %u, post mask target now 0x%x\n", local_cpu, mask);
+  LTRACEF("local %u, post mask target now %#" PRIx64 "\n", local_cpu, mask.word(0));
 
   // if we have no work to do, return
-  if (mask == 0) {
+  if (mask.none()) {
     return;
   }
 
@@ -129,7 +143,7 @@ struct mp_sync_context {
   mp_sync_task_t task;
   void* task_context;
   // Mask of which CPUs need to finish the task
-  ktl::atomic<cpu_mask_t> outstanding_cpus;
+  AtomicCpuMask outstanding_cpus;
 };
 
 void mp_sync_task(void* raw_context) {
@@ -176,7 +190,7 @@ void mp_sync_exec(const mp_ipi_target target, cpu_mask_t mask, const mp_sync_tas
   const cpu_num_t local_cpu = arch_curr_cpu_num();
 
   // remove self from target lists, since no need to IPI ourselves
-  const bool targetting_self = mask & cpu_num_to_mask(local_cpu);
+  const bool targetting_self = mask.test(local_cpu);
   mask &= ~cpu_num_to_mask(local_cpu);
 
   // create tasks to enqueue (we need one per target due to each containing
@@ -184,7 +198,7 @@ void mp_sync_exec(const mp_ipi_target target, cpu_mask_t mask, const mp_sync_tas
   mp_sync_context sync_context = {
       .task = task,
       .task_context = context,
-      .outstanding_cpus = mask,
+      .outstanding_cpus{mask},
   };
 
   // Create an array up to SMP_MAX_CPUs of tasks to run, but only initialize
@@ -197,13 +211,9 @@ void mp_sync_exec(const mp_ipi_target target, cpu_mask_t mask, const mp_sync_tas
   // enqueue tasks
   mp.ipi_task_lock.Acquire();
   cpu_mask_t remaining = mask;
-  cpu_num_t cpu_id = 0;
-  while (remaining && cpu_id < num_cpus) {
-    if (remaining & 1) {
-      mp.ipi_task_list[cpu_id].push_back(&sync_tasks[cpu_id].Get());
-    }
-    remaining >>= 1;
-    cpu_id++;
+  cpu_num_t cpu_id;
+  while ((cpu_id = remove_cpu_from_mask(remaining)) != INVALID_CPU && cpu_id < num_cpus) {
+    mp.ipi_task_list[cpu_id].push_back(&sync_tasks[cpu_id].Get());
   }
   mp.ipi_task_lock.Release();
 
@@ -228,7 +238,7 @@ void mp_sync_exec(const mp_ipi_target target, cpu_mask_t mask, const mp_sync_tas
     // guarantees.
     cpu_mask_t outstanding = sync_context.outstanding_cpus.load(ktl::memory_order_relaxed);
     cpu_mask_t online = mp_get_online_mask();
-    if ((outstanding & online) == 0) {
+    if ((outstanding & online).none()) {
       break;
     }
 
@@ -319,7 +329,7 @@ zx_status_t mp_hotplug_cpu_mask(cpu_mask_t cpu_mask) {
     return ZX_ERR_BAD_STATE;
   }
 
-  while (cpu_mask != 0) {
+  while (cpu_mask.any()) {
     cpu_num_t cpu_id = highest_cpu_set(cpu_mask);
     cpu_mask &= ~cpu_num_to_mask(cpu_id);
 
@@ -382,7 +392,7 @@ zx_status_t mp_unplug_cpu_mask(cpu_mask_t cpu_mask, zx_instant_mono_t deadline)
     return ZX_ERR_BAD_STATE;
   }
 
-  while (cpu_mask != 0) {
+  while (cpu_mask.any()) {
     cpu_num_t cpu_id = highest_cpu_set(cpu_mask);
     cpu_mask &= ~cpu_num_to_mask(cpu_id);
 
@@ -437,13 +447,21 @@ void mp_mbx_interrupt_irq() {
 
 zx_status_t platform_mp_cpu_hotplug(cpu_num_t cpu_id) { return arch_mp_cpu_hotplug(cpu_id); }
 
+void mp_record_boot_stage(cpu_num_t cpu, mp_boot_stage stage) {
+  DEBUG_ASSERT(cpu < SMP_MAX_CPUS);
+  DEBUG_ASSERT(stage < mp_boot_stage::COUNT_);
+  boot_stage_ticks[cpu][static_cast<size_t>(stage)].store(current_mono_ticks(),
+                                                          ktl::memory_order_relaxed);
+}
+
 void mp_signal_curr_cpu_ready() {
   cpu_num_t num = arch_curr_cpu_num();
+  mp_record_boot_stage(num, mp_boot_stage::READY);
   DEBUG_ASSERT_MSG(Scheduler::PeekIsActive(num), "CPU %u cannot be ready if it is not yet active",
                    num);
   cpu_mask_t mask = cpu_num_to_mask(num);
   cpu_mask_t ready = mp.ready_cpu_mask.fetch_or(mask) | mask;
-  int ready_count = ktl::popcount(ready);
+  int ready_count = static_cast<int>(ready.count());
   int max_count = static_cast<int>(arch_max_num_cpus());
   DEBUG_ASSERT(ready_count <= max_count);
   if (ready_count == max_count) {
@@ -457,6 +475,78 @@ zx_status_t mp_wait_for_all_cpus_ready(Deadline deadline) {
 
 namespace {
 
+zx_instant_mono_ticks_t boot_stage_tick(cpu_num_t cpu, size_t stage) {
+  return boot_stage_ticks[cpu][stage].load(ktl::memory_order_relaxed);
+}
+
+int64_t ticks_to_usec(zx_duration_mono_ticks_t ticks) {
+  return timer_get_ticks_to_time_ratio().Scale(ticks) / ZX_USEC(1);
+}
+
+// Reports how long the secondary CPUs took to start, and the slowest CPU of each stage. Called
+// once all CPUs are ready, at which point every stage has been recorded for every started CPU.
+void mp_report_boot_stages() {
+  zx_instant_mono_ticks_t first_start = 0;
+  zx_instant_mono_ticks_t last_ready = 0;
+  zx_duration_mono_ticks_t slowest[kBootStageCount] = {};
+  cpu_num_t slowest_cpu[kBootStageCount] = {};
+  uint started = 0;
+  for (cpu_num_t cpu = 1; cpu < SMP_MAX_CPUS; cpu++) {
+    const zx_instant_mono_ticks_t start = boot_stage_tick(cpu, 0);
+    if (start == 0) {
+      continue;
+    }
+    started++;
+    first_start = (first_start == 0) ? start : ktl::min(first_start, start);
+    last_ready = ktl::max(last_ready, boot_stage_tick(cpu, kBootStageCount - 1));
+    for (size_t stage = 1; stage < kBootStageCount; stage++) {
+      const zx_duration_mono_ticks_t duration =
+          boot_stage_tick(cpu, stage) - boot_stage_tick(cpu, stage - 1);
+      if (duration > slowest[stage]) {
+        slowest[stage] = duration;
+        slowest_cpu[stage] = cpu;
+      }
+    }
+  }
+  if (started == 0) {
+    return;
+  }
+
+  timeline_secondary_start.Set(first_start);
+  timeline_secondary_ready.Set(last_ready);
+  dprintf(INFO, "mp: %u secondary CPUs ready %" PRIi64 " us after the first was started\n",
+          started, ticks_to_usec(last_ready - first_start));
+  for (size_t stage = 1; stage < kBootStageCount; stage++) {
+    dprintf(INFO, "mp:   %s to %s: slowest cpu %u took %" PRIi64 " us\n",
+            kBootStageNames[stage - 1], kBootStageNames[stage], slowest_cpu[stage],
+            ticks_to_usec(slowest[stage]));
+  }
+}
+
+void mp_dump_boot_stages() {
+  printf("cpu");
+  for (size_t stage = 1; stage < kBootStageCount; stage++) {
+    printf(" %12s", kBootStageNames[stage]);
+  }
+  printf("  (us since start)\n");
+  for (cpu_num_t cpu = 1; cpu < SMP_MAX_CPUS; cpu++) {
+    const zx_instant_mono_ticks_t start = boot_stage_tick(cpu, 0);
+    if (start == 0) {
+      continue;
+    }
+    printf("%3u", cpu);
+    for (size_t stage = 1; stage < kBootStageCount; stage++) {
+      const zx_instant_mono_ticks_t when = boot_stage_tick(cpu, stage);
+      if (when == 0) {
+        printf(" %12s", "-");
+      } else {
+        printf(" %12" PRIi64, ticks_to_usec(when - start));
+      }
+    }
+    printf("\n");
+  }
+}
+
 void mp_all_cpu_startup_sync_hook(unsigned int rl) {
   // Before proceeding any further, wait for a _really_ long time to make sure
   // that all of the CPUs are ready.  We really don't want to start user-mode
@@ -470,6 +560,7 @@ void mp_all_cpu_startup_sync_hook(unsigned int rl) {
   constexpr zx_duration_mono_t kCpuStartupTimeout = ZX_SEC(30);
   zx_status_t status = mp_wait_for_all_cpus_ready(Deadline::after_mono(kCpuStartupTimeout));
   if (status == ZX_OK) {
+    mp_report_boot_stages();
     return;
   }
 
@@ -497,7 +588,7 @@ void mp_all_cpu_startup_sync_hook(unsigned int rl) {
   // missing.  Note, ready implies online.
   const cpu_mask_t ready_mask = mp.ready_cpu_mask.load(ktl::memory_order_relaxed);
   const cpu_mask_t online_mask = mp_get_online_mask();
-  cpu_mask_t expected_ready_mask = 0;
+  cpu_mask_t expected_ready_mask{};
   for (system_topology::Node* node : system_topology::GetSystemTopology().processors()) {
     const zbi_topology_processor_t& processor = node->entity.processor;
     for (int i = 0; i < processor.logical_id_count; i++) {
@@ -510,8 +601,9 @@ void mp_all_cpu_startup_sync_hook(unsigned int rl) {
   char msg[200];
   snprintf(msg, sizeof(msg),
            "At least one CPU has not declared itself to be started after %ld ms "
-           "(ready %08x, online %08x, expected %08x)\n\n",
-           kCpuStartupTimeout / ZX_MSEC(1), ready_mask, online_mask, expected_ready_mask);
+           "(ready %#" PRIx64 ", online %#" PRIx64 ", expected %#" PRIx64 ")\n\n",
+           kCpuStartupTimeout / ZX_MSEC(1), ready_mask.word(0), online_mask.word(0),
+           expected_ready_mask.word(0));
 
   // Is this a development build?
   if (LK_DEBUGLEVEL > 0) {
@@ -557,6 +649,7 @@ int cmd_mp(int argc, const cmd_args* argv, uint32_t flags) {
     printf("%s unplug <cpu_id>\n", argv[0].str);
     printf("%s hotplug <cpu_id>\n", argv[0].str);
     printf("%s reschedule <cpu_id>        : send a reschedule ipi to <cpu_id>\n", argv[0].str);
+    printf("%s boot                       : show how long each cpu took to start\n", argv[0].str);
     return ZX_ERR_INTERNAL;
   }
 
@@ -602,6 +695,8 @@ int cmd_mp(int argc, const cmd_args* argv, uint32_t flags) {
     } else {
       printf("sent reschedule ipi to cpu %u\n", target_cpu);
     }
+  } else if (!strcmp(argv[1].str, "boot")) {
+    mp_dump_boot_stages();
   } else {
     printf("unknown command\n");
     goto usage;
@@ -22,6 +22,7 @@
 #include <lib/affine/ratio.h>
 #include <lib/affine/utils.h>
 #include <lib/arch/intrin.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 #include <lib/fxt/interned_string.h>
 #include <lib/fxt/string_ref.h>
@@ -41,12 +42,26 @@
 #include <kernel/spin_tracing.h>
 #include <kernel/task_runtime_timers.h>
 #include <kernel/thread.h>
+#include <ktl/algorithm.h>
+#include <ktl/limits.h>
 #include <ktl/type_traits.h>
 
 #include <ktl/enforce.h>
 
 #define LOCAL_TRACE 0
 
+// Counts contended acquires, with kernel.mutex.adaptive-spin enabled, that
+// acquired the mutex while spinning.
+KCOUNTER(mutex_spin_acquired, "mutex.adaptive_spin.acquired")
+
+// Counts contended acquires, with kernel.mutex.adaptive-spin enabled, that
+// stopped spinning because the owner of the mutex did not appear to be running.
+KCOUNTER(mutex_spin_owner_not_running, "mutex.adaptive_spin.owner_not_running")
+
+// Counts contended acquires, with kernel.mutex.adaptive-spin enabled, that
+// spun for their whole budget without acquiring the mutex.
+KCOUNTER(mutex_spin_timed_out, "mutex.adaptive_spin.timed_out")
+
 namespace {
 
 enum class KernelMutexTracingLevel {
@@ -186,6 +201,11 @@ bool Mutex::AcquireCommon(zx_duration_t spin_max_duration,
       // will take care of updating the wait queue ownership.
       KTracer{}.KernelMutexUncontestedAcquire(this);
 
+      if (unlikely(lock_stat::Enabled())) {
+        lock_stat::RecordAcquire(lock_stat_class_, false, 0);
+        lock_stat_acquired_ticks_ = current_mono_ticks();
+      }
+
       return set_extension;
     }
     if constexpr (TimesliceExtensionEnabled) {
@@ -195,6 +215,16 @@ bool Mutex::AcquireCommon(zx_duration_t spin_max_duration,
     }
   }
 
+  if (unlikely(lock_stat::Enabled())) {
+    const zx_instant_mono_ticks_t wait_start_ticks = current_mono_ticks();
+    const bool set_extension =
+        AcquireContendedMutex(spin_max_duration, current_thread, timeslice_extension);
+    const zx_instant_mono_ticks_t now_ticks = current_mono_ticks();
+    lock_stat::RecordAcquire(lock_stat_class_, true, now_ticks - wait_start_ticks);
+    lock_stat_acquired_ticks_ = now_ticks;
+    return set_extension;
+  }
+
   return AcquireContendedMutex(spin_max_duration, current_thread, timeslice_extension);
 }
 
@@ -243,6 +273,14 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
   // So, it is possible to keep spinning when we probably shouldn't, and also
   // possible to drop out of a spin when we might want to stay in it.
   //
+  // When kernel.mutex.adaptive-spin is enabled, the spin phase also ends as
+  // soon as the owner does not appear to be running on the CPU in
+  // |maybe_acquired_on_cpu_|, since a blocked or preempted owner cannot release
+  // the mutex until it runs again. The same caveats apply to this guess. In
+  // addition, the spin phase is bounded by a budget learned from previous
+  // contended acquires of this mutex rather than by |spin_max_duration| alone.
+  // See |SpinBudget| and |UpdateSpinBudget|.
+  //
   // TODO(https://fxbug.dev/42109976): Optimize cache pressure of spinners and default spin max.
 
   const uintptr_t new_mutex_state = reinterpret_cast<uintptr_t>(current_thread);
@@ -262,9 +300,15 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
   zx_instant_mono_ticks_t now_ticks = current_mono_ticks();
   spin_tracing::Tracer<kSchedulerLockSpinTracingEnabled> spin_tracer{now_ticks};
 
-  const affine::Ratio time_to_ticks = timer_get_ticks_to_time_ratio().Inverse();
+  const bool adaptive_spin = gBootOptions->mutex_adaptive_spin;
+  const zx_duration_t spin_duration =
+      adaptive_spin ? SpinBudget(spin_max_duration) : spin_max_duration;
+
+  const affine::Ratio ticks_to_time = timer_get_ticks_to_time_ratio();
+  const affine::Ratio time_to_ticks = ticks_to_time.Inverse();
+  const zx_instant_mono_ticks_t spin_start_ticks = now_ticks;
   const zx_instant_mono_ticks_t spin_until_ticks =
-      affine::utils::ClampAdd(now_ticks, time_to_ticks.Scale(spin_max_duration));
+      affine::utils::ClampAdd(now_ticks, time_to_ticks.Scale(spin_duration));
   do {
     uintptr_t old_mutex_state = STATE_FREE;
     // Attempt to acquire the mutex by swapping out "STATE_FREE" for our current thread.
@@ -278,6 +322,12 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
       spin_tracer.Finish(spin_tracing::FinishType::kLockAcquired, this->encoded_lock_id());
       RecordInitialAssignedCpu();
 
+      if (adaptive_spin) {
+        // Leave twice the time it took as headroom for the next acquire.
+        UpdateSpinBudget(spin_max_duration, 2 * ticks_to_time.Scale(now_ticks - spin_start_ticks));
+        kcounter_add(mutex_spin_acquired, 1);
+      }
+
       // Same as above in the fastest path: leave accounting to later contending
       // threads.
       KTracer{}.KernelMutexUncontestedAcquire(this);
@@ -301,7 +351,16 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
       // Note: The accuracy of |curr_cpu_num| depends on whether preemption is
       // currently enabled or not and whether we re-enable it below.
       const cpu_num_t curr_cpu_num = arch_curr_cpu_num();
-      if (curr_cpu_num == maybe_acquired_on_cpu_.load(ktl::memory_order_relaxed)) {
+      const cpu_num_t owner_cpu_num = maybe_acquired_on_cpu_.load(ktl::memory_order_relaxed);
+      if (curr_cpu_num == owner_cpu_num) {
+        break;
+      }
+
+      // Stop spinning if the owner does not look to be running. An owner which
+      // has not recorded its CPU yet is assumed to be running.
+      if (adaptive_spin && owner_cpu_num != INVALID_CPU &&
+          !Scheduler::IsActiveThreadHint(holder_from_val(old_mutex_state), owner_cpu_num)) {
+        kcounter_add(mutex_spin_owner_not_running, 1);
         break;
       }
 
@@ -309,7 +368,7 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
         // If this CPU has a preemption pending, briefly enable then disable
         // preemption to give this CPU a chance to reschedule.
         const cpu_mask_t curr_cpu_mask = cpu_num_to_mask(arch_curr_cpu_num());
-        if ((Thread::Current::preemption_state().preempts_pending() & curr_cpu_mask) != 0) {
+        if ((Thread::Current::preemption_state().preempts_pending() & curr_cpu_mask).any()) {
           // Reenable preemption to trigger a local reschedule and then disable it again.
           preempt_disabler.Enable();
           preempt_disabler.Disable();
@@ -322,6 +381,13 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
     now_ticks = current_mono_ticks();
   } while (now_ticks < spin_until_ticks);
 
+  // The owner kept running for the whole budget, so holds of this mutex are
+  // long compared to the budget. Spin for less time on the next acquire.
+  if (adaptive_spin && spin_duration > 0 && now_ticks >= spin_until_ticks) {
+    UpdateSpinBudget(spin_max_duration, spin_duration / 2);
+    kcounter_add(mutex_spin_timed_out, 1);
+  }
+
   // Capture the end-of-spin timestamp for our spin tracer, but do not finish
   // the event just yet. We don't actually know if we are going to block or not
   // yet; we have one last chance to grab the lock after we obtain a few more
@@ -453,6 +519,30 @@ __NO_INLINE bool Mutex::AcquireContendedMutex(
                                          do_transaction);
 }
 
+zx_duration_t Mutex::SpinBudget(zx_duration_t spin_max_duration) const {
+  const uint32_t budget_ns = spin_budget_ns_.load(ktl::memory_order_relaxed);
+  if (budget_ns == 0) {
+    return spin_max_duration;
+  }
+  return ktl::min<zx_duration_t>(budget_ns, spin_max_duration);
+}
+
+void Mutex::UpdateSpinBudget(zx_duration_t spin_max_duration, zx_duration_t sample) {
+  const zx_duration_t max_ns =
+      ktl::min<zx_duration_t>(spin_max_duration, ktl::numeric_limits<uint32_t>::max());
+  if (max_ns <= 0) {
+    return;
+  }
+
+  // Move a quarter of the way towards the sample, the same rate the scheduler
+  // uses for its expected runtime estimates.
+  const zx_duration_t min_ns = ktl::max<zx_duration_t>(max_ns / 8, 1);
+  const zx_duration_t budget_ns = SpinBudget(spin_max_duration);
+  const zx_duration_t updated_ns =
+      ktl::clamp<zx_duration_t>(budget_ns + (sample - budget_ns) / 4, min_ns, max_ns);
+  spin_budget_ns_.store(static_cast<uint32_t>(updated_ns), ktl::memory_order_relaxed);
+}
+
 inline uintptr_t Mutex::TryRelease(Thread* current_thread) {
   // Try the fast path.  Assume that we are locked, but uncontested.
   uintptr_t old_mutex_state = reinterpret_cast<uintptr_t>(current_thread);
@@ -602,6 +692,12 @@ void Mutex::ReleaseInternal() {
 
   ClearInitialAssignedCpu();
 
+  // Only the holder touches |lock_stat_acquired_ticks_|, so sample it before
+  // letting go of the mutex.
+  if (unlikely(lock_stat::Enabled()) && lock_stat_acquired_ticks_ != 0) {
+    lock_stat::RecordHold(lock_stat_class_, current_mono_ticks() - lock_stat_acquired_ticks_);
+  }
+
   if (const uintptr_t old_mutex_state = TryRelease(current_thread); old_mutex_state != STATE_FREE) {
     ReleaseContendedMutex(current_thread, old_mutex_state);
   }
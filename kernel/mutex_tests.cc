@@ -6,6 +6,7 @@
 
 #include <lib/unittest/unittest.h>
 
+#include <kernel/lock_stat.h>
 #include <kernel/mutex.h>
 
 namespace {
@@ -256,6 +257,43 @@ bool singleton_mutex_threadsafe() {
   END_TEST;
 }
 
+bool mutex_lock_stats() {
+  BEGIN_TEST;
+
+  // Registering a class is idempotent. The id only needs to be unique.
+  static int fake_class;
+  const auto lcid = reinterpret_cast<lockdep::LockClassId>(&fake_class);
+  const lock_stat::ClassIndex index = lock_stat::Register(lcid);
+  EXPECT_NE(lock_stat::kUnknownClass, index);
+  EXPECT_EQ(index, lock_stat::Register(lcid));
+  EXPECT_EQ(lock_stat::kUnknownClass, lock_stat::Register(lockdep::kInvalidLockClassId));
+
+  if (!lock_stat::Enabled()) {
+    printf("kernel.lock-stats is disabled.  Skipping the rest!
+");
+    END_TEST;
+  }
+
+  // A mutex declared without lockdep is recorded under the unknown class, which
+  // other threads may be using concurrently.
+  lock_stat::ClassStats before;
+  ASSERT_TRUE(lock_stat::GetClassStats(lock_stat::kUnknownClass, &before));
+  Mutex mutex;
+  mutex.Acquire();
+  mutex.Release();
+  lock_stat::ClassStats after;
+  ASSERT_TRUE(lock_stat::GetClassStats(lock_stat::kUnknownClass, &after));
+  EXPECT_GT(after.acquires, before.acquires);
+
+  // Nothing is recorded against the fake class, so `lockstat` never tries to
+  // name it.
+  lock_stat::ClassStats stats;
+  ASSERT_TRUE(lock_stat::GetClassStats(index, &stats));
+  EXPECT_EQ(0u, stats.acquires);
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(mutex_tests)
@@ -272,4 +310,6 @@ UNITTEST("critical_mutex_assert_held_compile", critical_mutex_assert_held_compil
 
 UNITTEST("singleton mutex has thread-safe init", singleton_mutex_threadsafe)
 
+UNITTEST("mutex_lock_stats", mutex_lock_stats)
+
 UNITTEST_END_TESTCASE(mutex_tests, "mutex", "Mutex tests")
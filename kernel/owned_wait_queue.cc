@@ -61,6 +61,10 @@
 KCOUNTER(pi_promotions, "kernel.pi.adj.promotions")
 KCOUNTER(pi_demotions, "kernel.pi.adj.demotions")
 KCOUNTER(pi_bp_changed, "kernel.pi.adj.bp_changed")
+// Propagations which ended before reaching the end of their chain, or which
+// were skipped entirely, because the IPVs of a node they reached did not change.
+KCOUNTER(pi_propagation_early_stops, "kernel.pi.adj.early_stops")
+KCOUNTER(pi_propagation_skipped, "kernel.pi.adj.skipped")
 KCOUNTER_DECLARE(max_pi_chain_traverse, "kernel.pi.max_chain_traverse", Max)
 
 namespace {
@@ -128,6 +132,15 @@ inline bool IpvsAreConsequential(const SchedulerState::InheritedProfileValues* i
   return ipvs != nullptr && ipvs->is_consequential();
 }
 
+// Returns true if replacing |lost| with |added| leaves the weight and
+// utilization sums of every downstream node unchanged, so that only minimum
+// deadlines might need to be updated.
+inline bool IpvSumsAreUnchanged(const SchedulerState::InheritedProfileValues* added,
+                                const SchedulerState::InheritedProfileValues* lost) {
+  return added != nullptr && lost != nullptr && added->total_weight == lost->total_weight &&
+         added->uncapped_utilization == lost->uncapped_utilization;
+}
+
 template <typename UpstreamType, typename DownstreamType>
 void Propagate(UpstreamType& upstream, DownstreamType& downstream, AddSingleEdgeTag)
     TA_REQ(chainlock_transaction_token, ChainLockable::GetLock(upstream),
@@ -230,7 +243,10 @@ OwnedWaitQueue::WakeThreadsResult OwnedWaitQueue::WakeThreadsLocked(Thread::Unbl
     }
   }
 
-  // Now wake all of the threads we had selected
+  // Now wake all of the threads we had selected. They are unblocked together
+  // once they have all been removed from the queue, so that the scheduler can
+  // spread them across CPUs and send a single round of reschedule IPIs.
+  Thread::UnblockList unblock_list;
   while (!threads.is_empty()) {
     Thread* const t = threads.pop_front();
     t->get_lock().AssertAcquired();
@@ -261,10 +277,15 @@ OwnedWaitQueue::WakeThreadsResult OwnedWaitQueue::WakeThreadsLocked(Thread::Unbl
       AssignOwnerInternal(t);
     }
 
-    // Finally, unblock the thread, drop its lock in the process.
-    Scheduler::Unblock(t);
+    // Finally, queue the thread to be unblocked. The scheduler drops its lock
+    // in the process. Unblock pops the list from the back, so push to the
+    // front to preserve the wake order.
+    unblock_list.push_front(t);
     ++woken;
   }
+  if (!unblock_list.is_empty()) {
+    Scheduler::Unblock(ktl::move(unblock_list));
+  }
 
   // If our WakeOption was None, we should no longer have an owner.  Otherwise,
   // it was AssignOwner, in which case we should only have an owner if we still
@@ -514,6 +535,22 @@ void OwnedWaitQueue::FinishPropagate(UpstreamNodeType& upstream_node,
     return;
   }
 
+  // If the values we are adding are the same as the ones we are removing (for
+  // example, a blocked thread changed its base profile in a way which does not
+  // change what it transmits), then nothing downstream changes either.  Skip
+  // the walk, which would otherwise reset the dynamic parameters of every node
+  // along the way.
+  //
+  // Otherwise, the same weight and utilization deltas are applied to every
+  // node in the chain.  If those deltas are zero, only the minimum deadlines
+  // can change, and we can stop as soon as we reach a node whose minimum
+  // deadline does not.
+  const bool sums_unchanged = IpvSumsAreUnchanged(added_ipv, lost_ipv);
+  if (sums_unchanged && (added_ipv->min_deadline == lost_ipv->min_deadline)) {
+    pi_propagation_skipped.Add(1u);
+    return;
+  }
+
   // When we have finally finished updating everything, make sure to update
   // our max traversal statistic.
   ChainLengthTracker len_tracker;
@@ -609,9 +646,18 @@ void OwnedWaitQueue::FinishPropagate(UpstreamNodeType& upstream_node,
           *owq_iter->inherited_scheduler_state_storage_;
       owq_iss.ipvs.AssertConsistency();
       const SchedUtilization utilization_before = owq_iss.ipvs.uncapped_utilization;
+      const SchedDuration min_deadline_before = owq_iss.ipvs.min_deadline;
       ApplyIpvDeltaToOwq(lost_ipv, added_ipv, *owq_iter);
       const SchedUtilization utilization_after = owq_iss.ipvs.uncapped_utilization;
 
+      // If this queue's IPVs did not change at all, then neither will those of
+      // anything downstream of it.
+      if (sums_unchanged && (owq_iss.ipvs.min_deadline == min_deadline_before)) {
+        len_tracker.NodeVisited();
+        pi_propagation_early_stops.Add(1u);
+        break;
+      }
+
       if (utilization_before != utilization_after) {
         if (utilization_before == SchedUtilization{0}) {
           // First deadline thread just arrived, copy its parameters.
@@ -655,10 +701,20 @@ void OwnedWaitQueue::FinishPropagate(UpstreamNodeType& upstream_node,
       // Propagate from the current owq_iter to the current thread_iter.
       // Apply the change in pressure to the next thread in the chain.
       thread_iter->get_lock().AssertHeld();
+      const SchedulerState::InheritedProfileValues& thread_ipvs =
+          thread_iter->scheduler_state().inherited_profile_values_;
+      const SchedDuration min_deadline_before = thread_ipvs.min_deadline;
       ApplyIpvDeltaToThread(lost_ipv, added_ipv, *thread_iter);
       Propagate(upstream_node, *thread_iter, op);
       len_tracker.NodeVisited();
 
+      // As above, a thread whose IPVs did not change cannot change the IPVs it
+      // transmits to the queue it is blocked in.
+      if (sums_unchanged && (thread_ipvs.min_deadline == min_deadline_before)) {
+        pi_propagation_early_stops.Add(1u);
+        break;
+      }
+
       owq_iter = DowncastToOwq(thread_iter->wait_queue_state().blocking_wait_queue_);
       if (owq_iter == nullptr) {
         break;
@@ -1908,6 +1964,10 @@ zx_status_t OwnedWaitQueue::BlockAndAssignOwnerLocked(Thread* const current_thre
   // the BAAO operation by calling BlockEtcPostable.  When we return from the
   // block operation, we should have re-acquired the current thread's lock
   // (however, it may be with a different lock token).
+  //
+  // Note who we are about to block behind while we can still look at owner_, so
+  // that it can be recorded in traces of the block.
+  const zx_koid_t owner_tid = (owner_ != nullptr) ? owner_->tid() : ZX_KOID_INVALID;
   get_lock().Release();
   active_clt.AssertNumLocksHeld(1);
 
@@ -1926,7 +1986,8 @@ zx_status_t OwnedWaitQueue::BlockAndAssignOwnerLocked(Thread* const current_thre
   //
   // DANGER!! DANGER!! DANGER!! DANGER!! DANGER!! DANGER!! DANGER!! DANGER!!
   //
-  res = BlockEtcPostamble(current_thread, deadline);
+  res = BlockEtcPostamble(current_thread, deadline,
+                          reinterpret_cast<uintptr_t>(__builtin_return_address(0)), owner_tid);
   DEBUG_ASSERT(&active_clt == ChainLockTransaction::Active());
   active_clt.AssertNumLocksHeld(1);
   return res;
@@ -110,7 +110,9 @@ void percpu::InitializeSecondariesBegin() {
     processor_index_[i]->search_set.Dump();
 
     const size_t cluster = processor_index_[i]->search_set.cluster();
-    processor_index_[i]->scheduler.cluster_ = cluster;
+    processor_index_[i]->scheduler.SetCluster(cluster);
+    processor_index_[i]->scheduler.smt_siblings_ =
+        system_topology::GetSystemTopology().SmtSiblingMask(i);
   }
 }
 
@@ -0,0 +1,129 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/arch/intrin.h>
+
+#include <arch/defines.h>
+#include <kernel/queued_spinlock.h>
+
+#include <ktl/enforce.h>
+
+namespace queued_spinlock {
+namespace {
+
+struct alignas(MAX_CACHE_LINE) Node {
+  ktl::atomic<Node*> next;
+  ktl::atomic<bool> ready;
+};
+
+// Indexed by CPU number, see the comment in the header for why one per CPU is enough.
+Node gNodes[SMP_MAX_CPUS];
+
+ktl::atomic<bool> gPanicMode{false};
+
+bool InPanicMode() { return gPanicMode.load(ktl::memory_order_relaxed); }
+
+}  // namespace
+
+void EnterPanicMode() { gPanicMode.store(true, ktl::memory_order_relaxed); }
+
+void AcquireBypassingQueue(arch_spin_lock_t* lock, cpu_num_t cpu) TA_NO_THREAD_SAFETY_ANALYSIS {
+  while (!TryAcquire(lock, cpu)) {
+    arch::Yield();
+  }
+}
+
+void AcquireContended(arch_spin_lock_t* lock, cpu_num_t cpu) TA_NO_THREAD_SAFETY_ANALYSIS {
+  if (unlikely(InPanicMode())) {
+    AcquireBypassingQueue(lock, cpu);
+    return;
+  }
+
+  const cpu_num_t owner = cpu + 1;
+  const cpu_num_t tail = owner << kTailShift;
+  Node& node = gNodes[cpu];
+  node.next.store(nullptr, ktl::memory_order_relaxed);
+  node.ready.store(false, ktl::memory_order_relaxed);
+
+  // Become the tail of the queue, unless the lock has meanwhile become free with nobody waiting, in
+  // which case just take it. Publishing the tail releases the initialization of our node to the
+  // next waiter, and acquires that of the previous tail.
+  cpu_num_t old = lock->value.load(ktl::memory_order_relaxed);
+  while (true) {
+    if (old == 0) {
+      if (lock->value.compare_exchange_weak(old, owner, ktl::memory_order_acquire,
+                                            ktl::memory_order_relaxed)) {
+        return;
+      }
+      continue;
+    }
+    if (lock->value.compare_exchange_weak(old, (old & kArchSpinLockOwnerMask) | tail,
+                                          ktl::memory_order_acq_rel, ktl::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  // Link in behind the previous tail, if any, and wait for it to make us the head of the queue.
+  // Our predecessor may have been halted by a panic, in which case we are never made the head and
+  // leave the queue as it is. Every other waiter does the same once in panic mode.
+  const cpu_num_t prev = old >> kTailShift;
+  if (prev != 0) {
+    gNodes[prev - 1].next.store(&node, ktl::memory_order_release);
+    while (!node.ready.load(ktl::memory_order_acquire)) {
+      if (unlikely(InPanicMode())) {
+        AcquireBypassingQueue(lock, cpu);
+        return;
+      }
+      arch::Yield();
+    }
+  }
+
+  // As the head of the queue, wait for the owner to release the lock and then take it. If we are
+  // still the tail, the queue becomes empty.
+  cpu_num_t value = lock->value.load(ktl::memory_order_relaxed);
+  cpu_num_t desired;
+  while (true) {
+    if ((value & kArchSpinLockOwnerMask) != 0) {
+      arch::Yield();
+      value = lock->value.load(ktl::memory_order_relaxed);
+      continue;
+    }
+    desired = value == tail ? owner : value | owner;
+    if (lock->value.compare_exchange_weak(value, desired, ktl::memory_order_acquire,
+                                          ktl::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  // Pass the head of the queue on. The next waiter has already replaced us as the tail, but may
+  // not have linked itself in yet, and never will if it was halted in between. In panic mode it
+  // does not need to be handed anything.
+  if (desired != owner) {
+    Node* next;
+    while ((next = node.next.load(ktl::memory_order_acquire)) == nullptr) {
+      if (unlikely(InPanicMode())) {
+        return;
+      }
+      arch::Yield();
+    }
+    next->ready.store(true, ktl::memory_order_release);
+  }
+}
+
+bool TryAcquire(arch_spin_lock_t* lock, cpu_num_t cpu) {
+  cpu_num_t value = lock->value.load(ktl::memory_order_relaxed);
+  while ((value & kArchSpinLockOwnerMask) == 0) {
+    // This may barge ahead of the head of the queue, which will simply see the lock as owned and
+    // keep waiting. Only a change to the tail can make this fail, so retry in that case.
+    if (lock->value.compare_exchange_weak(value, value | (cpu + 1), ktl::memory_order_acquire,
+                                          ktl::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace queued_spinlock
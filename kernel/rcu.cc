@@ -0,0 +1,145 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "kernel/rcu.h"
+
+#include <assert.h>
+#include <lib/counters.h>
+#include <zircon/errors.h>
+
+#include <arch/ops.h>
+#include <kernel/cpu.h>
+#include <kernel/event.h>
+#include <kernel/mp.h>
+#include <kernel/thread.h>
+#include <ktl/atomic.h>
+#include <lk/init.h>
+
+#include <ktl/enforce.h>
+
+KCOUNTER(rcu_grace_periods, "rcu.grace_periods")
+KCOUNTER(rcu_callbacks, "rcu.callbacks")
+
+namespace rcu {
+
+namespace {
+
+// Callbacks queued by Call, newest first.  Each RcuHead's |next| points at the
+// one queued before it.
+ktl::atomic<RcuHead*> gHead{nullptr};
+
+// Signaled when |gHead| goes from empty to non-empty.
+Event gEvent;
+
+int ReclaimerThread(void*) {
+  for (;;) {
+    // Unsignal before looking at the stack.  A producer that pushes onto it
+    // after we have taken it sees it empty and signals again, so the wakeup
+    // cannot be lost.
+    gEvent.Unsignal();
+    RcuHead* head = gHead.exchange(nullptr, ktl::memory_order_acquire);
+    if (head == nullptr) {
+      [[maybe_unused]] zx_status_t err = gEvent.Wait();
+      DEBUG_ASSERT(err == ZX_OK);
+      continue;
+    }
+
+    // The stack is newest first.  Reverse it so that callbacks run in the
+    // order they were queued, which Barrier relies on.
+    RcuHead* pending = nullptr;
+    while (head != nullptr) {
+      RcuHead* next = head->next;
+      head->next = pending;
+      pending = head;
+      head = next;
+    }
+
+    // Everything in |pending| was queued before this grace period began.
+    Synchronize();
+
+    while (pending != nullptr) {
+      RcuHead* next = pending->next;
+      pending->func(pending);
+      kcounter_add(rcu_callbacks, 1);
+      pending = next;
+    }
+  }
+
+  return 0;
+}
+
+void RcuInit(unsigned int level) {
+  Thread* thread = Thread::Create("rcu-reclaimer", ReclaimerThread, nullptr, DEFAULT_PRIORITY);
+  ASSERT(thread != nullptr);
+  thread->DetachAndResume();
+}
+
+}  // namespace
+
+void Synchronize() {
+  DEBUG_ASSERT(!InReadSection());
+  DEBUG_ASSERT(arch_num_spinlocks_held() == 0);
+
+  Thread* const current = Thread::Current::Get();
+  const cpu_mask_t prev_affinity = current->GetCpuAffinity();
+
+  // Run on each online CPU in turn.  Being scheduled onto a CPU means that it
+  // has context switched with preemption enabled, so any read-side section it
+  // was in when we started has finished.  The CPU we start on qualifies
+  // trivially, since we are running on it with preemption enabled.
+  //
+  // CPUs which go offline while we are looping have no read-side sections in
+  // progress, and CPUs which come online can only start new ones, so both may
+  // be skipped.
+  cpu_mask_t remaining = mp_get_online_mask();
+  remaining.reset(arch_curr_cpu_num());
+  while (remaining) {
+    const cpu_num_t cpu = remove_cpu_from_mask(remaining);
+    if (!(mp_get_online_mask() & cpu_num_to_mask(cpu))) {
+      continue;
+    }
+    current->SetCpuAffinity(cpu_num_to_mask(cpu));
+    while (arch_curr_cpu_num() != cpu) {
+      Thread::Current::Yield();
+    }
+  }
+
+  current->SetCpuAffinity(prev_affinity);
+  kcounter_add(rcu_grace_periods, 1);
+}
+
+void Call(RcuHead* head, RcuHead::Func* func) {
+  DEBUG_ASSERT(func != nullptr);
+  head->func = func;
+
+  RcuHead* old_head = gHead.load(ktl::memory_order_relaxed);
+  do {
+    head->next = old_head;
+  } while (!gHead.compare_exchange_weak(old_head, head, ktl::memory_order_release,
+                                        ktl::memory_order_relaxed));
+
+  if (old_head == nullptr) {
+    gEvent.Signal();
+  }
+}
+
+void Barrier() {
+  struct BarrierHead {
+    RcuHead head;
+    Event done;
+  } barrier;
+
+  Call(&barrier.head, [](RcuHead* head) {
+    // |head| is the first member of a BarrierHead.
+    reinterpret_cast<BarrierHead*>(head)->done.Signal();
+  });
+  [[maybe_unused]] zx_status_t err = barrier.done.Wait();
+  DEBUG_ASSERT(err == ZX_OK);
+}
+
+}  // namespace rcu
+
+LK_INIT_HOOK(rcu, rcu::RcuInit, LK_INIT_LEVEL_THREADING)
@@ -75,6 +75,50 @@ KCOUNTER(counter_update_in_transition, "scheduler.update_in_transition")
 // selected Target became in-active after we chose it.
 KCOUNTER(counter_find_target_cpu_retries, "scheduler.find_target_cpu.retries")
 
+// Counts the number of times a synchronous wakeup placed the woken thread on
+// the waking CPU.
+KCOUNTER(counter_sync_wakeup_local, "scheduler.find_target_cpu.sync_local")
+KCOUNTER(counter_cluster_search, "scheduler.find_target_cpu.cluster_search")
+
+// Counts the number of times a fair thread was placed starting from the CPU of
+// the thread that repeatedly wakes it.
+KCOUNTER(counter_wake_affine, "scheduler.find_target_cpu.wake_affine")
+
+// Counts the number of times a directed yield moved its target ahead in a run
+// queue.
+KCOUNTER(counter_yield_to_boost, "scheduler.yield_to.boost")
+
+// Counts the number of times an idle CPU looked for work to steal.
+KCOUNTER(counter_steal_attempts, "scheduler.steal.attempts")
+
+// Counts the number of threads stolen from a CPU in the same logical cluster.
+KCOUNTER(counter_steal_intra_cluster, "scheduler.steal.intra_cluster")
+
+// Counts the number of threads stolen from a CPU in another logical cluster.
+KCOUNTER(counter_steal_inter_cluster, "scheduler.steal.inter_cluster")
+
+// Counts the number of times a search for work to steal gave up after trying
+// kStealVictimLimit CPUs.
+KCOUNTER(counter_steal_victim_limit, "scheduler.steal.victim_limit")
+
+// Counts the number of times energy aware placement packed a fair thread onto
+// an efficient CPU.
+KCOUNTER(counter_energy_aware_packed, "scheduler.energy_aware.packed")
+
+// Counts the number of power level requests made to match the estimated demand.
+KCOUNTER(counter_energy_aware_power_level_requests, "scheduler.energy_aware.power_level_requests")
+
+// The load averages of each CPU over 1, 10, and 60 seconds, in thousandths:
+// the number of runnable threads, including the running thread, and the
+// fraction of time spent running threads. Summed across CPUs, they are the
+// system-wide load averages. See Scheduler::UpdateLoadAverages.
+KCOUNTER(counter_load_runnable_1s, "scheduler.load.runnable_1s")
+KCOUNTER(counter_load_runnable_10s, "scheduler.load.runnable_10s")
+KCOUNTER(counter_load_runnable_60s, "scheduler.load.runnable_60s")
+KCOUNTER(counter_load_busy_1s, "scheduler.load.busy_1s")
+KCOUNTER(counter_load_busy_10s, "scheduler.load.busy_10s")
+KCOUNTER(counter_load_busy_60s, "scheduler.load.busy_60s")
+
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
 // Counts the number of times the fair timeline was snapped forward to make a
 // fair thread eligible to run.
@@ -271,7 +315,7 @@ inline void Scheduler::TraceThreadQueueEvent(const fxt::InternedString& name,
 
     const uint64_t arg0 = thread->tid();
     const uint64_t arg1 =
-        (thread->scheduler_state().GetEffectiveCpuMask(PeekActiveMask()) & 0xFFFF) |
+        (thread->scheduler_state().GetEffectiveCpuMask(PeekActiveMask()).word(0) & 0xFFFF) |
         (ktl::clamp<uint64_t>(this_cpu_, 0, 0xF) << 16) |
         (ktl::clamp<uint64_t>(cnt, 0, 0xFF) << 20) | ((fair ? 1 : 0) << 28) |
         ((eligible ? 1 : 0) << 29) | ((thread->IsIdle() ? 1 : 0) << 30);
@@ -546,6 +590,23 @@ Scheduler* Scheduler::Get() { return Get(arch_curr_cpu_num()); }
 
 Scheduler* Scheduler::Get(cpu_num_t cpu) { return &percpu::Get(cpu).scheduler; }
 
+bool Scheduler::IsActiveThreadHint(const Thread* thread, cpu_num_t cpu) {
+  return cpu < percpu::processor_count() &&
+         Get(cpu)->exported_active_thread_.load() == reinterpret_cast<uintptr_t>(thread);
+}
+
+zx_duration_mono_t Scheduler::PeekIdleLatencyLimit(cpu_num_t cpu, zx_instant_mono_t now) {
+  const Scheduler* const scheduler = Get(cpu);
+  if (SchedTime{now} >= scheduler->exported_idle_latency_expiry_.load()) {
+    return ZX_TIME_INFINITE;
+  }
+  return scheduler->exported_idle_latency_limit_.load().raw_value();
+}
+
+cpu_mask_t Scheduler::IsolatedMask() {
+  return cpu_mask_t::FromWord(gBootOptions->scheduler_isolated_cpus);
+}
+
 void Scheduler::InitializeThread(Thread* thread, const SchedulerState::BaseProfile& profile) {
   new (&thread->scheduler_state()) SchedulerState{profile};
   thread->scheduler_state().expected_runtime_ns_ =
@@ -676,6 +737,12 @@ Scheduler::DequeueResult Scheduler::DequeueThread(
     return DequeueFairThread(now);
   }
 
+  // An isolated CPU only runs the threads placed on it, so go idle instead of
+  // pulling in work from other CPUs.
+  if (IsIsolatedCpu(this_cpu_)) {
+    return &self.idle_power_thread.thread();
+  }
+
   // Release the queue lock while attempting to steal work, leaving IRQs
   // disabled.  Latch our scale up factor to use while determining whether or
   // not we can steal a given thread before we drop our lock.
@@ -705,160 +772,209 @@ Scheduler::DequeueResult Scheduler::StealWork(SchedTime now, SchedProcessingRate
   const cpu_mask_t current_cpu_mask = cpu_num_to_mask(current_cpu);
   const cpu_mask_t active_cpu_mask = PeekActiveMask();
 
-  const CpuSearchSet& search_set = percpu::Get(current_cpu).search_set;
-  for (const auto& entry : search_set.const_iterator()) {
-    if (entry.cpu != current_cpu && active_cpu_mask & cpu_num_to_mask(entry.cpu)) {
-      Scheduler* const scheduler = Get(entry.cpu);
+  counter_steal_attempts.Add(1);
 
-      // Only steal across clusters if the target is above the load threshold.
-      if (cluster() != entry.cluster &&
-          scheduler->exported_queue_time_ns() <= kInterClusterThreshold) {
-        continue;
-      }
-
-      Guard<MonitoredSpinLock, NoIrqSave> queue_guard{&scheduler->queue_lock_, SOURCE_TAG};
+  // Attempts to steal a thread from the given CPU's run queues.
+  const auto steal_from_cpu = [current_cpu, current_cpu_mask, active_cpu_mask, now,
+                               processing_rate](Scheduler* scheduler) -> DequeueResult {
+    Guard<MonitoredSpinLock, NoIrqSave> queue_guard{&scheduler->queue_lock_, SOURCE_TAG};
 
-      // Check if the scheduler is still active. If it's not, ignore it because
-      // MigrateUnpinnedThreads will move the threads off of it.
-      if (!scheduler->IsSchedulerActiveLocked()) {
-        continue;
-      }
+    // Check if the scheduler is still active. If it's not, ignore it because
+    // MigrateUnpinnedThreads will move the threads off of it.
+    if (!scheduler->IsSchedulerActiveLocked()) {
+      return nullptr;
+    }
 
-      // TODO(b/430139320): Disabled until root cause of x64 pessimization is
-      // understood and addressed.
+    // TODO(b/430139320): Disabled until root cause of x64 pessimization is
+    // understood and addressed.
 #if 0
-      // Only attempt to steal from CPUs that have more than one task, avoiding
-      // unnecessary overhead when a task was just added to an idle CPU but the
-      // CPU has not started running the new task (i.e. when this CPU wins the
-      // race to acquire the target CPU's queue lock after the singular task is
-      // queued).
-      if (scheduler->runnable_task_count() <= 1) {
-        continue;
-      }
+    // Only attempt to steal from CPUs that have more than one task, avoiding
+    // unnecessary overhead when a task was just added to an idle CPU but the
+    // CPU has not started running the new task (i.e. when this CPU wins the
+    // race to acquire the target CPU's queue lock after the singular task is
+    // queued).
+    if (scheduler->runnable_task_count() <= 1) {
+      return nullptr;
+    }
 #endif
 
-      // Note that in the lambdas below we will be making use of both the
-      // MarkHasSchedulerAccess (but only on |queue|) and
-      // MarkHasOwnedThreadAccess.  We just acquired |queue|'s queue lock, and
-      // each thread we will be examining is a member of one of |queue|'s run
-      // queues (either fair or deadline).  This should satisfy the requirements
-      // of both no-op checks.
-
-      // Returns true if the given thread can run on this CPU.  Static analysis
-      // needs to be disabled, but this should be fine.  We only need R/O access
-      // to the thread's scheduler state, which we have because we are holding
-      // the queue lock for a thread which belongs to that queue (see below).
-      const auto check_affinity = [current_cpu_mask,
-                                   active_cpu_mask](const Thread& thread) -> bool {
-        MarkHasOwnedThreadAccess(thread);
-        return current_cpu_mask & thread.scheduler_state().GetEffectiveCpuMask(active_cpu_mask);
-      };
-
-      // Common routine for stealing from a run queue.
-      const auto steal_from_queue = [current_cpu, check_affinity, scheduler, now](
-                                        RunQueue& run_queue,
-                                        const auto& predicate) -> DequeueResult {
-        ktrace::Scope trace_steal = LOCAL_KTRACE_BEGIN_SCOPE(COMMON, "sched_steal");
-
-        DEBUG_ASSERT((&run_queue == &scheduler->fair_run_queue_) ||
-                     (&run_queue == &scheduler->deadline_run_queue_));
-        MarkHasSchedulerAccess(*scheduler);
-        const bool is_fair_run_queue = &run_queue == &scheduler->fair_run_queue_;
-
-        // Convert the monotonic eligible time to variable time and potentially
-        // snap the virtual timeline forward when stealing from the fair queue.
-        SchedTime eligible_time = now;
-        if (is_fair_run_queue) {
+    // Note that in the lambdas below we will be making use of both the
+    // MarkHasSchedulerAccess (but only on |queue|) and
+    // MarkHasOwnedThreadAccess.  We just acquired |queue|'s queue lock, and
+    // each thread we will be examining is a member of one of |queue|'s run
+    // queues (either fair or deadline).  This should satisfy the requirements
+    // of both no-op checks.
+
+    // Returns true if the given thread can run on this CPU.  Static analysis
+    // needs to be disabled, but this should be fine.  We only need R/O access
+    // to the thread's scheduler state, which we have because we are holding
+    // the queue lock for a thread which belongs to that queue (see below).
+    const auto check_affinity = [current_cpu_mask, active_cpu_mask](const Thread& thread) -> bool {
+      MarkHasOwnedThreadAccess(thread);
+      const cpu_mask_t effective = thread.scheduler_state().GetEffectiveCpuMask(active_cpu_mask);
+      return (current_cpu_mask & effective).any();
+    };
+
+    // Common routine for stealing from a run queue.
+    const auto steal_from_queue = [current_cpu, check_affinity, scheduler, now](
+                                      RunQueue& run_queue,
+                                      const auto& predicate) -> DequeueResult {
+      ktrace::Scope trace_steal = LOCAL_KTRACE_BEGIN_SCOPE(COMMON, "sched_steal");
+
+      DEBUG_ASSERT((&run_queue == &scheduler->fair_run_queue_) ||
+                   (&run_queue == &scheduler->deadline_run_queue_));
+      MarkHasSchedulerAccess(*scheduler);
+      const bool is_fair_run_queue = &run_queue == &scheduler->fair_run_queue_;
+
+      // Convert the monotonic eligible time to variable time and potentially
+      // snap the virtual timeline forward when stealing from the fair queue.
+      SchedTime eligible_time = now;
+      if (is_fair_run_queue) {
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
-          scheduler->MonotonicToVariableInPlace(eligible_time);
+        scheduler->MonotonicToVariableInPlace(eligible_time);
 #else
-          scheduler->UpdateTimeline(now);
-          eligible_time = scheduler->virtual_time_;
+        scheduler->UpdateTimeline(now);
+        eligible_time = scheduler->virtual_time_;
 #endif  // EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
-          if (!run_queue.is_empty()) {
-            const Thread& earliest_thread = run_queue.front();
-            MarkHasOwnedThreadAccess(earliest_thread);
+        if (!run_queue.is_empty()) {
+          const Thread& earliest_thread = run_queue.front();
+          MarkHasOwnedThreadAccess(earliest_thread);
 
-            const SchedTime earliest_start = earliest_thread.scheduler_state().start_time();
+          const SchedTime earliest_start = earliest_thread.scheduler_state().start_time();
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
-            if (eligible_time < earliest_start) {
-              counter_fair_timeline_snap_count.Add(1);
-              counter_fair_timeline_snap_time.Add(Round<int64_t>(earliest_start - eligible_time));
+          if (eligible_time < earliest_start) {
+            counter_fair_timeline_snap_count.Add(1);
+            counter_fair_timeline_snap_time.Add(Round<int64_t>(earliest_start - eligible_time));
 
-              scheduler->fair_affine_transform_.Snap(now, earliest_start);
-              eligible_time = earliest_start;
-            }
+            scheduler->fair_affine_transform_.Snap(now, earliest_start);
+            eligible_time = earliest_start;
+          }
 #else
-            eligible_time = ktl::max(eligible_time, earliest_start);
+          eligible_time = ktl::max(eligible_time, earliest_start);
 #endif  // EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
-          }
         }
+      }
 
-        Thread* thread =
-            scheduler->FindEarliestEligibleThread(&run_queue, eligible_time, predicate);
-        if (!thread) {
-          return nullptr;
-        }
+      Thread* thread =
+          scheduler->FindEarliestEligibleThread(&run_queue, eligible_time, predicate);
+      if (!thread) {
+        return nullptr;
+      }
 
-        MarkHasOwnedThreadAccess(*thread);
+      MarkHasOwnedThreadAccess(*thread);
 
-        ktl::ignore = check_affinity;  // Silence compiler when debug asserts are disabled.
-        DEBUG_ASSERT(check_affinity(*thread));
-        DEBUG_ASSERT(!thread->has_migrate_fn());
-        DEBUG_ASSERT(thread->disposition() == Disposition::Enqueued);
+      ktl::ignore = check_affinity;  // Silence compiler when debug asserts are disabled.
+      DEBUG_ASSERT(check_affinity(*thread));
+      DEBUG_ASSERT(!thread->has_migrate_fn());
+      DEBUG_ASSERT(thread->disposition() == Disposition::Enqueued);
 
-        // Remove the thread from the source run queue and record that it was
-        // stolen by this CPU.
-        run_queue.erase(*thread);
-        scheduler->Remove(now, thread, current_cpu);
-        scheduler->TraceThreadQueueEvent("tqe_deque_steal_work"_intern, thread);
-        DEBUG_ASSERT(thread->disposition() == Disposition::Stolen);
+      // Remove the thread from the source run queue and record that it was
+      // stolen by this CPU.
+      run_queue.erase(*thread);
+      scheduler->Remove(now, thread, current_cpu);
+      scheduler->TraceThreadQueueEvent("tqe_deque_steal_work"_intern, thread);
+      DEBUG_ASSERT(thread->disposition() == Disposition::Stolen);
 
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
-        if (is_fair_run_queue) {
-          const SchedulerState& state = const_cast<const Thread*>(thread)->scheduler_state();
-          const SchedTime mono_start_time = scheduler->VariableToMonotonic(state.start_time());
-          const SchedTime mono_finish_time = scheduler->VariableToMonotonic(state.finish_time());
-          return DequeueResult{thread, mono_start_time, mono_finish_time};
-        }
+      if (is_fair_run_queue) {
+        const SchedulerState& state = const_cast<const Thread*>(thread)->scheduler_state();
+        const SchedTime mono_start_time = scheduler->VariableToMonotonic(state.start_time());
+        const SchedTime mono_finish_time = scheduler->VariableToMonotonic(state.finish_time());
+        return DequeueResult{thread, mono_start_time, mono_finish_time};
+      }
 #endif  // EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
 
-        return thread;
-      };
+      return thread;
+    };
 
-      // Returns true if the given thread in the run queue meets the criteria to
-      // run on this CPU.  Don't attempt to steal any threads which are
-      // currently in the process of being scheduled.
-      const auto deadline_predicate = [check_affinity, processing_rate](const auto& iter) -> bool {
-        const Thread& thread = *iter;
-        MarkHasOwnedThreadAccess(thread);
+    // Returns true if the given thread in the run queue meets the criteria to
+    // run on this CPU.  Don't attempt to steal any threads which are
+    // currently in the process of being scheduled.
+    const auto deadline_predicate = [check_affinity, processing_rate](const auto& iter) -> bool {
+      const Thread& thread = *iter;
+      MarkHasOwnedThreadAccess(thread);
 
-        const SchedulerState& state = thread.scheduler_state();
-        const EffectiveProfile& ep = state.effective_profile_;
-        const bool is_scheduleable = ep.deadline().utilization <= processing_rate;
+      const SchedulerState& state = thread.scheduler_state();
+      const EffectiveProfile& ep = state.effective_profile_;
+      const bool is_scheduleable = ep.deadline().utilization <= processing_rate;
 
-        return check_affinity(thread) && is_scheduleable && !thread.has_migrate_fn();
-      };
+      return check_affinity(thread) && is_scheduleable && !thread.has_migrate_fn();
+    };
 
-      // Attempt to find a deadline thread that can run on this CPU.
-      if (DequeueResult result =
-              steal_from_queue(scheduler->deadline_run_queue_, deadline_predicate)) {
-        return result;
-      }
+    // Attempt to find a deadline thread that can run on this CPU.
+    if (DequeueResult result =
+            steal_from_queue(scheduler->deadline_run_queue_, deadline_predicate)) {
+      return result;
+    }
 
-      // Returns true if the given thread in the run queue meets the criteria to
-      // run on this CPU.
-      const auto fair_predicate = [check_affinity](const auto& iter) -> bool {
-        const Thread& thread = *iter;
-        MarkHasOwnedThreadAccess(thread);
-        return check_affinity(thread) && !thread.has_migrate_fn();
-      };
+    // Returns true if the given thread in the run queue meets the criteria to
+    // run on this CPU.
+    const auto fair_predicate = [check_affinity](const auto& iter) -> bool {
+      const Thread& thread = *iter;
+      MarkHasOwnedThreadAccess(thread);
+      return check_affinity(thread) && !thread.has_migrate_fn();
+    };
 
-      // Attempt to find a fair thread that can run on this CPU.
-      if (DequeueResult result = steal_from_queue(scheduler->fair_run_queue_, fair_predicate)) {
-        return result;
+    // Attempt to find a fair thread that can run on this CPU.
+    return steal_from_queue(scheduler->fair_run_queue_, fair_predicate);
+  };
+
+  // Each victim costs a remote queue lock acquisition, so bound how many are
+  // tried by a single idle transition.
+  size_t victims_tried = 0;
+  cpu_mask_t tried_mask = current_cpu_mask;
+
+  // Steal from the most loaded CPU in this cluster first, since draining the
+  // deepest queue does the most to even out load. CPUs at or below the
+  // intra-cluster threshold are not worth migrating work away from.
+  const CpuSearchSet& search_set = percpu::Get(current_cpu).search_set;
+  while (victims_tried < kStealVictimLimit) {
+    cpu_num_t busiest_cpu = INVALID_CPU;
+    SchedDuration busiest_queue_time_ns = kIntraClusterThreshold;
+    for (const auto& entry : search_set.const_iterator()) {
+      const cpu_mask_t entry_mask = cpu_num_to_mask(entry.cpu);
+      if (cluster() != entry.cluster || (tried_mask & entry_mask).any() ||
+          (active_cpu_mask & entry_mask).none()) {
+        continue;
+      }
+      const SchedDuration queue_time_ns = Get(entry.cpu)->exported_queue_time_ns();
+      if (queue_time_ns > busiest_queue_time_ns) {
+        busiest_cpu = entry.cpu;
+        busiest_queue_time_ns = queue_time_ns;
       }
     }
+    if (busiest_cpu == INVALID_CPU) {
+      break;
+    }
+
+    tried_mask |= cpu_num_to_mask(busiest_cpu);
+    victims_tried++;
+    if (DequeueResult result = steal_from_cpu(Get(busiest_cpu))) {
+      counter_steal_intra_cluster.Add(1);
+      return result;
+    }
+  }
+
+  // Then fall back to other clusters, nearest first, but only steal across
+  // clusters if the target is above the load threshold.
+  for (const auto& entry : search_set.const_iterator()) {
+    if (victims_tried >= kStealVictimLimit) {
+      counter_steal_victim_limit.Add(1);
+      break;
+    }
+    if (cluster() == entry.cluster || (active_cpu_mask & cpu_num_to_mask(entry.cpu)).none()) {
+      continue;
+    }
+    Scheduler* const scheduler = Get(entry.cpu);
+    if (scheduler->exported_queue_time_ns() <= kInterClusterThreshold) {
+      continue;
+    }
+
+    victims_tried++;
+    if (DequeueResult result = steal_from_cpu(scheduler)) {
+      counter_steal_inter_cluster.Add(1);
+      return result;
+    }
   }
 
   return nullptr;
@@ -1108,12 +1224,12 @@ bool Scheduler::NeedsMigration(Thread* thread) {
   }
 
   // If we have no active CPUs, then we cannot migrate this thread, so return false.
-  if (active_mask == 0) {
+  if (active_mask.none()) {
     return false;
   }
 
   // We need to migrate if the set of CPUs this thread can run on does not include the current CPU.
-  return (thread->scheduler_state().GetEffectiveCpuMask(active_mask) & current_cpu_mask) == 0;
+  return (thread->scheduler_state().GetEffectiveCpuMask(active_mask) & current_cpu_mask).none();
 }
 
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
@@ -1321,27 +1437,79 @@ class Scheduler::CandidatePlacement {
   SchedUtilization deadline_utilization_{0};
 };
 
-cpu_num_t Scheduler::FindTargetCpu(Thread* thread) {
+cpu_num_t Scheduler::FindTargetCpu(Thread* thread, cpu_mask_t batch_mask) {
   ktrace::Scope trace = LOCAL_KTRACE_BEGIN_SCOPE(DETAILED, "find_target");
 
   // Determine the set of CPUs the thread is allowed to run on.
   const cpu_num_t current_cpu = arch_curr_cpu_num();
   const cpu_mask_t active_mask = PeekActiveMask();
   const SchedulerState& thread_state = const_cast<const Thread*>(thread)->scheduler_state();
-  const cpu_mask_t available_mask = thread_state.GetEffectiveCpuMask(active_mask);
-  DEBUG_ASSERT_MSG(available_mask != 0,
-                   "thread=%s affinity=%#x soft_affinity=%#x active=%#x "
-                   "idle=%#x arch_ints_disabled=%d",
-                   thread->name(), thread_state.hard_affinity_, thread_state.soft_affinity_,
-                   active_mask, PeekIdleMask(), arch_ints_disabled());
+  cpu_mask_t available_mask = thread_state.GetEffectiveCpuMask(active_mask);
+  // Keep threads off isolated CPUs unless those are the only CPUs they may run on.
+  if (const cpu_mask_t shared_mask = available_mask & ~IsolatedMask(); shared_mask.any()) {
+    available_mask = shared_mask;
+  }
+  DEBUG_ASSERT_MSG(available_mask.any(),
+                   "thread=%s affinity=%#" PRIx64 " soft_affinity=%#" PRIx64 " active=%#" PRIx64
+                   " idle=%#" PRIx64 " arch_ints_disabled=%d",
+                   thread->name(), thread_state.hard_affinity_.word(0),
+                   thread_state.soft_affinity_.word(0), active_mask.word(0), PeekIdleMask().word(0),
+                   arch_ints_disabled());
 
-  LOCAL_KTRACE(DETAILED, "target_mask", ("online", mp_get_online_mask()), ("active", active_mask));
+  LOCAL_KTRACE(DETAILED, "target_mask", ("online", mp_get_online_mask().word(0)),
+               ("active", active_mask.word(0)));
+
+  const bool is_fair = IsFairThread(thread);
+
+  // A synchronous wakeup comes from a thread that is about to block waiting on
+  // the thread being woken, such as a channel call waiting for its reply. The
+  // current CPU is about to become free, so keep the woken thread here if it
+  // may run here and nothing else is queued. This avoids a reschedule IPI and a
+  // cold cache on another CPU for a thread that will hand control straight
+  // back. Wakeups from interrupt context are never synchronous as the thread
+  // that was interrupted is not the one waiting.
+  if (is_fair && Thread::Current::sync_wakeup() && !arch_blocking_disallowed() &&
+      available_mask.test(current_cpu) && !batch_mask.test(current_cpu)) {
+    const CandidatePlacement current_queue{Get(current_cpu)};
+    if (current_queue.queue_time_ns() <= kIntraClusterThreshold) {
+      counter_sync_wakeup_local.Add(1);
+      trace = KTRACE_END_SCOPE(("last_cpu", thread_state.last_cpu_), ("target_cpu", current_cpu));
+      return current_cpu;
+    }
+  }
+
+  // With energy aware scheduling, pack fair threads onto the most efficient CPU
+  // with spare capacity. Once there is no such CPU, the search below spreads
+  // the load instead.
+  if (is_fair && gBootOptions->scheduler_energy_aware) {
+    const cpu_num_t efficient_cpu = FindEnergyEfficientCpu(available_mask);
+    if (efficient_cpu != INVALID_CPU) {
+      counter_energy_aware_packed.Add(1);
+      trace = KTRACE_END_SCOPE(("last_cpu", thread_state.last_cpu_), ("target_cpu", efficient_cpu));
+      return efficient_cpu;
+    }
+  }
 
   // Find the best target CPU starting at the last CPU the task ran on, if any.
   // Alternatives are considered in order of best to worst potential cache
   // affinity.
   const cpu_num_t last_cpu = thread_state.last_cpu_;
-  const cpu_num_t starting_cpu = last_cpu != INVALID_CPU ? last_cpu : current_cpu;
+  cpu_num_t starting_cpu = last_cpu != INVALID_CPU ? last_cpu : current_cpu;
+
+  // A fair thread that is repeatedly woken by the current thread, such as the
+  // consumer in a producer/consumer pair, is placed near the waker instead: the
+  // search starts from the current CPU, whose search set visits its SMT
+  // siblings and the CPUs sharing its caches first, and the waker's cluster is
+  // considered cache warm for the thread.
+  const size_t current_cluster = Get(current_cpu)->cluster();
+  const bool wake_affine = is_fair && !arch_blocking_disallowed() &&
+                           thread_state.consecutive_wakes_ >= kWakeAffineMinWakes &&
+                           thread_state.last_waker_tid_ == Thread::Current::Get()->tid() &&
+                           Get(starting_cpu)->cluster() != current_cluster;
+  if (wake_affine) {
+    counter_wake_affine.Add(1);
+    starting_cpu = current_cpu;
+  }
   const CpuSearchSet& search_set = percpu::Get(starting_cpu).search_set;
 
   // TODO(https://fxbug.dev/42180608): Working on isolating a low-frequency panic due to
@@ -1350,80 +1518,180 @@ cpu_num_t Scheduler::FindTargetCpu(Thread* thread) {
   // catch the corruption and include additional context. This assert is enabled
   // in non-eng builds, however, the small impact is acceptable for production.
   ASSERT_MSG(search_set.cpu_count() <= SMP_MAX_CPUS,
-             "current_cpu=%u starting_cpu=%u active_mask=%x thread=%p search_set=%p cpu_count=%zu "
-             "entries=%p",
-             current_cpu, starting_cpu, active_mask, &thread, &search_set, search_set.cpu_count(),
-             search_set.const_iterator().data());
+             "current_cpu=%u starting_cpu=%u active_mask=%#" PRIx64
+             " thread=%p search_set=%p cpu_count=%zu entries=%p",
+             current_cpu, starting_cpu, active_mask.word(0), &thread, &search_set,
+             search_set.cpu_count(), search_set.const_iterator().data());
 
-  const bool is_fair = IsFairThread(thread);
   const SchedUtilization thread_deadline_utilization =
       is_fair ? SchedUtilization{0} : thread_state.effective_profile().deadline().utilization;
 
+  // Returns true if the thread ran in the given logical cluster recently enough
+  // that some of its working set is likely still in that cluster's caches.
+  const SchedTime now = CurrentTime();
+  const auto is_warm = [&thread_state, now, wake_affine, current_cluster](size_t cluster) {
+    if (wake_affine && cluster == current_cluster) {
+      return true;
+    }
+    const SchedTime last_ran = thread_state.last_ran_on_cluster(cluster);
+    return last_ran != SchedTime{0} && now - last_ran < kCacheWarmDuration;
+  };
+
+  // The CPU the thread last ran on is preferred over its cluster peers while it
+  // is cache warm.
+  const Scheduler* const warm_scheduler =
+      is_fair && last_cpu != INVALID_CPU && is_warm(Get(last_cpu)->cluster()) ? Get(last_cpu)
+                                                                              : nullptr;
+
+  // With SMT isolation enabled, deadline threads prefer CPUs whose SMT siblings
+  // are idle or running threads of the same process, to avoid interference from
+  // unrelated work sharing the core.
+  const bool smt_isolation = !is_fair && gBootOptions->scheduler_smt_isolation;
+  const cpu_mask_t idle_mask = smt_isolation ? PeekIdleMask() : cpu_mask_t{};
+  const zx_koid_t pid = thread->pid();
+  const auto is_isolated = [smt_isolation, idle_mask, pid](const CandidatePlacement& target) {
+    return !smt_isolation || target.scheduler()->IsSmtIsolatedFor(pid, idle_mask);
+  };
+
   // Compares candidates and returns true if alternate_target is a better
   // alternative than current_target for placing the thread.
-  const auto compare = [is_fair](const CandidatePlacement& alternate_target,
-                                 const CandidatePlacement& current_target) {
+  const auto compare = [is_fair, is_warm, warm_scheduler, is_isolated](
+                           const CandidatePlacement& alternate_target,
+                           const CandidatePlacement& current_target) {
     ktrace::Scope trace_compare = LOCAL_KTRACE_BEGIN_SCOPE(
         DETAILED, "compare", ("Alternate target queue time", alternate_target.queue_time_ns()),
         ("Current target queue time", current_target.queue_time_ns()));
 
     if (is_fair) {
       // CPUs in the same logical cluster are considered equivalent in terms of
-      // cache affinity. Choose the least loaded among the members of a cluster.
-      if (alternate_target.scheduler()->cluster() == current_target.scheduler()->cluster()) {
-        ktl::tuple alternate_criteria{alternate_target.queue_time_ns(),
-                                      alternate_target.deadline_utilization()};
-        ktl::tuple current_criteria{current_target.queue_time_ns(),
-                                    current_target.deadline_utilization()};
+      // cache affinity, apart from a warm last CPU. Choose the least loaded
+      // among the members of a cluster, discounting the warm CPU's queue time.
+      const size_t current_cluster = current_target.scheduler()->cluster();
+      if (alternate_target.scheduler()->cluster() == current_cluster) {
+        const auto warmth_discount = [warm_scheduler](const CandidatePlacement& target) {
+          return target.scheduler() == warm_scheduler ? kWarmCpuThreshold : SchedDuration{0};
+        };
+        ktl::tuple alternate_criteria{
+            alternate_target.queue_time_ns() - warmth_discount(alternate_target),
+            alternate_target.deadline_utilization()};
+        ktl::tuple current_criteria{
+            current_target.queue_time_ns() - warmth_discount(current_target),
+            current_target.deadline_utilization()};
         return alternate_criteria < current_criteria;
       }
 
       // Only consider crossing cluster boundaries if the current candidate is
-      // above the threshold.
-      return current_target.queue_time_ns() > kInterClusterThreshold &&
+      // above the threshold. The threshold models the cost of losing cache
+      // affinity, so it does not apply if the thread has not run in the current
+      // candidate's cluster recently.
+      const SchedDuration threshold =
+          is_warm(current_cluster) ? kInterClusterThreshold : SchedDuration{0};
+      return current_target.queue_time_ns() > threshold &&
              alternate_target.queue_time_ns() < current_target.queue_time_ns();
     }
 
-    ktl::tuple alternate_criteria{alternate_target.deadline_utilization(),
+    ktl::tuple alternate_criteria{!is_isolated(alternate_target),
+                                  alternate_target.deadline_utilization(),
                                   alternate_target.queue_time_ns()};
-    ktl::tuple current_criteria{current_target.deadline_utilization(),
+    ktl::tuple current_criteria{!is_isolated(current_target), current_target.deadline_utilization(),
                                 current_target.queue_time_ns()};
     return alternate_criteria < current_criteria;
   };
 
   // Determines whether the current target is sufficiently good to terminate the
   // selection loop.
-  const auto is_sufficient =
-      [is_fair, thread_deadline_utilization](const CandidatePlacement& current_target) {
-        ktrace::Scope trace_is_sufficient = LOCAL_KTRACE_BEGIN_SCOPE(
-            DETAILED, "is_sufficient", ("intra cluster threshold", kIntraClusterThreshold),
-            ("candidate queue time", current_target.queue_time_ns()));
-
-        if (is_fair) {
-          return current_target.queue_time_ns() <= kIntraClusterThreshold;
-        }
+  const auto is_sufficient = [is_fair, thread_deadline_utilization, is_isolated,
+                              batch_mask](const CandidatePlacement& current_target) {
+    ktrace::Scope trace_is_sufficient = LOCAL_KTRACE_BEGIN_SCOPE(
+        DETAILED, "is_sufficient", ("intra cluster threshold", kIntraClusterThreshold),
+        ("candidate queue time", current_target.queue_time_ns()));
+
+    if (batch_mask.test(current_target.scheduler()->this_cpu())) {
+      return false;
+    }
 
-        return current_target.queue_time_ns() <= kIntraClusterThreshold &&
-               current_target.deadline_utilization() + thread_deadline_utilization <=
-                   current_target.processing_rate();
-      };
+    if (is_fair) {
+      return current_target.queue_time_ns() <= kIntraClusterThreshold;
+    }
+
+    return current_target.queue_time_ns() <= kIntraClusterThreshold &&
+           current_target.deadline_utilization() + thread_deadline_utilization <=
+               current_target.processing_rate() &&
+           is_isolated(current_target);
+  };
 
-  // Loop over the search set for CPU the task last ran on to find a suitable
-  // target.
   cpu_num_t target_cpu = INVALID_CPU;
   CandidatePlacement target_queue{};
 
-  for (const auto& entry : search_set.const_iterator()) {
-    const cpu_num_t candidate_cpu = entry.cpu;
-    const bool candidate_available = available_mask & cpu_num_to_mask(candidate_cpu);
+  // Considers the given CPU as the target, returning true if the search can
+  // stop at the current target.
+  const auto consider = [&](cpu_num_t candidate_cpu) {
+    if (!available_mask.test(candidate_cpu)) {
+      return false;
+    }
     const CandidatePlacement candidate_queue{Get(candidate_cpu)};
-
-    if (candidate_available && (!target_queue || compare(candidate_queue, target_queue))) {
+    if (!target_queue || compare(candidate_queue, target_queue)) {
       target_cpu = candidate_cpu;
       target_queue = candidate_queue;
 
       // Stop searching at the first sufficiently unloaded CPU.
-      if (is_sufficient(target_queue)) {
+      return is_sufficient(target_queue);
+    }
+    return false;
+  };
+
+  const size_t cluster_count = CpuSearchSet::cluster_count();
+  if (search_set.cpu_count() >= kClusterSearchMinCpus && cluster_count > 1 &&
+      !gBootOptions->scheduler_prefer_little_cpus) {
+    counter_cluster_search.Add(1);
+
+    // Search the cluster of the CPU the task last ran on first, since that is
+    // where it has the best cache affinity.
+    const size_t starting_cluster = Get(starting_cpu)->cluster();
+    bool sufficient = false;
+    for (const cpu_num_t cpu : CpuSearchSet::cluster_members(starting_cluster)) {
+      if (consider(cpu)) {
+        sufficient = true;
+        break;
+      }
+    }
+
+    // Otherwise, search only the other cluster with an available CPU and the
+    // lowest average load, preferring lower deadline utilization for deadline
+    // threads.
+    if (!sufficient) {
+      size_t best_cluster = cluster_count;
+      ktl::tuple<int64_t, int64_t> best_criteria{};
+      for (size_t cluster = 0; cluster < cluster_count; cluster++) {
+        if (cluster == starting_cluster ||
+            !(available_mask & CpuSearchSet::cluster_mask(cluster)).any()) {
+          continue;
+        }
+        const int64_t members =
+            static_cast<int64_t>(CpuSearchSet::cluster_members(cluster).size());
+        const int64_t queue_time = cluster_loads_[cluster].queue_time_ns.load() / members;
+        const int64_t utilization = cluster_loads_[cluster].deadline_utilization.load() / members;
+        const ktl::tuple criteria = is_fair ? ktl::tuple{queue_time, utilization}
+                                            : ktl::tuple{utilization, queue_time};
+        if (best_cluster == cluster_count || criteria < best_criteria) {
+          best_cluster = cluster;
+          best_criteria = criteria;
+        }
+      }
+
+      if (best_cluster != cluster_count) {
+        for (const cpu_num_t cpu : CpuSearchSet::cluster_members(best_cluster)) {
+          if (consider(cpu)) {
+            break;
+          }
+        }
+      }
+    }
+  } else {
+    // Loop over the search set for CPU the task last ran on to find a suitable
+    // target.
+    for (const auto& entry : search_set.const_iterator()) {
+      if (consider(entry.cpu)) {
         break;
       }
     }
@@ -1434,6 +1702,81 @@ cpu_num_t Scheduler::FindTargetCpu(Thread* thread) {
   return target_cpu;
 }
 
+void Scheduler::RecordWaker(Thread* thread) {
+  SchedulerState& state = thread->scheduler_state();
+  if (arch_blocking_disallowed()) {
+    state.last_waker_tid_ = ZX_KOID_INVALID;
+    state.consecutive_wakes_ = 0;
+    return;
+  }
+
+  const zx_koid_t waker_tid = Thread::Current::Get()->tid();
+  if (state.last_waker_tid_ == waker_tid) {
+    if (state.consecutive_wakes_ < kWakeAffineMinWakes) {
+      state.consecutive_wakes_++;
+    }
+  } else {
+    state.last_waker_tid_ = waker_tid;
+    state.consecutive_wakes_ = 1;
+  }
+}
+
+void Scheduler::SetCluster(size_t cluster) {
+  Guard<MonitoredSpinLock, IrqSave> guard{&queue_lock_, SOURCE_TAG};
+  const int64_t queue_time_ns = exported_queue_time_ns_.load().raw_value();
+  const int64_t deadline_utilization = exported_deadline_utilization_.load().raw_value();
+  cluster_loads_[cluster_].queue_time_ns -= queue_time_ns;
+  cluster_loads_[cluster_].deadline_utilization -= deadline_utilization;
+  cluster_ = cluster;
+  cluster_loads_[cluster_].queue_time_ns += queue_time_ns;
+  cluster_loads_[cluster_].deadline_utilization += deadline_utilization;
+}
+
+cpu_num_t Scheduler::FindEnergyEfficientCpu(cpu_mask_t available_mask) {
+  cpu_num_t target_cpu = INVALID_CPU;
+  ktl::tuple<SchedProcessingRate, SchedUtilization> target_criteria{};
+
+  cpu_mask_t candidates = available_mask;
+  while (candidates.any()) {
+    const cpu_num_t candidate_cpu = candidates.lowest();
+    candidates.reset(candidate_cpu);
+
+    // Skip CPUs that are already loaded, either on average or right now.
+    const Scheduler* const candidate = Get(candidate_cpu);
+    const SchedProcessingRate processing_rate = candidate->exported_processing_rate();
+    const SchedUtilization demand = candidate->exported_demand();
+    if (demand >= SchedUtilization{kEnergyPackUtilization * processing_rate} ||
+        candidate->exported_queue_time_ns() > kInterClusterThreshold) {
+      continue;
+    }
+
+    const ktl::tuple candidate_criteria{processing_rate, demand};
+    if (target_cpu == INVALID_CPU || candidate_criteria < target_criteria) {
+      target_cpu = candidate_cpu;
+      target_criteria = candidate_criteria;
+    }
+  }
+
+  return target_cpu;
+}
+
+bool Scheduler::IsSmtIsolatedFor(zx_koid_t pid, cpu_mask_t idle_mask) const {
+  cpu_mask_t siblings = smt_siblings_;
+  while (siblings.any()) {
+    const cpu_num_t sibling = siblings.lowest();
+    siblings.reset(sibling);
+    if (idle_mask.test(sibling)) {
+      continue;
+    }
+    // Kernel threads do not belong to a process and are never considered
+    // related to the thread being placed.
+    if (pid == ZX_KOID_INVALID || Get(sibling)->exported_active_pid_.load() != pid) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void Scheduler::IncFindTargetCpuRetriesKcounter() { counter_find_target_cpu_retries.Add(1u); }
 
 #if !EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
@@ -1471,7 +1814,7 @@ void Scheduler::ProcessSaveStateList() {
   ChainLockTransaction& active_clt = ChainLockTransaction::ActiveRef();
   active_clt.Restart(CLT_TAG("Scheduler::ProcessSaveStateList (restart)"));
 
-  cpu_mask_t cpus_to_reschedule_mask = 0;
+  cpu_mask_t cpus_to_reschedule_mask{};
   while (!local_save_state_list.is_empty()) {
     Thread* to_migrate = local_save_state_list.pop_front();
     // Acquire the thread's lock without backing off using an explicit retry
@@ -1517,6 +1860,114 @@ void Scheduler::ProcessSaveStateList() {
   }
 }
 
+void Scheduler::UpdateDemand(SchedTime now, SchedDuration busy_ns) {
+  demand_window_busy_ns_ += busy_ns;
+  const SchedDuration elapsed_ns = now - demand_window_start_;
+  if (elapsed_ns < kDemandWindow) {
+    return;
+  }
+
+  // Scale the busy fraction by the processing rate the window ran at so that
+  // demand is comparable across CPUs and power levels.
+  const SchedUtilization busy_fraction = ktl::min(
+      SchedUtilization{ffl::FromRatio(demand_window_busy_ns_.raw_value(), elapsed_ns.raw_value())},
+      SchedUtilization{1});
+  const SchedUtilization sample{busy_fraction * power_level_control_.processing_rate()};
+
+  // A window can span a long idle period, since an idle CPU does not
+  // reschedule. Decay once per elapsed window, up to a limit, so that a CPU
+  // waking from idle does not report its old demand.
+  constexpr int64_t kMaxDecaySteps = 8;
+  const int64_t windows =
+      ktl::min(elapsed_ns.raw_value() / kDemandWindow.raw_value(), kMaxDecaySteps);
+  for (int64_t i = 0; i < windows; i++) {
+    demand_ += PeakDecayDelta(demand_, sample, kExpectedRuntimeAlpha, kExpectedRuntimeBeta);
+  }
+  exported_demand_ = demand_;
+  demand_window_start_ = now;
+  demand_window_busy_ns_ = SchedDuration{0};
+  LOCAL_KTRACE_COUNTER(COUNTER, "Demand", this_cpu(),
+                       ("CPU", ffl::Round<uint64_t>(demand_ * 1000)));
+
+  // RescheduleCommon sends any resulting request after accounting is done.
+  if (gBootOptions->scheduler_energy_aware) {
+    const SchedProcessingRate target_rate{demand_ * kPowerLevelHeadroom};
+    if (power_level_control_.RequestPowerLevelForRate(target_rate)) {
+      counter_energy_aware_power_level_requests.Add(1);
+    }
+  }
+}
+
+void Scheduler::UpdateLoadAverages(SchedTime now) {
+  DEBUG_ASSERT(this_cpu_ == arch_curr_cpu_num());
+
+  const int64_t elapsed_ns = (now - load_last_update_).raw_value();
+  if (elapsed_ns > 0) {
+    load_runnable_ns_ += runnable_task_count() * elapsed_ns;
+    if (active_thread_ != nullptr && !active_thread_->IsIdle()) {
+      load_busy_ns_ += elapsed_ns;
+    }
+    load_last_update_ = now;
+  }
+
+  const zx_duration_mono_t period_ns = (now - load_period_start_).raw_value();
+  if (period_ns < kLoadAveragePeriod) {
+    ArmLoadRefreshTimer(now);
+    return;
+  }
+
+  // The mean over the elapsed time stands in for each elapsed period, which
+  // also decays the averages of a CPU that was idle for several periods.
+  const uint64_t periods = period_ns / kLoadAveragePeriod;
+  const int64_t runnable_sample = LoadAverageSample(load_runnable_ns_, period_ns);
+  const int64_t busy_sample = LoadAverageSample(load_busy_ns_, period_ns);
+  for (size_t i = 0; i < kLoadAverageWindows; i++) {
+    runnable_load_[i] =
+        LoadAverageUpdate(runnable_load_[i], runnable_sample, kLoadAverageDecay[i], periods);
+    busy_load_[i] = LoadAverageUpdate(busy_load_[i], busy_sample, kLoadAverageDecay[i], periods);
+  }
+  load_period_start_ = now;
+  load_runnable_ns_ = 0;
+  load_busy_ns_ = 0;
+
+  // Each CPU sets its own slot, so the sums across CPUs are the system-wide
+  // load averages.
+  const auto thousandths = [](int64_t average) { return average * 1000 / kLoadAverageOne; };
+  counter_load_runnable_1s.Set(thousandths(runnable_load_[0]));
+  counter_load_runnable_10s.Set(thousandths(runnable_load_[1]));
+  counter_load_runnable_60s.Set(thousandths(runnable_load_[2]));
+  counter_load_busy_1s.Set(thousandths(busy_load_[0]));
+  counter_load_busy_10s.Set(thousandths(busy_load_[1]));
+  counter_load_busy_60s.Set(thousandths(busy_load_[2]));
+
+  ArmLoadRefreshTimer(now);
+}
+
+void Scheduler::ArmLoadRefreshTimer(SchedTime now) {
+  // Refresh soon after the CPU last ran a thread, when the averages change the
+  // most, then back off while it stays idle.
+  if (active_thread_ != nullptr && !active_thread_->IsIdle()) {
+    load_refresh_interval_ = kLoadAverageMinRefresh;
+  }
+  if (now < load_refresh_deadline_) {
+    return;
+  }
+  const auto is_zero = [](int64_t average) { return average == 0; };
+  if (ktl::all_of(runnable_load_.begin(), runnable_load_.end(), is_zero) &&
+      ktl::all_of(busy_load_.begin(), busy_load_.end(), is_zero)) {
+    return;
+  }
+
+  // The timer has no slack so that it stays on this CPU. If this CPU went
+  // offline while the timer was pending, it fired on another CPU, where the
+  // handler does nothing.
+  load_refresh_deadline_ = now + SchedNs(load_refresh_interval_);
+  load_refresh_interval_ = ktl::min(load_refresh_interval_ * 2, kLoadAverageMaxRefresh);
+  load_refresh_timer_.Cancel();
+  load_refresh_timer_.Set(Deadline::no_slack(load_refresh_deadline_.raw_value()),
+                          LoadRefreshTimerHandler, this);
+}
+
 void Scheduler::UpdateEstimatedEnergyConsumption(Thread* current_thread,
                                                  SchedMonoTimeAndBootTicks now,
                                                  SchedDuration actual_runtime_ns) {
@@ -1649,11 +2100,16 @@ void Scheduler::RescheduleCommon(Thread* const current_thread, EndTraceCallback
   const SchedDuration total_runtime_ns = now - start_of_current_time_slice_ns_;
 
   current_state->runtime_ns_ += actual_runtime_ns;
+  if (!current_thread->IsIdle() && cluster() < SchedulerState::kMaxWarmClusters) {
+    current_state->cluster_last_ran_[cluster()] = now;
+  }
   current_thread->UpdateRuntimeStats(current_thread->state());
 
   // Update the energy consumption accumulators for the current task and
   // processor.
   UpdateEstimatedEnergyConsumption(current_thread, mono_and_boot_now, actual_runtime_ns);
+  UpdateDemand(now, current_thread->IsIdle() ? SchedDuration{0} : actual_runtime_ns);
+  UpdateLoadAverages(now);
 
 #if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
   // Update the used time slice before evaluating the next task. Scale the
@@ -1908,6 +2364,12 @@ void Scheduler::RescheduleCommon(Thread* const current_thread, EndTraceCallback
     // Update stall contributions of the current and next thread.
     StallAccumulator::ApplyContextSwitch(current_thread, next_thread);
 
+    if (gBootOptions->scheduler_latency_histograms) {
+      RecordLatencyHistograms(now, current_thread, next_thread);
+    }
+    next_state->switched_in_time_ = now;
+    next_state->wakeup_time_ = SchedTime{0};
+
     // If the current thread is not the idle thread and not migrating, return it
     // to the run queue or remove its bookkeeping, depending on whether it is
     // READY.
@@ -1916,12 +2378,30 @@ void Scheduler::RescheduleCommon(Thread* const current_thread, EndTraceCallback
         QueueThread(current_thread,
                     timeslice_expired ? Placement::Insertion : Placement::Preemption, now);
       } else {
+        // A blocking deadline thread is likely to wake on this CPU within the
+        // next couple of its periods, and can tolerate at most the slack in its
+        // deadline as wakeup latency. Bound the idle exit latency accordingly.
+        if (IsDeadlineThread(current_thread)) {
+          const SchedDeadlineParams& params = current_state->effective_profile_.deadline();
+          SchedDuration limit = params.deadline_ns - params.capacity_ns;
+          if (now < exported_idle_latency_expiry_.load()) {
+            const SchedDuration current_limit = exported_idle_latency_limit_.load();
+            limit = current_limit < limit ? current_limit : limit;
+          }
+          exported_idle_latency_limit_ = limit;
+          exported_idle_latency_expiry_ = now + params.deadline_ns + params.deadline_ns;
+        }
         RemoveThreadLocked(now, current_thread);
       }
     }
   }
 
   next_thread->set_running();
+  if (next_state->last_cpu_ != current_cpu && next_state->last_cpu_ != INVALID_CPU &&
+      !next_thread->IsIdle()) {
+    next_state->migration_count_++;
+    next_thread->CountMigration();
+  }
   next_state->last_cpu_ = current_cpu;
   DEBUG_ASSERT(next_state->curr_cpu_ == current_cpu);
   active_thread_ = next_thread;
@@ -1982,6 +2462,8 @@ void Scheduler::RescheduleCommon(Thread* const current_thread, EndTraceCallback
   power_level_control_.SendPendingPowerLevelRequest();
 
   SetIdle(next_thread->IsIdle());
+  exported_active_pid_ = next_thread->IsIdle() ? ZX_KOID_INVALID : next_thread->pid();
+  exported_active_thread_ = reinterpret_cast<uintptr_t>(next_thread);
 
   if (current_thread->IsIdle()) {
     percpu::Get(current_cpu).stats.idle_time += actual_runtime_ns;
@@ -2013,13 +2495,14 @@ void Scheduler::RescheduleCommon(Thread* const current_thread, EndTraceCallback
     start_of_current_time_slice_ns_ = now;
     scheduled_weight_total_ = weight_total_;
 
-    // Adjust the preemption time to account for a deadline thread becoming
-    // eligible before the current time slice expires.
-    const SchedTime preemption_time_ns =
-        IsFairThread(next_thread)
-            ? ClampToDeadline(target_preemption_time_ns_)
-            : ClampToEarlierDeadline(target_preemption_time_ns_, next_state->finish_time_);
-    DEBUG_ASSERT(preemption_time_ns <= target_preemption_time_ns_);
+    // Adjust the preemption time to account for a thread that should preempt
+    // this one becoming eligible before the current time slice expires.
+    const SchedTime preemption_time_ns = CanStopTick(next_thread)
+                                             ? SchedTime{ZX_TIME_INFINITE}
+                                             : ClampPreemptionTime(IsFairThread(next_thread),
+                                                                   target_preemption_time_ns_,
+                                                                   next_state->finish_time_);
+    DEBUG_ASSERT(CanStopTick(next_thread) || preemption_time_ns <= target_preemption_time_ns_);
 
     PreemptReset(current_cpu, now.raw_value(), preemption_time_ns.raw_value());
     trace_start_preemption =
@@ -2051,29 +2534,32 @@ void Scheduler::RescheduleCommon(Thread* const current_thread, EndTraceCallback
     //     before its time slice expires.
     //   * Current is a deadline thread and a deadline thread with an earlier
     //     deadline will become eligible before its time slice expires.
+    //   * Current is a fair thread, kernel.scheduler.bandwidth-preemption is
+    //     set, and a fair thread with an earlier finish time will become
+    //     eligible before its time slice expires.
     //
     // Note that the target preemption time remains set to the ideal
     // preemption time for the current task, even if the preemption timer is set
     // earlier. If a task that becomes eligible is stolen before the early
     // preemption is handled, this logic will reset to the original target
     // preemption time.
-    const SchedTime preemption_time_ns =
-        IsFairThread(next_thread)
-            ? ClampToDeadline(target_preemption_time_ns_)
-            : ClampToEarlierDeadline(target_preemption_time_ns_, next_state->finish_time_);
-    DEBUG_ASSERT(preemption_time_ns <= target_preemption_time_ns_);
+    const SchedTime preemption_time_ns = CanStopTick(next_thread)
+                                             ? SchedTime{ZX_TIME_INFINITE}
+                                             : ClampPreemptionTime(IsFairThread(next_thread),
+                                                                   target_preemption_time_ns_,
+                                                                   next_state->finish_time_);
+    DEBUG_ASSERT(CanStopTick(next_thread) || preemption_time_ns <= target_preemption_time_ns_);
 
     PreemptReset(current_cpu, now.raw_value(), preemption_time_ns.raw_value());
     trace_continue = KTRACE_END_SCOPE(("preemption_time", preemption_time_ns),
                                       ("target preemption time", target_preemption_time_ns_));
   }
 
-  // Assert that there is no path beside running the idle thread can leave the
-  // preemption timer unarmed. However, the preemption timer may or may not be
-  // armed when running the idle thread.
-  // TODO(eieio): In the future, the preemption timer may be canceled when there
-  // is only one task available to run. Revisit this assertion at that time.
-  DEBUG_ASSERT(next_thread->IsIdle() || percpu::Get(current_cpu).timer_queue.PreemptArmed());
+  // Assert that there is no path beside running the idle thread or the only
+  // thread of an isolated CPU can leave the preemption timer unarmed. However,
+  // the preemption timer may or may not be armed in those cases.
+  DEBUG_ASSERT(next_thread->IsIdle() || CanStopTick(next_thread) ||
+               percpu::Get(current_cpu).timer_queue.PreemptArmed());
 
   // Almost done, we need to handle the actual context switch (if any).
   if (current_thread != next_thread) {
@@ -2311,6 +2797,69 @@ SchedTime Scheduler::ClampToEarlierDeadline(SchedTime completion_time, SchedTime
   return completion_time;
 }
 
+#if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+SchedTime Scheduler::ClampToEarlierFair(SchedTime completion_time, SchedTime finish_time) {
+  const Thread* const thread = FindEarlierFairThread(completion_time, finish_time);
+
+  if (thread != nullptr) {
+    AssertInScheduler(*thread);
+    // Queued fair threads are kept in the variable timeline.
+    const SchedTime start_time = VariableToMonotonic(thread->scheduler_state().start_time_);
+    return ktl::min(completion_time, start_time);
+  }
+
+  return completion_time;
+}
+#endif  // EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+
+SchedTime Scheduler::ClampPreemptionTime(bool is_fair, SchedTime completion_time,
+                                         SchedTime finish_time) {
+  if (!is_fair) {
+    return ClampToEarlierDeadline(completion_time, finish_time);
+  }
+
+  // Eligible deadline threads always preempt fair threads.
+  const SchedTime preemption_time = ClampToDeadline(completion_time);
+
+#if EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+  // Following the bandwidth model in //zircon/kernel/lib/sched/README.md, also
+  // preempt in favor of a fair thread that becomes eligible before the time
+  // slice completes and finishes before this one.
+  if (gBootOptions->scheduler_bandwidth_preemption) {
+    return ktl::min(preemption_time, ClampToEarlierFair(completion_time, finish_time));
+  }
+#endif  // EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+
+  return preemption_time;
+}
+
+void Scheduler::RecordLatencyHistograms(SchedTime now, Thread* current_thread,
+                                        Thread* next_thread) {
+  // Per-thread buckets saturate rather than wrap so that a long-lived thread
+  // does not appear to have an empty bucket.
+  const auto record = [](SchedulerState::LatencyHistogram& histogram,
+                         zx_duration_mono_t duration) {
+    uint32_t& count = histogram[SchedHistogramBucket(duration)];
+    if (count != ktl::numeric_limits<uint32_t>::max()) {
+      count++;
+    }
+  };
+
+  SchedulerState& current_state = current_thread->scheduler_state();
+  if (!current_thread->IsIdle() && current_state.switched_in_time_ != SchedTime{0}) {
+    const zx_duration_mono_t burst = (now - current_state.switched_in_time_).raw_value();
+    CPU_STATS_HISTOGRAM_RECORD(run_burst, burst);
+    record(current_state.run_burst_histogram_, burst);
+  }
+
+  SchedulerState& next_state = next_thread->scheduler_state();
+  if (!next_thread->IsIdle() && next_state.wakeup_time_ != SchedTime{0}) {
+    const zx_duration_mono_t latency = (now - next_state.wakeup_time_).raw_value();
+    CPU_STATS_HISTOGRAM_RECORD(wakeup_latency, latency);
+    record(next_state.wakeup_latency_histogram_, latency);
+  }
+}
+
 SchedTime Scheduler::NextThreadTimeslice(Thread* thread, SchedTime now) {
   ktrace::Scope trace = LOCAL_KTRACE_BEGIN_SCOPE(DETAILED, "next_timeslice");
   SchedulerState* const state = &thread->scheduler_state();
@@ -2941,6 +3490,7 @@ void Scheduler::Unblock(Thread* thread) {
   thread->canary().Assert();
 
   const SchedTime now = CurrentTime();
+  RecordWaker(thread);
   cpu_num_t target_cpu = INVALID_CPU;
   while (true) {
     // TODO(rudymathu): This target_cpu should be stashed in the thread prior to
@@ -2960,6 +3510,7 @@ void Scheduler::Unblock(Thread* thread) {
       TraceWakeup(thread, target_cpu);
       thread->set_ready();
       thread->UpdateRuntimeStats(thread->state());
+      thread->scheduler_state().wakeup_time_ = now;
       if (needs_migration) {
         MarkHasOwnedThreadAccess(*thread);
         target->save_state_list_.push_front(thread);
@@ -2984,13 +3535,14 @@ void Scheduler::Unblock(Thread::UnblockList list) {
   ChainLockTransaction::ActiveRef().AssertFinalized();
 
   const SchedTime now = CurrentTime();
-  cpu_mask_t cpus_to_reschedule_mask = 0;
+  cpu_mask_t cpus_to_reschedule_mask{};
 
   Thread* thread;
   while ((thread = list.pop_back()) != nullptr) {
     thread->canary().Assert();
     DEBUG_ASSERT(!thread->IsIdle());
     thread->get_lock().AssertAcquired();
+    RecordWaker(thread);
 
     cpu_num_t target_cpu = INVALID_CPU;
     while (true) {
@@ -2998,7 +3550,12 @@ void Scheduler::Unblock(Thread::UnblockList list) {
       // to adding it to the save_state_list_, as that would allow us to bypass
       // CPU selection when processing the list so long as the CPU is still
       // online.
-      target_cpu = FindTargetCpu(thread);
+      //
+      // The CPUs chosen for earlier threads in the list already account for
+      // them in their queue times. Passing them as the batch keeps the search
+      // going past them, so that a herd of woken threads is spread out while
+      // the reschedule IPIs are still sent once for the whole batch below.
+      target_cpu = FindTargetCpu(thread, cpus_to_reschedule_mask);
       const cpu_num_t last_cpu = thread->scheduler_state().last_cpu();
       const bool needs_migration = (last_cpu != INVALID_CPU && target_cpu != last_cpu &&
                                     thread->has_migrate_fn() && !thread->migrate_pending());
@@ -3012,6 +3569,7 @@ void Scheduler::Unblock(Thread::UnblockList list) {
         TraceWakeup(thread, target_cpu);
         thread->set_ready();
         thread->UpdateRuntimeStats(thread->state());
+        thread->scheduler_state().wakeup_time_ = now;
         if (needs_migration) {
           MarkHasOwnedThreadAccess(*thread);
           target->save_state_list_.push_front(thread);
@@ -3038,7 +3596,7 @@ void Scheduler::UnblockIdle(Thread* thread) {
   SchedulerState* const state = &thread->scheduler_state();
 
   DEBUG_ASSERT(thread->IsIdle());
-  DEBUG_ASSERT(ktl::popcount(state->hard_affinity_) == 1);
+  DEBUG_ASSERT(state->hard_affinity_.count() == 1);
 
   const cpu_num_t target_cpu = lowest_cpu_set(state->hard_affinity_);
   Scheduler* const target_scheduler = Get(target_cpu);
@@ -3099,6 +3657,42 @@ void Scheduler::Yield(Thread* const current_thread) {
   }
 }
 
+zx_status_t Scheduler::PrepareYieldTo(Thread* const target) {
+  ktrace::Scope trace = LOCAL_KTRACE_BEGIN_SCOPE(COMMON, "sched_prepare_yield_to");
+  DEBUG_ASSERT(target != Thread::Current::Get());
+
+  if (target->state() == THREAD_RUNNING) {
+    return ZX_ERR_SHOULD_WAIT;
+  }
+  if (target->state() != THREAD_READY) {
+    return ZX_ERR_BAD_STATE;
+  }
+
+#if !EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+  SchedulerState& state = target->scheduler_state();
+  if (const cpu_num_t curr_cpu = state.curr_cpu_; curr_cpu != INVALID_CPU && IsFairThread(target)) {
+    Scheduler& scheduler = *Get(curr_cpu);
+    Guard<MonitoredSpinLock, NoIrqSave> queue_guard{&scheduler.queue_lock_, SOURCE_TAG};
+    scheduler.AssertInScheduler(*target);
+
+    // A thread in transition between queues is left alone; it is about to be placed anyway.
+    if (target->disposition() == Disposition::Enqueued) {
+      scheduler.EraseFromQueue(target);
+
+      // Making the target eligible as of the current virtual time lets it run ahead of every
+      // thread whose activation starts later, without granting it any more time slice than it
+      // already has.
+      scheduler.UpdateTimeline(CurrentTime());
+      state.start_time_ = ktl::min(state.start_time_, scheduler.virtual_time_);
+      scheduler.QueueThread(target, Placement::Adjustment);
+      counter_yield_to_boost.Add(1);
+    }
+  }
+#endif  // !EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
+
+  return ZX_OK;
+}
+
 void Scheduler::Preempt() {
   Thread* current_thread = Thread::Current::Get();
   SingleChainLockGuard thread_guard{IrqSaveOption, current_thread->get_lock(),
@@ -3151,7 +3745,7 @@ void Scheduler::MigrateUnpinnedThreads() {
 
   const cpu_num_t current_cpu = arch_curr_cpu_num();
   const cpu_mask_t current_cpu_mask = cpu_num_to_mask(current_cpu);
-  cpu_mask_t cpus_to_reschedule_mask = 0;
+  cpu_mask_t cpus_to_reschedule_mask{};
 
   // Flag this scheduler as being in the process de-activating.  If a thread
   // with a migration function unblocks and needs to become READY while we are
@@ -3343,6 +3937,18 @@ void Scheduler::TimerTick(SchedTime now) {
   Thread::Current::preemption_state().PreemptSetPending();
 }
 
+void Scheduler::SampleLoad(SchedTime now) {
+  DEBUG_ASSERT(arch_ints_disabled());
+
+  // A busy CPU updates its load averages when it reschedules.
+  if (!Thread::Current::Get()->IsIdle()) {
+    return;
+  }
+  Scheduler* scheduler = Get();
+  Guard<MonitoredSpinLock, NoIrqSave> guard{&scheduler->queue_lock_, SOURCE_TAG};
+  scheduler->UpdateLoadAverages(now);
+}
+
 void Scheduler::InitializeProcessingRate(SchedProcessingRate scale) TA_NO_THREAD_SAFETY_ANALYSIS {
   // Since this happens early in boot, before the scheduler is actually running,
   // acquiring the queue lock is unnecessary.
@@ -3354,7 +3960,7 @@ void Scheduler::UpdateProcessingRates(zx_cpu_performance_info_t* info, size_t co
   DEBUG_ASSERT(count <= percpu::processor_count());
   InterruptDisableGuard irqd;
 
-  cpu_num_t cpus_to_reschedule_mask = 0;
+  cpu_mask_t cpus_to_reschedule_mask{};
   for (auto& entry : ktl::span{info, count}) {
     DEBUG_ASSERT(entry.logical_cpu_number <= percpu::processor_count());
 
@@ -3399,9 +4005,10 @@ cpu_mask_t Scheduler::SetCpuAffinity(Thread& thread, cpu_mask_t affinity,
                                      AffinityType affinity_type) {
   DEBUG_ASSERT_MSG(
       const cpu_mask_t active_mask = PeekActiveMask();
-      affinity_type == AffinityType::Soft || (affinity & active_mask) != 0,
-      "Attempted to set affinity mask to %#x, which has no overlap of active CPUs %#x.", affinity,
-      active_mask);
+      affinity_type == AffinityType::Soft || (affinity & active_mask).any(),
+      "Attempted to set affinity mask to %#" PRIx64
+      ", which has no overlap of active CPUs %#" PRIx64 ".",
+      affinity.word(0), active_mask.word(0));
 
   // Utility to set the correct affinity mask based on the affinity type. Uses a
   // function pointer conversion (i.e. +) to avoid a bug with static annotations
@@ -3447,9 +4054,9 @@ cpu_mask_t Scheduler::SetCpuAffinity(Thread& thread, cpu_mask_t affinity,
       DEBUG_ASSERT(state.curr_cpu() != INVALID_CPU);
       const cpu_mask_t thread_cpu_mask = cpu_num_to_mask(state.curr_cpu());
 
-      cpu_mask_t cpus_to_reschedule_mask = 0;
+      cpu_mask_t cpus_to_reschedule_mask{};
       bool find_new_target_cpu = false;
-      cpu_mask_t previous_affinity = 0;
+      cpu_mask_t previous_affinity{};
 
       // Use a lambda to prevent the AssertInScheduler from leaking out of the
       // scope of the queue lock guard. Static lock assertions can leak out of
@@ -3466,7 +4073,7 @@ cpu_mask_t Scheduler::SetCpuAffinity(Thread& thread, cpu_mask_t affinity,
         previous_affinity = set_affinity(thread, affinity, affinity_type);
 
         const cpu_mask_t effective_cpu_mask = state.GetEffectiveCpuMask(PeekActiveMask());
-        const bool stale_curr_cpu = (thread_cpu_mask & effective_cpu_mask) == 0;
+        const bool stale_curr_cpu = (thread_cpu_mask & effective_cpu_mask).none();
 
         if (thread.state() == THREAD_RUNNING) {
           DEBUG_ASSERT(disposition == Disposition::Associated);
@@ -3488,7 +4095,7 @@ cpu_mask_t Scheduler::SetCpuAffinity(Thread& thread, cpu_mask_t affinity,
             CountUpdateInTransition();
             DEBUG_ASSERT(queue_state.stolen_by() != INVALID_CPU);
             const cpu_mask_t stealing_cpu_mask = cpu_num_to_mask(queue_state.stolen_by());
-            const bool stale_stealing_cpu = (stealing_cpu_mask & effective_cpu_mask) == 0;
+            const bool stale_stealing_cpu = (stealing_cpu_mask & effective_cpu_mask).none();
             if (stale_stealing_cpu) {
               cpus_to_reschedule_mask |= stealing_cpu_mask;
             }
@@ -3595,6 +4202,21 @@ bool Scheduler::PowerLevelControl::RequestPowerLevel(uint8_t power_level) {
   return !had_pending_request && pending_update_request_.has_value();
 }
 
+bool Scheduler::PowerLevelControl::RequestPowerLevelForRate(SchedProcessingRate processing_rate) {
+  if (!domain() || !domain()->scheduler_control_enabled()) {
+    return false;
+  }
+
+  const ktl::optional<uint8_t> power_level =
+      domain()->model().FindActivePowerLevelForRate(FromProcessingRate(processing_rate));
+  const ktl::optional<uint8_t> desired_power_level = power_state_.desired_active_power_level();
+  if (!power_level || power_level == desired_power_level ||
+      (!desired_power_level && power_level == active_power_level())) {
+    return false;
+  }
+  return RequestPowerLevel(*power_level);
+}
+
 void Scheduler::PowerLevelControl::TimerHandler(Timer* timer, zx_instant_mono_t now, void* arg) {
   // Only queue the DPC if the timer handler is running on the expected CPU. If the timer handler
   // is running on a different CPU, the CPU it services went offline while the timer was pending
@@ -7,7 +7,10 @@
 #include <lib/unittest/unittest.h>
 
 #include <arch/arch_interrupt.h>
+#include <kernel/queued_spinlock.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <ktl/array.h>
 
 namespace {
 
@@ -104,6 +107,73 @@ bool spinlock_assert_held_compile_test() {
   END_TEST;
 }
 
+struct ContendedCounter {
+  SpinLock lock;
+  uint64_t value TA_GUARDED(lock) = 0;
+};
+
+constexpr uint64_t kContendedIterations = 20000;
+
+int contended_increment(void* arg) {
+  auto* counter = static_cast<ContendedCounter*>(arg);
+  for (uint64_t i = 0; i < kContendedIterations; i++) {
+    interrupt_saved_state_t state;
+    counter->lock.AcquireIrqSave(state);
+    counter->value++;
+    counter->lock.ReleaseIrqRestore(state);
+  }
+  return 0;
+}
+
+// Contended acquisitions queue up behind one another. Check that no increment is lost and that
+// the queue is empty once everyone is done.
+bool spinlock_contended() {
+  BEGIN_TEST;
+
+  ContendedCounter counter;
+  ktl::array<Thread*, 4> threads;
+  for (Thread*& thread : threads) {
+    thread = Thread::Create("spinlock contender", contended_increment, &counter, DEFAULT_PRIORITY);
+    ASSERT_NONNULL(thread);
+  }
+  for (Thread* thread : threads) {
+    thread->Resume();
+  }
+  for (Thread* thread : threads) {
+    thread->Join(nullptr, ZX_TIME_INFINITE);
+  }
+
+  interrupt_saved_state_t state;
+  counter.lock.AcquireIrqSave(state);
+  EXPECT_EQ(kContendedIterations * threads.size(), counter.value);
+  counter.lock.ReleaseIrqRestore(state);
+  EXPECT_EQ(INVALID_CPU, counter.lock.HolderCpu());
+
+  END_TEST;
+}
+
+// A waiter that stopped while queued must not keep the panic path from taking the lock. Make up
+// such a waiter and check that the fallback takes the lock regardless and leaves the tail alone.
+bool spinlock_bypass_queue() {
+  BEGIN_TEST;
+
+  constexpr cpu_num_t kStuckTail = cpu_num_t{SMP_MAX_CPUS} << queued_spinlock::kTailShift;
+  arch_spin_lock_t lock;
+  lock.value.store(kStuckTail);
+
+  interrupt_saved_state_t state = arch_interrupt_save();
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  queued_spinlock::AcquireBypassingQueue(&lock, cpu);
+  EXPECT_EQ(kStuckTail | (cpu + 1), lock.value.load());
+  EXPECT_FALSE(queued_spinlock::TryAcquire(&lock, cpu));
+  queued_spinlock::Release(&lock);
+  arch_interrupt_restore(state);
+
+  EXPECT_EQ(kStuckTail, lock.value.load());
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(spinlock_tests)
@@ -112,4 +182,6 @@ UNITTEST("spinlock_trylock", spinlock_trylock)
 UNITTEST("spinlock_is_held", spinlock_is_held)
 UNITTEST("spinlock_assert_held", spinlock_assert_held)
 UNITTEST("spinlock_assert_held_compile_test", spinlock_assert_held_compile_test)
+UNITTEST("spinlock_contended", spinlock_contended)
+UNITTEST("spinlock_bypass_queue", spinlock_bypass_queue)
 UNITTEST_END_TESTCASE(spinlock_tests, "spinlock", "SpinLock tests")
@@ -20,6 +20,7 @@
 #include <debug.h>
 #include <inttypes.h>
 #include <lib/arch/intrin.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 #include <lib/fit/defer.h>
 #include <lib/fxt/interned_string.h>
@@ -94,6 +95,57 @@ KCOUNTER(thread_timeslice_extended, "thread.timeslice_extended")
 KCOUNTER(thread_restricted_kick_count, "thread.restricted_kick")
 // counts the number of failed samples
 KCOUNTER(thread_sampling_failed, "thread.sampling_failed")
+// counts the Thread structure allocations served from, or missed by, the per-CPU caches.
+KCOUNTER(thread_struct_cache_hit, "thread.struct_cache.hit")
+KCOUNTER(thread_struct_cache_miss, "thread.struct_cache.miss")
+
+namespace {
+
+// Thread structures are too large for the heap's per-CPU caches, so creating and freeing one takes
+// the heap lock. Like kernel stacks, each CPU keeps a few freed structures around for reuse, so
+// that threads that are created and destroyed at a high rate skip the heap.
+constexpr size_t kThreadStructCacheSize = 4;
+
+struct alignas(MAX_CACHE_LINE) ThreadStructCache {
+  DECLARE_MUTEX(ThreadStructCache) lock;
+  size_t count TA_GUARDED(lock) = 0;
+  void* structs[kThreadStructCacheSize] TA_GUARDED(lock) = {};
+};
+
+// Indexed by the CPU the caller happens to be running on. Nothing depends on staying on that CPU,
+// it only spreads out the lock contention.
+ThreadStructCache gThreadStructCaches[SMP_MAX_CPUS];
+
+ThreadStructCache& CurrentThreadStructCache() {
+  return gThreadStructCaches[arch_curr_cpu_num()];
+}
+
+void* AllocThreadStruct() {
+  {
+    ThreadStructCache& cache = CurrentThreadStructCache();
+    Guard<Mutex> guard{&cache.lock};
+    if (cache.count > 0) {
+      thread_struct_cache_hit.Add(1);
+      return cache.structs[--cache.count];
+    }
+  }
+  thread_struct_cache_miss.Add(1);
+  return memalign(alignof(Thread), sizeof(Thread));
+}
+
+void FreeThreadStruct(void* t) {
+  {
+    ThreadStructCache& cache = CurrentThreadStructCache();
+    Guard<Mutex> guard{&cache.lock};
+    if (cache.count < kThreadStructCacheSize) {
+      cache.structs[cache.count++] = t;
+      return;
+    }
+  }
+  free(t);
+}
+
+}  // namespace
 
 // The global thread list. This is a lazy_init type, since initial thread code
 // manipulates the list before global constructors are run. This is initialized by
@@ -213,7 +265,7 @@ static void free_thread_resources(Thread* t) {
   bool thread_needs_free = t->free_struct();
   t->~Thread();
   if (thread_needs_free) {
-    free(t);
+    FreeThreadStruct(t);
   }
 }
 
@@ -310,7 +362,7 @@ Thread* Thread::CreateEtc(Thread* t, const char* name, thread_start_routine entr
   unsigned int flags = 0;
 
   if (!t) {
-    t = static_cast<Thread*>(memalign(alignof(Thread), sizeof(Thread)));
+    t = static_cast<Thread*>(AllocThreadStruct());
     if (!t) {
       return nullptr;
     }
@@ -385,6 +437,27 @@ Thread* Thread::CreateEtc(Thread* t, const char* name, thread_start_routine entr
   return t;
 }
 
+size_t Thread::TrimStructCache() {
+  size_t trimmed = 0;
+  for (ThreadStructCache& cache : gThreadStructCaches) {
+    void* structs[kThreadStructCacheSize];
+    size_t count;
+    {
+      Guard<Mutex> guard{&cache.lock};
+      count = cache.count;
+      for (size_t i = 0; i < count; i++) {
+        structs[i] = cache.structs[i];
+      }
+      cache.count = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+      free(structs[i]);
+    }
+    trimmed += count;
+  }
+  return trimmed;
+}
+
 Thread* Thread::Create(const char* name, thread_start_routine entry, void* arg, int priority) {
   return Thread::CreateEtc(nullptr, name, entry, arg, SchedulerState::BaseProfile{priority},
                            nullptr);
@@ -631,7 +704,7 @@ zx_status_t Thread::RestrictedKick() {
 
   // Hold the thread's lock while we examine its state and figure out what to
   // do.
-  cpu_mask_t ipi_mask{0};
+  cpu_mask_t ipi_mask{};
   {
     SingleChainLockGuard guard{IrqSaveOption, get_lock(), CLT_TAG("Thread::RestrictedKick")};
 
@@ -656,7 +729,7 @@ zx_status_t Thread::RestrictedKick() {
     }
   }
 
-  if (ipi_mask != 0) {
+  if (ipi_mask) {
     mp_interrupt(mp_ipi_target::MASK, ipi_mask);
   }
 
@@ -1550,6 +1623,38 @@ void Thread::Current::Yield() {
   Scheduler::Yield(current_thread);
 }
 
+zx_status_t Thread::Current::YieldTo(Thread* target) {
+  Thread* current_thread = Thread::Current::Get();
+
+  current_thread->canary_.Assert();
+  target->canary_.Assert();
+  DEBUG_ASSERT(!arch_blocking_disallowed());
+  if (target == current_thread) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+
+  const auto do_transaction =
+      [&]() TA_REQ(chainlock_transaction_token) -> ChainLockTransaction::Result<zx_status_t> {
+    if (!AcquireBothOrBackoff(current_thread->get_lock(), target->get_lock())) {
+      return ChainLockTransaction::Action::Backoff;
+    }
+    ChainLockTransaction::Finalize();
+    DEBUG_ASSERT(current_thread->state() == THREAD_RUNNING);
+
+    const zx_status_t status = Scheduler::PrepareYieldTo(target);
+    // The target's lock must be dropped before rescheduling, which may pick it to run next.
+    target->get_lock().Release();
+    if (status == ZX_OK) {
+      CPU_STATS_INC(yields);
+      Scheduler::Yield(current_thread);
+    }
+    current_thread->get_lock().Release();
+    return status;
+  };
+  return ChainLockTransaction::UntilDone(IrqSaveOption, CLT_TAG("Thread::Current::YieldTo"),
+                                         do_transaction);
+}
+
 /**
  * @brief Preempt the current thread from an interrupt
  *
@@ -1605,17 +1710,17 @@ void PreemptionState::FlushPendingContinued(Flush flush) {
   InterruptDisableGuard interrupt_disable;
   // Recheck, pending preemptions could have been flushed by a context switch
   // before interrupts were disabled.
-  const cpu_mask_t pending_mask = preempts_pending_;
+  const cpu_mask_t pending_mask = preempts_pending_.load(ktl::memory_order_relaxed);
 
   // If there is a pending local preemption the scheduler will take care of
   // flushing all pending reschedules.
   const cpu_mask_t current_cpu_mask = cpu_num_to_mask(arch_curr_cpu_num());
-  if ((pending_mask & current_cpu_mask) != 0 && (flush & FlushLocal) != 0) {
+  if ((pending_mask & current_cpu_mask) && (flush & FlushLocal) != 0) {
     // Clear the local preempt pending flag before calling preempt.  Failure
     // to do this can cause recursion during Scheduler::Preempt if any code
     // (such as debug tracing code) attempts to disable and re-enable
     // preemption during the scheduling operation.
-    preempts_pending_ &= ~current_cpu_mask;
+    preempts_pending_.fetch_and(~current_cpu_mask, ktl::memory_order_relaxed);
 
     // TODO(johngro): We cannot be holding the current thread's lock while we do
     // this.  Is there a good way to enforce this requirement via either static
@@ -1624,7 +1729,7 @@ void PreemptionState::FlushPendingContinued(Flush flush) {
   } else if ((flush & FlushRemote) != 0) {
     // The current cpu is ignored by mp_reschedule if present in the mask.
     mp_reschedule(pending_mask, 0);
-    preempts_pending_ &= current_cpu_mask;
+    preempts_pending_.fetch_and(current_cpu_mask, ktl::memory_order_relaxed);
   }
 }
 
@@ -2134,14 +2239,18 @@ void ThreadDumper::DumpLocked(const Thread* t, const char* match_owner, bool ful
   if (full_dump) {
     dprintf(INFO, "dump_thread: t %p (%s:%s)\n", t, oname, t->name());
     dprintf(INFO,
-            "\tstate %s, curr/last cpu %d/%d, hard_affinity %#x, soft_cpu_affinity %#x, "
-            "%s, remaining time slice %" PRIi64 "\n",
+            "\tstate %s, curr/last cpu %d/%d, hard_affinity %#" PRIx64
+            ", soft_cpu_affinity %#" PRIx64 ", %s, remaining time slice %" PRIi64 "\n",
             thread_state_to_str(t->state()), (int)t->scheduler_state().curr_cpu(),
-            (int)t->scheduler_state().last_cpu(), t->scheduler_state().hard_affinity(),
-            t->scheduler_state().soft_affinity(), profile_str,
+            (int)t->scheduler_state().last_cpu(), t->scheduler_state().hard_affinity().word(0),
+            t->scheduler_state().soft_affinity().word(0), profile_str,
             t->scheduler_state().remaining_time_slice_ns().raw_value());
-    dprintf(INFO, "\truntime_ns %" PRIi64 ", runtime_s %" PRIi64 "\n", runtime,
-            runtime / 1000000000);
+    dprintf(INFO, "\truntime_ns %" PRIi64 ", runtime_s %" PRIi64 ", migrations %" PRIu64 "\n",
+            runtime, runtime / 1000000000, t->scheduler_state().migration_count());
+    if (gBootOptions->scheduler_latency_histograms) {
+      DumpSchedHistogram("wakeup latency (ns)", t->scheduler_state().wakeup_latency_histogram());
+      DumpSchedHistogram("run burst (ns)", t->scheduler_state().run_burst_histogram());
+    }
     t->stack().DumpInfo(INFO);
     dprintf(INFO, "\tentry %p, arg %p, flags 0x%x %s%s%s%s\n", t->task_state_.entry_,
             t->task_state_.arg_, t->flags_, (t->flags_ & THREAD_FLAG_DETACHED) ? "Dt" : "",
@@ -2245,6 +2354,12 @@ void Thread::UpdateRuntimeStats(thread_state new_state) {
   }
 }
 
+void Thread::CountMigration() {
+  if (user_thread_) {
+    user_thread_->AddMigration();
+  }
+}
+
 fbl::RefPtr<VmAspace> Thread::GetAspaceRef() const {
   SingleChainLockGuard guard{IrqSaveOption, get_lock(), CLT_TAG("Thread::GetAspaceRef")};
   return GetAspaceRefLocked();
@@ -2379,6 +2494,7 @@ ScopedMemoryStall::ScopedMemoryStall() {
   DEBUG_ASSERT(current_thread->memory_stall_state() == ThreadStallState::Progressing);
   current_thread->set_memory_stall_state(ThreadStallState::Stalling);
   percpu::GetCurrent().memory_stall_accumulator.Update(-1, +1);
+  start_ticks_ = current_mono_ticks();
 }
 
 ScopedMemoryStall::~ScopedMemoryStall() {
@@ -2393,4 +2509,9 @@ ScopedMemoryStall::~ScopedMemoryStall() {
   DEBUG_ASSERT(current_thread->memory_stall_state() == ThreadStallState::Stalling);
   current_thread->set_memory_stall_state(ThreadStallState::Progressing);
   percpu::GetCurrent().memory_stall_accumulator.Update(+1, -1);
+
+  ThreadDispatcher* user_thread = current_thread->user_thread();
+  if (likely(user_thread)) {
+    user_thread->AddMemoryStallTicks(current_mono_ticks() - start_ticks_);
+  }
 }
@@ -103,14 +103,14 @@ bool set_affinity_self_test() {
   // Our worker thread will attempt to schedule itself onto each core, one at
   // a time, and ensure it landed in the right location.
   cpu_mask_t online_cpus = mp_get_online_mask();
-  ASSERT_NE(online_cpus, 0u, "Expected at least one CPU to be online.");
+  ASSERT_TRUE(online_cpus.any(), "Expected at least one CPU to be online.");
   auto worker_body = +[](void* arg) -> int {
     cpu_mask_t& online_cpus = *reinterpret_cast<cpu_mask_t*>(arg);
     Thread* const self = Thread::Current::Get();
 
     for (cpu_num_t c = 0u; c <= highest_cpu_set(online_cpus); c++) {
       // Skip offline CPUs.
-      if ((cpu_num_to_mask(c) & online_cpus) == 0) {
+      if (!online_cpus.test(c)) {
         continue;
       }
 
@@ -163,10 +163,10 @@ bool set_affinity_other_test() {
 
   // Migrate the worker task amongst different threads.
   const cpu_mask_t online_cpus = mp_get_online_mask();
-  ASSERT_NE(online_cpus, 0u, "Expected at least one CPU to be online.");
+  ASSERT_TRUE(online_cpus.any(), "Expected at least one CPU to be online.");
   for (cpu_num_t c = 0u; c <= highest_cpu_set(online_cpus); c++) {
     // Skip offline CPUs.
-    if ((cpu_num_to_mask(c) & online_cpus) == 0) {
+    if (!online_cpus.test(c)) {
       continue;
     }
 
@@ -209,10 +209,10 @@ bool thread_last_cpu_running_thread() {
 
   // Migrate the worker task across different CPUs.
   const cpu_mask_t online_cpus = mp_get_online_mask();
-  ASSERT_NE(online_cpus, 0u, "Expected at least one CPU to be online.");
+  ASSERT_TRUE(online_cpus.any(), "Expected at least one CPU to be online.");
   for (cpu_num_t c = 0u; c <= highest_cpu_set(online_cpus); c++) {
     // Skip offline CPUs.
-    if ((cpu_num_to_mask(c) & online_cpus) == 0) {
+    if (!online_cpus.test(c)) {
       continue;
     }
 
@@ -236,7 +236,7 @@ bool thread_empty_soft_affinity_mask() {
   worker.WaitForWorkerProgress();
 
   // Set affinity to an invalid (empty) mask.
-  worker.thread()->SetSoftCpuAffinity(0);
+  worker.thread()->SetSoftCpuAffinity({});
 
   // Ensure that the thread is still running.
   worker.WaitForWorkerProgress();
@@ -280,7 +280,7 @@ bool set_migrate_fn_test() {
   BEGIN_TEST;
 
   cpu_mask_t active_cpus = Scheduler::PeekActiveMask();
-  if (active_cpus == 0 || ispow2(active_cpus)) {
+  if (active_cpus.count() < 2) {
     printf("Expected multiple CPUs to be active.\n");
     return true;
   }
@@ -361,7 +361,7 @@ bool set_migrate_ready_threads_test() {
   BEGIN_TEST;
 
   cpu_mask_t active_cpus = Scheduler::PeekActiveMask();
-  if (active_cpus == 0 || ispow2(active_cpus)) {
+  if (active_cpus.count() < 2) {
     printf("Expected multiple CPUs to be active.\n");
     return true;
   }
@@ -447,7 +447,7 @@ bool set_migrate_ready_threads_test() {
 bool migrate_unpinned_threads_test() {
   BEGIN_TEST;
   const cpu_mask_t active_cpus = Scheduler::PeekActiveMask();
-  if (active_cpus == 0 || ispow2(active_cpus)) {
+  if (active_cpus.count() < 2) {
     printf("Expected multiple CPUs to be active.\n");
     return true;
   }
@@ -521,7 +521,7 @@ bool migrate_stress_test() {
   }
 
   // Get number of CPUs in the system.
-  const int active_cpus = ktl::popcount(Scheduler::PeekActiveMask());
+  const int active_cpus = static_cast<int>(Scheduler::PeekActiveMask().count());
   printf("Found %d active CPU(s)\n", active_cpus);
   if (active_cpus <= 1) {
     printf("Test can only proceed with multiple active CPUs.\n");
@@ -611,7 +611,7 @@ bool migrate_stress_test() {
     threads[i].thread->SetMigrateFn(migrate_fn);
 
     // Start running on `starting_cpu`.
-    threads[i].thread->SetSoftCpuAffinity(1 << starting_cpu);
+    threads[i].thread->SetSoftCpuAffinity(cpu_num_to_mask(starting_cpu));
     threads[i].thread->Resume();
   }
 
@@ -627,7 +627,7 @@ bool migrate_stress_test() {
   // Mutate threads as they run.
   for (int i = 0; i < 10'000; i++) {
     for (size_t j = 0; j < threads.size(); j++) {
-      const cpu_mask_t affinity = static_cast<cpu_mask_t>(i + j) & Scheduler::PeekActiveMask();
+      const cpu_mask_t affinity = CpuMask::FromWord(i + j) & Scheduler::PeekActiveMask();
       if (affinity) {
         threads[j].thread->SetSoftCpuAffinity(affinity);
       }
@@ -666,7 +666,7 @@ bool set_migrate_fn_stress_test() {
   BEGIN_TEST;
 
   // Get number of CPUs in the system.
-  int active_cpus = ktl::popcount(Scheduler::PeekActiveMask());
+  int active_cpus = static_cast<int>(Scheduler::PeekActiveMask().count());
   printf("Found %d active CPU(s)\n", active_cpus);
   if (active_cpus <= 1) {
     printf("Test can only proceed with multiple active CPUs.\n");
@@ -775,6 +775,36 @@ bool set_context_switch_fn_test() {
   END_TEST;
 }
 
+bool yield_to_test() {
+  BEGIN_TEST;
+
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS, Thread::Current::YieldTo(Thread::Current::Get()));
+
+  ktl::atomic<bool> ran{false};
+  auto worker_body = [](void* arg) -> int {
+    static_cast<ktl::atomic<bool>*>(arg)->store(true);
+    return 0;
+  };
+  Thread* worker = Thread::Create("yield_to_test_worker", worker_body, &ran, DEFAULT_PRIORITY);
+  ASSERT_NONNULL(worker, "thread_create failed.");
+
+  // A thread that has not been resumed is not runnable, so there is nothing to yield to.
+  EXPECT_EQ(ZX_ERR_BAD_STATE, Thread::Current::YieldTo(worker));
+
+  // Yielding to the worker must let it make progress, wherever it was placed.
+  worker->Resume();
+  while (!ran.load()) {
+    const zx_status_t status = Thread::Current::YieldTo(worker);
+    EXPECT_NE(ZX_ERR_INVALID_ARGS, status);
+  }
+
+  int worker_retcode;
+  ASSERT_EQ(worker->Join(&worker_retcode, ZX_TIME_INFINITE), ZX_OK, "Failed to join thread.");
+  EXPECT_EQ(worker_retcode, 0);
+
+  END_TEST;
+}
+
 bool scoped_allocation_disabled_test() {
   BEGIN_TEST;
 
@@ -1019,6 +1049,26 @@ struct TaskRuntimeStatsTests {
     EXPECT_EQ(prev_trs.queue_ticks, trs.queue_ticks);
     EXPECT_EQ(kPageFaultTicks, trs.page_fault_ticks);
     EXPECT_EQ(kLockContentionTicks, trs.lock_contention_ticks);
+    EXPECT_EQ(0u, trs.migrations);
+
+    // Migrations are counted, and accumulate like the other stats.
+    stats.AddMigration();
+    stats.AddMigration();
+    trs = stats.GetCompensatedTaskRuntimeStats();
+    EXPECT_EQ(2u, trs.migrations);
+    EXPECT_EQ(kLockContentionTicks, trs.lock_contention_ticks);
+
+    const zx_duration_mono_ticks_t kMemoryStallTicks = 50;
+    EXPECT_EQ(0, trs.memory_stall_ticks);
+    stats.AddMemoryStallTicks(kMemoryStallTicks);
+    trs = stats.GetCompensatedTaskRuntimeStats();
+    EXPECT_EQ(kMemoryStallTicks, trs.memory_stall_ticks);
+    EXPECT_EQ(kPageFaultTicks, trs.page_fault_ticks);
+
+    TaskRuntimeStats total = trs;
+    total += trs;
+    EXPECT_EQ(4u, total.migrations);
+    EXPECT_EQ(2 * kMemoryStallTicks, total.memory_stall_ticks);
 
     END_TEST;
   }
@@ -1037,6 +1087,7 @@ UNITTEST("migrate_unpinned_threads_test", migrate_unpinned_threads_test)
 UNITTEST("migrate_stress_test", migrate_stress_test)
 UNITTEST("set_migrate_fn_stress_test", set_migrate_fn_stress_test)
 UNITTEST("set_context_switch_fn", set_context_switch_fn_test)
+UNITTEST("yield_to_test", yield_to_test)
 UNITTEST("scoped_allocation_disabled_test", scoped_allocation_disabled_test)
 UNITTEST("backtrace_static_method_test", backtrace_static_method_test)
 UNITTEST("backtrace_instance_method_test", backtrace_instance_method_test)
@@ -40,6 +40,7 @@
 
 #include <cstdio>
 
+#include <arch/interrupt.h>
 #include <kernel/lockdep.h>
 #include <kernel/mp.h>
 #include <kernel/percpu.h>
@@ -64,8 +65,8 @@ KCOUNTER(timer_fired_counter, "timer.fired")
 // firing are not counted.
 KCOUNTER(timer_canceled_counter, "timer.canceled")
 
-// static
-MonitoredSpinLock Timer::timer_lock __CPU_ALIGN_EXCLUSIVE{"timer_lock"_intern};
+// Number of timers placed on another cpu's queue to share a wakeup it already had.
+KCOUNTER(timer_migrated_counter, "timer.migrated")
 
 namespace {
 
@@ -124,8 +125,18 @@ zx_ticks_t TimerQueue::ConvertBootTimeToRawTicks(zx_instant_boot_t boot) {
   return zx_ticks_sub_ticks(deadline_boot_ticks, timer_get_boot_ticks_offset());
 }
 
+zx_duration_mono_t TimerQueue::TimeUntilNextWakeup() const {
+  DEBUG_ASSERT(arch_ints_disabled());
+  if (next_timer_deadline_ == ZX_TIME_INFINITE) {
+    return ZX_TIME_INFINITE;
+  }
+  const zx_ticks_t remaining =
+      zx_ticks_sub_ticks(next_timer_deadline_, platform_current_raw_ticks());
+  return remaining <= 0 ? 0 : gTicksToTime.Scale(remaining);
+}
+
 void TimerQueue::UpdatePlatformTimer() {
-  Guard<MonitoredSpinLock, NoIrqSave> guard{Timer::TimerLock::Get(), SOURCE_TAG};
+  Guard<MonitoredSpinLock, NoIrqSave> guard{&lock_, SOURCE_TAG};
   UpdatePlatformTimerLocked();
 }
 
@@ -134,11 +145,11 @@ void TimerQueue::UpdatePlatformTimerLocked() {
   zx_ticks_t timer_deadline = ZX_TIME_INFINITE;
 
   // The monotonic deadline should be the minimum of the preemption timer and the front of the
-  // monotonic timer list.
+  // monotonic timer tree.
   zx_instant_mono_t mono_time_deadline = preempt_timer_deadline_;
-  if (!monotonic_timer_list_.is_empty()) {
+  if (!monotonic_timers_.is_empty()) {
     mono_time_deadline =
-        ktl::min(mono_time_deadline, monotonic_timer_list_.front().scheduled_time_);
+        ktl::min(mono_time_deadline, monotonic_timers_.front().scheduled_time_);
   }
   const ktl::optional<zx_ticks_t> mono_ticks_deadline =
       ConvertMonotonicTimeToRawTicks(mono_time_deadline);
@@ -148,9 +159,9 @@ void TimerQueue::UpdatePlatformTimerLocked() {
 
   // Check if we have a boot timer with a sooner scheduled time and update the timer deadline
   // accordingly.
-  if (!boot_timer_list_.is_empty()) {
+  if (!boot_timers_.is_empty()) {
     const zx_ticks_t boot_deadline =
-        ConvertBootTimeToRawTicks(boot_timer_list_.front().scheduled_time_);
+        ConvertBootTimeToRawTicks(boot_timers_.front().scheduled_time_);
     timer_deadline = ktl::min(timer_deadline, boot_deadline);
   }
 
@@ -206,114 +217,156 @@ void TimerQueue::Insert(Timer* timer, zx_time_t earliest_deadline, zx_time_t lat
   DEBUG_ASSERT(arch_ints_disabled());
   LTRACEF("timer %p, cpu %u, scheduled %" PRIi64 "\n", timer, arch_curr_cpu_num(),
           timer->scheduled_time_);
-  fbl::DoublyLinkedList<Timer*>& timer_list =
-      timer->clock_id_ == ZX_CLOCK_MONOTONIC ? monotonic_timer_list_ : boot_timer_list_;
-  InsertIntoTimerList(timer_list, timer, earliest_deadline, latest_deadline);
+  InsertIntoTimerTree(TreeForLocked(*timer), timer, earliest_deadline, latest_deadline);
+  timer->queue_.store(this, ktl::memory_order_relaxed);
+  PublishHeadHintLocked();
 }
 
-void TimerQueue::InsertIntoTimerList(fbl::DoublyLinkedList<Timer*>& timer_list, Timer* timer,
-                                     zx_time_t earliest_deadline, zx_time_t latest_deadline) {
-  // For inserting the timer we consider several cases. In general we
-  // want to coalesce with the current timer unless we can prove that
-  // either that:
-  //  1- there is no slack overlap with current timer OR
-  //  2- the next timer is a better fit.
-  //
-  // In diagrams that follow
-  // - Let |e| be the current (existing) timer deadline
-  // - Let |t| be the deadline of the timer we are inserting
-  // - Let |n| be the next timer deadline if any
-  // - Let |x| be the end of the list (not a timer)
-  // - Let |(| and |)| the earliest_deadline and latest_deadline.
+void TimerQueue::RemoveLocked(Timer* timer) {
+  TimerTree& timers = TreeForLocked(*timer);
+  const bool was_head = &timers.front() == timer;
+  timers.erase(*timer);
+  timer->queue_.store(nullptr, ktl::memory_order_relaxed);
+  kcounter_add(timer_canceled_counter, 1);
+  PublishHeadHintLocked();
 
-  for (Timer& entry : timer_list) {
-    if (entry.scheduled_time_ > latest_deadline) {
-      // New timer latest is earlier than the current timer.
-      // Just add upfront as is, without slack.
-      //
-      //   ---------t---)--e-------------------------------> time
-      timer->slack_ = 0ll;
-      timer_list.insert(entry, timer);
-      return;
+  // TODO(cpu): If, after removing |timer| there is one other single Timer with
+  // the same scheduled_time_ and slack_ non-zero, then it is possible to return
+  // that timer to the ideal scheduled_time_.
+
+  // See if we've just modified the head of this TimerQueue.
+  //
+  // If Timer was on another cpu's queue, we'll just let it fire and sort itself out.
+  if (unlikely(was_head) && this == &percpu::GetCurrent().timer_queue) {
+    // The Timer we're canceling was at head of this queue, so see if we should update platform
+    // timer.
+    if (!timers.is_empty()) {
+      UpdatePlatformTimerLocked();
+    } else if (next_timer_deadline_ == ZX_TIME_INFINITE) {
+      LTRACEF("clearing old hw timer, preempt timer not set, nothing in the queue\n");
+      platform_stop_timer();
     }
+  }
+}
 
-    if (entry.scheduled_time_ >= timer->scheduled_time_) {
-      //  New timer slack overlaps and is to the left (or equal). We
-      //  coalesce with current by scheduling late.
-      //
-      //  --------(----t---e-)----------------------------> time
-      timer->slack_ = zx_time_sub_time(entry.scheduled_time_, timer->scheduled_time_);
-      timer->scheduled_time_ = entry.scheduled_time_;
-      kcounter_add(timer_coalesced_counter, 1);
-      timer_list.insert_after(timer_list.make_iterator(entry), timer);
-      return;
+TimerQueue::TimerTree& TimerQueue::TreeForLocked(const Timer& timer) {
+  return timer.clock_id_ == ZX_CLOCK_MONOTONIC ? monotonic_timers_ : boot_timers_;
+}
+
+void TimerQueue::PublishHeadHintLocked() {
+  const zx_instant_mono_t head =
+      monotonic_timers_.is_empty() ? ZX_TIME_INFINITE : monotonic_timers_.front().scheduled_time_;
+  monotonic_head_hint_.store(head, ktl::memory_order_relaxed);
+}
+
+bool TimerQueue::HasTimerInWindow(TimerTree& timers, zx_time_t earliest_deadline,
+                                  zx_time_t latest_deadline) {
+  auto iter = timers.lower_bound({earliest_deadline, 0});
+  return iter.IsValid() && iter->scheduled_time_ <= latest_deadline;
+}
+
+bool TimerQueue::InsertOnRemoteQueue(Timer* timer, cpu_num_t local_cpu,
+                                     zx_time_t earliest_deadline, zx_time_t latest_deadline) {
+  DEBUG_ASSERT(arch_ints_disabled());
+  DEBUG_ASSERT(timer->clock_id_ == ZX_CLOCK_MONOTONIC);
+
+  for (cpu_num_t i = 0; i < percpu::processor_count(); i++) {
+    if (i == local_cpu || !mp_is_cpu_online(i)) {
+      continue;
     }
+    TimerQueue& timer_queue = percpu::Get(i).timer_queue;
 
-    if (entry.scheduled_time_ < earliest_deadline) {
-      // new timer earliest is later than the current timer. This case
-      // is handled in a future iteration.
-      //
-      //   ----------------e--(---t-----------------------> time
+    // Only take the lock of a queue whose next wakeup looks like it falls within the slack.
+    const zx_instant_mono_t head = timer_queue.monotonic_head_hint_.load(ktl::memory_order_relaxed);
+    if (head < earliest_deadline || head > latest_deadline) {
       continue;
     }
 
-    // New timer is to the right of current timer and there is overlap
-    // with the current timer, but could the next timer (if any) be
-    // a better fit?
-    //
-    //  -------------(--e---t-----?-------------------> time
-
-    auto iter = timer_list.make_iterator(entry);
-    ++iter;
-    if (iter != timer_list.end()) {
-      const Timer& next = *iter;
-      if (next.scheduled_time_ <= timer->scheduled_time_) {
-        // The new timer is to the right of the next timer. There is no
-        // chance the current timer is a better fit.
-        //
-        //  -------------(--e---n---t----------------------> time
-        continue;
-      }
+    Guard<MonitoredSpinLock, NoIrqSave> guard{&timer_queue.lock_, SOURCE_TAG};
+    if (!HasTimerInWindow(timer_queue.monotonic_timers_, earliest_deadline, latest_deadline)) {
+      continue;
+    }
+    // The timer coalesces with an existing timer, so it cannot become an earlier head and the
+    // other cpu's platform timer, which we could not program from here, stays correct.
+    timer_queue.Insert(timer, earliest_deadline, latest_deadline);
+    DEBUG_ASSERT(timer->scheduled_time_ >= timer_queue.monotonic_timers_.front().scheduled_time_);
+    kcounter_add(timer_migrated_counter, 1);
+    return true;
+  }
+  return false;
+}
 
-      if (next.scheduled_time_ < latest_deadline) {
-        // There is slack overlap with the next timer, and also with the
-        // current timer. Which coalescing is a better match?
-        //
-        //  --------------(-e---t---n-)-----------------------> time
-        zx_duration_t delta_entry = zx_time_sub_time(timer->scheduled_time_, entry.scheduled_time_);
-        zx_duration_t delta_next = zx_time_sub_time(next.scheduled_time_, timer->scheduled_time_);
-        if (delta_next < delta_entry) {
-          // New timer is closer to the next timer, handle it in the
-          // next iteration.
-          continue;
-        }
-      }
+void TimerQueue::InsertIntoTimerTree(TimerTree& timers, Timer* timer, zx_time_t earliest_deadline,
+                                     zx_time_t latest_deadline) {
+  // For inserting the timer we coalesce with an existing timer whose deadline
+  // falls within the new timer's slack, picking whichever such timer is closest.
+  //
+  // Only two existing timers can be the closest: the last one scheduled before
+  // the new timer (|prev|) and the first one scheduled at or after it (|next|).
+  //
+  // In diagrams that follow
+  // - Let |p| be the previous timer deadline if any
+  // - Let |t| be the deadline of the timer we are inserting
+  // - Let |n| be the next timer deadline if any
+  // - Let |(| and |)| the earliest_deadline and latest_deadline.
+  const zx_time_t deadline = timer->scheduled_time_;
+
+  const Timer* prev = nullptr;
+  const Timer* next = nullptr;
+  auto iter = timers.lower_bound({deadline, 0});
+  if (iter.IsValid()) {
+    next = &*iter;
+    if (iter != timers.begin()) {
+      --iter;
+      prev = &*iter;
     }
+  } else if (!timers.is_empty()) {
+    prev = &timers.back();
+  }
 
-    // Handles the remaining cases, note that there is overlap with
-    // the current timer.
-    //
-    //  1- this is the last timer (next == NULL) or
-    //  2- there is no overlap with the next timer, or
-    //  3- there is overlap with both current and next but
-    //     current is closer.
+  // Discard the neighbors that are outside the slack.
+  //
+  //   ------p--(---t---)--n--------------------------> time
+  if (prev != nullptr && prev->scheduled_time_ < earliest_deadline) {
+    prev = nullptr;
+  }
+  if (next != nullptr && next->scheduled_time_ > latest_deadline) {
+    next = nullptr;
+  }
+
+  const Timer* target = next;
+  if (prev != nullptr) {
+    // There is slack overlap with the previous timer. Only prefer the next
+    // timer if it is strictly closer, or lands exactly on the new timer.
     //
-    //  So we coalesce by scheduling early.
-    timer->slack_ = zx_time_sub_time(entry.scheduled_time_, timer->scheduled_time_);
-    timer->scheduled_time_ = entry.scheduled_time_;
-    kcounter_add(timer_coalesced_counter, 1);
-    timer_list.insert_after(timer_list.make_iterator(entry), timer);
-    return;
+    //  --------------(-p---t---n-)-----------------------> time
+    const bool prefer_next =
+        next != nullptr &&
+        (next->scheduled_time_ == deadline ||
+         (next->scheduled_time_ < latest_deadline &&
+          zx_time_sub_time(next->scheduled_time_, deadline) <
+              zx_time_sub_time(deadline, prev->scheduled_time_)));
+    if (!prefer_next) {
+      target = prev;
+    }
   }
 
-  // Walked off the end of the list and there was no overlap.
-  timer->slack_ = 0;
-  timer_list.push_back(timer);
+  if (target == nullptr) {
+    // There was no overlap. Just add as is, without slack.
+    timer->slack_ = 0;
+  } else {
+    // Coalesce by scheduling early (with |prev|) or late (with |next|).
+    timer->slack_ = zx_time_sub_time(target->scheduled_time_, deadline);
+    timer->scheduled_time_ = target->scheduled_time_;
+    kcounter_add(timer_coalesced_counter, 1);
+  }
+  timers.insert(timer);
 }
 
 Timer::~Timer() {
-  // Ensure that we are not on any TimerQueue's list.
+  // Ensure that we are not on any TimerQueue.
   ZX_DEBUG_ASSERT(!InContainer());
+  ZX_DEBUG_ASSERT(queue_.load(ktl::memory_order_relaxed) == nullptr);
   // Ensure that we are not active on some cpu.
   ZX_DEBUG_ASSERT(active_cpu_.load(ktl::memory_order_relaxed) == INVALID_CPU);
 }
@@ -328,15 +381,19 @@ void Timer::Set(const Deadline& deadline, Callback callback, void* arg) {
   DEBUG_ASSERT(deadline.slack().amount() >= 0);
 
   if (InContainer()) {
-    panic("timer %p already in list\n", this);
+    panic("timer %p already in a queue\n", this);
   }
 
   const zx_time_t latest_deadline = deadline.latest();
   const zx_time_t earliest_deadline = deadline.earliest();
 
-  Guard<MonitoredSpinLock, IrqSave> guard{TimerLock::Get(), SOURCE_TAG};
-
+  // Timers are always set on the current cpu's queue, so interrupts must stay disabled from
+  // choosing the queue until it is locked.
+  InterruptDisableGuard irqd;
   cpu_num_t cpu = arch_curr_cpu_num();
+  TimerQueue& timer_queue = percpu::Get(cpu).timer_queue;
+  Guard<MonitoredSpinLock, NoIrqSave> guard{&timer_queue.lock_, SOURCE_TAG};
+
   cpu_num_t active_cpu = active_cpu_.load(ktl::memory_order_relaxed);
 
   bool currently_active = (active_cpu == cpu);
@@ -358,19 +415,34 @@ void Timer::Set(const Deadline& deadline, Callback callback, void* arg) {
 
   LTRACEF("scheduled time %" PRIi64 "\n", scheduled_time_);
 
-  TimerQueue& timer_queue = percpu::Get(cpu).timer_queue;
+  // A timer that cannot coalesce with anything on this cpu would need a wakeup of its own. If
+  // another cpu is already going to wake up within its slack, put it on that cpu's queue instead.
+  // Timers re-armed from their own callback stay put, as they are still active on this cpu.
+  if (clock_id_ == ZX_CLOCK_MONOTONIC && earliest_deadline != latest_deadline &&
+      !currently_active &&
+      !TimerQueue::HasTimerInWindow(timer_queue.monotonic_timers_, earliest_deadline,
+                                    latest_deadline)) {
+    bool migrated = false;
+    guard.CallUnlocked([&]() {
+      migrated = TimerQueue::InsertOnRemoteQueue(this, cpu, earliest_deadline, latest_deadline);
+    });
+    if (migrated) {
+      kcounter_add(timer_created_counter, 1);
+      return;
+    }
+  }
+
   timer_queue.Insert(this, earliest_deadline, latest_deadline);
 
   switch (clock_id_) {
     case ZX_CLOCK_MONOTONIC:
-      if (!timer_queue.monotonic_timer_list_.is_empty() &&
-          &timer_queue.monotonic_timer_list_.front() == this) {
+      if (!timer_queue.monotonic_timers_.is_empty() &&
+          &timer_queue.monotonic_timers_.front() == this) {
         timer_queue.UpdatePlatformTimerMono(deadline.when());
       }
       break;
     case ZX_CLOCK_BOOT:
-      if (!timer_queue.boot_timer_list_.is_empty() &&
-          &timer_queue.boot_timer_list_.front() == this) {
+      if (!timer_queue.boot_timers_.is_empty() && &timer_queue.boot_timers_.front() == this) {
         timer_queue.UpdatePlatformTimerBoot(deadline.when());
       }
       break;
@@ -388,74 +460,39 @@ void TimerQueue::PreemptReset(zx_instant_mono_t deadline) {
 bool Timer::Cancel() {
   DEBUG_ASSERT(magic_ == kMagic);
 
-  Guard<MonitoredSpinLock, IrqSave> guard{TimerLock::Get(), SOURCE_TAG};
-
-  cpu_num_t cpu = arch_curr_cpu_num();
-
   // mark the timer as canceled
   cancel_.store(true, ktl::memory_order_relaxed);
   // TODO(https://fxbug.dev/42142666): Consider whether this DeviceMemoryBarrier is required
   arch::DeviceMemoryBarrier();
 
   // see if we're trying to cancel the timer we're currently in the middle of handling
-  if (unlikely(active_cpu_.load(ktl::memory_order_relaxed) == cpu)) {
-    // zero it out
-    callback_ = nullptr;
-    arg_ = nullptr;
-
-    // we're done, so return back to the callback
-    return false;
-  }
-
-  bool callback_not_running;
-
-  // If this Timer is in a queue, remove it and adjust hardware timers if needed.
-  if (InContainer()) {
-    callback_not_running = true;
-
-    TimerQueue& timer_queue = percpu::Get(cpu).timer_queue;
-
-    // Save a copy of the old head of the queue so later we can see if we modified the head.
-    const Timer* oldhead = nullptr;
-    fbl::DoublyLinkedList<Timer*>& timer_list = clock_id_ == ZX_CLOCK_MONOTONIC
-                                                    ? timer_queue.monotonic_timer_list_
-                                                    : timer_queue.boot_timer_list_;
-    if (!timer_list.is_empty()) {
-      oldhead = &timer_list.front();
-    }
-
-    // Remove this Timer from this whatever TimerQueue it's on.
-    RemoveFromContainer();
-    kcounter_add(timer_canceled_counter, 1);
-
-    // TODO(cpu): If, after removing |timer| there is one other single Timer with
-    // the same scheduled_time_ and slack_ non-zero, then it is possible to return
-    // that timer to the ideal scheduled_time_.
-
-    // See if we've just modified the head of this TimerQueue.
-    //
-    // If Timer was on another cpu's queue, we'll just let it fire and sort itself out.
-    if (unlikely(oldhead == this)) {
-      // The Timer we're canceling was at head of this queue, so see if we should update platform
-      // timer.
-      if (!timer_list.is_empty()) {
-        timer_queue.UpdatePlatformTimerLocked();
-      } else if (timer_queue.next_timer_deadline_ == ZX_TIME_INFINITE) {
-        LTRACEF("clearing old hw timer, preempt timer not set, nothing in the queue\n");
-        platform_stop_timer();
-      }
+  {
+    InterruptDisableGuard irqd;
+    if (unlikely(active_cpu_.load(ktl::memory_order_relaxed) == arch_curr_cpu_num())) {
+      // zero it out
+      callback_ = nullptr;
+      arg_ = nullptr;
+
+      // we're done, so return back to the callback
+      return false;
     }
-  } else {
-    callback_not_running = false;
   }
 
-  guard.Release();
+  // If this Timer is in a queue, remove it and adjust hardware timers if needed.
+  const bool callback_not_running = RemoveFromTimerQueue();
 
   // wait for the timer to become un-busy in case a callback is currently active on another cpu
-  while (active_cpu_.load(ktl::memory_order_relaxed) != INVALID_CPU) {
+  while (active_cpu_.load(ktl::memory_order_acquire) != INVALID_CPU) {
     arch::Yield();
   }
 
+  // |cancel_| is not set under the lock of the queue the callback ran on, so the callback may
+  // have re-armed the timer before observing it. The callback has finished, so take the timer
+  // back off the queue if it did.
+  if (!callback_not_running) {
+    RemoveFromTimerQueue();
+  }
+
   // zero it out
   callback_ = nullptr;
   arg_ = nullptr;
@@ -463,6 +500,24 @@ bool Timer::Cancel() {
   return callback_not_running;
 }
 
+bool Timer::RemoveFromTimerQueue() {
+  for (;;) {
+    TimerQueue* timer_queue = queue_.load(ktl::memory_order_acquire);
+    if (timer_queue == nullptr) {
+      return false;
+    }
+
+    Guard<MonitoredSpinLock, IrqSave> guard{&timer_queue->lock_, SOURCE_TAG};
+    // The timer may have started firing, or been moved by TransitionOffCpu, before we got the
+    // lock. Either way |queue_| no longer names this queue, so try again.
+    if (queue_.load(ktl::memory_order_relaxed) != timer_queue) {
+      continue;
+    }
+    timer_queue->RemoveLocked(this);
+    return true;
+  }
+}
+
 // called at interrupt time to process any pending timers
 void timer_tick() {
   DEBUG_ASSERT(arch_ints_disabled());
@@ -486,27 +541,27 @@ void TimerQueue::Tick(cpu_num_t cpu) {
     preempt_timer_deadline_ = ZX_TIME_INFINITE;
     Scheduler::TimerTick(SchedTime{now});
   }
+  Scheduler::SampleLoad(SchedTime{now});
 
-  // Tick both of the timer lists.
-  TickInternal(now, cpu, &monotonic_timer_list_);
-  TickInternal(boot_now, cpu, &boot_timer_list_);
+  // Tick both of the timer trees.
+  TickInternal(now, cpu, &monotonic_timers_);
+  TickInternal(boot_now, cpu, &boot_timers_);
 
   // Update the platform timer.
   UpdatePlatformTimer();
 }
 
 template <typename TimestampType>
-void TimerQueue::TickInternal(TimestampType now, cpu_num_t cpu,
-                              fbl::DoublyLinkedList<Timer*>* timer_list) {
-  Guard<MonitoredSpinLock, NoIrqSave> guard{Timer::TimerLock::Get(), SOURCE_TAG};
+void TimerQueue::TickInternal(TimestampType now, cpu_num_t cpu, TimerTree* timers) {
+  Guard<MonitoredSpinLock, NoIrqSave> guard{&lock_, SOURCE_TAG};
 
   for (;;) {
     // See if there's an event to process.
-    if (timer_list->is_empty()) {
+    if (timers->is_empty()) {
       break;
     }
 
-    Timer& timer = timer_list->front();
+    Timer& timer = timers->front();
 
     LTRACEF("next item on timer queue %p at %" PRIi64 " now %" PRIi64 " (%p, arg %p)\n", &timer,
             timer.scheduled_time_, now, timer.callback_, timer.arg_);
@@ -519,13 +574,15 @@ void TimerQueue::TickInternal(TimestampType now, cpu_num_t cpu,
     DEBUG_ASSERT_MSG(timer.magic_ == Timer::kMagic,
                      "ASSERT: timer failed magic check: timer %p, magic 0x%x\n", &timer,
                      (uint)timer.magic_);
-    timer_list->erase(timer);
+    timers->erase(timer);
 
-    // Mark the timer busy.
+    // Mark the timer busy before clearing its queue, so that a Cancel on another cpu that sees
+    // no queue also sees the callback running and waits for it.
     timer.active_cpu_.store(cpu, ktl::memory_order_relaxed);
+    timer.queue_.store(nullptr, ktl::memory_order_release);
     // Unlocking the spinlock in CallUnlocked acts as a release fence.
 
-    // Now that the timer is off of the list, release the spinlock to handle
+    // Now that the timer is off of the queue, release the spinlock to handle
     // the callback, then re-acquire in case it is requeued.
     guard.CallUnlocked([&timer, now]() {
       LTRACEF("dequeued timer %p, scheduled %" PRIi64 "\n", &timer, timer.scheduled_time_);
@@ -539,16 +596,17 @@ void TimerQueue::TickInternal(TimestampType now, cpu_num_t cpu,
       DEBUG_ASSERT(arch_ints_disabled());
     });
 
-    // Mark it not busy.
-    timer.active_cpu_.store(INVALID_CPU, ktl::memory_order_relaxed);
+    // Mark it not busy. This publishes any re-arm done by the callback to a waiting Cancel.
+    timer.active_cpu_.store(INVALID_CPU, ktl::memory_order_release);
     // TODO(https://fxbug.dev/42142666): Consider whether this DeviceMemoryBarrier is required
     arch::DeviceMemoryBarrier();
   }
 
   // Verify that the head of the timer queue has a scheduled time after now.
-  if (!timer_list->is_empty()) {
-    DEBUG_ASSERT(timer_list->front().scheduled_time_ > now);
+  if (!timers->is_empty()) {
+    DEBUG_ASSERT(timers->front().scheduled_time_ > now);
   }
+  PublishHeadHintLocked();
 }
 
 zx_status_t Timer::TrylockOrCancel(MonitoredSpinLock* lock) {
@@ -583,31 +641,32 @@ zx_status_t Timer::TrylockOrCancel(ChainLock& lock) {
   return ZX_OK;
 }
 
-ktl::optional<Timer*> TimerQueue::TransitionTimerList(fbl::DoublyLinkedList<Timer*>& src_list,
-                                                      fbl::DoublyLinkedList<Timer*>& dst_list) {
-  // Keep track of what the first timer in the dst_list was.
+ktl::optional<Timer*> TimerQueue::TransitionTimerTree(TimerTree& src_timers,
+                                                      TimerTree& dst_timers) {
+  // Keep track of what the first timer in dst_timers was.
   Timer* old_head = nullptr;
-  if (!dst_list.is_empty()) {
-    old_head = &dst_list.front();
+  if (!dst_timers.is_empty()) {
+    old_head = &dst_timers.front();
   }
 
-  // Move all the timers from the src_list to the dst_list.
+  // Move all the timers from src_timers to dst_timers.
   Timer* timer;
-  while ((timer = src_list.pop_front()) != nullptr) {
+  while ((timer = src_timers.pop_front()) != nullptr) {
     // We lost the original asymmetric slack information so when we combine them
     // with the other timer queue they are not coalesced again.
     // TODO(cpu): figure how important this case is.
-    InsertIntoTimerList(dst_list, timer, timer->scheduled_time_, timer->scheduled_time_);
+    InsertIntoTimerTree(dst_timers, timer, timer->scheduled_time_, timer->scheduled_time_);
+    timer->queue_.store(this, ktl::memory_order_relaxed);
     // Note, we do not increment the "created" counter here because we are simply moving these
     // timers from one queue to another and we already counted them when they were first
     // created.
   }
   Timer* new_head = nullptr;
-  if (!dst_list.is_empty()) {
-    new_head = &dst_list.front();
+  if (!dst_timers.is_empty()) {
+    new_head = &dst_timers.front();
   }
 
-  // If the head of the timer list changed, then we need to return the new head.
+  // If the head of the timer tree changed, then we need to return the new head.
   if (new_head != nullptr && new_head != old_head) {
     return ktl::optional<Timer*>(new_head);
   }
@@ -615,19 +674,34 @@ ktl::optional<Timer*> TimerQueue::TransitionTimerList(fbl::DoublyLinkedList<Time
 }
 
 void TimerQueue::TransitionOffCpu(TimerQueue& source) {
-  Guard<MonitoredSpinLock, IrqSave> guard{Timer::TimerLock::Get(), SOURCE_TAG};
-
-  // Transition both timer lists. This may update the platform timer.
+  DEBUG_ASSERT(this != &source);
+
+  // Hold both queues' locks, always taken in address order, so that a concurrent Timer::Cancel
+  // finds each timer either still on |source| or already on this queue.
+  InterruptDisableGuard irqd;
+  const bool source_first =
+      reinterpret_cast<uintptr_t>(&source) < reinterpret_cast<uintptr_t>(this);
+  TimerQueue& first = source_first ? source : *this;
+  TimerQueue& second = source_first ? *this : source;
+  Guard<MonitoredSpinLock, NoIrqSave> first_guard{AssertOrderedLock, &first.lock_, 0, SOURCE_TAG};
+  Guard<MonitoredSpinLock, NoIrqSave> second_guard{AssertOrderedLock, &second.lock_, 1,
+                                                   SOURCE_TAG};
+  AssertHeld(lock_);
+  AssertHeld(source.lock_);
+
+  // Transition both timer trees. This may update the platform timer.
   const ktl::optional<Timer*> new_mono_head =
-      TransitionTimerList(source.monotonic_timer_list_, monotonic_timer_list_);
+      TransitionTimerTree(source.monotonic_timers_, monotonic_timers_);
   if (new_mono_head) {
     UpdatePlatformTimerMono(new_mono_head.value()->scheduled_time_);
   }
   const ktl::optional<Timer*> new_boot_head =
-      TransitionTimerList(source.boot_timer_list_, boot_timer_list_);
+      TransitionTimerTree(source.boot_timers_, boot_timers_);
   if (new_boot_head) {
     UpdatePlatformTimerBoot(new_boot_head.value()->scheduled_time_);
   }
+  PublishHeadHintLocked();
+  source.PublishHeadHintLocked();
 
   // The old TimerQueue has no tasks left, so reset the deadlines.
   source.preempt_timer_deadline_ = ZX_TIME_INFINITE;
@@ -635,10 +709,9 @@ void TimerQueue::TransitionOffCpu(TimerQueue& source) {
 }
 
 template <typename TimestampType>
-void TimerQueue::PrintTimerList(TimestampType now, fbl::DoublyLinkedList<Timer*>& timer_list,
-                                StringFile& buffer) {
+void TimerQueue::PrintTimerTree(TimestampType now, TimerTree& timers, StringFile& buffer) {
   TimestampType last = now;
-  for (Timer& t : timer_list) {
+  for (Timer& t : timers) {
     zx_duration_t delta_now = zx_time_sub_time(t.scheduled_time_, now);
     zx_duration_t delta_last = zx_time_sub_time(t.scheduled_time_, last);
     fprintf(&buffer,
@@ -650,13 +723,14 @@ void TimerQueue::PrintTimerList(TimestampType now, fbl::DoublyLinkedList<Timer*>
 
 void TimerQueue::PrintTimerQueues(char* buf, size_t len) {
   StringFile buffer{ktl::span(buf, len)};
-  Guard<MonitoredSpinLock, IrqSave> guard{Timer::TimerLock::Get(), SOURCE_TAG};
   for (cpu_num_t i = 0; i < percpu::processor_count(); i++) {
     if (mp_is_cpu_online(i)) {
+      TimerQueue& timer_queue = percpu::Get(i).timer_queue;
+      Guard<MonitoredSpinLock, IrqSave> guard{&timer_queue.lock_, SOURCE_TAG};
       fprintf(&buffer, "cpu %u:\n", i);
-      PrintTimerList(current_mono_time(), percpu::Get(i).timer_queue.monotonic_timer_list_, buffer);
+      PrintTimerTree(current_mono_time(), timer_queue.monotonic_timers_, buffer);
       fprintf(&buffer, "boot timers:\n");
-      PrintTimerList(current_boot_time(), percpu::Get(i).timer_queue.boot_timer_list_, buffer);
+      PrintTimerTree(current_boot_time(), timer_queue.boot_timers_, buffer);
     }
   }
   // Null terminate the buffer.
@@ -405,7 +405,9 @@ zx_status_t WaitQueue::BlockEtc(Thread* const current_thread, const Deadline& de
     return res;
   }
 
-  return BlockEtcPostamble(current_thread, deadline);
+  return BlockEtcPostamble(current_thread, deadline,
+                           reinterpret_cast<uintptr_t>(__builtin_return_address(0)),
+                           ZX_KOID_INVALID);
 }
 
 /**
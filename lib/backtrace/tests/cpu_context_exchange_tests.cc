@@ -93,7 +93,7 @@ bool OneToManyTest() {
 
   cpu_mask_t mask = Scheduler::PeekActiveMask();
   const cpu_num_t requester = remove_cpu_from_mask(mask);
-  if (requester == INVALID_CPU || mask == 0) {
+  if (requester == INVALID_CPU || mask.none()) {
     printf("not enough active cpus; skipping test\n");
     END_TEST;
   }
@@ -91,7 +91,8 @@ template <>
 inline constexpr auto Enum<CompressionStrategy> = [](auto&& Switch) {
   return Switch  //
       .Case("none", CompressionStrategy::kNone)
-      .Case("lz4", CompressionStrategy::kLz4);
+      .Case("lz4", CompressionStrategy::kLz4)
+      .Case("lz4hc", CompressionStrategy::kLz4Hc);
 };
 
 template <>
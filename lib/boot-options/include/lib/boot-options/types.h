@@ -103,6 +103,7 @@ enum class ScannerLruAction {
 enum class CompressionStrategy {
   kNone,
   kLz4,
+  kLz4Hc,
 };
 
 enum class CompressionStorageStrategy {
@@ -12,7 +12,9 @@
 #include <arch/ops.h>
 #include <kernel/percpu.h>
 #include <ktl/algorithm.h>
+#include <ktl/array.h>
 #include <ktl/atomic.h>
+#include <ktl/bit.h>
 #include <ktl/limits.h>
 
 #include "counter-vmo-abi.h"
@@ -51,6 +53,17 @@
 // KCOUNTER_DECLARE and will present with a min() or max() across cores,
 // respectively.
 //
+// 3- A distribution can be tracked with a histogram of log2 buckets:
+//
+//      KCOUNTER_HISTOGRAM(histogram_name, "<counter name>", shift);
+//      histogram_name.Add(value);
+//
+// This defines kCounterHistogramBuckets Sum counters named "<counter name>.00"
+// through "<counter name>.15". Bucket 0 counts values below 2^shift, bucket N
+// counts values in [2^(N-1+shift), 2^(N+shift)), and the last bucket also
+// counts every larger value. Like any other Sum counter, each bucket is per-CPU
+// and merged on read, so nothing new is needed in the counters VMO ABI.
+//
 // Naming the counters
 // The naming convention is "subsystem.thing_or_action"
 // for example "dispatcher.destroy"
@@ -231,6 +244,59 @@ class Counter {
 
 #define KCOUNTER(var, name) KCOUNTER_DECLARE(var, name, Sum)
 
+inline constexpr size_t kCounterHistogramBuckets = 16;
+
+class CounterHistogram {
+ public:
+  constexpr CounterHistogram(int shift, ktl::array<Counter, kCounterHistogramBuckets> buckets)
+      : shift_(shift), buckets_(buckets) {}
+
+  // Returns the bucket that counts |value| in a histogram with the given |shift|.
+  static constexpr size_t Bucket(uint64_t value, int shift) {
+    return ktl::min(static_cast<size_t>(ktl::bit_width(value >> shift)),
+                    kCounterHistogramBuckets - 1);
+  }
+
+  void Add(uint64_t value) const { buckets_[Bucket(value, shift_)].Add(1); }
+
+ private:
+  const int shift_;
+  const ktl::array<Counter, kCounterHistogramBuckets> buckets_;
+};
+
+static_assert(CounterHistogram::Bucket(0, 10) == 0);
+static_assert(CounterHistogram::Bucket(1023, 10) == 0);
+static_assert(CounterHistogram::Bucket(1024, 10) == 1);
+static_assert(CounterHistogram::Bucket(2047, 10) == 1);
+static_assert(CounterHistogram::Bucket(2048, 10) == 2);
+static_assert(CounterHistogram::Bucket(ktl::numeric_limits<uint64_t>::max(), 0) ==
+              kCounterHistogramBuckets - 1);
+
+// The bucket names are zero padded so that the buckets sort in order.
+#define KCOUNTER_HISTOGRAM(var, name, shift)                                                   \
+  KCOUNTER(var##_00, name ".00")                                                               \
+  KCOUNTER(var##_01, name ".01")                                                               \
+  KCOUNTER(var##_02, name ".02")                                                               \
+  KCOUNTER(var##_03, name ".03")                                                               \
+  KCOUNTER(var##_04, name ".04")                                                               \
+  KCOUNTER(var##_05, name ".05")                                                               \
+  KCOUNTER(var##_06, name ".06")                                                               \
+  KCOUNTER(var##_07, name ".07")                                                               \
+  KCOUNTER(var##_08, name ".08")                                                               \
+  KCOUNTER(var##_09, name ".09")                                                               \
+  KCOUNTER(var##_10, name ".10")                                                               \
+  KCOUNTER(var##_11, name ".11")                                                               \
+  KCOUNTER(var##_12, name ".12")                                                               \
+  KCOUNTER(var##_13, name ".13")                                                               \
+  KCOUNTER(var##_14, name ".14")                                                               \
+  KCOUNTER(var##_15, name ".15")                                                               \
+  namespace {                                                                                  \
+  constexpr CounterHistogram var(shift, {var##_00, var##_01, var##_02, var##_03, var##_04,     \
+                                         var##_05, var##_06, var##_07, var##_08, var##_09,     \
+                                         var##_10, var##_11, var##_12, var##_13, var##_14,     \
+                                         var##_15});                                           \
+  }  // anonymous namespace
+
 inline void kcounter_add(const Counter& counter, int64_t delta) { counter.Add(delta); }
 inline void kcounter_min(const Counter& counter, int64_t value) { counter.Min(value); }
 inline void kcounter_max(const Counter& counter, int64_t value) { counter.Max(value); }
@@ -5,9 +5,15 @@
 // https://opensource.org/licenses/MIT
 
 #include <lib/crypto/entropy/hw_rng_collector.h>
+#include <string.h>
 #include <zircon/errors.h>
 
 #include <dev/hw_rng.h>
+#include <explicit-memory/bytes.h>
+#include <kernel/thread.h>
+#include <ktl/algorithm.h>
+
+#include <ktl/enforce.h>
 
 namespace crypto {
 
@@ -30,14 +36,80 @@ zx_status_t HwRngCollector::GetInstance(Collector** ptr) {
 
 HwRngCollector::HwRngCollector() : Collector("hw_rng", /* entropy_per_1000_bytes */ 8000) {}
 
+void HwRngCollector::StartBuffering() {
+  if (!hw_rng_is_registered()) {
+    return;
+  }
+  {
+    Guard<Mutex> guard(&instance.buffer_lock_);
+    if (instance.buffering_) {
+      return;
+    }
+    instance.buffering_ = true;
+  }
+  instance.refill_event_.Signal();
+  Thread* t = Thread::Create("hw-rng-fill", FillLoop, &instance, LOW_PRIORITY);
+  t->DetachAndResume();
+}
+
+int HwRngCollector::FillLoop(void* arg) {
+  HwRngCollector* self = static_cast<HwRngCollector*>(arg);
+  uint8_t chunk[kBufferSize];
+  for (;;) {
+    self->refill_event_.Wait();
+
+    size_t needed;
+    {
+      Guard<Mutex> guard(&self->buffer_lock_);
+      needed = kBufferSize - self->buffered_;
+    }
+    size_t drawn;
+    {
+      Guard<Mutex> guard(&self->lock_);
+      drawn = hw_rng_get_entropy(chunk, needed);
+    }
+    {
+      Guard<Mutex> guard(&self->buffer_lock_);
+      // Draws may have consumed more of the buffer meanwhile, but never added to it.
+      memcpy(self->buffer_.data() + self->buffered_, chunk, drawn);
+      self->buffered_ += drawn;
+    }
+    mandatory_memset(chunk, 0, sizeof(chunk));
+
+    if (drawn < needed) {
+      // Leave a failing or exhausted hardware RNG alone for a while rather than spin on it.
+      Thread::Current::SleepRelative(ZX_SEC(1));
+      self->refill_event_.Signal();
+    }
+  }
+  return 0;
+}
+
 size_t HwRngCollector::DrawEntropy(uint8_t* buf, size_t len) {
+  size_t drawn;
+  {
+    Guard<Mutex> guard(&buffer_lock_);
+    drawn = ktl::min(len, buffered_);
+    // Take from the end, wiping what was taken, so that the rest stays in place.
+    uint8_t* const taken = buffer_.data() + buffered_ - drawn;
+    memcpy(buf, taken, drawn);
+    mandatory_memset(taken, 0, drawn);
+    buffered_ -= drawn;
+    if (buffering_ && buffered_ < kBufferSize / 2) {
+      refill_event_.Signal();
+    }
+  }
+  if (drawn == len) {
+    return len;
+  }
+
   // Especially on systems that have RdRand but not RdSeed, avoid parallel
   // accesses. Per the Intel documentation, properly using RdRand to seed a
   // CPRNG requires careful access patterns, to avoid multiple RNG draws from
   // the same physical seed (see https://fxbug.dev/42105846).
   Guard<Mutex> guard(&lock_);
 
-  return hw_rng_get_entropy(buf, len);
+  return drawn + hw_rng_get_entropy(buf + drawn, len - drawn);
 }
 
 }  // namespace entropy
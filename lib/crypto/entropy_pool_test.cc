@@ -147,5 +147,6 @@ UNITTEST("AddEntropyFromDifferentDigests generates different contents.",
          AddEntropyFromDifferentDigests)
 UNITTEST("Move shreds contents.", DestructorCleansUpContents)
 UNITTEST("Destructor shreds contents.", MoveCleansUpContents)
-UNITTEST_END_TESTCASE(crypto_entropy_pool_tests, "crypto_entropy_pool",
-                      "Validate security properties of entropy pool.")
+UNITTEST_END_TESTCASE_WITH_FLAGS(crypto_entropy_pool_tests, "crypto_entropy_pool",
+                                 "Validate security properties of entropy pool.",
+                                 UNITTEST_TESTCASE_FLAG_ISOLATED)
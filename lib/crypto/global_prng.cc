@@ -41,6 +41,8 @@ namespace {
 
 Prng* g_prng_instance = nullptr;
 
+Prng::PerCpuKey g_per_cpu_keys[SMP_MAX_CPUS];
+
 // Returns true on success, false on failure.
 bool SeedFrom(entropy::Collector* collector) {
   uint8_t buf[Prng::kMinEntropy] = {0};
@@ -133,8 +135,12 @@ void EarlyBootSeed(uint level) {
   }
 }
 
-// Migrate the global PRNG to enter thread-safe mode.
-void BecomeThreadSafe(uint level) { GetInstance()->BecomeThreadSafe(); }
+// Migrate the global PRNG to enter thread-safe mode, with per-CPU keys so
+// that concurrent draws don't all serialize on its lock.
+void BecomeThreadSafe(uint level) {
+  GetInstance()->BecomeThreadSafe();
+  GetInstance()->EnablePerCpuKeys(g_per_cpu_keys);
+}
 
 // Collect entropy and add it to the cprng.
 void ReseedPRNG() {
@@ -177,6 +183,11 @@ void StartReseedThread(uint level) {
   // TODO(https://fxbug.dev/42163418): Make this synchronous reseed faster by removing
   // JitterEntropy reseed, as we already seeded from it in EarlyBoot.
   ReseedPRNG();
+  // From here on, reseeds draw hardware randomness collected ahead of time in bulk, rather than
+  // waiting on the hardware at the reseed thread's priority.
+  if (!gBootOptions->cprng_disable_hw_rng) {
+    entropy::HwRngCollector::StartBuffering();
+  }
   Thread* t = Thread::Create("prng-reseed", ReseedLoop, nullptr, HIGHEST_PRIORITY);
   t->DetachAndResume();
 }
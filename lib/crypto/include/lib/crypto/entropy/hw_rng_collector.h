@@ -10,7 +10,9 @@
 #include <lib/crypto/entropy/collector.h>
 #include <zircon/types.h>
 
+#include <kernel/event.h>
 #include <kernel/mutex.h>
+#include <ktl/array.h>
 
 namespace crypto {
 
@@ -27,8 +29,16 @@ class HwRngCollector : public Collector {
   // HwRngCollector instance is also thread-safe.
   static zx_status_t GetInstance(Collector** ptr);
 
+  // Starts a low priority thread that keeps a buffer of hardware randomness
+  // filled, drawing from the hardware RNG in bulk. Does nothing if there is no
+  // hardware RNG or the thread has already been started.
+  static void StartBuffering();
+
   // Inherited from crypto::entropy::Collector; see comments there.
   //
+  // Draws are served from the buffer filled by StartBuffering() where
+  // possible, and otherwise directly from the hardware RNG.
+  //
   // Note that this method internally uses a mutex to prevent multiple
   // accesses. It is safe to call this method from multiple threads, but it
   // may block.
@@ -43,7 +53,21 @@ class HwRngCollector : public Collector {
  private:
   DISALLOW_COPY_ASSIGN_AND_MOVE(HwRngCollector);
 
+  // Enough for several reseeds, so that a reseed never waits on the hardware.
+  static constexpr size_t kBufferSize = 512;
+
+  static int FillLoop(void* arg);
+
+  // Serializes accesses to the hardware RNG.
   DECLARE_MUTEX(HwRngCollector) lock_;
+
+  DECLARE_MUTEX(HwRngCollector) buffer_lock_;
+  ktl::array<uint8_t, kBufferSize> buffer_ TA_GUARDED(buffer_lock_) = {};
+  size_t buffered_ TA_GUARDED(buffer_lock_) = 0;
+  bool buffering_ TA_GUARDED(buffer_lock_) = false;
+
+  // Signaled when the buffer has drained below half full.
+  AutounsignalEvent refill_event_;
 };
 
 }  // namespace entropy
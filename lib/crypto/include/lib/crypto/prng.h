@@ -13,10 +13,12 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <arch/defines.h>
 #include <kernel/event.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <ktl/atomic.h>
+#include <ktl/span.h>
 
 namespace crypto {
 
@@ -72,6 +74,24 @@ class Prng {
   // instance is not yet thread-safe.
   void BecomeThreadSafe();
 
+  // The key a CPU draws with when per-CPU keys are enabled, see
+  // EnablePerCpuKeys().
+  struct alignas(MAX_CACHE_LINE) PerCpuKey {
+    uint8_t key[kMinEntropy];
+    // The value of |generation_| when |key| was drawn.
+    uint64_t generation;
+    // The number of draws made with |key|, which doubles as their nonce.
+    uint64_t draws;
+  };
+
+  // After this, Draw() does not touch the shared state, except to draw a new
+  // key for the current CPU from it.  That happens when the CPU has not drawn
+  // before, when entropy has been added since its key was drawn, or when its
+  // key has been used kPerCpuKeyMaxDraws times.  |keys| must have an entry
+  // per possible CPU and must outlive this instance.  This asserts that the
+  // instance is thread-safe and does not already have per-CPU keys.
+  void EnablePerCpuKeys(ktl::span<PerCpuKey> keys);
+
   // Inspect if this PRNG is thread-safe.
   bool is_thread_safe() const;
 
@@ -89,10 +109,17 @@ class Prng {
   // uses a different key/nonce pair.  Anything above this will panic.
   static constexpr uint64_t kMaxDrawLen = 1ULL << 38;
 
+  // The number of draws after which a per-CPU key is replaced, bounding how
+  // much output depends on a key that lingers in memory.
+  static constexpr uint64_t kPerCpuKeyMaxDraws = 1ULL << 16;
+
  private:
   Prng(const Prng&) = delete;
   Prng& operator=(const Prng&) = delete;
 
+  // Draws from the shared key and nonce.
+  void DrawShared(void* out, size_t size) TA_EXCL(pool_lock_);
+
   // Synchronizes calls to |AddEntropy|.
   DECLARE_MUTEX(Prng) add_entropy_lock_;
 
@@ -111,6 +138,13 @@ class Prng {
 
   // Number of bytes of entropy added so far.
   ktl::atomic<size_t> accumulated_;
+
+  // Bumped each time |pool_| changes, so that per-CPU keys drawn from an
+  // older pool are replaced.
+  ktl::atomic<uint64_t> generation_{1};
+
+  // Empty unless EnablePerCpuKeys() was called.
+  ktl::span<PerCpuKey> per_cpu_keys_;
 };
 
 }  // namespace crypto
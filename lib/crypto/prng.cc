@@ -14,6 +14,8 @@
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
+#include <arch/interrupt.h>
+#include <arch/ops.h>
 #include <explicit-memory/bytes.h>
 #include <kernel/mutex.h>
 #include <ktl/atomic.h>
@@ -63,6 +65,7 @@ void Prng::AddEntropy(const void* data, size_t size) {
     Guard<SpinLock, IrqSave> pool_guard(&pool_lock_);
     pool_ = ktl::move(pool);
   }
+  generation_.fetch_add(1, ktl::memory_order_release);
 
   // Increment how much entropy has been added, and signal if we have enough.
   size_t total_entropy = accumulated_.fetch_add(size) + size;
@@ -81,6 +84,38 @@ void Prng::Draw(void* out, size_t size) {
   if (is_thread_safe() && accumulated_.load() < kMinEntropy) {
     ready_->Wait();
   }
+
+  if (per_cpu_keys_.empty()) {
+    DrawShared(out, size);
+    return;
+  }
+
+  // Copy out the current CPU's key, drawing a new one first if it is stale.
+  // Interrupts stay disabled so that nothing else on this CPU can use the key
+  // in between, which keeps each nonce unique.
+  uint8_t key[kMinEntropy];
+  uint128_t nonce;
+  auto cleanup = fit::defer([&] {
+    mandatory_memset(key, 0, sizeof(key));
+    mandatory_memset(&nonce, 0, sizeof(nonce));
+  });
+  {
+    InterruptDisableGuard irqd;
+    PerCpuKey& cpu_key = per_cpu_keys_[arch_curr_cpu_num()];
+    const uint64_t generation = generation_.load(ktl::memory_order_acquire);
+    if (cpu_key.generation != generation || cpu_key.draws == kPerCpuKeyMaxDraws) {
+      DrawShared(cpu_key.key, sizeof(cpu_key.key));
+      cpu_key.generation = generation;
+      cpu_key.draws = 0;
+    }
+    nonce = ++cpu_key.draws;
+    memcpy(key, cpu_key.key, sizeof(key));
+  }
+  CRYPTO_chacha_20(static_cast<uint8_t*>(out), static_cast<uint8_t*>(out), size, key,
+                   reinterpret_cast<uint8_t*>(&nonce), 0);
+}
+
+void Prng::DrawShared(void* out, size_t size) {
   // Save these on the stack, but guarantee we clean them up
   EntropyPool pool;
   uint128_t nonce;
@@ -131,6 +166,18 @@ void Prng::BecomeThreadSafe() {
   is_thread_safe_ = true;
 }
 
+void Prng::EnablePerCpuKeys(ktl::span<PerCpuKey> keys) {
+  ASSERT(is_thread_safe());
+  ASSERT(per_cpu_keys_.empty());
+  ASSERT(keys.size() >= arch_max_num_cpus());
+  for (PerCpuKey& cpu_key : keys) {
+    // A generation that never matches, so that each key is drawn on first use.
+    cpu_key.generation = 0;
+    cpu_key.draws = 0;
+  }
+  per_cpu_keys_ = keys;
+}
+
 bool Prng::is_thread_safe() const {
   // Safe to read |is_thread_safe_|; it is read-only in a threaded context.
   return is_thread_safe_;
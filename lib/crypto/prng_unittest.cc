@@ -11,7 +11,11 @@
 #include <lib/zircon-internal/macros.h>
 #include <stdint.h>
 
+#include <arch/ops.h>
+#include <fbl/alloc_checker.h>
+#include <kernel/auto_preempt_disabler.h>
 #include <kernel/thread.h>
+#include <ktl/unique_ptr.h>
 
 namespace crypto {
 
@@ -263,6 +267,52 @@ bool prng_from_entropy_pool_matches_prng_from_contents() {
   END_TEST;
 }
 
+bool prng_per_cpu_keys() {
+  BEGIN_TEST;
+  constexpr int kDrawSize = 13;
+  static const char kSeed[32] = {'a', 'b', 'c'};
+
+  Prng prng(kSeed, sizeof(kSeed));
+  const size_t num_cpus = arch_max_num_cpus();
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<Prng::PerCpuKey[]> keys(new (&ac) Prng::PerCpuKey[num_cpus]);
+  ASSERT_TRUE(ac.check());
+  prng.EnablePerCpuKeys({keys.get(), num_cpus});
+
+  uint8_t out1[kDrawSize] = {0};
+  uint8_t out2[kDrawSize] = {0};
+  uint64_t generation;
+  {
+    // Stay on one CPU so that all of these draws use the same key.
+    AutoPreemptDisabler preempt_disabled;
+    const Prng::PerCpuKey& key = keys[arch_curr_cpu_num()];
+
+    prng.Draw(out1, sizeof(out1));
+    prng.Draw(out2, sizeof(out2));
+    EXPECT_NE(0, memcmp(out1, out2, sizeof(out1)), "prng output is constant");
+    EXPECT_EQ(2u, key.draws);
+    generation = key.generation;
+
+    // A key that has been used up is replaced.
+    keys[arch_curr_cpu_num()].draws = Prng::kPerCpuKeyMaxDraws;
+    prng.Draw(out1, sizeof(out1));
+    EXPECT_EQ(1u, key.draws);
+    EXPECT_EQ(generation, key.generation);
+  }
+
+  // Adding entropy replaces the key on the next draw.
+  prng.SelfReseed();
+  {
+    AutoPreemptDisabler preempt_disabled;
+    const Prng::PerCpuKey& key = keys[arch_curr_cpu_num()];
+    prng.Draw(out2, sizeof(out2));
+    EXPECT_EQ(1u, key.draws);
+    EXPECT_GT(key.generation, generation);
+  }
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(prng_tests)
@@ -274,6 +324,7 @@ UNITTEST("Test RandInt", prng_randint)
 UNITTEST("Block if not enough entropy", prng_blocks)
 UNITTEST("Dont block if entropy added in early boot", prng_doesnt_block_if_entropy_is_added_early)
 UNITTEST("Initialize through EntropyPool", prng_from_entropy_pool_matches_prng_from_contents)
+UNITTEST("Per-CPU keys", prng_per_cpu_keys)
 UNITTEST_END_TESTCASE(prng_tests, "prng", "Test pseudo-random number generator implementation.")
 
 }  // namespace crypto
@@ -166,6 +166,14 @@ zx_status_t DLog::Shutdown(zx_instant_mono_t deadline) {
 void DLog::PanicStart() {
   // Stop processing log writes they'll fail over to kernel console and serial.
   panic_ = true;
+
+  // Move any staged records into the ring buffer so that they make it into the
+  // crashlog, unless the lock is held (see RenderToCrashlog).
+  InterruptDisableGuard irqd;
+  Guard<MonitoredSpinLock, TryLockNoIrqSave> guard{&lock_, SOURCE_TAG};
+  if (static_cast<bool>(guard)) {
+    DrainStagedLocked();
+  }
 }
 
 void DLog::BluescreenInit() {
@@ -187,8 +195,6 @@ void DLog::BluescreenInit() {
 zx_status_t DLog::Write(uint32_t severity, uint32_t flags, ktl::string_view str) {
   str = str.substr(0, DLOG_MAX_DATA);
 
-  const char* ptr = str.data();
-
   const size_t len = str.size();
 
   if (panic_) {
@@ -217,73 +223,159 @@ zx_status_t DLog::Write(uint32_t severity, uint32_t flags, ktl::string_view str)
   }
 
   bool do_signal = true;
+  zx_status_t status = ZX_OK;
+  bool written = false;
   {
+    InterruptDisableGuard irqd;
+    Guard<MonitoredSpinLock, TryLockNoIrqSave> guard{&lock_, SOURCE_TAG};
+    if (static_cast<bool>(guard)) {
+      status = WriteLocked(hdr, str, do_signal);
+      written = true;
+    } else if (lifecycle_.load(ktl::memory_order_acquire) == Lifecycle::Running &&
+               ChainLockTransaction::Active() == nullptr) {
+      // Rather than spin behind the other writers, leave the record on this
+      // CPU's stage for the current holder of the lock, or the notifier thread,
+      // to pick up.  This isn't done if the signal would have to be deferred
+      // (see WriteLocked), as that needs the lock.
+      written = StageRecord(hdr, str);
+    }
+  }
+
+  if (!written) {
     Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+    status = WriteLocked(hdr, str, do_signal);
+  }
+  if (status != ZX_OK) {
+    return status;
+  }
 
-    hdr.sequence = sequence_count_;
+  if (do_signal) {
+    notifier_state_.event.Signal();
+  }
 
-    if (lifecycle_.load(ktl::memory_order_acquire) != Lifecycle::Running) {
-      return ZX_ERR_BAD_STATE;
-    }
+  return ZX_OK;
+}
 
-    // We're about to place a log record in the buffer.  Once we've done that
-    // we'll need to signal the notifier thread.  Ideally we'd just call
-    // Event::Signal after dropping our spinlock, however, Event::Signal might
-    // start a new chainlock transaction and we might have been called in a
-    // context where there's *already* an active transaction.  If there's an
-    // active transaction we must instead defer calling signal to a point at
-    // which there is no active transaction.  We use a Timer for this because
-    // Timers only fire when interrupts are enabled and it would be an error to
-    // have an active chainlock transaction with interrupts enabled.
-    if (ChainLockTransaction::Active() != nullptr) {
-      do_signal = false;
-      // As an optimization, we track whether or not there's a pending timer.
-      // This is check may race with the timer firing (and clearing the bool),
-      // but that's OK.  The worst case is that we observed false and set an
-      // "extra" timer.
-      if (!pending_deferred_signal_.load()) {
-        pending_deferred_signal_.store(true);
-        deferred_signal_timer_.Set(Deadline::no_slack(ZX_TIME_INFINITE_PAST), DLog::DeferredSignal,
-                                   this);
-      }
-    }
+zx_status_t DLog::WriteLocked(dlog_header_t& hdr, ktl::string_view str, bool& do_signal) {
+  if (lifecycle_.load(ktl::memory_order_acquire) != Lifecycle::Running) {
+    return ZX_ERR_BAD_STATE;
+  }
 
-    // Discard records at tail until there is enough
-    // space for the new record.
-    while ((head_ - tail_) > (DLOG_SIZE - wiresize)) {
-      uint32_t preamble = *reinterpret_cast<uint32_t*>(data_ + (tail_ & DLOG_MASK));
-      tail_ += DLOG_HDR_GET_FIFOLEN(preamble);
+  // We're about to place a log record in the buffer.  Once we've done that
+  // we'll need to signal the notifier thread.  Ideally we'd just call
+  // Event::Signal after dropping our spinlock, however, Event::Signal might
+  // start a new chainlock transaction and we might have been called in a
+  // context where there's *already* an active transaction.  If there's an
+  // active transaction we must instead defer calling signal to a point at
+  // which there is no active transaction.  We use a Timer for this because
+  // Timers only fire when interrupts are enabled and it would be an error to
+  // have an active chainlock transaction with interrupts enabled.
+  if (ChainLockTransaction::Active() != nullptr) {
+    do_signal = false;
+    // As an optimization, we track whether or not there's a pending timer.
+    // This is check may race with the timer firing (and clearing the bool),
+    // but that's OK.  The worst case is that we observed false and set an
+    // "extra" timer.
+    if (!pending_deferred_signal_.load()) {
+      pending_deferred_signal_.store(true);
+      deferred_signal_timer_.Set(Deadline::no_slack(ZX_TIME_INFINITE_PAST), DLog::DeferredSignal,
+                                 this);
     }
+  }
 
-    size_t offset = head_ & DLOG_MASK;
-    size_t fifospace = DLOG_SIZE - offset;
-
-    if (fifospace >= wiresize) {
-      // everything fits in one write, simple case!
-      memcpy(data_ + offset, &hdr, sizeof(hdr));
-      memcpy(data_ + offset + sizeof(hdr), ptr, len);
-    } else if (fifospace < sizeof(hdr)) {
-      // the wrap happens in the header
-      memcpy(data_ + offset, &hdr, fifospace);
-      memcpy(data_, reinterpret_cast<uint8_t*>(&hdr) + fifospace, sizeof(hdr) - fifospace);
-      memcpy(data_ + (sizeof(hdr) - fifospace), ptr, len);
-    } else {
-      // the wrap happens in the data
-      memcpy(data_ + offset, &hdr, sizeof(hdr));
-      offset += sizeof(hdr);
-      fifospace -= sizeof(hdr);
-      memcpy(data_ + offset, ptr, fifospace);
-      memcpy(data_, ptr + fifospace, len - fifospace);
-    }
-    head_ += wiresize;
-    sequence_count_++;
+  // Staged records were written before this one.
+  DrainStagedLocked();
+  InsertLocked(hdr, str);
+  return ZX_OK;
+}
+
+void DLog::InsertLocked(dlog_header_t& hdr, ktl::string_view str) {
+  const char* ptr = str.data();
+  const size_t len = str.size();
+  const size_t wiresize = DLOG_HDR_GET_FIFOLEN(hdr.preamble);
+
+  hdr.sequence = sequence_count_;
+
+  // Discard records at tail until there is enough
+  // space for the new record.
+  while ((head_ - tail_) > (DLOG_SIZE - wiresize)) {
+    uint32_t preamble = *reinterpret_cast<uint32_t*>(data_ + (tail_ & DLOG_MASK));
+    tail_ += DLOG_HDR_GET_FIFOLEN(preamble);
   }
 
-  if (do_signal) {
-    notifier_state_.event.Signal();
+  size_t offset = head_ & DLOG_MASK;
+  size_t fifospace = DLOG_SIZE - offset;
+
+  if (fifospace >= wiresize) {
+    // everything fits in one write, simple case!
+    memcpy(data_ + offset, &hdr, sizeof(hdr));
+    memcpy(data_ + offset + sizeof(hdr), ptr, len);
+  } else if (fifospace < sizeof(hdr)) {
+    // the wrap happens in the header
+    memcpy(data_ + offset, &hdr, fifospace);
+    memcpy(data_, reinterpret_cast<uint8_t*>(&hdr) + fifospace, sizeof(hdr) - fifospace);
+    memcpy(data_ + (sizeof(hdr) - fifospace), ptr, len);
+  } else {
+    // the wrap happens in the data
+    memcpy(data_ + offset, &hdr, sizeof(hdr));
+    offset += sizeof(hdr);
+    fifospace -= sizeof(hdr);
+    memcpy(data_ + offset, ptr, fifospace);
+    memcpy(data_, ptr + fifospace, len - fifospace);
   }
+  head_ += wiresize;
+  sequence_count_++;
+}
 
-  return ZX_OK;
+bool DLog::StageRecord(const dlog_header_t& hdr, ktl::string_view str) {
+  DEBUG_ASSERT(arch_ints_disabled());
+  Stage& stage = stages_[arch_curr_cpu_num()];
+  const size_t head = stage.head.load(ktl::memory_order_relaxed);
+  if (head - stage.tail.load(ktl::memory_order_acquire) == kStageRecords) {
+    return false;
+  }
+  dlog_record_t& record = stage.records[head % kStageRecords];
+  record.hdr = hdr;
+  memcpy(record.data, str.data(), str.size());
+  stage.head.store(head + 1, ktl::memory_order_release);
+  staged_count_.fetch_add(1, ktl::memory_order_release);
+  return true;
+}
+
+void DLog::DrainStagedLocked() {
+  if (staged_count_.load(ktl::memory_order_acquire) == 0) {
+    return;
+  }
+
+  const uint num_cpus = arch_max_num_cpus();
+  size_t drained = 0;
+  for (;;) {
+    // Pick the oldest record at the front of any stage.
+    Stage* oldest = nullptr;
+    for (uint i = 0; i < num_cpus; ++i) {
+      Stage& stage = stages_[i];
+      const size_t tail = stage.tail.load(ktl::memory_order_relaxed);
+      if (tail == stage.head.load(ktl::memory_order_acquire)) {
+        continue;
+      }
+      if (oldest == nullptr ||
+          stage.records[tail % kStageRecords].hdr.timestamp <
+              oldest->records[oldest->tail.load(ktl::memory_order_relaxed) % kStageRecords]
+                  .hdr.timestamp) {
+        oldest = &stage;
+      }
+    }
+    if (oldest == nullptr) {
+      break;
+    }
+
+    const size_t tail = oldest->tail.load(ktl::memory_order_relaxed);
+    dlog_record_t& record = oldest->records[tail % kStageRecords];
+    InsertLocked(record.hdr, {record.data, record.hdr.datalen});
+    oldest->tail.store(tail + 1, ktl::memory_order_release);
+    ++drained;
+  }
+  staged_count_.fetch_sub(drained, ktl::memory_order_relaxed);
 }
 
 size_t DLog::RenderToCrashlog(ktl::span<char> target_span) const {
@@ -384,6 +476,12 @@ int DLog::NotifierThread() {
     }
     notifier_state_.event.Wait();
 
+    // Move any staged records into the ring buffer for the readers.
+    {
+      Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+      DrainStagedLocked();
+    }
+
     // notify readers that new DLOG items were posted
     {
       Guard<Mutex> guard(&readers_lock_);
@@ -457,6 +555,7 @@ zx_status_t DlogReader::Read(uint32_t flags, dlog_record_t* record, size_t* actu
 
   {
     Guard<MonitoredSpinLock, IrqSave> guard{&log_->lock_, SOURCE_TAG};
+    log_->DrainStagedLocked();
 
     size_t rtail = tail_;
 
@@ -11,11 +11,13 @@
 #include <lib/zircon-internal/thread_annotations.h>
 #include <lib/zx/result.h>
 
+#include <arch/defines.h>
 #include <kernel/event.h>
 #include <kernel/mutex.h>
 #include <kernel/spinlock.h>
 #include <kernel/timer.h>
 #include <ktl/algorithm.h>
+#include <ktl/atomic.h>
 #include <ktl/limits.h>
 #include <ktl/span.h>
 #include <ktl/string_view.h>
@@ -94,6 +96,18 @@ class DLog {
     bool ends_with_newline{false};
   };
 
+  // When |lock_| is contended, Write queues the record on the current CPU's
+  // stage instead of spinning, and whoever next holds |lock_| moves all staged
+  // records into the ring buffer, assigning their sequence numbers as it does.
+  // A stage is a single-producer, single-consumer ring: it is only written by
+  // its CPU with interrupts disabled, and only drained with |lock_| held.
+  static constexpr size_t kStageRecords = 8;
+  struct alignas(MAX_CACHE_LINE) Stage {
+    ktl::atomic<size_t> head{0};
+    ktl::atomic<size_t> tail{0};
+    dlog_record_t records[kStageRecords]{};
+  };
+
   static inline constexpr char kDlogNotifierThreadName[] = "debuglog-notifier";
   static inline constexpr char kDlogDumperThreadName[] = "debuglog-dumper";
 
@@ -127,9 +141,25 @@ class DLog {
     return (target.data() == nullptr) ? ret : ktl::min(target.size(), ret);
   }
 
-  // A small helper alias for FormatHeader which helps to make it a bit more
-  // clear at the callsite what operation is being performed.
-  static size_t MeasureRenderedHeader(const dlog_header_t& hdr) { return FormatHeader({}, hdr); }
+  // Returns the length FormatHeader would render for |hdr|.  Rendering the
+  // debuglog into the crashlog measures every record in the log, in the panic
+  // path, so this counts digits rather than going through snprintf.
+  static size_t MeasureRenderedHeader(const dlog_header_t& hdr) {
+    // The width of a %05 conversion of |val|, plus one for a sign.
+    auto width = [](uint64_t val, bool negative) -> size_t {
+      size_t digits = 1;
+      for (; val >= 10; val /= 10) {
+        ++digits;
+      }
+      return ktl::max<size_t>(5, digits + (negative ? 1 : 0));
+    };
+    const int seconds = static_cast<int>(hdr.timestamp / ZX_SEC(1));
+    const uint64_t magnitude =
+        seconds < 0 ? -static_cast<int64_t>(seconds) : static_cast<uint64_t>(seconds);
+    // "[", ".", the three digits of milliseconds, "] ", ":" and "> ".
+    constexpr size_t kFixed = 10;
+    return kFixed + width(magnitude, seconds < 0) + width(hdr.pid, false) + width(hdr.tid, false);
+  }
 
   // Attempt to read |target.size()| bytes from an absolute location in the
   // debuglog buffer given by |offset|, storing the result at |target.data()|
@@ -220,6 +250,24 @@ class DLog {
 
   size_t RenderToCrashlogLocked(ktl::span<char> target) const TA_REQ(lock_);
 
+  // The part of Write done with |lock_| held.  Clears |do_signal| if the
+  // notifier thread will be signaled by |deferred_signal_timer_| instead.
+  zx_status_t WriteLocked(dlog_header_t& hdr, ktl::string_view str, bool& do_signal)
+      TA_REQ(lock_);
+
+  // Copies |hdr| (assigning its sequence number) and |data| into the ring
+  // buffer, discarding the oldest records to make room.
+  void InsertLocked(dlog_header_t& hdr, ktl::string_view data) TA_REQ(lock_);
+
+  // Queues a record on the current CPU's stage.  Must be called with
+  // interrupts disabled.  Returns false if the stage is full.
+  bool StageRecord(const dlog_header_t& hdr, ktl::string_view data);
+
+  // Moves all staged records into the ring buffer.  Records from different
+  // stages are merged by timestamp, so that the records of a thread that
+  // migrated between staging them stay in order.
+  void DrainStagedLocked() TA_REQ(lock_);
+
   int NotifierThread();
   int DumperThread();
 
@@ -270,6 +318,10 @@ class DLog {
   // A counter incremented for each log message that enters the debuglog.
   uint64_t sequence_count_ TA_GUARDED(lock_) = 0;
 
+  // The number of records across all of |stages_| that are yet to be drained.
+  ktl::atomic<size_t> staged_count_{0};
+  Stage stages_[SMP_MAX_CPUS];
+
   // Signaled when shutdown has completed.
   Event shutdown_finished_;
 
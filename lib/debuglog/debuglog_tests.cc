@@ -68,6 +68,29 @@ struct DebuglogTests {
     END_TEST;
   }
 
+  // MeasureRenderedHeader must agree with what FormatHeader actually renders.
+  static bool measure_header() {
+    BEGIN_TEST;
+
+    constexpr zx_instant_boot_t kTimestamps[] = {
+        0, ZX_MSEC(999), ZX_SEC(99999), ZX_SEC(100000) + ZX_MSEC(1), ZX_SEC(1234567), -ZX_SEC(1),
+        -ZX_SEC(123456)};
+    constexpr zx_koid_t kKoids[] = {0, 1, 99999, 100000, ZX_KOID_INVALID - 1};
+
+    for (zx_instant_boot_t timestamp : kTimestamps) {
+      for (zx_koid_t koid : kKoids) {
+        dlog_header_t hdr{};
+        hdr.timestamp = timestamp;
+        hdr.pid = koid;
+        hdr.tid = kKoids[ktl::size(kKoids) - 1] - koid;
+        char buffer[128];
+        EXPECT_EQ(DLog::FormatHeader(buffer, hdr), DLog::MeasureRenderedHeader(hdr));
+      }
+    }
+
+    END_TEST;
+  }
+
   static bool log_wrap() {
     BEGIN_TEST;
 
@@ -582,12 +605,61 @@ struct DebuglogTests {
 
     END_TEST;
   }
+
+  // Records left on a CPU's stage enter the log, in order, ahead of the next write.
+  static bool staged_records() {
+    BEGIN_TEST;
+
+    fbl::AllocChecker ac;
+    ktl::unique_ptr<DLog> log = ktl::make_unique<DLog>(&ac);
+    ASSERT_TRUE(ac.check());
+
+    constexpr ktl::string_view kMsgs[] = {"first", "second", "third"};
+    auto make_header = [](ktl::string_view msg) {
+      dlog_header_t hdr{};
+      const size_t wiresize = sizeof(dlog_header) + DLOG_ALIGN(msg.size());
+      hdr.preamble =
+          static_cast<uint32_t>(DLOG_HDR_SET(wiresize, sizeof(dlog_header) + msg.size()));
+      hdr.datalen = static_cast<uint16_t>(msg.size());
+      hdr.severity = DEBUGLOG_INFO;
+      hdr.timestamp = current_boot_time();
+      return hdr;
+    };
+
+    {
+      InterruptDisableGuard irqd;
+      ASSERT_TRUE(log->StageRecord(make_header(kMsgs[0]), kMsgs[0]));
+      ASSERT_TRUE(log->StageRecord(make_header(kMsgs[1]), kMsgs[1]));
+    }
+    {
+      Guard<MonitoredSpinLock, IrqSave> guard{&log->lock_, SOURCE_TAG};
+      EXPECT_EQ(0u, log->head_);
+    }
+    EXPECT_EQ(2u, log->staged_count_.load());
+
+    ASSERT_OK(log->Write(DEBUGLOG_INFO, 0, kMsgs[2]));
+    EXPECT_EQ(0u, log->staged_count_.load());
+
+    DlogReader reader;
+    reader.Initialize(nullptr, nullptr, log.get());
+    for (size_t i = 0; i < ktl::size(kMsgs); ++i) {
+      size_t got;
+      dlog_record_t rec{};
+      ASSERT_EQ(ZX_OK, reader.Read(0, &rec, &got));
+      EXPECT_EQ(i, rec.hdr.sequence);
+      EXPECT_TRUE(kMsgs[i] == ktl::string_view(rec.data, rec.hdr.datalen));
+    }
+    reader.Disconnect();
+
+    END_TEST;
+  }
 };
 
 #define DEBUGLOG_UNITTEST(fname) UNITTEST(#fname, fname)
 
 UNITTEST_START_TESTCASE(debuglog_tests)
 DEBUGLOG_UNITTEST(DebuglogTests::log_format)
+DEBUGLOG_UNITTEST(DebuglogTests::measure_header)
 DEBUGLOG_UNITTEST(DebuglogTests::log_wrap)
 DEBUGLOG_UNITTEST(DebuglogTests::log_reader_read)
 DEBUGLOG_UNITTEST(DebuglogTests::log_reader_dataloss)
@@ -596,4 +668,5 @@ DEBUGLOG_UNITTEST(DebuglogTests::render_to_crashlog)
 DEBUGLOG_UNITTEST(DebuglogTests::read_record)
 DEBUGLOG_UNITTEST(DebuglogTests::shutdown)
 DEBUGLOG_UNITTEST(DebuglogTests::write_with_active_chainlock_transaction)
+DEBUGLOG_UNITTEST(DebuglogTests::staged_records)
 UNITTEST_END_TESTCASE(debuglog_tests, "debuglog_tests", "Debuglog test")
@@ -0,0 +1,136 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_LIB_DEVICETREE_INCLUDE_LIB_DEVICETREE_INDEX_H_
+#define ZIRCON_KERNEL_LIB_DEVICETREE_INCLUDE_LIB_DEVICETREE_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+
+#include "devicetree.h"
+
+namespace devicetree {
+
+// An index over the nodes of a |Devicetree|, built in a single walk, so that nodes can be looked up
+// by phandle, by path and by compatible string without walking the flattened tree again.
+//
+// Like |Devicetree|, an index does not dynamically allocate memory. The caller provides storage for
+// one |Entry| per node, see |NodeCount|, and for a phandle hash table of |PhandleTableSize|
+// elements. Both must outlive the index, as must the flattened devicetree itself, since entries
+// refer directly to its node names and properties.
+//
+// Usage example:
+// ```
+//   std::array<devicetree::Index::Entry, kMaxNodes> entries;
+//   std::array<uint32_t, devicetree::Index::PhandleTableSize(kMaxNodes)> phandles;
+//   auto index = devicetree::Index::Create(dt, entries, phandles);
+//   if (!index) {
+//     return;  // The tree has more than kMaxNodes nodes.
+//   }
+//   if (auto gic = index->FindPhandle(interrupt_parent)) {
+//     devicetree::PropertyDecoder decoder((*index)[*gic].properties);
+//     ...
+//   }
+// ```
+class Index {
+ public:
+  // Entry index used for a missing parent, child or sibling.
+  static constexpr uint32_t kNone = UINT32_MAX;
+
+  // A node of the tree. Entries are in the order of a pre-order walk, so the root is entry 0 and
+  // every node's subtree follows it.
+  struct Entry {
+    // The name of the node, including the unit address if any.
+    Node name{{}};
+    Properties properties;
+    uint32_t parent = kNone;
+    uint32_t first_child = kNone;
+    uint32_t next_sibling = kNone;
+    // The value of the 'phandle' (or legacy 'linux,phandle') property, or zero if the node has
+    // none, zero not being a valid phandle.
+    uint32_t phandle = 0;
+    // A filter with bits set for each of the node's 'compatible' strings, see |CompatibleFilter|.
+    uint64_t compatible_filter = 0;
+  };
+
+  // Returns the number of nodes in |tree|, for sizing the entry storage.
+  static size_t NodeCount(const Devicetree& tree);
+
+  // Returns the size of phandle hash table needed for an index of |node_count| nodes.
+  static constexpr size_t PhandleTableSize(size_t node_count) {
+    size_t size = 1;
+    while (size < 2 * node_count) {
+      size *= 2;
+    }
+    return size;
+  }
+
+  // Returns the filter bits that a node with |compatible| among its compatible strings has set.
+  static uint64_t CompatibleFilter(std::string_view compatible);
+
+  // Indexes |tree|. Returns std::nullopt if |entries| cannot hold every node or |phandle_table|
+  // is smaller than |PhandleTableSize(entries.size())|.
+  static std::optional<Index> Create(const Devicetree& tree, std::span<Entry> entries,
+                                     std::span<uint32_t> phandle_table);
+
+  size_t size() const { return entries_.size(); }
+  const Entry& operator[](uint32_t index) const { return entries_[index]; }
+  std::span<const Entry> entries() const { return entries_; }
+
+  // Returns the entry of the node with the given phandle.
+  std::optional<uint32_t> FindPhandle(uint32_t phandle) const;
+
+  // Returns the entry of the node at |path|, which is either absolute, or relative to an alias in
+  // the '/aliases' node. A path component without a unit address matches a node with one, as long
+  // as it is the only such node.
+  std::optional<uint32_t> FindPath(std::string_view path) const;
+
+  // Calls |callback| with the entry of each node that has |compatible| among its compatible
+  // strings, in pre-order. Returning false from |callback| stops the search.
+  template <typename Callback>
+  void ForEachCompatible(std::string_view compatible, Callback&& callback) const {
+    const uint64_t filter = CompatibleFilter(compatible);
+    for (uint32_t i = 0; i < entries_.size(); ++i) {
+      if ((entries_[i].compatible_filter & filter) == filter && IsCompatible(i, compatible)) {
+        if (!callback(i)) {
+          return;
+        }
+      }
+    }
+  }
+
+  // Returns the first node, in pre-order, that has |compatible| among its compatible strings.
+  std::optional<uint32_t> FindCompatible(std::string_view compatible) const {
+    std::optional<uint32_t> found;
+    ForEachCompatible(compatible, [&found](uint32_t index) {
+      found = index;
+      return false;
+    });
+    return found;
+  }
+
+ private:
+  Index(std::span<const Entry> entries, std::span<const uint32_t> phandle_table)
+      : entries_(entries), phandle_table_(phandle_table) {}
+
+  bool IsCompatible(uint32_t index, std::string_view compatible) const;
+
+  // Returns the child of |parent| named |name|, see FindPath.
+  std::optional<uint32_t> FindChild(uint32_t parent, std::string_view name) const;
+
+  std::optional<uint32_t> FindPathFrom(uint32_t start, std::string_view relative_path) const;
+
+  std::span<const Entry> entries_;
+  // Open addressed hash table of entry indices, keyed by their phandle.
+  std::span<const uint32_t> phandle_table_;
+};
+
+}  // namespace devicetree
+
+#endif  // ZIRCON_KERNEL_LIB_DEVICETREE_INCLUDE_LIB_DEVICETREE_INDEX_H_
@@ -0,0 +1,206 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/devicetree/devicetree.h>
+#include <lib/devicetree/index.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+namespace devicetree {
+namespace {
+
+// FNV-1a, which is plenty for the few hundred strings of a devicetree.
+constexpr uint64_t Hash(std::string_view str) {
+  uint64_t hash = 0xcbf29ce484222325;
+  for (char c : str) {
+    hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3;
+  }
+  return hash;
+}
+
+constexpr size_t PhandleSlot(uint32_t phandle, size_t table_size) {
+  return static_cast<size_t>((uint64_t{phandle} * 0x9e3779b97f4a7c15) >> 32) & (table_size - 1);
+}
+
+}  // namespace
+
+size_t Index::NodeCount(const Devicetree& tree) {
+  size_t count = 0;
+  tree.Walk([&count](const NodePath&, const PropertyDecoder&) {
+    ++count;
+    return true;
+  });
+  return count;
+}
+
+uint64_t Index::CompatibleFilter(std::string_view compatible) {
+  // Two bits per string keeps false positives rare for the handful of compatible strings a node
+  // typically has.
+  const uint64_t hash = Hash(compatible);
+  return (uint64_t{1} << (hash & 63)) | (uint64_t{1} << ((hash >> 6) & 63));
+}
+
+std::optional<Index> Index::Create(const Devicetree& tree, std::span<Entry> entries,
+                                   std::span<uint32_t> phandle_table) {
+  if (phandle_table.size() < PhandleTableSize(entries.size())) {
+    return std::nullopt;
+  }
+  const size_t table_size = PhandleTableSize(entries.size());
+  std::fill(phandle_table.begin(), phandle_table.begin() + table_size, kNone);
+
+  size_t count = 0;
+  uint32_t current = kNone;
+  bool phandles_ok = true;
+  auto pre_order = [&](const NodePath& path, const PropertyDecoder& decoder) {
+    if (count++ >= entries.size()) {
+      return true;
+    }
+    const uint32_t index = static_cast<uint32_t>(count - 1);
+    Entry& entry = entries[index];
+    entry = Entry{.name = path.back(), .properties = decoder.properties(), .parent = current};
+    if (current != kNone) {
+      // Children end up in reverse order, which does not matter to lookups.
+      entry.next_sibling = entries[current].first_child;
+      entries[current].first_child = index;
+    }
+    current = index;
+
+    auto [phandle, linux_phandle, compatible] =
+        decoder.FindProperties("phandle", "linux,phandle", "compatible");
+    if (!phandle) {
+      phandle = linux_phandle;
+    }
+    if (phandle) {
+      entry.phandle = phandle->AsUint32().value_or(0);
+    }
+    if (entry.phandle != 0 && entry.phandle != kNone) {
+      size_t slot = PhandleSlot(entry.phandle, table_size);
+      while (phandle_table[slot] != kNone) {
+        if (entries[phandle_table[slot]].phandle == entry.phandle) {
+          // Duplicate phandles make the tree malformed.
+          phandles_ok = false;
+          break;
+        }
+        slot = (slot + 1) & (table_size - 1);
+      }
+      phandle_table[slot] = index;
+    }
+    if (compatible) {
+      if (auto strings = compatible->AsStringList()) {
+        for (std::string_view str : *strings) {
+          entry.compatible_filter |= CompatibleFilter(str);
+        }
+      }
+    }
+    return true;
+  };
+  auto post_order = [&](const NodePath&, const PropertyDecoder&) {
+    if (current != kNone && count <= entries.size()) {
+      current = entries[current].parent;
+    }
+  };
+  tree.Walk(pre_order, post_order);
+
+  if (count > entries.size() || !phandles_ok) {
+    return std::nullopt;
+  }
+  return Index(entries.subspan(0, count), phandle_table.subspan(0, table_size));
+}
+
+std::optional<uint32_t> Index::FindPhandle(uint32_t phandle) const {
+  if (phandle == 0 || phandle == kNone || phandle_table_.empty()) {
+    return std::nullopt;
+  }
+  for (size_t slot = PhandleSlot(phandle, phandle_table_.size());
+       phandle_table_[slot] != kNone; slot = (slot + 1) & (phandle_table_.size() - 1)) {
+    if (entries_[phandle_table_[slot]].phandle == phandle) {
+      return phandle_table_[slot];
+    }
+  }
+  return std::nullopt;
+}
+
+bool Index::IsCompatible(uint32_t index, std::string_view compatible) const {
+  auto strings =
+      PropertyDecoder(entries_[index].properties)
+          .FindAndDecodeProperty<&PropertyValue::AsStringList>("compatible");
+  if (!strings) {
+    return false;
+  }
+  for (std::string_view str : *strings) {
+    if (str == compatible) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::optional<uint32_t> Index::FindChild(uint32_t parent, std::string_view name) const {
+  const bool match_name_only = name.find('@') == std::string_view::npos;
+  std::optional<uint32_t> name_match;
+  for (uint32_t child = entries_[parent].first_child; child != kNone;
+       child = entries_[child].next_sibling) {
+    const Node& child_name = entries_[child].name;
+    if (child_name == name) {
+      return child;
+    }
+    if (match_name_only && child_name.name() == name) {
+      if (name_match) {
+        // Ambiguous without the unit address.
+        return std::nullopt;
+      }
+      name_match = child;
+    }
+  }
+  return name_match;
+}
+
+std::optional<uint32_t> Index::FindPathFrom(uint32_t start, std::string_view relative_path) const {
+  uint32_t current = start;
+  for (std::string_view component : StringList<'/'>(relative_path)) {
+    if (component.empty()) {
+      continue;
+    }
+    auto child = FindChild(current, component);
+    if (!child) {
+      return std::nullopt;
+    }
+    current = *child;
+  }
+  return current;
+}
+
+std::optional<uint32_t> Index::FindPath(std::string_view path) const {
+  if (entries_.empty() || path.empty()) {
+    return std::nullopt;
+  }
+  if (path.front() == '/') {
+    return FindPathFrom(0, path);
+  }
+
+  // Resolve the alias, which must itself be an absolute path.
+  const size_t separator = path.find('/');
+  const std::string_view alias = path.substr(0, separator);
+  auto aliases = FindChild(0, "aliases");
+  if (!aliases) {
+    return std::nullopt;
+  }
+  auto aliased = PropertyDecoder(entries_[*aliases].properties)
+                     .FindAndDecodeProperty<&PropertyValue::AsString>(alias);
+  if (!aliased || aliased->empty() || aliased->front() != '/') {
+    return std::nullopt;
+  }
+  auto start = FindPathFrom(0, *aliased);
+  if (!start || separator == std::string_view::npos) {
+    return start;
+  }
+  return FindPathFrom(*start, path.substr(separator + 1));
+}
+
+}  // namespace devicetree
@@ -0,0 +1,131 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/devicetree/devicetree.h>
+#include <lib/devicetree/index.h>
+#include <lib/devicetree/testing/loaded-dtb.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <zxtest/zxtest.h>
+
+namespace {
+
+using devicetree::testing::LoadDtb;
+
+class IndexTest : public zxtest::Test {
+ public:
+  void SetUp() override {
+    auto loaded_dtb = LoadDtb("qemu-arm-gic3.dtb");
+    ASSERT_TRUE(loaded_dtb.is_ok(), "%s", loaded_dtb.error_value().c_str());
+    dtb_ = std::move(loaded_dtb).value();
+    const size_t node_count = devicetree::Index::NodeCount(dtb_.fdt());
+    entries_.resize(node_count);
+    phandles_.resize(devicetree::Index::PhandleTableSize(node_count));
+  }
+
+  std::optional<devicetree::Index> Create() {
+    return devicetree::Index::Create(dtb_.fdt(), entries_, phandles_);
+  }
+
+ protected:
+  devicetree::testing::LoadedDtb dtb_;
+  std::vector<devicetree::Index::Entry> entries_;
+  std::vector<uint32_t> phandles_;
+};
+
+TEST_F(IndexTest, NodesInPreOrder) {
+  auto index = Create();
+  ASSERT_TRUE(index.has_value());
+  ASSERT_EQ(index->size(), entries_.size());
+
+  size_t i = 0;
+  dtb_.fdt().Walk([&](const devicetree::NodePath& path, const devicetree::PropertyDecoder&) {
+    EXPECT_EQ(std::string_view((*index)[static_cast<uint32_t>(i)].name), path.back());
+    ++i;
+    return true;
+  });
+  EXPECT_EQ(i, index->size());
+  EXPECT_EQ((*index)[0].parent, devicetree::Index::kNone);
+}
+
+TEST_F(IndexTest, StorageTooSmall) {
+  entries_.pop_back();
+  EXPECT_FALSE(Create().has_value());
+
+  entries_.push_back({});
+  phandles_.resize(phandles_.size() / 2);
+  EXPECT_FALSE(Create().has_value());
+}
+
+TEST_F(IndexTest, FindPhandle) {
+  auto index = Create();
+  ASSERT_TRUE(index.has_value());
+
+  auto gic = index->FindPhandle(0x8001);
+  ASSERT_TRUE(gic.has_value());
+  EXPECT_EQ(std::string_view((*index)[*gic].name), "intc@8000000");
+
+  auto clock = index->FindPhandle(0x8000);
+  ASSERT_TRUE(clock.has_value());
+  EXPECT_EQ(std::string_view((*index)[*clock].name), "apb-pclk");
+
+  EXPECT_FALSE(index->FindPhandle(0).has_value());
+  EXPECT_FALSE(index->FindPhandle(0x1234).has_value());
+}
+
+TEST_F(IndexTest, FindPath) {
+  auto index = Create();
+  ASSERT_TRUE(index.has_value());
+
+  EXPECT_EQ(index->FindPath("/").value_or(devicetree::Index::kNone), 0u);
+
+  auto cpu = index->FindPath("/cpus/cpu@2");
+  ASSERT_TRUE(cpu.has_value());
+  EXPECT_EQ(std::string_view((*index)[*cpu].name), "cpu@2");
+  auto cpus = index->FindPath("/cpus");
+  ASSERT_TRUE(cpus.has_value());
+  EXPECT_EQ((*index)[*cpu].parent, *cpus);
+
+  // The unit address may be omitted when there is no ambiguity.
+  auto uart = index->FindPath("/pl011");
+  ASSERT_TRUE(uart.has_value());
+  EXPECT_EQ(std::string_view((*index)[*uart].name), "pl011@9000000");
+  EXPECT_FALSE(index->FindPath("/cpus/cpu").has_value());
+
+  EXPECT_FALSE(index->FindPath("/cpus/cpu@4").has_value());
+  EXPECT_FALSE(index->FindPath("/does-not-exist").has_value());
+  EXPECT_FALSE(index->FindPath("no-such-alias").has_value());
+}
+
+TEST_F(IndexTest, FindCompatible) {
+  auto index = Create();
+  ASSERT_TRUE(index.has_value());
+
+  auto gic = index->FindCompatible("arm,gic-v3");
+  ASSERT_TRUE(gic.has_value());
+  EXPECT_EQ(index->FindPhandle(0x8001), gic);
+
+  std::vector<std::string_view> primecells;
+  index->ForEachCompatible("arm,primecell", [&](uint32_t i) {
+    primecells.push_back((*index)[i].name);
+    return true;
+  });
+  EXPECT_EQ(primecells.size(), 3u);
+
+  size_t cpu_count = 0;
+  index->ForEachCompatible("arm,cortex-a57", [&](uint32_t) {
+    ++cpu_count;
+    return true;
+  });
+  EXPECT_EQ(cpu_count, 4u);
+
+  EXPECT_FALSE(index->FindCompatible("arm,cortex").has_value());
+  EXPECT_FALSE(index->FindCompatible("does-not-exist").has_value());
+}
+
+}  // namespace
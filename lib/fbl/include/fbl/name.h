@@ -7,12 +7,11 @@
 #ifndef ZIRCON_KERNEL_LIB_FBL_INCLUDE_FBL_NAME_H_
 #define ZIRCON_KERNEL_LIB_FBL_INCLUDE_FBL_NAME_H_
 
-#include <lib/zircon-internal/thread_annotations.h>
+#include <lib/kconcurrent/seqlock.h>
 #include <string.h>
 #include <zircon/compiler.h>
 #include <zircon/types.h>
 
-#include <kernel/spinlock.h>
 #include <ktl/algorithm.h>
 
 namespace fbl {
@@ -42,8 +41,8 @@ class Name {
   void get(size_t out_len, char* out_name) const __NONNULL((3)) {
     memset(out_name, 0, out_len);
     if (out_len > 0u) {
-      Guard<SpinLock, IrqSave> lock(&lock_);
-      strlcpy(out_name, name_, ktl::min(out_len, Size));
+      const Storage snapshot = name_.Read();
+      strlcpy(out_name, snapshot.data, ktl::min(out_len, Size));
     }
   }
 
@@ -56,9 +55,9 @@ class Name {
     if (len >= Size)
       len = Size - 1;
 
-    Guard<SpinLock, IrqSave> lock(&lock_);
-    memcpy(name_, name, len);
-    memset(name_ + len, 0, Size - len);
+    Storage storage = {};
+    memcpy(storage.data, name, len);
+    name_.Update(storage);
     return ZX_OK;
   }
 
@@ -72,12 +71,17 @@ class Name {
   }
 
  private:
+  struct Storage {
+    // This includes the trailing NUL.
+    char data[Size];
+  };
+
   // These Names are often included for diagnostic purposes, and
   // access to the Name might be made under various other locks or
-  // in interrupt context. So we use a spinlock to serialize.
-  mutable DECLARE_SPINLOCK(Name) lock_;
-  // This includes the trailing NUL.
-  char name_[Size] TA_GUARDED(lock_) = {};
+  // in interrupt context. Names are read far more often than they
+  // are written (every ZX_INFO query and ktrace record fetches one),
+  // so readers use a seqlock and never contend with each other.
+  SeqLockedValue<Storage> name_;
 };
 
 }  // namespace fbl
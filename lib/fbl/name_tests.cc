@@ -226,4 +226,5 @@ NAME_UNITTEST((output_buffer_size<kTypicalNameSize, kTypicalNameSize>))
 // Don't bother testing a larger output buffer, since most of the
 // earlier tests use larger output buffers.
 
-UNITTEST_END_TESTCASE(name_tests, "nametests", "Name test")
+UNITTEST_END_TESTCASE_WITH_FLAGS(name_tests, "nametests", "Name test",
+                                 UNITTEST_TESTCASE_FLAG_ISOLATED)
@@ -27,6 +27,14 @@
 
 #define KERNEL_ASAN (__has_feature(address_sanitizer) && _KERNEL)
 
+// Small allocations are served from per-CPU caches in front of the free lists in the kernel. ASAN
+// builds skip them so that every free goes through the quarantine.
+#if defined(_KERNEL) && !KERNEL_ASAN
+#define CMPCT_CPU_CACHE 1
+#else
+#define CMPCT_CPU_CACHE 0
+#endif
+
 #if KERNEL_ASAN
 #include <lib/instrumentation/asan.h>
 #else  // !KERNEL_ASAN
@@ -119,6 +127,14 @@
 //   Exception: to avoid OS free/alloc churn when right on the edge, the heap
 //   will try to hold onto one entirely-free, non-large OS allocation instead of
 //   returning it to the OS. See cached_os_alloc.
+//
+// Per-CPU caches:
+//   In the kernel, memory areas from the smallest buckets are not freed to the
+//   free lists directly. Each CPU keeps a short stack of still-allocated areas
+//   per bucket, which allocations in that bucket take from without touching
+//   TheHeapLock. An empty stack is refilled, and a full one half flushed, in a
+//   batch under a single acquisition of TheHeapLock. cmpct_trim() flushes all
+//   of them, so that memory pressure can return the areas to the OS.
 
 #if defined(DEBUG) || defined(__riscv) || LK_DEBUGLEVEL > 2
 // TODO(https://fxbug.dev/404291515): Enable on riscv to track down heap corruption.
@@ -132,6 +148,10 @@
 #include <lib/ktrace.h>
 #include <trace.h>
 
+#include <arch/defines.h>
+#include <arch/ops.h>
+#include <kernel/auto_preempt_disabler.h>
+
 #define LOCAL_TRACE_DURATION(label, name, ...) \
   ktrace::Scope name = KTRACE_BEGIN_SCOPE_ENABLE(false, "kernel:memory", label, ##__VA_ARGS__)
 
@@ -151,6 +171,8 @@ KCOUNTER(malloc_size_le_2048, "malloc.size_le_2048")
 KCOUNTER(malloc_size_other, "malloc.size_other")
 // The number of failed attempts at growing the heap.
 KCOUNTER(malloc_heap_grow_fail, "malloc.heap_grow_fail")
+KCOUNTER(malloc_cpu_cache_hit, "malloc.cpu_cache.hit")
+KCOUNTER(malloc_cpu_cache_miss, "malloc.cpu_cache.miss")
 
 #else
 
@@ -579,8 +601,8 @@ NO_ASAN static void FixLeftPointer(header_t* right, header_t* new_left) TA_REQ(T
 }
 
 #ifdef CMPCT_DEBUG
-[[maybe_unused]] NO_ASAN static void check_free_fill(void* ptr, size_t size)
-    TA_REQ(TheHeapLock::Get()) {
+// Only looks at memory owned by the caller, so it needs no lock.
+[[maybe_unused]] NO_ASAN static void check_free_fill(void* ptr, size_t size) {
   // The first 16 bytes of the region won't have free fill due to overlap
   // with the allocator bookkeeping.
   const size_t start = sizeof(free_t) - sizeof(header_t);
@@ -861,6 +883,149 @@ constexpr size_t kHeapMaxAllocSize = (size_t(1) << 20) - sizeof(header_t);
 static_assert(SizeToIndexAllocating(kHeapMaxAllocSize).rounded_up + sizeof(header_t) <=
               HEAP_LARGE_ALLOC_BYTES);
 
+// Allocates |rounded_up| bytes (including the header) from the first free
+// area in |bucket|, which must be non-empty, and returns the payload.
+NO_ASAN static void* carve_allocation(int bucket, size_t rounded_up, size_t size)
+    TA_REQ(TheHeapLock::Get()) {
+  free_t* head = theheap.free_lists[bucket];
+  size_t left_over = head->header.size - rounded_up;
+  // We can't carve off the rest for a new free space if it's smaller than the
+  // free-list linked structure.  We also don't carve it off if it's less than
+  // 1.6% the size of the allocation.  This is to avoid small long-lived
+  // allocations being placed right next to large allocations, hindering
+  // coalescing and returning pages to the OS.
+  if (left_over >= sizeof(free_t) && left_over > (size >> 6)) {
+    header_t* right = right_header(&head->header);
+    unlink_free(head, bucket);
+    void* free = (char*)head + rounded_up;
+    create_free_area(free, head, left_over);
+    FixLeftPointer(right, (header_t*)free);
+    head->header.size -= static_cast<uint32_t>(left_over);
+  } else {
+    unlink_free(head, bucket);
+  }
+  return create_allocation_header(head, 0, head->header.size, head->header.left);
+}
+
+#if CMPCT_CPU_CACHE
+
+static void cmpct_free_internal(void* payload, header_t* header) TA_REQ(TheHeapLock::Get());
+
+// Allocations of up to this many bytes are served from the per-CPU caches.
+constexpr size_t kCpuCacheMaxSize = 512;
+constexpr int kCpuCacheBuckets = SizeToIndexAllocating(kCpuCacheMaxSize).bucket + 1;
+// The most areas a CPU caches per bucket, and how many it moves to or from
+// the free lists at once.
+constexpr uint32_t kCpuCacheDepth = 16;
+constexpr uint32_t kCpuCacheBatch = kCpuCacheDepth / 2;
+
+// The cookie of areas parked in a per-CPU cache, so that freeing one of them again is caught. The
+// cache owns those areas, so nothing else reads or sets their cookies until they are allocated.
+constexpr uint32_t kCpuCacheCookie = 0x63616368;  // "cach"
+
+struct alignas(MAX_CACHE_LINE) CpuCache {
+  // Only contended by cmpct_trim(). It is held across TheHeapLock.
+  DECLARE_MUTEX(CpuCache) lock;
+  // Cached areas are still marked as allocated, and are linked through the
+  // first word of their payloads.
+  void* heads[kCpuCacheBuckets] TA_GUARDED(lock){};
+  uint32_t counts[kCpuCacheBuckets] TA_GUARDED(lock){};
+};
+
+static CpuCache cpu_caches[SMP_MAX_CPUS];
+
+static void* cpu_cache_pop(CpuCache& cache, int bucket) TA_REQ(cache.lock) {
+  void* payload = cache.heads[bucket];
+  cache.heads[bucket] = *static_cast<void**>(payload);
+  cache.counts[bucket]--;
+  return payload;
+}
+
+static void cpu_cache_push(CpuCache& cache, int bucket, void* payload) TA_REQ(cache.lock) {
+  *static_cast<void**>(payload) = cache.heads[bucket];
+  cache.heads[bucket] = payload;
+  cache.counts[bucket]++;
+}
+
+// Returns up to |count| areas of |bucket| to the free lists.
+static size_t cpu_cache_flush(CpuCache& cache, int bucket, uint32_t count)
+    TA_REQ(cache.lock, TheHeapLock::Get()) {
+  size_t bytes = 0;
+  while (count-- > 0 && cache.counts[bucket] > 0) {
+    void* payload = cpu_cache_pop(cache, bucket);
+    header_t* header = (header_t*)payload - 1;
+    bytes += header->size;
+    cmpct_free_internal(payload, header);
+  }
+  return bytes;
+}
+
+// Returns an area of at least |rounded_up| bytes (including the header) from
+// the current CPU's cache for |bucket|, refilling it from the free lists if
+// needed. Returns null if that would need the heap to grow.
+static void* cpu_cache_alloc(int bucket, size_t rounded_up, size_t size)
+    TA_EXCL(TheHeapLock::Get()) {
+  AutoPreemptDisabler preempt_disable;
+  CpuCache& cache = cpu_caches[arch_curr_cpu_num()];
+  Guard<Mutex> guard{&cache.lock};
+  if (cache.counts[bucket] == 0) {
+    kcounter_add(malloc_cpu_cache_miss, 1);
+    LockGuard heap_guard(TheHeapLock::Get());
+    for (uint32_t i = 0; i < kCpuCacheBatch; i++) {
+      const int nonempty = find_nonempty_bucket(bucket);
+      if (nonempty == -1) {
+        break;
+      }
+      void* payload = carve_allocation(nonempty, rounded_up, size);
+      ((header_t*)payload - 1)->cookie = kCpuCacheCookie;
+      cpu_cache_push(cache, bucket, payload);
+    }
+    if (cache.counts[bucket] == 0) {
+      return NULL;
+    }
+  } else {
+    kcounter_add(malloc_cpu_cache_hit, 1);
+  }
+  void* payload = cpu_cache_pop(cache, bucket);
+  header_t* header = (header_t*)payload - 1;
+  ZX_DEBUG_ASSERT(header->cookie == kCpuCacheCookie);
+#ifdef CMPCT_DEBUG
+  // Cached areas are free filled as they are cached, apart from the link, so this catches writes
+  // after free to them just as for areas on the free lists.
+  check_free_fill(payload, header->size - sizeof(header_t));
+#endif
+  header->cookie = 0;
+  return payload;
+}
+
+// Caches |payload| on the current CPU if it is small enough, flushing half of
+// the bucket to the free lists first if it is full. Returns false if the area
+// is too large to be cached.
+static bool cpu_cache_free(void* payload) TA_EXCL(TheHeapLock::Get()) {
+  header_t* header = (header_t*)payload - 1;
+  const int bucket = size_to_index_freeing(header->size - sizeof(header_t));
+  if (bucket >= kCpuCacheBuckets) {
+    return false;
+  }
+  // Cached areas are still marked as allocated, so the free lists cannot catch this.
+  ZX_ASSERT_MSG(header->cookie != kCpuCacheCookie, "double free of %p", payload);
+  header->cookie = kCpuCacheCookie;
+#ifdef CMPCT_DEBUG
+  memset(payload, FREE_FILL, header->size - sizeof(header_t));
+#endif
+  AutoPreemptDisabler preempt_disable;
+  CpuCache& cache = cpu_caches[arch_curr_cpu_num()];
+  Guard<Mutex> guard{&cache.lock};
+  if (cache.counts[bucket] == kCpuCacheDepth) {
+    LockGuard heap_guard(TheHeapLock::Get());
+    cpu_cache_flush(cache, bucket, kCpuCacheBatch);
+  }
+  cpu_cache_push(cache, bucket, payload);
+  return true;
+}
+
+#endif  // CMPCT_CPU_CACHE
+
 NO_ASAN void* cmpct_alloc(size_t size) {
   LOCAL_TRACE_DURATION("cmpct_alloc", trace, ("size", size));
 
@@ -915,6 +1080,23 @@ NO_ASAN void* cmpct_alloc(size_t size) {
 
   rounded_up += sizeof(header_t);
 
+#if CMPCT_CPU_CACHE
+  if (start_bucket < kCpuCacheBuckets) {
+    void* result = cpu_cache_alloc(start_bucket, rounded_up, size);
+    if (result != NULL) {
+#ifdef CMPCT_DEBUG
+      memset(result, ALLOC_FILL, size);
+      memset(((char*)result) + size, PADDING_FILL,
+             ((header_t*)result - 1)->size - size - sizeof(header_t));
+#endif
+      if (alloc_size < g_fill_on_alloc_threshold) {
+        memset(result, 0, alloc_size);
+      }
+      return result;
+    }
+  }
+#endif  // CMPCT_CPU_CACHE
+
   LockGuard guard(TheHeapLock::Get());
   LOCAL_TRACE_DURATION("locked", trace_lock);
   int bucket = find_nonempty_bucket(start_bucket);
@@ -961,24 +1143,7 @@ NO_ASAN void* cmpct_alloc(size_t size) {
     // the assertion of the growby amount above to succeed and then this assertion to fail.
     ZX_DEBUG_ASSERT(bucket != -1);
   }
-  free_t* head = theheap.free_lists[bucket];
-  size_t left_over = head->header.size - rounded_up;
-  // We can't carve off the rest for a new free space if it's smaller than the
-  // free-list linked structure.  We also don't carve it off if it's less than
-  // 1.6% the size of the allocation.  This is to avoid small long-lived
-  // allocations being placed right next to large allocations, hindering
-  // coalescing and returning pages to the OS.
-  if (left_over >= sizeof(free_t) && left_over > (size >> 6)) {
-    header_t* right = right_header(&head->header);
-    unlink_free(head, bucket);
-    void* free = (char*)head + rounded_up;
-    create_free_area(free, head, left_over);
-    FixLeftPointer(right, (header_t*)free);
-    head->header.size -= static_cast<uint32_t>(left_over);
-  } else {
-    unlink_free(head, bucket);
-  }
-  void* result = create_allocation_header(head, 0, head->header.size, head->header.left);
+  void* result = carve_allocation(bucket, rounded_up, size);
 #ifdef CMPCT_DEBUG
   check_free_fill(result, size);
   memset(result, ALLOC_FILL, size);
@@ -1060,6 +1225,11 @@ NO_ASAN void cmpct_free(void* payload) {
   if (payload == NULL) {
     return;
   }
+#if CMPCT_CPU_CACHE
+  if (cpu_cache_free(payload)) {
+    return;
+  }
+#endif
 
   LockGuard guard(TheHeapLock::Get());
   LOCAL_TRACE_DURATION("locked", trace_locked);
@@ -1073,13 +1243,19 @@ NO_ASAN void cmpct_sized_free(void* payload, size_t s) {
     return;
   }
 
-  LockGuard guard(TheHeapLock::Get());
-  LOCAL_TRACE_DURATION("locked", trace_locked);
   header_t* header = (header_t*)payload - 1;
   // header->size is the size of the heap block |payload| is in, plus sizeof(header_t), plus
   // the difference between the block size and the requested allocation size. If kernel ASAN
   // is enabled, it also includes an ASAN redzone.
   ZX_ASSERT_MSG(static_cast<size_t>(header->size) >= s, "expected %u got %lu", header->size, s);
+#if CMPCT_CPU_CACHE
+  if (cpu_cache_free(payload)) {
+    return;
+  }
+#endif
+
+  LockGuard guard(TheHeapLock::Get());
+  LOCAL_TRACE_DURATION("locked", trace_locked);
   return cmpct_free_internal(payload, header);
 }
 
@@ -1184,6 +1360,22 @@ NO_ASAN void cmpct_get_info(size_t* used_bytes, size_t* free_bytes, size_t* cach
   }
 }
 
+size_t cmpct_trim(void) {
+#if CMPCT_CPU_CACHE
+  size_t bytes = 0;
+  for (CpuCache& cache : cpu_caches) {
+    Guard<Mutex> guard{&cache.lock};
+    LockGuard heap_guard(TheHeapLock::Get());
+    for (int bucket = 0; bucket < kCpuCacheBuckets; bucket++) {
+      bytes += cpu_cache_flush(cache, bucket, kCpuCacheDepth);
+    }
+  }
+  return bytes;
+#else
+  return 0;
+#endif
+}
+
 #ifdef HEAP_ENABLE_TESTS
 void cmpct_test(void) {
   cmpct_test_buckets();
@@ -61,6 +61,11 @@ void cmpct_get_info(size_t* used_bytes, size_t* free_bytes, size_t* cached_bytes
     TA_EXCL(TheHeapLock::Get());
 void cmpct_test(void) TA_EXCL(TheHeapLock::Get());
 
+// Flushes the per-CPU caches of small allocations back to the free lists, so
+// that OS allocations left entirely free can be returned to the OS. Returns the
+// number of bytes flushed.
+size_t cmpct_trim(void) TA_EXCL(TheHeapLock::Get());
+
 // Get and set a user defined cookie against an allocation returned from cmpct_alloc
 // or cmpct_memalign. |ptr| must be non-null and these methods are not thread
 // safe.
@@ -260,6 +260,8 @@ void heap_get_info(size_t* total_bytes, size_t* free_bytes) {
   }
 }
 
+size_t heap_trim() { return cmpct_trim(); }
+
 static void heap_test() { cmpct_test(); }
 
 void* heap_page_alloc(size_t pages) {
@@ -362,6 +364,8 @@ static int cmd_heap(int argc, const cmd_args* argv, uint32_t flags) {
     dump_stats();
   } else if (!(flags & CMD_FLAG_PANIC) && strcmp(argv[1].str, "test") == 0) {
     heap_test();
+  } else if (!(flags & CMD_FLAG_PANIC) && strcmp(argv[1].str, "trim") == 0) {
+    printf("trimmed %zu bytes\n", heap_trim());
   } else if (!(flags & CMD_FLAG_PANIC) && strcmp(argv[1].str, "trace") == 0) {
     heap_trace = !heap_trace;
     printf("heap trace is now %s\n", heap_trace ? "on" : "off");
@@ -34,6 +34,11 @@ void sized_free(void* ptr, size_t s);
 // from the PMM), |free_bytes| is the free portion.
 void heap_get_info(size_t* total_bytes, size_t* free_bytes);
 
+// Returns the small allocations cached per CPU to the heap, and any heap pages
+// left entirely free to the PMM. Returns the number of bytes returned to the
+// heap.
+size_t heap_trim(void);
+
 // called once at kernel initialization
 void heap_init(void);
 
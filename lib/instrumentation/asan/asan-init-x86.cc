@@ -28,6 +28,7 @@
 
 KCOUNTER(asan_allocated_shadow_pages, "asan.allocated_shadow_pages")
 KCOUNTER(asan_allocated_shadow_page_tables, "asan.allocated_shadow_page_tables")
+KCOUNTER(asan_allocated_shadow_large_pages, "asan.allocated_shadow_large_pages")
 
 extern volatile pt_entry_t kasan_shadow_pt[];
 extern volatile pt_entry_t kasan_shadow_pd[];
@@ -57,6 +58,26 @@ paddr_t get_or_allocate_page_table(volatile pt_entry_t* table, size_t i,
   return pd_page_paddr;
 }
 
+// Tries to back the shadow of the whole page directory entry |pd[i]| with a single zeroed large
+// page, which saves the page table and the TLB entries of 512 small pages. Returns false if no
+// suitably aligned contiguous run of pages is available.
+bool allocate_large_shadow_page(pt_entry_t* pd, size_t i) {
+  constexpr size_t kLargePageCount = 1ul << (PD_SHIFT - PAGE_SIZE_SHIFT);
+  list_node pages = LIST_INITIAL_VALUE(pages);
+  paddr_t paddr;
+  if (pmm_alloc_contiguous(kLargePageCount, 0, PD_SHIFT, &paddr, &pages) != ZX_OK) {
+    return false;
+  }
+  vm_page_t* page;
+  list_for_every_entry (&pages, page, vm_page_t, queue_node) {
+    page->set_state(vm_page_state::WIRED);
+  }
+  __unsanitized_memset(paddr_to_physmap(paddr), 0, kLargePageCount * PAGE_SIZE);
+  kcounter_add(asan_allocated_shadow_large_pages, 1);
+  pd[i] = paddr | X86_KERNEL_KASAN_RW_LP_FLAGS | X86_MMU_PG_NX;
+  return true;
+}
+
 // asan_remap_shadow_internal updates the kASAN shadow map to allow poisoning in the region [start,
 // start+size)
 void asan_remap_shadow_internal(volatile pt_entry_t* pdp, uintptr_t start, size_t size) {
@@ -85,6 +106,21 @@ void asan_remap_shadow_internal(volatile pt_entry_t* pdp, uintptr_t start, size_
         continue;
       }
 
+      if (pd[j] & X86_MMU_PG_PS) {
+        // Already backed by a large page.
+        continue;
+      }
+
+      // Arenas are dense, so the shadow of an entire page directory entry is worth a large page,
+      // unless a page table has already been populated for part of it.
+      const bool partial_start = i == pdp_map_start && j == pd_map_start && pt_map_start != 0;
+      const bool partial_end =
+          i == pdp_map_end && j == pd_map_end && pt_map_end != NO_OF_PT_ENTRIES - 1;
+      if (!partial_start && !partial_end && !(pd[j] & X86_MMU_PG_RW) &&
+          allocate_large_shadow_page(pd, j)) {
+        continue;
+      }
+
       pt_entry_t new_pd_entry = get_or_allocate_page_table(pd, j, kasan_shadow_pt);
       pt_entry_t* pt = reinterpret_cast<pt_entry_t*>(paddr_to_physmap(new_pd_entry));
       new_pd_entry |= X86_KERNEL_KASAN_PD_FLAGS;
@@ -24,9 +24,26 @@ ktl::atomic<bool> g_asan_initialized;
 namespace {
 
 // Checks if an entire memory region is all zeroes.
+//
+// The shadow of a kernel stack or a large heap block spans kilobytes, so the aligned middle of the
+// region is checked a word at a time.
 bool is_mem_zero(ktl::span<const uint8_t> region) {
-  for (auto val : region) {
-    if (val != 0) {
+  const uint8_t* p = region.data();
+  const uint8_t* const end = p + region.size();
+  for (; p < end && !IS_ROUNDED(p, sizeof(uint64_t)); ++p) {
+    if (*p != 0) {
+      return false;
+    }
+  }
+  for (; end - p >= static_cast<ptrdiff_t>(sizeof(uint64_t)); p += sizeof(uint64_t)) {
+    uint64_t word;
+    memcpy(&word, p, sizeof(word));
+    if (word != 0) {
+      return false;
+    }
+  }
+  for (; p < end; ++p) {
+    if (*p != 0) {
       return false;
     }
   }
@@ -137,10 +154,18 @@ bool asan_address_is_poisoned(uintptr_t address) {
 }
 
 bool asan_entire_region_is_poisoned(uintptr_t address, size_t size) {
-  for (size_t i = 0; i < size; i++) {
-    if (!asan_address_is_poisoned(address + i)) {
+  const uintptr_t end = address + size;
+  while (address < end) {
+    // A fully poisoned shadow byte covers the rest of its granule; anything else has to be checked
+    // a byte at a time.
+    if (*addr2shadow(address) >= kAsanSmallestPoisonedValue) {
+      address = ROUNDDOWN(address, kAsanGranularity) + kAsanGranularity;
+      continue;
+    }
+    if (!asan_address_is_poisoned(address)) {
       return false;
     }
+    address++;
   }
   return true;
 }
@@ -17,10 +17,13 @@ InstrumentationDataVmo SancovGetCountsVmo() { return {}; }
 
 #else  // HAVE_SANCOV
 
+#include <align.h>
 #include <lib/instrumentation/kernel-mapped-vmo.h>
 #include <stdint.h>
 #include <zircon/assert.h>
 
+#include <arch/ops.h>
+#include <kernel/thread.h>
 #include <ktl/atomic.h>
 #include <ktl/utility.h>
 #include <lk/init.h>
@@ -73,11 +76,53 @@ extern "C" uint32_t __start___sancov_guards[], __stop___sancov_guards[];
 // This way, no early PC hits are lost in the counts.  However, for PCs whose
 // only hits were before buffer setup, the nonzero counts will be paired with
 // zero PC slots because the PC values are only saved in the real buffers.
+//
+// Once set up, hits are not counted directly in the published 64-bit counts,
+// as atomic increments of counters shared by all CPUs make instrumented
+// kernels too slow to run realistic loads.  Instead each CPU has its own shard
+// of 32-bit counters that it increments with plain loads and stores, and a
+// thread periodically folds the shards into the published counts.  A hit can
+// be lost if the incrementing thread migrates or races with the fold, which
+// is an acceptable inaccuracy for coverage and profile data.
 
 uint64_t* gSancovPcTable = nullptr;
 uint64_t* gSancovPcCounts = nullptr;
 
-KernelMappedVmo gSancovPcVmo, gSancovCountsVmo;
+// The per-CPU shards, each gSancovShardStride counters apart.
+uint32_t* gSancovShards = nullptr;
+size_t gSancovShardStride = 0;
+
+// How often the shards are folded into gSancovPcCounts. This is frequent
+// enough that no 32-bit shard counter can overflow in between.
+constexpr zx_duration_mono_t kFoldInterval = ZX_SEC(1);
+
+KernelMappedVmo gSancovPcVmo, gSancovCountsVmo, gSancovShardsVmo;
+
+// Adds the per-CPU shard counts into gSancovPcCounts, resetting the shards.
+void FoldShards() {
+  for (uint cpu = 0; cpu < arch_max_num_cpus(); ++cpu) {
+    uint32_t* shard = gSancovShards + cpu * gSancovShardStride;
+    for (size_t i = 0; i < GuardsCount(); ++i) {
+      ktl::atomic_ref shard_count(shard[i]);
+      if (shard_count.load(ktl::memory_order_relaxed) == 0) {
+        continue;
+      }
+      // Only this thread writes the published counts once the shards exist.
+      ktl::atomic_ref count(gSancovPcCounts[i + 1]);
+      count.store(count.load(ktl::memory_order_relaxed) +
+                      shard_count.exchange(0, ktl::memory_order_relaxed),
+                  ktl::memory_order_relaxed);
+    }
+  }
+}
+
+int SancovFoldThread(void*) {
+  while (true) {
+    Thread::Current::SleepRelative(kFoldInterval);
+    FoldShards();
+  }
+  return 0;
+}
 
 void InitSancov(uint level) {
   fbl::RefPtr<VmObjectPaged> vmo;
@@ -97,6 +142,15 @@ void InitSancov(uint level) {
   gSancovPcTable[0] = kMagic64;
   gSancovPcCounts[0] = kCountsMagic;
 
+  // Each CPU's shard starts on its own page so that no cache lines are shared.
+  gSancovShardStride = ROUNDUP_PAGE_SIZE(GuardsCount() * sizeof(uint32_t)) / sizeof(uint32_t);
+  const size_t shards_size = gSancovShardStride * sizeof(uint32_t) * arch_max_num_cpus();
+  status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0, shards_size, &vmo);
+  ZX_ASSERT(status == ZX_OK);
+  status = gSancovShardsVmo.Init(ktl::move(vmo), 0, shards_size, "sancov-pc-count-shards");
+  ZX_ASSERT(status == ZX_OK);
+  gSancovShards = reinterpret_cast<uint32_t*>(gSancovShardsVmo.base_locking());
+
   // Move the counts accumulated in the guard slots into their proper places,
   // and reset the guards.
   for (size_t i = 0; i < GuardsCount(); ++i) {
@@ -112,6 +166,14 @@ void InitSancov(uint level) {
 // kernel is still running only in the initial thread on the boot CPU.
 LK_INIT_HOOK(InitSancov, InitSancov, LK_INIT_LEVEL_KERNEL)
 
+void StartSancovFolding(uint level) {
+  Thread* thread = Thread::Create("sancov-fold", SancovFoldThread, nullptr, LOW_PRIORITY);
+  ZX_ASSERT(thread);
+  thread->DetachAndResume();
+}
+
+LK_INIT_HOOK(StartSancovFolding, StartSancovFolding, LK_INIT_LEVEL_LAST)
+
 }  // namespace
 
 extern "C" {
@@ -133,15 +195,15 @@ void __sanitizer_cov_trace_pc_guard(uint32_t* guard_ptr) {
   // but the first slot in each of those is reserved for the magic number.
   const size_t idx = guard_ptr - __start___sancov_guards + 1;
 
-  if (!gSancovPcCounts) [[unlikely]] {
+  if (!gSancovShards) [[unlikely]] {
     // Pre-initialization, just count the hit in the guard slot.  See above.
     ++*guard_ptr;
     return;
   }
 
-  // Every time through, increment the counter.
-  ktl::atomic_ref count(gSancovPcCounts[idx]);
-  count.fetch_add(1, ktl::memory_order_relaxed);
+  // Every time through, increment this CPU's counter.  See above.
+  ktl::atomic_ref count(gSancovShards[arch_curr_cpu_num() * gSancovShardStride + idx - 1]);
+  count.store(count.load(ktl::memory_order_relaxed) + 1, ktl::memory_order_relaxed);
 
   // Use the guard as a simple flag to indicate whether the PC has been stored.
   ktl::atomic_ref guard(*guard_ptr);
@@ -135,6 +135,37 @@ bool kasan_test_poison_heap_partial() {
   END_TEST;
 }
 
+// Make sure poison checks find a single poisoned granule anywhere in a large region, whose shadow
+// is scanned a word at a time.
+bool kasan_test_poison_large_region() {
+  BEGIN_TEST;
+
+  constexpr size_t kBufSz = 16 * PAGE_SIZE;
+  fbl::AllocChecker ac;
+  auto buf = ktl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[kBufSz]);
+  ASSERT(ac.check());
+  const uintptr_t base = reinterpret_cast<uintptr_t>(buf.get());
+  ASSERT_EQ(0UL, asan_region_is_poisoned(base, kBufSz));
+
+  constexpr size_t offsets[] = {1 << kAsanShift, 9 << kAsanShift, 1000 << kAsanShift,
+                                kBufSz - (1 << kAsanShift)};
+  for (size_t offset : offsets) {
+    asan_poison_shadow(base + offset, 1 << kAsanShift, kAsanHeapLeftRedzoneMagic);
+    EXPECT_EQ(base + offset, asan_region_is_poisoned(base, kBufSz));
+    asan_unpoison_shadow(base + offset, 1 << kAsanShift);
+    EXPECT_EQ(0UL, asan_region_is_poisoned(base, kBufSz));
+  }
+
+  asan_poison_shadow(base, kBufSz, kAsanHeapLeftRedzoneMagic);
+  EXPECT_TRUE(asan_entire_region_is_poisoned(base, kBufSz));
+  asan_unpoison_shadow(base + 3, 1);
+  EXPECT_FALSE(asan_entire_region_is_poisoned(base, kBufSz));
+  asan_unpoison_shadow(base, kBufSz);
+  EXPECT_EQ(0UL, asan_region_is_poisoned(base, kBufSz));
+
+  END_TEST;
+}
+
 bool kasan_test_poison_unaligned_offsets() {
   BEGIN_TEST;
 
@@ -319,6 +350,7 @@ UNITTEST("free_poisons", kasan_test_free_poisons)
 UNITTEST("detects_buffer_overflows", kasan_test_detects_buffer_overflows)
 UNITTEST("test_poisoning_heap", kasan_test_poison_heap)
 UNITTEST("test_poisoning_heap_partial", kasan_test_poison_heap_partial)
+UNITTEST("test_poisoning_large_region", kasan_test_poison_large_region)
 UNITTEST("test_quarantine", kasan_test_quarantine)
 UNITTEST("test_walk_shadow", kasan_test_walk_shadow)
 UNITTEST("test_asan_map_shadow_for", kasan_test_map_shadow_for)
@@ -12,6 +12,7 @@
 #include <platform.h>
 #include <zircon/time.h>
 
+#include <arch/defines.h>
 #include <arch/ops.h>
 #include <fbl/canary.h>
 #include <kernel/auto_preempt_disabler.h>
@@ -164,9 +165,14 @@ class JTrace {
 
     // Record the fact that there is now a trace operation in progress, making
     // sure that we remember to decrement this count when we exit this method.
-    trace_ops_in_flight_.fetch_add(1, ktl::memory_order_acq_rel);
+    // The count is kept per-CPU so that tracing on many CPUs at once does not
+    // bounce a single cache line around.  We may migrate before decrementing,
+    // which is fine, as only the sum over all CPUs is meaningful.
+    ktl::atomic<int32_t>& in_flight =
+        trace_ops_in_flight_[arch_curr_cpu_num() % ktl::size(trace_ops_in_flight_)].count;
+    in_flight.fetch_add(1, ktl::memory_order_acq_rel);
     auto cleanup =
-        fit::defer([this]() { trace_ops_in_flight_.fetch_add(-1, ktl::memory_order_acq_rel); });
+        fit::defer([&in_flight]() { in_flight.fetch_sub(1, ktl::memory_order_acq_rel); });
 
     // Try to reserve a slot to write a record into.  This should only fail if
     // the tracing is temporarily disabled for dumping.
@@ -258,8 +264,7 @@ class JTrace {
     const affine::Ratio ticks_to_time_ratio = timer_get_ticks_to_time_ratio();
     const zx_instant_boot_ticks_t deadline =
         zx_ticks_add_ticks(current_boot_ticks(), ticks_to_time_ratio.Inverse().Scale(timeout));
-    while ((trace_ops_in_flight_.load(ktl::memory_order_acquire) > 0) &&
-           (current_boot_ticks() < deadline)) {
+    while ((TraceOpsInFlight() > 0) && (current_boot_ticks() < deadline)) {
       // just spin while we wait.
       arch::Yield();
     }
@@ -308,6 +313,14 @@ class JTrace {
 
   inline Header* hdr() { return reinterpret_cast<Header*>(storage_.data()); }
 
+  int32_t TraceOpsInFlight() const {
+    int32_t total = 0;
+    for (const InFlightCount& c : trace_ops_in_flight_) {
+      total += c.count.load(ktl::memory_order_acquire);
+    }
+    return total;
+  }
+
   ktl::optional<uint32_t> ReserveSlot() {
     uint32_t wr, next_wr;
     do {
@@ -437,7 +450,10 @@ class JTrace {
   TraceHooks& hooks_;
   ktl::span<uint8_t> storage_{};
   uint32_t entry_cnt_{0};
-  ktl::atomic<uint32_t> trace_ops_in_flight_{0};
+  struct alignas(MAX_CACHE_LINE) InFlightCount {
+    ktl::atomic<int32_t> count{0};
+  };
+  InFlightCount trace_ops_in_flight_[SMP_MAX_CPUS];
   bool after_thread_init_early_ = false;
   alignas(Header) uint8_t recovered_buf_[kRecoveryBufferSize];
 };
@@ -74,7 +74,7 @@ class ChainLockTransaction
   struct StateSaver;
 
   // State used by concurrent::ChainLock to store contended lock state for backoff mitigation.
-  using ContentionState = ktl::atomic<cpu_mask_t>;
+  using ContentionState = AtomicCpuMask;
 
  private:
   using Base = ::concurrent::ChainLockTransaction<ChainLockTransaction, kCltDebugChecksEnabled,
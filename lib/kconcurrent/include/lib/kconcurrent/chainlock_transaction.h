@@ -87,7 +87,7 @@ inline void ChainLockTransaction::ReleaseAndNotify(ContentionState& contention_s
                                                    Callable&& do_release) {
   // Sample the contention state before releasing the chainlock. The caller will ensure that
   // contention state will not be modified until after do_release is called.
-  cpu_mask_t wake_mask = contention_state.exchange(0, ktl::memory_order_acq_rel);
+  cpu_mask_t wake_mask = contention_state.exchange({}, ktl::memory_order_acq_rel);
 
   // Perform the actual chainlock release operation, allowing contenders to attempt to acquire the
   // lock. The contention state MUST NOT be accessed after the release to avoid use-after-free
@@ -95,10 +95,9 @@ inline void ChainLockTransaction::ReleaseAndNotify(ContentionState& contention_s
   ktl::invoke(do_release);
 
   // Use the sampled contention state to poke any backed-off contenders.
-  for (cpu_num_t cpu = 0; wake_mask; ++cpu, wake_mask >>= 1) {
-    if (wake_mask & 1) {
-      percpu::Get(cpu).chain_lock_conflict_id.fetch_add(1, ktl::memory_order_release);
-    }
+  cpu_num_t cpu;
+  while ((cpu = remove_cpu_from_mask(wake_mask)) != INVALID_CPU) {
+    percpu::Get(cpu).chain_lock_conflict_id.fetch_add(1, ktl::memory_order_release);
   }
 }
 
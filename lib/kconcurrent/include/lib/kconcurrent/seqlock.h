@@ -222,4 +222,83 @@ LOCK_DEP_POLICY_OPTION(SeqLock<::concurrent::SyncOpt::Fence>, SharedNoIrqSave,
 template <typename T, typename LockDepWrapper>
 using SeqLockPayload = ::concurrent::SeqLockPayload<T, typename LockDepWrapper::LockType>;
 
+// SeqLockedValue<T> bundles a SeqLock together with a single payload of type T
+// for read-mostly state which used to be protected by a mutex or spinlock.
+//
+// Readers never block writers and never write to shared cache lines.  They
+// copy the payload out using the well defined copy routines from
+// <lib/kconcurrent/copy.h> and simply retry if a writer was active during the
+// copy, so they may be called from any context, including IRQ context.
+//
+// Writers are serialized against each other and run with interrupts disabled
+// so that a reader spinning on the same CPU can never be stuck behind a
+// preempted write.  Keep updates short.
+//
+// T must be trivially copyable; multi-word structs are fine.
+//
+// ```
+// struct Params { uint64_t a; uint64_t b; };
+// SeqLockedValue<Params> params;
+//
+// params.Update({1, 2});
+// Params snapshot = params.Read();
+// params.Modify([](Params& p) { ++p.a; });
+// ```
+//
+// This helper is not instrumented with lockdep.  Users which need to compose a
+// read transaction with other reads, or need lockdep coverage, should declare
+// their SeqLock with DECLARE_SEQLOCK and use SeqLockPayload directly.
+template <typename T, ::concurrent::SyncOpt kSyncOpt = ::concurrent::SyncOpt::AcqRelOps>
+class SeqLockedValue {
+ public:
+  SeqLockedValue() = default;
+  explicit SeqLockedValue(const T& initial) : payload_(initial) {}
+
+  SeqLockedValue(const SeqLockedValue&) = delete;
+  SeqLockedValue& operator=(const SeqLockedValue&) = delete;
+
+  // Return a consistent snapshot of the payload.
+  T Read() const {
+    T ret;
+    Read(ret);
+    return ret;
+  }
+
+  void Read(T& out) const {
+    bool transaction_success;
+    do {
+      typename LockType::ReadTransactionToken token = lock_.BeginReadTransaction();
+      payload_.Read(out);
+      transaction_success = lock_.EndReadTransaction(token);
+    } while (!transaction_success);
+  }
+
+  // Replace the payload.
+  void Update(const T& val) {
+    Modify([&val](T& payload) { payload = val; });
+  }
+
+  // Atomically (with respect to other writers) read, modify, and re-publish
+  // the payload.  |func| is called with interrupts disabled and must not block.
+  template <typename Func>
+  void Modify(Func func) {
+    interrupt_saved_state_t interrupt_state = arch_interrupt_save();
+    lock_.Acquire();
+    // We hold the lock exclusively, so no other thread can be writing the
+    // payload while we copy it out.
+    T local;
+    payload_.Read(local);
+    func(local);
+    payload_.Update(local);
+    lock_.Release();
+    arch_interrupt_restore(interrupt_state);
+  }
+
+ private:
+  using LockType = SeqLock<kSyncOpt>;
+
+  mutable LockType lock_;
+  ::concurrent::SeqLockPayload<T, LockType> payload_ TA_GUARDED(lock_){};
+};
+
 #endif  // ZIRCON_KERNEL_LIB_KCONCURRENT_INCLUDE_LIB_KCONCURRENT_SEQLOCK_H_
@@ -44,17 +44,17 @@ class CurrentCpuPinner {
   ~CurrentCpuPinner() { ReleasePin(); }
 
   void ReleasePin() {
-    if (pin_mask_ != 0) {
+    if (pin_mask_.any()) {
       Thread::Current::Get()->SetCpuAffinity(prev_affinity_);
-      pin_mask_ = 0;
+      pin_mask_ = {};
     }
   }
 
   cpu_mask_t other_cpus_mask() const { return ~pin_mask_; }
 
  private:
-  cpu_mask_t prev_affinity_{0};
-  cpu_mask_t pin_mask_{0};
+  cpu_mask_t prev_affinity_{};
+  cpu_mask_t pin_mask_{};
 };
 
 template <typename LockPolicy, SyncOpt kSyncOpt>
@@ -210,8 +210,8 @@ struct Test {
     // simply no way with a runtime unit-test to _prove_ that exclusion will occur
     // until the lock is released.
     //
-    if (uint32_t cpus_online = ktl::popcount(mp_get_online_mask()); cpus_online < 2) {
-      printf("Skipping Contested %s SeqLock test.  There is only %u CPU online\n",
+    if (size_t cpus_online = mp_get_online_mask().count(); cpus_online < 2) {
+      printf("Skipping Contested %s SeqLock test.  There is only %zu CPU online\n",
              SharedTest ? "Read" : "Write", cpus_online);
     } else {
       enum class State : uint32_t {
@@ -326,6 +326,40 @@ using TestAcqRel = Test<LockPolicy, SyncOpt::AcqRelOps>;
 
 template <typename LockPolicy>
 using TestFence = Test<LockPolicy, SyncOpt::Fence>;
+
+template <SyncOpt kSyncOpt>
+bool SeqLockedValueTest() {
+  BEGIN_TEST;
+
+  struct Payload {
+    uint64_t a;
+    uint64_t b;
+    uint32_t c;
+  };
+
+  SeqLockedValue<Payload, kSyncOpt> value{Payload{1, 2, 3}};
+  Payload snapshot = value.Read();
+  EXPECT_EQ(1u, snapshot.a);
+  EXPECT_EQ(2u, snapshot.b);
+  EXPECT_EQ(3u, snapshot.c);
+
+  value.Update(Payload{4, 5, 6});
+  value.Read(snapshot);
+  EXPECT_EQ(4u, snapshot.a);
+  EXPECT_EQ(5u, snapshot.b);
+  EXPECT_EQ(6u, snapshot.c);
+
+  value.Modify([](Payload& p) {
+    EXPECT_TRUE(arch_ints_disabled());
+    p.b += 10;
+  });
+  snapshot = value.Read();
+  EXPECT_EQ(4u, snapshot.a);
+  EXPECT_EQ(15u, snapshot.b);
+  EXPECT_EQ(6u, snapshot.c);
+
+  END_TEST;
+}
 }  // namespace
 
 UNITTEST_START_TESTCASE(seqlock_tests)
@@ -346,4 +380,7 @@ UNITTEST("ContestedRead<IrqSave, Fence>", TestFence<SharedIrqSave>::ContestedTes
 UNITTEST("ContestedRead<NoIrqSave, Fence>", TestFence<SharedNoIrqSave>::ContestedTest)
 UNITTEST("ContestedWrite<IrqSave, Fence>", TestFence<ExclusiveIrqSave>::ContestedTest)
 UNITTEST("ContestedWrite<NoIrqSave, Fence>", TestFence<ExclusiveNoIrqSave>::ContestedTest)
+
+UNITTEST("SeqLockedValue<AcqRel>", SeqLockedValueTest<SyncOpt::AcqRelOps>)
+UNITTEST("SeqLockedValue<Fence>", SeqLockedValueTest<SyncOpt::Fence>)
 UNITTEST_END_TESTCASE(seqlock_tests, "seqlock", "SeqLock Guard Tests")
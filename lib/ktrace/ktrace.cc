@@ -24,6 +24,7 @@
 #include <hypervisor/ktrace.h>
 #include <kernel/koid.h>
 #include <kernel/mp.h>
+#include <ktl/algorithm.h>
 #include <ktl/atomic.h>
 #include <ktl/iterator.h>
 #include <lk/init.h>
@@ -167,6 +168,8 @@ void KTrace::ReportMetadata() {
 
     // Emit the magic and initialization records.
     KTrace* ktrace = static_cast<KTrace*>(arg);
+    PerCpuBuffer& buffer = ktrace->percpu_buffers_[arch_curr_cpu_num()];
+    const uint32_t mark = buffer.WriteMark();
     zx_status_t status = fxt::WriteMagicNumberRecord(ktrace);
     DEBUG_ASSERT(status == ZX_OK);
     status = fxt::WriteInitializationRecord(ktrace, ticks_per_second());
@@ -188,6 +191,12 @@ void KTrace::ReportMetadata() {
                                    ZX_OBJ_TYPE_THREAD, fxt::StringRef{name},
                                    fxt::Argument{"process"_intern, kNoProcess});
     }
+
+    // A circular trace reports its metadata when it is stopped, after the records that need it.
+    // Move the metadata to the front of the buffer so that it is read first.
+    if (ktrace->circular_.load(ktl::memory_order_relaxed)) {
+      buffer.RotateToFront(mark);
+    }
   };
   const cpu_mask_t target_mask = cpu_num_to_mask(BOOT_CPU_ID);
   mp_sync_exec(mp_ipi_target::MASK, target_mask, emit_starting_records, &GetInstance());
@@ -200,7 +209,7 @@ void KTrace::ReportMetadata() {
   ktrace_report_live_threads();
 }
 
-zx_status_t KTrace::Start(uint32_t, uint32_t categories) {
+zx_status_t KTrace::Start(uint32_t action, uint32_t categories) {
   // Allocate the buffers. This will be a no-op if the buffers are already initialized.
   if (zx_status_t status = Allocate(); status != ZX_OK) {
     return status;
@@ -213,14 +222,23 @@ zx_status_t KTrace::Start(uint32_t, uint32_t categories) {
     return ZX_OK;
   }
 
-  // Otherwise, enable writes.
+  // Otherwise, select the buffer mode and enable writes. The release store in EnableWrites
+  // publishes the mode to the writers.
+  const bool circular = action == KTRACE_ACTION_START_CIRCULAR;
+  circular_.store(circular, ktl::memory_order_relaxed);
+  for (uint32_t i = 0; i < num_buffers_; i++) {
+    percpu_buffers_[i].set_overwrite(circular);
+  }
   EnableWrites();
 
   // Report static metadata before setting the categories bitmask.
   // These metadata records must be emitted before we enable arbitrary categories, otherwise generic
   // trace records may fill up the buffer and cause these metadata records to be dropped, which
-  // could make the trace unreadable.
-  ReportMetadata();
+  // could make the trace unreadable. A circular trace would overwrite them instead, so it reports
+  // them when it is stopped.
+  if (!circular) {
+    ReportMetadata();
+  }
 
   set_categories_bitmask(categories);
   DiagsPrintf(INFO, "Enabled category mask: 0x%03x\n", categories);
@@ -233,7 +251,7 @@ zx_status_t KTrace::Start(uint32_t, uint32_t categories) {
   return ZX_OK;
 }
 
-void KTrace::Init(uint32_t bufsize, uint32_t initial_grpmask) {
+void KTrace::Init(uint32_t bufsize, uint32_t initial_grpmask, bool circular) {
   Guard<Mutex> guard{&lock_};
 
   ASSERT_MSG(buffer_size_ == 0, "KTrace::Init called twice");
@@ -252,7 +270,7 @@ void KTrace::Init(uint32_t bufsize, uint32_t initial_grpmask) {
     return;
   }
   // Otherwise, begin tracing immediately.
-  Start(KTRACE_ACTION_START, initial_grpmask);
+  Start(circular ? KTRACE_ACTION_START_CIRCULAR : KTRACE_ACTION_START, initial_grpmask);
 }
 
 zx_status_t KTrace::Stop() {
@@ -263,6 +281,14 @@ zx_status_t KTrace::Stop() {
 
   // Clear the categories bitmask and disable writes. This prevents any new writes from starting.
   set_categories_bitmask(0u);
+
+  // A circular trace has overwritten the metadata reported at start, if any, so report it now
+  // while writes are still enabled. Only the records emitted through ReportMetadata are written
+  // after the categories bitmask is cleared, and their buffers make room by discarding the oldest
+  // trace records.
+  if (circular_.load(ktl::memory_order_relaxed) && WritesEnabled()) {
+    ReportMetadata();
+  }
   DisableWrites();
 
   // Wait for any in-progress writes to complete and emit any dropped record statistics.
@@ -281,7 +307,7 @@ zx_status_t KTrace::Stop() {
     // do about that.
     curr_cpu_buffer.EmitDropStats();
   };
-  mp_sync_exec(mp_ipi_target::ALL, 0, emit_drop_stats, percpu_buffers_.get());
+  mp_sync_exec(mp_ipi_target::ALL, {}, emit_drop_stats, percpu_buffers_.get());
   return ZX_OK;
 }
 
@@ -309,7 +335,7 @@ zx_status_t KTrace::Rewind() {
     curr_cpu_buffer.Drain();
     curr_cpu_buffer.ResetDropStats();
   };
-  mp_sync_exec(mp_ipi_target::ALL, 0, run_drain, percpu_buffers_.get());
+  mp_sync_exec(mp_ipi_target::ALL, {}, run_drain, percpu_buffers_.get());
   return ZX_OK;
 }
 
@@ -328,33 +354,48 @@ zx::result<size_t> KTrace::ReadUser(user_out_ptr<void> ptr, uint32_t offset, siz
     return zx::ok(0);
   }
 
+  // Writers of a circular trace advance the read pointer to overwrite old records, so reading
+  // concurrently with them would break the single reader invariant of the per-CPU buffers.
+  if (circular_.load(ktl::memory_order_relaxed) && WritesEnabled()) {
+    return zx::error(ZX_ERR_BAD_STATE);
+  }
+
   // Eventually, this should support users passing in buffers smaller than the sum of the size of
   // all per-CPU buffers, but for now we do not allow this.
   if (len < (buffer_size_ * num_buffers_)) {
     return zx::error(ZX_ERR_INVALID_ARGS);
   }
 
-  // Iterate through each per-CPU buffer and read its contents.
-  size_t bytes_read = 0;
+  // Determine how much data there is to read across all of the per-CPU buffers. Writers may add
+  // more while we read, which is fine; this only sizes the soft fault below.
+  size_t bytes_available = 0;
+  for (uint32_t i = 0; i < num_buffers_; i++) {
+    bytes_available += percpu_buffers_[i].AvailableData();
+  }
+  if (bytes_available == 0) {
+    return zx::ok(0);
+  }
+
+  // This is safe to do while holding the lock_ because the KTrace lock is a leaf lock that is
+  // not acquired during the course of a page fault.
+  //
+  // Prepare the whole destination range up front, coalescing the potential page faults of every
+  // segment copied below into a single bulk operation. Any data written after this point is
+  // copied with ordinary page faults.
   user_out_ptr<ktl::byte> byte_ptr = ptr.reinterpret<ktl::byte>();
+  guard.CallUntracked([&]() {
+    Thread::Current::SoftFaultInRange(reinterpret_cast<vaddr_t>(byte_ptr.get()),
+                                      VMM_PF_FLAG_USER | VMM_PF_FLAG_WRITE,
+                                      ktl::min(bytes_available, len));
+  });
 
+  // Iterate through each per-CPU buffer and read its contents.
+  size_t bytes_read = 0;
   auto copy_fn = [&](uint32_t byte_offset, ktl::span<ktl::byte> src) {
-    // This is safe to do while holding the lock_ because the KTrace lock is a leaf lock that is
-    // not acquired during the course of a page fault.
     zx_status_t status = ZX_ERR_BAD_STATE;
     guard.CallUntracked([&]() {
-      // Compute the destination address for this segment.
-      user_out_ptr out_ptr = byte_ptr.byte_offset(bytes_read + byte_offset);
-
-      // Prepare the destination range of this segment to improve efficiency by
-      // coalescing potential page faults into a bulk operation.
-      // TODO(eieio): This could be improved further by restructuring the copy
-      // out operation so that the full destination range can be determined and
-      // soft-faulted in a single operation.
-      Thread::Current::SoftFaultInRange(reinterpret_cast<vaddr_t>(out_ptr.get()),
-                                        VMM_PF_FLAG_USER | VMM_PF_FLAG_WRITE, src.size());
-
       // Copy the trace data to the user segment.
+      user_out_ptr out_ptr = byte_ptr.byte_offset(bytes_read + byte_offset);
       status = out_ptr.copy_array_to_user(src.data(), src.size());
     });
 
@@ -381,8 +422,10 @@ zx::result<size_t> KTrace::ReadUser(user_out_ptr<void> ptr, uint32_t offset, siz
 void KTrace::InitHook(unsigned) {
   const uint32_t bufsize = gBootOptions->ktrace_bufsize << 20;
   const uint32_t initial_grpmask = gBootOptions->ktrace_grpmask;
+  const bool circular = gBootOptions->ktrace_circular;
 
-  dprintf(INFO, "ktrace_init: bufsize=%u grpmask=%x\n", bufsize, initial_grpmask);
+  dprintf(INFO, "ktrace_init: bufsize=%u grpmask=%x circular=%d\n", bufsize, initial_grpmask,
+          circular);
 
   if (!bufsize) {
     dprintf(INFO, "ktrace: disabled\n");
@@ -403,7 +446,7 @@ void KTrace::InitHook(unsigned) {
   }
 
   // Initialize the singleton data structures.
-  GetInstance().Init(bufsize, initial_grpmask);
+  GetInstance().Init(bufsize, initial_grpmask, circular);
 }
 
 // Finish initialization before starting userspace (i.e. before debug syscalls can occur).
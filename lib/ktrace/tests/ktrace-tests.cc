@@ -361,6 +361,83 @@ class KTraceTests {
     END_TEST;
   }
 
+  // Test that a circular trace overwrites its oldest records, can be frozen, and can only be read
+  // once stopped.
+  static bool TestCircular() {
+    BEGIN_TEST;
+
+    TestKTrace ktrace;
+    const uint32_t num_cpus = arch_max_num_cpus();
+    const uint32_t total_bufsize = PAGE_SIZE * num_cpus;
+    ktrace.Init(total_bufsize, 0u);
+
+    // Start a circular trace, which defers reporting metadata until it is stopped.
+    ASSERT_OK(ktrace.Control(KTRACE_ACTION_START_CIRCULAR, 0xfff));
+    ASSERT_TRUE(ktrace.WritesEnabled());
+    ASSERT_EQ(0xfffu, ktrace.categories_bitmask());
+    ASSERT_EQ(0u, ktrace.report_metadata_count());
+
+    // Write more records than fit in a per-CPU buffer, each tagged with its index.
+    constexpr uint32_t kRecordSize = PAGE_SIZE / 4;
+    constexpr uint32_t kNumRecords = 6;
+    constexpr uint64_t fxt_header =
+        fxt::MakeHeader(fxt::RecordType::kBlob, fxt::WordSize::FromBytes(kRecordSize));
+    const cpu_num_t target_cpu = [&]() {
+      InterruptDisableGuard guard;
+      for (uint64_t i = 0; i < kNumRecords; i++) {
+        zx::result<TestKTrace::Reservation> res = ktrace.Reserve(fxt_header);
+        DEBUG_ASSERT(res.is_ok());
+        res->WriteWord(i);
+        for (uint32_t j = 2; j < kRecordSize / sizeof(uint64_t); j++) {
+          res->WriteWord(0);
+        }
+        res->Commit();
+      }
+      return arch_curr_cpu_num();
+    }();
+
+    // Freezing stops new records, but the trace cannot be read until it is stopped.
+    ktrace.FreezeFlightRecorder();
+    ASSERT_EQ(0u, ktrace.categories_bitmask());
+    ASSERT_TRUE(ktrace.WritesEnabled());
+    using testing::UserMemory;
+    ktl::unique_ptr<UserMemory> user_mem = UserMemory::Create(total_bufsize);
+    zx::result<size_t> result = ktrace.ReadUser(user_mem->user_out<void>(), 0, total_bufsize);
+    ASSERT_EQ(ZX_ERR_BAD_STATE, result.status_value());
+
+    // Stopping reports the metadata and allows the trace to be read.
+    ASSERT_OK(ktrace.Control(KTRACE_ACTION_STOP, 0));
+    ASSERT_FALSE(ktrace.WritesEnabled());
+    ASSERT_EQ(1u, ktrace.report_metadata_count());
+
+    // Only the most recent records that fit remain in the buffer.
+    uint64_t record[kRecordSize / sizeof(uint64_t)];
+    auto copy_out = [&](uint32_t offset, ktl::span<ktl::byte> src) {
+      memcpy(reinterpret_cast<ktl::byte*>(record) + offset, src.data(), src.size());
+      return ZX_OK;
+    };
+    constexpr uint32_t kRecordsPerBuffer = PAGE_SIZE / kRecordSize;
+    for (uint64_t i = kNumRecords - kRecordsPerBuffer; i < kNumRecords; i++) {
+      zx::result<size_t> read_result =
+          ktrace.percpu_buffers_[target_cpu].Read(copy_out, kRecordSize);
+      ASSERT_OK(read_result.status_value());
+      ASSERT_EQ(kRecordSize, read_result.value());
+      EXPECT_EQ(fxt_header, record[0]);
+      EXPECT_EQ(i, record[1]);
+    }
+    result = ktrace.percpu_buffers_[target_cpu].Read(copy_out, kRecordSize);
+    ASSERT_OK(result.status_value());
+    ASSERT_EQ(0u, result.value());
+
+    // Freezing a trace that is not circular does nothing.
+    ASSERT_OK(ktrace.Control(KTRACE_ACTION_START, 0xff));
+    ktrace.FreezeFlightRecorder();
+    ASSERT_EQ(0xffu, ktrace.categories_bitmask());
+    ASSERT_OK(ktrace.Control(KTRACE_ACTION_STOP, 0));
+
+    END_TEST;
+  }
+
   static bool TestDroppedRecordTracking() {
     BEGIN_TEST;
 
@@ -563,4 +640,5 @@ UNITTEST("write", KTraceTests::TestWrite)
 UNITTEST("rewind", KTraceTests::TestRewind)
 UNITTEST("read_user", KTraceTests::TestReadUser)
 UNITTEST("dropped_records", KTraceTests::TestDroppedRecordTracking)
+UNITTEST("circular", KTraceTests::TestCircular)
 UNITTEST_END_TESTCASE(ktrace_tests, "ktrace", "KTrace tests")
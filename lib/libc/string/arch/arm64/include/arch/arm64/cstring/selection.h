@@ -0,0 +1,35 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_LIB_LIBC_STRING_ARCH_ARM64_INCLUDE_ARCH_ARM64_CSTRING_SELECTION_H_
+#define ZIRCON_KERNEL_LIB_LIBC_STRING_ARCH_ARM64_INCLUDE_ARCH_ARM64_CSTRING_SELECTION_H_
+
+#include <lib/arch/arm64/feature.h>
+
+#include <string_view>
+
+// Whether the FEAT_MOPS memory copy and memory set instructions are implemented.
+inline bool Arm64HasMops(const arch::ArmIdAa64IsaR2El1& isar2) {
+  return isar2.mops() != arch::ArmIdAa64IsaR2El1::Mops::kNone;
+}
+
+// Returns the appropriate code patching alternative of `memcpy()`.
+inline std::string_view SelectArm64MemcpyAlternative(const arch::ArmIdAa64IsaR2El1& isar2) {
+  if (Arm64HasMops(isar2)) {
+    return "memcpy_mops";
+  }
+  return "memcpy_cortex";
+}
+
+// Returns the appropriate code patching alternative of `memset()`.
+inline std::string_view SelectArm64MemsetAlternative(const arch::ArmIdAa64IsaR2El1& isar2) {
+  if (Arm64HasMops(isar2)) {
+    return "memset_mops";
+  }
+  return "memset_cortex";
+}
+
+#endif  // ZIRCON_KERNEL_LIB_LIBC_STRING_ARCH_ARM64_INCLUDE_ARCH_ARM64_CSTRING_SELECTION_H_
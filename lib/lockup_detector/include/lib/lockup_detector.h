@@ -83,6 +83,22 @@ void lockup_timed_begin(const char* name);
 // Same as lockup_end except the critical section is timed.
 void lockup_timed_end();
 
+// Returns true if kernel.lockup-detector.section-histograms is enabled, in which case preempt
+// disabled sections are reported with the functions below.
+inline bool lockup_section_histograms_enabled() {
+  return lockup_internal::gSectionHistogramsEnabled;
+}
+
+// Returns the time (tick count) at which an outermost preempt disabled section began, to be passed
+// to |lockup_preempt_disabled_end| when it ends.
+zx_instant_boot_ticks_t lockup_preempt_disabled_begin();
+
+// Records a preempt disabled section that began at |begin_ticks|, which may be 0 if the section
+// began before the histograms were enabled.
+//
+// Must be called with preemption disabled.
+void lockup_preempt_disabled_end(zx_instant_boot_ticks_t begin_ticks);
+
 // Returns the number of times a "critical section threshold exceeded" oops was triggered.
 int64_t lockup_get_critical_section_oops_count();
 
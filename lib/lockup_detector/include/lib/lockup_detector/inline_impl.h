@@ -18,6 +18,13 @@
 
 namespace lockup_internal {
 
+// True when kernel.lockup-detector.section-histograms is enabled.  Set once by lockup_init.
+extern bool gSectionHistogramsEnabled;
+
+// Record the beginning and end of the outermost critical section in the section histograms.
+void SectionBegin(LockupDetectorState& state);
+void SectionEnd(LockupDetectorState& state);
+
 // Enter a critical section.
 //
 // Returns true if this is the outermost critical section.
@@ -94,12 +101,18 @@ inline void lockup_begin(const char* name) {
     // CriticalSectionLockupChecker may see stale name values because there is
     // nothing for them to synchronize-with.
     cs_state.name.store(name, ktl::memory_order_relaxed);
+    if (unlikely(lockup_internal::gSectionHistogramsEnabled)) {
+      lockup_internal::SectionBegin(state);
+    }
   }
 }
 
 inline void lockup_end() {
   LockupDetectorState& state = gLockupDetectorPerCpuState[arch_curr_cpu_num()];
   lockup_internal::CallIfOuterAndLeave(state, [](LockupDetectorState& state) {
+    if (unlikely(lockup_internal::gSectionHistogramsEnabled)) {
+      lockup_internal::SectionEnd(state);
+    }
     auto& cs_state = state.critical_section;
     // See comment in lockup_begin at the point where name is stored.
     cs_state.name.store(nullptr, ktl::memory_order_relaxed);
@@ -8,6 +8,8 @@
 #define ZIRCON_KERNEL_LIB_LOCKUP_DETECTOR_INCLUDE_LIB_LOCKUP_DETECTOR_STATE_H_
 
 #include <align.h>
+#include <lib/backtrace.h>
+#include <zircon/types.h>
 
 #include <kernel/cpu.h>
 #include <kernel/event_limiter.h>
@@ -131,6 +133,37 @@ struct __CPU_ALIGN LockupDetectorState {
     // Accessed only by observers.
     EventLimiter<ZX_SEC(1)> worst_case_alert_limiter;
   } critical_section;
+
+  /////////////////////////////////////////////////////////////////////////////
+  //
+  // Per-cpu state used for the section duration histograms, enabled by
+  // kernel.lockup-detector.section-histograms.
+  //
+  /////////////////////////////////////////////////////////////////////////////
+
+  // The longest section of one kind recorded by this CPU, the name of the
+  // critical section (if any), and a backtrace taken as it ended.
+  //
+  // Written only by this CPU, when a new longest section ends.  Observers may
+  // see a partially updated record, which is tolerated since it is only used for
+  // diagnostics.
+  struct SectionWorstCase {
+    ktl::atomic<zx_duration_boot_ticks_t> ticks{0};
+    ktl::atomic<const char*> name{nullptr};
+    Backtrace backtrace;
+  };
+
+  struct {
+    // The time (tick count) at which the CPU entered its outermost critical
+    // section, or 0 if it is not in one or entered it before the histograms
+    // were enabled.
+    //
+    // Accessed only by this CPU.
+    zx_instant_boot_ticks_t begin_ticks{0};
+
+    SectionWorstCase critical_section_worst;
+    SectionWorstCase preempt_disabled_worst;
+  } sections;
 };
 
 extern LockupDetectorState gLockupDetectorPerCpuState[SMP_MAX_CPUS];
@@ -12,6 +12,7 @@
 #include <lib/console.h>
 #include <lib/counters.h>
 #include <lib/crashlog.h>
+#include <lib/ktrace.h>
 #include <lib/lockup_detector/diagnostics.h>
 #include <lib/lockup_detector/inline_impl.h>
 #include <lib/lockup_detector/state.h>
@@ -54,8 +55,19 @@ KCOUNTER(counter_lockup_cs_exceeding_100000ms,
 // Counts the number of times the lockup detector has emitted a "no heartbeat" oops.
 KCOUNTER(counter_lockup_no_heartbeat_oops, "lockup_detector.no_heartbeat_oops")
 
+// Histograms of the durations of outermost critical sections and of preempt disabled sections,
+// recorded when kernel.lockup-detector.section-histograms is enabled.
+KCOUNTER_HISTOGRAM(histogram_critical_section_ns, "lockup_detector.critical_section.duration_ns",
+                   10)
+KCOUNTER_HISTOGRAM(histogram_preempt_disabled_ns, "lockup_detector.preempt_disabled.duration_ns",
+                   10)
+
 LockupDetectorState gLockupDetectorPerCpuState[SMP_MAX_CPUS];
 
+namespace lockup_internal {
+bool gSectionHistogramsEnabled = false;
+}  // namespace lockup_internal
+
 namespace {
 
 inline zx_duration_boot_t TicksToDuration(zx_duration_boot_ticks_t ticks) {
@@ -258,6 +270,9 @@ void HeartbeatLockupChecker::PerformCheck(LockupDetectorState& state, cpu_num_t
     FILE* output_target =
         (severity == lockup_internal::FailureSeverity::Fatal) ? &stdout_panic_buffer : stdout;
 
+    // Preserve the trace of the activity leading up to the lockup, if a flight recorder is running.
+    KTrace::GetInstance().FreezeFlightRecorder();
+
     // Print an OOPS header so that we properly trigger tefmo checks, but only
     // send it to stdout.  If this a fatal failure, we don't want to waste any
     // bytes saying "OOPS" in the crashlog.  It should be pretty clear from the
@@ -318,6 +333,8 @@ void CriticalSectionLockupChecker::PerformCheck(LockupDetectorState& state, cpu_
       FILE* output_target =
           (severity == lockup_internal::FailureSeverity::Fatal) ? &stdout_panic_buffer : stdout;
 
+      KTrace::GetInstance().FreezeFlightRecorder();
+
       // See the comment in HeartbeatLockupChecker::PerformCheck for an explanation of why this
       // curious empty-string OOPS is here.
       KERNEL_OOPS("");
@@ -379,6 +396,31 @@ void CriticalSectionLockupChecker::PerformCheck(LockupDetectorState& state, cpu_
   }
 }
 
+// Records a section of |ticks| in |histogram|.  If it is the longest of its kind seen on this CPU,
+// also records it as the worst case, along with its |name| and a backtrace of where it ended.
+void RecordSection(const CounterHistogram& histogram, LockupDetectorState::SectionWorstCase& worst,
+                   zx_duration_boot_ticks_t ticks, const char* name) {
+  histogram.Add(TicksToDuration(ticks));
+  if (ticks > worst.ticks.load(ktl::memory_order_relaxed)) {
+    worst.ticks.store(ticks, ktl::memory_order_relaxed);
+    worst.name.store(name, ktl::memory_order_relaxed);
+    Thread::Current::GetBacktrace(worst.backtrace);
+  }
+}
+
+// Prints the worst case section recorded in |worst|, if any.
+void PrintSectionWorstCase(cpu_num_t cpu, const char* kind,
+                           const LockupDetectorState::SectionWorstCase& worst) {
+  const zx_duration_boot_ticks_t ticks = worst.ticks.load(ktl::memory_order_relaxed);
+  if (ticks == 0) {
+    return;
+  }
+  const char* name = worst.name.load(ktl::memory_order_relaxed);
+  printf("CPU-%u longest %s section %" PRId64 " uSec (%s), ended at:\n", cpu, kind,
+         TicksToDuration(ticks) / ZX_USEC(1), name != nullptr ? name : "unnamed");
+  worst.backtrace.PrintWithoutVersion();
+}
+
 // Return an absolute deadline |duration| nanoseconds from now with a jitter of +/- |percent|%.
 Deadline DeadlineWithJitterAfter(zx_duration_boot_t duration, uint32_t percent) {
   DEBUG_ASSERT(percent <= 100);
@@ -470,7 +512,9 @@ void stop_heartbeats() {
 // Start the process of recording heartbeats and checking in on other CPUs on
 // the current CPU.
 void start_heartbeats() {
-  if (HeartbeatLockupChecker::period() <= 0) {
+  // Isolated CPUs are kept free of periodic kernel timers, so they neither
+  // heartbeat nor check in on their peers.
+  if (HeartbeatLockupChecker::period() <= 0 || Scheduler::IsIsolatedCpu(arch_curr_cpu_num())) {
     stop_heartbeats();
     return;
   }
@@ -493,6 +537,9 @@ void lockup_init() {
   // Initialize parameters for the heartbeat checks.
   HeartbeatLockupChecker::InitStaticParams();
 
+  // The section histograms do not depend on the heartbeat mechanism.
+  lockup_internal::gSectionHistogramsEnabled = gBootOptions->lockup_detector_section_histograms;
+
   dprintf(INFO,
           "lockup_detector: heartbeats %s, period %" PRId64 " ms, threshold %" PRId64
           " ms, fatal threshold %" PRId64 " ms, diags dump timeout %" PRIu64 " ms\n",
@@ -558,6 +605,9 @@ void lockup_timed_begin(const char* name) {
     // store with release semantics will ensure the CriticalSectionLockupChecker
     // sees the latest value.
     cs_state.name.store(name, ktl::memory_order_relaxed);
+    if (unlikely(lockup_internal::gSectionHistogramsEnabled)) {
+      lockup_internal::SectionBegin(state);
+    }
     if (CriticalSectionLockupChecker::IsEnabled()) {
       const zx_instant_boot_ticks_t now = current_boot_ticks();
       // Use release semantics to ensure that if an observer sees this store to |begin_ticks|,
@@ -570,6 +620,10 @@ void lockup_timed_begin(const char* name) {
 void lockup_timed_end() {
   LockupDetectorState& state = gLockupDetectorPerCpuState[arch_curr_cpu_num()];
   lockup_internal::CallIfOuterAndLeave(state, [](LockupDetectorState& state) {
+    if (unlikely(lockup_internal::gSectionHistogramsEnabled)) {
+      lockup_internal::SectionEnd(state);
+    }
+
     // Is this a new worst for us?
     const zx_instant_boot_ticks_t now_ticks = current_boot_ticks();
     auto& cs_state = state.critical_section;
@@ -595,6 +649,32 @@ void lockup_timed_end() {
   });
 }
 
+void lockup_internal::SectionBegin(LockupDetectorState& state) {
+  state.sections.begin_ticks = current_boot_ticks();
+}
+
+void lockup_internal::SectionEnd(LockupDetectorState& state) {
+  const zx_instant_boot_ticks_t begin_ticks = state.sections.begin_ticks;
+  if (begin_ticks == 0) {
+    return;
+  }
+  state.sections.begin_ticks = 0;
+  RecordSection(histogram_critical_section_ns, state.sections.critical_section_worst,
+                zx_time_sub_time(current_boot_ticks(), begin_ticks),
+                state.critical_section.name.load(ktl::memory_order_relaxed));
+}
+
+zx_instant_boot_ticks_t lockup_preempt_disabled_begin() { return current_boot_ticks(); }
+
+void lockup_preempt_disabled_end(zx_instant_boot_ticks_t begin_ticks) {
+  if (begin_ticks == 0) {
+    return;
+  }
+  LockupDetectorState& state = gLockupDetectorPerCpuState[arch_curr_cpu_num()];
+  RecordSection(histogram_preempt_disabled_ns, state.sections.preempt_disabled_worst,
+                zx_time_sub_time(current_boot_ticks(), begin_ticks), nullptr);
+}
+
 int64_t lockup_get_critical_section_oops_count() {
   return counter_lockup_cs_count.SumAcrossAllCpus();
 }
@@ -634,6 +714,14 @@ void lockup_status() {
     }
   }
 
+  if (lockup_internal::gSectionHistogramsEnabled) {
+    for (cpu_num_t i = 0; i < percpu::processor_count(); i++) {
+      const auto& sections = gLockupDetectorPerCpuState[i].sections;
+      PrintSectionWorstCase(i, "critical", sections.critical_section_worst);
+      PrintSectionWorstCase(i, "preempt disabled", sections.preempt_disabled_worst);
+    }
+  }
+
   printf("heartbeat period is %" PRId64 " ms, heartbeat threshold is %" PRId64 " ms\n",
          HeartbeatLockupChecker::period() / ZX_MSEC(1),
          HeartbeatLockupChecker::threshold() / ZX_MSEC(1));
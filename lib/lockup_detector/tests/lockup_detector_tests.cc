@@ -9,8 +9,10 @@
 #include <lib/lockup_detector/diagnostics.h>
 #include <lib/unittest/unittest.h>
 
+#include <arch/interrupt.h>
 #include <kernel/auto_preempt_disabler.h>
 #include <kernel/percpu.h>
+#include <ktl/algorithm.h>
 #include <vm/vm.h>
 #include <vm/vm_address_region.h>
 #include <vm/vm_aspace.h>
@@ -112,6 +114,37 @@ bool NestedTimedCriticalSectionTest() {
   END_TEST;
 }
 
+bool SectionHistogramWorstCaseTest() {
+  BEGIN_TEST;
+
+  // Keep interrupt handlers from recording sections of their own on this CPU.
+  InterruptDisableGuard irqd;
+
+  auto& worst = gLockupDetectorPerCpuState[arch_curr_cpu_num()].sections.critical_section_worst;
+  auto cleanup = fit::defer([orig_enabled = lockup_internal::gSectionHistogramsEnabled,
+                             orig_ticks = worst.ticks.load(), &worst]() {
+    lockup_internal::gSectionHistogramsEnabled = orig_enabled;
+    worst.ticks.store(ktl::max(orig_ticks, worst.ticks.load()));
+  });
+  lockup_internal::gSectionHistogramsEnabled = true;
+  worst.ticks.store(0);
+
+  static constexpr const char kName[] = "SectionHistogramWorstCaseTest";
+  lockup_begin(kName);
+  const zx_instant_boot_t deadline = zx_time_add_duration(current_boot_time(), ZX_USEC(100));
+  while (current_boot_time() < deadline) {
+    arch::Yield();
+  }
+  lockup_end();
+
+  EXPECT_GT(worst.ticks.load(), 0);
+  EXPECT_EQ(kName, worst.name.load());
+  EXPECT_GT(worst.backtrace.size(), 0u);
+  EXPECT_EQ(0, gLockupDetectorPerCpuState[arch_curr_cpu_num()].sections.begin_ticks);
+
+  END_TEST;
+}
+
 bool GetBacktraceFromDapStateTest() {
   BEGIN_TEST;
 
@@ -307,5 +340,6 @@ bool GetBacktraceFromDapStateTest() {
 UNITTEST_START_TESTCASE(lockup_detetcor_tests)
 UNITTEST("nested_critical_section", NestedCriticalSectionTest)
 UNITTEST("nested_timed_critical_section", NestedTimedCriticalSectionTest)
+UNITTEST("section_histogram_worst_case", SectionHistogramWorstCaseTest)
 UNITTEST("get_backtrace_from_dap_state", GetBacktraceFromDapStateTest)
 UNITTEST_END_TESTCASE(lockup_detetcor_tests, "lockup_detector", "lockup_detector tests")
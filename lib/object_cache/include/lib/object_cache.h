@@ -324,6 +324,18 @@ class ObjectCache<T, Option::Single, Allocator> : private Allocator {
     return slab_count_;
   }
 
+  // Releases every empty slab, including those retained by the reserve.
+  // Returns the number of slabs released.
+  size_t Trim() TA_EXCL(lock_) {
+    Guard<Mutex> guard{&lock_};
+    size_t count = 0;
+    while (!empty_list_.is_empty()) {
+      RemoveSlab(&empty_list_.front());
+      count++;
+    }
+    return count;
+  }
+
   static constexpr size_t objects_per_slab() { return kEntriesPerSlab; }
   static constexpr size_t slab_control_size() { return kSlabControlSize; }
   static constexpr size_t entry_size() { return sizeof(Entry); }
@@ -780,6 +792,16 @@ class ObjectCache<T, Option::PerCpu, Allocator> {
     return count;
   }
 
+  // Releases every empty slab of every per-CPU cache, including those retained
+  // by the reserve. Returns the number of slabs released.
+  size_t Trim() {
+    size_t count = 0;
+    for (size_t i = 0; i < processor_count_; i++) {
+      count += cpu_caches_[i]->Trim();
+    }
+    return count;
+  }
+
  private:
   using CpuCache = ktl::optional<ObjectCache<T, Option::Single, Allocator>>;
 
@@ -248,6 +248,11 @@ bool ObjectCacheTests() {
 
     EXPECT_EQ(TestObject::constructor_count, TestObject::destructor_count);
     EXPECT_EQ(object_count, TestObject::destructor_count);
+
+    // Trimming releases the empty slabs retained by the reserve.
+    EXPECT_EQ(ktl::min(slab_count, retain_slabs), static_cast<int>(object_cache->Trim()));
+    EXPECT_EQ(0u, object_cache->slab_count());
+    EXPECT_EQ(TestAllocator::allocated_slabs, TestAllocator::freed_slabs);
   }
   EXPECT_EQ(TestObject::constructor_count, TestObject::destructor_count);
 
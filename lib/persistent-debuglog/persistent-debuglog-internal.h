@@ -13,6 +13,7 @@
 #include <arch/ops.h>
 #include <kernel/lockdep.h>
 #include <kernel/spinlock.h>
+#include <ktl/atomic.h>
 #include <ktl/string_view.h>
 
 namespace tests {
@@ -36,8 +37,8 @@ class PersistentDebugLog {
 
   void Invalidate() {
     Guard<SpinLock, IrqSave> guard{&persistent_log_lock_};
-    if (plog.hdr) {
-      plog.hdr->InvalidateMagic();
+    if (LogHeader* hdr = plog.hdr.load(ktl::memory_order_acquire)) {
+      hdr->InvalidateMagic();
     }
   }
 
@@ -62,9 +63,16 @@ class PersistentDebugLog {
       CleanCacheRange(this, sizeof(*this));
     }
 
+    // Writers publish rd_ptr concurrently, so the header is naturally aligned rather than packed;
+    // the layout is the same either way.
+    void PublishRdPtr(uint32_t val) {
+      ktl::atomic_ref<uint32_t>(rd_ptr).store(val, ktl::memory_order_relaxed);
+    }
+
     uint32_t magic;
     uint32_t rd_ptr;
-  } __PACKED;
+  };
+  static_assert(sizeof(LogHeader) == 2 * sizeof(uint32_t));
 
   static inline void CleanCacheRange(void* addr, size_t len) {
     arch_clean_cache_range(reinterpret_cast<vaddr_t>(addr), len);
@@ -73,18 +81,27 @@ class PersistentDebugLog {
   // Used only by testing to reset a log to its "pre SetLocation'ed" state.
   void ForceReset() {
     Guard<SpinLock, IrqSave> guard{&persistent_log_lock_};
-    plog.hdr = nullptr;
+    plog.hdr.store(nullptr, ktl::memory_order_release);
     plog.payload_size = 0;
     recovered_persistent_log_.size = 0;
   }
 
+  // Serializes SetLocation, Invalidate and ForceReset.  Write does not take it,
+  // so that the log can stay enabled on paths which cannot afford a lock.
   DECLARE_SPINLOCK(PersistentDebugLog) persistent_log_lock_;
 
   // Info about where the persisted log is in RAM, if we have a persisted log.
+  // |hdr| is published once the log is ready, and |payload_size| does not
+  // change while it is.
   struct {
-    LogHeader* hdr = nullptr;
+    ktl::atomic<LogHeader*> hdr{nullptr};
     uint32_t payload_size = 0;
-  } plog TA_GUARDED(persistent_log_lock_);
+  } plog;
+
+  // Free running count of the payload bytes claimed by writers, and the end of
+  // the furthest claim published as the header's rd_ptr.
+  ktl::atomic<uint64_t> claimed_{0};
+  ktl::atomic<uint64_t> published_{0};
 
   // We don't bother to lock this structure.  The log, if present, is recovered
   // during early boot while we are still running on a single core.  After that,
@@ -109,7 +109,7 @@ void PersistentDebugLog::SetLocation(void* virt, size_t len) {
   // TODO(johngro): come back here and try to put a warning/OOPS in to the dlog
   // buffer?
   Guard<SpinLock, IrqSave> guard{&persistent_log_lock_};
-  if (plog.hdr != nullptr) {
+  if (plog.hdr.load(ktl::memory_order_relaxed) != nullptr) {
     return;
   }
 
@@ -163,45 +163,69 @@ void PersistentDebugLog::SetLocation(void* virt, size_t len) {
   hdr->rd_ptr = 0;
   ::memset(hdr->payload(), 0, payload_size);
   CleanCacheRange(hdr, len);
-  plog.hdr = hdr;
   plog.payload_size = payload_size;
+  claimed_.store(0, ktl::memory_order_relaxed);
+  published_.store(0, ktl::memory_order_relaxed);
+  plog.hdr.store(hdr, ktl::memory_order_release);
 }
 
 void PersistentDebugLog::Write(ktl::string_view str) {
-  Guard<SpinLock, IrqSave> guard{&persistent_log_lock_};
-
   // If we have no persistent log, just get out.
-  if (plog.hdr == nullptr) {
+  LogHeader* const hdr = plog.hdr.load(ktl::memory_order_acquire);
+  if (hdr == nullptr) {
     return;
   }
+  const uint32_t payload_size = plog.payload_size;
 
-  // Copy the data into our log
-  char* payload = plog.hdr->payload();
   uint32_t todo;
   size_t offset;
-  if (str.size() > plog.payload_size) {
-    todo = plog.payload_size;
-    offset = str.size() - plog.payload_size;
+  if (str.size() > payload_size) {
+    todo = payload_size;
+    offset = str.size() - payload_size;
   } else {
     todo = static_cast<uint32_t>(str.size());
     offset = 0;
   }
 
-  uint32_t space = plog.payload_size - plog.hdr->rd_ptr;
+  // Claim our part of the payload, then copy the data into it.  Concurrent
+  // writers claim disjoint parts, unless the log wraps while a write is still
+  // in progress, in which case the oldest data gets garbled, as it would be
+  // overwritten anyway.
+  const uint64_t start = claimed_.fetch_add(todo, ktl::memory_order_relaxed);
+  const uint64_t end = start + todo;
+  char* payload = hdr->payload();
+  const uint32_t wr = static_cast<uint32_t>(start % payload_size);
+  const uint32_t space = payload_size - wr;
   if (space > todo) {
-    str.copy(payload + plog.hdr->rd_ptr, todo, offset);
-    CleanCacheRange(payload + plog.hdr->rd_ptr, todo);
-
-    plog.hdr->rd_ptr += todo;
-    CleanCacheRange(plog.hdr, sizeof(*plog.hdr));
+    str.copy(payload + wr, todo, offset);
+    CleanCacheRange(payload + wr, todo);
   } else {
-    str.copy(payload + plog.hdr->rd_ptr, space, offset);
+    str.copy(payload + wr, space, offset);
     str.copy(payload, todo - space, offset + space);
-    CleanCacheRange(payload + plog.hdr->rd_ptr, space);
+    CleanCacheRange(payload + wr, space);
     CleanCacheRange(payload, todo - space);
+  }
 
-    plog.hdr->rd_ptr = todo - space;
-    CleanCacheRange(plog.hdr, sizeof(*plog.hdr));
+  // Advance the published read pointer to the end of our claim, unless a later
+  // claim has already moved it further.  After storing it, check that no later
+  // claim was published in the meantime, as our store might have landed after
+  // that one's.
+  uint64_t published = published_.load(ktl::memory_order_relaxed);
+  while (published < end &&
+         !published_.compare_exchange_weak(published, end, ktl::memory_order_relaxed)) {
+  }
+  if (published >= end) {
+    return;
+  }
+  published = end;
+  for (;;) {
+    hdr->PublishRdPtr(static_cast<uint32_t>(published % payload_size));
+    CleanCacheRange(hdr, sizeof(*hdr));
+    const uint64_t latest = published_.load(ktl::memory_order_relaxed);
+    if (latest == published) {
+      break;
+    }
+    published = latest;
   }
 }
 
@@ -9,6 +9,7 @@
 #include <lib/unittest/unittest.h>
 
 #include <fbl/alloc_checker.h>
+#include <kernel/thread.h>
 #include <ktl/algorithm.h>
 #include <ktl/array.h>
 #include <ktl/unique_ptr.h>
@@ -227,6 +228,63 @@ bool pdlog_zeros_removed_test() {
   END_TEST;
 }
 
+// Writes from several threads at once must each land intact, since writers do
+// not serialize on a lock.
+bool pdlog_concurrent_writes_test() {
+  BEGIN_TEST;
+
+  constexpr ktl::array kLines = {
+      "AAAAAAAAAAAAAAA\n"sv,
+      "BBBBBBBBBBBBBBB\n"sv,
+      "CCCCCCCCCCCCCCC\n"sv,
+      "DDDDDDDDDDDDDDD\n"sv,
+  };
+  constexpr uint32_t kWritesPerThread = 64;
+  constexpr uint32_t kLogSize =
+      sizeof(LogHeader) + kLines.size() * kWritesPerThread * kLines[0].size();
+
+  TestEnvironment env;
+  ASSERT_TRUE(env.Setup(kLogSize, kLogSize));
+  env.log->SetLocation(env.log_buffer.storage.get(), env.log_buffer.capacity);
+
+  struct WriterArgs {
+    PersistentDebugLog* log;
+    ktl::string_view line;
+  };
+  ktl::array<WriterArgs, kLines.size()> args;
+  ktl::array<Thread*, kLines.size()> threads;
+  for (size_t i = 0; i < kLines.size(); ++i) {
+    args[i] = {&env.log.Get(), kLines[i]};
+    threads[i] = Thread::Create(
+        "pdlog-writer",
+        [](void* arg) -> int {
+          auto* writer = static_cast<WriterArgs*>(arg);
+          for (uint32_t j = 0; j < kWritesPerThread; ++j) {
+            writer->log->Write(writer->line);
+          }
+          return 0;
+        },
+        &args[i], DEFAULT_PRIORITY);
+    ASSERT_NONNULL(threads[i]);
+    threads[i]->Resume();
+  }
+  for (Thread* t : threads) {
+    t->Join(nullptr, ZX_TIME_INFINITE);
+  }
+
+  // "reboot" and recover the log, which should be exactly full of whole lines.
+  tests::PersistentDebuglogTestingFriend::ForceReset(env.log.Get());
+  env.log->SetLocation(env.log_buffer.storage.get(), env.log_buffer.capacity);
+  ktl::string_view recovered = env.log->GetRecoveredLog();
+  ASSERT_EQ(kLogSize - sizeof(LogHeader), recovered.size());
+  for (size_t i = 0; i < recovered.size(); i += kLines[0].size()) {
+    ktl::string_view line = recovered.substr(i, kLines[0].size());
+    EXPECT_TRUE(ktl::find(kLines.begin(), kLines.end(), line) != kLines.end());
+  }
+
+  END_TEST;
+}
+
 bool pdlog_rejects_bad_magic_test() {
   BEGIN_TEST;
 
@@ -275,6 +333,7 @@ UNITTEST_START_TESTCASE(persistent_debuglog_tests)
 UNITTEST("basic", pdlog_basic_test)
 UNITTEST("logwrap", pdlog_logwrap_test)
 UNITTEST("zeros_removed", pdlog_zeros_removed_test)
+UNITTEST("concurrent_writes", pdlog_concurrent_writes_test)
 UNITTEST("rejects bad magic", pdlog_rejects_bad_magic_test)
 UNITTEST("rejects bad read pointer", pdlog_rejects_bad_rd_ptr_test)
 UNITTEST_END_TESTCASE(persistent_debuglog_tests, "pdlog", "Persistent Debuglog Tests")
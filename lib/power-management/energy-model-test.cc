@@ -17,6 +17,9 @@
 
 #include <array>
 #include <cstddef>
+#include <optional>
+#include <span>
+#include <string_view>
 #include <utility>
 
 #include <fbl/ref_ptr.h>
@@ -372,6 +375,65 @@ TEST(PowerModelTest, CreateWithEmptyTransitionsIsOk) {
   EXPECT_FALSE(energy_model->FindPowerLevel(static_cast<ControlInterface>(495), 0));
 }
 
+TEST(PowerModelTest, FindActivePowerLevelForRate) {
+  static constexpr auto kPowerLevels = std::to_array<zx_processor_power_level_t>({
+      {
+          .options = 0,
+          .processing_rate = 0,
+          .power_coefficient_nw = 1,
+          .control_interface = cpp23::to_underlying(ControlInterface::kArmWfi),
+          .control_argument = 0,
+          .diagnostic_name = "idle",
+      },
+      {
+          .options = 0,
+          .processing_rate = 1000,
+          .power_coefficient_nw = 100,
+          .control_interface = cpp23::to_underlying(ControlInterface::kCpuDriver),
+          .control_argument = 2,
+          .diagnostic_name = "fast",
+      },
+      {
+          .options = 0,
+          .processing_rate = 250,
+          .power_coefficient_nw = 10,
+          .control_interface = cpp23::to_underlying(ControlInterface::kCpuDriver),
+          .control_argument = 0,
+          .diagnostic_name = "slow",
+      },
+      {
+          .options = 0,
+          .processing_rate = 500,
+          .power_coefficient_nw = 30,
+          .control_interface = cpp23::to_underlying(ControlInterface::kCpuDriver),
+          .control_argument = 1,
+          .diagnostic_name = "medium",
+      },
+  });
+
+  auto energy_model = EnergyModel::Create(kPowerLevels, {});
+  ASSERT_TRUE(energy_model.is_ok());
+  auto levels = energy_model->levels();
+
+  auto name_for_rate = [&](uint64_t rate) -> std::string_view {
+    const std::optional<uint8_t> index = energy_model->FindActivePowerLevelForRate(rate);
+    return index ? levels[*index].name() : "none";
+  };
+
+  EXPECT_EQ(name_for_rate(0), "slow");
+  EXPECT_EQ(name_for_rate(250), "slow");
+  EXPECT_EQ(name_for_rate(251), "medium");
+  EXPECT_EQ(name_for_rate(1000), "fast");
+
+  // Demand beyond the fastest level saturates at the fastest level.
+  EXPECT_EQ(name_for_rate(5000), "fast");
+
+  // A model with only idle levels has nothing to select.
+  auto idle_model = EnergyModel::Create(std::span(kPowerLevels).subspan(0, 1), {});
+  ASSERT_TRUE(idle_model.is_ok());
+  EXPECT_FALSE(idle_model->FindActivePowerLevelForRate(0));
+}
+
 TEST(PowerDomainRegistryTest, RegisterUniquePowerDomains) {
   PowerDomainRegistry registry;
   std::map<size_t, fbl::RefPtr<PowerDomain>> registed_domains;
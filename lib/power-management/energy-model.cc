@@ -279,4 +279,21 @@ std::optional<uint8_t> EnergyModel::FindPowerLevel(ControlInterface interface_id
   return std::nullopt;
 }
 
+std::optional<uint8_t> EnergyModel::FindActivePowerLevelForRate(uint64_t processing_rate) const {
+  const std::span<const PowerLevel> levels = active_levels();
+  if (levels.empty()) {
+    return std::nullopt;
+  }
+
+  // Levels with the same processing rate are sorted by power coefficient, so the first match is
+  // also the cheapest.
+  auto it = std::lower_bound(levels.begin(), levels.end(), processing_rate,
+                             [](const PowerLevel& level, uint64_t rate) {
+                               return level.processing_rate() < rate;
+                             });
+  const size_t index =
+      it == levels.end() ? levels.size() - 1 : static_cast<size_t>(it - levels.begin());
+  return static_cast<uint8_t>(idle_power_levels_ + index);
+}
+
 }  // namespace power_management
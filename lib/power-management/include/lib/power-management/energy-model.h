@@ -332,6 +332,11 @@ class EnergyModel {
   std::optional<uint8_t> FindPowerLevel(ControlInterface interface_id,
                                         uint64_t control_argument) const;
 
+  // Returns the index of the slowest active power level whose processing rate is at least
+  // `processing_rate`, or of the fastest active power level if none is fast enough. Returns
+  // std::nullopt if there are no active power levels.
+  std::optional<uint8_t> FindActivePowerLevelForRate(uint64_t processing_rate) const;
+
  private:
   EnergyModel(fbl::Vector<PowerLevel> levels, fbl::Vector<PowerLevelTransition> transitions,
               fbl::Vector<size_t> control_lookup, size_t idle_levels)
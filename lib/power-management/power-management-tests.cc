@@ -194,7 +194,7 @@ bool SchedulerFlushesPendingControlRequests() {
   ASSERT_TRUE(ac.check());
 
   fbl::RefPtr domain = fbl::MakeRefCountedChecked<PowerDomain>(
-      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu())}},
+      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu()).word(0)}},
       ktl::move(*energy_model), controller);
   ASSERT_TRUE(ac.check());
 
@@ -255,7 +255,7 @@ bool SchedulerElidesPendingControlRequests() {
   ASSERT_TRUE(ac.check());
 
   fbl::RefPtr domain = fbl::MakeRefCountedChecked<PowerDomain>(
-      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu())}},
+      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu()).word(0)}},
       ktl::move(*energy_model), controller);
   ASSERT_TRUE(ac.check());
 
@@ -302,7 +302,7 @@ bool SchedulerCanPendControlRequestsInIrqContext() {
   ASSERT_TRUE(ac.check());
 
   fbl::RefPtr domain = fbl::MakeRefCountedChecked<PowerDomain>(
-      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu())}},
+      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu()).word(0)}},
       ktl::move(*energy_model), controller);
   ASSERT_TRUE(ac.check());
 
@@ -359,7 +359,7 @@ bool SchedulerCanPendControlRequestsAcrossCpus() {
   ASSERT_TRUE(ac.check());
 
   fbl::RefPtr domain = fbl::MakeRefCountedChecked<PowerDomain>(
-      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu())}},
+      &ac, 1, zx_cpu_set_t{.mask = {cpu_num_to_mask(scheduler.this_cpu()).word(0)}},
       ktl::move(*energy_model), controller);
   ASSERT_TRUE(ac.check());
 
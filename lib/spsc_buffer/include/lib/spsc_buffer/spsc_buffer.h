@@ -6,6 +6,7 @@
 #define ZIRCON_KERNEL_LIB_SPSC_BUFFER_INCLUDE_LIB_SPSC_BUFFER_SPSC_BUFFER_H_
 
 #include <lib/zx/result.h>
+#include <string.h>
 #include <zircon/types.h>
 
 #include <ktl/algorithm.h>
@@ -276,6 +277,73 @@ class SpscBuffer {
     AdvanceReadPointer(initial_state, available_data);
   }
 
+  // Returns the number of bytes currently available to read. When called by the reader, this is a
+  // lower bound, since the writer may commit more data at any time.
+  uint32_t AvailableData() const { return AvailableData(LoadPointers()); }
+
+  // Discards the oldest records in the buffer until there are at least |size| bytes of free space.
+  // This lets a writer keep the most recent data when the buffer is used as an overwriting ring.
+  //
+  // The buffer does not know about record boundaries, so |record_size| is invoked with the first
+  // 8 bytes of the oldest record and must return that record's total size in bytes. Records are
+  // therefore required to be 8 byte aligned, and to start with their size.
+  //
+  // This method moves the read pointer from the writer's side, so the caller must ensure that no
+  // Read or Drain runs concurrently with it. Returns false if the space could not be made, either
+  // because |size| exceeds the buffer size or because |record_size| reported a malformed record.
+  template <typename RecordSizeFunc>
+  bool DiscardOldest(uint32_t size, RecordSizeFunc&& record_size) {
+    if (size > storage_.size()) {
+      return false;
+    }
+    RingPointers pointers = LoadPointers();
+    while (AvailableSpace(pointers) < size) {
+      const uint32_t read_offset = PointerToOffset(pointers.read);
+      DEBUG_ASSERT(read_offset % sizeof(uint64_t) == 0);
+      uint64_t header;
+      memcpy(&header, &storage_[read_offset], sizeof(header));
+      const uint32_t discard = record_size(header);
+      if (discard == 0 || discard > AvailableData(pointers)) {
+        return false;
+      }
+      AdvanceReadPointer(pointers, discard);
+      pointers = LoadPointers();
+    }
+    return true;
+  }
+
+  // Returns a mark identifying the current end of the data in the buffer, for use with
+  // RotateToFront.
+  uint32_t WriteMark() const { return LoadPointers().write; }
+
+  // Moves the data written after |mark| ahead of all of the other data in the buffer, so that it
+  // is the first data returned by the next Read. This is used to place data that is written late,
+  // such as metadata needed to interpret earlier records, at the front of the buffer. If some of
+  // that data has since been discarded, nothing is moved.
+  //
+  // The rotation is done in place and is linear in the amount of data in the buffer. The caller
+  // must ensure that no reads or writes run concurrently with it.
+  void RotateToFront(uint32_t mark) {
+    const RingPointers pointers = LoadPointers();
+    const uint32_t available_data = AvailableData(pointers);
+    const uint32_t len = pointers.write - mark;
+    if (len == 0 || len >= available_data) {
+      return;
+    }
+    // Rotating [A B] into [B A] is reversing A and B individually, and then the whole.
+    auto reverse = [this, &pointers](uint32_t begin, uint32_t end) {
+      while (begin + 1 < end) {
+        --end;
+        ktl::swap(storage_[PointerToOffset(pointers.read + begin)],
+                  storage_[PointerToOffset(pointers.read + end)]);
+        ++begin;
+      }
+    };
+    reverse(0, available_data - len);
+    reverse(available_data - len, available_data);
+    reverse(0, available_data);
+  }
+
  private:
   friend class SpscBufferTests;
 
@@ -552,6 +552,113 @@ class SpscBufferTests {
     END_TEST;
   }
 
+  // Test that DiscardOldest drops whole records from the front of the buffer until the requested
+  // space is available.
+  static bool TestDiscardOldest() {
+    BEGIN_TEST;
+
+    constexpr uint32_t kStorageSize = 256;
+    SpscBuffer<HeapAllocator> spsc;
+    ASSERT_OK(spsc.Init(kStorageSize));
+
+    // Fill the buffer with 64 byte records, each starting with its size. Start near the end of
+    // the storage so that the records wrap around the ring break.
+    const uint64_t starting_pointers = SpscBuffer<HeapAllocator>::CombinePointers({
+        .read = kStorageSize - 32,
+        .write = kStorageSize - 32,
+    });
+    spsc.combined_pointers_.store(starting_pointers, ktl::memory_order_release);
+    for (uint64_t i = 0; i < kStorageSize / 64; i++) {
+      const ktl::array<uint64_t, 8> record = {64, i, i, i, i, i, i, i};
+      zx::result<SpscBuffer<HeapAllocator>::Reservation> reservation = spsc.Reserve(64);
+      ASSERT_OK(reservation.status_value());
+      reservation->Write(ktl::as_bytes(ktl::span(record)));
+      reservation->Commit();
+    }
+    ASSERT_EQ(0u, spsc.AvailableSpace(spsc.LoadPointers()));
+
+    auto record_size = [](uint64_t header) { return static_cast<uint32_t>(header); };
+
+    // Asking for a partial record's worth of space discards exactly one record.
+    ASSERT_TRUE(spsc.DiscardOldest(8, record_size));
+    EXPECT_EQ(64u, spsc.AvailableSpace(spsc.LoadPointers()));
+
+    // Space that is already available discards nothing.
+    ASSERT_TRUE(spsc.DiscardOldest(64, record_size));
+    EXPECT_EQ(64u, spsc.AvailableSpace(spsc.LoadPointers()));
+
+    // Asking for more space discards as many records as needed, oldest first.
+    ASSERT_TRUE(spsc.DiscardOldest(100, record_size));
+    EXPECT_EQ(128u, spsc.AvailableSpace(spsc.LoadPointers()));
+    ktl::array<uint64_t, 8> dst;
+    auto copy_out_fn = [&dst](uint32_t offset, ktl::span<ktl::byte> src) {
+      memcpy(reinterpret_cast<ktl::byte*>(dst.data()) + offset, src.data(), src.size());
+      return ZX_OK;
+    };
+    zx::result<uint32_t> read = spsc.Read(copy_out_fn, 64);
+    ASSERT_OK(read.status_value());
+    EXPECT_EQ(64u, read.value());
+    EXPECT_EQ(2u, dst[1]);
+
+    // Space larger than the buffer, and malformed records, are refused.
+    EXPECT_FALSE(spsc.DiscardOldest(kStorageSize + 8, record_size));
+    EXPECT_FALSE(spsc.DiscardOldest(kStorageSize, [](uint64_t) { return 0u; }));
+    EXPECT_FALSE(spsc.DiscardOldest(kStorageSize, [](uint64_t) { return 1024u; }));
+
+    END_TEST;
+  }
+
+  // Test that RotateToFront moves the newest data ahead of the older data.
+  static bool TestRotateToFront() {
+    BEGIN_TEST;
+
+    constexpr uint32_t kStorageSize = 64;
+    SpscBuffer<HeapAllocator> spsc;
+    ASSERT_OK(spsc.Init(kStorageSize));
+
+    // Write 48 bytes of ascending values, wrapping around the ring break.
+    const uint64_t starting_pointers = SpscBuffer<HeapAllocator>::CombinePointers({
+        .read = kStorageSize - 20,
+        .write = kStorageSize - 20,
+    });
+    spsc.combined_pointers_.store(starting_pointers, ktl::memory_order_release);
+    ktl::array<uint8_t, 48> src;
+    for (size_t i = 0; i < src.size(); i++) {
+      src[i] = static_cast<uint8_t>(i);
+    }
+    auto write = [&spsc](ktl::span<const uint8_t> data) {
+      zx::result<SpscBuffer<HeapAllocator>::Reservation> reservation =
+          spsc.Reserve(static_cast<uint32_t>(data.size()));
+      ASSERT(reservation.is_ok());
+      reservation->Write(ktl::as_bytes(data));
+      reservation->Commit();
+    };
+    write(ktl::span(src).subspan(0, 32));
+    const uint32_t mark = spsc.WriteMark();
+    write(ktl::span(src).subspan(32));
+
+    // Rotating everything, or nothing, is a no-op.
+    spsc.RotateToFront(mark + 16);
+    spsc.RotateToFront(mark - 32);
+
+    // Rotate the last 16 bytes to the front.
+    spsc.RotateToFront(mark);
+
+    ktl::array<uint8_t, 48> dst;
+    auto copy_out_fn = [&dst](uint32_t offset, ktl::span<ktl::byte> src) {
+      memcpy(dst.data() + offset, src.data(), src.size());
+      return ZX_OK;
+    };
+    zx::result<uint32_t> read = spsc.Read(copy_out_fn, static_cast<uint32_t>(dst.size()));
+    ASSERT_OK(read.status_value());
+    ASSERT_EQ(dst.size(), read.value());
+    for (size_t i = 0; i < dst.size(); i++) {
+      EXPECT_EQ(static_cast<uint8_t>((i + 32) % 48), dst[i]);
+    }
+
+    END_TEST;
+  }
+
  private:
   // Allocator used by the TestInit function to validate proper error behavior when a nullptr
   // is returned by Allocate.
@@ -586,5 +693,7 @@ UNITTEST("advance_write_pointer", SpscBufferTests::TestAdvanceWritePointer)
 UNITTEST("init", SpscBufferTests::TestInit)
 UNITTEST("read_write_single_threaded", SpscBufferTests::TestReadWriteSingleThreaded)
 UNITTEST("drain", SpscBufferTests::TestDrain)
+UNITTEST("discard_oldest", SpscBufferTests::TestDiscardOldest)
+UNITTEST("rotate_to_front", SpscBufferTests::TestRotateToFront)
 UNITTEST_END_TESTCASE(spsc_buffer_tests, "spsc_buffer",
                       "Test the single-producer, single-consumer ring buffer implementation.")
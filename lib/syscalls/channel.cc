@@ -171,11 +171,8 @@ static __WARN_UNUSED_RESULT zx_status_t msg_get_handles(ProcessDispatcher* up, M
         channel->CancelMessageWaiters();
       }
     }
-    HandleOwner handle(handle_list[i]);
-    // TODO(https://fxbug.dev/42105832): This takes a lock per call. Consider doing these in a
-    // batch.
-    up->handle_table().AddHandle(ktl::move(handle));
   }
+  up->handle_table().AddHandles(ktl::span(handle_list, num_handles));
   msg->set_owns_handles(false);
 
   return ZX_OK;
@@ -316,7 +313,8 @@ static __WARN_UNUSED_RESULT zx_status_t msg_put_handles(ProcessDispatcher* up, M
                                                         uint32_t num_handles, Dispatcher* channel) {
   DEBUG_ASSERT(num_handles <= kMaxMessageHandles);  // This must be checked before calling.
 
-  typename UserHandles::ValueType handles[kMaxMessageHandles] = {};
+  // Only the first |num_handles| entries are used, and those are all copied in.
+  __UNINITIALIZED typename UserHandles::ValueType handles[kMaxMessageHandles];
   zx_status_t status = user_handles.copy_array_from_user(handles, num_handles);
   if (status != ZX_OK)
     return status;
@@ -0,0 +1,38 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_LIB_SYSCALLS_INCLUDE_LIB_SYSCALLS_VMO_VECTOR_H_
+#define ZIRCON_KERNEL_LIB_SYSCALLS_INCLUDE_LIB_SYSCALLS_VMO_VECTOR_H_
+
+#include <lib/user_copy/user_ptr.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <zircon/types.h>
+
+// One segment of a vectored VMO read or write. |buffer.capacity| bytes at |vmo_offset| in the VMO
+// are transferred to or from |buffer.buffer|.
+struct VmoSegment {
+  uint64_t vmo_offset;
+  zx_iovec_t buffer;
+};
+
+// The largest number of segments accepted by a single vmo_readv or vmo_writev call.
+inline constexpr size_t kVmoVectorMaxSegments = 1024;
+
+// Reads or writes the |count| segments in |segments|, in order, as if by a zx_vmo_read or
+// zx_vmo_write call for each, but with the VMO lock held across consecutive segments. The handle
+// needs ZX_RIGHT_READ or ZX_RIGHT_WRITE respectively.
+//
+// The total number of bytes transferred is written to |actual|, if it is not null, including when
+// a segment fails, in which case the segments after it are not attempted. Returns
+// ZX_ERR_OUT_OF_RANGE if |count| exceeds kVmoVectorMaxSegments or a segment is outside the VMO,
+// and ZX_ERR_INVALID_ARGS if the segments cannot be read.
+zx_status_t vmo_readv(zx_handle_t handle, user_in_ptr<const VmoSegment> segments, size_t count,
+                      user_out_ptr<size_t> actual);
+zx_status_t vmo_writev(zx_handle_t handle, user_in_ptr<const VmoSegment> segments, size_t count,
+                       user_out_ptr<size_t> actual);
+
+#endif  // ZIRCON_KERNEL_LIB_SYSCALLS_INCLUDE_LIB_SYSCALLS_VMO_VECTOR_H_
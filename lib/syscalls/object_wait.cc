@@ -105,7 +105,7 @@ zx_status_t sys_object_wait_many(user_inout_ptr<zx_wait_item_t> user_items, size
   if (count > kMaxWaitHandleCount)
     return ZX_ERR_OUT_OF_RANGE;
 
-  zx_wait_item_t items[kMaxWaitHandleCount];
+  __UNINITIALIZED zx_wait_item_t items[kMaxWaitHandleCount];
   if (user_items.copy_array_from_user(items, count) != ZX_OK)
     return ZX_ERR_INVALID_ARGS;
 
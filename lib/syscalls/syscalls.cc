@@ -5,6 +5,8 @@
 // https://opensource.org/licenses/MIT
 
 #include <inttypes.h>
+#include <lib/console.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <lib/syscalls/forward.h>
 #include <lib/syscalls/safe-syscall-argument.h>
@@ -12,6 +14,7 @@
 #include <lib/userabi/vdso.h>
 #include <platform.h>
 #include <stdint.h>
+#include <string.h>
 #include <trace.h>
 #include <zircon/errors.h>
 #include <zircon/syscalls.h>
@@ -21,7 +24,9 @@
 
 #include <kernel/stats.h>
 #include <kernel/thread.h>
+#include <ktl/atomic.h>
 #include <object/process_dispatcher.h>
+#include <platform/timer.h>
 #include <syscalls/syscalls.h>
 
 #include "vdso-valid-sysret.h"
@@ -39,11 +44,12 @@ namespace {
 
 struct SyscallNameRefEntry {
   fxt::StringRef<fxt::RefType::kId> name{"[unknown]"_intern};
+  const char* string = "[unknown]";
 };
 
 #define VDSO_SYSCALL(...)
 #define KERNEL_SYSCALL(name, type, attrs, nargs, arglist, prototype) \
-  [ZX_SYS_##name] = {#name##_intern},
+  [ZX_SYS_##name] = {#name##_intern, #name},
 #define INTERNAL_SYSCALL(...) KERNEL_SYSCALL(__VA_ARGS__)
 #define BLOCKING_SYSCALL(...) KERNEL_SYSCALL(__VA_ARGS__)
 
@@ -58,6 +64,33 @@ SyscallNameRefEntry kSyscallNameRefs[] = {
 #pragma GCC diagnostic pop
 #endif
 
+// Per-syscall latency histograms, switched on and off with the `syscallstat` console command.
+// When they are off, the only cost on the syscall path is one relaxed load. The buckets are
+// shared by all CPUs and updated with relaxed atomics, which is cheap enough for a diagnostic
+// that is only on while someone is looking at it. Bucket 0 counts syscalls shorter than 128ns,
+// and the last one counts every syscall of 2ms or more.
+constexpr int kSyscallStatsShift = 7;
+
+struct SyscallStats {
+  ktl::atomic<uint64_t> buckets[kCounterHistogramBuckets];
+  ktl::atomic<uint64_t> total_ns;
+};
+
+ktl::atomic<bool> syscall_stats_enabled{false};
+SyscallStats syscall_stats[ktl::size(kSyscallNameRefs)];
+
+void RecordSyscallLatency(uint64_t syscall_num, zx_instant_mono_ticks_t start_ticks) {
+  if (syscall_num >= ktl::size(syscall_stats)) {
+    return;
+  }
+  const uint64_t ns = static_cast<uint64_t>(
+      timer_get_ticks_to_time_ratio().Scale(current_mono_ticks() - start_ticks));
+  SyscallStats& stats = syscall_stats[syscall_num];
+  stats.buckets[CounterHistogram::Bucket(ns, kSyscallStatsShift)].fetch_add(
+      1, ktl::memory_order_relaxed);
+  stats.total_ns.fetch_add(ns, ktl::memory_order_relaxed);
+}
+
 __NO_INLINE int sys_invalid_syscall(uint64_t num, uint64_t pc, uintptr_t vdso_code_address) {
   LTRACEF("invalid syscall %lu from PC %#lx vDSO code %#lx\n", num, pc, vdso_code_address);
   Thread::Current::SignalPolicyException(ZX_EXCP_POLICY_CODE_BAD_SYSCALL,
@@ -68,6 +101,8 @@ __NO_INLINE int sys_invalid_syscall(uint64_t num, uint64_t pc, uintptr_t vdso_co
 struct syscall_pre_out {
   uintptr_t vdso_code_address;
   ProcessDispatcher* current_process;
+  // Zero unless syscall latency stats are enabled.
+  zx_instant_mono_ticks_t start_ticks;
 };
 
 inline fxt::StringRef<fxt::RefType::kId> syscall_name_ref(uint64_t syscall_num) {
@@ -88,6 +123,11 @@ __NO_INLINE syscall_pre_out do_syscall_pre(uint64_t syscall_num, uint64_t pc) {
 
   CPU_STATS_INC(syscalls);
 
+  zx_instant_mono_ticks_t start_ticks = 0;
+  if (unlikely(syscall_stats_enabled.load(ktl::memory_order_relaxed))) {
+    start_ticks = current_mono_ticks();
+  }
+
   /* re-enable interrupts to maintain kernel preemptiveness
      This must be done after the above fxt_duration_begin call, and after the
      above CPU_STATS_INC call as it also calls arch_curr_cpu_num. */
@@ -99,10 +139,11 @@ __NO_INLINE syscall_pre_out do_syscall_pre(uint64_t syscall_num, uint64_t pc) {
   ProcessDispatcher* current_process = ProcessDispatcher::GetCurrent();
   uintptr_t vdso_code_address = current_process->vdso_code_address();
 
-  return {vdso_code_address, current_process};
+  return {vdso_code_address, current_process, start_ticks};
 }
 
-__NO_INLINE syscall_result do_syscall_post(uint64_t ret, uint64_t syscall_num) {
+__NO_INLINE syscall_result do_syscall_post(uint64_t ret, uint64_t syscall_num,
+                                           zx_instant_mono_ticks_t start_ticks) {
   LTRACEF_LEVEL(2, "t %p ret %#" PRIx64 "\n", Thread::Current::Get(), ret);
 
   // Disable interrupts on the way out before checking thread signals.
@@ -116,6 +157,10 @@ __NO_INLINE syscall_result do_syscall_post(uint64_t ret, uint64_t syscall_num) {
 
   KTRACE_DURATION_END_LABEL_REF("kernel:syscall", syscall_name_ref(syscall_num));
 
+  if (unlikely(start_ticks != 0)) {
+    RecordSyscallLatency(syscall_num, start_ticks);
+  }
+
   // The assembler caller will re-disable interrupts at the appropriate time.
   return {ret, Thread::Current::Get()->IsSignaled()};
 }
@@ -143,7 +188,7 @@ inline syscall_result do_syscall(uint64_t syscall_num, uint64_t pc, bool (*valid
   }
 
   // Call through to the shared postamble code
-  return do_syscall_post(ret, syscall_num);
+  return do_syscall_post(ret, syscall_num, pre_ret.start_ticks);
 }
 
 // Called when an out of bounds syscall number is passed from user space
@@ -158,3 +203,71 @@ syscall_result unknown_syscall(uint64_t syscall_num, uint64_t pc) {
 
 // Autogenerated per-syscall wrapper functions.
 #include <lib/syscalls/kernel-wrappers.inc>
+
+namespace {
+
+void DumpSyscallStats() {
+  for (size_t i = 0; i < ktl::size(syscall_stats); i++) {
+    const SyscallStats& stats = syscall_stats[i];
+    uint64_t count = 0;
+    for (const auto& bucket : stats.buckets) {
+      count += bucket.load(ktl::memory_order_relaxed);
+    }
+    if (count == 0) {
+      continue;
+    }
+    printf("%-32s count %8" PRIu64 " avg_ns %8" PRIu64 "\n", kSyscallNameRefs[i].string, count,
+           stats.total_ns.load(ktl::memory_order_relaxed) / count);
+    printf("\t");
+    for (size_t b = 0; b < kCounterHistogramBuckets; b++) {
+      const uint64_t bucket_count = stats.buckets[b].load(ktl::memory_order_relaxed);
+      if (bucket_count != 0) {
+        const uint64_t start = b == 0 ? 0 : uint64_t{1} << (b - 1 + kSyscallStatsShift);
+        printf(" %" PRIu64 "%s=%" PRIu64, start, b == kCounterHistogramBuckets - 1 ? "+" : "",
+               bucket_count);
+      }
+    }
+    printf("\n");
+  }
+}
+
+void ResetSyscallStats() {
+  for (SyscallStats& stats : syscall_stats) {
+    for (auto& bucket : stats.buckets) {
+      bucket.store(0, ktl::memory_order_relaxed);
+    }
+    stats.total_ns.store(0, ktl::memory_order_relaxed);
+  }
+}
+
+int cmd_syscallstat(int argc, const cmd_args* argv, uint32_t flags) {
+  if (argc < 2) {
+  usage:
+    printf("usage:\n");
+    printf("%s enable  : start recording syscall latencies\n", argv[0].str);
+    printf("%s disable : stop recording syscall latencies\n", argv[0].str);
+    printf("%s reset   : clear the recorded latencies\n", argv[0].str);
+    printf("%s dump    : print a latency histogram (in ns) for each syscall\n", argv[0].str);
+    return -1;
+  }
+
+  if (!strcmp(argv[1].str, "enable")) {
+    syscall_stats_enabled.store(true, ktl::memory_order_relaxed);
+  } else if (!strcmp(argv[1].str, "disable")) {
+    syscall_stats_enabled.store(false, ktl::memory_order_relaxed);
+  } else if (!strcmp(argv[1].str, "reset")) {
+    ResetSyscallStats();
+  } else if (!strcmp(argv[1].str, "dump")) {
+    DumpSyscallStats();
+  } else {
+    printf("unknown command\n");
+    goto usage;
+  }
+  return 0;
+}
+
+}  // namespace
+
+STATIC_COMMAND_START
+STATIC_COMMAND("syscallstat", "per-syscall latency histograms", &cmd_syscallstat)
+STATIC_COMMAND_END(syscallstat)
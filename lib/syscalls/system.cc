@@ -516,7 +516,7 @@ zx_status_t sys_system_powerctl(zx_handle_t power_rsrc, uint32_t cmd,
 
   switch (cmd) {
     case ZX_SYSTEM_POWERCTL_ENABLE_ALL_CPUS: {
-      cpu_mask_t all_cpus = ((cpu_mask_t)1u << arch_max_num_cpus()) - 1;
+      cpu_mask_t all_cpus = CpuMask::FirstN(arch_max_num_cpus());
       return mp_hotplug_cpu_mask(~mp_get_online_mask() & all_cpus);
     }
     case ZX_SYSTEM_POWERCTL_DISABLE_ALL_CPUS_BUT_PRIMARY: {
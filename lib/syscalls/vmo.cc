@@ -7,6 +7,7 @@
 #include <inttypes.h>
 #include <lib/fit/defer.h>
 #include <lib/syscalls/forward.h>
+#include <lib/syscalls/vmo-vector.h>
 #include <lib/user_copy/user_ptr.h>
 #include <lib/zircon-internal/thread_annotations.h>
 #include <trace.h>
@@ -14,6 +15,8 @@
 #include <zircon/types.h>
 
 #include <fbl/ref_ptr.h>
+#include <ktl/algorithm.h>
+#include <ktl/span.h>
 #include <object/handle.h>
 #include <object/process_dispatcher.h>
 #include <object/resource.h>
@@ -103,6 +106,70 @@ zx_status_t sys_vmo_write(zx_handle_t handle, user_in_ptr<const void> _data, uin
   return vmo->Write(_data.reinterpret<const char>(), offset, len).first;
 }
 
+namespace {
+
+zx_status_t vmo_transfer_vector(zx_handle_t handle, user_in_ptr<const VmoSegment> _segments,
+                                size_t count, user_out_ptr<size_t> _actual, bool write) {
+  LTRACEF("handle %x, count %zu, write %d\n", handle, count, write);
+
+  if (count > kVmoVectorMaxSegments) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+
+  auto up = ProcessDispatcher::GetCurrent();
+
+  fbl::RefPtr<VmObjectDispatcher> vmo;
+  zx_status_t status = up->handle_table().GetDispatcherWithRights(
+      *up, handle, write ? ZX_RIGHT_WRITE : ZX_RIGHT_READ, &vmo);
+  if (status != ZX_OK) {
+    return status;
+  }
+
+  // Segments are copied in in small batches to bound the stack usage, and each batch is handed to
+  // the VMO as a whole so that it can keep its lock held from one segment to the next.
+  constexpr size_t kBatch = 16;
+  VmoSegment segments[kBatch];
+  UserCopyRange ranges[kBatch];
+  size_t total = 0;
+  for (size_t base = 0; base < count && status == ZX_OK; base += kBatch) {
+    const size_t batch = ktl::min(kBatch, count - base);
+    if (_segments.element_offset(base).copy_array_from_user(segments, batch) != ZX_OK) {
+      status = ZX_ERR_INVALID_ARGS;
+      break;
+    }
+    for (size_t i = 0; i < batch; i++) {
+      ranges[i] = {.offset = segments[i].vmo_offset,
+                   .len = segments[i].buffer.capacity,
+                   .buffer = segments[i].buffer.buffer};
+    }
+    const ktl::span<const UserCopyRange> span(ranges, batch);
+    auto [transfer_status, transferred] =
+        write ? vmo->vmo()->WriteUserRanges(span) : vmo->vmo()->ReadUserRanges(span);
+    total += transferred;
+    status = transfer_status;
+  }
+
+  if (_actual) {
+    zx_status_t copy_status = _actual.copy_to_user(total);
+    if (status == ZX_OK && copy_status != ZX_OK) {
+      status = copy_status;
+    }
+  }
+  return status;
+}
+
+}  // namespace
+
+zx_status_t vmo_readv(zx_handle_t handle, user_in_ptr<const VmoSegment> _segments, size_t count,
+                      user_out_ptr<size_t> _actual) {
+  return vmo_transfer_vector(handle, _segments, count, _actual, false);
+}
+
+zx_status_t vmo_writev(zx_handle_t handle, user_in_ptr<const VmoSegment> _segments, size_t count,
+                       user_out_ptr<size_t> _actual) {
+  return vmo_transfer_vector(handle, _segments, count, _actual, true);
+}
+
 // zx_status_t zx_vmo_transfer_data
 zx_status_t sys_vmo_transfer_data(zx_handle_t dst_vmo_handle, uint32_t options, uint64_t offset,
                                   uint64_t length, zx_handle_t src_vmo_handle,
@@ -143,7 +210,8 @@ zx_status_t sys_vmo_transfer_data(zx_handle_t dst_vmo_handle, uint32_t options,
     return status;
   }
 
-  // TODO(https://fxbug.dev/42082399): Stop decompressing compressed pages from the source range.
+  // Pages, compressed references and gaps in the splice list are all moved into the destination
+  // without copying, with gaps becoming markers or empty slots as the destination requires.
   return dst_vmo_dispatcher->vmo()->SupplyPages(offset, length, &pages,
                                                 SupplyOptions::TransferData);
 }
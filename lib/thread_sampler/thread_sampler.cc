@@ -141,7 +141,7 @@ zx::result<> sampler::ThreadSamplerDispatcher::StartImpl() TA_EXCL(get_lock()) {
   }
 
   mp_sync_exec(
-      mp_ipi_target::ALL, 0,
+      mp_ipi_target::ALL, {},
       [](void* s) { reinterpret_cast<sampler::ThreadSamplerDispatcher*>(s)->SetCurrCpuTimer(); },
       this);
   state_ = SamplingState::Running;
@@ -286,28 +286,31 @@ zx::result<> sampler::ThreadSamplerDispatcher::SampleThreadImpl(zx_koid_t pid, z
     actual_fp -= 16;
 #endif
 
-    user_in_ptr<const vaddr_t> user_next_fp{reinterpret_cast<vaddr_t*>(actual_fp)};
-    user_in_ptr<const vaddr_t> user_pc{reinterpret_cast<vaddr_t*>(actual_fp + 8)};
+    // The saved frame pointer and return address are adjacent, so read both with a single user
+    // copy. This halves the number of user copies, and their fault handling setup, per frame.
+    struct FrameRecord {
+      vaddr_t next_fp;
+      vaddr_t pc;
+    };
+    user_in_ptr<const FrameRecord> user_frame{reinterpret_cast<const FrameRecord*>(actual_fp)};
 
     // A well formed frame pointer chain ends in 0 and should never fail to copy. If a thread's
     // stack is not readable or well formatted, we return an error to indicate that sampling should
     // be disabled for the offending thread.
-    zx_status_t copy_res = user_pc.copy_from_user(&pc);
+    FrameRecord frame;
+    zx_status_t copy_res = user_frame.copy_from_user(&frame);
     if (copy_res != ZX_OK) {
-      // We eat the copy_res and return ZX_ERR_NOT_SUPPORTED here and below to indicate that we
-      // failed to take a sample, but we might still succeed in the future. A thread may not
-      // necessarily have valid frame pointers at all points in execution, so don't give on this
-      // thread just yet.
+      // We eat the copy_res and return ZX_ERR_NOT_SUPPORTED here to indicate that we failed to
+      // take a sample, but we might still succeed in the future. A thread may not necessarily have
+      // valid frame pointers at all points in execution, so don't give on this thread just yet.
       return zx::error(ZX_ERR_NOT_SUPPORTED);
     }
+    pc = frame.pc;
     if (pc == 0) {
       break;
     }
     bt[frame_num++] = pc;
-    copy_res = user_next_fp.copy_from_user(&fp);
-    if (copy_res != ZX_OK) {
-      return zx::error(ZX_ERR_NOT_SUPPORTED);
-    }
+    fp = frame.next_fp;
   }
 
   // Up until this point, interrupts are enabled so that we can handle faults when doing usercopies.
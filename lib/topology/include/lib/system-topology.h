@@ -103,6 +103,23 @@ class Graph {
     return ZX_OK;
   }
 
+  // Returns the mask of the other logical processors that share a processor node
+  // with the given logical id. The mask is empty if the processor is not SMT or
+  // the id is not found.
+  cpu_mask_t SmtSiblingMask(cpu_num_t id) const {
+    cpu_mask_t siblings{};
+    Node* processor;
+    if (ProcessorByLogicalId(id, &processor) == ZX_OK) {
+      for (int i = 0; i < processor->entity.processor.logical_id_count; i++) {
+        const cpu_num_t logical_id = processor->entity.processor.logical_ids[i];
+        if (logical_id != id) {
+          siblings.set(logical_id);
+        }
+      }
+    }
+    return siblings;
+  }
+
   // Returns an immutable reference to the system topology graph. This may be
   // called after the graph is initialized by Graph::InitializeSystemTopology.
   static const Graph& GetSystemTopology() { return system_topology_.Get(); }
@@ -52,6 +52,12 @@ bool test_flat_to_heap_simple() {
   ASSERT_EQ(ZX_ERR_NOT_FOUND, graph.ProcessorByLogicalId(
                                   static_cast<cpu_num_t>(graph.logical_processor_count()), &node));
 
+  // Only the SMT2 core has siblings.
+  EXPECT_TRUE(graph.SmtSiblingMask(0) == cpu_num_to_mask(1));
+  EXPECT_TRUE(graph.SmtSiblingMask(1) == cpu_num_to_mask(0));
+  EXPECT_TRUE(graph.SmtSiblingMask(2).none());
+  EXPECT_TRUE(graph.SmtSiblingMask(4).none());
+
   END_TEST;
 }
 
@@ -24,10 +24,14 @@
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
+#include <fbl/alloc_checker.h>
 #include <kernel/mp.h>
 #include <kernel/mutex.h>
 #include <kernel/scheduler.h>
 #include <kernel/thread.h>
+#include <ktl/algorithm.h>
+#include <ktl/atomic.h>
+#include <ktl/unique_ptr.h>
 #include <vm/vm_aspace.h>
 
 // External references to the testcase registration tables.
@@ -47,7 +51,8 @@ void usage(const char* progname) {
       "  where case is a specific testcase name, or...\n"
       "  all : run all tests\n"
       "  ?   : list tests\n"
-      "  [-r num]  : repeat a test case num times\n",
+      "  [-r num]  : repeat a test case num times\n"
+      "  [-p]  : run isolated test cases concurrently across CPUs\n",
       progname);
 }
 
@@ -75,7 +80,10 @@ void list_cases(void) {
   }
 }
 
-bool run_unittest(const unittest_testcase_registration_t* testcase) {
+// Runs every test of |testcase|.  When |quiet|, as when test cases run
+// concurrently and whole lines are needed to keep the output legible, only
+// failing tests and the summary are reported.
+bool run_unittest(const unittest_testcase_registration_t* testcase, bool quiet) {
   size_t max_namelen = 0;
   size_t passed = 0;
 
@@ -92,8 +100,10 @@ bool run_unittest(const unittest_testcase_registration_t* testcase) {
     }
   }
 
-  unittest_printf("%s : Running %zu test%s...\n", testcase->name, testcase->test_cnt,
-                  testcase->test_cnt == 1 ? "" : "s");
+  if (!quiet) {
+    unittest_printf("%s : Running %zu test%s...\n", testcase->name, testcase->test_cnt,
+                    testcase->test_cnt == 1 ? "" : "s");
+  }
 
   zx_instant_mono_t testcase_start = current_mono_time();
 
@@ -101,7 +111,9 @@ bool run_unittest(const unittest_testcase_registration_t* testcase) {
     for (size_t i = 0; i < testcase->test_cnt; ++i) {
       const unittest_registration_t* test = &testcase->tests[i];
 
-      unittest_printf("  %-*s : ", static_cast<int>(max_namelen), test->name ? test->name : "");
+      if (!quiet) {
+        unittest_printf("  %-*s : ", static_cast<int>(max_namelen), test->name ? test->name : "");
+      }
 
       const cpu_mask_t online_mask_before = mp_get_online_mask();
       const cpu_mask_t active_mask_before = Scheduler::PeekActiveMask();
@@ -116,22 +128,33 @@ bool run_unittest(const unittest_testcase_registration_t* testcase) {
       if ((online_mask_before != online_mask_after) || (active_mask_before != active_mask_after)) {
         KERNEL_OOPS(
             "Online/active CPUs changed during test!\n"
-            "(online after=0x%08x before=0x%08x, active after=0x%08x before=0x%08x)\n",
-            online_mask_after, online_mask_before, active_mask_after, active_mask_before);
+            "(online after=%#" PRIx64 " before=%#" PRIx64 ", active after=%#" PRIx64
+            " before=%#" PRIx64 ")\n",
+            online_mask_after.word(0), online_mask_before.word(0), active_mask_after.word(0),
+            active_mask_before.word(0));
         good = false;
       }
 
-      unittest_printf("%s (%" PRIi64 " nSec) ", good ? "PASSED" : "FAILED", test_runtime);
-      if (g_repeat > 1) {
-        unittest_printf(" [%lu / %lu]", j + 1, g_repeat);
+      if (quiet) {
+        if (!good) {
+          unittest_printf("%s : %s : FAILED (%" PRIi64 " nSec) [%lu / %lu]\n", testcase->name,
+                          test->name ? test->name : "", test_runtime, j + 1, g_repeat);
+        }
+      } else {
+        unittest_printf("%s (%" PRIi64 " nSec) ", good ? "PASSED" : "FAILED", test_runtime);
+        if (g_repeat > 1) {
+          unittest_printf(" [%lu / %lu]", j + 1, g_repeat);
+        }
+        unittest_printf("\n");
       }
-      unittest_printf("\n");
       if (good) {
         if (j == g_repeat - 1) {
           passed++;
         }
       } else {
-        printf("  %-*s : ", static_cast<int>(max_namelen), test->name ? test->name : "");
+        if (!quiet) {
+          printf("  %-*s : ", static_cast<int>(max_namelen), test->name ? test->name : "");
+        }
         break;
       }
     }
@@ -146,18 +169,23 @@ bool run_unittest(const unittest_testcase_registration_t* testcase) {
   return passed == testcase->test_cnt;
 }
 
+struct TestcaseRun {
+  const unittest_testcase_registration_t* testcase;
+  bool quiet;
+};
+
 // Runs the testcase specified by |arg| and returns 1 if test passes.
 //
-// |arg| is a const unittest_testcase_registration_t*.
+// |arg| is a const TestcaseRun*.
 int run_unittest_thread_entry(void* arg) {
-  auto* testcase = static_cast<const unittest_testcase_registration_t*>(arg);
-  return run_unittest(testcase);
+  auto* run = static_cast<const TestcaseRun*>(arg);
+  return run_unittest(run->testcase, run->quiet);
 }
 
 // Runs |testcase| in another thread and waits for it to complete.
 //
 // Returns true if the test passed.
-bool run_testcase_in_thread(const unittest_testcase_registration_t* testcase) {
+bool run_testcase_in_thread(const unittest_testcase_registration_t* testcase, bool quiet = false) {
   fbl::RefPtr<VmAspace> aspace = VmAspace::Create(VmAspace::Type::User, "unittest");
   if (!aspace) {
     unittest_printf("failed to create unittest user aspace\n");
@@ -167,9 +195,8 @@ bool run_testcase_in_thread(const unittest_testcase_registration_t* testcase) {
     zx_status_t status = aspace->Destroy();
     DEBUG_ASSERT(status == ZX_OK);
   });
-  Thread* t =
-      Thread::Create("unittest", run_unittest_thread_entry,
-                     const_cast<void*>(static_cast<const void*>(testcase)), DEFAULT_PRIORITY);
+  TestcaseRun run{testcase, quiet};
+  Thread* t = Thread::Create("unittest", run_unittest_thread_entry, &run, DEFAULT_PRIORITY);
   if (!t) {
     unittest_printf("failed to create unittest thread\n");
     return false;
@@ -187,6 +214,60 @@ bool run_testcase_in_thread(const unittest_testcase_registration_t* testcase) {
   return success;
 }
 
+// Shared state of the workers running isolated test cases concurrently.
+struct ParallelRun {
+  const unittest_testcase_registration_t* const* testcases;
+  size_t count;
+  bool* passed;
+  ktl::atomic<size_t> next{0};
+};
+
+// Runs test cases of the ParallelRun |arg| until none are left.
+int parallel_worker_entry(void* arg) {
+  auto* run = static_cast<ParallelRun*>(arg);
+  size_t i = run->next.fetch_add(1, ktl::memory_order_relaxed);
+  for (; i < run->count; i = run->next.fetch_add(1, ktl::memory_order_relaxed)) {
+    run->passed[i] = run_testcase_in_thread(run->testcases[i], /*quiet=*/true);
+  }
+  return 0;
+}
+
+// Runs the |count| isolated |testcases| concurrently, with as many workers as
+// there are online CPUs, and records which passed in |passed|.
+//
+// Returns false if the workers could not be started.
+bool run_testcases_in_parallel(const unittest_testcase_registration_t* const* testcases,
+                               size_t count, bool* passed) {
+  const size_t num_workers = ktl::min<size_t>(count, mp_get_online_mask().count());
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<Thread*[]> workers(new (&ac) Thread*[num_workers]);
+  if (!ac.check()) {
+    unittest_printf("failed to allocate unittest workers\n");
+    return false;
+  }
+
+  unittest_printf("Running %zu isolated test case%s on %zu CPU%s...\n", count,
+                  count == 1 ? "" : "s", num_workers, num_workers == 1 ? "" : "s");
+  ParallelRun run{.testcases = testcases, .count = count, .passed = passed};
+  size_t started = 0;
+  for (; started < num_workers; ++started) {
+    workers[started] =
+        Thread::Create("unittest-worker", parallel_worker_entry, &run, DEFAULT_PRIORITY);
+    if (!workers[started]) {
+      break;
+    }
+    workers[started]->Resume();
+  }
+  for (size_t i = 0; i < started; ++i) {
+    workers[i]->Join(nullptr, ZX_TIME_INFINITE);
+  }
+  if (started == 0) {
+    unittest_printf("failed to create unittest workers\n");
+    return false;
+  }
+  return true;
+}
+
 int run_unittests_locked(int argc, const cmd_args* argv, uint32_t flags)
     TA_REQ(UnittestLock::Get()) {
   DEBUG_ASSERT(UnittestLock::Get()->lock().IsHeld());
@@ -195,21 +276,28 @@ int run_unittests_locked(int argc, const cmd_args* argv, uint32_t flags)
     return 0;
   }
 
-  const char* casename = argv[1].str;
-
-  if (!strcmp(casename, "?")) {
+  if (!strcmp(argv[1].str, "?")) {
     list_cases();
     return 0;
   }
   g_repeat = 1;
-  if (!strcmp(casename, "-r")) {
-    if (argc < 4) {
+  bool parallel = false;
+  int arg = 1;
+  for (; arg < argc && argv[arg].str[0] == '-'; ++arg) {
+    if (!strcmp(argv[arg].str, "-r") && arg + 1 < argc) {
+      g_repeat = argv[++arg].u;
+    } else if (!strcmp(argv[arg].str, "-p")) {
+      parallel = true;
+    } else {
       usage(argv[0].str);
       return 0;
     }
-    g_repeat = argv[2].u;
-    casename = argv[3].str;
   }
+  if (arg >= argc) {
+    usage(argv[0].str);
+    return 0;
+  }
+  const char* casename = argv[arg].str;
 
   bool run_all = !strcmp(casename, "all");
   const unittest_testcase_registration_t* testcase;
@@ -221,8 +309,43 @@ int run_unittests_locked(int argc, const cmd_args* argv, uint32_t flags)
   const char** failed_names = static_cast<const char**>(calloc(num_tests + 1, sizeof(char*)));
   const char** fn = failed_names;
 
+  // Run the isolated test cases concurrently first, then the rest one at a time as usual.
+  bool ran_in_parallel = false;
+  if (parallel && run_all) {
+    fbl::AllocChecker ac;
+    ktl::unique_ptr<const unittest_testcase_registration_t*[]> isolated(
+        new (&ac) const unittest_testcase_registration_t*[num_tests]);
+    fbl::AllocChecker passed_ac;
+    ktl::unique_ptr<bool[]> isolated_passed(new (&passed_ac) bool[num_tests]);
+    if (ac.check() && passed_ac.check()) {
+      size_t num_isolated = 0;
+      for (testcase = __start_unittest_testcases; testcase != __stop_unittest_testcases;
+           ++testcase) {
+        if (testcase->name && (testcase->flags & UNITTEST_TESTCASE_FLAG_ISOLATED)) {
+          isolated[num_isolated++] = testcase;
+        }
+      }
+      if (num_isolated > 0 &&
+          run_testcases_in_parallel(isolated.get(), num_isolated, isolated_passed.get())) {
+        ran_in_parallel = true;
+        for (size_t i = 0; i < num_isolated; ++i) {
+          chosen++;
+          if (isolated_passed[i]) {
+            passed++;
+          } else {
+            *fn++ = isolated[i]->name;
+          }
+        }
+        printf("\n");
+      }
+    }
+  }
+
   for (testcase = __start_unittest_testcases; testcase != __stop_unittest_testcases; ++testcase) {
     if (testcase->name) {
+      if (ran_in_parallel && (testcase->flags & UNITTEST_TESTCASE_FLAG_ISOLATED)) {
+        continue;
+      }
       if (run_all || !strcmp(casename, testcase->name)) {
         chosen++;
 
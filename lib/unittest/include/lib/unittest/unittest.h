@@ -30,6 +30,14 @@
  * This creates an entry in the global unittest table and registers it with the
  * unit test framework.
  *
+ * A test case whose tests neither depend on nor disturb global state, such as
+ * system-wide counters or the set of online CPUs, can instead end with
+ *
+ *  UNITTEST_END_TESTCASE_WITH_FLAGS(foo_tests, "footest", "...",
+ *                                   UNITTEST_TESTCASE_FLAG_ISOLATED);
+ *
+ * which lets `ut -p all` run it concurrently with other isolated test cases.
+ *
  * A test looks like this, using the BEGIN_TEST and END_TEST macros at
  * the beginning and end of the test and the EXPECT_* macros to
  * validate test results, as shown:
@@ -369,6 +377,8 @@ bool unittest_testcase(const char* name, const test_case_element*, size_t n);
   ;                                                        \
   return unittest_testcase(name, cases, ktl::size(cases)); \
   }
+#define UNITTEST_END_TESTCASE_WITH_FLAGS(global_id, name, desc, flags) \
+  UNITTEST_END_TESTCASE(global_id, name, desc)
 
 #else  // _KERNEL
 
@@ -397,11 +407,16 @@ typedef struct unitest_registration {
   unittest_fn_t fn;
 } unittest_registration_t;
 
+// The tests of the test case touch no global state, so the test case may run
+// concurrently with other such test cases.
+#define UNITTEST_TESTCASE_FLAG_ISOLATED (1u << 0)
+
 typedef struct unitest_testcase_registration {
   const char* name;
   const char* desc;
   const unittest_registration_t* tests;
   size_t test_cnt;
+  uint32_t flags;
 } unittest_testcase_registration_t;
 
 #if LK_DEBUGLEVEL == 0
@@ -410,6 +425,7 @@ typedef struct unitest_testcase_registration {
   [[maybe_unused]] static void __unittest_table_##_global_id() {
 #define UNITTEST(_name, _fn) (void)(_fn);
 #define UNITTEST_END_TESTCASE(_global_id, _name, _desc) }
+#define UNITTEST_END_TESTCASE_WITH_FLAGS(_global_id, _name, _desc, _flags) }
 
 #else  // LK_DEBUGLEVEL != 0
 
@@ -417,7 +433,7 @@ typedef struct unitest_testcase_registration {
   static const unittest_registration_t __unittest_table_##_global_id[] = {
 #define UNITTEST(_name, _fn) {.name = _name, .fn = _fn},
 
-#define UNITTEST_END_TESTCASE(_global_id, _name, _desc)                                       \
+#define UNITTEST_END_TESTCASE_WITH_FLAGS(_global_id, _name, _desc, _flags)                    \
   }                                                                                           \
   ; /* __unittest_table_##_global_id */                                                       \
   static const unittest_testcase_registration_t __unittest_case_##_global_id SPECIAL_SECTION( \
@@ -426,7 +442,10 @@ typedef struct unitest_testcase_registration {
       .desc = _desc,                                                                          \
       .tests = __unittest_table_##_global_id,                                                 \
       .test_cnt = std::size(__unittest_table_##_global_id),                                   \
+      .flags = _flags,                                                                        \
   };
+#define UNITTEST_END_TESTCASE(_global_id, _name, _desc) \
+  UNITTEST_END_TESTCASE_WITH_FLAGS(_global_id, _name, _desc, 0)
 
 #endif  // LK_DEBUGLEVEL == 0
 
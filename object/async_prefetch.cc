@@ -0,0 +1,162 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "object/async_prefetch.h"
+
+#include <assert.h>
+#include <lib/counters.h>
+#include <stdio.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/intrusive_double_list.h>
+#include <kernel/mutex.h>
+#include <kernel/semaphore.h>
+#include <kernel/thread.h>
+#include <ktl/unique_ptr.h>
+#include <lk/init.h>
+#include <object/port_dispatcher.h>
+#include <object/process_dispatcher.h>
+
+#include <ktl/enforce.h>
+
+KCOUNTER(async_prefetch_quota_exceeded, "object.async_prefetch.quota_exceeded")
+KCOUNTER(async_prefetch_port_closed, "object.async_prefetch.port_closed")
+
+namespace {
+
+// Charged by prefetches queued from kernel threads, which have no process.
+AsyncPrefetchQuota gKernelAsyncPrefetchQuota;
+
+// An outstanding QueueAsyncPrefetch request. It lives until its packet is freed by the port, and
+// keeps the process whose quota it is charged to alive until then.
+//
+// The request is the allocator of its own packet, so that freeing the packet frees the request.
+struct AsyncPrefetch final : public fbl::DoublyLinkedListable<ktl::unique_ptr<AsyncPrefetch>>,
+                             public PortAllocator {
+  PortPacket* Alloc() final { return nullptr; }
+  void Free(PortPacket* port_packet) final {
+    DEBUG_ASSERT(port_packet == &packet);
+    quota->Release();
+    delete this;
+  }
+
+  AsyncPrefetchFunction prefetch;
+  uint64_t arg0;
+  uint64_t arg1;
+  fbl::RefPtr<PortDispatcher> port;
+  fbl::RefPtr<ProcessDispatcher> process;
+  AsyncPrefetchQuota* quota;
+  // Embedded so that completion cannot fail for lack of memory. As it does not come from the
+  // port's default allocator, queuing it is not subject to the port's packet limit.
+  PortPacket packet{nullptr, this};
+};
+
+// The number of worker threads servicing QueueAsyncPrefetch.
+constexpr size_t kAsyncPrefetchThreads = 4;
+
+DECLARE_SINGLETON_MUTEX(AsyncPrefetchLock);
+fbl::DoublyLinkedList<ktl::unique_ptr<AsyncPrefetch>> gAsyncPrefetchQueue
+    TA_GUARDED(AsyncPrefetchLock::Get());
+Semaphore gAsyncPrefetchPending;
+
+int AsyncPrefetchWorker(void*) {
+  for (;;) {
+    [[maybe_unused]] zx_status_t wait_status = gAsyncPrefetchPending.Wait(Deadline::infinite());
+    DEBUG_ASSERT(wait_status == ZX_OK);
+
+    ktl::unique_ptr<AsyncPrefetch> request;
+    {
+      Guard<Mutex> guard{AsyncPrefetchLock::Get()};
+      request = gAsyncPrefetchQueue.pop_front();
+    }
+    DEBUG_ASSERT(request);
+
+    const zx_status_t status = request->prefetch();
+
+    zx_port_packet_t& packet = request->packet.packet;
+    packet.type = ZX_PKT_TYPE_USER;
+    packet.status = status;
+    packet.user.u64[0] = request->arg0;
+    packet.user.u64[1] = request->arg1;
+
+    // The port owns the request once the packet is queued. This can only fail if the port has
+    // lost all its handles, and there is then nobody left to report the completion to.
+    fbl::RefPtr<PortDispatcher> port = ktl::move(request->port);
+    AsyncPrefetch* queued = request.release();
+    if (zx_status_t queue_status = port->Queue(&queued->packet); queue_status != ZX_OK) {
+      DEBUG_ASSERT(queue_status == ZX_ERR_BAD_HANDLE);
+      kcounter_add(async_prefetch_port_closed, 1);
+      queued->packet.Free();
+    }
+  }
+  return 0;
+}
+
+void AsyncPrefetchInit(unsigned int level) {
+  for (size_t i = 0; i < kAsyncPrefetchThreads; i++) {
+    char name[ZX_MAX_NAME_LEN];
+    snprintf(name, sizeof(name), "vmo-prefetch-%zu", i);
+    Thread* thread = Thread::Create(name, AsyncPrefetchWorker, nullptr, DEFAULT_PRIORITY);
+    ASSERT(thread != nullptr);
+    thread->DetachAndResume();
+  }
+}
+
+}  // namespace
+
+LK_INIT_HOOK(vmo_async_prefetch, AsyncPrefetchInit, LK_INIT_LEVEL_THREADING)
+
+bool AsyncPrefetchQuota::TryAcquire() {
+  uint32_t outstanding = outstanding_.load(ktl::memory_order_relaxed);
+  do {
+    if (outstanding >= kMaxOutstanding) {
+      return false;
+    }
+  } while (!outstanding_.compare_exchange_weak(outstanding, outstanding + 1,
+                                               ktl::memory_order_relaxed));
+  return true;
+}
+
+void AsyncPrefetchQuota::Release() {
+  [[maybe_unused]] const uint32_t previous = outstanding_.fetch_sub(1, ktl::memory_order_relaxed);
+  DEBUG_ASSERT(previous > 0);
+}
+
+AsyncPrefetchQuota& CurrentAsyncPrefetchQuota() {
+  ProcessDispatcher* process = ProcessDispatcher::GetCurrent();
+  return process != nullptr ? process->async_prefetch_quota() : gKernelAsyncPrefetchQuota;
+}
+
+zx_status_t QueueAsyncPrefetch(AsyncPrefetchFunction prefetch, fbl::RefPtr<PortDispatcher> port,
+                               uint64_t key, uint64_t arg0, uint64_t arg1) {
+  ProcessDispatcher* process = ProcessDispatcher::GetCurrent();
+  AsyncPrefetchQuota& quota = CurrentAsyncPrefetchQuota();
+  if (!quota.TryAcquire()) {
+    kcounter_add(async_prefetch_quota_exceeded, 1);
+    return ZX_ERR_SHOULD_WAIT;
+  }
+
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<AsyncPrefetch> request(new (&ac) AsyncPrefetch);
+  if (!ac.check()) {
+    quota.Release();
+    return ZX_ERR_NO_MEMORY;
+  }
+  request->packet.packet.key = key;
+  request->prefetch = ktl::move(prefetch);
+  request->arg0 = arg0;
+  request->arg1 = arg1;
+  request->port = ktl::move(port);
+  request->process = fbl::RefPtr(process);
+  request->quota = &quota;
+
+  {
+    Guard<Mutex> guard{AsyncPrefetchLock::Get()};
+    gAsyncPrefetchQueue.push_back(ktl::move(request));
+  }
+  gAsyncPrefetchPending.Post();
+  return ZX_OK;
+}
@@ -18,6 +18,8 @@
 
 #include <fbl/alloc_checker.h>
 #include <kernel/event.h>
+#include <lk/init.h>
+#include <object/dispatcher_cache.h>
 #include <object/handle.h>
 #include <object/message_packet.h>
 #include <object/process_dispatcher.h>
@@ -34,6 +36,36 @@ KCOUNTER(channel_packet_depth_unbounded, "channel.depth.unbounded")
 KCOUNTER(channel_full, "channel.full")
 KCOUNTER(dispatcher_channel_create_count, "dispatcher.channel.create")
 KCOUNTER(dispatcher_channel_destroy_count, "dispatcher.channel.destroy")
+KCOUNTER(dispatcher_channel_cache_slabs, "dispatcher.channel.cache.slabs")
+
+namespace {
+
+// Counts the slabs of the channel cache on top of the totals for all object caches.
+struct ChannelCacheAllocator : object_cache::DefaultAllocator {
+  static void CountSlabAllocation() {
+    DefaultAllocator::CountSlabAllocation();
+    kcounter_add(dispatcher_channel_cache_slabs, 1);
+  }
+  static void CountSlabFree() {
+    DefaultAllocator::CountSlabFree();
+    kcounter_add(dispatcher_channel_cache_slabs, -1);
+  }
+};
+
+DispatcherCache<ChannelDispatcher, ChannelCacheAllocator> channel_cache;
+
+void channel_cache_init(uint level) { channel_cache.Init(); }
+
+}  // namespace
+
+void* ChannelDispatcher::operator new(size_t size, fbl::AllocChecker* ac) noexcept {
+  return channel_cache.Allocate(size, ac);
+}
+
+void ChannelDispatcher::operator delete(void* ptr, size_t size) { channel_cache.Free(ptr, size); }
+
+// Initialize the cache after the percpu data structures are initialized.
+LK_INIT_HOOK(channel_dispatcher_cache_init, channel_cache_init, LK_INIT_LEVEL_KERNEL)
 
 namespace {
 
@@ -108,6 +140,21 @@ uint64_t ChannelMessageFlowId(const MessagePacket& msg, const ChannelDispatcher*
   return high << 32 | low;
 }
 
+// Marks wakeups issued by the current thread as synchronous for the lifetime of the object. Used
+// where the current thread is handing a message to a thread that it will then block waiting on, so
+// the scheduler can run the woken thread on this CPU. See Thread::Current::set_sync_wakeup.
+class AutoSyncWakeup {
+ public:
+  AutoSyncWakeup() : previous_(Thread::Current::set_sync_wakeup(true)) {}
+  ~AutoSyncWakeup() { Thread::Current::set_sync_wakeup(previous_); }
+
+  AutoSyncWakeup(const AutoSyncWakeup&) = delete;
+  AutoSyncWakeup& operator=(const AutoSyncWakeup&) = delete;
+
+ private:
+  const bool previous_;
+};
+
 enum class MessageOp : uint8_t {
   Write,
   Read,
@@ -343,6 +390,57 @@ zx_status_t ChannelDispatcher::Read(zx_koid_t owner, uint32_t* msg_size, uint32_
   return status;
 }
 
+// This method should never acquire |get_lock()|.  See the comment at |channel_lock_| for details.
+zx_status_t ChannelDispatcher::ReadMany(zx_koid_t owner, uint32_t* total_size,
+                                        uint32_t* total_handle_count,
+                                        ktl::span<MessagePacketPtr> msgs, size_t* num_msgs) {
+  canary_.Assert();
+
+  DEBUG_ASSERT(!msgs.empty());
+  uint32_t size_remaining = *total_size;
+  uint32_t handles_remaining = *total_handle_count;
+  size_t count = 0;
+
+  Guard<CriticalMutex> guard{&channel_lock_};
+
+  if (owner != owner_) {
+    return ZX_ERR_BAD_HANDLE;
+  }
+
+  if (messages_.is_empty()) {
+    return peer_has_closed_ ? ZX_ERR_PEER_CLOSED : ZX_ERR_SHOULD_WAIT;
+  }
+
+  if (messages_.front().data_size() > size_remaining ||
+      messages_.front().num_handles() > handles_remaining) {
+    *total_size = messages_.front().data_size();
+    *total_handle_count = messages_.front().num_handles();
+    return ZX_ERR_BUFFER_TOO_SMALL;
+  }
+
+  while (count < msgs.size() && !messages_.is_empty()) {
+    const MessagePacket& next = messages_.front();
+    if (next.data_size() > size_remaining || next.num_handles() > handles_remaining) {
+      break;
+    }
+    size_remaining -= next.data_size();
+    handles_remaining -= next.num_handles();
+    msgs[count] = messages_.pop_front();
+    TraceMessage(*msgs[count], this, MessageOp::Read);
+    count++;
+  }
+  DEBUG_ASSERT(count > 0);
+
+  if (messages_.is_empty()) {
+    ClearSignals(ZX_CHANNEL_READABLE);
+  }
+
+  *total_size -= size_remaining;
+  *total_handle_count -= handles_remaining;
+  *num_msgs = count;
+  return ZX_OK;
+}
+
 zx_status_t ChannelDispatcher::Write(zx_koid_t owner, MessagePacketPtr msg) {
   canary_.Assert();
 
@@ -364,8 +462,13 @@ zx_status_t ChannelDispatcher::Write(zx_koid_t owner, MessagePacketPtr msg) {
 
   AssertHeld(*peer()->get_lock());
 
-  if (peer()->TryWriteToMessageWaiter(msg)) {
-    return ZX_OK;
+  {
+    // A reply delivered to a waiting caller hands control back to it, and the replying thread is
+    // typically about to go back to waiting for its next request.
+    AutoSyncWakeup sync_wakeup;
+    if (peer()->TryWriteToMessageWaiter(msg)) {
+      return ZX_OK;
+    }
   }
 
   peer()->WriteSelf(ktl::move(msg));
@@ -373,6 +476,44 @@ zx_status_t ChannelDispatcher::Write(zx_koid_t owner, MessagePacketPtr msg) {
   return ZX_OK;
 }
 
+zx_status_t ChannelDispatcher::WriteMany(zx_koid_t owner, ktl::span<MessagePacketPtr> msgs) {
+  canary_.Assert();
+
+  Guard<CriticalMutex> guard{get_lock()};
+
+  // See Write() for an explanation of this test.
+  if (owner != owner_) {
+    return ZX_ERR_BAD_HANDLE;
+  }
+
+  if (!peer()) {
+    return ZX_ERR_PEER_CLOSED;
+  }
+
+  AssertHeld(*peer()->get_lock());
+
+  // Deliver any replies to waiting callers first, compacting the remaining messages to the front of
+  // |msgs| so they can be queued together while preserving their order.
+  size_t queued = 0;
+  for (size_t i = 0; i < msgs.size(); i++) {
+    DEBUG_ASSERT(msgs[i]);
+    TraceMessage(*msgs[i], this, MessageOp::Write);
+    if (peer()->TryWriteToMessageWaiter(msgs[i])) {
+      continue;
+    }
+    if (queued != i) {
+      msgs[queued] = ktl::move(msgs[i]);
+    }
+    queued++;
+  }
+
+  if (queued > 0) {
+    peer()->WriteSelf(msgs.subspan(0, queued));
+  }
+
+  return ZX_OK;
+}
+
 zx_txid_t ChannelDispatcher::GenerateTxid() {
   // Values 1..kMinKernelGeneratedTxid are reserved for userspace.
   return (++txid_) | kMinKernelGeneratedTxid;
@@ -466,8 +607,10 @@ zx_status_t ChannelDispatcher::Call(zx_koid_t owner, MessagePacketPtr msg,
     // waiter to the list.
     waiters_.push_back(waiter);
 
-    // (1) Write outbound message to opposing endpoint.
+    // (1) Write outbound message to opposing endpoint. We are about to block waiting for the reply,
+    // so let a server thread that is woken by this message run on our CPU.
     AssertHeld(*peer()->get_lock());
+    AutoSyncWakeup sync_wakeup;
     peer()->WriteSelf(ktl::move(msg));
   }
 
@@ -553,11 +696,13 @@ bool ChannelDispatcher::TryWriteToMessageWaiter(MessagePacketPtr& msg) {
   return false;
 }
 
-void ChannelDispatcher::WriteSelf(MessagePacketPtr msg) {
+void ChannelDispatcher::WriteSelf(ktl::span<MessagePacketPtr> msgs) {
   canary_.Assert();
 
   // Once we've acquired the channel_lock_ we're going to make a copy of the previously active
-  // signals and raise the READABLE signal before dropping the lock.  After we've dropped the lock,
+  // signals and raise the READABLE signal before dropping the lock. When writing a batch of
+  // messages all of them are queued under a single acquisition, so the signal is raised and
+  // observers notified once for the whole batch.  After we've dropped the lock,
   // we'll notify observers using the previously active signals plus READABLE.
   //
   // There are several things to note about this sequence:
@@ -576,33 +721,11 @@ void ChannelDispatcher::WriteSelf(MessagePacketPtr msg) {
   {
     Guard<CriticalMutex> guard{&channel_lock_};
 
-    messages_.push_back(ktl::move(msg));
-    previous_signals = RaiseSignalsLocked(ZX_CHANNEL_READABLE);
-    const size_t size = messages_.size();
-    if (size > max_message_count_) {
-      max_message_count_ = size;
-    }
-    // TODO(cpu): Remove this hack. See comment in kMaxPendingMessageCount definition.
-    if (size >= kWarnPendingMessageCount) {
-      if (size == kWarnPendingMessageCount) {
-        const auto* process = ProcessDispatcher::GetCurrent();
-        char pname[ZX_MAX_NAME_LEN];
-        [[maybe_unused]] zx_status_t status = process->get_name(pname);
-        DEBUG_ASSERT(status == ZX_OK);
-        printf("KERN: warning! channel (%zu) has %zu messages (%s) (peer: %zu) (write).\n",
-               get_koid(), size, pname, peer()->owner_);
-      } else if (size > kMaxPendingMessageCount) {
-        const auto* process = ProcessDispatcher::GetCurrent();
-        char pname[ZX_MAX_NAME_LEN];
-        [[maybe_unused]] zx_status_t status = process->get_name(pname);
-        DEBUG_ASSERT(status == ZX_OK);
-        printf(
-            "KERN: channel (%zu) has %zu messages (%s) (peer: %zu) (write). Raising exception.\n",
-            get_koid(), size, pname, peer()->owner_);
-        Thread::Current::SignalPolicyException(ZX_EXCP_POLICY_CODE_CHANNEL_FULL_WRITE, 0u);
-        kcounter_add(channel_full, 1);
-      }
+    for (MessagePacketPtr& msg : msgs) {
+      messages_.push_back(ktl::move(msg));
+      CheckPendingMessageCountLocked(messages_.size());
     }
+    previous_signals = RaiseSignalsLocked(ZX_CHANNEL_READABLE);
   }
 
   // Don't bother waking observers if ZX_CHANNEL_READABLE was already active.
@@ -611,6 +734,32 @@ void ChannelDispatcher::WriteSelf(MessagePacketPtr msg) {
   }
 }
 
+void ChannelDispatcher::CheckPendingMessageCountLocked(size_t size) {
+  if (size > max_message_count_) {
+    max_message_count_ = size;
+  }
+  // TODO(cpu): Remove this hack. See comment in kMaxPendingMessageCount definition.
+  if (size >= kWarnPendingMessageCount) {
+    if (size == kWarnPendingMessageCount) {
+      const auto* process = ProcessDispatcher::GetCurrent();
+      char pname[ZX_MAX_NAME_LEN];
+      [[maybe_unused]] zx_status_t status = process->get_name(pname);
+      DEBUG_ASSERT(status == ZX_OK);
+      printf("KERN: warning! channel (%zu) has %zu messages (%s) (peer: %zu) (write).\n",
+             get_koid(), size, pname, peer()->owner_);
+    } else if (size > kMaxPendingMessageCount) {
+      const auto* process = ProcessDispatcher::GetCurrent();
+      char pname[ZX_MAX_NAME_LEN];
+      [[maybe_unused]] zx_status_t status = process->get_name(pname);
+      DEBUG_ASSERT(status == ZX_OK);
+      printf("KERN: channel (%zu) has %zu messages (%s) (peer: %zu) (write). Raising exception.\n",
+             get_koid(), size, pname, peer()->owner_);
+      Thread::Current::SignalPolicyException(ZX_EXCP_POLICY_CODE_CHANNEL_FULL_WRITE, 0u);
+      kcounter_add(channel_full, 1);
+    }
+  }
+}
+
 ChannelDispatcher::MessageWaiter::~MessageWaiter() {
   if (unlikely(channel_)) {
     channel_->RemoveWaiter(this);
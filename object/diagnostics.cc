@@ -21,6 +21,7 @@
 #include <object/handle.h>
 #include <object/io_buffer_dispatcher.h>
 #include <object/job_dispatcher.h>
+#include <object/mbuf.h>
 #include <object/process_dispatcher.h>
 #include <object/socket_dispatcher.h>
 #include <object/vm_object_dispatcher.h>
@@ -1235,6 +1236,7 @@ int cmd_diagnostics(int argc, const cmd_args* argv, uint32_t flags) {
     printf("%s kill <pid>        : kill process\n", argv[0].str);
     printf("%s asd  <pid>|kernel : dump process/kernel address space\n", argv[0].str);
     printf("%s htinfo            : handle table info\n", argv[0].str);
+    printf("%s mbuf              : socket buffer memory usage\n", argv[0].str);
     printf("%s koid <koid>       : list all handles for a koid\n", argv[0].str);
     printf("%s koid help         : print header label descriptions for 'koid'\n", argv[0].str);
     printf("%s ch   <koid>       : dump channels for pid or for all processes,\n", argv[0].str);
@@ -1353,6 +1355,10 @@ int cmd_diagnostics(int argc, const cmd_args* argv, uint32_t flags) {
     if (argc != 2)
       goto usage;
     DumpHandleTable();
+  } else if (strcmp(argv[1].str, "mbuf") == 0) {
+    if (argc != 2)
+      goto usage;
+    MBufChain::DumpMemoryUsage();
   } else if (strcmp(argv[1].str, "koid") == 0) {
     if (argc < 3)
       goto usage;
@@ -92,7 +92,9 @@ zx_status_t Dispatcher::AddObserver(SignalObserver* observer, const void* handle
     const zx_signals_t active_signals = signals_.load(ktl::memory_order_acquire);
     if ((active_signals & signals) != 0) {
       observer->OnMatch(active_signals);
-      return ZX_OK;
+      if (!observer->IsPersistent()) {
+        return ZX_OK;
+      }
     }
   }
 
@@ -100,6 +102,7 @@ zx_status_t Dispatcher::AddObserver(SignalObserver* observer, const void* handle
   observer->handle_ = handle;
   observer->triggering_signals_ = signals;
   observers_.push_front(observer);
+  observed_signals_ |= signals;
 
   return ZX_OK;
 }
@@ -118,6 +121,9 @@ bool Dispatcher::RemoveObserver(SignalObserver* observer, zx_signals_t* signals)
 
   if (observer->InContainer()) {
     observers_.erase(*observer);
+    if (observers_.is_empty()) {
+      observed_signals_ = 0;
+    }
     return true;
   }
 
@@ -133,8 +139,10 @@ void Dispatcher::Cancel(const void* handle) {
   const zx_signals_t signals = signals_.load(ktl::memory_order_acquire);
 
   // Cancel all observers that registered on "handle".
+  zx_signals_t observed = 0;
   for (auto it = observers_.begin(); it != observers_.end(); /* nothing */) {
     if (it->handle_ != handle) {
+      observed |= it->triggering_signals_;
       ++it;
       continue;
     }
@@ -145,6 +153,7 @@ void Dispatcher::Cancel(const void* handle) {
     observers_.erase(to_remove);
     to_remove->OnCancel(signals);
   }
+  observed_signals_ = observed;
 }
 
 bool Dispatcher::CancelByKey(const void* handle, const void* port, uint64_t key) {
@@ -157,8 +166,10 @@ bool Dispatcher::CancelByKey(const void* handle, const void* port, uint64_t key)
 
   // Cancel all observers that registered on "handle" that match the given key.
   bool remove_performed = false;
+  zx_signals_t observed = 0;
   for (auto it = observers_.begin(); it != observers_.end(); /* nothing */) {
     if (it->handle_ != handle || !it->MatchesKey(port, key)) {
+      observed |= it->triggering_signals_;
       ++it;
       continue;
     }
@@ -170,6 +181,7 @@ bool Dispatcher::CancelByKey(const void* handle, const void* port, uint64_t key)
     to_remove->OnCancel(signals);
     remove_performed = true;
   }
+  observed_signals_ = observed;
 
   return remove_performed;
 }
@@ -183,24 +195,52 @@ void Dispatcher::UpdateState(zx_signals_t clear_mask, zx_signals_t set_mask,
     return;
   }
 
+  // Raising signals that are all already active cannot trigger any observer, which leaves only the
+  // clearing of the others to do, and that does not need the lock either.  A producer signaling
+  // faster than its consumer clears the signal is usually in this state.
+  if (strobe_mask == 0) {
+    zx_signals_t previous = signals_.load(ktl::memory_order_acquire);
+    while ((previous & set_mask) == set_mask) {
+      if (signals_.compare_exchange_weak(previous, previous & ~(clear_mask & ~set_mask),
+                                         ktl::memory_order_acq_rel, ktl::memory_order_acquire)) {
+        return;
+      }
+    }
+  }
+
   Guard<CriticalMutex> guard{get_lock()};
 
   UpdateStateLocked(clear_mask, set_mask, strobe_mask);
 }
 
 void Dispatcher::NotifyObserversLocked(zx_signals_t signals) {
+  // No observer triggers on any of these signals.
+  if ((observed_signals_ & signals) == 0) {
+    return;
+  }
+
+  zx_signals_t observed = 0;
   for (auto it = observers_.begin(); it != observers_.end(); /* nothing */) {
     // Ignore observers that don't need to be notified.
     if ((it->triggering_signals_ & signals) == 0) {
+      observed |= it->triggering_signals_;
       ++it;
       continue;
     }
 
+    // Persistent observers stay registered.
+    if (it->IsPersistent()) {
+      observed |= it->triggering_signals_;
+      (it++)->OnMatch(signals);
+      continue;
+    }
+
     auto to_remove = it;
     ++it;
     observers_.erase(to_remove);
     to_remove->OnMatch(signals);
   }
+  observed_signals_ = observed;
 }
 
 void Dispatcher::UpdateStateLocked(zx_signals_t clear_mask, zx_signals_t set_mask,
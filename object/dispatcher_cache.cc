@@ -0,0 +1,33 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <object/dispatcher_cache.h>
+
+#include <kernel/mutex.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+DECLARE_SINGLETON_MUTEX(DispatcherCacheLock);
+fbl::DoublyLinkedList<DispatcherCacheBase*> dispatcher_caches
+    TA_GUARDED(DispatcherCacheLock::Get());
+
+}  // namespace
+
+void DispatcherCacheBase::Register() {
+  Guard<Mutex> guard{DispatcherCacheLock::Get()};
+  dispatcher_caches.push_back(this);
+}
+
+size_t DispatcherCacheBase::TrimAll() {
+  Guard<Mutex> guard{DispatcherCacheLock::Get()};
+  size_t slabs = 0;
+  for (DispatcherCacheBase& cache : dispatcher_caches) {
+    slabs += cache.Trim();
+  }
+  return slabs;
+}
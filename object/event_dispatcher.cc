@@ -12,9 +12,41 @@
 #include <zircon/types.h>
 
 #include <fbl/alloc_checker.h>
+#include <lk/init.h>
+#include <object/dispatcher_cache.h>
 
 KCOUNTER(dispatcher_event_create_count, "dispatcher.event.create")
 KCOUNTER(dispatcher_event_destroy_count, "dispatcher.event.destroy")
+KCOUNTER(dispatcher_event_cache_slabs, "dispatcher.event.cache.slabs")
+
+namespace {
+
+// Counts the slabs of the event cache on top of the totals for all object caches.
+struct EventCacheAllocator : object_cache::DefaultAllocator {
+  static void CountSlabAllocation() {
+    DefaultAllocator::CountSlabAllocation();
+    kcounter_add(dispatcher_event_cache_slabs, 1);
+  }
+  static void CountSlabFree() {
+    DefaultAllocator::CountSlabFree();
+    kcounter_add(dispatcher_event_cache_slabs, -1);
+  }
+};
+
+DispatcherCache<EventDispatcher, EventCacheAllocator> event_cache;
+
+void event_cache_init(uint level) { event_cache.Init(); }
+
+}  // namespace
+
+void* EventDispatcher::operator new(size_t size, fbl::AllocChecker* ac) noexcept {
+  return event_cache.Allocate(size, ac);
+}
+
+void EventDispatcher::operator delete(void* ptr, size_t size) { event_cache.Free(ptr, size); }
+
+// Initialize the cache after the percpu data structures are initialized.
+LK_INIT_HOOK(event_dispatcher_cache_init, event_cache_init, LK_INIT_LEVEL_KERNEL)
 
 zx_status_t EventDispatcher::Create(uint32_t options, KernelHandle<EventDispatcher>* handle,
                                     zx_rights_t* rights) {
@@ -13,9 +13,43 @@
 #include <zircon/types.h>
 
 #include <fbl/alloc_checker.h>
+#include <lk/init.h>
+#include <object/dispatcher_cache.h>
 
 KCOUNTER(dispatcher_eventpair_create_count, "dispatcher.eventpair.create")
 KCOUNTER(dispatcher_eventpair_destroy_count, "dispatcher.eventpair.destroy")
+KCOUNTER(dispatcher_eventpair_cache_slabs, "dispatcher.eventpair.cache.slabs")
+
+namespace {
+
+// Counts the slabs of the event pair cache on top of the totals for all object caches.
+struct EventPairCacheAllocator : object_cache::DefaultAllocator {
+  static void CountSlabAllocation() {
+    DefaultAllocator::CountSlabAllocation();
+    kcounter_add(dispatcher_eventpair_cache_slabs, 1);
+  }
+  static void CountSlabFree() {
+    DefaultAllocator::CountSlabFree();
+    kcounter_add(dispatcher_eventpair_cache_slabs, -1);
+  }
+};
+
+DispatcherCache<EventPairDispatcher, EventPairCacheAllocator> event_pair_cache;
+
+void event_pair_cache_init(uint level) { event_pair_cache.Init(); }
+
+}  // namespace
+
+void* EventPairDispatcher::operator new(size_t size, fbl::AllocChecker* ac) noexcept {
+  return event_pair_cache.Allocate(size, ac);
+}
+
+void EventPairDispatcher::operator delete(void* ptr, size_t size) {
+  event_pair_cache.Free(ptr, size);
+}
+
+// Initialize the cache after the percpu data structures are initialized.
+LK_INIT_HOOK(event_pair_dispatcher_cache_init, event_pair_cache_init, LK_INIT_LEVEL_KERNEL)
 
 zx_status_t EventPairDispatcher::Create(KernelHandle<EventPairDispatcher>* handle0,
                                         KernelHandle<EventPairDispatcher>* handle1,
@@ -59,6 +59,18 @@ bool HasRestrictedInThreadHandler() {
   RestrictedState* rs = Thread::Current::restricted_state();
   return rs != nullptr && rs->in_restricted();
 }
+
+// Hands an exception taken in restricted mode back to the thread's normal mode, with |report| in
+// the side-car.
+void DeliverRestrictedException(const zx_exception_report_t& report) {
+  RestrictedState* rs = Thread::Current::restricted_state();
+  DEBUG_ASSERT(rs != nullptr);
+  RedirectRestrictedExceptionToNormalMode(rs);
+
+  auto* exception = rs->state_ptr_as<zx_restricted_exception_t>();
+  DEBUG_ASSERT(exception != nullptr);
+  exception->exception = report;
+}
 }  // namespace
 
 // This isn't an "iterator" in the pure c++ sense. We don't need all that
@@ -109,14 +121,10 @@ class ExceptionHandlerIterator final {
           next_job_ = thread_->process()->job();
           break;
         case ExceptionDeliveryMethod::kRestrictedModeVectoredException: {
-          RestrictedState* rs = Thread::Current::restricted_state();
-          DEBUG_ASSERT(rs != nullptr);
-          RedirectRestrictedExceptionToNormalMode(rs);
-
-          // Write the exception report into the side-car.
-          auto* exception = rs->state_ptr_as<zx_restricted_exception_t>();
-          DEBUG_ASSERT(exception != nullptr);
-          exception_->FillReport(&exception->exception);
+          zx_exception_report_t report;
+          [[maybe_unused]] bool filled = exception_->FillReport(&report);
+          DEBUG_ASSERT(filled);
+          DeliverRestrictedException(report);
 
           // Handle the exception on behalf of restricted mode.
           //
@@ -196,6 +204,16 @@ static zx_status_t exception_handler_worker(uint exception_type,
 
   zx_exception_report_t report = ExceptionDispatcher::BuildArchReport(exception_type, *context);
 
+  // An exception taken in restricted mode with an in-thread handler goes straight back to normal
+  // mode unless a debugger is there to see it first, so when none is, skip creating the exception
+  // object that only the channels need. A debugger attaching concurrently is no different from one
+  // attaching just after the exception was handled.
+  if (HasRestrictedInThreadHandler() &&
+      !thread->process()->debug_exceptionate()->HasValidChannel()) {
+    DeliverRestrictedException(report);
+    return ZX_OK;
+  }
+
   fbl::RefPtr<ExceptionDispatcher> exception =
       ExceptionDispatcher::Create(fbl::RefPtr(thread), exception_type, &report, context);
   if (!exception) {
@@ -18,7 +18,7 @@ KCOUNTER(dispatcher_fifo_create_count, "dispatcher.fifo.create")
 KCOUNTER(dispatcher_fifo_destroy_count, "dispatcher.fifo.destroy")
 
 // static
-zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t options,
+zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t /*options*/,
                                    KernelHandle<FifoDispatcher>* handle0,
                                    KernelHandle<FifoDispatcher>* handle1, zx_rights_t* rights) {
   // count and elemsize must be nonzero
@@ -34,23 +34,24 @@ zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t optio
     return ZX_ERR_NO_MEMORY;
   auto holder1 = holder0;
 
-  auto data0 = ktl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
-  if (!ac.check())
-    return ZX_ERR_NO_MEMORY;
-
-  KernelHandle fifo0(fbl::AdoptRef(
-      new (&ac) FifoDispatcher(ktl::move(holder0), options, static_cast<uint32_t>(count),
-                               static_cast<uint32_t>(elemsize), ktl::move(data0))));
-  if (!ac.check())
-    return ZX_ERR_NO_MEMORY;
+  fbl::RefPtr<Ring> rings[2];
+  for (fbl::RefPtr<Ring>& ring : rings) {
+    auto data = ktl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
+    if (!ac.check())
+      return ZX_ERR_NO_MEMORY;
+    ring = fbl::AdoptRef(new (&ac) Ring(static_cast<uint32_t>(count),
+                                        static_cast<uint32_t>(elemsize), ktl::move(data)));
+    if (!ac.check())
+      return ZX_ERR_NO_MEMORY;
+  }
 
-  auto data1 = ktl::unique_ptr<uint8_t[]>(new (&ac) uint8_t[count * elemsize]);
+  KernelHandle fifo0(
+      fbl::AdoptRef(new (&ac) FifoDispatcher(ktl::move(holder0), rings[0], rings[1])));
   if (!ac.check())
     return ZX_ERR_NO_MEMORY;
 
-  KernelHandle fifo1(fbl::AdoptRef(
-      new (&ac) FifoDispatcher(ktl::move(holder1), options, static_cast<uint32_t>(count),
-                               static_cast<uint32_t>(elemsize), ktl::move(data1))));
+  KernelHandle fifo1(
+      fbl::AdoptRef(new (&ac) FifoDispatcher(ktl::move(holder1), rings[1], rings[0])));
   if (!ac.check())
     return ZX_ERR_NO_MEMORY;
 
@@ -63,14 +64,11 @@ zx_status_t FifoDispatcher::Create(size_t count, size_t elemsize, uint32_t optio
   return ZX_OK;
 }
 
-FifoDispatcher::FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder, uint32_t /*options*/,
-                               uint32_t count, uint32_t elem_size, ktl::unique_ptr<uint8_t[]> data)
+FifoDispatcher::FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder,
+                               fbl::RefPtr<Ring> read_ring, fbl::RefPtr<Ring> write_ring)
     : PeeredDispatcher(ktl::move(holder), ZX_FIFO_WRITABLE),
-      elem_count_(count),
-      elem_size_(elem_size),
-      head_(0u),
-      tail_(0u),
-      data_(ktl::move(data)) {
+      read_ring_(ktl::move(read_ring)),
+      write_ring_(ktl::move(write_ring)) {
   kcounter_add(dispatcher_fifo_create_count, 1);
 }
 
@@ -81,22 +79,58 @@ void FifoDispatcher::on_zero_handles_locked() { canary_.Assert(); }
 void FifoDispatcher::OnPeerZeroHandlesLocked() {
   canary_.Assert();
 
+  peer_closed_.store(true, ktl::memory_order_release);
   UpdateStateLocked(ZX_FIFO_WRITABLE, ZX_FIFO_PEER_CLOSED);
 }
 
+void FifoDispatcher::UpdateSignalsLocked() {
+  UpdateSelfSignalsLocked();
+  if (peer()) {
+    AssertHeld(*peer()->get_lock());
+    peer()->UpdateSelfSignalsLocked();
+  }
+}
+
+void FifoDispatcher::UpdateSelfSignalsLocked() {
+  zx_signals_t set = 0;
+  zx_signals_t clear = 0;
+  (read_ring_->IsEmpty() ? clear : set) |= ZX_FIFO_READABLE;
+  // Once the peer has closed this endpoint is never writable again.
+  if (!peer_closed_.load(ktl::memory_order_relaxed)) {
+    (write_ring_->IsFull() ? clear : set) |= ZX_FIFO_WRITABLE;
+  }
+  UpdateStateLocked(clear, set);
+}
+
+bool FifoDispatcher::Ring::IsEmpty() const {
+  return head_.load(ktl::memory_order_acquire) == tail_.load(ktl::memory_order_acquire);
+}
+
+bool FifoDispatcher::Ring::IsFull() const {
+  const uint32_t tail = tail_.load(ktl::memory_order_acquire);
+  return head_.load(ktl::memory_order_acquire) - tail == elem_count_;
+}
+
 zx_status_t FifoDispatcher::WriteFromUser(size_t elem_size, user_in_ptr<const uint8_t> ptr,
                                           size_t count, size_t* actual) {
   canary_.Assert();
 
   while (true) {
     ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> write_result;
+    bool signal_update = false;
     {
-      Guard<CriticalMutex> guard{get_lock()};
-      if (!peer()) {
+      if (peer_closed_.load(ktl::memory_order_acquire)) {
         return ZX_ERR_PEER_CLOSED;
       }
-      AssertHeld(*peer()->get_lock());
-      write_result = peer()->WriteSelfLocked(elem_size, ptr, count, actual);
+      if (elem_size != write_ring_->elem_size()) {
+        return ZX_ERR_OUT_OF_RANGE;
+      }
+      Guard<CriticalMutex> guard{&write_ring_->write_lock_};
+      write_result = write_ring_->Write(ptr, count, actual, &signal_update);
+    }
+    if (signal_update) {
+      Guard<CriticalMutex> guard{get_lock()};
+      UpdateSignalsLocked();
     }
     // Check for any regular error and return it.
     if (ktl::holds_alternative<zx_status_t>(write_result)) {
@@ -122,34 +156,34 @@ zx_status_t FifoDispatcher::WriteFromUser(size_t elem_size, user_in_ptr<const ui
   }
 }
 
-ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> FifoDispatcher::WriteSelfLocked(
-    size_t elem_size, user_in_ptr<const uint8_t> ptr, size_t count, size_t* actual) {
-  canary_.Assert();
-
-  if (elem_size != elem_size_) {
-    return ZX_ERR_OUT_OF_RANGE;
-  }
+ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> FifoDispatcher::Ring::Write(
+    user_in_ptr<const uint8_t> ptr, size_t count, size_t* actual, bool* signal_update) {
+  // |elem_size| is validated by the caller.
   if (count == 0) {
     return ZX_ERR_OUT_OF_RANGE;
   }
 
-  uint32_t old_head = head_;
+  // Only writers modify |head_|, and we hold the write lock. Acquiring |tail_| ensures the reader
+  // has finished copying out of any slots it released before we overwrite them.
+  const uint32_t old_head = head_.load(ktl::memory_order_relaxed);
+  const uint32_t old_tail = tail_.load(ktl::memory_order_acquire);
 
   // total number of available empty slots in the fifo
-  size_t avail = elem_count_ - (head_ - tail_);
+  size_t avail = elem_count_ - (old_head - old_tail);
 
   if (avail == 0) {
     return ZX_ERR_SHOULD_WAIT;
   }
 
-  bool was_empty = (avail == elem_count_);
-
   if (count > avail) {
     count = avail;
   }
 
+  // Copy everything before publishing the new head, so that a failed copy does not need rolling
+  // back and the reader never sees partially written elements.
+  uint32_t head = old_head;
   while (count > 0) {
-    uint32_t offset = (head_ % elem_count_);
+    uint32_t offset = (head % elem_count_);
 
     // number of slots from target to end, inclusive
     uint32_t n = elem_count_ - offset;
@@ -160,41 +194,48 @@ ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> FifoDispatcher::WriteSelf
     UserCopyCaptureFaultsResult result =
         ptr.copy_array_from_user_capture_faults(&data_[offset * elem_size_], to_copy * elem_size_);
     if (result.status != ZX_OK) {
-      // roll back, in case this is the second copy
-      head_ = old_head;
       return result;
     }
 
     // adjust head and count
     // due to size limitations on fifo, to_copy will always fit in a u32
-    head_ += static_cast<uint32_t>(to_copy);
+    head += static_cast<uint32_t>(to_copy);
     count -= to_copy;
     ptr = ptr.byte_offset(to_copy * elem_size_);
   }
 
-  // if was empty, we've become readable
-  if (was_empty) {
-    UpdateStateLocked(0u, ZX_FIFO_READABLE);
-  }
+  // Publish the elements, then check where the reader is. These are sequentially consistent so
+  // that for a racing reader that finds the ring empty, at least one of us observes the other and
+  // recomputes the signals, and READABLE cannot be lost.
+  head_.store(head, ktl::memory_order_seq_cst);
+  const uint32_t tail = tail_.load(ktl::memory_order_seq_cst);
 
-  // if now full, we're no longer writable
-  if (elem_count_ == (head_ - tail_)) {
-    AssertHeld(*peer()->get_lock());
-    peer()->UpdateStateLocked(ZX_FIFO_WRITABLE, 0u);
-  }
-
-  *actual = (head_ - old_head);
+  // Signals need updating if the ring was empty just before we published, making it readable, or
+  // if it is now full, making the writer no longer writable.
+  *signal_update = (tail == old_head) || (head - tail == elem_count_);
+  *actual = (head - old_head);
   return ZX_OK;
 }
 
 zx_status_t FifoDispatcher::ReadToUser(size_t elem_size, user_out_ptr<uint8_t> ptr, size_t count,
                                        size_t* actual) {
   canary_.Assert();
+  if (elem_size != read_ring_->elem_size()) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
   while (true) {
     ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> read_result;
+    bool signal_update = false;
     {
+      // Observe whether the peer has closed before the ring is inspected, so that if the peer has
+      // closed all of its writes are visible and an empty ring means there is nothing left to read.
+      const bool peer_closed = peer_closed_.load(ktl::memory_order_acquire);
+      Guard<CriticalMutex> guard{&read_ring_->read_lock_};
+      read_result = read_ring_->Read(ptr, count, peer_closed, actual, &signal_update);
+    }
+    if (signal_update) {
       Guard<CriticalMutex> guard{get_lock()};
-      read_result = ReadToUserLocked(elem_size, ptr, count, actual);
+      UpdateSignalsLocked();
     }
     // Check for any regular error and return it.
     if (ktl::holds_alternative<zx_status_t>(read_result)) {
@@ -220,34 +261,33 @@ zx_status_t FifoDispatcher::ReadToUser(size_t elem_size, user_out_ptr<uint8_t> p
   }
 }
 
-ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> FifoDispatcher::ReadToUserLocked(
-    size_t elem_size, user_out_ptr<uint8_t> ptr, size_t count, size_t* actual) {
-  canary_.Assert();
-
-  if (elem_size != elem_size_) {
-    return ZX_ERR_OUT_OF_RANGE;
-  }
+ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> FifoDispatcher::Ring::Read(
+    user_out_ptr<uint8_t> ptr, size_t count, bool writer_closed, size_t* actual,
+    bool* signal_update) {
+  // |elem_size| is validated by the caller.
   if (count == 0) {
     return ZX_ERR_OUT_OF_RANGE;
   }
 
-  uint32_t old_tail = tail_;
+  // Only readers modify |tail_|, and we hold the read lock. Acquiring |head_| ensures the elements
+  // the writer published are visible.
+  const uint32_t old_tail = tail_.load(ktl::memory_order_relaxed);
+  const uint32_t old_head = head_.load(ktl::memory_order_acquire);
 
   // total number of available entries to read from the fifo
-  size_t avail = (head_ - tail_);
+  size_t avail = (old_head - old_tail);
 
   if (avail == 0) {
-    return peer() ? ZX_ERR_SHOULD_WAIT : ZX_ERR_PEER_CLOSED;
+    return writer_closed ? ZX_ERR_PEER_CLOSED : ZX_ERR_SHOULD_WAIT;
   }
 
-  bool was_full = (avail == elem_count_);
-
   if (count > avail) {
     count = avail;
   }
 
+  uint32_t tail = old_tail;
   while (count > 0) {
-    uint32_t offset = (tail_ % elem_count_);
+    uint32_t offset = (tail % elem_count_);
 
     // number of slots from target to end, inclusive
     uint32_t n = elem_count_ - offset;
@@ -258,29 +298,24 @@ ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> FifoDispatcher::ReadToUse
     UserCopyCaptureFaultsResult result =
         ptr.copy_array_to_user_capture_faults(&data_[offset * elem_size_], to_copy * elem_size_);
     if (result.status != ZX_OK) {
-      // roll back, in case this is the second copy
-      tail_ = old_tail;
       return result;
     }
 
     // adjust tail and count
     // due to size limitations on fifo, to_copy will always fit in a u32
-    tail_ += static_cast<uint32_t>(to_copy);
+    tail += static_cast<uint32_t>(to_copy);
     count -= to_copy;
     ptr = ptr.byte_offset(to_copy * elem_size_);
   }
 
-  // if we were full, we have become writable
-  if (was_full && peer()) {
-    AssertHeld(*peer()->get_lock());
-    peer()->UpdateStateLocked(0u, ZX_FIFO_WRITABLE);
-  }
-
-  // if we've become empty, we're no longer readable
-  if ((head_ - tail_) == 0) {
-    UpdateStateLocked(ZX_FIFO_READABLE, 0u);
-  }
+  // Release the slots, then check where the writer is. See Write for why these are sequentially
+  // consistent.
+  tail_.store(tail, ktl::memory_order_seq_cst);
+  const uint32_t head = head_.load(ktl::memory_order_seq_cst);
 
-  *actual = (tail_ - old_tail);
+  // Signals need updating if the ring was full just before we released slots, making the writer
+  // writable, or if it is now empty, making it no longer readable.
+  *signal_update = (head - old_tail == elem_count_) || (head == tail);
+  *actual = (tail - old_tail);
   return ZX_OK;
 }
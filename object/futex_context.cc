@@ -7,6 +7,8 @@
 #include "object/futex_context.h"
 
 #include <assert.h>
+#include <lib/boot-options/boot-options.h>
+#include <lib/fit/defer.h>
 #include <lib/kconcurrent/chainlock.h>
 #include <lib/kconcurrent/chainlock_transaction.h>
 #include <lib/ktrace.h>
@@ -14,13 +16,17 @@
 #include <trace.h>
 #include <zircon/types.h>
 
-#include <fbl/intrusive_hash_table.h>
 #include <fbl/null_lock.h>
 #include <kernel/auto_preempt_disabler.h>
 #include <kernel/mutex.h>
 #include <kernel/scheduler.h>
+#include <ktl/optional.h>
+#include <lk/init.h>
 #include <object/process_dispatcher.h>
 #include <object/thread_dispatcher.h>
+#include <vm/vm_address_region.h>
+#include <vm/vm_aspace.h>
+#include <vm/vm_object_paged.h>
 
 #define LOCAL_TRACE 0
 
@@ -31,6 +37,12 @@
 namespace {  // file scope only
 
 constexpr bool kFutexBlockTracingEnabled = FUTEX_BLOCK_TRACING_ENABLED;
+
+// The context used by every process when kernel.futex.memory-object-keys is
+// enabled.  See FutexContext::MemoryKeyed.
+FutexContext gMemoryKeyedFutexContext;
+bool gMemoryKeyedFutexContextEnabled = false;
+
 // Gets a reference to the thread that the user is asserting is the new owner of
 // the futex.  The thread must have the same futex context as the caller since
 // futexes may not be owned by threads with different futex contexts.  In addition,
@@ -162,43 +174,109 @@ struct SetBlockingFutexIdState {
 
 FutexContext::FutexState::~FutexState() {}
 
-FutexContext::FutexContext() : active_futexes_(fbl::HashTableOption::DelayedInit) { LTRACE_ENTRY; }
+uint32_t FutexContext::FutexState::WakeMultiWaitersLocked(uint32_t count) {
+  uint32_t woken = 0;
+  while ((woken < count) && !multi_waiters_.is_empty()) {
+    // Entries of waiters which another futex has already woken are simply
+    // dropped here.  Those waiters will find them gone as they leave.
+    MultiWaitEntry* entry = multi_waiters_.pop_front();
+    int32_t expected = -1;
+    if (entry->waiter->woken_index.compare_exchange_strong(
+            expected, entry->index, ktl::memory_order_acq_rel, ktl::memory_order_relaxed)) {
+      entry->waiter->event.Signal();
+      ++woken;
+    }
+  }
+  return woken;
+}
+
+FutexContext::FutexContext() { LTRACE_ENTRY; }
 
 FutexContext::~FutexContext() {
   LTRACE_ENTRY;
 
   // All of the threads should have removed themselves from wait queues and
   // destroyed themselves by the time the process has exited.
-  DEBUG_ASSERT(active_futexes_.is_empty());
+  if constexpr (DEBUG_ASSERT_IMPLEMENTED) {
+    for (size_t i = 0; i < num_buckets_; ++i) {
+      Guard<SpinLock, IrqSave> bucket_guard{&buckets_[i].lock};
+      DEBUG_ASSERT(buckets_[i].futexes.is_empty());
+    }
+  }
   DEBUG_ASSERT(free_futexes_.is_empty());
 }
 
-zx_status_t FutexContext::Init(ProcessType type) {
-  size_t num_buckets;
+zx_status_t FutexContext::Init(ProcessType type, KeyType key_type) {
+  // The number of buckets must be a power of two.  See |BucketFor|.
+  uint32_t bucket_bits;
   switch (type) {
     case ProcessType::Regular:
-      num_buckets = 37;
+      bucket_bits = 6;
       break;
     case ProcessType::Shared:
       // A FutexContext used by a group of shared processes tends to have *many* active futexes.
-      num_buckets = 1031;
+      bucket_bits = 10;
       break;
     default:
       panic("unknown ProcessType %u", static_cast<uint32_t>(type));
   };
 
+  const size_t num_buckets = size_t{1} << bucket_bits;
   fbl::AllocChecker ac;
-  auto storage = ktl::make_unique<ActiveFutexMap::BucketType[]>(&ac, num_buckets);
+  buckets_ = ktl::make_unique<Bucket[]>(&ac, num_buckets);
   if (!ac.check()) {
     return ZX_ERR_NO_MEMORY;
   }
+  num_buckets_ = num_buckets;
+  bucket_shift_ = 64 - bucket_bits;
+  key_type_ = key_type;
+
+  return ZX_OK;
+}
+
+FutexContext* FutexContext::MemoryKeyed() {
+  return gMemoryKeyedFutexContextEnabled ? &gMemoryKeyedFutexContext : nullptr;
+}
+
+FutexId FutexContext::GetFutexId(user_in_ptr<const zx_futex_t> value_ptr) const {
+  if (key_type_ == KeyType::Address) {
+    return FutexId(value_ptr);
+  }
 
+  // Resolve the futex through the mapping containing it.  Nothing here is held
+  // across the futex operation, so the mapping may change before the operation
+  // reads the futex, just as it could change right after.
+  //
+  // If there is no mapping, the futex is keyed by its address in the address
+  // space instead, and the operation reports the fault (if any) when it reads
+  // the futex.
+  ProcessDispatcher* const process = ProcessDispatcher::GetCurrent();
+  const vaddr_t va = FutexId::GetFutexID(value_ptr.get());
+  VmAspace* const aspace = process->aspace_at(va);
+  if (aspace == nullptr) {
+    return FutexId(process, va);
+  }
+
+  fbl::RefPtr<VmAddressRegionOrMapping> region = aspace->FindRegion(va);
+  fbl::RefPtr<VmMapping> mapping = region ? region->as_vm_mapping() : nullptr;
+  fbl::RefPtr<VmObject> vmo = mapping ? mapping->vmo() : nullptr;
+  if (vmo == nullptr) {
+    return FutexId(aspace, va);
+  }
+
+  uint64_t offset;
   {
-    Guard<SpinLock, IrqSave> pool_lock_guard{&pool_lock_};
-    active_futexes_.Init(ktl::move(storage), num_buckets);
+    Guard<CriticalMutex> guard{mapping->lock()};
+    offset = va - mapping->base() + mapping->object_offset_locked();
   }
 
-  return ZX_OK;
+  // Key paged VMOs by the VmCowPages holding their content, so that reference
+  // children see the same futexes as their parent.
+  if (VmObjectPaged* paged = DownCastVmObject<VmObjectPaged>(vmo.get()); paged != nullptr) {
+    const auto [cow_pages, cow_offset] = paged->GetCowPagesAndOffset(offset);
+    return FutexId(cow_pages, cow_offset);
+  }
+  return FutexId(vmo.get(), offset);
 }
 
 zx_status_t FutexContext::GrowFutexStatePool() {
@@ -229,6 +307,33 @@ void FutexContext::ShrinkFutexStatePool() {
   }
 }
 
+zx_status_t FutexContext::AddFutexStates(size_t count) {
+  fbl::DoublyLinkedList<ktl::unique_ptr<FutexState>> new_states;
+  for (size_t i = 0; i < count; ++i) {
+    fbl::AllocChecker ac;
+    ktl::unique_ptr<FutexState> new_state{new (&ac) FutexState};
+    if (!ac.check()) {
+      return ZX_ERR_NO_MEMORY;
+    }
+    new_states.push_front(ktl::move(new_state));
+  }
+
+  Guard<SpinLock, IrqSave> pool_lock_guard{&pool_lock_};
+  free_futexes_.splice(free_futexes_.begin(), new_states);
+  return ZX_OK;
+}
+
+void FutexContext::RemoveFutexStates(size_t count) {
+  fbl::DoublyLinkedList<ktl::unique_ptr<FutexState>> states;
+  {  // Do not let the futex states become released inside of the lock.
+    Guard<SpinLock, IrqSave> pool_lock_guard{&pool_lock_};
+    for (size_t i = 0; i < count; ++i) {
+      DEBUG_ASSERT(free_futexes_.is_empty() == false);
+      states.push_front(free_futexes_.pop_front());
+    }
+  }
+}
+
 // NullableDispatcherGuard is a mutex guard type.  Its purpose is to allow the use of clang
 // thread-safety static analysis in situations where we have a (possibly null) pointer to a
 // ThreadDispatcher that we want to lock, but only when the pointer is non-null.  When the pointer
@@ -281,7 +386,7 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const zx_futex_t> value_ptr,
 
   Thread* current_core_thread = Thread::Current::Get();
   ThreadDispatcher* current_thread = current_core_thread->user_thread();
-  FutexId futex_id(value_ptr);
+  const FutexId futex_id = GetFutexId(value_ptr);
   {
     // Obtain the FutexState for the ID we are interested in, activating a free
     // futex state in the process if needed.  This operation should never fail
@@ -558,6 +663,101 @@ zx_status_t FutexContext::FutexWait(user_in_ptr<const zx_futex_t> value_ptr,
   return result;
 }
 
+zx_status_t FutexContext::FutexWaitMultiple(ktl::span<const WaitEntry> entries,
+                                            const Deadline& deadline, size_t* woken_index) {
+  LTRACE_ENTRY;
+
+  if (entries.empty() || (entries.size() > kMaxWaitEntries)) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  for (const WaitEntry& entry : entries) {
+    zx_status_t result = ValidateFutexPointer(entry.value_ptr);
+    if (result != ZX_OK) {
+      return result;
+    }
+  }
+
+  // Contribute a FutexState to the pool for each of the futexes for as long
+  // as we wait on them.  Do this before activating any of them, so the
+  // FutexStates are back in the pool before they are removed again.
+  zx_status_t result = AddFutexStates(entries.size());
+  if (result != ZX_OK) {
+    return result;
+  }
+  auto remove_states = fit::defer([this, count = entries.size()]() { RemoveFutexStates(count); });
+
+  MultiWaiter waiter;
+  MultiWaitEntry wait_entries[kMaxWaitEntries];
+  ktl::optional<FutexState::PendingOpRef> futex_refs[kMaxWaitEntries];
+  for (size_t i = 0; i < entries.size(); ++i) {
+    futex_refs[i].emplace(ActivateFutex(GetFutexId(entries[i].value_ptr)));
+    DEBUG_ASSERT(*futex_refs[i] != nullptr);
+    wait_entries[i].waiter = &waiter;
+    wait_entries[i].index = static_cast<int32_t>(i);
+  }
+
+  // Validate each futex and queue ourselves on it while holding its lock, as
+  // FutexWait does, so that a FutexWake following a change to any of the
+  // values cannot be missed.  A wake of a futex which is already queued may
+  // arrive before we are done; it leaves us signaled and we do not block.
+  size_t queued = 0;
+  while (queued < entries.size()) {
+    FutexState::PendingOpRef& futex_ref = *futex_refs[queued];
+    Guard<SpinLock, IrqSave> futex_state_guard{&futex_ref->lock_};
+
+    int value;
+    UserCopyCaptureFaultsResult copy_result =
+        arch_copy_from_user_capture_faults(&value, entries[queued].value_ptr.get(), sizeof(int),
+                                           CopyContext::kBlockingNotAllowed);
+    if (copy_result.status != ZX_OK) {
+      futex_state_guard.Release();
+      if (auto fault = copy_result.fault_info) {
+        result = Thread::Current::SoftFault(fault->pf_va, fault->pf_flags);
+        if (result == ZX_OK) {
+          continue;
+        }
+      } else {
+        result = copy_result.status;
+      }
+      break;
+    }
+
+    if (value != entries[queued].current_value) {
+      result = ZX_ERR_BAD_STATE;
+      break;
+    }
+
+    futex_ref->multi_waiters_.push_back(&wait_entries[queued]);
+    ++queued;
+  }
+
+  if (result == ZX_OK) {
+    ThreadDispatcher::AutoBlocked by(ThreadDispatcher::Blocked::FUTEX);
+    result = waiter.event.Wait(deadline);
+  }
+
+  // Dequeue ourselves from every futex which has not already dropped our
+  // entry.  Taking each of the locks also makes sure that no waker is still
+  // signaling |waiter| once we are done.
+  for (size_t i = 0; i < queued; ++i) {
+    FutexState::PendingOpRef& futex_ref = *futex_refs[i];
+    Guard<SpinLock, IrqSave> futex_state_guard{&futex_ref->lock_};
+    if (wait_entries[i].InContainer()) {
+      futex_ref->multi_waiters_.erase(wait_entries[i]);
+    }
+  }
+
+  // A wake takes precedence over anything else which stopped the wait, since
+  // the waker has already counted us as woken.
+  const int32_t index = waiter.woken_index.load(ktl::memory_order_acquire);
+  if (index >= 0) {
+    *woken_index = static_cast<size_t>(index);
+    return ZX_OK;
+  }
+  DEBUG_ASSERT(result != ZX_OK);
+  return result;
+}
+
 zx_status_t FutexContext::FutexWake(user_in_ptr<const zx_futex_t> value_ptr, uint32_t wake_count,
                                     OwnerAction owner_action) {
   LTRACE_ENTRY;
@@ -571,7 +771,7 @@ zx_status_t FutexContext::FutexWake(user_in_ptr<const zx_futex_t> value_ptr, uin
 
   // Try to find an active futex with the specified ID.  If we cannot find one,
   // then we are done.  This wake operation had no threads to wake.
-  FutexId futex_id(value_ptr);
+  const FutexId futex_id = GetFutexId(value_ptr);
   FutexState::PendingOpRef futex_ref = FindActiveFutex(futex_id);
   if (futex_ref == nullptr) {
     return ZX_OK;
@@ -610,6 +810,12 @@ zx_status_t FutexContext::FutexWake(user_in_ptr<const zx_futex_t> value_ptr, uin
       // the FutexWait hot-path, and they have expected us to manage their
       // blocking_futex_id and pending operation references for them.
       futex_ref.SetExtraRefs(wake_result.woken);
+
+      // Threads in FutexWaitMultiple release their own pending operation
+      // references, so they are not counted above.
+      if (wake_result.woken < wake_count) {
+        futex_ref->WakeMultiWaitersLocked(wake_count - wake_result.woken);
+      }
     }
   }
 
@@ -645,27 +851,23 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const zx_futex_t> wake_ptr, u
   const zx_status_t validator_status =
       ValidateFutexOwner(new_requeue_owner_handle, &requeue_owner_thread);
 
-  // Find the FutexState for the wake and requeue futexes.
-  FutexId wake_id(wake_ptr);
-  FutexId requeue_id(requeue_ptr);
+  // Find the FutexState for the wake and requeue futexes.  When futexes are
+  // keyed by memory object, two different addresses may name the same futex.
+  const FutexId wake_id = GetFutexId(wake_ptr);
+  const FutexId requeue_id = GetFutexId(requeue_ptr);
+  if (wake_id == requeue_id) {
+    return ZX_ERR_INVALID_ARGS;
+  }
 
-  Guard<SpinLock, IrqSave> ref_lookup_guard{&pool_lock_};
-  FutexState::PendingOpRef wake_futex_ref = ActivateFutexLocked(wake_id);
-  FutexState::PendingOpRef requeue_futex_ref = ActivateFutexLocked(requeue_id);
+  // The two futexes are usually in different buckets, so they are activated
+  // one at a time, each under its own bucket lock.  The two FutexStates each
+  // thread contributes to the pool guarantee that both activations succeed.
+  FutexState::PendingOpRef wake_futex_ref = ActivateFutex(wake_id);
+  FutexState::PendingOpRef requeue_futex_ref = ActivateFutex(requeue_id);
 
   DEBUG_ASSERT(wake_futex_ref != nullptr);
   DEBUG_ASSERT(requeue_futex_ref != nullptr);
 
-  // Manually release the ref lookup guard.  While we would typically do this
-  // using scope, the PendingOpRefs need to live outside of just the locking
-  // scope.  We cannot declare the PendingOpRefs outside of the scope because we
-  // do not allow default construction of PendingOpRefs, nor do we allow move
-  // assignment.  This is done on purpose; pending op refs should only ever be
-  // constructed during lookup operations, and they really should not be moved
-  // around.  We need to have a move constructor, but there is no reason for a
-  // move assignment.
-  ref_lookup_guard.Release();
-
   while (1) {
     // See the comment in FutexWait about the structure of lock ordering in this method.
     NullableDispatcherGuard requeue_owner_guard(requeue_owner_thread.get());
@@ -751,6 +953,11 @@ zx_status_t FutexContext::FutexRequeue(user_in_ptr<const zx_futex_t> wake_ptr, u
       // threads.  They are on the hot-path out of FutexWake, and we are responsible
       // for their pending op refs.
       wake_futex_ref.SetExtraRefs(wake_threads_result.woken);
+
+      // Threads in FutexWaitMultiple can be woken, but are never requeued.
+      if (wake_threads_result.woken < wake_count) {
+        wake_futex_ref->WakeMultiWaitersLocked(wake_count - wake_threads_result.woken);
+      }
     }
     // If we got to here then we have no user copy faults that need retrying, so we should break out
     // of the infinite loop.
@@ -775,7 +982,7 @@ zx_status_t FutexContext::FutexGetOwner(user_in_ptr<const zx_futex_t> value_ptr,
 
   // Attempt to find the futex.  If it is not in the active set, then there is no owner.
   zx_koid_t koid = ZX_KOID_INVALID;
-  FutexId futex_id(value_ptr);
+  const FutexId futex_id = GetFutexId(value_ptr);
   FutexState::PendingOpRef futex_ref = FindActiveFutex(futex_id);
 
   // We found a FutexState in the active set.  It may have an owner, but we need
@@ -796,3 +1003,18 @@ zx_status_t FutexContext::FutexGetOwner(user_in_ptr<const zx_futex_t> value_ptr,
 
   return koid_out.copy_to_user(koid);
 }
+
+static void futex_memory_keyed_init(uint level) {
+  if (!gBootOptions->futex_memory_object_keys) {
+    return;
+  }
+
+  // Every process shares this context, so size it like a context shared by a
+  // group of processes.
+  zx_status_t status = gMemoryKeyedFutexContext.Init(FutexContext::ProcessType::Shared,
+                                                     FutexContext::KeyType::MemoryObject);
+  ASSERT_MSG(status == ZX_OK, "failed to initialize memory keyed futexes: %d", status);
+  gMemoryKeyedFutexContextEnabled = true;
+}
+
+LK_INIT_HOOK(futex_memory_keyed, futex_memory_keyed_init, LK_INIT_LEVEL_THREADING)
@@ -6,82 +6,163 @@
 
 #include "object/handle.h"
 
+#include <lib/arch/intrin.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
-#include <pow2.h>
 
 #include <fbl/conditional_select_nospec.h>
+#include <kernel/auto_preempt_disabler.h>
+#include <kernel/percpu.h>
+#include <ktl/algorithm.h>
 #include <object/dispatcher.h>
 
 namespace {
 
-// The number of outstanding (live) handles in the arena.
-constexpr size_t kMaxHandleCount = 256 * 1024u;
-
-// Warning level: When the number of handles exceeds this value, we start to emit
-// warnings to the kernel's debug log.
-constexpr size_t kHighHandleCount = (kMaxHandleCount * 7) / 8;
-
 KCOUNTER(handle_count_made, "handles.made")
 KCOUNTER(handle_count_duped, "handles.duped")
 KCOUNTER(handle_count_live, "handles.live")
 KCOUNTER(handle_count_alloc_failed, "handles.alloc.failed")
 
-// Masks for building a Handle's base_value, which ProcessDispatcher
-// uses to create zx_handle_t values.
-//
-// base_value bit fields:
-//   [31..(32 - kHandleReservedBits)]                     : Must be zero
-//   [(31 - kHandleReservedBits)..kHandleGenerationShift] : Generation number
-//                                                          Masked by kHandleGenerationMask
-//   [kHandleGenerationShift-1..0]                        : Index into handle_arena
-//                                                          Masked by kHandleIndexMask
-constexpr uint32_t kHandleIndexMask = kMaxHandleCount - 1;
-static_assert((kHandleIndexMask & kMaxHandleCount) == 0, "kMaxHandleCount must be a power of 2");
-
-constexpr uint32_t kHandleReservedBitsMask = ((1 << kHandleReservedBits) - 1)
-                                             << (32 - kHandleReservedBits);
-constexpr uint32_t kHandleGenerationMask = ~kHandleIndexMask & ~kHandleReservedBitsMask;
-constexpr uint32_t kHandleGenerationShift = log2_uint_floor(kMaxHandleCount);
-static_assert(((3 << (kHandleGenerationShift - 1)) & kHandleGenerationMask) ==
-                  1 << kHandleGenerationShift,
-              "Shift is wrong");
-static_assert((kHandleGenerationMask >> kHandleGenerationShift) >= 255,
-              "Not enough room for a useful generation count");
-
-static_assert((kHandleReservedBitsMask & kHandleGenerationMask) == 0, "Handle Mask Overlap!");
-static_assert((kHandleReservedBitsMask & kHandleIndexMask) == 0, "Handle Mask Overlap!");
-static_assert((kHandleGenerationMask & kHandleIndexMask) == 0, "Handle Mask Overlap!");
-static_assert((kHandleReservedBitsMask | kHandleGenerationMask | kHandleIndexMask) == 0xffffffffu,
-              "Handle masks do not cover all bits!");
-
-// |index| is the literal index into the table. |old_value| is the
-// |index mixed with the per-handle-lifetime state.
-uint32_t NewHandleValue(uint32_t index, uint32_t old_value) {
-  DEBUG_ASSERT((index & ~kHandleIndexMask) == 0);
-
-  uint32_t old_gen = 0;
-  if (old_value != 0) {
-    // This slot has been used before.
-    DEBUG_ASSERT((old_value & kHandleIndexMask) == index);
-    old_gen = (old_value & kHandleGenerationMask) >> kHandleGenerationShift;
+}  // namespace
+
+HandleTableArena gHandleTableArena;
+
+void Handle::Init() { gHandleTableArena.Init(gBootOptions->handle_max_count); }
+
+void HandleTableArena::Init(size_t max_count) {
+  // Only widen the index field of handle values, at the expense of their generation count, if a
+  // limit larger than the default was asked for.
+  value_layout_ = HandleValueLayout::ForCount(max_count);
+  const size_t index_limit = value_layout_.index_limit();
+  max_count = ktl::clamp<size_t>(max_count, 1, index_limit);
+
+  // Free slots sitting in CPU caches are still allocated from the arena's point of view, so size
+  // the arena such that the caches cannot prevent |max_count| handles from being live, as far as
+  // the index field allows.
+  const size_t num_cpus = percpu::processor_count();
+  const size_t arena_count = ktl::min(max_count + num_cpus * kCpuCacheSize, index_limit);
+  arena_.Init("handles", arena_count);
+
+  fbl::AllocChecker ac;
+  cpu_caches_ = fbl::MakeArray<CpuCache>(&ac, num_cpus);
+  ASSERT(ac.check());
+
+  // Warning level: When the number of handles exceeds this value, we start to emit warnings to the
+  // kernel's debug log.
+  high_handle_count_ = (max_count * 7) / 8;
+}
+
+HandleTableArena::CpuCache& HandleTableArena::CurrentCache() {
+  DEBUG_ASSERT(Thread::Current::preemption_state().PreemptIsEnabled() == false);
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  DEBUG_ASSERT(cpu < cpu_caches_.size());
+  return cpu_caches_[cpu];
+}
+
+size_t HandleTableArena::OutstandingCount() const {
+  // This is only used for diagnostics, and so races with other CPUs moving slots in and out of
+  // their caches are acceptable.
+  size_t cached = 0;
+  for (const CpuCache& cache : cpu_caches_) {
+    cached += cache.count.load(ktl::memory_order_relaxed);
   }
-  uint32_t new_gen = (((old_gen + 1) << kHandleGenerationShift) & kHandleGenerationMask);
-  return (index | new_gen);
+  const size_t allocated = arena_.DiagnosticCount();
+  return allocated > cached ? allocated - cached : 0;
 }
 
-uint32_t HandleValueToIndex(uint32_t value) { return value & kHandleIndexMask; }
+void* HandleTableArena::AllocSlot() {
+  {
+    AutoPreemptDisabler preempt_disable;
+    CpuCache& cache = CurrentCache();
+    const size_t count = cache.count.load(ktl::memory_order_relaxed);
+    if (likely(count > 0)) {
+      cache.count.store(count - 1, ktl::memory_order_relaxed);
+      return cache.slots[count - 1];
+    }
+  }
 
-}  // namespace
+  // The cache was empty. Refill it with a batch from the arena. This must be done with preemption
+  // enabled as growing the arena may need to commit memory.
+  void* batch[kCpuCacheBatch];
+  size_t allocated = 0;
+  for (; allocated < kCpuCacheBatch; allocated++) {
+    batch[allocated] = arena_.Alloc();
+    if (batch[allocated] == nullptr) {
+      break;
+    }
+  }
+  if (allocated == 0) {
+    return nullptr;
+  }
 
-HandleTableArena gHandleTableArena;
+  // Keep one slot to return, and stash what we can of the remainder in whichever CPU we are now
+  // running on. Any slots that do not fit, due to racing with another thread on this CPU, go back
+  // to the arena.
+  void* result = batch[--allocated];
+  {
+    AutoPreemptDisabler preempt_disable;
+    CpuCache& cache = CurrentCache();
+    size_t count = cache.count.load(ktl::memory_order_relaxed);
+    while (allocated > 0 && count < kCpuCacheSize) {
+      cache.slots[count++] = batch[--allocated];
+    }
+    cache.count.store(count, ktl::memory_order_relaxed);
+  }
+  while (allocated > 0) {
+    arena_.Free(batch[--allocated]);
+  }
+
+  // Emit a warning if too many handles have been created and we haven't recently logged. This is
+  // only checked when refilling to keep the counting off the fast path.
+  const size_t outstanding_handles = OutstandingCount();
+  if (unlikely(outstanding_handles > high_handle_count_) && handle_count_high_log_.Ready()) {
+    printf("WARNING: High handle count: %zu / %zu handles\n", outstanding_handles,
+           high_handle_count_);
+  }
+  return result;
+}
 
-void Handle::Init() { gHandleTableArena.arena_.Init("handles", kMaxHandleCount); }
+void HandleTableArena::FreeSlot(Handle* handle) {
+  void* drain[kCpuCacheBatch];
+  size_t drained = 0;
+  {
+    AutoPreemptDisabler preempt_disable;
+    CpuCache& cache = CurrentCache();
+    size_t count = cache.count.load(ktl::memory_order_relaxed);
+    if (unlikely(count == kCpuCacheSize)) {
+      // Cache is full, move a batch of the oldest entries back to the arena so the other CPUs can
+      // make use of them.
+      for (; drained < kCpuCacheBatch; drained++) {
+        drain[drained] = cache.slots[drained];
+      }
+      count -= drained;
+      memmove(&cache.slots[0], &cache.slots[drained], count * sizeof(cache.slots[0]));
+    }
+    cache.slots[count++] = handle;
+    cache.count.store(count, ktl::memory_order_relaxed);
+  }
+  for (size_t i = 0; i < drained; i++) {
+    arena_.Free(drain[i]);
+  }
+}
 
 void Handle::set_handle_table_id(zx_koid_t pid) {
-  handle_table_id_.store(pid, ktl::memory_order_relaxed);
+  handle_table_id_.store(pid, ktl::memory_order_release);
   dispatcher_->set_owner(pid);
 }
 
+bool Handle::BeginLookup(zx_koid_t table_id) const {
+  // Pairs with the fence in HandleTableArena::Delete. Either Delete sees this lookup, and waits for
+  // it, or the lookup sees the handle was removed from its table before being deleted.
+  lookups_.fetch_add(1, ktl::memory_order_relaxed);
+  ktl::atomic_thread_fence(ktl::memory_order_seq_cst);
+  if (unlikely(handle_table_id_.load(ktl::memory_order_relaxed) != table_id)) {
+    EndLookup();
+    return false;
+  }
+  return true;
+}
+
 // Returns a new |base_value| based on the value stored in the free
 // arena slot pointed to by |addr|. The new value will be different
 // from the last |base_value| used by this slot.
@@ -92,7 +173,9 @@ uint32_t HandleTableArena::GetNewBaseValue(void* addr) {
   // Check the free memory for a stashed base_value.
   uint32_t v = reinterpret_cast<Handle*>(addr)->base_value_;
 
-  return NewHandleValue(handle_index, v);
+  DEBUG_ASSERT((handle_index & ~value_layout_.index_mask()) == 0);
+  DEBUG_ASSERT(v == 0 || value_layout_.ValueToIndex(v) == handle_index);
+  return value_layout_.NewValue(handle_index, v);
 }
 
 // Allocate space for a Handle from the arena, but don't instantiate the
@@ -101,20 +184,13 @@ uint32_t HandleTableArena::GetNewBaseValue(void* addr) {
 void* HandleTableArena::Alloc(const fbl::RefPtr<Dispatcher>& dispatcher, const char* what,
                               uint32_t* base_value) {
   // Attempt to allocate a handle.
-  void* addr = arena_.Alloc();
-  size_t outstanding_handles = arena_.DiagnosticCount();
+  void* addr = AllocSlot();
   if (unlikely(addr == nullptr)) {
     kcounter_add(handle_count_alloc_failed, 1);
-    printf("WARNING: Could not allocate %s handle (%zu outstanding)\n", what, outstanding_handles);
+    printf("WARNING: Could not allocate %s handle (%zu outstanding)\n", what, OutstandingCount());
     return nullptr;
   }
 
-  // Emit a warning if too many handles have been created and we haven't recently logged
-  if (unlikely(outstanding_handles > kHighHandleCount) && handle_count_high_log_.Ready()) {
-    printf("WARNING: High handle count: %zu / %zu handles\n", outstanding_handles,
-           kHighHandleCount);
-  }
-
   dispatcher->increment_handle_count();
   // checking the handle_table_id_ and dispatcher_ is really about trying to catch cases where this
   // Handle might somehow already be in use.
@@ -172,36 +248,54 @@ Handle::Handle(Handle* rhs, zx_rights_t rights, uint32_t base_value)
       base_value_(base_value) {}
 
 void HandleTableArena::Delete(Handle* handle) {
-  fbl::RefPtr<Dispatcher> dispatcher(ktl::move(handle->dispatcher_));
-  [[maybe_unused]] uint32_t old_base_value = handle->base_value_;
-  [[maybe_unused]] const uint32_t* base_value = &handle->base_value_;
   // There may be stale pointers to this slot and they will look at handle_table_id. We expect
   // handle_table_id to already have been cleared by the process dispatcher before the handle got to
   // this point.
   DEBUG_ASSERT(handle->handle_table_id() == ZX_KOID_INVALID);
 
+  // HandleTable resolves handle values without holding its lock, inside an RCU read-side section.
+  // Such a lookup may have matched this handle just before it was removed from its table, and may
+  // still be copying |dispatcher_|. Lookups are short and run with preemption disabled, so wait
+  // them out rather than deferring the release of the dispatcher. Pairs with Handle::BeginLookup.
+  ktl::atomic_thread_fence(ktl::memory_order_seq_cst);
+  while (handle->lookups_.load(ktl::memory_order_acquire) != 0) {
+    arch::Yield();
+  }
+
+  fbl::RefPtr<Dispatcher> dispatcher(ktl::move(handle->dispatcher_));
   if (dispatcher->is_waitable()) {
     dispatcher->Cancel(handle);
   }
-  // The destructor should not do anything interesting but call it for completeness.
-  handle->~Handle();
-  // Make sure the base value was not altered by the destructor.
-  DEBUG_ASSERT(*base_value == old_base_value);
 
-  bool zero_handles = dispatcher->decrement_handle_count();
-  arena_.Free(handle);
-
-  if (zero_handles) {
+  if (dispatcher->decrement_handle_count()) {
     dispatcher->on_zero_handles();
   }
+  kcounter_add(handle_count_live, -1);
 
-  // If |disp| is the last reference (which is likely) then the dispatcher object
+  // The slot itself must outlive any lookup that may still read it, and is returned to the arena
+  // after a grace period.
+  rcu::Call(&handle->rcu_head_, &HandleTableArena::FinishDelete);
+
+  // If |dispatcher| is the last reference (which is likely) then the dispatcher object
   // gets destroyed at the exit of this function.
-  kcounter_add(handle_count_live, -1);
+}
+
+void HandleTableArena::FinishDelete(rcu::RcuHead* head) {
+  Handle* handle = reinterpret_cast<Handle*>(reinterpret_cast<uintptr_t>(head) -
+                                             offsetof(Handle, rcu_head_));
+  [[maybe_unused]] uint32_t old_base_value = handle->base_value_;
+  [[maybe_unused]] const uint32_t* base_value = &handle->base_value_;
+
+  // The destructor should not do anything interesting but call it for completeness.
+  handle->~Handle();
+  // Make sure the base value was not altered by the destructor.
+  DEBUG_ASSERT(*base_value == old_base_value);
+
+  gHandleTableArena.FreeSlot(handle);
 }
 
 Handle* Handle::FromU32(uint32_t value) {
-  uint32_t index = HandleValueToIndex(value);
+  uint32_t index = gHandleTableArena.value_layout_.ValueToIndex(value);
   uintptr_t handle_addr = IndexToHandle(index);
   if (unlikely(!gHandleTableArena.arena_.Committed(reinterpret_cast<void*>(handle_addr))))
     return nullptr;
@@ -218,7 +312,7 @@ uint32_t Handle::Count(const fbl::RefPtr<const Dispatcher>& dispatcher) {
 uint32_t Handle::Count(const Dispatcher& dispatcher) { return dispatcher.current_handle_count(); }
 
 size_t Handle::diagnostics::OutstandingHandles() {
-  return gHandleTableArena.arena_.DiagnosticCount();
+  return gHandleTableArena.OutstandingCount();
 }
 
 void Handle::diagnostics::DumpTableInfo() { gHandleTableArena.arena_.Dump(); }
@@ -9,6 +9,7 @@
 #include <lib/crypto/global_prng.h>
 
 #include <kernel/auto_preempt_disabler.h>
+#include <kernel/rcu.h>
 #include <object/job_dispatcher.h>
 
 constexpr uint32_t kHandleMustBeOneMask = ((0x1u << kHandleReservedBits) - 1);
@@ -104,6 +105,28 @@ Handle* HandleTable::GetHandleLocked(ProcessDispatcher* caller, zx_handle_t hand
   return nullptr;
 }
 
+bool HandleTable::ResolveHandle(ProcessDispatcher* caller, zx_handle_t handle_value,
+                                fbl::RefPtr<Dispatcher>* out_dispatcher,
+                                zx_rights_t* out_rights) const {
+  {
+    rcu::RcuReadGuard rcu_guard;
+    const Handle* handle = map_value_to_handle(handle_value, random_value_);
+    if (likely(handle && handle->handle_table_id() == koid_ && handle->BeginLookup(koid_))) {
+      *out_dispatcher = handle->dispatcher();
+      *out_rights = handle->rights();
+      handle->EndLookup();
+      return true;
+    }
+  }
+
+  if (likely(caller)) {
+    // See GetHandleLocked.
+    [[maybe_unused]] auto result = caller->EnforceBasicPolicy(ZX_POL_BAD_HANDLE);
+  }
+
+  return false;
+}
+
 uint32_t HandleTable::HandleCount() const {
   Guard<BrwLockPi, BrwLockPi::Reader> guard{&lock_};
   return count_;
@@ -121,6 +144,14 @@ void HandleTable::AddHandleLocked(HandleOwner handle) {
   count_++;
 }
 
+void HandleTable::AddHandles(ktl::span<Handle* const> handles) {
+  AutoExpiringPreemptDisabler preempt_disable{Mutex::DEFAULT_TIMESLICE_EXTENSION};
+  Guard<BrwLockPi, BrwLockPi::Writer> guard{&lock_};
+  for (Handle* handle : handles) {
+    AddHandleLocked(HandleOwner(handle));
+  }
+}
+
 HandleOwner HandleTable::RemoveHandleLocked(Handle* handle) {
   DEBUG_ASSERT(count_ > 0);
   handle->set_handle_table_id(ZX_KOID_INVALID);
@@ -164,24 +195,22 @@ zx_status_t HandleTable::RemoveHandles(ProcessDispatcher& caller,
 }
 
 zx_koid_t HandleTable::GetKoidForHandle(ProcessDispatcher& caller, zx_handle_t handle_value) {
-  Guard<BrwLockPi, BrwLockPi::Reader> guard{&lock_};
-  Handle* handle = GetHandleLocked(caller, handle_value);
-  if (!handle)
+  fbl::RefPtr<Dispatcher> dispatcher;
+  zx_rights_t rights;
+  if (!ResolveHandle(&caller, handle_value, &dispatcher, &rights))
     return ZX_KOID_INVALID;
-  return handle->dispatcher()->get_koid();
+  return dispatcher->get_koid();
 }
 
 zx_status_t HandleTable::GetDispatcherInternal(ProcessDispatcher& caller, zx_handle_t handle_value,
                                                fbl::RefPtr<Dispatcher>* dispatcher,
                                                zx_rights_t* rights) {
-  Guard<BrwLockPi, BrwLockPi::Reader> guard{&lock_};
-  Handle* handle = GetHandleLocked(caller, handle_value);
-  if (!handle)
+  zx_rights_t handle_rights;
+  if (!ResolveHandle(&caller, handle_value, dispatcher, &handle_rights))
     return ZX_ERR_BAD_HANDLE;
 
-  *dispatcher = handle->dispatcher();
   if (rights)
-    *rights = handle->rights();
+    *rights = handle_rights;
   return ZX_OK;
 }
 
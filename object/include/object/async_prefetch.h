@@ -0,0 +1,58 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_ASYNC_PREFETCH_H_
+#define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_ASYNC_PREFETCH_H_
+
+#include <lib/fit/function.h>
+#include <stdint.h>
+#include <zircon/types.h>
+
+#include <fbl/ref_ptr.h>
+#include <ktl/atomic.h>
+
+class PortDispatcher;
+
+// Bounds the number of prefetches that QueueAsyncPrefetch has outstanding on behalf of one process.
+// A prefetch is outstanding from the time it is queued until its completion packet has been
+// dequeued from its port, or discarded along with the port.
+class AsyncPrefetchQuota {
+ public:
+  static constexpr uint32_t kMaxOutstanding = 64;
+
+  // Returns false if kMaxOutstanding prefetches are already outstanding.
+  bool TryAcquire();
+  void Release();
+
+  uint32_t outstanding() const { return outstanding_.load(ktl::memory_order_relaxed); }
+
+ private:
+  ktl::atomic<uint32_t> outstanding_{0};
+};
+
+// Returns the quota that QueueAsyncPrefetch charges when called on the current thread. This is
+// the current process's, or a single quota shared by all kernel threads.
+AsyncPrefetchQuota& CurrentAsyncPrefetchQuota();
+
+// Performs a prefetch on behalf of QueueAsyncPrefetch, returning its status.
+using AsyncPrefetchFunction = fit::inline_function<zx_status_t(), sizeof(void*) * 4>;
+
+// Queues |prefetch| to run on a shared pool of kernel worker threads, and once it has run queues a
+// ZX_PKT_TYPE_USER packet with |key| on |port|. The packet's status is the status returned by
+// |prefetch| and its u64[0] and u64[1] are |arg0| and |arg1|.
+//
+// Each prefetch blocked on the pager occupies a worker, so the pool bounds the number of cold
+// ranges being brought in at once. The number that may be queued is bounded per process by
+// CurrentAsyncPrefetchQuota(): once it is used up, this returns ZX_ERR_SHOULD_WAIT until earlier
+// completion packets have been dequeued.
+//
+// The port packet is allocated up front, and is not subject to the port's limit on queued packets
+// as the quota bounds it instead. Once this has returned ZX_OK the packet is therefore always
+// queued, unless the port has lost all its handles and nobody is left to dequeue it.
+zx_status_t QueueAsyncPrefetch(AsyncPrefetchFunction prefetch, fbl::RefPtr<PortDispatcher> port,
+                               uint64_t key, uint64_t arg0, uint64_t arg1);
+
+#endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_ASYNC_PREFETCH_H_
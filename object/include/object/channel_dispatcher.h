@@ -11,11 +11,13 @@
 #include <zircon/rights.h>
 #include <zircon/types.h>
 
+#include <fbl/alloc_checker.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/ref_counted.h>
 #include <kernel/event.h>
 #include <kernel/mutex.h>
+#include <ktl/span.h>
 #include <ktl/unique_ptr.h>
 #include <object/dispatcher.h>
 #include <object/handle.h>
@@ -29,6 +31,10 @@ class ChannelDispatcher final
   static zx_status_t Create(KernelHandle<ChannelDispatcher>* handle0,
                             KernelHandle<ChannelDispatcher>* handle1, zx_rights_t* rights);
 
+  // Allocated from a per-CPU cache. See <object/dispatcher_cache.h>.
+  static void* operator new(size_t size, fbl::AllocChecker* ac) noexcept;
+  static void operator delete(void* ptr, size_t size);
+
   ~ChannelDispatcher() final;
   zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_CHANNEL; }
 
@@ -41,10 +47,27 @@ class ChannelDispatcher final
   zx_status_t Read(zx_koid_t owner, uint32_t* msg_size, uint32_t* msg_handle_count,
                    MessagePacketPtr* msg, bool may_disard);
 
+  // Batched form of Read that dequeues up to |msgs.size()| messages while acquiring the message
+  // lock once, and clearing ZX_CHANNEL_READABLE at most once.
+  // |total_size| and |total_handle_count| are in-out parameters. As input, they specify the
+  // maximum combined size and handle count of the dequeued messages, and on ZX_OK they are set to
+  // the actual combined totals. Messages are dequeued in order until |msgs| is full, the queue is
+  // empty, or the next message would exceed the remaining budget. |*num_msgs| is set to the number
+  // of messages placed at the start of |msgs|, which is at least one on ZX_OK.
+  // If the first message does not fit then ZX_ERR_BUFFER_TOO_SMALL is returned with its size and
+  // handle count in |total_size| and |total_handle_count|, and it remains queued.
+  zx_status_t ReadMany(zx_koid_t owner, uint32_t* total_size, uint32_t* total_handle_count,
+                       ktl::span<MessagePacketPtr> msgs, size_t* num_msgs);
+
   // Write to the opposing endpoint's message queue. |owner| is the handle table koid of the process
   // attempting to write to the channel, or ZX_KOID_INVALID if kernel is doing it.
   zx_status_t Write(zx_koid_t owner, MessagePacketPtr msg);
 
+  // Batched form of Write that enqueues all of |msgs|, in order, while acquiring the dispatcher and
+  // message locks once and raising ZX_CHANNEL_READABLE on the peer at most once. On ZX_OK all of
+  // the messages have been consumed. On error no messages have been consumed.
+  zx_status_t WriteMany(zx_koid_t owner, ktl::span<MessagePacketPtr> msgs);
+
   // Perform a transacted Write + Read. |owner| is the handle table koid of the process attempting
   // to write to the channel, or ZX_KOID_INVALID if kernel is doing it.
   zx_status_t Call(zx_koid_t owner, MessagePacketPtr msg, zx_instant_mono_t deadline,
@@ -132,7 +155,13 @@ class ChannelDispatcher final
   // Returns true and takes ownership of |msg| iff the message was delivered.
   bool TryWriteToMessageWaiter(MessagePacketPtr& msg) TA_REQ(get_lock());
 
-  void WriteSelf(MessagePacketPtr msg) TA_REQ(get_lock());
+  void WriteSelf(MessagePacketPtr msg) TA_REQ(get_lock()) { WriteSelf(ktl::span(&msg, 1)); }
+
+  // Enqueues all of |msgs| and then notifies observers of READABLE at most once.
+  void WriteSelf(ktl::span<MessagePacketPtr> msgs) TA_REQ(get_lock());
+
+  // Checks the pending message count of |messages_| against the warning and policy limits.
+  void CheckPendingMessageCountLocked(size_t size) TA_REQ(get_lock(), channel_lock_);
 
   // Generate a unique txid to be used in a channel call.
   zx_txid_t GenerateTxid() TA_REQ(get_lock());
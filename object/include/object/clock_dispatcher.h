@@ -24,6 +24,10 @@ class ClockDispatcher final : public SoloDispatcher<ClockDispatcher, ZX_DEFAULT_
  public:
   static inline constexpr uint64_t kMappedSize = PAGE_SIZE;
 
+  // Only clocks created with ZX_CLOCK_OPT_MAPPABLE get a pinned page to share
+  // their transformation through, and a handle with ZX_RIGHT_MAP.  Creators of
+  // clocks that are read often, such as UTC, should ask for it so that readers
+  // can map the clock instead of making a syscall per read.
   static zx_status_t Create(uint64_t options, const zx_clock_create_args_v1_t& create_args,
                             KernelHandle<ClockDispatcher>* handle, zx_rights_t* rights);
 
@@ -27,17 +27,23 @@ class CounterDispatcher
   // Returns the counter's value.
   //
   // Synchronizes-with |SetValue| or |Add|.
-  int64_t Value() const {
-    Guard<CriticalMutex> guard{get_lock()};
-    return value_;
-  }
+  int64_t Value() const { return value_.load(ktl::memory_order_acquire); }
 
   // Sets the counter's value, asserting/deasserting signals as appropriate.
   //
   // Synchronizes-with |Value| or |Add|.
   void SetValue(int64_t new_value) {
+    int64_t old_value = value_.load(ktl::memory_order_relaxed);
+    while (IsPositive(old_value) == IsPositive(new_value)) {
+      if (value_.compare_exchange_weak(old_value, new_value, ktl::memory_order_acq_rel,
+                                       ktl::memory_order_relaxed)) {
+        return;
+      }
+    }
+
     Guard<CriticalMutex> guard{get_lock()};
-    SetValueLocked(new_value);
+    value_.store(new_value, ktl::memory_order_release);
+    UpdateSignalsLocked(new_value);
   }
 
   // Adds |amount| to this counter.
@@ -46,44 +52,55 @@ class CounterDispatcher
   //
   // Returns an error if the value would underflow/overflow.
   zx_status_t Add(int64_t amount) {
-    Guard<CriticalMutex> guard{get_lock()};
-
-    const int64_t before = value_;
-    int64_t after;
-    if (add_overflow(before, amount, &after)) {
-      return ZX_ERR_OUT_OF_RANGE;
+    int64_t before = value_.load(ktl::memory_order_relaxed);
+    for (;;) {
+      int64_t after;
+      if (add_overflow(before, amount, &after)) {
+        return ZX_ERR_OUT_OF_RANGE;
+      }
+      if (IsPositive(before) != IsPositive(after)) {
+        break;
+      }
+      if (value_.compare_exchange_weak(before, after, ktl::memory_order_acq_rel,
+                                       ktl::memory_order_relaxed)) {
+        return ZX_OK;
+      }
     }
 
-    SetValueLocked(after);
-
-    return ZX_OK;
+    Guard<CriticalMutex> guard{get_lock()};
+    before = value_.load(ktl::memory_order_relaxed);
+    for (;;) {
+      int64_t after;
+      if (add_overflow(before, amount, &after)) {
+        return ZX_ERR_OUT_OF_RANGE;
+      }
+      if (value_.compare_exchange_weak(before, after, ktl::memory_order_acq_rel,
+                                       ktl::memory_order_relaxed)) {
+        UpdateSignalsLocked(after);
+        return ZX_OK;
+      }
+    }
   }
 
  private:
   CounterDispatcher();
 
-  // Returns true iff |old_value| is non-positive and |new_value| is positive.
-  static bool NewlyPositive(int64_t old_value, int64_t new_value) {
-    return (old_value <= 0 && new_value > 0);
-  }
-
-  // Returns true iff |old_value| is positive and |new_value| is non-positive.
-  static bool NewlyNonPositive(int64_t old_value, int64_t new_value) {
-    return (old_value > 0 && new_value <= 0);
-  }
-
-  void SetValueLocked(int64_t new_value) TA_REQ(get_lock()) {
-    const int64_t old_value = value_;
-    value_ = new_value;
+  static bool IsPositive(int64_t value) { return value > 0; }
 
-    if (NewlyPositive(old_value, new_value)) {
+  // Asserts the signal that matches |new_value| and deasserts the other.
+  void UpdateSignalsLocked(int64_t new_value) TA_REQ(get_lock()) {
+    if (IsPositive(new_value)) {
       UpdateStateLocked(ZX_COUNTER_NON_POSITIVE, ZX_COUNTER_POSITIVE);
-    } else if (NewlyNonPositive(old_value, new_value)) {
+    } else {
       UpdateStateLocked(ZX_COUNTER_POSITIVE, ZX_COUNTER_NON_POSITIVE);
     }
   }
 
-  int64_t value_ TA_GUARDED(get_lock()){};
+  // Only changes that move the value across zero change the signals, and only those are made with
+  // the lock held, which orders the signal updates. Any other change keeps the value on the same
+  // side of zero, so whichever signal the last crossing asserted stays correct, and is made with a
+  // compare-and-swap alone.
+  ktl::atomic<int64_t> value_{0};
 };
 
 #endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_COUNTER_DISPATCHER_H_
@@ -326,6 +326,11 @@ class Dispatcher : private fbl::RefCountedUpgradeable<Dispatcher>,
   // memory order for accessing signals_.
   ktl::atomic<zx_signals_t> signals_;
 
+  // A superset of the signals that some observer in |observers_| triggers on, so that signal
+  // updates none of them care about do not need to walk the list. Bits are added as observers are
+  // added, and dropped whenever the whole list is walked anyway.
+  zx_signals_t observed_signals_ TA_GUARDED(get_lock()) = 0;
+
   // List of observers watching for changes in signals on this dispatcher.
   fbl::DoublyLinkedList<SignalObserver*> observers_ TA_GUARDED(get_lock());
 
@@ -407,7 +412,7 @@ class SoloDispatcher : public Dispatcher {
 // allocation. This would mean PeerHolder would have two EndPoint
 // members, and that PeeredDispatcher would have custom refcounting.
 template <typename Endpoint, lockdep::LockFlags Flags = lockdep::LockFlagsNone>
-class PeerHolder : public fbl::RefCounted<PeerHolder<Endpoint>> {
+class PeerHolder : public fbl::RefCounted<PeerHolder<Endpoint, Flags>> {
  public:
   PeerHolder() = default;
   ~PeerHolder() = default;
@@ -0,0 +1,92 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_DISPATCHER_CACHE_H_
+#define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_DISPATCHER_CACHE_H_
+
+#include <assert.h>
+#include <lib/object_cache.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fbl/alloc_checker.h>
+#include <fbl/intrusive_double_list.h>
+#include <ktl/utility.h>
+
+// Per-CPU object caches for the dispatcher types that are created and destroyed
+// at high rates, so that doing so neither contends on the heap lock nor
+// fragments the heap. A cached type declares class-specific allocation
+// functions that forward to a DispatcherCache defined next to them:
+//
+//   class FooDispatcher final : public SoloDispatcher<...> {
+//    public:
+//     static void* operator new(size_t size, fbl::AllocChecker* ac) noexcept;
+//     static void operator delete(void* ptr, size_t size);
+//   };
+//
+// Types derived from a cached type inherit these functions, but are a different
+// size, so their allocations go to the heap instead.
+class DispatcherCacheBase : public fbl::DoublyLinkedListable<DispatcherCacheBase*> {
+ public:
+  // Releases the empty slabs of every cache, including the ones each CPU keeps
+  // in reserve. Returns the number of slabs released.
+  static size_t TrimAll();
+
+ protected:
+  // Adds this cache to the ones trimmed by TrimAll().
+  void Register();
+
+ private:
+  virtual size_t Trim() = 0;
+};
+
+template <typename T, typename Allocator = object_cache::DefaultAllocator>
+class DispatcherCache final : public DispatcherCacheBase {
+ public:
+  // Each CPU keeps up to this many empty slabs, so that a burst of creates does
+  // not go to the PMM for every slab.
+  static constexpr size_t kReserveSlabs = 1;
+
+  // Creates the per-CPU caches. Must be called from an init hook, after the
+  // per-CPU data is initialized and before the first allocation.
+  void Init() {
+    zx::result result = Cache::Create(kReserveSlabs);
+    ASSERT(result.is_ok());
+    cache_ = ktl::move(*result);
+    Register();
+  }
+
+  void* Allocate(size_t size, fbl::AllocChecker* ac) {
+    if (size != sizeof(T)) {
+      return ::operator new(size, ac);
+    }
+    zx::result result = cache_.Allocate();
+    ac->arm(size, result.is_ok());
+    return result.is_ok() ? result.value().release() : nullptr;
+  }
+
+  void Free(void* ptr, size_t size) {
+    if (size != sizeof(T)) {
+      ::operator delete(ptr, size);
+      return;
+    }
+    typename Cache::PtrType destroyer{static_cast<Storage*>(ptr)};
+  }
+
+ private:
+  // The cache only provides the memory. The new-expression constructs the T in
+  // it, and the delete-expression destroys the T before it is freed.
+  struct alignas(T) Storage {
+    uint8_t bytes[sizeof(T)];
+  };
+  using Cache = object_cache::ObjectCache<Storage, object_cache::Option::PerCpu, Allocator>;
+
+  size_t Trim() final { return cache_.Trim(); }
+
+  Cache cache_;
+};
+
+#endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_DISPATCHER_CACHE_H_
@@ -11,6 +11,7 @@
 #include <zircon/rights.h>
 #include <zircon/types.h>
 
+#include <fbl/alloc_checker.h>
 #include <object/dispatcher.h>
 #include <object/handle.h>
 
@@ -20,6 +21,10 @@ class EventDispatcher
   static zx_status_t Create(uint32_t options, KernelHandle<EventDispatcher>* handle,
                             zx_rights_t* rights);
 
+  // Allocated from a per-CPU cache. See <object/dispatcher_cache.h>.
+  static void* operator new(size_t size, fbl::AllocChecker* ac) noexcept;
+  static void operator delete(void* ptr, size_t size);
+
   ~EventDispatcher();
   zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_EVENT; }
 
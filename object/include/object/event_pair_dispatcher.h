@@ -11,6 +11,7 @@
 #include <zircon/rights.h>
 #include <zircon/types.h>
 
+#include <fbl/alloc_checker.h>
 #include <fbl/ref_ptr.h>
 #include <object/dispatcher.h>
 #include <object/handle.h>
@@ -21,6 +22,10 @@ class EventPairDispatcher final
   static zx_status_t Create(KernelHandle<EventPairDispatcher>* handle0,
                             KernelHandle<EventPairDispatcher>* handle1, zx_rights_t* rights);
 
+  // Allocated from a per-CPU cache. See <object/dispatcher_cache.h>.
+  static void* operator new(size_t size, fbl::AllocChecker* ac) noexcept;
+  static void operator delete(void* ptr, size_t size);
+
   ~EventPairDispatcher() final;
   zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_EVENTPAIR; }
 
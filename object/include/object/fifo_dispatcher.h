@@ -13,6 +13,10 @@
 #include <zircon/types.h>
 
 #include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <kernel/mutex.h>
+#include <ktl/atomic.h>
+#include <ktl/unique_ptr.h>
 #include <ktl/variant.h>
 #include <object/dispatcher.h>
 #include <object/handle.h>
@@ -36,20 +40,69 @@ class FifoDispatcher final : public PeeredDispatcher<FifoDispatcher, ZX_DEFAULT_
   void OnPeerZeroHandlesLocked() TA_REQ(get_lock());
 
  private:
-  FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder, uint32_t options,
-                 uint32_t elem_count, uint32_t elem_size, ktl::unique_ptr<uint8_t[]> data);
-  ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> WriteSelfLocked(
-      size_t elem_size, user_in_ptr<const uint8_t> ptr, size_t count, size_t* actual)
-      TA_REQ(get_lock());
-  ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> ReadToUserLocked(
-      size_t elem_size, user_out_ptr<uint8_t> ptr, size_t count, size_t* actual) TA_REQ(get_lock());
-
-  const uint32_t elem_count_;
-  const uint32_t elem_size_;
-
-  uint32_t head_ TA_GUARDED(get_lock());
-  uint32_t tail_ TA_GUARDED(get_lock());
-  ktl::unique_ptr<uint8_t[]> data_ TA_GUARDED(get_lock());
+  // One direction of the fifo, holding the elements written by one endpoint and read by the other.
+  //
+  // Each ring is a single-producer single-consumer queue: writers are serialized by |write_lock_|
+  // and readers by |read_lock_|, and they synchronize with each other only through |head_| and
+  // |tail_|. This keeps the two endpoints from contending on their shared dispatcher lock for every
+  // read and write. The shared lock is only taken to update signals, when an operation moves the
+  // ring into or out of the empty or full states.
+  //
+  // Rings are reference counted so that a writer can keep using its peer's ring without holding
+  // the shared lock, even while the peer is being closed.
+  class Ring : public fbl::RefCounted<Ring> {
+   public:
+    Ring(uint32_t elem_count, uint32_t elem_size, ktl::unique_ptr<uint8_t[]> data)
+        : elem_count_(elem_count), elem_size_(elem_size), data_(ktl::move(data)) {}
+
+    uint32_t elem_size() const { return elem_size_; }
+    bool IsEmpty() const;
+    bool IsFull() const;
+
+    // Copies up to |count| elements in to or out of the ring. On success |*signal_update| is set
+    // if the operation may have moved the ring to or from the empty or full states, in which case
+    // the caller must recompute the signals of both endpoints.
+    ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> Write(user_in_ptr<const uint8_t> ptr,
+                                                                 size_t count, size_t* actual,
+                                                                 bool* signal_update)
+        TA_REQ(write_lock_);
+    ktl::variant<zx_status_t, UserCopyCaptureFaultsResult> Read(user_out_ptr<uint8_t> ptr,
+                                                                size_t count, bool writer_closed,
+                                                                size_t* actual,
+                                                                bool* signal_update)
+        TA_REQ(read_lock_);
+
+    DECLARE_CRITICAL_MUTEX(Ring) write_lock_;
+    DECLARE_CRITICAL_MUTEX(Ring) read_lock_;
+
+   private:
+    const uint32_t elem_count_;
+    const uint32_t elem_size_;
+    const ktl::unique_ptr<uint8_t[]> data_;
+
+    // The free running indices of the next element to write and read. |head_| is only modified
+    // with |write_lock_| held and |tail_| with |read_lock_| held, and each is read without a lock
+    // by the other side.
+    ktl::atomic<uint32_t> head_ = 0;
+    ktl::atomic<uint32_t> tail_ = 0;
+  };
+
+  FifoDispatcher(fbl::RefPtr<PeerHolder<FifoDispatcher>> holder, fbl::RefPtr<Ring> read_ring,
+                 fbl::RefPtr<Ring> write_ring);
+
+  // Recomputes the READABLE and WRITABLE signals of this endpoint and its peer from the state of
+  // the rings.
+  void UpdateSignalsLocked() TA_REQ(get_lock());
+  void UpdateSelfSignalsLocked() TA_REQ(get_lock());
+
+  // The ring this endpoint reads from, which is the peer's |write_ring_|, and the ring this
+  // endpoint writes to, which is the peer's |read_ring_|.
+  const fbl::RefPtr<Ring> read_ring_;
+  const fbl::RefPtr<Ring> write_ring_;
+
+  // Set once the peer has no handles, so that reads and writes can observe it without acquiring
+  // the shared lock. Only modified with |get_lock()| held.
+  ktl::atomic<bool> peer_closed_ = false;
 
   static constexpr uint32_t kMaxSizeBytes = ZX_FIFO_MAX_SIZE_BYTES;
 };
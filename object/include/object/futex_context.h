@@ -12,30 +12,38 @@
 
 #include <arch/vm.h>
 #include <fbl/intrusive_double_list.h>
-#include <fbl/intrusive_hash_table.h>
 #include <fbl/ref_ptr.h>
+#include <kernel/event.h>
 #include <kernel/lockdep.h>
 #include <kernel/mutex.h>
 #include <kernel/owned_wait_queue.h>
+#include <ktl/atomic.h>
+#include <ktl/span.h>
 #include <ktl/unique_ptr.h>
 #include <ktl/utility.h>
 
 class ThreadDispatcher;
 
+// A FutexId is either the address of a futex in the user address space of the
+// process using it, or, for futexes keyed by memory object (see
+// FutexContext::KeyType), the pair of the object holding the futex and the
+// futex's offset in it.  The object is only ever compared, never dereferenced.
 class FutexId {
  public:
   // Shift for a better ID for hashing since the low bits are zero.
   FutexId(user_in_ptr<const zx_futex_t> value_ptr) : id_(GetFutexID(value_ptr.get()) >> 2) {}
-  bool operator==(const FutexId& other) const { return id_ == other.id_; }
-  bool operator!=(const FutexId& other) const { return id_ != other.id_; }
+  FutexId(const void* object, uint64_t offset)
+      : id_(offset >> 2), object_(reinterpret_cast<uintptr_t>(object)) {}
+  bool operator==(const FutexId& other) const {
+    return id_ == other.id_ && object_ == other.object_;
+  }
+  bool operator!=(const FutexId& other) const { return !(*this == other); }
   uintptr_t get() const { return id_; }
 
   static inline constexpr FutexId Null() { return FutexId{}; }
-  static size_t GetHash(FutexId key) { return key.id_; }
-
- private:
-  constexpr FutexId() : id_(0) {}
+  static size_t GetHash(FutexId key) { return key.id_ ^ (key.object_ >> 4); }
 
+  // Returns the address of the futex at |value_ptr|, without any pointer tag.
   static inline uintptr_t GetFutexID(const zx_futex_t* value_ptr) {
     uintptr_t futex_id = reinterpret_cast<uintptr_t>(value_ptr);
 #if defined(__aarch64__)
@@ -48,7 +56,11 @@ class FutexId {
     return futex_id;
   }
 
+ private:
+  constexpr FutexId() : id_(0) {}
+
   uintptr_t id_;
+  uintptr_t object_ = 0;
 };
 
 // FutexContex
@@ -93,13 +105,28 @@ class FutexContext {
   // See |Init|.
   enum class ProcessType { Regular, Shared };
 
+  // How futexes are identified.  See |Init|.
+  enum class KeyType { Address, MemoryObject };
+
   FutexContext();
   ~FutexContext();
 
   // Initialize this instance for use in the specified process type.
   //
+  // With KeyType::Address, futexes are identified by their user virtual
+  // address, which only makes sense within the address space of a single
+  // process (or group of shared processes).  With KeyType::MemoryObject,
+  // futexes are identified by the memory holding them, resolved through the
+  // mapping containing them, so processes mapping the same VMO can use futexes
+  // in it to synchronize with each other.
+  //
   // Must be called exactly once.
-  zx_status_t Init(ProcessType type);
+  zx_status_t Init(ProcessType type, KeyType key_type = KeyType::Address);
+
+  // Returns the system-wide context keyed by memory object, which every
+  // process uses instead of its own when kernel.futex.memory-object-keys is
+  // enabled, or nullptr when it is disabled.
+  static FutexContext* MemoryKeyed();
 
   // Called as ThreadDispatchers are created and destroyed in order to ensure
   // that there are always two FutexStates for each ThreadDispatcher in a
@@ -137,6 +164,27 @@ class FutexContext {
                         zx_handle_t new_futex_owner, const Deadline& deadline)
       TA_EXCL(chainlock_transaction_token);
 
+  // One of the futexes of a FutexWaitMultiple operation.
+  struct WaitEntry {
+    user_in_ptr<const zx_futex_t> value_ptr;
+    zx_futex_t current_value;
+  };
+
+  // The most futexes a single FutexWaitMultiple operation may wait on.
+  static constexpr size_t kMaxWaitEntries = 16;
+
+  // FutexWaitMultiple verifies that the integer pointed to by the |value_ptr| of each of |entries|
+  // still equals its |current_value|, and then blocks the current thread until the |deadline|
+  // passes, or until any one of the futexes is woken by a FutexWake or FutexRequeue operation.  On
+  // success, |woken_index| is set to the index of the entry which woke the thread.
+  //
+  // If a value check fails, FutexWaitMultiple returns BAD_STATE, unless one of the futexes already
+  // checked was woken in the meantime.  Unlike FutexWait, there is no futex owner, so waiting
+  // threads do not lend priority to anyone, and FutexRequeue wakes these threads but never moves
+  // them to another futex.
+  zx_status_t FutexWaitMultiple(ktl::span<const WaitEntry> entries, const Deadline& deadline,
+                                size_t* woken_index) TA_EXCL(chainlock_transaction_token);
+
   // FutexWake will wake up to |wake_count| number of threads blocked on the |value_ptr| futex.
   //
   // If owner_action is set to RELEASE, then the futex's owner will be set to nullptr in the
@@ -173,6 +221,21 @@ class FutexContext {
   // NullableDispatcherGuard here inside of FutuexContext, we can leach off of
   // the ThreadDispatcher --> FutexContext friendship.
   class TA_SCOPED_CAP NullableDispatcherGuard;
+
+  // The state of a thread blocked in FutexWaitMultiple, which lives on its stack.
+  struct MultiWaiter {
+    // The index of the entry which woke the waiter, or -1 while it has not been woken.  Set exactly
+    // once, by whichever waker claims the waiter first.
+    ktl::atomic<int32_t> woken_index{-1};
+    Event event;
+  };
+
+  // One of the futexes a MultiWaiter waits on, queued on that futex's FutexState.
+  struct MultiWaitEntry : public fbl::DoublyLinkedListable<MultiWaitEntry*> {
+    MultiWaiter* waiter = nullptr;
+    int32_t index = 0;
+  };
+
   // Notes about FutexState lifecycle.
   // aka. Why is this safe?
   //
@@ -182,11 +245,13 @@ class FutexContext {
   // thread exits, it take two FutexStates out of the free pool and lets them
   // expire.
   //
-  // There is a master spin lock for each process which protects the sets of
-  // active and free FutexStates.  Any time a thread needs to work with futex
-  // ID X, it must first obtain the process-wide pool lock and either find the
-  // FutexState in the active set with that ID, or activate one from the free
-  // list.  After this, the process wide pool lock is immediately released.
+  // The active FutexStates are kept in a table of buckets, each with its own
+  // spin lock, and the free FutexStates in a pool with a separate pool lock.
+  // Any time a thread needs to work with futex ID X, it must first obtain the
+  // lock of X's bucket and either find the FutexState in the bucket with that
+  // ID, or activate one from the free pool, briefly taking the pool lock as
+  // well.  After this, the bucket lock is immediately released.  Threads
+  // working with futexes in different buckets never contend on these locks.
   //
   // In order to keep this FutexState from disappearing out from under
   // the thread during its Wait/Wake/Requeue operation, a "pending operation"
@@ -196,7 +261,7 @@ class FutexContext {
   // FutexState objects are managed using ktl::unique_ptr.  At all times, a
   // FutexState will be in one of three states.
   //
-  // 1) A member of a FutexContext's active_futexes_ hashtable.  Futexes in this state are
+  // 1) A member of one of a FutexContext's buckets_.  Futexes in this state are
   //    currently involved in at least one futex operation.  Their futex ID will
   //    be non-zero as will their pending operation count..
   // 2) A member of a FutexContext's free_futexes_ list.  These futexes are
@@ -214,7 +279,7 @@ class FutexContext {
     // PendingOpRef to represent the borrow from the pool instead of a raw
     // FutexState pointer.  By default, these object will release a pending
     // operation reference when they go out of scope.  They do this under the
-    // protection of the outer FutexContext's pool_lock_, returning the
+    // protection of the lock of the FutexState's bucket, returning the
     // FutexState to the FutexContext's free pool when the pending operation
     // count reaches zero.
     //
@@ -291,13 +356,22 @@ class FutexContext {
       }
 
       void TakeRefs(PendingOpRef* other, uint32_t count) {
-        Guard<SpinLock, IrqSave> pool_lock_guard{&ctx_->pool_lock_};
         DEBUG_ASSERT(state_ != nullptr);
         DEBUG_ASSERT(other->state_ != nullptr);
-        DEBUG_ASSERT(state_->pending_operation_count_ > 0);
-        DEBUG_ASSERT(other->state_->pending_operation_count_ > count);
 
-        state_->pending_operation_count_ += count;
+        // The two states may be in different buckets.  Add the references here
+        // before removing them from |other|, which keeps both counts above
+        // zero throughout, so neither lock needs to be held with the other.
+        {
+          Bucket& bucket = ctx_->BucketFor(state_->id());
+          Guard<SpinLock, IrqSave> bucket_guard{&bucket.lock};
+          DEBUG_ASSERT(state_->pending_operation_count_ > 0);
+          state_->pending_operation_count_ += count;
+        }
+
+        Bucket& other_bucket = ctx_->BucketFor(other->state_->id());
+        Guard<SpinLock, IrqSave> other_bucket_guard{&other_bucket.lock};
+        DEBUG_ASSERT(other->state_->pending_operation_count_ > count);
         other->state_->pending_operation_count_ -= count;
       }
 
@@ -315,7 +389,8 @@ class FutexContext {
      private:
       void Release() {
         if (state_ != nullptr) {
-          Guard<SpinLock, IrqSave> pool_lock_guard{&ctx_->pool_lock_};
+          Bucket& bucket = ctx_->BucketFor(state_->id());
+          Guard<SpinLock, IrqSave> bucket_guard{&bucket.lock};
           uint32_t release_count = 1 + extra_refs_;
 
           DEBUG_ASSERT(state_ != nullptr);
@@ -324,9 +399,13 @@ class FutexContext {
 
           state_->pending_operation_count_ -= release_count;
           if (state_->pending_operation_count_ == 0) {
-            ctx_->free_futexes_.push_front(ctx_->active_futexes_.erase(*state_));
+            ktl::unique_ptr<FutexState> free_state = bucket.futexes.erase(*state_);
             state_->id_ = FutexId::Null();
             state_->waiters_.AssertNotOwned();
+            DEBUG_ASSERT(state_->multi_waiters_.is_empty());
+
+            Guard<SpinLock, NoIrqSave> pool_lock_guard{&ctx_->pool_lock_};
+            ctx_->free_futexes_.push_front(ktl::move(free_state));
           }
 
           state_ = nullptr;
@@ -343,9 +422,9 @@ class FutexContext {
 
     FutexId id() const { return id_; }
 
-    // hashtable support
-    FutexId GetKey() const { return id(); }
-    static size_t GetHash(FutexId key) { return FutexId::GetHash(key); }
+    // Wakes up to |count| of the threads waiting on this futex in FutexWaitMultiple, returning how
+    // many were woken.  Must be called with |lock_| held.
+    uint32_t WakeMultiWaitersLocked(uint32_t count);
 
    private:
     friend typename ktl::unique_ptr<FutexState>::deleter_type;
@@ -364,7 +443,12 @@ class FutexContext {
     FutexId id_{FutexId::Null()};
     OwnedWaitQueue waiters_;
 
-    // pending operation count is protected by the outer FutexContext pool lock.
+    // Threads waiting on this futex in FutexWaitMultiple.  Protected by |lock_|.  Each of them
+    // holds a pending operation reference while it is queued.
+    fbl::DoublyLinkedList<MultiWaitEntry*> multi_waiters_;
+
+    // pending operation count is protected by the lock of the FutexContext bucket holding this
+    // state.
     // Sadly, there is no good way to express this using static annotations.
     uint32_t pending_operation_count_ = 0;
 
@@ -397,16 +481,59 @@ class FutexContext {
   static void* operator new(size_t) = delete;
   static void* operator new[](size_t) = delete;
 
+  // Returns the ID of the futex at |value_ptr| in the current process, as
+  // determined by |key_type_|.
+  FutexId GetFutexId(user_in_ptr<const zx_futex_t> value_ptr) const;
+
+  // Add |count| newly allocated FutexStates to the free pool, or take |count|
+  // FutexStates out of it and free them.  Used by FutexWaitMultiple, which
+  // needs a FutexState for each of its futexes, on top of the ones contributed
+  // by each thread (see GrowFutexStatePool).
+  zx_status_t AddFutexStates(size_t count);
+  void RemoveFutexStates(size_t count);
+
+  // A bucket of the table of active futexes.  Each bucket has its own lock, so
+  // that operations on futexes in different buckets do not contend.
+  struct Bucket {
+    // Protects |futexes| and the pending operation counts of the FutexStates in
+    // it.  This is an irq-disable spin lock because it should _never_ be held
+    // during any blocking operations.
+    //
+    // There are times where an individual futex state must be held invariant
+    // while a decision to return a futex into the free pool needs to be made.
+    // In these cases, the bucket lock must be acquired *after* the individual
+    // FutexState lock.  Sadly, I don't know a good way to express this with
+    // static analysis.
+    //
+    // Note that lockdep tracking is disabled on this lock because it is
+    // acquired while holding the thread lock.
+    DECLARE_SPINLOCK(Bucket, lockdep::LockFlagsTrackingDisabled) lock;
+
+    // FutexStates currently in use (eg; futexes with waiters) whose IDs hash
+    // to this bucket.  Buckets are expected to hold very few states, so a list
+    // is searched linearly.
+    fbl::DoublyLinkedList<ktl::unique_ptr<FutexState>> futexes TA_GUARDED(lock);
+  };
+
+  // Returns the bucket of the futex with the given ID.  The ID hash is scrambled
+  // with a multiplicative (Fibonacci) hash, whose top bits select the bucket,
+  // since futex addresses tend to differ only in a few low bits.
+  Bucket& BucketFor(FutexId id) const {
+    constexpr uint64_t kMultiplier = 0x9E3779B97F4A7C15;
+    return buckets_[(static_cast<uint64_t>(FutexId::GetHash(id)) * kMultiplier) >> bucket_shift_];
+  }
+
   // Find the futex state for a given ID in the futex table, increment its
   // pending operation reference count, and return an RAII helper which helps to
   // manage the pending operation references.
-  FutexState::PendingOpRef FindActiveFutex(FutexId id) TA_EXCL(pool_lock_) {
-    Guard<SpinLock, IrqSave> pool_lock_guard{&pool_lock_};
-    return FindActiveFutexLocked(id);
+  FutexState::PendingOpRef FindActiveFutex(FutexId id) {
+    Bucket& bucket = BucketFor(id);
+    Guard<SpinLock, IrqSave> bucket_guard{&bucket.lock};
+    return FindActiveFutexLocked(bucket, id);
   }
 
-  FutexState::PendingOpRef FindActiveFutexLocked(FutexId id) TA_REQ(pool_lock_) {
-    auto iter = active_futexes_.find(id);
+  FutexState::PendingOpRef FindActiveFutexLocked(Bucket& bucket, FutexId id) TA_REQ(bucket.lock) {
+    auto iter = bucket.futexes.find_if([id](const FutexState& state) { return state.id() == id; });
 
     if (iter.IsValid()) {
       DEBUG_ASSERT(iter->pending_operation_count_ > 0);
@@ -421,16 +548,17 @@ class FutexContext {
   // and return it to the caller.  If the given futex ID is not currently
   // active, grab a free one and activate it.
   FutexState::PendingOpRef ActivateFutex(FutexId id) TA_EXCL(pool_lock_) {
-    Guard<SpinLock, IrqSave> pool_lock_guard{&pool_lock_};
-    return ActivateFutexLocked(id);
-  }
-
-  FutexState::PendingOpRef ActivateFutexLocked(FutexId id) TA_REQ(pool_lock_) {
-    if (auto ret = FindActiveFutexLocked(id); ret != nullptr) {
+    Bucket& bucket = BucketFor(id);
+    Guard<SpinLock, IrqSave> bucket_guard{&bucket.lock};
+    if (auto ret = FindActiveFutexLocked(bucket, id); ret != nullptr) {
       return ret;
     }
 
-    ktl::unique_ptr<FutexState> new_state = free_futexes_.pop_front();
+    ktl::unique_ptr<FutexState> new_state;
+    {
+      Guard<SpinLock, NoIrqSave> pool_lock_guard{&pool_lock_};
+      new_state = free_futexes_.pop_front();
+    }
 
     // Sanity checks.
     DEBUG_ASSERT(new_state != nullptr);
@@ -441,35 +569,30 @@ class FutexContext {
     FutexState* ptr = new_state.get();
     ptr->id_ = id;
     ++ptr->pending_operation_count_;
-    active_futexes_.insert(ktl::move(new_state));
+    bucket.futexes.push_front(ktl::move(new_state));
 
     return {this, ptr};
   }
 
-  // Protects the free futex pool, and active futex table.  This is an
-  // irq-disable spin lock because it should _never_ be held during any blocking
-  // operations.  Only when putting FutexStates into and out of the free pool,
-  // and when moving Futexes states to and from the active table.
-  //
-  // There are times where an individual futex state must be held invariant
-  // while a decision to return a futex into the free pool needs to be made.  In
-  // these cases, the pool lock must be acquired *after* the individual
-  // FutexState lock.  Sadly, I don't know a good way to express this with
-  // static analysis.
+  // Protects the free futex pool.  This is an irq-disable spin lock because it
+  // should _never_ be held during any blocking operations.  Only when putting
+  // FutexStates into and out of the free pool.  When both are needed, it is
+  // acquired after a bucket lock.
   //
   // Note that lockdep tracking is disabled on this lock because it is acquired
   // while holding the thread lock.
   DECLARE_SPINLOCK(FutexContext, lockdep::LockFlagsTrackingDisabled) pool_lock_;
 
-  using ActiveFutexMap = fbl::HashTable<FutexId, ktl::unique_ptr<FutexState>,
-                                        fbl::DoublyLinkedList<ktl::unique_ptr<FutexState>>, size_t,
-                                        fbl::kDynamicBucketCount>;
-
-  // Map containing FutexStates currently in use (eg; futexes with waiters).
-  ActiveFutexMap active_futexes_ TA_GUARDED(pool_lock_);
+  // The table of active futexes.  Its size is a power of two, fixed by |Init|.
+  ktl::unique_ptr<Bucket[]> buckets_;
+  size_t num_buckets_ = 0;
+  uint32_t bucket_shift_ = 0;
 
   // Free list for all futexes which are currently not in use.
   fbl::DoublyLinkedList<ktl::unique_ptr<FutexState>> free_futexes_ TA_GUARDED(pool_lock_);
+
+  // Set once by |Init|.
+  KeyType key_type_ = KeyType::Address;
 };
 
 #endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_FUTEX_CONTEXT_H_
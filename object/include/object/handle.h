@@ -10,11 +10,14 @@
 #include <stdint.h>
 #include <zircon/types.h>
 
+#include <arch/defines.h>
+#include <fbl/array.h>
 #include <fbl/gparena.h>
 #include <fbl/intrusive_double_list.h>
 #include <fbl/macros.h>
 #include <fbl/ref_ptr.h>
 #include <kernel/event_limiter.h>
+#include <kernel/rcu.h>
 #include <ktl/atomic.h>
 #include <ktl/utility.h>
 
@@ -23,6 +26,74 @@ class Handle;
 
 constexpr uint32_t kHandleReservedBits = 2;
 
+// Splits a Handle's base_value, which ProcessDispatcher uses to create zx_handle_t values, into an
+// index into the handle arena and a generation number that changes each time the slot is reused:
+//
+//   [31..(32 - kHandleReservedBits)]             : Must be zero
+//   [(31 - kHandleReservedBits)..index_bits()]   : Generation number, masked by generation_mask()
+//   [index_bits()-1..0]                          : Index into the arena, masked by index_mask()
+//
+// By default the index has 18 bits, for 256K slots, which leaves 12 bits for the generation. An
+// arena with more slots is opt-in through kernel.handle.max-count, since each extra index bit
+// halves the number of times a slot can be reused before its values repeat.
+class HandleValueLayout {
+ public:
+  static constexpr uint32_t kDefaultIndexBits = 18;
+  static constexpr uint32_t kMaxIndexBits = 20;
+
+  constexpr HandleValueLayout() = default;
+  explicit constexpr HandleValueLayout(uint32_t index_bits) : index_bits_(index_bits) {}
+
+  // Returns the default layout if it can index |count| slots, or otherwise the one with the
+  // fewest index bits that can, up to kMaxIndexBits.
+  static constexpr HandleValueLayout ForCount(size_t count) {
+    uint32_t index_bits = kDefaultIndexBits;
+    while (index_bits < kMaxIndexBits && (size_t{1} << index_bits) < count) {
+      index_bits++;
+    }
+    return HandleValueLayout(index_bits);
+  }
+
+  constexpr uint32_t index_bits() const { return index_bits_; }
+  constexpr size_t index_limit() const { return size_t{1} << index_bits_; }
+  constexpr uint32_t index_mask() const { return static_cast<uint32_t>(index_limit() - 1); }
+  constexpr uint32_t generation_mask() const { return ~index_mask() & ~kReservedBitsMask; }
+  // The number of distinct generations a slot goes through before its values repeat.
+  constexpr uint32_t generation_count() const {
+    return 1u << (32 - kHandleReservedBits - index_bits_);
+  }
+
+  // Returns the value for the next use of slot |index|, whose previous value was |old_value|, or
+  // zero if the slot has never been used.
+  constexpr uint32_t NewValue(uint32_t index, uint32_t old_value) const {
+    uint32_t old_gen = 0;
+    if (old_value != 0) {
+      // This slot has been used before.
+      old_gen = (old_value & generation_mask()) >> index_bits_;
+    }
+    const uint32_t new_gen = ((old_gen + 1) << index_bits_) & generation_mask();
+    return index | new_gen;
+  }
+
+  constexpr uint32_t ValueToIndex(uint32_t value) const { return value & index_mask(); }
+
+ private:
+  static constexpr uint32_t kReservedBitsMask = ((1u << kHandleReservedBits) - 1)
+                                                << (32 - kHandleReservedBits);
+  static_assert(32 - kHandleReservedBits - kMaxIndexBits >= 8,
+                "Not enough room for a useful generation count");
+
+  uint32_t index_bits_ = kDefaultIndexBits;
+};
+
+static_assert((HandleValueLayout().generation_mask() & HandleValueLayout().index_mask()) == 0,
+              "Handle Mask Overlap!");
+static_assert((HandleValueLayout().generation_mask() | HandleValueLayout().index_mask()) ==
+                  (0xffffffffu >> kHandleReservedBits),
+              "Handle masks do not cover all bits!");
+static_assert(HandleValueLayout().generation_count() == 4096,
+              "The default layout must keep 12 generation bits");
+
 template <typename T>
 class KernelHandle;
 
@@ -45,11 +116,21 @@ class Handle final {
 
   // Returns the handle table that owns this instance. Used to guarantee
   // that a process may only access handles in its own handle table.
-  zx_koid_t handle_table_id() const { return handle_table_id_.load(ktl::memory_order_relaxed); }
+  //
+  // Pairs with set_handle_table_id() so that a lockless lookup which observes
+  // the owning table also observes the fully constructed handle.
+  zx_koid_t handle_table_id() const { return handle_table_id_.load(ktl::memory_order_acquire); }
 
   // Sets the value returned by handle_table_id().
   void set_handle_table_id(zx_koid_t pid);
 
+  // Lockless lookups, see HandleTable::ResolveHandle, bracket their use of dispatcher() with these
+  // so that HandleTableArena::Delete does not release the dispatcher underneath them. Must be
+  // called inside an RCU read-side section, on a handle already seen owned by |table_id|.
+  // BeginLookup returns false, and needs no EndLookup, if the handle is no longer owned by it.
+  bool BeginLookup(zx_koid_t table_id) const;
+  void EndLookup() const { lookups_.fetch_sub(1, ktl::memory_order_release); }
+
   // Returns the |rights| parameter that was provided when this instance
   // was created.
   uint32_t rights() const { return rights_; }
@@ -127,6 +208,13 @@ class Handle final {
   friend HandleTableArena;
 
   NodeState node_state_;
+
+  // Used by HandleTableArena::Delete to defer returning the arena slot until
+  // lockless lookups which may have found this handle are done.
+  rcu::RcuHead rcu_head_;
+
+  // The number of lockless lookups between BeginLookup and EndLookup.
+  mutable ktl::atomic<uint32_t> lookups_{0};
 };
 
 class HandleTableArena {
@@ -134,11 +222,35 @@ class HandleTableArena {
   // Alloc returns storage for a handle.
   void* Alloc(const fbl::RefPtr<Dispatcher>&, const char* what, uint32_t* base_value);
 
+  // Tears down |handle| and releases its dispatcher reference. The arena slot is
+  // only returned after an RCU grace period, since HandleTable resolves handle
+  // values without its lock.
   void Delete(Handle* handle);
 
   static int64_t get_alloc_failed_count();
 
+  // The number of free slots each CPU may cache, and the number that are moved between a CPU's
+  // cache and the arena at a time.
+  static constexpr size_t kCpuCacheSize = 64;
+  static constexpr size_t kCpuCacheBatch = kCpuCacheSize / 2;
+
  private:
+  // Sets up the arena to hold at least |max_count| live handles, in addition to any free slots
+  // held in the per-CPU caches.
+  void Init(size_t max_count);
+
+  // Returns the number of live handles, i.e. allocated arena slots that are not in a CPU cache.
+  size_t OutstandingCount() const;
+
+  // Allocates and frees slots through the current CPU's cache, falling back to the arena in
+  // batches.
+  void* AllocSlot();
+  void FreeSlot(Handle* handle);
+
+  // Returns the slot of a deleted handle to the arena, once no lockless lookup
+  // can still observe it.
+  static void FinishDelete(rcu::RcuHead* head);
+
   // GetNewBaseValue is a helper needed to actually create a Handle.
   uint32_t GetNewBaseValue(void* addr);
 
@@ -154,6 +266,24 @@ class HandleTableArena {
                 Handle::PreserveSize);
   fbl::GPArena<Handle::PreserveSize, sizeof(Handle)> arena_;
 
+  // Per-CPU cache of free arena slots, which lets the common Alloc and Delete paths avoid the
+  // arena's shared free list and counters. A cache is only accessed by its own CPU with preemption
+  // disabled, except for |count| being read by diagnostics. Slots in a cache are free, and so
+  // retain their stashed base_value_ just like slots in the arena's free list.
+  struct alignas(MAX_CACHE_LINE) CpuCache {
+    ktl::atomic<size_t> count = 0;
+    void* slots[kCpuCacheSize];
+  };
+  // Must be called with preemption disabled.
+  CpuCache& CurrentCache();
+  fbl::Array<CpuCache> cpu_caches_;
+
+  // How handle values map to arena slots, which depends on the arena's size.
+  HandleValueLayout value_layout_;
+
+  // Live handle count at which warnings start being logged.
+  size_t high_handle_count_ = 0;
+
   // Limit logs about handle counts being too high.
   EventLimiter<ZX_SEC(1)> handle_count_high_log_;
 
@@ -66,6 +66,10 @@ class HandleTable : public fbl::RefCounted<HandleTable> {
   void AddHandle(HandleOwner handle);
   void AddHandleLocked(HandleOwner handle) TA_REQ(lock_);
 
+  // Adds all of |handles| to this handle table under a single acquisition of the lock, taking
+  // ownership of each of them.
+  void AddHandles(ktl::span<Handle* const> handles);
+
   // Set of overloads that remove the |handle| or |handle_value| from this
   // handle table and returns ownership to the handle.
   HandleOwner RemoveHandleLocked(Handle* handle) TA_REQ(lock_);
@@ -231,6 +235,20 @@ class HandleTable : public fbl::RefCounted<HandleTable> {
     HandleTable::HandleList::iterator iter_ TA_GUARDED(&lock_);
   };
 
+  // Resolves |handle_value| to its dispatcher and rights without taking |lock_|.
+  //
+  // The handle is located in |gHandleTableArena| by the index and generation
+  // encoded in |handle_value|, and accepted only if it is owned by this table.
+  // The lookup runs in an RCU read-side section, and HandleTableArena::Delete
+  // keeps the dispatcher reference alive for a grace period, so the dispatcher
+  // may be safely copied even if the handle is concurrently closed. In that
+  // case the lookup is ordered before the close.
+  //
+  // On failure, returns false and enforces ZX_POL_BAD_HANDLE if |caller| is
+  // non-null.
+  bool ResolveHandle(ProcessDispatcher* caller, zx_handle_t handle_value,
+                     fbl::RefPtr<Dispatcher>* out_dispatcher, zx_rights_t* out_rights) const;
+
   // Same as public |GetHandleLocked| overload, except process can be null.
   //
   // When |caller| is null, no policy enforcement happens.
@@ -248,21 +266,11 @@ class HandleTable : public fbl::RefCounted<HandleTable> {
   zx_status_t GetDispatcherWithRightsImpl(ProcessDispatcher* caller, zx_handle_t handle_value,
                                           zx_rights_t desired_rights,
                                           fbl::RefPtr<T>* out_dispatcher, zx_rights_t* out_rights) {
-    bool has_desired_rights;
     zx_rights_t rights;
     fbl::RefPtr<Dispatcher> generic_dispatcher;
-
-    {
-      // Scope utilized to reduce lock duration.
-      Guard<BrwLockPi, BrwLockPi::Reader> guard{&lock_};
-      Handle* handle = GetHandleLocked(caller, handle_value);
-      if (!handle)
-        return ZX_ERR_BAD_HANDLE;
-
-      has_desired_rights = handle->HasRights(desired_rights);
-      rights = handle->rights();
-      generic_dispatcher = handle->dispatcher();
-    }
+    if (!ResolveHandle(caller, handle_value, &generic_dispatcher, &rights))
+      return ZX_ERR_BAD_HANDLE;
+    const bool has_desired_rights = (rights & desired_rights) == desired_rights;
 
     fbl::RefPtr<T> dispatcher = DownCastDispatcher<T>(&generic_dispatcher);
 
@@ -13,8 +13,10 @@
 #include <zircon/rights.h>
 #include <zircon/types.h>
 
+#include <kernel/cpu.h>
 #include <kernel/event.h>
 #include <kernel/spinlock.h>
+#include <kernel/timer.h>
 #include <object/dispatcher.h>
 #include <object/port_dispatcher.h>
 
@@ -56,11 +58,29 @@ class InterruptDispatcher : public SoloDispatcher<InterruptDispatcher, ZX_DEFAUL
   // Returns information about this interrupt in a zx_object_get_info call.
   zx_info_interrupt_t GetInfo() const;
 
+  // Routes the interrupt to the lowest online CPU in |mask|. Returns ZX_ERR_NOT_SUPPORTED if the
+  // interrupt cannot be routed, e.g. if it is virtual.
+  zx_status_t SetAffinity(cpu_mask_t mask);
+
+  // While enabled, the interrupt is routed to the CPU of the thread that waits for or acks it, so
+  // that the handler runs where the consumer's caches are warm. Rerouting is rate limited, see
+  // MaybeFollowConsumerLocked. Stops on its own if the interrupt turns out not to be routable.
+  zx_status_t SetFollowConsumer(bool follow);
+
+  // While |window| is non-zero, an IRQ on a port-bound interrupt that is idle opens a coalescing
+  // window instead of queuing a packet straight away. IRQs within the window are folded into one
+  // packet, queued when the window closes, that also carries their number and the timestamp of
+  // the last of them. Interrupts that are masked while serviced stay masked for the window.
+  // Not supported for virtual interrupts or wake vectors.
+  zx_status_t SetCoalescing(zx_duration_mono_t window);
+
  protected:
   virtual void MaskInterrupt() = 0;
   virtual void UnmaskInterrupt() = 0;
   virtual void DeactivateInterrupt() = 0;
   virtual void UnregisterInterruptHandler() = 0;
+  // Routes the interrupt to |cpu|, which is online. Called with spinlock_ held.
+  virtual zx_status_t SetInterruptAffinity(cpu_num_t cpu) { return ZX_ERR_NOT_SUPPORTED; }
 
   enum Flags : uint32_t {
     // The interrupt is virtual.
@@ -115,9 +135,22 @@ class InterruptDispatcher : public SoloDispatcher<InterruptDispatcher, ZX_DEFAUL
   zx_status_t DoWaitForInterruptBlock() TA_EXCL(spinlock_);
 
  private:
+  // Reroutes the interrupt to the current CPU if following the consumer and the interrupt has
+  // fired often enough, and long enough ago, since it was last rerouted.
+  void MaybeFollowConsumerLocked() TA_REQ(spinlock_);
+
+  // Opens a coalescing window, see SetCoalescing.
+  void ArmCoalescingLocked() TA_REQ(spinlock_);
+  static void CoalescingTimerCallback(Timer* timer, zx_time_t now, void* arg);
+  void OnCoalescingWindowClosed() TA_EXCL(spinlock_);
+
   AutounsignalEvent event_;
 
   zx_time_t timestamp_ TA_GUARDED(spinlock_);
+  // When the first IRQ since the last wait fired, used to measure how long it takes the waiting
+  // thread to observe it. Zero if it has been observed, or if the interrupt was triggered by
+  // software.
+  zx_instant_mono_ticks_t irq_ticks_ TA_GUARDED(spinlock_) = 0;
   const Flags flags_;
   const uint32_t options_;
   // Current state of the interrupt object
@@ -126,6 +159,20 @@ class InterruptDispatcher : public SoloDispatcher<InterruptDispatcher, ZX_DEFAUL
   fbl::RefPtr<PortDispatcher> port_dispatcher_ TA_GUARDED(spinlock_);
   wake_vector::WakeEvent wake_event_ TA_GUARDED(spinlock_);
 
+  // Hardware IRQs delivered so far, and the affinity bookkeeping for SetFollowConsumer.
+  uint64_t interrupt_count_ TA_GUARDED(spinlock_) = 0;
+  bool follow_consumer_ TA_GUARDED(spinlock_) = false;
+  cpu_num_t affinity_cpu_ TA_GUARDED(spinlock_) = INVALID_CPU;
+  uint64_t last_steer_count_ TA_GUARDED(spinlock_) = 0;
+  zx_instant_mono_t last_steer_time_ TA_GUARDED(spinlock_) = 0;
+
+  // Coalescing state, see SetCoalescing. |pending_count_| counts the IRQs since the last packet.
+  zx_duration_mono_t coalescing_window_ TA_GUARDED(spinlock_) = 0;
+  bool coalescing_armed_ TA_GUARDED(spinlock_) = false;
+  uint64_t pending_count_ TA_GUARDED(spinlock_) = 0;
+  zx_time_t last_timestamp_ TA_GUARDED(spinlock_) = 0;
+  Timer coalescing_timer_;
+
   // Controls the access to Interrupt properties
   DECLARE_SPINLOCK(InterruptDispatcher) spinlock_;
 };
@@ -37,6 +37,7 @@ class InterruptEventDispatcher final : public InterruptDispatcher {
   void UnmaskInterrupt() final;
   void DeactivateInterrupt() final;
   void UnregisterInterruptHandler() final;
+  zx_status_t SetInterruptAffinity(cpu_num_t cpu) final;
 
   zx_status_t RegisterInterruptHandler();
 
@@ -45,9 +45,20 @@ class IoBufferSharedRegionDispatcher
 
   Header* GetHeader() const { return reinterpret_cast<Header*>(base_); }
 
+  // Messages up to this size are staged on the stack rather than in a heap bounce buffer.
+  static constexpr size_t kInlineBounceSize = 256;
+
   fbl::RefPtr<VmObjectPaged> vmo_;
   fbl::RefPtr<VmMapping> mapping_;
   zx_vaddr_t base_;
+
+  // Writes are not serialized by a lock. Each writer copies its message into a bounce buffer,
+  // reserves its space by advancing |reserved_|, copies its message in and then, once every
+  // message before its own has been published, publishes it by advancing |committed_| and the head
+  // seen by userspace. Both are kept here rather than read back from the header, which userspace
+  // can write to.
+  ktl::atomic<uint64_t> reserved_{0};
+  ktl::atomic<uint64_t> committed_{0};
 };
 
 #endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_IO_BUFFER_SHARED_REGION_DISPATCHER_H_
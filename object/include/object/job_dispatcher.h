@@ -47,6 +47,22 @@ class JobEnumerator {
   virtual ~JobEnumerator() = default;
 };
 
+// A flattened record of one job or process, see JobDispatcher::SnapshotSubtree.
+struct JobTreeEntry {
+  zx_koid_t koid;
+  // The koid of the parent job.
+  zx_koid_t parent_koid;
+  // Either ZX_OBJ_TYPE_JOB or ZX_OBJ_TYPE_PROCESS.
+  zx_obj_type_t type;
+  // The number of jobs between this node and the job the snapshot was taken of, which has a depth
+  // of 0.
+  uint32_t depth;
+  char name[ZX_MAX_NAME_LEN];
+  // As returned by GetTaskRuntimeStats. For a job this only covers its own processes, both live and
+  // exited, and not those of its child jobs.
+  TaskRuntimeStats runtime;
+};
+
 namespace internal {
 struct JobDispatcherRawListTag {};  // Tag for a JobDispatcher's parent's raw job list.
 struct JobDispatcherListTag {};     // Tag for a JobDispatcher's parent's job list.
@@ -152,6 +168,17 @@ class JobDispatcher final
   // otherwise.
   bool EnumerateChildrenRecursive(JobEnumerator* je) TA_EXCL(get_lock());
 
+  // Walks this job and the whole tree below it, invoking |func| once for each job and process with
+  // every job reported before any of its descendants. Unlike EnumerateChildrenRecursive, no lock is
+  // held across the walk or while |func| is invoked: the lock of each job is only held while its
+  // direct children and their runtime stats are collected, which makes each job's record
+  // consistent with those of its processes and allows |func| to perform user copies.
+  //
+  // Returns ZX_ERR_STOP if |func| returned false, ZX_ERR_NO_MEMORY if the snapshot of a job's
+  // children could not be allocated, and ZX_OK otherwise.
+  zx_status_t SnapshotSubtree(fit::inline_function<bool(const JobTreeEntry&)> func)
+      TA_EXCL(get_lock());
+
   fbl::RefPtr<ProcessDispatcher> LookupProcessById(zx_koid_t koid);
   fbl::RefPtr<JobDispatcher> LookupJobById(zx_koid_t koid);
 
@@ -247,6 +274,12 @@ class JobDispatcher final
   template <typename T>
   uint64_t ChildCountLocked() const TA_REQ(get_lock());
 
+  // Reports this job, at |depth|, and its processes to |func| and collects its child jobs into
+  // |child_jobs|. See SnapshotSubtree.
+  zx_status_t SnapshotNode(uint32_t depth, LiveRefsArray<JobDispatcher>* child_jobs,
+                           const fit::inline_function<bool(const JobTreeEntry&)>& func)
+      TA_EXCL(get_lock());
+
   bool CanSetPolicy() TA_REQ(get_lock());
 
   using OOMBitJobArray = ktl::array<fbl::RefPtr<JobDispatcher>, 8>;
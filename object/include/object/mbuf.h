@@ -7,6 +7,8 @@
 #ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_MBUF_H_
 #define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_MBUF_H_
 
+#include <lib/page_cache.h>
+#include <lib/user_copy/user_iovec.h>
 #include <lib/user_copy/user_ptr.h>
 #include <stdint.h>
 #include <zircon/types.h>
@@ -18,6 +20,10 @@
 //
 // It's designed to back sockets and channels.  Don't simultaneously store stream data and datagrams
 // in a single instance.
+//
+// MBufs are allocated from a private PageCache so that bursty traffic, where chains repeatedly grow
+// and drain, is served from per-CPU reserves instead of the PMM. The page cache is tunable by the
+// kernel command line parameter kernel.mbuf.reserve-pages.
 class MBufChain {
  public:
   MBufChain() = default;
@@ -40,6 +46,11 @@ class MBufChain {
   // |written| is set with the amount.
   zx_status_t WriteDatagram(user_in_ptr<const char> src, size_t len, size_t* written);
 
+  // Same as WriteStream() and WriteDatagram() but gathers the data from the buffers in |src|. A
+  // vector written with WriteDatagram() forms a single datagram.
+  zx_status_t WriteStream(user_in_iovec_t src, size_t* written);
+  zx_status_t WriteDatagram(user_in_iovec_t src, size_t* written);
+
   // Reads up to |len| bytes from chain into |dst|.
   //
   // When |datagram| is false, the data in the chain is treated as a stream (no boundaries).
@@ -61,6 +72,22 @@ class MBufChain {
   // Returns an error on failure.
   zx_status_t Peek(user_out_ptr<char> dst, size_t len, bool datagram, size_t* actual) const;
 
+  // Same as Read() and Peek() but scatters the data into the buffers in |dst|, in order, reading
+  // up to their total capacity.
+  zx_status_t Read(user_out_iovec_t dst, bool datagram, size_t* actual);
+  zx_status_t Peek(user_out_iovec_t dst, bool datagram, size_t* actual) const;
+
+  // Moves up to |len| bytes from the front of |src| to the back of this chain, limited by the space
+  // remaining in this chain, and returns the number of bytes moved.
+  //
+  // Whole MBufs are unlinked from |src| and linked into this chain, so only a partially consumed
+  // buffer at the front of |src|, or a buffer small enough to fit in the free space of our last
+  // buffer, is copied.
+  //
+  // When |datagram| is true, only whole datagrams are moved and the splice stops at the first
+  // datagram that does not fit in |len| or in this chain.
+  size_t Splice(MBufChain* src, size_t len, bool datagram);
+
   bool is_full() const { return size_ >= kSizeMax; }
   bool is_empty() const { return size_ == 0; }
 
@@ -81,6 +108,11 @@ class MBufChain {
   // testing reasons.
   static size_t mbuf_payload_size() { return MBuf::kPayloadSize; }
 
+  static void InitializePageCache(uint32_t level);
+
+  // Prints the memory held by MBufs across all chains.
+  static void DumpMemoryUsage();
+
  private:
   // An MBuf is a small fixed-size chainable memory buffer.
   struct MBuf : public fbl::DoublyLinkedListable<MBuf*> {
@@ -134,6 +166,8 @@ class MBufChain {
   // Takes ownership of and frees the provided buffers.
   static void FreeMBufs(MBufList&& bufs);
 
+  inline static page_cache::PageCache page_cache_;
+
   // Helper method to provide common code for Read() and Peek().
   //
   // The static template function allows us to use the same code for both
@@ -143,6 +177,19 @@ class MBufChain {
   static zx_status_t ReadHelper(T* chain, user_out_ptr<char> dst, size_t len, bool datagram,
                                 size_t* actual);
 
+  // Helper method to provide common code for the vectored Read() and Peek().
+  template <typename T>
+  static zx_status_t ReadVectorHelper(T* chain, user_out_iovec_t dst, bool datagram,
+                                      size_t* actual);
+
+  // Discards |len| bytes of stream data, or the first datagram when |datagram| is true, from the
+  // front of the chain.
+  void Consume(size_t len, bool datagram);
+
+  // Appends |len| bytes from kernel memory |src| to the chain, allocating buffers as needed, and
+  // returns the number of bytes appended, which is short only if allocation fails.
+  size_t AppendBytes(const char* src, size_t len);
+
   // The active buffers that make up this chain. buffers_.front() + read_cursor_off_ is the read
   // cursor. buffers_.back() is the write cursor.
   MBufList buffers_;
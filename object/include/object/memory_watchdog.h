@@ -56,6 +56,21 @@ class MemoryWatchdog {
   // pressure change to level |idx|.
   inline bool IsSignalDue(PressureLevel idx, zx_instant_mono_t time_now) const;
 
+  // Called by the WorkerThread to sample free memory and memory stall time, and to update whether
+  // the warning level is predicted to be reached soon.
+  void UpdatePrediction(zx_instant_mono_t time_now);
+
+  // The level whose event should be signaled, which is the current level unless a warning has been
+  // predicted while at the normal level.
+  PressureLevel LevelToSignal() const {
+    return mem_event_idx_ == PressureLevel::kNormal && warning_predicted_ ? PressureLevel::kWarning
+                                                                          : mem_event_idx_;
+  }
+
+  // The deadline for waiting on a memory state change while at the current level, which is bounded
+  // by the prediction sample period whenever there is something to predict.
+  Deadline PredictionDeadline(zx_instant_mono_t time_now) const;
+
   // Called by the WorkerThread to determine if kernel eviction (asynchronous) needs to be triggered
   // in response to pressure change to level |idx|.
   inline bool IsEvictionRequired(PressureLevel idx) const;
@@ -81,6 +96,10 @@ class MemoryWatchdog {
   RelaxedAtomic<PressureLevel> mem_event_idx_ = PressureLevel::kNormal;
   PressureLevel prev_mem_event_idx_ = mem_event_idx_;
 
+  // The level whose event is currently signaled. This only differs from |prev_mem_event_idx_| when
+  // a warning was signaled because it was predicted.
+  PressureLevel signaled_idx_ = mem_event_idx_;
+
   // Watermark information is not modified after Init and so is safe for multiple threads to access.
   static constexpr uint8_t kNumWatermarks = PressureLevel::kNumLevels - 1;
   ktl::array<uint64_t, kNumWatermarks> mem_watermarks_;
@@ -96,6 +115,22 @@ class MemoryWatchdog {
   // Tracks last time the memory state was evaluated (and signaled if required).
   zx_instant_mono_t prev_mem_state_eval_time_ = ZX_TIME_INFINITE_PAST;
 
+  // How far ahead a decline in free memory is projected to predict the warning level, or zero if
+  // prediction is disabled. See kernel.oom.predict-warning-seconds.
+  zx_duration_mono_t predict_horizon_ = 0;
+  uint32_t predict_stall_percent_ = 0;
+
+  // How often free memory is sampled for prediction while at the normal level.
+  static constexpr zx_duration_mono_t kPredictionSamplePeriod = ZX_SEC(1);
+
+  // Prediction state, only accessed by the WorkerThread.
+  zx_instant_mono_t prev_sample_time_ = ZX_TIME_INFINITE_PAST;
+  uint64_t prev_sample_free_mem_ = 0;
+  zx_duration_mono_t prev_sample_stall_ = 0;
+  // Smoothed rate, in bytes per second, at which free memory has been falling.
+  int64_t free_mem_decline_rate_ = 0;
+  bool warning_predicted_ = false;
+
   // The highest pressure level we trigger eviction at, OOM being the lowest pressure level (0).
   PressureLevel max_eviction_level_ = PressureLevel::kCritical;
 
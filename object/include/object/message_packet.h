@@ -57,11 +57,19 @@ class MessagePacket final : public fbl::DoublyLinkedListable<MessagePacketPtr> {
   static zx_status_t Create(const char* data, uint32_t data_size, uint32_t num_handles,
                             MessagePacketPtr* msg);
 
+  // Messages whose packet, handles and payload fit in this many bytes are stored in a single slab
+  // object, rather than a BufferChain of pages. See |Storage|.
+  static constexpr size_t kSmallSlabSize = 256;
+  static constexpr size_t kMediumSlabSize = 1024;
+
   uint32_t data_size() const { return data_size_; }
 
   // Copies the packet's |data_size()| bytes to |buf|.
   // Returns an error if |buf| points to a bad user address.
   zx_status_t CopyDataTo(user_out_ptr<char> buf) const {
+    if (storage_ != Storage::kBufferChain) {
+      return buf.copy_array_to_user(static_cast<const char*>(payload()), data_size_);
+    }
     return buffer_chain_->CopyOut(buf, payload_offset_, data_size_);
   }
 
@@ -103,18 +111,28 @@ class MessagePacket final : public fbl::DoublyLinkedListable<MessagePacketPtr> {
   }
 
  private:
+  // Where the packet, followed by its handles and payload, lives. Messages that fit are stored in
+  // an object of a size class slab, so that a small message does not take a whole page. Larger
+  // messages are stored in a BufferChain, and the packet lives in its first buffer.
+  enum class Storage : uint8_t {
+    kBufferChain,
+    kSmallSlab,
+    kMediumSlab,
+  };
+
   // A private constructor ensures that users must use the static factory
   // Create method to create a MessagePacket.  This, in turn, guarantees that
   // when a user creates a MessagePacket, they end up with the proper
   // MessagePacket::UPtr type for managing the message packet's life cycle.
-  MessagePacket(BufferChain* chain, uint32_t data_size, uint32_t payload_offset,
+  MessagePacket(Storage storage, BufferChain* chain, uint32_t data_size, uint32_t payload_offset,
                 uint16_t num_handles, Handle** handles)
       : buffer_chain_(chain),
         handles_(handles),
         data_size_(data_size),
         payload_offset_(payload_offset),
         num_handles_(num_handles),
-        owns_handles_(false) {}
+        owns_handles_(false),
+        storage_(storage) {}
 
   // A private destructor helps to make sure that only our custom deleter is
   // ever used to destroy this object which, in turn, makes it very difficult
@@ -140,17 +158,28 @@ class MessagePacket final : public fbl::DoublyLinkedListable<MessagePacketPtr> {
                                           MessagePacketPtr* msg);
   static zx_status_t CreateCommon(size_t data_size, size_t num_handles, MessagePacketPtr* msg);
 
+  // Appends |size| bytes from |src| to the payload. Returns ZX_ERR_OUT_OF_RANGE if the payload
+  // does not have room for them.
+  zx_status_t AppendData(user_in_ptr<const char> src, size_t size);
+  zx_status_t AppendData(const char* src, size_t size);
+
   void set_data_size(uint32_t data_size) { data_size_ = data_size; }
 
-  const void* payload() const { return buffer_chain_->buffers()->front().data() + payload_offset_; }
-  void* payload() { return buffer_chain_->buffers()->front().data() + payload_offset_; }
+  // The packet is always at the start of its storage, and the beginning of the payload is always
+  // contiguous with it.
+  const void* payload() const { return reinterpret_cast<const char*>(this) + payload_offset_; }
+  void* payload() { return reinterpret_cast<char*>(this) + payload_offset_; }
 
+  // Only valid for Storage::kBufferChain.
   BufferChain* buffer_chain_;
   Handle** const handles_;
   uint32_t data_size_;
   const uint32_t payload_offset_;
   const uint16_t num_handles_;
   bool owns_handles_;
+  const Storage storage_;
+  // Number of payload bytes appended so far, for the slab storage. A BufferChain tracks its own.
+  uint32_t slab_append_offset_ = 0;
 };
 
 namespace internal {
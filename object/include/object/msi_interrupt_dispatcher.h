@@ -123,6 +123,7 @@ class MsiInterruptDispatcherImpl : public MsiInterruptDispatcher {
         capability_(reinterpret_cast<MsiCapability*>(this->mapping()->base() + reg_offset)) {}
   void MaskInterrupt() final;
   void UnmaskInterrupt() final;
+  zx_status_t SetInterruptAffinity(cpu_num_t cpu) final;
 
  private:
   // Not all interrupt controllers / configurations support masking at the
@@ -164,6 +165,7 @@ class MsixInterruptDispatcherImpl : public MsiInterruptDispatcher {
 
   void MaskInterrupt() final;
   void UnmaskInterrupt() final;
+  zx_status_t SetInterruptAffinity(cpu_num_t cpu) final;
 
  private:
   volatile MsixTableEntry* const table_entries_ = {};
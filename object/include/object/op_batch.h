@@ -0,0 +1,63 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_OP_BATCH_H_
+#define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_OP_BATCH_H_
+
+#include <stdint.h>
+#include <zircon/syscalls/port.h>
+#include <zircon/types.h>
+
+#include <ktl/span.h>
+
+class ProcessDispatcher;
+
+// Operations which may be submitted together and executed in a single kernel entry.
+enum class BatchOpcode : uint32_t {
+  // Equivalent to zx_object_signal(handle, signal.clear_mask, signal.set_mask).
+  kObjectSignal = 1,
+  // Equivalent to zx_object_signal_peer(handle, signal.clear_mask, signal.set_mask).
+  kObjectSignalPeer = 2,
+  // Equivalent to zx_port_queue(handle, &packet).
+  kPortQueue = 3,
+  // Equivalent to zx_futex_wake(futex_wake.value_ptr, futex_wake.count).  |handle| is ignored.
+  kFutexWake = 4,
+};
+
+// A single submitted operation.  This is the layout a user-space submission ring entry would
+// have, and is copied in to the kernel before the batch is executed.
+struct BatchOp {
+  BatchOpcode opcode;
+  zx_handle_t handle;
+  union {
+    struct {
+      uint32_t clear_mask;
+      uint32_t set_mask;
+    } signal;
+    zx_port_packet_t packet;
+    struct {
+      vaddr_t value_ptr;
+      uint32_t count;
+    } futex_wake;
+  };
+};
+
+// Options for ExecuteOpBatch.
+inline constexpr uint32_t kBatchStopOnError = 1u << 0;
+
+// Executes |ops| in order on behalf of |up|, writing the status of each executed operation to the
+// matching entry of |results|, which must be at least as long as |ops|.
+//
+// Each operation behaves exactly as its stand-alone syscall would, including rights checks and
+// bad handle policy.  When consecutive operations name the same handle, the handle is resolved
+// once and its dispatcher is reused.
+//
+// With kBatchStopOnError, execution stops after the first operation that fails.  Returns the
+// number of operations executed.
+size_t ExecuteOpBatch(ProcessDispatcher& up, ktl::span<const BatchOp> ops,
+                      ktl::span<zx_status_t> results, uint32_t options);
+
+#endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_OP_BATCH_H_
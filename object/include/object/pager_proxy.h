@@ -72,6 +72,18 @@ class PagerProxy : public PageProvider,
   // next request.
   void OnPacketFreedLocked() TA_REQ(mtx_);
 
+  // Moves pending requests of |type| that overlap or are adjacent to [*offset, *offset + *length)
+  // to coalesced_requests_, growing the range to cover them. At most
+  // kernel.userpager.coalesce_max_requests requests are moved.
+  void CoalescePendingLocked(page_request_type type, uint64_t* offset, uint64_t* length)
+      TA_REQ(mtx_);
+
+  using RequestList = fbl::TaggedDoublyLinkedList<PageRequest*, PageProviderTag>;
+
+  // Returns the list |request| is queued on, or nullptr if it is in neither pending_requests_ nor
+  // coalesced_requests_.
+  RequestList* QueuedListLocked(PageRequest* request) TA_REQ(mtx_);
+
   // Helper to do an informational printout if the thread has been waiting on the page request for
   // too long.
   void PrintOvertime(uint64_t waited_seconds) TA_EXCL(mtx_);
@@ -110,7 +122,11 @@ class PagerProxy : public PageProvider,
   // More details about this race can be found in https://fxbug.dev/42173553.
   // Queue of page_request_t's that have come in while packet_ is busy. The
   // head of this queue is sent to the port when packet_ is freed.
-  fbl::TaggedDoublyLinkedList<PageRequest*, PageProviderTag> pending_requests_ TA_GUARDED(mtx_);
+  RequestList pending_requests_ TA_GUARDED(mtx_);
+  // Requests whose ranges are covered by the packet_ currently queued in the port, in addition to
+  // active_request_. They are forgotten once the packet is delivered, as active_request_ is, and
+  // are returned to the head of pending_requests_ if the packet is cancelled instead.
+  RequestList coalesced_requests_ TA_GUARDED(mtx_);
 
   // PageRequest used for the complete message.
   PageRequest complete_request_ TA_GUARDED(mtx_);
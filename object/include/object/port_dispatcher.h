@@ -18,6 +18,7 @@
 #include <kernel/mutex.h>
 #include <kernel/semaphore.h>
 #include <kernel/spinlock.h>
+#include <ktl/span.h>
 #include <ktl/unique_ptr.h>
 #include <object/dispatcher.h>
 #include <object/handle.h>
@@ -134,6 +135,13 @@ struct PortAllocator {
 
 constexpr zx_packet_type_t kPortPacketTypeCanceled = 0xffffffff;
 
+// Kernel-internal wait_async option for a persistent observer. A persistent
+// observer stays registered with its Dispatcher after each match and reuses
+// its one packet: a match while the packet is still queued ORs the newly
+// observed signals into it instead of queuing another. There is no need to
+// re-arm the wait after each packet is dequeued.
+constexpr uint32_t kWaitAsyncPersistent = 1u << 31;
+
 struct PortPacket final : public fbl::DoublyLinkedListable<PortPacket*> {
   zx_port_packet_t packet;
   const void* const handle;
@@ -153,7 +161,12 @@ struct PortPacket final : public fbl::DoublyLinkedListable<PortPacket*> {
 
 struct PortInterruptPacket final : public fbl::DoublyLinkedListable<PortInterruptPacket*> {
   zx_instant_boot_t timestamp;
+  // For a coalesced interrupt, the number of IRQs and the timestamp of the last, otherwise zero.
+  uint64_t count;
+  zx_instant_boot_t last_timestamp;
   uint64_t key;
+  // When the packet was queued, used to measure how long it takes to be dequeued.
+  zx_instant_mono_ticks_t queued_ticks;
 };
 
 // Observers are weakly contained in Dispatchers.
@@ -196,6 +209,7 @@ class PortObserver final : public SignalObserver {
   void OnMatch(zx_signals_t signals) final;
   void OnCancel(zx_signals_t signals) final;
   bool MatchesKey(const void* port, uint64_t key) final;
+  bool IsPersistent() const final { return options_ & kWaitAsyncPersistent; }
 
   const uint32_t options_;
   PortPacket packet_;
@@ -249,12 +263,23 @@ class PortDispatcher final : public SoloDispatcher<PortDispatcher, ZX_DEFAULT_PO
   zx_status_t QueueAndRemoveObserver(PortPacket* port_packet, zx_signals_t observed,
                                      PortObserver* observer);
 
+  // Queues the packet of a persistent observer with |observed| signals and |timestamp|, or ORs
+  // |observed| into it if it is still queued.
+  zx_status_t QueueOrUpdatePersistent(PortPacket* port_packet, zx_signals_t observed,
+                                      uint64_t timestamp);
+
   // Queues a user packet.
   zx_status_t QueueUser(const zx_port_packet_t& packet);
 
   // Queues an interrupt packet.
-  bool QueueInterruptPacket(PortInterruptPacket* port_packet, zx_instant_boot_t timestamp);
+  bool QueueInterruptPacket(PortInterruptPacket* port_packet, zx_instant_boot_t timestamp,
+                            uint64_t count = 0, zx_instant_boot_t last_timestamp = 0);
   zx_status_t Dequeue(const Deadline& deadline, zx_port_packet_t* packet);
+
+  // Waits until |deadline| for at least one packet, then dequeues up to |packets.size()| packets
+  // that are ready, taking the port lock once. The number dequeued is returned in |num_packets|.
+  zx_status_t DequeueMany(const Deadline& deadline, ktl::span<zx_port_packet_t> packets,
+                          size_t* num_packets);
   bool RemoveInterruptPacket(PortInterruptPacket* port_packet);
 
   // This method determines the observer's fate. Upon return, one of the following will have
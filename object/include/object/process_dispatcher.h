@@ -24,6 +24,7 @@
 #include <ktl/array.h>
 #include <ktl/forward.h>
 #include <ktl/span.h>
+#include <object/async_prefetch.h>
 #include <object/dispatcher.h>
 #include <object/exceptionate.h>
 #include <object/futex_context.h>
@@ -35,6 +36,7 @@
 #include <vm/vm_aspace.h>
 
 class JobDispatcher;
+class ProcessTemplate;
 class VmarMapsInfoWriter;
 class VmoInfoWriter;
 
@@ -61,10 +63,13 @@ class ProcessDispatcher final
   using RawJobListTag = internal::ProcessDispatcherRawJobListTag;
   using JobListTag = internal::ProcessDispatcherJobListTag;
 
+  // If |process_template| is given, its segments are mapped into the root VMAR before the process
+  // is made visible in its job.
   static zx_status_t Create(fbl::RefPtr<JobDispatcher> job, ktl::string_view name, uint32_t flags,
                             KernelHandle<ProcessDispatcher>* handle, zx_rights_t* rights,
                             KernelHandle<VmAddressRegionDispatcher>* root_vmar_handle,
-                            zx_rights_t* root_vmar_rights);
+                            zx_rights_t* root_vmar_rights,
+                            const ProcessTemplate* process_template = nullptr);
 
   // Creates a new process dispatcher for a process that will share its `shareable_state_` with
   // other processes.
@@ -134,12 +139,21 @@ class ProcessDispatcher final
   HandleTable& handle_table() { return shareable_state_->handle_table(); }
   const HandleTable& handle_table() const { return shareable_state_->handle_table(); }
 
-  FutexContext& futex_context() { return shareable_state_->futex_context(); }
+  // Returns the futex context used by this process.  This is the context shared
+  // with other processes sharing its state, unless futexes are keyed by memory
+  // object (see FutexContext::MemoryKeyed).
+  FutexContext& futex_context() {
+    FutexContext* const memory_keyed = FutexContext::MemoryKeyed();
+    return memory_keyed != nullptr ? *memory_keyed : shareable_state_->futex_context();
+  }
 
   // Returns a pointer to the process's VmAspace containing |va| if such an aspace exists, otherwise
   // it returns the normal aspace of the process.
   VmAspace* aspace_at(vaddr_t va);
 
+  // Bounds the asynchronous prefetches queued on behalf of this process.
+  AsyncPrefetchQuota& async_prefetch_quota() { return async_prefetch_quota_; }
+
 #if ARCH_X86
   // Returns an identifier that can be used to associate hardware trace
   // data with this process.
@@ -408,6 +422,8 @@ class ProcessDispatcher final
   Exceptionate exceptionate_;
   Exceptionate debug_exceptionate_;
 
+  AsyncPrefetchQuota async_prefetch_quota_;
+
   // This is the value of _dl_debug_addr from ld.so.
   // See third_party/ulib/musl/ldso/dynlink.c.
   uintptr_t debug_addr_ TA_GUARDED(get_lock()) = 0;
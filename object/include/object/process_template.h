@@ -0,0 +1,61 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_PROCESS_TEMPLATE_H_
+#define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_PROCESS_TEMPLATE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <zircon/types.h>
+
+#include <fbl/array.h>
+#include <fbl/ref_counted.h>
+#include <fbl/ref_ptr.h>
+#include <ktl/span.h>
+
+class VmAddressRegion;
+class VmObject;
+
+// An immutable description of the initial layout of a process's root VMAR, such as the vDSO and
+// the segments of a program and its interpreter, which can be stamped into any number of new
+// processes by ProcessDispatcher::Create without a separate map call per segment.
+//
+// Read-only segments map the template's VMO directly, so every process created from the template
+// shares its pages. Writable segments map a fresh snapshot-at-least-on-write child of the VMO, so
+// pages are only copied once a process writes to them. No mapping is populated up front; page
+// tables are filled in lazily by faults, as for any other mapping.
+class ProcessTemplate final : public fbl::RefCounted<ProcessTemplate> {
+ public:
+  struct Segment {
+    fbl::RefPtr<VmObject> vmo;
+    uint64_t vmo_offset;
+    // Offset of the mapping from the base of the root VMAR.
+    size_t vmar_offset;
+    size_t size;
+    // Any combination of ARCH_MMU_FLAG_PERM_{READ,WRITE,EXECUTE}. ARCH_MMU_FLAG_PERM_USER is
+    // implied.
+    uint arch_mmu_flags;
+  };
+
+  // Creates a template from |segments|, which must be non-empty, page aligned, sorted by
+  // |vmar_offset| and non overlapping. Returns ZX_ERR_INVALID_ARGS otherwise. Whether a segment
+  // fits is only known once it is mapped into a particular root VMAR.
+  static zx_status_t Create(ktl::span<const Segment> segments, fbl::RefPtr<ProcessTemplate>* out);
+
+  // Maps every segment into |root_vmar|, which is expected to be the empty root VMAR of a newly
+  // created process. On failure any segments already mapped are left in place for the caller to
+  // discard along with the process.
+  zx_status_t Instantiate(VmAddressRegion& root_vmar) const;
+
+  size_t segment_count() const { return segments_.size(); }
+
+ private:
+  explicit ProcessTemplate(fbl::Array<Segment> segments) : segments_(ktl::move(segments)) {}
+
+  const fbl::Array<Segment> segments_;
+};
+
+#endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_PROCESS_TEMPLATE_H_
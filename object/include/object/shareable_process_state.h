@@ -51,17 +51,30 @@ class ShareableProcessState : public fbl::RefCounted<ShareableProcessState> {
   }
 
   // Removes this state from a process. If the state is not shared with any other processes, the
-  // shared resources are cleaned.
-  void DecrementShareCount() {
+  // shared resources are cleaned and true is returned.
+  //
+  // With |destroy_aspace| false only the handle table is cleaned, and a caller that gets true back
+  // must later call DestroyAspace, for example from a context where the potentially lengthy
+  // teardown of a large address space does not hold anything up.
+  bool DecrementShareCount(bool destroy_aspace = true) {
     DEBUG_ASSERT(process_count_ > 0);
 
     const uint64_t prev = process_count_.fetch_sub(1, ktl::memory_order_relaxed);
 
     if (prev > 1) {
-      return;
+      return false;
     }
 
     handle_table_.Clean();
+    if (destroy_aspace) {
+      DestroyAspace();
+    }
+    return true;
+  }
+
+  // Destroys the address space once the last share has been removed. See DecrementShareCount.
+  void DestroyAspace() {
+    DEBUG_ASSERT(process_count_.load(ktl::memory_order_relaxed) == 0);
     if (aspace_) {
       zx_status_t result = aspace_->Destroy();
       ASSERT_MSG(result == ZX_OK, "%d\n", result);
@@ -47,6 +47,12 @@ class SignalObserver : public fbl::DoublyLinkedListable<SignalObserver*> {
   // WARNING: This is called under Dispatcher's lock.
   virtual bool MatchesKey(const void* port, uint64_t key) { return false; }
 
+  // Determine if this observer stays registered after OnMatch, to be matched
+  // again by later signal changes until it is canceled.
+  //
+  // A persistent observer must not be deleted from within OnMatch.
+  virtual bool IsPersistent() const { return false; }
+
  protected:
   virtual ~SignalObserver() = default;
 
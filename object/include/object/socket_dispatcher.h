@@ -7,6 +7,7 @@
 #ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_SOCKET_DISPATCHER_H_
 #define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_SOCKET_DISPATCHER_H_
 
+#include <lib/user_copy/user_iovec.h>
 #include <lib/user_copy/user_ptr.h>
 #include <lib/zx/result.h>
 #include <stdint.h>
@@ -19,7 +20,9 @@
 #include <object/handle.h>
 #include <object/mbuf.h>
 
-class SocketDispatcher final : public PeeredDispatcher<SocketDispatcher, ZX_DEFAULT_SOCKET_RIGHTS> {
+// The lock is nestable so that Splice() can hold the locks of two unrelated sockets at once.
+class SocketDispatcher final : public PeeredDispatcher<SocketDispatcher, ZX_DEFAULT_SOCKET_RIGHTS,
+                                                       0u, lockdep::LockFlagsNestable> {
  public:
   class Disposition {
    public:
@@ -46,11 +49,26 @@ class SocketDispatcher final : public PeeredDispatcher<SocketDispatcher, ZX_DEFA
   // Socket methods.
   zx_status_t Write(user_in_ptr<const char> src, size_t len, size_t* written);
 
+  // Same as Write() but gathers the data from the buffers in |src|. In datagram mode the whole
+  // vector is written as a single datagram.
+  zx_status_t WriteVector(user_in_iovec_t src, size_t* written);
+
   // Set the socket endpoints' dispositions.
   zx_status_t SetDisposition(Disposition disposition, Disposition disposition_peer);
 
   zx_status_t Read(ReadType type, user_out_ptr<char> dst, size_t len, size_t* nread);
 
+  // Same as Read() but scatters the data into the buffers in |dst|.
+  zx_status_t ReadVector(ReadType type, user_out_iovec_t dst, size_t* nread);
+
+  // Moves up to |len| bytes readable from this socket to the sending side of |dst|, to be read by
+  // the peer of |dst|, without copying through user space. Both sockets must have the same mode,
+  // and in datagram mode only whole datagrams are moved.
+  //
+  // Returns ZX_ERR_SHOULD_WAIT if this socket is empty or |dst| is full, and
+  // ZX_ERR_BUFFER_TOO_SMALL if the next datagram is larger than |len|.
+  zx_status_t Splice(SocketDispatcher* dst, size_t len, size_t* moved);
+
   // Property methods.
   size_t GetReadThreshold() const;
   zx_status_t SetReadThreshold(size_t value);
@@ -64,12 +82,30 @@ class SocketDispatcher final : public PeeredDispatcher<SocketDispatcher, ZX_DEFA
   void OnPeerZeroHandlesLocked() TA_REQ(get_lock());
 
  private:
-  using PeerHolderType = PeerHolder<SocketDispatcher>;
+  using PeerHolderType = PeerHolder<SocketDispatcher, lockdep::LockFlagsNestable>;
 
   SocketDispatcher(fbl::RefPtr<PeerHolderType> holder, zx_signals_t starting_signals,
                    uint32_t flags);
-  zx_status_t WriteSelfLocked(user_in_ptr<const char> src, size_t len, size_t* nwritten,
-                              Guard<CriticalMutex>& guard) TA_REQ(get_lock());
+  // Returns ZX_OK if |len| bytes may be written to the peer, which must then be non-null.
+  zx_status_t CheckWritableLocked(size_t len) const TA_REQ(get_lock());
+  // Returns ZX_OK if there is data to read, or the reason there is none.
+  zx_status_t CheckReadableLocked() const TA_REQ(get_lock());
+  // Appends to |data_| by calling |write(MBufChain& data, size_t* written)| with user copies
+  // permitted, and updates the signals of both endpoints.
+  template <typename WriteFn>
+  zx_status_t WriteSelfLocked(WriteFn write, size_t* nwritten, Guard<CriticalMutex>& guard)
+      TA_REQ(get_lock());
+  // Reads from |data_| by calling |read(MBufChain& data, size_t* actual)| with user copies
+  // permitted, and updates the signals of both endpoints if the data was consumed.
+  template <typename ReadFn>
+  zx_status_t ReadSelfLocked(ReadType type, ReadFn read, size_t* nread,
+                             Guard<CriticalMutex>& guard) TA_REQ(get_lock());
+  zx_status_t SpliceLocked(SocketDispatcher* dst, size_t len, size_t* moved)
+      TA_REQ(get_lock(), dst->get_lock());
+  // Update the signals of both endpoints after |written| bytes were added to, or |nread| bytes
+  // were consumed from, |data_|.
+  void UpdateSignalsForWriteLocked(bool was_empty, size_t written) TA_REQ(get_lock());
+  void UpdateSignalsForReadLocked(bool was_full, size_t nread) TA_REQ(get_lock());
   void UpdateReadStatus(Disposition disposition_peer) TA_REQ(get_lock());
   [[nodiscard]] bool IsDispositionStateValid(Disposition disposition_peer) const TA_REQ(get_lock());
 
@@ -18,6 +18,7 @@
 #include <fbl/intrusive_double_list.h>
 #include <fbl/ref_counted.h>
 #include <fbl/ref_ptr.h>
+#include <kernel/deadline_admission.h>
 #include <kernel/event.h>
 #include <kernel/owned_wait_queue.h>
 #include <kernel/thread.h>
@@ -73,6 +74,11 @@ class ThreadDispatcher final : public SoloDispatcher<ThreadDispatcher, ZX_DEFAUL
   static zx_status_t Create(fbl::RefPtr<ProcessDispatcher> process, uint32_t flags,
                             ktl::string_view name, KernelHandle<ThreadDispatcher>* out_handle,
                             zx_rights_t* out_rights);
+
+  // Allocated from a per-CPU cache. See <object/dispatcher_cache.h>.
+  static void* operator new(size_t size, fbl::AllocChecker* ac) noexcept;
+  static void operator delete(void* ptr, size_t size);
+
   ~ThreadDispatcher();
 
   static ThreadDispatcher* GetCurrent() { return Thread::Current::Get()->user_thread(); }
@@ -184,6 +190,10 @@ class ThreadDispatcher final : public SoloDispatcher<ThreadDispatcher, ZX_DEFAUL
                          size_t buffer_size) TA_EXCL(get_lock());
 
   // Profile support
+  //
+  // With deadline admission control enabled, both fail with
+  // ZX_ERR_NO_RESOURCES and leave the thread unchanged if the thread's deadline
+  // utilization does not fit on any CPU of its resulting affinity.
   zx_status_t SetBaseProfile(const SchedulerState::BaseProfile& profile) TA_EXCL(get_lock());
   zx_status_t SetSoftAffinity(cpu_mask_t mask) TA_EXCL(get_lock());
 
@@ -203,15 +213,24 @@ class ThreadDispatcher final : public SoloDispatcher<ThreadDispatcher, ZX_DEFAUL
 
   // Blocking syscalls, once they commit to a path that will likely block the
   // thread, use this helper class to properly set/restore |blocked_reason_|.
+  // Kernel threads, such as those running unittests, have no ThreadDispatcher
+  // and so no reason to record.
   class AutoBlocked final {
    public:
     explicit AutoBlocked(Blocked reason)
         : thread_(ThreadDispatcher::GetCurrent()),
-          prev_reason(thread_->blocked_reason_.load(ktl::memory_order_acquire)) {
+          prev_reason(thread_ ? thread_->blocked_reason_.load(ktl::memory_order_acquire)
+                              : Blocked::NONE) {
       DEBUG_ASSERT(reason != Blocked::NONE);
-      thread_->blocked_reason_.store(reason, ktl::memory_order_release);
+      if (thread_) {
+        thread_->blocked_reason_.store(reason, ktl::memory_order_release);
+      }
+    }
+    ~AutoBlocked() {
+      if (thread_) {
+        thread_->blocked_reason_.store(prev_reason, ktl::memory_order_release);
+      }
     }
-    ~AutoBlocked() { thread_->blocked_reason_.store(prev_reason, ktl::memory_order_release); }
 
    private:
     ThreadDispatcher* const thread_;
@@ -240,6 +259,13 @@ class ThreadDispatcher final : public SoloDispatcher<ThreadDispatcher, ZX_DEFAUL
   // Update time spent contended on locks. This is called by lock implementations.
   void AddLockContentionTicks(zx_duration_mono_ticks_t ticks);
 
+  // Count a migration to another CPU. This is called by Scheduler when the
+  // thread starts running on a different CPU than the one it last ran on.
+  void AddMigration();
+
+  // Update time spent stalled on memory. This is called when a ScopedMemoryStall ends.
+  void AddMemoryStallTicks(zx_duration_mono_ticks_t ticks);
+
   class CoreThreadObservation {
    public:
     CoreThreadObservation() = default;
@@ -386,6 +412,11 @@ class ThreadDispatcher final : public SoloDispatcher<ThreadDispatcher, ZX_DEFAUL
   // only when this reference count reaches 0.
   int suspend_count_ TA_GUARDED(get_lock()) = 0;
 
+  // The utilization reserved by the deadline profile last applied to this
+  // thread, if admission control is enabled. It is released when the thread
+  // exits, or when the dispatcher is destroyed if the thread never started.
+  DeadlineAdmission::Reservation deadline_reservation_ TA_GUARDED(get_lock());
+
   // Per-thread structure used while waiting in a ChannelDispatcher::Call.
   // Needed to support the requirements of being able to interrupt a Call
   // in order to suspend a thread.
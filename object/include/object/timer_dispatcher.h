@@ -11,6 +11,7 @@
 #include <zircon/rights.h>
 #include <zircon/types.h>
 
+#include <fbl/alloc_checker.h>
 #include <kernel/dpc.h>
 #include <kernel/timer.h>
 #include <object/dispatcher.h>
@@ -21,6 +22,10 @@ class TimerDispatcher final : public SoloDispatcher<TimerDispatcher, ZX_DEFAULT_
   static zx_status_t Create(uint32_t options, zx_clock_t clock_id,
                             KernelHandle<TimerDispatcher>* handle, zx_rights_t* rights);
 
+  // Allocated from a per-CPU cache. See <object/dispatcher_cache.h>.
+  static void* operator new(size_t size, fbl::AllocChecker* ac) noexcept;
+  static void operator delete(void* ptr, size_t size);
+
   ~TimerDispatcher() final;
   zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_TIMER; }
   void on_zero_handles() final;
@@ -17,7 +17,8 @@
 
 // Extracts the handles that would be consumed on syscalls with handle_release semantics
 // from |offset| to  |offset + chunk_size| from |user_handles| and returns them
-// in |handles| which must be at of at least size |chunk_size|.
+// in |handles| which must be at of at least size |chunk_size|. Entries for handles
+// that would not be consumed are set to ZX_HANDLE_INVALID.
 zx_status_t get_user_handles_to_consume(user_in_ptr<const zx_handle_t> user_handles, size_t offset,
                                         size_t chunk_size, zx_handle_t* handles);
 
@@ -28,7 +29,8 @@ zx_status_t get_user_handles_to_consume(user_inout_ptr<zx_handle_disposition_t>
 // have been removed, error otherwise. It only stops early if get_user_handles() fails.
 template <typename T>
 zx_status_t RemoveUserHandles(T user_handles, size_t num_handles, ProcessDispatcher* process) {
-  zx_handle_t handles[kMaxMessageHandles] = {ZX_HANDLE_INVALID};
+  // Each chunk fills the first |chunk_size| entries, so the buffer needs no initialization.
+  __UNINITIALIZED zx_handle_t handles[kMaxMessageHandles];
   size_t offset = 0u;
   zx_status_t status = ZX_OK;
 
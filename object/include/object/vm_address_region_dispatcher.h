@@ -14,6 +14,7 @@
 #include <object/dispatcher.h>
 #include <object/handle.h>
 
+class PortDispatcher;
 class VmAddressRegion;
 class VmMapping;
 class VmObject;
@@ -43,6 +44,19 @@ class VmAddressRegionDispatcher final
   zx_status_t RangeOp(uint32_t op, uint64_t offset, uint64_t size, zx_rights_t rights,
                       user_inout_ptr<void> buffer, size_t buffer_size);
 
+  // Starts a ZX_VMAR_OP_PREFETCH of [base, base + len) on the QueueAsyncPrefetch worker threads,
+  // and then queues a ZX_PKT_TYPE_USER packet with |key| on |port|. The packet's status is the
+  // result of the prefetch and its u64[0] and u64[1] are |base| and |len|. Errors in the range,
+  // including the VMAR being destroyed before the prefetch runs, are only reported in the packet.
+  //
+  // Returns ZX_ERR_SHOULD_WAIT if the calling process already has the maximum number of
+  // asynchronous prefetches outstanding, see AsyncPrefetchQuota.
+  //
+  // The caller is responsible for checking ZX_RIGHT_WRITE on |port|. This is not reachable through
+  // zx_vmar_op_range until the public ABI allocates an op value for it.
+  zx_status_t PrefetchAsync(vaddr_t base, size_t len, zx_rights_t rights,
+                            fbl::RefPtr<PortDispatcher> port, uint64_t key);
+
   zx_status_t Unmap(vaddr_t base, size_t len, VmAddressRegionOpChildren op_children);
 
   zx_status_t SetMemoryPriority(VmAddressRegion::MemoryPriority priority);
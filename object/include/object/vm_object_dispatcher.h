@@ -24,6 +24,8 @@
 #include <vm/content_size_manager.h>
 #include <vm/vm_object.h>
 
+class PortDispatcher;
+
 class VmObjectDispatcher final : public SoloDispatcher<VmObjectDispatcher, ZX_DEFAULT_VMO_RIGHTS>,
                                  public VmObjectChildObserver {
  public:
@@ -71,6 +73,21 @@ class VmObjectDispatcher final : public SoloDispatcher<VmObjectDispatcher, ZX_DE
   zx_status_t CreateChild(uint32_t options, uint64_t offset, uint64_t size, bool copy_name,
                           fbl::RefPtr<VmObject>* child_vmo);
 
+  // Asynchronously brings [offset, offset + size) into memory, as ZX_VMO_OP_PREFETCH would, and
+  // then queues a ZX_PKT_TYPE_USER packet with |key| on |port|. The packet's status is the result
+  // of the prefetch and its u64[0] and u64[1] are |offset| and |size|.
+  //
+  // The prefetch runs on the QueueAsyncPrefetch worker threads, so a pager-backed range which is
+  // not yet present blocks a worker rather than the caller. Once the packet arrives, a Read of the
+  // range will not need to wait on the pager unless the pages were evicted in the meantime.
+  //
+  // Returns ZX_ERR_SHOULD_WAIT if the calling process already has the maximum number of
+  // asynchronous prefetches outstanding, see AsyncPrefetchQuota.
+  //
+  // The caller is responsible for checking ZX_RIGHT_READ on this VMO and ZX_RIGHT_WRITE on |port|.
+  zx_status_t PrefetchAsync(uint64_t offset, uint64_t size, fbl::RefPtr<PortDispatcher> port,
+                            uint64_t key);
+
   zx_status_t SetMappingCachePolicy(uint32_t cache_policy);
 
   zx_info_vmo_t GetVmoInfo(zx_rights_t rights);
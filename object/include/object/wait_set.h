@@ -0,0 +1,132 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_WAIT_SET_H_
+#define ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_WAIT_SET_H_
+
+#include <stdint.h>
+#include <zircon/types.h>
+
+#include <fbl/canary.h>
+#include <fbl/intrusive_double_list.h>
+#include <fbl/intrusive_wavl_tree.h>
+#include <fbl/ref_ptr.h>
+#include <kernel/deadline.h>
+#include <kernel/event.h>
+#include <kernel/mutex.h>
+#include <ktl/span.h>
+#include <ktl/unique_ptr.h>
+#include <object/dispatcher.h>
+#include <object/signal_observer.h>
+
+class Handle;
+
+// A WaitSet is a reusable set of (handle, signals) pairs that can be waited on as a whole.
+//
+// Unlike wait_many, which registers and removes an observer for every item on every call, a
+// WaitSet registers one persistent observer per entry when the entry is added. Matching
+// entries are moved to a ready list as their signals assert, so a wait only looks at the ready
+// entries rather than the whole set.
+//
+// Waits are level triggered: an entry is reported by every Wait() for as long as any of its
+// signals remain asserted. An entry whose handle is closed is reported once, with
+// ZX_SIGNAL_HANDLE_CLOSED, and then dropped from the set.
+//
+// Lock ordering is lock_ -> Dispatcher::get_lock() -> ready_lock_.
+class WaitSet {
+ public:
+  struct Result {
+    uint64_t key;
+    zx_signals_t signals;
+  };
+
+  WaitSet() = default;
+  ~WaitSet();
+
+  WaitSet(const WaitSet&) = delete;
+  WaitSet& operator=(const WaitSet&) = delete;
+
+  // Start watching |handle| for any of |signals|, reporting matches under |key|.
+  //
+  // This should be called under the handle table lock so that closing |handle| concurrently
+  // reliably cancels the entry. The caller is responsible for checking ZX_RIGHT_WAIT.
+  //
+  // Returns ZX_ERR_ALREADY_EXISTS if |key| is already in use.
+  zx_status_t Add(Handle* handle, zx_signals_t signals, uint64_t key);
+
+  // Stop watching the entry registered under |key|.
+  //
+  // Returns ZX_ERR_NOT_FOUND if there is no such entry.
+  zx_status_t Remove(uint64_t key);
+
+  // Remove every entry.
+  void Clear();
+
+  // Wait until at least one entry is ready, then fill in up to |results.size()| of them and
+  // report how many in |count|.
+  //
+  // Returns ZX_ERR_TIMED_OUT if nothing became ready before |deadline|, or the status of the
+  // interrupted wait.
+  zx_status_t Wait(const Deadline& deadline, ktl::span<Result> results, size_t* count);
+
+  size_t size() const;
+
+ private:
+  class Entry final : public SignalObserver,
+                      public fbl::WAVLTreeContainable<ktl::unique_ptr<Entry>> {
+   public:
+    Entry(WaitSet* set, fbl::RefPtr<Dispatcher> dispatcher, zx_signals_t signals, uint64_t key)
+        : set_(set), dispatcher_(ktl::move(dispatcher)), signals_(signals), key_(key) {}
+    ~Entry() final = default;
+
+    uint64_t GetKey() const { return key_; }
+
+    // |SignalObserver| implementation.
+    void OnMatch(zx_signals_t signals) final;
+    void OnCancel(zx_signals_t signals) final;
+    bool IsPersistent() const final { return true; }
+
+    fbl::Canary<fbl::magic("WTSE")> canary_;
+
+    WaitSet* const set_;
+    const fbl::RefPtr<Dispatcher> dispatcher_;
+    const zx_signals_t signals_;
+    const uint64_t key_;
+
+    // Guarded by the set's ready_lock_.
+    fbl::DoublyLinkedListNodeState<Entry*> ready_node_;
+    bool canceled_ = false;
+    zx_signals_t canceled_signals_ = 0;
+  };
+
+  struct ReadyListTraits {
+    static fbl::DoublyLinkedListNodeState<Entry*>& node_state(Entry& entry) {
+      return entry.ready_node_;
+    }
+  };
+  using ReadyList =
+      fbl::DoublyLinkedListCustomTraits<Entry*, ReadyListTraits, fbl::SizeOrder::Constant>;
+  using EntryTree = fbl::WAVLTree<uint64_t, ktl::unique_ptr<Entry>>;
+
+  // Removes |entry| from its dispatcher and from the ready list. The entry stays in |entries_|.
+  void DetachLocked(Entry* entry) TA_REQ(lock_);
+
+  // Report up to |results.size()| ready entries. Entries dropped because their handle was
+  // closed are moved to |dead| so they can be destroyed outside of |lock_|.
+  size_t HarvestLocked(ktl::span<Result> results, EntryTree* dead) TA_REQ(lock_);
+
+  mutable DECLARE_CRITICAL_MUTEX(WaitSet) lock_;
+  EntryTree entries_ TA_GUARDED(lock_);
+
+  DECLARE_CRITICAL_MUTEX(WaitSet) ready_lock_;
+  ReadyList ready_ TA_GUARDED(ready_lock_);
+
+  // Signaled whenever an entry is added to |ready_|, and unsignaled by Wait() once it finds
+  // |ready_| empty.
+  Event event_;
+};
+
+#endif  // ZIRCON_KERNEL_OBJECT_INCLUDE_OBJECT_WAIT_SET_H_
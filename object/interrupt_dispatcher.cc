@@ -6,6 +6,8 @@
 
 #include "object/interrupt_dispatcher.h"
 
+#include <lib/counters.h>
+#include <lib/fit/defer.h>
 #include <platform.h>
 #include <zircon/syscalls/object.h>
 #include <zircon/syscalls/port.h>
@@ -15,6 +17,27 @@
 #include <kernel/idle_power_thread.h>
 #include <object/port_dispatcher.h>
 #include <object/process_dispatcher.h>
+#include <platform/timer.h>
+
+// Time from an IRQ firing to a thread in zx_interrupt_wait observing it, from 1us up to 16ms.
+// Interrupts bound to a port are covered by the port's interrupt packet latency instead.
+KCOUNTER_HISTOGRAM(interrupt_wait_latency_ns, "interrupt.wait_latency_ns", 10)
+
+KCOUNTER(interrupt_affinity_steer_count, "interrupt.affinity_steer")
+KCOUNTER(interrupt_coalesced_count, "interrupt.coalesced")
+
+namespace {
+
+// Following the consumer only reroutes an interrupt that has fired at least this many times, and
+// at most once per interval, so that a consumer bouncing between CPUs does not turn every ack
+// into a write to the interrupt controller or device.
+constexpr uint64_t kFollowConsumerMinInterrupts = 64;
+constexpr zx_duration_mono_t kFollowConsumerInterval = ZX_MSEC(10);
+
+// A coalescing window delays delivery of the first IRQ in it, so keep it short.
+constexpr zx_duration_mono_t kMaxCoalescingWindow = ZX_MSEC(10);
+
+}  // namespace
 
 InterruptDispatcher::InterruptDispatcher(Flags flags, uint32_t options)
     : WakeVector(&InterruptDispatcher::wake_event_),
@@ -29,6 +52,117 @@ InterruptDispatcher::InterruptDispatcher(Flags flags, uint32_t options)
 
 zx_info_interrupt_t InterruptDispatcher::GetInfo() const { return {.options = options_}; }
 
+zx_status_t InterruptDispatcher::SetAffinity(cpu_mask_t mask) {
+  const cpu_mask_t online = mask & mp_get_online_mask();
+  if (!online) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  const cpu_num_t cpu = online.lowest();
+
+  Guard<SpinLock, IrqSave> guard{&spinlock_};
+  if (state_ == InterruptState::DESTROYED) {
+    return ZX_ERR_CANCELED;
+  }
+  zx_status_t status = SetInterruptAffinity(cpu);
+  if (status == ZX_OK) {
+    affinity_cpu_ = cpu;
+  }
+  return status;
+}
+
+zx_status_t InterruptDispatcher::SetFollowConsumer(bool follow) {
+  if (flags_ & INTERRUPT_VIRTUAL) {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+
+  Guard<SpinLock, IrqSave> guard{&spinlock_};
+  if (state_ == InterruptState::DESTROYED) {
+    return ZX_ERR_CANCELED;
+  }
+  follow_consumer_ = follow;
+  last_steer_count_ = interrupt_count_;
+  last_steer_time_ = 0;
+  return ZX_OK;
+}
+
+zx_status_t InterruptDispatcher::SetCoalescing(zx_duration_mono_t window) {
+  if (flags_ & (INTERRUPT_VIRTUAL | INTERRUPT_WAKE_VECTOR)) {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+  if (window < 0 || window > kMaxCoalescingWindow) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+
+  Guard<SpinLock, IrqSave> guard{&spinlock_};
+  if (state_ == InterruptState::DESTROYED) {
+    return ZX_ERR_CANCELED;
+  }
+  // A window that is already open still closes as scheduled.
+  coalescing_window_ = window;
+  return ZX_OK;
+}
+
+void InterruptDispatcher::ArmCoalescingLocked() {
+  DEBUG_ASSERT(!coalescing_armed_);
+  coalescing_armed_ = true;
+  coalescing_timer_.Set(Deadline::after_mono(coalescing_window_), CoalescingTimerCallback, this);
+}
+
+void InterruptDispatcher::CoalescingTimerCallback(Timer* timer, zx_time_t now, void* arg) {
+  static_cast<InterruptDispatcher*>(arg)->OnCoalescingWindowClosed();
+}
+
+void InterruptDispatcher::OnCoalescingWindowClosed() {
+  AutoPreemptDisabler preempt_disable;
+  Guard<SpinLock, IrqSave> guard{&spinlock_};
+  if (!coalescing_armed_) {
+    return;
+  }
+  coalescing_armed_ = false;
+  if (state_ != InterruptState::IDLE && state_ != InterruptState::WAITING) {
+    return;
+  }
+
+  // Deliver the window's IRQs the way InterruptHandler would have delivered the first. The port
+  // may have been unbound while the window was open.
+  if (pending_count_ > 1) {
+    interrupt_coalesced_count.Add(pending_count_ - 1);
+  }
+  if (port_dispatcher_) {
+    SendPacketLocked(timestamp_);
+    state_ = InterruptState::NEEDACK;
+  } else {
+    if (flags_ & INTERRUPT_MASK_POSTWAIT) {
+      MaskInterrupt();
+    }
+    Signal();
+    state_ = InterruptState::TRIGGERED;
+  }
+}
+
+void InterruptDispatcher::MaybeFollowConsumerLocked() {
+  if (!follow_consumer_) {
+    return;
+  }
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  if (cpu == affinity_cpu_ || interrupt_count_ - last_steer_count_ < kFollowConsumerMinInterrupts) {
+    return;
+  }
+  const zx_instant_mono_t now = current_mono_time();
+  if (last_steer_time_ != 0 && now - last_steer_time_ < kFollowConsumerInterval) {
+    return;
+  }
+
+  last_steer_count_ = interrupt_count_;
+  last_steer_time_ = now;
+  if (SetInterruptAffinity(cpu) != ZX_OK) {
+    follow_consumer_ = false;
+    return;
+  }
+  affinity_cpu_ = cpu;
+  interrupt_affinity_steer_count.Add(1);
+}
+
 zx_status_t InterruptDispatcher::WaitForInterrupt(zx_time_t* out_timestamp) {
   while (true) {
     const ktl::optional<zx_status_t> opt_status = BeginWaitForInterrupt(out_timestamp);
@@ -59,12 +193,18 @@ ktl::optional<zx_status_t> InterruptDispatcher::BeginWaitForInterrupt(zx_time_t*
         state_ = InterruptState::NEEDACK;
         *out_timestamp = timestamp_;
         timestamp_ = 0;
+        if (irq_ticks_ != 0) {
+          interrupt_wait_latency_ns.Add(static_cast<uint64_t>(
+              timer_get_ticks_to_time_ratio().Scale(current_mono_ticks() - irq_ticks_)));
+          irq_ticks_ = 0;
+        }
         return event_.Unsignal();
 
       case InterruptState::NEEDACK:
         if (is_wake_vector()) {
           wake_event_.Acknowledge();
         }
+        MaybeFollowConsumerLocked();
         if (flags_ & INTERRUPT_UNMASK_PREWAIT) {
           UnmaskInterrupt();
         } else if (flags_ & INTERRUPT_UNMASK_PREWAIT_UNLOCKED) {
@@ -104,11 +244,19 @@ zx_status_t InterruptDispatcher::DoWaitForInterruptBlock() {
 }
 
 bool InterruptDispatcher::SendPacketLocked(zx_time_t timestamp) {
-  bool status = port_dispatcher_->QueueInterruptPacket(&port_packet_, timestamp);
+  bool status;
+  if (coalescing_window_ > 0) {
+    status = port_dispatcher_->QueueInterruptPacket(&port_packet_, timestamp, pending_count_,
+                                                    last_timestamp_);
+  } else {
+    status = port_dispatcher_->QueueInterruptPacket(&port_packet_, timestamp);
+  }
   if (flags_ & INTERRUPT_MASK_POSTWAIT) {
     MaskInterrupt();
   }
   timestamp_ = 0;
+  irq_ticks_ = 0;
+  pending_count_ = 0;
   return status;
 }
 
@@ -154,18 +302,36 @@ void InterruptDispatcher::InterruptHandler() {
   // for clarity and robustness.
   AutoPreemptDisabler preempt_disable;
   Guard<SpinLock, IrqSave> guard{&spinlock_};
+  ++interrupt_count_;
+  ++pending_count_;
 
   // only record timestamp if this is the first IRQ since we started waiting
   if (!timestamp_) {
+    irq_ticks_ = current_mono_ticks();
     if (flags_ & INTERRUPT_TIMESTAMP_MONO) {
       timestamp_ = current_mono_time();
     } else {
       timestamp_ = current_boot_time();
     }
+    last_timestamp_ = timestamp_;
+  } else if (coalescing_window_ > 0) {
+    last_timestamp_ =
+        (flags_ & INTERRUPT_TIMESTAMP_MONO) ? current_mono_time() : current_boot_time();
   }
   if (state_ == InterruptState::NEEDACK && port_dispatcher_) {
     return;
   }
+  if (coalescing_armed_) {
+    // Delivered when the window closes.
+    return;
+  }
+  if (port_dispatcher_ && coalescing_window_ > 0) {
+    if (flags_ & INTERRUPT_MASK_POSTWAIT) {
+      MaskInterrupt();
+    }
+    ArmCoalescingLocked();
+    return;
+  }
   if (port_dispatcher_) {
     SendPacketLocked(timestamp_);
     state_ = InterruptState::NEEDACK;
@@ -194,6 +360,10 @@ zx_status_t InterruptDispatcher::Destroy() {
   DeactivateInterrupt();
   UnregisterInterruptHandler();
 
+  // Once DESTROYED no window can be opened, so cancel any open one after dropping the spinlock,
+  // which the timer callback takes.
+  auto cancel_coalescing = fit::defer([this] { coalescing_timer_.Cancel(); });
+
   // Use preempt disable for correctness to prevent rescheduling when waking a
   // thread while holding the spinlock.
   AutoPreemptDisabler preempt_disable;
@@ -294,12 +464,18 @@ zx::result<InterruptDispatcher::PostAckState> InterruptDispatcher::AckInternal()
       if (is_wake_vector()) {
         wake_event_.Acknowledge();
       }
+      MaybeFollowConsumerLocked();
       if (flags_ & INTERRUPT_UNMASK_PREWAIT) {
         UnmaskInterrupt();
       } else if (flags_ & INTERRUPT_UNMASK_PREWAIT_UNLOCKED) {
         defer_unmask = true;
       }
-      if (timestamp_) {
+      if (timestamp_ && coalescing_window_ > 0) {
+        // IRQs arrived while the packet was outstanding, fold them into a new window rather than
+        // queuing a packet for them straight away.
+        state_ = InterruptState::IDLE;
+        ArmCoalescingLocked();
+      } else if (timestamp_) {
         if (!SendPacketLocked(timestamp_)) {
           // We cannot queue another packet here.
           // If we reach here it means that the
@@ -145,6 +145,10 @@ void InterruptEventDispatcher::MaskInterrupt() { mask_interrupt(vector_); }
 
 void InterruptEventDispatcher::UnmaskInterrupt() { unmask_interrupt(vector_); }
 
+zx_status_t InterruptEventDispatcher::SetInterruptAffinity(cpu_num_t cpu) {
+  return set_interrupt_affinity(vector_, cpu_num_to_mask(cpu));
+}
+
 void InterruptEventDispatcher::DeactivateInterrupt() {
 #if __aarch64__
   // deactivate_interrupt only exist in arm64
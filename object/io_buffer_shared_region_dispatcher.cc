@@ -6,7 +6,13 @@
 
 #include "object/io_buffer_shared_region_dispatcher.h"
 
+#include <lib/arch/intrin.h>
+#include <string.h>
+
 #include <fbl/algorithm.h>
+#include <fbl/alloc_checker.h>
+#include <kernel/auto_preempt_disabler.h>
+#include <ktl/unique_ptr.h>
 
 // static
 zx_status_t IoBufferSharedRegionDispatcher::Create(
@@ -59,8 +65,8 @@ zx::result<> IoBufferSharedRegionDispatcher::Write(const uint64_t tag, user_in_i
   size_t vector_count = 0;
   size_t message_size = 0;
 
-  // Copy the vectors to our stack copy so we can compute the message size and have access to the
-  // vectors below once we have taken the lock.
+  // Copy the vectors to our stack copy so we can compute the message size before copying the
+  // message itself.
   if (zx_status_t status = message.ForEach([&](user_in_ptr<const char> data, size_t len) {
         if (vector_count == std::size(vectors)) {
           return ZX_ERR_INVALID_ARGS;
@@ -87,6 +93,29 @@ zx::result<> IoBufferSharedRegionDispatcher::Write(const uint64_t tag, user_in_i
     return zx::error(ZX_ERR_NO_SPACE);
   }
 
+  // Copy the message into a bounce buffer first. Writers are published in the order they reserved
+  // their space, so a reservation must never be held across a fault on the source buffer, which
+  // could take arbitrarily long and would stall every writer behind it.
+  char inline_bounce[kInlineBounceSize];
+  ktl::unique_ptr<char[]> heap_bounce;
+  char* bounce = inline_bounce;
+  if (message_size > sizeof(inline_bounce)) {
+    fbl::AllocChecker ac;
+    heap_bounce.reset(new (&ac) char[message_size]);
+    if (!ac.check()) {
+      return zx::error(ZX_ERR_NO_MEMORY);
+    }
+    bounce = heap_bounce.get();
+  }
+  size_t copied = 0;
+  for (size_t i = 0; i < vector_count; ++i) {
+    if (zx_status_t status = vectors[i].data.copy_array_from_user(&bounce[copied], vectors[i].len);
+        status != ZX_OK) {
+      return zx::error(status);
+    }
+    copied += vectors[i].len;
+  }
+
   Header* header = GetHeader();
   ZX_ASSERT(header != nullptr);
 
@@ -94,76 +123,64 @@ zx::result<> IoBufferSharedRegionDispatcher::Write(const uint64_t tag, user_in_i
     return &reinterpret_cast<char*>(header)[PAGE_SIZE + offset];
   };
 
+  // From reserving space to publishing the message, nothing can fault as the ring is pinned and
+  // mapped, and preemption is disabled so that writers waiting to publish behind this one only
+  // ever wait for a running memcpy.
+  AutoPreemptDisabler preempt_disable;
+
+  // Reserve space for the message. Where the reservation starts is also the message's place in the
+  // order in which messages are published.
+  uint64_t start = reserved_.load(ktl::memory_order_relaxed);
   for (;;) {
-    ktl::optional<UserCopyCaptureFaultsResult::FaultInfo> fault;
-
-    {
-      Guard<CriticalMutex> guard{get_lock()};
-
-      // Relaxed ordering because only the kernel modifies this value while holding the dispatcher
-      // lock.
-      const uint64_t head = header->head.load(ktl::memory_order_relaxed);
-
-      // Acquire ordering so that the following writes are not reordered before this load since
-      // otherwise it is possible that we will overwrite a message that userspace has not finished
-      // reading yet.
-      const uint64_t tail = header->tail.load(ktl::memory_order_acquire);
-
-      if (tail > head || ktl::numeric_limits<uint64_t>::max() - head < rounded_message_size ||
-          !IS_ROUNDED(head, 8)) {
-        return zx::error(ZX_ERR_IO_DATA_INTEGRITY);
-      }
-
-      if (head - tail > buffer_size - rounded_message_size) {
-        return zx::error(ZX_ERR_NO_SPACE);
-      }
-
-      uint64_t offset = head % buffer_size;
-      *reinterpret_cast<uint64_t*>(get_ptr(offset)) = tag;
-      offset = (offset + 8) % buffer_size;
-
-      *reinterpret_cast<uint64_t*>(get_ptr(offset)) = static_cast<uint64_t>(message_size);
-      offset = (offset + 8) % buffer_size;
-
-      for (size_t i = 0; i < vector_count && !fault; ++i) {
-        user_in_ptr<const char> data = vectors[i].data;
-        size_t len = vectors[i].len;
-
-        while (len > 0) {
-          const uint64_t amount = ktl::min(buffer_size - offset, len);
-
-          UserCopyCaptureFaultsResult copy_result = arch_copy_from_user_capture_faults(
-              get_ptr(offset), data.get(), amount, CopyContext::kBlockingNotAllowed);
-
-          if (copy_result.status != ZX_OK) {
-            if (copy_result.fault_info) {
-              fault = copy_result.fault_info;
-              break;
-            } else {
-              return zx::error(copy_result.status);
-            }
-          }
-
-          offset = (offset + amount) % buffer_size;
-          len -= amount;
-          data = data.byte_offset(amount);
-        }
-      }
-
-      if (!fault) {
-        // Release ordering so that the previous writes are not reordered after this store since
-        // otherwise it is possible for userspace to read old data when it notices the change in
-        // head value.
-        header->head.fetch_add(rounded_message_size, ktl::memory_order_release);
-        UpdateStateLocked(0, 0, ZX_IOB_SHARED_REGION_UPDATED);
-        return zx::ok();
-      }
+    // Acquire ordering so that the following writes are not reordered before this load since
+    // otherwise it is possible that we will overwrite a message that userspace has not finished
+    // reading yet.
+    const uint64_t tail = header->tail.load(ktl::memory_order_acquire);
+
+    if (tail > start || ktl::numeric_limits<uint64_t>::max() - start < rounded_message_size) {
+      return zx::error(ZX_ERR_IO_DATA_INTEGRITY);
     }
 
-    // Handle the fault and then retry.
-    if (zx_status_t status = Thread::Current::SoftFault(fault->pf_va, fault->pf_flags);
-        status != ZX_OK) {
-      return zx::error(status);
+    if (start - tail > buffer_size - rounded_message_size) {
+      return zx::error(ZX_ERR_NO_SPACE);
+    }
+
+    if (reserved_.compare_exchange_weak(start, start + rounded_message_size,
+                                        ktl::memory_order_relaxed, ktl::memory_order_relaxed)) {
+      break;
     }
-  }  // for (;;)
+  }
+
+  uint64_t offset = start % buffer_size;
+  *reinterpret_cast<uint64_t*>(get_ptr(offset)) = tag;
+  offset = (offset + 8) % buffer_size;
+
+  *reinterpret_cast<uint64_t*>(get_ptr(offset)) = static_cast<uint64_t>(message_size);
+  offset = (offset + 8) % buffer_size;
+
+  const char* data = bounce;
+  for (size_t len = message_size; len > 0;) {
+    const uint64_t amount = ktl::min(buffer_size - offset, len);
+    memcpy(get_ptr(offset), data, amount);
+    offset = (offset + amount) % buffer_size;
+    len -= amount;
+    data += amount;
+  }
+
+  // Messages are published in the order their space was reserved, so wait for the writers ahead of
+  // this one. They are running with preemption disabled and only copying from kernel memory.
+  while (committed_.load(ktl::memory_order_acquire) != start) {
+    arch::Yield();
+  }
+
+  // Release ordering so that the previous writes are not reordered after this store since otherwise
+  // it is possible for userspace to read old data when it notices the change in head value. The
+  // same goes for the next writer, which waits on |committed_| before it publishes.
+  const uint64_t end = start + rounded_message_size;
+  header->head.store(end, ktl::memory_order_release);
+  committed_.store(end, ktl::memory_order_release);
+  preempt_disable.Enable();
+
+  UpdateState(0, 0, ZX_IOB_SHARED_REGION_UPDATED);
+  return zx::ok();
 }
@@ -623,6 +623,126 @@ bool JobDispatcher::EnumerateChildrenRecursive(JobEnumerator* je) {
   return result == ZX_OK;
 }
 
+zx_status_t JobDispatcher::SnapshotSubtree(fit::inline_function<bool(const JobTreeEntry&)> func) {
+  canary_.Assert();
+
+  // The cursor holds, for every job on the path from this job to the one being visited, the
+  // snapshot of its child jobs and the position of the next one to visit. As max_height() drops by
+  // at least one from a job to its children, it bounds the depth of the walk.
+  struct Level {
+    LiveRefsArray<JobDispatcher> jobs;
+    size_t next = 0;
+  };
+  const size_t levels = max_height() + 1;
+  fbl::AllocChecker ac;
+  fbl::Array<Level> cursor(new (&ac) Level[levels], levels);
+  if (!ac.check()) {
+    return ZX_ERR_NO_MEMORY;
+  }
+
+  zx_status_t status = SnapshotNode(0, &cursor[0].jobs, func);
+  uint32_t depth = 0;
+  while (status == ZX_OK) {
+    Level& level = cursor[depth];
+    if (level.next == level.jobs.size()) {
+      level.jobs.reset();
+      if (depth == 0) {
+        break;
+      }
+      depth--;
+      continue;
+    }
+    fbl::RefPtr<JobDispatcher> job = ktl::move(level.jobs[level.next++]);
+    if (!job) {
+      continue;
+    }
+    DEBUG_ASSERT(depth + 1 < levels);
+    cursor[depth + 1].next = 0;
+    status = job->SnapshotNode(depth + 1, &cursor[depth + 1].jobs, func);
+    depth++;
+  }
+
+  return status;
+}
+
+zx_status_t JobDispatcher::SnapshotNode(
+    uint32_t depth, LiveRefsArray<JobDispatcher>* child_jobs,
+    const fit::inline_function<bool(const JobTreeEntry&)>& func) {
+  canary_.Assert();
+
+  LiveRefsArray<ProcessDispatcher> proc_refs;
+  fbl::Array<TaskRuntimeStats> proc_runtimes;
+  JobTreeEntry entry = {
+      .koid = get_koid(),
+      .parent_koid = get_related_koid(),
+      .type = ZX_OBJ_TYPE_JOB,
+      .depth = depth,
+      .name = {},
+      .runtime = {},
+  };
+
+  zx_status_t result = ZX_OK;
+
+  {
+    Guard<CriticalMutex> guard{get_lock()};
+
+    // Sample the runtime stats inside the lock, as GetTaskRuntimeStats does, so that the job's
+    // total is consistent with the records of its processes.
+    const size_t count = ChildCountLocked<ProcessDispatcher>();
+    fbl::AllocChecker ac;
+    proc_runtimes = fbl::Array<TaskRuntimeStats>(new (&ac) TaskRuntimeStats[count], count);
+    if (!ac.check()) {
+      return ZX_ERR_NO_MEMORY;
+    }
+    entry.runtime = exited_process_runtime_stats_;
+    size_t ix = 0;
+    proc_refs = ForEachChildInLocked<ProcessDispatcher>(
+        procs_, &result, [&](const fbl::RefPtr<ProcessDispatcher>& proc) {
+          proc_runtimes[ix] = proc->GetTaskRuntimeStats();
+          entry.runtime += proc_runtimes[ix];
+          ix++;
+          return ZX_OK;
+        });
+    if (result != ZX_OK) {
+      return result;
+    }
+
+    *child_jobs = ForEachChildInLocked<JobDispatcher>(
+        jobs_, &result, [&](const fbl::RefPtr<JobDispatcher>& job) { return ZX_OK; });
+    if (result != ZX_OK) {
+      return result;
+    }
+  }
+
+  [[maybe_unused]] zx_status_t status = get_name(entry.name);
+  DEBUG_ASSERT(status == ZX_OK);
+  if (!func(entry)) {
+    return ZX_ERR_STOP;
+  }
+
+  for (size_t i = 0; i < proc_refs.size(); i++) {
+    const fbl::RefPtr<ProcessDispatcher>& process = proc_refs[i];
+    if (!process) {
+      continue;
+    }
+    JobTreeEntry proc_entry = {
+        .koid = process->get_koid(),
+        .parent_koid = get_koid(),
+        .type = ZX_OBJ_TYPE_PROCESS,
+        .depth = depth + 1,
+        .name = {},
+        .runtime = proc_runtimes[i],
+    };
+    status = process->get_name(proc_entry.name);
+    DEBUG_ASSERT(status == ZX_OK);
+    if (!func(proc_entry)) {
+      return ZX_ERR_STOP;
+    }
+  }
+
+  return ZX_OK;
+}
+
 fbl::RefPtr<ProcessDispatcher> JobDispatcher::LookupProcessById(zx_koid_t koid) {
   canary_.Assert();
 
@@ -6,15 +6,20 @@
 
 #include "object/mbuf.h"
 
+#include <inttypes.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 #include <lib/fit/defer.h>
 #include <lib/user_copy/user_ptr.h>
+#include <stdio.h>
+#include <string.h>
 #include <zircon/compiler.h>
 
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <ktl/algorithm.h>
 #include <ktl/type_traits.h>
+#include <lk/init.h>
 #include <vm/physmap.h>
 #include <vm/pmm.h>
 
@@ -36,6 +41,14 @@ zx_status_t MBufChain::Peek(user_out_ptr<char> dst, size_t len, bool datagram,
   return ReadHelper(this, dst, len, datagram, actual);
 }
 
+zx_status_t MBufChain::Read(user_out_iovec_t dst, bool datagram, size_t* actual) {
+  return ReadVectorHelper(this, dst, datagram, actual);
+}
+
+zx_status_t MBufChain::Peek(user_out_iovec_t dst, bool datagram, size_t* actual) const {
+  return ReadVectorHelper(this, dst, datagram, actual);
+}
+
 template <class T>
 zx_status_t MBufChain::ReadHelper(T* chain, user_out_ptr<char> dst, size_t len, bool datagram,
                                   size_t* actual) {
@@ -113,6 +126,78 @@ zx_status_t MBufChain::ReadHelper(T* chain, user_out_ptr<char> dst, size_t len,
   return status;
 }
 
+template <class T>
+zx_status_t MBufChain::ReadVectorHelper(T* chain, user_out_iovec_t dst, bool datagram,
+                                        size_t* actual) {
+  *actual = 0;
+  if (chain->size_ == 0) {
+    return ZX_OK;
+  }
+
+  const size_t avail = datagram ? chain->buffers_.front().pkt_len_ : chain->size_;
+  size_t pos = 0;
+  auto iter = chain->buffers_.begin();
+  uint32_t read_off = chain->read_cursor_off_;
+  zx_status_t status = dst.ForEach([&](user_out_ptr<char> ptr, size_t capacity) -> zx_status_t {
+    size_t seg_pos = 0;
+    while (seg_pos < capacity && pos < avail) {
+      size_t copy_len = ktl::min({static_cast<size_t>(iter->len_ - read_off), capacity - seg_pos,
+                                  avail - pos});
+      zx_status_t status =
+          ptr.byte_offset(seg_pos).copy_array_to_user(iter->data_ + read_off, copy_len);
+      if (status != ZX_OK) {
+        return status;
+      }
+      seg_pos += copy_len;
+      pos += copy_len;
+      read_off += static_cast<uint32_t>(copy_len);
+      if (read_off == iter->len_) {
+        ++iter;
+        read_off = 0;
+      }
+    }
+    return pos < avail ? ZX_ERR_NEXT : ZX_ERR_STOP;
+  });
+
+  // As with ReadHelper(), bytes copied before a failure are consumed, and a datagram is dropped
+  // even if it could not be copied out.
+  if constexpr (!ktl::is_const_v<T>) {
+    chain->Consume(pos, datagram);
+  }
+  *actual = pos;
+  return status;
+}
+
+void MBufChain::Consume(size_t len, bool datagram) {
+  MBufList free_list;
+  if (datagram) {
+    if (!buffers_.is_empty()) {
+      DEBUG_ASSERT(read_cursor_off_ == 0);
+      size_ -= buffers_.front().pkt_len_;
+      free_list.push_front(buffers_.pop_front());
+      while (!buffers_.is_empty() && buffers_.front().pkt_len_ == 0) {
+        free_list.push_front(buffers_.pop_front());
+      }
+    }
+  } else {
+    DEBUG_ASSERT(len <= size_);
+    while (len > 0) {
+      MBuf& buf = buffers_.front();
+      const size_t consume_len = ktl::min(static_cast<size_t>(buf.len_ - read_cursor_off_), len);
+      read_cursor_off_ += static_cast<uint32_t>(consume_len);
+      size_ -= consume_len;
+      len -= consume_len;
+      if (read_cursor_off_ == buf.len_) {
+        free_list.push_front(buffers_.pop_front());
+        read_cursor_off_ = 0;
+      }
+    }
+  }
+  if (!free_list.is_empty()) {
+    FreeMBufs(ktl::move(free_list));
+  }
+}
+
 zx_status_t MBufChain::WriteDatagram(user_in_ptr<const char> src, size_t len, size_t* written) {
   if (len == 0) {
     *written = 0;
@@ -214,14 +299,173 @@ zx_status_t MBufChain::WriteStream(user_in_ptr<const char> src, size_t len, size
   return ZX_OK;
 }
 
-ktl::optional<fbl::DoublyLinkedList<MBufChain::MBuf*>> MBufChain::AllocMBufs(size_t num) {
-  list_node_t pages = LIST_INITIAL_VALUE(pages);
-  zx_status_t status = Pmm::Node().AllocPages(num, 0, &pages);
+zx_status_t MBufChain::WriteStream(user_in_iovec_t src, size_t* written) {
+  size_t total = 0;
+  zx_status_t status = src.ForEach([&](user_in_ptr<const char> ptr, size_t capacity) {
+    if (capacity == 0) {
+      return ZX_ERR_NEXT;
+    }
+    size_t st = 0;
+    zx_status_t status = WriteStream(ptr, capacity, &st);
+    total += st;
+    if (status != ZX_OK) {
+      // Running out of space after part of the vector was written is a short write.
+      return (status == ZX_ERR_SHOULD_WAIT && total > 0) ? ZX_ERR_STOP : status;
+    }
+    return st == capacity ? ZX_ERR_NEXT : ZX_ERR_STOP;
+  });
+
+  *written = total;
+  return status;
+}
+
+zx_status_t MBufChain::WriteDatagram(user_in_iovec_t src, size_t* written) {
+  *written = 0;
+  size_t len;
+  zx_status_t status = src.GetTotalCapacity(&len);
   if (status != ZX_OK) {
-    return ktl::nullopt;
+    return status;
+  }
+  if (len == 0) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  if (len > kSizeMax) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+  if (len + size_ > kSizeMax) {
+    return ZX_ERR_SHOULD_WAIT;
+  }
+
+  ktl::optional<MBufList> alloc_bufs = AllocMBufs(MBuf::NumBuffersForPayload(len));
+  if (!alloc_bufs.has_value()) {
+    return ZX_ERR_SHOULD_WAIT;
+  }
+  MBufList& bufs = *alloc_bufs;
+
+  // The vector is read from user memory a second time here, so bound the copies by |len| in case
+  // it changed underneath us.
+  size_t pos = 0;
+  auto iter = bufs.begin();
+  status = src.ForEach([&](user_in_ptr<const char> ptr, size_t capacity) -> zx_status_t {
+    size_t seg_pos = 0;
+    while (seg_pos < capacity && pos < len) {
+      if (iter->rem() == 0) {
+        ++iter;
+      }
+      size_t copy_len = ktl::min({iter->rem(), capacity - seg_pos, len - pos});
+      if (ptr.byte_offset(seg_pos).copy_array_from_user(iter->data_ + iter->len_, copy_len) !=
+          ZX_OK) {
+        return ZX_ERR_INVALID_ARGS;  // Bad user buffer.
+      }
+      seg_pos += copy_len;
+      pos += copy_len;
+      iter->len_ += static_cast<uint32_t>(copy_len);
+    }
+    return pos < len ? ZX_ERR_NEXT : ZX_ERR_STOP;
+  });
+  if (status == ZX_OK && pos != len) {
+    status = ZX_ERR_INVALID_ARGS;
+  }
+  if (status != ZX_OK) {
+    FreeMBufs(ktl::move(bufs));
+    return status;
+  }
+
+  bufs.front().pkt_len_ = static_cast<uint32_t>(len);
+  buffers_.splice(buffers_.end(), bufs);
+
+  *written = len;
+  size_ += len;
+  return ZX_OK;
+}
+
+size_t MBufChain::Splice(MBufChain* src, size_t len, bool datagram) {
+  DEBUG_ASSERT(src != this);
+  len = ktl::min(len, kSizeMax - size_);
+
+  size_t moved = 0;
+  if (datagram) {
+    while (!src->buffers_.is_empty()) {
+      const size_t pkt_len = src->buffers_.front().pkt_len_;
+      if (pkt_len > len - moved) {
+        break;
+      }
+      do {
+        buffers_.push_back(src->buffers_.pop_front());
+      } while (!src->buffers_.is_empty() && src->buffers_.front().pkt_len_ == 0);
+      src->size_ -= pkt_len;
+      size_ += pkt_len;
+      moved += pkt_len;
+    }
+    return moved;
+  }
+
+  while (moved < len && !src->buffers_.is_empty()) {
+    MBuf& buf = src->buffers_.front();
+    const size_t avail = buf.len_ - src->read_cursor_off_;
+    size_t count = ktl::min(avail, len - moved);
+    if (src->read_cursor_off_ == 0 && count == avail &&
+        (buffers_.is_empty() || buffers_.back().rem() < count)) {
+      // The whole buffer is being moved and would not fit in our last buffer, so relink it.
+      buffers_.push_back(src->buffers_.pop_front());
+      size_ += count;
+    } else {
+      count = AppendBytes(buf.data_ + src->read_cursor_off_, count);
+      if (count == 0) {
+        break;
+      }
+      src->read_cursor_off_ += static_cast<uint32_t>(count);
+      if (src->read_cursor_off_ == buf.len_) {
+        MBufList free_list;
+        free_list.push_front(src->buffers_.pop_front());
+        FreeMBufs(ktl::move(free_list));
+        src->read_cursor_off_ = 0;
+      }
+    }
+    src->size_ -= count;
+    moved += count;
+  }
+  return moved;
+}
+
+size_t MBufChain::AppendBytes(const char* src, size_t len) {
+  size_t pos = 0;
+  while (pos < len) {
+    if (buffers_.is_empty() || buffers_.back().rem() == 0) {
+      ktl::optional<MBufList> bufs = AllocMBufs(1);
+      if (!bufs.has_value()) {
+        break;
+      }
+      buffers_.splice(buffers_.end(), *bufs);
+    }
+    MBuf& buf = buffers_.back();
+    const size_t copy_len = ktl::min(buf.rem(), len - pos);
+    memcpy(buf.data_ + buf.len_, src + pos, copy_len);
+    buf.len_ += static_cast<uint32_t>(copy_len);
+    pos += copy_len;
+  }
+  size_ += pos;
+  return pos;
+}
+
+ktl::optional<fbl::DoublyLinkedList<MBufChain::MBuf*>> MBufChain::AllocMBufs(size_t num) {
+  page_cache::PageCache::PageList pages;
+  if (likely(page_cache_)) {
+    zx::result<page_cache::PageCache::AllocateResult> result = page_cache_.Allocate(num);
+    if (result.is_error()) {
+      return ktl::nullopt;
+    }
+    pages = ktl::move(result->page_list);
+  } else {
+    // The cache is not yet initialized early in boot.
+    list_node_t alloc_pages = LIST_INITIAL_VALUE(alloc_pages);
+    if (Pmm::Node().AllocPages(num, 0, &alloc_pages) != ZX_OK) {
+      return ktl::nullopt;
+    }
+    pages = page_cache::PageCache::PageList(ktl::move(alloc_pages));
   }
   MBufList ret;
-  while (!list_is_empty(&pages)) {
+  while (!pages.is_empty()) {
     vm_page_t* page = list_remove_head_type(&pages, vm_page_t, queue_node);
     MBuf* buf = reinterpret_cast<MBuf*>(paddr_to_physmap(page->paddr()));
     new (buf) MBuf(page);
@@ -239,7 +483,30 @@ void MBufChain::FreeMBufs(MBufList&& bufs) {
     buf->~MBuf();
     list_add_head(&pages, &page->queue_node);
   }
-  Pmm::Node().FreeList(&pages);
+  if (likely(page_cache_)) {
+    page_cache_.Free(ktl::move(pages));
+  } else {
+    Pmm::Node().FreeList(&pages);
+  }
+}
+
+void MBufChain::InitializePageCache(uint32_t /*level*/) {
+  zx::result<page_cache::PageCache> result =
+      page_cache::PageCache::Create(gBootOptions->mbuf_reserve_pages);
+  ASSERT(result.is_ok());
+  page_cache_ = ktl::move(result.value());
+}
+
+// Initialize the cache after the percpu data structures are initialized.
+LK_INIT_HOOK(mbuf_cache_init, MBufChain::InitializePageCache, LK_INIT_LEVEL_KERNEL)
+
+void MBufChain::DumpMemoryUsage() {
+  const int64_t total_bytes = mbuf_total_bytes_count.SumAcrossAllCpus();
+  printf("mbufs: %" PRId64 " bytes in %" PRId64 " buffers\n", total_bytes,
+         total_bytes / static_cast<int64_t>(sizeof(MBuf)));
+  if (page_cache_) {
+    printf("mbuf page cache: up to %zu reserve pages per cpu\n", page_cache_.reserve_pages());
+  }
 }
 
 MBufChain::MBuf::MBuf(vm_page_t* page) : page_(page) {
@@ -7,13 +7,18 @@
 #include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 #include <lib/debuglog.h>
+#include <lib/heap.h>
+#include <lib/ktrace.h>
 #include <lib/zircon-internal/macros.h>
 
+#include <kernel/thread.h>
+#include <object/dispatcher_cache.h>
 #include <object/executor.h>
 #include <object/memory_watchdog.h>
 #include <platform/halt_helper.h>
 #include <platform/halt_token.h>
 #include <pretty/cpp/sizes.h>
+#include <vm/kstack.h>
 #include <vm/scanner.h>
 
 using pretty::FormattedBytes;
@@ -26,6 +31,8 @@ KCOUNTER(pressure_level_critical, "memory_watchdog.pressure.critical")
 KCOUNTER(pressure_level_warning, "memory_watchdog.pressure.warning")
 KCOUNTER(pressure_level_normal, "memory_watchdog.pressure.normal")
 
+KCOUNTER(pressure_level_warning_predicted, "memory_watchdog.pressure.warning_predicted")
+
 KCOUNTER(eviction_triggered, "memory_watchdog.eviction.triggered")
 
 void CountPressureEvent(MemoryWatchdog::PressureLevel level) {
@@ -178,6 +185,9 @@ void MemoryWatchdog::EvictionTrigger() {
 
 // Helper called by the memory pressure thread when OOM state is entered.
 void MemoryWatchdog::OnOom() {
+  // Preserve the trace of the activity leading up to the OOM, if a flight recorder is running.
+  KTrace::GetInstance().FreezeFlightRecorder();
+
   switch (gBootOptions->oom_behavior) {
     case OomBehavior::kJobKill:
       if (!executor_->GetRootJobDispatcher()->KillJobWithKillOnOOM()) {
@@ -200,7 +210,7 @@ bool MemoryWatchdog::IsSignalDue(PressureLevel idx, zx_instant_mono_t time_now)
   // 1) The current index is lower than the previous one signaled (i.e. available memory is lower
   // now), so that clients can act on the signal quickly.
   // 2) |hysteresis_seconds_| have elapsed since the last time we examined the state.
-  return idx < prev_mem_event_idx_ ||
+  return idx < signaled_idx_ ||
          zx_time_sub_time(time_now, prev_mem_state_eval_time_) >= hysteresis_seconds_;
 }
 
@@ -218,12 +228,67 @@ bool MemoryWatchdog::IsEvictionRequired(PressureLevel idx) const {
          idx != PressureLevel::kOutOfMemory;
 }
 
+void MemoryWatchdog::UpdatePrediction(zx_instant_mono_t time_now) {
+  if (predict_horizon_ == 0) {
+    return;
+  }
+  if (mem_event_idx_ != PressureLevel::kNormal) {
+    // The warning level or worse has actually been reached, so there is nothing left to predict.
+    // Start over once back at the normal level.
+    warning_predicted_ = false;
+    prev_sample_time_ = ZX_TIME_INFINITE_PAST;
+    return;
+  }
+
+  const uint64_t free_mem = pmm_count_free_pages() * PAGE_SIZE;
+  const zx_duration_mono_t stall =
+      StallAggregator::GetStallAggregator()->ReadStats().stalled_time_some;
+  const zx_duration_mono_t elapsed = zx_time_sub_time(time_now, prev_sample_time_);
+  if (prev_sample_time_ != ZX_TIME_INFINITE_PAST) {
+    if (elapsed < ZX_MSEC(1)) {
+      // Too close to the previous sample to say anything about the rate.
+      return;
+    }
+    // Smooth the rate so that a single burst of allocation, or of freeing, does not dominate.
+    const int64_t decline =
+        static_cast<int64_t>(prev_sample_free_mem_) - static_cast<int64_t>(free_mem);
+    const int64_t rate = decline * 1000 / (elapsed / ZX_MSEC(1));
+    free_mem_decline_rate_ = (3 * free_mem_decline_rate_ + rate) / 4;
+  }
+
+  const bool stalling = prev_sample_time_ != ZX_TIME_INFINITE_PAST && predict_stall_percent_ != 0 &&
+                        (stall - prev_sample_stall_) * 100 > elapsed * predict_stall_percent_;
+  const uint64_t projected_decline =
+      free_mem_decline_rate_ > 0
+          ? static_cast<uint64_t>(free_mem_decline_rate_) * (predict_horizon_ / ZX_SEC(1))
+          : 0;
+  const bool predicted =
+      stalling || free_mem < mem_watermarks_[PressureLevel::kWarning] + projected_decline;
+  if (predicted && !warning_predicted_) {
+    pressure_level_warning_predicted.Add(1);
+  }
+  warning_predicted_ = predicted;
+
+  prev_sample_time_ = time_now;
+  prev_sample_free_mem_ = free_mem;
+  prev_sample_stall_ = stall;
+}
+
+Deadline MemoryWatchdog::PredictionDeadline(zx_instant_mono_t time_now) const {
+  if (predict_horizon_ == 0 || mem_event_idx_ != PressureLevel::kNormal) {
+    return Deadline::infinite();
+  }
+  return Deadline::no_slack(zx_time_add_duration(time_now, kPredictionSamplePeriod));
+}
+
 void MemoryWatchdog::WorkerThread() {
   while (true) {
     // If we've hit OOM level perform some immediate synchronous eviction to attempt to avoid OOM.
     if (mem_event_idx_ == PressureLevel::kOutOfMemory) {
       printf("memory-pressure: beginning reclamation to avoid OOM. Allocations are now disabled\n");
       CountPressureEvent(mem_event_idx_);
+      KernelStack::TrimCache();
+      Thread::TrimStructCache();
       // Keep trying to perform eviction for as long as we are evicting non-zero pages and we remain
       // in the out of memory state.
       while (mem_event_idx_ == PressureLevel::kOutOfMemory) {
@@ -258,13 +323,32 @@ void MemoryWatchdog::WorkerThread() {
 
     auto time_now = current_mono_time();
 
-    if (IsSignalDue(mem_event_idx_, time_now)) {
-      CountPressureEvent(mem_event_idx_);
-      printf("memory-pressure: memory availability state - %s\n",
-             PressureLevelToString(mem_event_idx_));
+    UpdatePrediction(time_now);
+    const PressureLevel signal_idx = LevelToSignal();
+
+    if (signal_idx == signaled_idx_ && mem_event_idx_ == prev_mem_event_idx_ &&
+        mem_event_idx_ != PressureLevel::kOutOfMemory &&
+        prev_mem_state_eval_time_ != ZX_TIME_INFINITE_PAST) {
+      // Nothing has changed since the last signal, which happens when the wait only ended for the
+      // next prediction sample. Leave the hysteresis timing alone and keep waiting.
+      WaitForMemChange(PredictionDeadline(time_now));
+      continue;
+    }
+
+    if (IsSignalDue(signal_idx, time_now)) {
+      CountPressureEvent(signal_idx);
+      printf("memory-pressure: memory availability state - %s%s\n",
+             PressureLevelToString(signal_idx), signal_idx != mem_event_idx_ ? " (predicted)" : "");
       pmm_page_queues()->Dump();
 
       if (IsEvictionRequired(mem_event_idx_)) {
+        // Cached kernel stacks and thread structures, per-CPU heap caches and empty dispatcher
+        // slabs are cheap to recreate, so release them before evicting anything.
+        KernelStack::TrimCache();
+        Thread::TrimStructCache();
+        heap_trim();
+        DispatcherCacheBase::TrimAll();
+
         // Clear any previous eviction trigger. Once Cancel completes we know that we will not race
         // with the callback and are free to update the targets. Cancel will return true if the
         // timer was canceled before it was scheduled on a cpu, i.e. an eviction was outstanding.
@@ -306,19 +390,20 @@ void MemoryWatchdog::WorkerThread() {
 
       // Unsignal the last event that was signaled.
       zx_status_t status =
-          mem_pressure_events_[prev_mem_event_idx_]->user_signal_self(ZX_EVENT_SIGNALED, 0);
+          mem_pressure_events_[signaled_idx_]->user_signal_self(ZX_EVENT_SIGNALED, 0);
       if (status != ZX_OK) {
         panic("memory-pressure: unsignal memory event %s failed: %d\n",
-              PressureLevelToString(prev_mem_event_idx_), status);
+              PressureLevelToString(signaled_idx_), status);
       }
 
       // Signal event corresponding to the new memory state.
-      status = mem_pressure_events_[mem_event_idx_]->user_signal_self(0, ZX_EVENT_SIGNALED);
+      status = mem_pressure_events_[signal_idx]->user_signal_self(0, ZX_EVENT_SIGNALED);
       if (status != ZX_OK) {
         panic("memory-pressure: signal memory event %s failed: %d\n",
-              PressureLevelToString(mem_event_idx_), status);
+              PressureLevelToString(signal_idx), status);
       }
       prev_mem_event_idx_ = mem_event_idx_;
+      signaled_idx_ = signal_idx;
       prev_mem_state_eval_time_ = time_now;
 
       // If we're below the out-of-memory watermark, trigger OOM behavior.
@@ -328,7 +413,7 @@ void MemoryWatchdog::WorkerThread() {
       }
 
       // Wait for the memory state to change again.
-      WaitForMemChange(Deadline::infinite());
+      WaitForMemChange(PredictionDeadline(time_now));
 
     } else {
       prev_mem_state_eval_time_ = time_now;
@@ -472,6 +557,10 @@ void MemoryWatchdog::Dump() {
   StallAggregator::Stats stats = StallAggregator::GetStallAggregator()->ReadStats();
   printf("memory stall time: some %ld, full %ld\n", stats.stalled_time_some,
          stats.stalled_time_full);
+  if (predict_horizon_ != 0) {
+    printf("warning predicted: %s, free memory decline: %ld bytes/s\n",
+           warning_predicted_ ? "yes" : "no", free_mem_decline_rate_);
+  }
 }
 
 void MemoryWatchdog::Init(Executor* executor) {
@@ -533,6 +622,8 @@ void MemoryWatchdog::Init(Executor* executor) {
 
     hysteresis_seconds_ = ZX_SEC(gBootOptions->oom_hysteresis_seconds);
     eviction_delay_ms_ = ZX_MSEC(gBootOptions->oom_eviction_delay_ms);
+    predict_horizon_ = ZX_SEC(gBootOptions->oom_predict_warning_seconds);
+    predict_stall_percent_ = gBootOptions->oom_predict_stall_percent;
 
     printf(
         "memory-pressure: memory watermarks - OutOfMemory: %zuMB, Critical: %zuMB, Warning: %zuMB, "
@@ -560,6 +651,11 @@ void MemoryWatchdog::Init(Executor* executor) {
              mem_watermarks_[PressureLevel::kImminentOutOfMemory] / MB);
     }
 
+    if (predict_horizon_ != 0) {
+      printf("memory-pressure: warning prediction - %ld seconds ahead, stall %u%%\n",
+             predict_horizon_ / ZX_SEC(1), predict_stall_percent_);
+    }
+
     auto memory_worker_thread = [](void* arg) -> int {
       MemoryWatchdog* watchdog = reinterpret_cast<MemoryWatchdog*>(arg);
       watchdog->WorkerThread();
@@ -6,6 +6,9 @@
 
 #include "object/message_packet.h"
 
+#include <lib/boot-options/boot-options.h>
+#include <lib/counters.h>
+#include <lib/object_cache.h>
 #include <stdint.h>
 #include <string.h>
 #include <zircon/errors.h>
@@ -17,6 +20,7 @@
 
 #include <fbl/algorithm.h>
 #include <ktl/algorithm.h>
+#include <lk/init.h>
 
 #include <ktl/enforce.h>
 
@@ -29,12 +33,84 @@
 //
 // The first buffer in a MessagePacket's BufferChain contains the MessagePacket object, followed by
 // its handles (if any), and finally its payload data (if any).
+//
+// Most messages are far smaller than a page though, and a queue of many small messages would
+// otherwise use a whole page per message. Messages that fit are instead stored, with the same
+// layout, in a single object from one of two size class object caches.
+
+// Payloads are always copied into the BufferChain on write and out of it on read, rather than
+// loaning the sender's pages to the packet. Once zx_channel_write returns the sender is free to
+// reuse its buffer, so sharing its pages would require write protecting them, and a sender that
+// reuses its buffer (the common case for bulk transfers) would then take a copy-on-write fault
+// per page, which copies the page anyway in addition to the fault and TLB shootdown costs. The
+// read side cannot have pages remapped in either, as zx_channel_read takes a buffer and not a
+// mapping. Bulk data that is large enough for page sharing to win should be sent as a VMO handle.
+//
+// Large messages are counted so the cost of these copies can be observed.
+static constexpr uint32_t kLargeMessageThreshold = 16 * 1024u;
+KCOUNTER(channel_msg_large_count, "channel.msg.large")
+KCOUNTER(channel_msg_large_bytes, "channel.msg.large.bytes")
+
+static inline void RecordMessageSize(uint32_t data_size) {
+  if (unlikely(data_size >= kLargeMessageThreshold)) {
+    kcounter_add(channel_msg_large_count, 1);
+    kcounter_add(channel_msg_large_bytes, data_size);
+  }
+}
 
 // The MessagePacket object, its handles and zx_txid_t must all fit in the first buffer.
 static constexpr size_t kContiguousBytes =
     sizeof(MessagePacket) + (kMaxMessageHandles * sizeof(Handle*)) + sizeof(zx_txid_t);
 static_assert(kContiguousBytes <= BufferChain::kContig, "");
 
+namespace {
+
+// The storage for a message that fits within |Size| bytes.
+template <size_t Size>
+struct alignas(MessagePacket) SlabMessage {
+  // Leave the bytes uninitialized, as they are about to be overwritten by the message.
+  SlabMessage() {}
+  char bytes[Size];
+};
+using SmallSlabMessage = SlabMessage<MessagePacket::kSmallSlabSize>;
+using MediumSlabMessage = SlabMessage<MessagePacket::kMediumSlabSize>;
+
+// Per-cpu cache allocators for the slab message size classes.
+object_cache::ObjectCache<SmallSlabMessage, object_cache::Option::PerCpu> small_message_allocator;
+object_cache::ObjectCache<MediumSlabMessage, object_cache::Option::PerCpu>
+    medium_message_allocator;
+
+KCOUNTER(channel_msg_small_slab_count, "channel.msg.slab.small")
+KCOUNTER(channel_msg_medium_slab_count, "channel.msg.slab.medium")
+
+// Allocates storage of the given size class, returning nullptr on failure.
+template <typename SlabMessageType, typename Allocator>
+void* AllocateSlabMessage(Allocator& allocator) {
+  zx::result<object_cache::UniquePtr<SlabMessageType>> result = allocator.Allocate();
+  return result.is_ok() ? result->release() : nullptr;
+}
+
+void InitializeMessageCaches(uint32_t /*level*/) {
+  const size_t reserve_pages = gBootOptions->channel_slab_message_reserve_pages;
+
+  zx::result small_result =
+      object_cache::ObjectCache<SmallSlabMessage, object_cache::Option::PerCpu>::Create(
+          reserve_pages);
+  ASSERT(small_result.is_ok());
+  small_message_allocator = ktl::move(*small_result);
+
+  zx::result medium_result =
+      object_cache::ObjectCache<MediumSlabMessage, object_cache::Option::PerCpu>::Create(
+          reserve_pages);
+  ASSERT(medium_result.is_ok());
+  medium_message_allocator = ktl::move(*medium_result);
+}
+
+}  // namespace
+
+// Initialize the caches after the percpu data structures are initialized.
+LK_INIT_HOOK(message_packet_cache_init, InitializeMessageCaches, LK_INIT_LEVEL_KERNEL)
+
 // Handles are stored just after the MessagePacket.
 static constexpr uint32_t kHandlesOffset = static_cast<uint32_t>(sizeof(MessagePacket));
 
@@ -58,27 +134,77 @@ inline zx_status_t MessagePacket::CreateCommon(size_t data_size, size_t num_hand
   }
 
   const size_t payload_offset = PayloadOffset(num_handles);
+  const size_t total_size = payload_offset + data_size;
+
+  // Small messages live in a single slab object holding the MessagePacket object, followed by its
+  // handles (if any), and finally the payload data. Should the slab allocation fail, fall back to
+  // a BufferChain, which has its own reserve of pages.
+  Storage storage = Storage::kBufferChain;
+  BufferChain* chain = nullptr;
+  char* data = nullptr;
+  if (total_size <= kSmallSlabSize) {
+    data = static_cast<char*>(AllocateSlabMessage<SmallSlabMessage>(small_message_allocator));
+    storage = Storage::kSmallSlab;
+  } else if (total_size <= kMediumSlabSize) {
+    data = static_cast<char*>(AllocateSlabMessage<MediumSlabMessage>(medium_message_allocator));
+    storage = Storage::kMediumSlab;
+  }
 
-  // MessagePackets lives *inside* a list of buffers.  The first buffer holds the MessagePacket
-  // object, followed by its handles (if any), and finally the payload data.
-  BufferChain* chain = BufferChain::Alloc(payload_offset + data_size);
-  if (unlikely(!chain)) {
-    return ZX_ERR_NO_MEMORY;
+  if (data) {
+    kcounter_add(storage == Storage::kSmallSlab ? channel_msg_small_slab_count
+                                                : channel_msg_medium_slab_count,
+                 1);
+  } else {
+    // MessagePackets lives *inside* a list of buffers.  The first buffer holds the MessagePacket
+    // object, followed by its handles (if any), and finally the payload data.
+    chain = BufferChain::Alloc(total_size);
+    if (unlikely(!chain)) {
+      return ZX_ERR_NO_MEMORY;
+    }
+    DEBUG_ASSERT(!chain->buffers()->is_empty());
+    chain->Skip(payload_offset);
+    data = chain->buffers()->front().data();
+    storage = Storage::kBufferChain;
   }
-  DEBUG_ASSERT(!chain->buffers()->is_empty());
-  chain->Skip(payload_offset);
 
-  char* const data = chain->buffers()->front().data();
   Handle** const handles = reinterpret_cast<Handle**>(data + kHandlesOffset);
 
-  // Construct the MessagePacket into the first buffer.
+  // Construct the MessagePacket into the start of its storage.
   MessagePacket* const packet = reinterpret_cast<MessagePacket*>(data);
   static_assert(kMaxMessageHandles <= UINT16_MAX, "");
-  msg->reset(new (packet) MessagePacket(chain, static_cast<uint32_t>(data_size),
+  msg->reset(new (packet) MessagePacket(storage, chain, static_cast<uint32_t>(data_size),
                                         static_cast<uint32_t>(payload_offset),
                                         static_cast<uint16_t>(num_handles), handles));
-  // The MessagePacket now owns the BufferChain and msg owns the MessagePacket.
+  // The MessagePacket now owns its storage and msg owns the MessagePacket.
+
+  return ZX_OK;
+}
+
+zx_status_t MessagePacket::AppendData(user_in_ptr<const char> src, size_t size) {
+  if (storage_ == Storage::kBufferChain) {
+    return buffer_chain_->Append(src, size);
+  }
+  if (unlikely(size > data_size_ - slab_append_offset_)) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+  zx_status_t status =
+      src.copy_array_from_user(static_cast<char*>(payload()) + slab_append_offset_, size);
+  if (unlikely(status != ZX_OK)) {
+    return status;
+  }
+  slab_append_offset_ += static_cast<uint32_t>(size);
+  return ZX_OK;
+}
 
+zx_status_t MessagePacket::AppendData(const char* src, size_t size) {
+  if (storage_ == Storage::kBufferChain) {
+    return buffer_chain_->AppendKernel(src, size);
+  }
+  if (unlikely(size > data_size_ - slab_append_offset_)) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+  memcpy(static_cast<char*>(payload()) + slab_append_offset_, src, size);
+  slab_append_offset_ += static_cast<uint32_t>(size);
   return ZX_OK;
 }
 
@@ -90,10 +216,11 @@ zx_status_t MessagePacket::Create(user_in_ptr<const char> data, uint32_t data_si
   if (unlikely(status != ZX_OK)) {
     return status;
   }
-  status = new_msg->buffer_chain_->Append(data, data_size);
+  status = new_msg->AppendData(data, data_size);
   if (unlikely(status != ZX_OK)) {
     return status;
   }
+  RecordMessageSize(data_size);
   *msg = ktl::move(new_msg);
   return ZX_OK;
 }
@@ -142,12 +269,13 @@ zx_status_t MessagePacket::CreateIovecBounded(user_in_ptr<const zx_channel_iovec
 
   for (uint32_t i = 0; i < num_iovecs; i++) {
     user_in_ptr<const char> src(reinterpret_cast<const char*>(iovecs[i].buffer));
-    status = new_msg->buffer_chain_->Append(src, iovecs[i].capacity);
+    status = new_msg->AppendData(src, iovecs[i].capacity);
     if (unlikely(status != ZX_OK)) {
       return status;
     }
   }
 
+  RecordMessageSize(new_msg->data_size());
   *msg = ktl::move(new_msg);
   return ZX_OK;
 }
@@ -180,7 +308,7 @@ zx_status_t MessagePacket::CreateIovecUnbounded(user_in_ptr<const zx_channel_iov
       static_assert(sizeof(message_size) > sizeof(iovec->capacity), "avoid overflow");
       message_size += iovec->capacity;
       user_in_ptr<const char> src(reinterpret_cast<const char*>(iovec->buffer));
-      status = new_msg->buffer_chain_->Append(src, iovec->capacity);
+      status = new_msg->AppendData(src, iovec->capacity);
       if (unlikely(status != ZX_OK)) {
         return status;
       }
@@ -192,6 +320,7 @@ zx_status_t MessagePacket::CreateIovecUnbounded(user_in_ptr<const zx_channel_iov
 
   new_msg->buffer_chain_->FreeUnusedBuffers();
   new_msg->set_data_size(static_cast<uint32_t>(message_size));
+  RecordMessageSize(new_msg->data_size());
 
   *msg = ktl::move(new_msg);
   return ZX_OK;
@@ -205,7 +334,7 @@ zx_status_t MessagePacket::Create(const char* data, uint32_t data_size, uint32_t
   if (unlikely(status != ZX_OK)) {
     return status;
   }
-  status = new_msg->buffer_chain_->AppendKernel(data, data_size);
+  status = new_msg->AppendData(data, data_size);
   if (unlikely(status != ZX_OK)) {
     return status;
   }
@@ -214,13 +343,28 @@ zx_status_t MessagePacket::Create(const char* data, uint32_t data_size, uint32_t
 }
 
 void MessagePacket::recycle(MessagePacket* packet) {
-  // Grab the buffer chain for this packet
+  // Grab the storage for this packet
+  const Storage storage = packet->storage_;
   BufferChain* chain = packet->buffer_chain_;
 
   // Manually destruct the packet.  Do not delete it; its memory did not come
-  // from new, it is contained as part of the buffer chain.
+  // from new, it is contained as part of its storage.
   packet->~MessagePacket();
 
-  // Now return the buffer chain to where it came from.
-  BufferChain::Free(chain);
+  // Now return the storage to where it came from.
+  switch (storage) {
+    case Storage::kSmallSlab: {
+      object_cache::UniquePtr<SmallSlabMessage> destroyer{
+          reinterpret_cast<SmallSlabMessage*>(packet)};
+      break;
+    }
+    case Storage::kMediumSlab: {
+      object_cache::UniquePtr<MediumSlabMessage> destroyer{
+          reinterpret_cast<MediumSlabMessage*>(packet)};
+      break;
+    }
+    case Storage::kBufferChain:
+      BufferChain::Free(chain);
+      break;
+  }
 }
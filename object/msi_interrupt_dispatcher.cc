@@ -241,6 +241,18 @@ void MsiInterruptDispatcherImpl::UnmaskInterrupt() {
   }
 }
 
+zx_status_t MsiInterruptDispatcherImpl::SetInterruptAffinity(cpu_num_t cpu) {
+  uint64_t tgt_addr;
+  zx_status_t status = msi_route_to_cpu(&allocation()->block(), msi_id(), cpu, &tgt_addr);
+  if (status != ZX_OK) {
+    return status;
+  }
+  // The address registers of the MSI capability are owned by the userspace PCI driver, and are
+  // shared by every vector of the function, so plain MSI can only be steered on platforms that
+  // route it without changing the address.
+  return tgt_addr == allocation()->block().tgt_addr ? ZX_OK : ZX_ERR_NOT_SUPPORTED;
+}
+
 MsixInterruptDispatcherImpl::MsixInterruptDispatcherImpl(fbl::RefPtr<MsiAllocation> alloc,
                                                          uint32_t base_irq_id, uint32_t msi_id,
                                                          fbl::RefPtr<VmMapping> mapping,
@@ -278,6 +290,32 @@ void MsixInterruptDispatcherImpl::UnmaskInterrupt() {
   arch::DeviceMemoryBarrier();
 }
 
+zx_status_t MsixInterruptDispatcherImpl::SetInterruptAffinity(cpu_num_t cpu) {
+  uint64_t tgt_addr;
+  zx_status_t status = msi_route_to_cpu(&allocation()->block(), msi_id(), cpu, &tgt_addr);
+  if (status != ZX_OK) {
+    return status;
+  }
+
+  // The address of a table entry must not be rewritten while the vector is unmasked, see the
+  // Vector Control notes in PCI Local Bus Spec v3 section 6.8.2. The mask is restored directly
+  // rather than through UnmaskInterrupt so the mask counters only reflect interrupt servicing.
+  volatile MsixTableEntry* entry = &table_entries_[msi_id()];
+  const bool was_masked = readl(&entry->vector_control) & (1u << kMsixVectorControlMaskBit);
+  if (!was_masked) {
+    RMWREG32(&entry->vector_control, kMsixVectorControlMaskBit, 1, 1);
+    arch::DeviceMemoryBarrier();
+  }
+  writel(tgt_addr & UINT32_MAX, &entry->msg_addr);
+  writel(static_cast<uint32_t>(tgt_addr >> 32), &entry->msg_upper_addr);
+  arch::DeviceMemoryBarrier();
+  if (!was_masked) {
+    RMWREG32(&entry->vector_control, kMsixVectorControlMaskBit, 1, 0);
+    arch::DeviceMemoryBarrier();
+  }
+  return ZX_OK;
+}
+
 MsixInterruptDispatcherImpl::~MsixInterruptDispatcherImpl() {
   MaskInterrupt();
   writel(0, &table_entries_[msi_id()].msg_addr);
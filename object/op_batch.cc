@@ -0,0 +1,110 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "object/op_batch.h"
+
+#include <lib/counters.h>
+#include <lib/user_copy/user_ptr.h>
+#include <zircon/errors.h>
+#include <zircon/rights.h>
+
+#include <fbl/ref_ptr.h>
+#include <object/dispatcher.h>
+#include <object/port_dispatcher.h>
+#include <object/process_dispatcher.h>
+
+KCOUNTER(op_batch_batches, "op_batch.batches")
+KCOUNTER(op_batch_ops, "op_batch.ops")
+
+namespace {
+
+// Remembers the most recently resolved handle so that runs of operations on the same object
+// only look it up once.
+class HandleCache {
+ public:
+  explicit HandleCache(ProcessDispatcher& up) : up_(up) {}
+
+  zx_status_t Get(zx_handle_t handle_value, zx_rights_t desired_rights,
+                  fbl::RefPtr<Dispatcher>* out) {
+    if (!dispatcher_ || handle_value != handle_value_) {
+      dispatcher_.reset();
+      const zx_status_t status =
+          up_.handle_table().GetDispatcherAndRights(up_, handle_value, &dispatcher_, &rights_);
+      if (status != ZX_OK) {
+        return status;
+      }
+      handle_value_ = handle_value;
+    }
+    if ((rights_ & desired_rights) != desired_rights) {
+      return ZX_ERR_ACCESS_DENIED;
+    }
+    *out = dispatcher_;
+    return ZX_OK;
+  }
+
+ private:
+  ProcessDispatcher& up_;
+  zx_handle_t handle_value_ = ZX_HANDLE_INVALID;
+  fbl::RefPtr<Dispatcher> dispatcher_;
+  zx_rights_t rights_ = 0;
+};
+
+zx_status_t ExecuteOne(ProcessDispatcher& up, HandleCache& cache, const BatchOp& op) {
+  fbl::RefPtr<Dispatcher> dispatcher;
+  switch (op.opcode) {
+    case BatchOpcode::kObjectSignal: {
+      const zx_status_t status = cache.Get(op.handle, ZX_RIGHT_SIGNAL, &dispatcher);
+      if (status != ZX_OK) {
+        return status;
+      }
+      return dispatcher->user_signal_self(op.signal.clear_mask, op.signal.set_mask);
+    }
+    case BatchOpcode::kObjectSignalPeer: {
+      const zx_status_t status = cache.Get(op.handle, ZX_RIGHT_SIGNAL_PEER, &dispatcher);
+      if (status != ZX_OK) {
+        return status;
+      }
+      return dispatcher->user_signal_peer(op.signal.clear_mask, op.signal.set_mask);
+    }
+    case BatchOpcode::kPortQueue: {
+      const zx_status_t status = cache.Get(op.handle, ZX_RIGHT_WRITE, &dispatcher);
+      if (status != ZX_OK) {
+        return status;
+      }
+      fbl::RefPtr<PortDispatcher> port = DownCastDispatcher<PortDispatcher>(&dispatcher);
+      if (!port) {
+        return ZX_ERR_WRONG_TYPE;
+      }
+      return port->QueueUser(op.packet);
+    }
+    case BatchOpcode::kFutexWake:
+      return up.futex_context().FutexWake(
+          make_user_in_ptr(reinterpret_cast<const zx_futex_t*>(op.futex_wake.value_ptr)),
+          op.futex_wake.count, FutexContext::OwnerAction::RELEASE);
+  }
+  return ZX_ERR_NOT_SUPPORTED;
+}
+
+}  // namespace
+
+size_t ExecuteOpBatch(ProcessDispatcher& up, ktl::span<const BatchOp> ops,
+                      ktl::span<zx_status_t> results, uint32_t options) {
+  DEBUG_ASSERT(results.size() >= ops.size());
+
+  HandleCache cache(up);
+  size_t executed = 0;
+  for (const BatchOp& op : ops) {
+    const zx_status_t status = ExecuteOne(up, cache, op);
+    results[executed++] = status;
+    if (status != ZX_OK && (options & kBatchStopOnError)) {
+      break;
+    }
+  }
+
+  kcounter_add(op_batch_batches, 1);
+  kcounter_add(op_batch_ops, static_cast<int64_t>(executed));
+  return executed;
+}
@@ -10,6 +10,7 @@
 #include <trace.h>
 #include <zircon/syscalls-next.h>
 
+#include <ktl/algorithm.h>
 #include <lk/init.h>
 #include <object/diagnostics.h>
 #include <object/pager_dispatcher.h>
@@ -24,6 +25,7 @@ KCOUNTER(dispatcher_pager_total_request_count, "dispatcher.pager.total_requests"
 KCOUNTER(dispatcher_pager_succeeded_request_count, "dispatcher.pager.succeeded_requests")
 KCOUNTER(dispatcher_pager_failed_request_count, "dispatcher.pager.failed_requests")
 KCOUNTER(dispatcher_pager_timed_out_request_count, "dispatcher.pager.timed_out_requests")
+KCOUNTER(dispatcher_pager_coalesced_request_count, "dispatcher.pager.coalesced_requests")
 
 PagerProxy::PagerProxy(PagerDispatcher* dispatcher, fbl::RefPtr<PortDispatcher> port, uint64_t key,
                        uint32_t options)
@@ -92,6 +94,8 @@ void PagerProxy::QueuePacketLocked(PageRequest* request) {
     uint64_t unused;
     DEBUG_ASSERT(!add_overflow(offset, length, &unused));
 
+    CoalescePendingLocked(GetRequestType(request), &offset, &length);
+
     // Trace flow events require an enclosing duration.
     VM_KTRACE_DURATION(1, "page_request_queue", ("vmo_id", GetRequestVmoId(request)),
                        ("offset", offset), ("length", length),
@@ -117,6 +121,53 @@ void PagerProxy::QueuePacketLocked(PageRequest* request) {
   ASSERT(port_->Queue(&packet_) != ZX_ERR_SHOULD_WAIT);
 }
 
+void PagerProxy::CoalescePendingLocked(page_request_type type, uint64_t* offset,
+                                       uint64_t* length) {
+  DEBUG_ASSERT(coalesced_requests_.is_empty());
+  const uint32_t max_requests = gBootOptions->userpager_coalesce_max_requests;
+  uint64_t start = *offset;
+  uint64_t end = *offset + *length;
+  uint32_t count = 0;
+  // Pending requests are in the order they were sent rather than in offset order, so keep making
+  // passes for as long as the range grows.
+  bool grew = true;
+  while (grew && count < max_requests) {
+    grew = false;
+    for (auto iter = pending_requests_.begin();
+         iter != pending_requests_.end() && count < max_requests;) {
+      PageRequest& request = *iter++;
+      const uint64_t request_start = GetRequestOffset(&request);
+      const uint64_t request_end = request_start + GetRequestLen(&request);
+      if (GetRequestType(&request) != type || request_end < start || request_start > end) {
+        continue;
+      }
+      start = ktl::min(start, request_start);
+      end = ktl::max(end, request_end);
+      coalesced_requests_.push_back(pending_requests_.erase(request));
+      count++;
+      grew = true;
+    }
+  }
+  if (count > 0) {
+    dispatcher_pager_coalesced_request_count.Add(count);
+    *offset = start;
+    *length = end - start;
+  }
+}
+
+PagerProxy::RequestList* PagerProxy::QueuedListLocked(PageRequest* request) {
+  if (!fbl::InContainer<PageProviderTag>(*request)) {
+    return nullptr;
+  }
+  // coalesced_requests_ is bounded by kernel.userpager.coalesce_max_requests.
+  for (PageRequest& coalesced : coalesced_requests_) {
+    if (&coalesced == request) {
+      return &coalesced_requests_;
+    }
+  }
+  return &pending_requests_;
+}
+
 void PagerProxy::ClearAsyncRequest(PageRequest* request) {
   Guard<Mutex> guard{&mtx_};
   ASSERT(!page_source_closed_);
@@ -142,10 +193,12 @@ void PagerProxy::ClearAsyncRequest(PageRequest* request) {
     // Condition on whether or not we actually cancel the packet, to make sure
     // we don't race with a call to PagerProxy::Free.
     if (port_->CancelQueued(&packet_)) {
+      // The requests coalesced into the packet were never delivered, so queue them again.
+      pending_requests_.splice(pending_requests_.begin(), coalesced_requests_);
       OnPacketFreedLocked();
     }
-  } else if (fbl::InContainer<PageProviderTag>(*request)) {
-    pending_requests_.erase(*request);
+  } else if (RequestList* list = QueuedListLocked(request)) {
+    list->erase(*request);
   }
 }
 
@@ -153,9 +206,9 @@ void PagerProxy::SwapAsyncRequest(PageRequest* old, PageRequest* new_req) {
   Guard<Mutex> guard{&mtx_};
   ASSERT(!page_source_closed_);
 
-  if (fbl::InContainer<PageProviderTag>(*old)) {
-    pending_requests_.insert(*old, new_req);
-    pending_requests_.erase(*old);
+  if (RequestList* list = QueuedListLocked(old)) {
+    list->insert(*old, new_req);
+    list->erase(*old);
   } else if (old == active_request_) {
     active_request_ = new_req;
   }
@@ -266,6 +319,8 @@ void PagerProxy::Free(PortPacket* packet) {
       VM_KTRACE_FLOW_END(1, "page_request_queue", reinterpret_cast<uintptr_t>(packet));
       active_request_ = nullptr;
     }
+    // The pager has been handed the coalesced requests along with the active one.
+    coalesced_requests_.clear();
     OnPacketFreedLocked();
   } else {
     // Freeing the complete_request_ indicates we have completed a pending action that might have
@@ -273,6 +328,7 @@ void PagerProxy::Free(PortPacket* packet) {
     complete_pending_ = false;
     // Should be nothing else queued.
     DEBUG_ASSERT(pending_requests_.is_empty());
+    DEBUG_ASSERT(coalesced_requests_.is_empty());
     active_request_ = nullptr;
     packet_busy_ = false;
     // If the source is closed, we need to do delayed cleanup. Make sure we are not still in the
@@ -449,6 +505,12 @@ void PagerProxy::Dump(uint depth, uint32_t max_items) {
   } else {
     printer.Emit("  no active request on pager port");
   }
+  if (packet_busy_ && !coalesced_requests_.is_empty()) {
+    printer.Emit("  packet on pager port covers [0x%lx, 0x%lx) with %zu coalesced requests",
+                 packet_.packet.page_request.offset,
+                 packet_.packet.page_request.offset + packet_.packet.page_request.length,
+                 coalesced_requests_.size_slow());
+  }
 
   if (pending_requests_.is_empty()) {
     printer.Emit("  no pending requests to queue on pager port");
@@ -23,6 +23,7 @@
 #include <lk/init.h>
 #include <object/process_dispatcher.h>
 #include <object/thread_dispatcher.h>
+#include <platform/timer.h>
 
 // All port sub-packets must be exactly 32 bytes
 static_assert(sizeof(zx_packet_user_t) == 32, "incorrect size for zx_packet_signal_t");
@@ -38,6 +39,8 @@ static_assert(sizeof(zx_packet_page_request_t) == 32,
 KCOUNTER(port_ephemeral_packet_live, "port.ephemeral_packet.live")
 KCOUNTER(port_ephemeral_packet_allocated, "port.ephemeral_packet.allocated")
 KCOUNTER(port_ephemeral_packet_freed, "port.ephemeral_packet.freed")
+// Time from an interrupt packet being queued to it being dequeued, from 1us up to 16ms.
+KCOUNTER_HISTOGRAM(port_interrupt_packet_latency_ns, "port.interrupt_packet.latency_ns", 10)
 KCOUNTER(port_full_count, "port.full.count")
 KCOUNTER(port_dequeue_count, "port.dequeue.count")
 KCOUNTER(port_dequeue_spurious_count, "port.dequeue.spurious.count")
@@ -123,6 +126,22 @@ PortObserver::PortObserver(uint32_t options, const Handle* handle, fbl::RefPtr<P
 }
 
 void PortObserver::OnMatch(zx_signals_t signals) {
+  if (IsPersistent()) {
+    // The packet may be queued, so it is only updated under the port's lock. |this| cannot be
+    // destroyed during this call since reaping a persistent observer requires removing it from
+    // the Dispatcher, whose lock our caller holds.
+    uint64_t timestamp = 0;
+    if (options_ & ZX_WAIT_ASYNC_TIMESTAMP) {
+      timestamp = current_mono_time();
+    } else if (options_ & ZX_WAIT_ASYNC_BOOT_TIMESTAMP) {
+      timestamp = current_boot_time();
+    }
+    const zx_status_t status = port_->QueueOrUpdatePersistent(&packet_, signals, timestamp);
+    DEBUG_ASSERT_MSG(status == ZX_OK || status == ZX_ERR_BAD_HANDLE || status == ZX_ERR_CANCELED,
+                     "status %d\n", status);
+    return;
+  }
+
   if (options_ & ZX_WAIT_ASYNC_TIMESTAMP) {
     // Getting the current time can be somewhat expensive.
     packet_.packet.signal.timestamp = current_mono_time();
@@ -202,8 +221,10 @@ void PortDispatcher::on_zero_handles() {
 
     // If the packet is ephemeral, free it outside of the lock. Otherwise,
     // reset the observer if it is present.
-    if (IsDefaultAllocatedEphemeral(*packet)) {
-      --num_ephemeral_packets_;
+    if (packet->is_ephemeral()) {
+      if (IsDefaultAllocatedEphemeral(*packet)) {
+        --num_ephemeral_packets_;
+      }
       guard.CallUnlocked([packet]() { packet->Free(); });
     } else {
       // The reference to the port that the observer holds cannot be the last one
@@ -265,7 +286,8 @@ bool PortDispatcher::RemoveInterruptPacket(PortInterruptPacket* port_packet) {
 }
 
 bool PortDispatcher::QueueInterruptPacket(PortInterruptPacket* port_packet,
-                                          zx_instant_boot_t timestamp) {
+                                          zx_instant_boot_t timestamp, uint64_t count,
+                                          zx_instant_boot_t last_timestamp) {
   {
     Guard<SpinLock, IrqSave> guard{&spinlock_};
     if (port_packet->InContainer()) {
@@ -273,6 +295,9 @@ bool PortDispatcher::QueueInterruptPacket(PortInterruptPacket* port_packet,
     }
 
     port_packet->timestamp = timestamp;
+    port_packet->count = count;
+    port_packet->last_timestamp = last_timestamp;
+    port_packet->queued_ticks = current_mono_ticks();
     interrupt_packets_.push_back(port_packet);
   }
 
@@ -317,6 +342,33 @@ zx_status_t PortDispatcher::QueueAndRemoveObserver(PortPacket* port_packet, zx_s
   return ZX_OK;
 }
 
+zx_status_t PortDispatcher::QueueOrUpdatePersistent(PortPacket* port_packet, zx_signals_t observed,
+                                                    uint64_t timestamp) {
+  canary_.Assert();
+  DEBUG_ASSERT(!port_packet->is_ephemeral());
+
+  {
+    Guard<CriticalMutex> guard{get_lock()};
+
+    if (port_packet->InContainer()) {
+      // Coalesce with the pending packet. There is no new packet, so no Post.
+      if (!port_packet->is_canceled()) {
+        port_packet->packet.signal.observed |= observed;
+      }
+      return ZX_OK;
+    }
+
+    port_packet->packet.signal.timestamp = timestamp;
+    zx_status_t status = QueuePacketLocked(port_packet, observed);
+    if (status != ZX_OK) {
+      return status;
+    }
+  }
+
+  sema_.Post();
+  return ZX_OK;
+}
+
 zx_status_t PortDispatcher::QueuePacketLocked(PortPacket* port_packet, zx_signals_t observed) {
   canary_.Assert();
 
@@ -354,8 +406,17 @@ zx_status_t PortDispatcher::QueuePacketLocked(PortPacket* port_packet, zx_signal
 }
 
 zx_status_t PortDispatcher::Dequeue(const Deadline& deadline, zx_port_packet_t* out_packet) {
+  size_t num_packets;
+  return DequeueMany(deadline, ktl::span(out_packet, 1), &num_packets);
+}
+
+zx_status_t PortDispatcher::DequeueMany(const Deadline& deadline,
+                                        ktl::span<zx_port_packet_t> out_packets,
+                                        size_t* num_packets) {
   canary_.Assert();
+  DEBUG_ASSERT(!out_packets.empty());
 
+  size_t count = 0;
   while (true) {
     // Wait until one of the queues has a packet.
     {
@@ -365,54 +426,86 @@ zx_status_t PortDispatcher::Dequeue(const Deadline& deadline, zx_port_packet_t*
         return st;
     }
 
+    // The wait above accounts for the first packet we take. Each further packet must take its own
+    // count from |sema_| without blocking, so that a thread already woken for it does not find
+    // the queues empty.
+    bool have_count = true;
+    auto take_count = [&]() {
+      if (have_count) {
+        have_count = false;
+        return true;
+      }
+      return sema_.TryWait();
+    };
+
     // Interrupt packets are higher priority so service the interrupt packet queue first.
     if (options_ == ZX_PORT_BIND_TO_INTERRUPT) {
       Guard<SpinLock, IrqSave> guard{&spinlock_};
-      PortInterruptPacket* port_interrupt_packet = interrupt_packets_.pop_front();
-      if (port_interrupt_packet != nullptr) {
-        *out_packet = {};
-        out_packet->key = port_interrupt_packet->key;
-        out_packet->type = ZX_PKT_TYPE_INTERRUPT;
-        out_packet->status = ZX_OK;
-        out_packet->interrupt.timestamp = port_interrupt_packet->timestamp;
-        break;
+      while (count < out_packets.size() && !interrupt_packets_.is_empty() && take_count()) {
+        PortInterruptPacket* port_interrupt_packet = interrupt_packets_.pop_front();
+        zx_port_packet_t& out_packet = out_packets[count++];
+        out_packet = {};
+        out_packet.key = port_interrupt_packet->key;
+        out_packet.type = ZX_PKT_TYPE_INTERRUPT;
+        out_packet.status = ZX_OK;
+        out_packet.interrupt.timestamp = port_interrupt_packet->timestamp;
+        out_packet.interrupt.reserved0 = port_interrupt_packet->count;
+        out_packet.interrupt.reserved1 =
+            static_cast<uint64_t>(port_interrupt_packet->last_timestamp);
+        port_interrupt_packet_latency_ns.Add(
+            static_cast<uint64_t>(timer_get_ticks_to_time_ratio().Scale(
+                current_mono_ticks() - port_interrupt_packet->queued_ticks)));
       }
     }
 
-    // No interrupt packets queued. Check the regular packets.
-    {
+    // Fill the rest from the regular packets.
+    if (count < out_packets.size()) {
+      // Packets that this thread now owns, either because they are ephemeral or because their
+      // observer has already been reaped. They are destroyed after dropping the lock to keep the
+      // critical section, which every waiter on this port contends on, as short as possible.
+      fbl::DoublyLinkedList<PortPacket*> owned_packets;
       Guard<CriticalMutex> guard{get_lock()};
-      PortPacket* port_packet = packets_.pop_front();
-      if (port_packet != nullptr) {
+      while (count < out_packets.size() && !packets_.is_empty() && take_count()) {
+        PortPacket* port_packet = packets_.pop_front();
         if (IsDefaultAllocatedEphemeral(*port_packet)) {
           --num_ephemeral_packets_;
         }
         DEBUG_ASSERT(port_packet->packet.type != kPortPacketTypeCanceled);
-        *out_packet = port_packet->packet;
-
-        bool is_ephemeral = port_packet->is_ephemeral();
-        // The reference to the port that the observer holds cannot be the last one
-        // because another reference was used to call Dequeue, so we don't need to
-        // worry about destroying ourselves.
-        port_packet->observer.reset();
-        guard.Release();
-
-        // If the packet is ephemeral, free it outside of the lock. We need to read
-        // is_ephemeral inside the lock because it's possible for a non-ephemeral packet
-        // to get deleted after a call to |MaybeReap| as soon as we release the lock.
-        if (is_ephemeral) {
+        out_packets[count++] = port_packet->packet;
+
+        // We need to decide ownership inside the lock because it's possible for a non-ephemeral
+        // packet with no observer to get deleted after a call to |MaybeReap| as soon as we
+        // release the lock.
+        if (port_packet->is_ephemeral() || port_packet->observer != nullptr) {
+          owned_packets.push_back(port_packet);
+        }
+      }
+      guard.Release();
+
+      while (!owned_packets.is_empty()) {
+        PortPacket* port_packet = owned_packets.pop_front();
+        if (port_packet->is_ephemeral()) {
           port_packet->Free();
+        } else {
+          // The observer embeds |port_packet|, so this destroys both. The reference to the port
+          // that the observer holds cannot be the last one because another reference was used to
+          // call Dequeue, so we don't need to worry about destroying ourselves.
+          object_cache::UniquePtr<const PortObserver> observer = ktl::move(port_packet->observer);
         }
-        break;
       }
     }
 
+    if (count > 0) {
+      break;
+    }
+
     // Both queues were empty. The packet must have been removed before we were able to
     // dequeue. Loop back and wait again.
     kcounter_add(port_dequeue_spurious_count, 1);
   }
 
-  kcounter_add(port_dequeue_count, 1);
+  kcounter_add(port_dequeue_count, count);
+  *num_packets = count;
   return ZX_OK;
 }
 
@@ -8,6 +8,7 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 #include <lib/crypto/global_prng.h>
 #include <lib/fit/defer.h>
@@ -19,11 +20,17 @@
 
 #include <arch/defines.h>
 #include <fbl/alloc_checker.h>
+#include <fbl/intrusive_double_list.h>
 #include <fbl/ref_ptr.h>
+#include <kernel/mutex.h>
+#include <kernel/semaphore.h>
 #include <kernel/thread.h>
+#include <ktl/unique_ptr.h>
+#include <lk/init.h>
 #include <object/diagnostics.h>
 #include <object/handle.h>
 #include <object/job_dispatcher.h>
+#include <object/process_template.h>
 #include <object/thread_dispatcher.h>
 #include <object/vm_address_region_dispatcher.h>
 #include <object/vm_object_dispatcher.h>
@@ -74,12 +81,83 @@ static_assert(std::size(kPolicyIdToPolicyException) == ZX_POL_MAX,
 
 KCOUNTER(dispatcher_process_create_count, "dispatcher.process.create")
 KCOUNTER(dispatcher_process_destroy_count, "dispatcher.process.destroy")
+KCOUNTER(dispatcher_process_deferred_teardown_count, "dispatcher.process.deferred_teardown")
+
+namespace {
+
+// An address space whose destruction has been handed off to the teardown threads, see
+// kernel.process.deferred-teardown.
+struct DeferredTeardown : public fbl::DoublyLinkedListable<ktl::unique_ptr<DeferredTeardown>> {
+  fbl::RefPtr<ShareableProcessState> state;
+};
+
+// Destroying an address space is mostly spent unmapping and freeing pages, which is serialized on
+// the aspace's own lock, so a couple of threads are enough to keep several dying processes from
+// queueing behind one very large one.
+constexpr size_t kTeardownThreads = 2;
+
+DECLARE_SINGLETON_MUTEX(DeferredTeardownLock);
+fbl::DoublyLinkedList<ktl::unique_ptr<DeferredTeardown>> gDeferredTeardownQueue
+    TA_GUARDED(DeferredTeardownLock::Get());
+Semaphore gDeferredTeardownPending;
+
+int DeferredTeardownWorker(void*) {
+  for (;;) {
+    [[maybe_unused]] zx_status_t wait_status = gDeferredTeardownPending.Wait(Deadline::infinite());
+    DEBUG_ASSERT(wait_status == ZX_OK);
+
+    ktl::unique_ptr<DeferredTeardown> teardown;
+    {
+      Guard<Mutex> guard{DeferredTeardownLock::Get()};
+      teardown = gDeferredTeardownQueue.pop_front();
+    }
+    DEBUG_ASSERT(teardown);
+
+    teardown->state->DestroyAspace();
+  }
+  return 0;
+}
+
+// Hands the destruction of |state|'s address space to the teardown threads. Returns false if that
+// is not possible, in which case the caller must destroy it.
+bool QueueDeferredTeardown(const fbl::RefPtr<ShareableProcessState>& state) {
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<DeferredTeardown> teardown(new (&ac) DeferredTeardown{{}, state});
+  if (!ac.check()) {
+    return false;
+  }
+  {
+    Guard<Mutex> guard{DeferredTeardownLock::Get()};
+    gDeferredTeardownQueue.push_back(ktl::move(teardown));
+  }
+  gDeferredTeardownPending.Post();
+  dispatcher_process_deferred_teardown_count.Add(1);
+  return true;
+}
+
+void DeferredTeardownInit(unsigned int level) {
+  if (!gBootOptions->process_deferred_teardown) {
+    return;
+  }
+  for (size_t i = 0; i < kTeardownThreads; i++) {
+    char name[ZX_MAX_NAME_LEN];
+    snprintf(name, sizeof(name), "process-teardown-%zu", i);
+    Thread* thread = Thread::Create(name, DeferredTeardownWorker, nullptr, DEFAULT_PRIORITY);
+    ASSERT(thread != nullptr);
+    thread->DetachAndResume();
+  }
+}
+
+}  // namespace
+
+LK_INIT_HOOK(process_deferred_teardown, DeferredTeardownInit, LK_INIT_LEVEL_THREADING)
 
 zx_status_t ProcessDispatcher::Create(fbl::RefPtr<JobDispatcher> job, ktl::string_view name,
                                       uint32_t flags, KernelHandle<ProcessDispatcher>* handle,
                                       zx_rights_t* rights,
                                       KernelHandle<VmAddressRegionDispatcher>* root_vmar_handle,
-                                      zx_rights_t* root_vmar_rights) {
+                                      zx_rights_t* root_vmar_rights,
+                                      const ProcessTemplate* process_template) {
   fbl::AllocChecker ac;
   fbl::RefPtr<ShareableProcessState> shareable_state =
       fbl::AdoptRef(new (&ac) ShareableProcessState);
@@ -113,6 +191,12 @@ zx_status_t ProcessDispatcher::Create(fbl::RefPtr<JobDispatcher> job, ktl::strin
   if (result != ZX_OK)
     return result;
 
+  if (process_template) {
+    result = process_template->Instantiate(*new_handle.dispatcher()->normal_aspace()->RootVmar());
+    if (result != ZX_OK)
+      return result;
+  }
+
   // Only now that the process has been fully created and initialized can we register it with its
   // parent job. We don't want anyone to see it in a partially initalized state.
   if (!job->AddChildProcess(new_handle.dispatcher())) {
@@ -559,9 +643,14 @@ void ProcessDispatcher::FinishDeadTransition() {
     ASSERT_MSG(result == ZX_OK, "%d\n", result);
   }
 
-  // clean up shareable state, including the handle table
+  // clean up shareable state, including the handle table. The address space may be left to the
+  // teardown threads so that waiters on ZX_TASK_TERMINATED do not wait for it.
   LTRACEF_LEVEL(2, "removing shareable state reference from proc %p\n", this);
-  shareable_state_->DecrementShareCount();
+  const bool defer_aspace = gBootOptions->process_deferred_teardown;
+  if (shareable_state_->DecrementShareCount(!defer_aspace) && defer_aspace &&
+      !QueueDeferredTeardown(shareable_state_)) {
+    shareable_state_->DestroyAspace();
+  }
 
   // signal waiter
   LTRACEF_LEVEL(2, "signaling waiters\n");
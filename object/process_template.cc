@@ -0,0 +1,88 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "object/process_template.h"
+
+#include <lib/counters.h>
+#include <zircon/errors.h>
+
+#include <fbl/alloc_checker.h>
+#include <vm/vm.h>
+#include <vm/vm_address_region.h>
+#include <vm/vm_object.h>
+
+#include <ktl/enforce.h>
+
+KCOUNTER(process_template_create_count, "process_template.create")
+KCOUNTER(process_template_instantiate_count, "process_template.instantiate")
+KCOUNTER(process_template_segments_mapped, "process_template.segments_mapped")
+
+zx_status_t ProcessTemplate::Create(ktl::span<const Segment> segments,
+                                    fbl::RefPtr<ProcessTemplate>* out) {
+  size_t prev_end = 0;
+  for (const Segment& segment : segments) {
+    if (!segment.vmo || segment.size == 0 || !IS_PAGE_ROUNDED(segment.vmo_offset) ||
+        !IS_PAGE_ROUNDED(segment.vmar_offset) || !IS_PAGE_ROUNDED(segment.size)) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+    if ((segment.arch_mmu_flags & ~ARCH_MMU_FLAG_PERM_RWX_MASK) != 0 ||
+        !(segment.arch_mmu_flags & ARCH_MMU_FLAG_PERM_READ)) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+    size_t end;
+    if (add_overflow(segment.vmar_offset, segment.size, &end) || segment.vmar_offset < prev_end) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+    prev_end = end;
+  }
+
+  fbl::AllocChecker ac;
+  fbl::Array<Segment> copy(new (&ac) Segment[segments.size()], segments.size());
+  if (!ac.check()) {
+    return ZX_ERR_NO_MEMORY;
+  }
+  for (size_t i = 0; i < segments.size(); i++) {
+    copy[i] = segments[i];
+  }
+
+  *out = fbl::AdoptRef(new (&ac) ProcessTemplate(ktl::move(copy)));
+  if (!ac.check()) {
+    return ZX_ERR_NO_MEMORY;
+  }
+  process_template_create_count.Add(1);
+  return ZX_OK;
+}
+
+zx_status_t ProcessTemplate::Instantiate(VmAddressRegion& root_vmar) const {
+  process_template_instantiate_count.Add(1);
+
+  for (const Segment& segment : segments_) {
+    fbl::RefPtr<VmObject> vmo = segment.vmo;
+    uint64_t vmo_offset = segment.vmo_offset;
+    if (segment.arch_mmu_flags & ARCH_MMU_FLAG_PERM_WRITE) {
+      // Give the process its own copy on write view, so that writes neither reach the template
+      // nor other processes created from it.
+      fbl::RefPtr<VmObject> child;
+      zx_status_t status = vmo->CreateClone(Resizability::NonResizable, SnapshotType::OnWrite,
+                                            vmo_offset, segment.size, true, &child);
+      if (status != ZX_OK) {
+        return status;
+      }
+      vmo = ktl::move(child);
+      vmo_offset = 0;
+    }
+
+    zx::result<VmAddressRegion::MapResult> result = root_vmar.CreateVmMapping(
+        segment.vmar_offset, segment.size, 0, VMAR_FLAG_SPECIFIC, ktl::move(vmo), vmo_offset,
+        ARCH_MMU_FLAG_PERM_USER | segment.arch_mmu_flags, "template");
+    if (result.is_error()) {
+      return result.status_value();
+    }
+    process_template_segments_mapped.Add(1);
+  }
+
+  return ZX_OK;
+}
@@ -15,6 +15,7 @@
 #include <fbl/alloc_checker.h>
 #include <fbl/ref_ptr.h>
 #include <ktl/bit.h>
+#include <ktl/iterator.h>
 #include <object/thread_dispatcher.h>
 #include <object/vm_address_region_dispatcher.h>
 
@@ -24,13 +25,12 @@ KCOUNTER(dispatcher_profile_create_count, "dispatcher.profile.create")
 KCOUNTER(dispatcher_profile_destroy_count, "dispatcher.profile.destroy")
 
 static zx::result<cpu_mask_t> parse_cpu_mask(const zx_cpu_set_t& set) {
-  // The code below only supports reading up to 1 word in the mask.
-  static_assert(SMP_MAX_CPUS <= sizeof(set.mask[0]) * CHAR_BIT);
-  static_assert(SMP_MAX_CPUS <= sizeof(cpu_mask_t) * CHAR_BIT);
+  static_assert(sizeof(set.mask[0]) == sizeof(CpuMask::Word));
   static_assert(SMP_MAX_CPUS <= ZX_CPU_SET_MAX_CPUS);
 
   // We throw away any bits beyond SMP_MAX_CPUs.
-  return zx::ok(static_cast<cpu_mask_t>(set.mask[0] & BIT_MASK(SMP_MAX_CPUS)));
+  return zx::ok(CpuMask::FromWords(set.mask, ktl::size(set.mask)) &
+                CpuMask::FirstN(SMP_MAX_CPUS));
 }
 
 static zx::result<SchedulerState::BaseProfile> validate_and_create_profile(
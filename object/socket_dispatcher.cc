@@ -17,6 +17,7 @@
 #include <zircon/types.h>
 
 #include <fbl/alloc_checker.h>
+#include <ktl/utility.h>
 #include <object/handle.h>
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
@@ -180,6 +181,30 @@ zx_status_t SocketDispatcher::SetDisposition(Disposition disposition,
   return ZX_OK;
 }
 
+zx_status_t SocketDispatcher::CheckWritableLocked(size_t len) const {
+  if (peer() == nullptr)
+    return ZX_ERR_PEER_CLOSED;
+  zx_signals_t signals = GetSignalsStateLocked();
+  if (signals & ZX_SOCKET_WRITE_DISABLED)
+    return ZX_ERR_BAD_STATE;
+  if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
+    return ZX_ERR_INVALID_ARGS;
+  return ZX_OK;
+}
+
+zx_status_t SocketDispatcher::CheckReadableLocked() const {
+  if (is_empty()) {
+    if (peer() == nullptr)
+      return ZX_ERR_PEER_CLOSED;
+    // If reading is disabled on our end and we're empty, we'll never become readable again.
+    // Return a different error to let the caller know.
+    if (read_disabled_)
+      return ZX_ERR_BAD_STATE;
+    return ZX_ERR_SHOULD_WAIT;
+  }
+  return ZX_OK;
+}
+
 zx_status_t SocketDispatcher::Write(user_in_ptr<const char> src, size_t len, size_t* nwritten) {
   canary_.Assert();
 
@@ -187,25 +212,58 @@ zx_status_t SocketDispatcher::Write(user_in_ptr<const char> src, size_t len, siz
 
   Guard<CriticalMutex> guard{get_lock()};
 
-  if (peer() == nullptr)
-    return ZX_ERR_PEER_CLOSED;
-  zx_signals_t signals = GetSignalsStateLocked();
-  if (signals & ZX_SOCKET_WRITE_DISABLED)
-    return ZX_ERR_BAD_STATE;
+  zx_status_t status = CheckWritableLocked(len);
+  if (status != ZX_OK)
+    return status;
 
   if (len == 0) {
     *nwritten = 0;
     return ZX_OK;
   }
-  if (len != static_cast<size_t>(static_cast<uint32_t>(len)))
-    return ZX_ERR_INVALID_ARGS;
 
+  const bool datagram = flags_ & ZX_SOCKET_DATAGRAM;
   AssertHeld(*peer()->get_lock());
-  return peer()->WriteSelfLocked(src, len, nwritten, guard);
+  return peer()->WriteSelfLocked(
+      [&](MBufChain& data, size_t* st) {
+        return datagram ? data.WriteDatagram(src, len, st) : data.WriteStream(src, len, st);
+      },
+      nwritten, guard);
 }
 
-zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const char> src, size_t len,
-                                              size_t* written, Guard<CriticalMutex>& guard) {
+zx_status_t SocketDispatcher::WriteVector(user_in_iovec_t src, size_t* nwritten) {
+  canary_.Assert();
+
+  LTRACE_ENTRY;
+
+  // Size the vector before taking the lock, as this reads it from user memory.
+  size_t len;
+  zx_status_t status = src.GetTotalCapacity(&len);
+  if (status != ZX_OK)
+    return status;
+
+  Guard<CriticalMutex> guard{get_lock()};
+
+  status = CheckWritableLocked(len);
+  if (status != ZX_OK)
+    return status;
+
+  if (len == 0) {
+    *nwritten = 0;
+    return ZX_OK;
+  }
+
+  const bool datagram = flags_ & ZX_SOCKET_DATAGRAM;
+  AssertHeld(*peer()->get_lock());
+  return peer()->WriteSelfLocked(
+      [&](MBufChain& data, size_t* st) {
+        return datagram ? data.WriteDatagram(src, st) : data.WriteStream(src, st);
+      },
+      nwritten, guard);
+}
+
+template <typename WriteFn>
+zx_status_t SocketDispatcher::WriteSelfLocked(WriteFn write, size_t* written,
+                                              Guard<CriticalMutex>& guard) {
   canary_.Assert();
 
   if (is_full())
@@ -223,19 +281,23 @@ zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const char> src, size_
   // lockdep detections that might involve this lock for the duration of the operation..
   guard.CallUntracked([&] {
     AssertHeld(*get_lock());
-    if (flags_ & ZX_SOCKET_DATAGRAM) {
-      status = data_.WriteDatagram(src, len, &st);
-    } else {
-      status = data_.WriteStream(src, len, &st);
-    }
+    status = write(data_, &st);
   });
 
   // Regardless of the status, data may have been added, and so we need to update the signals.
+  UpdateSignalsForWriteLocked(was_empty, st);
 
+  if (status == ZX_OK) {
+    *written = st;
+  }
+  return status;
+}
+
+void SocketDispatcher::UpdateSignalsForWriteLocked(bool was_empty, size_t written) {
   zx_signals_t clear = 0u;
   zx_signals_t set = 0u;
 
-  if (st > 0) {
+  if (written > 0) {
     if (was_empty)
       set |= ZX_SOCKET_READABLE;
     // Assert signal if we go above the read threshold
@@ -259,11 +321,6 @@ zx_status_t SocketDispatcher::WriteSelfLocked(user_in_ptr<const char> src, size_
     AssertHeld(*peer()->get_lock());
     peer()->UpdateStateLocked(clear, 0u);
   }
-
-  if (status == ZX_OK) {
-    *written = st;
-  }
-  return status;
 }
 
 zx_status_t SocketDispatcher::Read(ReadType type, user_out_ptr<char> dst, size_t len,
@@ -277,23 +334,46 @@ zx_status_t SocketDispatcher::Read(ReadType type, user_out_ptr<char> dst, size_t
   if (len != (size_t)((uint32_t)len))
     return ZX_ERR_INVALID_ARGS;
 
-  if (is_empty()) {
-    if (peer() == nullptr)
-      return ZX_ERR_PEER_CLOSED;
-    // If reading is disabled on our end and we're empty, we'll never become readable again.
-    // Return a different error to let the caller know.
-    if (read_disabled_)
-      return ZX_ERR_BAD_STATE;
-    return ZX_ERR_SHOULD_WAIT;
-  }
+  const bool datagram = flags_ & ZX_SOCKET_DATAGRAM;
+  return ReadSelfLocked(
+      type,
+      [&](MBufChain& data, size_t* actual) {
+        return type == ReadType::kPeek ? data.Peek(dst, len, datagram, actual)
+                                       : data.Read(dst, len, datagram, actual);
+      },
+      nread, guard);
+}
+
+zx_status_t SocketDispatcher::ReadVector(ReadType type, user_out_iovec_t dst, size_t* nread) {
+  canary_.Assert();
+
+  LTRACE_ENTRY;
+
+  Guard<CriticalMutex> guard{get_lock()};
+
+  const bool datagram = flags_ & ZX_SOCKET_DATAGRAM;
+  return ReadSelfLocked(
+      type,
+      [&](MBufChain& data, size_t* actual) {
+        return type == ReadType::kPeek ? data.Peek(dst, datagram, actual)
+                                       : data.Read(dst, datagram, actual);
+      },
+      nread, guard);
+}
+
+template <typename ReadFn>
+zx_status_t SocketDispatcher::ReadSelfLocked(ReadType type, ReadFn read, size_t* nread,
+                                             Guard<CriticalMutex>& guard) {
+  zx_status_t status = CheckReadableLocked();
+  if (status != ZX_OK)
+    return status;
 
   size_t actual = 0;
   if (type == ReadType::kPeek) {
-    zx_status_t status = ZX_OK;
     // TODO(https://fxbug.dev/42182048): See comment in WriteSelfLocked on why we use CallUntracked.
     guard.CallUntracked([&] {
       AssertHeld(*get_lock());
-      status = data_.Peek(dst, len, flags_ & ZX_SOCKET_DATAGRAM, &actual);
+      status = read(data_, &actual);
     });
     if (status != ZX_OK) {
       return status;
@@ -301,41 +381,13 @@ zx_status_t SocketDispatcher::Read(ReadType type, user_out_ptr<char> dst, size_t
   } else {
     bool was_full = is_full();
 
-    zx_status_t status = ZX_OK;
     // TODO(https://fxbug.dev/42182048): See comment in WriteSelfLocked on why we use CallUntracked.
     guard.CallUntracked([&] {
       AssertHeld(*get_lock());
-      status = data_.Read(dst, len, flags_ & ZX_SOCKET_DATAGRAM, &actual);
+      status = read(data_, &actual);
     });
     // Regardless of the status, data may have been consumed, and so we need to update the signals.
-
-    zx_signals_t clear = 0u;
-    zx_signals_t set = 0u;
-
-    // Deassert signal if we fell below the read threshold
-    if ((read_threshold_ > 0) && (data_.size() < read_threshold_))
-      clear |= ZX_SOCKET_READ_THRESHOLD;
-
-    if (is_empty()) {
-      clear |= ZX_SOCKET_READABLE;
-    }
-    if (set || clear) {
-      UpdateStateLocked(clear, set);
-      clear = set = 0u;
-    }
-    if (peer()) {
-      // Assert (write threshold) signal if space available is above
-      // threshold.
-      size_t peer_write_threshold = peer()->write_threshold_;
-      if (peer_write_threshold > 0 && ((data_.max_size() - data_.size()) >= peer_write_threshold))
-        set |= ZX_SOCKET_WRITE_THRESHOLD;
-      if (was_full && (actual > 0))
-        set |= ZX_SOCKET_WRITABLE;
-      if (set) {
-        AssertHeld(*peer()->get_lock());
-        peer()->UpdateStateLocked(0u, set);
-      }
-    }
+    UpdateSignalsForReadLocked(was_full, actual);
     if (status != ZX_OK) {
       return status;
     }
@@ -345,6 +397,104 @@ zx_status_t SocketDispatcher::Read(ReadType type, user_out_ptr<char> dst, size_t
   return ZX_OK;
 }
 
+void SocketDispatcher::UpdateSignalsForReadLocked(bool was_full, size_t nread) {
+  zx_signals_t clear = 0u;
+  zx_signals_t set = 0u;
+
+  // Deassert signal if we fell below the read threshold
+  if ((read_threshold_ > 0) && (data_.size() < read_threshold_))
+    clear |= ZX_SOCKET_READ_THRESHOLD;
+
+  if (is_empty()) {
+    clear |= ZX_SOCKET_READABLE;
+  }
+  if (set || clear) {
+    UpdateStateLocked(clear, set);
+    clear = set = 0u;
+  }
+  if (peer()) {
+    // Assert (write threshold) signal if space available is above
+    // threshold.
+    size_t peer_write_threshold = peer()->write_threshold_;
+    if (peer_write_threshold > 0 && ((data_.max_size() - data_.size()) >= peer_write_threshold))
+      set |= ZX_SOCKET_WRITE_THRESHOLD;
+    if (was_full && (nread > 0))
+      set |= ZX_SOCKET_WRITABLE;
+    if (set) {
+      AssertHeld(*peer()->get_lock());
+      peer()->UpdateStateLocked(0u, set);
+    }
+  }
+}
+
+zx_status_t SocketDispatcher::Splice(SocketDispatcher* dst, size_t len, size_t* moved) {
+  canary_.Assert();
+
+  LTRACE_ENTRY;
+
+  if ((flags_ & ZX_SOCKET_DATAGRAM) != (dst->flags_ & ZX_SOCKET_DATAGRAM))
+    return ZX_ERR_INVALID_ARGS;
+
+  if (get_lock() == dst->get_lock()) {
+    // |dst| is this socket or its peer.
+    Guard<CriticalMutex> guard{get_lock()};
+    AssertHeld(*dst->get_lock());
+    return SpliceLocked(dst, len, moved);
+  }
+
+  // The sockets are otherwise unrelated, so take their locks in koid order.
+  SocketDispatcher* first = this;
+  SocketDispatcher* second = dst;
+  if (first->get_koid() > second->get_koid()) {
+    ktl::swap(first, second);
+  }
+  Guard<CriticalMutex> first_guard{AssertOrderedLock, first->get_lock(), 0};
+  Guard<CriticalMutex> second_guard{AssertOrderedLock, second->get_lock(), 1};
+  AssertHeld(*get_lock());
+  AssertHeld(*dst->get_lock());
+  return SpliceLocked(dst, len, moved);
+}
+
+zx_status_t SocketDispatcher::SpliceLocked(SocketDispatcher* dst, size_t len, size_t* moved) {
+  zx_status_t status = dst->CheckWritableLocked(len);
+  if (status != ZX_OK)
+    return status;
+
+  // Data read from this socket is written to the chain of the peer of |dst|.
+  SocketDispatcher* sink = dst->peer();
+  if (sink == this)
+    return ZX_ERR_INVALID_ARGS;
+
+  status = CheckReadableLocked();
+  if (status != ZX_OK)
+    return status;
+
+  if (len == 0) {
+    *moved = 0;
+    return ZX_OK;
+  }
+
+  const bool datagram = flags_ & ZX_SOCKET_DATAGRAM;
+  if (datagram && data_.size(datagram) > len)
+    return ZX_ERR_BUFFER_TOO_SMALL;
+
+  AssertHeld(*sink->get_lock());
+  if (sink->is_full())
+    return ZX_ERR_SHOULD_WAIT;
+
+  const bool was_full = is_full();
+  const bool sink_was_empty = sink->is_empty();
+  const size_t actual = sink->data_.Splice(&data_, len, datagram);
+  if (actual == 0)
+    return ZX_ERR_SHOULD_WAIT;
+
+  sink->UpdateSignalsForWriteLocked(sink_was_empty, actual);
+  UpdateSignalsForReadLocked(was_full, actual);
+
+  *moved = actual;
+  return ZX_OK;
+}
+
 zx_info_socket_t SocketDispatcher::GetInfo() const {
   canary_.Assert();
   Guard<CriticalMutex> guard{get_lock()};
@@ -0,0 +1,91 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+
+#include <object/channel_dispatcher.h>
+#include <object/message_packet.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+// Creates a message whose payload is |size| bytes of |fill|.
+zx_status_t CreateMessage(char fill, uint32_t size, MessagePacketPtr* msg) {
+  char data[64];
+  DEBUG_ASSERT(size <= sizeof(data));
+  memset(data, fill, size);
+  return MessagePacket::Create(data, size, 0, msg);
+}
+
+// Write a batch of messages and read them back in one or more batches.
+bool TestWriteManyReadMany() {
+  BEGIN_TEST;
+
+  KernelHandle<ChannelDispatcher> handle0, handle1;
+  zx_rights_t rights;
+  ASSERT_EQ(ZX_OK, ChannelDispatcher::Create(&handle0, &handle1, &rights));
+  ChannelDispatcher* writer = handle0.dispatcher().get();
+  ChannelDispatcher* reader = handle1.dispatcher().get();
+
+  constexpr size_t kNumMsgs = 4;
+  constexpr uint32_t kMsgSize = 32;
+  MessagePacketPtr msgs[kNumMsgs];
+  for (size_t i = 0; i < kNumMsgs; i++) {
+    ASSERT_EQ(ZX_OK, CreateMessage(static_cast<char>('A' + i), kMsgSize, &msgs[i]));
+  }
+  EXPECT_EQ(0u, reader->PollSignals() & ZX_CHANNEL_READABLE);
+  ASSERT_EQ(ZX_OK, writer->WriteMany(ZX_KOID_INVALID, ktl::span(msgs)));
+  for (const MessagePacketPtr& msg : msgs) {
+    EXPECT_FALSE(msg);
+  }
+  EXPECT_EQ(ZX_CHANNEL_READABLE, reader->PollSignals() & ZX_CHANNEL_READABLE);
+  EXPECT_EQ(kNumMsgs, reader->get_message_counts().current);
+
+  // A budget too small for the first message reports its size and leaves it queued.
+  MessagePacketPtr out[kNumMsgs];
+  uint32_t total_size = kMsgSize - 1;
+  uint32_t total_handles = 0;
+  size_t num_msgs = 0;
+  EXPECT_EQ(ZX_ERR_BUFFER_TOO_SMALL, reader->ReadMany(ZX_KOID_INVALID, &total_size,
+                                                      &total_handles, ktl::span(out), &num_msgs));
+  EXPECT_EQ(kMsgSize, total_size);
+  EXPECT_EQ(kNumMsgs, reader->get_message_counts().current);
+
+  // A budget for three messages stops the batch early.
+  total_size = kMsgSize * 3 + kMsgSize / 2;
+  total_handles = 0;
+  ASSERT_EQ(ZX_OK, reader->ReadMany(ZX_KOID_INVALID, &total_size, &total_handles, ktl::span(out),
+                                    &num_msgs));
+  EXPECT_EQ(3u, num_msgs);
+  EXPECT_EQ(kMsgSize * 3, total_size);
+  EXPECT_EQ(0u, total_handles);
+  for (size_t i = 0; i < num_msgs; i++) {
+    ASSERT_TRUE(out[i]);
+    EXPECT_EQ(static_cast<zx_txid_t>(0x01010101u * ('A' + i)), out[i]->get_txid());
+  }
+  EXPECT_EQ(ZX_CHANNEL_READABLE, reader->PollSignals() & ZX_CHANNEL_READABLE);
+
+  // The remaining message drains the queue and clears READABLE.
+  MessagePacketPtr last[kNumMsgs];
+  total_size = kMsgSize * kNumMsgs;
+  ASSERT_EQ(ZX_OK, reader->ReadMany(ZX_KOID_INVALID, &total_size, &total_handles, ktl::span(last),
+                                    &num_msgs));
+  EXPECT_EQ(1u, num_msgs);
+  EXPECT_EQ(static_cast<zx_txid_t>(0x01010101u * 'D'), last[0]->get_txid());
+  EXPECT_EQ(0u, reader->PollSignals() & ZX_CHANNEL_READABLE);
+  EXPECT_EQ(ZX_ERR_SHOULD_WAIT, reader->ReadMany(ZX_KOID_INVALID, &total_size, &total_handles,
+                                                 ktl::span(last), &num_msgs));
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(channel_dispatcher_tests)
+UNITTEST("TestWriteManyReadMany", TestWriteManyReadMany)
+UNITTEST_END_TESTCASE(channel_dispatcher_tests, "channel_dispatcher_tests",
+                      "ChannelDispatcher tests")
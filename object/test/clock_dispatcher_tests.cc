@@ -0,0 +1,70 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+#include <zircon/rights.h>
+#include <zircon/syscalls/clock.h>
+
+#include <object/clock_dispatcher.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+// Starts |clock| at |value| and checks that it reads back at or after it.
+bool StartAndRead(ClockDispatcher& clock, zx_time_t value) {
+  BEGIN_TEST;
+
+  zx_clock_update_args_v2_t args{};
+  args.synthetic_value = value;
+  ASSERT_OK(clock.Update(ZX_CLOCK_UPDATE_OPTION_SYNTHETIC_VALUE_VALID, args));
+
+  zx_time_t now;
+  ASSERT_OK(clock.Read(&now));
+  EXPECT_GE(now, value);
+
+  END_TEST;
+}
+
+// Clocks only get a page to share their state through, and the right to map it, when asked to.
+bool TestClockNotMappableByDefault() {
+  BEGIN_TEST;
+
+  KernelHandle<ClockDispatcher> handle;
+  zx_rights_t rights;
+  ASSERT_OK(ClockDispatcher::Create(0, zx_clock_create_args_v1_t{}, &handle, &rights));
+
+  EXPECT_EQ(0u, rights & ZX_RIGHT_MAP);
+  EXPECT_FALSE(handle.dispatcher()->is_mappable());
+  EXPECT_NULL(handle.dispatcher()->vmo());
+  EXPECT_TRUE(StartAndRead(*handle.dispatcher(), ZX_SEC(1000)));
+
+  END_TEST;
+}
+
+bool TestClockMappableOnRequest() {
+  BEGIN_TEST;
+
+  KernelHandle<ClockDispatcher> handle;
+  zx_rights_t rights;
+  ASSERT_OK(ClockDispatcher::Create(ZX_CLOCK_OPT_MAPPABLE, zx_clock_create_args_v1_t{}, &handle,
+                                    &rights));
+
+  EXPECT_EQ(ZX_RIGHT_MAP, rights & ZX_RIGHT_MAP);
+  EXPECT_TRUE(handle.dispatcher()->is_mappable());
+  ASSERT_NONNULL(handle.dispatcher()->vmo());
+  EXPECT_EQ(ClockDispatcher::kMappedSize, handle.dispatcher()->vmo()->size());
+  EXPECT_TRUE(StartAndRead(*handle.dispatcher(), ZX_SEC(1000)));
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(clock_dispatcher_tests)
+UNITTEST("ClockNotMappableByDefault", TestClockNotMappableByDefault)
+UNITTEST("ClockMappableOnRequest", TestClockMappableOnRequest)
+UNITTEST_END_TESTCASE(clock_dispatcher_tests, "clock_dispatcher", "ClockDispatcher tests")
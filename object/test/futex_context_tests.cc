@@ -0,0 +1,127 @@
+// Copyright 2026 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+#include <lib/unittest/user_memory.h>
+
+#include <kernel/thread.h>
+#include <ktl/atomic.h>
+#include <object/futex_context.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+using testing::UserMemory;
+
+constexpr size_t kNumFutexes = 3;
+
+// Waiting on no futexes, or on more than the limit, is rejected before anything is checked.
+bool TestWaitMultipleInvalidArgs() {
+  BEGIN_TEST;
+
+  FutexContext context;
+  ASSERT_OK(context.Init(FutexContext::ProcessType::Regular));
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(PAGE_SIZE);
+  ASSERT_NONNULL(mem);
+
+  FutexContext::WaitEntry entries[FutexContext::kMaxWaitEntries + 1];
+  for (size_t i = 0; i < FutexContext::kMaxWaitEntries + 1; i++) {
+    entries[i] = {mem->user_in<zx_futex_t>().element_offset(i), 0};
+  }
+  size_t woken_index = 0;
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+            context.FutexWaitMultiple({}, Deadline::infinite_past(), &woken_index));
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+            context.FutexWaitMultiple(entries, Deadline::infinite_past(), &woken_index));
+
+  END_TEST;
+}
+
+// A mismatched value on any of the futexes fails the wait without blocking, and a wait whose
+// deadline has passed times out once every value has been checked.
+bool TestWaitMultipleValueCheck() {
+  BEGIN_TEST;
+
+  FutexContext context;
+  ASSERT_OK(context.Init(FutexContext::ProcessType::Regular));
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(PAGE_SIZE);
+  ASSERT_NONNULL(mem);
+
+  FutexContext::WaitEntry entries[kNumFutexes];
+  for (size_t i = 0; i < kNumFutexes; i++) {
+    mem->put<zx_futex_t>(static_cast<zx_futex_t>(i), i);
+    entries[i] = {mem->user_in<zx_futex_t>().element_offset(i), static_cast<zx_futex_t>(i)};
+  }
+
+  size_t woken_index = kNumFutexes;
+  entries[kNumFutexes - 1].current_value++;
+  EXPECT_EQ(ZX_ERR_BAD_STATE,
+            context.FutexWaitMultiple(entries, Deadline::infinite_past(), &woken_index));
+  EXPECT_EQ(kNumFutexes, woken_index);
+
+  entries[kNumFutexes - 1].current_value--;
+  EXPECT_EQ(ZX_ERR_TIMED_OUT,
+            context.FutexWaitMultiple(entries, Deadline::infinite_past(), &woken_index));
+  EXPECT_EQ(kNumFutexes, woken_index);
+
+  END_TEST;
+}
+
+// A wake of any one of the futexes ends the wait and reports which futex it was.
+bool TestWaitMultipleWake() {
+  BEGIN_TEST;
+
+  FutexContext context;
+  ASSERT_OK(context.Init(FutexContext::ProcessType::Regular));
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(PAGE_SIZE);
+  ASSERT_NONNULL(mem);
+
+  FutexContext::WaitEntry entries[kNumFutexes];
+  for (size_t i = 0; i < kNumFutexes; i++) {
+    mem->put<zx_futex_t>(0, i);
+    entries[i] = {mem->user_in<zx_futex_t>().element_offset(i), 0};
+  }
+
+  // Waking only takes the address of the futex, so the waker does not need to be able to access
+  // the user memory. Keep waking until the waiter is done, as it may not have queued itself yet.
+  constexpr size_t kWokenIndex = 1;
+  struct WakerState {
+    FutexContext* context;
+    user_in_ptr<const zx_futex_t> value_ptr;
+    ktl::atomic<bool> done{false};
+  } state{&context, entries[kWokenIndex].value_ptr};
+  Thread* waker = Thread::Create(
+      "futex waker",
+      [](void* arg) -> int {
+        WakerState* state = static_cast<WakerState*>(arg);
+        while (!state->done.load()) {
+          state->context->FutexWake(state->value_ptr, 1, FutexContext::OwnerAction::RELEASE);
+          Thread::Current::SleepRelative(ZX_MSEC(1));
+        }
+        return 0;
+      },
+      &state, DEFAULT_PRIORITY);
+  ASSERT_NONNULL(waker);
+  waker->Resume();
+
+  size_t woken_index = kNumFutexes;
+  EXPECT_OK(context.FutexWaitMultiple(entries, Deadline::infinite(), &woken_index));
+  EXPECT_EQ(kWokenIndex, woken_index);
+
+  state.done.store(true);
+  EXPECT_OK(waker->Join(nullptr, ZX_TIME_INFINITE));
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(futex_context_tests)
+UNITTEST("TestWaitMultipleInvalidArgs", TestWaitMultipleInvalidArgs)
+UNITTEST("TestWaitMultipleValueCheck", TestWaitMultipleValueCheck)
+UNITTEST("TestWaitMultipleWake", TestWaitMultipleWake)
+UNITTEST_END_TESTCASE(futex_context_tests, "futex_context_tests", "FutexContext tests")
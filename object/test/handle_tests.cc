@@ -8,9 +8,11 @@
 
 #include <fbl/alloc_checker.h>
 #include <fbl/ref_ptr.h>
+#include <kernel/rcu.h>
 #include <ktl/utility.h>
 #include <object/dispatcher.h>
 #include <object/event_pair_dispatcher.h>
+#include <object/handle_table.h>
 
 #include "fake_dispatcher.h"
 #include "object/handle.h"
@@ -206,6 +208,138 @@ bool KernelHandleUpgrade() {
   END_TEST;
 }
 
+class DestructionTrackingDispatcher final
+    : public SoloDispatcher<DestructionTrackingDispatcher, ZX_RIGHTS_BASIC> {
+ public:
+  explicit DestructionTrackingDispatcher(bool* destroyed) : destroyed_(destroyed) {}
+  ~DestructionTrackingDispatcher() final { *destroyed_ = true; }
+  zx_obj_type_t get_type() const final { return ZX_OBJ_TYPE_NONE; }
+
+ private:
+  bool* const destroyed_;
+};
+
+// Closing the last handle to a dispatcher releases it on the closing thread, even though the
+// handle's arena slot is only returned after an RCU grace period.
+bool HandleDeleteReleasesDispatcher() {
+  BEGIN_TEST;
+
+  KernelHandle<EventPairDispatcher> eventpair[2];
+  zx_rights_t rights;
+  ASSERT_EQ(EventPairDispatcher::Create(&eventpair[0], &eventpair[1], &rights), ZX_OK);
+  fbl::RefPtr<EventPairDispatcher> dispatcher = eventpair[0].dispatcher();
+  {
+    HandleOwner handle_owner = Handle::Make(ktl::move(eventpair[0]), rights);
+    ASSERT_TRUE(handle_owner);
+    EXPECT_EQ(1u, Handle::Count(*dispatcher));
+  }
+  EXPECT_EQ(0u, Handle::Count(*dispatcher));
+  EXPECT_EQ(eventpair[1].dispatcher()->user_signal_peer(0, ZX_USER_SIGNAL_0), ZX_ERR_PEER_CLOSED);
+
+  bool destroyed = false;
+  fbl::AllocChecker ac;
+  fbl::RefPtr<DestructionTrackingDispatcher> tracked =
+      fbl::AdoptRef(new (&ac) DestructionTrackingDispatcher(&destroyed));
+  ASSERT_TRUE(ac.check());
+  HandleOwner handle_owner =
+      Handle::Make(ktl::move(tracked), DestructionTrackingDispatcher::default_rights());
+  ASSERT_TRUE(handle_owner);
+  EXPECT_FALSE(destroyed);
+  handle_owner.reset();
+  EXPECT_TRUE(destroyed);
+
+  // Let the deferred return of the slots run.
+  rcu::Barrier();
+
+  END_TEST;
+}
+
+bool HandleTableAddHandles() {
+  BEGIN_TEST;
+
+  constexpr uint32_t kCount = 4;
+  fbl::RefPtr<FakeDispatcher> dispatchers[kCount];
+  Handle* handles[kCount];
+  for (size_t i = 0; i < kCount; ++i) {
+    dispatchers[i] = FakeDispatcher::Create();
+    handles[i] = Handle::Make(KernelHandle<Dispatcher>(dispatchers[i]), ZX_RIGHT_NONE).release();
+    ASSERT_NONNULL(handles[i]);
+  }
+
+  HandleTable table;
+  table.AddHandles(ktl::span(handles, kCount));
+  EXPECT_EQ(kCount, table.HandleCount());
+
+  // Every handle now belongs to the table, and is closed along with it.
+  uint32_t found = 0;
+  table.ForEachHandle([&](zx_handle_t, zx_rights_t, const Dispatcher* dispatcher) {
+    for (const auto& expected : dispatchers) {
+      if (dispatcher == expected.get()) {
+        found++;
+      }
+    }
+    return ZX_OK;
+  });
+  EXPECT_EQ(kCount, found);
+
+  table.Clean();
+  EXPECT_EQ(0u, table.HandleCount());
+  for (const auto& dispatcher : dispatchers) {
+    EXPECT_EQ(1, dispatcher->on_zero_handles_calls());
+  }
+
+  END_TEST;
+}
+
+// Only limits beyond what the default layout can index widen the index field.
+bool HandleValueLayoutForCount() {
+  BEGIN_TEST;
+
+  constexpr size_t kDefaultLimit = size_t{1} << HandleValueLayout::kDefaultIndexBits;
+  EXPECT_EQ(HandleValueLayout::kDefaultIndexBits, HandleValueLayout::ForCount(1).index_bits());
+  EXPECT_EQ(HandleValueLayout::kDefaultIndexBits,
+            HandleValueLayout::ForCount(kDefaultLimit).index_bits());
+  EXPECT_EQ(HandleValueLayout::kDefaultIndexBits + 1,
+            HandleValueLayout::ForCount(kDefaultLimit + 1).index_bits());
+  constexpr size_t kMaxLimit = size_t{1} << HandleValueLayout::kMaxIndexBits;
+  EXPECT_EQ(HandleValueLayout::kMaxIndexBits, HandleValueLayout::ForCount(kMaxLimit).index_bits());
+  EXPECT_EQ(HandleValueLayout::kMaxIndexBits, HandleValueLayout::ForCount(SIZE_MAX).index_bits());
+
+  // Each extra index bit costs a generation bit.
+  EXPECT_EQ(4096u, HandleValueLayout::ForCount(kDefaultLimit).generation_count());
+  EXPECT_EQ(1024u, HandleValueLayout::ForCount(SIZE_MAX).generation_count());
+
+  END_TEST;
+}
+
+// A slot's values go through every generation, keeping the index and the reserved bits clear,
+// before repeating.
+bool HandleValueLayoutGenerationWraparound() {
+  BEGIN_TEST;
+
+  for (uint32_t index_bits = HandleValueLayout::kDefaultIndexBits;
+       index_bits <= HandleValueLayout::kMaxIndexBits; index_bits++) {
+    const HandleValueLayout layout(index_bits);
+    const uint32_t index = layout.index_mask() - 1;
+
+    const uint32_t first = layout.NewValue(index, 0);
+    uint32_t value = first;
+    for (uint32_t generation = 2; generation < layout.generation_count(); generation++) {
+      value = layout.NewValue(index, value);
+      ASSERT_EQ(index, layout.ValueToIndex(value));
+      ASSERT_EQ(0u, value >> (32 - kHandleReservedBits));
+      ASSERT_NE(first, value);
+    }
+
+    // The generation wraps around to zero, after which values repeat.
+    value = layout.NewValue(index, value);
+    EXPECT_EQ(index, value);
+    EXPECT_EQ(first, layout.NewValue(index, value));
+  }
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(handle_tests)
@@ -220,4 +354,8 @@ UNITTEST("KernelHandleMoveConstructorUpcast", KernelHandleMoveConstructorUpcast)
 UNITTEST("KernelHandleMoveAssignment", KernelHandleMoveAssignment)
 UNITTEST("KernelHandleMoveAssignmentUpcast", KernelHandleMoveAssignmentUpcast)
 UNITTEST("KernelHandleUpgrade", KernelHandleUpgrade)
+UNITTEST("HandleDeleteReleasesDispatcher", HandleDeleteReleasesDispatcher)
+UNITTEST("HandleTableAddHandles", HandleTableAddHandles)
+UNITTEST("HandleValueLayoutForCount", HandleValueLayoutForCount)
+UNITTEST("HandleValueLayoutGenerationWraparound", HandleValueLayoutGenerationWraparound)
 UNITTEST_END_TESTCASE(handle_tests, "handle", "Handle test")
@@ -15,6 +15,7 @@
 #include <zircon/syscalls-next.h>
 
 #include <kernel/idle_power_thread.h>
+#include <kernel/mp.h>
 #include <ktl/atomic.h>
 #include <object/interrupt_dispatcher.h>
 #include <object/interrupt_event_dispatcher.h>
@@ -164,10 +165,104 @@ bool TestPendingWakeEventBlocksSuspend() {
   END_TEST;
 }
 
+// Tests that IRQs within a coalescing window are delivered as a single port packet.
+bool TestCoalescedPortPacket() {
+  BEGIN_TEST;
+
+  // Generating the interrupt events for this test is necessarily arch specific and is only
+  // implemented for x86 here.
+#if ARCH_X86
+  KernelHandle<InterruptDispatcher> interrupt;
+  zx_rights_t rights;
+
+  uint32_t gsi;
+  constexpr uint32_t gsi_search_max = 24;
+  for (gsi = 0; gsi < gsi_search_max; gsi++) {
+    zx_status_t status =
+        InterruptEventDispatcher::Create(&interrupt, &rights, gsi, ZX_INTERRUPT_MODE_EDGE_HIGH);
+    if (status == ZX_OK) {
+      break;
+    }
+  }
+  ASSERT_NE(gsi, gsi_search_max, "Failed to find free global interrupt");
+
+  KernelHandle<PortDispatcher> port;
+  ASSERT_EQ(ZX_OK, PortDispatcher::Create(ZX_PORT_BIND_TO_INTERRUPT, &port, &rights));
+  constexpr uint64_t kKey = 0x1234;
+  ASSERT_EQ(ZX_OK, interrupt.dispatcher()->Bind(port.dispatcher(), kKey));
+  ASSERT_EQ(ZX_OK, interrupt.dispatcher()->SetCoalescing(ZX_MSEC(5)));
+  EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, interrupt.dispatcher()->SetCoalescing(ZX_SEC(1)));
+
+  // Self IPIs are taken before the next instruction, so all three land within the window.
+  const uint8_t vector = apic_io_fetch_irq_vector(gsi);
+  const zx_instant_boot_t before = current_boot_time();
+  for (int i = 0; i < 3; i++) {
+    apic_send_self_ipi(vector, DELIVERY_MODE_FIXED);
+  }
+
+  zx_port_packet_t packet;
+  ASSERT_EQ(ZX_OK, port.dispatcher()->Dequeue(Deadline::infinite(), &packet));
+  EXPECT_EQ(kKey, packet.key);
+  EXPECT_EQ(static_cast<uint32_t>(ZX_PKT_TYPE_INTERRUPT), packet.type);
+  EXPECT_EQ(3u, packet.interrupt.reserved0);
+  EXPECT_GE(packet.interrupt.timestamp, before);
+  EXPECT_GE(static_cast<zx_instant_boot_t>(packet.interrupt.reserved1),
+            packet.interrupt.timestamp);
+
+  // Nothing more is queued until the packet is acked.
+  EXPECT_EQ(ZX_ERR_TIMED_OUT, port.dispatcher()->Dequeue(Deadline::after_mono(ZX_MSEC(10)),
+                                                          &packet));
+  EXPECT_EQ(ZX_OK, interrupt.dispatcher()->Ack());
+#endif
+
+  END_TEST;
+}
+
+// Tests that interrupts can be routed to any online CPU, and only to online CPUs.
+bool TestSetAffinity() {
+  BEGIN_TEST;
+
+  // Only the x86 IOAPIC implements routing for event interrupts here.
+#if ARCH_X86
+  KernelHandle<InterruptDispatcher> interrupt;
+  zx_rights_t rights;
+
+  uint32_t gsi;
+  constexpr uint32_t gsi_search_max = 24;
+  for (gsi = 0; gsi < gsi_search_max; gsi++) {
+    zx_status_t status =
+        InterruptEventDispatcher::Create(&interrupt, &rights, gsi, ZX_INTERRUPT_MODE_EDGE_HIGH);
+    if (status == ZX_OK) {
+      break;
+    }
+  }
+  ASSERT_NE(gsi, gsi_search_max, "Failed to find free global interrupt");
+
+  const cpu_mask_t online = mp_get_online_mask();
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS, interrupt.dispatcher()->SetAffinity(cpu_mask_t{}));
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+            interrupt.dispatcher()->SetAffinity(CPU_MASK_ALL & ~online));
+  EXPECT_EQ(ZX_OK, interrupt.dispatcher()->SetAffinity(cpu_num_to_mask(online.highest())));
+  EXPECT_EQ(ZX_OK, interrupt.dispatcher()->SetAffinity(cpu_num_to_mask(BOOT_CPU_ID)));
+
+  EXPECT_EQ(ZX_OK, interrupt.dispatcher()->SetFollowConsumer(true));
+  EXPECT_EQ(ZX_OK, interrupt.dispatcher()->SetFollowConsumer(false));
+
+  // Nothing can be routed once the interrupt is destroyed.
+  ASSERT_EQ(ZX_OK, interrupt.dispatcher()->Destroy());
+  EXPECT_EQ(ZX_ERR_CANCELED, interrupt.dispatcher()->SetAffinity(online));
+  EXPECT_EQ(ZX_ERR_CANCELED, interrupt.dispatcher()->SetFollowConsumer(true));
+#endif
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(interrupt_event_dispatcher_tests)
 UNITTEST("ConcurrentIntEventDispatcherTeardown", TestConcurrentIntEventDispatcherTeardown)
 UNITTEST("PendingWakeEventBlocksSuspend", TestPendingWakeEventBlocksSuspend)
+UNITTEST("CoalescedPortPacket", TestCoalescedPortPacket)
+UNITTEST("SetAffinity", TestSetAffinity)
 UNITTEST_END_TESTCASE(interrupt_event_dispatcher_tests, "interrupt_event_dispatcher_tests",
                       "InterruptEventDispatcher tests")
@@ -143,9 +143,85 @@ bool TestJobNoChildrenSignal() {
   END_TEST;
 }
 
+bool TestJobSnapshotSubtree() {
+  BEGIN_TEST;
+
+  // Build root -> {process, child -> grandchild -> process}.
+  KernelHandle<JobDispatcher> root;
+  zx_rights_t rights;
+  ASSERT_EQ(JobDispatcher::Create(0, /*parent=*/GetRootJobDispatcher(), &root, &rights), ZX_OK);
+  KernelHandle<JobDispatcher> child;
+  ASSERT_EQ(JobDispatcher::Create(0, root.dispatcher(), &child, &rights), ZX_OK);
+  KernelHandle<JobDispatcher> grandchild;
+  ASSERT_EQ(JobDispatcher::Create(0, child.dispatcher(), &grandchild, &rights), ZX_OK);
+  EXPECT_OK(grandchild.dispatcher()->set_name("grandchild", 10));
+
+  KernelHandle<ProcessDispatcher> root_process;
+  KernelHandle<ProcessDispatcher> grandchild_process;
+  KernelHandle<VmAddressRegionDispatcher> vmar;
+  zx_rights_t vmar_rights;
+  ASSERT_EQ(ProcessDispatcher::Create(root.dispatcher(), "root-process", /*flags=*/0u,
+                                      &root_process, &rights, &vmar, &vmar_rights),
+            ZX_OK);
+  ASSERT_EQ(ProcessDispatcher::Create(grandchild.dispatcher(), "grandchild-process", /*flags=*/0u,
+                                      &grandchild_process, &rights, &vmar, &vmar_rights),
+            ZX_OK);
+
+  constexpr size_t kMaxEntries = 8;
+  JobTreeEntry entries[kMaxEntries];
+  size_t count = 0;
+  auto record = [&](const JobTreeEntry& entry) {
+    if (count == kMaxEntries) {
+      return false;
+    }
+    entries[count++] = entry;
+    return true;
+  };
+  ASSERT_OK(root.dispatcher()->SnapshotSubtree(record));
+  ASSERT_EQ(count, 5u);
+
+  // The job the snapshot was taken of comes first, and every node after its parent.
+  EXPECT_EQ(entries[0].koid, root.dispatcher()->get_koid());
+  EXPECT_EQ(entries[0].parent_koid, GetRootJobDispatcher()->get_koid());
+  EXPECT_EQ(entries[0].depth, 0u);
+  for (size_t i = 1; i < count; i++) {
+    bool found_parent = false;
+    for (size_t j = 0; j < i; j++) {
+      if (entries[j].koid == entries[i].parent_koid) {
+        EXPECT_EQ(entries[j].type, ZX_OBJ_TYPE_JOB);
+        EXPECT_EQ(entries[j].depth + 1, entries[i].depth);
+        found_parent = true;
+      }
+    }
+    EXPECT_TRUE(found_parent);
+  }
+
+  bool found_grandchild_process = false;
+  for (size_t i = 0; i < count; i++) {
+    if (entries[i].koid == grandchild_process.dispatcher()->get_koid()) {
+      EXPECT_EQ(entries[i].type, ZX_OBJ_TYPE_PROCESS);
+      EXPECT_EQ(entries[i].parent_koid, grandchild.dispatcher()->get_koid());
+      EXPECT_EQ(entries[i].depth, 3u);
+      EXPECT_EQ(strcmp(entries[i].name, "grandchild-process"), 0);
+      found_grandchild_process = true;
+    } else if (entries[i].koid == grandchild.dispatcher()->get_koid()) {
+      EXPECT_EQ(strcmp(entries[i].name, "grandchild"), 0);
+    }
+  }
+  EXPECT_TRUE(found_grandchild_process);
+
+  // Stopping early is reported.
+  count = kMaxEntries - 1;
+  EXPECT_EQ(root.dispatcher()->SnapshotSubtree(record), ZX_ERR_STOP);
+
+  root.dispatcher()->Kill(0);
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(job_dispatcher_tests)
 UNITTEST("JobDispatcherJobEnumerator", TestJobEnumerator)
 UNITTEST("JobNoChildrenSignal", TestJobNoChildrenSignal)
+UNITTEST("JobSnapshotSubtree", TestJobSnapshotSubtree)
 UNITTEST_END_TESTCASE(job_dispatcher_tests, "job_dispatcher_tests", "JobDispatcher tests")
@@ -8,6 +8,7 @@
 #include <lib/unittest/user_memory.h>
 
 #include <fbl/array.h>
+#include <ktl/iterator.h>
 #include <ktl/unique_ptr.h>
 
 #include "object/mbuf.h"
@@ -595,6 +596,137 @@ static bool datagram_peek_underflow() {
   END_TEST;
 }
 
+// Tests gathering a stream from, and scattering it to, a vector of unevenly sized buffers.
+static bool stream_vector_write_read() {
+  BEGIN_TEST;
+  constexpr size_t kDataOffset = 64;
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(PAGE_SIZE);
+  ASSERT_NE(nullptr, mem.get());
+  char* data = reinterpret_cast<char*>(mem->base() + kDataOffset);
+  zx_iovec_t vec[3] = {{data, 3}, {data + 3, 0}, {data + 3, 5}};
+  ASSERT_EQ(ZX_OK, mem->user_out<zx_iovec_t>().copy_array_to_user(vec, ktl::size(vec)));
+  auto user_data = mem->user_out<char>().byte_offset(kDataOffset);
+  ASSERT_EQ(ZX_OK, user_data.copy_array_to_user("abcdefgh", 8));
+  auto user_vec = mem->user_in<const zx_iovec_t>();
+
+  MBufChain chain;
+  size_t written = 0;
+  ASSERT_EQ(ZX_OK, chain.WriteStream(make_user_in_iovec(user_vec, ktl::size(vec)), &written));
+  EXPECT_EQ(8u, written);
+  EXPECT_EQ(8u, chain.size());
+  ASSERT_TRUE(WriteHelper(&chain, "ijk", MessageType::kStream));
+
+  // Peek, then read, the first 8 bytes back into the same vector.
+  auto user_out_vec = make_user_out_iovec(mem->user_out<zx_iovec_t>(), ktl::size(vec));
+  size_t actual = 0;
+  ASSERT_EQ(ZX_OK, user_data.copy_array_to_user("--------", 8));
+  ASSERT_EQ(ZX_OK, chain.Peek(user_out_vec, false, &actual));
+  EXPECT_EQ(8u, actual);
+  EXPECT_EQ(11u, chain.size());
+  ASSERT_EQ(ZX_OK, chain.Read(user_out_vec, false, &actual));
+  EXPECT_EQ(8u, actual);
+  EXPECT_TRUE(Equal(ReadHelper(&chain, 3, MessageType::kStream, ReadType::kRead), "ijk"));
+  EXPECT_TRUE(chain.is_empty());
+
+  char buf[8];
+  ASSERT_EQ(ZX_OK, mem->user_in<char>().byte_offset(kDataOffset).copy_array_from_user(buf, 8));
+  EXPECT_EQ(0, memcmp(buf, "abcdefgh", 8));
+  END_TEST;
+}
+
+// Tests that a vector is written as a single datagram and read back as one.
+static bool datagram_vector_write_read() {
+  BEGIN_TEST;
+  constexpr size_t kDataOffset = 64;
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(PAGE_SIZE);
+  ASSERT_NE(nullptr, mem.get());
+  char* data = reinterpret_cast<char*>(mem->base() + kDataOffset);
+  zx_iovec_t vec[2] = {{data, 4}, {data + 4, 4}};
+  ASSERT_EQ(ZX_OK, mem->user_out<zx_iovec_t>().copy_array_to_user(vec, ktl::size(vec)));
+  auto user_data = mem->user_out<char>().byte_offset(kDataOffset);
+  ASSERT_EQ(ZX_OK, user_data.copy_array_to_user("abcdefgh", 8));
+
+  MBufChain chain;
+  size_t written = 0;
+  ASSERT_EQ(ZX_OK, chain.WriteDatagram(
+                       make_user_in_iovec(mem->user_in<const zx_iovec_t>(), ktl::size(vec)),
+                       &written));
+  EXPECT_EQ(8u, written);
+  EXPECT_EQ(8u, chain.size(true));
+  ASSERT_TRUE(WriteHelper(&chain, "ijk", MessageType::kDatagram));
+
+  // Read the first datagram into only the first buffer of the vector, dropping the rest of it.
+  size_t actual = 0;
+  auto first_vec = make_user_out_iovec(mem->user_out<zx_iovec_t>(), 1);
+  ASSERT_EQ(ZX_OK, chain.Read(first_vec, true, &actual));
+  EXPECT_EQ(4u, actual);
+  EXPECT_EQ(3u, chain.size());
+  EXPECT_TRUE(Equal(ReadHelper(&chain, 3, MessageType::kDatagram, ReadType::kRead), "ijk"));
+  EXPECT_TRUE(chain.is_empty());
+  END_TEST;
+}
+
+// Tests splicing stream data, both relinking whole buffers and copying partial ones.
+static bool stream_splice() {
+  BEGIN_TEST;
+  const size_t kPayload = MBufChain::mbuf_payload_size();
+  const size_t kWriteLen = kPayload * 2 + kPayload / 2;
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(kWriteLen);
+  ASSERT_NE(nullptr, mem.get());
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<char[]> buf(new (&ac) char[kWriteLen]);
+  ASSERT_TRUE(ac.check());
+  for (size_t i = 0; i < kWriteLen; ++i) {
+    buf[i] = static_cast<char>('a' + i % 26);
+  }
+  ASSERT_EQ(ZX_OK, mem->user_out<char>().copy_array_to_user(buf.get(), kWriteLen));
+
+  MBufChain src;
+  size_t written = 0;
+  ASSERT_EQ(ZX_OK, src.WriteStream(mem->user_in<char>(), kWriteLen, &written));
+  ASSERT_EQ(kWriteLen, written);
+
+  // Consume a few bytes so the first buffer is partially read and must be copied.
+  EXPECT_TRUE(Equal(ReadHelper(&src, 3, MessageType::kStream, ReadType::kRead), "abc"));
+
+  MBufChain dst;
+  ASSERT_TRUE(WriteHelper(&dst, "XY", MessageType::kStream));
+  EXPECT_EQ(kPayload, dst.Splice(&src, kPayload, false));
+  EXPECT_EQ(kWriteLen - 3 - kPayload, src.size());
+  EXPECT_EQ(kPayload + 2, dst.size());
+  EXPECT_EQ(kWriteLen - 3 - kPayload, dst.Splice(&src, SIZE_MAX, false));
+  EXPECT_TRUE(src.is_empty());
+  EXPECT_EQ(kWriteLen - 1, dst.size());
+
+  fbl::Array<char> out = ReadHelper(&dst, kWriteLen, MessageType::kStream, ReadType::kRead);
+  ASSERT_EQ(kWriteLen - 1, out.size());
+  EXPECT_EQ(0, memcmp(out.data(), "XY", 2));
+  EXPECT_EQ(0, memcmp(out.data() + 2, buf.get() + 3, kWriteLen - 3));
+  EXPECT_TRUE(dst.is_empty());
+  END_TEST;
+}
+
+// Tests that splicing datagrams only moves whole datagrams.
+static bool datagram_splice() {
+  BEGIN_TEST;
+  MBufChain src;
+  ASSERT_TRUE(WriteHelper(&src, "abc", MessageType::kDatagram));
+  ASSERT_TRUE(WriteHelper(&src, "defgh", MessageType::kDatagram));
+
+  MBufChain dst;
+  // The second datagram does not fit in what is left of |len|.
+  EXPECT_EQ(3u, dst.Splice(&src, 7, true));
+  EXPECT_EQ(5u, src.size());
+  EXPECT_EQ(5u, dst.Splice(&src, 5, true));
+  EXPECT_TRUE(src.is_empty());
+  EXPECT_EQ(0u, dst.Splice(&src, 5, true));
+
+  EXPECT_TRUE(Equal(ReadHelper(&dst, 8, MessageType::kDatagram, ReadType::kRead), "abc"));
+  EXPECT_TRUE(Equal(ReadHelper(&dst, 8, MessageType::kDatagram, ReadType::kRead), "defgh"));
+  EXPECT_TRUE(dst.is_empty());
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(mbuf_tests)
@@ -620,4 +752,8 @@ UNITTEST("datagram_peek", datagram_peek)
 UNITTEST("datagram_peek_empty", datagram_peek_empty)
 UNITTEST("datagram_peek_zero", datagram_peek_zero)
 UNITTEST("datagram_peek_underflow", datagram_peek_underflow)
+UNITTEST("stream_vector_write_read", stream_vector_write_read)
+UNITTEST("datagram_vector_write_read", datagram_vector_write_read)
+UNITTEST("stream_splice", stream_splice)
+UNITTEST("datagram_splice", datagram_splice)
 UNITTEST_END_TESTCASE(mbuf_tests, "mbuf", "MBuf test")
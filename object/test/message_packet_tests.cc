@@ -144,6 +144,49 @@ static bool copy_bad_mem() {
   END_TEST;
 }
 
+// Create MessagePackets on either side of the slab size class boundaries and call CopyDataTo.
+static bool create_size_classes() {
+  BEGIN_TEST;
+  constexpr size_t kMaxSize = 2 * MessagePacket::kMediumSlabSize;
+  ktl::unique_ptr<UserMemory> mem = UserMemory::Create(kMaxSize);
+  auto mem_in = mem->user_in<char>();
+  auto mem_out = mem->user_out<char>();
+
+  fbl::AllocChecker ac;
+  auto buf = ktl::unique_ptr<char[]>(new (&ac) char[kMaxSize]);
+  ASSERT_TRUE(ac.check());
+  auto result_buf = ktl::unique_ptr<char[]>(new (&ac) char[kMaxSize]);
+  ASSERT_TRUE(ac.check());
+  for (size_t i = 0; i < kMaxSize; i++) {
+    buf[i] = static_cast<char>(i % 251);
+  }
+
+  constexpr uint32_t kSizes[] = {
+      1,
+      MessagePacket::kSmallSlabSize / 2,
+      MessagePacket::kSmallSlabSize,
+      MessagePacket::kSmallSlabSize + 1,
+      MessagePacket::kMediumSlabSize - 1,
+      MessagePacket::kMediumSlabSize,
+      kMaxSize,
+  };
+  constexpr uint32_t kNumHandles[] = {0, 3, kMaxMessageHandles};
+  for (uint32_t size : kSizes) {
+    for (uint32_t num_handles : kNumHandles) {
+      ASSERT_EQ(ZX_OK, mem_out.copy_array_to_user(buf.get(), size));
+      MessagePacketPtr mp;
+      ASSERT_EQ(ZX_OK, MessagePacket::Create(mem_in, size, num_handles, &mp));
+      ASSERT_EQ(size, mp->data_size());
+      EXPECT_EQ(num_handles, mp->num_handles());
+
+      ASSERT_EQ(ZX_OK, mp->CopyDataTo(mem_out));
+      ASSERT_EQ(ZX_OK, mem_in.copy_array_from_user(result_buf.get(), size));
+      EXPECT_EQ(0, memcmp(buf.get(), result_buf.get(), size));
+    }
+  }
+  END_TEST;
+}
+
 // Create a message packet with the specified number of iovec inputs.
 template <uint32_t NIovecs, uint32_t NHandles>
 static bool create_iovec() {
@@ -200,6 +243,7 @@ UNITTEST("create_zero", create_zero)
 UNITTEST("create_too_many_handles", create_too_many_handles)
 UNITTEST("create_bad_mem", create_bad_mem)
 UNITTEST("copy_bad_mem", copy_bad_mem)
+UNITTEST("create_size_classes", create_size_classes)
 UNITTEST("create_iovec_bounded", (create_iovec<MessagePacket::kIovecChunkSize, 0>))
 UNITTEST("create_iovec_unbounded", (create_iovec<2 * MessagePacket::kIovecChunkSize, 0>))
 UNITTEST("create_iovec_bounded_handles", (create_iovec<MessagePacket::kIovecChunkSize, 3>))
@@ -0,0 +1,90 @@
+// Copyright 2026 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+#include <zircon/rights.h>
+
+#include <ktl/iterator.h>
+#include <object/event_dispatcher.h>
+#include <object/handle.h>
+#include <object/job_dispatcher.h>
+#include <object/op_batch.h>
+#include <object/process_dispatcher.h>
+#include <object/vm_address_region_dispatcher.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+BatchOp SignalOp(zx_handle_t handle, uint32_t clear_mask, uint32_t set_mask) {
+  BatchOp op{};
+  op.opcode = BatchOpcode::kObjectSignal;
+  op.handle = handle;
+  op.signal.clear_mask = clear_mask;
+  op.signal.set_mask = set_mask;
+  return op;
+}
+
+// Operations run in order against the handles of the given process, each reporting its own
+// status, and a failure only ends the batch when asked to.
+bool TestExecuteOpBatchSignal() {
+  BEGIN_TEST;
+
+  KernelHandle<JobDispatcher> job;
+  zx_rights_t rights;
+  ASSERT_OK(JobDispatcher::Create(0, GetRootJobDispatcher(), &job, &rights));
+  KernelHandle<ProcessDispatcher> process;
+  KernelHandle<VmAddressRegionDispatcher> vmar;
+  zx_rights_t vmar_rights;
+  ASSERT_OK(ProcessDispatcher::Create(job.dispatcher(), "op-batch", 0u, &process, &rights, &vmar,
+                                      &vmar_rights));
+  ProcessDispatcher& up = *process.dispatcher();
+
+  KernelHandle<EventDispatcher> event;
+  zx_rights_t event_rights;
+  ASSERT_OK(EventDispatcher::Create(0, &event, &event_rights));
+  fbl::RefPtr<EventDispatcher> event_dispatcher = event.dispatcher();
+
+  HandleOwner signal_handle = Handle::Make(event_dispatcher, event_rights);
+  ASSERT_TRUE(signal_handle);
+  const zx_handle_t signal_value = up.handle_table().MapHandleToValue(signal_handle);
+  up.handle_table().AddHandle(ktl::move(signal_handle));
+  HandleOwner no_signal_handle = Handle::Make(event_dispatcher, event_rights & ~ZX_RIGHT_SIGNAL);
+  ASSERT_TRUE(no_signal_handle);
+  const zx_handle_t no_signal_value = up.handle_table().MapHandleToValue(no_signal_handle);
+  up.handle_table().AddHandle(ktl::move(no_signal_handle));
+
+  const BatchOp ops[] = {
+      SignalOp(signal_value, 0, ZX_USER_SIGNAL_0),
+      SignalOp(signal_value, ZX_USER_SIGNAL_0, ZX_USER_SIGNAL_1),
+      SignalOp(no_signal_value, 0, ZX_USER_SIGNAL_3),
+      SignalOp(signal_value, 0, ZX_USER_SIGNAL_2),
+  };
+  zx_status_t results[ktl::size(ops)];
+
+  EXPECT_EQ(ktl::size(ops), ExecuteOpBatch(up, ops, results, 0));
+  EXPECT_OK(results[0]);
+  EXPECT_OK(results[1]);
+  EXPECT_EQ(ZX_ERR_ACCESS_DENIED, results[2]);
+  EXPECT_OK(results[3]);
+  EXPECT_EQ(ZX_USER_SIGNAL_1 | ZX_USER_SIGNAL_2, event_dispatcher->PollSignals());
+
+  EXPECT_OK(event_dispatcher->user_signal_self(ZX_USER_SIGNAL_1 | ZX_USER_SIGNAL_2, 0));
+  EXPECT_EQ(size_t{3}, ExecuteOpBatch(up, ops, results, kBatchStopOnError));
+  EXPECT_EQ(ZX_ERR_ACCESS_DENIED, results[2]);
+  EXPECT_EQ(ZX_USER_SIGNAL_1, event_dispatcher->PollSignals());
+
+  process.dispatcher()->Kill(0);
+  job.dispatcher()->Kill(0);
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(op_batch_tests)
+UNITTEST("TestExecuteOpBatchSignal", TestExecuteOpBatchSignal)
+UNITTEST_END_TESTCASE(op_batch_tests, "op_batch_tests", "ExecuteOpBatch tests")
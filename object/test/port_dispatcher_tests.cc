@@ -0,0 +1,75 @@
+// Copyright 2026 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+
+#include <object/event_dispatcher.h>
+#include <object/handle.h>
+#include <object/port_dispatcher.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+// A persistent observer stays registered after each match and coalesces matches into its one
+// packet while that packet is queued, until its key is canceled.
+bool TestPersistentObserverCoalesces() {
+  BEGIN_TEST;
+
+  constexpr uint64_t kKey = 42;
+  constexpr zx_signals_t kSignals = ZX_USER_SIGNAL_0 | ZX_USER_SIGNAL_1;
+
+  KernelHandle<PortDispatcher> port_handle;
+  zx_rights_t port_rights;
+  ASSERT_OK(PortDispatcher::Create(0, &port_handle, &port_rights));
+  const fbl::RefPtr<PortDispatcher>& port = port_handle.dispatcher();
+
+  KernelHandle<EventDispatcher> event;
+  zx_rights_t event_rights;
+  ASSERT_OK(EventDispatcher::Create(0, &event, &event_rights));
+  fbl::RefPtr<EventDispatcher> event_dispatcher = event.dispatcher();
+  HandleOwner event_handle = Handle::Make(event_dispatcher, event_rights);
+  ASSERT_TRUE(event_handle);
+
+  ASSERT_OK(port->MakeObserver(kWaitAsyncPersistent, event_handle.get(), kKey, kSignals));
+
+  zx_port_packet_t packet;
+  EXPECT_EQ(ZX_ERR_TIMED_OUT, port->Dequeue(Deadline::infinite_past(), &packet));
+
+  // Two matches while the packet is queued produce a single packet observing both.
+  ASSERT_OK(event_dispatcher->user_signal_self(0, ZX_USER_SIGNAL_0));
+  ASSERT_OK(event_dispatcher->user_signal_self(0, ZX_USER_SIGNAL_1));
+  ASSERT_OK(port->Dequeue(Deadline::infinite_past(), &packet));
+  EXPECT_EQ(kKey, packet.key);
+  EXPECT_EQ(ZX_PKT_TYPE_SIGNAL_ONE, packet.type);
+  EXPECT_EQ(kSignals, packet.signal.trigger);
+  EXPECT_EQ(kSignals, packet.signal.observed & kSignals);
+  EXPECT_EQ(ZX_ERR_TIMED_OUT, port->Dequeue(Deadline::infinite_past(), &packet));
+
+  // The observer is still registered, so a new match queues the packet again without re-arming.
+  ASSERT_OK(event_dispatcher->user_signal_self(kSignals, 0));
+  EXPECT_EQ(ZX_ERR_TIMED_OUT, port->Dequeue(Deadline::infinite_past(), &packet));
+  ASSERT_OK(event_dispatcher->user_signal_self(0, ZX_USER_SIGNAL_1));
+  ASSERT_OK(port->Dequeue(Deadline::infinite_past(), &packet));
+  EXPECT_EQ(kKey, packet.key);
+  EXPECT_EQ(ZX_USER_SIGNAL_1, packet.signal.observed & kSignals);
+
+  // Canceling the key removes both a queued packet and the observer.
+  ASSERT_OK(event_dispatcher->user_signal_self(ZX_USER_SIGNAL_1, ZX_USER_SIGNAL_0));
+  EXPECT_OK(port->CancelKey(kKey));
+  EXPECT_EQ(ZX_ERR_TIMED_OUT, port->Dequeue(Deadline::infinite_past(), &packet));
+  ASSERT_OK(event_dispatcher->user_signal_self(ZX_USER_SIGNAL_0, ZX_USER_SIGNAL_1));
+  EXPECT_EQ(ZX_ERR_TIMED_OUT, port->Dequeue(Deadline::infinite_past(), &packet));
+  EXPECT_EQ(ZX_ERR_NOT_FOUND, port->CancelKey(kKey));
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(port_dispatcher_tests)
+UNITTEST("PersistentObserverCoalesces", TestPersistentObserverCoalesces)
+UNITTEST_END_TESTCASE(port_dispatcher_tests, "port_dispatcher", "PortDispatcher tests")
@@ -0,0 +1,108 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+
+#include <object/job_dispatcher.h>
+#include <object/process_dispatcher.h>
+#include <object/process_template.h>
+#include <object/vm_address_region_dispatcher.h>
+#include <vm/vm_address_region.h>
+#include <vm/vm_object_paged.h>
+
+namespace {
+
+constexpr uint kReadOnly = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_EXECUTE;
+constexpr uint kReadWrite = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE;
+
+bool TestProcessTemplateInvalid() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, 2 * PAGE_SIZE, &vmo));
+
+  fbl::RefPtr<ProcessTemplate> process_template;
+  const ProcessTemplate::Segment unaligned[] = {{vmo, 0, PAGE_SIZE + 1, PAGE_SIZE, kReadOnly}};
+  EXPECT_EQ(ProcessTemplate::Create(unaligned, &process_template), ZX_ERR_INVALID_ARGS);
+
+  const ProcessTemplate::Segment no_read[] = {{vmo, 0, 0, PAGE_SIZE, ARCH_MMU_FLAG_PERM_WRITE}};
+  EXPECT_EQ(ProcessTemplate::Create(no_read, &process_template), ZX_ERR_INVALID_ARGS);
+
+  const ProcessTemplate::Segment overlapping[] = {
+      {vmo, 0, 0, 2 * PAGE_SIZE, kReadOnly},
+      {vmo, 0, PAGE_SIZE, PAGE_SIZE, kReadOnly},
+  };
+  EXPECT_EQ(ProcessTemplate::Create(overlapping, &process_template), ZX_ERR_INVALID_ARGS);
+
+  const ProcessTemplate::Segment valid[] = {
+      {vmo, 0, 0, PAGE_SIZE, kReadOnly},
+      {vmo, PAGE_SIZE, PAGE_SIZE, PAGE_SIZE, kReadWrite},
+  };
+  ASSERT_OK(ProcessTemplate::Create(valid, &process_template));
+  EXPECT_EQ(process_template->segment_count(), 2u);
+
+  END_TEST;
+}
+
+bool TestProcessTemplateInstantiate() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, 2 * PAGE_SIZE, &vmo));
+  // Fake user id to keep the cloning code happy.
+  vmo->set_user_id(0xff);
+
+  constexpr size_t kTextOffset = 16 * PAGE_SIZE;
+  constexpr size_t kDataOffset = 32 * PAGE_SIZE;
+  const ProcessTemplate::Segment segments[] = {
+      {vmo, 0, kTextOffset, PAGE_SIZE, kReadOnly},
+      {vmo, PAGE_SIZE, kDataOffset, PAGE_SIZE, kReadWrite},
+  };
+  fbl::RefPtr<ProcessTemplate> process_template;
+  ASSERT_OK(ProcessTemplate::Create(segments, &process_template));
+
+  KernelHandle<JobDispatcher> job;
+  zx_rights_t rights;
+  ASSERT_OK(JobDispatcher::Create(0, GetRootJobDispatcher(), &job, &rights));
+
+  // Stamp out two processes and check that they share the read-only segment but each get their
+  // own copy of the writable one.
+  fbl::RefPtr<VmObject> data_vmos[2];
+  for (fbl::RefPtr<VmObject>& data_vmo : data_vmos) {
+    KernelHandle<ProcessDispatcher> process;
+    KernelHandle<VmAddressRegionDispatcher> vmar;
+    zx_rights_t vmar_rights;
+    ASSERT_OK(ProcessDispatcher::Create(job.dispatcher(), "templated", 0u, &process, &rights,
+                                        &vmar, &vmar_rights, process_template.get()));
+    fbl::RefPtr<VmAddressRegion> root = vmar.dispatcher()->vmar();
+
+    fbl::RefPtr<VmAddressRegionOrMapping> text = root->FindRegion(root->base() + kTextOffset);
+    ASSERT_NONNULL(text);
+    fbl::RefPtr<VmMapping> text_mapping = text->as_vm_mapping();
+    ASSERT_NONNULL(text_mapping);
+    EXPECT_EQ(text_mapping->vmo().get(), static_cast<VmObject*>(vmo.get()));
+
+    fbl::RefPtr<VmAddressRegionOrMapping> data = root->FindRegion(root->base() + kDataOffset);
+    ASSERT_NONNULL(data);
+    fbl::RefPtr<VmMapping> data_mapping = data->as_vm_mapping();
+    ASSERT_NONNULL(data_mapping);
+    data_vmo = data_mapping->vmo();
+    EXPECT_NE(data_vmo.get(), static_cast<VmObject*>(vmo.get()));
+
+    process.dispatcher()->Kill(0);
+  }
+  EXPECT_NE(data_vmos[0].get(), data_vmos[1].get());
+
+  job.dispatcher()->Kill(0);
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(process_template_tests)
+UNITTEST("ProcessTemplateInvalid", TestProcessTemplateInvalid)
+UNITTEST("ProcessTemplateInstantiate", TestProcessTemplateInstantiate)
+UNITTEST_END_TESTCASE(process_template_tests, "process_template_tests", "ProcessTemplate tests")
@@ -44,9 +44,31 @@ bool IncrementDecrement() {
   END_TEST;
 }
 
+bool DeferredAspaceDestroy() {
+  BEGIN_TEST;
+
+  ShareableProcessState state;
+  ASSERT_TRUE(state.Initialize(USER_ASPACE_BASE, USER_ASPACE_SIZE, "deferred",
+                               VmAspace::ShareOpt::None));
+  EXPECT_TRUE(state.IncrementShareCount());
+
+  // Only the last decrement reports that the state is no longer shared.
+  EXPECT_FALSE(state.DecrementShareCount(/*destroy_aspace=*/false));
+  EXPECT_TRUE(state.DecrementShareCount(/*destroy_aspace=*/false));
+
+  // The address space outlives the last share until it is explicitly destroyed.
+  ASSERT_NONNULL(state.aspace());
+  EXPECT_FALSE(state.aspace()->is_destroyed());
+  state.DestroyAspace();
+  EXPECT_TRUE(state.aspace()->is_destroyed());
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(shareable_process_state_tests)
 UNITTEST("IncrementDecrement", IncrementDecrement)
+UNITTEST("DeferredAspaceDestroy", DeferredAspaceDestroy)
 UNITTEST_END_TESTCASE(shareable_process_state_tests, "shareable_process_state",
                       "ShareableProcessState test")
@@ -95,6 +95,54 @@ bool TestCreateWriteReadClose() {
   END_TEST;
 }
 
+// Splice data read from one socket pair into another.
+bool TestSplice() {
+  BEGIN_TEST;
+
+  static constexpr unsigned int kSize = 5000;
+  ktl::unique_ptr<testing::UserMemory> memory = testing::UserMemory::Create(kSize);
+  ASSERT_NONNULL(memory);
+
+  KernelHandle<SocketDispatcher> in0, in1, out0, out1;
+  zx_rights_t rights;
+  ASSERT_EQ(SocketDispatcher::Create(ZX_SOCKET_STREAM, &in0, &in1, &rights), ZX_OK);
+  ASSERT_EQ(SocketDispatcher::Create(ZX_SOCKET_STREAM, &out0, &out1, &rights), ZX_OK);
+  SocketDispatcher* source = in1.dispatcher().get();
+  SocketDispatcher* dest = out0.dispatcher().get();
+
+  size_t moved = 0;
+  EXPECT_EQ(source->Splice(dest, kSize, &moved), ZX_ERR_SHOULD_WAIT);
+  // Splicing into the socket's own peer would write back into the socket being read.
+  EXPECT_EQ(source->Splice(in0.dispatcher().get(), kSize, &moved), ZX_ERR_INVALID_ARGS);
+
+  for (unsigned int i = 0; i < kSize; ++i) {
+    memory->put<unsigned char>(static_cast<unsigned char>(i), i);
+  }
+  size_t written = 0;
+  ASSERT_EQ(in0.dispatcher()->Write(memory->user_in<char>(), kSize, &written), ZX_OK);
+  ASSERT_EQ(written, kSize);
+
+  EXPECT_EQ(source->Splice(dest, kSize - 1, &moved), ZX_OK);
+  EXPECT_EQ(moved, kSize - 1);
+  EXPECT_EQ(source->GetInfo().rx_buf_available, 1u);
+  EXPECT_EQ(out1.dispatcher()->GetInfo().rx_buf_available, kSize - 1);
+  EXPECT_TRUE(out1.dispatcher()->PollSignals() & ZX_SOCKET_READABLE);
+  EXPECT_EQ(source->Splice(dest, kSize, &moved), ZX_OK);
+  EXPECT_EQ(moved, 1u);
+  EXPECT_FALSE(source->PollSignals() & ZX_SOCKET_READABLE);
+
+  size_t bytes_read = 0;
+  ASSERT_EQ(out1.dispatcher()->Read(SocketDispatcher::ReadType::kConsume,
+                                    memory->user_out<char>(), kSize, &bytes_read),
+            ZX_OK);
+  EXPECT_EQ(bytes_read, kSize);
+  for (unsigned int i = 0; i < kSize; ++i) {
+    EXPECT_EQ(memory->get<unsigned char>(i), static_cast<unsigned char>(i));
+  }
+
+  END_TEST;
+}
+
 bool TestDispositionSwitchMustBeExhaustive() {
   BEGIN_TEST;
 
@@ -119,5 +167,6 @@ bool TestDispositionSwitchMustBeExhaustive() {
 UNITTEST_START_TESTCASE(socket_dispatcher_tests)
 UNITTEST("TestCreateDestroyManySockets", TestCreateDestroyManySockets)
 UNITTEST("TestCreateWriteReadClose", TestCreateWriteReadClose)
+UNITTEST("TestSplice", TestSplice)
 UNITTEST("TestDispositionSwitchMustBeExhaustive", TestDispositionSwitchMustBeExhaustive)
 UNITTEST_END_TESTCASE(socket_dispatcher_tests, "socket_dispatcher_tests", "SocketDispatcher tests")
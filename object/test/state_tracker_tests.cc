@@ -30,6 +30,14 @@ class TestDispatcher final : public SoloDispatcher<TestDispatcher, ZX_RIGHTS_BAS
   void SetSignals(zx_signals_t signals) {
     this->UpdateState(/*clear_mask=*/0, /*set_mask=*/signals);
   }
+
+  void UnsetSignals(zx_signals_t signals) {
+    this->UpdateState(/*clear_mask=*/signals, /*set_mask=*/0);
+  }
+
+  void UpdateSignals(zx_signals_t clear_mask, zx_signals_t set_mask) {
+    this->UpdateState(clear_mask, set_mask);
+  }
 };
 
 class TestSignalObserver final : public SignalObserver {
@@ -72,6 +80,32 @@ class TestSignalObserver final : public SignalObserver {
   uint64_t key_;
 };
 
+// An observer that stays registered and counts its matches.
+class PersistentSignalObserver final : public SignalObserver {
+ public:
+  int match_count() const { return match_count_; }
+  zx_signals_t signals() const { return signals_; }
+  bool cancel_called() const { return cancel_called_; }
+
+ private:
+  void OnMatch(zx_signals_t signals) final {
+    ZX_ASSERT(!cancel_called_);
+    signals_ = signals;
+    match_count_++;
+  }
+
+  void OnCancel(zx_signals_t signals) final {
+    ZX_ASSERT(!cancel_called_);
+    cancel_called_ = true;
+  }
+
+  bool IsPersistent() const final { return true; }
+
+  zx_signals_t signals_ = 0;
+  int match_count_ = 0;
+  bool cancel_called_ = false;
+};
+
 bool TestBasicMatch() {
   BEGIN_TEST;
 
@@ -210,6 +244,107 @@ bool TestRemoveByKey() {
   END_TEST;
 }
 
+bool TestPersistentMatch() {
+  BEGIN_TEST;
+
+  fbl::AllocChecker ac;
+  auto dispatcher = fbl::MakeRefCountedChecked<TestDispatcher>(&ac);
+  ASSERT_TRUE(ac.check());
+  HandleOwner handle = Handle::Make(dispatcher, TestDispatcher::default_rights());
+
+  // A persistent observer matches immediately and stays registered.
+  dispatcher->SetSignals(ZX_USER_SIGNAL_0);
+  PersistentSignalObserver observer;
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer, handle.get(), ZX_USER_SIGNAL_0));
+  EXPECT_EQ(1, observer.match_count());
+
+  // Each new assertion of the signal matches again without re-adding the observer.
+  dispatcher->UnsetSignals(ZX_USER_SIGNAL_0);
+  dispatcher->SetSignals(ZX_USER_SIGNAL_0);
+  EXPECT_EQ(2, observer.match_count());
+  dispatcher->SetSignals(ZX_USER_SIGNAL_1);
+  EXPECT_EQ(2, observer.match_count());
+  dispatcher->UnsetSignals(ZX_USER_SIGNAL_0);
+  dispatcher->SetSignals(ZX_USER_SIGNAL_0);
+  EXPECT_EQ(3, observer.match_count());
+
+  // Cancellation still removes it.
+  dispatcher->Cancel(handle.get());
+  EXPECT_TRUE(observer.cancel_called());
+  dispatcher->UnsetSignals(ZX_USER_SIGNAL_0);
+  dispatcher->SetSignals(ZX_USER_SIGNAL_0);
+  EXPECT_EQ(3, observer.match_count());
+
+  END_TEST;
+}
+
+bool TestRemainingObserversStillMatch() {
+  BEGIN_TEST;
+
+  fbl::AllocChecker ac;
+  auto dispatcher = fbl::MakeRefCountedChecked<TestDispatcher>(&ac);
+  ASSERT_TRUE(ac.check());
+  HandleOwner handle1 = Handle::Make(dispatcher, TestDispatcher::default_rights());
+  HandleOwner handle2 = Handle::Make(dispatcher, TestDispatcher::default_rights());
+
+  TestSignalObserver observer0;
+  TestSignalObserver observer1;
+  TestSignalObserver observer2;
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer0, handle1.get(), ZX_USER_SIGNAL_0));
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer1, handle1.get(), ZX_USER_SIGNAL_1));
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer2, handle2.get(), ZX_USER_SIGNAL_2));
+
+  // Matching one observer leaves the signals of the others observed.
+  dispatcher->SetSignals(ZX_USER_SIGNAL_0);
+  EXPECT_TRUE(observer0.match_called());
+  EXPECT_FALSE(observer1.called());
+  dispatcher->SetSignals(ZX_USER_SIGNAL_1);
+  EXPECT_TRUE(observer1.match_called());
+
+  // So does canceling one.
+  TestSignalObserver observer3;
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer3, handle1.get(), ZX_USER_SIGNAL_3));
+  dispatcher->Cancel(handle1.get());
+  EXPECT_TRUE(observer3.cancel_called());
+  dispatcher->SetSignals(ZX_USER_SIGNAL_2);
+  EXPECT_TRUE(observer2.match_called());
+
+  // A signal observed again after the last observer of it went away matches.
+  TestSignalObserver observer4;
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer4, handle2.get(), ZX_USER_SIGNAL_3));
+  EXPECT_TRUE(dispatcher->RemoveObserver(&observer4));
+  TestSignalObserver observer5;
+  ASSERT_EQ(ZX_OK, dispatcher->AddObserver(&observer5, handle2.get(), ZX_USER_SIGNAL_3));
+  dispatcher->SetSignals(ZX_USER_SIGNAL_3);
+  EXPECT_TRUE(observer5.match_called());
+
+  END_TEST;
+}
+
+bool TestRaiseActiveSignals() {
+  BEGIN_TEST;
+
+  TestDispatcher dispatcher;
+  dispatcher.SetSignals(ZX_USER_SIGNAL_0 | ZX_USER_SIGNAL_1);
+
+  TestSignalObserver observer;
+  ASSERT_EQ(ZX_OK, dispatcher.AddObserver(&observer, nullptr, ZX_USER_SIGNAL_2));
+
+  // Raising an active signal still clears the others, even those it raises.
+  dispatcher.UpdateSignals(ZX_USER_SIGNAL_0 | ZX_USER_SIGNAL_1, ZX_USER_SIGNAL_0);
+  EXPECT_EQ(ZX_USER_SIGNAL_0, dispatcher.PollSignals());
+  dispatcher.UpdateSignals(0, ZX_USER_SIGNAL_0);
+  EXPECT_EQ(ZX_USER_SIGNAL_0, dispatcher.PollSignals());
+  EXPECT_FALSE(observer.called());
+
+  // Raising an inactive signal along with an active one still notifies.
+  dispatcher.UpdateSignals(0, ZX_USER_SIGNAL_0 | ZX_USER_SIGNAL_2);
+  EXPECT_TRUE(observer.match_called());
+  EXPECT_EQ(ZX_USER_SIGNAL_0 | ZX_USER_SIGNAL_2, observer.signals());
+
+  END_TEST;
+}
+
 }  // namespace
 
 #define ST_UNITTEST(fname) UNITTEST(#fname, fname)
@@ -222,5 +357,8 @@ ST_UNITTEST(TestCancelled)
 ST_UNITTEST(TestRemoveObserver)
 ST_UNITTEST(TestRemoveObserverAfterMatch)
 ST_UNITTEST(TestRemoveByKey)
+ST_UNITTEST(TestPersistentMatch)
+ST_UNITTEST(TestRemainingObserversStillMatch)
+ST_UNITTEST(TestRaiseActiveSignals)
 
 UNITTEST_END_TESTCASE(state_tracker_tests, "statetracker", "StateTracker test")
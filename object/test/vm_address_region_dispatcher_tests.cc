@@ -0,0 +1,79 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/fit/defer.h>
+#include <lib/unittest/unittest.h>
+
+#include <object/port_dispatcher.h>
+#include <object/vm_address_region_dispatcher.h>
+#include <vm/vm_aspace.h>
+#include <vm/vm_object_paged.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+bool TestPrefetchAsyncMapsRange() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmAspace> aspace = VmAspace::Create(VmAspace::Type::User, "test aspace");
+  ASSERT_NONNULL(aspace);
+  auto destroy_aspace = fit::defer([&aspace]() { aspace->Destroy(); });
+
+  KernelHandle<VmAddressRegionDispatcher> vmar_handle;
+  zx_rights_t vmar_rights;
+  ASSERT_EQ(ZX_OK, VmAddressRegionDispatcher::Create(aspace->RootVmar(), ARCH_MMU_FLAG_PERM_USER,
+                                                     &vmar_handle, &vmar_rights));
+
+  constexpr uint64_t kSize = 4 * PAGE_SIZE;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_EQ(ZX_OK, VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, kSize, &vmo));
+  // Prefetching maps the pages that are present, so give it some.
+  ASSERT_EQ(ZX_OK, vmo->CommitRange(0, kSize));
+  auto mapping = vmar_handle.dispatcher()->Map(0, vmo, 0, kSize, ZX_VM_PERM_READ);
+  ASSERT_TRUE(mapping.is_ok());
+
+  KernelHandle<PortDispatcher> port_handle;
+  zx_rights_t port_rights;
+  ASSERT_EQ(ZX_OK, PortDispatcher::Create(0, &port_handle, &port_rights));
+  fbl::RefPtr<PortDispatcher> port = port_handle.dispatcher();
+
+  // Nothing is mapped until the prefetch has run.
+  paddr_t pa;
+  uint mmu_flags;
+  EXPECT_EQ(ZX_ERR_NOT_FOUND, aspace->arch_aspace().Query(mapping->base, &pa, &mmu_flags));
+
+  constexpr uint64_t kKey = 0x5678;
+  ASSERT_EQ(ZX_OK, vmar_handle.dispatcher()->PrefetchAsync(mapping->base, kSize, vmar_rights, port,
+                                                           kKey));
+
+  zx_port_packet_t packet;
+  ASSERT_EQ(ZX_OK, port->Dequeue(Deadline::infinite(), &packet));
+  EXPECT_EQ(kKey, packet.key);
+  EXPECT_EQ(ZX_PKT_TYPE_USER, packet.type);
+  EXPECT_EQ(ZX_OK, packet.status);
+  EXPECT_EQ(mapping->base, packet.user.u64[0]);
+  EXPECT_EQ(kSize, packet.user.u64[1]);
+  for (uint64_t offset = 0; offset < kSize; offset += PAGE_SIZE) {
+    EXPECT_EQ(ZX_OK, aspace->arch_aspace().Query(mapping->base + offset, &pa, &mmu_flags));
+  }
+
+  // Errors from the prefetch, here a range running past the mapping, are reported in the packet
+  // rather than by PrefetchAsync.
+  ASSERT_EQ(ZX_OK, vmar_handle.dispatcher()->PrefetchAsync(mapping->base, kSize + PAGE_SIZE,
+                                                           vmar_rights, port, kKey));
+  ASSERT_EQ(ZX_OK, port->Dequeue(Deadline::infinite(), &packet));
+  EXPECT_NE(ZX_OK, packet.status);
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(vm_address_region_dispatcher_tests)
+UNITTEST("PrefetchAsyncMapsRange", TestPrefetchAsyncMapsRange)
+UNITTEST_END_TESTCASE(vm_address_region_dispatcher_tests, "vm_address_region_dispatcher",
+                      "VmAddressRegionDispatcher tests")
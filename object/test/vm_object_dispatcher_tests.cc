@@ -0,0 +1,106 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+
+#include <kernel/thread.h>
+#include <object/async_prefetch.h>
+#include <object/port_dispatcher.h>
+#include <object/vm_object_dispatcher.h>
+#include <vm/vm_object_paged.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+bool TestPrefetchAsyncPostsCompletion() {
+  BEGIN_TEST;
+
+  constexpr uint64_t kSize = 4 * PAGE_SIZE;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_EQ(ZX_OK, VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, kSize, &vmo));
+
+  KernelHandle<VmObjectDispatcher> vmo_handle;
+  zx_rights_t rights;
+  ASSERT_EQ(ZX_OK, VmObjectDispatcher::Create(ktl::move(vmo), kSize,
+                                              VmObjectDispatcher::InitialMutability::kMutable,
+                                              &vmo_handle, &rights));
+
+  KernelHandle<PortDispatcher> port_handle;
+  ASSERT_EQ(ZX_OK, PortDispatcher::Create(0, &port_handle, &rights));
+  fbl::RefPtr<PortDispatcher> port = port_handle.dispatcher();
+
+  constexpr uint64_t kKey = 0x1234;
+  ASSERT_EQ(ZX_OK, vmo_handle.dispatcher()->PrefetchAsync(PAGE_SIZE, 2 * PAGE_SIZE, port, kKey));
+
+  zx_port_packet_t packet;
+  ASSERT_EQ(ZX_OK, port->Dequeue(Deadline::infinite(), &packet));
+  EXPECT_EQ(kKey, packet.key);
+  EXPECT_EQ(ZX_PKT_TYPE_USER, packet.type);
+  EXPECT_EQ(ZX_OK, packet.status);
+  EXPECT_EQ(PAGE_SIZE, packet.user.u64[0]);
+  EXPECT_EQ(2 * PAGE_SIZE, packet.user.u64[1]);
+
+  // Errors from the prefetch are reported in the packet rather than by PrefetchAsync.
+  ASSERT_EQ(ZX_OK, vmo_handle.dispatcher()->PrefetchAsync(kSize, PAGE_SIZE, port, kKey));
+  ASSERT_EQ(ZX_OK, port->Dequeue(Deadline::infinite(), &packet));
+  EXPECT_NE(ZX_OK, packet.status);
+
+  END_TEST;
+}
+
+// Prefetches stay charged to the caller's quota until their packets are dequeued, or discarded
+// along with the port, so a caller that never reads its port cannot queue without bound.
+bool TestPrefetchAsyncQuota() {
+  BEGIN_TEST;
+
+  constexpr uint64_t kSize = PAGE_SIZE;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_EQ(ZX_OK, VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, kSize, &vmo));
+
+  KernelHandle<VmObjectDispatcher> vmo_handle;
+  zx_rights_t rights;
+  ASSERT_EQ(ZX_OK, VmObjectDispatcher::Create(ktl::move(vmo), kSize,
+                                              VmObjectDispatcher::InitialMutability::kMutable,
+                                              &vmo_handle, &rights));
+
+  KernelHandle<PortDispatcher> port_handle;
+  ASSERT_EQ(ZX_OK, PortDispatcher::Create(0, &port_handle, &rights));
+  fbl::RefPtr<PortDispatcher> port = port_handle.dispatcher();
+
+  const AsyncPrefetchQuota& quota = CurrentAsyncPrefetchQuota();
+  const uint32_t initial = quota.outstanding();
+  ASSERT_LT(initial, AsyncPrefetchQuota::kMaxOutstanding);
+
+  for (uint32_t i = initial; i < AsyncPrefetchQuota::kMaxOutstanding; i++) {
+    ASSERT_EQ(ZX_OK, vmo_handle.dispatcher()->PrefetchAsync(0, kSize, port, i));
+  }
+  EXPECT_EQ(ZX_ERR_SHOULD_WAIT, vmo_handle.dispatcher()->PrefetchAsync(0, kSize, port, 0));
+
+  // Dequeuing a packet makes room for another prefetch.
+  zx_port_packet_t packet;
+  ASSERT_EQ(ZX_OK, port->Dequeue(Deadline::infinite(), &packet));
+  EXPECT_EQ(ZX_OK, vmo_handle.dispatcher()->PrefetchAsync(0, kSize, port, 0));
+  EXPECT_EQ(ZX_ERR_SHOULD_WAIT, vmo_handle.dispatcher()->PrefetchAsync(0, kSize, port, 0));
+
+  // Closing the port gives back everything, including prefetches whose packets were not yet
+  // queued when it was closed.
+  port.reset();
+  port_handle.reset();
+  while (quota.outstanding() != initial) {
+    Thread::Current::SleepRelative(ZX_MSEC(1));
+  }
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(vm_object_dispatcher_tests)
+UNITTEST("PrefetchAsyncPostsCompletion", TestPrefetchAsyncPostsCompletion)
+UNITTEST("PrefetchAsyncQuota", TestPrefetchAsyncQuota)
+UNITTEST_END_TESTCASE(vm_object_dispatcher_tests, "vm_object_dispatcher",
+                      "VmObjectDispatcher tests")
@@ -0,0 +1,111 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+
+#include <object/event_dispatcher.h>
+#include <object/handle.h>
+#include <object/wait_set.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+HandleOwner CreateEvent() {
+  KernelHandle<EventDispatcher> event;
+  zx_rights_t rights;
+  if (EventDispatcher::Create(0, &event, &rights) != ZX_OK) {
+    return HandleOwner();
+  }
+  return Handle::Make(ktl::move(event), rights);
+}
+
+bool TestReadySubset() {
+  BEGIN_TEST;
+
+  constexpr size_t kNumEvents = 4;
+  HandleOwner events[kNumEvents];
+  WaitSet wait_set;
+  for (size_t i = 0; i < kNumEvents; i++) {
+    events[i] = CreateEvent();
+    ASSERT_TRUE(events[i]);
+    ASSERT_EQ(ZX_OK, wait_set.Add(events[i].get(), ZX_USER_SIGNAL_0, i));
+  }
+  EXPECT_EQ(kNumEvents, wait_set.size());
+  EXPECT_EQ(ZX_ERR_ALREADY_EXISTS, wait_set.Add(events[0].get(), ZX_USER_SIGNAL_0, 0));
+
+  WaitSet::Result results[kNumEvents];
+  size_t count = 0;
+  EXPECT_EQ(ZX_ERR_TIMED_OUT,
+            wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+
+  // Only the signaled entries are reported.
+  ASSERT_EQ(ZX_OK, events[1]->dispatcher()->user_signal_self(0, ZX_USER_SIGNAL_0));
+  ASSERT_EQ(ZX_OK, events[3]->dispatcher()->user_signal_self(0, ZX_USER_SIGNAL_0));
+  ASSERT_EQ(ZX_OK, wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+  ASSERT_EQ(2u, count);
+  EXPECT_EQ(1u, results[0].key);
+  EXPECT_EQ(3u, results[1].key);
+  EXPECT_TRUE(results[0].signals & ZX_USER_SIGNAL_0);
+
+  // Entries stay ready for as long as their signals are asserted.
+  ASSERT_EQ(ZX_OK, wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+  EXPECT_EQ(2u, count);
+
+  // A short result buffer rotates through the ready entries.
+  ASSERT_EQ(ZX_OK, wait_set.Wait(Deadline::infinite_past(), ktl::span(results, 1), &count));
+  ASSERT_EQ(1u, count);
+  EXPECT_EQ(1u, results[0].key);
+  ASSERT_EQ(ZX_OK, wait_set.Wait(Deadline::infinite_past(), ktl::span(results, 1), &count));
+  ASSERT_EQ(1u, count);
+  EXPECT_EQ(3u, results[0].key);
+
+  // Deasserted entries drop out until they match again.
+  ASSERT_EQ(ZX_OK, events[1]->dispatcher()->user_signal_self(ZX_USER_SIGNAL_0, 0));
+  ASSERT_EQ(ZX_OK, wait_set.Remove(3));
+  EXPECT_EQ(ZX_ERR_NOT_FOUND, wait_set.Remove(3));
+  EXPECT_EQ(ZX_ERR_TIMED_OUT,
+            wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+  ASSERT_EQ(ZX_OK, events[1]->dispatcher()->user_signal_self(0, ZX_USER_SIGNAL_0));
+  ASSERT_EQ(ZX_OK, wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+  ASSERT_EQ(1u, count);
+  EXPECT_EQ(1u, results[0].key);
+
+  wait_set.Clear();
+  EXPECT_EQ(0u, wait_set.size());
+
+  END_TEST;
+}
+
+bool TestHandleClosed() {
+  BEGIN_TEST;
+
+  HandleOwner event = CreateEvent();
+  ASSERT_TRUE(event);
+  WaitSet wait_set;
+  ASSERT_EQ(ZX_OK, wait_set.Add(event.get(), ZX_USER_SIGNAL_0, 7));
+
+  // Closing the handle reports the entry once and then drops it.
+  event.reset();
+  WaitSet::Result results[1];
+  size_t count = 0;
+  ASSERT_EQ(ZX_OK, wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+  ASSERT_EQ(1u, count);
+  EXPECT_EQ(7u, results[0].key);
+  EXPECT_TRUE(results[0].signals & ZX_SIGNAL_HANDLE_CLOSED);
+  EXPECT_EQ(0u, wait_set.size());
+  EXPECT_EQ(ZX_ERR_TIMED_OUT,
+            wait_set.Wait(Deadline::infinite_past(), ktl::span(results), &count));
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(wait_set_tests)
+UNITTEST("TestReadySubset", TestReadySubset)
+UNITTEST("TestHandleClosed", TestHandleClosed)
+UNITTEST_END_TESTCASE(wait_set_tests, "wait_set_tests", "WaitSet tests")
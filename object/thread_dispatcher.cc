@@ -24,6 +24,8 @@
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <kernel/thread.h>
+#include <lk/init.h>
+#include <object/dispatcher_cache.h>
 #include <object/exception_dispatcher.h>
 #include <object/handle.h>
 #include <object/job_dispatcher.h>
@@ -38,6 +40,44 @@
 
 KCOUNTER(dispatcher_thread_create_count, "dispatcher.thread.create")
 KCOUNTER(dispatcher_thread_destroy_count, "dispatcher.thread.destroy")
+KCOUNTER(dispatcher_thread_cache_slabs, "dispatcher.thread.cache.slabs")
+
+namespace {
+
+// Counts the slabs of the thread cache on top of the totals for all object caches.
+struct ThreadCacheAllocator : object_cache::DefaultAllocator {
+  static void CountSlabAllocation() {
+    DefaultAllocator::CountSlabAllocation();
+    kcounter_add(dispatcher_thread_cache_slabs, 1);
+  }
+  static void CountSlabFree() {
+    DefaultAllocator::CountSlabFree();
+    kcounter_add(dispatcher_thread_cache_slabs, -1);
+  }
+};
+
+DispatcherCache<ThreadDispatcher, ThreadCacheAllocator> thread_cache;
+
+// Returns the CPUs a deadline reservation may be made on for a thread with
+// these affinities, following SchedulerState::GetEffectiveCpuMask: the soft
+// affinity is honored unless it leaves no CPU in the hard affinity.
+cpu_mask_t DeadlineAdmissionAffinity(cpu_mask_t hard_affinity, cpu_mask_t soft_affinity) {
+  const cpu_mask_t affinity = hard_affinity & soft_affinity;
+  return affinity.any() ? affinity : hard_affinity;
+}
+
+void thread_cache_init(uint level) { thread_cache.Init(); }
+
+}  // namespace
+
+void* ThreadDispatcher::operator new(size_t size, fbl::AllocChecker* ac) noexcept {
+  return thread_cache.Allocate(size, ac);
+}
+
+void ThreadDispatcher::operator delete(void* ptr, size_t size) { thread_cache.Free(ptr, size); }
+
+// Initialize the cache after the percpu data structures are initialized.
+LK_INIT_HOOK(thread_dispatcher_cache_init, thread_cache_init, LK_INIT_LEVEL_KERNEL)
 
 // static
 zx_status_t ThreadDispatcher::Create(fbl::RefPtr<ProcessDispatcher> process, uint32_t flags,
@@ -89,6 +129,10 @@ ThreadDispatcher::~ThreadDispatcher() {
                    "Thread %p killed in bad state: %s\n", this,
                    ThreadLifecycleToString(state_.lifecycle()));
 
+  // A thread that was given a deadline profile but never started does not go
+  // through ExitingCurrent, so its reservation is released here.
+  DeadlineAdmission::Release(deadline_reservation_);
+
   if (state_.lifecycle() != ThreadState::Lifecycle::INITIAL) {
     // We grew the pool in Initialize(), which transitioned the thread from its
     // inintial state.
@@ -351,10 +395,14 @@ void ThreadDispatcher::ExitingCurrent() {
 
   LTRACE_ENTRY_OBJ;
 
-  // Set ourselves in the DYING state before calling the Debugger.
+  // Set ourselves in the DYING state before calling the Debugger. Dying
+  // threads cannot have their profile changed, so any deadline reservation can
+  // be released now.
   {
     Guard<CriticalMutex> guard{get_lock()};
     SetStateLocked(ThreadState::Lifecycle::DYING);
+    DeadlineAdmission::Release(deadline_reservation_);
+    deadline_reservation_ = {};
   }
 
   // Notify a debugger if attached. Do this before marking the thread as
@@ -590,11 +638,11 @@ zx_info_thread_t ThreadDispatcher::GetInfoForUserspace() const {
   }
 
   // Get CPU affinity.
-  //
-  // We assume that we can fit the entire mask in the first word of
-  // cpu_affinity_mask.
-  static_assert(SMP_MAX_CPUS <= sizeof(info.cpu_affinity_mask.mask[0]) * 8);
-  info.cpu_affinity_mask.mask[0] = core_thread_->GetSoftCpuAffinity();
+  static_assert(SMP_MAX_CPUS <= ZX_CPU_SET_MAX_CPUS);
+  const cpu_mask_t affinity = core_thread_->GetSoftCpuAffinity();
+  for (size_t i = 0; i < CpuMask::kWords; i++) {
+    info.cpu_affinity_mask.mask[i] = affinity.word(i);
+  }
 
   return info;
 }
@@ -638,6 +686,16 @@ void ThreadDispatcher::AddLockContentionTicks(zx_duration_mono_ticks_t ticks) {
   runtime_stats_.AddLockContentionTicks(ticks);
 }
 
+void ThreadDispatcher::AddMigration() {
+  canary_.Assert();
+  runtime_stats_.AddMigration();
+}
+
+void ThreadDispatcher::AddMemoryStallTicks(zx_duration_mono_ticks_t ticks) {
+  canary_.Assert();
+  runtime_stats_.AddMemoryStallTicks(ticks);
+}
+
 zx_status_t ThreadDispatcher::GetExceptionReport(zx_exception_report_t* report) {
   canary_.Assert();
 
@@ -868,7 +926,25 @@ zx_status_t ThreadDispatcher::SetBaseProfile(const SchedulerState::BaseProfile&
     return ZX_ERR_BAD_STATE;
   }
 
-  // The profile was already validated by the Profile dispatcher.
+  // The profile was already validated by the Profile dispatcher, but deadline
+  // profiles must also fit in the remaining capacity of the thread's CPUs.
+  if (DeadlineAdmission::IsEnabled()) {
+    if (profile.IsDeadline()) {
+      zx::result<DeadlineAdmission::Reservation> reservation = DeadlineAdmission::Admit(
+          profile.deadline.utilization,
+          DeadlineAdmissionAffinity(core_thread_->GetCpuAffinity(),
+                                    core_thread_->GetSoftCpuAffinity()),
+          deadline_reservation_);
+      if (reservation.is_error()) {
+        return reservation.error_value();
+      }
+      deadline_reservation_ = reservation.value();
+    } else {
+      DeadlineAdmission::Release(deadline_reservation_);
+      deadline_reservation_ = {};
+    }
+  }
+
   core_thread_->SetBaseProfile(profile);
   return ZX_OK;
 }
@@ -880,7 +956,17 @@ zx_status_t ThreadDispatcher::SetSoftAffinity(cpu_mask_t mask) {
       (state_.lifecycle() == ThreadState::Lifecycle::DEAD)) {
     return ZX_ERR_BAD_STATE;
   }
-  // The mask was already validated by the Profile dispatcher.
+  // The mask was already validated by the Profile dispatcher, but a deadline
+  // reservation must be moved to a CPU the thread may now run on.
+  if (deadline_reservation_.is_valid()) {
+    zx::result<DeadlineAdmission::Reservation> reservation = DeadlineAdmission::Admit(
+        deadline_reservation_.utilization,
+        DeadlineAdmissionAffinity(core_thread_->GetCpuAffinity(), mask), deadline_reservation_);
+    if (reservation.is_error()) {
+      return reservation.error_value();
+    }
+    deadline_reservation_ = reservation.value();
+  }
   core_thread_->SetSoftCpuAffinity(mask);
   return ZX_OK;
 }
@@ -16,9 +16,41 @@
 
 #include <fbl/alloc_checker.h>
 #include <kernel/thread.h>
+#include <lk/init.h>
+#include <object/dispatcher_cache.h>
 
 KCOUNTER(dispatcher_timer_create_count, "dispatcher.timer.create")
 KCOUNTER(dispatcher_timer_destroy_count, "dispatcher.timer.destroy")
+KCOUNTER(dispatcher_timer_cache_slabs, "dispatcher.timer.cache.slabs")
+
+namespace {
+
+// Counts the slabs of the timer cache on top of the totals for all object caches.
+struct TimerCacheAllocator : object_cache::DefaultAllocator {
+  static void CountSlabAllocation() {
+    DefaultAllocator::CountSlabAllocation();
+    kcounter_add(dispatcher_timer_cache_slabs, 1);
+  }
+  static void CountSlabFree() {
+    DefaultAllocator::CountSlabFree();
+    kcounter_add(dispatcher_timer_cache_slabs, -1);
+  }
+};
+
+DispatcherCache<TimerDispatcher, TimerCacheAllocator> timer_cache;
+
+void timer_cache_init(uint level) { timer_cache.Init(); }
+
+}  // namespace
+
+void* TimerDispatcher::operator new(size_t size, fbl::AllocChecker* ac) noexcept {
+  return timer_cache.Allocate(size, ac);
+}
+
+void TimerDispatcher::operator delete(void* ptr, size_t size) { timer_cache.Free(ptr, size); }
+
+// Initialize the cache after the percpu data structures are initialized.
+LK_INIT_HOOK(timer_dispatcher_cache_init, timer_cache_init, LK_INIT_LEVEL_KERNEL)
 
 static void timer_irq_callback(Timer* timer, zx_time_t now, void* arg) {
   // We are in IRQ context and cannot touch the timer state_tracker, so we
@@ -44,7 +44,7 @@ zx_status_t get_user_handles_to_consume(user_in_ptr<const zx_handle_t> user_hand
 
 zx_status_t get_user_handles_to_consume(user_inout_ptr<zx_handle_disposition_t> user_handles,
                                         size_t offset, size_t chunk_size, zx_handle_t* handles) {
-  zx_handle_disposition_t local_handle_disposition[kMaxMessageHandles] = {};
+  __UNINITIALIZED zx_handle_disposition_t local_handle_disposition[kMaxMessageHandles];
 
   chunk_size = ktl::min<size_t>(chunk_size, kMaxMessageHandles);
 
@@ -57,9 +57,9 @@ zx_status_t get_user_handles_to_consume(user_inout_ptr<zx_handle_disposition_t>
   for (size_t i = 0; i < chunk_size; i++) {
     // !ZX_HANDLE_OP_DUPLICATE is used to capture the case where we failed
     // due to a bad operational arg.
-    if (local_handle_disposition[i].operation != ZX_HANDLE_OP_DUPLICATE) {
-      handles[i] = local_handle_disposition[i].handle;
-    }
+    handles[i] = local_handle_disposition[i].operation != ZX_HANDLE_OP_DUPLICATE
+                     ? local_handle_disposition[i].handle
+                     : ZX_HANDLE_INVALID;
   }
   return ZX_OK;
 }
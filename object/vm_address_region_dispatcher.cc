@@ -16,6 +16,8 @@
 #include <zircon/types.h>
 
 #include <fbl/alloc_checker.h>
+#include <object/async_prefetch.h>
+#include <object/port_dispatcher.h>
 #include <vm/vm_address_region.h>
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
@@ -24,6 +26,7 @@
 
 KCOUNTER(dispatcher_vmar_create_count, "dispatcher.vmar.create")
 KCOUNTER(dispatcher_vmar_destroy_count, "dispatcher.vmar.destroy")
+KCOUNTER(dispatcher_vmar_async_prefetch_count, "dispatcher.vmar.async_prefetch")
 
 namespace {
 
@@ -258,6 +261,26 @@ zx_status_t VmAddressRegionDispatcher::RangeOp(uint32_t op, vaddr_t base, size_t
   return ZX_ERR_INVALID_ARGS;
 }
 
+zx_status_t VmAddressRegionDispatcher::PrefetchAsync(vaddr_t base, size_t len,
+                                                     zx_rights_t rights,
+                                                     fbl::RefPtr<PortDispatcher> port,
+                                                     uint64_t key) {
+  canary_.Assert();
+
+  const VmAddressRegionOpChildren op_children = op_children_from_rights(rights);
+  zx_status_t status = QueueAsyncPrefetch(
+      [vmar = vmar_, base, len, op_children]() {
+        return vmar->RangeOp(VmAddressRegion::RangeOpType::Prefetch, base, len, op_children,
+                             user_inout_ptr<void>(nullptr), 0);
+      },
+      ktl::move(port), key, base, len);
+  if (status != ZX_OK) {
+    return status;
+  }
+  kcounter_add(dispatcher_vmar_async_prefetch_count, 1);
+  return ZX_OK;
+}
+
 zx_status_t VmAddressRegionDispatcher::Unmap(vaddr_t base, size_t len,
                                              VmAddressRegionOpChildren op_children) {
   canary_.Assert();
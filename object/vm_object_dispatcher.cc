@@ -18,6 +18,8 @@
 #include <ktl/algorithm.h>
 #include <ktl/atomic.h>
 #include <ktl/optional.h>
+#include <object/async_prefetch.h>
+#include <object/port_dispatcher.h>
 #include <vm/page_source.h>
 #include <vm/vm_aspace.h>
 #include <vm/vm_object.h>
@@ -29,6 +31,7 @@
 
 KCOUNTER(dispatcher_vmo_create_count, "dispatcher.vmo.create")
 KCOUNTER(dispatcher_vmo_destroy_count, "dispatcher.vmo.destroy")
+KCOUNTER(dispatcher_vmo_async_prefetch_count, "dispatcher.vmo.async_prefetch")
 
 zx::result<VmObjectDispatcher::CreateStats> VmObjectDispatcher::parse_create_syscall_flags(
     uint32_t flags, size_t size) {
@@ -516,6 +519,25 @@ zx_status_t VmObjectDispatcher::RangeOp(uint32_t op, uint64_t offset, uint64_t s
   }
 }
 
+zx_status_t VmObjectDispatcher::PrefetchAsync(uint64_t offset, uint64_t size,
+                                              fbl::RefPtr<PortDispatcher> port, uint64_t key) {
+  canary_.Assert();
+
+  uint64_t end;
+  if (add_overflow(offset, size, &end)) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+
+  zx_status_t status = QueueAsyncPrefetch(
+      [vmo = vmo_, offset, size]() { return vmo->PrefetchRange(offset, size); }, ktl::move(port),
+      key, offset, size);
+  if (status != ZX_OK) {
+    return status;
+  }
+  kcounter_add(dispatcher_vmo_async_prefetch_count, 1);
+  return ZX_OK;
+}
+
 zx_status_t VmObjectDispatcher::SetMappingCachePolicy(uint32_t cache_policy) {
   return vmo_->SetMappingCachePolicy(cache_policy);
 }
@@ -0,0 +1,184 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include "object/wait_set.h"
+
+#include <assert.h>
+
+#include <fbl/alloc_checker.h>
+#include <object/handle.h>
+
+#include <ktl/enforce.h>
+
+WaitSet::~WaitSet() { Clear(); }
+
+zx_status_t WaitSet::Add(Handle* handle, zx_signals_t signals, uint64_t key) {
+  fbl::RefPtr<Dispatcher> dispatcher = handle->dispatcher();
+  if (!dispatcher->is_waitable()) {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<Entry> entry(new (&ac) Entry(this, ktl::move(dispatcher), signals, key));
+  if (!ac.check()) {
+    return ZX_ERR_NO_MEMORY;
+  }
+
+  // Only destroyed, on failure, once |lock_| has been dropped.
+  ktl::unique_ptr<Entry> failed;
+  Guard<CriticalMutex> guard{&lock_};
+  if (entries_.find(key).IsValid()) {
+    return ZX_ERR_ALREADY_EXISTS;
+  }
+  Entry* raw = entry.get();
+  entries_.insert(ktl::move(entry));
+
+  // If |signals| are already active this makes the entry ready right away.
+  zx_status_t status = raw->dispatcher_->AddObserver(raw, handle, signals);
+  if (status != ZX_OK) {
+    DetachLocked(raw);
+    failed = entries_.erase(*raw);
+  }
+  return status;
+}
+
+zx_status_t WaitSet::Remove(uint64_t key) {
+  ktl::unique_ptr<Entry> entry;
+  Guard<CriticalMutex> guard{&lock_};
+  auto it = entries_.find(key);
+  if (!it.IsValid()) {
+    return ZX_ERR_NOT_FOUND;
+  }
+  DetachLocked(&*it);
+  entry = entries_.erase(it);
+  return ZX_OK;
+}
+
+void WaitSet::Clear() {
+  EntryTree entries;
+  {
+    Guard<CriticalMutex> guard{&lock_};
+    for (Entry& entry : entries_) {
+      DetachLocked(&entry);
+    }
+    entries_.swap(entries);
+  }
+  entries.clear();
+}
+
+size_t WaitSet::size() const {
+  Guard<CriticalMutex> guard{&lock_};
+  return entries_.size();
+}
+
+zx_status_t WaitSet::Wait(const Deadline& deadline, ktl::span<Result> results, size_t* count) {
+  if (results.empty()) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+
+  EntryTree dead;
+  for (;;) {
+    {
+      Guard<CriticalMutex> guard{&lock_};
+      *count = HarvestLocked(results, &dead);
+    }
+    if (*count > 0) {
+      return ZX_OK;
+    }
+    // Every ready entry turned out to be stale. Wait for the next match.
+    zx_status_t status = event_.Wait(deadline);
+    if (status != ZX_OK) {
+      return status;
+    }
+  }
+}
+
+void WaitSet::DetachLocked(Entry* entry) {
+  // Once this returns the entry can no longer be matched, so it will not be put back on the
+  // ready list. It may already have been removed if its handle was closed.
+  entry->dispatcher_->RemoveObserver(entry);
+
+  Guard<CriticalMutex> guard{&ready_lock_};
+  if (entry->ready_node_.InContainer()) {
+    ready_.erase(*entry);
+  }
+}
+
+size_t WaitSet::HarvestLocked(ktl::span<Result> results, EntryTree* dead) {
+  size_t remaining;
+  {
+    Guard<CriticalMutex> guard{&ready_lock_};
+    remaining = ready_.size();
+  }
+
+  // Look at each entry that was ready on entry at most once. Entries that are still asserting
+  // go back on the tail so that a small |results| does not starve the rest of the set.
+  size_t count = 0;
+  for (; count < results.size() && remaining > 0; --remaining) {
+    Entry* entry;
+    bool canceled;
+    zx_signals_t signals;
+    {
+      Guard<CriticalMutex> guard{&ready_lock_};
+      entry = ready_.pop_front();
+      if (entry == nullptr) {
+        break;
+      }
+      canceled = entry->canceled_;
+      signals = entry->canceled_signals_;
+    }
+    entry->canary_.Assert();
+
+    if (canceled) {
+      results[count++] = {entry->key_, signals | ZX_SIGNAL_HANDLE_CLOSED};
+      dead->insert(entries_.erase(*entry));
+      continue;
+    }
+
+    // The entry was taken off the ready list before sampling its signals, so a match that races
+    // with this either shows up here or puts the entry back on the ready list.
+    signals = entry->dispatcher_->PollSignals();
+    if ((signals & entry->signals_) == 0) {
+      continue;
+    }
+    results[count++] = {entry->key_, signals};
+
+    Guard<CriticalMutex> guard{&ready_lock_};
+    if (!entry->ready_node_.InContainer()) {
+      ready_.push_back(entry);
+    }
+  }
+
+  Guard<CriticalMutex> guard{&ready_lock_};
+  if (ready_.is_empty()) {
+    event_.Unsignal();
+  }
+  return count;
+}
+
+void WaitSet::Entry::OnMatch(zx_signals_t signals) {
+  canary_.Assert();
+
+  Guard<CriticalMutex> guard{&set_->ready_lock_};
+  if (!ready_node_.InContainer()) {
+    set_->ready_.push_back(this);
+  }
+  set_->event_.Signal();
+}
+
+void WaitSet::Entry::OnCancel(zx_signals_t signals) {
+  canary_.Assert();
+
+  // The dispatcher has already dropped this observer. Leave it ready so that the next Wait()
+  // can report the closed handle and reap it.
+  Guard<CriticalMutex> guard{&set_->ready_lock_};
+  canceled_ = true;
+  canceled_signals_ = signals;
+  if (!ready_node_.InContainer()) {
+    set_->ready_.push_back(this);
+  }
+  set_->event_.Signal();
+}
@@ -11,6 +11,7 @@
 #include <lib/memalloc/pool.h>
 #include <lib/memalloc/range.h>
 #include <lib/uart/uart.h>
+#include <string.h>
 #include <zircon/limits.h>
 #include <zircon/types.h>
 
@@ -19,6 +20,7 @@
 #include <ktl/byte.h>
 #include <ktl/optional.h>
 #include <ktl/ref.h>
+#include <ktl/tuple.h>
 #include <ktl/type_traits.h>
 #include <ktl/utility.h>
 #include <phys/stdio.h>
@@ -44,6 +46,48 @@ void AddressSpace::AllocateRootPageTables() {
   }
 }
 
+ktl::optional<uint64_t> AddressSpace::AllocatePageTableFromRun(memalloc::Type type,
+                                                               PageTableRun& run, uint64_t size,
+                                                               uint64_t alignment) {
+  uint64_t addr = fbl::round_up(run.next, alignment);
+  if (run.next == 0 || addr + size > run.end) {
+    ReleasePageTableRun(run);
+
+    memalloc::Pool& pool = Allocation::GetPool();
+    const uint64_t run_size = ktl::max(size, kPageTableRunSize);
+    auto result = pool.Allocate(type, run_size, ktl::max<uint64_t>(alignment, ZX_PAGE_SIZE),
+                                pt_allocation_lower_bound_, pt_allocation_upper_bound_);
+    if (result.is_error()) {
+      // Memory within the bounds may be too tight for a whole run.
+      result = pool.Allocate(type, size, alignment, pt_allocation_lower_bound_,
+                             pt_allocation_upper_bound_);
+      if (result.is_error()) {
+        return ktl::nullopt;
+      }
+      memset(reinterpret_cast<void*>(result.value()), 0, static_cast<size_t>(size));
+      return result.value();
+    }
+    addr = result.value();
+    run = {.next = addr, .end = addr + run_size};
+    memset(reinterpret_cast<void*>(addr), 0, static_cast<size_t>(run_size));
+  }
+  run.next = addr + size;
+  return addr;
+}
+
+void AddressSpace::ReleasePageTableRun(PageTableRun& run) {
+  if (run.next < run.end) {
+    // On failure the remainder just stays allocated as page tables.
+    ktl::ignore = Allocation::GetPool().Free(run.next, run.end - run.next);
+  }
+  run = {};
+}
+
+void AddressSpace::ReleasePageTableRuns() {
+  ReleasePageTableRun(temporary_run_);
+  ReleasePageTableRun(permanent_run_);
+}
+
 void AddressSpace::IdentityMapRam() {
   memalloc::Pool& pool = Allocation::GetPool();
 
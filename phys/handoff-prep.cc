@@ -20,6 +20,7 @@
 
 #include <ktl/tuple.h>
 #include <ktl/utility.h>
+#include <phys/address-space.h>
 #include <phys/allocation.h>
 #include <phys/arch/arch-handoff.h>
 #include <phys/elf-image.h>
@@ -439,6 +440,7 @@ PhysElfImage HandoffPrep::MakePhysElfImage(KernelStorage::Bootfs::iterator file,
 
   // This must be called last, as this finalizes the state of memory to hand off
   // to the kernel, which is affected by other set-up routines.
+  gAddressSpace->ReleasePageTableRuns();
   SetMemory();
 
   // One last log before the next line where we effectively disable logging
@@ -451,6 +453,7 @@ PhysElfImage HandoffPrep::MakePhysElfImage(KernelStorage::Bootfs::iterator file,
 
   // Now that all time samples have been collected, copy gBootTimes into the
   // hand-off.
+  gBootTimes.SampleNow(PhysBootTimes::kHandoffPrepared);
   handoff()->times = gBootTimes;
 
   // Now for the remaining arch-specific settings and the actual hand-off...
@@ -138,6 +138,7 @@ class AddressSpace {
   // this method comes in handy.
   void SetPageTableAllocationBounds(ktl::optional<uint64_t> low, ktl::optional<uint64_t> high) {
     ZX_ASSERT(!low || !high || *low <= *high);
+    ReleasePageTableRuns();
     pt_allocation_lower_bound_ = low;
     pt_allocation_upper_bound_ = high;
   }
@@ -147,6 +148,11 @@ class AddressSpace {
   // ArchCreatePagingState().
   template <typename... Args>
   void Init(Args&&... args) {
+    // Anything left of the current runs (see ReleasePageTableRuns()) is
+    // forgotten rather than freed, as the caller may already have reclaimed
+    // that memory for something else.
+    temporary_run_ = {};
+    permanent_run_ = {};
     AllocateRootPageTables();
     state_ = ArchCreatePagingState(ktl::forward<Args>(args)...);
   }
@@ -198,6 +204,13 @@ class AddressSpace {
     gAddressSpace = const_cast<AddressSpace*>(this);
   }
 
+  // Page tables are allocated from the pool in runs of kPageTableRunSize
+  // bytes, so that mapping a lot of memory (e.g., the physmap) doesn't cost a
+  // pool allocation per table. This returns the unused remainder of each run
+  // to the pool, and must be called before the pool is finalized for the next
+  // boot stage. Tables allocated after this just start new runs.
+  void ReleasePageTableRuns();
+
   // Install new lower and upper root page tables.
   template <bool DualSpaces = kDualSpaces, typename = ktl::enable_if_t<DualSpaces>>
   void InstallNewRootTables(uint64_t new_lower_root_paddr, uint64_t new_upper_root_paddr) {
@@ -250,18 +263,27 @@ class AddressSpace {
     return reinterpret_cast<Table*>(paddr)->direct_io();
   };
 
+  static constexpr uint64_t kPageTableRunSize = 16 * ZX_PAGE_SIZE;
+
+  // The zeroed, not yet used part of an allocated run of page tables.
+  struct PageTableRun {
+    uint64_t next = 0;
+    uint64_t end = 0;
+  };
+
   template <memalloc::Type AllocationType>
   ktl::optional<uint64_t> AllocatePageTable(uint64_t size, uint64_t alignment) {
-    auto result = Allocation::GetPool().Allocate(
-        AllocationType, size, alignment, pt_allocation_lower_bound_, pt_allocation_upper_bound_);
-    if (result.is_error()) {
-      return ktl::nullopt;
-    }
-    auto addr = static_cast<uintptr_t>(result.value());
-    memset(reinterpret_cast<void*>(addr), 0, static_cast<size_t>(size));
-    return addr;
+    static_assert(AllocationType == memalloc::Type::kTemporaryIdentityPageTables ||
+                  AllocationType == memalloc::Type::kKernelPageTables);
+    PageTableRun& run = AllocationType == memalloc::Type::kKernelPageTables ? permanent_run_
+                                                                            : temporary_run_;
+    return AllocatePageTableFromRun(AllocationType, run, size, alignment);
   }
 
+  ktl::optional<uint64_t> AllocatePageTableFromRun(memalloc::Type type, PageTableRun& run,
+                                                   uint64_t size, uint64_t alignment);
+  static void ReleasePageTableRun(PageTableRun& run);
+
   // An allocator of temporary, identity-mapping page tables, used in the following cases:
   // * When kDualSpaces is true, the lower root page table.
   // * Non-root tables for pages in the lower address space.
@@ -285,6 +307,10 @@ class AddressSpace {
   // See SetPageTableAllocationBounds() above.
   ktl::optional<uint64_t> pt_allocation_lower_bound_;
   ktl::optional<uint64_t> pt_allocation_upper_bound_;
+
+  // See ReleasePageTableRuns() above.
+  PageTableRun temporary_run_;
+  PageTableRun permanent_run_;
 };
 
 #endif  // ZIRCON_KERNEL_PHYS_INCLUDE_PHYS_ADDRESS_SPACE_H_
@@ -68,7 +68,9 @@ class PhysBootTimes {
     kPhysSetup,        // Earliest/arch-specific phys setup (e.g. paging).
     kDecompressStart,  // Begin decompression.
     kDecompressEnd,    // STORAGE_KERNEL decompressed.
+    kKernelLoaded,     // Kernel ELF image loaded, patched and relocated.
     kZbiDone,          // ZBI items have been ingested.
+    kHandoffPrepared,  // Hand-off data and kernel address space are complete.
     kCount
   };
 
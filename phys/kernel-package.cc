@@ -91,6 +91,14 @@ void KernelStorage::Init(Zbi zbi) {
   // the real kernel payload (which is usually compressed).
   decompress_start_ts_ = arch::EarlyTicks::Get();
 
+  // The whole item is a single BOOTFS image, compressed as a single zstd
+  // stream, and the kernel package has to be found by name in its directory.
+  // So there's no way to decompress only the parts that are used: the cost
+  // here is proportional to the whole item, i.e. every kernel package in it.
+  // Where that dominates boot time, the item can be stored uncompressed so
+  // this is only a copy, or the image can be built with a single package.
+  const bool compressed = item_->header->flags & ZBI_FLAGS_STORAGE_COMPRESSED;
+
   if (auto result = zbi_.CopyStorageItem(data(), item_, ZbitlScratchAllocator); result.is_error()) {
     printf("%s: Cannot load STORAGE_KERNEL item (uncompressed size %#x): ", ProgramName(),
            storage_size);
@@ -101,7 +109,8 @@ void KernelStorage::Init(Zbi zbi) {
   // This marks just the decompression (or copying) time.
   decompress_end_ts_ = arch::EarlyTicks::Get();
 
-  debugf("%s: STORAGE_KERNEL decompressed %s -> %s\n", ProgramName(),
+  debugf("%s: STORAGE_KERNEL %s %s -> %s\n", ProgramName(),
+         compressed ? "decompressed" : "copied",
          pretty::FormattedBytes(item_->header->length).c_str(),
          pretty::FormattedBytes(storage_size).c_str());
 
@@ -96,6 +96,7 @@ void RelocateElfKernel(ElfImage& kernel) {
   PatchElfKernel(kernel, patch_info);
 
   RelocateElfKernel(kernel);
+  gBootTimes.SampleNow(PhysBootTimes::kKernelLoaded);
 
   if (kernel.memory_image().size_bytes() > KERNEL_IMAGE_MAX_SIZE) {
     ZX_PANIC(
@@ -39,7 +39,9 @@
 #include <kernel/cpu.h>
 #include <kernel/cpu_distance_map.h>
 #include <kernel/dpc.h>
+#include <kernel/mp.h>
 #include <kernel/persistent_ram.h>
+#include <kernel/queued_spinlock.h>
 #include <kernel/spinlock.h>
 #include <kernel/topology.h>
 #include <ktl/algorithm.h>
@@ -91,7 +93,7 @@ static void halt_other_cpus(void) {
   if (halted.exchange(1) == 0) {
     // stop the other cpus
     printf("stopping other cpus\n");
-    arch_mp_send_ipi(mp_ipi_target::ALL_BUT_LOCAL, 0, mp_ipi::HALT);
+    arch_mp_send_ipi(mp_ipi_target::ALL_BUT_LOCAL, {}, mp_ipi::HALT);
 
     // spin for a while
     // TODO: find a better way to spin at this low level
@@ -120,6 +122,7 @@ static uint64_t ToMpid(const zbi_topology_processor_t& processor) {
 void platform_panic_start(PanicStartHaltOtherCpus option) {
   arch_disable_ints();
   dlog_panic_start();
+  queued_spinlock::EnterPanicMode();
 
   if (option == PanicStartHaltOtherCpus::Yes) {
     halt_other_cpus();
@@ -200,11 +203,13 @@ zx_status_t platform_suspend_cpu(PlatformAllowDomainPowerDown allow_domain) {
 zx_status_t platform_start_cpu(cpu_num_t cpu_id, uint64_t mpid) {
   paddr_t kernel_secondary_entry_paddr = KernelPhysicalAddressOf<arm64_secondary_start>();
 
+  mp_record_boot_stage(cpu_id, mp_boot_stage::START);
   uint32_t ret = power_cpu_on(mpid, kernel_secondary_entry_paddr, 0);
-  dprintf(INFO, "Trying to start cpu %u, mpid %#" PRIx64 " returned: %d\n", cpu_id, mpid, (int)ret);
   if (ret != 0) {
+    dprintf(INFO, "Failed to start cpu %u, mpid %#" PRIx64 ": %d\n", cpu_id, mpid, (int)ret);
     return ZX_ERR_INTERNAL;
   }
+  dprintf(SPEW, "Started cpu %u, mpid %#" PRIx64 "\n", cpu_id, mpid);
   return ZX_OK;
 }
 
@@ -224,6 +229,10 @@ static void topology_cpu_init(void) {
   arch_clean_cache_range(reinterpret_cast<vaddr_t>(__executable_start),
                          static_cast<size_t>(_end - __executable_start));
 
+  // Create the stacks of all of the secondary processors before starting any of them, so that
+  // they are started back to back and run their per-CPU init concurrently. The boot CPU does not
+  // wait for them here, see mp_all_cpu_startup_sync_hook().
+  cpu_mask_t to_start{};
   for (auto* node : system_topology::GetSystemTopology().processors()) {
     if (node->entity.discriminant != ZBI_TOPOLOGY_ENTITY_PROCESSOR ||
         node->entity.processor.architecture_info.discriminant !=
@@ -231,34 +240,39 @@ static void topology_cpu_init(void) {
       panic("Invalid processor node.");
     }
 
-    zx_status_t status;
     const auto& processor = node->entity.processor;
     for (uint8_t i = 0; i < processor.logical_id_count; i++) {
+      const cpu_num_t cpu = processor.logical_ids[i];
       const uint64_t mpid =
           (processor.logical_id_count > 1) ? ToSmtMpid(processor, i) : ToMpid(processor);
-      arch_register_mpid(processor.logical_ids[i], mpid);
+      arch_register_mpid(cpu, mpid);
 
       // Skip processor 0, we are only starting secondary processors.
-      if (processor.logical_ids[i] == 0) {
+      if (cpu == 0) {
         continue;
       }
 
-      status = arm64_create_secondary_stack(processor.logical_ids[i], mpid);
+      [[maybe_unused]] zx_status_t status = arm64_create_secondary_stack(cpu, mpid);
       DEBUG_ASSERT(status == ZX_OK);
+      to_start |= cpu_num_to_mask(cpu);
+    }
+  }
 
-      // start the cpu
-      status = platform_start_cpu(processor.logical_ids[i], mpid);
-
-      if (status != ZX_OK) {
-        // TODO(maniscalco): Is continuing really the right thing to do here?
+  uint started = 0;
+  cpu_num_t cpu;
+  while ((cpu = remove_cpu_from_mask(to_start)) != INVALID_CPU) {
+    zx_status_t status = platform_start_cpu(cpu, arch_cpu_num_to_mpidr(cpu));
+    if (status != ZX_OK) {
+      // TODO(maniscalco): Is continuing really the right thing to do here?
 
-        // start failed, free the stack
-        status = arm64_free_secondary_stack(processor.logical_ids[i]);
-        DEBUG_ASSERT(status == ZX_OK);
-        continue;
-      }
+      // start failed, free the stack
+      status = arm64_free_secondary_stack(cpu);
+      DEBUG_ASSERT(status == ZX_OK);
+      continue;
     }
+    started++;
   }
+  dprintf(INFO, "Started %u secondary cpus\n", started);
 }
 
 static constexpr zbi_topology_node_t fallback_topology = {
@@ -34,6 +34,7 @@
 #include <fbl/array.h>
 #include <kernel/cpu_distance_map.h>
 #include <kernel/dpc.h>
+#include <kernel/mp.h>
 #include <kernel/jtrace_config.h>
 #include <kernel/persistent_ram.h>
 #include <kernel/spinlock.h>
@@ -95,7 +96,7 @@ static void halt_other_cpus() {
   if (halted.exchange(1) == 0) {
     // stop the other cpus
     printf("stopping other cpus\n");
-    arch_mp_send_ipi(mp_ipi_target::ALL_BUT_LOCAL, 0, mp_ipi::HALT);
+    arch_mp_send_ipi(mp_ipi_target::ALL_BUT_LOCAL, {}, mp_ipi::HALT);
 
     // spin for a while
     // TODO: find a better way to spin at this low level
@@ -172,6 +173,7 @@ static void topology_cpu_init() {
       }
 
       // Try to start the hart.
+      mp_record_boot_stage(processor.logical_ids[i], mp_boot_stage::START);
       riscv64_start_cpu(processor.logical_ids[i], static_cast<uint32_t>(hart_id));
     }
   }
@@ -71,6 +71,17 @@ class InterruptManager {
     return IoApic::FetchIrqConfig(global_irq, tm, pol);
   }
 
+  // Retarget |global_irq| at the local APIC with the physical ID |apic_id|.  The x86 vector, and
+  // so the registered handler, is unchanged.
+  zx_status_t SetInterruptDestination(unsigned int global_irq, uint8_t apic_id) {
+    if (!IoApic::IsValidInterrupt(global_irq, 0 /* flags */)) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+    Guard<SpinLock, IrqSave> guard{&lock_};
+    IoApic::ConfigureIrqDestination(global_irq, apic_id);
+    return ZX_OK;
+  }
+
   // Returns true if the handler was present.  Must be called with
   // interrupts disabled.
   bool InvokeX86Vector(uint8_t x86_vector) { return handler_table_[x86_vector].InvokeIfPresent(); }
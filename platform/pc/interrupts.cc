@@ -10,6 +10,7 @@
 #include <debug.h>
 #include <lib/acpi_lite/apic.h>
 #include <lib/acpi_lite/structures.h>
+#include <lib/counters.h>
 #include <sys/types.h>
 #include <trace.h>
 #include <zircon/types.h>
@@ -17,6 +18,7 @@
 #include <arch/regs.h>
 #include <arch/x86.h>
 #include <arch/x86/feature.h>
+#include <arch/x86/mp.h>
 #include <arch/x86/platform_access.h>
 #include <arch/x86/pv.h>
 #include <dev/interrupt.h>
@@ -30,6 +32,7 @@
 #include <platform/pc/acpi.h>
 #include <platform/pc/memory.h>
 #include <platform/pc/pic.h>
+#include <platform/timer.h>
 
 #include "interrupt_manager.h"
 
@@ -40,6 +43,20 @@ namespace {
 // Values from ioapic to cache for calls to interrupt_get_base_vector / interrupt_get_max_vector
 ktl::optional<GsiRange> x64_gsis;
 
+// Returns the physical APIC ID of the lowest online CPU in |mask|, or nullopt if there is none or
+// its ID does not fit the 8-bit destination field of IOAPIC redirection entries and MSI addresses.
+ktl::optional<uint8_t> TargetApicId(cpu_mask_t mask) {
+  const cpu_mask_t online = mask & mp_get_online_mask();
+  if (!online) {
+    return ktl::nullopt;
+  }
+  const uint32_t apic_id = x86_cpu_num_to_apic_id(online.lowest());
+  if (apic_id > UINT8_MAX) {
+    return ktl::nullopt;
+  }
+  return static_cast<uint8_t>(apic_id);
+}
+
 // Interface passed to InterruptManager to construct the real system interrupt
 // manager.
 class IoApic {
@@ -57,6 +74,9 @@ class IoApic {
                            enum apic_interrupt_dst_mode dst_mode, uint8_t dst, uint8_t vector) {
     apic_io_configure_irq(global_irq, trig_mode, polarity, del_mode, mask, dst_mode, dst, vector);
   }
+  static void ConfigureIrqDestination(uint32_t global_irq, uint8_t dst) {
+    apic_io_configure_irq_destination(global_irq, dst);
+  }
   static void MaskIrq(uint32_t global_irq, bool mask) { apic_io_mask_irq(global_irq, mask); }
   static zx_status_t FetchIrqConfig(uint32_t global_irq, enum interrupt_trigger_mode* trig_mode,
                                     enum interrupt_polarity* polarity) {
@@ -197,6 +217,17 @@ zx_status_t get_interrupt_config(unsigned int vector, enum interrupt_trigger_mod
   return kInterruptManager.GetInterruptConfig(vector, tm, pol);
 }
 
+zx_status_t set_interrupt_affinity(unsigned int vector, cpu_mask_t mask) {
+  const ktl::optional<uint8_t> apic_id = TargetApicId(mask);
+  if (!apic_id) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  return kInterruptManager.SetInterruptDestination(vector, *apic_id);
+}
+
+// Time spent in registered device interrupt handlers, from 128ns up to 2ms.
+KCOUNTER_HISTOGRAM(interrupt_handler_duration_ns, "interrupt.handler_duration_ns", 7)
+
 void platform_irq(iframe_t* frame) {
   CPU_STATS_INC(interrupts);
   // get the current vector
@@ -204,7 +235,10 @@ void platform_irq(iframe_t* frame) {
   DEBUG_ASSERT(x86_vector >= X86_INT_PLATFORM_BASE && x86_vector <= X86_INT_PLATFORM_MAX);
 
   // deliver the interrupt
+  const zx_instant_mono_ticks_t start_ticks = current_mono_ticks();
   kInterruptManager.InvokeX86Vector(static_cast<uint8_t>(x86_vector));
+  interrupt_handler_duration_ns.Add(static_cast<uint64_t>(
+      timer_get_ticks_to_time_ratio().Scale(current_mono_ticks() - start_ticks)));
 
   // NOTE: On x86, we always deactivate the interrupt.
   apic_issue_eoi();
@@ -275,3 +309,17 @@ void msi_free_block(msi_block_t* block) { kInterruptManager.MsiFreeBlock(block);
 void msi_register_handler(const msi_block_t* block, uint msi_id, interrupt_handler_t handler) {
   kInterruptManager.MsiRegisterHandler(block, msi_id, ktl::move(handler));
 }
+
+zx_status_t msi_route_to_cpu(const msi_block_t* block, uint msi_id, cpu_num_t cpu,
+                             uint64_t* out_tgt_addr) {
+  DEBUG_ASSERT(block && block->allocated);
+  DEBUG_ASSERT(msi_id < block->num_irq);
+  const ktl::optional<uint8_t> apic_id = TargetApicId(cpu_num_to_mask(cpu));
+  if (!apic_id) {
+    return ZX_ERR_INVALID_ARGS;
+  }
+  // The destination ID lives in bits 19:12 of the target address, see msi_alloc_block.
+  constexpr uint64_t kDestIdMask = 0xffull << 12;
+  *out_tgt_addr = (block->tgt_addr & ~kDestIdMask) | (static_cast<uint64_t>(*apic_id) << 12);
+  return ZX_OK;
+}
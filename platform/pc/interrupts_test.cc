@@ -43,6 +43,10 @@ class FakeIoApic {
     FakeIoApic::entries[global_irq].trig_mode = trig_mode;
     FakeIoApic::entries[global_irq].polarity = polarity;
   }
+  static void ConfigureIrqDestination(uint32_t global_irq, uint8_t dst) {
+    ZX_ASSERT(global_irq < kIrqCount);
+    FakeIoApic::entries[global_irq].dst = dst;
+  }
   static void MaskIrq(uint32_t global_irq, bool mask) { ZX_ASSERT(global_irq < kIrqCount); }
   static zx_status_t FetchIrqConfig(uint32_t global_irq, enum interrupt_trigger_mode* trig_mode,
                                     enum interrupt_polarity* polarity) {
@@ -63,6 +67,7 @@ class FakeIoApic {
     uint8_t x86_vector;
     enum interrupt_trigger_mode trig_mode;
     enum interrupt_polarity polarity;
+    uint8_t dst;
   };
   static Entry entries[kIrqCount];
 };
@@ -91,6 +96,32 @@ bool TestRegisterInterruptHandler() {
   END_TEST;
 }
 
+bool TestSetInterruptDestination() {
+  BEGIN_TEST;
+
+  FakeIoApic::Reset();
+  fbl::AllocChecker ac;
+  auto im = ktl::make_unique<InterruptManager<FakeIoApic>>(&ac);
+  ASSERT_TRUE(ac.check());
+  ASSERT_EQ(im->Init(), ZX_OK);
+
+  unsigned int kIrq = 1;
+  interrupt_handler_t handler = []() { return; };
+  ASSERT_EQ(im->RegisterInterruptHandler(kIrq, ktl::move(handler)), ZX_OK);
+  const uint8_t x86_vector = FakeIoApic::entries[kIrq].x86_vector;
+
+  // Retargeting leaves the vector, and so the handler, alone.
+  ASSERT_EQ(im->SetInterruptDestination(kIrq, 3), ZX_OK);
+  EXPECT_EQ(FakeIoApic::entries[kIrq].dst, 3);
+  EXPECT_EQ(FakeIoApic::entries[kIrq].x86_vector, x86_vector);
+
+  EXPECT_EQ(im->SetInterruptDestination(X86_INT_COUNT + 1, 3), ZX_ERR_INVALID_ARGS);
+
+  ASSERT_EQ(im->RegisterInterruptHandler(kIrq, nullptr), ZX_OK);
+
+  END_TEST;
+}
+
 bool TestRegisterInterruptHandlerTwice() {
   BEGIN_TEST;
 
@@ -266,6 +297,7 @@ bool TestPvEoi() {
 UNITTEST_START_TESTCASE(pc_interrupt_tests)
 UNITTEST("RegisterInterruptHandler", TestRegisterInterruptHandler)
 UNITTEST("RegisterInterruptHandlerTwice", TestRegisterInterruptHandlerTwice)
+UNITTEST("SetInterruptDestination", TestSetInterruptDestination)
 UNITTEST("UnregisterInterruptHandlerNotRegistered", TestUnregisterInterruptHandlerNotRegistered)
 UNITTEST("RegisterInterruptHandlerTooMany", TestRegisterInterruptHandlerTooMany)
 UNITTEST("HandlerAllocationAlignment", TestHandlerAllocationAlignment)
@@ -20,6 +20,7 @@
 #include <arch/x86/apic.h>
 #include <arch/x86/feature.h>
 #include <arch/x86/mp.h>
+#include <kernel/queued_spinlock.h>
 #include <ktl/atomic.h>
 #include <platform/efi_bootbyte.h>
 #include <platform/pc/keyboard.h>
@@ -38,7 +39,7 @@ const uint8_t kQEMUExitCode = 0x1f;
 static_assert(kQEMUExitCode != 0 && kQEMUExitCode % 2 != 0,
               "QEMU exit code must be non-zero and odd.");
 
-ktl::atomic<cpu_mask_t> halted_cpus(0);
+AtomicCpuMask halted_cpus;
 
 void reboot() {
   // select the default reboot reason
@@ -76,13 +77,13 @@ void halt_other_cpus() {
     // initialized, check the online mask.  If this CPU is the only one online,
     // then simply return.
     cpu_mask_t targets = mp_get_online_mask() & ~cpu_num_to_mask(arch_curr_cpu_num());
-    if (targets == 0) {
+    if (targets.none()) {
       return;
     }
 
     // stop the other cpus
     printf("stopping other cpus\n");
-    arch_mp_send_ipi(mp_ipi_target::ALL_BUT_LOCAL, 0, mp_ipi::HALT);
+    arch_mp_send_ipi(mp_ipi_target::ALL_BUT_LOCAL, {}, mp_ipi::HALT);
 
     // spin for a while
     // TODO: find a better way to spin at this low level
@@ -116,6 +117,7 @@ zx_status_t platform_suspend_cpu(PlatformAllowDomainPowerDown allow_domain) {
 void platform_panic_start(PanicStartHaltOtherCpus option) {
   arch_disable_ints();
   dlog_panic_start();
+  queued_spinlock::EnterPanicMode();
 
   static ktl::atomic<int> panic_started(0);
   if (panic_started.exchange(1) == 0) {
@@ -152,6 +154,7 @@ void platform_specific_halt(platform_halt_action suggested_action, zircon_crash_
       break;
     case HALT_ACTION_HALT:
       printf("Halting...\n");
+      queued_spinlock::EnterPanicMode();
       halt_other_cpus();
       break;
     case HALT_ACTION_REBOOT_BOOTLOADER:
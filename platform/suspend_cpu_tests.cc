@@ -54,7 +54,7 @@ bool one_wakes_another() {
   }
 
   cpu_mask_t active_cpus = Scheduler::PeekActiveMask();
-  if (ktl::popcount(active_cpus) <= 1) {
+  if (active_cpus.count() <= 1) {
     printf("not enough active CPUs, skipping test\n");
     END_TEST;
   }
@@ -0,0 +1,413 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <inttypes.h>
+#include <lib/arch/intrin.h>
+#include <lib/fit/defer.h>
+#include <stdio.h>
+#include <string.h>
+#include <zircon/syscalls/port.h>
+
+#include <fbl/alloc_checker.h>
+#include <kernel/event.h>
+#include <kernel/mp.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
+#include <kernel/timer.h>
+#include <ktl/algorithm.h>
+#include <ktl/atomic.h>
+#include <ktl/bit.h>
+#include <ktl/span.h>
+#include <ktl/unique_ptr.h>
+#include <object/channel_dispatcher.h>
+#include <object/message_packet.h>
+#include <object/port_dispatcher.h>
+#include <vm/fault.h>
+#include <vm/pmm.h>
+#include <vm/vm_address_region.h>
+#include <vm/vm_aspace.h>
+#include <vm/vm_object_paged.h>
+
+#include "tests.h"
+
+#include <ktl/enforce.h>
+
+// Structured benchmarks of hot-path primitives, run with `k bench <suite>`.
+//
+// Each case is sampled repeatedly and reported as one line of key=value pairs giving the min,
+// median and p99 cycles per operation, so that results can be collected and compared across
+// builds. Cases that scale are additionally run on 1, 2, 4, ... CPUs at once, each with its own
+// pinned thread, to give a per-CPU scaling curve.
+
+namespace {
+
+constexpr size_t kSamples = 101;
+
+// Runs |ops| operations, storing the cycles taken by the operations alone in |cycles|. Any setup
+// and teardown is excluded from the measurement.
+using BenchFn = zx_status_t (*)(size_t ops, uint64_t* cycles);
+
+struct BenchCase {
+  const char* name;
+  BenchFn run;
+  size_t ops;
+  // Whether the case is also run concurrently on multiple CPUs.
+  bool scales;
+};
+
+struct BenchSuite {
+  const char* name;
+  ktl::span<const BenchCase> cases;
+};
+
+zx_status_t BenchChannelWriteRead(size_t ops, uint64_t* cycles) {
+  KernelHandle<ChannelDispatcher> handle0, handle1;
+  zx_rights_t rights;
+  zx_status_t status = ChannelDispatcher::Create(&handle0, &handle1, &rights);
+  if (status != ZX_OK) {
+    return status;
+  }
+  ChannelDispatcher* writer = handle0.dispatcher().get();
+  ChannelDispatcher* reader = handle1.dispatcher().get();
+
+  char data[64] = {};
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    MessagePacketPtr msg;
+    if ((status = MessagePacket::Create(data, sizeof(data), 0, &msg)) != ZX_OK ||
+        (status = writer->Write(ZX_KOID_INVALID, ktl::move(msg))) != ZX_OK) {
+      return status;
+    }
+    uint32_t size = sizeof(data);
+    uint32_t handle_count = 0;
+    if ((status = reader->Read(ZX_KOID_INVALID, &size, &handle_count, &msg, false)) != ZX_OK) {
+      return status;
+    }
+  }
+  *cycles = arch::Cycles() - before;
+  return ZX_OK;
+}
+
+zx_status_t BenchPortQueueDequeue(size_t ops, uint64_t* cycles) {
+  KernelHandle<PortDispatcher> handle;
+  zx_rights_t rights;
+  zx_status_t status = PortDispatcher::Create(0, &handle, &rights);
+  if (status != ZX_OK) {
+    return status;
+  }
+  PortDispatcher* port = handle.dispatcher().get();
+
+  zx_port_packet_t packet = {};
+  packet.type = ZX_PKT_TYPE_USER;
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    if ((status = port->QueueUser(packet)) != ZX_OK ||
+        (status = port->Dequeue(Deadline::infinite(), &packet)) != ZX_OK) {
+      return status;
+    }
+  }
+  *cycles = arch::Cycles() - before;
+  return ZX_OK;
+}
+
+zx_status_t BenchPmmAllocFree(size_t ops, uint64_t* cycles) {
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    vm_page_t* page;
+    zx_status_t status = pmm_alloc_page(0, &page);
+    if (status != ZX_OK) {
+      return status;
+    }
+    pmm_free_page(page);
+  }
+  *cycles = arch::Cycles() - before;
+  return ZX_OK;
+}
+
+// Maps |vmo| into a fresh user address space and write faults each of its first |ops| pages.
+zx_status_t FaultPages(fbl::RefPtr<VmObject> vmo, size_t ops, uint64_t* cycles) {
+  fbl::RefPtr<VmAspace> aspace = VmAspace::Create(VmAspace::Type::User, "bench aspace");
+  if (!aspace) {
+    return ZX_ERR_NO_MEMORY;
+  }
+  auto destroy_aspace = fit::defer([&aspace]() { aspace->Destroy(); });
+
+  constexpr uint kArchFlags =
+      ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE | ARCH_MMU_FLAG_PERM_USER;
+  auto mapping = aspace->RootVmar()->CreateVmMapping(0, ops * PAGE_SIZE, 0, 0, ktl::move(vmo), 0,
+                                                     kArchFlags, "bench mapping");
+  if (mapping.is_error()) {
+    return mapping.status_value();
+  }
+
+  constexpr uint kFaultFlags = VMM_PF_FLAG_WRITE | VMM_PF_FLAG_USER | VMM_PF_FLAG_NOT_PRESENT;
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    zx_status_t status = aspace->SoftFault(mapping->base + i * PAGE_SIZE, kFaultFlags);
+    if (status != ZX_OK) {
+      return status;
+    }
+  }
+  *cycles = arch::Cycles() - before;
+  return ZX_OK;
+}
+
+zx_status_t BenchPageFault(size_t ops, uint64_t* cycles) {
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, ops * PAGE_SIZE, &vmo);
+  if (status != ZX_OK) {
+    return status;
+  }
+  return FaultPages(ktl::move(vmo), ops, cycles);
+}
+
+// Write faults each page of a snapshot of a committed VMO, as after a fork.
+zx_status_t BenchCowFault(size_t ops, uint64_t* cycles) {
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, ops * PAGE_SIZE, &vmo);
+  if (status != ZX_OK) {
+    return status;
+  }
+  if ((status = vmo->CommitRange(0, ops * PAGE_SIZE)) != ZX_OK) {
+    return status;
+  }
+  fbl::RefPtr<VmObject> clone;
+  status = vmo->CreateClone(Resizability::NonResizable, SnapshotType::Full, 0, ops * PAGE_SIZE,
+                            false, &clone);
+  if (status != ZX_OK) {
+    return status;
+  }
+  return FaultPages(ktl::move(clone), ops, cycles);
+}
+
+DECLARE_SINGLETON_MUTEX(BenchMutex);
+
+// Uncontended when run on one CPU, and increasingly handed off between CPUs as the case scales.
+zx_status_t BenchMutexAcquireRelease(size_t ops, uint64_t* cycles) {
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    Guard<Mutex> guard{BenchMutex::Get()};
+  }
+  *cycles = arch::Cycles() - before;
+  return ZX_OK;
+}
+
+// Ping-pongs between the calling thread and a second thread on the same CPU, so that each
+// operation is a pair of context switches.
+zx_status_t BenchContextSwitch(size_t ops, uint64_t* cycles) {
+  struct PingPong {
+    AutounsignalEvent ping;
+    AutounsignalEvent pong;
+    size_t ops;
+  } state{.ops = ops};
+
+  auto partner = [](void* arg) -> int {
+    PingPong* state = static_cast<PingPong*>(arg);
+    for (size_t i = 0; i < state->ops; i++) {
+      state->ping.Wait();
+      state->pong.Signal();
+    }
+    return 0;
+  };
+  Thread* thread = Thread::Create("bench_context_switch", partner, &state, DEFAULT_PRIORITY);
+  if (!thread) {
+    return ZX_ERR_NO_MEMORY;
+  }
+  thread->SetCpuAffinity(Thread::Current::Get()->GetCpuAffinity());
+  thread->Resume();
+
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    state.ping.Signal();
+    state.pong.Wait();
+  }
+  *cycles = arch::Cycles() - before;
+  thread->Join(nullptr, ZX_TIME_INFINITE);
+  return ZX_OK;
+}
+
+zx_status_t BenchTimerSetCancel(size_t ops, uint64_t* cycles) {
+  Timer timer;
+  const Deadline deadline = Deadline::after_mono(ZX_HOUR(1));
+  const uint64_t before = arch::Cycles();
+  for (size_t i = 0; i < ops; i++) {
+    timer.Set(deadline, [](Timer*, zx_instant_mono_t, void*) {}, nullptr);
+    timer.Cancel();
+  }
+  *cycles = arch::Cycles() - before;
+  return ZX_OK;
+}
+
+constexpr BenchCase kIpcCases[] = {
+    {"channel_write_read", BenchChannelWriteRead, 64, true},
+    {"port_queue_dequeue", BenchPortQueueDequeue, 64, true},
+};
+
+constexpr BenchCase kVmCases[] = {
+    {"pmm_alloc_free", BenchPmmAllocFree, 64, true},
+    {"page_fault", BenchPageFault, 32, true},
+    {"cow_fault", BenchCowFault, 32, true},
+};
+
+constexpr BenchCase kSchedCases[] = {
+    {"mutex_acquire_release", BenchMutexAcquireRelease, 256, true},
+    {"context_switch", BenchContextSwitch, 64, false},
+    {"timer_set_cancel", BenchTimerSetCancel, 64, true},
+};
+
+constexpr BenchSuite kSuites[] = {
+    {"ipc", kIpcCases},
+    {"vm", kVmCases},
+    {"sched", kSchedCases},
+};
+
+struct Worker {
+  const BenchCase* bench;
+  ktl::atomic<uint32_t>* ready;
+  uint32_t thread_count;
+  uint64_t* samples;
+  zx_status_t status;
+};
+
+int WorkerThread(void* arg) {
+  Worker* worker = static_cast<Worker*>(arg);
+
+  // Start sampling only once every worker is running, so the samples overlap.
+  worker->ready->fetch_add(1);
+  while (worker->ready->load() < worker->thread_count) {
+    arch::Yield();
+  }
+
+  for (size_t i = 0; i < kSamples; i++) {
+    uint64_t cycles;
+    worker->status = worker->bench->run(worker->bench->ops, &cycles);
+    if (worker->status != ZX_OK) {
+      return 0;
+    }
+    worker->samples[i] = cycles / worker->bench->ops;
+  }
+  return 0;
+}
+
+// Runs |bench| on |thread_count| online CPUs at once and prints a summary of the samples from all
+// of them. Returns false if the case could not be run.
+bool RunCase(const BenchSuite& suite, const BenchCase& bench, uint32_t thread_count) {
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<uint64_t[]> samples(new (&ac) uint64_t[kSamples * thread_count]);
+  if (!ac.check()) {
+    printf("bench: suite=%s case=%s cpus=%u error=%d\n", suite.name, bench.name, thread_count,
+           ZX_ERR_NO_MEMORY);
+    return false;
+  }
+
+  ktl::atomic<uint32_t> ready = 0;
+  Worker workers[SMP_MAX_CPUS];
+  Thread* threads[SMP_MAX_CPUS] = {};
+  uint32_t started = 0;
+  const cpu_mask_t online_mask = mp_get_online_mask();
+  for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS && started < thread_count; cpu++) {
+    if ((online_mask & cpu_num_to_mask(cpu)) == 0) {
+      continue;
+    }
+    workers[started] = {
+        .bench = &bench,
+        .ready = &ready,
+        .thread_count = thread_count,
+        .samples = &samples[started * kSamples],
+        .status = ZX_OK,
+    };
+    threads[started] = Thread::Create("bench_suite", WorkerThread, &workers[started],
+                                      DEFAULT_PRIORITY);
+    if (!threads[started]) {
+      break;
+    }
+    threads[started]->SetCpuAffinity(cpu_num_to_mask(cpu));
+    started++;
+  }
+
+  // Release the workers that were created even if not all of them could be, with the barrier
+  // lowered to match.
+  zx_status_t status = started == thread_count ? ZX_OK : ZX_ERR_NO_MEMORY;
+  for (uint32_t i = 0; i < started; i++) {
+    workers[i].thread_count = started;
+    threads[i]->Resume();
+  }
+  for (uint32_t i = 0; i < started; i++) {
+    threads[i]->Join(nullptr, ZX_TIME_INFINITE);
+    if (workers[i].status != ZX_OK) {
+      status = workers[i].status;
+    }
+  }
+  if (status != ZX_OK) {
+    printf("bench: suite=%s case=%s cpus=%u error=%d\n", suite.name, bench.name, thread_count,
+           status);
+    return false;
+  }
+
+  const size_t count = kSamples * thread_count;
+  ktl::sort(&samples[0], &samples[count]);
+  printf("bench: suite=%s case=%s cpus=%u samples=%zu ops=%zu min=%" PRIu64 " median=%" PRIu64
+         " p99=%" PRIu64 " unit=cycles/op\n",
+         suite.name, bench.name, thread_count, count, bench.ops, samples[0], samples[count / 2],
+         samples[count * 99 / 100]);
+  return true;
+}
+
+void RunSuite(const BenchSuite& suite, uint32_t max_cpus) {
+  for (const BenchCase& bench : suite.cases) {
+    if (!RunCase(suite, bench, 1) || !bench.scales) {
+      continue;
+    }
+    for (uint32_t cpus = 2; cpus <= max_cpus; cpus *= 2) {
+      if (!RunCase(suite, bench, cpus)) {
+        break;
+      }
+    }
+  }
+}
+
+}  // namespace
+
+int bench_suite(int argc, const cmd_args* argv, uint32_t) {
+  if (argc < 2) {
+  usage:
+    printf("usage:\n");
+    printf("%s list\n", argv[0].str);
+    printf("%s <suite>|all [max cpus]\n", argv[0].str);
+    return ZX_ERR_INVALID_ARGS;
+  }
+
+  if (!strcmp(argv[1].str, "list")) {
+    for (const BenchSuite& suite : kSuites) {
+      for (const BenchCase& bench : suite.cases) {
+        printf("%s %s%s\n", suite.name, bench.name, bench.scales ? " (scales)" : "");
+      }
+    }
+    return ZX_OK;
+  }
+
+  uint32_t max_cpus = ktl::popcount(mp_get_online_mask());
+  if (argc > 2) {
+    if (argv[2].u == 0) {
+      goto usage;
+    }
+    max_cpus = ktl::min(max_cpus, static_cast<uint32_t>(argv[2].u));
+  }
+
+  const bool all = !strcmp(argv[1].str, "all");
+  bool found = false;
+  for (const BenchSuite& suite : kSuites) {
+    if (all || !strcmp(argv[1].str, suite.name)) {
+      RunSuite(suite, max_cpus);
+      found = true;
+    }
+  }
+  if (!found) {
+    printf("unknown suite %s\n", argv[1].str);
+    goto usage;
+  }
+  return ZX_OK;
+}
@@ -363,7 +363,7 @@ __NO_INLINE static void bench_mutex() {
 }
 
 template <typename LockType>
-__NO_INLINE static void bench_rwlock() {
+__NO_INLINE static void bench_rwlock(const char* rwlock_name) {
   LockType rw;
   static const uint count = 128 * 1024 * 1024;
   uint64_t c = arch::Cycles();
@@ -373,10 +373,9 @@ __NO_INLINE static void bench_rwlock() {
   }
   c = arch::Cycles() - c;
 
-  printf("%" PRIu64
-         " cycles to acquire/release uncontended brwlock(PI: %d) for read %u times (%" PRIu64
+  printf("%" PRIu64 " cycles to acquire/release uncontended %s for read %u times (%" PRIu64
          " cycles per)\n",
-         c, ktl::is_same_v<LockType, BrwLockPi>, count, c / count);
+         c, rwlock_name, count, c / count);
 
   c = arch::Cycles();
   for (size_t i = 0; i < count; i++) {
@@ -385,10 +384,9 @@ __NO_INLINE static void bench_rwlock() {
   }
   c = arch::Cycles() - c;
 
-  printf("%" PRIu64
-         " cycles to acquire/release uncontended brwlock(PI: %d) for write %u times (%" PRIu64
+  printf("%" PRIu64 " cycles to acquire/release uncontended %s for write %u times (%" PRIu64
          " cycles per)\n",
-         c, ktl::is_same_v<LockType, BrwLockPi>, count, c / count);
+         c, rwlock_name, count, c / count);
 }
 
 __NO_INLINE static void bench_heap() {
@@ -431,7 +429,73 @@ __NO_INLINE static void bench_heap() {
   }
 }
 
-int benchmarks(int, const cmd_args*, uint32_t) {
+// Allocates and frees batches of small allocations from a thread pinned to each online CPU at
+// once, to measure how the heap scales when every CPU is allocating.
+__NO_INLINE static void bench_heap_threads() {
+  constexpr size_t kAllocSize = 64;
+  constexpr size_t kBatch = 32;
+  constexpr size_t kRounds = 4096;
+
+  auto worker = [](void* arg) -> int {
+    void* allocs[kBatch];
+    const uint64_t before = arch::Cycles();
+    for (size_t round = 0; round < kRounds; round++) {
+      for (void*& alloc : allocs) {
+        alloc = malloc(kAllocSize);
+      }
+      for (void* alloc : allocs) {
+        free(alloc);
+      }
+    }
+    *static_cast<uint64_t*>(arg) = arch::Cycles() - before;
+    return 0;
+  };
+
+  Thread* threads[SMP_MAX_CPUS] = {};
+  uint64_t cycles[SMP_MAX_CPUS] = {};
+  const cpu_mask_t online_mask = mp_get_online_mask();
+  for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+    if ((online_mask & cpu_num_to_mask(cpu)) == 0) {
+      continue;
+    }
+    threads[cpu] = Thread::Create("bench_heap_threads", worker, &cycles[cpu], DEFAULT_PRIORITY);
+    if (!threads[cpu]) {
+      printf("Thread creation failed during %s\n", __FUNCTION__);
+      break;
+    }
+    threads[cpu]->SetCpuAffinity(cpu_num_to_mask(cpu));
+  }
+
+  for (Thread* thread : threads) {
+    if (thread) {
+      thread->Resume();
+    }
+  }
+  uint32_t thread_count = 0;
+  uint64_t total_cycles = 0;
+  for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+    if (threads[cpu]) {
+      threads[cpu]->Join(nullptr, ZX_TIME_INFINITE);
+      thread_count++;
+      total_cycles += cycles[cpu];
+    }
+  }
+  if (thread_count == 0) {
+    return;
+  }
+
+  const uint64_t pairs = static_cast<uint64_t>(thread_count) * kRounds * kBatch;
+  printf("Heap test using %u threads each doing %zu allocations of %zu bytes took %" PRIu64
+         " cycles per malloc/free pair\n",
+         thread_count, kRounds * kBatch, kAllocSize, total_cycles / pairs);
+}
+
+int benchmarks(int argc, const cmd_args* argv, uint32_t flags) {
+  // With arguments, run one of the structured suites instead, see bench_suites.cc.
+  if (argc > 1) {
+    return bench_suite(argc, argv, flags);
+  }
+
   // Disable the hardware watchdog (if present and enabled) because some of these benchmarks will
   // disable interrupts for extended periods of time.
   bool need_to_reenable = false;
@@ -451,6 +515,7 @@ int benchmarks(int, const cmd_args*, uint32_t) {
   bench_cycles_per_second();
   bench_set_overhead();
   bench_heap();
+  bench_heap_threads();
   bench_memcpy();
   bench_memset();
 
@@ -465,8 +530,9 @@ int benchmarks(int, const cmd_args*, uint32_t) {
   bench_spinlock<SpinLock>("SpinLock");
   bench_spinlock<MonitoredSpinLock>("MonitoredSpinLock");
   bench_mutex();
-  bench_rwlock<BrwLockPi>();
-  bench_rwlock<BrwLockNoPi>();
+  bench_rwlock<BrwLockPi>("BrwLockPi");
+  bench_rwlock<BrwLockNoPi>("BrwLockNoPi");
+  bench_rwlock<BrwLockPercpu>("BrwLockPercpu");
 
   return 0;
 }
@@ -54,7 +54,7 @@ class BrwLockTest {
       Thread::Current::Get()->SetBaseProfile(SchedulerState::BaseProfile{HIGH_PRIORITY});
       cpu_mask_t pin_mask = cpu_num_to_mask(lowest_cpu_set(worker_mask));
       Thread::Current::Get()->SetCpuAffinity(pin_mask);
-      worker_mask -= pin_mask;
+      worker_mask &= ~pin_mask;
     } else {
       Thread::Current::Get()->SetBaseProfile(SchedulerState::BaseProfile{DEFAULT_PRIORITY});
     }
@@ -82,16 +82,20 @@ class BrwLockTest {
       t->SetCpuAffinity(worker_mask);
       t->Resume();
     }
-    for (auto& t : upgrader_threads) {
-      t = Thread::Create(
-          "upgrader worker",
-          [](void* arg) -> int {
-            static_cast<BrwLockTest*>(arg)->UpgraderWorker();
-            return 0;
-          },
-          &test, DEFAULT_PRIORITY);
-      t->SetCpuAffinity(worker_mask);
-      t->Resume();
+    // Not every lock type supports ReadUpgrade, so only instantiate the upgrader
+    // worker when it is used.
+    if constexpr (upgraders > 0) {
+      for (auto& t : upgrader_threads) {
+        t = Thread::Create(
+            "upgrader worker",
+            [](void* arg) -> int {
+              static_cast<BrwLockTest*>(arg)->UpgraderWorker();
+              return 0;
+            },
+            &test, DEFAULT_PRIORITY);
+        t->SetCpuAffinity(worker_mask);
+        t->Resume();
+      }
     }
 
     zx_instant_mono_t start = current_mono_time();
@@ -202,4 +206,7 @@ UNITTEST("parallel readers(No PI)", (BrwLockTest<BrwLockNoPi>::RunTest<8, 0, 0>)
 UNITTEST("single writer(No PI)", (BrwLockTest<BrwLockNoPi>::RunTest<0, 4, 0>))
 UNITTEST("readers and writer(No PI)", (BrwLockTest<BrwLockNoPi>::RunTest<4, 2, 0>))
 UNITTEST("upgraders(No PI)", (BrwLockTest<BrwLockNoPi>::RunTest<2, 0, 3>))
+UNITTEST("parallel readers(Percpu)", (BrwLockTest<BrwLockPercpu>::RunTest<8, 0, 0>))
+UNITTEST("single writer(Percpu)", (BrwLockTest<BrwLockPercpu>::RunTest<0, 4, 0>))
+UNITTEST("readers and writer(Percpu)", (BrwLockTest<BrwLockPercpu>::RunTest<4, 2, 0>))
 UNITTEST_END_TESTCASE(brwlock_tests, "brwlock", "brwlock tests")
@@ -283,7 +283,7 @@ static bool cpu_search_set_test_1() {
   EXPECT_EQ(cpu_count, search_set.cpu_count());
 
   // Check that each CPU is in the search set.
-  cpu_mask_t cpu_set = 0;
+  cpu_mask_t cpu_set{};
   for (const auto entry : search_set.const_iterator()) {
     ASSERT_GT(cpu_count, entry.cpu);
     cpu_set |= cpu_num_to_mask(entry.cpu);
@@ -323,7 +323,7 @@ static bool cpu_search_set_test_2() {
     EXPECT_EQ(cpu_count, search_set.cpu_count());
 
     // Check that each CPU is in the search set.
-    cpu_mask_t cpu_set = 0;
+    cpu_mask_t cpu_set{};
     for (const auto entry : search_set.const_iterator()) {
       ASSERT_GT(cpu_count, entry.cpu);
       cpu_set |= cpu_num_to_mask(entry.cpu);
@@ -337,7 +337,7 @@ static bool cpu_search_set_test_2() {
     EXPECT_EQ(cpu_count, search_set.cpu_count());
 
     // Check that each CPU is in the search set.
-    cpu_mask_t cpu_set = 0;
+    cpu_mask_t cpu_set{};
     for (const auto entry : search_set.const_iterator()) {
       ASSERT_GT(cpu_count, entry.cpu);
       cpu_set |= cpu_num_to_mask(entry.cpu);
@@ -374,6 +374,8 @@ static bool cpu_search_set_test_4() {
   ASSERT_EQ(2u, cluster_set.clusters[1].members.size());
   EXPECT_EQ(cpu0, cluster_set.clusters[0].members[0]);
   EXPECT_EQ(cpu3, cluster_set.clusters[1].members[1]);
+  EXPECT_TRUE(cluster_set.clusters[0].mask == (cpu_num_to_mask(0) | cpu_num_to_mask(1)));
+  EXPECT_TRUE(cluster_set.clusters[1].mask == (cpu_num_to_mask(2) | cpu_num_to_mask(3)));
 
   {
     // The search set for CPU 0 should have four entries.
@@ -381,7 +383,7 @@ static bool cpu_search_set_test_4() {
     EXPECT_EQ(cpu_count, search_set.cpu_count());
 
     // Check that each CPU is in the search set.
-    cpu_mask_t cpu_set = 0;
+    cpu_mask_t cpu_set{};
     for (const auto entry : search_set.const_iterator()) {
       ASSERT_GT(cpu_count, entry.cpu);
       cpu_set |= cpu_num_to_mask(entry.cpu);
@@ -395,7 +397,7 @@ static bool cpu_search_set_test_4() {
     EXPECT_EQ(cpu_count, search_set.cpu_count());
 
     // Check that each CPU is in the search set.
-    cpu_mask_t cpu_set = 0;
+    cpu_mask_t cpu_set{};
     for (const auto entry : search_set.const_iterator()) {
       ASSERT_GT(cpu_count, entry.cpu);
       cpu_set |= cpu_num_to_mask(entry.cpu);
@@ -436,7 +438,7 @@ static bool cpu_search_set_test_max() {
     EXPECT_EQ(cpu_count, search_set.cpu_count());
 
     // Check that each CPU is in the search set.
-    cpu_mask_t cpu_set = 0;
+    cpu_mask_t cpu_set{};
     for (const auto entry : search_set.const_iterator()) {
       ASSERT_GT(cpu_count, entry.cpu);
       cpu_set |= cpu_num_to_mask(entry.cpu);
@@ -450,7 +452,7 @@ static bool cpu_search_set_test_max() {
     EXPECT_EQ(cpu_count, search_set.cpu_count());
 
     // Check that each CPU is in the search set.
-    cpu_mask_t cpu_set = 0;
+    cpu_mask_t cpu_set{};
     for (const auto entry : search_set.const_iterator()) {
       ASSERT_GT(cpu_count, entry.cpu);
       cpu_set |= cpu_num_to_mask(entry.cpu);
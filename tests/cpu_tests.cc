@@ -6,7 +6,6 @@
 
 // Contains tests for kernel/include/kernel/cpu.h
 
-#include <bits.h>
 #include <lib/unittest/unittest.h>
 
 #include <kernel/cpu.h>
@@ -21,16 +20,16 @@ bool remove_cpu_from_mask_test() {
 
   {
     // Empty.
-    cpu_mask_t mask = 0;
+    cpu_mask_t mask{};
     EXPECT_EQ(INVALID_CPU, remove_cpu_from_mask(mask));
   }
 
   {
     // Full.
-    const cpu_mask_t full_mask = BIT_MASK(SMP_MAX_CPUS);
+    const cpu_mask_t full_mask = CpuMask::FirstN(SMP_MAX_CPUS);
     cpu_mask_t mask = full_mask;
-    cpu_mask_t result = 0;
-    while (mask != 0u) {
+    cpu_mask_t result{};
+    while (mask.any()) {
       const cpu_mask_t prev_mask = mask;
       cpu_num_t cpu = remove_cpu_from_mask(mask);
       // Make sure it's valid.
@@ -39,19 +38,84 @@ bool remove_cpu_from_mask_test() {
       // Make sure it was removed.  If not, abort the test so we don't loop forever.
       ASSERT_FALSE(mask & cpu_num_to_mask(cpu));
       // Make sure nothing else was removed.
-      EXPECT_EQ(prev_mask, mask | cpu_num_to_mask(cpu));
+      EXPECT_TRUE(prev_mask == (mask | cpu_num_to_mask(cpu)));
       // Add it to our result set.
       result |= cpu_num_to_mask(cpu);
     }
     // See that the result set is complete.
-    EXPECT_EQ(full_mask, result);
+    EXPECT_TRUE(full_mask == result);
   }
 
   END_TEST;
 }
 
+bool cpu_mask_ops_test() {
+  BEGIN_TEST;
+
+  const cpu_num_t last = SMP_MAX_CPUS - 1;
+
+  cpu_mask_t mask{};
+  EXPECT_TRUE(mask.none());
+  EXPECT_EQ(0u, mask.count());
+
+  mask.set(0).set(last);
+  EXPECT_TRUE(mask.any());
+  EXPECT_TRUE(mask.test(0));
+  EXPECT_TRUE(mask.test(last));
+  EXPECT_EQ(last > 0 ? 2u : 1u, mask.count());
+  EXPECT_EQ(0u, lowest_cpu_set(mask));
+  EXPECT_EQ(last, highest_cpu_set(mask));
+
+  // Setting or testing a bit beyond the end of the mask is a no-op.
+  mask.set(static_cast<cpu_num_t>(CpuMask::kBits));
+  EXPECT_FALSE(mask.test(static_cast<cpu_num_t>(CpuMask::kBits)));
+  EXPECT_TRUE(cpu_num_to_mask(INVALID_CPU).none());
+
+  // Bitwise operators work across the whole mask.
+  const cpu_mask_t all = CpuMask::FirstN(SMP_MAX_CPUS);
+  EXPECT_EQ(static_cast<size_t>(SMP_MAX_CPUS), all.count());
+  EXPECT_TRUE(CPU_MASK_ALL == all);
+  EXPECT_TRUE((all & ~mask).count() == all.count() - mask.count());
+  EXPECT_TRUE((all ^ mask) == (all & ~mask));
+  EXPECT_TRUE((mask | all) == all);
+  EXPECT_FALSE(mask_all_but_one(last).test(last));
+  EXPECT_TRUE(mask_all_but_one(last).test(0) || last == 0);
+
+  mask.reset(last);
+  EXPECT_TRUE(mask == cpu_num_to_mask(0));
+
+  END_TEST;
+}
+
+bool atomic_cpu_mask_test() {
+  BEGIN_TEST;
+
+  const cpu_num_t last = SMP_MAX_CPUS - 1;
+  AtomicCpuMask atomic_mask;
+  EXPECT_TRUE(atomic_mask.load().none());
+
+  cpu_mask_t prev = atomic_mask.fetch_or(cpu_num_to_mask(last));
+  EXPECT_TRUE(prev.none());
+  EXPECT_TRUE(atomic_mask.test(last));
+
+  prev = atomic_mask.fetch_or(cpu_num_to_mask(0));
+  EXPECT_TRUE(prev == cpu_num_to_mask(last));
+
+  prev = atomic_mask.fetch_and(~cpu_num_to_mask(last));
+  EXPECT_TRUE(prev == (cpu_num_to_mask(0) | cpu_num_to_mask(last)));
+  EXPECT_TRUE(atomic_mask.load() == cpu_num_to_mask(0));
+
+  prev = atomic_mask.exchange({});
+  EXPECT_TRUE(prev == cpu_num_to_mask(0));
+  EXPECT_TRUE(atomic_mask.load().none());
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(cpu_tests)
 UNITTEST("remove_cpu_from_mask", remove_cpu_from_mask_test)
+UNITTEST("cpu_mask_ops", cpu_mask_ops_test)
+UNITTEST("atomic_cpu_mask", atomic_cpu_mask_test)
 UNITTEST_END_TESTCASE(cpu_tests, "cpu", "cpu tests")
@@ -114,7 +114,53 @@ static bool test_dpc_requeue() {
   END_TEST;
 }
 
+// Test that Dpcs queued from one cpu run in the order they were queued.
+static bool test_dpc_order() {
+  BEGIN_TEST;
+
+  struct Context {
+    Context() : dpc(&Record, this) {}
+
+    static void Record(Dpc* dpc) {
+      auto* const context = dpc->arg<Context>();
+      context->position = context->next->fetch_add(1);
+    }
+
+    Dpc dpc;
+    ktl::atomic<size_t>* next = nullptr;
+    size_t position = 0;
+  };
+
+  static constexpr size_t kNumDPCs = 64;
+
+  fbl::AllocChecker ac;
+  auto context = fbl::MakeArray<Context>(&ac, kNumDPCs);
+  ASSERT_TRUE(ac.check());
+
+  // Keep the worker from running, and the test thread from migrating, until everything has been
+  // queued so that the Dpcs pile up on a single queue.
+  AutoPreemptDisabler preempt_disable;
+  ktl::atomic<size_t> next = 0;
+  for (size_t i = 0; i < kNumDPCs; i++) {
+    context[i].next = &next;
+    ASSERT_EQ(ZX_OK, DpcRunner::Enqueue(context[i].dpc));
+  }
+
+  Event event_flush;
+  Dpc dpc_flush([](Dpc* d) { d->arg<Event>()->Signal(); }, &event_flush);
+  ASSERT_EQ(ZX_OK, DpcRunner::Enqueue(dpc_flush));
+  event_flush.Wait(Deadline::no_slack(ZX_TIME_INFINITE));
+
+  ASSERT_EQ(kNumDPCs, next.load());
+  for (size_t i = 0; i < kNumDPCs; i++) {
+    EXPECT_EQ(i, context[i].position);
+  }
+
+  END_TEST;
+}
+
 UNITTEST_START_TESTCASE(dpc_tests)
 UNITTEST("basic test of Dpc::Queue", test_dpc_queue)
 UNITTEST("repeatedly queue the same dpc", test_dpc_requeue)
+UNITTEST("dpcs run in the order they are queued", test_dpc_order)
 UNITTEST_END_TESTCASE(dpc_tests, "dpc_tests", "Tests of DPCs")
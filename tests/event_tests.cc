@@ -131,8 +131,7 @@ static bool event_signal_spinlock_test() {
     Guard<MonitoredSpinLock, IrqSave> guard{SpinlockForEventSignalTest::Get(), SOURCE_TAG};
     args.event.Signal();
     // Now that we have signaled, we should see that a preemption is pending on this CPU.
-    ASSERT_NE(
-        0u, (Thread::Current::preemption_state().preempts_pending() & cpu_num_to_mask(target_cpu)));
+    ASSERT_TRUE(Thread::Current::preemption_state().preempts_pending().test(target_cpu));
   }
 
   t->Join(nullptr, ZX_TIME_INFINITE);
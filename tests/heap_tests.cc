@@ -6,10 +6,13 @@
 
 #include <bits.h>
 #include <lib/boot-options/boot-options.h>
+#include <lib/heap.h>
 #include <lib/unittest/unittest.h>
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
+#include <kernel/auto_preempt_disabler.h>
+
 static bool test_alloc_fill_threshold() {
   BEGIN_TEST;
 
@@ -25,6 +28,40 @@ static bool test_alloc_fill_threshold() {
   END_TEST;
 }
 
+// Small allocations freed on a CPU are cached there, so the next allocation of the same size on
+// that CPU gets the same block back, and trimming returns the cached blocks to the heap. ASAN
+// builds quarantine freed blocks instead of caching them.
+static bool test_cpu_cache() {
+  BEGIN_TEST;
+
+#if !__has_feature(address_sanitizer)
+  // An unusual size, so the blocks are unlikely to share a bucket with anything else.
+  constexpr size_t kSize = 488;
+  constexpr size_t kCount = 8;
+
+  AutoPreemptDisabler preempt_disable;
+  void* first = malloc(kSize);
+  ASSERT_NONNULL(first);
+  free(first);
+  void* again = malloc(kSize);
+  EXPECT_EQ(first, again);
+  free(again);
+
+  void* allocs[kCount];
+  for (void*& alloc : allocs) {
+    alloc = malloc(kSize);
+    ASSERT_NONNULL(alloc);
+  }
+  for (void* alloc : allocs) {
+    free(alloc);
+  }
+  EXPECT_GE(heap_trim(), kCount * kSize);
+#endif
+
+  END_TEST;
+}
+
 UNITTEST_START_TESTCASE(heap_tests)
 UNITTEST("test allocations are zeroed if alloc_fill_threshold is set", test_alloc_fill_threshold)
+UNITTEST("test small allocations are cached per CPU", test_cpu_cache)
 UNITTEST_END_TESTCASE(heap_tests, "heap", "heap tests")
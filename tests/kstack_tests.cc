@@ -13,6 +13,7 @@
 #include <kernel/mp.h>
 #include <kernel/scheduler.h>
 #include <kernel/thread.h>
+#include <vm/kstack.h>
 
 namespace {
 
@@ -115,6 +116,33 @@ bool kstack_mp_sync_exec_test() {
   END_TEST;
 }
 
+// Test that stacks returned to the cache come back fully mapped, and that trimming the cache
+// releases them.
+bool kstack_cache_test() {
+  BEGIN_TEST;
+
+  // Start from an empty cache so that the next Init has to create its stack.
+  KernelStack::TrimCache();
+
+  for (int i = 0; i < 2; i++) {
+    KernelStack stack;
+    ASSERT_OK(stack.Init());
+    ASSERT_NE(0u, stack.base());
+    EXPECT_EQ(internal::kMachineStackSize, stack.top() - stack.base());
+    // Both ends of the stack must be mapped, whether or not it came from the cache. Only read, so
+    // as not to disturb the canary.
+    [[maybe_unused]] uint8_t byte = *reinterpret_cast<volatile uint8_t*>(stack.base());
+    byte = *reinterpret_cast<volatile uint8_t*>(stack.top() - 1);
+    ASSERT_OK(stack.Teardown());
+    EXPECT_EQ(0u, stack.base());
+  }
+
+  // Don't leave the test's stack behind in the cache.
+  KernelStack::TrimCache();
+
+  END_TEST;
+}
+
 }  // anonymous namespace
 
 UNITTEST_START_TESTCASE(kstack_tests)
@@ -123,4 +151,5 @@ UNITTEST("kstack-interrupt-depth", kstack_interrupt_depth_test)
 UNITTEST("kstack-interrupt-depth-no-safestack", kstack_interrupt_depth_test_no_safestack)
 #endif
 UNITTEST("kstack-mp-sync-exec", kstack_mp_sync_exec_test)
+UNITTEST("kstack-cache", kstack_cache_test)
 UNITTEST_END_TESTCASE(kstack_tests, "kstack", "kernel stack tests")
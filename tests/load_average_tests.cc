@@ -0,0 +1,115 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/unittest/unittest.h>
+#include <stdint.h>
+#include <zircon/time.h>
+
+#include <kernel/load_average.h>
+
+namespace {
+
+// The number of periods in each of the windows.
+constexpr ktl::array<uint64_t, kLoadAverageWindows> kWindowPeriods{10, 100, 600};
+
+// exp(-1) and 1 - exp(-1) in fixed point, and the tolerance of the comparisons against them.
+constexpr int64_t kOneOverE = 24109;
+constexpr int64_t kOneMinusOneOverE = kLoadAverageOne - kOneOverE;
+constexpr int64_t kTolerance = kLoadAverageOne / 100;
+
+bool Near(int64_t actual, int64_t expected) {
+  return actual > expected - kTolerance && actual < expected + kTolerance;
+}
+
+bool decay_pow() {
+  BEGIN_TEST;
+
+  for (size_t i = 0; i < kLoadAverageWindows; i++) {
+    const int64_t decay = kLoadAverageDecay[i];
+    EXPECT_EQ(kLoadAverageOne, LoadAverageDecayPow(decay, 0));
+    EXPECT_EQ(decay, LoadAverageDecayPow(decay, 1));
+
+    // A window's worth of periods decays by a factor of e.
+    EXPECT_TRUE(Near(LoadAverageDecayPow(decay, kWindowPeriods[i]), kOneOverE));
+
+    // The decay never grows with the number of periods, and reaches zero.
+    int64_t previous = kLoadAverageOne;
+    for (uint64_t n = 1; n <= 100 * kWindowPeriods[i]; n++) {
+      const int64_t result = LoadAverageDecayPow(decay, n);
+      EXPECT_LE(result, previous);
+      previous = result;
+    }
+    EXPECT_EQ(0, previous);
+    EXPECT_EQ(0, LoadAverageDecayPow(decay, UINT64_MAX));
+  }
+
+  END_TEST;
+}
+
+bool update() {
+  BEGIN_TEST;
+
+  for (size_t i = 0; i < kLoadAverageWindows; i++) {
+    const int64_t decay = kLoadAverageDecay[i];
+
+    // A constant quantity leaves the average unchanged.
+    EXPECT_EQ(3 * kLoadAverageOne, LoadAverageUpdate(3 * kLoadAverageOne, 3 * kLoadAverageOne,
+                                                     decay, kWindowPeriods[i]));
+
+    // A step covers about 1 - 1/e of the distance to the new value per window, whether the periods
+    // are folded in one at a time or all at once, and approaches without overshooting.
+    int64_t average = 0;
+    for (uint64_t n = 0; n < kWindowPeriods[i]; n++) {
+      const int64_t next = LoadAverageUpdate(average, kLoadAverageOne, decay, 1);
+      EXPECT_GE(next, average);
+      EXPECT_LE(next, kLoadAverageOne);
+      average = next;
+    }
+    EXPECT_TRUE(Near(average, kOneMinusOneOverE));
+    EXPECT_TRUE(Near(LoadAverageUpdate(0, kLoadAverageOne, decay, kWindowPeriods[i]),
+                     kOneMinusOneOverE));
+
+    // The same holds in the other direction, and an idle CPU's averages decay to exactly zero, so
+    // that it stops refreshing them.
+    average = kLoadAverageOne;
+    for (uint64_t n = 0; n < kWindowPeriods[i]; n++) {
+      const int64_t next = LoadAverageUpdate(average, 0, decay, 1);
+      EXPECT_LE(next, average);
+      EXPECT_GE(next, 0);
+      average = next;
+    }
+    EXPECT_TRUE(Near(average, kOneOverE));
+    EXPECT_EQ(0, LoadAverageUpdate(1000 * kLoadAverageOne, 0, decay, 100 * kWindowPeriods[i]));
+    EXPECT_EQ(0, LoadAverageUpdate(1000 * kLoadAverageOne, 0, decay, UINT64_MAX));
+  }
+
+  END_TEST;
+}
+
+bool sample() {
+  BEGIN_TEST;
+
+  EXPECT_EQ(0, LoadAverageSample(0, kLoadAveragePeriod));
+  EXPECT_EQ(kLoadAverageOne, LoadAverageSample(kLoadAveragePeriod, kLoadAveragePeriod));
+  EXPECT_EQ(kLoadAverageOne / 4, LoadAverageSample(kLoadAveragePeriod / 4, kLoadAveragePeriod));
+  EXPECT_EQ(5 * kLoadAverageOne / 2,
+            LoadAverageSample(5 * kLoadAveragePeriod / 2, kLoadAveragePeriod));
+
+  // Long periods, such as a long idle period, do not overflow.
+  EXPECT_EQ(kLoadAverageOne / 2, LoadAverageSample(ZX_HOUR(1000), ZX_HOUR(2000)));
+  EXPECT_EQ(kLoadAverageOne, LoadAverageSample(ZX_TIME_INFINITE - 1, ZX_TIME_INFINITE - 1));
+  EXPECT_EQ(0, LoadAverageSample(0, ZX_TIME_INFINITE - 1));
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(load_average_tests)
+UNITTEST("decay_pow", decay_pow)
+UNITTEST("update", update)
+UNITTEST("sample", sample)
+UNITTEST_END_TESTCASE(load_average_tests, "load_average", "Scheduler load average tests")
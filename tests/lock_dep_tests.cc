@@ -1439,7 +1439,7 @@ static bool bug_84827_regression_test() {
   BEGIN_TEST;
 
   cpu_mask_t online_cpus = mp_get_online_mask();
-  if (ktl::popcount(online_cpus) < 2) {
+  if (online_cpus.count() < 2) {
     printf("Skipping test, must have at least 2 CPUs online\n");
     return true;
   }
@@ -1544,14 +1544,14 @@ static bool bug_84827_regression_test() {
 
   struct TestArgs {
     DECLARE_SPINLOCK(TestArgs) lock;
-    cpu_mask_t first_cpu_mask{0};
-    cpu_mask_t second_cpu_mask{0};
+    cpu_mask_t first_cpu_mask{};
+    cpu_mask_t second_cpu_mask{};
     ktl::atomic<TestState> state{TestState::WaitingForThreadStart};
   } args;
 
   // Determine the cores that this test will use.
   for (cpu_num_t i = 0; !args.second_cpu_mask; ++i) {
-    if ((online_cpus & cpu_num_to_mask(i)) != 0) {
+    if (online_cpus.test(i)) {
       if (!args.first_cpu_mask) {
         args.first_cpu_mask = cpu_num_to_mask(i);
       } else {
@@ -38,13 +38,7 @@ static zx_status_t hotplug_core(cpu_num_t i) {
 }
 
 static unsigned get_num_cpus_online() {
-  unsigned count = 0;
-  cpu_mask_t online = mp_get_online_mask();
-  while (online) {
-    online >>= 1;
-    ++count;
-  }
-  return count;
+  return static_cast<unsigned>(mp_get_online_mask().count());
 }
 
 static zx_status_t wait_for_cpu_offline(cpu_num_t i) {
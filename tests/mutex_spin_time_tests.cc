@@ -6,6 +6,7 @@
 
 #include <lib/affine/ratio.h>
 #include <lib/arch/intrin.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/fit/defer.h>
 #include <lib/kconcurrent/chainlock_transaction.h>
 #include <lib/unittest/unittest.h>
@@ -14,6 +15,7 @@
 #include <platform.h>
 
 #include <kernel/auto_preempt_disabler.h>
+#include <kernel/event.h>
 #include <kernel/mp.h>
 #include <ktl/atomic.h>
 #include <ktl/bit.h>
@@ -32,17 +34,14 @@ bool mutex_spin_time_test(void) {
   cpu_mask_t spinner_mask;
   {
     cpu_mask_t avail_mask = mp_get_online_mask();
-    int avail_count = ktl::popcount(avail_mask);
+    int avail_count = static_cast<int>(avail_mask.count());
     if (avail_count < 2) {
       printf("Insufficient cores online to run the mutex spin timeout tests.  Skipping!\n");
       END_TEST;
     }
 
-    for (timer_mask = 0x1; (timer_mask & avail_mask) == 0; timer_mask <<= 1)
-      ;
-
-    for (spinner_mask = timer_mask << 1; (spinner_mask & avail_mask) == 0; spinner_mask <<= 1)
-      ;
+    timer_mask = cpu_num_to_mask(remove_cpu_from_mask(avail_mask));
+    spinner_mask = cpu_num_to_mask(remove_cpu_from_mask(avail_mask));
   }
 
   // No matter what happens from here on out, make sure we restore our main
@@ -63,7 +62,7 @@ bool mutex_spin_time_test(void) {
     DECLARE_MUTEX(Args) the_mutex;
     zx::duration spin_max_duration;
     ktl::atomic<bool> interlock{false};
-  } args;
+  };
 
   // Our test thunk is very simple.  One we are started, we disable preemption
   // and then signal the timer thread via the interlock atomic.  Once the timer
@@ -91,6 +90,11 @@ bool mutex_spin_time_test(void) {
     zx::ticks start, end;
     Thread* test_thread;
 
+    // Use a fresh mutex for each timeout. With kernel.mutex.adaptive-spin
+    // enabled, a mutex only spins for its whole spin limit until it has learned
+    // a budget from previous contended acquires.
+    Args args;
+
     // Setup the timeout and create the test thread (but don't start it yet).
     // Make sure that the thread runs on a different core from ours.
     args.spin_max_duration = timeout;
@@ -149,8 +153,75 @@ bool mutex_spin_time_test(void) {
 
   END_TEST;
 }
+
+// The spin limit used by mutex_spin_owner_blocked_test. This is long enough
+// that blocking before it expires cannot be due to the spin timing out.
+constexpr zx_duration_t kOwnerBlockedSpinMaxDuration = ZX_MSEC(50);
+
+// With adaptive spinning, a thread contending a mutex whose owner is blocked
+// should block right away instead of spinning for the whole spin limit.
+bool mutex_spin_owner_blocked_test() {
+  BEGIN_TEST;
+
+  if (!gBootOptions->mutex_adaptive_spin) {
+    printf("kernel.mutex.adaptive-spin is disabled.  Skipping!\n");
+    END_TEST;
+  }
+
+  struct Args {
+    DECLARE_MUTEX(Args) the_mutex;
+    Event owner_release;
+  } args;
+
+  // The owner grabs the mutex and then blocks holding it until released.
+  auto owner_thunk = [](void* ctx) -> int {
+    auto& args = *(static_cast<Args*>(ctx));
+    Guard<Mutex> guard{&args.the_mutex};
+    args.owner_release.Wait();
+    return 0;
+  };
+
+  auto spinner_thunk = [](void* ctx) -> int {
+    auto& args = *(static_cast<Args*>(ctx));
+    Guard<Mutex> guard{&args.the_mutex, kOwnerBlockedSpinMaxDuration};
+    return 0;
+  };
+
+  auto get_thread_state = [](const Thread& t) -> thread_state {
+    SingleChainLockGuard guard{IrqSaveOption, t.get_lock(),
+                               CLT_TAG("mutex_spin_owner_blocked_test")};
+    return t.state();
+  };
+
+  Thread* owner_thread = Thread::Create("mutex spin owner", owner_thunk, &args, DEFAULT_PRIORITY);
+  ASSERT_NONNULL(owner_thread, "Failed to create owner thread");
+  owner_thread->Resume();
+  while (get_thread_state(*owner_thread) != THREAD_BLOCKED) {
+    Thread::Current::SleepRelative(ZX_USEC(100));
+  }
+
+  Thread* spinner_thread =
+      Thread::Create("mutex spin waiter", spinner_thunk, &args, DEFAULT_PRIORITY);
+  ASSERT_NONNULL(spinner_thread, "Failed to create spinner thread");
+  const zx::ticks start = zx::ticks(current_mono_ticks());
+  spinner_thread->Resume();
+  while (get_thread_state(*spinner_thread) != THREAD_BLOCKED) {
+    arch::Yield();
+  }
+  const zx::ticks end = zx::ticks(current_mono_ticks());
+
+  args.owner_release.Signal();
+  ASSERT_EQ(owner_thread->Join(nullptr, current_mono_time() + ZX_SEC(30)), ZX_OK);
+  ASSERT_EQ(spinner_thread->Join(nullptr, current_mono_time() + ZX_SEC(30)), ZX_OK);
+
+  const zx::duration blocked_after(timer_get_ticks_to_time_ratio().Scale((end - start).get()));
+  EXPECT_LT(blocked_after.get(), kOwnerBlockedSpinMaxDuration, "Spun while the owner was blocked!");
+
+  END_TEST;
+}
 }  // namespace
 
 UNITTEST_START_TESTCASE(mutex_spin_time_tests)
 UNITTEST("Mutex spin timeouts", (mutex_spin_time_test))
+UNITTEST("Mutex spin stops when the owner blocks", (mutex_spin_owner_blocked_test))
 UNITTEST_END_TESTCASE(mutex_spin_time_tests, "mutex_spin_time", "mutex_spin_time tests")
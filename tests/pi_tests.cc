@@ -4,6 +4,7 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <inttypes.h>
 #include <lib/fit/defer.h>
 #include <lib/fit/function.h>
 #include <lib/kconcurrent/chainlock_transaction.h>
@@ -1572,6 +1573,103 @@ bool pi_test_cycle() {
   END_TEST;
 }
 
+// Measure the cost of changing the base profile of the thread at the upstream
+// end of a long PI chain, for changes which do not alter what the thread
+// transmits, changes which only alter the minimum deadline (and stop at the
+// first node which already has a smaller one), and changes which must be
+// propagated all of the way to the end of the chain.  Verify the effective
+// profile at the end of the chain after each phase.
+bool pi_test_chain_propagation_cost() {
+  BEGIN_TEST;
+
+  constexpr size_t kChainLen = 16;
+  constexpr uint32_t kIterations = 1000;
+
+  const fbl::RefPtr<Profile> default_profile =
+      FairProfile::Create(TEST_DEFAULT_WEIGHT, InheritableProfile::Yes);
+  const fbl::RefPtr<Profile> highest_profile =
+      FairProfile::Create(TEST_HIGHEST_WEIGHT, InheritableProfile::Yes);
+  const fbl::RefPtr<Profile> short_deadline_profile =
+      DeadlineProfile::Create(ZX_USEC(100), ZX_MSEC(1));
+  const ktl::array<fbl::RefPtr<Profile>, 2> deadline_profiles = {
+      DeadlineProfile::Create(ZX_MSEC(1), ZX_MSEC(5)),
+      DeadlineProfile::Create(ZX_MSEC(2), ZX_MSEC(10)),
+  };
+  const ktl::array<fbl::RefPtr<Profile>, 2> fair_profiles = {highest_profile, default_profile};
+
+  ASSERT_NONNULL(default_profile);
+  ASSERT_NONNULL(highest_profile);
+  ASSERT_NONNULL(short_deadline_profile);
+  for (auto& profile : deadline_profiles) {
+    ASSERT_NONNULL(profile);
+  }
+
+  ktl::array<TestThread, kChainLen> threads;
+  ktl::array<LockedOwnedWaitQueue, kChainLen - 1> links;
+
+  AutoProfileBooster pboost;
+  auto cleanup = fit::defer([&]() {
+    TestThread::ClearShutdownBarrier();
+    for (auto& link : links) {
+      link.ReleaseAllThreads();
+    }
+    for (auto& t : threads) {
+      t.Reset();
+    }
+  });
+
+  TestThread::ResetShutdownBarrier();
+
+  // The thread just downstream of the tail has a short deadline, so changes to
+  // the tail's deadline are absorbed there.
+  for (size_t tndx = 0; tndx < kChainLen; ++tndx) {
+    ASSERT_TRUE(threads[tndx].Create(tndx == kChainLen - 2 ? short_deadline_profile
+                                                           : default_profile));
+  }
+  ASSERT_TRUE(threads[0].DoStall());
+  for (size_t tndx = 1; tndx < kChainLen; ++tndx) {
+    ASSERT_TRUE(threads[tndx].BlockOnOwnedWaitQueue(&links[tndx - 1], &threads[tndx - 1]));
+  }
+
+  Thread& tail = threads[kChainLen - 1].thread();
+  auto VerifyHead = [&](Profile& tail_profile) -> bool {
+    BEGIN_TEST;
+    ExpectedEffectiveProfile expected_profile;
+    threads[0].initial_profile()->SetExpectedBaseProfile(expected_profile);
+    for (size_t tndx = 1; tndx < kChainLen - 1; ++tndx) {
+      threads[tndx].initial_profile()->AccumulateExpectedPressure(expected_profile);
+    }
+    tail_profile.AccumulateExpectedPressure(expected_profile);
+
+    unittest::ThreadEffectiveProfileObserver observer;
+    observer.Observe(threads[0].thread());
+    ASSERT_TRUE(observer.VerifyExpectedEffectiveProfile(expected_profile));
+    END_TEST;
+  };
+
+  auto Measure = [&](const char* label, const ktl::array<fbl::RefPtr<Profile>, 2>& profiles) {
+    const zx_instant_mono_t start = current_mono_time();
+    for (uint32_t i = 0; i < kIterations; ++i) {
+      profiles[i % profiles.size()]->Apply(tail);
+    }
+    const zx_duration_mono_t elapsed = current_mono_time() - start;
+    printf("pi chain of %zu, %-28s: %" PRId64 " ns per change\n", kChainLen, label,
+           elapsed / kIterations);
+  };
+
+  Measure("unchanged profile", {default_profile, default_profile});
+  ASSERT_TRUE(VerifyHead(*default_profile));
+
+  deadline_profiles[0]->Apply(tail);
+  Measure("equal utilization deadlines", deadline_profiles);
+  ASSERT_TRUE(VerifyHead(*deadline_profiles[(kIterations - 1) % deadline_profiles.size()]));
+
+  Measure("different weights", fair_profiles);
+  ASSERT_TRUE(VerifyHead(*fair_profiles[(kIterations - 1) % fair_profiles.size()]));
+
+  END_TEST;
+}
+
 bool bug_42182770_regression() {
   BEGIN_TEST;
 
@@ -1726,5 +1824,6 @@ UNITTEST("multiple waiters", pi_test_multi_waiter)
 UNITTEST("multiple owned queues", pi_test_multi_owned_queues)
 UNITTEST("cycles (inheritable)", pi_test_cycle<InheritableProfile::Yes>)
 UNITTEST("cycles (non-inheritable)", pi_test_cycle<InheritableProfile::No>)
+UNITTEST("chain propagation cost", pi_test_chain_propagation_cost)
 UNITTEST("b/42182770 regression test", bug_42182770_regression)
 UNITTEST_END_TESTCASE(pi_tests, "pi", "Priority inheritance tests for OwnedWaitQueues")
@@ -31,10 +31,10 @@ class PreemptDisableTestAccess {
     return {preemption_state->preempts_pending()};
   }
   static void RestoreState(PreemptionState* preemption_state, State state) {
-    preemption_state->preempts_pending_ = state.preempts_pending;
+    preemption_state->preempts_pending_.store(state.preempts_pending);
   }
   static void ClearPending(PreemptionState* preemption_state) {
-    preemption_state->preempts_pending_ = 0;
+    preemption_state->preempts_pending_.store({});
   }
 };
 
@@ -57,7 +57,7 @@ static void timer_callback_func(Timer* timer, zx_instant_mono_t now, void* arg)
   // Test that Scheduler::Reschedule() sets the preempt_pending flag when
   // PreemptDisable is set.
   PreemptDisableTestAccess::ClearPending(&preemption_state);
-  ASSERT(preemption_state.preempts_pending() == 0);
+  ASSERT(preemption_state.preempts_pending().none());
   {
     const auto do_transaction = [&]() TA_REQ(chainlock_transaction_token) {
       Thread& current_thread = *Thread::Current::Get();
@@ -69,14 +69,14 @@ static void timer_callback_func(Timer* timer, zx_instant_mono_t now, void* arg)
     ChainLockTransaction::UntilDone(IrqSaveOption, CLT_TAG("PreemptDisableTests timer_callback"),
                                     do_transaction);
   }
-  ASSERT(preemption_state.preempts_pending() != 0);
+  ASSERT(preemption_state.preempts_pending().any());
 
   // Test that preemption_state.PreemptSetPending() sets preempts_pending.
   PreemptDisableTestAccess::ClearPending(&preemption_state);
-  ASSERT(preemption_state.preempts_pending() == 0);
+  ASSERT(preemption_state.preempts_pending().none());
 
   preemption_state.PreemptSetPending();
-  ASSERT(preemption_state.preempts_pending() != 0);
+  ASSERT(preemption_state.preempts_pending().any());
 
   PreemptDisableTestAccess::RestoreState(&preemption_state, state);
   event->Signal();
@@ -110,7 +110,7 @@ static bool test_inc_dec_disable_counts() {
   ASSERT_EQ(preemption_state.PreemptDisableCount(), 0u);
   ASSERT_EQ(preemption_state.EagerReschedDisableCount(), 0u);
   // While preemption is allowed, a preemption should not be pending.
-  ASSERT_EQ(preemption_state.preempts_pending(), 0u);
+  ASSERT_TRUE(preemption_state.preempts_pending().none());
 
   // Test incrementing and decrementing of PreemptDisable.
   preemption_state.PreemptDisable();
@@ -148,21 +148,21 @@ static bool test_decrement_clears_preempt_pending() {
 
   PreemptionState& preemption_state = Thread::Current::preemption_state();
   ASSERT_TRUE(preemption_state.PreemptIsEnabled());
-  ASSERT_EQ(preemption_state.preempts_pending(), 0u);
+  ASSERT_TRUE(preemption_state.preempts_pending().none());
 
   // Test that preemption_state.PreemptReenable() clears preempt_pending.
   preemption_state.PreemptDisable();
   Thread::Current::Reschedule();
-  EXPECT_NE(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().any());
   preemption_state.PreemptReenable();
-  EXPECT_EQ(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().none());
 
   // Test that preemption_state.EagerReschedReenable() clears preempt_pending.
   preemption_state.EagerReschedDisable();
   Thread::Current::Reschedule();
-  EXPECT_NE(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().any());
   preemption_state.EagerReschedReenable();
-  EXPECT_EQ(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().none());
 
   END_TEST;
 }
@@ -176,12 +176,12 @@ static bool test_blocking_clears_preempt_pending() {
   // should clear a pending local preemption.
   preemption_state.PreemptDisable();
   Thread::Current::Reschedule();
-  EXPECT_NE(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().any());
   interrupt_saved_state_t int_state = arch_interrupt_save();
   Thread::Current::SleepRelative(ZX_MSEC(10));
   // Read preempts_pending with interrupts disabled because otherwise an
   // interrupt handler could set it.
-  EXPECT_EQ(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().none());
   arch_interrupt_restore(int_state);
   preemption_state.PreemptReenable();
 
@@ -193,7 +193,7 @@ static bool test_blocking_clears_preempt_pending() {
   Thread::Current::SleepRelative(ZX_MSEC(10));
   // Read preempts_pending with interrupts disabled because otherwise an
   // interrupt handler could set it.
-  EXPECT_EQ(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().none());
   arch_interrupt_restore(int_state);
   preemption_state.EagerReschedReenable();
 
@@ -222,10 +222,10 @@ static bool test_interrupt_preserves_preempt_pending() {
   bool do_preempt = int_handler_finish(&state);
 
   EXPECT_EQ(do_preempt, false);
-  EXPECT_NE(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().any());
   arch_interrupt_restore(int_state);
   preemption_state.EagerReschedReenable();
-  EXPECT_EQ(preemption_state.preempts_pending(), 0u);
+  EXPECT_TRUE(preemption_state.preempts_pending().none());
 
   END_TEST;
 }
@@ -261,7 +261,7 @@ static bool test_interrupt_with_preempt_disable() {
   // Spin until timer_ran is set by the interrupt handler.
   while (!timer_ran.load()) {
   }
-  EXPECT_EQ(preemption_state.preempts_pending(), cpu_num_to_mask(arch_curr_cpu_num()));
+  EXPECT_TRUE(preemption_state.preempts_pending() == cpu_num_to_mask(arch_curr_cpu_num()));
   preemption_state.PreemptReenable();
 
   // Make sure the timer has fully completed prior to letting it go out of scope.
@@ -474,7 +474,7 @@ static bool test_local_preempt_pending() {
     // local CPU should become pending.
     event.Signal();
     cpu_mask_t pending = Thread::Current::preemption_state().preempts_pending();
-    EXPECT_NE(0u, pending);
+    EXPECT_TRUE(pending.any());
     EXPECT_TRUE(pending | cpu_num_to_mask(arch_curr_cpu_num()));
     END_TEST;
   }));
@@ -487,7 +487,7 @@ static bool test_local_preempt_pending() {
     // disable), a preemption event for the local CPU should become pending.
     event.Signal();
     cpu_mask_t pending = Thread::Current::preemption_state().preempts_pending();
-    EXPECT_NE(0u, pending);
+    EXPECT_TRUE(pending.any());
     EXPECT_TRUE(pending | cpu_num_to_mask(arch_curr_cpu_num()));
     END_TEST;
   }));
@@ -500,7 +500,7 @@ static bool test_local_preempt_pending() {
     // disable), a preemption event for the local CPU should become pending.
     event.Signal();
     cpu_mask_t pending = Thread::Current::preemption_state().preempts_pending();
-    EXPECT_NE(0u, pending);
+    EXPECT_TRUE(pending.any());
     EXPECT_TRUE(pending | cpu_num_to_mask(arch_curr_cpu_num()));
     END_TEST;
   }));
@@ -514,7 +514,7 @@ static bool test_local_preempt_pending() {
     // should become pending.
     event.Signal();
     cpu_mask_t pending = Thread::Current::preemption_state().preempts_pending();
-    EXPECT_NE(0u, pending);
+    EXPECT_TRUE(pending.any());
     EXPECT_TRUE(pending | cpu_num_to_mask(arch_curr_cpu_num()));
     END_TEST;
   }));
@@ -531,7 +531,7 @@ static bool test_local_preempt_pending() {
     // should become pending.
     event.Signal();
     cpu_mask_t pending = Thread::Current::preemption_state().preempts_pending();
-    EXPECT_NE(0u, pending);
+    EXPECT_TRUE(pending.any());
     EXPECT_TRUE(pending | cpu_num_to_mask(arch_curr_cpu_num()));
     END_TEST;
   }));
@@ -649,7 +649,7 @@ static bool test_flush_race() {
     }
     ASSERT_FALSE(preemption_state.PreemptIsEnabled());
     // See that we did not flush.
-    ASSERT_EQ(curr_mask, preemption_state.preempts_pending());
+    ASSERT_TRUE(curr_mask == preemption_state.preempts_pending());
   }
 
   // Test PreemptReenableDelayFlush.
@@ -680,7 +680,7 @@ static bool test_flush_race() {
     }
     ASSERT_FALSE(preemption_state.PreemptIsEnabled());
     // See that we flushed the remote CPUs, but not the local.
-    ASSERT_EQ(curr_mask, preemption_state.preempts_pending());
+    ASSERT_TRUE(curr_mask == preemption_state.preempts_pending());
   }
 
   END_TEST;
@@ -0,0 +1,150 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/arch/intrin.h>
+#include <lib/unittest/unittest.h>
+
+#include <kernel/cpu.h>
+#include <kernel/mp.h>
+#include <kernel/rcu.h>
+#include <kernel/thread.h>
+#include <ktl/atomic.h>
+
+#include "tests.h"
+
+#include <ktl/enforce.h>
+
+namespace {
+
+bool rcu_read_guard_test() {
+  BEGIN_TEST;
+
+  EXPECT_FALSE(rcu::InReadSection());
+  {
+    rcu::RcuReadGuard guard;
+    EXPECT_TRUE(rcu::InReadSection());
+    {
+      rcu::RcuReadGuard nested;
+      EXPECT_TRUE(rcu::InReadSection());
+    }
+    EXPECT_TRUE(rcu::InReadSection());
+  }
+  EXPECT_FALSE(rcu::InReadSection());
+
+  END_TEST;
+}
+
+bool rcu_synchronize_restores_affinity_test() {
+  BEGIN_TEST;
+
+  Thread* const current = Thread::Current::Get();
+  const cpu_mask_t affinity = current->GetCpuAffinity();
+  rcu::Synchronize();
+  EXPECT_TRUE(current->GetCpuAffinity() == affinity);
+
+  END_TEST;
+}
+
+bool rcu_call_test() {
+  BEGIN_TEST;
+
+  struct Node {
+    rcu::RcuHead head;
+    ktl::atomic<int>* count;
+  };
+
+  constexpr int kNodes = 16;
+  ktl::atomic<int> count{0};
+  Node nodes[kNodes];
+  for (Node& node : nodes) {
+    node.count = &count;
+    rcu::Call(&node.head, [](rcu::RcuHead* head) {
+      reinterpret_cast<Node*>(head)->count->fetch_add(1);
+    });
+  }
+
+  rcu::Barrier();
+  EXPECT_EQ(kNodes, count.load());
+
+  END_TEST;
+}
+
+// Verify that Synchronize does not return while a read-side section which was
+// in progress when it was called is still running on another CPU.
+bool rcu_synchronize_waits_for_reader_test() {
+  BEGIN_TEST;
+
+  const cpu_mask_t others = mp_get_online_mask() & ~cpu_num_to_mask(arch_curr_cpu_num());
+  if (!others) {
+    printf("skipping test, requires at least 2 online CPUs\n");
+    END_TEST;
+  }
+
+  struct State {
+    ktl::atomic<bool> reader_in_section{false};
+    ktl::atomic<bool> release_reader{false};
+    ktl::atomic<bool> synchronized{false};
+  } state;
+
+  Thread* reader = Thread::Create(
+      "rcu reader",
+      [](void* arg) -> int {
+        State* state = static_cast<State*>(arg);
+        rcu::RcuReadGuard guard;
+        state->reader_in_section.store(true);
+        while (!state->release_reader.load()) {
+          arch::Yield();
+        }
+        // The writer must still be waiting for us.
+        return state->synchronized.load() ? 0 : 1;
+      },
+      &state, DEFAULT_PRIORITY);
+  ASSERT_NONNULL(reader);
+  // Keep the spinning reader off of our CPU so that we can keep running.
+  reader->SetCpuAffinity(cpu_num_to_mask(lowest_cpu_set(others)));
+  reader->Resume();
+
+  while (!state.reader_in_section.load()) {
+    Thread::Current::Yield();
+  }
+
+  Thread* writer = Thread::Create(
+      "rcu writer",
+      [](void* arg) -> int {
+        State* state = static_cast<State*>(arg);
+        rcu::Synchronize();
+        state->synchronized.store(true);
+        return 0;
+      },
+      &state, DEFAULT_PRIORITY);
+  ASSERT_NONNULL(writer);
+  writer->Resume();
+
+  // Give the writer a chance to (incorrectly) finish early.
+  Thread::Current::SleepRelative(ZX_MSEC(10));
+  EXPECT_FALSE(state.synchronized.load());
+
+  state.release_reader.store(true);
+
+  int reader_ret = -1;
+  int writer_ret = -1;
+  EXPECT_EQ(ZX_OK, reader->Join(&reader_ret, ZX_TIME_INFINITE));
+  EXPECT_EQ(ZX_OK, writer->Join(&writer_ret, ZX_TIME_INFINITE));
+  EXPECT_EQ(1, reader_ret);
+  EXPECT_EQ(0, writer_ret);
+  EXPECT_TRUE(state.synchronized.load());
+
+  END_TEST;
+}
+
+}  // namespace
+
+UNITTEST_START_TESTCASE(rcu_tests)
+UNITTEST("read guard", rcu_read_guard_test)
+UNITTEST("synchronize restores affinity", rcu_synchronize_restores_affinity_test)
+UNITTEST("call", rcu_call_test)
+UNITTEST("synchronize waits for reader", rcu_synchronize_waits_for_reader_test)
+UNITTEST_END_TESTCASE(rcu_tests, "rcu", "RCU deferred reclamation tests")
@@ -53,7 +53,7 @@ static int deadlock_test_thread(void* arg) {
 
   ktl::atomic<int> counter(0);
   InterruptDisableGuard block_interrupts;
-  mp_sync_exec(mp_ipi_target::ALL_BUT_LOCAL, 0, counter_task, &counter);
+  mp_sync_exec(mp_ipi_target::ALL_BUT_LOCAL, {}, counter_task, &counter);
   return 0;
 }
 
@@ -86,8 +86,8 @@ static bool sync_ipi_tests() {
   BEGIN_TEST;
 
   uint num_cpus = arch_max_num_cpus();
-  uint online = mp_get_online_mask();
-  if (online != (1U << num_cpus) - 1) {
+  cpu_mask_t online = mp_get_online_mask();
+  if (online != CpuMask::FirstN(num_cpus)) {
     printf("Can only run test with all CPUs online\n");
     return true;
   }
@@ -112,7 +112,7 @@ static bool sync_ipi_tests() {
     {
       InterruptDisableGuard irqd;
 
-      mp_sync_exec(mp_ipi_target::ALL_BUT_LOCAL, 0, counter_task, &counter);
+      mp_sync_exec(mp_ipi_target::ALL_BUT_LOCAL, {}, counter_task, &counter);
     }
 
     LTRACEF("  Finished signaling all but local (%d)\n", counter.load());
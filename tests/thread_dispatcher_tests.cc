@@ -6,6 +6,8 @@
 
 #include <lib/unittest/unittest.h>
 
+#include <kernel/deadline_admission.h>
+#include <kernel/scheduler.h>
 #include <object/handle.h>
 #include <object/job_dispatcher.h>
 #include <object/process_dispatcher.h>
@@ -63,7 +65,137 @@ static bool test_create_init_destroy_thread() {
   END_TEST;
 }
 
+// A utilization small enough to fit next to whatever else is admitted.
+constexpr SchedUtilization kSmallUtilization = ffl::FromRatio(1, 100);
+constexpr SchedDuration kDeadline{ZX_MSEC(10)};
+
+static bool test_deadline_admission_admit_reject_release() {
+  BEGIN_TEST;
+
+  if (!DeadlineAdmission::IsEnabled()) {
+    printf("deadline admission control is disabled, skipping\n");
+    END_TEST;
+  }
+
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  const cpu_mask_t affinity = cpu_num_to_mask(cpu);
+  const SchedUtilization remaining = DeadlineAdmission::RemainingCapacity(cpu);
+  if (remaining <= kSmallUtilization) {
+    printf("cpu %u has no deadline capacity left, skipping\n", cpu);
+    END_TEST;
+  }
+
+  // Filling the CPU up leaves no room for anything else.
+  zx::result<DeadlineAdmission::Reservation> full =
+      DeadlineAdmission::Admit(remaining, affinity, {});
+  ASSERT_TRUE(full.is_ok());
+  EXPECT_EQ(cpu, full->cpu);
+  EXPECT_EQ(0, DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+
+  zx::result<DeadlineAdmission::Reservation> rejected =
+      DeadlineAdmission::Admit(kSmallUtilization, affinity, {});
+  EXPECT_EQ(ZX_ERR_NO_RESOURCES, rejected.status_value());
+
+  // The capacity held by a reservation is available to its replacement, and is
+  // kept if the replacement is rejected.
+  zx::result<DeadlineAdmission::Reservation> replaced =
+      DeadlineAdmission::Admit(remaining, affinity, full.value());
+  ASSERT_TRUE(replaced.is_ok());
+  rejected = DeadlineAdmission::Admit(SchedUtilization{remaining + kSmallUtilization}, affinity,
+                                      replaced.value());
+  EXPECT_EQ(ZX_ERR_NO_RESOURCES, rejected.status_value());
+  EXPECT_EQ(0, DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+
+  DeadlineAdmission::Release(replaced.value());
+  EXPECT_EQ(remaining.raw_value(), DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+
+  // No CPU at all to reserve on.
+  rejected = DeadlineAdmission::Admit(kSmallUtilization, cpu_mask_t{}, {});
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS, rejected.status_value());
+
+  END_TEST;
+}
+
+// Deadline reservations follow the thread's affinity, and are released when
+// the dispatcher of a thread that never started is destroyed.
+static bool test_deadline_admission_unstarted_thread() {
+  BEGIN_TEST;
+
+  if (!DeadlineAdmission::IsEnabled()) {
+    printf("deadline admission control is disabled, skipping\n");
+    END_TEST;
+  }
+
+  KernelHandle<JobDispatcher> job;
+  zx_rights_t job_rights;
+  auto status = JobDispatcher::Create(0u, GetRootJobDispatcher(), &job, &job_rights);
+  ASSERT_EQ(status, ZX_OK, "job created");
+
+  KernelHandle<ProcessDispatcher> process;
+  KernelHandle<VmAddressRegionDispatcher> vmar;
+  zx_rights_t process_rights;
+  zx_rights_t vmar_rights;
+  status = ProcessDispatcher::Create(job.dispatcher(), "k-ut-p2", 0u, &process, &process_rights,
+                                     &vmar, &vmar_rights);
+  ASSERT_EQ(status, ZX_OK, "process created");
+
+  KernelHandle<ThreadDispatcher> thread;
+  zx_rights_t thread_rights;
+  status = ThreadDispatcher::Create(process.dispatcher(), 0u, "k-ut-t2", &thread, &thread_rights);
+  ASSERT_EQ(status, ZX_OK, "thread created");
+  status = thread.dispatcher()->Initialize();
+  ASSERT_EQ(status, ZX_OK, "thread init");
+
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  const SchedUtilization remaining = DeadlineAdmission::RemainingCapacity(cpu);
+  if (remaining <= kSmallUtilization) {
+    printf("cpu %u has no deadline capacity left, skipping\n", cpu);
+    END_TEST;
+  }
+  ASSERT_OK(thread.dispatcher()->SetSoftAffinity(cpu_num_to_mask(cpu)));
+
+  // Too much for the one CPU the thread may run on.
+  const SchedulerState::BaseProfile too_large{
+      SchedDeadlineParams{SchedUtilization{remaining + kSmallUtilization}, kDeadline}};
+  EXPECT_EQ(ZX_ERR_NO_RESOURCES, thread.dispatcher()->SetBaseProfile(too_large));
+  EXPECT_EQ(remaining.raw_value(), DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+
+  const SchedulerState::BaseProfile profile{SchedDeadlineParams{kSmallUtilization, kDeadline}};
+  ASSERT_OK(thread.dispatcher()->SetBaseProfile(profile));
+  EXPECT_EQ(SchedUtilization{remaining - kSmallUtilization}.raw_value(),
+            DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+
+  // Moving the thread to another CPU moves its reservation along.
+  const cpu_mask_t others = Scheduler::PeekActiveMask() & mask_all_but_one(cpu);
+  for (cpu_num_t other = 0; other < SMP_MAX_CPUS; other++) {
+    if (!others.test(other)) {
+      continue;
+    }
+    const SchedUtilization other_remaining = DeadlineAdmission::RemainingCapacity(other);
+    if (other_remaining < kSmallUtilization) {
+      continue;
+    }
+    ASSERT_OK(thread.dispatcher()->SetSoftAffinity(cpu_num_to_mask(other)));
+    EXPECT_EQ(remaining.raw_value(), DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+    EXPECT_EQ(SchedUtilization{other_remaining - kSmallUtilization}.raw_value(),
+              DeadlineAdmission::RemainingCapacity(other).raw_value());
+    ASSERT_OK(thread.dispatcher()->SetSoftAffinity(cpu_num_to_mask(cpu)));
+    EXPECT_EQ(other_remaining.raw_value(),
+              DeadlineAdmission::RemainingCapacity(other).raw_value());
+    break;
+  }
+
+  // The thread never started, so only destroying it gives the capacity back.
+  thread.reset();
+  EXPECT_EQ(remaining.raw_value(), DeadlineAdmission::RemainingCapacity(cpu).raw_value());
+
+  END_TEST;
+}
+
 UNITTEST_START_TESTCASE(thread_dispatcher)
 UNITTEST("test create destroy thread", test_create_destroy_thread_no_init)
 UNITTEST("test create init destroy thread", test_create_init_destroy_thread)
+UNITTEST("test deadline admission admit reject release",
+         test_deadline_admission_admit_reject_release)
+UNITTEST("test deadline admission unstarted thread", test_deadline_admission_unstarted_thread)
 UNITTEST_END_TESTCASE(thread_dispatcher, "thread_dispatcher", "Dispatcher objec tests")
@@ -657,11 +657,11 @@ static void spin_while(zx_instant_mono_t t, T func) {
 
 static cpu_mask_t random_mask(cpu_mask_t active) {
   cpu_mask_t r;
-  DEBUG_ASSERT(active != 0);
+  DEBUG_ASSERT(active.any());
   // Assuming rand is properly random this should converge in 2 iterations on average.
   do {
-    r = rand() % active;
-  } while (r == 0);
+    r = CpuMask::FromWord(static_cast<CpuMask::Word>(rand())) & active;
+  } while (r.none());
   return r;
 }
 
@@ -677,7 +677,7 @@ static int affinity_test_thread(void* arg) {
     switch (rand() % 5) {
       case 0:  // set affinity
         // printf("%p set aff %p\n", t, state->threads[which]);
-        state->threads[which]->SetCpuAffinity((cpu_mask_t)random_mask(active));
+        state->threads[which]->SetCpuAffinity(random_mask(active));
         break;
       case 1:  // sleep for a bit
         // printf("%p sleep\n", t);
@@ -5,6 +5,7 @@
 // https://opensource.org/licenses/MIT
 
 #include <inttypes.h>
+#include <lib/arch/intrin.h>
 #include <lib/fit/defer.h>
 #include <lib/unittest/unittest.h>
 #include <lib/zircon-internal/macros.h>
@@ -255,13 +256,7 @@ static int timer_stress_worker(void* void_arg) {
 }
 
 static unsigned get_num_cpus_online() {
-  unsigned count = 0;
-  cpu_mask_t online = mp_get_online_mask();
-  while (online) {
-    online >>= 1;
-    ++count;
-  }
-  return count;
+  return static_cast<unsigned>(mp_get_online_mask().count());
 }
 
 // timer_stress is a simple stress test intended to flush out bugs in kernel timers.
@@ -302,6 +297,48 @@ int timer_stress(int argc, const cmd_args* argv, uint32_t) {
   return 0;
 }
 
+// Measures the cost of setting and canceling a growing number of pending timers on one cpu.
+static void timer_bench_one(size_t count, TimerSlack slack) {
+  fbl::AllocChecker ac;
+  auto timers = ktl::unique_ptr<Timer[]>(new (&ac) Timer[count]);
+  if (!ac.check()) {
+    printf("failed to allocate %zu timers\n", count);
+    return;
+  }
+
+  // Far enough out that none of the timers fire while we hold them.
+  const zx_instant_mono_t when = current_mono_time() + ZX_HOUR(1);
+  uint64_t set_cycles;
+  uint64_t cancel_cycles;
+  {
+    InterruptDisableGuard block_interrupts;
+    uint64_t start = arch::Cycles();
+    for (size_t i = 0; i < count; i++) {
+      const Deadline deadline(when + rand_duration(ZX_SEC(1)), slack);
+      timers[i].Set(deadline, [](Timer*, zx_instant_mono_t, void*) {}, nullptr);
+    }
+    set_cycles = arch::Cycles() - start;
+
+    start = arch::Cycles();
+    for (size_t i = 0; i < count; i++) {
+      timers[i].Cancel();
+    }
+    cancel_cycles = arch::Cycles() - start;
+  }
+
+  printf("%6zu timers, slack %8" PRIi64 ": %6" PRIu64 " cycles/set %6" PRIu64 " cycles/cancel\n",
+         count, slack.amount(), set_cycles / count, cancel_cycles / count);
+}
+
+// timer_bench reports how the cost of Timer::Set and Timer::Cancel scales with queue depth.
+int timer_bench(int, const cmd_args*, uint32_t) {
+  for (size_t count = 100; count <= 100000; count *= 10) {
+    timer_bench_one(count, TimerSlack::none());
+    timer_bench_one(count, TimerSlack(ZX_USEC(100), TIMER_SLACK_CENTER));
+  }
+  return 0;
+}
+
 struct timer_args {
   ktl::atomic<int> result;
   ktl::atomic<int> timer_fired;
@@ -340,6 +377,146 @@ static bool cancel_after_fired() {
   END_TEST;
 }
 
+// Checks how timers set at |when| plus each of |offsets| are coalesced under |slack|.
+static bool check_coalescing(TimerSlack slack, const zx_duration_mono_t* offsets,
+                             const zx_duration_mono_t* expected_adj, size_t count) {
+  BEGIN_TEST;
+
+  fbl::AllocChecker ac;
+  auto timers = ktl::unique_ptr<Timer[]>(new (&ac) Timer[count]);
+  ASSERT_TRUE(ac.check());
+  auto cleanup = fit::defer([&]() {
+    for (size_t i = 0; i < count; ++i) {
+      timers[i].Cancel();
+    }
+  });
+
+  // Far enough out that none of the timers fire during the test. Interrupts stay disabled so
+  // that every timer lands on the same cpu's queue.
+  const zx_instant_mono_t when = current_mono_time() + ZX_HOUR(1);
+  {
+    InterruptDisableGuard block_interrupts;
+    for (size_t i = 0; i < count; ++i) {
+      timers[i].Set(Deadline(when + offsets[i], slack), [](Timer*, zx_instant_mono_t, void*) {},
+                    nullptr);
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    EXPECT_EQ(expected_adj[i], timers[i].slack_for_test());
+    EXPECT_EQ(when + offsets[i] + expected_adj[i],
+              timers[i].scheduled_time_for_test(ZX_CLOCK_MONOTONIC));
+  }
+
+  END_TEST;
+}
+
+// The same cases as timer_diag, but checked.
+static bool coalescing() {
+  BEGIN_TEST;
+
+  constexpr zx_duration_mono_t off = ZX_USEC(10);
+  {
+    const zx_duration_mono_t offsets[] = {6 * off, 0, -off, -3 * off, off, 3 * off, 5 * off,
+                                          -3 * off};
+    const zx_duration_mono_t expected_adj[] = {0, 0, off, 0, -off, 0, off, 0};
+    EXPECT_TRUE(check_coalescing(TimerSlack(2 * off, TIMER_SLACK_CENTER), offsets, expected_adj,
+                                 ktl::size(offsets)));
+  }
+  {
+    const zx_duration_mono_t offsets[] = {off, 2 * off, -off, -3 * off, 3 * off, 2 * off, -4 * off};
+    const zx_duration_mono_t expected_adj[] = {0, 0, 2 * off, 0, 0, 0, off};
+    EXPECT_TRUE(check_coalescing(TimerSlack(3 * off, TIMER_SLACK_LATE), offsets, expected_adj,
+                                 ktl::size(offsets)));
+  }
+  {
+    const zx_duration_mono_t offsets[] = {0, 2 * off, -off, -3 * off, 4 * off, 5 * off, -2 * off};
+    const zx_duration_mono_t expected_adj[] = {0, -2 * off, 0, 0, 0, -off, -off};
+    EXPECT_TRUE(check_coalescing(TimerSlack(3 * off, TIMER_SLACK_EARLY), offsets, expected_adj,
+                                 ktl::size(offsets)));
+  }
+
+  END_TEST;
+}
+
+struct fire_in_order_args {
+  ktl::atomic<size_t> fired;
+  ktl::atomic<zx_instant_mono_t> last;
+  ktl::atomic<bool> out_of_order;
+};
+
+static void fire_in_order_cb(Timer* t, zx_instant_mono_t now, void* void_arg) {
+  fire_in_order_args* arg = reinterpret_cast<fire_in_order_args*>(void_arg);
+  const zx_instant_mono_t scheduled = t->scheduled_time_for_test(ZX_CLOCK_MONOTONIC);
+  if (scheduled < arg->last.load()) {
+    arg->out_of_order.store(true);
+  }
+  arg->last.store(scheduled);
+  arg->fired.fetch_add(1);
+}
+
+// Set many timers in a scrambled order on one cpu and see that they fire in deadline order.
+static bool fire_in_order() {
+  BEGIN_TEST;
+
+  constexpr size_t kNumTimers = 1000;
+  fbl::AllocChecker ac;
+  auto timers = ktl::unique_ptr<Timer[]>(new (&ac) Timer[kNumTimers]);
+  ASSERT_TRUE(ac.check());
+  fire_in_order_args arg{};
+
+  {
+    InterruptDisableGuard block_interrupts;
+    const zx_instant_mono_t when = current_mono_time() + ZX_MSEC(1);
+    for (size_t i = 0; i < kNumTimers; ++i) {
+      // Spread the deadlines over a few milliseconds, out of insertion order.
+      const zx_duration_mono_t offset = ZX_USEC(static_cast<int64_t>((i * 7919) % 5000));
+      timers[i].Set(Deadline::no_slack(when + offset), fire_in_order_cb, &arg);
+    }
+  }
+
+  while (arg.fired.load() != kNumTimers) {
+    Thread::Current::SleepRelative(ZX_MSEC(1));
+  }
+  for (size_t i = 0; i < kNumTimers; ++i) {
+    EXPECT_FALSE(timers[i].Cancel());
+  }
+  EXPECT_FALSE(arg.out_of_order.load());
+
+  END_TEST;
+}
+
+// Set a timer on one cpu and cancel it from another.
+static bool cancel_from_other_cpu() {
+  BEGIN_TEST;
+
+  // We need 2 or more CPUs for this test.
+  if (get_num_cpus_online() < 2) {
+    printf("skipping test cancel_from_other_cpu, not enough online cpus\n");
+    return true;
+  }
+
+  timer_args arg{};
+  Timer t;
+  const cpu_mask_t old_affinity = Thread::Current::Get()->GetCpuAffinity();
+  auto restore_affinity =
+      fit::defer([&]() { Thread::Current::Get()->SetCpuAffinity(old_affinity); });
+
+  // Set the timer on timer_cpu's queue, then move to a different cpu before canceling it.
+  {
+    InterruptDisableGuard block_interrupts;
+    cpu_num_t timer_cpu = arch_curr_cpu_num();
+    t.Set(Deadline::after_mono(ZX_HOUR(5)), timer_cb, &arg);
+    Thread::Current::Get()->SetCpuAffinity(~cpu_num_to_mask(timer_cpu));
+    DEBUG_ASSERT(arch_curr_cpu_num() != timer_cpu);
+  }
+
+  ASSERT_TRUE(t.Cancel());
+  ASSERT_FALSE(arg.timer_fired.load());
+  ASSERT_FALSE(t.Cancel());
+  END_TEST;
+}
+
 static void timer_cancel_cb(Timer* t, zx_instant_mono_t now, void* void_arg) {
   timer_args* arg = reinterpret_cast<timer_args*>(void_arg);
   arg->result.store(t->Cancel());
@@ -663,6 +840,9 @@ static bool boot_timer() {
 UNITTEST_START_TESTCASE(timer_tests)
 UNITTEST("cancel_before_deadline", cancel_before_deadline)
 UNITTEST("cancel_after_fired", cancel_after_fired)
+UNITTEST("cancel_from_other_cpu", cancel_from_other_cpu)
+UNITTEST("coalescing", coalescing)
+UNITTEST("fire_in_order", fire_in_order)
 UNITTEST("cancel_from_callback", cancel_from_callback)
 UNITTEST("set_from_callback", set_from_callback)
 UNITTEST("trylock_or_cancel_canceled", trylock_or_cancel_canceled)
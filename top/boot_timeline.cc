@@ -0,0 +1,188 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <assert.h>
+#include <lib/arch/ticks.h>
+#include <lib/counters.h>
+#include <lib/ktrace.h>
+#include <platform.h>
+
+#include <arch/ops.h>
+#include <lk/boot_timeline.h>
+#include <phys/handoff.h>
+#include <platform/timer.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+// Like the physboot samples in handoff.cc, each of these holds the zx_ticks_t at which the point
+// was reached. boot.timeline.threading and boot.timeline.init are set directly by main.cc.
+KCOUNTER(timeline_earliest, "boot.timeline.earliest")
+KCOUNTER(timeline_arch_early, "boot.timeline.arch-early")
+KCOUNTER(timeline_platform_early, "boot.timeline.platform-early")
+KCOUNTER(timeline_arch_prevm, "boot.timeline.arch-prevm")
+KCOUNTER(timeline_pmm_init_start, "boot.timeline.pmm-init-start")
+KCOUNTER(timeline_pmm_init_end, "boot.timeline.pmm-init-end")
+KCOUNTER(timeline_platform_prevm, "boot.timeline.platform-prevm")
+KCOUNTER(timeline_vm_preheap, "boot.timeline.vm-preheap")
+KCOUNTER(timeline_heap, "boot.timeline.heap")
+KCOUNTER(timeline_vm, "boot.timeline.vm")
+KCOUNTER(timeline_topology, "boot.timeline.topology")
+KCOUNTER(timeline_kernel, "boot.timeline.kernel")
+KCOUNTER(timeline_arch, "boot.timeline.arch")
+KCOUNTER(timeline_platform, "boot.timeline.platform")
+KCOUNTER(timeline_arch_late, "boot.timeline.arch-late")
+KCOUNTER(timeline_userboot, "boot.timeline.userboot")
+
+constexpr size_t kPointCount = static_cast<size_t>(BootTimelinePoint::kCount);
+
+// Only touched by the boot CPU, see boot_timeline_sample().
+arch::EarlyTicks samples[kPointCount];
+bool sampled[kPointCount];
+bool published;
+
+// Emits a "kernel:boot" instant event at a time in the past.
+#define BOOT_TIMELINE_EVENT(label, ticks)                                                        \
+  FXT_EVENT_COMMON(true, KTrace::CategoryEnabled, KTrace::EmitInstant, "kernel:boot",            \
+                   FXT_INTERN_STRING(label), static_cast<uint64_t>(ticks), KTrace::Context::Cpu, \
+                   KTrace::Unused{})
+
+#define BOOT_TIMELINE_POINT(counter, label, ticks) \
+  do {                                             \
+    counter.Set(ticks);                            \
+    BOOT_TIMELINE_EVENT(label, ticks);             \
+  } while (0)
+
+void Publish(BootTimelinePoint point) {
+  const size_t i = static_cast<size_t>(point);
+  if (!sampled[i]) {
+    return;
+  }
+  // Zero if early samples cannot be converted on this machine, see PhysBootTimes.
+  const zx_ticks_t ticks = platform_convert_early_ticks(samples[i]);
+  if (ticks == 0) {
+    return;
+  }
+
+  switch (point) {
+    case BootTimelinePoint::kEarliest:
+      BOOT_TIMELINE_POINT(timeline_earliest, "earliest", ticks);
+      break;
+    case BootTimelinePoint::kArchEarly:
+      BOOT_TIMELINE_POINT(timeline_arch_early, "arch-early", ticks);
+      break;
+    case BootTimelinePoint::kPlatformEarly:
+      BOOT_TIMELINE_POINT(timeline_platform_early, "platform-early", ticks);
+      break;
+    case BootTimelinePoint::kArchPrevm:
+      BOOT_TIMELINE_POINT(timeline_arch_prevm, "arch-prevm", ticks);
+      break;
+    case BootTimelinePoint::kPmmInitStart:
+      BOOT_TIMELINE_POINT(timeline_pmm_init_start, "pmm-init-start", ticks);
+      break;
+    case BootTimelinePoint::kPmmInitEnd:
+      BOOT_TIMELINE_POINT(timeline_pmm_init_end, "pmm-init-end", ticks);
+      break;
+    case BootTimelinePoint::kPlatformPrevm:
+      BOOT_TIMELINE_POINT(timeline_platform_prevm, "platform-prevm", ticks);
+      break;
+    case BootTimelinePoint::kVmPreheap:
+      BOOT_TIMELINE_POINT(timeline_vm_preheap, "vm-preheap", ticks);
+      break;
+    case BootTimelinePoint::kHeap:
+      BOOT_TIMELINE_POINT(timeline_heap, "heap", ticks);
+      break;
+    case BootTimelinePoint::kVm:
+      BOOT_TIMELINE_POINT(timeline_vm, "vm", ticks);
+      break;
+    case BootTimelinePoint::kTopology:
+      BOOT_TIMELINE_POINT(timeline_topology, "topology", ticks);
+      break;
+    case BootTimelinePoint::kKernel:
+      BOOT_TIMELINE_POINT(timeline_kernel, "kernel", ticks);
+      break;
+    case BootTimelinePoint::kThreading:
+      BOOT_TIMELINE_EVENT("threading", ticks);
+      break;
+    case BootTimelinePoint::kArch:
+      BOOT_TIMELINE_POINT(timeline_arch, "arch", ticks);
+      break;
+    case BootTimelinePoint::kPlatform:
+      BOOT_TIMELINE_POINT(timeline_platform, "platform", ticks);
+      break;
+    case BootTimelinePoint::kArchLate:
+      BOOT_TIMELINE_POINT(timeline_arch_late, "arch-late", ticks);
+      break;
+    case BootTimelinePoint::kUserboot:
+      BOOT_TIMELINE_POINT(timeline_userboot, "userboot", ticks);
+      break;
+    case BootTimelinePoint::kInit:
+      BOOT_TIMELINE_EVENT("init", ticks);
+      break;
+    case BootTimelinePoint::kCount:
+      break;
+  }
+}
+
+// The physboot samples already have kcounters, see handoff.cc, so only emit their events.
+void PublishPhys() {
+  for (size_t i = 0; i < PhysBootTimes::kCount; ++i) {
+    const PhysBootTimes::Index when = static_cast<PhysBootTimes::Index>(i);
+    const zx_ticks_t ticks = platform_convert_early_ticks(gPhysHandoff->times.Get(when));
+    if (ticks == 0) {
+      continue;
+    }
+    switch (when) {
+      case PhysBootTimes::kZbiEntry:
+        BOOT_TIMELINE_EVENT("phys-zbi-entry", ticks);
+        break;
+      case PhysBootTimes::kPhysSetup:
+        BOOT_TIMELINE_EVENT("phys-setup", ticks);
+        break;
+      case PhysBootTimes::kDecompressStart:
+        BOOT_TIMELINE_EVENT("phys-decompress-start", ticks);
+        break;
+      case PhysBootTimes::kDecompressEnd:
+        BOOT_TIMELINE_EVENT("phys-decompress-end", ticks);
+        break;
+      case PhysBootTimes::kKernelLoaded:
+        BOOT_TIMELINE_EVENT("phys-kernel-loaded", ticks);
+        break;
+      case PhysBootTimes::kZbiDone:
+        BOOT_TIMELINE_EVENT("phys-zbi-done", ticks);
+        break;
+      case PhysBootTimes::kHandoffPrepared:
+        BOOT_TIMELINE_EVENT("phys-handoff-prepared", ticks);
+        break;
+      case PhysBootTimes::kCount:
+        break;
+    }
+  }
+}
+
+}  // namespace
+
+void boot_timeline_sample(BootTimelinePoint point) {
+  DEBUG_ASSERT(arch_curr_cpu_num() == BOOT_CPU_ID);
+  const size_t i = static_cast<size_t>(point);
+  DEBUG_ASSERT(i < kPointCount);
+  DEBUG_ASSERT(!sampled[i]);
+  samples[i] = arch::EarlyTicks::Get();
+  sampled[i] = true;
+  if (published) {
+    Publish(point);
+  }
+}
+
+void boot_timeline_publish() {
+  DEBUG_ASSERT(!published);
+  PublishPhys();
+  for (size_t i = 0; i < kPointCount; ++i) {
+    Publish(static_cast<BootTimelinePoint>(i));
+  }
+  published = true;
+}
@@ -71,7 +71,9 @@ KCOUNTER(timeline_zbi_entry, "boot.timeline.zbi")
 KCOUNTER(timeline_physboot_setup, "boot.timeline.physboot-setup")
 KCOUNTER(timeline_decompress_start, "boot.timeline.decompress-start")
 KCOUNTER(timeline_decompress_end, "boot.timeline.decompress-end")
+KCOUNTER(timeline_kernel_loaded, "boot.timeline.kernel-loaded")
 KCOUNTER(timeline_zbi_done, "boot.timeline.zbi-done")
+KCOUNTER(timeline_handoff_prep, "boot.timeline.handoff-prep")
 KCOUNTER(timeline_physboot_handoff, "boot.timeline.physboot-handoff")
 KCOUNTER(timeline_virtual_entry, "boot.timeline.virtual")
 
@@ -102,9 +104,15 @@ void TimelineCounters(unsigned int level) {
       case PhysBootTimes::kDecompressEnd:
         Set(timeline_decompress_end, when);
         break;
+      case PhysBootTimes::kKernelLoaded:
+        Set(timeline_kernel_loaded, when);
+        break;
       case PhysBootTimes::kZbiDone:
         Set(timeline_zbi_done, when);
         break;
+      case PhysBootTimes::kHandoffPrepared:
+        Set(timeline_handoff_prep, when);
+        break;
       case PhysBootTimes::kCount:
         // There is no PhysBootTimes entry corresponding to kCount.
         // This is the first sample taken by the kernel proper after physboot handed off.
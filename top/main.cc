@@ -30,9 +30,11 @@
 #include <dev/init.h>
 #include <kernel/cpu.h>
 #include <kernel/init.h>
+#include <kernel/mp.h>
 #include <kernel/mutex.h>
 #include <kernel/thread.h>
 #include <kernel/topology.h>
+#include <lk/boot_timeline.h>
 #include <lk/init.h>
 #include <phys/handoff.h>
 #include <vm/init.h>
@@ -119,15 +121,18 @@ void lk_main(PhysHandoff* handoff) {
   // constructors (if needed) have been run.
 
   lk_primary_cpu_init_level(LK_INIT_LEVEL_EARLIEST, LK_INIT_LEVEL_ARCH_EARLY - 1);
+  boot_timeline_sample(BootTimelinePoint::kEarliest);
 
   // Carry out any early architecture-specific and platform-specific init
   // required to get the boot CPU and platform into a known state.
   arch_early_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_ARCH_EARLY, LK_INIT_LEVEL_PLATFORM_EARLY - 1);
+  boot_timeline_sample(BootTimelinePoint::kArchEarly);
 
   platform_early_init();
   DriverHandoffEarly(*gPhysHandoff);
   lk_primary_cpu_init_level(LK_INIT_LEVEL_PLATFORM_EARLY, LK_INIT_LEVEL_ARCH_PREVM - 1);
+  boot_timeline_sample(BootTimelinePoint::kPlatformEarly);
 
   // At this point, the kernel command line and serial are set up.
 
@@ -139,24 +144,29 @@ void lk_main(PhysHandoff* handoff) {
   dprintf(SPEW, "initializing arch pre-vm\n");
   arch_prevm_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_ARCH_PREVM, LK_INIT_LEVEL_PLATFORM_PREVM - 1);
+  boot_timeline_sample(BootTimelinePoint::kArchPrevm);
   dprintf(SPEW, "initializing platform pre-vm\n");
   platform_prevm_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_PLATFORM_PREVM, LK_INIT_LEVEL_VM_PREHEAP - 1);
+  boot_timeline_sample(BootTimelinePoint::kPlatformPrevm);
 
   // perform basic virtual memory setup
   dprintf(SPEW, "initializing vm pre-heap\n");
   vm_init_preheap();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_VM_PREHEAP, LK_INIT_LEVEL_HEAP - 1);
+  boot_timeline_sample(BootTimelinePoint::kVmPreheap);
 
   // bring up the kernel heap
   dprintf(SPEW, "initializing heap\n");
   heap_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_HEAP, LK_INIT_LEVEL_VM - 1);
+  boot_timeline_sample(BootTimelinePoint::kHeap);
 
   // enable virtual memory
   dprintf(SPEW, "initializing vm\n");
   vm_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_VM, LK_INIT_LEVEL_TOPOLOGY - 1);
+  boot_timeline_sample(BootTimelinePoint::kVm);
 
   // Initialize the lockup detector, after the platform timer has been
   // configured, but before the topology subsystem has brought up other CPUs.
@@ -168,11 +178,13 @@ void lk_main(PhysHandoff* handoff) {
   dprintf(SPEW, "initializing system topology\n");
   topology_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_TOPOLOGY, LK_INIT_LEVEL_KERNEL - 1);
+  boot_timeline_sample(BootTimelinePoint::kTopology);
 
   // initialize other parts of the kernel
   dprintf(SPEW, "initializing kernel\n");
   kernel_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_KERNEL, LK_INIT_LEVEL_THREADING - 1);
+  boot_timeline_sample(BootTimelinePoint::kKernel);
 
   // Mark the current CPU as being active, then create a thread to complete
   // system initialization
@@ -192,6 +204,7 @@ static int bootstrap2(void*) {
   DEBUG_ASSERT(arch_curr_cpu_num() == BOOT_CPU_ID);
 
   timeline_threading.Set(current_mono_ticks());
+  boot_timeline_sample(BootTimelinePoint::kThreading);
 
   // dprintf(SPEW, "top of bootstrap2()\n");
 
@@ -200,6 +213,8 @@ static int bootstrap2(void*) {
   // when unblocking once we solve races higher in the stack.
   dprintf(INFO, "Boot option: New thread wakeup accounting %s\n",
           gBootOptions->enable_new_wakeup_accounting ? "enabled" : "disabled");
+  dprintf(INFO, "Boot option: Bandwidth model preemption %s\n",
+          gBootOptions->scheduler_bandwidth_preemption ? "enabled" : "disabled");
 #endif  // EXPERIMENTAL_UNIFIED_SCHEDULER_ENABLED
 
   // Initialize the rest of the architecture and platform.
@@ -208,11 +223,13 @@ static int bootstrap2(void*) {
   dprintf(SPEW, "initializing arch\n");
   arch_init();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_ARCH, LK_INIT_LEVEL_PLATFORM - 1);
+  boot_timeline_sample(BootTimelinePoint::kArch);
 
   dprintf(SPEW, "initializing platform\n");
   platform_init();
   DriverHandoffLate(*gPhysHandoff);
   lk_primary_cpu_init_level(LK_INIT_LEVEL_PLATFORM, LK_INIT_LEVEL_ARCH_LATE - 1);
+  boot_timeline_sample(BootTimelinePoint::kPlatform);
 
   // At this point, other cores in the system have been started (though may
   // not yet be online).  Signal that the boot CPU is ready.
@@ -222,6 +239,11 @@ static int bootstrap2(void*) {
   dprintf(SPEW, "initializing late arch\n");
   arch_late_init_percpu();
   lk_primary_cpu_init_level(LK_INIT_LEVEL_ARCH_LATE, LK_INIT_LEVEL_USER - 1);
+  boot_timeline_sample(BootTimelinePoint::kArchLate);
+
+  // Publish the boot timeline now that ktrace is initialized, while the physboot samples are
+  // still available.
+  boot_timeline_publish();
 
   // End hand-off before shell initialization, as we want kernel state to be
   // 'finalized' before we run any kernel scripts (e.g., for unit-testing).
@@ -232,11 +254,13 @@ static int bootstrap2(void*) {
 
   dprintf(SPEW, "starting user space\n");
   userboot_init(ktl::move(handoff_end));
+  boot_timeline_sample(BootTimelinePoint::kUserboot);
 
   dprintf(SPEW, "moving to last init level\n");
   lk_primary_cpu_init_level(LK_INIT_LEVEL_USER, LK_INIT_LEVEL_LAST);
 
   timeline_init.Set(current_mono_ticks());
+  boot_timeline_sample(BootTimelinePoint::kInit);
   return 0;
 }
 
@@ -251,12 +275,16 @@ void lk_secondary_cpu_entry() {
     return;
   }
 
+  mp_record_boot_stage(cpu, mp_boot_stage::EARLY_INIT);
+
   // late CPU initialization for secondary CPUs
   arch_late_init_percpu();
 
   // secondary cpu initialize from threading level up. 0 to threading was handled in arch
   lk_init_level(LK_INIT_FLAG_SECONDARY_CPUS, LK_INIT_LEVEL_THREADING, LK_INIT_LEVEL_LAST);
 
+  mp_record_boot_stage(cpu, mp_boot_stage::LATE_INIT);
+
   lockup_percpu_init();
 
   dprintf(SPEW, "entering scheduler on cpu %u\n", cpu);
@@ -9,8 +9,12 @@
 #include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 
+#include <arch/ops.h>
+#include <kernel/percpu.h>
 #include <ktl/algorithm.h>
+#include <ktl/bit.h>
 #include <vm/lz4_compressor.h>
+#include <vm/lz4hc_compressor.h>
 #include <vm/physmap.h>
 #include <vm/pmm.h>
 #include <vm/slot_page_storage.h>
@@ -19,16 +23,40 @@
 namespace {
 
 KCOUNTER(pages_decompressed, "vm.reclamation.pages_decompressed")
-
-// We always add zx_instant_mono_ticks_t to any data that we store, so ensure that the maximum size
-// of the compressed data combined with that would not require us to store more than a page.
-constexpr size_t ensure_threshold(size_t threshold) {
-  if (threshold + sizeof(zx_instant_mono_ticks_t) > PAGE_SIZE) {
-    return PAGE_SIZE - sizeof(zx_instant_mono_ticks_t);
+// Number of calls to AcquireCompressor that found every instance in use and had to block, and the
+// total time spent blocked.
+KCOUNTER(compressor_acquire_contended, "vm.compression.acquire.contended")
+KCOUNTER(compressor_acquire_wait_ns, "vm.compression.acquire.wait_ns")
+// Per effort compression counts, time spent, and the number of pages and bytes stored. The ratio of
+// stored bytes to stored pages gives the achieved compression ratio of each strategy.
+KCOUNTER(compression_fast_attempts, "vm.compression.fast.attempts")
+KCOUNTER(compression_fast_time_ns, "vm.compression.fast.time_ns")
+KCOUNTER(compression_fast_stored_pages, "vm.compression.fast.stored_pages")
+KCOUNTER(compression_fast_stored_bytes, "vm.compression.fast.stored_bytes")
+KCOUNTER(compression_dense_attempts, "vm.compression.dense.attempts")
+KCOUNTER(compression_dense_time_ns, "vm.compression.dense.time_ns")
+KCOUNTER(compression_dense_stored_pages, "vm.compression.dense.stored_pages")
+KCOUNTER(compression_dense_stored_bytes, "vm.compression.dense.stored_bytes")
+KCOUNTER(compression_dense_retries, "vm.compression.dense.retries")
+// Content deduplication index lookups that found an identical stored page, found an entry with the
+// same hash but different contents, and new entries inserted into the index.
+KCOUNTER(compression_dedup_hits, "vm.compression.dedup.hits")
+KCOUNTER(compression_dedup_collisions, "vm.compression.dedup.collisions")
+KCOUNTER(compression_dedup_inserts, "vm.compression.dedup.inserts")
+
+// We always add a trailer of |trailer_size| to any data that we store, so ensure that the maximum
+// size of the compressed data combined with that would not require us to store more than a page.
+constexpr size_t ensure_threshold(size_t threshold, size_t trailer_size) {
+  if (threshold + trailer_size > PAGE_SIZE) {
+    return PAGE_SIZE - trailer_size;
   }
   return threshold;
 }
 
+constexpr size_t trailer_size(bool dedup) {
+  return sizeof(zx_instant_mono_ticks_t) + (dedup ? sizeof(uint64_t) : 0);
+}
+
 constexpr size_t bucket_for_ticks(zx_instant_mono_ticks_t start, zx_instant_mono_ticks_t end) {
   // Turn the ticks range into seconds. As we want whole seconds we are happy to tolerate the
   // rounding behavior of integer division here.
@@ -37,69 +65,193 @@ constexpr size_t bucket_for_ticks(zx_instant_mono_ticks_t start, zx_instant_mono
   return ktl::min(log2_floor(seconds), VmCompression::kNumLogBuckets - 1);
 }
 
+const char* StrategyName(CompressionStrategy strategy) {
+  switch (strategy) {
+    case CompressionStrategy::kLz4:
+      return "lz4";
+    case CompressionStrategy::kLz4Hc:
+      return "lz4hc";
+    case CompressionStrategy::kNone:
+      break;
+  }
+  return "none";
+}
+
+fbl::RefPtr<VmCompressionStrategy> CreateStrategy(CompressionStrategy strategy,
+                                                  size_t num_streams) {
+  switch (strategy) {
+    case CompressionStrategy::kLz4:
+      return VmLz4Compressor::Create(num_streams);
+    case CompressionStrategy::kLz4Hc:
+      return VmLz4HcCompressor::Create(num_streams);
+    case CompressionStrategy::kNone:
+      break;
+  }
+  return nullptr;
+}
+
+// Returns whether data produced by |dense| can be decompressed by |regular|.
+bool IsCompatibleDenseStrategy(CompressionStrategy regular, CompressionStrategy dense) {
+  // Both lz4 and lz4hc produce regular lz4 blocks.
+  const auto is_lz4 = [](CompressionStrategy s) {
+    return s == CompressionStrategy::kLz4 || s == CompressionStrategy::kLz4Hc;
+  };
+  return is_lz4(regular) && is_lz4(dense);
+}
+
 }  // namespace
 
 VmCompression::CompressorGuard::~CompressorGuard() {
   // Ensure the compressor instance was not left in an in progress state before returning it.
   ASSERT(instance_.IsIdle());
+  if (slot_) {
+    // Drop the lock before the users count so that anyone who sees the slot as idle will not have
+    // to block on it.
+    instance_guard_.Release();
+    slot_->users.fetch_sub(1, ktl::memory_order_release);
+  }
 }
 
 VmCompression::CompressorGuard VmCompression::AcquireCompressor() {
-  Guard<Mutex> guard_{&instance_lock_};
-  return CompressorGuard(instance_, &guard_);
+  const size_t count = compressors_.size();
+  // Start searching from the instance associated with the current CPU, so that reclaimers running
+  // on different CPUs generally find different idle instances. Migrating after reading the CPU
+  // number is harmless, it only makes contention slightly more likely.
+  const size_t start = arch_curr_cpu_num() % count;
+  for (size_t i = 0; i < count; i++) {
+    CompressorSlot& slot = compressors_[(start + i) % count];
+    uint32_t expected = 0;
+    if (slot.users.compare_exchange_strong(expected, 1, ktl::memory_order_acquire,
+                                           ktl::memory_order_relaxed)) {
+      // Other than a thread that is just finishing its release there is no one else who could be
+      // holding this lock, so this should not block.
+      Guard<Mutex> guard{&slot.lock};
+      return CompressorGuard(slot, &guard);
+    }
+  }
+
+  // Every instance is in use, so queue up on the one for this CPU.
+  CompressorSlot& slot = compressors_[start];
+  slot.users.fetch_add(1, ktl::memory_order_acquire);
+  compressor_acquire_contended.Add(1);
+  const zx_instant_mono_t wait_start = current_mono_time();
+  Guard<Mutex> guard{&slot.lock};
+  compressor_acquire_wait_ns.Add(current_mono_time() - wait_start);
+  return CompressorGuard(slot, &guard);
+}
+
+VmCompressor& VmCompression::InstanceForTempReference(CompressedRef ref) {
+  DEBUG_ASSERT(IsTempReference(ref));
+  const size_t index = (kTempReferenceValue - ref.value()) >> CompressedRef::kAlignBits;
+  ASSERT(index < compressors_.size());
+  return *compressors_[index].instance;
 }
 
 VmCompression::VmCompression(fbl::RefPtr<VmCompressedStorage> storage,
                              fbl::RefPtr<VmCompressionStrategy> strategy,
-                             size_t compression_threshold)
+                             size_t compression_threshold, size_t num_compressors,
+                             fbl::RefPtr<VmCompressionStrategy> dense_strategy,
+                             size_t dedup_buckets, bool dense_retry)
     : storage_(ktl::move(storage)),
       strategy_(ktl::move(strategy)),
-      compression_threshold_(ensure_threshold(compression_threshold)),
-      // Currently only a single VmCompressor instance is supported, so only a single temporary
-      // reference value (the reserved value) is needed.
-      instance_(*this, kTempReferenceValue) {
+      dense_strategy_(ktl::move(dense_strategy)),
+      dense_retry_(dense_retry),
+      dedup_buckets_(dedup_buckets > 0 ? ktl::bit_ceil(dedup_buckets) : 0),
+      trailer_size_(trailer_size(dedup_buckets_ > 0)),
+      compression_threshold_(ensure_threshold(compression_threshold, trailer_size_)) {
   ASSERT(storage_);
   ASSERT(strategy_);
-  // Ensure we can steal space to store the compression timestamp.
-  ASSERT(compression_threshold_ + sizeof(zx_instant_mono_ticks_t) <= PAGE_SIZE);
+  // Ensure we can steal space to store the trailer.
+  ASSERT(compression_threshold_ + trailer_size_ <= PAGE_SIZE);
+  ASSERT(num_compressors > 0 && num_compressors <= kMaxCompressors);
+
+  // Each instance is given its own temporary reference value from the reserved range.
+  fbl::AllocChecker ac;
+  compressors_ = fbl::MakeArray<CompressorSlot>(&ac, num_compressors);
+  ASSERT_MSG(ac.check(), "Failed to allocate %zu compressor slots", num_compressors);
+  for (size_t i = 0; i < num_compressors; i++) {
+    compressors_[i].instance =
+        ktl::unique_ptr<VmCompressor>(new (&ac) VmCompressor(*this, TempReferenceForIndex(i)));
+    ASSERT_MSG(ac.check(), "Failed to allocate compressor %zu", i);
+  }
+
+  if (dedup_buckets_ > 0) {
+    {
+      Guard<CriticalMutex> guard{&dedup_lock_};
+      dedup_table_ = fbl::MakeArray<DedupEntry>(&ac, dedup_buckets_);
+      ASSERT_MSG(ac.check(), "Failed to allocate %zu dedup buckets", dedup_buckets_);
+    }
+    Guard<CriticalMutex> guard{&dedup_scratch_lock_};
+    zx_status_t status = pmm_alloc_page(0, &dedup_scratch_page_);
+    ASSERT_MSG(status == ZX_OK, "Failed to allocate dedup scratch page");
+  }
 }
 
 VmCompression::~VmCompression() {
-  if (buffer_page_) {
-    pmm_free_page(buffer_page_);
+  Guard<CriticalMutex> guard{&dedup_scratch_lock_};
+  if (dedup_scratch_page_) {
+    pmm_free_page(dedup_scratch_page_);
   }
 }
 
 VmCompression::CompressResult VmCompression::Compress(const void* page_src,
+                                                      vm_page_t** buffer_page, Effort effort,
                                                       zx_instant_mono_ticks_t now) {
-  VM_KTRACE_DURATION(2, "compress_page");
-  // Take the compression lock so we can use the buffer_page_.
-  Guard<Mutex> guard{&compression_lock_};
+  // Without a dense strategy every compression is performed, and accounted, as a fast one.
+  if (!dense_strategy_) {
+    effort = Effort::Fast;
+  }
+  const bool dense = effort == Effort::Dense;
+  VmCompressionStrategy& strategy = dense ? *dense_strategy_ : *strategy_;
+  EffortStats& effort_stats = effort_stats_[static_cast<size_t>(effort)];
+  VM_KTRACE_DURATION(2, "compress_page", ("dense", dense));
+
+  // If this page is identical to one already stored then there is no need to compress it at all.
+  uint64_t hash = 0;
+  if (IsDedupEnabled()) {
+    hash = HashPage(page_src);
+    if (ktl::optional<CompressedRef> ref = TryDedup(page_src, hash, 0)) {
+      compression_attempts_.fetch_add(1);
+      compression_success_.fetch_add(1);
+      return *ref;
+    }
+  }
 
   // Ensure buffer page exists.
-  if (!buffer_page_) {
+  if (!*buffer_page) {
     // Explicitly do not use delayed allocation since we might be under memory pressure.
-    zx_status_t status = pmm_alloc_page(0, &buffer_page_);
+    zx_status_t status = pmm_alloc_page(0, buffer_page);
     if (status != ZX_OK) {
       return FailTag{};
     }
   }
 
   compression_attempts_.fetch_add(1);
+  effort_stats.attempts.fetch_add(1);
+  (dense ? compression_dense_attempts : compression_fast_attempts).Add(1);
 
   // Compress into the buffer page, measuring the time taken to do so.
   const zx_duration_mono_t start_runtime = Thread::Current::Get()->Runtime();
-  void* buffer_ptr = paddr_to_physmap(buffer_page_->paddr());
-  auto result = strategy_->Compress(page_src, buffer_ptr, compression_threshold_);
+  void* buffer_ptr = paddr_to_physmap((*buffer_page)->paddr());
+  auto result = strategy.Compress(page_src, buffer_ptr, compression_threshold_);
   const zx_duration_mono_t end_runtime = Thread::Current::Get()->Runtime();
   if (likely(end_runtime > start_runtime)) {
-    compression_time_.fetch_add(end_runtime - start_runtime);
+    const zx_duration_mono_t elapsed = end_runtime - start_runtime;
+    compression_time_.fetch_add(elapsed);
+    effort_stats.time.fetch_add(elapsed);
+    (dense ? compression_dense_time_ns : compression_fast_time_ns).Add(elapsed);
   }
 
   // The result is a different type so we need to convert, and it gives us a chance to record
   // statistics.
   if (ktl::holds_alternative<FailTag>(result)) {
     compression_fail_.fetch_add(1);
+    // Content that the fast strategy could not compress well enough may still be worth storing
+    // with the dense strategy, instead of being left uncompressed.
+    if (!dense && dense_retry_ && dense_strategy_) {
+      compression_dense_retries.Add(1);
+      return Compress(page_src, buffer_page, Effort::Dense, now);
+    }
     return FailTag{};
   }
   if (ktl::holds_alternative<ZeroTag>(result)) {
@@ -112,23 +264,34 @@ VmCompression::CompressResult VmCompression::Compress(const void* page_src,
   const size_t compressed_size = *ktl::get_if<size_t>(&result);
   DEBUG_ASSERT(compressed_size > 0 && compressed_size <= compression_threshold_);
 
-  // Store the current ticks for tracking how long pages remain compressed. We had previously
-  // validated in the constructor that we would always have space on the page.
-  const size_t storage_size = compressed_size + sizeof(zx_instant_mono_ticks_t);
+  // Store the trailer, containing the hash when deduplicating and the current ticks for tracking
+  // how long pages remain compressed. We had previously validated in the constructor that we would
+  // always have space on the page.
+  const size_t storage_size = compressed_size + trailer_size_;
   DEBUG_ASSERT(storage_size <= PAGE_SIZE);
+  if (IsDedupEnabled()) {
+    *reinterpret_cast<uint64_t*>(reinterpret_cast<uintptr_t>(buffer_ptr) + compressed_size) = hash;
+  }
   *reinterpret_cast<zx_instant_mono_ticks_t*>(reinterpret_cast<uintptr_t>(buffer_ptr) +
-                                              compressed_size) = now;
+                                              storage_size - sizeof(zx_instant_mono_ticks_t)) = now;
 
-  // Store the data, it takes ownership of the buffer_page_ and might return ownership of a page.
+  // Store the data, it takes ownership of the buffer_page and might return ownership of a page.
   // Metadata associated with the page will be stored later, when the caller reaccquires the VMO
   // lock and requests compression results.
-  auto [maybe_ref, page] = storage_->Store(buffer_page_, storage_size);
-  buffer_page_ = page;
+  auto [maybe_ref, page] = storage_->Store(*buffer_page, storage_size);
+  *buffer_page = page;
 
   if (auto ref = maybe_ref) {
     // Make sure the storage system never produced the temp reference.
     ASSERT(!IsTempReference(*ref));
     compression_success_.fetch_add(1);
+    effort_stats.stored_pages.fetch_add(1);
+    effort_stats.stored_bytes.fetch_add(compressed_size);
+    (dense ? compression_dense_stored_pages : compression_fast_stored_pages).Add(1);
+    (dense ? compression_dense_stored_bytes : compression_fast_stored_bytes).Add(compressed_size);
+    if (IsDedupEnabled()) {
+      InsertDedup(hash, *ref);
+    }
     return *ref;
   }
   compression_fail_.fetch_add(1);
@@ -143,6 +306,48 @@ void VmCompression::Decompress(CompressedRef ref, void* page_dest, uint32_t* met
     return;
   }
 
+  const zx_instant_mono_ticks_t compressed_ticks =
+      DecompressData(ref, page_dest, metadata_dest, now);
+
+  // Now that decompression is finished, free the backing memory.
+  ForgetDedup(ref);
+  storage_->Free(ref);
+  VM_KTRACE_DURATION_END(2, "decompress_page",
+                         ("compressed_time_s", (now - compressed_ticks) / ticks_per_second()));
+}
+
+void VmCompression::DecompressBatch(ktl::span<const CompressedRef> refs,
+                                    ktl::span<void* const> page_dests,
+                                    ktl::span<uint32_t> metadata_dests,
+                                    zx_instant_mono_ticks_t now) {
+  DEBUG_ASSERT(refs.size() == page_dests.size());
+  DEBUG_ASSERT(refs.size() == metadata_dests.size());
+  VM_KTRACE_DURATION(2, "decompress_batch", ("pages", refs.size()));
+
+  // Storage references are released to the storage in runs, broken up by any temporary references,
+  // which are returned as part of decompressing them.
+  size_t run_start = 0;
+  for (size_t i = 0; i < refs.size(); i++) {
+    if (likely(!IsTempReference(refs[i]))) {
+      DecompressData(refs[i], page_dests[i], &metadata_dests[i], now);
+      ForgetDedup(refs[i]);
+      continue;
+    }
+    if (i > run_start) {
+      storage_->FreeBatch(refs.subspan(run_start, i - run_start));
+    }
+    DecompressTempReference(refs[i], page_dests[i], &metadata_dests[i]);
+    run_start = i + 1;
+  }
+  if (refs.size() > run_start) {
+    storage_->FreeBatch(refs.subspan(run_start));
+  }
+}
+
+zx_instant_mono_ticks_t VmCompression::DecompressData(CompressedRef ref, void* page_dest,
+                                                      uint32_t* metadata_dest,
+                                                      zx_instant_mono_ticks_t now) {
+  DEBUG_ASSERT(!IsTempReference(ref));
   pages_decompressed.Add(1);
   decompressions_.fetch_add(1);
 
@@ -157,18 +362,16 @@ void VmCompression::Decompress(CompressedRef ref, void* page_dest, uint32_t* met
   const size_t bucket = bucket_for_ticks(compressed_ticks, now);
   decompressions_within_log_seconds_[bucket].fetch_add(1);
 
-  // Decompress the data, excluding our timestamp, and measure how long decompression takes.
+  // Decompress the data, excluding our trailer, and measure how long decompression takes.
+  DEBUG_ASSERT(len > trailer_size_);
   const zx_duration_mono_t start_runtime = Thread::Current::Get()->Runtime();
-  strategy_->Decompress(src, len - sizeof(zx_instant_mono_ticks_t), page_dest);
+  strategy_->Decompress(src, len - trailer_size_, page_dest);
   const zx_duration_mono_t end_runtime = Thread::Current::Get()->Runtime();
+  storage_->ReleaseCompressedData(ref);
   if (end_runtime > start_runtime) {
     decompression_time_.fetch_add(end_runtime - start_runtime);
   }
-
-  // Now that decompression is finished, free the backing memory.
-  storage_->Free(ref);
-  VM_KTRACE_DURATION_END(2, "decompress_page",
-                         ("compressed_time_s", (now - compressed_ticks) / ticks_per_second()));
+  return compressed_ticks;
 }
 
 void VmCompression::Free(CompressedRef ref) {
@@ -176,15 +379,157 @@ void VmCompression::Free(CompressedRef ref) {
     FreeTempReference(ref);
     return;
   }
+  ForgetDedup(ref);
   storage_->Free(ref);
   decompression_skipped_.fetch_add(1);
 }
 
+void VmCompression::FreeBatch(ktl::span<const CompressedRef> refs) {
+  // As with |DecompressBatch| runs of storage references are freed together.
+  size_t run_start = 0;
+  for (size_t i = 0; i < refs.size(); i++) {
+    if (likely(!IsTempReference(refs[i]))) {
+      ForgetDedup(refs[i]);
+      continue;
+    }
+    if (i > run_start) {
+      storage_->FreeBatch(refs.subspan(run_start, i - run_start));
+      decompression_skipped_.fetch_add(i - run_start);
+    }
+    FreeTempReference(refs[i]);
+    run_start = i + 1;
+  }
+  if (refs.size() > run_start) {
+    storage_->FreeBatch(refs.subspan(run_start));
+    decompression_skipped_.fetch_add(refs.size() - run_start);
+  }
+}
+
+// static
+uint64_t VmCompression::HashPage(const void* page_src) {
+  // The hash is only used to find candidates, which are always compared in full before being
+  // deduplicated, so it just needs to be cheap and reasonably well distributed. This is FNV-1a
+  // applied to whole words, finished with the murmur3 finalizer to mix the high bits down.
+  const uint64_t* words = static_cast<const uint64_t*>(page_src);
+  uint64_t hash = 0xcbf29ce484222325ul;
+  for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+    hash = (hash ^ words[i]) * 0x100000001b3ul;
+  }
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdul;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53ul;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+uint64_t VmCompression::StoredHash(const void* src, size_t len) const {
+  DEBUG_ASSERT(IsDedupEnabled());
+  DEBUG_ASSERT(len >= trailer_size_);
+  return *reinterpret_cast<const uint64_t*>(reinterpret_cast<uintptr_t>(src) + len -
+                                            trailer_size_);
+}
+
+bool VmCompression::IsDedupCandidate(const void* page_src) {
+  if (!IsDedupEnabled()) {
+    return false;
+  }
+  const uint64_t hash = HashPage(page_src);
+  Guard<CriticalMutex> guard{&dedup_lock_};
+  const DedupEntry& entry = dedup_table_[hash & (dedup_buckets_ - 1)];
+  return entry.ref && entry.hash == hash;
+}
+
+ktl::optional<VmCompression::CompressedRef> VmCompression::Dedup(const void* page_src,
+                                                                 uint32_t metadata) {
+  if (!IsDedupEnabled()) {
+    return ktl::nullopt;
+  }
+  const uint64_t hash = HashPage(page_src);
+  ktl::optional<CompressedRef> ref = TryDedup(page_src, hash, metadata);
+  if (ref) {
+    compression_attempts_.fetch_add(1);
+    compression_success_.fetch_add(1);
+  }
+  return ref;
+}
+
+ktl::optional<VmCompression::CompressedRef> VmCompression::TryDedup(const void* page_src,
+                                                                    uint64_t hash,
+                                                                    uint32_t metadata) {
+  // Entries are removed before their reference is freed, so while the index lock is held any entry
+  // found is still valid and can be shared. The shared reference keeps the stored data alive by
+  // itself, so the expensive verification below does not need the index lock, and nothing needs to
+  // be rechecked afterwards even if the entry is replaced or forgotten in the meantime.
+  ktl::optional<CompressedRef> ref;
+  {
+    Guard<CriticalMutex> guard{&dedup_lock_};
+    const DedupEntry& entry = dedup_table_[hash & (dedup_buckets_ - 1)];
+    if (!entry.ref || entry.hash != hash) {
+      return ktl::nullopt;
+    }
+    ref = storage_->Share(*entry.ref);
+  }
+  if (!ref) {
+    return ktl::nullopt;
+  }
+  ASSERT(!IsTempReference(*ref));
+  VM_KTRACE_DURATION(2, "dedup_page");
+  // Decompress the stored data to verify the contents are truly identical.
+  bool identical;
+  {
+    auto [src, stored_metadata, len] = storage_->CompressedData(*ref);
+    Guard<CriticalMutex> guard{&dedup_scratch_lock_};
+    void* scratch = paddr_to_physmap(dedup_scratch_page_->paddr());
+    strategy_->Decompress(src, len - trailer_size_, scratch);
+    storage_->ReleaseCompressedData(*ref);
+    identical = memcmp(scratch, page_src, PAGE_SIZE) == 0;
+  }
+  if (!identical) {
+    // The shared reference was never placed in the index, so it can be returned to the storage
+    // directly without needing to |ForgetDedup| it.
+    storage_->Free(*ref);
+    dedup_collisions_.fetch_add(1);
+    compression_dedup_collisions.Add(1);
+    return ktl::nullopt;
+  }
+  if (metadata != 0) {
+    storage_->SetMetadata(*ref, metadata);
+  }
+  dedup_hits_.fetch_add(1);
+  compression_dedup_hits.Add(1);
+  return ref;
+}
+
+void VmCompression::InsertDedup(uint64_t hash, CompressedRef ref) {
+  Guard<CriticalMutex> guard{&dedup_lock_};
+  // Newer items replace any older item in the same bucket, which just means the older item can no
+  // longer be a deduplication target.
+  DedupEntry& entry = dedup_table_[hash & (dedup_buckets_ - 1)];
+  entry.hash = hash;
+  entry.ref = ref;
+  compression_dedup_inserts.Add(1);
+}
+
+void VmCompression::ForgetDedup(CompressedRef ref) {
+  if (!IsDedupEnabled()) {
+    return;
+  }
+  auto [src, metadata, len] = storage_->CompressedData(ref);
+  const uint64_t hash = StoredHash(src, len);
+  storage_->ReleaseCompressedData(ref);
+  Guard<CriticalMutex> guard{&dedup_lock_};
+  DedupEntry& entry = dedup_table_[hash & (dedup_buckets_ - 1)];
+  if (entry.ref && entry.ref->value() == ref.value()) {
+    entry.ref.reset();
+  }
+}
+
 // Metadata manipulations need to disable analysis. The caller is required to hold the lock for the
 // VMO who created the reference, but we can't refer to that lock here.
 uint32_t VmCompression::GetMetadata(CompressedRef ref) TA_NO_THREAD_SAFETY_ANALYSIS {
   if (unlikely(IsTempReference(ref))) {
-    return instance_.temp_reference_metadata_;
+    return InstanceForTempReference(ref).temp_reference_metadata_;
   }
   return storage_->GetMetadata(ref);
 }
@@ -193,7 +538,7 @@ uint32_t VmCompression::GetMetadata(CompressedRef ref) TA_NO_THREAD_SAFETY_ANALY
 // VMO who created the reference, but we can't refer to that lock here.
 void VmCompression::SetMetadata(CompressedRef ref, uint32_t metadata) TA_NO_THREAD_SAFETY_ANALYSIS {
   if (unlikely(IsTempReference(ref))) {
-    instance_.temp_reference_metadata_ = metadata;
+    InstanceForTempReference(ref).temp_reference_metadata_ = metadata;
   } else {
     storage_->SetMetadata(ref, metadata);
   }
@@ -207,7 +552,8 @@ VmCompression::Stats VmCompression::GetStats() const {
                            .total_page_compression_attempts = compression_attempts_,
                            .failed_page_compression_attempts = compression_fail_,
                            .total_page_decompressions = decompressions_,
-                           .compressed_page_evictions = decompression_skipped_};
+                           .compressed_page_evictions = decompression_skipped_,
+                           .compaction = storage_->GetCompactionStats()};
   for (size_t i = 0; i < kNumLogBuckets; i++) {
     stats.pages_decompressed_within_log_seconds[i] = decompressions_within_log_seconds_[i];
   }
@@ -227,7 +573,25 @@ void VmCompression::Dump() const {
       decompressions_within_log_seconds_[2].load(), decompressions_within_log_seconds_[3].load(),
       decompressions_within_log_seconds_[4].load(), decompressions_within_log_seconds_[5].load(),
       decompressions_within_log_seconds_[6].load(), decompressions_within_log_seconds_[7].load());
+  constexpr const char* kEffortNames[VmCompressor::kNumEfforts] = {"fast", "dense"};
+  for (size_t i = 0; i < VmCompressor::kNumEfforts; i++) {
+    const uint64_t stored_pages = effort_stats_[i].stored_pages.load();
+    const uint64_t stored_bytes = effort_stats_[i].stored_bytes.load();
+    // Report the ratio as a percentage of the original page size, lower is better.
+    const uint64_t percent = stored_pages > 0 ? stored_bytes * 100 / (stored_pages * PAGE_SIZE) : 0;
+    printf("[zram]: %s compression attempts: %zu stored: %zu bytes: %zu (%" PRIu64
+           "%%) time: %" PRIi64 " ns\n",
+           kEffortNames[i], effort_stats_[i].attempts.load(), stored_pages, stored_bytes, percent,
+           effort_stats_[i].time.load());
+  }
   strategy_->Dump();
+  if (dense_strategy_) {
+    dense_strategy_->Dump();
+  }
+  if (IsDedupEnabled()) {
+    printf("[zram]: Dedup buckets: %zu hits: %zu collisions: %zu\n", dedup_buckets_,
+           dedup_hits_.load(), dedup_collisions_.load());
+  }
   storage_->Dump();
 }
 
@@ -271,30 +635,55 @@ fbl::RefPtr<VmCompression> VmCompression::CreateDefault() {
   const uint32_t threshold =
       static_cast<uint32_t>(PAGE_SIZE) * gBootOptions->compression_threshold / 100u;
 
-  fbl::RefPtr<VmCompressionStrategy> strategy;
-  switch (gBootOptions->compression_strategy) {
-    case CompressionStrategy::kLz4:
-      strategy = VmLz4Compressor::Create();
-      if (!strategy) {
-        printf("[ZRAM]: Failed to create lz4 compressor\n");
-        return nullptr;
+  // Default to one compressor instance per CPU so that reclaimers do not need to contend.
+  size_t num_compressors = gBootOptions->compression_compressors;
+  if (num_compressors == 0) {
+    num_compressors = percpu::processor_count();
+  }
+  num_compressors = ktl::clamp<size_t>(num_compressors, 1, kMaxCompressors);
+
+  fbl::RefPtr<VmCompressionStrategy> strategy =
+      CreateStrategy(gBootOptions->compression_strategy, num_compressors);
+  if (!strategy) {
+    printf("[ZRAM]: Failed to create %s compressor\n",
+           StrategyName(gBootOptions->compression_strategy));
+    return nullptr;
+  }
+  printf("[ZRAM]: Using compression strategy: %s\n",
+         StrategyName(gBootOptions->compression_strategy));
+
+  fbl::RefPtr<VmCompressionStrategy> dense_strategy;
+  if (gBootOptions->compression_dense_strategy != CompressionStrategy::kNone) {
+    if (!IsCompatibleDenseStrategy(gBootOptions->compression_strategy,
+                                   gBootOptions->compression_dense_strategy)) {
+      printf(
+          "ERROR: kernel.compression.dense-strategy is not compatible with "
+          "kernel.compression.strategy, ignoring\n");
+    } else {
+      dense_strategy = CreateStrategy(gBootOptions->compression_dense_strategy, num_compressors);
+      if (!dense_strategy) {
+        printf("[ZRAM]: Failed to create dense compressor, continuing without\n");
+      } else {
+        printf("[ZRAM]: Using dense compression strategy: %s\n",
+               StrategyName(gBootOptions->compression_dense_strategy));
       }
-      printf("[ZRAM]: Using compression strategy: lz4\n");
-      break;
-    case CompressionStrategy::kNone:
-      // Original check should have handled this.
-      panic("Unreachable");
-      break;
+    }
   }
-  ASSERT(strategy);
 
   fbl::RefPtr<VmCompression> compression = fbl::MakeRefCountedChecked<VmCompression>(
-      &ac, ktl::move(storage), ktl::move(strategy), threshold);
+      &ac, ktl::move(storage), ktl::move(strategy), threshold, num_compressors,
+      ktl::move(dense_strategy), gBootOptions->compression_dedup_buckets,
+      gBootOptions->compression_dense_retry);
   if (!ac.check()) {
     printf("[ZRAM]: Failed to create compressor\n");
     return nullptr;
   }
   ASSERT(compression);
+  printf("[ZRAM]: Using %zu compressor instances\n", num_compressors);
+  if (compression->IsDedupEnabled()) {
+    printf("[ZRAM]: Using content deduplication with %u buckets\n",
+           gBootOptions->compression_dedup_buckets);
+  }
   return compression;
 }
 
@@ -307,31 +696,33 @@ ktl::optional<VmCompression::PageAndMetadata> VmCompression::MoveTempReference(C
   // The owner of the temp ref is the owner as page. So if we are seeing the temporary reference
   // then we know page cannot progress (i.e. FinalizeState can be called), so we can safely
   // perform the copy.
-  ASSERT(instance_.using_temp_reference_);
-  ASSERT(instance_.page_);
-  ASSERT(instance_.spare_page_);
-  void* addr = paddr_to_physmap(instance_.spare_page_->paddr());
+  VmCompressor& instance = InstanceForTempReference(ref);
+  ASSERT(instance.using_temp_reference_);
+  ASSERT(instance.page_);
+  ASSERT(instance.spare_page_);
+  void* addr = paddr_to_physmap(instance.spare_page_->paddr());
   ASSERT(addr);
   uint32_t metadata;
   Decompress(ref, addr, &metadata);
-  vm_page_t* ret = instance_.spare_page_;
-  instance_.spare_page_ = nullptr;
+  vm_page_t* ret = instance.spare_page_;
+  instance.spare_page_ = nullptr;
   return VmCompression::PageAndMetadata{.page = ret, .metadata = metadata};
 }
 
 void VmCompression::FreeTempReference(CompressedRef ref) TA_NO_THREAD_SAFETY_ANALYSIS {
   DEBUG_ASSERT(IsTempReference(ref));
-  instance_.ReturnTempReference(ref);
+  InstanceForTempReference(ref).ReturnTempReference(ref);
 }
 
 void VmCompression::DecompressTempReference(CompressedRef ref, void* page_dest,
                                             uint32_t* metadata_dest) TA_NO_THREAD_SAFETY_ANALYSIS {
   DEBUG_ASSERT(IsTempReference(ref));
-  ASSERT(instance_.using_temp_reference_);
-  ASSERT(instance_.page_);
-  void* addr = paddr_to_physmap(instance_.page_->paddr());
+  VmCompressor& instance = InstanceForTempReference(ref);
+  ASSERT(instance.using_temp_reference_);
+  ASSERT(instance.page_);
+  void* addr = paddr_to_physmap(instance.page_->paddr());
   ASSERT(addr);
   memcpy(page_dest, addr, PAGE_SIZE);
-  *metadata_dest = instance_.temp_reference_metadata_;
+  *metadata_dest = instance.temp_reference_metadata_;
   FreeTempReference(ref);
 }
@@ -14,9 +14,12 @@ VmCompressor::~VmCompressor() {
   // Should not have an in progress compression.
   ASSERT(IsIdle());
   ASSERT(!IsTempReferenceInUse());
+  if (buffer_page_) {
+    pmm_free_page(buffer_page_);
+  }
 }
 
-zx_status_t VmCompressor::Arm() {
+zx_status_t VmCompressor::Arm(Effort effort) {
   ASSERT(IsIdle());
   if (!spare_page_) {
     // Allocate a new one. Explicitly do not use delayed allocations.
@@ -25,6 +28,7 @@ zx_status_t VmCompressor::Arm() {
       return status;
     }
   }
+  effort_ = effort;
   state_ = State::Ready;
   return ZX_OK;
 }
@@ -45,7 +49,7 @@ void VmCompressor::Compress() {
   void* addr = paddr_to_physmap(page_->paddr());
   ASSERT(addr);
 
-  compression_result_ = compressor_.Compress(addr);
+  compression_result_ = compressor_.Compress(addr, &buffer_page_, effort_);
   state_ = State::Compressed;
 }
 
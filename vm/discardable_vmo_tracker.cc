@@ -4,10 +4,19 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <lib/counters.h>
+
+#include <ktl/algorithm.h>
+#include <ktl/array.h>
 #include <vm/discardable_vmo_tracker.h>
 #include <vm/vm_cow_pages.h>
 #include <vm/vm_object.h>
 
+#include <ktl/enforce.h>
+
+KCOUNTER(discardable_batch_reclaims, "vm.discardable.batch_reclaim.batches")
+KCOUNTER(discardable_batch_vmos_discarded, "vm.discardable.batch_reclaim.vmos_discarded")
+
 DiscardableVmoTracker::DiscardableList DiscardableVmoTracker::discardable_reclaim_candidates_ = {};
 DiscardableVmoTracker::DiscardableList DiscardableVmoTracker::discardable_non_reclaim_candidates_ =
     {};
@@ -270,3 +279,65 @@ DiscardableVmoTracker::DiscardablePageCounts DiscardableVmoTracker::DebugDiscard
 
   return total_counts;
 }
+
+// static
+uint64_t DiscardableVmoTracker::ReclaimIdleVmos(uint64_t target_pages,
+                                               zx_duration_mono_t min_idle) {
+  const zx_instant_mono_t unlocked_before = zx_time_sub_duration(current_mono_time(), min_idle);
+  uint64_t pages_freed = 0;
+
+  Guard<CriticalMutex> guard{DiscardableVmosLock::Get()};
+  Cursor cursor(DiscardableVmosLock::Get(), discardable_reclaim_candidates_,
+                discardable_vmos_cursors_);
+  AssertHeld(cursor.lock_ref());
+
+  bool reached_recent = false;
+  while (pages_freed < target_pages && !reached_recent) {
+    // Gather a batch of candidates in one go. The same rules as in DebugDiscardablePageCounts()
+    // apply: the RefPtr upgrade is only safe while the |DiscardableVmosLock| is held, and the
+    // VmCowPages lock may only be acquired once it has been dropped.
+    struct Candidate {
+      fbl::RefPtr<VmCowPages> cow;
+      uint64_t pages;
+    };
+    ktl::array<Candidate, kReclaimBatchSize> batch;
+    size_t count = 0;
+    DiscardableVmoTracker* discardable;
+    while (count < batch.size() && (discardable = cursor.Next())) {
+      fbl::RefPtr<VmCowPages> cow_ref = fbl::MakeRefPtrUpgradeFromRaw(discardable->cow_, guard);
+      if (cow_ref) {
+        batch[count++].cow = ktl::move(cow_ref);
+      }
+    }
+    if (count == 0) {
+      break;
+    }
+
+    guard.CallUnlocked([&]() {
+      // The reclaim list is kept in unlock order, so the first candidate that has not been idle
+      // long enough means no candidate after this batch will have been either.
+      for (size_t i = 0; i < count; i++) {
+        batch[i].pages = batch[i].cow->IdleDiscardablePages(unlocked_before);
+        reached_recent |= batch[i].pages == 0;
+      }
+      // Discard the largest VMOs first, stopping as soon as the target is met.
+      ktl::stable_sort(batch.begin(), batch.begin() + count,
+                       [](const Candidate& a, const Candidate& b) { return a.pages > b.pages; });
+      for (size_t i = 0; i < count && pages_freed < target_pages && batch[i].pages > 0; i++) {
+        zx::result<uint64_t> result = batch[i].cow->DiscardIfIdle(unlocked_before);
+        if (result.is_ok()) {
+          pages_freed += *result;
+          discardable_batch_vmos_discarded.Add(1);
+        }
+      }
+      // Drop the references before the |DiscardableVmosLock| is re-acquired, since that may run
+      // the VmCowPages destructor.
+      for (size_t i = 0; i < count; i++) {
+        batch[i].cow.reset();
+      }
+    });
+    discardable_batch_reclaims.Add(1);
+  }
+
+  return pages_freed;
+}
@@ -32,6 +32,15 @@ KCOUNTER(compression_evicted, "vm.reclamation.pages_evicted_compressed.total")
 KCOUNTER(compression_evicted_oom, "vm.reclamation.pages_evicted_compressed.oom")
 KCOUNTER(discardable_pages_evicted, "vm.reclamation.pages_evicted_discardable.total")
 KCOUNTER(discardable_pages_evicted_oom, "vm.reclamation.pages_evicted_discardable.oom")
+KCOUNTER(proactive_pages_evicted, "vm.reclamation.pages_evicted_proactive")
+KCOUNTER(proactive_budget_exhausted, "vm.reclamation.proactive_budget_exhausted")
+// Non-loaned pages freed by each EvictUntilTargetsMet call.
+KCOUNTER_HISTOGRAM(eviction_batch_pages, "vm.reclamation.batch_pages", 0)
+// Evictions split between eviction workers, the batches the workers (not counting the thread that
+// split the eviction) took on, and the non-loaned pages they freed doing so.
+KCOUNTER(parallel_evictions, "vm.reclamation.parallel.evictions")
+KCOUNTER(worker_batches, "vm.reclamation.parallel.worker_batches")
+KCOUNTER(worker_pages_evicted, "vm.reclamation.parallel.worker_pages_evicted")
 
 inline void CheckedIncrement(uint64_t* a, uint64_t b) {
   uint64_t result;
@@ -63,7 +72,12 @@ ktl::optional<ktl::pair<Evictor::EvictedPageCounts, const vm_page_t*>> ReclaimFr
     if (compression) {
       maybe_instance.emplace(compression->AcquireCompressor());
       compression_instance = &maybe_instance->get();
-      zx_status_t status = compression_instance->Arm();
+      // When evicting all the way to the newest pages the system is close to running out of
+      // memory, and it is worth spending extra time to get a better compression ratio.
+      const VmCompressor::Effort effort = eviction_level == Evictor::EvictionLevel::IncludeNewest
+                                              ? VmCompressor::Effort::Dense
+                                              : VmCompressor::Effort::Fast;
+      zx_status_t status = compression_instance->Arm(effort);
       if (status != ZX_OK) {
         return ktl::nullopt;
       }
@@ -134,6 +148,23 @@ Evictor::Evictor(ReclaimFunction reclaim_function, FreePagesFunction free_pages_
 
 Evictor::~Evictor() { DisableEviction(); }
 
+void Evictor::SetProactiveWatermarks(uint64_t low_mem, uint64_t high_mem,
+                                     uint64_t max_bytes_per_second) {
+  Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+  proactive_watermarks_ = {
+      .low_pages = low_mem / PAGE_SIZE,
+      .high_pages = ktl::max(low_mem, high_mem) / PAGE_SIZE,
+      // A zero rate means the rate is unlimited.
+      .pages_per_period =
+          max_bytes_per_second == 0
+              ? UINT64_MAX
+              : ktl::max<uint64_t>(max_bytes_per_second / PAGE_SIZE * kProactivePeriod / ZX_SEC(1),
+                                   1),
+  };
+  // Wake the eviction thread so that it starts, or stops, polling the watermarks.
+  eviction_signal_.Signal();
+}
+
 bool Evictor::IsEvictionEnabled() const {
   Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
   return eviction_enabled_;
@@ -144,7 +175,7 @@ bool Evictor::IsCompressionEnabled() const {
   return use_compression_;
 }
 
-void Evictor::EnableEviction(bool use_compression) {
+void Evictor::EnableEviction(bool use_compression, uint32_t num_workers) {
   {
     Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
     // It's an error to call this whilst the eviction thread is still exiting.
@@ -157,6 +188,25 @@ void Evictor::EnableEviction(bool use_compression) {
     }
   }
 
+  // Start the workers before the eviction thread, and before they can be handed any work, so that
+  // |num_workers_| only ever counts running workers.
+  auto worker_thread = [](void* arg) -> int {
+    Evictor* evictor = reinterpret_cast<Evictor*>(arg);
+    return evictor->EvictionWorkerLoop();
+  };
+  num_workers = ktl::min(num_workers, kMaxEvictionWorkers);
+  for (uint32_t i = 0; i < num_workers; i++) {
+    char name[ZX_MAX_NAME_LEN];
+    snprintf(name, sizeof(name), "eviction-worker-%u", i);
+    worker_threads_[i] = Thread::Create(name, worker_thread, this, DEFAULT_PRIORITY);
+    DEBUG_ASSERT(worker_threads_[i]);
+    worker_threads_[i]->Resume();
+  }
+  {
+    Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+    num_workers_ = num_workers;
+  }
+
   // Set up the eviction thread to process asynchronous eviction requests.
   auto eviction_thread = [](void* arg) -> int {
     Evictor* evictor = reinterpret_cast<Evictor*>(arg);
@@ -188,6 +238,28 @@ void Evictor::DisableEviction() {
   int res = 0;
   eviction_thread->Join(&res, ZX_TIME_INFINITE);
   DEBUG_ASSERT(res == 0);
+
+  // Synchronous evictions may still be using the workers, so wait for any to finish, and keep new
+  // ones from starting until the workers are gone.
+  no_ongoing_eviction_.Wait(Deadline::infinite());
+  uint32_t num_workers;
+  {
+    Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+    num_workers = num_workers_;
+    num_workers_ = 0;
+  }
+  workers_exiting_ = true;
+  for (uint32_t i = 0; i < num_workers; i++) {
+    worker_start_.Post();
+  }
+  for (uint32_t i = 0; i < num_workers; i++) {
+    worker_threads_[i]->Join(&res, ZX_TIME_INFINITE);
+    DEBUG_ASSERT(res == 0);
+    worker_threads_[i] = nullptr;
+  }
+  workers_exiting_ = false;
+  no_ongoing_eviction_.Signal();
+
   {
     Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
     // Now update the state to indicate that eviction is disabled.
@@ -202,6 +274,11 @@ Evictor::EvictionTarget Evictor::DebugGetEvictionTarget() const {
   return eviction_target_;
 }
 
+uint32_t Evictor::DebugNumWorkers() const {
+  Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+  return num_workers_;
+}
+
 void Evictor::CombineEvictionTarget(EvictionTarget target) {
   Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
   eviction_target_.pending = eviction_target_.pending || target.pending;
@@ -342,6 +419,12 @@ Evictor::EvictedPageCounts Evictor::EvictUntilTargetsMet(uint64_t min_pages_to_e
     no_ongoing_eviction_.Signal();
   });
 
+  // Evicting the newest pages means memory is running out, and page tables of idle mappings are
+  // as good a source of free pages as any.
+  if (level == EvictionLevel::IncludeNewest && !test_reclaim_function_) {
+    scanner_request_page_table_reclaim();
+  }
+
   uint64_t total_non_loaned_pages_freed = 0;
 
   while (true) {
@@ -356,7 +439,17 @@ Evictor::EvictedPageCounts Evictor::EvictUntilTargetsMet(uint64_t min_pages_to_e
       break;
     }
 
-    EvictedPageCounts pages_freed = EvictPageQueues(pages_to_free, level);
+    EvictedPageCounts pages_freed = {};
+    // When asked to include the newest pages, every unlocked discardable VMO is fair game anyway,
+    // so discard them whole, largest first, rather than waiting for the page queues to age each
+    // VMO's first page to the reclaim end one at a time.
+    if (level == EvictionLevel::IncludeNewest && !test_reclaim_function_) {
+      pages_freed.discardable = DiscardableVmoTracker::ReclaimIdleVmos(pages_to_free, 0);
+      discardable_pages_evicted.Add(static_cast<int64_t>(pages_freed.discardable));
+    }
+    if (pages_freed.discardable < pages_to_free) {
+      pages_freed += EvictPageQueuesParallel(pages_to_free - pages_freed.discardable, level);
+    }
     const uint64_t non_loaned_evicted =
         pages_freed.pager_backed + pages_freed.compressed + pages_freed.discardable;
     total_evicted_counts += pages_freed;
@@ -368,6 +461,7 @@ Evictor::EvictedPageCounts Evictor::EvictUntilTargetsMet(uint64_t min_pages_to_e
     }
   }
 
+  eviction_batch_pages.Add(total_non_loaned_pages_freed);
   return total_evicted_counts;
 }
 
@@ -429,9 +523,88 @@ Evictor::EvictedPageCounts Evictor::EvictPageQueues(uint64_t target_pages,
   return counts;
 }
 
+Evictor::EvictedPageCounts Evictor::EvictPageQueuesParallel(uint64_t target_pages,
+                                                            EvictionLevel eviction_level) {
+  uint32_t num_workers;
+  {
+    Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+    num_workers = num_workers_;
+    worker_pass_counts_ = {};
+  }
+  if (num_workers == 0 || target_pages < kWorkerBatchPages * 2) {
+    return EvictPageQueues(target_pages, eviction_level);
+  }
+
+  parallel_evictions.Add(1);
+  worker_pass_target_ = target_pages;
+  worker_pass_level_ = eviction_level;
+  worker_pass_claimed_.store(0, ktl::memory_order_relaxed);
+  worker_pass_exhausted_.store(false, ktl::memory_order_relaxed);
+  worker_pass_running_.store(num_workers + 1, ktl::memory_order_relaxed);
+  // Posting publishes the pass to the workers.
+  for (uint32_t i = 0; i < num_workers; i++) {
+    worker_start_.Post();
+  }
+  RunWorkerPass(false);
+  worker_pass_done_.Wait();
+
+  Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+  return worker_pass_counts_;
+}
+
+void Evictor::RunWorkerPass(bool is_worker) {
+  EvictedPageCounts counts = {};
+  while (!worker_pass_exhausted_.load(ktl::memory_order_relaxed)) {
+    const uint64_t claimed =
+        worker_pass_claimed_.fetch_add(kWorkerBatchPages, ktl::memory_order_relaxed);
+    if (claimed >= worker_pass_target_) {
+      break;
+    }
+    const uint64_t batch = ktl::min(kWorkerBatchPages, worker_pass_target_ - claimed);
+    const EvictedPageCounts batch_counts = EvictPageQueues(batch, worker_pass_level_);
+    counts += batch_counts;
+    const uint64_t non_loaned_evicted =
+        batch_counts.pager_backed + batch_counts.compressed + batch_counts.discardable;
+    if (is_worker) {
+      worker_batches.Add(1);
+      worker_pages_evicted.Add(static_cast<int64_t>(non_loaned_evicted));
+    }
+    // EvictPageQueues only stops short of its target once there are no more candidates.
+    if (non_loaned_evicted < batch) {
+      worker_pass_exhausted_.store(true, ktl::memory_order_relaxed);
+    }
+  }
+
+  {
+    Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+    worker_pass_counts_ += counts;
+  }
+  if (worker_pass_running_.fetch_sub(1, ktl::memory_order_acq_rel) == 1) {
+    worker_pass_done_.Signal();
+  }
+}
+
+int Evictor::EvictionWorkerLoop() {
+  while (true) {
+    worker_start_.Wait(Deadline::infinite());
+    if (workers_exiting_) {
+      break;
+    }
+    RunWorkerPass(true);
+  }
+  return 0;
+}
+
 int Evictor::EvictionThreadLoop() {
+  ProactiveWatermarks marks;
+  bool proactive_reclaiming = false;
   while (!eviction_thread_exiting_) {
-    eviction_signal_.Wait();
+    // Without proactive reclamation there is nothing to do until someone makes a request.
+    if (marks.low_pages == 0) {
+      eviction_signal_.Wait();
+    } else {
+      eviction_signal_.Wait(Deadline::after_mono(kProactivePeriod));
+    }
 
     if (eviction_thread_exiting_) {
       break;
@@ -440,10 +613,56 @@ int Evictor::EvictionThreadLoop() {
     // Process an eviction target if there is one. This is a no-op and no pages are evicted if no
     // target is pending.
     EvictFromPreloadedTarget();
+
+    {
+      Guard<MonitoredSpinLock, IrqSave> guard{&lock_, SOURCE_TAG};
+      marks = proactive_watermarks_;
+    }
+    if (marks.low_pages != 0) {
+      EvictProactively(marks, &proactive_reclaiming);
+    } else {
+      proactive_reclaiming = false;
+    }
   }
   return 0;
 }
 
+Evictor::EvictedPageCounts Evictor::EvictProactively(const ProactiveWatermarks& marks,
+                                                     bool* reclaiming) {
+  const uint64_t free_pages = CountFreePages();
+  if (free_pages >= marks.high_pages) {
+    *reclaiming = false;
+    return {};
+  }
+  if (!*reclaiming && free_pages >= marks.low_pages) {
+    return {};
+  }
+  *reclaiming = true;
+
+  // Once below half of the low watermark allocations are close to stalling, so allow twice the
+  // usual budget. Stick to the oldest pages regardless; evicting newer pages is left to the memory
+  // watchdog as the system nears running out of memory.
+  uint64_t budget = marks.pages_per_period;
+  if (free_pages < marks.low_pages / 2 && budget <= UINT64_MAX / 2) {
+    budget *= 2;
+  }
+  const uint64_t deficit = marks.high_pages - free_pages;
+  if (deficit > budget) {
+    proactive_budget_exhausted.Add(1);
+  }
+
+  EvictedPageCounts counts =
+      EvictUntilTargetsMet(ktl::min(deficit, budget), 0, EvictionLevel::OnlyOldest);
+  const uint64_t evicted = counts.pager_backed + counts.compressed + counts.discardable;
+  proactive_pages_evicted.Add(static_cast<int64_t>(evicted));
+  // If nothing could be evicted, stop until free memory next drops below the low watermark rather
+  // than retrying every period on the way back up to the high one.
+  if (evicted == 0) {
+    *reclaiming = false;
+  }
+  return counts;
+}
+
 uint64_t Evictor::CountFreePages() const {
   if (unlikely(test_free_pages_function_)) {
     return test_free_pages_function_();
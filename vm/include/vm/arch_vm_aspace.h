@@ -165,12 +165,16 @@ class ArchVmAspaceInterface {
 
   // For HarvestAccessed Terminal and non-terminal get processed based on the following two
   // controls.
-  enum class NonTerminalAction : bool {
+  enum class NonTerminalAction : uint8_t {
     // If a non-terminal entry has no accessed information, unmap and free it. If it has accessed
     // information, just remove the flag.
     FreeUnaccessed,
     // Retain both the non-terminal mappings and any accessed information.
     Retain,
+    // Retain the non-terminal mappings, but remove their accessed flag. Later harvests then skip
+    // any page table that has not been walked through since, so their cost follows the part of the
+    // aspace that is actually in use rather than everything that has ever been mapped.
+    Harvest,
   };
   enum class TerminalAction : bool {
     // If the page is accessed update its age in the page queues, and remove the accessed flag.
@@ -189,6 +193,14 @@ class ArchVmAspaceInterface {
   // Marks any pages in the given virtual address range as being accessed.
   virtual zx_status_t MarkAccessed(vaddr_t vaddr, size_t count) = 0;
 
+  // Calls |dirty| for each range of mapped pages in the given range that has been written to since
+  // it was mapped or last harvested, and resets that record. A range may be reported again by a
+  // later harvest but a write is never missed. Returns ZX_ERR_NOT_SUPPORTED if the page tables do
+  // not record writes.
+  using DirtyRangeFunction = fit::inline_function<void(vaddr_t vaddr, size_t len)>;
+  virtual zx_status_t HarvestDirty(vaddr_t vaddr, size_t count,
+                                   const DirtyRangeFunction& dirty) = 0;
+
   // Returns whether or not this aspace might have additional accessed information since the last
   // time this method was called with clear=true. If this returns |false| then, modulo races,
   // HarvestAccessed is defined to not find any set bits and not call PageQueues::MarkAccessed.
@@ -10,10 +10,14 @@
 #include <debug.h>
 #include <zircon/types.h>
 
+#include <fbl/array.h>
 #include <fbl/ref_counted.h>
 #include <kernel/mutex.h>
+#include <ktl/atomic.h>
 #include <ktl/optional.h>
+#include <ktl/span.h>
 #include <ktl/tuple.h>
+#include <ktl/unique_ptr.h>
 #include <ktl/variant.h>
 #include <vm/compressor.h>
 #include <vm/page.h>
@@ -55,13 +59,28 @@ class VmCompressedStorage : public fbl::RefCounted<VmCompressedStorage> {
   // previous result of |CompressedData| must not be used.
   virtual void Free(CompressedRef ref) = 0;
 
+  // Free all of the given |refs|, with the same semantics as calling |Free| on each of them. The
+  // default implementation does exactly that, but storage implementations may override this to
+  // amortize locking and returning pages to the pmm.
+  virtual void FreeBatch(ktl::span<const CompressedRef> refs) {
+    for (CompressedRef ref : refs) {
+      Free(ref);
+    }
+  }
+
+  // Returns a new reference to the same data as |ref|, allowing multiple users to share a single
+  // stored copy of identical data. The new reference has its own metadata, initially zero, and must
+  // be separately passed to |Free|. The data remains valid until every reference to it is freed.
+  // Returns nullopt if the data cannot be shared, which is the default for storage that does not
+  // support sharing.
+  virtual ktl::optional<CompressedRef> Share(CompressedRef ref) { return ktl::nullopt; }
+
   // Retrieve a reference to original data that was stored. The metadata and length of the data are
   // also returned, alleviating the need to retain them separately.
   //
-  // The return address remains valid as long as this specific reference is not freed, and otherwise
-  // any other calls to |Store| or |Free| do not invalidate.
-  // TODO(https://fxbug.dev/42138396): Restrict this if de-fragmentation of the compressed storage
-  // becomes necessary.
+  // The return address remains valid until |ReleaseCompressedData| is called for |ref|, and every
+  // successful call must be paired with such a release. Whilst any data is held, calls to |Store|,
+  // |Free| and |Compact| do not invalidate it.
   //
   // No guarantee on alignment of the data is provided, and callers must tolerate arbitrary byte
   // alignment.
@@ -69,6 +88,16 @@ class VmCompressedStorage : public fbl::RefCounted<VmCompressedStorage> {
   // decompressors.
   virtual ktl::tuple<const void*, uint32_t, size_t> CompressedData(CompressedRef ref) const = 0;
 
+  // Indicates that the address returned by a prior |CompressedData| call for |ref| is no longer
+  // being used. The default implementation, for storage that never moves data, does nothing.
+  virtual void ReleaseCompressedData(CompressedRef ref) const {}
+
+  // Attempts to reduce fragmentation by moving stored data out of sparsely used storage pages,
+  // examining at most |max_pages| source pages. Moving data does not change any references.
+  // Returns the number of pages given back to the pmm. The default implementation, for storage that
+  // cannot move data, does nothing.
+  virtual size_t Compact(size_t max_pages) { return 0; }
+
   // Retrieve the metadata for the original page referred to by ref.
   virtual uint32_t GetMetadata(CompressedRef ref) = 0;
 
@@ -84,6 +113,16 @@ class VmCompressedStorage : public fbl::RefCounted<VmCompressedStorage> {
     uint64_t compressed_storage_used_bytes = 0;
   };
   virtual MemoryUsage GetMemoryUsage() const = 0;
+
+  struct CompactionStats {
+    // Number of |Compact| calls that found the storage fragmented enough to move data.
+    uint64_t runs = 0;
+    // Number of stored items that have been moved to a different storage page.
+    uint64_t items_moved = 0;
+    // Number of storage pages emptied by compaction and given back to the pmm.
+    uint64_t pages_freed = 0;
+  };
+  virtual CompactionStats GetCompactionStats() const { return {}; }
 };
 
 // Defines the interface for different compression algorithms.
@@ -130,16 +169,36 @@ class VmCompressionStrategy : public fbl::RefCounted<VmCompressionStrategy> {
 // that there be a single global instance.
 //
 // This also manages the `VmCompressor` instances that provide the state machine for a VMO to do
-// compression. Currently only a single instance is supported limiting to one simultaneous
-// compression.
+// compression. A fixed pool of instances is created up front, allowing that many simultaneous
+// compressions, with each instance having its own temporary reference value.
 class VmCompression final : public fbl::RefCounted<VmCompression> {
  public:
+  // The largest number of VmCompressor instances that can be requested. This bounds the range of
+  // values reserved for temporary references.
+  static constexpr size_t kMaxCompressors = SMP_MAX_CPUS;
+
   // Constructs a compression manager using the given storage and compression strategies. The
   // |compression_threshold| is the number of bytes above which a compression is considered to have
-  // failed and should not be considered worth storing.
+  // failed and should not be considered worth storing. |num_compressors| is the number of
+  // VmCompressor instances that can be acquired simultaneously, and must be between 1 and
+  // kMaxCompressors.
+  //
+  // The optional |dense_strategy| is used for compressions requested with Effort::Dense, and
+  // |strategy| is used for everything else. All data is decompressed with |strategy|, so the output
+  // of |dense_strategy| must be decompressible by |strategy|.
+  //
+  // |dedup_buckets| is the size of the content deduplication index, see |IsDedupEnabled|, and is
+  // rounded up to a power of two. A value of 0 disables deduplication.
+  //
+  // If |dense_retry| is true, and there is a |dense_strategy|, then a page that fails to compress
+  // with Effort::Fast is given a second attempt with the dense strategy before being reported as
+  // having failed.
   // TODO(https://fxbug.dev/42138396): Limit total amount of pages stored.
   VmCompression(fbl::RefPtr<VmCompressedStorage> storage,
-                fbl::RefPtr<VmCompressionStrategy> strategy, size_t compression_threshold);
+                fbl::RefPtr<VmCompressionStrategy> strategy, size_t compression_threshold,
+                size_t num_compressors = 1,
+                fbl::RefPtr<VmCompressionStrategy> dense_strategy = nullptr,
+                size_t dedup_buckets = 0, bool dense_retry = false);
   ~VmCompression();
 
   // Construct a VmCompression instance using default options for the storage and compression
@@ -155,15 +214,31 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
   //  FailTag - Input could not be compressed or stored.
   // The |now| parameter is the timestamp to be stored with the compressed data, and is used with
   // the corresponding parameter to |Decompress| to determine how long a page was stored for.
+  //
+  // The |effort| selects between the regular and the dense compression strategy. If no dense
+  // strategy was provided then both efforts use the regular strategy.
+  //
+  // The |buffer_page| is owned by the caller and is used as the destination for compression. If it
+  // points to a nullptr a page will be allocated. On return it will hold the page to use for the
+  // next call, which might be a nullptr. Keeping a buffer page per caller avoids going to and from
+  // the pmm on every compression attempt, and allows for compressions to run in parallel.
   // TODO(https://fxbug.dev/42138396): Should different failures be exposed here?
   using CompressedRef = VmPageOrMarker::ReferenceValue;
   using FailTag = VmCompressor::FailTag;
   using ZeroTag = VmCompressor::ZeroTag;
   using CompressResult = VmCompressor::CompressResult;
-  CompressResult Compress(const void* page_src, zx_instant_mono_ticks_t now);
+  using Effort = VmCompressor::Effort;
+  CompressResult Compress(const void* page_src, vm_page_t** buffer_page, Effort effort,
+                          zx_instant_mono_ticks_t now);
 
   // Wrapper that passes current_mono_ticks() as |now|
-  CompressResult Compress(const void* page_src) { return Compress(page_src, current_mono_ticks()); }
+  CompressResult Compress(const void* page_src, vm_page_t** buffer_page,
+                          Effort effort = Effort::Fast) {
+    return Compress(page_src, buffer_page, effort, current_mono_ticks());
+  }
+
+  // Returns whether a dense strategy, distinct from the regular strategy, is available.
+  bool HasDenseStrategy() const { return dense_strategy_ != nullptr; }
 
   // Decompresses and frees the provided reference into |page_dest| and |metadata_dest|. This cannot
   // fail and always produces PAGE_SIZE worth of data. After calling this the reference is no longer
@@ -182,12 +257,56 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
     Decompress(ref, page_dest, metadata_dest, current_mono_ticks());
   }
 
+  // Batched version of |Decompress| that decompresses and frees each of |refs| into the matching
+  // entries of |page_dests| and |metadata_dests|, which must be the same length as |refs|. The
+  // backing storage of all the references is released to the storage with a single |FreeBatch|,
+  // avoiding acquiring the storage lock per page.
+  //
+  // Temporary references may be included, with the same requirements as for |Decompress|.
+  void DecompressBatch(ktl::span<const CompressedRef> refs, ktl::span<void* const> page_dests,
+                       ktl::span<uint32_t> metadata_dests, zx_instant_mono_ticks_t now);
+
+  // Wrapper that passes current_mono_ticks() as |now|
+  void DecompressBatch(ktl::span<const CompressedRef> refs, ktl::span<void* const> page_dests,
+                       ktl::span<uint32_t> metadata_dests) {
+    DecompressBatch(refs, page_dests, metadata_dests, current_mono_ticks());
+  }
+
   // Free the compressed reference without decompressing it.
   //
   // Note that the temporary reference may be passed into here, however the same locking
   // requirements as |MoveReference| must be observed.
   void Free(CompressedRef ref);
 
+  // Batched version of |Free|.
+  void FreeBatch(ktl::span<const CompressedRef> refs);
+
+  // Compacts the backing storage, moving at most |max_pages| worth of sparsely used storage pages
+  // into denser ones. See |VmCompressedStorage::Compact|. Returns the number of pages freed.
+  size_t Compact(size_t max_pages) { return storage_->Compact(max_pages); }
+
+  // Content based deduplication, or same-page merging, allows identical pages to share a single
+  // copy of their compressed data. Each stored item is indexed by a hash of its uncompressed
+  // contents, and any compression whose input matches an indexed item returns a new reference to
+  // the existing data instead of compressing and storing it again. References to shared data are
+  // otherwise indistinguishable from regular references, and have their own metadata.
+  //
+  // The index is a fixed size hash table, sized at construction, in which newer items replace older
+  // ones. Deduplication is disabled if the table has no buckets, and will never find a match if the
+  // storage does not support |VmCompressedStorage::Share|.
+  bool IsDedupEnabled() const { return dedup_buckets_ > 0; }
+
+  // Performs a racy check of whether the page of data at |page_src| might be a duplicate of an
+  // already stored item. The contents of |page_src| do not need to be stable, and this is intended
+  // to be used to cheaply filter candidates prior to calling |Dedup|.
+  bool IsDedupCandidate(const void* page_src);
+
+  // If the page of data at |page_src| is identical to an already stored item returns a new
+  // reference to the stored data, otherwise returns nullopt. The contents of |page_src| must not
+  // change during this call. The returned reference is owned by the caller and has a metadata
+  // value of |metadata|.
+  ktl::optional<CompressedRef> Dedup(const void* page_src, uint32_t metadata);
+
   // Must be called if a reference is being moved in or from a VmPageList. Will return a nullopt if
   // the reference is safe to move without being converted to a page. Otherwise returns a vm_page_t
   // along with associated metadata which is now owned by the caller and should be used to replace
@@ -208,10 +327,13 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
     return ktl::nullopt;
   }
 
-  // Returns whether or not the provided reference is a temporary reference.
+  // Returns whether or not the provided reference is a temporary reference from any of the
+  // compressor instances.
   //
   // See |VmCompressor| for a full explanation of temporary references.
-  bool IsTempReference(const CompressedRef& ref) { return ref.value() == kTempReferenceValue; }
+  bool IsTempReference(const CompressedRef& ref) {
+    return ref.value() > kTempReferenceValue - (kMaxCompressors << CompressedRef::kAlignBits);
+  }
 
   // Retrieve the metadata for the original page referred to by ref.
   //
@@ -223,36 +345,49 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
   // This may only be called if the VMO lock for the VMO that ref was placed into is held.
   void SetMetadata(CompressedRef ref, uint32_t metadata);
 
+ private:
+  struct CompressorSlot;
+
+ public:
   // An RAII wrapper around holding a locked reference to a VmCompressor.
   class CompressorGuard {
    public:
     ~CompressorGuard();
     CompressorGuard(CompressorGuard&& instance) noexcept
-        : instance_guard_(AdoptLock, &instance.instance_.compressor_.instance_lock_,
-                          instance.instance_guard_.take()),
-          instance_(instance.instance_) {}
+        : instance_guard_(AdoptLock, &instance.slot_->lock, instance.instance_guard_.take()),
+          slot_(instance.slot_),
+          instance_(instance.instance_) {
+      instance.slot_ = nullptr;
+    }
 
     // Return a reference to the VmCompressor. Reference must not outlive this object.
     VmCompressor& get() { return instance_; }
 
    private:
-    CompressorGuard(VmCompressor& instance, Guard<Mutex>* guard)
-        : instance_guard_(AdoptLock, &instance.compressor_.instance_lock_, guard->take()),
-          instance_(instance) {}
+    CompressorGuard(CompressorSlot& slot, Guard<Mutex>* guard)
+        : instance_guard_(AdoptLock, &slot.lock, guard->take()),
+          slot_(&slot),
+          instance_(*slot.instance) {}
     friend VmCompression;
     // Guard that keeps the instance owned by us, must never be released for the lifetime of this
     // object and the reference to instance_.
     Guard<Mutex> instance_guard_;
+    // The slot the instance was acquired from, or null if this guard has been moved from.
+    CompressorSlot* slot_;
     VmCompressor& instance_;
   };
 
   // Retrieve a reference to a VmCompressor, wrapped in the RAII CompressorGuard. Once the
   // compressor is finished with it can be destroyed, which will release it for re-use.
-  // This method may block until a compressor becomes available and callers should be prepared for
-  // extended wait times.
+  // An idle instance is preferred, starting with the one associated with the current CPU. If all
+  // instances are in use this method will block until one becomes available and callers should be
+  // prepared for extended wait times.
   // The returned CompressorGuard must not outlive this object.
   CompressorGuard AcquireCompressor();
 
+  // Returns the number of VmCompressor instances in the pool.
+  size_t NumCompressors() const { return compressors_.size(); }
+
   // Perform an information dump of the internal state to the debuglog.
   void Dump() const;
 
@@ -266,6 +401,7 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
     uint64_t total_page_decompressions = 0;
     uint64_t compressed_page_evictions = 0;
     uint64_t pages_decompressed_within_log_seconds[kNumLogBuckets] = {};
+    VmCompressedStorage::CompactionStats compaction;
   };
   Stats GetStats() const;
 
@@ -273,32 +409,79 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
   // References to the backing storage and compression strategies.
   const fbl::RefPtr<VmCompressedStorage> storage_;
   const fbl::RefPtr<VmCompressionStrategy> strategy_;
+  const fbl::RefPtr<VmCompressionStrategy> dense_strategy_;
+  // Whether a failed Effort::Fast compression is retried with the |dense_strategy_|.
+  const bool dense_retry_;
+  // Number of buckets in |dedup_table_|, which is either zero or a power of two.
+  const size_t dedup_buckets_;
+  // Every stored item has a trailer appended to the compressed data. The trailer always contains
+  // the timestamp of when the page was compressed and, if deduplication is enabled, is preceded by
+  // the hash of the uncompressed contents so the item can be removed from the index when freed.
+  const size_t trailer_size_;
   // Pages must compress to less than or equal to this threshold for compression to be considered a
   // success. The largest amount we might need to store is larger than this, as this threshold does
-  // not include the 8 bytes we add on as a timestamp for when a page was compressed.
+  // not include the |trailer_size_| bytes we add on.
   const size_t compression_threshold_;
 
-  // Currently only a single VmCompressor instance is supported, so only a single temporary
-  // reference is needed.
-  // It is the responsibility of each underlying storage to not return this.
+  // Each VmCompressor instance needs its own temporary reference. The instance at index i uses
+  // kTempReferenceValue - (i << kAlignBits), and so the top kMaxCompressors aligned values are
+  // reserved. It is the responsibility of each underlying storage to not return these.
   static constexpr uint64_t kTempReferenceValue = UINT32_MAX & ~BIT_MASK(CompressedRef::kAlignBits);
+  static_assert((kMaxCompressors << CompressedRef::kAlignBits) < kTempReferenceValue);
 
-  DECLARE_MUTEX(VmCompression) instance_lock_;
-  // The compressor instance has a more complicated locking structure than can be expressed with
-  // annotations here. The instance_lock_ is used to control vending this out in |GetCompressor| to
-  // ensure it is only owned by one thread at a time, however certain mutation of the compressor
-  // requires holding the VMO lock of the relevant page, and this allows for usage with just holding
-  // the VMO lock and not the instance_lock_. See VmCompressor for more details on what fields may
-  // be read/written with which locks held.
-  VmCompressor instance_ TA_GUARDED(instance_lock_);
-
-  // Lock for compression state. In practice this should never be contended, since presently only a
-  // single VmCompressor is supported.
-  DECLARE_MUTEX(VmCompression) compression_lock_;
-  // The buffer_page_ is used as the destination for compressing any input page. To avoid going to
-  // and from the pmm every compression attempt we attempt to re-use a single buffer page as much as
-  // possible.
-  vm_page_t* buffer_page_ TA_GUARDED(compression_lock_) = nullptr;
+  static constexpr uint32_t TempReferenceForIndex(size_t index) {
+    return static_cast<uint32_t>(kTempReferenceValue - (index << CompressedRef::kAlignBits));
+  }
+
+  // Returns the compressor instance that owns the temporary reference |ref|.
+  VmCompressor& InstanceForTempReference(CompressedRef ref);
+
+  // The compressor instances have a more complicated locking structure than can be expressed with
+  // annotations here. Each slot's lock is used to control vending its instance out in
+  // |AcquireCompressor| to ensure it is only owned by one thread at a time, however certain
+  // mutation of the compressor requires holding the VMO lock of the relevant page, and this allows
+  // for usage with just holding the VMO lock and not the slot lock. See VmCompressor for more
+  // details on what fields may be read/written with which locks held.
+  struct CompressorSlot {
+    DECLARE_MUTEX(CompressorSlot) lock;
+    // Number of threads that either hold, or are blocked waiting for, |lock|. This is only a hint
+    // used by |AcquireCompressor| to find an idle instance without blocking, the lock itself
+    // provides the actual exclusion.
+    ktl::atomic<uint32_t> users = 0;
+    ktl::unique_ptr<VmCompressor> instance;
+  };
+  fbl::Array<CompressorSlot> compressors_;
+
+  // Decompresses the non-temporary reference |ref| into |page_dest| and |metadata_dest|, updating
+  // statistics, but does not free it. Returns the timestamp the data was compressed at.
+  zx_instant_mono_ticks_t DecompressData(CompressedRef ref, void* page_dest,
+                                         uint32_t* metadata_dest, zx_instant_mono_ticks_t now);
+
+  // Internal helpers for the content deduplication index. The index lock is held over looking up an
+  // entry and sharing its data, and entries are removed by |ForgetDedup| before their reference is
+  // freed, ensuring that any reference found in the table is still valid.
+  struct DedupEntry {
+    uint64_t hash = 0;
+    ktl::optional<CompressedRef> ref;
+  };
+  static uint64_t HashPage(const void* page_src);
+  // Returns a new shared reference to the indexed data matching |hash|, if its contents are
+  // identical to |page_src|. The contents are verified without holding |dedup_lock_|.
+  ktl::optional<CompressedRef> TryDedup(const void* page_src, uint64_t hash, uint32_t metadata)
+      TA_EXCL(dedup_lock_);
+  void InsertDedup(uint64_t hash, CompressedRef ref);
+  // Removes |ref| from the index if present, must be called prior to freeing any non-temporary
+  // reference to the storage.
+  void ForgetDedup(CompressedRef ref);
+  // Returns the hash stored in the trailer of |len| bytes of stored data at |src|.
+  uint64_t StoredHash(const void* src, size_t len) const;
+
+  DECLARE_CRITICAL_MUTEX(VmCompression) dedup_lock_;
+  fbl::Array<DedupEntry> dedup_table_ TA_GUARDED(dedup_lock_);
+  // Page used to decompress indexed items into when verifying a duplicate. This has its own lock so
+  // that verification does not serialize lookups and insertions into the index.
+  DECLARE_CRITICAL_MUTEX(VmCompression) dedup_scratch_lock_;
+  vm_page_t* dedup_scratch_page_ TA_GUARDED(dedup_scratch_lock_) = nullptr;
 
   // Internal helpers to operate on the temporary references.
   ktl::optional<PageAndMetadata> MoveTempReference(CompressedRef ref);
@@ -315,6 +498,18 @@ class VmCompression final : public fbl::RefCounted<VmCompression> {
   RelaxedAtomic<uint64_t> decompressions_ = 0;
   RelaxedAtomic<uint64_t> decompression_skipped_ = 0;
   RelaxedAtomic<uint64_t> decompressions_within_log_seconds_[kNumLogBuckets] = {};
+  RelaxedAtomic<uint64_t> dedup_hits_ = 0;
+  RelaxedAtomic<uint64_t> dedup_collisions_ = 0;
+
+  // Statistics broken down by the effort that was actually used for a compression, allowing the
+  // compression ratio and time of the regular and dense strategies to be compared.
+  struct EffortStats {
+    RelaxedAtomic<uint64_t> attempts = 0;
+    RelaxedAtomic<uint64_t> stored_pages = 0;
+    RelaxedAtomic<uint64_t> stored_bytes = 0;
+    RelaxedAtomic<zx_duration_mono_t> time = 0;
+  };
+  EffortStats effort_stats_[VmCompressor::kNumEfforts];
 };
 
 #endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_COMPRESSION_H_
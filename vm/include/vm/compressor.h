@@ -96,9 +96,19 @@ class VmCompressor {
   struct ZeroTag {};
   using CompressResult = ktl::variant<CompressedRef, ZeroTag, FailTag>;
 
+  // How much effort should be spent compressing a page. |Fast| favors compression speed and is
+  // suitable for routine reclamation, whereas |Dense| favors a better compression ratio and is
+  // intended for when the system is close to running out of memory. See |VmCompression| for how
+  // these map onto compression strategies.
+  enum class Effort : uint8_t {
+    Fast,
+    Dense,
+  };
+  static constexpr size_t kNumEfforts = 2;
+
   // Arms the compressor, ensuring the backup page is allocated. This must be called prior to
-  // |Start|.
-  zx_status_t Arm();
+  // |Start|. The |effort| is used for the next compression performed by |Compress|.
+  zx_status_t Arm(Effort effort = Effort::Fast);
 
   // Start the compression process. Gives ownership of the page to the compressor, and returns the
   // temporary compression reference that should be installed in the page list in its place. |Arm|
@@ -189,6 +199,9 @@ class VmCompressor {
   // Begin in the Finalized state to require Arm to be called initially.
   State state_ = State::Finalized;
 
+  // Effort requested by the most recent |Arm|. Only accessed by the owner of the instance.
+  Effort effort_ = Effort::Fast;
+
   // Has no load bearing functionality and is only used for assertion checking. Ownership
   // permissions are the same as for spare_page.
   bool using_temp_reference_ = false;
@@ -206,6 +219,10 @@ class VmCompressor {
   // holder of the VMO lock.
   vm_page_t* spare_page_ = nullptr;
 
+  // Destination page handed to VmCompression::Compress. It is kept across compressions to avoid
+  // going to the pmm every time, and is only accessed by the owner of the VmCompressor instance.
+  vm_page_t* buffer_page_ = nullptr;
+
   // Result of the most recent compression attempt.
   // Read-only, and must only be accessed in the Compressed state by the holder of the VMO lock.
   ktl::optional<CompressResult> compression_result_ = ktl::nullopt;
@@ -67,10 +67,22 @@ class DiscardableVmoTracker final
   using DiscardablePageCounts = VmCowPages::DiscardablePageCounts;
   static DiscardablePageCounts DebugDiscardablePageCounts() TA_EXCL(DiscardableVmosLock::Get());
 
+  // Discards reclaimable VMOs until at least |target_pages| pages have been freed or there are no
+  // candidates left, returning the number of pages freed. Only VMOs last unlocked at least
+  // |min_idle| ago are considered. Candidates are gathered from the least recently unlocked end of
+  // the reclaim list |kReclaimBatchSize| at a time under a single acquisition of the
+  // |DiscardableVmosLock|, and each batch is then discarded largest first with that lock dropped,
+  // so that the target is met by discarding as few VMOs as possible.
+  static uint64_t ReclaimIdleVmos(uint64_t target_pages, zx_duration_mono_t min_idle)
+      TA_EXCL(DiscardableVmosLock::Get());
+
   // Accessors for private members.
   DiscardableState discardable_state_locked() const TA_REQ(cow_->lock()) {
     return discardable_state_;
   }
+  zx_instant_mono_t last_unlock_timestamp_locked() const TA_REQ(cow_->lock()) {
+    return last_unlock_timestamp_;
+  }
 
   // Debug functions exposed for testing.
   uint64_t DebugGetLockCount() const {
@@ -86,6 +98,9 @@ class DiscardableVmoTracker final
   void assert_cow_pages_locked() TA_ASSERT(cow_->lock()) { AssertHeld(cow_->lock_ref()); }
 
  private:
+  // Number of candidates ReclaimIdleVmos() gathers per acquisition of the |DiscardableVmosLock|.
+  static constexpr size_t kReclaimBatchSize = 16;
+
   // Updates the |discardable_state_| of a discardable vmo, and moves it from one discardable list
   // to another.
   void UpdateDiscardableStateLocked(DiscardableState state) TA_REQ(cow_->lock())
@@ -12,7 +12,9 @@
 #include <zircon/time.h>
 
 #include <kernel/event.h>
+#include <kernel/semaphore.h>
 #include <kernel/spinlock.h>
+#include <ktl/array.h>
 #include <vm/page.h>
 
 class PmmNode;
@@ -87,14 +89,25 @@ class Evictor {
   Evictor();
   ~Evictor();
 
+  // Most eviction workers that can be requested, see EnableEviction.
+  static constexpr uint32_t kMaxEvictionWorkers = 8;
+
+  // Pages that an eviction worker claims from a parallel eviction at a time. Evictions of fewer
+  // than two batches are not worth splitting up and are done by the caller alone.
+  static constexpr uint64_t kWorkerBatchPages = 64;
+
   // Called from the scanner to enable eviction if required. Creates an eviction thread to process
   // asynchronous eviction requests.
   // By default this only enables user pager based eviction and |use_compression| can be used to
   // also perform compression.
-  void EnableEviction(bool use_compression);
+  // |num_workers|, capped at kMaxEvictionWorkers, is the number of additional eviction worker
+  // threads to create. Large evictions, whether from the eviction thread or a synchronous caller,
+  // are split into batches that the caller and the workers reclaim in parallel. |num_workers| is
+  // ignored if the eviction thread is already running.
+  void EnableEviction(bool use_compression, uint32_t num_workers = 0);
   // Called from the scanner to disable all eviction if needed, will shut down any in existing
-  // eviction thread. It is a responsibility of the scanner to not have multiple concurrent calls
-  // to this and EnableEviction.
+  // eviction thread and eviction workers. It is a responsibility of the scanner to not have
+  // multiple concurrent calls to this and EnableEviction.
   void DisableEviction();
 
   // Evict from a user specified external |target| which is only used for this eviction attempt and
@@ -121,6 +134,25 @@ class Evictor {
                          EvictionLevel eviction_level = EvictionLevel::OnlyOldest,
                          Output output = Output::NoPrint);
 
+  // Proactive reclamation limits, in pages. A |low_pages| of zero means proactive reclamation is
+  // disabled.
+  struct ProactiveWatermarks {
+    uint64_t low_pages = 0;
+    uint64_t high_pages = 0;
+    // Most pages to evict per |kProactivePeriod|.
+    uint64_t pages_per_period = 0;
+  };
+
+  // How often the eviction thread checks free memory against the proactive watermarks.
+  static constexpr zx_duration_mono_t kProactivePeriod = ZX_MSEC(100);
+
+  // Configures proactive reclamation. Once free memory drops below |low_mem| (in bytes) the
+  // eviction thread reclaims the oldest pages until free memory is back up to |high_mem|, evicting
+  // at most |max_bytes_per_second| while doing so. This keeps a reserve of free memory ahead of
+  // demand, so that allocations rarely have to wait for reclamation. A |low_mem| of zero disables
+  // proactive reclamation.
+  void SetProactiveWatermarks(uint64_t low_mem, uint64_t high_mem, uint64_t max_bytes_per_second);
+
   // Whether any eviction can occur.
   bool IsEvictionEnabled() const;
 
@@ -152,6 +184,13 @@ class Evictor {
 
   // Helpers for testing.
   EvictionTarget DebugGetEvictionTarget() const;
+  uint32_t DebugNumWorkers() const;
+
+  // Performs one period's worth of proactive reclamation against |marks|. |reclaiming| tracks
+  // whether a previous period dropped below the low watermark and the high one has not yet been
+  // reached, and is updated accordingly. This may acquire arbitrary vmo and aspace locks.
+  EvictedPageCounts EvictProactively(const ProactiveWatermarks &marks, bool *reclaiming)
+      TA_EXCL(lock_);
 
   friend class vm_unittest::TestPmmNode;
 
@@ -181,9 +220,23 @@ class Evictor {
   EvictedPageCounts EvictPageQueues(uint64_t target_pages, EvictionLevel eviction_level) const
       TA_EXCL(lock_);
 
+  // Evicts |target_pages| like EvictPageQueues, splitting the work between the calling thread and
+  // any eviction workers if it is large enough. Must be called with |no_ongoing_eviction_| held,
+  // which keeps there from being more than one parallel eviction at a time.
+  EvictedPageCounts EvictPageQueuesParallel(uint64_t target_pages, EvictionLevel eviction_level)
+      TA_EXCL(lock_);
+
+  // Claims and evicts batches of the current parallel eviction until it is complete or runs out of
+  // pages to evict, then adds what was evicted to |worker_pass_counts_|. Run by the thread that
+  // started the parallel eviction and by each eviction worker, as indicated by |is_worker|.
+  void RunWorkerPass(bool is_worker) TA_EXCL(lock_);
+
   // The main loop for the eviction thread.
   int EvictionThreadLoop() TA_EXCL(lock_);
 
+  // The main loop for the eviction workers.
+  int EvictionWorkerLoop() TA_EXCL(lock_);
+
   // Returns the count of the free pages for use in performing target calculations. This could be
   // from the PMM or a test fake.
   uint64_t CountFreePages() const;
@@ -202,6 +255,9 @@ class Evictor {
   // Target for eviction.
   EvictionTarget eviction_target_ TA_GUARDED(lock_) = {};
 
+  // Watermarks for proactive reclamation by the eviction thread.
+  ProactiveWatermarks proactive_watermarks_ TA_GUARDED(lock_) = {};
+
   // Event that enforces only one eviction attempt to be active at any time. This prevents us from
   // overshooting the free memory targets required by various simultaneous eviction requests.
   AutounsignalEvent no_ongoing_eviction_{true};
@@ -218,6 +274,27 @@ class Evictor {
   // Used by the eviction thread to wait for eviction requests.
   AutounsignalEvent eviction_signal_;
 
+  // Eviction workers that help the eviction thread and synchronous callers with large evictions.
+  // Only changed by EnableEviction and DisableEviction, while no eviction is ongoing.
+  ktl::array<Thread *, kMaxEvictionWorkers> worker_threads_ = {};
+  uint32_t num_workers_ TA_GUARDED(lock_) = 0;
+  ktl::atomic<bool> workers_exiting_ = false;
+  // Posted once per worker to start each parallel eviction, or to have the workers exit.
+  Semaphore worker_start_;
+
+  // The parallel eviction in progress, if any. The target and level are set before the workers are
+  // started and are then constant until it is complete.
+  uint64_t worker_pass_target_ = 0;
+  EvictionLevel worker_pass_level_ = EvictionLevel::OnlyOldest;
+  // Pages claimed by the threads running the pass so far, which may overshoot the target.
+  ktl::atomic<uint64_t> worker_pass_claimed_ = 0;
+  // Set once any thread fails to evict a whole batch, as there is then nothing more to evict.
+  ktl::atomic<bool> worker_pass_exhausted_ = false;
+  // Threads that have yet to finish the pass. The last one signals |worker_pass_done_|.
+  ktl::atomic<uint32_t> worker_pass_running_ = 0;
+  AutounsignalEvent worker_pass_done_;
+  EvictedPageCounts worker_pass_counts_ TA_GUARDED(lock_) = {};
+
   // Optionally specified methods to allow for tests to fake interactions with the pmm. To avoid
   // virtual dispatch in non test scenarios these are empty/null methods when not set.
   const ReclaimFunction test_reclaim_function_;
@@ -36,9 +36,14 @@ class KernelStack {
   // This is useful during a thread dump.
   void DumpInfo(int debug_level) const;
 
-  // Returns the stack to its pre-Init() state.
+  // Returns the stack to its pre-Init() state. The mappings are kept in a small per-CPU cache for
+  // reuse by a later Init(), and only destroyed if that cache is full.
   zx_status_t Teardown();
 
+  // Destroys every stack held in the per-CPU caches, for use when memory is tight. Returns the
+  // number of cached stacks that were released.
+  static size_t TrimCache();
+
   vaddr_t base() const { return main_map_.base(); }
   vaddr_t top() const { return main_map_.top(); }
 #if __has_feature(safe_stack)
@@ -60,6 +65,10 @@ class KernelStack {
   };
 
  private:
+  // Moves the mappings of a stack into, or out of, the per-CPU caches. Returns false if there was
+  // no cached stack to take, or no room to cache this one.
+  bool TakeFromCache();
+  bool ReturnToCache();
   Mapping main_map_;
 
 #if __has_feature(safe_stack)
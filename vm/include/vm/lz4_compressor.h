@@ -14,8 +14,9 @@
 
 class VmLz4Compressor final : public VmCompressionStrategy {
  public:
-  // Returns nullptr on allocation or other failure.
-  static fbl::RefPtr<VmLz4Compressor> Create();
+  // Returns nullptr on allocation or other failure. |num_streams| is the number of independent
+  // compression streams to create, bounding how many compressions can run in parallel.
+  static fbl::RefPtr<VmLz4Compressor> Create(size_t num_streams = 1);
   ~VmLz4Compressor() override = default;
   DISALLOW_COPY_ASSIGN_AND_MOVE(VmLz4Compressor);
 
@@ -27,11 +28,9 @@ class VmLz4Compressor final : public VmCompressionStrategy {
   // Constructor is private to ensure that Init() gets called to initialize state.
   VmLz4Compressor(int lz4_acceleration) : acceleration_(lz4_acceleration) {}
 
-  DECLARE_MUTEX(VmLz4Compressor) compress_lock_;
-
-  // Internal helper that initializes the stream_ and compressed_zero_. If this returns false the
+  // Internal helper that initializes the streams_ and compressed_zero_. If this returns false the
   // object should be destroyed and not used.
-  bool Init();
+  bool Init(size_t num_streams);
 
   // The acceleration factor that is directly passed into the lz4 compress methods. Is set by the
   // constructor and has no default value. Making this non-const would require a different form of
@@ -42,8 +41,14 @@ class VmLz4Compressor final : public VmCompressionStrategy {
   // determine if any |Compress| request is actually just a zero page by memcmp'ing with the result.
   fbl::Array<char> compressed_zero_;
 
-  // The LZ4_stream_t used to hold compression state.
-  LZ4_stream_t stream_ TA_GUARDED(compress_lock_);
+  // The LZ4_stream_t instances used to hold compression state. A compression uses the stream
+  // associated with the current CPU, so concurrent compressions on different CPUs generally do not
+  // contend on the lock.
+  struct Stream {
+    DECLARE_MUTEX(Stream) lock;
+    LZ4_stream_t stream TA_GUARDED(lock);
+  };
+  fbl::Array<Stream> streams_;
 };
 
 #endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_LZ4_COMPRESSOR_H_
@@ -0,0 +1,57 @@
+// Copyright 2023 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_VM_INCLUDE_VM_LZ4HC_COMPRESSOR_H_
+#define ZIRCON_KERNEL_VM_INCLUDE_VM_LZ4HC_COMPRESSOR_H_
+
+#include <fbl/array.h>
+#include <kernel/mutex.h>
+#include <lz4/lz4hc.h>
+#include <vm/compression.h>
+
+// Compression strategy using the high compression mode of LZ4. This trades substantially more time
+// compressing for a better compression ratio, and produces regular LZ4 blocks, so decompression
+// speed is the same as VmLz4Compressor and the two strategies can decompress each other's output.
+class VmLz4HcCompressor final : public VmCompressionStrategy {
+ public:
+  // Each LZ4_streamHC_t is over 256KiB, so unlike VmLz4Compressor only a small number of streams
+  // are supported. Concurrent compressions beyond this many will contend.
+  static constexpr size_t kMaxStreams = 4;
+
+  // Returns nullptr on allocation or other failure. |num_streams| is the number of independent
+  // compression streams to create, and is clamped to kMaxStreams.
+  static fbl::RefPtr<VmLz4HcCompressor> Create(size_t num_streams = 1);
+  ~VmLz4HcCompressor() override = default;
+  DISALLOW_COPY_ASSIGN_AND_MOVE(VmLz4HcCompressor);
+
+  CompressResult Compress(const void* src, void* dst, size_t dst_limit) override;
+  void Decompress(const void* src, size_t src_len, void* dst) override;
+  void Dump() const override;
+
+ private:
+  // Constructor is private to ensure that Init() gets called to initialize state.
+  VmLz4HcCompressor(int level) : level_(level) {}
+
+  // Internal helper that initializes the streams_ and compressed_zero_. If this returns false the
+  // object should be destroyed and not used.
+  bool Init(size_t num_streams);
+
+  // The compression level that is directly passed into the lz4hc compress methods.
+  const int level_;
+
+  // The compressed representation, using the |level_| value, of a page of zeroes. Used to determine
+  // if any |Compress| request is actually just a zero page by memcmp'ing with the result.
+  fbl::Array<char> compressed_zero_;
+
+  // The LZ4_streamHC_t instances used to hold compression state, selected by the current CPU.
+  struct Stream {
+    DECLARE_MUTEX(Stream) lock;
+    LZ4_streamHC_t stream TA_GUARDED(lock);
+  };
+  fbl::Array<Stream> streams_;
+};
+
+#endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_LZ4HC_COMPRESSOR_H_
@@ -18,7 +18,9 @@
 #include <kernel/mutex.h>
 #include <kernel/semaphore.h>
 #include <ktl/array.h>
+#include <ktl/atomic.h>
 #include <ktl/optional.h>
+#include <ktl/unique_ptr.h>
 #include <ktl/variant.h>
 #include <vm/debug_compressor.h>
 #include <vm/page.h>
@@ -109,6 +111,8 @@ class PageQueues {
   void SetAnonymous(vm_page_t* page, VmCowPages* object, uint64_t page_offset,
                     bool skip_reclaim = false);
   void SetReclaim(vm_page_t* page, VmCowPages* object, uint64_t page_offset);
+  // Batched version of SetReclaim, which takes the page queues lock once per kMaxBatchSize pages.
+  void SetReclaimArray(vm_page_t** pages, VmCowPages* object, uint64_t* offsets, size_t count);
   void SetPagerBackedDirty(vm_page_t* page, VmCowPages* object, uint64_t page_offset);
   void SetAnonymousZeroFork(vm_page_t* page, VmCowPages* object, uint64_t page_offset);
   void SetHighPriority(vm_page_t* page, VmCowPages* object, uint64_t page_offset);
@@ -314,6 +318,11 @@ class PageQueues {
   // or if not running in debug mode.
   void StartDebugCompressor();
 
+  // Allocates the per-CPU staging batches, after which pages inserted by SetAnonymous,
+  // SetAnonymousZeroFork and SetReclaim are linked into their queues in groups, rather than each
+  // insertion acquiring the list_lock_. See |staging_| for details.
+  void StartStaging();
+
   // Sets the active ratio multiplier.
   void SetActiveRatioMultiplier(uint32_t multiplier);
 
@@ -466,6 +475,26 @@ class PageQueues {
                                   PageQueue queue) TA_REQ(list_lock_);
   void MoveToQueueLockedList(vm_page_t* page, PageQueue queue) TA_REQ(list_lock_);
 
+  // Sets the backlink, queue and count of a page that is not in any queue, without linking the page
+  // into its queue's list.
+  void SetQueueBacklink(vm_page_t* page, void* object, uintptr_t page_offset, PageQueue queue);
+
+  // Stages |page| with the given backlink into the current CPU's staging batch, with the queue
+  // returned by |get_queue|. Falls back to immediately linking the page if staging is not started,
+  // and links the whole batch if it is full. |debug_compress| indicates whether the page should be
+  // given to the debug compressor once it is linked.
+  template <typename F>
+  void SetQueueBacklinkStaged(vm_page_t* page, VmCowPages* object, uint64_t page_offset,
+                              bool debug_compress, F get_queue) TA_EXCL(list_lock_);
+
+  // Helpers for linking staged pages into their queues. All operations that require a page to be in
+  // its list, or that walk the lists in a way that staged pages could be missed, must first flush.
+  struct StagingBatch;
+  void FlushStagingBatchLockedList(StagingBatch& batch) TA_REQ(list_lock_);
+  void FlushStagedLockedList() TA_REQ(list_lock_);
+  // Flushes the staging batches if |page| is presently staged, ensuring that it is in its list.
+  void EnsureListedLockedList(vm_page_t* page) TA_REQ(list_lock_);
+
   // Potentially calls |CheckActiveRatioAgingLocked| based on the kActiveInactiveErrorMargin.
   // |pages| indicates how many pages might have changed queue, and hence how much the ratio could
   // have changed by.
@@ -698,6 +727,35 @@ class PageQueues {
   ktl::unique_ptr<VmDebugCompressor> debug_compressor_ TA_GUARDED(list_lock_);
 #endif
 
+  // Maximum number of pages that a CPU can stage before they must be linked into their queues.
+  static constexpr size_t kStagingBatchSize = 15;
+
+  struct StagingBatch {
+    DECLARE_SPINLOCK(StagingBatch) lock;
+    ktl::array<vm_page_t*, kStagingBatchSize> pages TA_GUARDED(lock);
+#if DEBUG_ASSERT_IMPLEMENTED
+    // Whether the corresponding page is given to the debug compressor once it is linked.
+    ktl::array<bool, kStagingBatchSize> debug_compress TA_GUARDED(lock);
+#endif
+    size_t count TA_GUARDED(lock) = 0;
+  };
+
+  // Per-CPU batches of staged pages. A staged page has its backlink, queue and count set, just as
+  // if it had been inserted, but it is not yet linked into the list for its queue. Linking happens
+  // for a whole batch under a single acquisition of the list_lock_, either once the batch is full,
+  // or when another operation needs the page to be in its list. As pages are never staged while in
+  // a list, a page that is in the page queues but not in a list is known to be staged.
+  //
+  // The lock of a batch is only acquired with interrupts disabled, and is acquired after the
+  // list_lock_ when both are needed. As the queue of a staged page is chosen with the lock of its
+  // batch held, and ProcessLruQueue flushes all batches before advancing the lru_gen_, staged pages
+  // are only ever linked into valid lists.
+  //
+  // The staging_ pointer is null until StartStaging, and is never changed once set.
+  ktl::atomic<StagingBatch*> staging_ = nullptr;
+  ktl::unique_ptr<StagingBatch[]> staging_storage_ TA_GUARDED(list_lock_);
+  size_t num_staging_batches_ TA_GUARDED(list_lock_) = 0;
+
   // Queue rotation parameters. These are not locked as they are only read by the mru thread, and
   // are set before the mru thread is started.
   zx_duration_mono_t min_mru_rotate_time_;
@@ -248,6 +248,21 @@ class PageSource final : public PageRequestInterface {
     return PopulateRequest(req, offset, len, vmo_debug_info, page_request_type::READ);
   }
 
+  // Returns the length that a read request for [offset, offset + len) should be extended to in
+  // order to read ahead of the access pattern, and records the request in the readahead state. Read
+  // requests that start exactly where the previous one ended are considered sequential and double
+  // the readahead window, up to kReadaheadMaxPages, whereas any other request halves it. Requests
+  // that start within the range of the previous one, such as when a request is retried, do not
+  // change the window.
+  //
+  // The returned length is never less than |len|, and may need to be trimmed by the caller to the
+  // size of the VMO and to avoid content that is already present.
+  uint64_t ReadaheadLength(uint64_t offset, uint64_t len);
+
+  // Bounds of the readahead window added to sequential read requests.
+  static constexpr uint64_t kReadaheadMinPages = 4;
+  static constexpr uint64_t kReadaheadMaxPages = 64;
+
   void FreePages(list_node* pages);
 
   // For asserting purposes only.  This gives the PageProvider a chance to check that a page is
@@ -384,6 +399,20 @@ class PageSource final : public PageRequestInterface {
   // We cache the immutable page_provider_->properties() to avoid many virtual calls.
   const PageSourceProperties page_provider_properties_;
 
+  // Readahead state for read requests, see ReadaheadLength.
+  struct ReadaheadState {
+    // Range of the most recent read request, including its readahead.
+    uint64_t start = 0;
+    uint64_t end = 0;
+    // Size of the window that requests are extended to.
+    uint64_t window_pages = 0;
+    // Read requests that were sequential, and so consumed the previous readahead, and those that
+    // were not.
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+  };
+  ReadaheadState readahead_ TA_GUARDED(page_source_mtx_);
+
   // Trees of outstanding requests which have been sent to the PageProvider, one for each supported
   // page request type. These lists are keyed by the end offset of the requests (not the start
   // offsets).
@@ -30,6 +30,15 @@ class PhysicalPageBorrowingConfig {
     return borrowing_on_mru_enabled_.load(ktl::memory_order_relaxed);
   }
 
+  // true - allow page borrowing when a pager supplies pages to a VMO
+  // false - disallow page borrowing when a pager supplies pages to a VMO
+  void set_borrowing_in_supplypages_enabled(bool enabled) {
+    borrowing_in_supplypages_enabled_.store(enabled, ktl::memory_order_relaxed);
+  }
+  bool is_borrowing_in_supplypages_enabled() {
+    return borrowing_in_supplypages_enabled_.load(ktl::memory_order_relaxed);
+  }
+
   // true - decommitted contiguous VMO pages will decommit+loan the pages.
   // false - decommit of a contiguous VMO page zeroes instead of decommitting+loaning.
   void set_loaning_enabled(bool enabled) {
@@ -52,6 +61,11 @@ class PhysicalPageBorrowingConfig {
   // accessed non-loaned page with loaned on access.  If false, this is disabled.
   ktl::atomic<bool> borrowing_on_mru_enabled_ = false;
 
+  // Enable page borrowing when a pager supplies pages. If true, supplied non-loaned pages are
+  // replaced with loaned pages as they are added to the VMO, so that file content can be cached in
+  // loaned pages without first waiting for it to be accessed. If false, this is disabled.
+  ktl::atomic<bool> borrowing_in_supplypages_enabled_ = false;
+
   // Enable page loaning.  If false, no page loaning will occur.  If true, decommitting pages of a
   // contiguous VMO will loan the pages.  This can be dynamically changed, but changes will only
   // apply to subsequent decommit of contiguous VMO pages.
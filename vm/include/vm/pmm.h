@@ -164,6 +164,11 @@ void pmm_checker_init_from_cmdline();
 // operation and should only be used for debugging purposes.
 void pmm_checker_check_all_free_pages();
 
+// Validate the free pages among the next |max_pages| pages of the PMM's arenas, continuing on from
+// the previous call. Cheap enough to be called periodically to spread a check of every free page
+// over time. Returns the number of free pages validated.
+uint64_t pmm_checker_check_free_pages(uint64_t max_pages);
+
 // Synchronously walk the PMM's free list and poison (via kASAN) each page. This is an
 // incredibly expensive operation and should be used with care.
 void pmm_asan_poison_all_free_pages();
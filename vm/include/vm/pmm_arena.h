@@ -10,8 +10,11 @@
 #include <trace.h>
 #include <zircon/types.h>
 
+#include <fbl/array.h>
 #include <fbl/macros.h>
+#include <ktl/algorithm.h>
 #include <ktl/array.h>
+#include <ktl/atomic.h>
 #include <vm/page.h>
 #include <vm/phys/arena.h>
 
@@ -34,16 +37,93 @@ class PmmNode;
 
 class PmmArena {
  public:
+  // The page structures of an arena are initialized in chunks of at least 2^kMinInitChunkShift
+  // pages. At boot only the chunks needed to bring the system up are initialized, see
+  // InitDeferredChunk(). Arenas too large for kMaxInitChunks chunks of the minimum size use larger
+  // chunks, see |init_chunk_shift_|.
+  static constexpr size_t kMinInitChunkShift = 18;
+  static constexpr size_t kMaxInitChunks = 128;
+
+  // Pages are grouped into aligned blocks of this many pages for the full block summary, see
+  // |full_blocks_|.
+  static constexpr size_t kSummaryBlockShift = 9;
+  static constexpr size_t kSummaryBlockPages = 1ul << kSummaryBlockShift;
+
   constexpr PmmArena() = default;
   ~PmmArena() = default;
 
   DISALLOW_COPY_ASSIGN_AND_MOVE(PmmArena);
 
-  // initialize the arena and allocate memory for internal data structures
-  void Init(const PmmArenaSelection& selected, PmmNode* node);
+  // initialize the arena and allocate memory for internal data structures. If |defer| is set only
+  // the first chunk of pages and the chunks backing the page array itself are initialized, and the
+  // rest is left to InitDeferredChunk().
+  void Init(const PmmArenaSelection& selected, PmmNode* node, bool defer);
+
+  // Initializes every chunk overlapping [|pa|, |pa| + |length|) that is not yet initialized, adding
+  // its free pages to |node|. Only used during early boot, before the deferred chunks are handed
+  // out by InitDeferredChunk().
+  void InitRangeEarly(paddr_t pa, size_t length, PmmNode* node);
+
+  // Claims the next chunk whose initialization was deferred at boot, initializes its pages and
+  // hands the free ones to |node|. May be called concurrently from multiple threads. Returns false
+  // once there are no deferred chunks left to claim.
+  bool InitDeferredChunk(PmmNode* node);
+
+  // Returns whether any chunk has not yet been claimed by InitDeferredChunk().
+  bool has_deferred_chunks() const {
+    return next_deferred_chunk_.load(ktl::memory_order_relaxed) < chunk_count();
+  }
+
+  // Marks |chunk| as initialized, making its pages visible to FindSpecific(), FindFreeContiguous()
+  // and the other arena walks. Called by the PmmNode with its lock held as it takes the free pages.
+  void MarkChunkInitialized(size_t chunk) {
+    DEBUG_ASSERT(chunk < chunk_count());
+    initialized_chunks_[chunk / 64].fetch_or(1ul << (chunk % 64), ktl::memory_order_release);
+    // Before now the pages of the chunk were not free, and so its blocks could have been found
+    // full. As chunks are a multiple of the block size, whole words of the summary are cleared.
+    static_assert((1ul << kMinInitChunkShift) % (kSummaryBlockPages * 64) == 0);
+    if (!full_blocks_.empty()) {
+      const size_t words_per_chunk = init_chunk_pages() / kSummaryBlockPages / 64;
+      const size_t first_word = chunk * words_per_chunk;
+      const size_t last_word = ktl::min(first_word + words_per_chunk, full_blocks_.size());
+      for (size_t word = first_word; word < last_word; word++) {
+        full_blocks_[word] = 0;
+      }
+    }
+  }
+
+  // Returns whether the vm_page_t at |index| has been initialized. Pages of chunks that have not
+  // been initialized yet are not owned by anyone and must not be looked at.
+  bool page_initialized(size_t index) const {
+    const size_t chunk = index >> init_chunk_shift_;
+    return initialized_chunks_[chunk / 64].load(ktl::memory_order_acquire) & (1ul << (chunk % 64));
+  }
 
   void InitForTest(const pmm_arena_info_t& info, vm_page_t* page_array);
 
+  // Returns the number of words that the full block summary of this arena needs.
+  size_t full_block_summary_words() const {
+    return ((size() / PAGE_SIZE + kSummaryBlockPages - 1) / kSummaryBlockPages + 63) / 64;
+  }
+
+  // Installs |summary|, which must be zeroed and hold full_block_summary_words() words, as the full
+  // block summary. Called once, with the PmmNode lock held.
+  void SetFullBlockSummary(fbl::Array<uint64_t> summary) {
+    DEBUG_ASSERT(summary.size() == full_block_summary_words());
+    DEBUG_ASSERT(full_blocks_.empty());
+    full_blocks_ = ktl::move(summary);
+  }
+
+  // Records that the block holding the page at |index| may have FREE pages. Must be called, with
+  // the PmmNode lock held, whenever a page of this arena becomes FREE other than by chunk
+  // initialization, which is covered by MarkChunkInitialized.
+  void MarkBlockMayHaveFree(size_t index) {
+    const size_t block = index >> kSummaryBlockShift;
+    if (!full_blocks_.empty()) {
+      full_blocks_[block / 64] &= ~(1ul << (block % 64));
+    }
+  }
+
   // accessors
   const pmm_arena_info_t& info() const { return info_; }
   const char* name() const { return info_.name; }
@@ -86,13 +166,56 @@ class PmmArena {
   //
   // A loaned page is considered non-free for purposes of contiguous memory
   // allocation.
-  zx::result<uint64_t> FindLastNonFree(uint64_t offset, size_t count) const;
+  //
+  // For regions of at least a block, the full block summary is consulted and
+  // updated, and the returned index may be past the end of the region if the
+  // pages in between are also known to be non-free.
+  zx::result<uint64_t> FindLastNonFree(uint64_t offset, size_t count);
+
+  // Returns whether the page at |index| is initialized and FREE.
+  bool page_free(size_t index) const {
+    return page_initialized(index) && page_array_[index].is_free();
+  }
+
+  // Returns whether every page of |block| is known to be non-free, and verifies and records whether
+  // every page of |block| is non-free, respectively.
+  bool block_known_full(size_t block) const {
+    return !full_blocks_.empty() && (full_blocks_[block / 64] & (1ul << (block % 64)));
+  }
+  bool CheckBlockFull(size_t block);
+
+  size_t init_chunk_pages() const { return 1ul << init_chunk_shift_; }
+  size_t chunk_count() const {
+    return (size() / PAGE_SIZE + init_chunk_pages() - 1) >> init_chunk_shift_;
+  }
+
+  // Sets |init_chunk_shift_| to the smallest chunk size that covers the arena with at most
+  // kMaxInitChunks chunks.
+  void SetInitChunkShift();
+
+  // Initializes the page structures of |chunk| and appends its free pages to |free_list|.
+  void InitChunk(size_t chunk, list_node* free_list);
 
   pmm_arena_info_t info_ = {};
   vm_page_t* page_array_ = nullptr;
+  // The range of |page_array_| that backs the page array itself, whose pages are WIRED.
+  size_t array_start_index_ = 0;
+  size_t array_end_index_ = 0;
+  // log2 of the number of pages per initialization chunk.
+  size_t init_chunk_shift_ = kMinInitChunkShift;
+  // One bit per chunk, set once the page structures of the chunk are initialized.
+  ktl::array<ktl::atomic<uint64_t>, kMaxInitChunks / 64> initialized_chunks_ = {};
+  // The next chunk for InitDeferredChunk() to consider.
+  ktl::atomic<size_t> next_deferred_chunk_ = 0;
   // The index into |page_array_| at which the next |FindFreeContiguous| serach
   // should begin.  Used to optimize |FindFreeContiguous|.
   uint64_t search_hint_ = 0;
+  // Full block summary, with one bit per block of kSummaryBlockPages pages that is set only if
+  // every page of the block is known to not be FREE. Bits are set by FindFreeContiguous as it
+  // verifies blocks, and cleared as pages become free, allowing searches for large runs to skip
+  // over used blocks without looking at their pages. Empty until installed by the PmmNode, after
+  // which it is protected by the PmmNode lock.
+  fbl::Array<uint64_t> full_blocks_;
 };
 
 #endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_PMM_ARENA_H_
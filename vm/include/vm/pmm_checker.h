@@ -24,6 +24,9 @@
 //   // Check only the first 16 bytes of each page.
 //   checker.SetFillSize(16);
 //
+//   // Only fill and check 1 in every 100 pages.
+//   checker.SetSampleRate(100);
+//
 //   // For all free pages...
 //   for (...) {
 //     checker.FillPattern(page);
@@ -56,6 +59,20 @@ class PmmChecker {
   // Returns the fill size.
   size_t GetFillSize() const { return fill_size_; }
 
+  // Sets the checker to only fill and validate 1 in every |sample_rate| pages, which must be at
+  // least 1. Which pages are sampled depends only on their physical address, so a page that was not
+  // filled when freed will also not be validated.
+  //
+  // As with |SetFillSize|, it is an error to call this method if the checker |IsArmed|, and any
+  // free pages should be re-filled afterwards.
+  void SetSampleRate(uint64_t sample_rate);
+
+  // Returns the sample rate.
+  uint64_t GetSampleRate() const { return sample_rate_; }
+
+  // Returns true if |page| is one of the pages that is filled and validated.
+  bool IsSampled(const vm_page_t* page) const;
+
   void SetAction(CheckFailAction action) { action_ = action; }
   CheckFailAction GetAction() const { return action_; }
 
@@ -66,10 +83,11 @@ class PmmChecker {
 
   void PrintStatus(FILE* f) const;
 
-  // Fills |page| with a pattern.
+  // Fills |page| with a pattern, if it |IsSampled|.
   void FillPattern(vm_page_t* page) const;
 
-  // Returns true if |page| contains the expected fill pattern or |IsArmed| is false.
+  // Returns true if |page| contains the expected fill pattern, or |IsArmed| is false, or |page| is
+  // not |IsSampled|.
   //
   // Otherwise, returns false.
   __WARN_UNUSED_RESULT bool ValidatePattern(vm_page_t* page) const;
@@ -85,6 +103,9 @@ class PmmChecker {
   // The number of bytes to fill/validate.
   size_t fill_size_ = PAGE_SIZE;
 
+  // One in how many pages to fill/validate.
+  uint64_t sample_rate_ = 1;
+
   CheckFailAction action_ = kDefaultAction;
 
   bool armed_ = false;
@@ -8,6 +8,8 @@
 
 #include <lib/memalloc/range.h>
 
+#include <arch/defines.h>
+#include <fbl/array.h>
 #include <fbl/canary.h>
 #include <fbl/intrusive_double_list.h>
 #include <kernel/event.h>
@@ -84,6 +86,20 @@ class PmmNode {
   zx_status_t AllocRange(paddr_t address, size_t count, list_node* list);
   zx_status_t AllocContiguous(size_t count, uint alloc_flags, uint8_t alignment_log2, paddr_t* pa,
                               list_node* list);
+
+  // Size of the naturally aligned runs of pages returned by |AllocLargePage|. This is the range
+  // covered by a single leaf page table, which all architectures can map with a single entry.
+  static constexpr uint8_t kLargePageShift = PAGE_SIZE_SHIFT + (PAGE_SIZE_SHIFT - 3);
+  static constexpr size_t kLargePageSize = 1ul << kLargePageShift;
+  static constexpr size_t kLargePageCount = kLargePageSize / PAGE_SIZE;
+
+  // Opportunistically allocates kLargePageCount physically contiguous pages aligned to
+  // kLargePageSize, placing them in |list| in physical address order. Unlike |AllocContiguous| this
+  // is intended for callers that can fall back to single pages, and so it fails with
+  // ZX_ERR_NOT_FOUND, instead of draining the per-cpu caches or dipping into the free memory that
+  // remains once allocations start being delayed, if a run is not immediately available.
+  zx_status_t AllocLargePage(paddr_t* pa, list_node* list);
+
   void FreePage(vm_page* page);
   void FreeList(list_node* list);
 
@@ -161,6 +177,22 @@ class PmmNode {
 
   void StopReturningShouldWait();
 
+  // Creates the per-CPU free page magazines, each of which may cache up to |magazine_size| free
+  // pages. Until this is called, or if |magazine_size| is 0, all allocations and frees go directly
+  // to the free list. Must be called at most once, after the heap and percpu structures are
+  // initialized.
+  zx_status_t InitMagazines(size_t magazine_size);
+
+  // Allocates the full block summaries of the arenas, which let contiguous allocations skip over
+  // blocks of pages that are in use. Until this is called, contiguous allocations look at every
+  // page. Must be called at most once, after the heap is initialized.
+  zx_status_t InitFullBlockSummaries();
+
+  // Returns all pages cached in the per-CPU magazines to the free list. The magazines remain usable
+  // and will refill on demand.
+  void DrainMagazines() TA_EXCL(lock_);
+
+  // Includes pages cached in the per-CPU magazines.
   uint64_t CountFreePages() const;
   uint64_t CountLoanedFreePages() const;
   uint64_t CountLoanCancelledPages() const;
@@ -195,6 +227,39 @@ class PmmNode {
   // add new pages to the free queue. used when boostrapping a PmmArena
   void AddFreePages(list_node* list);
 
+  // Adds the free pages of a chunk of |arena| that was initialized after boot to the free queue,
+  // and marks the chunk as initialized. See PmmArena::InitDeferredChunk().
+  void AddDeferredFreePages(PmmArena* arena, size_t chunk, list_node* list);
+
+  // Returns whether any arena still has page structures left to initialize.
+  bool HasDeferredPages() TA_NO_THREAD_SAFETY_ANALYSIS;
+
+  // Initializes one deferred chunk of some arena. Returns false once every chunk has been claimed.
+  // Intended to be called from a thread on each CPU until it returns false.
+  bool InitDeferredChunk() TA_NO_THREAD_SAFETY_ANALYSIS;
+
+  // Upper bounds on the NUMA configuration accepted by |SetNumaNodes|.
+  static constexpr size_t kMaxNumaNodes = 8;
+  static constexpr size_t kMaxNumaRanges = 16;
+
+  // A range of physical memory that is local to NUMA node |node|.
+  struct NumaMemoryRange {
+    paddr_t base;
+    size_t size;
+    uint8_t node;
+  };
+
+  // Splits the free pages into one free list per NUMA node according to |ranges|, and has
+  // allocations prefer the free list of the node that |cpu_nodes| maps the allocating CPU to,
+  // falling back to the other nodes in order once it is empty. Memory outside of every range, and
+  // CPUs past the end of |cpu_nodes|, are considered to be on node 0. Replaces any previous
+  // configuration.
+  //
+  // Returns ZX_ERR_OUT_OF_RANGE if there are too many ranges or CPUs, or a node is not less than
+  // kMaxNumaNodes.
+  zx_status_t SetNumaNodes(ktl::span<const NumaMemoryRange> ranges,
+                           ktl::span<const uint8_t> cpu_nodes);
+
   PageQueues* GetPageQueues() { return &page_queues_; }
 
   // Retrieve any page compression instance. If this returns non-null then it's return value will
@@ -217,6 +282,14 @@ class PmmNode {
   // an incredibly expensive operation and should only be used for debugging purposes.
   void CheckAllFreePages();
 
+  // Validates the free pages among the next |max_pages| pages of the arenas, continuing from where
+  // the previous call stopped and wrapping around once every arena has been walked. Intended to be
+  // called periodically so that corruption of pages that stay free for a long time is found without
+  // the cost of |CheckAllFreePages|. Returns the number of free pages that were validated.
+  //
+  // This is a no-op if the checker is not armed.
+  uint64_t CheckFreePagesIncremental(uint64_t max_pages);
+
 #if __has_feature(address_sanitizer)
   // Synchronously walk the PMM's free list (and free loaned list) and poison each page.
   void PoisonAllFreePages();
@@ -229,8 +302,10 @@ class PmmNode {
   // Note, pages freed piror to calling this method will remain unfilled.  To fill them, call
   // |FillFreePagesAndArm|.
   //
+  // Only 1 in every |sample_rate| pages is filled and checked, see |PmmChecker::SetSampleRate|.
+  //
   // Returns true if the checker was enabled with the requested fill_size, or |false| otherwise.
-  bool EnableFreePageFilling(size_t fill_size, CheckFailAction action);
+  bool EnableFreePageFilling(size_t fill_size, CheckFailAction action, uint64_t sample_rate = 1);
 
   // Return a pointer to this object's free fill checker.
   //
@@ -342,7 +417,59 @@ class PmmNode {
 
   bool ShouldDelayAllocationLocked() TA_REQ(lock_);
 
+  // Returns the NUMA node whose free list |page| belongs on.
+  uint8_t PageNumaNodeLocked(const vm_page_t* page) const TA_REQ(lock_);
+  // Returns the NUMA node of the current CPU. Must be called with preemption disabled.
+  uint8_t CurrentNumaNodeLocked() const TA_REQ(lock_);
+  // Places a single free page, or a list of them, on the free list of their NUMA node.
+  void AddToFreeListLocked(vm_page_t* page) TA_REQ(lock_);
+  void ReturnToFreeListsLocked(list_node* list) TA_REQ(lock_);
+  // Removes a page from the free lists, preferring the current CPU's NUMA node. Returns nullptr if
+  // every free list is empty.
+  vm_page_t* RemoveFreePageLocked() TA_REQ(lock_);
+  // Moves |count| pages from the free lists to the tail of |list|, preferring the current CPU's
+  // NUMA node, and calls |per_page| on each. The caller must ensure that there are at least |count|
+  // free pages.
+  template <typename F>
+  void RemoveFreePagesLocked(uint64_t count, list_node* list, F per_page) TA_REQ(lock_);
+
+  // Per-CPU cache of free pages that services single page allocations and frees without touching
+  // lock_ or the free lists. Magazines are refilled from, and drained to, the free lists in batches
+  // of magazine_batch_ pages, so that watermark and free memory signal processing observes magazine
+  // traffic only at batch granularity. Pages in a magazine are in the CACHE state, are not on the
+  // free lists, and are accounted in magazine_count_ instead of free_count_.
+  //
+  // The magazine lock is per-CPU and so only contended by DrainMagazines. It must be acquired
+  // before lock_.
+  struct alignas(MAX_CACHE_LINE) PageMagazine {
+    DECLARE_MUTEX(PageMagazine) lock;
+    list_node pages TA_GUARDED(lock) = LIST_INITIAL_VALUE(pages);
+    size_t count TA_GUARDED(lock) = 0;
+  };
+
+  // Returns whether the magazine fast paths may be used. This is racy, and callers must re-validate
+  // the parts that matter for correctness under the magazine lock.
+  bool MagazinesActiveRacy() const TA_NO_THREAD_SAFETY_ANALYSIS {
+    return magazines_enabled_.load(ktl::memory_order_acquire) &&
+           !delaying_allocations_.load(ktl::memory_order_relaxed) && !IsFreeFillEnabledRacy();
+  }
+  // Must be called with preemption disabled.
+  PageMagazine& CurrentMagazine();
+  vm_page_t* AllocPageFromMagazine(PageMagazine& magazine, uint alloc_flags)
+      TA_EXCL(magazine.lock, lock_);
+  bool FreePageToMagazine(PageMagazine& magazine, vm_page_t* page) TA_EXCL(magazine.lock, lock_);
+  bool RefillMagazineLocked(PageMagazine& magazine, uint alloc_flags) TA_REQ(magazine.lock)
+      TA_EXCL(lock_);
+  void ReturnMagazinePagesLocked(list_node* list) TA_REQ(lock_);
+
+  zx_status_t AllocContiguousLocked(size_t count, uint8_t alignment_log2, paddr_t* pa,
+                                    list_node* list) TA_REQ(lock_);
+
   void AllocPageHelperLocked(vm_page_t* page) TA_REQ(lock_);
+  // Informs the arena of |page| that it has become FREE, see PmmArena::MarkBlockMayHaveFree.
+  void MarkArenaBlockMayHaveFreeLocked(vm_page_t* page) TA_REQ(lock_);
+  // Returns the arena holding |page|, or nullptr, by a binary search of |arenas_by_base_|.
+  PmmArena* ArenaForPageLocked(const vm_page_t* page) TA_REQ(lock_);
   void AllocLoanedPageHelperLocked(vm_page_t* page) TA_REQ(loaned_list_lock_);
 
   // This method should be called when the PMM fails to allocate in a user-visible way and will
@@ -362,8 +489,16 @@ class PmmNode {
   ktl::atomic<uint64_t> loaned_count_ TA_GUARDED(loaned_list_lock_) = 0;
   ktl::atomic<uint64_t> loan_cancelled_count_ TA_GUARDED(loaned_list_lock_) = 0;
 
-  // Free pages where !loaned.
-  list_node free_list_ TA_GUARDED(lock_) = LIST_INITIAL_VALUE(free_list_);
+  // Free pages where !loaned, one list per NUMA node. Only the first numa_node_count_ lists are
+  // used, and until SetNumaNodes is called every free page is on the first.
+  struct NumaFreeList {
+    list_node pages = LIST_INITIAL_VALUE(pages);
+  };
+  NumaFreeList free_lists_[kMaxNumaNodes] TA_GUARDED(lock_);
+  size_t numa_node_count_ TA_GUARDED(lock_) = 1;
+  NumaMemoryRange numa_ranges_[kMaxNumaRanges] TA_GUARDED(lock_) = {};
+  size_t numa_range_count_ TA_GUARDED(lock_) = 0;
+  uint8_t cpu_numa_node_[SMP_MAX_CPUS] TA_GUARDED(lock_) = {};
   // Free pages where loaned && !loan_cancelled.
   mutable DECLARE_MUTEX(PmmNode) loaned_list_lock_;
   list_node free_loaned_list_ TA_GUARDED(loaned_list_lock_) = LIST_INITIAL_VALUE(free_loaned_list_);
@@ -404,6 +539,17 @@ class PmmNode {
     UntilReset,
   };
   ShouldWaitState should_wait_ TA_GUARDED(lock_) = ShouldWaitState::OnceLevelTripped;
+  // Mirrors whether should_wait_ is UntilReset so the magazine fast paths can avoid lock_. While
+  // allocations are being delayed the magazines are bypassed so that waitable allocations observe
+  // the delay and frees are immediately visible to the free memory signals.
+  ktl::atomic<bool> delaying_allocations_ = false;
+
+  // Updates should_wait_ and the racy copy of whether allocations are being delayed that is
+  // consulted by the magazine fast paths.
+  void SetShouldWaitLocked(ShouldWaitState state) TA_REQ(lock_) {
+    should_wait_ = state;
+    delaying_allocations_.store(state == ShouldWaitState::UntilReset, ktl::memory_order_relaxed);
+  }
 
   // Below this number of free pages the PMM will transition into delaying allocations.
   uint64_t should_wait_free_pages_level_ TA_GUARDED(lock_) = 0;
@@ -422,6 +568,20 @@ class PmmNode {
   uint64_t mem_signal_lower_bound_ TA_GUARDED(lock_) = 0;
   uint64_t mem_signal_upper_bound_ TA_GUARDED(lock_) = 0;
 
+  // Per-CPU page magazines, indexed by cpu number. Allocated by InitMagazines and never freed, with
+  // magazines_enabled_ being set with release semantics once the array is populated.
+  fbl::Array<PageMagazine> magazines_;
+  ktl::atomic<bool> magazines_enabled_ = false;
+  // Maximum pages a single magazine may hold, and the number of pages moved to or from the free
+  // list at a time. Immutable once magazines_enabled_ is set.
+  size_t magazine_size_ = 0;
+  size_t magazine_batch_ = 0;
+  // Total pages across all magazines.
+  ktl::atomic<uint64_t> magazine_count_ = 0;
+
+  // Whether InitFullBlockSummaries has installed the arena full block summaries.
+  bool full_block_summaries_ TA_GUARDED(lock_) = false;
+
   PageQueues page_queues_;
 
   Evictor evictor_;
@@ -445,6 +605,10 @@ class PmmNode {
   // safe to call AssertPattern even without the lock held.
   bool all_free_pages_filled_ TA_GUARDED(loaned_list_lock_) TA_GUARDED(lock_) = false;
   PmmChecker checker_;
+  // Position in the arenas, as an index into active_arenas() and a page index in that arena, at
+  // which the next |CheckFreePagesIncremental| continues.
+  size_t checker_cursor_arena_ TA_GUARDED(lock_) = 0;
+  size_t checker_cursor_index_ TA_GUARDED(lock_) = 0;
 
   // This method is racy as it allows us to read free_fill_enabled_ without holding the lock. If we
   // receive a value of 'true', then as there is no mechanism to re-set it to false, we know it is
@@ -491,6 +655,10 @@ class PmmNode {
 
   size_t used_arena_count_ TA_GUARDED(lock_) = 0;
   PmmArena arenas_[kArenaCount] TA_GUARDED(lock_);
+  // Indices into |arenas_| of the active arenas in increasing order of base address. Arenas are
+  // added in whatever order the boot memory ranges come in, and |arenas_| cannot be reordered as
+  // page indices encode positions in it.
+  uint8_t arenas_by_base_[kArenaCount] TA_GUARDED(lock_) = {};
 
   // Return the span of arenas from the built-in array that are known to be active. Used in loops
   // that iterate across all arenas.
@@ -508,7 +676,7 @@ inline vm_page_t* PmmNode::PaddrToPage(paddr_t addr) TA_NO_THREAD_SAFETY_ANALYSI
   for (auto& a : active_arenas()) {
     if (a.address_in_arena(addr)) {
       size_t index = (addr - a.base()) / PAGE_SIZE;
-      return a.get_page(index);
+      return a.page_initialized(index) ? a.get_page(index) : nullptr;
     }
   }
   return nullptr;
@@ -24,7 +24,9 @@ void scanner_pop_disable_count();
 
 // Attempts to scan for, and dedupe, zero pages. Page candidates are pulled from the
 // anonymous_zero_fork page queue. It will consider up to `limit` candidates, and return the
-// number of pages actually deduped.
+// number of pages actually deduped. If the compression system has content deduplication enabled
+// then candidates that are not zero are also merged with any identical stored page, and these are
+// included in the returned count.
 // This is expected to be used internally by the scanner thread, but is exposed for testing,
 // debugging and other code to use.
 uint64_t scanner_do_zero_scan(uint64_t limit);
@@ -37,6 +39,12 @@ void scanner_enable_page_table_reclaim();
 // Inverse of |scanner_enable_page_table_reclaim|, also does not stack.
 void scanner_disable_page_table_reclaim();
 
+// Asks the scanner to reclaim the next slice of unaccessed page tables as soon as possible, as
+// memory is running low. This is done regardless of whether page table reclamation is enabled,
+// unless it was disabled on the command line, and at most once per reclamation period slice.
+// Returns immediately.
+void scanner_request_page_table_reclaim();
+
 // Ask the scanner to dump informational state before issuing a panic. The assumption on calling
 // this is that the panic is due to eviction/scanner going wrong for some hard to infer reason at
 // the panic site, and this method can attempt to provide some additional context in the kernel log.
@@ -48,6 +48,13 @@
 // The use of 64 slots, and the resulting 64-byte slot size for 4k pages, is a trade-off in the
 // resulting fragmentation due to rounding, and the efficiency of being able to track slots in a
 // bitmap that fits in a single machine word.
+//
+// As items are freed in a different order to which they were stored, pages can end up holding only
+// a few items each. |Compact| addresses this by evacuating the sparsest pages, moving each of their
+// items into pages that are already more densely used, and giving the emptied pages back to the
+// pmm. To find the items in a page every item is prefixed, within its slots, by the id of its
+// |Allocation|. Data returned by |CompressedData| is kept in place by not compacting until it has
+// been released.
 
 class VmSlotPageStorage final : public VmCompressedStorage {
  public:
@@ -55,14 +62,19 @@ class VmSlotPageStorage final : public VmCompressedStorage {
   ~VmSlotPageStorage() final;
 
   void Free(CompressedRef ref) final;
+  void FreeBatch(ktl::span<const CompressedRef> refs) final;
   std::pair<ktl::optional<CompressedRef>, vm_page_t*> Store(vm_page_t* page, size_t len) final;
+  ktl::optional<CompressedRef> Share(CompressedRef ref) final;
   ktl::tuple<const void*, uint32_t, size_t> CompressedData(CompressedRef ref) const final;
+  void ReleaseCompressedData(CompressedRef ref) const final;
+  size_t Compact(size_t max_pages) final;
 
   uint32_t GetMetadata(CompressedRef ref) final;
   void SetMetadata(CompressedRef ref, uint32_t metadata) final;
 
   void Dump() const final;
   MemoryUsage GetMemoryUsage() const final;
+  CompactionStats GetCompactionStats() const final;
 
   // Query specific breakdown of the memory usage used internally by the storage system. Intended to
   // be used by tests.
@@ -80,25 +92,44 @@ class VmSlotPageStorage final : public VmCompressedStorage {
   static constexpr size_t kSlotSize = PAGE_SIZE / kNumSlots;
   static constexpr size_t kNumSlotBits = log2_floor(kNumSlots);
   static constexpr size_t kSlotSizeBits = log2_floor(kSlotSize);
+  // Size of the allocation id stored in front of every item, which counts towards the slots used.
+  static constexpr size_t kItemTagSize = sizeof(uint32_t);
 
  private:
   // Used to track a single allocation of the underlying storage. References to this are what is
   // returned in the `CompressedRef`, and these are allocated out of a slab allocator.
+  //
+  // An allocation either owns a range of slots, or is an alias created by |Share| that refers to
+  // the data of an owning allocation, and only holds its own metadata. An owner whose own reference
+  // is freed while aliases remain is kept, without being counted as stored, until the last alias is
+  // freed.
   struct Allocation {
-    // The original (non-rounded) size in bytes of the data being stored.
-    uint64_t byte_size() const {
+    // Aliases never own any slots, whereas owners always have at least one.
+    bool is_alias() const { return num_slots == 0; }
+    // The number of bytes used in the slots, which is the item tag followed by the data.
+    uint64_t slot_bytes() const {
       DEBUG_ASSERT(num_slots > 0);
       DEBUG_ASSERT(last_slot_bytes > 0 && last_slot_bytes <= kSlotSize);
       return (static_cast<uint64_t>(num_slots - 1) * kSlotSize) +
              static_cast<uint64_t>(last_slot_bytes);
     }
-    // Base address of the raw data.
-    void* data() const {
+    // The original (non-rounded) size in bytes of the data being stored.
+    uint64_t byte_size() const { return slot_bytes() - kItemTagSize; }
+    // Base address of the slots, where the item tag is stored.
+    void* slot_base() const {
       return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(paddr_to_physmap(page->paddr())) +
                                      (static_cast<uint64_t>(slot_start) * kSlotSize));
     }
-    // Reference to the page being used by this allocation.
-    vm_page_t* page = nullptr;
+    // Base address of the raw data.
+    void* data() const {
+      return reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(slot_base()) + kItemTagSize);
+    }
+    union {
+      // Reference to the page being used by this allocation, valid for owners.
+      vm_page_t* page = nullptr;
+      // The allocation that owns the data, valid for aliases.
+      Allocation* owner;
+    };
     // Offset of the start slot in the page, zero indexed.
     uint8_t slot_start = 0;
     // Number of slots referenced by this data. By definition zero sized data may not be stored,
@@ -106,6 +137,10 @@ class VmSlotPageStorage final : public VmCompressedStorage {
     uint8_t num_slots = 0;
     // Amount of data stored in the last slot. This is between [1, kSlotSize)
     uint8_t last_slot_bytes = 0;
+    // Number of references, the owner's own plus those of any aliases, using the data of an owner.
+    // This fits in what would otherwise be padding, and so limits how many times data may be
+    // shared.
+    uint8_t users = 0;
     // As we're using 8-bit values, ensure that a slot index or offset will not overflow.
     static_assert(kNumSlotBits <= 8);
     static_assert(kSlotSizeBits <= 8);
@@ -121,6 +156,25 @@ class VmSlotPageStorage final : public VmCompressedStorage {
         allocator_.IdToObject(ref.value() >> CompressedRef::kAlignBits));
   }
   InternalMemoryUsage GetInternalMemoryUsageLocked() const TA_REQ(lock_);
+  // Frees the allocation for |ref|, returning its page if the page is now completely unused and
+  // should be given back to the pmm.
+  vm_page_t* FreeLocked(CompressedRef ref) TA_REQ(lock_);
+  // Drops a user of the owning allocation |data|, freeing its slots once there are no users left.
+  // Returns a page to give back to the pmm, as for |FreeLocked|.
+  vm_page_t* ReleaseOwnerLocked(Allocation* data) TA_REQ(lock_);
+  // Returns the allocation that holds the data for |alloc|.
+  static const Allocation* DataOwner(const Allocation* alloc) {
+    return alloc->is_alias() ? alloc->owner : alloc;
+  }
+  static Allocation* DataOwner(Allocation* alloc) {
+    return alloc->is_alias() ? alloc->owner : alloc;
+  }
+  // Whether enough of the storage pages are unused that compacting is worthwhile.
+  bool IsFragmentedLocked() const TA_REQ(lock_);
+  // Moves every item out of |page|, which must not be in any of the |max_contig_remain_| lists,
+  // into pages that are more densely used. Returns whether |page| was emptied, otherwise |page| is
+  // placed back in the correct list.
+  bool EvacuatePageLocked(vm_page_t* page) TA_REQ(lock_);
 
   fbl::Canary<fbl::magic("SPS_")> canary_;
 
@@ -145,6 +199,18 @@ class VmSlotPageStorage final : public VmCompressedStorage {
   // Informational counters not required for operation, but used to provide statistics.
   size_t stored_items_ TA_GUARDED(lock_) = 0;
   size_t total_compressed_item_size_ TA_GUARDED(lock_) = 0;
+  size_t shared_items_ TA_GUARDED(lock_) = 0;
+
+  // Number of pages, and the number of slots in those pages, used to store items. Used to decide if
+  // compaction is worthwhile without walking the page lists.
+  size_t storage_pages_ TA_GUARDED(lock_) = 0;
+  size_t used_slots_ TA_GUARDED(lock_) = 0;
+
+  // Number of |CompressedData| results that have not yet been released. Compaction does not move
+  // any data while this is non-zero.
+  mutable size_t readers_ TA_GUARDED(lock_) = 0;
+
+  CompactionStats compaction_stats_ TA_GUARDED(lock_);
 };
 
 #endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_SLOT_PAGE_STORAGE_H_
@@ -650,6 +650,15 @@ class VmAddressRegion final : public VmAddressRegionOrMapping {
     DontNeed,
     AlwaysNeed,
     Prefetch,
+    // Sets the maximum number of pages, passed as a uint32_t in the buffer, that a single page
+    // fault in any mapping in the range may map by growing its fault-around window. Kernel
+    // internal: it has no ZX_VMAR_OP_* value until one is allocated in the public ABI.
+    SetFaultAround,
+    // Fills the buffer, a bitmap of uint64_t words with one bit per page of the range, with the
+    // pages written to since they were mapped or last harvested, and resets that record. Writes
+    // are recorded by the page tables, so this is only supported where they record them. Kernel
+    // internal, like SetFaultAround.
+    HarvestDirty,
   };
 
   // Apply |op| to VMO mappings in the specified range of pages.
@@ -710,6 +719,11 @@ class VmAddressRegion final : public VmAddressRegionOrMapping {
   // returned.
   zx_status_t EnumerateChildren(VmEnumerator* ve) TA_EXCL(lock());
 
+  // Number of regions and mappings EnumerateChildren yields to the VmEnumerator between drops of
+  // the lock, so that enumerating a large aspace does not hold off page faults for its whole
+  // duration.
+  static constexpr size_t kEnumerateChunkSize = 64;
+
  protected:
   friend class VmAspace;
   friend lazy_init::Access;
@@ -1053,12 +1067,18 @@ class VmMapping final : public VmAddressRegionOrMapping {
   // and try again. In addition to a status this returns how many pages got mapped in.
   // If ZX_OK is returned then the number of pages mapped in is guaranteed to be >0.
   // If |additional_pages| was non-zero, then the maximum number of pages that will be mapped is
-  // |additional_pages + 1|. Otherwise the maximum number of pages that will be mapped is
-  // kPageFaultMaxOptimisticPages.
+  // |additional_pages + 1|. Otherwise the maximum number of pages that will be mapped is the
+  // current fault-around window, which starts at kPageFaultMaxOptimisticPages and grows for
+  // sequential faults up to the limit given to SetFaultAroundLocked.
   ktl::pair<zx_status_t, uint32_t> PageFaultLocked(vaddr_t va, uint pf_flags,
                                                    size_t additional_pages,
                                                    MultiPageRequest* page_request) TA_REQ(lock());
 
+  // Sets the maximum number of pages, including the faulting page, that a single page fault in
+  // this mapping may map by growing its fault-around window. A value of 1 disables optimistically
+  // mapping any additional pages. Must be between 1 and kPageFaultMaxFaultAroundPages.
+  void SetFaultAroundLocked(uint32_t max_pages) TA_REQ(lock());
+
   // Apis intended for use by VmObject
 
   // |assert_object_lock| exists to satisfy clang capability analysis since there are circumstances
@@ -1127,6 +1147,11 @@ class VmMapping final : public VmAddressRegionOrMapping {
   // This is defined and exposed here for the purposes of unittests.
   static constexpr uint64_t kPageFaultMaxOptimisticPages = 16;
 
+  // The default, and largest settable, limit that sequential page faults can grow the fault-around
+  // window to.
+  static constexpr uint32_t kPageFaultDefaultFaultAroundPages = 64;
+  static constexpr uint32_t kPageFaultMaxFaultAroundPages = 256;
+
   // WAVL tree key function
   // For use in WAVL tree code only.
   VmObject::MappingTreeTraits::Key GetKey() const TA_NO_THREAD_SAFETY_ANALYSIS {
@@ -1241,6 +1266,17 @@ class VmMapping final : public VmAddressRegionOrMapping {
   // does not have permission to.
   bool private_clone_ TA_GUARDED(lock()) = false;
 
+  // Whether any part of this mapping has ever been mapped with a large page, in which case faults
+  // must take care to split any large page that they would otherwise attempt to map over.
+  bool large_pages_mapped_ TA_GUARDED(lock()) = false;
+
+  // Adaptive fault-around state. A fault at |fault_around_next_|, i.e. immediately after the range
+  // mapped by the previous fault, is considered sequential and doubles |fault_around_pages_| up to
+  // |fault_around_max_pages_|. Any other fault resets the window to kPageFaultMaxOptimisticPages.
+  vaddr_t fault_around_next_ TA_GUARDED(lock()) = 0;
+  uint32_t fault_around_pages_ TA_GUARDED(lock()) = kPageFaultMaxOptimisticPages;
+  uint32_t fault_around_max_pages_ TA_GUARDED(lock()) = kPageFaultDefaultFaultAroundPages;
+
   fbl::WAVLTreeNodeState<VmMapping*> vmo_mapping_node_ TA_GUARDED(object_->lock());
   VmMappingSubtreeState mapping_subtree_state_ TA_GUARDED(object_->lock());
 
@@ -1280,7 +1316,9 @@ class VmMapping final : public VmAddressRegionOrMapping {
 // to the callbacks as |guard|. A callback is permitted to temporarily drop the lock, using
 // |CallUnlocked|, although doing so invalidates the pointers and to use them without the lock held,
 // of after it is reacquired, they should first be turned into a RefPtr, with the caveat that they
-// might now refer to a dead, aka unmapped, object.
+// might now refer to a dead, aka unmapped, object. The traversal itself also drops the lock between
+// callbacks every VmAddressRegion::kEnumerateChunkSize objects, so the tree may change between any
+// two callbacks; see VmAddressRegionEnumerator for what is then guaranteed to be visited.
 class VmEnumerator {
  public:
   // |depth| will be 0 for the root VmAddressRegion.
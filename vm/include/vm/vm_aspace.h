@@ -20,6 +20,7 @@
 #include <fbl/ref_ptr.h>
 #include <kernel/lockdep.h>
 #include <kernel/mutex.h>
+#include <ktl/array.h>
 #include <vm/arch_vm_aspace.h>
 #include <vm/attribution.h>
 #include <vm/vm.h>
@@ -131,11 +132,19 @@ class VmAspace : public fbl::DoublyLinkedListable<VmAspace*>, public fbl::RefCou
   // passed in action. This requires holding the aspaces_list_lock_ over the entire duration and
   // whilst not a commonly used lock this function should still only be called infrequently to
   // avoid monopolizing the lock.
+  //
+  // Page tables are reclaimed incrementally: a harvest with NonTerminalAction::FreeUnaccessed only
+  // frees the unaccessed page tables of the next of kPageTableReclaimSlices equal slices of each
+  // aspace, and retains those of the rest.
   using NonTerminalAction = ArchVmAspace::NonTerminalAction;
   using TerminalAction = ArchVmAspace::TerminalAction;
   static void HarvestAllUserAccessedBits(NonTerminalAction non_terminal_action,
                                          TerminalAction terminal_action);
 
+  // Number of slices each aspace is divided into for page table reclamation, see
+  // HarvestAllUserAccessedBits.
+  static constexpr uint32_t kPageTableReclaimSlices = 4;
+
   // A collection of memory usage counts.
   struct vm_usage_t {
     // A count of bytes covered by VmMapping ranges.
@@ -315,14 +324,28 @@ class VmAspace : public fbl::DoublyLinkedListable<VmAspace*>, public fbl::RefCou
 
   mutable DECLARE_CRITICAL_MUTEX(VmAspace) lock_;
 
-  // Keep a cache of the VmMapping of the last PageFault that occurred. On a page fault this can
-  // be checked to see if it matches more quickly than walking the full vmar tree. Mappings that
-  // are stored here must be in the ALIVE state, implying that they are in the VMAR tree. It is
-  // then the responsibility of the VmMapping to remove itself from here should it transition out
-  // of ALIVE, and remove itself from the VMAR tree. A raw pointer is stored here since the
-  // VmMapping must be alive and in tree anyway and if it were a RefPtr we would not be able to
-  // handle being the one to drop the last ref and perform destruction.
-  VmMapping* last_fault_ TA_GUARDED(lock_) = nullptr;
+  // Keep a cache of the VmMappings of the most recent PageFaults. On a page fault these can be
+  // checked to see if one matches more quickly than walking the full vmar tree, which shortens the
+  // time the aspace lock is held. Several entries are kept so that threads of a process faulting on
+  // their own stacks and heap arenas do not keep evicting each other's mapping. Mappings that are
+  // stored here must be in the ALIVE state, implying that they are in the VMAR tree. It is then the
+  // responsibility of the VmMapping to remove itself from here, with ForgetFaultMappingLocked,
+  // should it transition out of ALIVE, and remove itself from the VMAR tree. Raw pointers are
+  // stored here since the VmMapping must be alive and in tree anyway and if it were a RefPtr we
+  // would not be able to handle being the one to drop the last ref and perform destruction.
+  static constexpr size_t kFaultCacheSize = 4;
+  ktl::array<VmMapping*, kFaultCacheSize> fault_cache_ TA_GUARDED(lock_) = {};
+  // Index of the entry that the next cache miss replaces.
+  size_t fault_cache_next_ TA_GUARDED(lock_) = 0;
+
+  // Removes |mapping| from the fault cache if present.
+  void ForgetFaultMappingLocked(const VmMapping* mapping) TA_REQ(lock_) {
+    for (VmMapping*& entry : fault_cache_) {
+      if (entry == mapping) {
+        entry = nullptr;
+      }
+    }
+  }
 
   // root of virtual address space
   // Access to this reference is guarded by lock_.
@@ -340,11 +363,14 @@ class VmAspace : public fbl::DoublyLinkedListable<VmAspace*>, public fbl::RefCou
   fbl::RefPtr<VmMapping> vdso_code_mapping_ TA_GUARDED(lock_);
 
   // The number of page table reclamations attempted since last active. This is used since we need
-  // to perform pt reclamation twice in a row (once to clear accessed bits, another time to
-  // reclaim page tables) before the aspace is at a fixed point and we can actually stop
+  // to perform pt reclamation twice in a row on every slice (once to clear accessed bits, another
+  // time to reclaim page tables) before the aspace is at a fixed point and we can actually stop
   // performing the harvests.
   uint32_t pt_harvest_since_active_ TA_GUARDED(AspaceListLock::Get()) = 0;
 
+  // The slice whose page tables the next page table reclamation will free.
+  uint32_t pt_reclaim_slice_ TA_GUARDED(AspaceListLock::Get()) = 0;
+
   DECLARE_SINGLETON_MUTEX(AspaceListLock);
   static fbl::DoublyLinkedList<VmAspace*> aspaces_list_ TA_GUARDED(AspaceListLock::Get());
 
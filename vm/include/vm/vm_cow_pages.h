@@ -683,11 +683,46 @@ class VmCowPages final : public fbl::ContainableBaseClasses<
   // marker put in its place.
   bool DedupZeroPage(vm_page_t* page, uint64_t offset);
 
+  // Attempts to merge the given page at the specified offset with an identical page held by the
+  // compression system, see |VmCompression::Dedup|. Has the same correctness requirements as
+  // |DedupZeroPage|, and returns false under the same conditions, as well as if
+  //  * this is not an anonymous VMO
+  //  * there is no compression system, or it does not have deduplication enabled
+  //  * no identical page is stored
+  // Otherwise 'true' is returned and the page will have been returned to the pmm with a reference
+  // to the shared copy put in its place.
+  bool DedupPage(vm_page_t* page, uint64_t offset);
+
+  // Attempts to commit the large page aligned |range|, which must be exactly
+  // PmmNode::kLargePageSize in length, with a single physically contiguous large page of zeroed
+  // pages, returning the physical address of the first page in |pa|. This is only supported for
+  // anonymous VMOs that have no parent and no content in the range, and otherwise returns
+  // ZX_ERR_NOT_SUPPORTED. As large pages are opportunistic, this returns ZX_ERR_NOT_FOUND if one
+  // could not be allocated without waiting, and the caller should fall back to committing single
+  // pages.
+  zx_status_t CommitLargePageLocked(VmCowRange range, DeferredOps& deferred, paddr_t* pa)
+      TA_REQ(lock());
+
+  // Checks whether the large page aligned |range|, which must be exactly PmmNode::kLargePageSize
+  // in length, is fully committed in this anonymous VMO with pages that are physically contiguous
+  // and aligned such that they can be mapped as a single large page, returning the physical address
+  // of the first page in |pa| if so. The pages are all owned by this VMO and so may be mapped
+  // writable.
+  bool LookupLargePageLocked(VmCowRange range, paddr_t* pa) const TA_REQ(lock());
+
   void DumpLocked(uint depth, bool verbose) const TA_REQ(lock());
 
   // see VmObject::DebugLookupDepth
   uint32_t DebugLookupDepthLocked() const TA_REQ(lock());
 
+  // Number of ancestors a content lookup must search before it is counted in vm.cow.lookup.deep.
+  static constexpr uint32_t kDeepLookupDepth = 8;
+
+  // Largest range that commit and decommit operations process under a single acquisition of the
+  // lock. Larger ranges are split up so that other users of the VMO are not stalled for the whole
+  // operation.
+  static constexpr uint64_t kMaxRangeOpChunkSize = 32ul * 1024 * 1024;
+
   // VMO_VALIDATION
   bool DebugValidatePageSharingLocked() const TA_REQ(lock());
   bool DebugValidateBacklinksLocked() const TA_REQ(lock());
@@ -810,6 +845,15 @@ class VmCowPages final : public fbl::ContainableBaseClasses<
   };
   DiscardablePageCounts DebugGetDiscardablePageCounts() const TA_EXCL(lock());
 
+  // Returns the number of pages that discarding this VMO would free, provided it is discardable,
+  // currently reclaimable and was last unlocked before |unlocked_before|. Returns zero otherwise.
+  uint64_t IdleDiscardablePages(zx_instant_mono_t unlocked_before) const TA_EXCL(lock());
+
+  // Discards all pages of this VMO if it is still reclaimable and was last unlocked before
+  // |unlocked_before|, returning the number of pages freed. The freed pages are returned to the PMM
+  // after the lock has been dropped.
+  zx::result<uint64_t> DiscardIfIdle(zx_instant_mono_t unlocked_before) TA_EXCL(lock());
+
   // Returns the parent of this cow pages, may be null. Generally the parent should never be
   // directly accessed externally, but this exposed specifically for tests.
   fbl::RefPtr<VmCowPages> DebugGetParent();
@@ -829,6 +873,11 @@ class VmCowPages final : public fbl::ContainableBaseClasses<
   VmCowPages::ReclaimCounts ReclaimPageForEviction(vm_page_t* page, uint64_t offset,
                                                    EvictionAction eviction_action);
 
+  // Consumes any shadow entry left by evicting |offset| and accounts for the refault. The size of
+  // the active set is computed into |active_pages| on first use, so that it can be shared across a
+  // batch of supplied pages.
+  void CheckRefaultLocked(uint64_t offset, ktl::optional<uint64_t>* active_pages) TA_REQ(lock());
+
   // Potentially transitions from Alive->Dead if the cow pages is unreachable (i.e. has no
   // paged_ref_ and no children). Used by the VmObjectPaged when it unlinks the paged_ref_, but
   // prior to dropping the RefPtr, giving the VmCowPages a chance to transition.
@@ -1121,6 +1170,14 @@ class VmCowPages final : public fbl::ContainableBaseClasses<
   zx_status_t ReplaceReferenceWithPageLocked(VmPageOrMarkerRef page_or_mark, uint64_t offset,
                                              AnonymousPageRequest* page_request) TA_REQ(lock());
 
+  // Opportunistically replaces up to |max_pages| contiguous References, starting at |cursor| which
+  // is at |offset| in this page_list_, with real vm_page_ts, as if by
+  // ReplaceReferenceWithPageLocked. Stops at the first slot that is not a Reference, or if a page
+  // cannot be allocated without waiting. The References are decompressed with a single
+  // VmCompression::DecompressBatch. Returns the number of References that were replaced.
+  uint PrefetchReferencesLocked(VMPLCursor cursor, uint64_t offset, uint max_pages)
+      TA_REQ(lock());
+
   zx_status_t AllocateCopyPage(paddr_t parent_paddr, list_node_t* alloc_list,
                                AnonymousPageRequest* request, vm_page_t** clone);
 
@@ -1667,6 +1724,17 @@ class VmCowPages final : public fbl::ContainableBaseClasses<
   // a tree of pages
   VmPageList page_list_ TA_GUARDED(lock());
 
+  // The result of the last GetAttributedMemoryInRangeLocked query. This is only filled in, and
+  // only consulted, while there is no parent_, as then the attribution depends solely on the
+  // content of |page_list_| and remains valid for as long as its generation is unchanged.
+  struct CachedAttribution {
+    VmCowRange range;
+    uint64_t generation = 0;
+    AttributionCounts counts;
+    bool valid = false;
+  };
+  mutable CachedAttribution cached_attribution_ TA_GUARDED(lock());
+
   // Reference back to a VmObjectPaged, which should be valid at all times after creation until the
   // VmObjectPaged has been destroyed, unless this is a hidden node. We use this in places where we
   // have access to the VmCowPages and need to look up the "owning" VmObjectPaged for some
@@ -2004,8 +2072,12 @@ class VmCowPages::LookupCursor {
                                                            AnonymousPageRequest* page_request)
       TA_REQ(lock());
 
-  // Attempts to turn the current cursor, which must be a reference, into a page.
-  zx_status_t CursorReferenceToPage(AnonymousPageRequest* page_request) TA_REQ(lock());
+  // Attempts to turn the current cursor, which must be a reference, into a page. On success any
+  // References immediately following the cursor in the owner, up to a total of
+  // |max_request_pages|, are also turned into pages on the assumption that they will be accessed
+  // next.
+  zx_status_t CursorReferenceToPage(uint max_request_pages, AnonymousPageRequest* page_request)
+      TA_REQ(lock());
 
   // Helpers for generating read or dirty requests for the given maximal range.
   zx_status_t ReadRequest(uint max_request_pages, PageRequest* page_request) TA_REQ(lock());
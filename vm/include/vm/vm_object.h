@@ -30,6 +30,7 @@
 #include <fbl/ref_ptr.h>
 #include <kernel/lockdep.h>
 #include <kernel/mutex.h>
+#include <ktl/span.h>
 #include <ktl/utility.h>
 #include <vm/attribution.h>
 #include <vm/content_size_manager.h>
@@ -79,6 +80,21 @@ enum class SupplyOptions : uint8_t {
   PhysicalPageProvider,
 };
 
+// One range of a batched supply, see VmObject::SupplyPagesMany.
+struct SupplyRange {
+  uint64_t offset;
+  uint64_t len;
+  VmPageSpliceList* pages;
+};
+
+// One range of a batched user read or write, see VmObject::ReadUserRanges. |len| bytes at |offset|
+// in the VMO are transferred to or from the user address |buffer|.
+struct UserCopyRange {
+  uint64_t offset;
+  uint64_t len;
+  void* buffer;
+};
+
 namespace internal {
 struct ChildListTag {};
 struct GlobalListTag {};
@@ -406,6 +422,17 @@ class VmObject : public fbl::ContainableBaseClasses<
     return {ZX_ERR_NOT_SUPPORTED, 0};
   }
 
+  // Batched forms of ReadUser and WriteUser that transfer each of |ranges|, in order, between the
+  // VMO and the user buffer of that range. The lock is held from one range to the next and is only
+  // dropped to wait on a page request, handle a fault or let a contending thread in. As with
+  // ReadUser, the total number of bytes transferred is returned even upon error.
+  virtual ktl::pair<zx_status_t, size_t> ReadUserRanges(ktl::span<const UserCopyRange> ranges) {
+    return {ZX_ERR_NOT_SUPPORTED, 0};
+  }
+  virtual ktl::pair<zx_status_t, size_t> WriteUserRanges(ktl::span<const UserCopyRange> ranges) {
+    return {ZX_ERR_NOT_SUPPORTED, 0};
+  }
+
   // Removes the pages from this vmo in the range [offset, offset + len) and returns
   // them in pages.  This vmo must be a paged vmo with no parent, and it cannot have any
   // pinned pages in the source range. |offset| and |len| must be page aligned.
@@ -423,6 +450,15 @@ class VmObject : public fbl::ContainableBaseClasses<
     return ZX_ERR_NOT_SUPPORTED;
   }
 
+  // Batched form of SupplyPages that supplies each of |ranges|, in order, from its own splice list.
+  // The lock is acquired once for the whole batch, and is only dropped if a page request must be
+  // waited on. The ranges must not overlap. ZX_ERR_OUT_OF_RANGE is returned without supplying
+  // anything if any range is out of bounds; on any other error the ranges before the failing one
+  // have been supplied.
+  virtual zx_status_t SupplyPagesMany(ktl::span<const SupplyRange> ranges, SupplyOptions options) {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+
   // Indicates that page requests in the range [offset, offset + len) could not be fulfilled.
   // |error_status| specifies the error encountered. |offset| and |len| must be page aligned.
   virtual zx_status_t FailPageRequests(uint64_t offset, uint64_t len, zx_status_t error_status) {
@@ -221,6 +221,8 @@ class VmObjectPaged final : public VmObject, public VmDeferredDeleter<VmObjectPa
   ktl::pair<zx_status_t, size_t> WriteUser(
       user_in_ptr<const char> ptr, uint64_t offset, size_t len, VmObjectReadWriteOptions options,
       const OnWriteBytesTransferredCallback& on_bytes_transferred) override;
+  ktl::pair<zx_status_t, size_t> ReadUserRanges(ktl::span<const UserCopyRange> ranges) override;
+  ktl::pair<zx_status_t, size_t> WriteUserRanges(ktl::span<const UserCopyRange> ranges) override;
   ktl::pair<zx_status_t, size_t> ReadUserVector(user_out_iovec_t vec, uint64_t offset, size_t len);
   ktl::pair<zx_status_t, size_t> WriteUserVector(
       user_in_iovec_t vec, uint64_t offset, size_t len,
@@ -229,6 +231,7 @@ class VmObjectPaged final : public VmObject, public VmDeferredDeleter<VmObjectPa
   zx_status_t TakePages(uint64_t offset, uint64_t len, VmPageSpliceList* pages) override;
   zx_status_t SupplyPages(uint64_t offset, uint64_t len, VmPageSpliceList* pages,
                           SupplyOptions options) override;
+  zx_status_t SupplyPagesMany(ktl::span<const SupplyRange> ranges, SupplyOptions options) override;
   zx_status_t FailPageRequests(uint64_t offset, uint64_t len, zx_status_t error_status) override {
     Guard<CriticalMutex> guard{lock()};
     if (auto cow_range = GetCowRange(offset, len)) {
@@ -302,6 +305,26 @@ class VmObjectPaged final : public VmObject, public VmDeferredDeleter<VmObjectPa
     return zx::error{ZX_ERR_OUT_OF_RANGE};
   }
 
+  // Large page helpers for the range at |offset| of length PmmNode::kLargePageSize, which must be
+  // aligned in both this VMO and the underlying VmCowPages.
+  //
+  // See |VmCowPages::CommitLargePageLocked| and |VmCowPages::LookupLargePageLocked|.
+  zx_status_t CommitLargePageLocked(uint64_t offset, VmCowPages::DeferredOps& deferred,
+                                    paddr_t* pa) TA_REQ(lock()) {
+    auto cow_range = GetCowRangeSizeCheckLocked(offset, PmmNode::kLargePageSize);
+    if (!cow_range || cow_range->offset % PmmNode::kLargePageSize != 0) {
+      return ZX_ERR_NOT_SUPPORTED;
+    }
+    return cow_pages_locked()->CommitLargePageLocked(*cow_range, deferred, pa);
+  }
+  bool LookupLargePageLocked(uint64_t offset, paddr_t* pa) TA_REQ(lock()) {
+    auto cow_range = GetCowRangeSizeCheckLocked(offset, PmmNode::kLargePageSize);
+    if (!cow_range || cow_range->offset % PmmNode::kLargePageSize != 0) {
+      return false;
+    }
+    return cow_pages_locked()->LookupLargePageLocked(*cow_range, pa);
+  }
+
   zx_status_t CreateClone(Resizability resizable, SnapshotType type, uint64_t offset, uint64_t size,
                           bool copy_name, fbl::RefPtr<VmObject>* child_vmo) override;
 
@@ -379,6 +402,14 @@ class VmObjectPaged final : public VmObject, public VmDeferredDeleter<VmObjectPa
   // require one.
   VmCowPages::DeferredOps MakeDeferredOps() { return VmCowPages::DeferredOps(cow_pages_.get()); }
 
+  // Returns the VmCowPages holding the content at |offset| in this VMO and the offset of that
+  // content in it. VMOs that reference the same pages, such as reference children and slices,
+  // return the same pair for the same content. The VmCowPages may be destroyed once the caller
+  // drops its reference to this VMO, so the pointer is only suitable as an identity.
+  ktl::pair<const VmCowPages*, uint64_t> GetCowPagesAndOffset(uint64_t offset) const {
+    return {cow_pages_.get(), offset + cow_range_.offset};
+  }
+
  private:
   // private constructor (use Create())
   VmObjectPaged(uint32_t options, fbl::RefPtr<VmCowPages> cow_pages);
@@ -417,6 +448,18 @@ class VmObjectPaged final : public VmObject, public VmDeferredDeleter<VmObjectPa
   template <typename T>
   ktl::pair<zx_status_t, size_t> ReadWriteInternal(uint64_t offset, size_t len, bool write,
                                                    VmObjectReadWriteOptions options, T copyfunc);
+  template <typename T>
+  ktl::pair<zx_status_t, size_t> ReadWriteRangesInternal(ktl::span<const UserCopyRange> ranges,
+                                                         bool write,
+                                                         VmObjectReadWriteOptions options,
+                                                         T copyfunc);
+
+  // Fast path for small reads into user memory of content that is already resident. The pages are
+  // copied into a bounce buffer with the lock held and then copied out to |ptr| after the lock is
+  // dropped, so that concurrent readers hold the lock only for the memcpy and never across a user
+  // copy. Returns ZX_ERR_NEXT if the read must instead take the regular path, in which case some of
+  // |ptr| may already have been written.
+  zx_status_t TryReadUserResident(user_out_ptr<char> ptr, uint64_t offset, size_t len);
 
   // Zeroes a partial range in a page. The page to zero is looked up using page_base_offset, and
   // will be committed if needed. The range of [zero_start_offset, zero_end_offset) is relative to
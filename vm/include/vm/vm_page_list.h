@@ -74,6 +74,7 @@ class VmPageOrMarker {
     // sync with the private VmPageOrMarker::kTypeBits.
     static constexpr int kAlignBits = 3;
 
+    constexpr ReferenceValue() = default;
     explicit constexpr ReferenceValue(uint32_t raw) : value_(raw) {
       DEBUG_ASSERT((value_ & BIT_MASK32(kAlignBits)) == 0);
     }
@@ -81,7 +82,7 @@ class VmPageOrMarker {
     uint32_t value() const { return value_; }
 
    private:
-    uint32_t value_;
+    uint32_t value_ = 0;
   };
 
   // Returns a reference to the underlying vm_page*. Is only valid to call if `IsPage` is true.
@@ -798,6 +799,12 @@ class VmPageList final {
   }
   uint64_t GetSkew() const { return list_skew_; }
 
+  // Returns a value that changes whenever the content of the list may have been modified, i.e. on
+  // any call to a non-const method. This lets callers cache information derived from the list and
+  // cheaply check whether it is still valid. Spurious changes are possible, for example a mutable
+  // lookup that did not end up modifying the slot, but a modification is never missed.
+  uint64_t generation() const { return generation_; }
+
   DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(VmPageList);
 
   // walk the page tree, calling the passed in function on every tree node.
@@ -810,6 +817,7 @@ class VmPageList final {
   // a const VmPageOrMarker*, allowing for limited mutation.
   template <typename F>
   zx_status_t ForEveryPageMutable(F per_page_func) {
+    generation_++;
     return ForEveryPage<VmPageOrMarkerRef>(this, per_page_func);
   }
 
@@ -838,6 +846,7 @@ class VmPageList final {
   template <typename F>
   zx_status_t ForEveryPageInRangeMutable(F per_page_func, uint64_t start_offset,
                                          uint64_t end_offset) {
+    generation_++;
     return ForEveryPageInRange<VmPageOrMarkerRef>(this, per_page_func, start_offset, end_offset);
   }
 
@@ -852,6 +861,7 @@ class VmPageList final {
   template <typename PAGE_FUNC, typename GAP_FUNC>
   zx_status_t ForEveryPageAndGapInRangeMutable(PAGE_FUNC per_page_func, GAP_FUNC per_gap_func,
                                                uint64_t start_offset, uint64_t end_offset) {
+    generation_++;
     return ForEveryPageAndGapInRange<VmPageOrMarkerRef>(this, per_page_func, per_gap_func,
                                                         start_offset, end_offset);
   }
@@ -923,9 +933,8 @@ class VmPageList final {
   // is returned it may still be the case that IsEmpty() on the returned PageOrMarker is true.
   const VmPageOrMarker* Lookup(uint64_t offset) const {
     // lookup the tree node that holds this offset
-    NodeList::const_iterator pln = list_.find(NodeOffset(offset));
-
-    if (!pln.IsValid()) {
+    const VmPageListNode* pln = FindNode(NodeOffset(offset));
+    if (!pln) {
       return nullptr;
     }
     return &pln->Lookup(NodeIndex(offset));
@@ -934,9 +943,10 @@ class VmPageList final {
   // Similar to `Lookup` but returns a VmPageOrMarkerRef that allows for limited mutation of the
   // slot. General mutation requires calling `LookupOrAllocate`.
   VmPageOrMarkerRef LookupMutable(uint64_t offset) {
+    generation_++;
     // lookup the tree node that holds this offset
-    NodeList::iterator pln = list_.find(NodeOffset(offset));
-    if (!pln.IsValid()) {
+    VmPageListNode* pln = FindNode(NodeOffset(offset));
+    if (!pln) {
       return VmPageOrMarkerRef(nullptr);
     }
     return VmPageOrMarkerRef(&pln->Lookup(NodeIndex(offset)));
@@ -945,6 +955,7 @@ class VmPageList final {
   // Similar to `LookupMutable` but returns a VMPLCursor that allows for iterating over any
   // contiguous slots from the provided offset.
   VMPLCursor LookupMutableCursor(uint64_t offset) {
+    generation_++;
     // lookup the tree node that holds this offset
     NodeList::iterator pln = list_.find(NodeOffset(offset));
     if (!pln.IsValid()) {
@@ -956,6 +967,7 @@ class VmPageList final {
   // Similar to `LookupMutableCursor` but does a lower_bound search instead of a find, returning the
   // first slot >= offset, if any exists.
   VMPLCursor LookupNearestMutableCursor(uint64_t offset) {
+    generation_++;
     // lookup the tree node that holds this offset or a larger one.
     const uint64_t node_offset = NodeOffset(offset);
     NodeList::iterator pln = list_.lower_bound(node_offset);
@@ -998,6 +1010,7 @@ class VmPageList final {
   //  comments near LookupOrAllocateCheckForInterval for an explanation of how splitting works.)
   ktl::pair<VmPageOrMarker*, bool> LookupOrAllocate(uint64_t offset,
                                                     IntervalHandling interval_handling) {
+    generation_++;
     switch (interval_handling) {
       case IntervalHandling::NoIntervals:
         // The page list does not expect any intervals. Short circuit any checks for intervals.
@@ -1028,6 +1041,7 @@ class VmPageList final {
   // ownership. Any markers are cleared.
   template <typename T>
   void RemoveAllContent(T free_content_fn) {
+    generation_++;
     // per page get a reference to the page pointer inside the page list node
     auto per_page_func = [&free_content_fn](VmPageOrMarker* p, uint64_t offset) {
       if (p->IsPageOrRef()) {
@@ -1042,6 +1056,7 @@ class VmPageList final {
 
     // empty the tree
     list_.clear();
+    lookup_hint_ = nullptr;
   }
 
   // Calls the provided callback for every page or marker in the range [start_offset, end_offset).
@@ -1051,6 +1066,7 @@ class VmPageList final {
   // longer needed.
   template <typename T>
   zx_status_t RemovePages(T per_page_fn, uint64_t start_offset, uint64_t end_offset) {
+    generation_++;
     return ForEveryPageInRange<VmPageOrMarker*, NodeCheck::CleanupEmpty>(this, per_page_fn,
                                                                          start_offset, end_offset);
   }
@@ -1062,6 +1078,7 @@ class VmPageList final {
   template <typename P, typename G>
   zx_status_t RemovePagesAndIterateGaps(P per_page_fn, G per_gap_fn, uint64_t start_offset,
                                         uint64_t end_offset) {
+    generation_++;
     return ForEveryPageAndGapInRange<VmPageOrMarker*, NodeCheck::CleanupEmpty>(
         this, per_page_fn, per_gap_fn, start_offset, end_offset);
   }
@@ -1086,6 +1103,8 @@ class VmPageList final {
   template <typename F>
   void MergeRangeOntoAndClear(F migrate_fn, VmPageList& other, uint64_t offset,
                               uint64_t end_offset) {
+    generation_++;
+    other.generation_++;
     // The skewed |offset| in |this| must be equal to 0 skewed in |other|. This allows
     // nodes to moved directly between the lists, without having to worry about allocations.
     constexpr uint64_t kNodeSize = PAGE_SIZE * VmPageListNode::kPageFanOut;
@@ -1112,6 +1131,7 @@ class VmPageList final {
     for (auto iter = list_.lower_bound(ROUNDDOWN(skewed_offset, kNodeSize));
          iter && iter->offset() < skewed_end_offset;) {
       __UNINITIALIZED ktl::unique_ptr<VmPageListNode> node = list_.erase(iter++);
+      ForgetNode(node.get());
       DEBUG_ASSERT(node->HasNoIntervalSentinel());
       // Trim start/end slots that are not in the range, make sure that the node does not end up
       // completely empty.
@@ -1147,6 +1167,7 @@ class VmPageList final {
         auto prev = cur_other++;
         // If prev was empty after migrating then remove it now that we have found the next node.
         if (prev->IsEmpty()) {
+          other.ForgetNode(&*prev);
           other.list_.erase(prev);
         }
       } else {
@@ -1171,6 +1192,7 @@ class VmPageList final {
       }
     }
     list_.clear();
+    lookup_hint_ = nullptr;
   }
 
   // Takes the content out of this page list and places them in the provided |splice| list, which
@@ -1194,6 +1216,8 @@ class VmPageList final {
   template <typename F>
   zx_status_t MoveRange(F on_migrate_fn, VmPageList& other, uint64_t offset, uint64_t end_offset) {
     DEBUG_ASSERT(other.IsEmpty());
+    generation_++;
+    other.generation_++;
     // The skewed |offset| in |this| must be equal to 0 skewed in |other|. This allows
     // nodes to moved directly between the lists, without having to worry about allocations.
     constexpr uint64_t kNodeSize = PAGE_SIZE * VmPageListNode::kPageFanOut;
@@ -1247,6 +1271,7 @@ class VmPageList final {
         // empty, which would be an invalid state.
         DEBUG_ASSERT(!(src_empty && target_empty));
         if (src_empty) {
+          ForgetNode(&*old);
           list_.erase(*old);
         }
         if (target_empty) {
@@ -1254,6 +1279,7 @@ class VmPageList final {
         }
       } else {
         node = list_.erase(iter++);
+        ForgetNode(node.get());
         node->ForEveryPage<VmPageOrMarkerRef>(
             [&on_migrate_fn](VmPageOrMarkerRef slot, uint64_t offset) {
               on_migrate_fn(slot, offset);
@@ -1432,6 +1458,7 @@ class VmPageList final {
       auto prev = cur++;
       if constexpr (NODE_CHECK == NodeCheck::CleanupEmpty) {
         if (prev->IsEmpty()) {
+          self->ForgetNode(&*prev);
           self->list_.erase(prev);
         }
       }
@@ -1791,14 +1818,42 @@ class VmPageList final {
     return ZX_OK;
   }
 
+  // Returns the node at |node_offset|, or nullptr if there is none. The most recently found node
+  // is checked before walking the tree, as lookups tend to come in runs of neighbouring offsets
+  // that land in the same node.
+  VmPageListNode* FindNode(uint64_t node_offset) const {
+    if (lookup_hint_ && lookup_hint_->offset() == node_offset) {
+      return lookup_hint_;
+    }
+    NodeList::const_iterator pln = list_.find(node_offset);
+    if (!pln.IsValid()) {
+      return nullptr;
+    }
+    // The list owns its nodes, so dropping the const here does not grant anything that a
+    // non-const lookup could not.
+    lookup_hint_ = const_cast<VmPageListNode*>(&*pln);
+    return lookup_hint_;
+  }
+
+  // Must be called before |node| is removed from |list_|.
+  void ForgetNode(const VmPageListNode* node) {
+    if (lookup_hint_ == node) {
+      lookup_hint_ = nullptr;
+    }
+  }
+
   using NodeList = fbl::WAVLTree<uint64_t, ktl::unique_ptr<VmPageListNode>>;
   NodeList list_;
+  // Node most recently returned by FindNode, always either null or a node in |list_|.
+  mutable VmPageListNode* lookup_hint_ = nullptr;
   // A skew added to offsets provided as arguments to VmPageList functions before
   // interfacing with list_. This allows all VmPageLists within a clone tree
   // to place individual vm_page_t entries at the same offsets within their nodes, so
   // that the nodes can be moved between different lists without having to worry
   // about needing to split up a node.
   uint64_t list_skew_ = 0;
+  // Incremented on every potential modification, see generation().
+  uint64_t generation_ = 0;
 };
 
 // Class which holds the list of vm_page structs removed from a VmPageList
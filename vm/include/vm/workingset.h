@@ -0,0 +1,94 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_VM_INCLUDE_VM_WORKINGSET_H_
+#define ZIRCON_KERNEL_VM_INCLUDE_VM_WORKINGSET_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <fbl/array.h>
+#include <ktl/atomic.h>
+#include <ktl/optional.h>
+#include <ktl/unique_ptr.h>
+#include <ktl/utility.h>
+
+// Tracks recently evicted pages so that a page faulted back in soon after eviction can be
+// recognized as a refault.
+//
+// Every eviction advances an eviction clock and leaves a shadow entry, recording the clock, for
+// the evicted (object, offset). When the content is later supplied again the shadow entry is
+// consumed and the refault distance, the number of pages evicted in between, is computed. Had
+// there been that many more pages of memory the page would never have been evicted, so comparing
+// the distance against the size of the active set tells whether the page is part of the working
+// set and its eviction was a mistake.
+//
+// Shadow entries live in a fixed size hash table instead of in the page lists of the owning
+// objects, so they cost no memory per object and need no cleanup when an object is destroyed. The
+// trade off is that entries can be overwritten by colliding evictions, in which case a refault is
+// not noticed, and that an entry can outlive its object and be attributed to a new object that
+// reuses the address. Either way only the classification of a single fault is affected.
+//
+// Each shadow entry takes 8 bytes. A table should have room for a few times as many entries as
+// pages are evicted between typical refaults; with fewer, collisions hide more refaults.
+//
+// All methods are lock free and may be called with any locks held.
+class Workingset {
+ public:
+  // Creates a table of |num_shadows| shadow entries, rounded up to a power of two. Returns nullptr
+  // if |num_shadows| is zero or the table cannot be allocated.
+  static ktl::unique_ptr<Workingset> Create(size_t num_shadows);
+
+  Workingset(const Workingset&) = delete;
+  Workingset& operator=(const Workingset&) = delete;
+
+  // Number of shadow entries in the table.
+  size_t num_shadows() const { return shadows_.size(); }
+
+  // Records that the content at |offset| in |object| was evicted.
+  void RecordEviction(const void* object, uint64_t offset);
+
+  // Looks up, and consumes, the shadow entry for |offset| in |object|. Returns the refault distance
+  // if the content was recently evicted, and nullopt otherwise.
+  ktl::optional<uint32_t> TakeRefaultDistance(const void* object, uint64_t offset);
+
+  // Returns whether a refault at |distance| would have stayed resident given |active_pages| pages
+  // in the active set.
+  static bool IsWorkingsetRefault(uint32_t distance, uint64_t active_pages) {
+    return distance <= active_pages;
+  }
+
+  // The global instance used by pager backed VMOs, sized by the
+  // kernel.page-scanner.refault-shadow-entries boot option. Returns nullptr if refaults are not
+  // tracked, or before the instance is created at LK_INIT_LEVEL_VM.
+  static Workingset* Get() { return global_.load(ktl::memory_order_acquire); }
+
+  // Creates the global instance. Called once during init.
+  static void InitGlobal(size_t num_shadows);
+
+ private:
+  explicit Workingset(fbl::Array<ktl::atomic<uint64_t>> shadows) : shadows_(ktl::move(shadows)) {}
+
+  // A shadow entry packs a non-zero tag, identifying the (object, offset), in the upper half and
+  // the eviction clock in the lower half. Zero is an empty entry.
+  static constexpr uint64_t kTagShift = 32;
+
+  struct Key {
+    size_t index;
+    uint64_t tag;
+  };
+  Key MakeKey(const void* object, uint64_t offset) const;
+
+  // Count of evictions, allowed to wrap. Distances are computed modulo 2^32, which only misjudges
+  // shadow entries that have survived four billion evictions.
+  ktl::atomic<uint32_t> clock_ = 0;
+
+  fbl::Array<ktl::atomic<uint64_t>> shadows_;
+
+  static ktl::atomic<Workingset*> global_;
+};
+
+#endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_WORKINGSET_H_
@@ -0,0 +1,26 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#ifndef ZIRCON_KERNEL_VM_INCLUDE_VM_ZEROED_PAGE_POOL_H_
+#define ZIRCON_KERNEL_VM_INCLUDE_VM_ZEROED_PAGE_POOL_H_
+
+#include <vm/page.h>
+
+// A small pool of pages that have already been zeroed, kept topped up by a lowest priority kernel
+// thread so that zeroing happens when CPUs would otherwise be idle instead of in the fault path.
+//
+// Pages in the pool are allocated from the PMM in the ALLOC state, so the PMM checker validates
+// their free fill pattern as normal when they enter the pool, and fills them again when they are
+// eventually freed by whoever took them. The pool is sized by kernel.vm.zeroed-page-pool-pages and
+// is only refilled while free memory is comfortably above the pool size, so it never competes with
+// reclamation for the last free pages. It is disabled when kernel.pmm.alloc-random-should-wait is
+// set, so that faults keep exercising the PMM wait paths.
+
+// Returns a page in the ALLOC state whose contents are all zero, or nullptr if the pool is empty.
+// The caller owns the page and is responsible for initializing it for its use. Never blocks.
+vm_page_t* zeroed_page_pool_take();
+
+#endif  // ZIRCON_KERNEL_VM_INCLUDE_VM_ZEROED_PAGE_POOL_H_
@@ -9,6 +9,7 @@
 #include <inttypes.h>
 #include <lib/counters.h>
 #include <lib/fit/defer.h>
+#include <lib/instrumentation/asan.h>
 #include <lib/thread-stack/abi.h>
 #include <stdio.h>
 #include <string.h>
@@ -18,6 +19,7 @@
 #include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <fbl/ref_ptr.h>
+#include <kernel/mutex.h>
 #include <ktl/utility.h>
 #include <phys/zircon-abi-spec.h>
 #include <vm/vm.h>
@@ -45,6 +47,9 @@ struct Stack : public ZirconAbiSpec::Stack {
 };
 
 KCOUNTER(vm_kernel_stack_bytes, "vm.kstack.allocated_bytes")
+KCOUNTER(vm_kernel_stack_cache_hit, "vm.kstack.cache.hit")
+KCOUNTER(vm_kernel_stack_cache_miss, "vm.kstack.cache.miss")
+KCOUNTER(vm_kernel_stack_cache_trimmed, "vm.kstack.cache.trimmed")
 
 constexpr Stack kSafe = {"kernel-safe-stack", kMachineStack, Stack::Growth::kDown};
 #if __has_feature(safe_stack)
@@ -158,6 +163,42 @@ zx_status_t unmap(const Stack& type, KernelStack::Mapping& map) {
   return ZX_OK;
 }
 
+// Readies a cached stack mapping for use by a new thread.
+void reuse(const Stack& stack, const KernelStack::Mapping& map) {
+#if __has_feature(address_sanitizer)
+  // The previous thread may have exited with frames, and so their redzones, still on the stack.
+  asan_unpoison_shadow(map.base(), map.size());
+#endif
+  stack_canary_write(stack, reinterpret_cast<void*>(map.base()));
+}
+
+// Creating a kernel stack allocates a VMAR and commits and maps its pages, and destroying one
+// unmaps them and invalidates the TLB. Threads are created and destroyed often enough that each CPU
+// keeps a few fully mapped stacks around, so that the churn can skip both.
+constexpr size_t kStackCacheSize = 4;
+
+struct CachedStack {
+  KernelStack::Mapping main;
+#if __has_feature(safe_stack)
+  KernelStack::Mapping unsafe;
+#endif
+#if __has_feature(shadow_call_stack)
+  KernelStack::Mapping shadow_call;
+#endif
+};
+
+struct alignas(MAX_CACHE_LINE) StackCache {
+  DECLARE_MUTEX(StackCache) lock;
+  size_t count TA_GUARDED(lock) = 0;
+  CachedStack stacks[kStackCacheSize] TA_GUARDED(lock);
+};
+
+// Indexed by the CPU the caller happens to be running on. Nothing depends on staying on that CPU,
+// it only spreads out the lock contention.
+StackCache gStackCaches[SMP_MAX_CPUS];
+
+StackCache& CurrentStackCache() { return gStackCaches[arch_curr_cpu_num()]; }
+
 }  // namespace
 
 vaddr_t KernelStack::Mapping::base() const {
@@ -171,6 +212,10 @@ size_t KernelStack::Mapping::size() const {
 }
 
 zx_status_t KernelStack::Init() {
+  if (TakeFromCache()) {
+    return ZX_OK;
+  }
+
   // Determine the total VMO size we needed for all stacks.
   size_t vmo_size = kSafe.size_bytes;
 #if __has_feature(safe_stack)
@@ -245,7 +290,112 @@ KernelStack::~KernelStack() {
   DEBUG_ASSERT_MSG(status == ZX_OK, "KernelStack::Teardown returned %d\n", status);
 }
 
+bool KernelStack::TakeFromCache() {
+  DEBUG_ASSERT(!main_map_.vmar_);
+  {
+    StackCache& cache = CurrentStackCache();
+    Guard<Mutex> guard{&cache.lock};
+    if (cache.count == 0) {
+      vm_kernel_stack_cache_miss.Add(1);
+      return false;
+    }
+    CachedStack& cached = cache.stacks[--cache.count];
+    main_map_ = ktl::move(cached.main);
+#if __has_feature(safe_stack)
+    unsafe_map_ = ktl::move(cached.unsafe);
+#endif
+#if __has_feature(shadow_call_stack)
+    shadow_call_map_ = ktl::move(cached.shadow_call);
+#endif
+  }
+
+  reuse(kSafe, main_map_);
+#if __has_feature(safe_stack)
+  reuse(kUnsafe, unsafe_map_);
+#endif
+#if __has_feature(shadow_call_stack)
+  reuse(kShadowCall, shadow_call_map_);
+#endif
+  vm_kernel_stack_cache_hit.Add(1);
+  return true;
+}
+
+bool KernelStack::ReturnToCache() {
+  // Only cache complete stacks, a failed Init() may have left some mappings missing.
+  bool complete = !!main_map_.vmar_;
+#if __has_feature(safe_stack)
+  complete = complete && unsafe_map_.vmar_;
+#endif
+#if __has_feature(shadow_call_stack)
+  complete = complete && shadow_call_map_.vmar_;
+#endif
+  if (!complete) {
+    return false;
+  }
+
+  // Check the canaries now, as the stack will not pass through unmap until it is evicted.
+  stack_canary_check(kSafe, reinterpret_cast<void*>(main_map_.base()));
+#if __has_feature(safe_stack)
+  stack_canary_check(kUnsafe, reinterpret_cast<void*>(unsafe_map_.base()));
+#endif
+#if __has_feature(shadow_call_stack)
+  stack_canary_check(kShadowCall, reinterpret_cast<void*>(shadow_call_map_.base()));
+#endif
+
+  StackCache& cache = CurrentStackCache();
+  Guard<Mutex> guard{&cache.lock};
+  if (cache.count == kStackCacheSize) {
+    return false;
+  }
+  CachedStack& cached = cache.stacks[cache.count++];
+  cached.main = ktl::move(main_map_);
+#if __has_feature(safe_stack)
+  cached.unsafe = ktl::move(unsafe_map_);
+#endif
+#if __has_feature(shadow_call_stack)
+  cached.shadow_call = ktl::move(shadow_call_map_);
+#endif
+  return true;
+}
+
+size_t KernelStack::TrimCache() {
+  size_t trimmed = 0;
+  for (StackCache& cache : gStackCaches) {
+    CachedStack stacks[kStackCacheSize];
+    size_t count;
+    {
+      Guard<Mutex> guard{&cache.lock};
+      count = cache.count;
+      for (size_t i = 0; i < count; i++) {
+        stacks[i] = ktl::move(cache.stacks[i]);
+      }
+      cache.count = 0;
+    }
+
+    // Destroy the mappings outside of the lock, as it takes the kernel aspace lock.
+    for (size_t i = 0; i < count; i++) {
+      [[maybe_unused]] zx_status_t status = unmap(kSafe, stacks[i].main);
+      DEBUG_ASSERT(status == ZX_OK);
+#if __has_feature(safe_stack)
+      status = unmap(kUnsafe, stacks[i].unsafe);
+      DEBUG_ASSERT(status == ZX_OK);
+#endif
+#if __has_feature(shadow_call_stack)
+      status = unmap(kShadowCall, stacks[i].shadow_call);
+      DEBUG_ASSERT(status == ZX_OK);
+#endif
+    }
+    trimmed += count;
+  }
+  vm_kernel_stack_cache_trimmed.Add(static_cast<int64_t>(trimmed));
+  return trimmed;
+}
+
 zx_status_t KernelStack::Teardown() {
+  if (ReturnToCache()) {
+    return ZX_OK;
+  }
+
   zx_status_t status = unmap(kSafe, main_map_);
   if (status != ZX_OK) {
     return status;
@@ -7,6 +7,7 @@
 #include <lib/boot-options/boot-options.h>
 #include <lib/fit/defer.h>
 
+#include <arch/ops.h>
 #include <vm/lz4_compressor.h>
 #include <vm/physmap.h>
 #include <vm/vm.h>
@@ -16,10 +17,11 @@ VmLz4Compressor::CompressResult VmLz4Compressor::Compress(const void *src, void
   int compressed_result;
   int threshold = static_cast<int>(dst_limit);
   {
-    Guard<Mutex> guard{&compress_lock_};
+    Stream &stream = streams_[arch_curr_cpu_num() % streams_.size()];
+    Guard<Mutex> guard{&stream.lock};
     compressed_result = LZ4_compress_fast_extState_fastReset(
-        &stream_, static_cast<const char *>(src), static_cast<char *>(dst), PAGE_SIZE, threshold,
-        acceleration_);
+        &stream.stream, static_cast<const char *>(src), static_cast<char *>(dst), PAGE_SIZE,
+        threshold, acceleration_);
   }
   if (compressed_result == 0) {
     return FailTag{};
@@ -42,20 +44,30 @@ void VmLz4Compressor::Decompress(const void *src, size_t src_len, void *dst) {
 
 void VmLz4Compressor::Dump() const {}
 
-bool VmLz4Compressor::Init() {
-  Guard<Mutex> guard{&compress_lock_};
-  // Initialize the stream. As our stream should be exactly sized and aligned there is no reason for
-  // this to return anything other than the original pointer.
-  LZ4_stream_t *stream = LZ4_initStream(&stream_, sizeof(stream_));
-  if (stream != &stream_) {
+bool VmLz4Compressor::Init(size_t num_streams) {
+  DEBUG_ASSERT(num_streams > 0);
+  fbl::AllocChecker ac;
+  streams_ = fbl::MakeArray<Stream>(&ac, num_streams);
+  if (!ac.check()) {
     return false;
   }
+  // Initialize the streams. As our streams should be exactly sized and aligned there is no reason
+  // for this to return anything other than the original pointer.
+  for (Stream &s : streams_) {
+    Guard<Mutex> stream_guard{&s.lock};
+    LZ4_stream_t *stream = LZ4_initStream(&s.stream, sizeof(s.stream));
+    if (stream != &s.stream) {
+      return false;
+    }
+  }
+
+  Guard<Mutex> guard{&streams_[0].lock};
 
   // Zero page should compress quite well, so just use a small stack allocation.
   constexpr size_t kMaxZeroPageStorage = 128;
   char temp_zero_compress[kMaxZeroPageStorage];
   int compress_result = LZ4_compress_fast_extState_fastReset(
-      &stream_, static_cast<const char *>(paddr_to_physmap(vm_get_zero_page_paddr())),
+      &streams_[0].stream, static_cast<const char *>(paddr_to_physmap(vm_get_zero_page_paddr())),
       temp_zero_compress, PAGE_SIZE, kMaxZeroPageStorage, acceleration_);
   if (compress_result == 0) {
     printf("ERROR: LZ4 failed to compress zero page with acceleration %d into %zu bytes\n",
@@ -66,7 +78,6 @@ bool VmLz4Compressor::Init() {
   size_t compressed_size = static_cast<size_t>(compress_result);
   DEBUG_ASSERT(compressed_size <= kMaxZeroPageStorage);
   // Now allocate the exact storage.
-  fbl::AllocChecker ac;
   compressed_zero_ = fbl::MakeArray<char>(&ac, compressed_size);
   if (!ac.check()) {
     return false;
@@ -76,7 +87,7 @@ bool VmLz4Compressor::Init() {
   return true;
 }
 
-fbl::RefPtr<VmLz4Compressor> VmLz4Compressor::Create() {
+fbl::RefPtr<VmLz4Compressor> VmLz4Compressor::Create(size_t num_streams) {
   const int acceleration = static_cast<int>(gBootOptions->compression_lz4_acceleration);
 
   fbl::AllocChecker ac;
@@ -86,7 +97,7 @@ fbl::RefPtr<VmLz4Compressor> VmLz4Compressor::Create() {
     return nullptr;
   }
 
-  if (!lz4->Init()) {
+  if (!lz4->Init(num_streams)) {
     return nullptr;
   }
 
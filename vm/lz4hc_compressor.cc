@@ -0,0 +1,111 @@
+// Copyright 2023 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+// LZ4_compress_HC_extStateHC_fastReset is only available from the static API.
+#define LZ4_HC_STATIC_LINKING_ONLY
+
+#include <lib/boot-options/boot-options.h>
+
+#include <arch/ops.h>
+#include <ktl/algorithm.h>
+#include <vm/lz4hc_compressor.h>
+#include <vm/physmap.h>
+#include <vm/vm.h>
+
+VmLz4HcCompressor::CompressResult VmLz4HcCompressor::Compress(const void *src, void *dst,
+                                                              size_t dst_limit) {
+  int compressed_result;
+  int threshold = static_cast<int>(dst_limit);
+  {
+    Stream &stream = streams_[arch_curr_cpu_num() % streams_.size()];
+    Guard<Mutex> guard{&stream.lock};
+    compressed_result = LZ4_compress_HC_extStateHC_fastReset(
+        &stream.stream, static_cast<const char *>(src), static_cast<char *>(dst), PAGE_SIZE,
+        threshold, level_);
+  }
+  if (compressed_result == 0) {
+    return FailTag{};
+  }
+  DEBUG_ASSERT(compressed_result > 0 && compressed_result <= threshold);
+  size_t compressed_size = static_cast<size_t>(compressed_result);
+  if (compressed_size == compressed_zero_.size()) {
+    if (memcmp(dst, compressed_zero_.get(), compressed_size) == 0) {
+      return ZeroTag{};
+    }
+  }
+  return compressed_size;
+}
+
+void VmLz4HcCompressor::Decompress(const void *src, size_t src_len, void *dst) {
+  // LZ4-HC produces regular LZ4 blocks, so uses the regular decompressor.
+  int result = LZ4_decompress_safe(static_cast<const char *>(src), static_cast<char *>(dst),
+                                   static_cast<int>(src_len), PAGE_SIZE);
+  ASSERT(result == PAGE_SIZE);
+}
+
+void VmLz4HcCompressor::Dump() const {}
+
+bool VmLz4HcCompressor::Init(size_t num_streams) {
+  DEBUG_ASSERT(num_streams > 0 && num_streams <= kMaxStreams);
+  fbl::AllocChecker ac;
+  streams_ = fbl::MakeArray<Stream>(&ac, num_streams);
+  if (!ac.check()) {
+    return false;
+  }
+  for (Stream &s : streams_) {
+    Guard<Mutex> stream_guard{&s.lock};
+    LZ4_streamHC_t *stream = LZ4_initStreamHC(&s.stream, sizeof(s.stream));
+    if (stream != &s.stream) {
+      return false;
+    }
+  }
+
+  Guard<Mutex> guard{&streams_[0].lock};
+
+  // Zero page should compress quite well, so just use a small stack allocation.
+  constexpr size_t kMaxZeroPageStorage = 128;
+  char temp_zero_compress[kMaxZeroPageStorage];
+  int compress_result = LZ4_compress_HC_extStateHC_fastReset(
+      &streams_[0].stream, static_cast<const char *>(paddr_to_physmap(vm_get_zero_page_paddr())),
+      temp_zero_compress, PAGE_SIZE, kMaxZeroPageStorage, level_);
+  if (compress_result == 0) {
+    printf("ERROR: LZ4-HC failed to compress zero page with level %d into %zu bytes\n", level_,
+           kMaxZeroPageStorage);
+    return false;
+  }
+  DEBUG_ASSERT(compress_result > 0);
+  size_t compressed_size = static_cast<size_t>(compress_result);
+  DEBUG_ASSERT(compressed_size <= kMaxZeroPageStorage);
+  // Now allocate the exact storage.
+  compressed_zero_ = fbl::MakeArray<char>(&ac, compressed_size);
+  if (!ac.check()) {
+    return false;
+  }
+  memcpy(compressed_zero_.get(), temp_zero_compress, compressed_size);
+
+  return true;
+}
+
+fbl::RefPtr<VmLz4HcCompressor> VmLz4HcCompressor::Create(size_t num_streams) {
+  const uint32_t level = gBootOptions->compression_lz4hc_level;
+  if (level < 1 || level > LZ4HC_CLEVEL_MAX) {
+    printf("ERROR: kernel.compression.lz4hc.level must be between 1 and %d\n", LZ4HC_CLEVEL_MAX);
+    return nullptr;
+  }
+
+  fbl::AllocChecker ac;
+  fbl::RefPtr<VmLz4HcCompressor> lz4hc =
+      fbl::AdoptRef<VmLz4HcCompressor>(new (&ac) VmLz4HcCompressor(static_cast<int>(level)));
+  if (!ac.check()) {
+    return nullptr;
+  }
+
+  if (!lz4hc->Init(ktl::clamp<size_t>(num_streams, 1, kMaxStreams))) {
+    return nullptr;
+  }
+
+  return lz4hc;
+}
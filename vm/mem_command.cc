@@ -8,6 +8,7 @@
 #include <lib/console.h>
 
 #include <object/memory_watchdog.h>
+#include <vm/compression.h>
 #include <vm/pmm.h>
 #include <vm/scanner.h>
 
@@ -87,6 +88,21 @@ static int cmd_oom(int argc, const cmd_args* argv) {
   return ZX_OK;
 }
 
+// Runs a single zero page scan, which also merges pages with identical compressed pages when
+// content deduplication is enabled, over at most |limit| candidates.
+static int cmd_dedup(uint64_t limit) {
+  VmCompression* compression = Pmm::Node().GetPageCompression();
+  if (!compression || !compression->IsDedupEnabled()) {
+    printf("Content deduplication is not enabled, only zero pages will be deduped\n");
+  }
+  const uint64_t deduped = scanner_do_zero_scan(limit);
+  printf("Deduped %" PRIu64 " pages\n", deduped);
+  if (compression) {
+    compression->Dump();
+  }
+  return ZX_OK;
+}
+
 static int cmd_usage(const char* cmd_name) {
   printf("usage:\n");
   printf("%s dump                                     : dump memory availability state info \n",
@@ -111,6 +127,10 @@ static int cmd_usage(const char* cmd_name) {
       "optional [step] mode, allocation pauses for 1 second at each intermediate memory "
       "availability state until <state> is reached.\n",
       cmd_name);
+  printf(
+      "%s dedup [<pages>]                          : scan up to <pages> (all by default) "
+      "candidates for zero and duplicate pages and merge them\n",
+      cmd_name);
   return ZX_ERR_INTERNAL;
 }
 
@@ -129,6 +149,11 @@ static int cmd_mem(int argc, const cmd_args* argv, uint32_t flags) {
       return cmd_usage(name);
     }
     return cmd_oom(argc, argv);
+  } else if (!strcmp(argv[1].str, "dedup")) {
+    if (argc > 3) {
+      return cmd_usage(name);
+    }
+    return cmd_dedup(argc > 2 ? argv[2].u : UINT64_MAX);
   } else if (!strcmp(argv[1].str, "avail_state")) {
     if (argc < 3) {
       return cmd_usage(name);
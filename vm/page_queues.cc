@@ -9,6 +9,8 @@
 #include <lib/fit/defer.h>
 #include <lib/zircon-internal/macros.h>
 
+#include <arch/interrupt.h>
+#include <arch/ops.h>
 #include <fbl/ref_counted_upgradeable.h>
 #include <kernel/auto_preempt_disabler.h>
 #include <object/thread_dispatcher.h>
@@ -34,6 +36,9 @@ KCOUNTER(pq_lru_pages_discarded, "pq.lru.pages_discarded")
 KCOUNTER(pq_accessed_normal, "pq.accessed.normal")
 KCOUNTER(pq_accessed_normal_same_queue, "pq.accessed.normal_same_queue")
 KCOUNTER(pq_accessed_isolate, "pq.accessed.isolate")
+KCOUNTER(pq_staging_staged, "pq.staging.staged")
+KCOUNTER(pq_staging_flush_full, "pq.staging.flush_full")
+KCOUNTER(pq_staging_flush_forced, "pq.staging.flush_forced")
 
 // Helper class for building an isolate list for deferred processing when acting on the LRU queues.
 // Pages are added while the page queues lock is held, and processed once the lock is dropped.
@@ -122,9 +127,10 @@ class LruIsolate {
             compressor = &maybe_compressor->get();
           }
         }
-        // If using a compressor, make sure it is Armed between reclamations.
+        // If using a compressor, make sure it is Armed between reclamations. Aging out pages is
+        // routine reclamation, and so favors compression speed over ratio.
         if (compressor) {
-          zx_status_t status = compressor->Arm();
+          zx_status_t status = compressor->Arm(VmCompressor::Effort::Fast);
           if (status != ZX_OK) {
             // Continue processing as we might still be able to evict and we need to clear all the
             // refptrs as well.
@@ -261,6 +267,20 @@ void PageQueues::StartDebugCompressor() {
 #endif
 }
 
+void PageQueues::StartStaging() {
+  const size_t num_batches = arch_max_num_cpus();
+  fbl::AllocChecker ac;
+  ktl::unique_ptr<StagingBatch[]> batches = ktl::make_unique<StagingBatch[]>(&ac, num_batches);
+  if (!ac.check()) {
+    panic("Failed to allocate page queue staging batches");
+  }
+  Guard<SpinLock, IrqSave> guard{&list_lock_};
+  ASSERT(!staging_storage_);
+  num_staging_batches_ = num_batches;
+  staging_storage_ = ktl::move(batches);
+  staging_.store(staging_storage_.get(), ktl::memory_order_release);
+}
+
 void PageQueues::StopThreads() {
   // Cannot wait for threads to complete with the lock held, so update state and then perform any
   // joins outside the lock.
@@ -836,6 +856,8 @@ void PageQueues::ProcessLruQueue(uint64_t target_gen) {
       if (lru >= target_gen) {
         break;
       }
+      // Staged pages in the lru queue must be in its list before it can be processed.
+      FlushStagedLockedList();
       const PageQueue mru_queue = mru_gen_to_queue();
       const PageQueue lru_queue = gen_to_queue(lru);
       list_node_t* list = &page_queues_[lru_queue];
@@ -947,8 +969,8 @@ void PageQueues::MaybeCheckActiveRatioAgingLocked(size_t pages) {
   }
 }
 
-void PageQueues::SetQueueBacklinkLockedList(vm_page_t* page, void* object, uintptr_t page_offset,
-                                            PageQueue queue) {
+void PageQueues::SetQueueBacklink(vm_page_t* page, void* object, uintptr_t page_offset,
+                                  PageQueue queue) {
   DEBUG_ASSERT(page->state() == vm_page_state::OBJECT);
   DEBUG_ASSERT(!page->is_free());
   DEBUG_ASSERT(!list_in_list(&page->queue_node));
@@ -961,11 +983,95 @@ void PageQueues::SetQueueBacklinkLockedList(vm_page_t* page, void* object, uintp
 
   DEBUG_ASSERT(page->object.get_page_queue_ref().load(ktl::memory_order_relaxed) == PageQueueNone);
   page->object.get_page_queue_ref().store(queue, ktl::memory_order_relaxed);
-  list_add_head(&page_queues_[queue], &page->queue_node);
   page_queue_counts_[queue].fetch_add(1, ktl::memory_order_relaxed);
 }
 
+void PageQueues::SetQueueBacklinkLockedList(vm_page_t* page, void* object, uintptr_t page_offset,
+                                            PageQueue queue) {
+  SetQueueBacklink(page, object, page_offset, queue);
+  list_add_head(&page_queues_[queue], &page->queue_node);
+}
+
+template <typename F>
+void PageQueues::SetQueueBacklinkStaged(vm_page_t* page, VmCowPages* object, uint64_t page_offset,
+                                        bool debug_compress, F get_queue) {
+  auto set_locked = [&]() TA_REQ(list_lock_) {
+    SetQueueBacklinkLockedList(page, object, page_offset, get_queue());
+#if DEBUG_ASSERT_IMPLEMENTED
+    if (debug_compress && debug_compressor_) {
+      debug_compressor_->Add(page, object, page_offset);
+    }
+#endif
+  };
+
+  StagingBatch* const staging = staging_.load(ktl::memory_order_acquire);
+  // Loaned pages are never staged, as GetCowForLoanedPage relies on the backlink of a loaned page
+  // only being set with the list_lock_ held.
+  if (!staging || page->is_loaned()) {
+    Guard<SpinLock, IrqSave> guard{&list_lock_};
+    set_locked();
+    return;
+  }
+
+  InterruptDisableGuard irqd;
+  StagingBatch& batch = staging[arch_curr_cpu_num()];
+  {
+    Guard<SpinLock, NoIrqSave> guard{&batch.lock};
+    if (batch.count < kStagingBatchSize) {
+      SetQueueBacklink(page, object, page_offset, get_queue());
+      batch.pages[batch.count] = page;
+#if DEBUG_ASSERT_IMPLEMENTED
+      batch.debug_compress[batch.count] = debug_compress;
+#endif
+      batch.count++;
+      pq_staging_staged.Add(1);
+      return;
+    }
+  }
+  // The batch is full, so link it, along with this page, under a single acquisition of the lock.
+  Guard<SpinLock, IrqSave> guard{&list_lock_};
+  pq_staging_flush_full.Add(1);
+  FlushStagingBatchLockedList(batch);
+  set_locked();
+}
+
+void PageQueues::FlushStagingBatchLockedList(StagingBatch& batch) {
+  Guard<SpinLock, NoIrqSave> guard{&batch.lock};
+  for (size_t i = 0; i < batch.count; i++) {
+    vm_page_t* page = batch.pages[i];
+    DEBUG_ASSERT(!list_in_list(&page->queue_node));
+    // The queue may have been changed by MarkAccessed since the page was staged, but any operation
+    // that would change it to the Isolate queue, or remove the page, would have flushed first.
+    const PageQueue queue =
+        static_cast<PageQueue>(page->object.get_page_queue_ref().load(ktl::memory_order_relaxed));
+    DEBUG_ASSERT(queue != PageQueueNone && queue != PageQueueReclaimIsolate);
+    list_add_head(&page_queues_[queue], &page->queue_node);
+#if DEBUG_ASSERT_IMPLEMENTED
+    if (batch.debug_compress[i] && debug_compressor_) {
+      debug_compressor_->Add(page, reinterpret_cast<VmCowPages*>(page->object.get_object()),
+                             page->object.get_page_offset());
+    }
+#endif
+  }
+  batch.count = 0;
+}
+
+void PageQueues::FlushStagedLockedList() {
+  StagingBatch* const staging = staging_storage_.get();
+  for (size_t i = 0; i < num_staging_batches_; i++) {
+    FlushStagingBatchLockedList(staging[i]);
+  }
+}
+
+void PageQueues::EnsureListedLockedList(vm_page_t* page) {
+  if (!list_in_list(&page->queue_node) && staging_storage_) {
+    pq_staging_flush_forced.Add(1);
+    FlushStagedLockedList();
+  }
+}
+
 void PageQueues::MoveToQueueLockedList(vm_page_t* page, PageQueue queue) {
+  EnsureListedLockedList(page);
   DEBUG_ASSERT(page->state() == vm_page_state::OBJECT);
   DEBUG_ASSERT(!page->is_free());
   DEBUG_ASSERT(list_in_list(&page->queue_node));
@@ -998,17 +1104,9 @@ void PageQueues::MoveToWired(vm_page_t* page) {
 
 void PageQueues::SetAnonymous(vm_page_t* page, VmCowPages* object, uint64_t page_offset,
                               bool skip_reclaim) {
-  {
-    Guard<SpinLock, IrqSave> guard{&list_lock_};
-    SetQueueBacklinkLockedList(
-        page, object, page_offset,
-        anonymous_is_reclaimable_ && !skip_reclaim ? mru_gen_to_queue() : PageQueueAnonymous);
-#if DEBUG_ASSERT_IMPLEMENTED
-    if (debug_compressor_) {
-      debug_compressor_->Add(page, object, page_offset);
-    }
-#endif
-  }
+  SetQueueBacklinkStaged(page, object, page_offset, /*debug_compress=*/true, [&]() {
+    return anonymous_is_reclaimable_ && !skip_reclaim ? mru_gen_to_queue() : PageQueueAnonymous;
+  });
   MaybeCheckActiveRatioAging(1);
 }
 
@@ -1041,13 +1139,37 @@ void PageQueues::MoveToAnonymous(vm_page_t* page, bool skip_reclaim) {
 }
 
 void PageQueues::SetReclaim(vm_page_t* page, VmCowPages* object, uint64_t page_offset) {
-  {
-    Guard<SpinLock, IrqSave> guard{&list_lock_};
-    SetQueueBacklinkLockedList(page, object, page_offset, mru_gen_to_queue());
-  }
+  SetQueueBacklinkStaged(page, object, page_offset, /*debug_compress=*/false,
+                         [this]() { return mru_gen_to_queue(); });
   MaybeCheckActiveRatioAging(1);
 }
 
+void PageQueues::SetReclaimArray(vm_page_t** pages, VmCowPages* object, uint64_t* offsets,
+                                 size_t count) {
+  DEBUG_ASSERT(pages);
+  DEBUG_ASSERT(offsets);
+  DEBUG_ASSERT(object);
+
+  for (size_t i = 0; i < count;) {
+    // Bound the time the lock is held, see ChangeObjectOffsetArray.
+    const size_t batch_start = i;
+    const size_t end = i + ktl::min(count - i, kMaxBatchSize);
+    {
+      Guard<SpinLock, IrqSave> guard{&list_lock_};
+      const PageQueue queue = mru_gen_to_queue();
+      for (; i < end; i++) {
+        DEBUG_ASSERT(pages[i]);
+        SetQueueBacklinkLockedList(pages[i], object, offsets[i], queue);
+      }
+    }
+    MaybeCheckActiveRatioAging(end - batch_start);
+
+    if (i < count) {
+      arch::Yield();
+    }
+  }
+}
+
 void PageQueues::MoveToReclaim(vm_page_t* page) {
   {
     Guard<SpinLock, IrqSave> guard{&list_lock_};
@@ -1078,17 +1200,9 @@ void PageQueues::MoveToPagerBackedDirty(vm_page_t* page) {
 }
 
 void PageQueues::SetAnonymousZeroFork(vm_page_t* page, VmCowPages* object, uint64_t page_offset) {
-  {
-    Guard<SpinLock, IrqSave> guard{&list_lock_};
-    SetQueueBacklinkLockedList(
-        page, object, page_offset,
-        zero_fork_is_reclaimable_ ? mru_gen_to_queue() : PageQueueAnonymousZeroFork);
-#if DEBUG_ASSERT_IMPLEMENTED
-    if (debug_compressor_) {
-      debug_compressor_->Add(page, object, page_offset);
-    }
-#endif
-  }
+  SetQueueBacklinkStaged(page, object, page_offset, /*debug_compress=*/true, [this]() {
+    return zero_fork_is_reclaimable_ ? mru_gen_to_queue() : PageQueueAnonymousZeroFork;
+  });
   MaybeCheckActiveRatioAging(1);
 }
 
@@ -1176,6 +1290,7 @@ void PageQueues::ChangeObjectOffsetArray(vm_page_t** pages, VmCowPages* object,
 
 void PageQueues::ChangeObjectOffsetLockedList(vm_page_t* page, VmCowPages* object,
                                               uint64_t page_offset) {
+  EnsureListedLockedList(page);
   DEBUG_ASSERT(page->state() == vm_page_state::OBJECT);
   DEBUG_ASSERT(!page->is_free());
   DEBUG_ASSERT(list_in_list(&page->queue_node));
@@ -1186,6 +1301,7 @@ void PageQueues::ChangeObjectOffsetLockedList(vm_page_t* page, VmCowPages* objec
 }
 
 void PageQueues::RemoveLockedList(vm_page_t* page) {
+  EnsureListedLockedList(page);
   // Directly exchange the old gen.
   uint32_t old_queue =
       page->object.get_page_queue_ref().exchange(PageQueueNone, ktl::memory_order_relaxed);
@@ -1378,6 +1494,7 @@ ktl::optional<PageQueues::VmoBacklink> PageQueues::PopAnonymousZeroFork() {
   ktl::optional<PageQueues::VmoBacklink> ret;
   {
     Guard<SpinLock, IrqSave> guard{&list_lock_};
+    FlushStagedLockedList();
 
     vm_page_t* page =
         list_peek_tail_type(&page_queues_[PageQueueAnonymousZeroFork], vm_page_t, queue_node);
@@ -1455,6 +1572,8 @@ void PageQueues::EnableAnonymousReclaim(bool zero_forks) {
     Guard<SpinLock, IrqSave> guard{&list_lock_};
     anonymous_is_reclaimable_ = true;
     zero_fork_is_reclaimable_ = zero_forks;
+    // Any page staged before the above change must be in its list so that it is migrated below.
+    FlushStagedLockedList();
 
     const PageQueue mru_queue = mru_gen_to_queue();
 
@@ -5,10 +5,12 @@
 // https://opensource.org/licenses/MIT
 
 #include <lib/console.h>
+#include <lib/counters.h>
 #include <lib/dump/depth_printer.h>
 #include <trace.h>
 
 #include <kernel/lockdep.h>
+#include <ktl/algorithm.h>
 #include <ktl/utility.h>
 #include <vm/page_source.h>
 
@@ -16,6 +18,14 @@
 
 #define LOCAL_TRACE 0
 
+namespace {
+
+KCOUNTER(page_source_readahead_hits, "vm.page_source.readahead.hits")
+KCOUNTER(page_source_readahead_misses, "vm.page_source.readahead.misses")
+KCOUNTER(page_source_readahead_pages, "vm.page_source.readahead.pages")
+
+}  // namespace
+
 PageSource::PageSource(fbl::RefPtr<PageProvider>&& page_provider)
     : page_provider_properties_(page_provider->properties()),
       page_provider_(ktl::move(page_provider)) {
@@ -331,6 +341,44 @@ zx_status_t PageSource::PopulateRequest(PageRequest* request, uint64_t offset, u
   return PopulateRequestLocked(request, offset, len, vmo_debug_info, type);
 }
 
+uint64_t PageSource::ReadaheadLength(uint64_t offset, uint64_t len) {
+  canary_.Assert();
+  DEBUG_ASSERT(IS_PAGE_ROUNDED(offset));
+  DEBUG_ASSERT(IS_PAGE_ROUNDED(len));
+
+  // Reading ahead only makes sense if the provider is going to supply actual content.
+  if (!properties().is_preserving_page_content) {
+    return len;
+  }
+
+  Guard<Mutex> guard{&page_source_mtx_};
+  ReadaheadState& ra = readahead_;
+  if (offset >= ra.start && offset < ra.end) {
+    // Still within the previous request, which might just not be fully supplied yet.
+    return ktl::max(len, ra.end - offset);
+  }
+  if (offset == ra.end) {
+    ra.window_pages = ktl::clamp(ra.window_pages * 2, kReadaheadMinPages, kReadaheadMaxPages);
+    ra.hits++;
+    page_source_readahead_hits.Add(1);
+  } else {
+    ra.window_pages = ra.window_pages / 2 < kReadaheadMinPages ? 0 : ra.window_pages / 2;
+    ra.misses++;
+    page_source_readahead_misses.Add(1);
+  }
+  const uint64_t window = ra.window_pages * PAGE_SIZE;
+  if (window > len) {
+    page_source_readahead_pages.Add((window - len) / PAGE_SIZE);
+    len = window;
+  }
+  ra.start = offset;
+  // Saturate rather than overflow, the caller will trim the request to the VMO size anyway.
+  if (add_overflow(offset, len, &ra.end)) {
+    ra.end = UINT64_MAX;
+  }
+  return len;
+}
+
 void PageSource::FreePages(list_node* pages) { page_provider_->FreePages(pages); }
 
 zx_status_t PageSource::PopulateRequestLocked(PageRequest* request, uint64_t offset, uint64_t len,
@@ -486,6 +534,8 @@ void PageSource::DumpSelf(uint depth, uint max_items) const {
   Guard<Mutex> guard{&page_source_mtx_};
   dump::DepthPrinter printer(depth);
   printer.Emit("page_source %p detached %d closed %d", this, detached_, closed_);
+  printer.Emit("  readahead window %lu pages hits %lu misses %lu", readahead_.window_pages,
+               readahead_.hits, readahead_.misses);
   for (uint8_t type = 0; type < page_request_type::COUNT; type++) {
     printer.BeginList(max_items);
     for (auto& req : outstanding_requests_[type]) {
@@ -16,6 +16,8 @@ static void ppb_init_func(uint level) {
   // One option per potential borrowing site.
 
   PhysicalPageBorrowingConfig::Get().set_borrowing_on_mru_enabled(gBootOptions->ppb_borrow_on_mru);
+  PhysicalPageBorrowingConfig::Get().set_borrowing_in_supplypages_enabled(
+      gBootOptions->ppb_borrow_in_supplypages);
 
   // One option for whether decommit on contiguous VMO can work or returns ZX_ERR_NOT_SUPPORTED.
   PhysicalPageBorrowingConfig::Get().set_loaning_enabled(gBootOptions->ppb_loan);
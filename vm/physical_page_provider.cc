@@ -19,6 +19,9 @@
 KCOUNTER(physical_reclaim_total_requests, "physical.reclaim.total_requests")
 KCOUNTER(physical_reclaim_succeeded_requests, "physical.reclaim.succeeded_requests")
 KCOUNTER(physical_reclaim_failed_requests, "physical.reclaim.failed_requests")
+KCOUNTER(physical_unloan_free, "physical.unloan.free")
+KCOUNTER(physical_unloan_replaced, "physical.unloan.replaced")
+KCOUNTER(physical_unloan_evicted, "physical.unloan.evicted")
 
 PhysicalPageProvider::PhysicalPageProvider(uint64_t size) : size_(size) { LTRACEF("\n"); }
 
@@ -271,8 +274,12 @@ void PhysicalPageProvider::UnloanRange(uint64_t range_offset, uint64_t length, l
             // If replacement succeeded, i.e. we are not going to fall back to eviction, then the
             // page should be back in the PMM.
             DEBUG_ASSERT(needs_evict || page->is_free_loaned());
+            if (!needs_evict) {
+              physical_unloan_replaced.Add(1);
+            }
           }
           if (needs_evict) {
+            physical_unloan_evicted.Add(1);
             [[maybe_unused]] VmCowPages::ReclaimCounts counts =
                 cow_container->ReclaimPageForEviction(page, vmo_backlink.offset,
                                                       VmCowPages::EvictionAction::Require);
@@ -292,6 +299,8 @@ void PhysicalPageProvider::UnloanRange(uint64_t range_offset, uint64_t length, l
       // For all the scenarios, no backlink, successful replacement or eviction attempts, the page
       // must have ended up in the PMM.
       ASSERT(page->is_free_loaned());
+    } else {
+      physical_unloan_free.Add(1);
     }
     // Now that the page is definitely in the FREE_LOANED state, gain ownership from the PMM.
     Pmm::Node().EndLoan(page);
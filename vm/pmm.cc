@@ -14,6 +14,7 @@
 #include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <lib/memalloc/range.h>
+#include <lib/system-topology.h>
 #include <platform.h>
 #include <pow2.h>
 #include <stdlib.h>
@@ -28,8 +29,10 @@
 #include <fbl/intrusive_double_list.h>
 #include <kernel/mp.h>
 #include <kernel/mutex.h>
+#include <kernel/thread.h>
 #include <kernel/timer.h>
 #include <ktl/algorithm.h>
+#include <lk/boot_timeline.h>
 #include <lk/init.h>
 #include <vm/compression.h>
 #include <vm/physmap.h>
@@ -70,7 +73,137 @@ LK_INIT_HOOK(pmm_init_alloc_random_should_wait, &pmm_init_alloc_random_should_wa
 static void pmm_fill_free_pages(uint level) { Pmm::Node().FillFreePagesAndArm(); }
 LK_INIT_HOOK(pmm_fill, &pmm_fill_free_pages, LK_INIT_LEVEL_VM)
 
-zx_status_t pmm_init(ktl::span<const memalloc::Range> ranges) { return Pmm::Node().Init(ranges); }
+// The magazines are sized by the number of CPUs, so wait for the percpu structures to be
+// initialized.
+static void pmm_init_magazines(uint level) {
+  zx_status_t status = Pmm::Node().InitMagazines(gBootOptions->pmm_magazine_size);
+  if (status != ZX_OK) {
+    printf("pmm: failed to initialize page magazines: %d\n", status);
+  }
+}
+LK_INIT_HOOK(pmm_magazines, &pmm_init_magazines, LK_INIT_LEVEL_KERNEL)
+
+static void pmm_init_full_block_summaries(uint level) {
+  zx_status_t status = Pmm::Node().InitFullBlockSummaries();
+  if (status != ZX_OK) {
+    printf("pmm: failed to initialize full block summaries: %d\n", status);
+  }
+}
+LK_INIT_HOOK(pmm_full_block_summaries, &pmm_init_full_block_summaries, LK_INIT_LEVEL_VM)
+
+// Once the system topology is known, give each NUMA region that has processors its own free list
+// so that allocations prefer memory local to the allocating CPU.
+static void pmm_init_numa(uint level) {
+  const system_topology::Node* regions[PmmNode::kMaxNumaNodes] = {};
+  size_t region_count = 0;
+  uint8_t cpu_nodes[SMP_MAX_CPUS] = {};
+  size_t cpu_count = 0;
+
+  for (const system_topology::Node* processor : system_topology::GetSystemTopology().processors()) {
+    const system_topology::Node* region = processor->parent;
+    while (region && region->entity.discriminant != ZBI_TOPOLOGY_ENTITY_NUMA_REGION) {
+      region = region->parent;
+    }
+    if (!region) {
+      continue;
+    }
+
+    size_t node = 0;
+    while (node < region_count && regions[node] != region) {
+      node++;
+    }
+    if (node == region_count) {
+      if (region_count == PmmNode::kMaxNumaNodes) {
+        printf("pmm: more than %zu NUMA regions, not partitioning free memory\n",
+               PmmNode::kMaxNumaNodes);
+        return;
+      }
+      regions[region_count++] = region;
+    }
+
+    const auto& info = processor->entity.processor;
+    for (size_t i = 0; i < info.logical_id_count; i++) {
+      const cpu_num_t cpu = info.logical_ids[i];
+      if (cpu < SMP_MAX_CPUS) {
+        cpu_nodes[cpu] = static_cast<uint8_t>(node);
+        cpu_count = ktl::max<size_t>(cpu_count, cpu + 1);
+      }
+    }
+  }
+
+  if (region_count < 2) {
+    return;
+  }
+
+  PmmNode::NumaMemoryRange ranges[PmmNode::kMaxNumaNodes];
+  for (size_t i = 0; i < region_count; i++) {
+    ranges[i] = {
+        .base = regions[i]->entity.numa_region.start,
+        .size = regions[i]->entity.numa_region.size,
+        .node = static_cast<uint8_t>(i),
+    };
+  }
+  zx_status_t status = Pmm::Node().SetNumaNodes(ktl::span(ranges, region_count),
+                                                ktl::span(cpu_nodes, cpu_count));
+  if (status != ZX_OK) {
+    printf("pmm: failed to partition free memory by NUMA region: %d\n", status);
+    return;
+  }
+  dprintf(INFO, "pmm: partitioned free memory across %zu NUMA regions\n", region_count);
+}
+LK_INIT_HOOK(pmm_numa, &pmm_init_numa, LK_INIT_LEVEL_TOPOLOGY)
+
+static int pmm_deferred_init_thread(void*) {
+  while (Pmm::Node().InitDeferredChunk()) {
+  }
+  return 0;
+}
+
+// Initialize the page structures whose initialization was deferred at boot, see
+// kernel.pmm.deferred-page-init, with a thread on every online CPU now that the secondary CPUs are
+// up. Pages become available as each chunk completes, but wait for all of them so that user space
+// and the memory watchdog start out seeing all of RAM.
+static void pmm_init_deferred(uint level) {
+  if (!Pmm::Node().HasDeferredPages()) {
+    return;
+  }
+  const zx_instant_mono_t start = current_mono_time();
+
+  Thread* threads[SMP_MAX_CPUS] = {};
+  const cpu_mask_t online_mask = mp_get_online_mask();
+  const cpu_num_t curr_cpu = arch_curr_cpu_num();
+  for (cpu_num_t cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+    if (cpu == curr_cpu || (online_mask & cpu_num_to_mask(cpu)) == 0) {
+      continue;
+    }
+    threads[cpu] =
+        Thread::Create("pmm-deferred-init", pmm_deferred_init_thread, nullptr, DEFAULT_PRIORITY);
+    if (!threads[cpu]) {
+      break;
+    }
+    threads[cpu]->SetCpuAffinity(cpu_num_to_mask(cpu));
+    threads[cpu]->Resume();
+  }
+
+  // The current CPU takes part as well, and covers everything if no threads could be created.
+  pmm_deferred_init_thread(nullptr);
+  for (Thread* thread : threads) {
+    if (thread) {
+      thread->Join(nullptr, ZX_TIME_INFINITE);
+    }
+  }
+
+  dprintf(INFO, "pmm: initialized deferred pages in %" PRIi64 " ms, %" PRIu64 " pages free\n",
+          (current_mono_time() - start) / ZX_MSEC(1), pmm_count_free_pages());
+}
+LK_INIT_HOOK(pmm_deferred_init, &pmm_init_deferred, LK_INIT_LEVEL_USER - 1)
+
+zx_status_t pmm_init(ktl::span<const memalloc::Range> ranges) {
+  boot_timeline_sample(BootTimelinePoint::kPmmInitStart);
+  zx_status_t status = Pmm::Node().Init(ranges);
+  boot_timeline_sample(BootTimelinePoint::kPmmInitEnd);
+  return status;
+}
 
 void pmm_end_handoff() { Pmm::Node().EndHandoff(); }
 
@@ -180,6 +313,10 @@ void pmm_stop_returning_should_wait() { Pmm::Node().StopReturningShouldWait(); }
 
 void pmm_checker_check_all_free_pages() { Pmm::Node().CheckAllFreePages(); }
 
+uint64_t pmm_checker_check_free_pages(uint64_t max_pages) {
+  return Pmm::Node().CheckFreePagesIncremental(max_pages);
+}
+
 #if __has_feature(address_sanitizer)
 void pmm_asan_poison_all_free_pages() { Pmm::Node().PoisonAllFreePages(); }
 #endif
@@ -234,7 +371,13 @@ void pmm_checker_init_from_cmdline() {
       fill_size = PAGE_SIZE;
     }
 
-    Pmm::Node().EnableFreePageFilling(fill_size, gBootOptions->pmm_checker_action);
+    uint64_t sample_rate = gBootOptions->pmm_checker_sample_rate;
+    if (sample_rate == 0) {
+      printf("PMM: value from kernel.pmm-checker.sample-rate is invalid (0), using 1 instead\n");
+      sample_rate = 1;
+    }
+
+    Pmm::Node().EnableFreePageFilling(fill_size, gBootOptions->pmm_checker_action, sample_rate);
   }
 }
 
@@ -15,6 +15,7 @@
 #include <zircon/types.h>
 
 #include <kernel/range_check.h>
+#include <ktl/algorithm.h>
 #include <ktl/limits.h>
 #include <pretty/cpp/sizes.h>
 #include <vm/physmap.h>
@@ -29,8 +30,10 @@
 // A possibly "lossy" estimate of the maximum number of page runs examined while performing a
 // contiguous allocation.  See the comment where this counter is updated.
 KCOUNTER_DECLARE(counter_max_runs_examined, "vm.pmm.max_runs_examined", Max)
+// Number of blocks skipped by contiguous allocation searches because they were known to be full.
+KCOUNTER(counter_full_blocks_skipped, "vm.pmm.full_blocks_skipped")
 
-void PmmArena::Init(const PmmArenaSelection& selected, PmmNode* node) {
+void PmmArena::Init(const PmmArenaSelection& selected, PmmNode* node, bool defer) {
   DEBUG_ASSERT(IS_PAGE_ROUNDED(selected.arena.base));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(selected.arena.size));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(selected.bookkeeping.base));
@@ -59,41 +62,111 @@ void PmmArena::Init(const PmmArenaSelection& selected, PmmNode* node) {
   void* raw_page_array = paddr_to_physmap(selected.bookkeeping.base);
   LTRACEF("arena for base 0%#" PRIxPTR " size %#zx page array at %p size %#zx\n", base(), size(),
           raw_page_array, page_array_size);
-  memset(raw_page_array, 0, page_array_size);
   page_array_ = (vm_page_t*)raw_page_array;
 
-  // we've just constructed |page_count| pages in the state vm_page_state::FREE
-  vm_page::add_to_initial_count(vm_page_state::FREE, page_count);
-
   // compute the range of the array that backs the array itself
-  size_t array_start_index = (selected.bookkeeping.base - info_.base) / PAGE_SIZE;
-  size_t array_end_index = array_start_index + page_array_size / PAGE_SIZE;
-  LTRACEF("array_start_index %zu, array_end_index %zu, page_count %zu\n", array_start_index,
-          array_end_index, page_count);
+  array_start_index_ = (selected.bookkeeping.base - info_.base) / PAGE_SIZE;
+  array_end_index_ = array_start_index_ + page_array_size / PAGE_SIZE;
+  LTRACEF("array_start_index %zu, array_end_index %zu, page_count %zu\n", array_start_index_,
+          array_end_index_, page_count);
+
+  DEBUG_ASSERT(array_start_index_ < page_count && array_end_index_ <= page_count);
+
+  // Every chunk needs a bit in |initialized_chunks_|, whether or not initialization is deferred,
+  // so size the chunks to the arena.
+  SetInitChunkShift();
+  ASSERT(chunk_count() <= kMaxInitChunks);
+
+  // Clearing and linking the page structures of a large arena takes a long time, and the boot CPU
+  // is the only one running at this point. When deferring, only initialize the first chunk and the
+  // page array itself now, and leave the rest to InitDeferredChunk() once all CPUs are up.
+  if (defer) {
+    next_deferred_chunk_.store(1, ktl::memory_order_relaxed);
+    InitRangeEarly(base(), ktl::min(size(), init_chunk_pages() * PAGE_SIZE), node);
+    InitRangeEarly(selected.bookkeeping.base, selected.bookkeeping.size, node);
+  } else {
+    next_deferred_chunk_.store(chunk_count(), ktl::memory_order_relaxed);
+    InitRangeEarly(base(), size(), node);
+  }
+}
 
-  DEBUG_ASSERT(array_start_index < page_count && array_end_index <= page_count);
+void PmmArena::SetInitChunkShift() {
+  init_chunk_shift_ = kMinInitChunkShift;
+  while (chunk_count() > kMaxInitChunks) {
+    init_chunk_shift_++;
+  }
+}
+
+void PmmArena::InitChunk(size_t chunk, list_node* free_list) {
+  const size_t first = chunk << init_chunk_shift_;
+  const size_t last = ktl::min(first + init_chunk_pages(), size() / PAGE_SIZE);
+  memset(&page_array_[first], 0, (last - first) * sizeof(vm_page));
+
+  // we've just constructed |last - first| pages in the state vm_page_state::FREE
+  vm_page::add_to_initial_count(vm_page_state::FREE, last - first);
 
   // add all pages that aren't part of the page array to the free list
   // pages part of the free array go to the WIRED state
-  list_node list;
-  list_initialize(&list);
-  for (size_t i = 0; i < page_count; i++) {
+  for (size_t i = first; i < last; i++) {
     auto& p = page_array_[i];
 
     p.paddr_priv = base() + i * PAGE_SIZE;
-    if (i >= array_start_index && i < array_end_index) {
+    if (i >= array_start_index_ && i < array_end_index_) {
       p.set_state(vm_page_state::WIRED);
     } else {
-      list_add_tail(&list, &p.queue_node);
+      list_add_tail(free_list, &p.queue_node);
     }
   }
+}
+
+void PmmArena::InitRangeEarly(paddr_t pa, size_t length, PmmNode* node) {
+  DEBUG_ASSERT(length > 0);
+  DEBUG_ASSERT(address_in_arena(pa) && address_in_arena(pa + length - 1));
+
+  const size_t first_chunk = ((pa - base()) / PAGE_SIZE) >> init_chunk_shift_;
+  const size_t last_chunk = ((pa + length - 1 - base()) / PAGE_SIZE) >> init_chunk_shift_;
+
+  list_node list;
+  list_initialize(&list);
+  for (size_t chunk = first_chunk; chunk <= last_chunk; chunk++) {
+    if (page_initialized(chunk << init_chunk_shift_)) {
+      continue;
+    }
+    InitChunk(chunk, &list);
+    MarkChunkInitialized(chunk);
+  }
+  if (!list_is_empty(&list)) {
+    node->AddFreePages(&list);
+  }
+}
 
-  node->AddFreePages(&list);
+bool PmmArena::InitDeferredChunk(PmmNode* node) {
+  for (;;) {
+    const size_t chunk = next_deferred_chunk_.fetch_add(1, ktl::memory_order_relaxed);
+    if (chunk >= chunk_count()) {
+      return false;
+    }
+    // Chunks holding boot reservations were initialized early.
+    if (page_initialized(chunk << init_chunk_shift_)) {
+      continue;
+    }
+
+    list_node list;
+    list_initialize(&list);
+    InitChunk(chunk, &list);
+    node->AddDeferredFreePages(this, chunk, &list);
+    return true;
+  }
 }
 
 void PmmArena::InitForTest(const pmm_arena_info_t& info, vm_page_t* page_array) {
   info_ = info;
   page_array_ = page_array;
+  SetInitChunkShift();
+  for (size_t chunk = 0; chunk < chunk_count(); chunk++) {
+    MarkChunkInitialized(chunk);
+  }
+  next_deferred_chunk_.store(chunk_count(), ktl::memory_order_relaxed);
 }
 
 vm_page_t* PmmArena::FindSpecific(paddr_t pa) {
@@ -105,6 +178,9 @@ vm_page_t* PmmArena::FindSpecific(paddr_t pa) {
 
   DEBUG_ASSERT(index < size() / PAGE_SIZE);
 
+  if (!page_initialized(index)) {
+    return nullptr;
+  }
   return get_page(index);
 }
 
@@ -122,10 +198,41 @@ static uint64_t Align(uint64_t offset, uint8_t alignment_log2, uint64_t first_al
   return ROUNDUP(offset - first_aligned_offset, 1UL << (offset_alignment)) + first_aligned_offset;
 }
 
-zx::result<uint64_t> PmmArena::FindLastNonFree(uint64_t offset, size_t count) const {
+bool PmmArena::CheckBlockFull(size_t block) {
+  const size_t first = block << kSummaryBlockShift;
+  const size_t last = ktl::min(first + kSummaryBlockPages, size() / PAGE_SIZE);
+  for (size_t i = first; i < last; i++) {
+    if (page_free(i)) {
+      return false;
+    }
+  }
+  full_blocks_[block / 64] |= 1ul << (block % 64);
+  return true;
+}
+
+zx::result<uint64_t> PmmArena::FindLastNonFree(uint64_t offset, size_t count) {
+  // Only large regions use the summary, as verifying a block costs as much as a region of a block.
+  const bool use_summary = !full_blocks_.empty() && count >= kSummaryBlockPages;
+  const uint64_t arena_last = size() / PAGE_SIZE - 1;
+
   uint64_t i = offset + count - 1;
   do {
-    if (!page_array_[i].is_free()) {
+    if (use_summary) {
+      const size_t block = i >> kSummaryBlockShift;
+      const uint64_t block_last = ktl::min(((block + 1) << kSummaryBlockShift) - 1, arena_last);
+      // No run can include a page of a full block, so skip to the end of the block.
+      if (block_known_full(block)) {
+        counter_full_blocks_skipped.Add(1);
+        return zx::ok(block_last);
+      }
+      // Finding the last page of a block in use is a hint that the whole block might be, and if
+      // it is then later searches can skip it.
+      if (i == block_last && !page_free(i) && CheckBlockFull(block)) {
+        return zx::ok(block_last);
+      }
+    }
+    // Pages that are not initialized yet are not available to allocate.
+    if (!page_free(i)) {
       return zx::ok(i);
     }
   } while (i-- > offset);
@@ -201,7 +308,9 @@ vm_page_t* PmmArena::FindFreeContiguous(size_t count, uint8_t alignment_log2) {
 
 void PmmArena::CountStates(PmmStateCount* state_count) const {
   for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-    (*state_count)[VmPageStateIndex(page_array_[i].state())]++;
+    if (page_initialized(i)) {
+      (*state_count)[VmPageStateIndex(page_array_[i].state())]++;
+    }
   }
 }
 
@@ -213,7 +322,9 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges, PmmStateCount* count
   // dump all of the pages
   if (dump_pages) {
     for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-      page_array_[i].dump();
+      if (page_initialized(i)) {
+        page_array_[i].dump();
+      }
     }
   }
 
@@ -232,7 +343,7 @@ void PmmArena::Dump(bool dump_pages, bool dump_free_ranges, PmmStateCount* count
     printf("\tfree ranges:\n");
     ssize_t last = -1;
     for (size_t i = 0; i < size() / PAGE_SIZE; i++) {
-      if (page_array_[i].is_free()) {
+      if (page_initialized(i) && page_array_[i].is_free()) {
         if (last == -1) {
           last = i;
         }
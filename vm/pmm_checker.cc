@@ -62,23 +62,55 @@ void PmmChecker::SetFillSize(size_t fill_size) {
   fill_size_ = fill_size;
 }
 
+void PmmChecker::SetSampleRate(uint64_t sample_rate) {
+  DEBUG_ASSERT(sample_rate > 0);
+  DEBUG_ASSERT(!armed_);
+  sample_rate_ = sample_rate;
+}
+
+bool PmmChecker::IsSampled(const vm_page_t* page) const {
+  if (sample_rate_ == 1) {
+    return true;
+  }
+  // Scramble the page number so that the sampled pages are spread out, rather than every page at a
+  // fixed stride that could line up with how memory is used.
+  const uint64_t hash = (page->paddr() >> PAGE_SIZE_SHIFT) * 0x9e3779b97f4a7c15ull;
+  return (hash >> 32) % sample_rate_ == 0;
+}
+
 void PmmChecker::Arm() { armed_ = true; }
 
 void PmmChecker::FillPattern(vm_page_t* page) const {
+  if (!IsSampled(page)) {
+    return;
+  }
   void* kvaddr = paddr_to_physmap(page->paddr());
   DEBUG_ASSERT(is_kernel_address(reinterpret_cast<vaddr_t>(kvaddr)));
   __unsanitized_memset(kvaddr, kPatternOneByte, fill_size_);
 }
 
 NO_ASAN bool PmmChecker::ValidatePattern(vm_page_t* page) const {
-  if (!armed_) {
+  if (!armed_ || !IsSampled(page)) {
     return true;
   }
 
-  // Validate the pattern.  There's a decent chance that, on arm64, checking 8 bytes at a time will
-  // be faster than 1 byte at time.
-  auto kvaddr = static_cast<uint64_t*>(paddr_to_physmap(page->paddr()));
-  for (size_t j = 0; j < fill_size_ / 8; ++j) {
+  // Validate the pattern 8 bytes at a time, folding a cache line worth of comparisons into a single
+  // branch. The fill size is a multiple of 8 bytes, but may be smaller than a cache line, so finish
+  // off any remainder one word at a time.
+  auto kvaddr = static_cast<const uint64_t*>(paddr_to_physmap(page->paddr()));
+  constexpr size_t kWordsPerStep = 8;
+  const size_t words = fill_size_ / 8;
+  size_t j = 0;
+  for (; j + kWordsPerStep <= words; j += kWordsPerStep) {
+    uint64_t diff = 0;
+    for (size_t k = 0; k < kWordsPerStep; ++k) {
+      diff |= kvaddr[j + k] ^ kPattern;
+    }
+    if (diff != 0) {
+      return false;
+    }
+  }
+  for (; j < words; ++j) {
     if (kvaddr[j] != kPattern) {
       return false;
     }
@@ -102,8 +134,8 @@ void PmmChecker::AssertPattern(vm_page_t* page) const {
 }
 
 void PmmChecker::PrintStatus(FILE* f) const {
-  fprintf(f, "PMM: pmm checker %s, fill size is %lu, action is ", armed_ ? "enabled" : "disabled",
-          fill_size_);
+  fprintf(f, "PMM: pmm checker %s, fill size is %lu, sample rate is 1 in %lu, action is ",
+          armed_ ? "enabled" : "disabled", fill_size_, sample_rate_);
   BootOptions::PrintValue(action_, f);
   putc('\n', f);
 }
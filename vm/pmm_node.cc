@@ -15,6 +15,7 @@
 #include <lib/instrumentation/asan.h>
 #include <lib/memalloc/range.h>
 #include <lib/zircon-internal/macros.h>
+#include <string.h>
 #include <trace.h>
 
 #include <new>
@@ -22,8 +23,11 @@
 #include <fbl/algorithm.h>
 #include <kernel/auto_preempt_disabler.h>
 #include <kernel/mp.h>
+#include <kernel/percpu.h>
 #include <kernel/scheduler.h>
 #include <kernel/thread.h>
+#include <ktl/algorithm.h>
+#include <ktl/array.h>
 #include <phys/handoff.h>
 #include <pretty/cpp/sizes.h>
 #include <vm/compression.h>
@@ -39,6 +43,17 @@
 // The number of PMM allocation calls that have failed.
 KCOUNTER(pmm_alloc_failed, "vm.pmm.alloc.failed")
 KCOUNTER(pmm_alloc_delayed, "vm.pmm.alloc.delayed")
+// Single page allocations and frees serviced by a per-CPU magazine, and the number of pages moved
+// between the magazines and the free list.
+KCOUNTER(pmm_magazine_alloc_hit, "vm.pmm.magazine.alloc_hit")
+KCOUNTER(pmm_magazine_free_hit, "vm.pmm.magazine.free_hit")
+KCOUNTER(pmm_magazine_refill_pages, "vm.pmm.magazine.refill_pages")
+KCOUNTER(pmm_magazine_drain_pages, "vm.pmm.magazine.drain_pages")
+KCOUNTER(pmm_large_page_alloc, "vm.pmm.large_page.alloc")
+KCOUNTER(pmm_large_page_alloc_failed, "vm.pmm.large_page.alloc_failed")
+KCOUNTER(pmm_numa_remote_alloc, "vm.pmm.numa.remote_alloc")
+// The most loaned pages that have been borrowed at once.
+KCOUNTER_DECLARE(pmm_loaned_used_max, "vm.pmm.loaned.max_used", Max)
 
 namespace {
 
@@ -63,7 +78,7 @@ void AsanUnpoisonPage(vm_page_t* p) {
 
 void ReturnPagesToFreeList(list_node* target_list, list_node* to_free) {
   if constexpr (!__has_feature(address_sanitizer)) {
-    // splice list at the head of free_list_; free_loaned_list_.
+    // splice list at the head of the free list.
     list_splice_after(to_free, target_list);
   } else {
     // If address sanitizer is enabled, put the pages at the tail to maximize reuse distance.
@@ -81,7 +96,7 @@ void ReturnPagesToFreeList(list_node* target_list, list_node* to_free) {
 // during early boot before threading exists.
 zx_status_t PmmNode::Init(ktl::span<const memalloc::Range> ranges) TA_NO_THREAD_SAFETY_ANALYSIS {
   // Make sure we're in early boot (ints disabled and no active Schedulers)
-  DEBUG_ASSERT(Scheduler::PeekActiveMask() == 0);
+  DEBUG_ASSERT(Scheduler::PeekActiveMask().none());
   DEBUG_ASSERT(arch_ints_disabled());
 
   zx_status_t status = ZX_OK;
@@ -144,6 +159,8 @@ zx_status_t PmmNode::Init(ktl::span<const memalloc::Range> ranges) TA_NO_THREAD_
     }
 
     DEBUG_ASSERT(arena->address_in_arena(range.end() - 1));
+    // Reserving the range needs its page structures, even if the rest of its chunk was deferred.
+    arena->InitRangeEarly(range.addr, range.size, this);
     InitReservedRange(range);
     return true;
   };
@@ -195,7 +212,7 @@ void PmmNode::AddFreePages(list_node* list) TA_NO_THREAD_SAFETY_ANALYSIS {
     DEBUG_ASSERT(!page->is_loaned());
     DEBUG_ASSERT(!page->is_loan_cancelled());
     DEBUG_ASSERT(page->is_free());
-    list_add_tail(&free_list_, &page->queue_node);
+    list_add_tail(&free_lists_[PageNumaNodeLocked(page)].pages, &page->queue_node);
     ++free_count;
   }
   free_count_.fetch_add(free_count);
@@ -205,7 +222,197 @@ void PmmNode::AddFreePages(list_node* list) TA_NO_THREAD_SAFETY_ANALYSIS {
   LTRACEF("free count now %" PRIu64 "\n", free_count_.load(ktl::memory_order_relaxed));
 }
 
+void PmmNode::AddDeferredFreePages(PmmArena* arena, size_t chunk, list_node* list) {
+  AutoPreemptDisabler preempt_disable;
+  const bool fill = IsFreeFillEnabledRacy();
+  uint64_t count = 0;
+  vm_page* page;
+  list_for_every_entry (list, page, vm_page, queue_node) {
+    if (fill) {
+      checker_.FillPattern(page);
+    }
+    count++;
+  }
+  Guard<Mutex> guard{&lock_};
+
+  // As in FreePageHelperLocked, free filling may have been enabled since it was checked above.
+  if (FreeFillEnabledLocked() && !fill) {
+    list_for_every_entry (list, page, vm_page, queue_node) {
+      checker_.FillPattern(page);
+    }
+  }
+
+  // Arena walks happen with lock_ held, so once the chunk is marked initialized here they see its
+  // pages as free only when the pages are also on the free lists.
+  arena->MarkChunkInitialized(chunk);
+  ReturnToFreeListsLocked(list);
+  IncrementFreeCountLocked(count);
+}
+
+// Arenas are only added during early boot, and their deferred chunks are claimed atomically, so
+// these do not need to hold lock_.
+bool PmmNode::HasDeferredPages() TA_NO_THREAD_SAFETY_ANALYSIS {
+  return ktl::any_of(active_arenas().begin(), active_arenas().end(),
+                     [](const PmmArena& a) { return a.has_deferred_chunks(); });
+}
+
+bool PmmNode::InitDeferredChunk() TA_NO_THREAD_SAFETY_ANALYSIS {
+  for (PmmArena& a : active_arenas()) {
+    if (a.InitDeferredChunk(this)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+zx_status_t PmmNode::SetNumaNodes(ktl::span<const NumaMemoryRange> ranges,
+                                  ktl::span<const uint8_t> cpu_nodes) {
+  if (ranges.size() > kMaxNumaRanges || cpu_nodes.size() > SMP_MAX_CPUS) {
+    return ZX_ERR_OUT_OF_RANGE;
+  }
+  size_t node_count = 1;
+  for (const NumaMemoryRange& range : ranges) {
+    if (range.node >= kMaxNumaNodes) {
+      return ZX_ERR_OUT_OF_RANGE;
+    }
+    node_count = ktl::max<size_t>(node_count, range.node + 1);
+  }
+  for (uint8_t node : cpu_nodes) {
+    if (node >= kMaxNumaNodes) {
+      return ZX_ERR_OUT_OF_RANGE;
+    }
+    node_count = ktl::max<size_t>(node_count, node + 1);
+  }
+
+  // Pages cached in the magazines were taken from the previous node's free lists, so send them back
+  // to be redistributed along with everything else.
+  DrainMagazines();
+
+  AutoPreemptDisabler preempt_disable;
+  Guard<Mutex> guard{&lock_};
+
+  ktl::copy(ranges.begin(), ranges.end(), numa_ranges_);
+  numa_range_count_ = ranges.size();
+  ktl::fill(ktl::copy(cpu_nodes.begin(), cpu_nodes.end(), cpu_numa_node_),
+            cpu_numa_node_ + SMP_MAX_CPUS, 0);
+
+  // Gather every free page and then sort them onto their new lists. Appending preserves the
+  // relative order of the pages, and so which of them are most recently freed.
+  list_node_t pages = LIST_INITIAL_VALUE(pages);
+  for (NumaFreeList& free_list : free_lists_) {
+    if (list_is_empty(&pages)) {
+      list_move(&free_list.pages, &pages);
+    } else {
+      list_splice_after(&free_list.pages, list_peek_tail(&pages));
+    }
+  }
+  numa_node_count_ = node_count;
+
+  vm_page_t* page;
+  while ((page = list_remove_head_type(&pages, vm_page, queue_node)) != nullptr) {
+    list_add_tail(&free_lists_[PageNumaNodeLocked(page)].pages, &page->queue_node);
+  }
+
+  return ZX_OK;
+}
+
+uint8_t PmmNode::PageNumaNodeLocked(const vm_page_t* page) const {
+  if (numa_node_count_ == 1) {
+    return 0;
+  }
+  const paddr_t pa = page->paddr();
+  for (const NumaMemoryRange& range : ktl::span(numa_ranges_, numa_range_count_)) {
+    if (pa >= range.base && pa - range.base < range.size) {
+      return range.node;
+    }
+  }
+  return 0;
+}
+
+uint8_t PmmNode::CurrentNumaNodeLocked() const {
+  DEBUG_ASSERT(Thread::Current::preemption_state().PreemptIsEnabled() == false);
+  return cpu_numa_node_[arch_curr_cpu_num()];
+}
+
+void PmmNode::AddToFreeListLocked(vm_page_t* page) {
+  list_node* free_list = &free_lists_[PageNumaNodeLocked(page)].pages;
+  if constexpr (!__has_feature(address_sanitizer)) {
+    list_add_head(free_list, &page->queue_node);
+  } else {
+    // If address sanitizer is enabled, put the page at the tail to maximize reuse distance.
+    list_add_tail(free_list, &page->queue_node);
+  }
+}
+
+void PmmNode::ReturnToFreeListsLocked(list_node* list) {
+  if (numa_node_count_ == 1) {
+    ReturnPagesToFreeList(&free_lists_[0].pages, list);
+    return;
+  }
+  // Walk the list from the tail so that, when pages are added at the head, each free list ends up
+  // with them in the same order that splicing the whole list would have produced.
+  vm_page_t* page;
+  while ((page = list_remove_tail_type(list, vm_page, queue_node)) != nullptr) {
+    AddToFreeListLocked(page);
+  }
+}
+
+vm_page_t* PmmNode::RemoveFreePageLocked() {
+  const uint8_t local = CurrentNumaNodeLocked();
+  for (size_t i = 0; i < numa_node_count_; i++) {
+    list_node* free_list = &free_lists_[(local + i) % numa_node_count_].pages;
+    vm_page_t* page = list_remove_head_type(free_list, vm_page, queue_node);
+    if (page) {
+      if (i != 0) {
+        pmm_numa_remote_alloc.Add(1);
+      }
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+template <typename F>
+void PmmNode::RemoveFreePagesLocked(uint64_t count, list_node* list, F per_page) {
+  const uint8_t local = CurrentNumaNodeLocked();
+  for (size_t i = 0; i < numa_node_count_ && count > 0; i++) {
+    list_node* free_list = &free_lists_[(local + i) % numa_node_count_].pages;
+    list_node_t* node = free_list;
+    uint64_t taken = 0;
+    for (list_node_t* next; taken < count && (next = list_next(free_list, node)) != nullptr;
+         taken++) {
+      node = next;
+      per_page(containerof(node, vm_page, queue_node));
+    }
+    if (taken == 0) {
+      continue;
+    }
+
+    // Want to take the pages ranging from the start of free_list up to node, and place them in
+    // list. Due to how the listnode operations work, it's easier to move the entire free list out,
+    // then split the pages that we are not taking back into it.
+    list_node_t taken_list = LIST_INITIAL_VALUE(taken_list);
+    list_move(free_list, &taken_list);
+    list_split_after(&taken_list, node, free_list);
+    if (list_is_empty(list)) {
+      list_move(&taken_list, list);
+    } else {
+      list_splice_after(&taken_list, list_peek_tail(list));
+    }
+
+    count -= taken;
+    if (i != 0) {
+      pmm_numa_remote_alloc.Add(static_cast<int64_t>(taken));
+    }
+  }
+  DEBUG_ASSERT(count == 0);
+}
+
 void PmmNode::FillFreePagesAndArm() {
+  // Free filling bypasses the magazines, so once any pages cached prior to it being enabled are
+  // returned every free page will be on one of the free lists.
+  DrainMagazines();
+
   // Require both locks so we can process both of the free lists and modify all_free_pages_filled_.
   Guard<Mutex> loaned_guard{&loaned_list_lock_};
   Guard<Mutex> free_guard{&lock_};
@@ -215,8 +422,10 @@ void PmmNode::FillFreePagesAndArm() {
   }
 
   vm_page* page;
-  list_for_every_entry (&free_list_, page, vm_page, queue_node) {
-    checker_.FillPattern(page);
+  for (NumaFreeList& free_list : free_lists_) {
+    list_for_every_entry (&free_list.pages, page, vm_page, queue_node) {
+      checker_.FillPattern(page);
+    }
   }
   list_for_every_entry (&free_loaned_list_, page, vm_page, queue_node) {
     checker_.FillPattern(page);
@@ -230,6 +439,8 @@ void PmmNode::FillFreePagesAndArm() {
 }
 
 void PmmNode::CheckAllFreePages() {
+  DrainMagazines();
+
   // Require both locks so we can process both of the free lists. This is an infrequent manual
   // operation and does not need to be optimized to avoid holding both locks at once.
   Guard<Mutex> loaned_guard{&loaned_list_lock_};
@@ -242,9 +453,11 @@ void PmmNode::CheckAllFreePages() {
   uint64_t free_page_count = 0;
   uint64_t free_loaned_page_count = 0;
   vm_page* page;
-  list_for_every_entry (&free_list_, page, vm_page, queue_node) {
-    checker_.AssertPattern(page);
-    ++free_page_count;
+  for (NumaFreeList& free_list : free_lists_) {
+    list_for_every_entry (&free_list.pages, page, vm_page, queue_node) {
+      checker_.AssertPattern(page);
+      ++free_page_count;
+    }
   }
   list_for_every_entry (&free_loaned_list_, page, vm_page, queue_node) {
     checker_.AssertPattern(page);
@@ -255,6 +468,45 @@ void PmmNode::CheckAllFreePages() {
   ASSERT(free_loaned_page_count == free_loaned_count_.load(ktl::memory_order_relaxed));
 }
 
+uint64_t PmmNode::CheckFreePagesIncremental(uint64_t max_pages) {
+  // Pages are walked in small batches, dropping the locks in between, so that allocations are not
+  // held up for the whole walk.
+  constexpr uint64_t kBatchPages = 256;
+  uint64_t checked = 0;
+  while (max_pages > 0) {
+    // Both locks are needed as free pages may be on either of the free lists.
+    Guard<Mutex> loaned_guard{&loaned_list_lock_};
+    Guard<Mutex> free_guard{&lock_};
+    if (!checker_.IsArmed() || active_arenas().empty()) {
+      break;
+    }
+    if (checker_cursor_arena_ >= active_arenas().size()) {
+      checker_cursor_arena_ = 0;
+      checker_cursor_index_ = 0;
+    }
+    PmmArena& arena = active_arenas()[checker_cursor_arena_];
+    const uint64_t arena_pages = arena.size() / PAGE_SIZE;
+    const uint64_t end =
+        ktl::min(arena_pages, checker_cursor_index_ + ktl::min(max_pages, kBatchPages));
+    max_pages -= end - checker_cursor_index_;
+    for (; checker_cursor_index_ < end; checker_cursor_index_++) {
+      if (!arena.page_initialized(checker_cursor_index_)) {
+        continue;
+      }
+      vm_page_t* page = arena.get_page(checker_cursor_index_);
+      if (page->is_free() || page->is_free_loaned()) {
+        checker_.AssertPattern(page);
+        checked++;
+      }
+    }
+    if (checker_cursor_index_ == arena_pages) {
+      checker_cursor_arena_++;
+      checker_cursor_index_ = 0;
+    }
+  }
+  return checked;
+}
+
 #if __has_feature(address_sanitizer)
 void PmmNode::PoisonAllFreePages() {
   // Require both locks so we can process both of the free lists. This is an infrequent manual
@@ -263,16 +515,19 @@ void PmmNode::PoisonAllFreePages() {
   Guard<Mutex> free_guard{&lock_};
 
   vm_page* page;
-  list_for_every_entry (&free_list_, page, vm_page, queue_node) {
-    AsanPoisonPage(page, kAsanPmmFreeMagic);
-  };
+  for (NumaFreeList& free_list : free_lists_) {
+    list_for_every_entry (&free_list.pages, page, vm_page, queue_node) {
+      AsanPoisonPage(page, kAsanPmmFreeMagic);
+    };
+  }
   list_for_every_entry (&free_loaned_list_, page, vm_page, queue_node) {
     AsanPoisonPage(page, kAsanPmmFreeMagic);
   };
 }
 #endif  // __has_feature(address_sanitizer)
 
-bool PmmNode::EnableFreePageFilling(size_t fill_size, CheckFailAction action) {
+bool PmmNode::EnableFreePageFilling(size_t fill_size, CheckFailAction action,
+                                    uint64_t sample_rate) {
   // Require both locks so we can manipulate free_fill_enabled_.
   Guard<Mutex> loaned_guard{&loaned_list_lock_};
   Guard<Mutex> free_guard{&lock_};
@@ -281,6 +536,7 @@ bool PmmNode::EnableFreePageFilling(size_t fill_size, CheckFailAction action) {
     return false;
   }
   checker_.SetFillSize(fill_size);
+  checker_.SetSampleRate(sample_rate);
   checker_.SetAction(action);
   // As free_fill_enabled_ may be examined outside of the lock, ensure the manipulations to checker_
   // complete first by performing a release. See IsFreeFillEnabledRacy for where the acquire is
@@ -344,6 +600,8 @@ zx::result<vm_page_t*> PmmNode::AllocLoanedPage(
     AllocLoanedPageHelperLocked(page);
 
     DecrementFreeLoanedCountLocked(1);
+    kcounter_max(pmm_loaned_used_max, loaned_count_.load(ktl::memory_order_relaxed) -
+                                          free_loaned_count_.load(ktl::memory_order_relaxed));
 
     // Run the callback while still holding the lock.
     allocated(page);
@@ -367,6 +625,13 @@ zx::result<vm_page_t*> PmmNode::AllocPage(uint alloc_flags) {
 
   {
     AutoPreemptDisabler preempt_disable;
+    if (MagazinesActiveRacy()) {
+      page = AllocPageFromMagazine(CurrentMagazine(), alloc_flags);
+      if (page) {
+        return zx::ok(page);
+      }
+    }
+
     Guard<Mutex> guard{&lock_};
     free_list_had_fill_pattern = FreePagesFilledLocked();
 
@@ -375,7 +640,13 @@ zx::result<vm_page_t*> PmmNode::AllocPage(uint alloc_flags) {
       return zx::error(ZX_ERR_SHOULD_WAIT);
     }
 
-    page = list_remove_head_type(&free_list_, vm_page, queue_node);
+    page = RemoveFreePageLocked();
+    if (!page && magazine_count_.load(ktl::memory_order_relaxed) > 0) {
+      // Free pages may be stranded in other CPUs' magazines; reclaim them before failing.
+      guard.CallUnlocked([this]() { DrainMagazines(); });
+      free_list_had_fill_pattern = FreePagesFilledLocked();
+      page = RemoveFreePageLocked();
+    }
     if (!page) {
       // Allocation failures from the regular free list are likely to become user-visible.
       ReportAllocFailureLocked(AllocFailure{.type = AllocFailure::Type::Pmm, .size = 1});
@@ -426,6 +697,12 @@ zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list)
     // based on whether allocated loaned pages or not, setup which_list to point directly to the
     // appropriate free list to simplify later allocation code that operates on either list.
 
+    if (unlikely(count > free_count) && magazine_count_.load(ktl::memory_order_relaxed) > 0) {
+      guard.CallUnlocked([this]() { DrainMagazines(); });
+      free_list_had_fill_pattern = FreePagesFilledLocked();
+      free_count = free_count_.load(ktl::memory_order_relaxed);
+    }
+
     if (unlikely(count > free_count)) {
       if ((alloc_flags & PMM_ALLOC_FLAG_CAN_WAIT) && should_wait_ != ShouldWaitState::Never) {
         pmm_alloc_delayed.Add(1);
@@ -443,19 +720,8 @@ zx_status_t PmmNode::AllocPages(size_t count, uint alloc_flags, list_node* list)
       pmm_alloc_delayed.Add(1);
       return ZX_ERR_SHOULD_WAIT;
     }
-    list_node_t* node = &free_list_;
-    while (count > 0) {
-      node = list_next(&free_list_, node);
-      AllocPageHelperLocked(containerof(node, vm_page, queue_node));
-      --count;
-    }
-
-    // Want to take the pages ranging from the start of the list (identified by which_list) up to
-    // node, and place them in alloc_list. Due to how the listnode operations work, it's easier to
-    // move the entire list into alloc_list, then split the pages that we are not allocating back
-    // into which_list.
-    list_move(&free_list_, &alloc_list);
-    list_split_after(&alloc_list, node, &free_list_);
+    RemoveFreePagesLocked(count, &alloc_list,
+                          [this](vm_page_t* page) TA_REQ(lock_) { AllocPageHelperLocked(page); });
   }
 
   // Check the pages we are allocating before appending them into the user's allocation list. Do
@@ -576,6 +842,46 @@ zx_status_t PmmNode::AllocContiguous(const size_t count, uint alloc_flags, uint8
   AutoPreemptDisabler preempt_disable;
   Guard<Mutex> guard{&lock_};
 
+  // Pages cached in the magazines are not FREE and so break up runs. Only pay for draining them if
+  // the first search fails.
+  for (bool drained = false;; drained = true) {
+    zx_status_t status = AllocContiguousLocked(count, alignment_log2, pa, list);
+    if (status != ZX_ERR_NOT_FOUND || drained ||
+        magazine_count_.load(ktl::memory_order_relaxed) == 0) {
+      return status;
+    }
+    guard.CallUnlocked([this]() { DrainMagazines(); });
+  }
+}
+
+zx_status_t PmmNode::AllocLargePage(paddr_t* pa, list_node* list) {
+  DEBUG_ASSERT(Thread::Current::memory_allocation_state().IsEnabled());
+  DEBUG_ASSERT(pa);
+  DEBUG_ASSERT(list);
+
+  AutoPreemptDisabler preempt_disable;
+  Guard<Mutex> guard{&lock_};
+
+  // Large pages are never required, so do not let them consume the last of the free memory that
+  // regular allocations would otherwise be waiting on.
+  if (ShouldDelayAllocationLocked() ||
+      free_count_.load(ktl::memory_order_relaxed) <
+          should_wait_free_pages_level_ + kLargePageCount) {
+    pmm_large_page_alloc_failed.Add(1);
+    return ZX_ERR_NOT_FOUND;
+  }
+
+  zx_status_t status = AllocContiguousLocked(kLargePageCount, kLargePageShift, pa, list);
+  if (status != ZX_OK) {
+    pmm_large_page_alloc_failed.Add(1);
+    return status;
+  }
+  pmm_large_page_alloc.Add(1);
+  return ZX_OK;
+}
+
+zx_status_t PmmNode::AllocContiguousLocked(size_t count, uint8_t alignment_log2, paddr_t* pa,
+                                           list_node* list) {
   for (auto& a : active_arenas()) {
     // FindFreeContiguous will search the arena for FREE pages. As we hold lock_, any pages in the
     // FREE state are assumed to be owned by us, and would only be modified if lock_ were held.
@@ -625,7 +931,15 @@ zx_status_t PmmNode::InitArena(const PmmArenaSelection& selected) TA_NO_THREAD_S
     return ZX_ERR_NOT_SUPPORTED;
   }
 
-  arenas_[used_arena_count_++].Init(selected, this);
+  const size_t arena_ix = used_arena_count_++;
+  arenas_[arena_ix].Init(selected, this, gBootOptions->pmm_deferred_page_init);
+
+  // Insert the arena into |arenas_by_base_|, keeping it sorted.
+  size_t i = arena_ix;
+  for (; i > 0 && arenas_[arenas_by_base_[i - 1]].base() > arenas_[arena_ix].base(); i--) {
+    arenas_by_base_[i] = arenas_by_base_[i - 1];
+  }
+  arenas_by_base_[i] = static_cast<uint8_t>(arena_ix);
   arena_cumulative_size_ += selected.arena.size;
   return ZX_OK;
 }
@@ -689,6 +1003,7 @@ void PmmNode::FreePageHelperLocked(vm_page* page, bool already_filled) {
   // 1. Be performing set_state here under the lock_
   // 2. Place the page in the free list and cease referring to the page before ever dropping lock_
   page->set_state(vm_page_state::FREE);
+  MarkArenaBlockMayHaveFreeLocked(page);
 
   // This page cannot be loaned.
   DEBUG_ASSERT(!page->is_loaned());
@@ -704,6 +1019,35 @@ void PmmNode::FreePageHelperLocked(vm_page* page, bool already_filled) {
   AsanPoisonPage(page, kAsanPmmFreeMagic);
 }
 
+void PmmNode::MarkArenaBlockMayHaveFreeLocked(vm_page_t* page) {
+  if (!full_block_summaries_) {
+    return;
+  }
+  if (PmmArena* arena = ArenaForPageLocked(page); arena != nullptr) {
+    arena->MarkBlockMayHaveFree(arena->get_index(page));
+  }
+}
+
+PmmArena* PmmNode::ArenaForPageLocked(const vm_page_t* page) {
+  // Find the last arena whose base is at or below the page, which is the only one that may hold it.
+  const paddr_t paddr = page->paddr();
+  size_t low = 0;
+  size_t high = used_arena_count_;
+  while (low < high) {
+    const size_t mid = low + (high - low) / 2;
+    if (arenas_[arenas_by_base_[mid]].base() <= paddr) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  if (low == 0) {
+    return nullptr;
+  }
+  PmmArena& arena = arenas_[arenas_by_base_[low - 1]];
+  return arena.page_belongs_to_arena(page) ? &arena : nullptr;
+}
+
 void PmmNode::FreeLoanedPageHelperLocked(vm_page* page, bool already_filled) {
   LTRACEF("page %p state %zu paddr %#" PRIxPTR "\n", page, VmPageStateIndex(page->state()),
           page->paddr());
@@ -846,6 +1190,9 @@ void PmmNode::WithLoanedPage(vm_page_t* page, fit::inline_function<void(vm_page_
 void PmmNode::FreePage(vm_page* page) {
   AutoPreemptDisabler preempt_disable;
   DEBUG_ASSERT(!page->is_loaned());
+  if (MagazinesActiveRacy() && FreePageToMagazine(CurrentMagazine(), page)) {
+    return;
+  }
   const bool fill = IsFreeFillEnabledRacy();
   if (fill) {
     checker_.FillPattern(page);
@@ -858,12 +1205,7 @@ void PmmNode::FreePage(vm_page* page) {
   FreePageHelperLocked(page, fill);
 
   IncrementFreeCountLocked(1);
-  if constexpr (!__has_feature(address_sanitizer)) {
-    list_add_head(&free_list_, &page->queue_node);
-  } else {
-    // If address sanitizer is enabled, put the page at the tail to maximize reuse distance.
-    list_add_tail(&free_list_, &page->queue_node);
-  }
+  AddToFreeListLocked(page);
 }
 
 template <typename F>
@@ -906,7 +1248,7 @@ void PmmNode::FreeListLocked(list_node* list, bool already_filled) {
     }
   }  // end scope page
 
-  ReturnPagesToFreeList(&free_list_, list);
+  ReturnToFreeListsLocked(list);
 
   IncrementFreeCountLocked(count);
 }
@@ -978,7 +1320,8 @@ bool PmmNode::ShouldDelayAllocationLocked() {
 }
 
 uint64_t PmmNode::CountFreePages() const TA_NO_THREAD_SAFETY_ANALYSIS {
-  return free_count_.load(ktl::memory_order_relaxed);
+  return free_count_.load(ktl::memory_order_relaxed) +
+         magazine_count_.load(ktl::memory_order_relaxed);
 }
 
 uint64_t PmmNode::CountLoanedFreePages() const TA_NO_THREAD_SAFETY_ANALYSIS {
@@ -1016,11 +1359,12 @@ void PmmNode::Dump(bool is_panic) const {
   auto dump = [this]() TA_NO_THREAD_SAFETY_ANALYSIS {
     uint64_t free_count = free_count_.load(ktl::memory_order_relaxed);
     uint64_t free_loaned_count = free_loaned_count_.load(ktl::memory_order_relaxed);
+    uint64_t magazine_count = magazine_count_.load(ktl::memory_order_relaxed);
     printf(
-        "pmm node %p: free_count %zu (%zu bytes), free_loaned_count: %zu (%zu bytes), total size "
-        "%zu\n",
+        "pmm node %p: free_count %zu (%zu bytes), free_loaned_count: %zu (%zu bytes), "
+        "magazine_count: %zu (%zu bytes), total size %zu\n",
         this, free_count, free_count * PAGE_SIZE, free_loaned_count, free_loaned_count * PAGE_SIZE,
-        arena_cumulative_size_);
+        magazine_count, magazine_count * PAGE_SIZE, arena_cumulative_size_);
     PmmStateCount count_sum = {};
     for (const auto& a : active_arenas()) {
       a.Dump(false, false, &count_sum);
@@ -1039,7 +1383,7 @@ void PmmNode::Dump(bool is_panic) const {
 
 void PmmNode::TripFreePagesLevelLocked() {
   if (should_wait_ == ShouldWaitState::OnceLevelTripped) {
-    should_wait_ = ShouldWaitState::UntilReset;
+    SetShouldWaitLocked(ShouldWaitState::UntilReset);
     free_pages_evt_.Unsignal();
   }
 }
@@ -1058,7 +1402,7 @@ bool PmmNode::SetFreeMemorySignal(uint64_t free_lower_bound, uint64_t free_upper
     TripFreePagesLevelLocked();
   } else if (should_wait_ == ShouldWaitState::UntilReset) {
     free_pages_evt_.Signal();
-    should_wait_ = ShouldWaitState::OnceLevelTripped;
+    SetShouldWaitLocked(ShouldWaitState::OnceLevelTripped);
   }
   should_wait_free_pages_level_ = delay_allocations_pages;
   mem_signal_lower_bound_ = free_lower_bound;
@@ -1075,7 +1419,7 @@ void PmmNode::SignalFreeMemoryChangeLocked() {
 
 void PmmNode::StopReturningShouldWait() {
   Guard<Mutex> guard{&lock_};
-  should_wait_ = ShouldWaitState::Never;
+  SetShouldWaitLocked(ShouldWaitState::Never);
   free_pages_evt_.Signal();
 }
 
@@ -1214,6 +1558,199 @@ void PmmNode::SeedRandomShouldWait() {
   }
 }
 
+zx_status_t PmmNode::InitMagazines(size_t magazine_size) {
+  DEBUG_ASSERT(!magazines_enabled_.load(ktl::memory_order_relaxed));
+  // Random should wait decisions are made under lock_, so the magazines must be bypassed for it to
+  // see every allocation.
+  if (magazine_size == 0 || gBootOptions->pmm_alloc_random_should_wait) {
+    return ZX_OK;
+  }
+
+  fbl::AllocChecker ac;
+  magazines_ = fbl::MakeArray<PageMagazine>(&ac, percpu::processor_count());
+  if (!ac.check()) {
+    return ZX_ERR_NO_MEMORY;
+  }
+  magazine_size_ = magazine_size;
+  magazine_batch_ = ktl::max<size_t>(magazine_size / 2, 1);
+  magazines_enabled_.store(true, ktl::memory_order_release);
+  return ZX_OK;
+}
+
+zx_status_t PmmNode::InitFullBlockSummaries() {
+  // The summaries cannot be allocated with lock_ held, as the heap may need to allocate pages, so
+  // size and allocate them first. Arenas are only added during early boot, so sizes are stable.
+  size_t words[kArenaCount] = {};
+  size_t arena_count;
+  {
+    Guard<Mutex> guard{&lock_};
+    arena_count = active_arenas().size();
+    for (size_t i = 0; i < arena_count; i++) {
+      words[i] = active_arenas()[i].full_block_summary_words();
+    }
+  }
+
+  ktl::array<fbl::Array<uint64_t>, kArenaCount> summaries;
+  for (size_t i = 0; i < arena_count; i++) {
+    fbl::AllocChecker ac;
+    summaries[i] = fbl::MakeArray<uint64_t>(&ac, words[i]);
+    if (!ac.check()) {
+      return ZX_ERR_NO_MEMORY;
+    }
+    memset(summaries[i].data(), 0, words[i] * sizeof(uint64_t));
+  }
+
+  AutoPreemptDisabler preempt_disable;
+  Guard<Mutex> guard{&lock_};
+  DEBUG_ASSERT(!full_block_summaries_);
+  for (size_t i = 0; i < arena_count; i++) {
+    active_arenas()[i].SetFullBlockSummary(ktl::move(summaries[i]));
+  }
+  full_block_summaries_ = true;
+  return ZX_OK;
+}
+
+PmmNode::PageMagazine& PmmNode::CurrentMagazine() {
+  DEBUG_ASSERT(Thread::Current::preemption_state().PreemptIsEnabled() == false);
+  const cpu_num_t cpu = arch_curr_cpu_num();
+  DEBUG_ASSERT(cpu < magazines_.size());
+  return magazines_[cpu];
+}
+
+vm_page_t* PmmNode::AllocPageFromMagazine(PageMagazine& magazine, uint alloc_flags) {
+  Guard<Mutex> guard{&magazine.lock};
+  // Free filling may have been enabled since MagazinesActiveRacy was checked. Any pages cached from
+  // now on would not have the pattern, so fall back to the free list.
+  if (IsFreeFillEnabledRacy()) {
+    return nullptr;
+  }
+  if (magazine.count == 0 && !RefillMagazineLocked(magazine, alloc_flags)) {
+    return nullptr;
+  }
+
+  vm_page_t* page = list_remove_head_type(&magazine.pages, vm_page, queue_node);
+  DEBUG_ASSERT(page);
+  DEBUG_ASSERT(page->state() == vm_page_state::CACHE && !page->is_loaned());
+  magazine.count--;
+  magazine_count_.fetch_sub(1, ktl::memory_order_relaxed);
+
+  AsanUnpoisonPage(page);
+  page->set_state(vm_page_state::ALLOC);
+  page->alloc.owner = nullptr;
+  pmm_magazine_alloc_hit.Add(1);
+  return page;
+}
+
+bool PmmNode::RefillMagazineLocked(PageMagazine& magazine, uint alloc_flags) {
+  DEBUG_ASSERT(magazine.count == 0);
+  Guard<Mutex> guard{&lock_};
+  // Let the slow path produce the ZX_ERR_SHOULD_WAIT, and do not hide pages from the free list once
+  // allocations are being delayed.
+  if (should_wait_ == ShouldWaitState::UntilReset ||
+      ((alloc_flags & PMM_ALLOC_FLAG_CAN_WAIT) && ShouldDelayAllocationLocked())) {
+    return false;
+  }
+  const uint64_t batch = ktl::min<uint64_t>(magazine_batch_, free_count_);
+  if (batch == 0) {
+    return false;
+  }
+
+  // Move the pages at the head of the free lists, which are the most recently freed, so that the
+  // magazine serves cache-warm pages.
+  RemoveFreePagesLocked(batch, &magazine.pages, [](vm_page_t* page) {
+    DEBUG_ASSERT(page->is_free() && !page->is_loaned());
+    // Leaving the FREE state transfers ownership to the magazine. Pages remain poisoned, as they
+    // are still free.
+    page->set_state(vm_page_state::CACHE);
+  });
+  magazine.count = batch;
+  magazine_count_.fetch_add(batch, ktl::memory_order_relaxed);
+
+  // Performed after the pages are in the magazine so that any free memory signals raised here are
+  // computed against a consistent CountFreePages.
+  DecrementFreeCountLocked(batch);
+  pmm_magazine_refill_pages.Add(static_cast<int64_t>(batch));
+  return true;
+}
+
+bool PmmNode::FreePageToMagazine(PageMagazine& magazine, vm_page_t* page) {
+  // pages freed individually shouldn't be in a queue
+  DEBUG_ASSERT(!list_in_list(&page->queue_node));
+  DEBUG_ASSERT(!page->is_free());
+  DEBUG_ASSERT(!page->is_free_loaned());
+  DEBUG_ASSERT(page->state() != vm_page_state::OBJECT ||
+               (page->object.pin_count == 0 && page->object.get_object() == nullptr));
+
+  list_node_t excess = LIST_INITIAL_VALUE(excess);
+  {
+    Guard<Mutex> guard{&magazine.lock};
+    // Checked under the magazine lock so that once DrainMagazines has visited this magazine, no
+    // unfilled pages can be added to it.
+    if (IsFreeFillEnabledRacy()) {
+      return false;
+    }
+    page->set_state(vm_page_state::CACHE);
+    AsanPoisonPage(page, kAsanPmmFreeMagic);
+    list_add_head(&magazine.pages, &page->queue_node);
+    magazine.count++;
+    magazine_count_.fetch_add(1, ktl::memory_order_relaxed);
+    pmm_magazine_free_hit.Add(1);
+
+    if (magazine.count <= magazine_size_) {
+      return true;
+    }
+
+    // Over capacity, return the coldest batch from the tail of the magazine to the free list. Keep
+    // the magazine lock held so that the pages are never absent from both magazine_count_ and
+    // free_count_.
+    list_node_t* node = &magazine.pages;
+    for (size_t i = magazine_batch_; i < magazine.count; i++) {
+      node = list_next(&magazine.pages, node);
+    }
+    list_split_after(&magazine.pages, node, &excess);
+    magazine.count -= magazine_batch_;
+
+    Guard<Mutex> free_guard{&lock_};
+    magazine_count_.fetch_sub(magazine_batch_, ktl::memory_order_relaxed);
+    ReturnMagazinePagesLocked(&excess);
+  }
+  pmm_magazine_drain_pages.Add(static_cast<int64_t>(magazine_batch_));
+  return true;
+}
+
+void PmmNode::ReturnMagazinePagesLocked(list_node* list) {
+  // Unpoison so that, should free filling have been enabled, the fill pattern can be written by
+  // FreeListLocked, which will re-poison the pages.
+  vm_page_t* page;
+  list_for_every_entry (list, page, vm_page, queue_node) {
+    DEBUG_ASSERT(page->state() == vm_page_state::CACHE);
+    AsanUnpoisonPage(page);
+  }
+  FreeListLocked(list, false);
+}
+
+void PmmNode::DrainMagazines() {
+  if (!magazines_enabled_.load(ktl::memory_order_acquire)) {
+    return;
+  }
+  AutoPreemptDisabler preempt_disable;
+  for (PageMagazine& magazine : magazines_) {
+    Guard<Mutex> guard{&magazine.lock};
+    if (magazine.count == 0) {
+      continue;
+    }
+    const size_t count = magazine.count;
+    list_node_t pages = LIST_INITIAL_VALUE(pages);
+    list_move(&magazine.pages, &pages);
+    magazine.count = 0;
+
+    Guard<Mutex> free_guard{&lock_};
+    magazine_count_.fetch_sub(count, ktl::memory_order_relaxed);
+    ReturnMagazinePagesLocked(&pages);
+    pmm_magazine_drain_pages.Add(static_cast<int64_t>(count));
+  }
+}
+
 zx_status_t PmmNode::SetPageCompression(fbl::RefPtr<VmCompression> compression) {
   Guard<Mutex> guard{&compression_lock_};
   if (page_compression_) {
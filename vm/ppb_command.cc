@@ -35,6 +35,16 @@ static void cmd_ppb_borrowing_off() {
   printf("borrowing disabled\n");
 }
 
+static void cmd_ppb_borrowing_supply_on() {
+  PhysicalPageBorrowingConfig::Get().set_borrowing_in_supplypages_enabled(true);
+  printf("borrowing in supply pages enabled\n");
+}
+
+static void cmd_ppb_borrowing_supply_off() {
+  PhysicalPageBorrowingConfig::Get().set_borrowing_in_supplypages_enabled(false);
+  printf("borrowing in supply pages disabled\n");
+}
+
 static void cmd_ppb_loaning_on() {
   PhysicalPageBorrowingConfig::Get().set_loaning_enabled(true);
   printf("loaning enabled\n");
@@ -91,6 +101,8 @@ struct Cmd {
 static Cmd commands[] = {
     {.name = "borrowing_on", .func = cmd_ppb_borrowing_on},
     {.name = "borrowing_off", .func = cmd_ppb_borrowing_off},
+    {.name = "borrowing_supply_on", .func = cmd_ppb_borrowing_supply_on},
+    {.name = "borrowing_supply_off", .func = cmd_ppb_borrowing_supply_off},
     {.name = "loaning_on", .func = cmd_ppb_loaning_on},
     {.name = "loaning_off", .func = cmd_ppb_loaning_off},
     {.name = "stats", .func = cmd_ppb_stats},
@@ -105,6 +117,10 @@ static Cmd commands[] = {
 // k ppb borrowing_off
 //   * disables page borrowing for new allocations
 //   * see also k ppb borrowing_on
+// k ppb borrowing_supply_on
+//   * enables page borrowing for pages supplied by a user pager
+// k ppb borrowing_supply_off
+//   * disables page borrowing for pages supplied by a user pager
 // k ppb loaning_on
 //   * enables loaning when a contiguous VMO pages are decommitted
 // k ppb loaning_off
@@ -37,15 +37,25 @@ constexpr uint32_t kScannerOpReclaimAll = 1u << 4;
 constexpr uint32_t kScannerOpUpdateHarvestTime = 1u << 6;
 constexpr uint32_t kScannerOpEnablePTReclaim = 1u << 8;
 constexpr uint32_t kScannerOpDisablePTReclaim = 1u << 9;
+constexpr uint32_t kScannerOpReclaimPTPressure = 1u << 10;
 
-// Amount of time between page table evictions. This is not atomic as it is only set during init
-// before the scanner thread starts up, at which point it becomes read only.
+// Amount of time in which page table eviction goes over every slice of every aspace once. This is
+// not atomic as it is only set during init before the scanner thread starts up, at which point it
+// becomes read only.
 zx_duration_mono_t page_table_evict_time = ZX_SEC(10);
 
 // Number of pages to attempt to de-dupe back to zero every second. This not atomic as it is only
 // set during init before the scanner thread starts up, at which point it becomes read only.
 uint64_t zero_page_scans_per_second = 0;
 
+// Number of compressed storage pages to attempt to compact every second. This not atomic as it is
+// only set during init before the scanner thread starts up, at which point it becomes read only.
+uint64_t compaction_pages_per_second = 0;
+
+// Number of pages of the pmm arenas for the pmm checker to walk every second. This not atomic as it
+// is only set during init before the scanner thread starts up, at which point it becomes read only.
+uint64_t pmm_checker_pages_per_second = 0;
+
 PageTableEvictionPolicy page_table_reclaim_policy = PageTableEvictionPolicy::kAlways;
 
 // Tracks what the scanner should do when it is next woken up.
@@ -76,10 +86,13 @@ ktl::atomic<zx_duration_mono_t> accessed_scan_period = PageQueues::kDefaultMinMr
 
 ktl::atomic<bool> reclaim_pt_next_accessed_scan = false;
 
+KCOUNTER(pt_reclaim_pressure_requests, "vm.scanner.pt_reclaim.pressure_requests")
+KCOUNTER(pt_reclaim_pressure_performed, "vm.scanner.pt_reclaim.pressure_performed")
 KCOUNTER(zero_scan_requests, "vm.scanner.zero_scan.requests")
 KCOUNTER(zero_scan_ends_empty, "vm.scanner.zero_scan.queue_emptied")
 KCOUNTER(zero_scan_pages_scanned, "vm.scanner.zero_scan.total_pages_considered")
 KCOUNTER(zero_scan_pages_deduped, "vm.scanner.zero_scan.pages_deduped")
+KCOUNTER(zero_scan_pages_merged, "vm.scanner.zero_scan.pages_merged")
 
 void scanner_print_stats() {
   PageQueues::Counts queue_counts = pmm_page_queues()->QueueCounts();
@@ -105,9 +118,26 @@ zx_instant_mono_t calc_next_zero_scan_deadline(zx_instant_mono_t current) {
                                         : ZX_TIME_INFINITE;
 }
 
+// Page tables are evicted one slice of each aspace at a time, see
+// VmAspace::HarvestAllUserAccessedBits.
+zx_duration_mono_t pt_evict_slice_time() {
+  return page_table_evict_time / VmAspace::kPageTableReclaimSlices;
+}
+
+zx_instant_mono_t calc_next_compaction_deadline(zx_instant_mono_t current) {
+  return compaction_pages_per_second > 0 && Pmm::Node().GetPageCompression()
+             ? zx_time_add_duration(current, ZX_SEC(1))
+             : ZX_TIME_INFINITE;
+}
+
+zx_instant_mono_t calc_next_pmm_check_deadline(zx_instant_mono_t current) {
+  return pmm_checker_pages_per_second > 0 ? zx_time_add_duration(current, ZX_SEC(1))
+                                          : ZX_TIME_INFINITE;
+}
+
 zx_instant_mono_t calc_next_pt_evict_deadline(zx_instant_mono_t current, bool pt_enable_override) {
   if (page_table_reclaim_policy == PageTableEvictionPolicy::kAlways || pt_enable_override) {
-    return zx_time_add_duration(current, page_table_evict_time);
+    return zx_time_add_duration(current, pt_evict_slice_time());
   } else {
     return ZX_TIME_INFINITE;
   }
@@ -118,6 +148,8 @@ int scanner_request_thread(void*) {
   bool pt_eviction_enabled = false;
   zx_instant_mono_t last_pt_evict = ZX_TIME_INFINITE_PAST;
   zx_instant_mono_t next_zero_scan_deadline = calc_next_zero_scan_deadline(current_mono_time());
+  zx_instant_mono_t next_compaction_deadline = calc_next_compaction_deadline(current_mono_time());
+  zx_instant_mono_t next_pmm_check_deadline = calc_next_pmm_check_deadline(current_mono_time());
   zx_instant_mono_t next_harvest_deadline =
       zx_time_add_duration(current_mono_time(), accessed_scan_period);
   while (1) {
@@ -126,8 +158,9 @@ int scanner_request_thread(void*) {
     } else {
       zx_instant_mono_t next_pt_evict_deadline =
           calc_next_pt_evict_deadline(last_pt_evict, pt_eviction_enabled);
-      scanner_request_event.Wait(Deadline::no_slack(ktl::min(
-          next_pt_evict_deadline, ktl::min(next_zero_scan_deadline, next_harvest_deadline))));
+      scanner_request_event.Wait(Deadline::no_slack(
+          ktl::min({next_pt_evict_deadline, next_zero_scan_deadline, next_harvest_deadline,
+                    next_compaction_deadline, next_pmm_check_deadline})));
     }
     int32_t op = scanner_operation.exchange(0);
     // It is possible for enable and disable to happen at the same time. This indicates the disabled
@@ -139,7 +172,8 @@ int scanner_request_thread(void*) {
       pmm_page_queues()->EnableAging();
       // Re-enable eviction if it was originally enabled.
       if (gBootOptions->page_scanner_enable_eviction) {
-        pmm_evictor()->EnableEviction(gBootOptions->compression_at_memory_pressure);
+        pmm_evictor()->EnableEviction(gBootOptions->compression_at_memory_pressure,
+                                      gBootOptions->page_scanner_eviction_workers);
       }
       disabled = false;
     }
@@ -163,6 +197,19 @@ int scanner_request_thread(void*) {
 
     zx_instant_mono_t current = current_mono_time();
 
+    // Under memory pressure evict the next slice of page tables right away, rather than waiting
+    // for the next deadline and then for the next accessed scan, unless one was just evicted.
+    if (op & kScannerOpReclaimPTPressure) {
+      op &= ~kScannerOpReclaimPTPressure;
+      if (page_table_reclaim_policy != PageTableEvictionPolicy::kNever &&
+          current >= zx_time_add_duration(last_pt_evict, pt_evict_slice_time())) {
+        reclaim_pt_next_accessed_scan = true;
+        scanner_wait_for_accessed_scan(current);
+        last_pt_evict = current;
+        pt_reclaim_pressure_performed.Add(1);
+      }
+    }
+
     if (current >= calc_next_pt_evict_deadline(last_pt_evict, pt_eviction_enabled) ||
         (op & kScannerOpReclaimAll)) {
       // Make sure a scan has happened since we last expected page table reclamation to happen.
@@ -206,8 +253,14 @@ int scanner_request_thread(void*) {
       };
       pmm_evictor()->EvictFromExternalTarget(target);
       // To ensure any page table eviction that was set earlier actually occurs, force an accessed
-      // scan to happen right now.
+      // scan to happen right now. Page tables are evicted a slice at a time, so carry on through
+      // the remaining slices.
+      const bool reclaim_pt = reclaim_pt_next_accessed_scan;
       scanner_wait_for_accessed_scan(current_mono_time());
+      for (uint32_t i = 1; reclaim_pt && i < VmAspace::kPageTableReclaimSlices; i++) {
+        reclaim_pt_next_accessed_scan = true;
+        scanner_wait_for_accessed_scan(current_mono_time());
+      }
     }
     if (op & kScannerOpDump) {
       op &= ~kScannerOpDump;
@@ -230,10 +283,22 @@ int scanner_request_thread(void*) {
       const uint64_t scan_limit = reclaim_all ? UINT64_MAX : zero_page_scans_per_second;
       const uint64_t pages = scanner_do_zero_scan(scan_limit);
       if (print) {
-        printf("[SCAN]: De-duped %lu pages that were recently forked from the zero page\n", pages);
+        printf("[SCAN]: De-duped %lu recently zero forked pages\n", pages);
       }
       next_zero_scan_deadline = calc_next_zero_scan_deadline(current);
     }
+    if (current >= next_compaction_deadline) {
+      VmCompression* compression = Pmm::Node().GetPageCompression();
+      const size_t pages = compression->Compact(compaction_pages_per_second);
+      if (print && pages > 0) {
+        printf("[SCAN]: Compacted %zu compressed storage pages\n", pages);
+      }
+      next_compaction_deadline = calc_next_compaction_deadline(current);
+    }
+    if (current >= next_pmm_check_deadline) {
+      pmm_checker_check_free_pages(pmm_checker_pages_per_second);
+      next_pmm_check_deadline = calc_next_pmm_check_deadline(current);
+    }
     DEBUG_ASSERT(op == 0);
   }
   return 0;
@@ -275,9 +340,16 @@ void scanner_wait_for_accessed_scan(zx_instant_mono_t update_time) {
   // If we neither have page eviction or page table eviction then we can skip harvesting
   // accessed bits.
   if (reclaim_pt || pmm_evictor()->IsEvictionEnabled()) {
-    const VmAspace::NonTerminalAction action = reclaim_pt
-                                                   ? VmAspace::NonTerminalAction::FreeUnaccessed
-                                                   : VmAspace::NonTerminalAction::Retain;
+    // Periodic page table reclamation clears the non-terminal accessed flags as it goes, which
+    // bounds how much of each aspace a scan has to walk. Without it nothing would ever clear them,
+    // so have the scan do so itself. This is not done alongside periodic reclamation, as it would
+    // shorten the window in which a page table must be used to avoid being reclaimed.
+    VmAspace::NonTerminalAction action = VmAspace::NonTerminalAction::Retain;
+    if (reclaim_pt) {
+      action = VmAspace::NonTerminalAction::FreeUnaccessed;
+    } else if (page_table_reclaim_policy != PageTableEvictionPolicy::kAlways) {
+      action = VmAspace::NonTerminalAction::Harvest;
+    }
     VmAspace::HarvestAllUserAccessedBits(action, VmAspace::TerminalAction::UpdateAgeAndHarvest);
   }
   last_accessed_scan_complete = current_mono_time();
@@ -285,6 +357,7 @@ void scanner_wait_for_accessed_scan(zx_instant_mono_t update_time) {
 
 uint64_t scanner_do_zero_scan(uint64_t limit) {
   uint64_t deduped = 0;
+  uint64_t merged = 0;
   uint64_t considered;
   zero_scan_requests.Add(1);
   for (considered = 0; considered < limit; considered++) {
@@ -295,6 +368,9 @@ uint64_t scanner_do_zero_scan(uint64_t limit) {
       }
       if (backlink->cow->DedupZeroPage(backlink->page, backlink->offset)) {
         deduped++;
+      } else if (backlink->cow->DedupPage(backlink->page, backlink->offset)) {
+        // Not a zero page, but identical to content already held by the compression system.
+        merged++;
       }
     } else {
       zero_scan_ends_empty.Add(1);
@@ -304,7 +380,14 @@ uint64_t scanner_do_zero_scan(uint64_t limit) {
 
   zero_scan_pages_scanned.Add(considered);
   zero_scan_pages_deduped.Add(deduped);
-  return deduped;
+  zero_scan_pages_merged.Add(merged);
+  return deduped + merged;
+}
+
+void scanner_request_page_table_reclaim() {
+  pt_reclaim_pressure_requests.Add(1);
+  scanner_operation.fetch_or(kScannerOpReclaimPTPressure);
+  scanner_request_event.Signal();
 }
 
 void scanner_enable_page_table_reclaim() {
@@ -379,6 +462,8 @@ static void scanner_init_func(uint level) {
       Thread::Create("scanner-request-thread", scanner_request_thread, nullptr, LOW_PRIORITY);
   DEBUG_ASSERT(thread);
   zero_page_scans_per_second = gBootOptions->page_scanner_zero_page_scans_per_second;
+  compaction_pages_per_second = gBootOptions->compression_compaction_pages_per_second;
+  pmm_checker_pages_per_second = gBootOptions->pmm_checker_verify_pages_per_second;
   if (!gBootOptions->page_scanner_start_at_boot) {
     Guard<Mutex> guard{scanner_disabled_lock::Get()};
     scanner_disable_count++;
@@ -390,12 +475,21 @@ static void scanner_init_func(uint level) {
       ktl::max(ZX_MSEC(gBootOptions->page_scanner_page_table_eviction_period_ms), ZX_SEC(1));
 
   if (gBootOptions->page_scanner_enable_eviction) {
-    pmm_evictor()->EnableEviction(gBootOptions->compression_at_memory_pressure);
+    pmm_evictor()->EnableEviction(gBootOptions->compression_at_memory_pressure,
+                                  gBootOptions->page_scanner_eviction_workers);
+    if (gBootOptions->page_scanner_proactive_reclaim_low_mb > 0) {
+      pmm_evictor()->SetProactiveWatermarks(
+          static_cast<uint64_t>(gBootOptions->page_scanner_proactive_reclaim_low_mb) * MB,
+          static_cast<uint64_t>(gBootOptions->page_scanner_proactive_reclaim_high_mb) * MB,
+          static_cast<uint64_t>(gBootOptions->page_scanner_proactive_reclaim_max_mb_per_second) *
+              MB);
+    }
   }
 
   pmm_page_queues()->SetActiveRatioMultiplier(gBootOptions->page_scanner_active_ratio_multiplier);
   pmm_page_queues()->StartThreads(ZX_MSEC(gBootOptions->page_scanner_min_aging_interval_ms),
                                   ZX_MSEC(gBootOptions->page_scanner_max_aging_interval_ms));
+  pmm_page_queues()->StartStaging();
   // Set the access scan to at least 1 second over the min page scanning interval. This both ensures
   // that the access scan period is never 0 and that redundant scanning before the page queues can
   // age does not occur.
@@ -4,16 +4,24 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <lib/counters.h>
+
 #include <vm/physmap.h>
 #include <vm/pmm.h>
 #include <vm/slot_page_storage.h>
 
+namespace {
+KCOUNTER(compaction_runs, "vm.compression.compaction.runs")
+KCOUNTER(compaction_items_moved, "vm.compression.compaction.items_moved")
+KCOUNTER(compaction_pages_freed, "vm.compression.compaction.pages_freed")
+KCOUNTER(compaction_skipped_readers, "vm.compression.compaction.skipped_readers")
+
 // The following helper methods are used for manipulating the free_block_mask. Slots are tracked
 // where a bit being set indicates the block is not allocated, and being clear means it is
 // allocated.
-namespace {
 constexpr size_t kNumSlots = VmSlotPageStorage::kNumSlots;
 constexpr size_t kSlotSize = VmSlotPageStorage::kSlotSize;
+constexpr size_t kItemTagSize = VmSlotPageStorage::kItemTagSize;
 
 // Given a zero indexed starting slot, and a non-zero length, returns a bitmask with those slots
 // set to true.
@@ -102,8 +110,17 @@ ktl::tuple<const void*, uint32_t, size_t> VmSlotPageStorage::CompressedData(
     CompressedRef ref) const {
   canary_.Assert();
   Guard<CriticalMutex> guard{&lock_};
-  const Allocation* data = RefToAllocLocked(ref);
-  return {data->data(), data->metadata, data->byte_size()};
+  const Allocation* alloc = RefToAllocLocked(ref);
+  const Allocation* data = DataOwner(alloc);
+  readers_++;
+  return {data->data(), alloc->metadata, data->byte_size()};
+}
+
+void VmSlotPageStorage::ReleaseCompressedData(CompressedRef ref) const {
+  canary_.Assert();
+  Guard<CriticalMutex> guard{&lock_};
+  DEBUG_ASSERT(readers_ > 0);
+  readers_--;
 }
 
 std::pair<ktl::optional<VmCompressedStorage::CompressedRef>, vm_page_t*> VmSlotPageStorage::Store(
@@ -114,19 +131,28 @@ std::pair<ktl::optional<VmCompressedStorage::CompressedRef>, vm_page_t*> VmSlotP
   canary_.Assert();
   Guard<CriticalMutex> guard{&lock_};
 
+  // The data is stored after its tag, and the two together must fit in the slots of a page.
+  const size_t slot_len = len + kItemTagSize;
+  if (slot_len >= PAGE_SIZE) {
+    return {ktl::nullopt, page};
+  }
+
   // Require an |Allocation| for our metadata.
   Allocation* data = allocator_.New();
   if (!data) {
     return {ktl::nullopt, page};
   }
+  const uint32_t tag = allocator_.ObjectToId(data);
 
   // Allocation cannot fail from here, so update our stats.
   total_compressed_item_size_ += len;
   stored_items_++;
 
-  const uint8_t slots = SlotsNeeded(len);
+  const uint8_t slots = SlotsNeeded(slot_len);
+  data->users = 1;
   data->num_slots = slots;
-  data->last_slot_bytes = LastSlotBytes(len);
+  data->last_slot_bytes = LastSlotBytes(slot_len);
+  used_slots_ += slots;
 
   // Search for an existing page to add to first, preferring to break up the smallest contiguous
   // slot run possible.
@@ -142,6 +168,10 @@ std::pair<ktl::optional<VmCompressedStorage::CompressedRef>, vm_page_t*> VmSlotP
     page->zram.free_block_mask = SlotMask(slots, contig_free);
     data->slot_start = 0;
     data->page = page;
+    // Shift the data up to make room for the tag in front of it.
+    memmove(data->data(), data->slot_base(), len);
+    *static_cast<uint32_t*>(data->slot_base()) = tag;
+    storage_pages_++;
     list_add_head(&max_contig_remain_[contig_free], &page->queue_node);
     // We have consumed |page|, so do not return it to the caller.
     return {AllocToRefLocked(data), nullptr};
@@ -156,8 +186,9 @@ std::pair<ktl::optional<VmCompressedStorage::CompressedRef>, vm_page_t*> VmSlotP
   target_page->zram.free_block_mask &= ~alloc_mask;
   data->slot_start = base;
   data->page = target_page;
-  // Copy the actual data.
+  // Copy the actual data, and tag it.
   memcpy(data->data(), paddr_to_physmap(page->paddr()), len);
+  *static_cast<uint32_t*>(data->slot_base()) = tag;
   // Re-insert the page into the, possibly changed, target list.
   const uint8_t contig_free = ContigFree(target_page->zram.free_block_mask);
   list_add_head(&max_contig_remain_[contig_free], &target_page->queue_node);
@@ -165,41 +196,202 @@ std::pair<ktl::optional<VmCompressedStorage::CompressedRef>, vm_page_t*> VmSlotP
   return {AllocToRefLocked(data), page};
 }
 
+ktl::optional<VmCompressedStorage::CompressedRef> VmSlotPageStorage::Share(CompressedRef ref) {
+  canary_.Assert();
+  Guard<CriticalMutex> guard{&lock_};
+
+  Allocation* owner = DataOwner(RefToAllocLocked(ref));
+  DEBUG_ASSERT(owner->users > 0);
+  if (owner->users == UINT8_MAX) {
+    return ktl::nullopt;
+  }
+  Allocation* alias = allocator_.New();
+  if (!alias) {
+    return ktl::nullopt;
+  }
+  // Leaving num_slots as zero marks this as an alias.
+  DEBUG_ASSERT(alias->is_alias());
+  alias->owner = owner;
+  owner->users++;
+  stored_items_++;
+  shared_items_++;
+  return AllocToRefLocked(alias);
+}
+
 void VmSlotPageStorage::Free(CompressedRef ref) {
   canary_.Assert();
   vm_page_t* page = nullptr;
   {
     Guard<CriticalMutex> guard{&lock_};
+    page = FreeLocked(ref);
+  }
+  // If we ended up with a completely free page, give it back to the PMM.
+  if (page) {
+    Pmm::Node().FreePage(page);
+  }
+}
 
-    // Lookup the metadata for this allocation.
-    Allocation* data = RefToAllocLocked(ref);
-    DEBUG_ASSERT(list_in_list(&data->page->queue_node));
-    page = data->page;
-
-    // Update stats tracking.
-    total_compressed_item_size_ -= data->byte_size();
-    stored_items_--;
+void VmSlotPageStorage::FreeBatch(ktl::span<const CompressedRef> refs) {
+  canary_.Assert();
+  list_node_t free_pages = LIST_INITIAL_VALUE(free_pages);
+  {
+    Guard<CriticalMutex> guard{&lock_};
+    for (CompressedRef ref : refs) {
+      if (vm_page_t* page = FreeLocked(ref)) {
+        list_add_tail(&free_pages, &page->queue_node);
+      }
+    }
+  }
+  if (!list_is_empty(&free_pages)) {
+    Pmm::Node().FreeList(&free_pages);
+  }
+}
 
-    // Add the slots for this allocation back to the free mask of the page and then can release the
-    // |Allocation|.
-    uint64_t free_mask = SlotMask(data->slot_start, data->num_slots);
-    page->zram.free_block_mask |= free_mask;
+vm_page_t* VmSlotPageStorage::FreeLocked(CompressedRef ref) {
+  // Lookup the metadata for this allocation.
+  Allocation* data = RefToAllocLocked(ref);
+  stored_items_--;
+  if (data->is_alias()) {
+    Allocation* owner = data->owner;
     allocator_.Delete(data);
+    shared_items_--;
+    return ReleaseOwnerLocked(owner);
+  }
+  return ReleaseOwnerLocked(data);
+}
+
+vm_page_t* VmSlotPageStorage::ReleaseOwnerLocked(Allocation* data) {
+  DEBUG_ASSERT(!data->is_alias());
+  DEBUG_ASSERT(data->users > 0);
+  if (--data->users > 0) {
+    // Data is still being shared.
+    return nullptr;
+  }
+  DEBUG_ASSERT(list_in_list(&data->page->queue_node));
+  vm_page_t* page = data->page;
+
+  // Update stats tracking.
+  total_compressed_item_size_ -= data->byte_size();
+  used_slots_ -= data->num_slots;
+
+  // Add the slots for this allocation back to the free mask of the page and then can release the
+  // |Allocation|.
+  uint64_t free_mask = SlotMask(data->slot_start, data->num_slots);
+  page->zram.free_block_mask |= free_mask;
+  allocator_.Delete(data);
+
+  // Remove the page from its current list since it's cheaper to potentially re-insert than to work
+  // out what list it's currently in.
+  list_delete(&page->queue_node);
+  const uint64_t contig_free = ContigFree(page->zram.free_block_mask);
+  if (contig_free != kNumSlots) {
+    list_add_head(&max_contig_remain_[contig_free], &page->queue_node);
+    // Page still in use, do not let it get freed.
+    return nullptr;
+  }
+  storage_pages_--;
+  return page;
+}
 
-    // Remove the page from its current list since it's cheaper to potentially re-insert than to work
-    // out what list it's currently in.
-    list_delete(&page->queue_node);
-    const uint64_t contig_free = ContigFree(page->zram.free_block_mask);
-    if (contig_free != kNumSlots) {
-      list_add_head(&max_contig_remain_[contig_free], &page->queue_node);
-      // Page still in use, do not let it get freed.
-      page = nullptr;
+bool VmSlotPageStorage::IsFragmentedLocked() const {
+  // Moving data costs a copy per item, so only bother once at least a quarter of the storage, and
+  // at least two pages worth of slots, is unused.
+  const size_t total_slots = storage_pages_ * kNumSlots;
+  DEBUG_ASSERT(used_slots_ <= total_slots);
+  const size_t free_slots = total_slots - used_slots_;
+  return free_slots >= kNumSlots * 2 && free_slots * 4 >= total_slots;
+}
+
+size_t VmSlotPageStorage::Compact(size_t max_pages) {
+  canary_.Assert();
+  list_node_t free_pages = LIST_INITIAL_VALUE(free_pages);
+  size_t freed = 0;
+  {
+    Guard<CriticalMutex> guard{&lock_};
+    if (!IsFragmentedLocked()) {
+      return 0;
+    }
+    // Someone may be reading data out of any page, so nothing can be moved right now.
+    if (readers_ > 0) {
+      compaction_skipped_readers.Add(1);
+      return 0;
     }
+    compaction_stats_.runs++;
+    compaction_runs.Add(1);
+    // Only pages that have at least half their slots free are considered as sources, starting with
+    // the sparsest.
+    const auto sources_end = max_contig_remain_.rbegin() + kNumSlots / 2;
+    for (size_t i = 0; i < max_pages && IsFragmentedLocked(); i++) {
+      auto source_list = ktl::find_if_not(max_contig_remain_.rbegin(), sources_end,
+                                          [](auto& list) { return list_is_empty(&list); });
+      if (source_list == sources_end) {
+        break;
+      }
+      vm_page_t* page = list_remove_head_type(&*source_list, vm_page_t, queue_node);
+      if (!EvacuatePageLocked(page)) {
+        // Failing to find space for one item means the remaining sources will not do any better.
+        break;
+      }
+      storage_pages_--;
+      list_add_tail(&free_pages, &page->queue_node);
+      freed++;
+    }
+    compaction_stats_.pages_freed += freed;
   }
-  // If we ended up with a completely free page, give it back to the PMM.
-  if (page) {
-    Pmm::Node().FreePage(page);
+  if (!list_is_empty(&free_pages)) {
+    compaction_pages_freed.Add(static_cast<int64_t>(freed));
+    Pmm::Node().FreeList(&free_pages);
   }
+  return freed;
+}
+
+bool VmSlotPageStorage::EvacuatePageLocked(vm_page_t* page) {
+  DEBUG_ASSERT(!list_in_list(&page->queue_node));
+  DEBUG_ASSERT(readers_ == 0);
+  const uintptr_t page_base = reinterpret_cast<uintptr_t>(paddr_to_physmap(page->paddr()));
+  // Items only move to pages that are at least as densely used as this one was, so that
+  // compaction makes progress instead of shuffling data between equally sparse pages.
+  const uint8_t source_contig = ContigFree(page->zram.free_block_mask);
+  uint64_t used_mask = ~page->zram.free_block_mask;
+  while (used_mask) {
+    const uint8_t slot = static_cast<uint8_t>(ktl::countr_zero(used_mask));
+    const uint32_t tag = *reinterpret_cast<const uint32_t*>(page_base + slot * kSlotSize);
+    Allocation* data = allocator_.IdToObject(tag);
+    DEBUG_ASSERT(!data->is_alias());
+    DEBUG_ASSERT(data->page == page && data->slot_start == slot);
+    const uint8_t slots = data->num_slots;
+
+    auto targets_end = max_contig_remain_.begin() + source_contig + 1;
+    auto target_list =
+        slots <= source_contig
+            ? ktl::find_if_not(max_contig_remain_.begin() + slots, targets_end,
+                               [](auto& list) { return list_is_empty(&list); })
+            : targets_end;
+    if (target_list == targets_end) {
+      list_add_head(&max_contig_remain_[ContigFree(page->zram.free_block_mask)],
+                    &page->queue_node);
+      return false;
+    }
+
+    // Allocate the slots in the target page as |Store| would, and copy the tagged data across.
+    vm_page_t* target_page = list_remove_head_type(&*target_list, vm_page_t, queue_node);
+    const uint8_t base = ContigBase(target_page->zram.free_block_mask, slots);
+    target_page->zram.free_block_mask &= ~SlotMask(base, slots);
+    const void* src = data->slot_base();
+    data->page = target_page;
+    data->slot_start = base;
+    memcpy(data->slot_base(), src, data->slot_bytes());
+    list_add_head(&max_contig_remain_[ContigFree(target_page->zram.free_block_mask)],
+                  &target_page->queue_node);
+
+    const uint64_t moved_mask = SlotMask(slot, slots);
+    page->zram.free_block_mask |= moved_mask;
+    used_mask &= ~moved_mask;
+    compaction_stats_.items_moved++;
+    compaction_items_moved.Add(1);
+  }
+  DEBUG_ASSERT(page->zram.free_block_mask == UINT64_MAX);
+  return true;
 }
 
 VmSlotPageStorage::InternalMemoryUsage VmSlotPageStorage::GetInternalMemoryUsage() const {
@@ -226,6 +418,12 @@ VmCompressedStorage::MemoryUsage VmSlotPageStorage::GetMemoryUsage() const {
                      .compressed_storage_used_bytes = total_compressed_item_size_};
 }
 
+VmCompressedStorage::CompactionStats VmSlotPageStorage::GetCompactionStats() const {
+  canary_.Assert();
+  Guard<CriticalMutex> guard{&lock_};
+  return compaction_stats_;
+}
+
 void VmSlotPageStorage::Dump() const {
   canary_.Assert();
 
@@ -233,4 +431,13 @@ void VmSlotPageStorage::Dump() const {
   printf("Storing %lu bytes compressed to %lu bytes using %lu bytes of storage\n",
          usage.uncompressed_content_bytes, usage.compressed_storage_used_bytes,
          usage.compressed_storage_bytes);
+  size_t shared;
+  {
+    Guard<CriticalMutex> guard{&lock_};
+    shared = shared_items_;
+  }
+  printf("%zu stored items are sharing data with another item\n", shared);
+  CompactionStats compaction = GetCompactionStats();
+  printf("Compacted %lu times moving %lu items and freeing %lu pages\n", compaction.runs,
+         compaction.items_moved, compaction.pages_freed);
 }
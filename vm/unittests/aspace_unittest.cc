@@ -4,7 +4,9 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <lib/crypto/prng.h>
 #include <lib/fit/defer.h>
+#include <platform.h>
 #include <pow2.h>
 #include <zircon/errors.h>
 
@@ -345,12 +347,91 @@ static bool vmaspace_accessed_test(uint8_t tag) {
 
 static bool vmaspace_accessed_test_untagged() { return vmaspace_accessed_test(0); }
 
+// Fault on a page right after its accessed flag was harvested. The translation still permits the
+// access, but where the hardware faults on the cleared accessed flag the fault must not be treated
+// as spurious, or the faulting access would be retried forever.
+static bool vmaspace_fault_after_harvest_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  vm_page_t* page;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status =
+      make_committed_pager_vmo(1, /*trap_dirty=*/false, /*resizable=*/false, &page, &vmo);
+  ASSERT_EQ(ZX_OK, status);
+  auto mem = testing::UserMemory::Create(vmo);
+  ASSERT_EQ(ZX_OK, mem->CommitAndMap(PAGE_SIZE));
+  mem->put<int>(42);
+
+  harvest_access_bits(VmAspace::NonTerminalAction::Retain,
+                      VmAspace::TerminalAction::UpdateAgeAndHarvest);
+  pmm_page_queues()->RotateReclaimQueues();
+  const uint8_t current_queue = page->object.get_page_queue_ref().load();
+
+  // Take the fault the hardware would raise for a read of the harvested page.
+  EXPECT_EQ(ZX_OK, mem->aspace()->PageFault(mem->base(), VMM_PF_FLAG_USER));
+  if (ArchVmAspace::HasUnreportedAccessFaults()) {
+    // Resolving the fault must have marked the page accessed again.
+    harvest_access_bits(VmAspace::NonTerminalAction::Retain,
+                        VmAspace::TerminalAction::UpdateAgeAndHarvest);
+    EXPECT_NE(current_queue, page->object.get_page_queue_ref().load());
+  }
+
+  // Touching the page must now complete.
+  harvest_access_bits(VmAspace::NonTerminalAction::Retain,
+                      VmAspace::TerminalAction::UpdateAgeAndHarvest);
+  EXPECT_EQ(42, mem->get<int>());
+
+  END_TEST;
+}
+
 #if defined(__aarch64__)
 // Rerun the `vmaspace_accessed_test` tests with tags in the top byte of user pointers. This tests
 // that the subsequent accessed faults are handled successfully, even if the FAR contains a tag.
 static bool vmaspace_accessed_test_tagged() { return vmaspace_accessed_test(0xAB); }
 #endif
 
+// Check that harvesting the non-terminal accessed flags does not cause later harvests to miss
+// accesses made through the page tables they skip.
+static bool vmaspace_harvest_non_terminal_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  vm_page_t* page;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status =
+      make_committed_pager_vmo(1, /*trap_dirty=*/false, /*resizable=*/false, &page, &vmo);
+  ASSERT_EQ(ZX_OK, status);
+  auto mem = testing::UserMemory::Create(vmo);
+
+  ASSERT_EQ(ZX_OK, mem->CommitAndMap(PAGE_SIZE));
+
+  // Clear both the terminal and non-terminal accessed information.
+  harvest_access_bits(VmAspace::NonTerminalAction::Harvest,
+                      VmAspace::TerminalAction::UpdateAgeAndHarvest);
+  uint8_t current_queue = page->object.get_page_queue_ref().load();
+
+  // Without an access, another harvest should skip the page tables and leave the page alone.
+  pmm_page_queues()->RotateReclaimQueues();
+  harvest_access_bits(VmAspace::NonTerminalAction::Harvest,
+                      VmAspace::TerminalAction::UpdateAgeAndHarvest);
+  EXPECT_EQ(current_queue, page->object.get_page_queue_ref().load());
+
+  // Unlike FreeUnaccessed, the unaccessed page tables are retained and the page is still mapped.
+  paddr_t paddr;
+  EXPECT_EQ(ZX_OK, mem->aspace()->arch_aspace().Query(mem->base(), &paddr, nullptr));
+
+  // An access has to be found again, even though the page tables leading to it were harvested.
+  ConsumeValue(mem->get<int>(0));
+  harvest_access_bits(VmAspace::NonTerminalAction::Harvest,
+                      VmAspace::TerminalAction::UpdateAgeAndHarvest);
+  EXPECT_NE(current_queue, page->object.get_page_queue_ref().load());
+
+  END_TEST;
+}
+
 // Ensure that if a user requested VMO read/write operation would hit a page that has had its
 // accessed bits harvested that any resulting fault (on ARM) can be handled.
 static bool vmaspace_usercopy_accessed_fault_test() {
@@ -390,6 +471,106 @@ static bool vmaspace_usercopy_accessed_fault_test() {
   END_TEST;
 }
 
+// Small reads of resident content are served through a bounce buffer. Check that they return the
+// right data across a page boundary, and that reads the fast path declines, such as those of
+// uncommitted content or into an unpopulated user buffer, still complete.
+static bool vmaspace_usercopy_resident_read_test() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, PAGE_SIZE * 3, &vmo);
+  ASSERT_EQ(ZX_OK, status);
+
+  constexpr size_t kLen = 64;
+  uint8_t pattern[kLen];
+  for (size_t i = 0; i < kLen; i++) {
+    pattern[i] = static_cast<uint8_t>(i + 1);
+  }
+  const uint64_t offset = PAGE_SIZE - kLen / 2;
+  ASSERT_EQ(ZX_OK, vmo->Write(pattern, offset, kLen));
+
+  // Nothing is committed in the user buffer, so the first read faults it in through the regular
+  // path.
+  fbl::RefPtr<VmObjectPaged> user_vmo;
+  status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, PAGE_SIZE, &user_vmo);
+  ASSERT_EQ(ZX_OK, status);
+  auto mem = testing::UserMemory::Create(user_vmo);
+  for (int pass = 0; pass < 2; pass++) {
+    auto [read_status, read_actual] =
+        vmo->ReadUser(mem->user_out<char>(), offset, kLen, VmObjectReadWriteOptions::None);
+    ASSERT_EQ(ZX_OK, read_status);
+    EXPECT_EQ(kLen, read_actual);
+    for (size_t i = 0; i < kLen; i++) {
+      EXPECT_EQ(pattern[i], mem->get<uint8_t>(i));
+    }
+  }
+
+  // The last page was never committed and reads as zero.
+  auto [read_status, read_actual] = vmo->ReadUser(mem->user_out<char>(), PAGE_SIZE * 2, kLen,
+                                                  VmObjectReadWriteOptions::None);
+  ASSERT_EQ(ZX_OK, read_status);
+  EXPECT_EQ(kLen, read_actual);
+  for (size_t i = 0; i < kLen; i++) {
+    EXPECT_EQ(0u, mem->get<uint8_t>(i));
+  }
+
+  END_TEST;
+}
+
+// Check that ReadUserRanges and WriteUserRanges transfer each range to its own buffer, including
+// ranges that straddle a page boundary, and stop at an out of range segment.
+static bool vmaspace_usercopy_ranges_test() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, PAGE_SIZE * 4, &vmo);
+  ASSERT_EQ(ZX_OK, status);
+
+  fbl::RefPtr<VmObjectPaged> user_vmo;
+  status = VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, PAGE_SIZE * 2, &user_vmo);
+  ASSERT_EQ(ZX_OK, status);
+  auto mem = testing::UserMemory::Create(user_vmo);
+  char* const base = reinterpret_cast<char*>(mem->base());
+
+  constexpr size_t kLen = 128;
+  for (size_t i = 0; i < kLen * 2; i++) {
+    mem->put<uint8_t>(static_cast<uint8_t>(i), i);
+  }
+
+  // Write the two halves of the user buffer to discontiguous offsets, the second half first.
+  const UserCopyRange writes[] = {
+      {.offset = PAGE_SIZE * 3, .len = kLen, .buffer = base + kLen},
+      {.offset = PAGE_SIZE - kLen / 2, .len = kLen, .buffer = base},
+  };
+  auto [write_status, written] = vmo->WriteUserRanges(writes);
+  ASSERT_EQ(ZX_OK, write_status);
+  EXPECT_EQ(kLen * 2, written);
+
+  // Read them back in their original order into the second user page.
+  char* const out = base + PAGE_SIZE;
+  const UserCopyRange reads[] = {
+      {.offset = PAGE_SIZE - kLen / 2, .len = kLen, .buffer = out},
+      {.offset = PAGE_SIZE * 3, .len = kLen, .buffer = out + kLen},
+  };
+  auto [read_status, read_actual] = vmo->ReadUserRanges(reads);
+  ASSERT_EQ(ZX_OK, read_status);
+  EXPECT_EQ(kLen * 2, read_actual);
+  for (size_t i = 0; i < kLen * 2; i++) {
+    EXPECT_EQ(static_cast<uint8_t>(i), mem->get<uint8_t>(PAGE_SIZE + i));
+  }
+
+  // A range past the end fails, after the ranges before it have been transferred.
+  const UserCopyRange bad[] = {
+      {.offset = 0, .len = kLen, .buffer = out},
+      {.offset = PAGE_SIZE * 4, .len = kLen, .buffer = out},
+  };
+  auto [bad_status, bad_read] = vmo->ReadUserRanges(bad);
+  EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, bad_status);
+  EXPECT_EQ(kLen, bad_read);
+
+  END_TEST;
+}
+
 // Test that page tables that do not get accessed can be successfully unmapped and freed.
 static bool vmaspace_free_unaccessed_page_tables_test() {
   BEGIN_TEST;
@@ -1921,6 +2102,145 @@ static bool vm_mapping_page_fault_range_test() {
   END_TEST;
 }
 
+// Validate that sequential page faults grow the fault-around window, and that it can be limited.
+static bool vm_mapping_page_fault_around_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  constexpr size_t kMaxOptPages = VmMapping::kPageFaultMaxOptimisticPages;
+  constexpr size_t kTestPages = kMaxOptPages * 8;
+  constexpr size_t kAllocSize = kTestPages * PAGE_SIZE;
+  constexpr uint kReadFlags = VMM_PF_FLAG_USER;
+  // Align the mapping so that the window does not get limited by a page table boundary.
+  static const uint8_t align_pow2 = log2_floor(kAllocSize);
+  static_assert(kMaxOptPages * 4 == VmMapping::kPageFaultDefaultFaultAroundPages);
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0, kAllocSize, &vmo));
+  ASSERT_OK(vmo->CommitRange(0, kAllocSize));
+
+  ktl::unique_ptr<testing::UserMemory> mapping = testing::UserMemory::Create(vmo, 0, align_pow2);
+  ASSERT_NONNULL(mapping);
+
+  // Each fault that lands where the previous one stopped doubles the window, until it reaches the
+  // default limit.
+  size_t mapped = 0;
+  for (size_t window : {kMaxOptPages, kMaxOptPages * 2, kMaxOptPages * 4, kMaxOptPages * 4}) {
+    EXPECT_OK(Thread::Current::SoftFaultInRange(mapping->base() + mapped * PAGE_SIZE, kReadFlags,
+                                                PAGE_SIZE));
+    mapped = ktl::min(mapped + window, kTestPages);
+    EXPECT_TRUE(verify_mapped_page_range(mapping->base(), kAllocSize, mapped));
+  }
+  EXPECT_EQ(kTestPages, mapped);
+
+  // A non sequential fault resets the window.
+  EXPECT_OK(vmo->DecommitRange(0, kAllocSize));
+  EXPECT_OK(vmo->CommitRange(0, kAllocSize));
+  ASSERT_TRUE(verify_mapped_page_range(mapping->base(), kAllocSize, 0));
+  EXPECT_OK(Thread::Current::SoftFaultInRange(mapping->base(), kReadFlags, PAGE_SIZE));
+  EXPECT_TRUE(verify_mapped_page_range(mapping->base(), kAllocSize, kMaxOptPages));
+
+  END_TEST;
+}
+
+// Validate that the fault-around limit can be set through a range op.
+static bool vm_mapping_page_fault_around_limit_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  constexpr size_t kMaxOptPages = VmMapping::kPageFaultMaxOptimisticPages;
+  constexpr size_t kAllocSize = kMaxOptPages * 2 * PAGE_SIZE;
+  constexpr uint kReadFlags = VMM_PF_FLAG_USER;
+  static const uint8_t align_pow2 = log2_floor(kAllocSize);
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0, kAllocSize, &vmo));
+  ASSERT_OK(vmo->CommitRange(0, kAllocSize));
+
+  ktl::unique_ptr<testing::UserMemory> mapping = testing::UserMemory::Create(vmo, 0, align_pow2);
+  ASSERT_NONNULL(mapping);
+  fbl::RefPtr<VmAddressRegion> vmar = mapping->aspace()->RootVmar();
+
+  // The limit is passed through a user buffer, and must be within range.
+  ktl::unique_ptr<testing::UserMemory> buffer = testing::UserMemory::Create(PAGE_SIZE);
+  ASSERT_NONNULL(buffer);
+  user_inout_ptr<void> buffer_ptr = make_user_inout_ptr(reinterpret_cast<void*>(buffer->base()));
+  auto set_limit = [&](uint32_t pages) {
+    buffer->put<uint32_t>(pages);
+    return vmar->RangeOp(VmAddressRegion::RangeOpType::SetFaultAround, mapping->base(), kAllocSize,
+                         VmAddressRegionOpChildren::Yes, buffer_ptr, sizeof(uint32_t));
+  };
+  EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, set_limit(0));
+  EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, set_limit(VmMapping::kPageFaultMaxFaultAroundPages + 1));
+  EXPECT_EQ(ZX_ERR_INVALID_ARGS,
+            vmar->RangeOp(VmAddressRegion::RangeOpType::SetFaultAround, mapping->base(), kAllocSize,
+                          VmAddressRegionOpChildren::Yes, buffer_ptr, 1));
+
+  // A limit of a single page disables fault-around entirely.
+  EXPECT_OK(set_limit(1));
+  EXPECT_OK(Thread::Current::SoftFaultInRange(mapping->base(), kReadFlags, PAGE_SIZE));
+  EXPECT_TRUE(verify_mapped_page_range(mapping->base(), kAllocSize, 1));
+  EXPECT_OK(Thread::Current::SoftFaultInRange(mapping->base() + PAGE_SIZE, kReadFlags, PAGE_SIZE));
+  EXPECT_TRUE(verify_mapped_page_range(mapping->base(), kAllocSize, 2));
+
+  // Smaller limits also cap the initial window.
+  EXPECT_OK(vmo->DecommitRange(0, kAllocSize));
+  EXPECT_OK(vmo->CommitRange(0, kAllocSize));
+  EXPECT_OK(set_limit(4));
+  EXPECT_OK(Thread::Current::SoftFaultInRange(mapping->base(), kReadFlags, PAGE_SIZE));
+  EXPECT_TRUE(verify_mapped_page_range(mapping->base(), kAllocSize, 4));
+
+  END_TEST;
+}
+
+static bool vmar_harvest_dirty_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  constexpr size_t kPages = 4;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0, kPages * PAGE_SIZE, &vmo));
+  ASSERT_OK(vmo->CommitRange(0, kPages * PAGE_SIZE));
+
+  ktl::unique_ptr<testing::UserMemory> mapping = testing::UserMemory::Create(vmo);
+  ASSERT_NONNULL(mapping);
+  fbl::RefPtr<VmAddressRegion> vmar = mapping->aspace()->RootVmar();
+
+  ktl::unique_ptr<testing::UserMemory> buffer = testing::UserMemory::Create(PAGE_SIZE);
+  ASSERT_NONNULL(buffer);
+  user_inout_ptr<void> buffer_ptr = make_user_inout_ptr(reinterpret_cast<void*>(buffer->base()));
+  auto harvest = [&](size_t buffer_size) {
+    return vmar->RangeOp(VmAddressRegion::RangeOpType::HarvestDirty, mapping->base(),
+                         kPages * PAGE_SIZE, VmAddressRegionOpChildren::Yes, buffer_ptr,
+                         buffer_size);
+  };
+
+  // The bitmap is rounded up to whole words.
+  EXPECT_EQ(ZX_ERR_BUFFER_TOO_SMALL, harvest(sizeof(uint64_t) - 1));
+
+#if defined(__x86_64__)
+  // Start from a clean record, then write to the first and third pages.
+  ASSERT_OK(harvest(sizeof(uint64_t)));
+  mapping->put<uint8_t>(1, 0);
+  mapping->put<uint8_t>(1, 2 * PAGE_SIZE);
+
+  ASSERT_OK(harvest(sizeof(uint64_t)));
+  EXPECT_EQ(0b101u, buffer->get<uint64_t>());
+
+  // Harvesting resets the record.
+  ASSERT_OK(harvest(sizeof(uint64_t)));
+  EXPECT_EQ(0u, buffer->get<uint64_t>());
+#else
+  // Only the x86 page tables record writes.
+  EXPECT_EQ(ZX_ERR_NOT_SUPPORTED, harvest(sizeof(uint64_t)));
+#endif
+
+  END_TEST;
+}
+
 using ArchUnmapOptions = ArchVmAspaceInterface::ArchUnmapOptions;
 
 static bool arch_noncontiguous_map() {
@@ -2404,6 +2724,57 @@ static bool region_list_get_alloc_spot_no_memory_test() {
   END_TEST;
 }
 
+// Builds a heavily fragmented region list, with thousands of one page gaps too small for the
+// allocation and a single gap that fits, and checks that the subtree gap augmentation finds the
+// fitting gap, whether placement is first fit or randomized.
+static bool region_list_get_alloc_spot_fragmented_test() {
+  BEGIN_TEST;
+
+  TestRegionList test_list;
+  auto regions = test_list.get_regions();
+  const vaddr_t base = 0xFFFF000000000000;
+  const size_t size = 0x0001000000000000;
+  const uint8_t align_pow2 = PAGE_SIZE_SHIFT;
+  constexpr size_t kNumRegions = 10000;
+  constexpr size_t kLargeGapIndex = kNumRegions - 10;
+  constexpr size_t kLargeGapPages = 4;
+
+  // One page regions separated by one page gaps, except for a single larger gap near the end.
+  vaddr_t next = base;
+  for (size_t i = 0; i < kNumRegions; i++) {
+    test_list.insert_region(next, PAGE_SIZE);
+    next += (i == kLargeGapIndex ? kLargeGapPages + 1 : 2) * PAGE_SIZE;
+  }
+  const vaddr_t large_gap = base + (kLargeGapIndex * 2 + 1) * PAGE_SIZE;
+  // Cover the rest of the parent so the only fitting gap is the large one.
+  test_list.insert_region(next, size - (next - base));
+
+  // First fit has to skip every one page gap before the large one.
+  vaddr_t alloc_spot = 0;
+  ASSERT_EQ(ZX_OK, regions->GetAllocSpot(&alloc_spot, align_pow2, /*entropy=*/0, 2 * PAGE_SIZE,
+                                         base, size, /*prng=*/nullptr));
+  EXPECT_EQ(large_gap, alloc_spot);
+
+  // Randomized placement can only pick one of the spots in the large gap, and, over enough
+  // attempts, picks each of them.
+  const uint8_t seed[] = {0x5a, 0xa5, 0x3c, 0xc3};
+  crypto::Prng prng(seed, sizeof(seed));
+  constexpr size_t kSpots = kLargeGapPages - 1;
+  bool picked[kSpots] = {};
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(ZX_OK, regions->GetAllocSpot(&alloc_spot, align_pow2, /*entropy=*/20, 2 * PAGE_SIZE,
+                                           base, size, &prng));
+    ASSERT_GE(alloc_spot, large_gap);
+    ASSERT_LE(alloc_spot + 2 * PAGE_SIZE, large_gap + kLargeGapPages * PAGE_SIZE);
+    picked[(alloc_spot - large_gap) / PAGE_SIZE] = true;
+  }
+  for (bool p : picked) {
+    EXPECT_TRUE(p);
+  }
+
+  END_TEST;
+}
+
 static bool region_list_find_region_test() {
   BEGIN_TEST;
 
@@ -2816,6 +3187,45 @@ static bool address_region_enumerator_test() {
   END_TEST;
 }
 
+// Tests that EnumerateChildren visits every mapping when it drops the lock part way through.
+static bool enumerate_children_chunked_test() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmAspace> aspace = VmAspace::Create(VmAspace::Type::User, "test aspace");
+  ASSERT_NONNULL(aspace);
+  auto destroy_aspace = fit::defer([&aspace]() { aspace->Destroy(); });
+
+  constexpr size_t kNumMappings = VmAddressRegion::kEnumerateChunkSize * 2 + 1;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0u, PAGE_SIZE, &vmo));
+  fbl::RefPtr<VmAddressRegion> vmar;
+  ASSERT_OK(aspace->RootVmar()->CreateSubVmar(
+      0, kNumMappings * 2 * PAGE_SIZE, 0, VMAR_FLAG_CAN_MAP_SPECIFIC | VMAR_FLAG_CAN_MAP_READ,
+      "test vmar", &vmar));
+  // Leave a gap between each mapping so that none of them are merged.
+  for (size_t i = 0; i < kNumMappings; i++) {
+    auto mapping = vmar->CreateVmMapping(i * 2 * PAGE_SIZE, PAGE_SIZE, 0,
+                                         VMAR_FLAG_CAN_MAP_READ | VMAR_FLAG_SPECIFIC, vmo, 0,
+                                         ARCH_MMU_FLAG_PERM_READ, "mapping");
+    ASSERT_TRUE(mapping.is_ok());
+  }
+
+  class Counter final : public VmEnumerator {
+   public:
+    zx_status_t OnVmMapping(VmMapping* map, VmAddressRegion* vmar, uint depth,
+                            Guard<CriticalMutex>& guard) TA_REQ(map->lock())
+        TA_REQ(vmar->lock()) override {
+      mappings++;
+      return ZX_ERR_NEXT;
+    }
+    size_t mappings = 0;
+  } counter;
+  EXPECT_OK(vmar->EnumerateChildren(&counter));
+  EXPECT_EQ(kNumMappings, counter.mappings);
+
+  END_TEST;
+}
+
 // Doesn't do anything, just prints all aspaces.
 // Should be run after all other tests so that people can manually comb
 // through the output for leaked test aspaces.
@@ -2990,11 +3400,15 @@ VM_UNITTEST(vmaspace_create_smoke_test)
 VM_UNITTEST(vmaspace_create_invalid_ranges)
 VM_UNITTEST(vmaspace_alloc_smoke_test)
 VM_UNITTEST(vmaspace_accessed_test_untagged)
+VM_UNITTEST(vmaspace_fault_after_harvest_test)
 #if defined(__aarch64__)
 VM_UNITTEST(vmaspace_accessed_test_tagged)
 #endif
 VM_UNITTEST(vmaspace_unified_accessed_test)
+VM_UNITTEST(vmaspace_harvest_non_terminal_test)
 VM_UNITTEST(vmaspace_usercopy_accessed_fault_test)
+VM_UNITTEST(vmaspace_usercopy_resident_read_test)
+VM_UNITTEST(vmaspace_usercopy_ranges_test)
 VM_UNITTEST(vmaspace_free_unaccessed_page_tables_test)
 VM_UNITTEST(vmaspace_merge_mapping_test)
 VM_UNITTEST(vmaspace_priority_propagation_test)
@@ -3013,6 +3427,9 @@ VM_UNITTEST(vm_mapping_sparse_mapping_test)
 VM_UNITTEST(vm_mapping_page_fault_optimisation_test)
 VM_UNITTEST(vm_mapping_page_fault_optimization_pt_limit_test)
 VM_UNITTEST(vm_mapping_page_fault_range_test)
+VM_UNITTEST(vm_mapping_page_fault_around_test)
+VM_UNITTEST(vm_mapping_page_fault_around_limit_test)
+VM_UNITTEST(vmar_harvest_dirty_test)
 VM_UNITTEST(arch_is_user_accessible_range)
 VM_UNITTEST(validate_user_address_range)
 VM_UNITTEST(arch_noncontiguous_map)
@@ -3022,11 +3439,13 @@ VM_UNITTEST(arch_vm_aspace_protect_split_pages_out_of_memory)
 VM_UNITTEST(vm_kernel_region_test)
 VM_UNITTEST(region_list_get_alloc_spot_test)
 VM_UNITTEST(region_list_get_alloc_spot_no_memory_test)
+VM_UNITTEST(region_list_get_alloc_spot_fragmented_test)
 VM_UNITTEST(region_list_find_region_test)
 VM_UNITTEST(region_list_include_or_higher_test)
 VM_UNITTEST(region_list_upper_bound_test)
 VM_UNITTEST(region_list_is_range_available_test)
 VM_UNITTEST(address_region_enumerator_test)
+VM_UNITTEST(enumerate_children_chunked_test)
 VM_UNITTEST(dump_all_aspaces)  // Run last
 UNITTEST_END_TESTCASE(aspace_tests, "aspace", "VmAspace / ArchVmAspace / VMAR tests")
 
@@ -10,6 +10,7 @@
 
 #include <ktl/variant.h>
 #include <vm/lz4_compressor.h>
+#include <vm/lz4hc_compressor.h>
 #include <vm/slot_page_storage.h>
 
 #include "test_helper.h"
@@ -78,6 +79,50 @@ bool lz4_zero_dedupe_test() {
   END_TEST;
 }
 
+bool lz4hc_compress_smoke_test() {
+  BEGIN_TEST;
+
+  fbl::RefPtr<VmLz4HcCompressor> lz4hc = VmLz4HcCompressor::Create();
+  ASSERT_TRUE(lz4hc);
+  fbl::RefPtr<VmLz4Compressor> lz4 = VmLz4Compressor::Create();
+  ASSERT_TRUE(lz4);
+
+  fbl::AllocChecker ac;
+  fbl::Array<char> src = fbl::MakeArray<char>(&ac, PAGE_SIZE);
+  ASSERT_TRUE(ac.check());
+  fbl::Array<char> compressed = fbl::MakeArray<char>(&ac, PAGE_SIZE);
+  ASSERT_TRUE(ac.check());
+  fbl::Array<char> uncompressed = fbl::MakeArray<char>(&ac, PAGE_SIZE);
+  ASSERT_TRUE(ac.check());
+
+  for (size_t i = 0; i < PAGE_SIZE; i++) {
+    src[i] = static_cast<char>((i / 128) & 0xff);
+  }
+
+  VmCompressionStrategy::CompressResult fast_result =
+      lz4->Compress(src.get(), compressed.get(), PAGE_SIZE);
+  ASSERT_TRUE(ktl::holds_alternative<size_t>(fast_result));
+  VmCompressionStrategy::CompressResult result =
+      lz4hc->Compress(src.get(), compressed.get(), PAGE_SIZE);
+  ASSERT_TRUE(ktl::holds_alternative<size_t>(result));
+  // The high compression mode should never do worse than the accelerated fast mode.
+  EXPECT_LE(ktl::get<size_t>(result), ktl::get<size_t>(fast_result));
+
+  // Output is regular lz4, and so can be decompressed by either strategy.
+  lz4hc->Decompress(compressed.get(), ktl::get<size_t>(result), uncompressed.get());
+  EXPECT_EQ(0, memcmp(src.get(), uncompressed.get(), PAGE_SIZE));
+  memset(uncompressed.get(), 0, PAGE_SIZE);
+  lz4->Decompress(compressed.get(), ktl::get<size_t>(result), uncompressed.get());
+  EXPECT_EQ(0, memcmp(src.get(), uncompressed.get(), PAGE_SIZE));
+
+  // Zero pages should be detected.
+  memset(src.get(), 0, PAGE_SIZE);
+  EXPECT_TRUE(ktl::holds_alternative<VmCompressionStrategy::ZeroTag>(
+      lz4hc->Compress(src.get(), compressed.get(), PAGE_SIZE)));
+
+  END_TEST;
+}
+
 void write_zeros(vm_page_t* page, size_t len) {
   DEBUG_ASSERT(page);
   DEBUG_ASSERT(len <= PAGE_SIZE);
@@ -108,10 +153,9 @@ bool validate_pattern(const void* data, size_t len, uint64_t offset) {
 bool validate_pattern_ref(VmCompressedStorage& storage, VmCompressedStorage::CompressedRef ref,
                           size_t expected_len, uint64_t offset) {
   auto [data, metadata, size] = storage.CompressedData(ref);
-  if (size != expected_len) {
-    return false;
-  }
-  return validate_pattern(data, size, offset);
+  const bool valid = size == expected_len && validate_pattern(data, size, offset);
+  storage.ReleaseCompressedData(ref);
+  return valid;
 }
 
 VmCompressedStorage::CompressedRef store(VmCompressedStorage& storage, vm_page_t* page,
@@ -141,11 +185,14 @@ bool slot_page_storage_size_rounding() {
 
   VmSlotPageStorage storage;
 
+  // Every item is stored after a tag, which counts towards the slots it uses.
+  constexpr size_t kTag = VmSlotPageStorage::kItemTagSize;
   constexpr size_t kNumItems = 5;
-  constexpr size_t items[kNumItems] = {64, 128, 63, 1, 65};
+  constexpr size_t items[kNumItems] = {64 - kTag, 128 - kTag, 63 - kTag, 1, 65 - kTag};
 
-  // Store items that are a perfectly multiple of the slot size, as well as +/- 1 byte, to ensure
-  // that the correct number of slots is used and the remainder is calculated correctly.
+  // Store items that, with their tag, are a perfect multiple of the slot size, as well as +/- 1
+  // byte, to ensure that the correct number of slots is used and the remainder is calculated
+  // correctly.
   VmCompressedStorage::CompressedRef refs[kNumItems] = {
       store_pattern(storage, items[0], 0), store_pattern(storage, items[1], 1),
       store_pattern(storage, items[2], 2), store_pattern(storage, items[3], 3),
@@ -153,7 +200,7 @@ bool slot_page_storage_size_rounding() {
 
   // So far should have used 7 slots to store our 5 items. Using the remaining 57 slots should not
   // cause us to need a second storage page.
-  VmCompressedStorage::CompressedRef padding = store_pattern(storage, 57ul * 64, 5);
+  VmCompressedStorage::CompressedRef padding = store_pattern(storage, 57ul * 64 - kTag, 5);
   EXPECT_EQ(storage.GetInternalMemoryUsage().data_bytes, static_cast<size_t>(PAGE_SIZE));
 
   for (size_t i = 0; i < kNumItems; i++) {
@@ -166,6 +213,57 @@ bool slot_page_storage_size_rounding() {
   END_TEST;
 }
 
+// Test that compaction moves items out of sparsely used pages, frees the emptied pages, and keeps
+// the data of every reference intact.
+bool slot_page_storage_compaction() {
+  BEGIN_TEST;
+
+  VmSlotPageStorage storage;
+
+  // Items that, with their tag, use 15 slots each so that four of them are stored per page.
+  constexpr size_t kItemSize = 15 * VmSlotPageStorage::kSlotSize - VmSlotPageStorage::kItemTagSize;
+  constexpr size_t kPages = 4;
+  constexpr size_t kItemsPerPage = 4;
+  VmCompressedStorage::CompressedRef refs[kPages * kItemsPerPage];
+  for (size_t i = 0; i < ktl::size(refs); i++) {
+    refs[i] = store_pattern(storage, kItemSize, i);
+  }
+  EXPECT_EQ(kPages * PAGE_SIZE, storage.GetInternalMemoryUsage().data_bytes);
+
+  // Storage without much unused space is not compacted.
+  EXPECT_EQ(0u, storage.Compact(kPages));
+
+  // Free all but the first item in every page, leaving each page three quarters unused.
+  for (size_t i = 0; i < ktl::size(refs); i++) {
+    if (i % kItemsPerPage != 0) {
+      storage.Free(refs[i]);
+    }
+  }
+  EXPECT_EQ(kPages * PAGE_SIZE, storage.GetInternalMemoryUsage().data_bytes);
+
+  // Data that is being read cannot be moved.
+  storage.CompressedData(refs[0]);
+  EXPECT_EQ(0u, storage.Compact(kPages));
+  storage.ReleaseCompressedData(refs[0]);
+
+  // Two of the pages can be merged into the other two, after which the remaining free space is no
+  // longer worth compacting.
+  EXPECT_EQ(2u, storage.Compact(kPages));
+  EXPECT_EQ(2 * PAGE_SIZE, storage.GetInternalMemoryUsage().data_bytes);
+  VmCompressedStorage::CompactionStats stats = storage.GetCompactionStats();
+  EXPECT_EQ(1u, stats.runs);
+  EXPECT_EQ(2u, stats.items_moved);
+  EXPECT_EQ(2u, stats.pages_freed);
+
+  for (size_t i = 0; i < ktl::size(refs); i += kItemsPerPage) {
+    EXPECT_TRUE(validate_pattern_ref(storage, refs[i], kItemSize, i));
+    storage.Free(refs[i]);
+  }
+  EXPECT_EQ(0u, storage.GetInternalMemoryUsage().data_bytes);
+
+  END_TEST;
+}
+
 // Test that the high-level compression-deconmpression flow preserves page data and metadata.
 bool compression_smoke_test() {
   BEGIN_TEST;
@@ -391,16 +489,348 @@ bool compression_move_reference_test() {
   END_TEST;
 }
 
+// Test that multiple compressor instances can be held and used at the same time, each with their
+// own temporary reference.
+bool compression_multiple_compressors_test() {
+  BEGIN_TEST;
+
+  constexpr uint32_t kCompressionThreshhold = static_cast<uint32_t>(PAGE_SIZE) * 70u / 100u;
+  constexpr size_t kNumCompressors = 2;
+  fbl::AllocChecker ac;
+  fbl::RefPtr<VmLz4Compressor> lz4 = VmLz4Compressor::Create(kNumCompressors);
+  ASSERT_TRUE(lz4);
+  fbl::RefPtr<VmSlotPageStorage> storage = fbl::MakeRefCountedChecked<VmSlotPageStorage>(&ac);
+  ASSERT_TRUE(ac.check());
+  fbl::RefPtr<VmCompression> compression = fbl::MakeRefCountedChecked<VmCompression>(
+      &ac, ktl::move(storage), ktl::move(lz4), kCompressionThreshhold, kNumCompressors);
+  ASSERT_TRUE(ac.check());
+  EXPECT_EQ(kNumCompressors, compression->NumCompressors());
+
+  vm_page_t* pages[kNumCompressors];
+  for (size_t i = 0; i < kNumCompressors; i++) {
+    zx_status_t status = pmm_alloc_page(0, &pages[i]);
+    ASSERT_EQ(ZX_OK, status);
+    write_pattern(pages[i], PAGE_SIZE, i);
+  }
+
+  // Acquiring a second compressor while holding the first must not block, and must give a
+  // different instance.
+  auto guard1 = compression->AcquireCompressor();
+  auto guard2 = compression->AcquireCompressor();
+  VmCompressor& compressor1 = guard1.get();
+  VmCompressor& compressor2 = guard2.get();
+  EXPECT_TRUE(&compressor1 != &compressor2);
+
+  ASSERT_OK(compressor1.Arm());
+  ASSERT_OK(compressor2.Arm());
+  auto temp_ref1 =
+      compressor1.Start(VmCompressor::PageAndMetadata{.page = pages[0], .metadata = 1});
+  auto temp_ref2 =
+      compressor2.Start(VmCompressor::PageAndMetadata{.page = pages[1], .metadata = 2});
+  EXPECT_NE(temp_ref1.value(), temp_ref2.value());
+  EXPECT_TRUE(compression->IsTempReference(temp_ref1));
+  EXPECT_TRUE(compression->IsTempReference(temp_ref2));
+  EXPECT_TRUE(compressor1.IsTempReference(temp_ref1));
+  EXPECT_FALSE(compressor1.IsTempReference(temp_ref2));
+
+  // Metadata and decompression of a temporary reference must resolve to the owning instance.
+  EXPECT_EQ(1u, compression->GetMetadata(temp_ref1));
+  EXPECT_EQ(2u, compression->GetMetadata(temp_ref2));
+  compression->SetMetadata(temp_ref2, 3);
+  EXPECT_EQ(1u, compression->GetMetadata(temp_ref1));
+  EXPECT_EQ(3u, compression->GetMetadata(temp_ref2));
+
+  compressor1.Compress();
+  compressor2.Compress();
+
+  fbl::Array<uint8_t> buffer = fbl::MakeArray<uint8_t>(&ac, PAGE_SIZE);
+  ASSERT_TRUE(ac.check());
+  uint32_t metadata = 0;
+  compression->Decompress(temp_ref2, buffer.get(), &metadata);
+  EXPECT_EQ(3u, metadata);
+  EXPECT_TRUE(validate_pattern(buffer.get(), PAGE_SIZE, 1));
+  EXPECT_FALSE(compressor2.IsTempReferenceInUse());
+  EXPECT_TRUE(compressor1.IsTempReferenceInUse());
+
+  VmCompressor* compressors[] = {&compressor1, &compressor2};
+  for (VmCompressor* compressor : compressors) {
+    auto result = compressor->TakeCompressionResult();
+    if (auto* ref = ktl::get_if<VmCompressor::CompressedRef>(&result)) {
+      compressor->Free(*ref);
+    }
+  }
+  compressor1.ReturnTempReference(temp_ref1);
+  compressor1.Finalize();
+  compressor2.Finalize();
+
+  for (vm_page_t* page : pages) {
+    pmm_free_page(page);
+  }
+
+  END_TEST;
+}
+
+// Test that a batch of references can be decompressed and freed in one call, and that the storage
+// is fully released afterwards.
+bool compression_batch_test() {
+  BEGIN_TEST;
+
+  constexpr uint32_t kCompressionThreshhold = static_cast<uint32_t>(PAGE_SIZE) * 70u / 100u;
+  fbl::AllocChecker ac;
+  fbl::RefPtr<VmLz4Compressor> lz4 = VmLz4Compressor::Create();
+  ASSERT_TRUE(lz4);
+  fbl::RefPtr<VmSlotPageStorage> storage = fbl::MakeRefCountedChecked<VmSlotPageStorage>(&ac);
+  ASSERT_TRUE(ac.check());
+  VmSlotPageStorage* storage_ptr = storage.get();
+  fbl::RefPtr<VmCompression> compression = fbl::MakeRefCountedChecked<VmCompression>(
+      &ac, ktl::move(storage), ktl::move(lz4), kCompressionThreshhold);
+  ASSERT_TRUE(ac.check());
+
+  // Compress a run of pages, each with a different pattern and metadata.
+  constexpr size_t kPages = 4;
+  VmCompressor::CompressedRef refs[kPages];
+  vm_page_t* buffer_page = nullptr;
+  auto free_buffer = fit::defer([&buffer_page]() {
+    if (buffer_page) {
+      pmm_free_page(buffer_page);
+    }
+  });
+  for (size_t i = 0; i < kPages; i++) {
+    vm_page_t* page;
+    ASSERT_OK(pmm_alloc_page(0, &page));
+    write_pattern(page, PAGE_SIZE, i);
+    auto result = compression->Compress(paddr_to_physmap(page->paddr()), &buffer_page);
+    pmm_free_page(page);
+    ASSERT_TRUE(ktl::holds_alternative<VmCompressor::CompressedRef>(result));
+    refs[i] = ktl::get<VmCompressor::CompressedRef>(result);
+    compression->SetMetadata(refs[i], static_cast<uint32_t>(i));
+  }
+  EXPECT_EQ(kPages * PAGE_SIZE, storage_ptr->GetMemoryUsage().uncompressed_content_bytes);
+
+  // Decompress all but the last page as a batch.
+  constexpr size_t kDecompress = kPages - 1;
+  fbl::Array<uint8_t> data = fbl::MakeArray<uint8_t>(&ac, kDecompress * PAGE_SIZE);
+  ASSERT_TRUE(ac.check());
+  void* dests[kDecompress];
+  uint32_t metadata[kDecompress] = {};
+  for (size_t i = 0; i < kDecompress; i++) {
+    dests[i] = &data[i * PAGE_SIZE];
+  }
+  compression->DecompressBatch(ktl::span(refs, kDecompress), ktl::span(dests),
+                               ktl::span(metadata));
+  for (size_t i = 0; i < kDecompress; i++) {
+    EXPECT_TRUE(validate_pattern(dests[i], PAGE_SIZE, i));
+    EXPECT_EQ(i, metadata[i]);
+  }
+  EXPECT_EQ(PAGE_SIZE, storage_ptr->GetMemoryUsage().uncompressed_content_bytes);
+
+  // Free the remainder without decompressing.
+  compression->FreeBatch(ktl::span(refs).subspan(kDecompress));
+  EXPECT_EQ(0u, storage_ptr->GetMemoryUsage().uncompressed_content_bytes);
+  EXPECT_EQ(0u, storage_ptr->GetMemoryUsage().compressed_storage_used_bytes);
+
+  END_TEST;
+}
+
+bool compression_dense_strategy_test() {
+  BEGIN_TEST;
+
+  constexpr uint32_t kCompressionThreshhold = static_cast<uint32_t>(PAGE_SIZE) * 70u / 100u;
+  fbl::AllocChecker ac;
+  fbl::RefPtr<VmLz4Compressor> lz4 = VmLz4Compressor::Create();
+  ASSERT_TRUE(lz4);
+  fbl::RefPtr<VmLz4HcCompressor> lz4hc = VmLz4HcCompressor::Create();
+  ASSERT_TRUE(lz4hc);
+  fbl::RefPtr<VmSlotPageStorage> storage = fbl::MakeRefCountedChecked<VmSlotPageStorage>(&ac);
+  ASSERT_TRUE(ac.check());
+  fbl::RefPtr<VmCompression> compression = fbl::MakeRefCountedChecked<VmCompression>(
+      &ac, ktl::move(storage), ktl::move(lz4), kCompressionThreshhold, 1, ktl::move(lz4hc));
+  ASSERT_TRUE(ac.check());
+  EXPECT_TRUE(compression->HasDenseStrategy());
+
+  vm_page_t* buffer_page = nullptr;
+  auto free_buffer = fit::defer([&buffer_page]() {
+    if (buffer_page) {
+      pmm_free_page(buffer_page);
+    }
+  });
+  vm_page_t* page;
+  ASSERT_OK(pmm_alloc_page(0, &page));
+  auto free_page = fit::defer([page]() { pmm_free_page(page); });
+  write_pattern(page, PAGE_SIZE, 0);
+
+  // Data compressed with either effort is decompressed by the regular strategy.
+  for (VmCompressor::Effort effort : {VmCompressor::Effort::Fast, VmCompressor::Effort::Dense}) {
+    auto result = compression->Compress(paddr_to_physmap(page->paddr()), &buffer_page, effort);
+    ASSERT_TRUE(ktl::holds_alternative<VmCompressor::CompressedRef>(result));
+    fbl::Array<uint8_t> data = fbl::MakeArray<uint8_t>(&ac, PAGE_SIZE);
+    ASSERT_TRUE(ac.check());
+    uint32_t metadata;
+    compression->Decompress(ktl::get<VmCompressor::CompressedRef>(result), data.get(), &metadata);
+    EXPECT_TRUE(validate_pattern(data.get(), PAGE_SIZE, 0));
+  }
+
+  END_TEST;
+}
+
+// A strategy that refuses to compress anything, but can decompress lz4 data.
+class FailingLz4Strategy final : public VmCompressionStrategy {
+ public:
+  explicit FailingLz4Strategy(fbl::RefPtr<VmLz4Compressor> lz4) : lz4_(ktl::move(lz4)) {}
+  CompressResult Compress(const void* src, void* dst, size_t dst_limit) final { return FailTag{}; }
+  void Decompress(const void* src, size_t src_len, void* dst) final {
+    lz4_->Decompress(src, src_len, dst);
+  }
+  void Dump() const final {}
+
+ private:
+  const fbl::RefPtr<VmLz4Compressor> lz4_;
+};
+
+bool compression_dense_retry_test() {
+  BEGIN_TEST;
+
+  constexpr uint32_t kCompressionThreshhold = static_cast<uint32_t>(PAGE_SIZE) * 70u / 100u;
+  fbl::AllocChecker ac;
+  fbl::RefPtr<VmLz4Compressor> lz4 = VmLz4Compressor::Create();
+  ASSERT_TRUE(lz4);
+
+  vm_page_t* buffer_page = nullptr;
+  auto free_buffer = fit::defer([&buffer_page]() {
+    if (buffer_page) {
+      pmm_free_page(buffer_page);
+    }
+  });
+  vm_page_t* page;
+  ASSERT_OK(pmm_alloc_page(0, &page));
+  auto free_page = fit::defer([page]() { pmm_free_page(page); });
+  write_pattern(page, PAGE_SIZE, 0);
+
+  // Without retries a failed fast compression is reported as a failure, and with them the dense
+  // strategy gets to store the page.
+  for (bool dense_retry : {false, true}) {
+    fbl::RefPtr<FailingLz4Strategy> failing =
+        fbl::MakeRefCountedChecked<FailingLz4Strategy>(&ac, lz4);
+    ASSERT_TRUE(ac.check());
+    fbl::RefPtr<VmLz4HcCompressor> lz4hc = VmLz4HcCompressor::Create();
+    ASSERT_TRUE(lz4hc);
+    fbl::RefPtr<VmSlotPageStorage> storage = fbl::MakeRefCountedChecked<VmSlotPageStorage>(&ac);
+    ASSERT_TRUE(ac.check());
+    fbl::RefPtr<VmCompression> compression = fbl::MakeRefCountedChecked<VmCompression>(
+        &ac, ktl::move(storage), ktl::move(failing), kCompressionThreshhold, 1, ktl::move(lz4hc),
+        0, dense_retry);
+    ASSERT_TRUE(ac.check());
+
+    auto result = compression->Compress(paddr_to_physmap(page->paddr()), &buffer_page);
+    if (!dense_retry) {
+      EXPECT_TRUE(ktl::holds_alternative<VmCompressor::FailTag>(result));
+      continue;
+    }
+    ASSERT_TRUE(ktl::holds_alternative<VmCompressor::CompressedRef>(result));
+    fbl::Array<uint8_t> data = fbl::MakeArray<uint8_t>(&ac, PAGE_SIZE);
+    ASSERT_TRUE(ac.check());
+    uint32_t metadata;
+    compression->Decompress(ktl::get<VmCompressor::CompressedRef>(result), data.get(), &metadata);
+    EXPECT_TRUE(validate_pattern(data.get(), PAGE_SIZE, 0));
+  }
+
+  END_TEST;
+}
+
+bool compression_dedup_test() {
+  BEGIN_TEST;
+
+  constexpr uint32_t kCompressionThreshhold = static_cast<uint32_t>(PAGE_SIZE) * 70u / 100u;
+  fbl::AllocChecker ac;
+  fbl::RefPtr<VmLz4Compressor> lz4 = VmLz4Compressor::Create();
+  ASSERT_TRUE(lz4);
+  fbl::RefPtr<VmSlotPageStorage> storage = fbl::MakeRefCountedChecked<VmSlotPageStorage>(&ac);
+  ASSERT_TRUE(ac.check());
+  VmSlotPageStorage* storage_ptr = storage.get();
+  fbl::RefPtr<VmCompression> compression = fbl::MakeRefCountedChecked<VmCompression>(
+      &ac, ktl::move(storage), ktl::move(lz4), kCompressionThreshhold, 1, nullptr, 64);
+  ASSERT_TRUE(ac.check());
+  EXPECT_TRUE(compression->IsDedupEnabled());
+
+  vm_page_t* buffer_page = nullptr;
+  auto free_buffer = fit::defer([&buffer_page]() {
+    if (buffer_page) {
+      pmm_free_page(buffer_page);
+    }
+  });
+  vm_page_t* page;
+  ASSERT_OK(pmm_alloc_page(0, &page));
+  auto free_page = fit::defer([page]() { pmm_free_page(page); });
+  write_pattern(page, PAGE_SIZE, 0);
+  void* page_src = paddr_to_physmap(page->paddr());
+
+  // Nothing is stored yet, so there is nothing to merge with.
+  EXPECT_FALSE(compression->Dedup(page_src, 0).has_value());
+
+  // Compressing the same contents twice should result in a single stored copy.
+  auto result = compression->Compress(page_src, &buffer_page);
+  ASSERT_TRUE(ktl::holds_alternative<VmCompressor::CompressedRef>(result));
+  VmCompressor::CompressedRef first = ktl::get<VmCompressor::CompressedRef>(result);
+  compression->SetMetadata(first, 1);
+  const uint64_t used_bytes = storage_ptr->GetMemoryUsage().compressed_storage_used_bytes;
+  result = compression->Compress(page_src, &buffer_page);
+  ASSERT_TRUE(ktl::holds_alternative<VmCompressor::CompressedRef>(result));
+  VmCompressor::CompressedRef second = ktl::get<VmCompressor::CompressedRef>(result);
+  EXPECT_NE(first.value(), second.value());
+  compression->SetMetadata(second, 2);
+  EXPECT_EQ(2 * PAGE_SIZE, storage_ptr->GetMemoryUsage().uncompressed_content_bytes);
+  EXPECT_EQ(used_bytes, storage_ptr->GetMemoryUsage().compressed_storage_used_bytes);
+
+  // A third reference can be made directly, and every reference has its own metadata.
+  EXPECT_TRUE(compression->IsDedupCandidate(page_src));
+  ktl::optional<VmCompressor::CompressedRef> third = compression->Dedup(page_src, 3);
+  ASSERT_TRUE(third);
+  EXPECT_EQ(1u, compression->GetMetadata(first));
+  EXPECT_EQ(2u, compression->GetMetadata(second));
+  EXPECT_EQ(3u, compression->GetMetadata(*third));
+
+  // Different contents should not match.
+  write_pattern(page, PAGE_SIZE, 1);
+  EXPECT_FALSE(compression->Dedup(page_src, 0).has_value());
+
+  // Releasing the original reference must leave the data intact for the others.
+  fbl::Array<uint8_t> data = fbl::MakeArray<uint8_t>(&ac, PAGE_SIZE);
+  ASSERT_TRUE(ac.check());
+  uint32_t metadata;
+  compression->Decompress(first, data.get(), &metadata);
+  EXPECT_TRUE(validate_pattern(data.get(), PAGE_SIZE, 0));
+  EXPECT_EQ(1u, metadata);
+  memset(data.get(), 0, PAGE_SIZE);
+  compression->Decompress(*third, data.get(), &metadata);
+  EXPECT_TRUE(validate_pattern(data.get(), PAGE_SIZE, 0));
+  EXPECT_EQ(3u, metadata);
+  EXPECT_EQ(PAGE_SIZE, storage_ptr->GetMemoryUsage().uncompressed_content_bytes);
+  EXPECT_EQ(used_bytes, storage_ptr->GetMemoryUsage().compressed_storage_used_bytes);
+
+  compression->Free(second);
+  EXPECT_EQ(0u, storage_ptr->GetMemoryUsage().uncompressed_content_bytes);
+  EXPECT_EQ(0u, storage_ptr->GetMemoryUsage().compressed_storage_used_bytes);
+
+  END_TEST;
+}
+
 }  // namespace
 
 UNITTEST_START_TESTCASE(compression_tests)
 VM_UNITTEST(lz4_compress_smoke_test)
 VM_UNITTEST(lz4_zero_dedupe_test)
+VM_UNITTEST(lz4hc_compress_smoke_test)
 VM_UNITTEST(slot_page_storage_size_rounding)
+VM_UNITTEST(slot_page_storage_compaction)
 VM_UNITTEST(compression_smoke_test)
 VM_UNITTEST(compression_zero_test)
 VM_UNITTEST(compression_fail_test)
 VM_UNITTEST(compression_move_reference_test)
+VM_UNITTEST(compression_multiple_compressors_test)
+VM_UNITTEST(compression_batch_test)
+VM_UNITTEST(compression_dense_strategy_test)
+VM_UNITTEST(compression_dense_retry_test)
+VM_UNITTEST(compression_dedup_test)
 UNITTEST_END_TESTCASE(compression_tests, "compression", "Compression tests")
 
 }  // namespace vm_unittest
@@ -4,24 +4,27 @@
 // license that can be found in the LICENSE file or at
 // https://opensource.org/licenses/MIT
 
+#include <ktl/unique_ptr.h>
 #include <vm/evictor.h>
+#include <vm/workingset.h>
 
 #include "test_helper.h"
 
 namespace vm_unittest {
 
 // Custom pmm node to link with the evictor under test. Facilitates verifying the free count which
-// is not possible with the global pmm node.
+// is not possible with the global pmm node. Fake reclamation is serialized so that evictors with
+// eviction workers can be tested.
 class TestPmmNode {
  public:
-  explicit TestPmmNode(bool discardable)
+  explicit TestPmmNode(bool discardable, uint32_t num_workers = 0)
       : evictor_(
             [this](VmCompression* compression, Evictor::EvictionLevel eviction_level) {
               return this->TestReclaim(compression, eviction_level);
             },
             [this]() { return this->FreePages(); }),
         discardable_(discardable) {
-    evictor_.EnableEviction(true);
+    evictor_.EnableEviction(true, num_workers);
   }
 
   ~TestPmmNode() = default;
@@ -36,17 +39,40 @@ class TestPmmNode {
     return evictor_.EvictFromPreloadedTarget();
   }
 
-  uint64_t FreePages() const { return free_pages_; }
+  Evictor::EvictedPageCounts EvictProactively(const Evictor::ProactiveWatermarks& marks,
+                                              bool* reclaiming) {
+    return evictor_.EvictProactively(marks, reclaiming);
+  }
+
+  uint64_t FreePages() const {
+    Guard<Mutex> guard{&lock_};
+    return free_pages_;
+  }
+
+  void ConsumePages(uint64_t count) {
+    Guard<Mutex> guard{&lock_};
+    ASSERT(count <= free_pages_);
+    free_pages_ -= count;
+  }
 
   Evictor* evictor() { return &evictor_; }
 
-  void CapEvictions(uint64_t max) { max_evictions_ = max; }
+  uint32_t NumWorkers() const { return evictor_.DebugNumWorkers(); }
 
-  void UncapEvictions() { max_evictions_ = UINT64_MAX; }
+  void CapEvictions(uint64_t max) {
+    Guard<Mutex> guard{&lock_};
+    max_evictions_ = max;
+  }
+
+  void UncapEvictions() {
+    Guard<Mutex> guard{&lock_};
+    max_evictions_ = UINT64_MAX;
+  }
 
  private:
   ktl::optional<Evictor::EvictedPageCounts> TestReclaim(VmCompression* compression,
                                                         Evictor::EvictionLevel eviction_level) {
+    Guard<Mutex> guard{&lock_};
     if (total_evictions_ >= max_evictions_) {
       return ktl::nullopt;
     }
@@ -67,9 +93,10 @@ class TestPmmNode {
     };
   }
 
-  uint64_t free_pages_ = 0;
-  uint64_t total_evictions_ = 0;
-  uint64_t max_evictions_ = UINT64_MAX;
+  mutable DECLARE_MUTEX(TestPmmNode) lock_;
+  uint64_t free_pages_ TA_GUARDED(lock_) = 0;
+  uint64_t total_evictions_ TA_GUARDED(lock_) = 0;
+  uint64_t max_evictions_ TA_GUARDED(lock_) = UINT64_MAX;
   Evictor evictor_;
   bool discardable_;
 };
@@ -426,6 +453,127 @@ static bool evictor_min_target_carried_over_test() {
   END_TEST;
 }
 
+// Test that proactive eviction reclaims from the low to the high watermark within its budget.
+static bool evictor_proactive_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+  TestPmmNode node(false);
+
+  const Evictor::ProactiveWatermarks marks = {
+      .low_pages = 40,
+      .high_pages = 60,
+      .pages_per_period = 15,
+  };
+  bool reclaiming = false;
+
+  // Starting below half of the low watermark allows twice the budget.
+  auto counts = node.EvictProactively(marks, &reclaiming);
+  EXPECT_EQ(counts.pager_backed, 2 * marks.pages_per_period);
+  EXPECT_TRUE(reclaiming);
+  EXPECT_EQ(node.FreePages(), 30u);
+
+  // Above the low watermark eviction carries on towards the high one, at the normal budget.
+  counts = node.EvictProactively(marks, &reclaiming);
+  EXPECT_EQ(counts.pager_backed, marks.pages_per_period);
+  counts = node.EvictProactively(marks, &reclaiming);
+  EXPECT_EQ(counts.pager_backed, marks.pages_per_period);
+  EXPECT_EQ(node.FreePages(), marks.high_pages);
+
+  // Having reached the high watermark, nothing more is evicted.
+  counts = node.EvictProactively(marks, &reclaiming);
+  EXPECT_EQ(counts.pager_backed, 0u);
+  EXPECT_FALSE(reclaiming);
+
+  // Dropping between the watermarks does not restart eviction.
+  node.ConsumePages(10);
+  counts = node.EvictProactively(marks, &reclaiming);
+  EXPECT_EQ(counts.pager_backed, 0u);
+  EXPECT_FALSE(reclaiming);
+
+  // Dropping below the low watermark does.
+  node.ConsumePages(15);
+  counts = node.EvictProactively(marks, &reclaiming);
+  EXPECT_EQ(counts.pager_backed, marks.pages_per_period);
+  EXPECT_TRUE(reclaiming);
+  EXPECT_EQ(node.FreePages(), 50u);
+
+  END_TEST;
+}
+
+// Test that evictions split between eviction workers evict exactly what was asked for, and stop
+// once there is nothing left to evict.
+static bool evictor_parallel_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+  TestPmmNode node(false, 3);
+  EXPECT_EQ(node.NumWorkers(), 3u);
+
+  // Small evictions are not split up, large ones are, and either way the counts are exact.
+  uint64_t evicted = node.evictor()->EvictSynchronous(5 * PAGE_SIZE);
+  EXPECT_EQ(evicted, 5u);
+  const uint64_t kLarge = Evictor::kWorkerBatchPages * 10 + 7;
+  evicted = node.evictor()->EvictSynchronous(kLarge * PAGE_SIZE);
+  EXPECT_EQ(evicted, kLarge);
+  EXPECT_EQ(node.FreePages(), kLarge + 5);
+
+  // Running out of pages part way through a batch ends the whole parallel eviction.
+  node.CapEvictions(kLarge + 5 + Evictor::kWorkerBatchPages * 3 + 1);
+  evicted = node.evictor()->EvictSynchronous(kLarge * PAGE_SIZE);
+  EXPECT_EQ(evicted, Evictor::kWorkerBatchPages * 3 + 1);
+
+  // The workers go away with eviction, and the count is capped when it comes back.
+  node.evictor()->DisableEviction();
+  EXPECT_EQ(node.NumWorkers(), 0u);
+  EXPECT_EQ(node.evictor()->EvictSynchronous(kLarge * PAGE_SIZE), 0u);
+  node.UncapEvictions();
+  node.evictor()->EnableEviction(true, Evictor::kMaxEvictionWorkers + 1);
+  EXPECT_EQ(node.NumWorkers(), Evictor::kMaxEvictionWorkers);
+  evicted = node.evictor()->EvictSynchronous(kLarge * PAGE_SIZE);
+  EXPECT_EQ(evicted, kLarge);
+
+  END_TEST;
+}
+
+// Test that the refault distance of an evicted page counts the evictions since.
+static bool workingset_refault_distance_test() {
+  BEGIN_TEST;
+
+  ktl::unique_ptr<Workingset> workingset = Workingset::Create(1000);
+  ASSERT_NONNULL(workingset);
+  // The table is rounded up to a power of two entries.
+  EXPECT_EQ(1024u, workingset->num_shadows());
+  EXPECT_NULL(Workingset::Create(0));
+
+  int object;
+  // Nothing has been evicted yet.
+  EXPECT_FALSE(workingset->TakeRefaultDistance(&object, 0).has_value());
+
+  workingset->RecordEviction(&object, 0);
+  workingset->RecordEviction(&object, PAGE_SIZE);
+  workingset->RecordEviction(&object, 2 * PAGE_SIZE);
+
+  ktl::optional<uint32_t> distance = workingset->TakeRefaultDistance(&object, 0);
+  ASSERT_TRUE(distance.has_value());
+  EXPECT_EQ(*distance, 2u);
+  // The shadow entry is consumed by the refault.
+  EXPECT_FALSE(workingset->TakeRefaultDistance(&object, 0).has_value());
+
+  distance = workingset->TakeRefaultDistance(&object, 2 * PAGE_SIZE);
+  ASSERT_TRUE(distance.has_value());
+  EXPECT_EQ(*distance, 0u);
+
+  // A different object at the same offset has no shadow.
+  int other;
+  EXPECT_FALSE(workingset->TakeRefaultDistance(&other, PAGE_SIZE).has_value());
+
+  EXPECT_TRUE(Workingset::IsWorkingsetRefault(10, 10));
+  EXPECT_FALSE(Workingset::IsWorkingsetRefault(11, 10));
+
+  END_TEST;
+}
+
 UNITTEST_START_TESTCASE(evictor_tests)
 VM_UNITTEST(evictor_set_target_test)
 VM_UNITTEST(evictor_combine_targets_test)
@@ -434,6 +582,9 @@ VM_UNITTEST(evictor_discardable_test)
 VM_UNITTEST(evictor_free_target_test)
 VM_UNITTEST(evictor_external_target_test)
 VM_UNITTEST(evictor_min_target_carried_over_test)
+VM_UNITTEST(evictor_proactive_test)
+VM_UNITTEST(evictor_parallel_test)
+VM_UNITTEST(workingset_refault_distance_test)
 UNITTEST_END_TESTCASE(evictor_tests, "evictor", "Evictor tests")
 
 }  // namespace vm_unittest
@@ -6,6 +6,8 @@
 
 #include <lib/fit/defer.h>
 
+#include <vm/zeroed_page_pool.h>
+
 #include "test_helper.h"
 
 namespace vm_unittest {
@@ -25,7 +27,9 @@ class ManagedPmmNode {
   static constexpr size_t kDefaultMemEventAlloc =
       ManagedPmmNode::kNumPages - kDefaultMemEventLowerBound + 1;
 
-  ManagedPmmNode() {
+  // Test nodes have checking enabled by default, which bypasses the page magazines. Nodes that want
+  // to exercise the magazines must disable checking and provide a |magazine_size|.
+  explicit ManagedPmmNode(bool enable_checker = true, size_t magazine_size = 0) {
     list_node list = LIST_INITIAL_VALUE(list);
     ZX_ASSERT(pmm_alloc_pages(kNumPages, 0, &list) == ZX_OK);
     vm_page_t* page;
@@ -36,9 +40,11 @@ class ManagedPmmNode {
     }
     node_.AddFreePages(&list);
 
-    // Test node always has checking enabled.
-    ASSERT(node_.EnableFreePageFilling(PAGE_SIZE, CheckFailAction::kPanic));
-    node_.FillFreePagesAndArm();
+    if (enable_checker) {
+      ASSERT(node_.EnableFreePageFilling(PAGE_SIZE, CheckFailAction::kPanic));
+      node_.FillFreePagesAndArm();
+    }
+    ASSERT(node_.InitMagazines(magazine_size) == ZX_OK);
 
     bool result = ResetDefaultMemEvent();
     ASSERT(result);
@@ -339,6 +345,92 @@ static bool pmm_node_oversized_alloc_test() {
   END_TEST;
 }
 
+// Checks that pages cached in the per-CPU magazines are still accounted as free and can always be
+// allocated.
+static bool pmm_node_magazine_test() {
+  BEGIN_TEST;
+
+  ManagedPmmNode node(false, 8);
+  EXPECT_EQ(ManagedPmmNode::kNumPages, node.node().CountFreePages());
+
+  // A single allocation refills the current magazine, which should not change the free count beyond
+  // the page actually allocated.
+  zx::result<vm_page_t*> result = node.node().AllocPage(0);
+  ASSERT_OK(result.status_value());
+  EXPECT_EQ(vm_page_state::ALLOC, (*result)->state());
+  EXPECT_EQ(ManagedPmmNode::kNumPages - 1, node.node().CountFreePages());
+  node.node().FreePage(*result);
+  EXPECT_EQ(ManagedPmmNode::kNumPages, node.node().CountFreePages());
+
+  // Every page must be allocatable one at a time, even though some are cached in magazines.
+  list_node list = LIST_INITIAL_VALUE(list);
+  for (size_t i = 0; i < ManagedPmmNode::kNumPages; i++) {
+    result = node.node().AllocPage(0);
+    ASSERT_OK(result.status_value());
+    list_add_tail(&list, &(*result)->queue_node);
+  }
+  EXPECT_EQ(0u, node.node().CountFreePages());
+
+  // Free back via the magazines and then drain them, all pages should be on the free list such that
+  // a bulk allocation of everything succeeds.
+  while (vm_page_t* page = list_remove_head_type(&list, vm_page_t, queue_node)) {
+    node.node().FreePage(page);
+  }
+  EXPECT_EQ(ManagedPmmNode::kNumPages, node.node().CountFreePages());
+  node.node().DrainMagazines();
+  EXPECT_EQ(ZX_OK, node.node().AllocPages(ManagedPmmNode::kNumPages, 0, &list));
+  node.node().FreeList(&list);
+
+  END_TEST;
+}
+
+// Checks that allocations prefer the free list of the current CPU's NUMA node, and fall back to the
+// other nodes once it is empty.
+static bool pmm_node_numa_test() {
+  BEGIN_TEST;
+
+  ManagedPmmNode node;
+
+  // Place a single page on node 1.
+  zx::result<vm_page_t*> result = node.node().AllocPage(0);
+  ASSERT_OK(result.status_value());
+  vm_page_t* const remote = *result;
+  node.node().FreePage(remote);
+  const PmmNode::NumaMemoryRange ranges[] = {
+      {.base = remote->paddr(), .size = PAGE_SIZE, .node = 1}};
+  uint8_t cpu_nodes[SMP_MAX_CPUS];
+
+  // With every CPU on node 1 the page is the only local one, and so must be allocated first.
+  ktl::fill(cpu_nodes, cpu_nodes + SMP_MAX_CPUS, 1);
+  ASSERT_OK(node.node().SetNumaNodes(ranges, cpu_nodes));
+  result = node.node().AllocPage(0);
+  ASSERT_OK(result.status_value());
+  EXPECT_EQ(remote, *result);
+  node.node().FreePage(*result);
+
+  // With every CPU on node 0 the page must be allocated last.
+  ktl::fill(cpu_nodes, cpu_nodes + SMP_MAX_CPUS, 0);
+  ASSERT_OK(node.node().SetNumaNodes(ranges, cpu_nodes));
+  list_node list = LIST_INITIAL_VALUE(list);
+  ASSERT_OK(node.node().AllocPages(ManagedPmmNode::kNumPages - 1, 0, &list));
+  vm_page_t* page;
+  list_for_every_entry (&list, page, vm_page_t, queue_node) {
+    EXPECT_NE(remote, page);
+  }
+  result = node.node().AllocPage(0);
+  ASSERT_OK(result.status_value());
+  EXPECT_EQ(remote, *result);
+  node.node().FreePage(*result);
+  node.node().FreeList(&list);
+  EXPECT_EQ(ManagedPmmNode::kNumPages, node.node().CountFreePages());
+
+  const PmmNode::NumaMemoryRange bad_ranges[] = {
+      {.base = remote->paddr(), .size = PAGE_SIZE, .node = PmmNode::kMaxNumaNodes}};
+  EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, node.node().SetNumaNodes(bad_ranges, {}));
+
+  END_TEST;
+}
+
 // Check that free memory events work correctly.
 static bool pmm_node_free_mem_event_test() {
   BEGIN_TEST;
@@ -563,12 +655,55 @@ static bool pmm_checker_test() {
 
   EXPECT_TRUE(pmm_checker_test_with_fill_size(8));
   EXPECT_TRUE(pmm_checker_test_with_fill_size(16));
+  // Not a multiple of the 64 byte validation step, so exercises the trailing words.
+  EXPECT_TRUE(pmm_checker_test_with_fill_size(72));
   EXPECT_TRUE(pmm_checker_test_with_fill_size(512));
   EXPECT_TRUE(pmm_checker_test_with_fill_size(PAGE_SIZE));
 
   END_TEST;
 }
 
+// Test that a sampling checker only fills and validates some pages, and does so consistently.
+static bool pmm_checker_sample_rate_test() {
+  BEGIN_TEST;
+
+  PmmChecker checker;
+  EXPECT_EQ(1u, checker.GetSampleRate());
+  checker.SetSampleRate(4);
+  EXPECT_EQ(4u, checker.GetSampleRate());
+  checker.Arm();
+
+  constexpr size_t kNumPages = 64;
+  list_node list = LIST_INITIAL_VALUE(list);
+  ASSERT_OK(pmm_alloc_pages(kNumPages, 0, &list));
+  auto free_pages = fit::defer([&list]() { pmm_free(&list); });
+
+  size_t sampled = 0;
+  vm_page_t* page;
+  list_for_every_entry (&list, page, vm_page_t, queue_node) {
+    auto p = static_cast<uint8_t*>(paddr_to_physmap(page->paddr()));
+    memset(p, 0, PAGE_SIZE);
+    checker.FillPattern(page);
+    if (checker.IsSampled(page)) {
+      // Sampled pages are filled and validated as normal.
+      sampled++;
+      EXPECT_NE(0, p[0]);
+      EXPECT_TRUE(checker.ValidatePattern(page));
+      p[PAGE_SIZE - 1] = 0;
+      EXPECT_FALSE(checker.ValidatePattern(page));
+    } else {
+      // Other pages are neither filled nor validated.
+      EXPECT_EQ(0, p[0]);
+      EXPECT_TRUE(checker.ValidatePattern(page));
+    }
+  }
+  // Which pages are sampled is not random, but should still be roughly 1 in 4.
+  EXPECT_GT(sampled, 0u);
+  EXPECT_LT(sampled, kNumPages);
+
+  END_TEST;
+}
+
 static bool pmm_checker_is_valid_fill_size_test() {
   BEGIN_TEST;
 
@@ -643,6 +778,24 @@ static void SetPageStateRange(enum vm_page_state state, vm_page_t* start, int co
   }
 }
 
+// Arenas too large for kMaxInitChunks chunks of the minimum size must still track every chunk.
+static bool pmm_arena_large_init_chunks_test() {
+  BEGIN_TEST;
+
+  // Four times what the minimum chunk size covers. The page array is never touched.
+  static constexpr size_t kNumPages = 4 * PmmArena::kMaxInitChunks << PmmArena::kMinInitChunkShift;
+  const pmm_arena_info_t info{"test arena", 0, 0x1000000, kNumPages * PAGE_SIZE};
+
+  PmmArena arena;
+  arena.InitForTest(info, nullptr);
+  EXPECT_TRUE(arena.page_initialized(0));
+  EXPECT_TRUE(arena.page_initialized(kNumPages / 2));
+  EXPECT_TRUE(arena.page_initialized(kNumPages - 1));
+  EXPECT_FALSE(arena.has_deferred_chunks());
+
+  END_TEST;
+}
+
 static bool pmm_arena_find_free_contiguous_test() {
   BEGIN_TEST;
 
@@ -714,6 +867,51 @@ static bool pmm_arena_find_free_contiguous_test() {
   END_TEST;
 }
 
+// Check that searches for contiguous runs skip over blocks recorded as full in the full block
+// summary, and see blocks again once they have been marked as possibly having free pages.
+static bool pmm_arena_full_block_summary_test() {
+  BEGIN_TEST;
+
+  static constexpr size_t kNumBlocks = 4;
+  static constexpr size_t kNumPages = kNumBlocks * PmmArena::kSummaryBlockPages;
+  const vaddr_t base = 0x1000000;
+  const pmm_arena_info_t info{"test arena", 0, base, kNumPages * PAGE_SIZE};
+
+  fbl::AllocChecker ac;
+  fbl::Array<vm_page_t> page_array = fbl::MakeArray<vm_page_t>(&ac, kNumPages);
+  ASSERT_TRUE(ac.check());
+  memset(page_array.data(), 0, kNumPages * sizeof(vm_page_t));
+  PmmArena arena;
+  arena.InitForTest(info, page_array.data());
+
+  fbl::Array<uint64_t> summary =
+      fbl::MakeArray<uint64_t>(&ac, arena.full_block_summary_words());
+  ASSERT_TRUE(ac.check());
+  memset(summary.data(), 0, summary.size() * sizeof(uint64_t));
+  arena.SetFullBlockSummary(ktl::move(summary));
+
+  // Use every page, leaving nothing to find. The failed search verifies and records every block
+  // as full.
+  SetPageStateRange(vm_page_state::ALLOC, &page_array[0], kNumPages);
+  ASSERT_EQ(nullptr, arena.FindFreeContiguous(PmmArena::kSummaryBlockPages, PAGE_SIZE_SHIFT));
+  ASSERT_EQ(nullptr, arena.FindFreeContiguous(PmmArena::kSummaryBlockPages, PAGE_SIZE_SHIFT));
+
+  // Free the third block. Until the summary is told, searches cannot see it.
+  vm_page_t* const third = &page_array[2 * PmmArena::kSummaryBlockPages];
+  SetPageStateRange(vm_page_state::FREE, third, PmmArena::kSummaryBlockPages);
+  EXPECT_EQ(nullptr, arena.FindFreeContiguous(PmmArena::kSummaryBlockPages, PAGE_SIZE_SHIFT));
+
+  arena.MarkBlockMayHaveFree(2 * PmmArena::kSummaryBlockPages + 1);
+  EXPECT_EQ(third, arena.FindFreeContiguous(PmmArena::kSummaryBlockPages, PAGE_SIZE_SHIFT));
+  SetPageStateRange(vm_page_state::ALLOC, third, PmmArena::kSummaryBlockPages);
+
+  // Smaller searches do not use the summary, so they find a free page in a block recorded as full.
+  third[5].set_state(vm_page_state::FREE);
+  EXPECT_EQ(&third[5], arena.FindFreeContiguous(1, PAGE_SIZE_SHIFT));
+
+  END_TEST;
+}
+
 // Check that when AllocPages appends to an existing list it does not run the checker on the pages
 // already in the list.
 static bool pmm_alloc_append_test() {
@@ -1060,6 +1258,70 @@ static bool pq_rotate_queue() {
   END_TEST;
 }
 
+static bool pq_staging() {
+  BEGIN_TEST;
+
+  PageQueues pq;
+  pq.SetActiveRatioMultiplier(0);
+  pq.StartThreads(0, ZX_TIME_INFINITE);
+  pq.StartStaging();
+
+  // Use more pages than fit in a single staging batch.
+  constexpr size_t kNumPages = 32;
+  vm_page_t pages[kNumPages] = {};
+  for (vm_page_t& page : pages) {
+    page.set_state(vm_page_state::OBJECT);
+  }
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status = make_uncommitted_pager_vmo(kNumPages, false, false, &vmo);
+  ASSERT_OK(status);
+
+  // Staged pages must be reported in their queues and counts exactly as if they were linked.
+  for (size_t i = 0; i < kNumPages; i++) {
+    pq.SetReclaim(&pages[i], vmo->DebugGetCowPages().get(), i * PAGE_SIZE);
+    size_t queue;
+    EXPECT_TRUE(pq.DebugPageIsReclaim(&pages[i], &queue));
+    EXPECT_EQ(queue, 0u);
+  }
+  EXPECT_TRUE(pq.QueueCounts() ==
+              ((PageQueues::Counts){.reclaim = {kNumPages, 0, 0, 0, 0, 0, 0, 0}}));
+
+  // Moving the most recently set page, which is the most likely to still be staged, must flush it
+  // into its list first.
+  pq.MoveToReclaimDontNeed(&pages[kNumPages - 1]);
+  EXPECT_TRUE(pq.DebugPageIsReclaimIsolate(&pages[kNumPages - 1]));
+
+  // Aging must see every page, whether staged or not.
+  pq.RotateReclaimQueues();
+  for (size_t i = 0; i < kNumPages - 1; i++) {
+    size_t queue;
+    EXPECT_TRUE(pq.DebugPageIsReclaim(&pages[i], &queue));
+    EXPECT_EQ(queue, 1u);
+  }
+  EXPECT_TRUE(pq.QueueCounts() == ((PageQueues::Counts){
+                                      .reclaim = {0, kNumPages - 1, 0, 0, 0, 0, 0, 0},
+                                      .reclaim_isolate = 1,
+                                  }));
+
+  // Re-stage some pages and then remove everything, some of which is staged.
+  pq.Remove(&pages[0]);
+  pq.Remove(&pages[1]);
+  pq.SetReclaim(&pages[0], vmo->DebugGetCowPages().get(), 0);
+  pq.SetReclaim(&pages[1], vmo->DebugGetCowPages().get(), PAGE_SIZE);
+  pq.Remove(&pages[0]);
+  vm_page_t* remove[kNumPages - 1];
+  for (size_t i = 1; i < kNumPages; i++) {
+    remove[i - 1] = &pages[i];
+  }
+  list_node_t removed = LIST_INITIAL_VALUE(removed);
+  pq.RemoveArrayIntoList(remove, kNumPages - 1, &removed);
+  EXPECT_EQ(list_length(&removed), kNumPages - 1);
+  EXPECT_TRUE(pq.QueueCounts() == ((PageQueues::Counts){}));
+
+  END_TEST;
+}
+
 static bool pq_toggle_dont_need_queue() {
   BEGIN_TEST;
 
@@ -1159,6 +1421,33 @@ static bool kasan_detects_use_after_free() {
 }
 #endif  // __has_feature(address_sanitizer)
 
+static bool pmm_alloc_large_page_test() {
+  BEGIN_TEST;
+
+  list_node_t list = LIST_INITIAL_VALUE(list);
+  paddr_t pa;
+  zx_status_t status = Pmm::Node().AllocLargePage(&pa, &list);
+  // Large pages are opportunistic and a fragmented or low memory system may legitimately not have
+  // any available.
+  if (status == ZX_ERR_NOT_FOUND) {
+    EXPECT_TRUE(list_is_empty(&list));
+    END_TEST;
+  }
+  ASSERT_OK(status);
+  auto cleanup = fit::defer([&list]() { pmm_free(&list); });
+
+  EXPECT_EQ(0u, pa % PmmNode::kLargePageSize);
+  EXPECT_EQ(PmmNode::kLargePageCount, list_length(&list));
+  paddr_t expected = pa;
+  vm_page_t* page;
+  list_for_every_entry (&list, page, vm_page_t, queue_node) {
+    EXPECT_EQ(expected, page->paddr());
+    expected += PAGE_SIZE;
+  }
+
+  END_TEST;
+}
+
 static bool pmm_page_to_from_index_test() {
   // Assert that indexes have zero bits, can roundtrip and are distinct for distinct pages.
   BEGIN_TEST;
@@ -1188,22 +1477,49 @@ static bool pmm_page_to_from_index_test() {
   END_TEST;
 }
 
+// Any page handed out by the zeroed page pool must be allocated and zero filled.
+static bool zeroed_page_pool_take_test() {
+  BEGIN_TEST;
+
+  vm_page_t* page = zeroed_page_pool_take();
+  if (!page) {
+    printf("skipping test, zeroed page pool is disabled or empty\n");
+    END_TEST;
+  }
+  auto free_page = fit::defer([page]() { pmm_free_page(page); });
+
+  EXPECT_EQ(vm_page_state::ALLOC, page->state());
+  const uint64_t* data = static_cast<const uint64_t*>(paddr_to_physmap(page->paddr()));
+  for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+    ASSERT_EQ(0u, data[i]);
+  }
+
+  END_TEST;
+}
+
 UNITTEST_START_TESTCASE(pmm_tests)
 VM_UNITTEST(pmm_smoke_test)
+VM_UNITTEST(zeroed_page_pool_take_test)
 VM_UNITTEST(pmm_alloc_contiguous_one_test)
 VM_UNITTEST(pmm_node_multi_alloc_test)
 VM_UNITTEST(pmm_node_singleton_list_test)
 VM_UNITTEST(pmm_node_loan_borrow_cancel_reclaim_end)
 VM_UNITTEST(pmm_node_oversized_alloc_test)
+VM_UNITTEST(pmm_node_magazine_test)
+VM_UNITTEST(pmm_node_numa_test)
 VM_UNITTEST(pmm_node_free_mem_event_test)
 VM_UNITTEST(pmm_node_low_mem_alloc_failure_test)
 VM_UNITTEST(pmm_node_explicit_should_wait_test)
 VM_UNITTEST(pmm_checker_test)
+VM_UNITTEST(pmm_checker_sample_rate_test)
 VM_UNITTEST(pmm_checker_is_valid_fill_size_test)
 VM_UNITTEST(pmm_get_arena_info_test)
+VM_UNITTEST(pmm_arena_large_init_chunks_test)
 VM_UNITTEST(pmm_arena_find_free_contiguous_test)
+VM_UNITTEST(pmm_arena_full_block_summary_test)
 VM_UNITTEST(pmm_alloc_append_test)
 VM_UNITTEST(pmm_page_to_from_index_test)
+VM_UNITTEST(pmm_alloc_large_page_test)
 UNITTEST_END_TESTCASE(pmm_tests, "pmm", "Physical memory manager tests")
 
 UNITTEST_START_TESTCASE(page_queues_tests)
@@ -1212,6 +1528,7 @@ VM_UNITTEST(pq_move_queues)
 VM_UNITTEST(pq_move_self_queue)
 VM_UNITTEST(pq_rotate_queue)
 VM_UNITTEST(pq_toggle_dont_need_queue)
+VM_UNITTEST(pq_staging)
 UNITTEST_END_TESTCASE(page_queues_tests, "pq", "PageQueues tests")
 
 #if __has_feature(address_sanitizer)
@@ -2243,6 +2243,42 @@ static bool vmo_attribution_ops_contiguous_test() {
   END_TEST;
 }
 
+// Tests that the readahead window of a page source adapts to the access pattern.
+static bool vmo_pager_readahead_test() {
+  BEGIN_TEST;
+
+  fbl::AllocChecker ac;
+  fbl::RefPtr<StubPageProvider> pager = fbl::MakeRefCountedChecked<StubPageProvider>(&ac);
+  ASSERT_TRUE(ac.check());
+  fbl::RefPtr<PageSource> src = fbl::MakeRefCountedChecked<PageSource>(&ac, ktl::move(pager));
+  ASSERT_TRUE(ac.check());
+  auto close = fit::defer([&src]() { src->Close(); });
+
+  constexpr uint64_t kMinWindow = PageSource::kReadaheadMinPages * PAGE_SIZE;
+  constexpr uint64_t kMaxWindow = PageSource::kReadaheadMaxPages * PAGE_SIZE;
+
+  // The first request at the start of the VMO counts as sequential.
+  EXPECT_EQ(kMinWindow, src->ReadaheadLength(0, PAGE_SIZE));
+  // Retrying within the previous request does not change the window.
+  EXPECT_EQ(kMinWindow - PAGE_SIZE, src->ReadaheadLength(PAGE_SIZE, PAGE_SIZE));
+
+  // Each sequential request doubles the window, until it reaches the maximum.
+  uint64_t offset = kMinWindow;
+  for (uint64_t window = kMinWindow * 2; window <= kMaxWindow; window *= 2) {
+    EXPECT_EQ(window, src->ReadaheadLength(offset, PAGE_SIZE));
+    offset += window;
+  }
+  EXPECT_EQ(kMaxWindow, src->ReadaheadLength(offset, PAGE_SIZE));
+  offset += kMaxWindow;
+
+  // Random access halves the window.
+  EXPECT_EQ(kMaxWindow / 2, src->ReadaheadLength(offset + kMaxWindow, PAGE_SIZE));
+  // Requests larger than the window are never shortened.
+  EXPECT_EQ(kMaxWindow * 4, src->ReadaheadLength(0, kMaxWindow * 4));
+
+  END_TEST;
+}
+
 // Tests that memory attribution behaves as expected for operations specific to pager-backed
 // vmo's - supplying pages, creating COW clones.
 static bool vmo_attribution_pager_test() {
@@ -2449,6 +2485,62 @@ static bool vmo_attribution_compression_test() {
   END_TEST;
 }
 
+// Tests that repeated attribution queries stay correct when they are answered from the cached
+// result of an earlier query, both while the VMO is idle and after its pages change.
+static bool vmo_attribution_cache_test() {
+  BEGIN_TEST;
+  AutoVmScannerDisable scanner_disable;
+  using AttributionCounts = VmObject::AttributionCounts;
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  zx_status_t status =
+      VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, VmObjectPaged::kResizable, 4 * PAGE_SIZE, &vmo);
+  ASSERT_EQ(ZX_OK, status);
+  // Fake user id to keep the cloning code happy.
+  vmo->set_user_id(0xff);
+
+  status = vmo->CommitRange(0, 2 * PAGE_SIZE);
+  ASSERT_EQ(ZX_OK, status);
+  const AttributionCounts two_pages = make_private_attribution_counts(2ul * PAGE_SIZE, 0);
+  EXPECT_TRUE(vmo->GetAttributedMemory() == two_pages);
+  EXPECT_TRUE(vmo->GetAttributedMemory() == two_pages);
+
+  // A query over a different range must not be answered with the previous result.
+  EXPECT_TRUE(vmo->GetAttributedMemoryInRange(PAGE_SIZE, PAGE_SIZE) ==
+              make_private_attribution_counts(PAGE_SIZE, 0));
+  EXPECT_TRUE(vmo->GetAttributedMemory() == two_pages);
+
+  // Changing the page list through any path must invalidate the cached result.
+  status = vmo->CommitRange(2 * PAGE_SIZE, PAGE_SIZE);
+  ASSERT_EQ(ZX_OK, status);
+  EXPECT_TRUE(vmo->GetAttributedMemory() == make_private_attribution_counts(3ul * PAGE_SIZE, 0));
+  status = vmo->DecommitRange(0, PAGE_SIZE);
+  ASSERT_EQ(ZX_OK, status);
+  EXPECT_TRUE(vmo->GetAttributedMemory() == two_pages);
+  status = vmo->Resize(2 * PAGE_SIZE);
+  ASSERT_EQ(ZX_OK, status);
+  EXPECT_TRUE(vmo->GetAttributedMemory() == make_private_attribution_counts(PAGE_SIZE, 0));
+
+  // Once a clone shares the pages the result depends on more than this page list, and the shared
+  // page must be reported as such.
+  fbl::RefPtr<VmObject> clone;
+  status = vmo->CreateClone(Resizability::NonResizable, SnapshotType::Full, 0, 2 * PAGE_SIZE, true,
+                            &clone);
+  ASSERT_EQ(ZX_OK, status);
+  clone->set_user_id(0xfc);
+  const AttributionCounts shared_page{.uncompressed_bytes = PAGE_SIZE,
+                                      .scaled_uncompressed_bytes =
+                                          vm::FractionalBytes(PAGE_SIZE, 2)};
+  EXPECT_TRUE(vmo->GetAttributedMemory() == shared_page);
+  EXPECT_TRUE(vmo->GetAttributedMemory() == shared_page);
+
+  // Dropping the clone makes the page private again.
+  clone.reset();
+  EXPECT_TRUE(vmo->GetAttributedMemory() == make_private_attribution_counts(PAGE_SIZE, 0));
+
+  END_TEST;
+}
+
 // Test that a VmObjectPaged that is only referenced by its children gets removed by effectively
 // merging into its parent and re-homing all the children. This should also drop any VmCowPages
 // being held open.
@@ -2975,6 +3067,46 @@ static bool vmo_discardable_counts_test() {
   END_TEST;
 }
 
+// Test the idle checks used when discarding whole VMOs in batches.
+static bool vmo_discard_if_idle_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  fbl::RefPtr<VmObjectPaged> vmo;
+  constexpr uint64_t kSize = 4 * PAGE_SIZE;
+  zx_status_t status =
+      VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, VmObjectPaged::kDiscardable, kSize, &vmo);
+  ASSERT_EQ(ZX_OK, status);
+  VmCowPages* cow = vmo->DebugGetCowPages().get();
+
+  // Nothing can be discarded while locked.
+  EXPECT_EQ(ZX_OK, vmo->TryLockRange(0, kSize));
+  EXPECT_EQ(ZX_OK, vmo->CommitRange(0, kSize));
+  EXPECT_EQ(0u, cow->IdleDiscardablePages(ZX_TIME_INFINITE));
+  EXPECT_TRUE(cow->DiscardIfIdle(ZX_TIME_INFINITE).is_error());
+
+  // Once unlocked, the VMO only counts as idle for cutoffs after the unlock.
+  const zx_instant_mono_t before_unlock = current_mono_time();
+  EXPECT_EQ(ZX_OK, vmo->UnlockRange(0, kSize));
+  EXPECT_EQ(0u, cow->IdleDiscardablePages(before_unlock));
+  EXPECT_TRUE(cow->DiscardIfIdle(before_unlock).is_error());
+  EXPECT_TRUE(make_private_attribution_counts(kSize, 0) == vmo->GetAttributedMemory());
+
+  EXPECT_EQ(kSize / PAGE_SIZE, cow->IdleDiscardablePages(ZX_TIME_INFINITE));
+  auto result = cow->DiscardIfIdle(ZX_TIME_INFINITE);
+  ASSERT_TRUE(result.is_ok());
+  EXPECT_EQ(kSize / PAGE_SIZE, *result);
+  EXPECT_TRUE((vm::AttributionCounts{}) == vmo->GetAttributedMemory());
+  EXPECT_TRUE(cow->DebugGetDiscardableTracker()->DebugIsDiscarded());
+
+  // A discarded VMO is not discarded again.
+  EXPECT_EQ(0u, cow->IdleDiscardablePages(ZX_TIME_INFINITE));
+  EXPECT_TRUE(cow->DiscardIfIdle(ZX_TIME_INFINITE).is_error());
+
+  END_TEST;
+}
+
 // using LookupCursor with different kinds of faults reads / writes should correctly
 // decompress or return an error.
 static bool vmo_lookup_compressed_pages_test() {
@@ -3481,6 +3613,108 @@ static bool vmo_supply_compressed_pages_test() {
   END_TEST;
 }
 
+// Tests that transferring data moves compressed pages without decompressing them, and that gaps in
+// the source become zero in the destination, even when the destination has a pager backed parent.
+static bool vmo_transfer_compressed_pages_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+  // Need a working compressor.
+  auto compression = Pmm::Node().GetPageCompression();
+  if (!compression) {
+    END_TEST;
+  }
+
+  vm_page_t* pager_pages[2];
+  fbl::RefPtr<VmObjectPaged> pager_vmo;
+  ASSERT_OK(make_committed_pager_vmo(2, /*trap_dirty=*/false, /*resizable=*/false, pager_pages,
+                                     &pager_vmo));
+  fbl::RefPtr<VmObject> clone;
+  ASSERT_OK(pager_vmo->CreateClone(Resizability::NonResizable, SnapshotType::OnWrite, 0,
+                                   2 * PAGE_SIZE, true, &clone));
+
+  // Only the first page of the source is populated, and it is compressed.
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0, 2 * PAGE_SIZE, &vmo));
+  uint64_t data = 42;
+  EXPECT_OK(vmo->Write(&data, 0, sizeof(data)));
+  vm_page_t* page;
+  ASSERT_OK(vmo->GetPageBlocking(0, 0, nullptr, &page, nullptr));
+  {
+    auto compressor = compression->AcquireCompressor();
+    EXPECT_OK(compressor.get().Arm());
+    EXPECT_EQ(reclaim_page(vmo, page, 0, VmCowPages::EvictionAction::FollowHint, &compressor.get()),
+              1u);
+  }
+  EXPECT_TRUE(make_private_attribution_counts(0, PAGE_SIZE) == vmo->GetAttributedMemory());
+
+  VmPageSpliceList pl;
+  EXPECT_OK(vmo->TakePages(0, 2 * PAGE_SIZE, &pl));
+  EXPECT_OK(clone->SupplyPages(0, 2 * PAGE_SIZE, &pl, SupplyOptions::TransferData));
+
+  // The clone should now own the compressed page, and read zero for the gap.
+  EXPECT_EQ(static_cast<size_t>(PAGE_SIZE), clone->GetAttributedMemory().compressed_bytes);
+  uint64_t result[2] = {1, 1};
+  EXPECT_OK(clone->Read(&result[0], 0, sizeof(uint64_t)));
+  EXPECT_OK(clone->Read(&result[1], PAGE_SIZE, sizeof(uint64_t)));
+  EXPECT_EQ(42u, result[0]);
+  EXPECT_EQ(0u, result[1]);
+
+  END_TEST;
+}
+
+// Tests that SupplyPagesMany supplies discontiguous ranges from several source VMOs.
+static bool vmo_supply_pages_many_test() {
+  BEGIN_TEST;
+
+  AutoVmScannerDisable scanner_disable;
+
+  constexpr uint64_t kNumPages = 4;
+  fbl::RefPtr<VmObjectPaged> vmo;
+  ASSERT_OK(make_uncommitted_pager_vmo(kNumPages, false, false, &vmo));
+
+  // Supply pages 0 and 2 to 3 from two different aux VMOs.
+  fbl::RefPtr<VmObjectPaged> aux_vmos[2];
+  VmPageSpliceList page_lists[2];
+  const uint64_t aux_pages[2] = {1, 2};
+  for (size_t i = 0; i < 2; i++) {
+    ASSERT_OK(VmObjectPaged::Create(PMM_ALLOC_FLAG_ANY, 0, aux_pages[i] * PAGE_SIZE, &aux_vmos[i]));
+    for (uint64_t page = 0; page < aux_pages[i]; page++) {
+      const uint64_t data = i * 10 + page + 1;
+      EXPECT_OK(aux_vmos[i]->Write(&data, page * PAGE_SIZE, sizeof(data)));
+    }
+    ASSERT_OK(aux_vmos[i]->TakePages(0, aux_pages[i] * PAGE_SIZE, &page_lists[i]));
+  }
+  const SupplyRange ranges[] = {
+      {.offset = 0, .len = PAGE_SIZE, .pages = &page_lists[0]},
+      {.offset = 2 * PAGE_SIZE, .len = 2 * PAGE_SIZE, .pages = &page_lists[1]},
+  };
+
+  // A range out of bounds fails the whole batch without supplying anything.
+  const SupplyRange bad_ranges[] = {
+      ranges[0],
+      {.offset = kNumPages * PAGE_SIZE, .len = PAGE_SIZE, .pages = &page_lists[1]},
+  };
+  EXPECT_EQ(ZX_ERR_OUT_OF_RANGE, vmo->SupplyPagesMany(bad_ranges, SupplyOptions::PagerSupply));
+  EXPECT_TRUE(vmo->GetAttributedMemory() == AttributionCounts{});
+
+  ASSERT_OK(vmo->SupplyPagesMany(ranges, SupplyOptions::PagerSupply));
+  EXPECT_TRUE(vmo->GetAttributedMemory() ==
+              make_private_attribution_counts(3ul * PAGE_SIZE, 0));
+
+  const uint64_t expected[kNumPages] = {1, 0, 11, 12};
+  for (uint64_t page = 0; page < kNumPages; page++) {
+    if (expected[page] == 0) {
+      continue;
+    }
+    uint64_t data = 0;
+    EXPECT_OK(vmo->Read(&data, page * PAGE_SIZE, sizeof(data)));
+    EXPECT_EQ(expected[page], data);
+  }
+
+  END_TEST;
+}
+
 static bool is_page_zero(vm_page_t* page) {
   auto* base = reinterpret_cast<uint64_t*>(paddr_to_physmap(page->paddr()));
   for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
@@ -4234,15 +4468,18 @@ VM_UNITTEST(vmo_attribution_clones_test)
 VM_UNITTEST(vmo_attribution_ops_test)
 VM_UNITTEST(vmo_attribution_ops_contiguous_test)
 VM_UNITTEST(vmo_attribution_pager_test)
+VM_UNITTEST(vmo_pager_readahead_test)
 VM_UNITTEST(vmo_attribution_evict_test)
 VM_UNITTEST(vmo_attribution_dedup_test)
 VM_UNITTEST(vmo_attribution_compression_test)
+VM_UNITTEST(vmo_attribution_cache_test)
 VM_UNITTEST(vmo_parent_merge_test)
 VM_UNITTEST(vmo_lock_count_test)
 VM_UNITTEST(vmo_discardable_states_test)
 VM_UNITTEST(vmo_discard_test)
 VM_UNITTEST(vmo_discard_failure_test)
 VM_UNITTEST(vmo_discardable_counts_test)
+VM_UNITTEST(vmo_discard_if_idle_test)
 VM_UNITTEST(vmo_lookup_compressed_pages_test)
 VM_UNITTEST(vmo_write_does_not_commit_test)
 VM_UNITTEST(vmo_dirty_pages_test)
@@ -4252,6 +4489,8 @@ VM_UNITTEST(vmo_pinning_backlink_test)
 VM_UNITTEST(vmo_pinning_dirty_state_test)
 VM_UNITTEST(vmo_high_priority_dirty_state_test)
 VM_UNITTEST(vmo_supply_compressed_pages_test)
+VM_UNITTEST(vmo_transfer_compressed_pages_test)
+VM_UNITTEST(vmo_supply_pages_many_test)
 VM_UNITTEST(vmo_zero_pinned_test)
 VM_UNITTEST(vmo_pinned_wrapper_test)
 VM_UNITTEST(vmo_dedup_dirty_test)
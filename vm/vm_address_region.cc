@@ -16,6 +16,7 @@
 #include <zircon/errors.h>
 #include <zircon/types.h>
 
+#include <fbl/algorithm.h>
 #include <fbl/alloc_checker.h>
 #include <kernel/mp.h>
 #include <ktl/algorithm.h>
@@ -45,6 +46,71 @@ KCOUNTER(vm_region_map_upper_bound_attempt, "vm.region.map.upper_bound.attempt")
 // Number of successful mapping at a specified address.
 KCOUNTER(vm_region_map_upper_bound_success, "vm.region.map.upper_bound.success")
 
+namespace {
+
+// Builds the bitmap of a HarvestDirty range op, one bit per page of the range starting at |base|.
+// The page tables report dirty ranges with their lock held, so the bitmap is gathered a chunk at a
+// time in a local buffer and copied out to the user buffer between harvests.
+class DirtyBitmapWriter {
+ public:
+  DirtyBitmapWriter(vaddr_t base, size_t len, user_inout_ptr<uint64_t> out)
+      : base_(base), total_words_(fbl::round_up(len / PAGE_SIZE, 64u) / 64), out_(out) {}
+
+  // Harvests the dirty pages of [vaddr, vaddr + len) from |aspace| and copies the updated part of
+  // the bitmap out. Ranges must be harvested in increasing address order.
+  zx_status_t Harvest(ArchVmAspace& aspace, vaddr_t vaddr, size_t len) {
+    const vaddr_t end = vaddr + len;
+    while (vaddr < end) {
+      const size_t chunk = (vaddr - base_) / PAGE_SIZE / kChunkPages;
+      if (chunk != chunk_) {
+        if (zx_status_t status = Flush(); status != ZX_OK) {
+          return status;
+        }
+        for (uint64_t& word : words_) {
+          word = 0;
+        }
+        chunk_ = chunk;
+      }
+      const vaddr_t chunk_end = base_ + (chunk + 1) * kChunkPages * PAGE_SIZE;
+      const size_t count = (ktl::min(end, chunk_end) - vaddr) / PAGE_SIZE;
+      if (zx_status_t status = aspace.HarvestDirty(
+              vaddr, count, [this](vaddr_t dirty, size_t dirty_len) { Set(dirty, dirty_len); });
+          status != ZX_OK) {
+        return status;
+      }
+      vaddr += count * PAGE_SIZE;
+    }
+    return Flush();
+  }
+
+ private:
+  static constexpr size_t kChunkWords = 16;
+  static constexpr size_t kChunkPages = kChunkWords * 64;
+
+  void Set(vaddr_t vaddr, size_t len) {
+    const size_t first = (vaddr - base_) / PAGE_SIZE - chunk_ * kChunkPages;
+    const size_t last = first + len / PAGE_SIZE;
+    DEBUG_ASSERT(last <= kChunkPages);
+    for (size_t i = first; i < last; i++) {
+      words_[i / 64] |= uint64_t{1} << (i % 64);
+    }
+  }
+
+  zx_status_t Flush() {
+    const size_t first_word = chunk_ * kChunkWords;
+    return out_.copy_array_to_user(words_, ktl::min(kChunkWords, total_words_ - first_word),
+                                   first_word);
+  }
+
+  const vaddr_t base_;
+  const size_t total_words_;
+  const user_inout_ptr<uint64_t> out_;
+  size_t chunk_ = 0;
+  uint64_t words_[kChunkWords] = {};
+};
+
+}  // namespace
+
 VmAddressRegion::VmAddressRegion(VmAspace& aspace, vaddr_t base, size_t size, uint32_t vmar_flags)
     : VmAddressRegionOrMapping(base, size, vmar_flags | VMAR_CAN_RWX_FLAGS, &aspace, nullptr,
                                false) {
@@ -551,6 +617,7 @@ zx_status_t VmAddressRegion::EnumerateChildren(VmEnumerator* ve) {
   VmAddressRegionEnumerator<VmAddressRegionEnumeratorType::VmarsAndMappings> enumerator(*this, 0,
                                                                                         UINT64_MAX);
   AssertHeld(enumerator.lock_ref());
+  size_t yielded = 0;
   while (auto result = enumerator.next()) {
     enumerator.pause();
     if (VmMapping* mapping = result->region_or_mapping->as_vm_mapping_ptr(); mapping) {
@@ -569,6 +636,11 @@ zx_status_t VmAddressRegion::EnumerateChildren(VmEnumerator* ve) {
       }
       return status;
     }
+    // Periodically let any waiters, such as page faults in this aspace, take the lock. The
+    // enumerator is paused, so it will resume correctly however the tree changes meanwhile.
+    if (++yielded % kEnumerateChunkSize == 0) {
+      guard.CallUnlocked([] {});
+    }
     enumerator.resume();
   }
   return ZX_OK;
@@ -628,7 +700,21 @@ zx_status_t VmAddressRegion::RangeOp(RangeOpType op, vaddr_t base, size_t len,
                                      VmAddressRegionOpChildren op_children,
                                      user_inout_ptr<void> buffer, size_t buffer_size) {
   canary_.Assert();
-  if (buffer || buffer_size) {
+  // Setting the fault-around limit takes its value from the buffer, and harvesting dirty pages
+  // fills it with a bitmap. All other ops take no buffer.
+  uint32_t fault_around_pages = 0;
+  if (op == RangeOpType::SetFaultAround) {
+    if (buffer_size != sizeof(fault_around_pages)) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+    if (zx_status_t s = buffer.reinterpret<uint32_t>().copy_from_user(&fault_around_pages);
+        s != ZX_OK) {
+      return s;
+    }
+    if (fault_around_pages == 0 || fault_around_pages > VmMapping::kPageFaultMaxFaultAroundPages) {
+      return ZX_ERR_OUT_OF_RANGE;
+    }
+  } else if (op != RangeOpType::HarvestDirty && (buffer || buffer_size)) {
     return ZX_ERR_INVALID_ARGS;
   }
   len = ROUNDUP_PAGE_SIZE(len);
@@ -640,6 +726,12 @@ zx_status_t VmAddressRegion::RangeOp(RangeOpType op, vaddr_t base, size_t len,
     return ZX_ERR_OUT_OF_RANGE;
   }
 
+  if (op == RangeOpType::HarvestDirty &&
+      buffer_size < fbl::round_up(len / PAGE_SIZE, 64u) / 64 * sizeof(uint64_t)) {
+    return ZX_ERR_BUFFER_TOO_SMALL;
+  }
+  DirtyBitmapWriter dirty_bitmap(base, len, buffer.reinterpret<uint64_t>());
+
   const vaddr_t last_addr = base + len;
 
   Guard<CriticalMutex> guard{lock()};
@@ -705,6 +797,15 @@ zx_status_t VmAddressRegion::RangeOp(RangeOpType op, vaddr_t base, size_t len,
       return ZX_ERR_INVALID_ARGS;
     }
 
+    // The fault-around limit is a property of the whole mapping and just needs the lock that is
+    // already held.
+    if (op == RangeOpType::SetFaultAround) {
+      mapping->SetFaultAroundLocked(fault_around_pages);
+      enumerator.resume();
+      expected += size;
+      continue;
+    }
+
     // For fault-beyond-stream-size mappings, ensure there are no gaps due to the stream size being
     // less than the end of the mapping. User synchronisation is required for the observable result
     // to be defined, as the stream size is a user managed property & not guaranteed atomic to the
@@ -723,7 +824,8 @@ zx_status_t VmAddressRegion::RangeOp(RangeOpType op, vaddr_t base, size_t len,
       }
     }
 
-    guard.CallUnlocked([&result, &vmo, &mapping, op, mapping_offset, vmo_offset, size] {
+    guard.CallUnlocked([&result, &vmo, &mapping, &dirty_bitmap, op, expected, mapping_offset,
+                        vmo_offset, size] {
       switch (op) {
         case RangeOpType::Commit:
           if (!mapping->is_valid_mapping_flags(ARCH_MMU_FLAG_PERM_WRITE)) {
@@ -777,6 +879,11 @@ zx_status_t VmAddressRegion::RangeOp(RangeOpType op, vaddr_t base, size_t len,
             }
           }
           break;
+        case RangeOpType::HarvestDirty:
+          // Reading and resetting the dirty record does not change the contents of the VMO, so
+          // like a query it needs no permissions on the mapping.
+          result = dirty_bitmap.Harvest(mapping->aspace()->arch_aspace(), expected, size);
+          break;
         default:
           result = ZX_ERR_NOT_SUPPORTED;
           break;
@@ -1211,8 +1318,8 @@ zx_status_t VmAddressRegion::ReserveSpace(const char* name, vaddr_t base, size_t
     // CPUs. In this case it is safe to allow the Protect operations to temporarily enlarge.
     const cpu_mask_t online = mp_get_online_mask();
     const cpu_num_t curr = arch_curr_cpu_num();
-    DEBUG_ASSERT_MSG((online & ~cpu_num_to_mask(curr)) == 0,
-                     "Online mask %u has more than current cpu %u", online, curr);
+    DEBUG_ASSERT_MSG((online & ~cpu_num_to_mask(curr)).none(),
+                     "Online mask %#" PRIx64 " has more than current cpu %u", online.word(0), curr);
     return aspace_->arch_aspace().Protect(base, size / PAGE_SIZE, arch_mmu_flags,
                                           ArchUnmapOptions::Enlarge);
   }
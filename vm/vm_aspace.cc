@@ -56,8 +56,10 @@ namespace {
 KCOUNTER(vm_aspace_high_priority, "vm.aspace.high_priority")
 KCOUNTER(vm_aspace_accessed_harvests_performed, "vm.aspace.accessed_harvest.performed")
 KCOUNTER(vm_aspace_accessed_harvests_skipped, "vm.aspace.accessed_harvest.skipped")
+KCOUNTER(vm_aspace_pt_reclaim_slices, "vm.aspace.accessed_harvest.pt_reclaim_slices")
 KCOUNTER(vm_aspace_last_fault_hit, "vm.aspace.last_fault.hit")
 KCOUNTER(vm_aspace_last_fault_miss, "vm.aspace.last_fault.miss")
+KCOUNTER(vm_aspace_spurious_fault, "vm.aspace.fault.spurious")
 
 // the singleton kernel address space
 lazy_init::LazyInit<VmAspace, lazy_init::CheckType::None, lazy_init::Destructor::Disabled>
@@ -586,6 +588,32 @@ zx_status_t VmAspace::PageFault(vaddr_t va, uint flags) {
   // for passing to PageFaultLocked.
   va = ROUNDDOWN_PAGE_SIZE(va);
 
+  // When several threads fault on the same page at once, all but the first find it already mapped
+  // once they get the aspace lock. Check the hardware translation first, which only needs the arch
+  // aspace's own lock, and if it already grants the access the fault was spurious and can simply
+  // be retried without serializing on the aspace lock. Faults on guest physical aspaces and
+  // software faults always take the full path, as do all faults where a harvested accessed flag
+  // can fault without being reported as an access fault, since Query does not report it and only
+  // the full path sets it again.
+  if (!ArchVmAspace::HasUnreportedAccessFaults() && type_ != Type::GuestPhysical &&
+      !(flags & VMM_PF_FLAG_SW_FAULT)) {
+    uint needed_mmu_flags = (flags & VMM_PF_FLAG_WRITE) ? ARCH_MMU_FLAG_PERM_WRITE
+                                                        : ARCH_MMU_FLAG_PERM_READ;
+    if (flags & VMM_PF_FLAG_USER) {
+      needed_mmu_flags |= ARCH_MMU_FLAG_PERM_USER;
+    }
+    if (flags & VMM_PF_FLAG_INSTRUCTION) {
+      needed_mmu_flags |= ARCH_MMU_FLAG_PERM_EXECUTE;
+    }
+    paddr_t pa;
+    uint mmu_flags;
+    if (arch_aspace_.Query(va, &pa, &mmu_flags) == ZX_OK &&
+        (mmu_flags & needed_mmu_flags) == needed_mmu_flags) {
+      vm_aspace_spurious_fault.Add(1);
+      return ZX_OK;
+    }
+  }
+
   return PageFaultInternal(va, flags, 0);
 }
 
@@ -606,31 +634,36 @@ zx_status_t VmAspace::PageFaultInternal(vaddr_t va, uint flags, size_t additiona
     {
       Guard<CriticalMutex> guard{&lock_};
       DEBUG_ASSERT(!aspace_destroyed_);
-      // First check if we're faulting on the same mapping as last time to short-circuit the vmar
-      // walk.
-      bool found = false;
-      if (likely(last_fault_)) {
-        AssertHeld(last_fault_->lock_ref());
-        if (last_fault_->is_in_range_locked(va, 1)) {
-          vm_aspace_last_fault_hit.Add(1);
-          found = true;
+      // First check if we're faulting on one of the recently faulted mappings to short-circuit the
+      // vmar walk.
+      VmMapping* mapping = nullptr;
+      for (VmMapping* entry : fault_cache_) {
+        if (entry) {
+          AssertHeld(entry->lock_ref());
+          if (entry->is_in_range_locked(va, 1)) {
+            mapping = entry;
+            break;
+          }
         }
       }
-      if (!found) {
+      if (likely(mapping)) {
+        vm_aspace_last_fault_hit.Add(1);
+      } else {
         vm_aspace_last_fault_miss.Add(1);
         AssertHeld(root_vmar_->lock_ref());
-        // Stash the mapping we found as the most recent fault. As we just found this mapping in the
-        // VMAR tree we know it's in the ALIVE state (or is a nullptr), satisfying that requirement
-        // that allows us to record this as a raw pointer.
-        last_fault_ = root_vmar_->FindMappingLocked(va);
-        if (unlikely(!last_fault_)) {
+        mapping = root_vmar_->FindMappingLocked(va);
+        if (unlikely(!mapping)) {
           return ZX_ERR_NOT_FOUND;
         }
+        // Stash the mapping we found in the fault cache. As we just found this mapping in the VMAR
+        // tree we know it's in the ALIVE state, satisfying that requirement that allows us to
+        // record this as a raw pointer.
+        fault_cache_[fault_cache_next_] = mapping;
+        fault_cache_next_ = (fault_cache_next_ + 1) % kFaultCacheSize;
       }
-      DEBUG_ASSERT(last_fault_);
-      AssertHeld(last_fault_->lock_ref());
+      AssertHeld(mapping->lock_ref());
       auto [fault_status, count] =
-          last_fault_->PageFaultLocked(va, flags, additional_pages, &page_request);
+          mapping->PageFaultLocked(va, flags, additional_pages, &page_request);
       status = fault_status;
       mapped = count;
     }
@@ -838,10 +871,10 @@ void VmAspace::HarvestAllUserAccessedBits(NonTerminalAction non_terminal_action,
           a.pt_harvest_since_active_ = 0;
         }
       } else if (apply_non_terminal_action == NonTerminalAction::FreeUnaccessed &&
-                 a.pt_harvest_since_active_ < 2) {
+                 a.pt_harvest_since_active_ < 2 * kPageTableReclaimSlices) {
         // The aspace hasn't been active, but we haven't yet performed two successive pt
-        // reclamations. Since the first pt reclamation only removes accessed information, the
-        // second is needed to actually do the reclamation.
+        // reclamations of every slice. Since the first pt reclamation only removes accessed
+        // information, the second is needed to actually do the reclamation.
         a.pt_harvest_since_active_++;
       } else {
         // Either this is not a request to harvest pt information, or enough pt harvesting has been
@@ -849,7 +882,33 @@ void VmAspace::HarvestAllUserAccessedBits(NonTerminalAction non_terminal_action,
         // information.
         harvest = false;
       }
-      if (harvest) {
+      if (harvest && apply_non_terminal_action == NonTerminalAction::FreeUnaccessed) {
+        // Only free from the current slice. Accessed information elsewhere is retained, as it is
+        // what tells the reclamation of the other slices which page tables are still in use.
+        const size_t slice_size = ROUNDUP_PAGE_SIZE(a.size() / kPageTableReclaimSlices);
+        const size_t start = ktl::min(a.pt_reclaim_slice_ * slice_size, a.size());
+        const size_t end = ktl::min(start + slice_size, a.size());
+        const struct {
+          size_t offset;
+          size_t len;
+          NonTerminalAction action;
+        } ranges[] = {
+            {0, start, NonTerminalAction::Retain},
+            {start, end - start, NonTerminalAction::FreeUnaccessed},
+            {end, a.size() - end, NonTerminalAction::Retain},
+        };
+        for (const auto& range : ranges) {
+          if (range.len > 0) {
+            [[maybe_unused]] zx_status_t result = a.arch_aspace().HarvestAccessed(
+                a.base() + range.offset, range.len / PAGE_SIZE, range.action,
+                apply_terminal_action);
+            DEBUG_ASSERT(result == ZX_OK);
+          }
+        }
+        a.pt_reclaim_slice_ = (a.pt_reclaim_slice_ + 1) % kPageTableReclaimSlices;
+        vm_aspace_accessed_harvests_performed.Add(1);
+        vm_aspace_pt_reclaim_slices.Add(1);
+      } else if (harvest) {
         [[maybe_unused]] zx_status_t result = a.arch_aspace().HarvestAccessed(
             a.base(), a.size() / PAGE_SIZE, apply_non_terminal_action, apply_terminal_action);
         DEBUG_ASSERT(result == ZX_OK);
@@ -22,11 +22,14 @@
 #include <vm/discardable_vmo_tracker.h>
 #include <vm/fault.h>
 #include <vm/page.h>
+#include <vm/physical_page_borrowing_config.h>
 #include <vm/physmap.h>
 #include <vm/pmm.h>
 #include <vm/vm_object.h>
 #include <vm/vm_object_paged.h>
 #include <vm/vm_page_list.h>
+#include <vm/workingset.h>
+#include <vm/zeroed_page_pool.h>
 
 #include "ktl/optional.h"
 #include "vm_priv.h"
@@ -66,6 +69,7 @@ KCOUNTER(vm_vmo_dont_need, "vm.vmo.dont_need")
 KCOUNTER(vm_vmo_always_need, "vm.vmo.always_need")
 KCOUNTER(vm_vmo_compression_zero_slot, "vm.vmo.compression.zero_empty_slot")
 KCOUNTER(vm_vmo_compression_marker, "vm.vmo.compression_zero_marker")
+KCOUNTER(vm_vmo_compression_prefetch, "vm.vmo.compression.prefetch_pages")
 KCOUNTER(vm_vmo_range_update_from_parent_skipped, "vm.vmo.range_updated_from_parent.skipped")
 KCOUNTER(vm_vmo_range_update_from_parent_performed, "vm.vmo.range_updated_from_parent.performed")
 
@@ -83,6 +87,14 @@ KCOUNTER(vm_reclaim_compress_success, "vm.reclaim.compress.success")
 KCOUNTER(vm_reclaim_compress_zero, "vm.reclaim.compress.zero")
 KCOUNTER(vm_reclaim_compress_fail, "vm.reclaim.compress.fail")
 KCOUNTER(vm_reclaim_compress_race, "vm.reclaim.compress.race")
+KCOUNTER_DECLARE(vm_cow_lookup_max_depth, "vm.cow.lookup.max_depth", Max)
+KCOUNTER(vm_cow_lookup_deep, "vm.cow.lookup.deep")
+KCOUNTER(vm_reclaim_refault, "vm.reclaim.refault")
+KCOUNTER(vm_attribution_cache_hit, "vm.attributed_memory.cow.cache_hit")
+KCOUNTER(vm_attribution_cache_miss, "vm.attributed_memory.cow.cache_miss")
+KCOUNTER(vm_reclaim_refault_workingset, "vm.reclaim.refault_workingset")
+KCOUNTER(vm_ppb_borrowed_on_supply, "vm.ppb.borrowed.supply")
+KCOUNTER(vm_ppb_borrowed_on_mru, "vm.ppb.borrowed.mru")
 
 template <typename T>
 uint32_t GetShareCount(T p) {
@@ -111,10 +123,21 @@ void ZeroPage(vm_page_t* p) {
 }
 
 bool IsZeroPage(vm_page_t* p) {
-  uint64_t* base = (uint64_t*)paddr_to_physmap(p->paddr());
-  for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
-    if (base[i] != 0)
+  const uint64_t* base = static_cast<const uint64_t*>(paddr_to_physmap(p->paddr()));
+  // The kernel cannot use vector registers, so instead of testing a word at a time OR together a
+  // cache line worth of words and test them with a single branch. This keeps the loads independent
+  // so they can all be in flight at once, which matters when the scanner is checking many pages
+  // for zero page deduplication.
+  constexpr size_t kWordsPerStep = 8;
+  static_assert(PAGE_SIZE % (kWordsPerStep * sizeof(uint64_t)) == 0);
+  for (size_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i += kWordsPerStep) {
+    uint64_t bits = 0;
+    for (size_t j = 0; j < kWordsPerStep; j++) {
+      bits |= base[i + j];
+    }
+    if (bits != 0) {
       return false;
+    }
   }
   return true;
 }
@@ -394,6 +417,50 @@ class BatchPQUpdateBacklink {
   uint64_t offsets_[kMaxPages];
 };
 
+// Helper class for collecting newly added pages to perform batched calls of |SetReclaim| on the
+// page queue, for the same reason as BatchPQUpdateBacklink. Pages are not in any page queue until
+// Flush has been called, and Flush must be called prior to object destruction and before the
+// object lock is dropped.
+//
+// This class has a large internal array and should be marked uninitialized.
+class BatchPQSetReclaim {
+ public:
+  explicit BatchPQSetReclaim(VmCowPages* object) : object_(object) {}
+  ~BatchPQSetReclaim() { DEBUG_ASSERT(count_ == 0); }
+  DISALLOW_COPY_AND_ASSIGN_ALLOW_MOVE(BatchPQSetReclaim);
+
+  // Add a page to the batch set. Automatically calls |Flush| if the limit is reached.
+  void Push(vm_page_t* page, uint64_t offset) {
+    DEBUG_ASSERT(page);
+    DEBUG_ASSERT(count_ < kMaxPages);
+
+    pages_[count_] = page;
+    offsets_[count_] = offset;
+    count_++;
+
+    if (count_ == kMaxPages) {
+      Flush();
+    }
+  }
+
+  // Performs |SetReclaim| on any pending pages.
+  void Flush() {
+    if (count_ > 0) {
+      pmm_page_queues()->SetReclaimArray(pages_, object_, offsets_, count_);
+      count_ = 0;
+    }
+  }
+
+ private:
+  static constexpr size_t kMaxPages = PageQueues::kMaxBatchSize;
+
+  VmCowPages* object_ = nullptr;
+
+  size_t count_ = 0;
+  vm_page_t* pages_[kMaxPages];
+  uint64_t offsets_[kMaxPages];
+};
+
 // Helper class for iterating over a subtree while respecting the child->parent lock ordering
 // requirement.
 // Cursor is constructed with a root, i.e. the starting point, and will iterate over at least
@@ -795,12 +862,20 @@ zx_status_t VmCowPages::AllocateCopyPage(paddr_t parent_paddr, list_node_t* allo
   DEBUG_ASSERT(!is_source_supplying_specific_physical_pages());
 
   vm_page_t* p_clone = nullptr;
+  bool zeroed = false;
 
   if (request->has_page()) {
     p_clone = request->take_page();
   } else if (alloc_list) {
     p_clone = list_remove_head_type(alloc_list, vm_page, queue_node);
   }
+  // A copy of the zero page can skip the zeroing entirely if a pre-zeroed page is available. Only
+  // do this if we have no restrictions on where the page comes from.
+  if (!p_clone && parent_paddr == vm_get_zero_page_paddr() &&
+      !(pmm_alloc_flags_ & PMM_ALLOC_FLAG_LO_MEM)) {
+    p_clone = zeroed_page_pool_take();
+    zeroed = p_clone != nullptr;
+  }
 
   if (p_clone) {
     InitializeVmPage(p_clone);
@@ -820,6 +895,8 @@ zx_status_t VmCowPages::AllocateCopyPage(paddr_t parent_paddr, list_node_t* allo
     const void* src = paddr_to_physmap(parent_paddr);
     DEBUG_ASSERT(src);
     memcpy(dst, src, PAGE_SIZE);
+  } else if (zeroed) {
+    DEBUG_ASSERT(IsZeroPage(p_clone));
   } else {
     // avoid pointless fetches by directly zeroing dst
     arch_zero_page(dst);
@@ -949,6 +1026,53 @@ zx_status_t VmCowPages::ReplaceReferenceWithPageLocked(VmPageOrMarkerRef page_or
   return ZX_OK;
 }
 
+uint VmCowPages::PrefetchReferencesLocked(VMPLCursor cursor, uint64_t offset, uint max_pages) {
+  // Bound the amount of work performed, and the size of the batch, for a single prefetch.
+  constexpr uint kMaxPrefetchPages = 16;
+  max_pages = ktl::min(max_pages, kMaxPrefetchPages);
+  if (max_pages == 0) {
+    return 0;
+  }
+  VmCompression* compression = Pmm::Node().GetPageCompression();
+  DEBUG_ASSERT(compression);
+
+  VmPageOrMarker::ReferenceValue refs[kMaxPrefetchPages];
+  vm_page_t* pages[kMaxPrefetchPages];
+  void* page_data[kMaxPrefetchPages];
+  uint32_t page_metadata[kMaxPrefetchPages];
+  uint count = 0;
+  cursor.ForEveryContiguous([&](VmPageOrMarkerRef slot) {
+    if (count == max_pages || !slot->IsReference()) {
+      return ZX_ERR_STOP;
+    }
+    // This is purely speculative, so never wait for an allocation or use any page_request.
+    vm_page_t* p;
+    paddr_t pa;
+    if (CacheAllocPage(pmm_alloc_flags_ & ~PMM_ALLOC_FLAG_CAN_WAIT, &p, &pa) != ZX_OK) {
+      return ZX_ERR_STOP;
+    }
+    InitializeVmPage(p);
+    refs[count] = slot.SwapReferenceForPage(p);
+    pages[count] = p;
+    page_data[count] = paddr_to_physmap(pa);
+    count++;
+    return ZX_ERR_NEXT;
+  });
+  if (count == 0) {
+    return 0;
+  }
+
+  compression->DecompressBatch(ktl::span(refs, count), ktl::span(page_data, count),
+                               ktl::span(page_metadata, count));
+  for (uint i = 0; i < count; i++) {
+    // Ensure the share count is propagated from the compressed page.
+    pages[i]->object.share_count = page_metadata[i];
+    SetNotPinnedLocked(pages[i], offset + static_cast<uint64_t>(i) * PAGE_SIZE);
+  }
+  vm_vmo_compression_prefetch.Add(count);
+  return count;
+}
+
 VmCowPages::VmCowPages(VmCowPagesOptions options, uint32_t pmm_alloc_flags, uint64_t size,
                        fbl::RefPtr<PageSource> page_source,
                        ktl::unique_ptr<DiscardableVmoTracker> discardable_tracker,
@@ -1383,6 +1507,129 @@ bool VmCowPages::DedupZeroPage(vm_page_t* page, uint64_t offset) {
   return false;
 }
 
+bool VmCowPages::DedupPage(vm_page_t* page, uint64_t offset) {
+  canary_.Assert();
+
+  VmCompression* compression = Pmm::Node().GetPageCompression();
+  if (!compression || !compression->IsDedupEnabled()) {
+    return false;
+  }
+
+  __UNINITIALIZED DeferredOps deferred(this);
+  Guard<CriticalMutex> guard{lock()};
+
+  // Only anonymous content may be replaced with a compressed reference, and similar to zero page
+  // deduping high priority VMOs must be left alone.
+  if (page_source_ || discardable_tracker_ || !can_decommit_zero_pages() ||
+      high_priority_count_ != 0) {
+    return false;
+  }
+  if (paged_ref_) {
+    if (!paged_backlink_locked(this)->CanDedupZeroPagesLocked()) {
+      return false;
+    }
+  }
+
+  // As with DedupZeroPage check that this page is still a part of this VMO and can be removed.
+  VmPageOrMarkerRef page_or_marker = page_list_.LookupMutable(offset);
+  if (!page_or_marker || !page_or_marker->IsPage() || page_or_marker->Page() != page ||
+      page->object.pin_count > 0 || page->is_loaned()) {
+    return false;
+  }
+
+  // Most pages will not have a duplicate, so first perform a racy check, leaving write permissions
+  // on the page, to avoid modifying page tables for pages that have no chance of being merged.
+  const void* page_src = paddr_to_physmap(page->paddr());
+  if (!compression->IsDedupCandidate(page_src)) {
+    return false;
+  }
+
+  // With write permissions removed, and the VMO lock held, the contents can no longer change and
+  // can be verified against the stored copy.
+  RangeChangeUpdateLocked(VmCowRange(offset, PAGE_SIZE), RangeChangeOp::RemoveWrite, nullptr);
+  ktl::optional<VmPageOrMarker::ReferenceValue> ref =
+      compression->Dedup(page_src, page->object.share_count);
+  if (!ref) {
+    return false;
+  }
+
+  // References cannot be mapped, so unmap the page before swapping it out of the page list.
+  RangeChangeUpdateLocked(VmCowRange(offset, PAGE_SIZE), RangeChangeOp::Unmap, &deferred);
+  [[maybe_unused]] vm_page_t* old_page = page_or_marker.SwapPageForReference(*ref);
+  DEBUG_ASSERT(old_page == page);
+  RemovePageLocked(page, deferred);
+
+  reclamation_event_count_++;
+  VMO_VALIDATION_ASSERT(DebugValidateHierarchyLocked());
+  VMO_FRUGAL_VALIDATION_ASSERT(DebugValidateVmoPageBorrowingLocked());
+  return true;
+}
+
+zx_status_t VmCowPages::CommitLargePageLocked(VmCowRange range, DeferredOps& deferred,
+                                              paddr_t* pa) {
+  canary_.Assert();
+  DEBUG_ASSERT(range.len == PmmNode::kLargePageSize);
+  DEBUG_ASSERT(range.offset % PmmNode::kLargePageSize == 0);
+  DEBUG_ASSERT(!is_hidden());
+
+  // Without a page source or a parent an empty range can only ever be zero, and so it can be
+  // committed with a large page without needing to consider where any existing content comes from.
+  if (page_source_ || parent_ || range.end() > size_ ||
+      page_list_.AnyPagesOrIntervalsInRange(range.offset, range.end())) {
+    return ZX_ERR_NOT_SUPPORTED;
+  }
+
+  list_node_t pages = LIST_INITIAL_VALUE(pages);
+  zx_status_t status = Pmm::Node().AllocLargePage(pa, &pages);
+  if (status != ZX_OK) {
+    return status;
+  }
+  // Any existing mappings of the range can only be of the zero page, and adding the pages will
+  // remove them.
+  return AddNewPagesLocked(range.offset, &pages, CanOverwriteContent::Zero, /*zero=*/true,
+                           &deferred);
+}
+
+bool VmCowPages::LookupLargePageLocked(VmCowRange range, paddr_t* pa) const {
+  canary_.Assert();
+  DEBUG_ASSERT(range.len == PmmNode::kLargePageSize);
+  DEBUG_ASSERT(range.offset % PmmNode::kLargePageSize == 0);
+
+  // Pages from a page source may need a write fault to track them as dirty, so they can never be
+  // mapped writable ahead of time.
+  if (page_source_ || range.end() > size_) {
+    return false;
+  }
+
+  // Every slot must be a page, with no gaps, and each must immediately follow the previous one in
+  // physical memory, starting from a large page aligned address.
+  size_t found = 0;
+  paddr_t base = 0;
+  page_list_.ForEveryPageInRange(
+      [&found, &base, &range](const VmPageOrMarker* p, uint64_t off) {
+        if (!p->IsPage() || off != range.offset + found * PAGE_SIZE) {
+          return ZX_ERR_STOP;
+        }
+        const paddr_t paddr = p->Page()->paddr();
+        if (found == 0) {
+          if (paddr % PmmNode::kLargePageSize != 0) {
+            return ZX_ERR_STOP;
+          }
+          base = paddr;
+        } else if (paddr != base + found * PAGE_SIZE) {
+          return ZX_ERR_STOP;
+        }
+        found++;
+        return ZX_ERR_NEXT;
+      },
+      range.offset, range.end());
+  if (found != PmmNode::kLargePageCount) {
+    return false;
+  }
+  *pa = base;
+  return true;
+}
+
 zx_status_t VmCowPages::Create(VmCowPagesOptions options, uint32_t pmm_alloc_flags, uint64_t size,
                                ktl::unique_ptr<DiscardableVmoTracker> discardable_tracker,
                                fbl::RefPtr<VmCowPages>* cow_pages) {
@@ -2208,6 +2455,18 @@ VmCowPages::AttributionCounts VmCowPages::GetAttributedMemoryInRangeLocked(VmCow
   // we cannot use the normal if constexpr guard and instead need a preprocessor guard.
   DEBUG_ASSERT(!is_hidden());
 
+  // Without a parent every page or reference is owned by this node and its share count is never
+  // read, so the result only changes when the page list does. Repeated queries of an idle VMO,
+  // which is the common case when gathering stats for every process, can then skip the walk.
+  const bool cacheable = !parent_;
+  if (cacheable && cached_attribution_.valid &&
+      cached_attribution_.generation == page_list_.generation() &&
+      cached_attribution_.range.offset == range.offset &&
+      cached_attribution_.range.len == range.len) {
+    vm_attribution_cache_hit.Add(1);
+    return cached_attribution_.counts;
+  }
+
   VmCompression* compression = Pmm::Node().GetPageCompression();
 
   // Accumulate bytes for all pages and references this node has ownership over.
@@ -2248,6 +2507,10 @@ VmCowPages::AttributionCounts VmCowPages::GetAttributedMemoryInRangeLocked(VmCow
       range.offset, range.len, LockedPtr());
   DEBUG_ASSERT(status == ZX_OK);
 
+  if (cacheable) {
+    vm_attribution_cache_miss.Add(1);
+    cached_attribution_ = {range, page_list_.generation(), counts, true};
+  }
   return counts;
 }
 
@@ -2770,6 +3033,18 @@ void VmCowPages::FindPageContentLocked(uint64_t offset, uint64_t max_owner_lengt
                                        PageLookup* out) {
   const uint64_t this_offset = offset;
 
+  // Track how many ancestors had to be searched, as a measure of how much deep clone chains are
+  // costing lookups.
+  uint32_t depth = 0;
+  auto record_depth = fit::defer([&depth]() {
+    if (depth > 0) {
+      kcounter_max(vm_cow_lookup_max_depth, depth);
+      if (depth >= kDeepLookupDepth) {
+        vm_cow_lookup_deep.Add(1);
+      }
+    }
+  });
+
   // Search up the clone chain for any committed pages. cur_offset is the offset
   // into cur we care about. The loop terminates either when that offset contains
   // a committed page or when that offset can't reach into the parent.
@@ -2844,6 +3119,7 @@ void VmCowPages::FindPageContentLocked(uint64_t offset, uint64_t max_owner_lengt
 
     offset += cur.locked_or(this).parent_offset_;
     cur = LockedPtr(parent);
+    depth++;
   }
   *out = {cur.locked_or(this).page_list_.LookupMutableCursor(offset), ktl::move(cur), offset,
           max_owner_length + this_offset};
@@ -3356,11 +3632,31 @@ VmCowPages::LookupCursor::TargetAllocateCopyPageAsResult(vm_page_t* source, Dirt
   return zx::ok(PageAsResultNoIncrement(out_page, true));
 }
 
-zx_status_t VmCowPages::LookupCursor::CursorReferenceToPage(AnonymousPageRequest* page_request) {
+zx_status_t VmCowPages::LookupCursor::CursorReferenceToPage(uint max_request_pages,
+                                                            AnonymousPageRequest* page_request) {
   DEBUG_ASSERT(CursorIsReference());
+  DEBUG_ASSERT(max_request_pages > 0);
+
+  VmCowPages& owner = owner_info_.owner.locked_or(target_);
+  zx_status_t status =
+      owner.ReplaceReferenceWithPageLocked(owner_cursor_, owner_info_.owner_offset, page_request);
+  if (status != ZX_OK) {
+    return status;
+  }
 
-  return owner_info_.owner.locked_or(target_).ReplaceReferenceWithPageLocked(
-      owner_cursor_, owner_info_.owner_offset, page_request);
+  // Having paid for a decompression on this access, decompress any immediately following
+  // references in the visible range of the owner, as these are likely to be accessed next. This
+  // does not move the cursor, and pages are replaced in place so the owner_cursor_ remains valid.
+  const uint64_t prefetch_end = ktl::min(
+      offset_ + static_cast<uint64_t>(max_request_pages) * PAGE_SIZE, owner_info_.visible_end);
+  const uint prefetch_pages = static_cast<uint>((prefetch_end - offset_) / PAGE_SIZE) - 1;
+  if (prefetch_pages > 0) {
+    VMPLCursor cursor = owner_info_.cursor;
+    cursor.step();
+    owner.PrefetchReferencesLocked(ktl::move(cursor), owner_info_.owner_offset + PAGE_SIZE,
+                                   prefetch_pages);
+  }
+  return ZX_OK;
 }
 
 zx_status_t VmCowPages::LookupCursor::ReadRequest(uint max_request_pages,
@@ -3393,6 +3689,20 @@ zx_status_t VmCowPages::LookupCursor::ReadRequest(uint max_request_pages,
     // owner.
     request_size = ktl::min(request_size, owner_info_.visible_end - offset_);
   }
+  // Extend the request to read ahead of any sequential access pattern, although never beyond the
+  // end of the owner, or the range that is visible from the target.
+  {
+    VmCowPages& owner = owner_info_.owner.locked_or(target_);
+    uint64_t readahead_end = owner.size_;
+    if (!TargetIsOwner()) {
+      readahead_end = ktl::min(readahead_end, owner_info_.owner_offset +
+                                                  (owner_info_.visible_end - offset_));
+    }
+    DEBUG_ASSERT(readahead_end >= owner_info_.owner_offset + request_size);
+    request_size = ktl::min(
+        owner.page_source_->ReadaheadLength(owner_info_.owner_offset, request_size),
+        readahead_end - owner_info_.owner_offset);
+  }
   // Limit |request_size| to the first page visible in the page owner to avoid requesting pages
   // that are already present. If there is one page present in an otherwise long run of absent pages
   // then it might be preferable to have one big page request, but for now only request absent
@@ -3556,7 +3866,7 @@ zx::result<VmCowPages::LookupCursor::RequireResult> VmCowPages::LookupCursor::Re
   // Convert any references to pages.
   if (CursorIsReference()) {
     // Decompress in place.
-    zx_status_t status = CursorReferenceToPage(page_request->GetAnonymous());
+    zx_status_t status = CursorReferenceToPage(max_request_pages, page_request->GetAnonymous());
     if (status != ZX_OK) {
       return zx::error(status);
     }
@@ -3678,7 +3988,7 @@ zx::result<VmCowPages::LookupCursor::RequireResult> VmCowPages::LookupCursor::Re
   // If there's a page or reference, return it.
   if (CursorIsPage() || CursorIsReference()) {
     if (CursorIsReference()) {
-      zx_status_t status = CursorReferenceToPage(page_request->GetAnonymous());
+      zx_status_t status = CursorReferenceToPage(max_request_pages, page_request->GetAnonymous());
       if (status != ZX_OK) {
         return zx::error(status);
       }
@@ -3871,34 +4181,72 @@ zx_status_t VmCowPages::PinRangeLocked(VmCowRange range) {
 zx_status_t VmCowPages::DecommitRange(VmCowRange range) {
   canary_.Assert();
 
-  __UNINITIALIZED DeferredOps deferred(this);
-  Guard<CriticalMutex> guard{AssertOrderedLock, lock(), lock_order()};
-  // Validate the size and perform our zero-length hot-path check before we recurse
-  // up to our top-level ancestor.  Size bounding needs to take place relative
-  // to the child the operation was originally targeted against.
-  if (!range.IsBoundedBy(size_)) {
-    return ZX_ERR_OUT_OF_RANGE;
-  }
+  {
+    __UNINITIALIZED DeferredOps deferred(this);
+    Guard<CriticalMutex> guard{AssertOrderedLock, lock(), lock_order()};
+    // Validate the size and perform our zero-length hot-path check before we recurse
+    // up to our top-level ancestor.  Size bounding needs to take place relative
+    // to the child the operation was originally targeted against.
+    if (!range.IsBoundedBy(size_)) {
+      return ZX_ERR_OUT_OF_RANGE;
+    }
 
-  // was in range, just zero length
-  if (range.is_empty()) {
-    return ZX_OK;
-  }
+    // was in range, just zero length
+    if (range.is_empty()) {
+      return ZX_OK;
+    }
 
-  // Currently, we can't decommit if the absence of a page doesn't imply zeroes.
-  if (parent_ || is_source_preserving_page_content()) {
-    return ZX_ERR_NOT_SUPPORTED;
-  }
+    // Currently, we can't decommit if the absence of a page doesn't imply zeroes.
+    if (parent_ || is_source_preserving_page_content()) {
+      return ZX_ERR_NOT_SUPPORTED;
+    }
 
-  // VmObjectPaged::DecommitRange() rejects is_contiguous() VMOs (for now).
-  DEBUG_ASSERT(can_decommit());
+    // VmObjectPaged::DecommitRange() rejects is_contiguous() VMOs (for now).
+    DEBUG_ASSERT(can_decommit());
 
-  // Demand offset and length be correctly aligned to not give surprising user semantics.
-  if (!range.is_page_aligned()) {
-    return ZX_ERR_INVALID_ARGS;
+    // Demand offset and length be correctly aligned to not give surprising user semantics.
+    if (!range.is_page_aligned()) {
+      return ZX_ERR_INVALID_ARGS;
+    }
+
+    // Check the whole range for pins up front, so that the common failure case does not leave
+    // the range partially decommitted.
+    if (AnyPagesPinnedLocked(range.offset, range.len)) {
+      return ZX_ERR_BAD_STATE;
+    }
+
+    const uint64_t chunk_len = ktl::min(range.len, kMaxRangeOpChunkSize);
+    zx::result<uint64_t> result = UnmapAndFreePagesLocked(range.offset, chunk_len, deferred);
+    if (result.is_error()) {
+      return result.status_value();
+    }
+    range.offset += chunk_len;
+    range.len -= chunk_len;
   }
 
-  return UnmapAndFreePagesLocked(range.offset, range.len, deferred).status_value();
+  // Decommit the remainder one chunk at a time, dropping the lock, and freeing the pages of the
+  // previous chunk, in between so that decommitting a huge range does not stall other users of
+  // the VMO. The VMO may have been resized while the lock was dropped, in which case only the
+  // part that still exists is decommitted.
+  while (!range.is_empty()) {
+    __UNINITIALIZED DeferredOps deferred(this);
+    Guard<CriticalMutex> guard{AssertOrderedLock, lock(), lock_order()};
+    if (parent_ || is_source_preserving_page_content()) {
+      return ZX_ERR_NOT_SUPPORTED;
+    }
+    if (range.offset >= size_) {
+      break;
+    }
+    const uint64_t chunk_len =
+        ktl::min(ktl::min(range.len, kMaxRangeOpChunkSize), size_ - range.offset);
+    zx::result<uint64_t> result = UnmapAndFreePagesLocked(range.offset, chunk_len, deferred);
+    if (result.is_error()) {
+      return result.status_value();
+    }
+    range.offset += chunk_len;
+    range.len -= chunk_len;
+  }
+  return ZX_OK;
 }
 
 zx::result<uint64_t> VmCowPages::UnmapAndFreePagesLocked(uint64_t offset, uint64_t len,
@@ -5678,6 +6026,9 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
   const uint64_t start = range.offset;
   const uint64_t end = range.end();
 
+  // Size of the active set, only computed if a refault is found.
+  ktl::optional<uint64_t> active_pages;
+
   const CanOverwriteContent overwrite_policy = options == SupplyOptions::TransferData
                                                    ? CanOverwriteContent::NonZero
                                                    : CanOverwriteContent::None;
@@ -5762,6 +6113,26 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
     }
   }
 
+  // Supplied pages start off Clean, so unless this VMO is high priority they will all go to the
+  // reclaim queues (see SetNotPinnedLocked). Sequential supplies can be large, so add them to the
+  // page queues in batches instead of taking the page queues lock for every page.
+  const bool batch_reclaim_queue =
+      options != SupplyOptions::PhysicalPageProvider && is_source_preserving_page_content() &&
+      high_priority_count_ == 0;
+  __UNINITIALIZED BatchPQSetReclaim pq_batch(this);
+
+  // When transferring data into a VMO that could have had its own content compressed, compressed
+  // references from the source can be moved in as is instead of being decompressed only to
+  // potentially be compressed again later. These are the same conditions under which the reclaimer
+  // will replace content with a reference.
+  const bool supply_references = [&]() TA_REQ(lock()) {
+    if (options != SupplyOptions::TransferData || discardable_tracker_ ||
+        !can_decommit_zero_pages() || high_priority_count_ != 0) {
+      return false;
+    }
+    return !paged_ref_ || paged_backlink_locked(this)->CanDedupZeroPagesLocked();
+  }();
+
   // [new_pages_start, new_pages_start + new_pages_len) tracks the current run of
   // consecutive new pages added to this vmo.
   uint64_t offset = range.offset;
@@ -5778,7 +6149,7 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
     VmPageOrMarkerRef src_page_ref = pages->PeekReference();
     // The src_page_ref can be null if the head of the page list is not a reference or if the page
     // list is empty.
-    if (src_page_ref) {
+    if (src_page_ref && !supply_references) {
       DEBUG_ASSERT(src_page_ref->IsReference());
       status = MakePageFromReference(src_page_ref, page_request->GetAnonymous());
       if (status != ZX_OK) {
@@ -5786,7 +6157,7 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
       }
     }
     VmPageOrMarker src_page = pages->Pop();
-    DEBUG_ASSERT(!src_page.IsReference());
+    DEBUG_ASSERT(supply_references || !src_page.IsReference());
 
     // The pager API does not allow the source VMO of supply pages to have a page source, so we can
     // assume that any empty pages are zeroes and insert explicit markers here. We need to insert
@@ -5823,8 +6194,9 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
       if (page_transaction.is_error()) {
         // Unable to insert anything at this slot, cleanup any existing src_page and handle a
         // completed run.
-        if (src_page.IsPageOrRef()) {
-          DEBUG_ASSERT(src_page.IsPage());
+        if (src_page.IsReference()) {
+          FreeReference(src_page.ReleaseReference());
+        } else if (src_page.IsPage()) {
           vm_page_t* page = src_page.ReleasePage();
           DEBUG_ASSERT(!list_in_list(&page->queue_node));
           list_add_tail(deferred.FreedList(this).List(), &page->queue_node);
@@ -5834,6 +6206,7 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
           // We hit the end of a run of absent pages, so notify the page source
           // of any new pages that were added and reset the tracking variables.
           if (new_pages_len) {
+            pq_batch.Flush();
             RangeChangeUpdateLocked(VmCowRange(new_pages_start, new_pages_len),
                                     RangeChangeOp::Unmap, &deferred);
             if (page_source_) {
@@ -5868,7 +6241,20 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
         // so we use AddPageLocked().
         // We only want to populate offsets that have true absence of content, so do not overwrite
         // anything in the page list.
-        old_page = CompleteAddPageLocked(*page_transaction, ktl::move(src_page), nullptr);
+        if (batch_reclaim_queue && src_page.IsPage()) {
+          // Equivalent to CompleteAddPageLocked with a null |deferred|, except for the page queue
+          // insertion which is batched.
+          DEBUG_ASSERT(page_source_->DebugIsPageOk(src_page.Page(), offset));
+          DEBUG_ASSERT(is_page_clean(src_page.Page()));
+          DEBUG_ASSERT(src_page.Page()->object.pin_count == 0);
+          pq_batch.Push(src_page.Page(), offset);
+          old_page = page_transaction->Complete(ktl::move(src_page));
+        } else {
+          old_page = CompleteAddPageLocked(*page_transaction, ktl::move(src_page), nullptr);
+        }
+        if (can_evict()) {
+          CheckRefaultLocked(offset, &active_pages);
+        }
       }
     }
     // If the content overwrite policy was None, the old page should be empty.
@@ -5900,6 +6286,7 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
 
     offset += PAGE_SIZE;
   }
+  pq_batch.Flush();
   // Unless there was an error and we exited the loop early, then there should have been the correct
   // number of pages in the splice list.
   DEBUG_ASSERT(offset == end || status != ZX_OK);
@@ -5911,6 +6298,27 @@ zx_status_t VmCowPages::SupplyPagesLocked(VmCowRange range, VmPageSpliceList* pa
     }
   }
 
+  // Optionally move the supplied content into loaned pages, freeing up the supplied pages. This is
+  // best effort and stops as soon as there are no more loaned pages to borrow.
+  if (options == SupplyOptions::PagerSupply &&
+      PhysicalPageBorrowingConfig::Get().is_borrowing_in_supplypages_enabled() &&
+      should_borrow_locked() && pmm_count_loaned_free_pages() != 0) {
+    for (uint64_t borrow_offset = start; borrow_offset < offset; borrow_offset += PAGE_SIZE) {
+      const VmPageOrMarker* slot = page_list_.Lookup(borrow_offset);
+      if (!slot || !slot->IsPage() || slot->Page()->is_loaned()) {
+        continue;
+      }
+      const zx_status_t borrow_status = ReplacePageLocked(slot->Page(), borrow_offset, true,
+                                                          nullptr, deferred, nullptr);
+      if (borrow_status == ZX_ERR_NO_RESOURCES) {
+        break;
+      }
+      if (borrow_status == ZX_OK) {
+        vm_ppb_borrowed_on_supply.Add(1);
+      }
+    }
+  }
+
   VMO_VALIDATION_ASSERT(DebugValidateHierarchyLocked());
   VMO_FRUGAL_VALIDATION_ASSERT(DebugValidateVmoPageBorrowingLocked());
 
@@ -6891,6 +7299,10 @@ VmCowPages::ReclaimCounts VmCowPages::ReclaimPageForEviction(vm_page_t* page, ui
   DEBUG_ASSERT(p == page);
   const bool loaned = page->is_loaned();
   RemovePageLocked(page, deferred);
+  // Leave a shadow entry behind so that a refault of this offset can be recognized.
+  if (Workingset* workingset = Workingset::Get(); workingset != nullptr) {
+    workingset->RecordEviction(this, offset);
+  }
 
   reclamation_event_count_++;
   VMO_VALIDATION_ASSERT(DebugValidateHierarchyLocked());
@@ -6901,6 +7313,26 @@ VmCowPages::ReclaimCounts VmCowPages::ReclaimPageForEviction(vm_page_t* page, ui
   };
 }
 
+void VmCowPages::CheckRefaultLocked(uint64_t offset, ktl::optional<uint64_t>* active_pages) {
+  Workingset* workingset = Workingset::Get();
+  if (workingset == nullptr) {
+    return;
+  }
+  ktl::optional<uint32_t> distance = workingset->TakeRefaultDistance(this, offset);
+  if (!distance) {
+    return;
+  }
+  vm_reclaim_refault.Add(1);
+  if (!active_pages->has_value()) {
+    *active_pages = pmm_page_queues()->GetActiveInactiveCounts().active;
+  }
+  // Supplied pages are placed in the MRU queue, and so are already part of the active set. A
+  // refault within the working set only needs to be accounted for.
+  if (Workingset::IsWorkingsetRefault(*distance, **active_pages)) {
+    vm_reclaim_refault_workingset.Add(1);
+  }
+}
+
 VmCowPages::ReclaimCounts VmCowPages::ReclaimPageForCompression(vm_page_t* page, uint64_t offset,
                                                                 VmCompressor* compressor) {
   DEBUG_ASSERT(compressor);
@@ -7182,7 +7614,11 @@ zx_status_t VmCowPages::ReplacePageWithLoaned(vm_page_t* before_page, uint64_t o
 
   __UNINITIALIZED DeferredOps deferred(this);
   Guard<CriticalMutex> guard{lock()};
-  return ReplacePageLocked(before_page, offset, true, nullptr, deferred, nullptr);
+  zx_status_t status = ReplacePageLocked(before_page, offset, true, nullptr, deferred, nullptr);
+  if (status == ZX_OK) {
+    vm_ppb_borrowed_on_mru.Add(1);
+  }
+  return status;
 }
 
 zx_status_t VmCowPages::ReplacePage(vm_page_t* before_page, uint64_t offset, bool with_loaned,
@@ -7786,6 +8222,47 @@ VmCowPages::DiscardablePageCounts VmCowPages::DebugGetDiscardablePageCounts() co
   return counts;
 }
 
+uint64_t VmCowPages::IdleDiscardablePages(zx_instant_mono_t unlocked_before) const {
+  canary_.Assert();
+  if (!discardable_tracker_) {
+    return 0;
+  }
+
+  Guard<CriticalMutex> guard{lock()};
+
+  discardable_tracker_->assert_cow_pages_locked();
+  if (!discardable_tracker_->IsEligibleForReclamationLocked() ||
+      discardable_tracker_->last_unlock_timestamp_locked() >= unlocked_before) {
+    return 0;
+  }
+
+  uint64_t pages = 0;
+  page_list_.ForEveryPage([&pages](const auto* p, uint64_t) {
+    if (p->IsPageOrRef()) {
+      ++pages;
+    }
+    return ZX_ERR_NEXT;
+  });
+  return pages;
+}
+
+zx::result<uint64_t> VmCowPages::DiscardIfIdle(zx_instant_mono_t unlocked_before) {
+  canary_.Assert();
+  if (!discardable_tracker_) {
+    return zx::error(ZX_ERR_BAD_STATE);
+  }
+
+  __UNINITIALIZED DeferredOps deferred(this);
+  Guard<CriticalMutex> guard{AssertOrderedLock, lock(), lock_order()};
+
+  // The VMO may have been locked and unlocked again since it was picked as a candidate.
+  discardable_tracker_->assert_cow_pages_locked();
+  if (discardable_tracker_->last_unlock_timestamp_locked() >= unlocked_before) {
+    return zx::error(ZX_ERR_BAD_STATE);
+  }
+  return DiscardPagesLocked(deferred);
+}
+
 zx::result<uint64_t> VmCowPages::DiscardPagesLocked(DeferredOps& deferred) {
   // Not a discardable VMO.
   if (!discardable_tracker_) {
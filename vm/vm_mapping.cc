@@ -7,6 +7,7 @@
 #include <align.h>
 #include <assert.h>
 #include <inttypes.h>
+#include <lib/boot-options/boot-options.h>
 #include <lib/counters.h>
 #include <lib/fit/defer.h>
 #include <trace.h>
@@ -38,6 +39,9 @@ namespace {
 KCOUNTER(vm_mapping_attribution_queries, "vm.attributed_memory.mapping.queries")
 KCOUNTER(vm_mappings_merged, "vm.aspace.mapping.merged_neighbors")
 KCOUNTER(vm_mappings_protect_no_write, "vm.aspace.mapping.protect_without_write")
+KCOUNTER(vm_mapping_large_page_committed, "vm.aspace.mapping.large_page.committed")
+KCOUNTER(vm_mapping_large_page_promoted, "vm.aspace.mapping.large_page.promoted")
+KCOUNTER(vm_mapping_fault_around_pages, "vm.aspace.mapping.fault_around.pages")
 
 }  // namespace
 
@@ -308,12 +312,16 @@ zx_status_t VmMapping::UnmapLocked(vaddr_t base, size_t size) {
     AssertHeld(right->object_lock_ref());
     MappingProtectionRanges right_prot = protection_ranges_.SplitAt(base + size);
     right->protection_ranges_ = ktl::move(right_prot);
+    right->large_pages_mapped_ = large_pages_mapped_;
+    right->fault_around_max_pages_ = fault_around_max_pages_;
   }
   if (left) {
     AssertHeld(left->lock_ref());
     AssertHeld(left->object_lock_ref());
     protection_ranges_.DiscardAbove(base);
     left->protection_ranges_ = ktl::move(protection_ranges_);
+    left->large_pages_mapped_ = large_pages_mapped_;
+    left->fault_around_max_pages_ = fault_around_max_pages_;
   }
 
   // Now finish destroying this mapping, but remember any memory_priority_ to apply to the new
@@ -563,8 +571,8 @@ class VmMappingCoalescer {
   // How much space remains in the phys_ array, starting from vaddr, that can be used to
   // opportunistically map additional pages.
   size_t ExtraPageCapacityFrom(vaddr_t vaddr) {
-    // vaddr must be appendable & the coalescer can't be empty.
-    return (can_append(vaddr) && count_ != 0) ? NumPages - count_ : 0;
+    // vaddr must be appendable & the run can't be empty, although it may have been flushed.
+    return (can_append(vaddr) && (count_ != 0 || total_mapped_ != 0)) ? NumPages - count_ : 0;
   }
 
   // Functions for the user to manually manage the pages array. It is up to the user to manage the
@@ -726,6 +734,16 @@ zx_status_t VmMapping::MapRange(size_t offset, size_t len, bool commit, bool ign
             return ZX_ERR_STOP;
           }
 
+          // Single page mappings cannot be added within a large page entry, so split any that might
+          // be present. This is only possible if mapping over existing entries was requested.
+          if (large_pages_mapped_ && ignore_existing) {
+            zx_status_t status = aspace_->arch_aspace().Unmap(base, len / PAGE_SIZE,
+                                                              aspace_->EnlargeArchUnmap());
+            if (status != ZX_OK) {
+              return status;
+            }
+          }
+
           VmMappingCoalescer<16> coalescer(this, base, mmu_flags,
                                            ignore_existing
                                                ? ArchVmAspace::ExistingEntryAction::Skip
@@ -841,12 +859,10 @@ zx_status_t VmMapping::DestroyLockedObject(bool unmap) {
   // subregions_.erase below).
   fbl::RefPtr<VmMapping> self(this);
 
-  // If this is the last_fault_ then clear it before removing from the VMAR tree. Even if this
-  // destroy fails, it's always safe to clear last_fault_, so we preference doing it upfront for
+  // If this is in the fault cache then clear it before removing from the VMAR tree. Even if this
+  // destroy fails, it's always safe to clear the cache entry, so we preference doing it upfront for
   // clarity.
-  if (aspace_->last_fault_ == this) {
-    aspace_->last_fault_ = nullptr;
-  }
+  aspace_->ForgetFaultMappingLocked(this);
 
   // The vDSO code mapping can never be unmapped, not even
   // by VMAR destruction (except for process exit, of course).
@@ -887,6 +903,14 @@ zx_status_t VmMapping::DestroyLockedObject(bool unmap) {
   return ZX_OK;
 }
 
+void VmMapping::SetFaultAroundLocked(uint32_t max_pages) {
+  canary_.Assert();
+  DEBUG_ASSERT(max_pages > 0 && max_pages <= kPageFaultMaxFaultAroundPages);
+  fault_around_max_pages_ = max_pages;
+  fault_around_pages_ =
+      ktl::min(static_cast<uint32_t>(kPageFaultMaxOptimisticPages), fault_around_max_pages_);
+}
+
 ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const uint pf_flags,
                                                             const size_t additional_pages,
                                                             MultiPageRequest* page_request) {
@@ -951,6 +975,24 @@ ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const ui
   // Calculate the number of pages from va until the end of the protection range.
   const size_t num_protection_range_pages = (range.region_top - va) / PAGE_SIZE;
 
+  // A fault that lands exactly where the previous one stopped mapping looks like a sequential
+  // access, so grow the fault-around window to take fewer faults over the rest of the range. Any
+  // other fault resets the window. Read-only user mappings can opt to start with the full window,
+  // as they are typically shared libraries and data files whose pages are already resident from
+  // other processes, and fault-around only maps pages that already exist.
+  if (additional_pages == 0) {
+    if (va == fault_around_next_) {
+      fault_around_pages_ = ktl::min(fault_around_pages_ * 2, fault_around_max_pages_);
+    } else if (gBootOptions->vm_read_only_fault_around && aspace_->is_user() &&
+               !(range.mmu_flags & ARCH_MMU_FLAG_PERM_WRITE)) {
+      fault_around_pages_ = fault_around_max_pages_;
+    } else {
+      fault_around_pages_ =
+          ktl::min(static_cast<uint32_t>(kPageFaultMaxOptimisticPages), fault_around_max_pages_);
+    }
+  }
+  const size_t fault_around_pages = fault_around_pages_;
+
   // Helper lambda that calculates two values:
   //  * Number of pages we're aiming to fault. If a range > 1 page is supplied, it is assumed the
   //    user knows the appropriate range, so opportunistic pages will not be added.
@@ -968,8 +1010,8 @@ ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const ui
       const uint64_t next_pt_base = ArchVmAspace::NextUserPageTableOffset(va);
       const size_t num_pt_pages = (next_pt_base - va) / PAGE_SIZE;
       // Number of opportunistic pages we can fault, including the required page.
-      const size_t num_fault_pages = ktl::min(
-          {kPageFaultMaxOptimisticPages, num_pt_pages, num_protection_range_pages, num_vmo_pages});
+      const size_t num_fault_pages =
+          ktl::min({fault_around_pages, num_pt_pages, num_protection_range_pages, num_vmo_pages});
       return ktl::optional<ktl::pair<size_t, size_t>>({1, num_fault_pages});
     } else {
       // Cap by requested pages.
@@ -998,10 +1040,91 @@ ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const ui
     }
     auto [num_required_pages, num_fault_pages] = *pages;
 
+    // Opportunistically map the entire large page aligned range containing the fault with a single
+    // large page, either by committing a new large page on a write, or because the range already
+    // happens to be backed by suitably contiguous pages. This is only attempted for regular faults
+    // in user and guest physical mappings where the whole range is readable and writable with the
+    // default cache policy, so that the large page never needs splitting just to map it. For guests
+    // this also saves a level of the two dimensional walk on every TLB miss.
+    auto map_large_page = [&]() TA_REQ(lock()) TA_REQ(object_->lock()) {
+      const uint large_page_mmu_flags = ARCH_MMU_FLAG_PERM_READ | ARCH_MMU_FLAG_PERM_WRITE |
+                                        (aspace_->is_user() ? ARCH_MMU_FLAG_PERM_USER : 0);
+      const vaddr_t large_va = ROUNDDOWN(va, PmmNode::kLargePageSize);
+      if (additional_pages != 0 || !gBootOptions->vm_anonymous_large_pages ||
+          !(aspace_->is_user() || aspace_->is_guest_physical()) ||
+          (flags_ & VMAR_FLAG_FAULT_BEYOND_STREAM_SIZE) ||
+          !ProtectRangesLocked().IsSingleRegion() ||
+          (range.mmu_flags & large_page_mmu_flags) != large_page_mmu_flags ||
+          (range.mmu_flags & ARCH_MMU_FLAG_CACHE_MASK) != ARCH_MMU_FLAG_CACHED ||
+          large_va < base_ || large_va + PmmNode::kLargePageSize > base_ + size_) {
+        return false;
+      }
+      const uint64_t large_offset = large_va - base_ + object_offset_locked();
+      if (large_offset % PmmNode::kLargePageSize != 0) {
+        return false;
+      }
+      AssertHeld(paged->lock_ref());
+      CurrentlyFaulting currently_faulting(this, large_offset, PmmNode::kLargePageSize);
+      paddr_t pa;
+      bool committed = false;
+      if (!paged->LookupLargePageLocked(large_offset, &pa)) {
+        // Reads of uncommitted content can be satisfied by the zero page, so only commit new
+        // memory for a write.
+        if (!write || paged->CommitLargePageLocked(large_offset, deferred, &pa) != ZX_OK) {
+          return false;
+        }
+        committed = true;
+        object_->mark_modified_locked();
+      }
+      // Nothing is mapped in the range on a first touch, so try to map it directly. Otherwise any
+      // existing single page mappings, or large page entry, must be removed first. This is an exact
+      // large page aligned range and so will never need enlarging.
+      zx_status_t status = aspace_->arch_aspace().MapContiguous(
+          large_va, pa, PmmNode::kLargePageCount, range.mmu_flags);
+      if (status == ZX_ERR_ALREADY_EXISTS) {
+        status = aspace_->arch_aspace().Unmap(large_va, PmmNode::kLargePageCount,
+                                              ArchVmAspace::ArchUnmapOptions::None);
+        if (status == ZX_OK) {
+          status = aspace_->arch_aspace().MapContiguous(large_va, pa, PmmNode::kLargePageCount,
+                                                        range.mmu_flags);
+        }
+      }
+      if (status != ZX_OK) {
+        return false;
+      }
+      currently_faulting.MappingUpdated();
+      large_pages_mapped_ = true;
+      (committed ? vm_mapping_large_page_committed : vm_mapping_large_page_promoted).Add(1);
+      return true;
+    };
+    if (map_large_page()) {
+      return {ZX_OK, static_cast<uint32_t>(PmmNode::kLargePageCount)};
+    }
+
     // Opportunistic pages are not considered in currently_faulting optimisation, as it is not
     // guaranteed the mappings will be updated.
     CurrentlyFaulting currently_faulting(this, vmo_offset, num_required_pages * PAGE_SIZE);
 
+    // Single page mappings cannot replace a large page entry, such as one that was made read-only
+    // by a clone, so split any large page covering the fault so that it can be handled normally. A
+    // large page entry maps every address it covers, and the fault range is smaller than a large
+    // page, so any large page overlapping it maps its first or last page. Faults on unmapped
+    // addresses, the usual case, need no split.
+    if (large_pages_mapped_) {
+      DEBUG_ASSERT(num_required_pages <= PmmNode::kLargePageCount);
+      paddr_t mapped_pa;
+      uint mapped_flags;
+      const vaddr_t last_va = va + (num_required_pages - 1) * PAGE_SIZE;
+      if (aspace_->arch_aspace().Query(va, &mapped_pa, &mapped_flags) == ZX_OK ||
+          aspace_->arch_aspace().Query(last_va, &mapped_pa, &mapped_flags) == ZX_OK) {
+        zx_status_t status = aspace_->arch_aspace().Unmap(va, num_required_pages,
+                                                          aspace_->EnlargeArchUnmap());
+        if (status != ZX_OK) {
+          return {status, 0};
+        }
+      }
+    }
+
     __UNINITIALIZED VmMappingCoalescer<coalescer_size> coalescer(
         this, va, range.mmu_flags, ArchVmAspace::ExistingEntryAction::Upgrade);
 
@@ -1058,17 +1181,32 @@ ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const ui
     // appropriate range, so opportunistic pages will not be fault.
     if (additional_pages == 0) {
       DEBUG_ASSERT(num_fault_pages > 0);
-      // Check how much space the coalescer has for faulting additional pages.
-      size_t extra_pages = coalescer.ExtraPageCapacityFrom(va + PAGE_SIZE);
-      extra_pages = ktl::min(extra_pages, num_fault_pages - 1);
-
+      const bool writeable = (coalescer.GetMmuFlags() & ARCH_MMU_FLAG_PERM_WRITE);
+      vaddr_t next_va = va + PAGE_SIZE;
+      size_t remaining = num_fault_pages - 1;
       // Acquire any additional pages, but only if they already exist as the user has not attempted
-      // to use these pages yet.
-      if (extra_pages > 0) {
-        bool writeable = (coalescer.GetMmuFlags() & ARCH_MMU_FLAG_PERM_WRITE);
-        size_t num_extra_pages = cursor->IfExistPages(writeable, static_cast<uint>(extra_pages),
-                                                      coalescer.GetNextPageSlot());
+      // to use these pages yet. The fault-around window can exceed the coalescer, in which case it
+      // is flushed each time it fills up.
+      while (remaining > 0) {
+        // Check how much space the coalescer has for faulting additional pages.
+        const size_t extra_pages = ktl::min(coalescer.ExtraPageCapacityFrom(next_va), remaining);
+        if (extra_pages == 0) {
+          break;
+        }
+        const size_t num_extra_pages = cursor->IfExistPages(
+            writeable, static_cast<uint>(extra_pages), coalescer.GetNextPageSlot());
         coalescer.IncrementCount(num_extra_pages);
+        vm_mapping_fault_around_pages.Add(num_extra_pages);
+        if (num_extra_pages != extra_pages) {
+          break;
+        }
+        next_va += num_extra_pages * PAGE_SIZE;
+        remaining -= num_extra_pages;
+        if (remaining > 0) {
+          if (zx_status_t status = coalescer.Flush(); status != ZX_OK) {
+            return {status, coalescer.TotalMapped()};
+          }
+        }
       }
     }
     zx_status_t status = coalescer.Flush();
@@ -1076,6 +1214,9 @@ ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const ui
       // Mapping has been successfully updated by us. Inform the faulting helper so that it knows
       // not to unmap the range instead.
       currently_faulting.MappingUpdated();
+      if (additional_pages == 0) {
+        fault_around_next_ = va + coalescer.TotalMapped() * PAGE_SIZE;
+      }
     }
     return {status, coalescer.TotalMapped()};
   } else if (VmObjectPhysical* phys = DownCastVmObject<VmObjectPhysical>(object_.get()); phys) {
@@ -1120,6 +1261,9 @@ ktl::pair<zx_status_t, uint32_t> VmMapping::PageFaultLocked(vaddr_t va, const ui
       // Mapping has been successfully updated by us. Inform the faulting helper so that it knows
       // not to unmap the range instead.
       currently_faulting.MappingUpdated();
+      if (additional_pages == 0) {
+        fault_around_next_ = va + coalescer.TotalMapped() * PAGE_SIZE;
+      }
     }
     return {status, coalescer.TotalMapped()};
   }
@@ -1249,6 +1393,10 @@ fbl::RefPtr<VmMapping> VmMapping::TryMergeRightNeighborLocked(VmMapping* right_c
 
         AssertHeld(new_mapping->object_lock_ref());
         new_mapping->protection_ranges_ = ktl::move(protection_ranges_);
+        new_mapping->large_pages_mapped_ =
+            large_pages_mapped_ || right_candidate->large_pages_mapped_;
+        new_mapping->fault_around_max_pages_ =
+            ktl::max(fault_around_max_pages_, right_candidate->fault_around_max_pages_);
 
         status = DestroyLockedObject(false);
         ASSERT(status == ZX_OK);
@@ -41,6 +41,12 @@
 namespace {
 
 KCOUNTER(vmo_attribution_queries, "vm.attributed_memory.object.queries")
+KCOUNTER(vmo_read_user_resident_hit, "vm.object.read_user.resident_hit")
+KCOUNTER(vmo_read_user_resident_miss, "vm.object.read_user.resident_miss")
+
+// Largest read served by VmObjectPaged::TryReadUserResident. The bounce buffer lives on the stack,
+// and larger reads amortize the cost of the regular path anyway.
+constexpr size_t kReadUserResidentMax = 512;
 
 }  // namespace
 
@@ -1001,9 +1007,12 @@ zx_status_t VmObjectPaged::CommitRangeInternal(uint64_t offset, uint64_t len, bo
         }
       }
 
-      status = cow_pages_locked()->CommitRangeLocked(*GetCowRange(offset, len), deferred,
+      // Commit at most one chunk per acquisition of the lock. The loop comes back around for the
+      // rest, bounding both the lock hold time and the size of each page allocation batch.
+      const uint64_t chunk_len = ktl::min(len, VmCowPages::kMaxRangeOpChunkSize);
+      status = cow_pages_locked()->CommitRangeLocked(*GetCowRange(offset, chunk_len), deferred,
                                                      &committed_len, &page_request);
-      DEBUG_ASSERT(committed_len <= len);
+      DEBUG_ASSERT(committed_len <= chunk_len);
 
       // If we're required to pin, try to pin the committed range before waiting on the
       // page_request, which has been populated to request pages beyond the committed range. Even
@@ -1281,15 +1290,32 @@ ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadWriteInternal(uint64_t offset,
                                                                 bool write,
                                                                 VmObjectReadWriteOptions options,
                                                                 T copyfunc) {
+  const UserCopyRange range{.offset = offset, .len = len, .buffer = nullptr};
+  return ReadWriteRangesInternal(ktl::span(&range, 1), write, options, copyfunc);
+}
+
+// As ReadWriteInternal, but for several ranges that are processed in order. The offset passed to
+// the copy routine is the number of bytes transferred so far across all the ranges, and a single
+// call never spans two ranges. The lock is held from one range to the next, and is only dropped to
+// wait on a page request, handle a fault or yield to a contending thread.
+template <typename T>
+ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadWriteRangesInternal(
+    ktl::span<const UserCopyRange> ranges, bool write, VmObjectReadWriteOptions options,
+    T copyfunc) {
   canary_.Assert();
 
-  uint64_t end_offset;
-  if (add_overflow(offset, len, &end_offset)) {
-    return {ZX_ERR_OUT_OF_RANGE, 0};
+  size_t total_len = 0;
+  for (const UserCopyRange& range : ranges) {
+    uint64_t range_end;
+    if (add_overflow(range.offset, range.len, &range_end) ||
+        add_overflow(total_len, range.len, &total_len)) {
+      return {ZX_ERR_OUT_OF_RANGE, 0};
+    }
   }
 
-  // Track our two offsets.
-  uint64_t src_offset = offset;
+  // Track the range being processed and our two offsets.
+  size_t range_index = 0;
+  uint64_t src_offset = ranges.empty() ? 0 : ranges[0].offset;
   size_t dest_offset = 0;
 
   // The PageRequest is a non-trivial object so we declare it outside the loop to avoid having to
@@ -1300,100 +1326,127 @@ ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadWriteInternal(uint64_t offset,
   // we need to first read in the range and then dirty it, and we cannot have both a read and dirty
   // request outstanding at one time.
   __UNINITIALIZED MultiPageRequest page_request(!write);
-  do {
-    zx_status_t status;
+  while (range_index < ranges.size()) {
+    zx_status_t status = ZX_OK;
     __UNINITIALIZED UserCopyCaptureFaultsResult copy_result(ZX_OK);
     {
       __UNINITIALIZED VmCowPages::DeferredOps deferred(cow_pages_.get());
       Guard<CriticalMutex> guard{AssertOrderedLock, lock(), cow_pages_->lock_order()};
       if (cache_policy_ != ARCH_MMU_FLAG_CACHED) {
-        return {ZX_ERR_BAD_STATE, src_offset - offset};
-      }
-      if (end_offset > size_locked()) {
-        if (!!(options & VmObjectReadWriteOptions::TrimLength)) {
-          if (src_offset >= size_locked()) {
-            return {ZX_OK, src_offset - offset};
-          }
-          end_offset = size_locked();
-        } else {
-          return {ZX_ERR_OUT_OF_RANGE, src_offset - offset};
-        }
-      } else if (src_offset >= end_offset) {
-        return {ZX_OK, src_offset - offset};
+        return {ZX_ERR_BAD_STATE, dest_offset};
       }
-
-      const size_t first_page_offset = ROUNDDOWN_PAGE_SIZE(src_offset);
-      const size_t last_page_offset = ROUNDDOWN_PAGE_SIZE(end_offset - 1);
-      size_t remaining_pages = (last_page_offset - first_page_offset) / PAGE_SIZE + 1;
       size_t pages_since_last_unlock = 0;
       bool modified = false;
-
-      __UNINITIALIZED zx::result<VmCowPages::LookupCursor> cursor =
-          GetLookupCursorLocked(first_page_offset, remaining_pages * PAGE_SIZE);
-      if (cursor.is_error()) {
-        return {cursor.status_value(), src_offset - offset};
-      }
-      // Performing explicit accesses by request of the user, so disable zero forking.
-      cursor->DisableZeroFork();
-      AssertHeld(cursor->lock_ref());
-
-      while (remaining_pages > 0) {
-        const size_t page_offset = src_offset % PAGE_SIZE;
-        const size_t tocopy = ktl::min(PAGE_SIZE - page_offset, end_offset - src_offset);
-
-        // If we need to wait on pages then we would like to wait on as many as possible, up to the
-        // actual limit of the read/write operation. For a read we can wake up once some pages are
-        // received, minimizing the latency before we start making progress, but as this is not true
-        // for writes we cap the maximum number requested.
-        constexpr uint64_t kMaxWriteWaitPages = 16;
-        const uint64_t max_wait_pages = write ? kMaxWriteWaitPages : UINT64_MAX;
-        const uint64_t max_waitable_pages = ktl::min(remaining_pages, max_wait_pages);
-
-        // Attempt to lookup a page
-        __UNINITIALIZED zx::result<VmCowPages::LookupCursor::RequireResult> result =
-            cursor->RequirePage(write, static_cast<uint>(max_waitable_pages), deferred,
-                                &page_request);
-
-        status = result.status_value();
-        if (status != ZX_OK) {
-          break;
+      bool yield = false;
+
+      while (range_index < ranges.size()) {
+        uint64_t end_offset = ranges[range_index].offset + ranges[range_index].len;
+        bool trimmed = false;
+        if (end_offset > size_locked()) {
+          if (!!(options & VmObjectReadWriteOptions::TrimLength)) {
+            if (src_offset >= size_locked()) {
+              return {ZX_OK, dest_offset};
+            }
+            end_offset = size_locked();
+            trimmed = true;
+          } else {
+            return {ZX_ERR_OUT_OF_RANGE, dest_offset};
+          }
         }
 
-        // Compute the kernel mapping of this page.
-        const paddr_t pa = result->page->paddr();
-        char* page_ptr = reinterpret_cast<char*>(paddr_to_physmap(pa));
+        if (src_offset < end_offset) {
+          const size_t first_page_offset = ROUNDDOWN_PAGE_SIZE(src_offset);
+          const size_t last_page_offset = ROUNDDOWN_PAGE_SIZE(end_offset - 1);
+          size_t remaining_pages = (last_page_offset - first_page_offset) / PAGE_SIZE + 1;
 
-        // Call the copy routine. If the copy was successful then ZX_OK is returned, otherwise
-        // ZX_ERR_SHOULD_WAIT may be returned to indicate the copy failed but we can retry it.
-        copy_result = copyfunc(page_ptr + page_offset, dest_offset, tocopy);
+          __UNINITIALIZED zx::result<VmCowPages::LookupCursor> cursor =
+              GetLookupCursorLocked(first_page_offset, remaining_pages * PAGE_SIZE);
+          if (cursor.is_error()) {
+            return {cursor.status_value(), dest_offset};
+          }
+          // Performing explicit accesses by request of the user, so disable zero forking.
+          cursor->DisableZeroFork();
+          AssertHeld(cursor->lock_ref());
+
+          while (remaining_pages > 0) {
+            const size_t page_offset = src_offset % PAGE_SIZE;
+            const size_t tocopy = ktl::min(PAGE_SIZE - page_offset, end_offset - src_offset);
+
+            // If we need to wait on pages then we would like to wait on as many as possible, up to
+            // the actual limit of the read/write operation. For a read we can wake up once some
+            // pages are received, minimizing the latency before we start making progress, but as
+            // this is not true for writes we cap the maximum number requested.
+            constexpr uint64_t kMaxWriteWaitPages = 16;
+            const uint64_t max_wait_pages = write ? kMaxWriteWaitPages : UINT64_MAX;
+            const uint64_t max_waitable_pages = ktl::min(remaining_pages, max_wait_pages);
+
+            // Attempt to lookup a page
+            __UNINITIALIZED zx::result<VmCowPages::LookupCursor::RequireResult> result =
+                cursor->RequirePage(write, static_cast<uint>(max_waitable_pages), deferred,
+                                    &page_request);
+
+            status = result.status_value();
+            if (status != ZX_OK) {
+              break;
+            }
+
+            // Compute the kernel mapping of this page.
+            const paddr_t pa = result->page->paddr();
+            char* page_ptr = reinterpret_cast<char*>(paddr_to_physmap(pa));
+
+            // Call the copy routine. If the copy was successful then ZX_OK is returned, otherwise
+            // ZX_ERR_SHOULD_WAIT may be returned to indicate the copy failed but we can retry it.
+            copy_result = copyfunc(page_ptr + page_offset, dest_offset, tocopy);
+
+            // If a fault has actually occurred, then we will have captured fault info that we can
+            // use to handle the fault.
+            if (copy_result.fault_info.has_value()) {
+              break;
+            }
+            // If we encounter _any_ unrecoverable error from the copy operation which
+            // produced no fault address, squash the error down to just "NOT_FOUND".
+            // This is what the SoftFault error would have told us if we did try to
+            // handle the fault and could not.
+            if (copy_result.status != ZX_OK) {
+              status = ZX_ERR_NOT_FOUND;
+              break;
+            }
+            // Advance the copy location.
+            src_offset += tocopy;
+            dest_offset += tocopy;
+            remaining_pages--;
+            modified = write;
+
+            // Periodically yield the lock in order to allow other read or write
+            // operations to advance sooner than they otherwise would.
+            constexpr size_t kPagesBetweenUnlocks = 16;
+            if (unlikely(++pages_since_last_unlock == kPagesBetweenUnlocks)) {
+              pages_since_last_unlock = 0;
+              if (guard.lock()->IsContested()) {
+                yield = true;
+                break;
+              }
+            }
+          }
+          if (status != ZX_OK || copy_result.fault_info.has_value() || src_offset < end_offset) {
+            break;
+          }
+        }
 
-        // If a fault has actually occurred, then we will have captured fault info that we can use
-        // to handle the fault.
-        if (copy_result.fault_info.has_value()) {
-          break;
+        // This range is done. A trimmed range reached the end of the VMO, so nothing after it can
+        // be transferred either.
+        if (trimmed) {
+          if (modified) {
+            mark_modified_locked();
+          }
+          return {ZX_OK, dest_offset};
         }
-        // If we encounter _any_ unrecoverable error from the copy operation which
-        // produced no fault address, squash the error down to just "NOT_FOUND".
-        // This is what the SoftFault error would have told us if we did try to
-        // handle the fault and could not.
-        if (copy_result.status != ZX_OK) {
-          status = ZX_ERR_NOT_FOUND;
-          break;
+        range_index++;
+        if (range_index < ranges.size()) {
+          src_offset = ranges[range_index].offset;
         }
-        // Advance the copy location.
-        src_offset += tocopy;
-        dest_offset += tocopy;
-        remaining_pages--;
-        modified = write;
-
-        // Periodically yield the lock in order to allow other read or write
-        // operations to advance sooner than they otherwise would.
-        constexpr size_t kPagesBetweenUnlocks = 16;
-        if (unlikely(++pages_since_last_unlock == kPagesBetweenUnlocks)) {
-          pages_since_last_unlock = 0;
-          if (guard.lock()->IsContested()) {
-            break;
-          }
+        if (yield) {
+          break;
         }
       }
       // Before dropping the lock, check if any pages were modified and update the VMO state
@@ -1405,8 +1458,11 @@ ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadWriteInternal(uint64_t offset,
 
     // If there was a fault while copying, then handle it now that the lock is dropped.
     if (copy_result.fault_info.has_value()) {
+      // Only fault in what is left of the current range, as the next range may be copying to or
+      // from an unrelated buffer.
       auto& info = *copy_result.fault_info;
-      uint64_t to_fault = len - dest_offset;
+      const UserCopyRange& range = ranges[range_index];
+      uint64_t to_fault = range.offset + range.len - src_offset;
       status = Thread::Current::SoftFaultInRange(info.pf_va, info.pf_flags, to_fault);
     } else if (status == ZX_ERR_SHOULD_WAIT) {
       // RequirePage 'failed', but told us that it had filled out the page request, so we should
@@ -1418,11 +1474,11 @@ ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadWriteInternal(uint64_t offset,
       }
     }
     if (status != ZX_OK) {
-      return {status, src_offset - offset};
+      return {status, dest_offset};
     }
-  } while (src_offset < end_offset);
+  }
 
-  return {ZX_OK, src_offset - offset};
+  return {ZX_OK, dest_offset};
 }
 
 zx_status_t VmObjectPaged::Read(void* _ptr, uint64_t offset, size_t len) {
@@ -1584,11 +1640,72 @@ zx_status_t VmObjectPaged::LookupContiguous(uint64_t offset, uint64_t len, paddr
   return ZX_OK;
 }
 
+zx_status_t VmObjectPaged::TryReadUserResident(user_out_ptr<char> ptr, uint64_t offset,
+                                               size_t len) {
+  DEBUG_ASSERT(len > 0 && len <= kReadUserResidentMax);
+
+  uint64_t end_offset;
+  if (add_overflow(offset, len, &end_offset)) {
+    return ZX_ERR_NEXT;
+  }
+
+  __UNINITIALIZED char buffer[kReadUserResidentMax];
+  {
+    Guard<CriticalMutex> guard{AssertOrderedLock, lock(), cow_pages_->lock_order()};
+    // Anything other than a plain in range read of cached memory, including the errors, is left to
+    // the regular path.
+    if (cache_policy_ != ARCH_MMU_FLAG_CACHED || end_offset > size_locked()) {
+      return ZX_ERR_NEXT;
+    }
+    const uint64_t first_page_offset = ROUNDDOWN_PAGE_SIZE(offset);
+    const uint64_t last_page_offset = ROUNDDOWN_PAGE_SIZE(end_offset - 1);
+    auto cursor = GetLookupCursorLocked(first_page_offset,
+                                        last_page_offset - first_page_offset + PAGE_SIZE);
+    if (cursor.is_error()) {
+      return ZX_ERR_NEXT;
+    }
+    cursor->DisableZeroFork();
+    AssertHeld(cursor->lock_ref());
+
+    size_t copied = 0;
+    while (copied < len) {
+      // MaybePage only returns pages that can be read right now, which excludes anything that would
+      // need a page request, a decompression or the zero page.
+      vm_page_t* page = cursor->MaybePage(false);
+      if (!page) {
+        vmo_read_user_resident_miss.Add(1);
+        return ZX_ERR_NEXT;
+      }
+      const size_t page_offset = (offset + copied) % PAGE_SIZE;
+      const size_t tocopy = ktl::min(PAGE_SIZE - page_offset, len - copied);
+      const char* page_ptr = reinterpret_cast<const char*>(paddr_to_physmap(page->paddr()));
+      memcpy(buffer + copied, page_ptr + page_offset, tocopy);
+      copied += tocopy;
+    }
+  }
+
+  // Any fault on the user buffer is left to the regular path, which will resolve it and retry, so
+  // that errors are reported the same way regardless of which path served the read.
+  if (ptr.copy_array_to_user_capture_faults(buffer, len).status != ZX_OK) {
+    vmo_read_user_resident_miss.Add(1);
+    return ZX_ERR_NEXT;
+  }
+  vmo_read_user_resident_hit.Add(1);
+  return ZX_OK;
+}
+
 ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadUser(user_out_ptr<char> ptr, uint64_t offset,
                                                        size_t len,
                                                        VmObjectReadWriteOptions options) {
   canary_.Assert();
 
+  if (len > 0 && len <= kReadUserResidentMax) {
+    zx_status_t status = TryReadUserResident(ptr, offset, len);
+    if (status != ZX_ERR_NEXT) {
+      return {status, status == ZX_OK ? len : 0};
+    }
+  }
+
   // read routine that uses copy_to_user
   auto read_routine = [ptr](const char* src, size_t offset,
                             size_t len) -> UserCopyCaptureFaultsResult {
@@ -1628,6 +1745,54 @@ ktl::pair<zx_status_t, size_t> VmObjectPaged::WriteUser(
   return ReadWriteInternal(offset, len, true, options, write_routine);
 }
 
+ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadUserRanges(
+    ktl::span<const UserCopyRange> ranges) {
+  canary_.Assert();
+
+  // The copy routine is only told how far into the transfer it is, so walk forward through the
+  // ranges to find the buffer that offset lands in. Offsets never go backwards, and a single call
+  // never spans two ranges.
+  auto read_routine = [ranges, index = size_t{0}, range_start = size_t{0}](
+                          const char* src, size_t offset,
+                          size_t len) mutable -> UserCopyCaptureFaultsResult {
+    while (offset >= range_start + ranges[index].len) {
+      range_start += ranges[index].len;
+      index++;
+    }
+    user_out_ptr<char> ptr(static_cast<char*>(ranges[index].buffer));
+    return ptr.byte_offset(offset - range_start).copy_array_to_user_capture_faults(src, len);
+  };
+
+  if (can_block_on_page_requests()) {
+    lockdep::AssertNoLocksHeld();
+  }
+
+  return ReadWriteRangesInternal(ranges, false, VmObjectReadWriteOptions::None, read_routine);
+}
+
+ktl::pair<zx_status_t, size_t> VmObjectPaged::WriteUserRanges(
+    ktl::span<const UserCopyRange> ranges) {
+  canary_.Assert();
+
+  // See ReadUserRanges.
+  auto write_routine = [ranges, index = size_t{0}, range_start = size_t{0}](
+                           char* dst, size_t offset,
+                           size_t len) mutable -> UserCopyCaptureFaultsResult {
+    while (offset >= range_start + ranges[index].len) {
+      range_start += ranges[index].len;
+      index++;
+    }
+    user_in_ptr<const char> ptr(static_cast<const char*>(ranges[index].buffer));
+    return ptr.byte_offset(offset - range_start).copy_array_from_user_capture_faults(dst, len);
+  };
+
+  if (can_block_on_page_requests()) {
+    lockdep::AssertNoLocksHeld();
+  }
+
+  return ReadWriteRangesInternal(ranges, true, VmObjectReadWriteOptions::None, write_routine);
+}
+
 ktl::pair<zx_status_t, size_t> VmObjectPaged::ReadUserVector(user_out_iovec_t vec, uint64_t offset,
                                                              size_t len) {
   if (len == 0u) {
@@ -1752,6 +1917,12 @@ zx_status_t VmObjectPaged::TakePages(uint64_t offset, uint64_t len, VmPageSplice
 
 zx_status_t VmObjectPaged::SupplyPages(uint64_t offset, uint64_t len, VmPageSpliceList* pages,
                                        SupplyOptions options) {
+  const SupplyRange range = {.offset = offset, .len = len, .pages = pages};
+  return SupplyPagesMany(ktl::span(&range, 1), options);
+}
+
+zx_status_t VmObjectPaged::SupplyPagesMany(ktl::span<const SupplyRange> ranges,
+                                           SupplyOptions options) {
   canary_.Assert();
 
   // We need this check here instead of in SupplyPagesLocked, as we do use that
@@ -1759,41 +1930,46 @@ zx_status_t VmObjectPaged::SupplyPages(uint64_t offset, uint64_t len, VmPageSpli
   if (is_contiguous()) {
     return ZX_ERR_NOT_SUPPORTED;
   }
-  auto cow_range = GetCowRange(offset, len);
-  if (!cow_range) {
-    return ZX_ERR_OUT_OF_RANGE;
+  for (const SupplyRange& range : ranges) {
+    if (!GetCowRange(range.offset, range.len)) {
+      return ZX_ERR_OUT_OF_RANGE;
+    }
   }
-  auto range = *cow_range;
 
+  // |index| is the range being supplied, and |supplied| how much of it has been supplied so far.
+  size_t index = 0;
+  uint64_t supplied = 0;
   __UNINITIALIZED MultiPageRequest page_request;
-  while (!range.is_empty()) {
-    uint64_t supply_len = 0;
-    zx_status_t status;
+  while (index < ranges.size()) {
+    zx_status_t status = ZX_OK;
     {
       __UNINITIALIZED VmCowPages::DeferredOps deferred(cow_pages_.get());
       Guard<CriticalMutex> guard{lock()};
-      status = cow_pages_locked()->SupplyPagesLocked(range, pages, options, &supply_len, deferred,
-                                                     &page_request);
-    }
-    if (status != ZX_ERR_SHOULD_WAIT && status != ZX_OK) {
-      return status;
+      for (; index < ranges.size(); index++, supplied = 0) {
+        const VmCowRange range =
+            GetCowRange(ranges[index].offset, ranges[index].len)->TrimedFromStart(supplied);
+        if (range.is_empty()) {
+          continue;
+        }
+        uint64_t supply_len = 0;
+        status = cow_pages_locked()->SupplyPagesLocked(range, ranges[index].pages, options,
+                                                       &supply_len, deferred, &page_request);
+        if (status != ZX_OK) {
+          // We should not have supplied any more than the requested range.
+          DEBUG_ASSERT(status != ZX_ERR_SHOULD_WAIT || supply_len <= range.len);
+          // Record the completed portion.
+          supplied += supply_len;
+          break;
+        }
+        // We should have supplied the entire range requested if the status was ZX_OK.
+        DEBUG_ASSERT(supply_len == range.len);
+      }
     }
-    // We would only have failed to supply anything if status was not ZX_OK, which in this case
-    // would be ZX_ERR_SHOULD_WAIT as that is the only non-OK status we can reach here with.
-    DEBUG_ASSERT(supply_len > 0 || status == ZX_ERR_SHOULD_WAIT);
-    // We should have supplied the entire range requested if the status was ZX_OK.
-    DEBUG_ASSERT(status != ZX_OK || supply_len == range.len);
-    // We should not have supplied any more than the requested range.
-    DEBUG_ASSERT(supply_len <= range.len);
-
-    // Record the completed portion.
-    range = range.TrimedFromStart(supply_len);
-
     if (status == ZX_ERR_SHOULD_WAIT) {
       status = page_request.Wait();
-      if (status != ZX_OK) {
-        return status;
-      }
+    }
+    if (status != ZX_OK) {
+      return status;
     }
   }
   return ZX_OK;
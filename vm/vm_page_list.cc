@@ -35,8 +35,10 @@ VmPageList::VmPageList() { LTRACEF("%p\n", this); }
 
 VmPageList::VmPageList(VmPageList&& other) : list_(ktl::move(other.list_)) {
   LTRACEF("%p\n", this);
+  other.lookup_hint_ = nullptr;
   list_skew_ = other.list_skew_;
   other.list_skew_ = 0;
+  other.generation_++;
 }
 
 VmPageList::~VmPageList() {
@@ -46,8 +48,12 @@ VmPageList::~VmPageList() {
 
 VmPageList& VmPageList::operator=(VmPageList&& other) {
   list_ = ktl::move(other.list_);
+  lookup_hint_ = nullptr;
+  other.lookup_hint_ = nullptr;
   list_skew_ = other.list_skew_;
   other.list_skew_ = 0;
+  generation_++;
+  other.generation_++;
   return *this;
 }
 
@@ -63,8 +69,8 @@ VmPageOrMarker* VmPageList::LookupOrAllocateInternal(uint64_t offset) {
                 node_offset, index);
 
   // lookup the tree node that holds this page
-  auto pln = list_.find(node_offset);
-  if (pln.IsValid()) {
+  VmPageListNode* pln = FindNode(node_offset);
+  if (pln) {
     return &pln->Lookup(index);
   }
 
@@ -84,6 +90,7 @@ VmPageOrMarker* VmPageList::LookupOrAllocateInternal(uint64_t offset) {
 }
 
 void VmPageList::ReturnEmptySlot(uint64_t offset) {
+  generation_++;
   uint64_t node_offset = NodeOffset(offset);
   size_t index = NodeIndex(offset);
 
@@ -91,19 +98,21 @@ void VmPageList::ReturnEmptySlot(uint64_t offset) {
                 node_offset, index);
 
   // lookup the tree node that holds this offset
-  auto pln = list_.find(node_offset);
-  DEBUG_ASSERT(pln.IsValid());
+  VmPageListNode* pln = FindNode(node_offset);
+  DEBUG_ASSERT(pln);
 
   // check that the slot was empty
   [[maybe_unused]] VmPageOrMarker page = ktl::move(pln->Lookup(index));
   DEBUG_ASSERT(page.IsEmpty());
   if (pln->IsEmpty()) {
     // node is empty, erase it.
+    ForgetNode(pln);
     list_.erase(*pln);
   }
 }
 
 VmPageOrMarker VmPageList::RemoveContent(uint64_t offset) {
+  generation_++;
   uint64_t node_offset = NodeOffset(offset);
   size_t index = NodeIndex(offset);
 
@@ -111,8 +120,8 @@ VmPageOrMarker VmPageList::RemoveContent(uint64_t offset) {
                 node_offset, index);
 
   // lookup the tree node that holds this page
-  auto pln = list_.find(node_offset);
-  if (!pln.IsValid()) {
+  VmPageListNode* pln = FindNode(node_offset);
+  if (!pln) {
     return VmPageOrMarker::Empty();
   }
 
@@ -121,6 +130,7 @@ VmPageOrMarker VmPageList::RemoveContent(uint64_t offset) {
   if (!page.IsEmpty() && pln->IsEmpty()) {
     // if it was the last item in the node, remove the node from the tree
     LTRACEF_LEVEL(2, "%p freeing the list node\n", this);
+    ForgetNode(pln);
     list_.erase(*pln);
   }
   return page;
@@ -452,6 +462,7 @@ ktl::pair<VmPageOrMarker*, bool> VmPageList::LookupOrAllocateCheckForInterval(ui
 }
 
 void VmPageList::ReturnIntervalSlot(uint64_t offset) {
+  generation_++;
   // We should be able to lookup a pre-existing interval slot.
   auto slot = LookupOrAllocateInternal(offset);
   DEBUG_ASSERT(slot);
@@ -474,6 +485,7 @@ void VmPageList::ReturnIntervalSlot(uint64_t offset) {
 }
 
 zx_status_t VmPageList::PopulateSlotsInInterval(uint64_t start_offset, uint64_t end_offset) {
+  generation_++;
   DEBUG_ASSERT(IS_PAGE_ROUNDED(start_offset));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(end_offset));
   DEBUG_ASSERT(end_offset > start_offset);
@@ -552,6 +564,7 @@ zx_status_t VmPageList::PopulateSlotsInInterval(uint64_t start_offset, uint64_t
         for (uint64_t off = first_unpopulated; off < node_offset;
              off += VmPageListNode::kPageFanOut * PAGE_SIZE) {
           [[maybe_unused]] auto node = list_.erase(off);
+          ForgetNode(node.get());
           DEBUG_ASSERT(node->IsEmpty());
         }
         // Also return the start and end slots that we split above.
@@ -675,6 +688,7 @@ zx_status_t VmPageList::AddZeroIntervalInternal(uint64_t start_offset, uint64_t
                                                 VmPageOrMarker::IntervalDirtyState dirty_state,
                                                 uint64_t awaiting_clean_len,
                                                 bool replace_existing_slot) {
+  generation_++;
   DEBUG_ASSERT(IS_PAGE_ROUNDED(start_offset));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(end_offset));
   DEBUG_ASSERT(start_offset < end_offset);
@@ -885,6 +899,7 @@ zx_status_t VmPageList::AddZeroIntervalInternal(uint64_t start_offset, uint64_t
 
 vm_page_t* VmPageList::ReplacePageWithZeroInterval(uint64_t offset,
                                                    VmPageOrMarker::IntervalDirtyState dirty_state) {
+  generation_++;
   // We are guaranteed to find the slot as we're replacing an existing page.
   VmPageOrMarker* slot = LookupOrAllocateInternal(offset);
   DEBUG_ASSERT(slot);
@@ -903,6 +918,7 @@ vm_page_t* VmPageList::ReplacePageWithZeroInterval(uint64_t offset,
 zx_status_t VmPageList::OverwriteZeroInterval(uint64_t old_start_offset, uint64_t old_end_offset,
                                               uint64_t new_start_offset, uint64_t new_end_offset,
                                               VmPageOrMarker::IntervalDirtyState new_dirty_state) {
+  generation_++;
   DEBUG_ASSERT(old_start_offset == UINT64_MAX || IS_PAGE_ROUNDED(old_start_offset));
   DEBUG_ASSERT(old_end_offset == UINT64_MAX || IS_PAGE_ROUNDED(old_end_offset));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(new_start_offset));
@@ -1078,6 +1094,7 @@ zx_status_t VmPageList::OverwriteZeroInterval(uint64_t old_start_offset, uint64_
 }
 
 zx_status_t VmPageList::ClipIntervalStart(uint64_t interval_start, uint64_t len) {
+  generation_++;
   DEBUG_ASSERT(IS_PAGE_ROUNDED(interval_start));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(len));
   if (len == 0) {
@@ -1128,6 +1145,7 @@ zx_status_t VmPageList::ClipIntervalStart(uint64_t interval_start, uint64_t len)
 }
 
 zx_status_t VmPageList::ClipIntervalEnd(uint64_t interval_end, uint64_t len) {
+  generation_++;
   DEBUG_ASSERT(IS_PAGE_ROUNDED(interval_end));
   DEBUG_ASSERT(IS_PAGE_ROUNDED(len));
   if (len == 0) {
@@ -1170,6 +1188,7 @@ zx_status_t VmPageList::ClipIntervalEnd(uint64_t interval_end, uint64_t len) {
 }
 
 zx_status_t VmPageList::TakePages(uint64_t offset, VmPageSpliceList* splice) {
+  generation_++;
   splice->InitializeSkew(offset, list_skew_);
 
   const uint64_t end = offset + splice->length_;
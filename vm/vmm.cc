@@ -9,6 +9,7 @@
 #include <inttypes.h>
 #include <lib/affine/ratio.h>
 #include <lib/console.h>
+#include <lib/counters.h>
 #include <lib/ktrace.h>
 #include <lib/zircon-internal/macros.h>
 #include <string.h>
@@ -20,6 +21,7 @@
 #include <kernel/mutex.h>
 #include <kernel/task_runtime_timers.h>
 #include <object/diagnostics.h>
+#include <platform/timer.h>
 #include <vm/fault.h>
 #include <vm/pmm.h>
 #include <vm/vm.h>
@@ -32,6 +34,9 @@
 #define LOCAL_TRACE VM_GLOBAL_TRACE(0)
 #define TRACE_PAGE_FAULT 0
 
+// Hardware page fault latency, from 1us up to 16ms.
+KCOUNTER_HISTOGRAM(page_fault_latency_ns, "vm.page_fault.latency_ns", 10)
+
 // This file mostly contains C wrappers around the underlying C++ objects, conforming to
 // the older api.
 
@@ -94,6 +99,8 @@ zx_status_t vmm_page_fault_handler(vaddr_t addr, uint flags) {
 
   KTRACE_COMPLETE("kernel:vm", "page_fault", start_time, ("vaddr", ktrace::Pointer{addr}),
                   ("flags", FlagsString{flags}));
+  page_fault_latency_ns.Add(static_cast<uint64_t>(
+      timer_get_ticks_to_time_ratio().Scale(current_mono_ticks() - start_time)));
 
   return status;
 }
@@ -0,0 +1,98 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <bits.h>
+#include <lib/boot-options/boot-options.h>
+#include <stdio.h>
+
+#include <arch/defines.h>
+#include <fbl/alloc_checker.h>
+#include <lk/init.h>
+#include <vm/workingset.h>
+
+#include <ktl/enforce.h>
+
+ktl::atomic<Workingset*> Workingset::global_{nullptr};
+
+ktl::unique_ptr<Workingset> Workingset::Create(size_t num_shadows) {
+  if (num_shadows == 0) {
+    return nullptr;
+  }
+  // Round up to a power of two so that MakeKey can mask the hash.
+  size_t size = 1;
+  while (size < num_shadows) {
+    size <<= 1;
+  }
+
+  fbl::AllocChecker ac;
+  auto* shadows = new (&ac) ktl::atomic<uint64_t>[size]();
+  if (!ac.check()) {
+    return nullptr;
+  }
+  fbl::Array<ktl::atomic<uint64_t>> array(shadows, size);
+  ktl::unique_ptr<Workingset> workingset(new (&ac) Workingset(ktl::move(array)));
+  if (!ac.check()) {
+    return nullptr;
+  }
+  return workingset;
+}
+
+void Workingset::InitGlobal(size_t num_shadows) {
+  DEBUG_ASSERT(Get() == nullptr);
+  ktl::unique_ptr<Workingset> workingset = Create(num_shadows);
+  if (!workingset) {
+    if (num_shadows != 0) {
+      printf("workingset: failed to allocate %zu shadow entries\n", num_shadows);
+    }
+    return;
+  }
+  // The global instance lives for the lifetime of the system.
+  global_.store(workingset.release(), ktl::memory_order_release);
+}
+
+static void workingset_init_func(uint level) {
+  Workingset::InitGlobal(gBootOptions->page_scanner_refault_shadow_entries);
+}
+
+LK_INIT_HOOK(workingset_init, &workingset_init_func, LK_INIT_LEVEL_VM)
+
+Workingset::Key Workingset::MakeKey(const void* object, uint64_t offset) const {
+  // Mix the object and page index so that neighbouring offsets, and objects, spread across the
+  // table.
+  uint64_t h = reinterpret_cast<uintptr_t>(object) ^ ((offset >> PAGE_SIZE_SHIFT) << 48) ^
+               (offset >> PAGE_SIZE_SHIFT);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdul;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ul;
+  h ^= h >> 33;
+  // The index already selects the slot, so take the tag from the other end of the hash. It is
+  // forced non-zero so that a valid entry is never mistaken for an empty one.
+  return Key{.index = static_cast<size_t>(h & (shadows_.size() - 1)),
+             .tag = ((h >> kTagShift) | 1) << kTagShift};
+}
+
+void Workingset::RecordEviction(const void* object, uint64_t offset) {
+  const Key key = MakeKey(object, offset);
+  const uint32_t now = clock_.fetch_add(1, ktl::memory_order_relaxed) + 1;
+  shadows_[key.index].store(key.tag | now, ktl::memory_order_relaxed);
+}
+
+ktl::optional<uint32_t> Workingset::TakeRefaultDistance(const void* object, uint64_t offset) {
+  const Key key = MakeKey(object, offset);
+  ktl::atomic<uint64_t>& slot = shadows_[key.index];
+  uint64_t shadow = slot.load(ktl::memory_order_relaxed);
+  if ((shadow & ~BIT_MASK(kTagShift)) != key.tag) {
+    return ktl::nullopt;
+  }
+  // Only the thread that clears the entry gets to report the refault. Losing the race to another
+  // eviction that reused the slot just means this refault goes unnoticed.
+  if (!slot.compare_exchange_strong(shadow, 0, ktl::memory_order_relaxed)) {
+    return ktl::nullopt;
+  }
+  const uint32_t evicted_at = static_cast<uint32_t>(shadow);
+  return clock_.load(ktl::memory_order_relaxed) - evicted_at;
+}
@@ -0,0 +1,116 @@
+// Copyright 2025 The Fuchsia Authors
+//
+// Use of this source code is governed by a MIT-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/MIT
+
+#include <lib/boot-options/boot-options.h>
+#include <lib/counters.h>
+
+#include <arch/ops.h>
+#include <kernel/event.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
+#include <lk/init.h>
+#include <vm/physmap.h>
+#include <vm/pmm.h>
+#include <vm/zeroed_page_pool.h>
+
+#include <ktl/enforce.h>
+
+namespace {
+
+KCOUNTER(zeroed_pool_hit, "vm.zeroed_page_pool.hit")
+KCOUNTER(zeroed_pool_miss, "vm.zeroed_page_pool.miss")
+KCOUNTER(zeroed_pool_zeroed, "vm.zeroed_page_pool.zeroed")
+
+// The pool is refilled once it drops to half of its target size, and only while free memory is
+// at least this many times the target size.
+constexpr uint64_t kFreeMemoryMultiple = 4;
+
+DECLARE_SINGLETON_SPINLOCK(pool_lock);
+list_node_t pool_pages TA_GUARDED(pool_lock::Get()) = LIST_INITIAL_VALUE(pool_pages);
+uint64_t pool_count TA_GUARDED(pool_lock::Get()) = 0;
+
+// Set once during init, before the refill thread is started, and read only after. A zero target
+// means the pool is disabled.
+uint64_t pool_target = 0;
+
+AutounsignalEvent refill_event;
+
+int zeroed_page_pool_refill_thread(void*) {
+  for (;;) {
+    refill_event.Wait();
+
+    for (;;) {
+      {
+        Guard<SpinLock, IrqSave> guard{pool_lock::Get()};
+        if (pool_count >= pool_target) {
+          break;
+        }
+      }
+      if (pmm_count_free_pages() < pool_target * kFreeMemoryMultiple) {
+        break;
+      }
+      vm_page_t* page;
+      paddr_t pa;
+      if (pmm_alloc_page(PMM_ALLOC_FLAG_ANY, &page, &pa) != ZX_OK) {
+        break;
+      }
+      // This thread runs at the lowest priority, so this zeroing only happens on otherwise idle
+      // CPUs and keeps the cache traffic of clearing the page off of the fault path.
+      arch_zero_page(paddr_to_physmap(pa));
+      zeroed_pool_zeroed.Add(1);
+
+      Guard<SpinLock, IrqSave> guard{pool_lock::Get()};
+      list_add_tail(&pool_pages, &page->queue_node);
+      pool_count++;
+    }
+  }
+  return 0;
+}
+
+void zeroed_page_pool_init(uint level) {
+  if (gBootOptions->vm_zeroed_page_pool_pages == 0 || gBootOptions->pmm_alloc_random_should_wait) {
+    return;
+  }
+  pool_target = gBootOptions->vm_zeroed_page_pool_pages;
+
+  Thread* thread = Thread::Create("zeroed-page-pool", zeroed_page_pool_refill_thread, nullptr,
+                                  LOWEST_PRIORITY + 1);
+  DEBUG_ASSERT(thread);
+  thread->DetachAndResume();
+  refill_event.Signal();
+}
+
+}  // namespace
+
+vm_page_t* zeroed_page_pool_take() {
+  if (pool_target == 0) {
+    return nullptr;
+  }
+
+  vm_page_t* page;
+  bool refill;
+  {
+    Guard<SpinLock, IrqSave> guard{pool_lock::Get()};
+    page = list_remove_head_type(&pool_pages, vm_page_t, queue_node);
+    if (page) {
+      pool_count--;
+    }
+    refill = pool_count <= pool_target / 2;
+  }
+  if (refill) {
+    refill_event.Signal();
+  }
+
+  if (!page) {
+    zeroed_pool_miss.Add(1);
+    return nullptr;
+  }
+  DEBUG_ASSERT(page->state() == vm_page_state::ALLOC);
+  zeroed_pool_hit.Add(1);
+  return page;
+}
+
+LK_INIT_HOOK(zeroed_page_pool, &zeroed_page_pool_init, LK_INIT_LEVEL_USER - 1)